@@ -13,6 +13,9 @@ RTLUSB=$(lsusb | awk '/RTL2838/ { print $2 "/" substr($4,1,3) }')
 # Find pasuspender for suspending the pulse audio server
 PASUSPENDER=$(which pasuspender 2>/dev/null)
 
+# Allow realtime scheduling and memory locking if REALTIME is set
+REALTIME=${REALTIME:-}
+
 if [[ -z "$@" ]]; then
   DOCKER_ARGS="-it --rm"
 else
@@ -23,6 +26,7 @@ exec ${PASUSPENDER:+$PASUSPENDER --} \
   sudo docker run ${DOCKER_ARGS} --hostname svxlink --name svxlink \
     --device /dev/snd -e HOSTAUDIO_GID=$(stat -c "%g" /dev/snd/timer) \
     ${RTLSDR_GID:+--device /dev/bus/usb -e RTLSDR_GID=$RTLSDR_GID} \
+    ${REALTIME:+--cap-add=SYS_NICE --ulimit rtprio=99 --ulimit memlock=-1} \
     -v $(pwd)/conf:/etc/svxlink:z \
     -v $(pwd)/spool:/var/spool/svxlink:z \
     svxlink:latest "$@"
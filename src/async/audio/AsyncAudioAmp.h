@@ -44,6 +44,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncAudioKernels.h>
 
 
 /****************************************************************************
@@ -138,11 +139,10 @@ class AudioAmp : public Async::AudioProcessor
   protected:
     void processSamples(float *dest, const float *src, int count)
     {
-      for (int i=0; i<count; ++i)
-      {
-      	dest[i] = src[i] * m_gain;
-      }
+      audioKernelGain(dest, src, m_gain, count);
     }
+
+    bool isSampleWise(void) const { return true; }
     
     
   private:
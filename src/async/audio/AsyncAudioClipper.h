@@ -43,6 +43,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncAudioKernels.h>
 
 
 
@@ -134,22 +135,10 @@ class AudioClipper : public AudioProcessor
   protected:
     virtual void processSamples(float *dest, const float *src, int count)
     {
-      for (int i=0; i<count; ++i)
-      {
-      	if (src[i] > clip_level)
-	{
-	  dest[i] = clip_level;
-	}
-	else if (src[i] < -clip_level)
-	{
-	  dest[i] = -clip_level;
-	}
-	else
-	{
-	  dest[i] = src[i];
-	}
-      }
+      audioKernelClip(dest, src, clip_level, count);
     }
+
+    bool isSampleWise(void) const { return true; }
     
     
   private:
@@ -32,7 +32,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <stdint.h>
+
 #include <iostream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -50,6 +55,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "AsyncAudioCompressor.h"
+#include "AsyncAudioKernels.h"
 
 
 
@@ -73,6 +79,9 @@ using namespace Async;
 // DC offset to prevent denormal
 static const double DC_OFFSET = 1.0E-25;
 
+// The number of samples processed in each pass
+static const int BLOCK_SIZE = 256;
+
 
 
 
@@ -91,14 +100,6 @@ static const double DC_OFFSET = 1.0E-25;
  *
  ****************************************************************************/
 
-// linear -> dB conversion
-static inline double lin2dB( double lin )
-{
-    // 20 / ln( 10 )
-  static const double LOG_2_DB = 8.6858896380650365530225783783321;
-  return log( lin ) * LOG_2_DB;
-}
-
 // dB -> linear conversion
 static inline double dB2lin( double dB )
 {
@@ -107,6 +108,51 @@ static inline double dB2lin( double dB )
   return exp( dB * DB_2_LOG );
 }
 
+/*
+ * Fast versions of the conversions above used in the sample processing loop.
+ * The argument is split into a power of two exponent and a mantissa and the
+ * mantissa part is calculated using a short series. The error is below
+ * 0.0001 dB. There are no branches so that the compiler is able to vectorize
+ * loops using them. The argument to fastDb2Lin must be within +/-750 dB.
+ */
+static inline float fastLin2dB( float lin )
+{
+  static const float LN_2 = 0.69314718f;
+  static const float LOG_2_DB = 8.6858896f;
+  uint32_t bits;
+  memcpy(&bits, &lin, sizeof(bits));
+    // Use a mantissa in [0.707, 1.414). If the mantissa bits are over the
+    // ones for sqrt(2), the mantissa is halved by decrementing its exponent.
+  const int upper = ((bits & 0x007fffff) > 0x003504f3);
+  const int e = static_cast<int>((bits >> 23) & 0xff) - 127 + upper;
+  bits = ((bits & 0x007fffff) | 0x3f800000) - (upper << 23);
+  float m;
+  memcpy(&m, &bits, sizeof(m));
+    // ln(m) = 2*atanh(t), where t is in [-0.172, 0.172]
+  const float t = (m - 1.0f) / (m + 1.0f);
+  const float t2 = t * t;
+  const float ln_m =
+    2.0f * t * (1.0f + t2 * (1.0f/3.0f + t2 * (1.0f/5.0f + t2 * (1.0f/7.0f))));
+  return (e * LN_2 + ln_m) * LOG_2_DB;
+}
+
+static inline float fastDb2Lin( float dB )
+{
+  static const float LN_2 = 0.69314718f;
+  static const float DB_2_LOG2 = 0.16609640f; // log2( 10 ) / 20
+  const float x = dB * DB_2_LOG2;
+    // Round to the nearest integer. The bias make the truncation a floor.
+  const int n = static_cast<int>(x + 127.5f) - 127;
+    // exp(f) where f is in [-0.347, 0.347]
+  const float f = (x - n) * LN_2;
+  const float p = 1.0f + f * (1.0f + f * (1.0f/2.0f + f * (1.0f/6.0f +
+                  f * (1.0f/24.0f + f * (1.0f/120.0f + f * (1.0f/720.0f))))));
+  const uint32_t bits = static_cast<uint32_t>(n + 127) << 23;
+  float scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
 
 
 /****************************************************************************
@@ -134,7 +180,7 @@ static inline double dB2lin( double dB )
 
 AudioCompressor::AudioCompressor(void)
   : threshdB_(0.0), ratio_(1.0), output_gain(1.0),att_(10.0), rel_(100.0),
-    envdB_(DC_OFFSET)
+    envdB_(DC_OFFSET), la_pos(0), la_fill(0), la_flush_cnt(0)
 {
 } /* AudioCompressor::AudioCompressor */
 
@@ -182,12 +228,52 @@ void AudioCompressor::setOutputGain(float gain)
 } /* AudioCompressor::setOutputGain */
 
 
+void AudioCompressor::setLookahead(double lookahead_ms)
+{
+  const unsigned len = static_cast<unsigned>(
+      std::max(0.0, lookahead_ms) * INTERNAL_SAMPLE_RATE / 1000.0 + 0.5);
+  la_buf.assign(len, 0.0f);
+  la_pos = 0;
+  la_fill = 0;
+  la_flush_cnt = 0;
+} /* AudioCompressor::setLookahead */
+
+
 void AudioCompressor::reset(void)
 {
   envdB_ = DC_OFFSET;
+  std::fill(la_buf.begin(), la_buf.end(), 0.0f);
+  la_pos = 0;
+  la_fill = 0;
 } /* AudioCompressor::reset */
 
 
+int AudioCompressor::writeSamples(const float *samples, int count)
+{
+    // New samples push out the look-ahead delay so an ongoing flush of the
+    // delay line is no longer needed
+  la_flush_cnt = 0;
+  return AudioProcessor::writeSamples(samples, count);
+} /* AudioCompressor::writeSamples */
+
+
+void AudioCompressor::flushSamples(void)
+{
+  la_flush_cnt = la_fill;
+  writeLookaheadTail();
+} /* AudioCompressor::flushSamples */
+
+
+void AudioCompressor::resumeOutput(void)
+{
+  AudioProcessor::resumeOutput();
+  if (la_flush_cnt > 0)
+  {
+    writeLookaheadTail();
+  }
+} /* AudioCompressor::resumeOutput */
+
+
 /****************************************************************************
  *
  * Protected member functions
@@ -197,60 +283,83 @@ void AudioCompressor::reset(void)
 
 void AudioCompressor::processSamples(float *dest, const float *src, int count)
 {
-  //double max_sample = 0.0;
-  for (int i=0; i<count; ++i)
+    // The samples are processed in passes over a block. Only the envelope
+    // detector has to run sample by sample. The dB conversions before and
+    // after it can then be vectorized by the compiler.
+  const float thresh_db = threshdB_;
+  const double reduction = ratio_ - 1.0;
+  const float gain_lin = output_gain;
+  const double att_coef = att_.getCoef();
+  const double rel_coef = rel_.getCoef();
+  double envdB = envdB_;  // local copy so that it can stay in a register
+  float level[BLOCK_SIZE];
+  float delayed[BLOCK_SIZE];
+  for (int pos=0; pos<count; pos+=BLOCK_SIZE)
   {
-    double rect = fabs(src[i]);	// rectify input
-
-    /* if desired, one could use another EnvelopeDetector to smooth
-     * the rectified signal.
-     */
+    const int block = std::min(count - pos, BLOCK_SIZE);
+    const float *in = src + pos;
 
-    rect += DC_OFFSET;			// add DC offset to avoid log( 0 )
-    double keydB = lin2dB( rect );	// convert linear -> dB
-
-    // threshold
-    double overdB = keydB - threshdB_;	// delta over threshold
-    if ( overdB < 0.0 )
-	    overdB = 0.0;
-
-    // attack/release
-
-    overdB += DC_OFFSET;		// add DC offset to avoid denormal
-
-    if ( overdB > envdB_ )
+      // rectify input, add DC offset to avoid log( 0 ), convert linear -> dB
+      // and calculate the delta over the threshold
+    for (int i=0; i<block; ++i)
     {
-      att_.run( overdB, envdB_ );		// attack
+      level[i] = fastLin2dB(std::fabs(in[i]) + static_cast<float>(DC_OFFSET))
+                 - thresh_db;
     }
-    else
+
+      // attack/release
+    for (int i=0; i<block; ++i)
     {
-      rel_.run( overdB, envdB_ );		// release
+      double overdB = std::max(level[i], 0.0f);
+      overdB += DC_OFFSET;		// add DC offset to avoid denormal
+
+        // Select the coefficient instead of branching since the attack
+        // and release phases alternate quickly for a signal around the
+        // threshold
+      const double coef = ( overdB > envdB ) ? att_coef : rel_coef;
+      envdB = overdB + coef * ( envdB - overdB );
+
+        // subtract DC offset and calculate the gain reduction (dB)
+      level[i] = std::min(std::max((envdB - DC_OFFSET) * reduction, -750.0),
+                          750.0);
     }
 
-    overdB = envdB_ - DC_OFFSET;		// subtract DC offset
-    //cout << overdB << endl;
-
-    /* Regarding the DC offset: In this case, since the offset is added before 
-     * the attack/release processes, the envelope will never fall below the offset,
-     * thereby avoiding denormals. However, to prevent the offset from causing
-     * constant gain reduction, we must subtract it from the envelope, yielding
-     * a minimum value of 0dB.
+    /* Regarding the DC offset: In this case, since the offset is added
+     * before the attack/release processes, the envelope will never fall
+     * below the offset, thereby avoiding denormals. However, to prevent
+     * the offset from causing constant gain reduction, we must subtract it
+     * from the envelope, yielding a minimum value of 0dB.
      */
 
-    // transfer function
-    double gr = overdB * ( ratio_ - 1.0 );    // gain reduction (dB)
-    gr = dB2lin( gr );			      // convert dB -> linear
+      // convert gain reduction dB -> linear
+    for (int i=0; i<block; ++i)
+    {
+      level[i] = gain_lin * fastDb2Lin(level[i]);
+    }
+
+      // With look-ahead, the gain calculated from the incoming samples is
+      // applied to samples delayed by the look-ahead time so that the gain
+      // reduction is in place when a peak reach the output
+    if (!la_buf.empty())
+    {
+      for (int i=0; i<block; ++i)
+      {
+        delayed[i] = la_buf[la_pos];
+        la_buf[la_pos] = in[i];
+        if (++la_pos == la_buf.size())
+        {
+          la_pos = 0;
+        }
+      }
+      la_fill = std::min(la_fill + block, static_cast<unsigned>(la_buf.size()));
+      in = delayed;
+    }
 
-    // output gain
-    dest[i] = output_gain * src[i] * gr;      // apply gain reduction to input
-    
-    //if (fabs(dest[i]) > max_sample)
-    //  max_sample = dest[i];
+      // output gain, apply gain reduction to input
+    audioKernelMultiply(dest + pos, in, level, block);
   }
-  
-  //cout << "max_sample=" << max_sample << endl;
-  
-} /* AudioCompressor::writeSamples */
+  envdB_ = envdB;
+} /* AudioCompressor::processSamples */
 
 
 
@@ -260,6 +369,25 @@ void AudioCompressor::processSamples(float *dest, const float *src, int count)
  *
  ****************************************************************************/
 
+void AudioCompressor::writeLookaheadTail(void)
+{
+    // Push the samples still in the look-ahead delay line out by writing
+    // silence before passing the flush on
+  static const float zeros[BLOCK_SIZE] = { 0.0f };
+  while (la_flush_cnt > 0)
+  {
+    int cnt = std::min(la_flush_cnt, static_cast<unsigned>(BLOCK_SIZE));
+    int ret = AudioProcessor::writeSamples(zeros, cnt);
+    if (ret == 0)
+    {
+      return;
+    }
+    la_flush_cnt -= ret;
+    la_fill = la_flush_cnt;
+  }
+  AudioProcessor::flushSamples();
+} /* AudioCompressor::writeLookaheadTail */
+
 
 
 
@@ -132,6 +132,9 @@ class EnvelopeDetector
 
     virtual double getSampleRate( void ) { return sampleRate_; }
 
+    // runtime coefficient
+    double getCoef( void ) const { return coef_; }
+
     // runtime function
     inline void run( double in, double &state )
     {
@@ -205,6 +208,19 @@ class AudioCompressor : public AudioProcessor
      * @param 	decay_ms The decay time in milliseconds
      */
     void setDecay(double decay_ms) { rel_.setTc(decay_ms); }
+
+    /**
+     * @brief 	Set the look-ahead time
+     * @param 	lookahead_ms The look-ahead time in milliseconds
+     *
+     * With look-ahead enabled the audio is delayed by the given time while
+     * the gain is calculated from the undelayed audio. This make the gain
+     * reduction take effect before a peak reach the output so that a limiter
+     * do not overshoot during the attack time. A look-ahead about the same
+     * as the attack time is a good choice. The default is 0, no look-ahead.
+     * Setting the look-ahead time clears the delay line.
+     */
+    void setLookahead(double lookahead_ms);
   
     /**
      * @brief 	Set the output gain
@@ -221,8 +237,38 @@ class AudioCompressor : public AudioProcessor
      */
     void reset(void);
 
+    /**
+     * @brief 	Write samples into the compressor
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the compressor to flush the previously written samples
+     *
+     * Samples in the look-ahead delay line are written out before the flush
+     * is passed on.
+     */
+    virtual void flushSamples(void);
+
+    /**
+     * @brief Resume audio output to the sink
+     */
+    virtual void resumeOutput(void);
     
   protected:
+    /**
+     * @brief Process incoming samples and put them into the output buffer
+     * @param dest  Destination buffer
+     * @param src   Source buffer
+     * @param count Number of samples in the source buffer
+     *
+     * The level is converted to and from dB using polynomial approximations
+     * so the output may differ by up to about 0.0001 dB from an exact
+     * calculation.
+     */
     virtual void processSamples(float *dest, const float *src, int count);
     
     
@@ -238,9 +284,15 @@ class AudioCompressor : public AudioProcessor
 
     // runtime variables
     double envdB_;			// over-threshold envelope (dB)
+    // look-ahead
+    std::vector<float>  la_buf;		// look-ahead delay line
+    unsigned            la_pos;		// delay line position
+    unsigned            la_fill;	// samples to flush from the delay line
+    unsigned            la_flush_cnt;	// samples left to flush
     
     AudioCompressor(const AudioCompressor&);
     AudioCompressor& operator=(const AudioCompressor&);
+    void writeLookaheadTail(void);
     
 };  /* class AudioCompressor */
 
@@ -38,6 +38,7 @@ ANY KIND. See http://www.dspguru.com/wol.htm for more information.
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncAudioPolyphase.h>
 
 
 /****************************************************************************
@@ -112,6 +113,9 @@ http://www.dsptutor.freeuk.com/remez/RemezFIRFilterDesign.html
 
 This implementation is based on the multirate FAQ at dspguru.com:
 http://dspguru.com/info/faqs/mrfaq.htm
+
+If compiled with USE_Q15_AUDIO defined, the filter is run using 16 bit fixed
+point arithmetic. The samples are then clipped to [-1, 1].
 */
 class AudioDecimator : public AudioProcessor
 {
@@ -147,10 +151,12 @@ class AudioDecimator : public AudioProcessor
 
     
   private:
-    const int 	factor_M;
-    float     	*p_Z;
-    int       	H_size;
-    const float *p_H;
+    const int 	      	      	    factor_M;
+#ifdef USE_Q15_AUDIO
+    AudioPolyphaseDecimator<int16_t> decimator;
+#else
+    AudioPolyphaseDecimator<float>  decimator;
+#endif
     
     AudioDecimator(const AudioDecimator&);
     AudioDecimator& operator=(const AudioDecimator&);
@@ -159,6 +159,20 @@ class AudioDecoder : public AudioSource, public sigc::trackable
      * @param 	size The size of the buffer
      */
     virtual void writeEncodedSamples(void *buf, int size) = 0;
+
+    /**
+     * @brief   Tell the decoder that one or more packets have been lost
+     * @param   next_buf  The packet that was received after the lost ones
+     * @param   next_size The size of that packet
+     * @param   lost_cnt  The number of packets that was lost
+     *
+     * Call this function just before writing the packet that followed the
+     * lost ones. A decoder that support it can use the packet to recover
+     * the lost audio, like the Opus decoder do using inband FEC, or at least
+     * conceal the loss. The default is to do nothing.
+     */
+    virtual void packetLost(void *next_buf, int next_size,
+                            unsigned lost_cnt=1) {}
     
     /**
      * @brief Call this function when all encoded samples have been received
@@ -44,6 +44,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncTracepoint.h>
 
 
 /****************************************************************************
@@ -229,6 +230,7 @@ void AudioDecoderOpus::writeEncodedSamples(void *buf, int size)
   frame_size = opus_decode_float(dec, packet, size, samples,
                                  frame_cnt*frame_size, 0);
   //cout << " " << frame_size << endl;
+  ASYNC_TRACEPOINT(async, opus_decode, size, frame_size);
   if (frame_size > 0)
   {
     sinkWriteSamples(samples, frame_size);
@@ -241,6 +243,53 @@ void AudioDecoderOpus::writeEncodedSamples(void *buf, int size)
 } /* AudioDecoderOpus::writeEncodedSamples */
 
 
+void AudioDecoderOpus::packetLost(void *next_buf, int next_size,
+                                  unsigned lost_cnt)
+{
+  unsigned char *packet = reinterpret_cast<unsigned char *>(next_buf);
+
+    // We do not know how much audio that was lost so assume that the lost
+    // packets had the same length as the next one
+  int frame_size = opus_packet_get_nb_samples(packet, next_size,
+                                              INTERNAL_SAMPLE_RATE);
+  if ((frame_size <= 0) || (lost_cnt == 0))
+  {
+    return;
+  }
+  if (lost_cnt > MAX_CONCEALED_PACKETS)
+  {
+    lost_cnt = MAX_CONCEALED_PACKETS;
+  }
+
+  float samples[frame_size];
+
+    // Conceal all but the last lost packet
+  for (unsigned i=1; i<lost_cnt; ++i)
+  {
+    int cnt = opus_decode_float(dec, 0, 0, samples, frame_size, 0);
+    if (cnt < 0)
+    {
+      cerr << "**** ERROR: Opus decoder error: " << opus_strerror(cnt)
+           << endl;
+      return;
+    }
+    sinkWriteSamples(samples, cnt);
+  }
+
+    // Recover the last lost packet from the FEC data in the next packet. If
+    // there is no FEC data, the decoder fall back to concealment.
+  int cnt = opus_decode_float(dec, packet, next_size, samples, frame_size, 1);
+  if (cnt > 0)
+  {
+    sinkWriteSamples(samples, cnt);
+  }
+  else if (cnt < 0)
+  {
+    cerr << "**** ERROR: Opus decoder error: " << opus_strerror(cnt) << endl;
+  }
+} /* AudioDecoderOpus::packetLost */
+
+
 
 /****************************************************************************
  *
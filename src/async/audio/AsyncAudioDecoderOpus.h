@@ -166,6 +166,26 @@ class AudioDecoderOpus : public AudioDecoder
      * @param 	size The size of the buffer
      */
     virtual void writeEncodedSamples(void *buf, int size);
+
+    /**
+     * @brief   Tell the decoder that one or more packets have been lost
+     * @param   next_buf  The packet that was received after the lost ones
+     * @param   next_size The size of that packet
+     * @param   lost_cnt  The number of packets that was lost
+     *
+     * If the encoder had inband FEC enabled, the last lost frame is
+     * recovered from the next packet. The Opus packet loss concealment is
+     * used to fill in the rest of the gap, up to MAX_CONCEALED_PACKETS
+     * packets. A longer gap is not filled in since the concealed audio fade
+     * out anyway.
+     */
+    virtual void packetLost(void *next_buf, int next_size,
+                            unsigned lost_cnt=1);
+
+    /**
+     * @brief   The maximum number of lost packets to fill in
+     */
+    static const unsigned MAX_CONCEALED_PACKETS = 5;
     
 
   protected:
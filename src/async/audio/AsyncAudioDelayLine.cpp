@@ -6,7 +6,7 @@
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2003-2010 Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -35,6 +35,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cstring>
 #include <cmath>
 #include <algorithm>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
 
 
 /****************************************************************************
@@ -52,6 +56,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "AsyncAudioDelayLine.h"
+#include "AsyncAudioKernels.h"
 
 
 
@@ -105,6 +110,12 @@ using namespace Async;
  *
  ****************************************************************************/
 
+  // Released buffers, indexed by their size in bytes. Delay lines are used
+  // in more than one thread, e.g. by receivers in worker threads, so the
+  // pool is protected by a lock.
+static map<size_t, vector<void*> > buffer_pool;
+static std::mutex buffer_pool_mutex;
+
 
 
 /****************************************************************************
@@ -114,12 +125,10 @@ using namespace Async;
  ****************************************************************************/
 
 AudioDelayLine::AudioDelayLine(int length_ms)
-  : size(length_ms * INTERNAL_SAMPLE_RATE / 1000), ptr(0), flush_cnt(0),
-    is_muted(false), mute_cnt(0), last_clear(0), fade_gain(0), fade_len(0),
-    fade_pos(0), fade_dir(0)
+  : buf(0), compact(false), size(length_ms * INTERNAL_SAMPLE_RATE / 1000),
+    ptr(0), flush_cnt(0), is_muted(false), mute_cnt(0), last_clear(0),
+    fade_gain(0), fade_len(0), fade_pos(0), fade_dir(0)
 {
-  buf = new float[size];
-  memset(buf, 0, size * sizeof(*buf));
   clear();
   setFadeTime(DEFAULT_FADE_TIME);
 } /* AudioDelayLine::AudioDelayLine */
@@ -128,7 +137,7 @@ AudioDelayLine::AudioDelayLine(int length_ms)
 AudioDelayLine::~AudioDelayLine(void)
 {
   delete [] fade_gain;
-  delete [] buf;
+  ::operator delete(buf);
 } /* AudioDelayLine::~AudioDelayLine */
 
 
@@ -156,6 +165,34 @@ void AudioDelayLine::setFadeTime(int time_ms)
 } /* AudioDelayLine::setFadeTime  */
 
 
+void AudioDelayLine::setCompactStorage(bool enable)
+{
+  if (enable == compact)
+  {
+    return;
+  }
+
+  if (buf != 0)
+  {
+    void *new_buf =
+      ::operator new(size * (enable ? sizeof(int16_t) : sizeof(float)));
+    if (enable)
+    {
+      audioKernelToS16(static_cast<int16_t*>(new_buf),
+                       static_cast<const float*>(buf), size);
+    }
+    else
+    {
+      audioKernelFromS16(static_cast<float*>(new_buf),
+                         static_cast<const int16_t*>(buf), size);
+    }
+    ::operator delete(buf);
+    buf = new_buf;
+  }
+  compact = enable;
+} /* AudioDelayLine::setCompactStorage */
+
+
 void AudioDelayLine::mute(bool do_mute, int time_ms)
 {
   int mute_ext = 0;
@@ -168,12 +205,7 @@ void AudioDelayLine::mute(bool do_mute, int time_ms)
   {
     fade_pos = 0; // Reset fade gain
     fade_dir = 1; // Fade out
-    ptr = (ptr + size - mute_ext) % size;
-    for (int i=0; i<mute_ext; ++i)
-    {
-      ptr = (ptr < size-1) ? ptr+1 : 0;
-      buf[ptr] *= currentFadeGain();
-    }
+    fadeBuffer((ptr + size - mute_ext) % size, mute_ext);
     is_muted = true;
     mute_cnt = 0;
   }
@@ -206,12 +238,7 @@ void AudioDelayLine::clear(int time_ms)
 
   //fade_pos = 0; // Reset fade gain
   fade_dir = 1; // Fade out
-  ptr = (ptr + size - count) % size;
-  for (int i=0; i<count; ++i)
-  {
-    ptr = (ptr < size-1) ? ptr+1 : 0;
-    buf[ptr] *= currentFadeGain();
-  }
+  fadeBuffer((ptr + size - count) % size, count);
 
   if (!is_muted)
   {
@@ -229,26 +256,29 @@ int AudioDelayLine::writeSamples(const float *samples, int count)
   last_clear = 0;
   
   count = min(count, size);
-  float output[count];
-  int out_ptr = ptr;
-  for (int i=0; i<count; ++i)
-  {
-    output[i] = buf[out_ptr];
-    out_ptr = (out_ptr < size-1) ? out_ptr+1 : 0;
-  }
+  float block[count];
+  readBuffer(ptr, block, count);
 
-  int written = sinkWriteSamples(output, count);
+  int written = writeDelayedSamples(block, count);
+  trace_queue.push(written);
 
-  for (int i=0; i<written; ++i)
+    // The sink have copied the delayed samples so the block is reused for
+    // the faded input samples.
+  int faded = 0;
+  if (is_muted && (mute_cnt > 0))
   {
-    buf[ptr] = samples[i] * currentFadeGain();
-    if (is_muted && (mute_cnt > 0) && (--mute_cnt == 0))
+    faded = min(written, mute_cnt);
+    applyFade(block, samples, faded);
+    mute_cnt -= faded;
+    if (mute_cnt == 0)
     {
       fade_dir = -1; // Fade in
       is_muted = false;
     }
-    ptr = (ptr < size-1) ? ptr+1 : 0;
   }
+  applyFade(block + faded, samples + faded, written - faded);
+  writeBuffer(ptr, block, written);
+  ptr = (ptr + written) % size;
   
   return written;
   
@@ -265,6 +295,7 @@ void AudioDelayLine::flushSamples(void)
   }
   else
   {
+    releaseBuffer();
     sinkFlushSamples();
   }
 } /* AudioDelayLine::flushSamples */
@@ -306,38 +337,193 @@ void AudioDelayLine::allSamplesFlushed(void)
 
 void AudioDelayLine::writeRemainingSamples(void)
 {
-  float output[512];
+  float output[BLOCK_SIZE];
   int written = 1; // Set to 1 so that we enter the loop the first time around
 
   while ((written > 0) && (flush_cnt > 0))
   {
-    int count = min(512, flush_cnt);
-    
-    int out_ptr = ptr;
-    for (int i=0; i<count; ++i)
-    {
-      output[i] = buf[out_ptr];
-      out_ptr = (out_ptr < size-1) ? out_ptr+1 : 0;
-    }
+    int count = min(static_cast<int>(BLOCK_SIZE), flush_cnt);
+    readBuffer(ptr, output, count);
+    written = writeDelayedSamples(output, count);
 
-    written = sinkWriteSamples(output, count);
-
-    for (int i=0; i<written; ++i)
+    if (buf != 0)
     {
-      buf[ptr] = 0;
-      ptr = (ptr < size-1) ? ptr+1 : 0;
+      memset(output, 0, written * sizeof(*output));
+      writeBuffer(ptr, output, written);
     }
+    ptr = (ptr + written) % size;
 
     flush_cnt -= written;
   }
   
   if (flush_cnt == 0)
   {
+      // Nothing but silence is left in the buffer so it is not needed
+      // until new samples arrive
+    releaseBuffer();
     sinkFlushSamples();
   }
 } /* AudioDelayLine::writeRemainingSamples */
 
 
+  // The trace queue only cover the newest samples in the buffer if not all
+  // of them have been written while tracing. The oldest are untagged.
+int AudioDelayLine::writeDelayedSamples(const float *output, int count)
+{
+  const int untagged = size - trace_queue.size();
+  int written;
+  {
+    AudioTrace::Scope trace_scope(
+        (untagged > 0) ? AudioTrace::Tag() : trace_queue.front());
+    written = sinkWriteSamples(output, count);
+  }
+  if (written > untagged)
+  {
+    trace_queue.pop(written - untagged);
+  }
+  return written;
+} /* AudioDelayLine::writeDelayedSamples */
+
+
+size_t AudioDelayLine::bufferBytes(void) const
+{
+  return size * (compact ? sizeof(int16_t) : sizeof(float));
+} /* AudioDelayLine::bufferBytes */
+
+
+void AudioDelayLine::allocBuffer(void)
+{
+  buf = 0;
+  {
+    std::lock_guard<std::mutex> lk(buffer_pool_mutex);
+    vector<void*>& pool = buffer_pool[bufferBytes()];
+    if (!pool.empty())
+    {
+      buf = pool.back();
+      pool.pop_back();
+    }
+  }
+  if (buf == 0)
+  {
+    buf = ::operator new(bufferBytes());
+  }
+  memset(buf, 0, bufferBytes());
+} /* AudioDelayLine::allocBuffer */
+
+
+void AudioDelayLine::releaseBuffer(void)
+{
+  if (buf != 0)
+  {
+    std::lock_guard<std::mutex> lk(buffer_pool_mutex);
+    buffer_pool[bufferBytes()].push_back(buf);
+    buf = 0;
+  }
+} /* AudioDelayLine::releaseBuffer */
+
+
+  // A released buffer read as silence
+void AudioDelayLine::readBuffer(int pos, float *dest, int count)
+{
+  if (buf == 0)
+  {
+    memset(dest, 0, count * sizeof(*dest));
+    return;
+  }
+
+  while (count > 0)
+  {
+    int chunk = min(count, size - pos);
+    if (compact)
+    {
+      audioKernelFromS16(dest, static_cast<int16_t*>(buf) + pos, chunk);
+    }
+    else
+    {
+      memcpy(dest, static_cast<float*>(buf) + pos, chunk * sizeof(*dest));
+    }
+    dest += chunk;
+    count -= chunk;
+    pos = 0;
+  }
+} /* AudioDelayLine::readBuffer */
+
+
+void AudioDelayLine::writeBuffer(int pos, const float *src, int count)
+{
+  if (buf == 0)
+  {
+    allocBuffer();
+  }
+
+  while (count > 0)
+  {
+    int chunk = min(count, size - pos);
+    if (compact)
+    {
+      audioKernelToS16(static_cast<int16_t*>(buf) + pos, src, chunk);
+    }
+    else
+    {
+      memcpy(static_cast<float*>(buf) + pos, src, chunk * sizeof(*src));
+    }
+    src += chunk;
+    count -= chunk;
+    pos = 0;
+  }
+} /* AudioDelayLine::writeBuffer */
+
+
+void AudioDelayLine::fadeBuffer(int pos, int count)
+{
+  float block[BLOCK_SIZE];
+  while (count > 0)
+  {
+    int chunk = min(count, static_cast<int>(BLOCK_SIZE));
+    readBuffer(pos, block, chunk);
+    applyFade(block, block, chunk);
+    if (buf != 0)
+    {
+      writeBuffer(pos, block, chunk);
+    }
+    pos = (pos + chunk) % size;
+    count -= chunk;
+  }
+} /* AudioDelayLine::fadeBuffer */
+
+
+  // Only the samples in an ongoing fade need a gain each. When the fade is
+  // done the rest of the block get the same gain.
+void AudioDelayLine::applyFade(float *dest, const float *src, int count)
+{
+  int i = 0;
+  if (fade_gain != 0)
+  {
+    for (; (i<count) && (fade_dir != 0); ++i)
+    {
+      dest[i] = src[i] * currentFadeGain();
+    }
+  }
+
+  const float gain = (fade_gain != 0) ? fade_gain[fade_pos] : 1.0f;
+  if (gain == 1.0f)
+  {
+    if (dest != src)
+    {
+      memcpy(dest + i, src + i, (count - i) * sizeof(*dest));
+    }
+  }
+  else if (gain == 0.0f)
+  {
+    memset(dest + i, 0, (count - i) * sizeof(*dest));
+  }
+  else
+  {
+    audioKernelGain(dest + i, src + i, gain, count - i);
+  }
+} /* AudioDelayLine::applyFade */
+
+
 
 /*
  * This file has not been truncated
@@ -6,7 +6,7 @@
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2003-2010  Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026  Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -35,6 +35,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <cstddef>
 
 
 /****************************************************************************
@@ -45,6 +46,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncAudioSink.h>
 #include <AsyncAudioSource.h>
+#include <AsyncAudioTrace.h>
 
 
 /****************************************************************************
@@ -113,6 +115,11 @@ the specified amount of time. This can be useful if you want to mute audio
 based on a slow detector. With a delay line you have the possibility to
 mute audio that have passed the detector but have not yet passed through the
 delay line.
+
+The buffer is released when the delay line has been flushed and is allocated
+again when new samples arrive. Released buffers are kept in a pool shared by
+all delay lines so that many receivers, of which only a few are active at the
+same time, do not each need to hold on to their own buffer.
 */
 class AudioDelayLine : public Async::AudioSink, public Async::AudioSource
 {
@@ -138,6 +145,18 @@ class AudioDelayLine : public Async::AudioSink, public Async::AudioSource
      * The default is 10 milliseconds. Set to 0 to turn off.
      */
     void setFadeTime(int time_ms);
+
+    /**
+     * @brief   Store the delayed samples as 16 bit integers
+     * @param   enable Set to \em true to use 16 bit storage
+     *
+     * A delay line use four bytes per sample by default. With compact
+     * storage the samples are stored using two bytes per sample, which
+     * halve the memory used by long delay lines at the cost of some
+     * precision. Samples outside of [-1, 1] are clipped. The samples already
+     * in the delay line are converted.
+     */
+    void setCompactStorage(bool enable);
     
     /**
      * @brief 	Mute audio
@@ -208,8 +227,10 @@ class AudioDelayLine : public Async::AudioSink, public Async::AudioSource
     
   private:
     static const int DEFAULT_FADE_TIME = 10; // 10ms default fade time
+    static const int BLOCK_SIZE = 512;
 
-    float	*buf;
+    void	*buf;
+    bool	compact;
     int		size;
     int		ptr;
     int		flush_cnt;
@@ -220,10 +241,19 @@ class AudioDelayLine : public Async::AudioSink, public Async::AudioSource
     int		fade_len;
     int		fade_pos;
     int		fade_dir;
+    AudioTrace::Queue trace_queue;
     
     AudioDelayLine(const AudioDelayLine&);
     AudioDelayLine& operator=(const AudioDelayLine&);
     void writeRemainingSamples(void);
+    int writeDelayedSamples(const float *output, int count);
+    size_t bufferBytes(void) const;
+    void allocBuffer(void);
+    void releaseBuffer(void);
+    void readBuffer(int pos, float *dest, int count);
+    void writeBuffer(int pos, const float *src, int count);
+    void fadeBuffer(int pos, int count);
+    void applyFade(float *dest, const float *src, int count);
 
     inline float currentFadeGain(void)
     {
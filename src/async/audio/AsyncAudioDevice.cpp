@@ -56,9 +56,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "AsyncFdWatch.h"
+#include "AsyncTracepoint.h"
 #include "AsyncAudioIO.h"
 #include "AsyncAudioDevice.h"
 #include "AsyncAudioDeviceFactory.h"
+#include "AsyncAudioKernels.h"
 
 
 /****************************************************************************
@@ -266,31 +268,91 @@ AudioDevice::~AudioDevice(void)
 void AudioDevice::putBlocks(int16_t *buf, size_t frame_cnt)
 {
   //printf("putBlocks: frame_cnt=%zu\n", frame_cnt);
-  float samples[frame_cnt];
+  ASYNC_TRACEPOINT(async, audio_dev_read, dev_name.c_str(), frame_cnt);
+  float samples[channels * frame_cnt];
+  float *chbuf[channels];
   for (size_t ch=0; ch<channels; ch++)
   {
-    for (size_t i=0; i<frame_cnt; i++)
-    {
-        // no divisions in index calculation (embedded system performance !!!)
-      samples[i] = static_cast<float>(buf[i * channels + ch]) / 32768.0;
-    }
-    list<AudioIO*>::iterator it;
-    for (it=aios.begin(); it!=aios.end(); ++it)
-    {
-      if ((*it)->channel() == ch)
-      {
-        (*it)->audioRead(samples, frame_cnt);
-      }
-    }
+    chbuf[ch] = samples + ch * frame_cnt;
+  }
+  audioKernelDeinterleaveS16(chbuf, buf, channels, frame_cnt);
+  writeChannels(chbuf, frame_cnt);
+} /* AudioDevice::putBlocks */
+
+
+void AudioDevice::putBlocks(const float *buf, size_t frame_cnt)
+{
+  ASYNC_TRACEPOINT(async, audio_dev_read, dev_name.c_str(), frame_cnt);
+  float samples[channels * frame_cnt];
+  float *chbuf[channels];
+  for (size_t ch=0; ch<channels; ch++)
+  {
+    chbuf[ch] = samples + ch * frame_cnt;
   }
+  audioKernelDeinterleave(chbuf, buf, channels, frame_cnt);
+  writeChannels(chbuf, frame_cnt);
 } /* AudioDevice::putBlocks */
 
 
 size_t AudioDevice::getBlocks(int16_t *buf, size_t block_cnt)
+{
+  const size_t frame_cnt = block_cnt * writeBlocksize();
+  float samples[channels * frame_cnt];
+  float *chbuf[channels];
+  for (size_t ch=0; ch<channels; ch++)
+  {
+    chbuf[ch] = samples + ch * frame_cnt;
+  }
+  size_t blocks = readChannels(chbuf, block_cnt);
+  audioKernelInterleaveS16(buf, chbuf, channels, blocks * writeBlocksize());
+  return blocks;
+} /* AudioDevice::getBlocks */
+
+
+size_t AudioDevice::getBlocks(float *buf, size_t block_cnt)
+{
+  const size_t frame_cnt = block_cnt * writeBlocksize();
+  float samples[channels * frame_cnt];
+  float *chbuf[channels];
+  for (size_t ch=0; ch<channels; ch++)
+  {
+    chbuf[ch] = samples + ch * frame_cnt;
+  }
+  size_t blocks = readChannels(chbuf, block_cnt);
+  audioKernelInterleave(buf, chbuf, channels, blocks * writeBlocksize());
+  return blocks;
+} /* AudioDevice::getBlocks */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void AudioDevice::writeChannels(float *const *chbuf, size_t frame_cnt)
+{
+  list<AudioIO*>::iterator it;
+  for (it=aios.begin(); it!=aios.end(); ++it)
+  {
+    size_t ch = (*it)->channel();
+    if (ch < channels)
+    {
+      (*it)->audioRead(chbuf[ch], frame_cnt);
+    }
+  }
+} /* AudioDevice::writeChannels */
+
+
+size_t AudioDevice::readChannels(float *const *chbuf, size_t block_cnt)
 {
   size_t block_size = writeBlocksize();
   size_t frames_to_write = block_cnt * block_size;
-  memset(buf, 0, channels * frames_to_write * sizeof(*buf));
+  for (size_t ch=0; ch<channels; ch++)
+  {
+    memset(chbuf[ch], 0, frames_to_write * sizeof(*chbuf[ch]));
+  }
   
     // Loop through all AudioIO objects and find out if they have any
     // samples to write and how many. The non-flushing AudioIO object with
@@ -354,22 +416,9 @@ size_t AudioDevice::getBlocks(int16_t *buf, size_t block_cnt)
       float tmp[frames_to_write];
       int samples_read = (*it)->readSamples(tmp, frames_to_write);
       assert(samples_read >= 0);
-      for (size_t i=0; i<static_cast<size_t>(samples_read); ++i)
+      if (channel < channels)
       {
-	int buf_pos = i * channels + channel;
-	float sample = 32767.0 * tmp[i] + buf[buf_pos];
-	if (sample > 32767)
-	{
-	  buf[buf_pos] = 32767;
-	}
-	else if (sample < -32767)
-	{
-	  buf[buf_pos] = -32767;
-	}
-	else
-	{
-	  buf[buf_pos] = static_cast<int16_t>(sample);
-	}
+        audioKernelAccumulate(chbuf[channel], tmp, samples_read);
       }
     }
   }  
@@ -382,18 +431,12 @@ size_t AudioDevice::getBlocks(int16_t *buf, size_t block_cnt)
     frames_to_write /= block_size;
     frames_to_write = (frames_to_write + 1) * block_size;
   }
-  
+
+  ASYNC_TRACEPOINT(async, audio_dev_write, dev_name.c_str(), frames_to_write,
+                   do_flush);
   return frames_to_write / block_size;
   
-} /* AudioDevice::getBlocks */
-
-
-
-/****************************************************************************
- *
- * Private member functions
- *
- ****************************************************************************/
+} /* AudioDevice::readChannels */
 
 
 /*
@@ -354,6 +354,29 @@ class AudioDevice : public sigc::trackable
      */
     size_t getBlocks(int16_t *buf, size_t block_cnt);
 
+    /**
+     * @brief   Write float samples read from audio device to upper layers
+     * @param   buf       Buffer containing frames of samples to write
+     * @param   frame_cnt The number of frames of samples in the buffer
+     *
+     * This function work like the 16 bit version of putBlocks but take
+     * floating point samples in the range -1.0 to 1.0. It is used by audio
+     * devices that natively transfer float samples so that no conversion is
+     * needed.
+     */
+    void putBlocks(const float *buf, size_t frame_cnt);
+
+    /**
+     * @brief   Read float samples from upper layers to write to audio device
+     * @brief   buf       Buffer which will be filled with frames of samples
+     * @brief   block_cnt The size of the buffer counted in blocks
+     * @return  The number of blocks actually stored in the buffer
+     *
+     * This function work like the 16 bit version of getBlocks but fill the
+     * buffer with floating point samples. The samples are not clipped.
+     */
+    size_t getBlocks(float *buf, size_t block_cnt);
+
   private:
     static const int    DEFAULT_SAMPLE_RATE = INTERNAL_SAMPLE_RATE;
     static const size_t DEFAULT_CHANNELS = 2;
@@ -366,6 +389,9 @@ class AudioDevice : public sigc::trackable
     size_t              use_count;
     std::list<AudioIO*> aios;
 
+    void writeChannels(float *const *chbuf, size_t frame_cnt);
+    size_t readChannels(float *const *chbuf, size_t block_cnt);
+
 };  /* class AudioDevice */
 
 
@@ -35,11 +35,21 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <sigc++/sigc++.h>
+#include <sys/eventfd.h>
 #include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <stdint.h>
 #include <iostream>
 #include <sstream>
 #include <cmath>
 #include <cstring>
+#include <cerrno>
+#include <cassert>
+#include <cstdlib>
+#include <atomic>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -49,6 +59,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncFdWatch.h>
+#include <AsyncMetrics.h>
+#include <AsyncRealtime.h>
 
 
 /****************************************************************************
@@ -101,12 +113,14 @@ class AudioDeviceAlsa::AlsaWatch : public sigc::trackable
         if (pfds[i].events & POLLOUT)
         {
           FdWatch *watch = new FdWatch(pfds[i].fd, FdWatch::FD_WATCH_WR);
+          watch->setLabel("Async::AudioDeviceAlsa write");
           watch->activity.connect(mem_fun(*this, &AlsaWatch::writeEvent));
           watch_list.push_back(watch);
         }
         if (pfds[i].events & POLLIN)
         {
           FdWatch *watch = new FdWatch(pfds[i].fd, FdWatch::FD_WATCH_RD);
+          watch->setLabel("Async::AudioDeviceAlsa read");
           watch->activity.connect(mem_fun(*this, &AlsaWatch::readEvent));
           watch_list.push_back(watch);
         }
@@ -158,6 +172,413 @@ class AudioDeviceAlsa::AlsaWatch : public sigc::trackable
 };
 
 
+/*
+ * This class runs the mmap transfers for one PCM stream in a separate thread.
+ * Audio is exchanged with the main loop through a single producer/single
+ * consumer ring buffer of interleaved frames. For a playback stream the main
+ * loop is the producer and the I/O thread is the consumer, for a capture
+ * stream it is the other way around. The I/O thread never call into the rest
+ * of the library. It only signal the main loop, through an eventfd, when it
+ * has consumed or produced a period.
+ */
+class AudioDeviceAlsa::MmapStream : public sigc::trackable
+{
+  public:
+    MmapStream(snd_pcm_t *pcm_handle, snd_pcm_stream_t stream,
+               size_t channels, size_t period_size, size_t period_count,
+               size_t ring_periods, bool zerofill, MetricCounter *xrun_cnt)
+      : pcm_handle(pcm_handle), stream(stream), channels(channels),
+        period_size(period_size), buffer_size(period_size * period_count),
+        zerofill(zerofill), head(0), tail(0), hw_delay(0), err(0),
+        stop(false), starving(false), wakeup_pending(false), ring(0),
+        ring_frames(1), ring_mask(0), ring_capacity(period_size * ring_periods),
+        main_fd(-1),
+        thread_fd(-1), main_watch(0), thread_started(false),
+        xrun_cnt(xrun_cnt)
+    {
+      while (ring_frames < ring_capacity)
+      {
+        ring_frames <<= 1;
+      }
+      ring_mask = ring_frames - 1;
+      ring = new int16_t[ring_frames * channels];
+    }
+
+    ~MmapStream(void)
+    {
+      if (thread_started)
+      {
+        Realtime::instance().releaseThread(thread);
+        stop = true;
+        kick();
+        pthread_join(thread, NULL);
+      }
+      delete main_watch;
+      if (main_fd >= 0)
+      {
+        ::close(main_fd);
+      }
+      if (thread_fd >= 0)
+      {
+        ::close(thread_fd);
+      }
+      delete [] ring;
+    }
+
+    bool start(int rt_prio)
+    {
+      main_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      thread_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if ((main_fd < 0) || (thread_fd < 0))
+      {
+        cerr << "*** ERROR: Could not create eventfd for ALSA I/O thread: "
+             << strerror(errno) << endl;
+        return false;
+      }
+      main_watch = new FdWatch(main_fd, FdWatch::FD_WATCH_RD);
+      main_watch->setLabel("Async::AudioDeviceAlsa mmap");
+      main_watch->activity.connect(mem_fun(*this, &MmapStream::onWakeup));
+
+      int ret = pthread_create(&thread, NULL, threadFunc, this);
+      if (ret != 0)
+      {
+        cerr << "*** ERROR: pthread_create: " << strerror(ret) << endl;
+        return false;
+      }
+      thread_started = true;
+
+        // In realtime mode the I/O thread is scheduled just above the main
+        // loop that feed it, using the configured realtime policy
+      if (Realtime::instance().isEnabled())
+      {
+        Realtime::instance().promoteThread(thread, "ALSA I/O", 1);
+      }
+      else if (rt_prio > 0)
+      {
+        sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = min(rt_prio, sched_get_priority_max(SCHED_FIFO));
+        ret = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if (ret != 0)
+        {
+          cerr << "*** WARNING: Could not set SCHED_FIFO priority "
+               << param.sched_priority << " for the ALSA I/O thread: "
+               << strerror(ret) << ". Running with normal priority.\n";
+        }
+      }
+      return true;
+    }
+
+      // Functions called from the main loop thread
+    size_t framesAvail(void) const
+    {
+      const unsigned t = tail.load(memory_order_acquire);
+      return head.load(memory_order_acquire) - t;
+    }
+
+    size_t spaceAvail(void) const
+    {
+      return ring_capacity - framesAvail();
+    }
+
+    size_t samplesToWrite(void) const
+    {
+      return framesAvail() + hw_delay.load(memory_order_relaxed);
+    }
+
+    int error(void) const { return err.load(memory_order_acquire); }
+
+    void write(const int16_t *buf, size_t frames)
+    {
+      const unsigned h = head.load(memory_order_relaxed);
+      assert(frames <= ring_capacity - (h - tail.load(memory_order_acquire)));
+      copyToRing(h, buf, frames);
+        // Sequential consistency is needed between the head update and the
+        // check of the starving flag so that a kick is never lost
+      head.store(h + frames, memory_order_seq_cst);
+      if (starving.load(memory_order_seq_cst))
+      {
+        kick();
+      }
+    }
+
+    void read(int16_t *buf, size_t frames)
+    {
+      const unsigned t = tail.load(memory_order_relaxed);
+      assert(frames <= head.load(memory_order_acquire) - t);
+      copyFromRing(t, buf, frames);
+      tail.store(t + frames, memory_order_release);
+    }
+
+      // May be called from any thread to have the activity signal emitted
+      // from the main loop. Like for the FdWatch in the read/write mode, the
+      // rest of the audio pipe is never called directly from a callback.
+    void wakeupMainLoop(void)
+    {
+      if (!wakeup_pending.exchange(true, memory_order_acq_rel))
+      {
+        const uint64_t one = 1;
+        ssize_t ret = ::write(main_fd, &one, sizeof(one));
+        (void)ret;
+      }
+    }
+
+    sigc::signal<void, MmapStream*> activity;
+
+  private:
+    snd_pcm_t             *pcm_handle;
+    snd_pcm_stream_t      stream;
+    size_t                channels;
+    size_t                period_size;
+    size_t                buffer_size;
+    bool                  zerofill;
+    std::atomic<unsigned> head;
+    std::atomic<unsigned> tail;
+    std::atomic<unsigned> hw_delay;
+    std::atomic<int>      err;
+    std::atomic<bool>     stop;
+    std::atomic<bool>     starving;
+    std::atomic<bool>     wakeup_pending;
+    int16_t               *ring;
+    size_t                ring_frames;
+    size_t                ring_mask;
+    size_t                ring_capacity;
+    int                   main_fd;
+    int                   thread_fd;
+    FdWatch               *main_watch;
+    pthread_t             thread;
+    bool                  thread_started;
+    MetricCounter         *xrun_cnt;
+
+    void copyToRing(unsigned pos, const int16_t *buf, size_t frames)
+    {
+      const size_t idx = pos & ring_mask;
+      const size_t n1 = min(frames, ring_frames - idx);
+      memcpy(ring + idx * channels, buf, n1 * channels * sizeof(*ring));
+      memcpy(ring, buf + n1 * channels,
+             (frames - n1) * channels * sizeof(*ring));
+    }
+
+    void copyFromRing(unsigned pos, int16_t *buf, size_t frames)
+    {
+      const size_t idx = pos & ring_mask;
+      const size_t n1 = min(frames, ring_frames - idx);
+      memcpy(buf, ring + idx * channels, n1 * channels * sizeof(*ring));
+      memcpy(buf + n1 * channels, ring,
+             (frames - n1) * channels * sizeof(*ring));
+    }
+
+    void kick(void)
+    {
+      const uint64_t one = 1;
+      ssize_t ret = ::write(thread_fd, &one, sizeof(one));
+      (void)ret;
+    }
+
+    void onWakeup(FdWatch *watch)
+    {
+      uint64_t cnt;
+      ssize_t ret = ::read(main_fd, &cnt, sizeof(cnt));
+      (void)ret;
+      wakeup_pending.exchange(false, memory_order_acq_rel);
+      activity(this);
+    }
+
+    static void *threadFunc(void *arg)
+    {
+      static_cast<MmapStream*>(arg)->run();
+      return NULL;
+    }
+
+      // Functions called from the I/O thread
+    bool recover(void)
+    {
+      xrun_cnt->inc();
+      int ret = snd_pcm_prepare(pcm_handle);
+      if ((ret >= 0) && (stream == SND_PCM_STREAM_CAPTURE))
+      {
+        ret = snd_pcm_start(pcm_handle);
+      }
+      if (ret < 0)
+      {
+        err.store(ret, memory_order_release);
+        return false;
+      }
+      return true;
+    }
+
+    void run(void)
+    {
+      const int nfds = snd_pcm_poll_descriptors_count(pcm_handle);
+      pollfd pfds[nfds + 1];
+      pfds[0].fd = thread_fd;
+      pfds[0].events = POLLIN;
+      snd_pcm_poll_descriptors(pcm_handle, pfds + 1, nfds);
+
+      while (!stop.load(memory_order_acquire))
+      {
+          // While waiting for the main loop to provide more audio, only
+          // wait for the kick since the PCM will be reported as writable
+        const bool only_kick = starving.load(memory_order_relaxed);
+        if (poll(pfds, only_kick ? 1 : nfds + 1, -1) < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          err.store(-errno, memory_order_release);
+          break;
+        }
+        if (pfds[0].revents & POLLIN)
+        {
+          uint64_t cnt;
+          ssize_t ret = ::read(thread_fd, &cnt, sizeof(cnt));
+          (void)ret;
+          starving.store(false, memory_order_release);
+        }
+        const bool ok = (stream == SND_PCM_STREAM_PLAYBACK)
+                        ? transferPlayback() : transferCapture();
+        if (!ok)
+        {
+          break;
+        }
+      }
+
+      if (err.load(memory_order_acquire) < 0)
+      {
+        wakeupMainLoop();
+      }
+    }
+
+    bool transferPlayback(void)
+    {
+      for (;;)
+      {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm_handle);
+        if (avail < 0)
+        {
+          if (!recover())
+          {
+            return false;
+          }
+          continue;
+        }
+        hw_delay.store(buffer_size - min(static_cast<size_t>(avail),
+                                         buffer_size),
+                       memory_order_relaxed);
+        if (static_cast<size_t>(avail) < period_size)
+        {
+          return true;
+        }
+
+        const unsigned t = tail.load(memory_order_relaxed);
+        const size_t ring_avail = head.load(memory_order_acquire) - t;
+        if ((ring_avail == 0) && !zerofill)
+        {
+          starving.store(true, memory_order_seq_cst);
+          if (head.load(memory_order_seq_cst) != t)
+          {
+            starving.store(false, memory_order_relaxed);
+            continue;
+          }
+          wakeupMainLoop();
+          return true;
+        }
+
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = period_size;
+        int ret = snd_pcm_mmap_begin(pcm_handle, &areas, &offset, &frames);
+        if (ret < 0)
+        {
+          if (!recover())
+          {
+            return false;
+          }
+          continue;
+        }
+        int16_t *dest = reinterpret_cast<int16_t*>(
+            static_cast<char*>(areas[0].addr) +
+            (areas[0].first + offset * areas[0].step) / 8);
+        const size_t n = min(static_cast<size_t>(frames), ring_avail);
+        copyFromRing(t, dest, n);
+        memset(dest + n * channels, 0, (frames - n) * channels * sizeof(*dest));
+        tail.store(t + n, memory_order_release);
+
+        snd_pcm_sframes_t committed =
+            snd_pcm_mmap_commit(pcm_handle, offset, frames);
+        if ((committed < 0) ||
+            (static_cast<snd_pcm_uframes_t>(committed) != frames))
+        {
+          if (!recover())
+          {
+            return false;
+          }
+        }
+        wakeupMainLoop();
+      }
+    }
+
+    bool transferCapture(void)
+    {
+      for (;;)
+      {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm_handle);
+        if (avail < 0)
+        {
+          if (!recover())
+          {
+            return false;
+          }
+          continue;
+        }
+        if (static_cast<size_t>(avail) < period_size)
+        {
+          return true;
+        }
+
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = period_size;
+        int ret = snd_pcm_mmap_begin(pcm_handle, &areas, &offset, &frames);
+        if (ret < 0)
+        {
+          if (!recover())
+          {
+            return false;
+          }
+          continue;
+        }
+        const int16_t *src = reinterpret_cast<const int16_t*>(
+            static_cast<const char*>(areas[0].addr) +
+            (areas[0].first + offset * areas[0].step) / 8);
+
+          // If the main loop has not kept up, the new frames are thrown away
+        const unsigned h = head.load(memory_order_relaxed);
+        const size_t space = ring_capacity - (h - tail.load(memory_order_acquire));
+        const size_t n = min(static_cast<size_t>(frames), space);
+        copyToRing(h, src, n);
+        head.store(h + n, memory_order_release);
+
+        snd_pcm_sframes_t committed =
+            snd_pcm_mmap_commit(pcm_handle, offset, frames);
+        if ((committed < 0) ||
+            (static_cast<snd_pcm_uframes_t>(committed) != frames))
+        {
+          if (!recover())
+          {
+            return false;
+          }
+        }
+        if (n > 0)
+        {
+          wakeupMainLoop();
+        }
+      }
+    }
+};
+
+
 /****************************************************************************
  *
  * Prototypes
@@ -194,16 +615,52 @@ AudioDeviceAlsa::AudioDeviceAlsa(const std::string& dev_name)
   : AudioDevice(dev_name), play_block_size(0), play_block_count(0),
     rec_block_size(0), rec_block_count(0), play_handle(0), 
     rec_handle(0), play_watch(0), rec_watch(0), duplex(false),
-    zerofill_on_underflow(true)
+    zerofill_on_underflow(true), use_mmap(false), rt_prio(DEFAULT_RT_PRIO),
+    period_size_override(0), play_mmap(0), rec_mmap(0),
+    play_xrun_cnt(0), rec_xrun_cnt(0)
 {
   assert(AudioDeviceAlsa_creator_registered);
 
+  play_xrun_cnt = Metrics::instance().counter(
+      "async_audio_alsa_playback_xruns_total",
+      "Number of ALSA playback buffer underruns and other stream errors",
+      Metric::Labels{{"device", dev_name}});
+  rec_xrun_cnt = Metrics::instance().counter(
+      "async_audio_alsa_capture_xruns_total",
+      "Number of ALSA capture buffer overruns and other stream errors",
+      Metric::Labels{{"device", dev_name}});
+
   char *zerofill_str = getenv("ASYNC_AUDIO_ALSA_ZEROFILL");
   if (zerofill_str != 0)
   {
     istringstream(zerofill_str) >> zerofill_on_underflow;
   }
 
+  char *mmap_str = getenv("ASYNC_AUDIO_ALSA_MMAP");
+  if (mmap_str != 0)
+  {
+    istringstream(mmap_str) >> use_mmap;
+  }
+
+  char *rt_prio_str = getenv("ASYNC_AUDIO_ALSA_RT_PRIO");
+  if (rt_prio_str != 0)
+  {
+    istringstream(rt_prio_str) >> rt_prio;
+  }
+
+  char *period_size_str = getenv("ASYNC_AUDIO_ALSA_PERIOD_SIZE");
+  if (period_size_str != 0)
+  {
+    istringstream(period_size_str) >> period_size_override;
+    if ((period_size_override > 0) &&
+        (period_size_override < MIN_PERIOD_SIZE))
+    {
+      cerr << "*** WARNING: ASYNC_AUDIO_ALSA_PERIOD_SIZE=" << period_size_str
+           << " is too small. Using " << MIN_PERIOD_SIZE << ".\n";
+      period_size_override = MIN_PERIOD_SIZE;
+    }
+  }
+
   snd_pcm_t *play, *capture;
 
     // Open the device to check its duplex capability
@@ -251,7 +708,11 @@ bool AudioDeviceAlsa::isFullDuplexCapable(void)
 void AudioDeviceAlsa::audioToWriteAvailable(void)
 {
   //printf("AudioDeviceAlsa::audioToWriteAvailable\n");
-  if (play_watch)
+  if (play_mmap)
+  {
+    play_mmap->wakeupMainLoop();
+  }
+  else if (play_watch)
   {
     play_watch->setEnabled(true);
   }
@@ -260,7 +721,11 @@ void AudioDeviceAlsa::audioToWriteAvailable(void)
 
 void AudioDeviceAlsa::flushSamples(void)
 {
-  if (play_watch)
+  if (play_mmap)
+  {
+    play_mmap->wakeupMainLoop();
+  }
+  else if (play_watch)
   {
     play_watch->setEnabled(true);
   }  
@@ -274,6 +739,11 @@ int AudioDeviceAlsa::samplesToWrite(void) const
     return 0;
   }
 
+  if (play_mmap)
+  {
+    return play_mmap->samplesToWrite();
+  }
+
   int space_avail = snd_pcm_avail_update(play_handle);
   if (space_avail < 0)
   {
@@ -324,17 +794,34 @@ bool AudioDeviceAlsa::openDevice(Mode mode)
       return false;
     }
 
-    play_watch = new AlsaWatch(play_handle);
-    play_watch->activity.connect(
-            mem_fun(*this, &AudioDeviceAlsa::writeSpaceAvailable));
-    play_watch->setEnabled(true);
-
     if (!startPlayback(play_handle))
     {
       cerr << "*** ERROR: Start playback failed" << endl;
       closeDevice();
       return false;
     }
+
+    if (use_mmap)
+    {
+      play_mmap = new MmapStream(play_handle, SND_PCM_STREAM_PLAYBACK,
+                                 channels, play_block_size, play_block_count,
+                                 PLAY_RING_PERIODS, zerofill_on_underflow,
+                                 play_xrun_cnt);
+      play_mmap->activity.connect(
+              hide(mem_fun(*this, &AudioDeviceAlsa::mmapWriteSpaceAvailable)));
+      if (!play_mmap->start(rt_prio))
+      {
+        closeDevice();
+        return false;
+      }
+    }
+    else
+    {
+      play_watch = new AlsaWatch(play_handle);
+      play_watch->activity.connect(
+              mem_fun(*this, &AudioDeviceAlsa::writeSpaceAvailable));
+      play_watch->setEnabled(true);
+    }
   }
 
   if ((mode == MODE_RD) || (mode == MODE_RDWR))
@@ -361,9 +848,12 @@ bool AudioDeviceAlsa::openDevice(Mode mode)
       return false;
     }
 
-    rec_watch = new AlsaWatch(rec_handle);
-    rec_watch->activity.connect(
-            mem_fun(*this, &AudioDeviceAlsa::audioReadHandler));
+    if (!use_mmap)
+    {
+      rec_watch = new AlsaWatch(rec_handle);
+      rec_watch->activity.connect(
+              mem_fun(*this, &AudioDeviceAlsa::audioReadHandler));
+    }
 
     if (!startCapture(rec_handle))
     {
@@ -371,6 +861,20 @@ bool AudioDeviceAlsa::openDevice(Mode mode)
       closeDevice();
       return false;
     }
+
+    if (use_mmap)
+    {
+      rec_mmap = new MmapStream(rec_handle, SND_PCM_STREAM_CAPTURE,
+                                channels, rec_block_size, rec_block_count,
+                                REC_RING_PERIODS, false, rec_xrun_cnt);
+      rec_mmap->activity.connect(
+              hide(mem_fun(*this, &AudioDeviceAlsa::mmapAudioRead)));
+      if (!rec_mmap->start(rt_prio))
+      {
+        closeDevice();
+        return false;
+      }
+    }
   }
 
   return true;
@@ -380,6 +884,12 @@ bool AudioDeviceAlsa::openDevice(Mode mode)
 
 void AudioDeviceAlsa::closeDevice(void)
 {
+    // The I/O threads must be stopped before the PCM handles are closed
+  delete play_mmap;
+  play_mmap = 0;
+  delete rec_mmap;
+  rec_mmap = 0;
+
   if (play_handle != 0)
   {
     snd_pcm_close(play_handle);
@@ -419,6 +929,7 @@ void AudioDeviceAlsa::audioReadHandler(FdWatch *watch, unsigned short revents)
   snd_pcm_sframes_t frames_avail = snd_pcm_avail_update(rec_handle);
   if (frames_avail < 0)
   {
+    rec_xrun_cnt->inc();
     if (!startCapture(rec_handle))
     {
       watch->setEnabled(false);
@@ -440,6 +951,7 @@ void AudioDeviceAlsa::audioReadHandler(FdWatch *watch, unsigned short revents)
                                                   frames_avail);
     if (frames_read < 0)
     {
+      rec_xrun_cnt->inc();
       if (!startCapture(rec_handle))
       {
         watch->setEnabled(false);
@@ -472,6 +984,7 @@ void AudioDeviceAlsa::writeSpaceAvailable(FdWatch *watch, unsigned short revents
       // Bail out if there's an error
     if (space_avail < 0)
     {
+      play_xrun_cnt->inc();
       if (!startPlayback(play_handle))
       {
         watch->setEnabled(false);
@@ -511,6 +1024,7 @@ void AudioDeviceAlsa::writeSpaceAvailable(FdWatch *watch, unsigned short revents
     //       blocks_gotten, (int)frames_written);
     if (frames_written < 0)
     {
+      play_xrun_cnt->inc();
       if (!startPlayback(play_handle))
       {
         watch->setEnabled(false);
@@ -536,6 +1050,79 @@ void AudioDeviceAlsa::writeSpaceAvailable(FdWatch *watch, unsigned short revents
 }
 
 
+void AudioDeviceAlsa::mmapAudioRead(void)
+{
+  assert(rec_mmap != 0);
+
+  if (rec_mmap->error() < 0)
+  {
+    mmapStreamFailed(rec_mmap);
+    return;
+  }
+
+  size_t frames_avail = rec_mmap->framesAvail();
+  while (frames_avail >= rec_block_size)
+  {
+    size_t frames = min(frames_avail, rec_block_count * rec_block_size);
+    frames /= rec_block_size;
+    frames *= rec_block_size;
+
+    int16_t buf[frames * channels];
+    rec_mmap->read(buf, frames);
+    putBlocks(buf, frames);
+
+      // The device may have been closed by an upper layer
+    if (rec_mmap == 0)
+    {
+      return;
+    }
+    frames_avail = rec_mmap->framesAvail();
+  }
+} /* AudioDeviceAlsa::mmapAudioRead */
+
+
+void AudioDeviceAlsa::mmapWriteSpaceAvailable(void)
+{
+  assert(play_mmap != 0);
+
+  if (play_mmap->error() < 0)
+  {
+    mmapStreamFailed(play_mmap);
+    return;
+  }
+
+  for (;;)
+  {
+    size_t blocks_to_read = play_mmap->spaceAvail() / play_block_size;
+    if (blocks_to_read == 0)
+    {
+      break;
+    }
+
+    int16_t buf[blocks_to_read * play_block_size * channels];
+    size_t blocks_avail = getBlocks(buf, blocks_to_read);
+    if ((blocks_avail == 0) || (play_mmap == 0))
+    {
+      break;
+    }
+    play_mmap->write(buf, blocks_avail * play_block_size);
+  }
+
+} /* AudioDeviceAlsa::mmapWriteSpaceAvailable */
+
+
+void AudioDeviceAlsa::mmapStreamFailed(MmapStream *stream)
+{
+  cerr << "*** ERROR: The ALSA I/O thread for "
+       << ((stream == play_mmap) ? "playback" : "capture")
+       << " on device " << devName() << " stopped (unrecoverable error): "
+       << snd_strerror(stream->error()) << endl;
+
+    // Stop further notifications. The thread has already exited.
+  stream->activity.clear();
+} /* AudioDeviceAlsa::mmapStreamFailed */
+
+
 bool AudioDeviceAlsa::initParams(snd_pcm_t *pcm_handle)
 {
   snd_pcm_hw_params_t *hw_params;
@@ -560,7 +1147,8 @@ bool AudioDeviceAlsa::initParams(snd_pcm_t *pcm_handle)
   }
 
   err = snd_pcm_hw_params_set_access(pcm_handle, hw_params,
-				     SND_PCM_ACCESS_RW_INTERLEAVED);
+				     use_mmap ? SND_PCM_ACCESS_MMAP_INTERLEAVED
+                                              : SND_PCM_ACCESS_RW_INTERLEAVED);
   if (err < 0)
   {
     cerr << "*** ERROR: Set access type failed: "
@@ -613,7 +1201,9 @@ bool AudioDeviceAlsa::initParams(snd_pcm_t *pcm_handle)
     return false;
   }
 
-  snd_pcm_uframes_t period_size = block_size_hint;
+  const size_t block_size = (period_size_override > 0)
+                           ? period_size_override : block_size_hint;
+  snd_pcm_uframes_t period_size = block_size;
   err = snd_pcm_hw_params_set_period_size_near(pcm_handle, hw_params,
 					       &period_size, 0);
   if (err < 0)
@@ -625,7 +1215,7 @@ bool AudioDeviceAlsa::initParams(snd_pcm_t *pcm_handle)
     return false;
   }
   
-  snd_pcm_uframes_t buffer_size = block_count_hint * block_size_hint;
+  snd_pcm_uframes_t buffer_size = block_count_hint * block_size;
   err = snd_pcm_hw_params_set_buffer_size_near(pcm_handle, hw_params,
 					       &buffer_size);
   if (err < 0)
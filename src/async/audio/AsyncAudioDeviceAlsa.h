@@ -80,6 +80,8 @@ namespace Async
  *
  ****************************************************************************/
 
+class MetricCounter;
+
 
 
 /****************************************************************************
@@ -113,6 +115,16 @@ This class implements the low level interface to an Alsa audio device. This
 class is not intended to be used by the end user of the Async library. It is
 used by the Async::AudioIO class, which is the Async API frontend for using
 audio in an application.
+
+If the environment variable ASYNC_AUDIO_ALSA_MMAP is set to 1, the device is
+instead accessed using mmap transfers from a separate I/O thread, running
+with SCHED_FIFO priority if permitted. The thread exchange audio with the
+main loop through lock free ring buffers. That make it possible to use a
+smaller period size, set with ASYNC_AUDIO_ALSA_PERIOD_SIZE, to lower the
+latency without risking underruns when the main loop is busy. If the
+application has enabled the Async::Realtime operating mode, the I/O thread
+use the realtime policy and a priority just above the main loop instead of
+ASYNC_AUDIO_ALSA_RT_PRIO.
 */
 class AudioDeviceAlsa : public AudioDevice
 {
@@ -186,7 +198,13 @@ class AudioDeviceAlsa : public AudioDevice
 
 
   private:
+    static const int    DEFAULT_RT_PRIO = 50;
+    static const size_t MIN_PERIOD_SIZE = 16;
+    static const size_t PLAY_RING_PERIODS = 2;
+    static const size_t REC_RING_PERIODS = 16;
+
     class       AlsaWatch;
+    class       MmapStream;
     size_t      play_block_size;
     size_t      play_block_count;
     size_t      rec_block_size;
@@ -197,11 +215,21 @@ class AudioDeviceAlsa : public AudioDevice
     AlsaWatch   *rec_watch;
     bool        duplex;
     bool        zerofill_on_underflow;
+    bool        use_mmap;
+    int         rt_prio;
+    size_t      period_size_override;
+    MmapStream  *play_mmap;
+    MmapStream  *rec_mmap;
+    MetricCounter *play_xrun_cnt;
+    MetricCounter *rec_xrun_cnt;
 
     AudioDeviceAlsa(const AudioDeviceAlsa&);
     AudioDeviceAlsa& operator=(const AudioDeviceAlsa&);
     void audioReadHandler(FdWatch *watch, unsigned short revents);
     void writeSpaceAvailable(FdWatch *watch, unsigned short revents);
+    void mmapAudioRead(void);
+    void mmapWriteSpaceAvailable(void);
+    void mmapStreamFailed(MmapStream *stream);
     bool initParams(snd_pcm_t *pcm_handle);
     bool getBlockAttributes(snd_pcm_t *pcm_handle, size_t &block_size,
                             size_t &period_size);
@@ -0,0 +1,639 @@
+/**
+@file	 AsyncAudioDeviceJack.cpp
+@brief   Handle JACK and PipeWire audio devices
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+Implements the low level interface to a JACK audio server. PipeWire is
+supported through its JACK API.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cassert>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncFdWatch.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioDeviceJack.h"
+#include "AsyncAudioDeviceFactory.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+/*
+ * A single producer/single consumer ring buffer of interleaved float frames.
+ * The realtime process callback use the planar functions to copy directly
+ * to or from the JACK port buffers while the main loop use the interleaved
+ * functions.
+ */
+class AudioDeviceJack::Ring
+{
+  public:
+    Ring(size_t channels, size_t min_frames)
+      : channels(channels), frames(1), mask(0), buf(0), head(0), tail(0)
+    {
+      while (frames < min_frames)
+      {
+        frames <<= 1;
+      }
+      mask = frames - 1;
+      buf = new float[frames * channels];
+    }
+
+    ~Ring(void) { delete [] buf; }
+
+    size_t size(void) const { return frames; }
+
+    size_t framesAvail(void) const
+    {
+      const unsigned t = tail.load(memory_order_acquire);
+      return head.load(memory_order_acquire) - t;
+    }
+
+    size_t spaceAvail(void) const { return frames - framesAvail(); }
+
+    void write(const float *src, size_t cnt)
+    {
+      const unsigned h = head.load(memory_order_relaxed);
+      for (size_t i=0; i<cnt; ++i)
+      {
+        memcpy(buf + ((h + i) & mask) * channels, src + i * channels,
+               channels * sizeof(*buf));
+      }
+      head.store(h + cnt, memory_order_release);
+    }
+
+    void read(float *dest, size_t cnt)
+    {
+      const unsigned t = tail.load(memory_order_relaxed);
+      for (size_t i=0; i<cnt; ++i)
+      {
+        memcpy(dest + i * channels, buf + ((t + i) & mask) * channels,
+               channels * sizeof(*buf));
+      }
+      tail.store(t + cnt, memory_order_release);
+    }
+
+      // Returns the number of frames written. Frames that do not fit are
+      // thrown away.
+    size_t writePlanar(const float *const *src, size_t cnt)
+    {
+      const unsigned h = head.load(memory_order_relaxed);
+      const unsigned t = tail.load(memory_order_acquire);
+      cnt = min(cnt, frames - (h - t));
+      for (size_t ch=0; ch<channels; ++ch)
+      {
+        const float *s = src[ch];
+        for (size_t i=0; i<cnt; ++i)
+        {
+          buf[((h + i) & mask) * channels + ch] = s[i];
+        }
+      }
+      head.store(h + cnt, memory_order_release);
+      return cnt;
+    }
+
+      // Returns the number of frames read. The rest of the destination
+      // buffers are zeroed.
+    size_t readPlanar(float *const *dest, size_t cnt)
+    {
+      const unsigned t = tail.load(memory_order_relaxed);
+      const unsigned h = head.load(memory_order_acquire);
+      const size_t n = min(cnt, static_cast<size_t>(h - t));
+      for (size_t ch=0; ch<channels; ++ch)
+      {
+        float *d = dest[ch];
+        for (size_t i=0; i<n; ++i)
+        {
+          d[i] = buf[((t + i) & mask) * channels + ch];
+        }
+        memset(d + n, 0, (cnt - n) * sizeof(*d));
+      }
+      tail.store(t + n, memory_order_release);
+      return n;
+    }
+
+  private:
+    size_t                channels;
+    size_t                frames;
+    size_t                mask;
+    float                 *buf;
+    std::atomic<unsigned> head;
+    std::atomic<unsigned> tail;
+
+    Ring(const Ring&);
+    Ring& operator=(const Ring&);
+};
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+REGISTER_AUDIO_DEVICE_TYPE("jack", AudioDeviceJack);
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AudioDeviceJack::AudioDeviceJack(const std::string& dev_name)
+  : AudioDevice(dev_name), client(0), play_ring(0), rec_ring(0),
+    block_size(block_size_hint), wakeup_pending(false), server_gone(false),
+    event_fd(-1), event_watch(0), autoconnect(true)
+{
+  assert(AudioDeviceJack_creator_registered);
+
+  char *autoconnect_str = getenv("ASYNC_AUDIO_JACK_AUTOCONNECT");
+  if (autoconnect_str != 0)
+  {
+    istringstream(autoconnect_str) >> autoconnect;
+  }
+
+  event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd < 0)
+  {
+    cerr << "*** ERROR: Could not create eventfd for JACK audio device: "
+         << strerror(errno) << endl;
+    return;
+  }
+  event_watch = new FdWatch(event_fd, FdWatch::FD_WATCH_RD);
+  event_watch->setLabel("Async::AudioDeviceJack");
+  event_watch->activity.connect(mem_fun(*this, &AudioDeviceJack::onWakeup));
+} /* AudioDeviceJack::AudioDeviceJack */
+
+
+AudioDeviceJack::~AudioDeviceJack(void)
+{
+  closeDevice();
+  delete event_watch;
+  if (event_fd >= 0)
+  {
+    ::close(event_fd);
+  }
+} /* AudioDeviceJack::~AudioDeviceJack */
+
+
+size_t AudioDeviceJack::readBlocksize(void)
+{
+  return block_size;
+} /* AudioDeviceJack::readBlocksize */
+
+
+size_t AudioDeviceJack::writeBlocksize(void)
+{
+  return block_size;
+} /* AudioDeviceJack::writeBlocksize */
+
+
+bool AudioDeviceJack::isFullDuplexCapable(void)
+{
+  return true;
+} /* AudioDeviceJack::isFullDuplexCapable */
+
+
+void AudioDeviceJack::audioToWriteAvailable(void)
+{
+    // Defer the write to the main loop, like for the other audio devices,
+    // so that the audio pipe is not called back from inside a write
+  wakeupMainLoop();
+} /* AudioDeviceJack::audioToWriteAvailable */
+
+
+void AudioDeviceJack::flushSamples(void)
+{
+  wakeupMainLoop();
+} /* AudioDeviceJack::flushSamples */
+
+
+int AudioDeviceJack::samplesToWrite(void) const
+{
+  if (play_ring == 0)
+  {
+    return 0;
+  }
+
+    // Add one quantum for the samples that are being processed by the graph
+  return play_ring->framesAvail() + block_size;
+} /* AudioDeviceJack::samplesToWrite */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+bool AudioDeviceJack::openDevice(Mode mode)
+{
+  closeDevice();
+
+  if (event_fd < 0)
+  {
+    return false;
+  }
+
+    // Ask PipeWire for a quantum matching the block size hint. Other JACK
+    // servers ignore this variable. A value set by the user is not changed.
+  ostringstream latency;
+  latency << block_size_hint << "/" << sample_rate;
+  setenv("PIPEWIRE_LATENCY", latency.str().c_str(), 0);
+
+  jack_status_t status;
+  client = jack_client_open(dev_name.c_str(), JackNoStartServer, &status);
+  if (client == 0)
+  {
+    cerr << "*** ERROR: Could not connect to the JACK server as client \""
+         << dev_name << "\" (status=0x" << hex << status << dec << ")"
+         << endl;
+    return false;
+  }
+
+  const jack_nframes_t server_rate = jack_get_sample_rate(client);
+  if (static_cast<int>(server_rate) != sample_rate)
+  {
+    cerr << "*** ERROR: The sample rate of the JACK server ("
+         << server_rate << "Hz) does not match the configured sample rate ("
+         << sample_rate << "Hz) for JACK device \"" << dev_name << "\"."
+         << endl;
+    closeDevice();
+    return false;
+  }
+
+  block_size = jack_get_buffer_size(client);
+  server_gone = false;
+
+  jack_set_process_callback(client, processCallback, this);
+  jack_set_buffer_size_callback(client, bufferSizeCallback, this);
+  jack_on_shutdown(client, shutdownCallback, this);
+
+  const size_t ring_frames = max(MIN_RING_FRAMES, 4 * block_size.load());
+  if ((mode == MODE_RD) || (mode == MODE_RDWR))
+  {
+    if (!registerPorts(rec_ports, "in", JackPortIsInput))
+    {
+      closeDevice();
+      return false;
+    }
+    rec_ring = new Ring(channels, ring_frames);
+  }
+  if ((mode == MODE_WR) || (mode == MODE_RDWR))
+  {
+    if (!registerPorts(play_ports, "out", JackPortIsOutput))
+    {
+      closeDevice();
+      return false;
+    }
+    play_ring = new Ring(channels, ring_frames);
+  }
+
+  int err = jack_activate(client);
+  if (err != 0)
+  {
+    cerr << "*** ERROR: Could not activate JACK client \"" << dev_name
+         << "\" (error " << err << ")" << endl;
+    closeDevice();
+    return false;
+  }
+
+  if (autoconnect)
+  {
+    connectPorts(rec_ports, JackPortIsPhysical | JackPortIsOutput, true);
+    connectPorts(play_ports, JackPortIsPhysical | JackPortIsInput, false);
+  }
+
+  return true;
+
+} /* AudioDeviceJack::openDevice */
+
+
+void AudioDeviceJack::closeDevice(void)
+{
+  if (client != 0)
+  {
+      // The process callback is no longer called when jack_deactivate
+      // return so the rings can safely be deleted after this
+    if (!server_gone)
+    {
+      jack_deactivate(client);
+    }
+    jack_client_close(client);
+    client = 0;
+  }
+  play_ports.clear();
+  rec_ports.clear();
+  delete play_ring;
+  play_ring = 0;
+  delete rec_ring;
+  rec_ring = 0;
+} /* AudioDeviceJack::closeDevice */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+int AudioDeviceJack::processCallback(jack_nframes_t nframes, void *arg)
+{
+  static_cast<AudioDeviceJack*>(arg)->process(nframes);
+  return 0;
+} /* AudioDeviceJack::processCallback */
+
+
+int AudioDeviceJack::bufferSizeCallback(jack_nframes_t nframes, void *arg)
+{
+  AudioDeviceJack *dev = static_cast<AudioDeviceJack*>(arg);
+  dev->block_size = nframes;
+  dev->wakeupMainLoop();
+  return 0;
+} /* AudioDeviceJack::bufferSizeCallback */
+
+
+void AudioDeviceJack::shutdownCallback(void *arg)
+{
+  AudioDeviceJack *dev = static_cast<AudioDeviceJack*>(arg);
+  dev->server_gone = true;
+  dev->wakeupMainLoop();
+} /* AudioDeviceJack::shutdownCallback */
+
+
+void AudioDeviceJack::process(jack_nframes_t nframes)
+{
+    // This function run in the realtime thread of the JACK server so it
+    // must not block or call into the rest of the library
+  bool wakeup = false;
+  if (rec_ring != 0)
+  {
+    const float *src[channels];
+    for (size_t ch=0; ch<channels; ++ch)
+    {
+      src[ch] = static_cast<const float*>(
+          jack_port_get_buffer(rec_ports[ch], nframes));
+    }
+    wakeup = (rec_ring->writePlanar(src, nframes) > 0);
+  }
+
+  if (play_ring != 0)
+  {
+    float *dest[channels];
+    for (size_t ch=0; ch<channels; ++ch)
+    {
+      dest[ch] = static_cast<float*>(
+          jack_port_get_buffer(play_ports[ch], nframes));
+    }
+    if (play_ring->readPlanar(dest, nframes) > 0)
+    {
+      wakeup = true;
+    }
+  }
+
+  if (wakeup)
+  {
+    wakeupMainLoop();
+  }
+} /* AudioDeviceJack::process */
+
+
+void AudioDeviceJack::wakeupMainLoop(void)
+{
+    // Only signal the eventfd if the main loop is not already about to wake
+    // up so that a system call is not needed for every period
+  if (!wakeup_pending.exchange(true, memory_order_acq_rel))
+  {
+    const uint64_t one = 1;
+    ssize_t ret = ::write(event_fd, &one, sizeof(one));
+    (void)ret;
+  }
+} /* AudioDeviceJack::wakeupMainLoop */
+
+
+void AudioDeviceJack::onWakeup(FdWatch *watch)
+{
+  uint64_t cnt;
+  ssize_t ret = ::read(event_fd, &cnt, sizeof(cnt));
+  (void)ret;
+  wakeup_pending.exchange(false, memory_order_acq_rel);
+
+  if (server_gone && (client != 0))
+  {
+    cerr << "*** ERROR: The JACK server shut down the connection for "
+            "client \"" << dev_name << "\"" << endl;
+    closeDevice();
+    return;
+  }
+
+  if (rec_ring != 0)
+  {
+    readFromRing();
+  }
+  if (play_ring != 0)
+  {
+    writeToRing();
+  }
+} /* AudioDeviceJack::onWakeup */
+
+
+void AudioDeviceJack::readFromRing(void)
+{
+  const size_t bs = block_size;
+  size_t frames = rec_ring->framesAvail();
+  frames /= bs;
+  frames *= bs;
+  while (frames > 0)
+  {
+    const size_t cnt = min(frames, PLAY_BUF_BLOCKS * bs);
+    float buf[cnt * channels];
+    rec_ring->read(buf, cnt);
+    putBlocks(buf, cnt);
+    if (rec_ring == 0)
+    {
+      return;
+    }
+    frames -= cnt;
+  }
+} /* AudioDeviceJack::readFromRing */
+
+
+void AudioDeviceJack::writeToRing(void)
+{
+    // Only keep a couple of blocks in the ring to not add latency
+  for (;;)
+  {
+    const size_t bs = block_size;
+    const size_t target = min(PLAY_BUF_BLOCKS * bs, play_ring->size());
+    const size_t frames_avail = play_ring->framesAvail();
+    if (frames_avail >= target)
+    {
+      return;
+    }
+    size_t blocks_to_read = (target - frames_avail) / bs;
+    if (blocks_to_read == 0)
+    {
+      return;
+    }
+
+    float buf[blocks_to_read * bs * channels];
+    size_t blocks_avail = getBlocks(buf, blocks_to_read);
+    if ((blocks_avail == 0) || (play_ring == 0) || (bs != block_size))
+    {
+      return;
+    }
+    play_ring->write(buf, blocks_avail * bs);
+  }
+} /* AudioDeviceJack::writeToRing */
+
+
+bool AudioDeviceJack::registerPorts(std::vector<jack_port_t*>& ports,
+                                    const char *prefix, unsigned long flags)
+{
+  for (size_t ch=0; ch<channels; ++ch)
+  {
+    ostringstream name;
+    name << prefix << "_" << (ch + 1);
+    jack_port_t *port = jack_port_register(client, name.str().c_str(),
+                                           JACK_DEFAULT_AUDIO_TYPE, flags, 0);
+    if (port == 0)
+    {
+      cerr << "*** ERROR: Could not register JACK port \"" << name.str()
+           << "\" for client \"" << dev_name << "\"" << endl;
+      return false;
+    }
+    ports.push_back(port);
+  }
+  return true;
+} /* AudioDeviceJack::registerPorts */
+
+
+void AudioDeviceJack::connectPorts(const std::vector<jack_port_t*>& ports,
+                                   unsigned long phys_flags, bool is_input)
+{
+  if (ports.empty())
+  {
+    return;
+  }
+
+  const char **phys = jack_get_ports(client, 0, JACK_DEFAULT_AUDIO_TYPE,
+                                     phys_flags);
+  if (phys == 0)
+  {
+    cerr << "*** WARNING: No physical JACK ports found to connect client \""
+         << dev_name << "\" to" << endl;
+    return;
+  }
+  for (size_t ch=0; (ch < ports.size()) && (phys[ch] != 0); ++ch)
+  {
+    const char *own = jack_port_name(ports[ch]);
+    int err = is_input ? jack_connect(client, phys[ch], own)
+                       : jack_connect(client, own, phys[ch]);
+    if ((err != 0) && (err != EEXIST))
+    {
+      cerr << "*** WARNING: Could not connect JACK port " << own
+           << (is_input ? " from " : " to ") << phys[ch] << endl;
+    }
+  }
+  jack_free(phys);
+} /* AudioDeviceJack::connectPorts */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,252 @@
+/**
+@file	 AsyncAudioDeviceJack.h
+@brief   Handle JACK and PipeWire audio devices
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+Implements the low level interface to a JACK audio server. PipeWire is
+supported through its JACK API.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_DEVICE_JACK_INCLUDED
+#define ASYNC_AUDIO_DEVICE_JACK_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <jack/jack.h>
+
+#include <atomic>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioDevice.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class FdWatch;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Implements the low level interface to a JACK audio server
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class implements the low level interface to a JACK audio server. Since
+PipeWire implement the JACK API, it is also the way to share a sound card
+with other applications on a system running PipeWire, without the extra
+latency and resampling of the Alsa compatibility layer. This class is not
+intended to be used by the end user of the Async library. It is used by the
+Async::AudioIO class, which is the Async API frontend for using audio in an
+application.
+
+The device name is used as the JACK client name, e.g. "jack:svxlink". One
+input and one output port is registered per channel. They are connected to
+the physical ports of the server unless the environment variable
+ASYNC_AUDIO_JACK_AUTOCONNECT is set to 0.
+
+Samples are transferred as 32 bit floats, which is the native JACK format.
+The sample rate of the server must match the configured sample rate. The
+block size is the quantum of the server. On PipeWire, a quantum matching the
+block size hint is requested. The realtime process callback exchange audio
+with the main loop through lock free ring buffers.
+*/
+class AudioDeviceJack : public AudioDevice
+{
+  public:
+    /**
+     * @brief 	Constuctor
+     * @param 	dev_name  The client name to use when connecting to JACK
+     */
+    explicit AudioDeviceJack(const std::string& dev_name);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~AudioDeviceJack(void);
+
+    /**
+     * @brief 	Find out what the read (recording) blocksize is set to
+     * @return	Returns the currently set blocksize in samples per channel
+     */
+    virtual size_t readBlocksize(void);
+
+    /**
+     * @brief 	Find out what the write (playback) blocksize is set to
+     * @return	Returns the currently set blocksize in samples per channel
+     */
+    virtual size_t writeBlocksize(void);
+
+    /**
+     * @brief 	Check if the audio device has full duplex capability
+     * @return	Returns \em true if the device has full duplex capability
+     *	      	or else \em false
+     */
+    virtual bool isFullDuplexCapable(void);
+
+    /**
+     * @brief 	Tell the audio device handler that there are audio to be
+     *	      	written in the buffer
+     */
+    virtual void audioToWriteAvailable(void);
+
+    /**
+     * @brief	Tell the audio device to flush its buffers
+     */
+    virtual void flushSamples(void);
+
+    /**
+     * @brief 	Find out how many samples there are in the output buffer
+     * @return	Returns the number of samples in the output buffer on
+     *          success or -1 on failure.
+     *
+     * This function can be used to find out how many samples there are
+     * in the output buffer at the moment. This can for example be used
+     * to find out how long it will take before the output buffer has
+     * been flushed.
+     */
+    virtual int samplesToWrite(void) const;
+
+
+  protected:
+    /**
+     * @brief 	Open the audio device
+     * @param 	mode The mode to open the audio device in (See AudioIO::Mode)
+     * @return	Returns \em true on success or else \em false
+     */
+    virtual bool openDevice(Mode mode);
+
+    /**
+     * @brief 	Close the audio device
+     */
+    virtual void closeDevice(void);
+
+
+  private:
+    static const size_t MIN_RING_FRAMES = 8192;
+    static const size_t PLAY_BUF_BLOCKS = 2;
+
+    class Ring;
+
+    jack_client_t               *client;
+    std::vector<jack_port_t*>   play_ports;
+    std::vector<jack_port_t*>   rec_ports;
+    Ring                        *play_ring;
+    Ring                        *rec_ring;
+    std::atomic<size_t>         block_size;
+    std::atomic<bool>           wakeup_pending;
+    std::atomic<bool>           server_gone;
+    int                         event_fd;
+    FdWatch                     *event_watch;
+    bool                        autoconnect;
+
+    AudioDeviceJack(const AudioDeviceJack&);
+    AudioDeviceJack& operator=(const AudioDeviceJack&);
+    static int processCallback(jack_nframes_t nframes, void *arg);
+    static int bufferSizeCallback(jack_nframes_t nframes, void *arg);
+    static void shutdownCallback(void *arg);
+    void process(jack_nframes_t nframes);
+    void wakeupMainLoop(void);
+    void onWakeup(FdWatch *watch);
+    void readFromRing(void);
+    void writeToRing(void);
+    bool registerPorts(std::vector<jack_port_t*>& ports, const char *prefix,
+                       unsigned long flags);
+    void connectPorts(const std::vector<jack_port_t*>& ports,
+                      unsigned long phys_flags, bool is_input);
+
+};  /* class AudioDeviceJack */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_DEVICE_JACK_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -37,11 +37,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <sys/ioctl.h>
+#include <time.h>
+#include <stdint.h>
 
 #include <cassert>
 #include <cstdio>
 #include <vector>
 #include <sstream>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
 
 
 
@@ -147,7 +152,7 @@ void AudioDeviceUDP::audioToWriteAvailable(void)
 {
   if (!pace_timer->isEnabled())
   {
-    audioWriteHandler();
+    startPacing();
   }
 } /* AudioDeviceUDP::audioToWriteAvailable */
 
@@ -156,7 +161,7 @@ void AudioDeviceUDP::flushSamples(void)
 {
   if (!pace_timer->isEnabled())
   {
-    audioWriteHandler();
+    startPacing();
   }
 } /* AudioDeviceUDP::flushSamples */
 
@@ -190,15 +195,37 @@ int AudioDeviceUDP::samplesToWrite(void) const
 
 AudioDeviceUDP::AudioDeviceUDP(const string& dev_name)
   : AudioDevice(dev_name), block_size(0), sock(0), read_buf(0),
-    read_buf_pos(0), port(0)
+    read_buf_pos(0), port(0), mtu(0), blocks_per_datagram(1),
+    pace_origin(0.0), frames_sent(0)
 {
   assert(AudioDeviceUDP_creator_registered);
   assert(sampleRate() > 0);
   size_t pace_interval = 1000 * block_size_hint / sampleRate();
   block_size = pace_interval * sampleRate() / 1000;
 
+  char *mtu_str = getenv("ASYNC_AUDIO_UDP_MTU");
+  if (mtu_str != 0)
+  {
+    istringstream(mtu_str) >> mtu;
+  }
+  if (mtu > 0)
+  {
+    const size_t block_bytes = block_size * channels * sizeof(int16_t);
+    if (mtu > IP_UDP_HEADER_SIZE)
+    {
+      blocks_per_datagram = (mtu - IP_UDP_HEADER_SIZE) / block_bytes;
+    }
+    if (blocks_per_datagram == 0)
+    {
+      cerr << "*** WARNING: ASYNC_AUDIO_UDP_MTU=" << mtu << " is too small to "
+              "fit one audio block of " << block_bytes << " bytes. "
+              "Sending one block per datagram.\n";
+      blocks_per_datagram = 1;
+    }
+  }
+
   read_buf = new int16_t[block_size * channels];
-  pace_timer = new Timer(pace_interval, Timer::TYPE_PERIODIC);
+  pace_timer = new Timer(0, Timer::TYPE_ONESHOT);
   pace_timer->setEnable(false);
   pace_timer->expired.connect(
       sigc::hide(mem_fun(*this, &AudioDeviceUDP::audioWriteHandler)));
@@ -259,6 +286,10 @@ bool AudioDeviceUDP::openDevice(Mode mode)
              << devName() << ")\n";
         return false;
       }
+      if (mtu > 0)
+      {
+        sock->setBatchMode(BATCH_SIZE, max(mtu, static_cast<size_t>(2048)));
+      }
       break;
       
     case MODE_RDWR:
@@ -286,8 +317,13 @@ bool AudioDeviceUDP::openDevice(Mode mode)
              << ")\n";
         return false;
       }
-      sock->dataReceived.connect(
-              mem_fun(*this, &AudioDeviceUDP::audioReadHandler));
+      sock->setDataHandler<AudioDeviceUDP,
+                           &AudioDeviceUDP::audioReadHandler>(this);
+        // Drain the socket using batched receives when an MTU is configured
+      if (mtu > 0)
+      {
+        sock->setBatchMode(BATCH_SIZE, max(mtu, static_cast<size_t>(2048)));
+      }
       break;
       
     case MODE_NONE:
@@ -318,14 +354,14 @@ void AudioDeviceUDP::closeDevice(void)
 
 
 void AudioDeviceUDP::audioReadHandler(const IpAddress &ip, uint16_t port,
-                                      void *buf, int count)
+                                      DataView data)
 {
-  for (unsigned i=0; i < count / (channels * sizeof(int16_t)); ++i)
+  const int16_t *samples = reinterpret_cast<const int16_t *>(data.data());
+  for (unsigned i=0; i < data.size() / (channels * sizeof(int16_t)); ++i)
   {
     for (size_t ch=0; ch < channels; ++ch)
     {
-      read_buf[read_buf_pos * channels + ch] =
-              ((int16_t *)buf)[i * channels + ch];
+      read_buf[read_buf_pos * channels + ch] = samples[i * channels + ch];
     }
     if (++read_buf_pos == block_size)
     {
@@ -340,30 +376,89 @@ void AudioDeviceUDP::audioWriteHandler(void)
 {
   assert(sock != 0);
   assert((mode() == MODE_WR) || (mode() == MODE_RDWR));
-  
-  unsigned frags_read;
-  const unsigned frag_size = block_size * sizeof(int16_t) * channels;
-  int16_t buf[block_size * channels];
-  frags_read = getBlocks(buf, 1);
-  if (frags_read == 0)
+
+    // The output is paced using the monotonic clock. The number of frames
+    // that may have been sent by now is calculated from the time elapsed
+    // since the stream started so that timer jitter does not accumulate.
+    // One datagram is sent ahead of time.
+  const size_t datagram_frames = blocks_per_datagram * block_size;
+  double t = now();
+  uint64_t allowed = static_cast<uint64_t>((t - pace_origin) * sampleRate())
+                     + datagram_frames;
+  if (allowed > frames_sent + MAX_PACE_BACKLOG * datagram_frames)
   {
-    pace_timer->setEnable(false);
-    return;
+      // We are way behind, probably since the main loop has been blocked.
+      // Restart the clock rather than sending a burst of audio.
+    pace_origin = t - static_cast<double>(frames_sent) / sampleRate();
+    allowed = frames_sent + datagram_frames;
   }
 
-    // Write the samples to the socket
-  if (!sock->write(ip_addr, port, (void *)buf, frag_size))
+  sock->beginWriteBatch();
+  while (frames_sent + block_size <= allowed)
+  {
+    const size_t blocks_to_read =
+        min(blocks_per_datagram,
+            static_cast<size_t>((allowed - frames_sent) / block_size));
+    int16_t buf[blocks_to_read * block_size * channels];
+    const size_t blocks_read = getBlocks(buf, blocks_to_read);
+    if (blocks_read == 0)
+    {
+      sock->flushWriteBatch();
+      pace_timer->setEnable(false);
+      return;
+    }
+
+      // Write the samples to the socket
+    const size_t frames = blocks_read * block_size;
+    if (!sock->write(ip_addr, port, (void *)buf,
+                     frames * channels * sizeof(*buf)))
+    {
+      perror("write in AudioDeviceUDP::write");
+      sock->flushWriteBatch();
+      pace_timer->setEnable(false);
+      return;
+    }
+    frames_sent += frames;
+
+    if (blocks_read < blocks_to_read)
+    {
+      break;
+    }
+  }
+  if (!sock->flushWriteBatch())
   {
     perror("write in AudioDeviceUDP::write");
     pace_timer->setEnable(false);
     return;
   }
 
+    // Wake up when the next full datagram is due
+  const double next = pace_origin +
+                      static_cast<double>(frames_sent) / sampleRate();
+  const int timeout = max(0, static_cast<int>(ceil(1000.0 * (next - now()))));
+  pace_timer->setEnable(false);
+  pace_timer->setTimeout(timeout);
   pace_timer->setEnable(true);
 
 } /* AudioDeviceUDP::audioWriteHandler */
 
 
+void AudioDeviceUDP::startPacing(void)
+{
+  pace_origin = now();
+  frames_sent = 0;
+  audioWriteHandler();
+} /* AudioDeviceUDP::startPacing */
+
+
+double AudioDeviceUDP::now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+} /* AudioDeviceUDP::now */
+
+
 
 /*
  * This file has not been truncated
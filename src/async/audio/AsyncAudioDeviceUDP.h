@@ -49,6 +49,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncIpAddress.h>
+#include <AsyncDataHandler.h>
 #include <AsyncTimer.h>
 
 
@@ -192,6 +193,10 @@ class AudioDeviceUDP : public Async::AudioDevice
 
     
   private:
+    static const size_t   IP_UDP_HEADER_SIZE = 28;
+    static const unsigned BATCH_SIZE = 16;
+    static const unsigned MAX_PACE_BACKLOG = 4;
+
     size_t              block_size;
     Async::UdpSocket    *sock;
     int16_t             *read_buf;
@@ -199,10 +204,16 @@ class AudioDeviceUDP : public Async::AudioDevice
     IpAddress           ip_addr;
     uint16_t            port;
     Async::Timer        *pace_timer;
+    size_t              mtu;
+    size_t              blocks_per_datagram;
+    double              pace_origin;
+    uint64_t            frames_sent;
     
     void audioReadHandler(const Async::IpAddress &ip, uint16_t port,
-                          void *buf, int count);
+                          Async::DataView data);
     void audioWriteHandler(void);
+    void startPacing(void);
+    static double now(void);
     
 };  /* class AudioDeviceUDP */
 
@@ -156,7 +156,7 @@ class AudioEncoder : public AudioSink, public sigc::trackable
     /**
      * @brief 	Call this function when all encoded samples have been flushed
      */
-    void allEncodedSamplesFlushed(void) { sourceAllSamplesFlushed(); }
+    virtual void allEncodedSamplesFlushed(void) { sourceAllSamplesFlushed(); }
     
     /**
      * @brief 	Tell the sink to flush the previously written samples
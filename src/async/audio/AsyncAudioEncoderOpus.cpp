@@ -32,6 +32,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <time.h>
+
 #include <iostream>
 #include <cassert>
 #include <cstdlib>
@@ -44,6 +46,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncTracepoint.h>
 
 
 /****************************************************************************
@@ -115,7 +118,11 @@ using namespace Async;
  ****************************************************************************/
 
 AudioEncoderOpus::AudioEncoderOpus(void)
-  : enc(0), frame_size(0), sample_buf(0), buf_len(0)
+  : enc(0), frame_size(0), sample_buf(0), buf_len(0), adaptive(false),
+    cpu_budget(5.0f), min_complexity(0), max_complexity(10),
+    frame_size_ms(0.0f), frame_size_ms_cfg(0.0f), max_frame_size_ms_cfg(0.0f),
+    inband_fec_cfg(false), adapt_enc_time(0.0), adapt_samples(0),
+    cpu_load(0.0f)
 {
   int error;
   enc = opus_encoder_create(INTERNAL_SAMPLE_RATE, 1, OPUS_APPLICATION_AUDIO,
@@ -127,6 +134,7 @@ AudioEncoderOpus::AudioEncoderOpus(void)
   }
 
   setFrameSize(20);
+  max_complexity = complexity();
   setBitrate(20000);
   enableVbr(true);
   setMaxBandwidth(OPUS_BANDWIDTH_MEDIUMBAND);
@@ -181,6 +189,30 @@ void AudioEncoderOpus::setOption(const std::string &name,
   {
     enableConstrainedVbr(atoi(value.c_str()) != 0);
   }
+  else if (name == "INBAND_FEC")
+  {
+    enableInbandFec(atoi(value.c_str()) != 0);
+  }
+  else if (name == "EXPECTED_PACKET_LOSS")
+  {
+    setExpectedPacketLoss(atoi(value.c_str()));
+  }
+  else if (name == "ADAPTIVE")
+  {
+    enableAdaptive(atoi(value.c_str()) != 0);
+  }
+  else if (name == "CPU_BUDGET")
+  {
+    setCpuBudget(atof(value.c_str()));
+  }
+  else if (name == "MIN_COMPLEXITY")
+  {
+    setMinComplexity(atoi(value.c_str()));
+  }
+  else if (name == "MAX_FRAME_SIZE")
+  {
+    setMaxFrameSize(atof(value.c_str()));
+  }
   else
   {
     cerr << "*** WARNING AudioEncoderOpus: Unknown option \""
@@ -211,31 +243,31 @@ void AudioEncoderOpus::printCodecParams(void)
 #if OPUS_MAJOR > 0
   cout << "LSB depth            = " << lsbDepth() << endl;
 #endif
+  cout << "Adaptive             = " << (adaptiveEnabled() ? "YES" : "NO")
+       << endl;
+  if (adaptiveEnabled())
+  {
+    cout << "CPU budget           = " << cpu_budget << "%\n";
+    cout << "Min complexity       = " << min_complexity << endl;
+    cout << "Max frame size       = "
+         << max(max_frame_size_ms_cfg, frame_size_ms_cfg) << "ms\n";
+  }
   cout << "--------------------------------------\n";
 } /* AudioEncoderOpus::printCodecParams */
 
 
 float AudioEncoderOpus::setFrameSize(float new_frame_size_ms)
 {
-    // The frame size may be 2.5, 5, 10, 20, 40 or 60 ms
-  frame_size =
-    static_cast<int>(new_frame_size_ms * INTERNAL_SAMPLE_RATE / 1000);
-  delete [] sample_buf;
-  sample_buf = new float[frame_size];
-  return new_frame_size_ms;
+  frame_size_ms_cfg = new_frame_size_ms;
+  return applyFrameSize(new_frame_size_ms);
 } /* AudioEncoderOpus::setFrameSize */
 
 
 opus_int32 AudioEncoderOpus::setComplexity(opus_int32 new_comp)
 {
-  int err = opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(new_comp));
-  if (err != OPUS_OK)
-  {
-    cerr << "*** ERROR: Could not set Opus encoder complexity: "
-         << opus_strerror(err) << endl;
-  }
-  return complexity();
-} /* AudioEncoderOpus::setBitrate */
+  max_complexity = new_comp;
+  return applyComplexity(new_comp);
+} /* AudioEncoderOpus::setComplexity */
 
 
 opus_int32 AudioEncoderOpus::complexity(void)
@@ -446,14 +478,8 @@ opus_int32 AudioEncoderOpus::applicationType(void)
 
 bool AudioEncoderOpus::enableInbandFec(bool enable)
 {
-  opus_int32 do_enable = enable ? 1 : 0;
-  int err = opus_encoder_ctl(enc, OPUS_SET_INBAND_FEC(do_enable));
-  if (err != OPUS_OK)
-  {
-    cerr << "*** ERROR: Could not set Opus encoder inband FEC: "
-         << opus_strerror(err) << endl;
-  }
-  return inbandFecEnabled();
+  inband_fec_cfg = enable;
+  return applyInbandFec(enable);
 } /* AudioEncoderOpus::enableInbandFec */
 
 
@@ -629,6 +655,24 @@ const char *AudioEncoderOpus::applicationTypeStr(opus_int32 type)
 } /* AudioEncoderOpus::applicationTypeStr */
 
 
+void AudioEncoderOpus::enableAdaptive(bool enable)
+{
+  adaptive = enable;
+  adapt_enc_time = 0.0;
+  adapt_samples = 0;
+  cpu_load = 0.0f;
+  if (!enable)
+  {
+    applyComplexity(max_complexity);
+    applyInbandFec(inband_fec_cfg);
+    if (buf_len == 0)
+    {
+      applyFrameSize(frame_size_ms_cfg);
+    }
+  }
+} /* AudioEncoderOpus::enableAdaptive */
+
+
 int AudioEncoderOpus::writeSamples(const float *samples, int count)
 {
   for (int i=0; i<count; ++i)
@@ -639,9 +683,16 @@ int AudioEncoderOpus::writeSamples(const float *samples, int count)
     {
       buf_len = 0;
       unsigned char output_buf[4000];
+      const double start = adaptive ? now() : 0.0;
       opus_int32 nbytes = opus_encode_float(enc, sample_buf, frame_size,
                                             output_buf, sizeof(output_buf));
+      if (adaptive)
+      {
+        adapt_enc_time += now() - start;
+        adapt_samples += frame_size;
+      }
       //cout << "### frame_size=" << frame_size << " nbytes=" << nbytes << endl;
+      ASYNC_TRACEPOINT(async, opus_encode, frame_size, nbytes);
       if (nbytes > 0)
       {
         writeEncodedSamples(output_buf, nbytes);
@@ -651,6 +702,11 @@ int AudioEncoderOpus::writeSamples(const float *samples, int count)
         cerr << "**** ERROR: Opus encoder error: " << opus_strerror(frame_size)
              << endl;
       }
+      if (adaptive &&
+          (adapt_samples >= ADAPT_PERIOD_MS * INTERNAL_SAMPLE_RATE / 1000))
+      {
+        adapt();
+      }
     }
   }
   
@@ -675,6 +731,133 @@ int AudioEncoderOpus::writeSamples(const float *samples, int count)
  *
  ****************************************************************************/
 
+float AudioEncoderOpus::applyFrameSize(float new_frame_size_ms)
+{
+    // The frame size may be 2.5, 5, 10, 20, 40 or 60 ms
+  frame_size_ms = new_frame_size_ms;
+  frame_size =
+    static_cast<int>(new_frame_size_ms * INTERNAL_SAMPLE_RATE / 1000);
+  delete [] sample_buf;
+  sample_buf = new float[frame_size];
+  return new_frame_size_ms;
+} /* AudioEncoderOpus::applyFrameSize */
+
+
+opus_int32 AudioEncoderOpus::applyComplexity(opus_int32 new_comp)
+{
+  int err = opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(new_comp));
+  if (err != OPUS_OK)
+  {
+    cerr << "*** ERROR: Could not set Opus encoder complexity: "
+         << opus_strerror(err) << endl;
+  }
+  return complexity();
+} /* AudioEncoderOpus::applyComplexity */
+
+
+bool AudioEncoderOpus::applyInbandFec(bool enable)
+{
+  opus_int32 do_enable = enable ? 1 : 0;
+  int err = opus_encoder_ctl(enc, OPUS_SET_INBAND_FEC(do_enable));
+  if (err != OPUS_OK)
+  {
+    cerr << "*** ERROR: Could not set Opus encoder inband FEC: "
+         << opus_strerror(err) << endl;
+  }
+  return inbandFecEnabled();
+} /* AudioEncoderOpus::applyInbandFec */
+
+
+void AudioEncoderOpus::adapt(void)
+{
+  static const float frame_sizes[] = { 2.5f, 5.0f, 10.0f, 20.0f, 40.0f, 60.0f };
+  static const int frame_sizes_cnt = sizeof(frame_sizes) / sizeof(*frame_sizes);
+
+  cpu_load = 100.0 * adapt_enc_time * INTERNAL_SAMPLE_RATE / adapt_samples;
+  adapt_enc_time = 0.0;
+  adapt_samples = 0;
+
+  const opus_int32 comp = complexity();
+  const bool fec = inbandFecEnabled();
+  const float max_frame_size_ms = max(max_frame_size_ms_cfg, frame_size_ms_cfg);
+  float new_frame_size_ms = frame_size_ms;
+  opus_int32 new_comp = comp;
+  bool new_fec = fec;
+
+    // Step down one setting at a time when over budget. Step up again when
+    // the load is below half the budget so that the one step is not enough
+    // to get right back over budget.
+  if (cpu_load > cpu_budget)
+  {
+    if (comp > min_complexity)
+    {
+      new_comp = max(min_complexity, comp - ADAPT_COMPLEXITY_STEP);
+    }
+    else if (fec)
+    {
+      new_fec = false;
+    }
+    else
+    {
+      for (int i=0; i<frame_sizes_cnt; ++i)
+      {
+        if ((frame_sizes[i] > frame_size_ms) &&
+            (frame_sizes[i] <= max_frame_size_ms))
+        {
+          new_frame_size_ms = frame_sizes[i];
+          break;
+        }
+      }
+    }
+  }
+  else if (cpu_load < cpu_budget / 2)
+  {
+    if (frame_size_ms > frame_size_ms_cfg)
+    {
+      new_frame_size_ms = frame_size_ms_cfg;
+      for (int i=frame_sizes_cnt-1; i>=0; --i)
+      {
+        if ((frame_sizes[i] < frame_size_ms) &&
+            (frame_sizes[i] >= frame_size_ms_cfg))
+        {
+          new_frame_size_ms = frame_sizes[i];
+          break;
+        }
+      }
+    }
+    else if (inband_fec_cfg && !fec)
+    {
+      new_fec = true;
+    }
+    else if (comp < max_complexity)
+    {
+      new_comp = comp + 1;
+    }
+  }
+
+  if ((new_comp == comp) && (new_fec == fec) &&
+      (new_frame_size_ms == frame_size_ms))
+  {
+    return;
+  }
+
+  applyComplexity(new_comp);
+  applyInbandFec(new_fec);
+  applyFrameSize(new_frame_size_ms);
+  cout << "AudioEncoderOpus: CPU load " << cpu_load << "% (budget "
+       << cpu_budget << "%). Complexity=" << new_comp
+       << " Frame size=" << new_frame_size_ms << "ms"
+       << " FEC=" << (new_fec ? "YES" : "NO") << endl;
+} /* AudioEncoderOpus::adapt */
+
+
+double AudioEncoderOpus::now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+} /* AudioEncoderOpus::now */
+
 
 
 /*
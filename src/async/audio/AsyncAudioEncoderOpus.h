@@ -367,6 +367,57 @@ class AudioEncoderOpus : public AudioEncoder
      */
     void reset(void);
 
+    /**
+     * @brief   Enable or disable CPU adaptive encoding
+     * @param   enable Set to \em true to enable adaptive encoding
+     *
+     * In adaptive mode the time spent encoding is measured and compared to
+     * the CPU budget set by setCpuBudget. If the budget is exceeded, the
+     * encoder will step down the complexity until the minimum complexity
+     * is reached, then disable inband FEC and last increase the frame size up
+     * to the maximum frame size. When the load falls well below the budget,
+     * the steps are taken back in reverse order. The configured complexity,
+     * frame size and inband FEC setting are upper limits for the adaption.
+     */
+    void enableAdaptive(bool enable);
+
+    /**
+     * @brief   Find out if adaptive encoding is enabled
+     * @returns Returns \em true if adaptive encoding is enabled
+     */
+    bool adaptiveEnabled(void) const { return adaptive; }
+
+    /**
+     * @brief   Set the CPU budget for adaptive encoding
+     * @param   percent The allowed encoding time in percent of real time
+     */
+    void setCpuBudget(float percent) { cpu_budget = percent; }
+
+    /**
+     * @brief   Set the lowest complexity that adaptive encoding may use
+     * @param   min_comp The minimum complexity (0-10)
+     */
+    void setMinComplexity(opus_int32 min_comp) { min_complexity = min_comp; }
+
+    /**
+     * @brief   Set the largest frame size that adaptive encoding may use
+     * @param   max_frame_size_ms The maximum frame size in milliseconds
+     *
+     * Setting the maximum frame size lower than the configured frame size
+     * disable frame size adaption.
+     */
+    void setMaxFrameSize(float max_frame_size_ms)
+    {
+      max_frame_size_ms_cfg = max_frame_size_ms;
+    }
+
+    /**
+     * @brief   Get the measured encoder CPU load
+     * @returns Returns the encoding time in percent of real time for the
+     *          last adaption period
+     */
+    float cpuLoad(void) const { return cpu_load; }
+
 #if 0
     /**
      * @brief 	Set the number of frames that are sent in each packet
@@ -414,15 +465,34 @@ class AudioEncoderOpus : public AudioEncoder
   protected:
     
   private:
+    static const int    ADAPT_PERIOD_MS = 1000;
+    static const int    ADAPT_COMPLEXITY_STEP = 2;
+
     OpusEncoder *enc;
     int       frame_size;
     float     *sample_buf;
     int       buf_len;
+    bool      adaptive;
+    float     cpu_budget;
+    opus_int32 min_complexity;
+    opus_int32 max_complexity;
+    float     frame_size_ms;
+    float     frame_size_ms_cfg;
+    float     max_frame_size_ms_cfg;
+    bool      inband_fec_cfg;
+    double    adapt_enc_time;
+    int       adapt_samples;
+    float     cpu_load;
     //int       frames_per_packet;
     //int       frame_cnt;
     
     AudioEncoderOpus(const AudioEncoderOpus&);
     AudioEncoderOpus& operator=(const AudioEncoderOpus&);
+    float applyFrameSize(float new_frame_size_ms);
+    opus_int32 applyComplexity(opus_int32 new_comp);
+    bool applyInbandFec(bool enable);
+    void adapt(void);
+    static double now(void);
     
 };  /* class AudioEncoderOpus */
 
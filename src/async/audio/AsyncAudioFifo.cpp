@@ -8,7 +8,7 @@ Implements a FIFO (with some extra functionality) for storing samples.
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2003-2009  Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026  Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -171,6 +171,7 @@ void AudioFifo::clear(void)
   
   is_full = false;
   tail = head = 0;
+  trace_queue.clear();
   prebuf = (prebuf_samples > 0);
   output_stopped = false;
   
@@ -254,6 +255,7 @@ int AudioFifo::writeSamples(const float *samples, int count)
   {
     while (!is_full && (samples_written < count))
     {
+      const int buffered_start = samples_written;
       while (!is_full && (samples_written < count))
       {
 	fifo[head] = samples[samples_written++];
@@ -270,6 +272,8 @@ int AudioFifo::writeSamples(const float *samples, int count)
 	  }
 	}
       }
+      trace_queue.push(samples_written - buffered_start);
+      trace_queue.trim(samplesInFifo(true));
       
       if (prebuf && (samplesInFifo() > 0))
       {
@@ -377,7 +381,9 @@ void AudioFifo::writeSamplesFromFifo(void)
     int samples_to_write = min(MAX_WRITE_SIZE, samplesInFifo(true));
     int to_end_of_fifo = fifo_size - tail;
     samples_to_write = min(samples_to_write, to_end_of_fifo);
+    AudioTrace::Scope trace_scope(trace_queue.front());
     samples_written = sinkWriteSamples(fifo+tail, samples_to_write);
+    trace_queue.pop(samples_written);
     //printf("AudioFifo::writeSamplesFromFifo(%s): samples_to_write=%d "
     //  	   "samples_written=%d\n", debug_name.c_str(), samples_to_write,
 	//   samples_written);
@@ -0,0 +1,461 @@
+/**
+@file	 AsyncAudioFileWriter.cpp
+@brief   Write audio files in large blocks from a background thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <cstring>
+#include <cerrno>
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioFileWriter.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+#define BLOCK_ALIGNMENT 4096
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AudioFileWriter::AudioFileWriter(size_t block_size)
+  : block_size(block_size), fd(-1), block(0), block_len(0), file_pos(0),
+    thread_started(false), do_quit(false), thread_errno(0)
+{
+  if (this->block_size == 0)
+  {
+    this->block_size = BLOCK_ALIGNMENT;
+  }
+  this->block_size = (this->block_size + BLOCK_ALIGNMENT - 1) /
+                     BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&cond, NULL);
+} /* AudioFileWriter::AudioFileWriter */
+
+
+AudioFileWriter::~AudioFileWriter(void)
+{
+  close();
+  for (vector<char*>::iterator it=free_blocks.begin();
+       it!=free_blocks.end(); ++it)
+  {
+    free(*it);
+  }
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&mutex);
+} /* AudioFileWriter::~AudioFileWriter */
+
+
+bool AudioFileWriter::open(const std::string& filename)
+{
+  assert(fd < 0);
+
+  errmsg = "";
+  fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+              0666);
+  if (fd < 0)
+  {
+    errmsg = string("open: ") + strerror(errno);
+    return false;
+  }
+
+  block_len = 0;
+  file_pos = 0;
+  do_quit = false;
+  thread_errno = 0;
+  int ret = pthread_create(&thread, NULL, threadFunc, this);
+  if (ret != 0)
+  {
+    errmsg = string("pthread_create: ") + strerror(ret);
+    ::close(fd);
+    fd = -1;
+    return false;
+  }
+  thread_started = true;
+
+  return true;
+} /* AudioFileWriter::open */
+
+
+void AudioFileWriter::setPosition(off_t pos)
+{
+  assert(block_len == 0);
+  file_pos = pos;
+} /* AudioFileWriter::setPosition */
+
+
+bool AudioFileWriter::write(const void *buf, size_t len)
+{
+  if (fd < 0)
+  {
+    return false;
+  }
+  if (!checkThreadError())
+  {
+    return false;
+  }
+
+  const char *ptr = reinterpret_cast<const char *>(buf);
+  while (len > 0)
+  {
+    if (block == 0)
+    {
+      block = allocBlock();
+      if (block == 0)
+      {
+        return false;
+      }
+    }
+
+      // The staged block end at the next block boundary in the file so
+      // that all writes except the first and the last are aligned
+    const size_t space = block_size - file_pos % block_size - block_len;
+    const size_t n = (len < space) ? len : space;
+    memcpy(block + block_len, ptr, n);
+    block_len += n;
+    ptr += n;
+    len -= n;
+
+    if (block_len + file_pos % block_size == block_size)
+    {
+      char *data = block;
+      const size_t data_len = block_len;
+      const off_t pos = file_pos;
+      block = 0;
+      block_len = 0;
+      file_pos += data_len;
+      if (!queueBlock(data, data_len, pos))
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+} /* AudioFileWriter::write */
+
+
+bool AudioFileWriter::writeAt(off_t pos, const void *buf, size_t len)
+{
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  const char *ptr = reinterpret_cast<const char *>(buf);
+  while (len > 0)
+  {
+    char *data = allocBlock();
+    if (data == 0)
+    {
+      return false;
+    }
+    const size_t n = (len < block_size) ? len : block_size;
+    memcpy(data, ptr, n);
+    if (!queueBlock(data, n, pos))
+    {
+      return false;
+    }
+    ptr += n;
+    pos += n;
+    len -= n;
+  }
+
+  return checkThreadError();
+} /* AudioFileWriter::writeAt */
+
+
+bool AudioFileWriter::close(void)
+{
+  if (fd < 0)
+  {
+    return true;
+  }
+
+  bool success = true;
+  if (block_len > 0)
+  {
+    success = queueBlock(block, block_len, file_pos);
+    file_pos += block_len;
+    block = 0;
+    block_len = 0;
+  }
+
+  if (thread_started)
+  {
+    pthread_mutex_lock(&mutex);
+    do_quit = true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(thread, NULL);
+    thread_started = false;
+  }
+  success = checkThreadError() && success;
+
+  if (::close(fd) != 0)
+  {
+    errmsg = string("close: ") + strerror(errno);
+    success = false;
+  }
+  fd = -1;
+
+  if (block != 0)
+  {
+    free_blocks.push_back(block);
+    block = 0;
+  }
+  free_blocks.insert(free_blocks.end(), done_blocks.begin(),
+                     done_blocks.end());
+  done_blocks.clear();
+
+  return success;
+} /* AudioFileWriter::close */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+char *AudioFileWriter::allocBlock(void)
+{
+  if (free_blocks.empty())
+  {
+    pthread_mutex_lock(&mutex);
+    free_blocks.swap(done_blocks);
+    pthread_mutex_unlock(&mutex);
+  }
+  if (!free_blocks.empty())
+  {
+    char *data = free_blocks.back();
+    free_blocks.pop_back();
+    return data;
+  }
+
+  void *data = 0;
+  int ret = posix_memalign(&data, BLOCK_ALIGNMENT, block_size);
+  if (ret != 0)
+  {
+    errmsg = string("posix_memalign: ") + strerror(ret);
+    return 0;
+  }
+  return reinterpret_cast<char *>(data);
+} /* AudioFileWriter::allocBlock */
+
+
+bool AudioFileWriter::queueBlock(char *data, size_t len, off_t pos)
+{
+  pthread_mutex_lock(&mutex);
+  const bool is_full = (queue.size() >= DEFAULT_MAX_QUEUED_BLOCKS);
+  if (!is_full)
+  {
+    Block blk = { data, len, pos };
+    queue.push_back(blk);
+    pthread_cond_signal(&cond);
+  }
+  pthread_mutex_unlock(&mutex);
+
+  if (is_full)
+  {
+    free_blocks.push_back(data);
+    errmsg = "The file could not be written fast enough";
+    return false;
+  }
+  return true;
+} /* AudioFileWriter::queueBlock */
+
+
+bool AudioFileWriter::checkThreadError(void)
+{
+  pthread_mutex_lock(&mutex);
+  const int err = thread_errno;
+  pthread_mutex_unlock(&mutex);
+  if (err != 0)
+  {
+    errmsg = string("write: ") + strerror(err);
+    return false;
+  }
+  return true;
+} /* AudioFileWriter::checkThreadError */
+
+
+void *AudioFileWriter::threadFunc(void *arg)
+{
+  reinterpret_cast<AudioFileWriter *>(arg)->writerThread();
+  return NULL;
+} /* AudioFileWriter::threadFunc */
+
+
+void AudioFileWriter::writerThread(void)
+{
+  pthread_mutex_lock(&mutex);
+  for (;;)
+  {
+    while (queue.empty() && !do_quit)
+    {
+      pthread_cond_wait(&cond, &mutex);
+    }
+    if (queue.empty())
+    {
+      break;
+    }
+    Block blk = queue.front();
+    queue.pop_front();
+    bool write_failed = (thread_errno != 0);
+    pthread_mutex_unlock(&mutex);
+
+    int err = 0;
+    const char *ptr = blk.data;
+    size_t len = blk.len;
+    off_t pos = blk.pos;
+    while (!write_failed && (len > 0))
+    {
+      ssize_t ret = pwrite(fd, ptr, len, pos);
+      if (ret < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        err = errno;
+        write_failed = true;
+      }
+      else if (ret == 0)
+      {
+        err = ENOSPC;
+        write_failed = true;
+      }
+      else
+      {
+        ptr += ret;
+        pos += ret;
+        len -= ret;
+      }
+    }
+
+    pthread_mutex_lock(&mutex);
+    if ((err != 0) && (thread_errno == 0))
+    {
+      thread_errno = err;
+    }
+    done_blocks.push_back(blk.data);
+  }
+  pthread_mutex_unlock(&mutex);
+} /* AudioFileWriter::writerThread */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,268 @@
+/**
+@file	 AsyncAudioFileWriter.h
+@brief   Write audio files in large blocks from a background thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_FILE_WRITER_INCLUDED
+#define ASYNC_AUDIO_FILE_WRITER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <pthread.h>
+#include <sys/types.h>
+
+#include <string>
+#include <deque>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Write a file in large blocks from a background thread
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class is used to write audio files without blocking the Async main loop
+on file I/O. Data written to the object is collected in memory until a whole
+block have been filled. The block is then handed over to a background thread
+that write it to the file. The blocks are aligned to the file offset so that
+the storage device, e.g. an SD card, see few and large writes. Only the last
+block of the file is written partially, when the file is closed.
+
+Data can also be written to a specific position in the file using writeAt.
+That is typically used to fill in a file header, which space have been
+reserved for using setPosition, just before closing the file.
+
+If the background thread fail to write to the file, the error is reported by
+the next call to write or close. If the background thread cannot keep up, the
+incoming data is thrown away rather than blocking the main loop.
+*/
+class AudioFileWriter
+{
+  public:
+      /// The default block size
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+      /// The default maximum number of blocks waiting to be written
+    static const size_t DEFAULT_MAX_QUEUED_BLOCKS = 32;
+
+    /**
+     * @brief 	Constuctor
+     * @param   block_size The size of the blocks written to the file. It is
+     *                     rounded up to a multiple of 4096 bytes.
+     */
+    explicit AudioFileWriter(size_t block_size=DEFAULT_BLOCK_SIZE);
+
+    /**
+     * @brief 	Destructor
+     *
+     * The file is closed if open.
+     */
+    ~AudioFileWriter(void);
+
+    /**
+     * @brief   Open a file for writing
+     * @param   filename The name of the file
+     * @return  Returns \em true on success or else \em false
+     *
+     * The file is created or truncated. On error, the error message can be
+     * retrieved using the errorMsg function.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief   Check if a file is open
+     * @return  Returns \em true if a file is open
+     */
+    bool isOpen(void) const { return fd >= 0; }
+
+    /**
+     * @brief   Set the position where the next write will start
+     * @param   pos The file offset
+     *
+     * This function may only be called before the first write. It is used to
+     * reserve space for a file header.
+     */
+    void setPosition(off_t pos);
+
+    /**
+     * @brief   Get the position where the next write will start
+     * @return  Returns the file offset
+     */
+    off_t position(void) const { return file_pos + block_len; }
+
+    /**
+     * @brief   Append data to the file
+     * @param   buf The data to write
+     * @param   len The number of bytes to write
+     * @return  Returns \em true on success or \em false if an error has
+     *          occurred
+     */
+    bool write(const void *buf, size_t len);
+
+    /**
+     * @brief   Write data to a specific position in the file
+     * @param   pos The file offset to write to
+     * @param   buf The data to write
+     * @param   len The number of bytes to write
+     * @return  Returns \em true on success or \em false if an error has
+     *          occurred
+     *
+     * The region written must not overlap data that have been appended
+     * using the write function. The data is written by the background
+     * thread after all previously appended blocks.
+     */
+    bool writeAt(off_t pos, const void *buf, size_t len);
+
+    /**
+     * @brief   Close the file
+     * @return  Returns \em true on success or \em false if an error has
+     *          occurred
+     *
+     * All buffered data is written to the file before it is closed. This
+     * function block until the background thread is done.
+     */
+    bool close(void);
+
+    /**
+     * @brief   Get the last error message
+     * @return  Returns the last error message
+     */
+    const std::string& errorMsg(void) const { return errmsg; }
+
+  private:
+    struct Block
+    {
+      char*   data;
+      size_t  len;
+      off_t   pos;
+    };
+    typedef std::deque<Block> Queue;
+
+    size_t              block_size;
+    int                 fd;
+    std::string         errmsg;
+    char*               block;
+    size_t              block_len;
+    off_t               file_pos;
+    std::vector<char*>  free_blocks;
+    pthread_t           thread;
+    bool                thread_started;
+
+      // Shared with the background thread, protected by the mutex
+    pthread_mutex_t     mutex;
+    pthread_cond_t      cond;
+    Queue               queue;
+    bool                do_quit;
+    int                 thread_errno;
+    std::vector<char*>  done_blocks;
+
+    AudioFileWriter(const AudioFileWriter&);
+    AudioFileWriter& operator=(const AudioFileWriter&);
+    char *allocBlock(void);
+    bool queueBlock(char *data, size_t len, off_t pos);
+    bool checkThreadError(void);
+    static void *threadFunc(void *arg);
+    void writerThread(void);
+
+};  /* class AudioFileWriter */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_FILE_WRITER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -38,6 +38,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cstdlib>
 #include <cmath>
 #include <locale>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
 
 
 /****************************************************************************
@@ -59,6 +63,7 @@ extern "C" {
 };
 
 #include "AsyncAudioFilter.h"
+#include "AsyncAudioKernels.h"
 
 
 
@@ -92,15 +97,56 @@ namespace Async
   class FidVars
   {
     public:
-      FidFilter 	*ff;
-      FidRun    	*run;
-      FidFunc   	*func;
-      void      	*buf;
-
-      FidVars(void) : ff(0), run(0), func(0), buf(0) {}
+        /*
+         * One second order section in a compiled biquad cascade. The
+         * coefficients are normalized so that a0 is 1.0. The section is
+         * run in transposed direct form II so only two state variables
+         * are needed.
+         */
+      struct Biquad
+      {
+        double b0, b1, b2;
+        double a1, a2;
+        double s1, s2;
+      };
+
+        /*
+         * A designed filter. A design never change after it has been
+         * created so it is shared by all filters using the same filter
+         * specification and sample rate.
+         */
+      struct Design
+      {
+        FidFilter 	    *ff;
+        FidRun    	    *run;
+        FidFunc   	    *func;
+        std::vector<Biquad> sos;
+        double              sos_gain;
+
+        Design(void) : ff(0), run(0), func(0), sos_gain(1.0) {}
+        ~Design(void)
+        {
+          if (run != 0)
+          {
+            fid_run_free(run);
+          }
+          free(ff);
+        }
+      };
+
+      std::shared_ptr<const Design> design;
+      FidFunc   	    *func;
+      void      	    *buf;
+      std::vector<Biquad> sos;
+      double              sos_gain;
+
+      FidVars(void) : func(0), buf(0), sos_gain(1.0) {}
   };
 };
 
+typedef std::pair<std::string, int> DesignKey;
+typedef std::map<DesignKey, std::weak_ptr<const FidVars::Design> > DesignCache;
+
 
 /****************************************************************************
  *
@@ -108,6 +154,11 @@ namespace Async
  *
  ****************************************************************************/
 
+static bool compileBiquads(FidFilter *ff, std::vector<FidVars::Biquad> &sos,
+                           double &gain);
+static std::shared_ptr<const FidVars::Design> designFilter(
+    const std::string &filter_spec, int sample_rate, std::string &error_str);
+
 
 
 /****************************************************************************
@@ -125,6 +176,11 @@ namespace Async
  *
  ****************************************************************************/
 
+  // Designed filters are cached so that a filter specification only is
+  // designed once even if used by many filters. A cache entry expire when
+  // the last filter using it has been deleted.
+static DesignCache design_cache;
+static std::mutex design_cache_mutex;
 
 
 /****************************************************************************
@@ -161,24 +217,24 @@ bool AudioFilter::parseFilterSpec(const std::string &filter_spec)
 {
   deleteFilter();
 
-  fv = new FidVars;
-  
-  char spec_buf[256];
-  strncpy(spec_buf, filter_spec.c_str(), sizeof(spec_buf));
-  spec_buf[sizeof(spec_buf) - 1] = 0;
-  char *spec = spec_buf;
-  char *old_locale = setlocale(LC_ALL, "C");
-  char *fferr = fid_parse(sample_rate, &spec, &fv->ff);
-  setlocale(LC_ALL, old_locale);
-  if (fferr != 0)
+  std::shared_ptr<const FidVars::Design> design =
+    designFilter(filter_spec, sample_rate, error_str);
+  if (design == 0)
   {
-    error_str = fferr;
-    free(fferr);
-    deleteFilter();
     return false;
   }
-  fv->run = fid_run_new(fv->ff, &fv->func);
-  fv->buf = fid_run_newbuf(fv->run);
+
+    // Only the filter state is allocated for each filter instance
+  fv = new FidVars;
+  fv->design = design;
+  fv->sos = design->sos;
+  fv->sos_gain = design->sos_gain;
+  if (design->run != 0)
+  {
+    fv->func = design->func;
+    fv->buf = fid_run_newbuf(design->run);
+  }
+
   return true;
 } /* AudioFilter::parseFilterSpec */
 
@@ -191,7 +247,19 @@ void AudioFilter::setOutputGain(float gain_db)
 
 void AudioFilter::reset(void)
 {
-  fid_run_zapbuf(fv->buf);
+  if (fv == 0)
+  {
+    return;
+  }
+  for (std::vector<FidVars::Biquad>::iterator it = fv->sos.begin();
+       it != fv->sos.end(); ++it)
+  {
+    it->s1 = it->s2 = 0.0;
+  }
+  if (fv->buf != 0)
+  {
+    fid_run_zapbuf(fv->buf);
+  }
 } /* AudioFilter::reset */
 
 
@@ -206,10 +274,46 @@ void AudioFilter::reset(void)
 void AudioFilter::processSamples(float *dest, const float *src, int count)
 {
   //cout << "AudioFilter::processSamples: len=" << len << endl;
-  
-  for (int i=0; i<count; ++i)
+
+  if (fv->func != 0)
+  {
+    for (int i=0; i<count; ++i)
+    {
+      dest[i] = output_gain * fv->func(fv->buf, src[i]);
+    }
+    return;
+  }
+
+  if (fv->sos.empty())
+  {
+    audioKernelGain(dest, src, output_gain * fv->sos_gain, count);
+    return;
+  }
+
+    // Run the whole block through one section at a time. That keeps the
+    // coefficients and the state of the section in registers for the
+    // duration of the block. The gain is applied on the input of the first
+    // section and the output of each section is the input of the next.
+  const double gain = output_gain * fv->sos_gain;
+  const float *in = src;
+  for (std::vector<FidVars::Biquad>::iterator it = fv->sos.begin();
+       it != fv->sos.end(); ++it)
   {
-    dest[i] = output_gain * fv->func(fv->buf, src[i]);
+    const double b0 = it->b0, b1 = it->b1, b2 = it->b2;
+    const double a1 = it->a1, a2 = it->a2;
+    double s1 = it->s1, s2 = it->s2;
+    const double g = (in == src) ? gain : 1.0;
+    for (int i=0; i<count; ++i)
+    {
+      const double x = g * in[i];
+      const double y = b0 * x + s1;
+      s1 = b1 * x - a1 * y + s2;
+      s2 = b2 * x - a2 * y;
+      dest[i] = y;
+    }
+    it->s1 = s1;
+    it->s2 = s2;
+    in = dest;
   }
 } /* AudioFilter::writeSamples */
 
@@ -226,11 +330,9 @@ void AudioFilter::deleteFilter(void)
 {
   if (fv != 0)
   {
-    if (fv->ff != 0)
+    if (fv->buf != 0)
     {
       fid_run_freebuf(fv->buf);
-      fid_run_free(fv->run);
-      free(fv->ff);
     }
     delete fv;
     fv = 0;
@@ -238,6 +340,146 @@ void AudioFilter::deleteFilter(void)
 } /* AudioFilter::deleteFilter */
 
 
+/**
+ * @brief   Convert a fidlib filter into a cascade of second order sections
+ * @param   ff    The filter as designed by fidlib
+ * @param   sos   The resulting list of sections
+ * @param   gain  The resulting overall gain
+ * @return  Returns \em true on success or \em false if the filter could not
+ *          be expressed as a biquad cascade
+ *
+ * The filter elements are paired up the same way as the fidlib run time
+ * does it, that is an IIR element is combined with the FIR element following
+ * it. FIR elements with only one coefficient are just gain factors.
+ */
+static bool compileBiquads(FidFilter *ff, std::vector<FidVars::Biquad> &sos,
+                           double &gain)
+{
+  sos.clear();
+  gain = 1.0;
+  while (ff->typ != 0)
+  {
+    const double *iir = 0;
+    const double *fir = 0;
+    int n_iir = 0;
+    int n_fir = 0;
+    if ((ff->typ == 'F') && (ff->len == 1))
+    {
+      gain *= ff->val[0];
+      ff = FFNEXT(ff);
+      continue;
+    }
+    if (ff->typ == 'F')
+    {
+      fir = ff->val;
+      n_fir = ff->len;
+      ff = FFNEXT(ff);
+    }
+    else if (ff->typ == 'I')
+    {
+      iir = ff->val;
+      n_iir = ff->len;
+      ff = FFNEXT(ff);
+      while ((ff->typ == 'F') && (ff->len == 1))
+      {
+        gain *= ff->val[0];
+        ff = FFNEXT(ff);
+      }
+      if (ff->typ == 'F')
+      {
+        fir = ff->val;
+        n_fir = ff->len;
+        ff = FFNEXT(ff);
+      }
+    }
+    else
+    {
+      return false;
+    }
+
+    if ((n_iir > 3) || (n_fir > 3) || ((n_iir > 0) && (iir[0] == 0.0)))
+    {
+      return false;
+    }
+
+    FidVars::Biquad bq = { 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (n_fir > 0)
+    {
+      bq.b0 = fir[0];
+      bq.b1 = (n_fir > 1) ? fir[1] : 0.0;
+      bq.b2 = (n_fir > 2) ? fir[2] : 0.0;
+    }
+    if (n_iir > 0)
+    {
+      const double adj = 1.0 / iir[0];
+      gain *= adj;
+      bq.a1 = (n_iir > 1) ? iir[1] * adj : 0.0;
+      bq.a2 = (n_iir > 2) ? iir[2] * adj : 0.0;
+    }
+    sos.push_back(bq);
+  }
+  return true;
+} /* compileBiquads */
+
+
+
+/**
+ * @brief   Design a filter or get an already designed one from the cache
+ * @param   filter_spec The fidlib filter specification
+ * @param   sample_rate The sample rate to design the filter for
+ * @param   error_str   Set to an error message on failure
+ * @return  Returns the filter design or an empty pointer on failure
+ */
+static std::shared_ptr<const FidVars::Design> designFilter(
+    const std::string &filter_spec, int sample_rate, std::string &error_str)
+{
+  std::lock_guard<std::mutex> lock(design_cache_mutex);
+
+  const DesignKey key(filter_spec, sample_rate);
+  DesignCache::iterator it = design_cache.find(key);
+  if (it != design_cache.end())
+  {
+    std::shared_ptr<const FidVars::Design> design = it->second.lock();
+    if (design != 0)
+    {
+      return design;
+    }
+    design_cache.erase(it);
+  }
+
+  std::shared_ptr<FidVars::Design> design(new FidVars::Design);
+  char spec_buf[256];
+  strncpy(spec_buf, filter_spec.c_str(), sizeof(spec_buf));
+  spec_buf[sizeof(spec_buf) - 1] = 0;
+  char *spec = spec_buf;
+  char *old_locale = setlocale(LC_ALL, "C");
+  char *fferr = fid_parse(sample_rate, &spec, &design->ff);
+  setlocale(LC_ALL, old_locale);
+  if (fferr != 0)
+  {
+    error_str = fferr;
+    free(fferr);
+    return std::shared_ptr<const FidVars::Design>();
+  }
+
+    // Most filters designed by fidlib are cascades of first and second
+    // order sections. Those are run by our own biquad cascade, which is a
+    // lot faster than the fidlib command list interpreter. Anything else
+    // falls back to fidlib. The fidlib run object may be shared by many
+    // filters as long as each one has its own buffer.
+  if (!compileBiquads(design->ff, design->sos, design->sos_gain))
+  {
+    design->sos.clear();
+    design->sos_gain = 1.0;
+    design->run = fid_run_new(design->ff, &design->func);
+  }
+
+  design_cache[key] = design;
+
+  return design;
+} /* designFilter */
+
+
 
 /*
  * This file has not been truncated
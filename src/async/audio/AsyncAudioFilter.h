@@ -187,6 +187,12 @@ class AudioFilter : public AudioProcessor
      */
     void processSamples(float *dest, const float *src, int count);
 
+    /**
+     * @brief Tell AudioProcessor::fuseChain that this filter can be fused
+     * @return Always returns \em true
+     */
+    bool isSampleWise(void) const { return true; }
+
 
   private:
     int         sample_rate;
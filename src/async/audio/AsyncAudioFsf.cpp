@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cstring>
 #include <cassert>
 #include <iostream>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -51,6 +52,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "AsyncAudioFsf.h"
+#include "AsyncAudioKernels.h"
+#include "AsyncAudioFifo.h"
 
 
 
@@ -118,41 +121,152 @@ namespace Async
   }; /* AudioFsf::CombFilter */
 
 
-  class AudioFsf::Resonator
+  /*
+   * The comb filters and all resonators of one or more filters sharing the
+   * same input. Each resonator is a bin k and is shared by all filters that
+   * use that bin, only the output gain differ between the filters. The
+   * resonator state is stored as a structure of arrays so that the
+   * resonators can be updated in parallel by audioKernelResonatorBank.
+   */
+  class AudioFsf::Core
   {
     public:
-      Resonator(const size_t N, const size_t k, const float r, const float H)
-        : gain(H), coeff1(2.0*r*cos(2.0*M_PI*k/N)), coeff2(-r*r),
-          z1(0.0), z2(0.0)
+      static const int BLOCK_SIZE = 256;
+
+      Core(const size_t N, const float r)
+        : N(N), r(r), combN(N, r), comb2(2, r), outputs(0)
+      {
+        assert(N % 2 == 0);
+        assert((r >= 0.0) && (r <= 1.0));
+      }
+
+      int outputCount(void) const { return outputs; }
+
+      int addFilter(const float *coeff)
       {
-        gain /= N;
+        for (size_t k=0; k<=N/2; ++k)
+        {
+          if ((coeff[k] > 0.0f) &&
+              (std::find(bins.begin(), bins.end(), k) == bins.end()))
+          {
+            addBin(k);
+          }
+        }
+        for (size_t stage=0; stage<bins.size(); ++stage)
+        {
+          const size_t k = bins[stage];
+          gain.push_back(resonatorGain(k, coeff[k]));
+        }
+        block_dest.push_back(0);
+        return outputs++;
+      }
+
+      void processSamples(float *const *dest, const float *src, int count)
+      {
+        float comb_out[BLOCK_SIZE];
+        for (int pos=0; pos<count; pos += BLOCK_SIZE)
+        {
+          const int block = std::min(count - pos, BLOCK_SIZE);
+          for (int i=0; i<block; ++i)
+          {
+            comb_out[i] = comb2.processSample(combN.processSample(src[pos+i]));
+          }
+          for (int o=0; o<outputs; ++o)
+          {
+            block_dest[o] = dest[o] + pos;
+          }
+          audioKernelResonatorBank(block_dest.data(), outputs, gain.data(),
+                                   comb_out, block, z1.data(), z2.data(),
+                                   coeff1.data(), coeff2.data(), bins.size());
+        }
+      }
+
+    private:
+      const size_t        N;
+      const float         r;
+      CombFilter          combN;
+      CombFilter          comb2;
+      int                 outputs;
+      std::vector<size_t> bins;
+      std::vector<float>  coeff1;
+      std::vector<float>  coeff2;
+      std::vector<float>  z1;
+      std::vector<float>  z2;
+      std::vector<float>  gain;
+      std::vector<float*> block_dest;
+
+      float resonatorGain(const size_t k, const float H) const
+      {
+        if (!(H > 0.0f))
+        {
+          return 0.0f;
+        }
+        float g = H / N;
         if ((k == 0) || (k == N/2))
         {
-          gain /= 2.0;
+          g /= 2.0;
         }
         if (k % 2 == 1)
         {
-          gain = -gain;
+          g = -g;
         }
-        //std::cout << "### Resonator: N=" << N << " k=" << k << " r=" << r
-        //          << " H=" << H << " gain=" << gain
-        //          << " coeff1=" << coeff1 << " coeff2=" << coeff2 << std::endl;
+        return g;
       }
 
-      inline float processSample(const float& src)
+      void addBin(const size_t k)
       {
-        float dest = src + z1*coeff1 + z2*coeff2;
-        z2 = z1;
-        z1 = dest;
-        return dest * gain;
+          // Insert a zero gain column for the new resonator into the gain
+          // matrix of the filters that have already been added
+        const size_t stages = bins.size();
+        std::vector<float> new_gain;
+        for (int o=0; o<outputs; ++o)
+        {
+          new_gain.insert(new_gain.end(), gain.begin() + o*stages,
+                          gain.begin() + (o+1)*stages);
+          new_gain.push_back(0.0f);
+        }
+        gain.swap(new_gain);
+        bins.push_back(k);
+        coeff1.push_back(2.0*r*cos(2.0*M_PI*k/N));
+        coeff2.push_back(-r*r);
+        z1.push_back(0.0f);
+        z2.push_back(0.0f);
       }
 
+      Core(const Core&);
+      Core& operator=(const Core&);
+  };
+
+
+  class AudioFsfBank::Output : public AudioSource
+  {
+    public:
+      Output(AudioFsfBank *bank, unsigned fifo_size)
+        : bank(bank), fifo_size(fifo_size), fifo(new AudioFifo(fifo_size)),
+          buf(AudioFsf::Core::BLOCK_SIZE)
+      {
+        registerSink(fifo, true);
+      }
+
+      AudioFifo *output(void) { return fifo; }
+      float *buffer(void) { return &buf[0]; }
+
+      unsigned spaceAvail(void) const
+      {
+        return fifo_size - fifo->samplesInFifo();
+      }
+
+      int writeBuffer(int count) { return sinkWriteSamples(&buf[0], count); }
+      void flush(void) { sinkFlushSamples(); }
+
+      virtual void resumeOutput(void) { bank->outputResumed(); }
+      virtual void allSamplesFlushed(void) { bank->outputFlushed(); }
+
     private:
-      float       gain;
-      const float coeff1;
-      const float coeff2;
-      float       z1;
-      float       z2;
+      AudioFsfBank *      bank;
+      const unsigned      fifo_size;
+      AudioFifo *         fifo;
+      std::vector<float>  buf;
   };
 };
 
@@ -188,37 +302,102 @@ namespace Async
  ****************************************************************************/
 
 AudioFsf::AudioFsf(const size_t N, const float *coeff, const float r)
+  : m_core(new Core(N, r))
 {
-  assert(N % 2 == 0);
-  assert((r >= 0.0) && (r <= 1.0));
-  m_combN = new CombFilter(N, r);
-  m_comb2 = new CombFilter(2, r);
-  for (size_t k=0; k<=N/2; ++k)
-  {
-    float H = coeff[k];
-    if (H > 0.0f)
-    {
-      Resonator *res = new Resonator(N, k, r, H);
-      m_resonators.push_back(res);
-    }
-  }
+  m_core->addFilter(coeff);
 } /* AudioFsf::AudioFsf */
 
 
 AudioFsf::~AudioFsf(void)
 {
-  for (std::vector<Resonator*>::iterator it=m_resonators.begin();
-       it!=m_resonators.end();
+  delete m_core;
+  m_core = 0;
+} /* AudioFsf::~AudioFsf */
+
+
+AudioFsfBank::AudioFsfBank(const size_t N, const float r, unsigned fifo_size)
+  : m_core(new AudioFsf::Core(N, r)), m_fifo_size(fifo_size),
+    m_input_stopped(false), m_is_flushing(false), m_flush_pending(0)
+{
+  assert(fifo_size > 0);
+} /* AudioFsfBank::AudioFsfBank */
+
+
+AudioFsfBank::~AudioFsfBank(void)
+{
+  for (std::vector<Output*>::iterator it=m_outputs.begin();
+       it!=m_outputs.end();
        ++it)
   {
     delete *it;
   }
-  m_resonators.clear();
-  delete m_comb2;
-  m_comb2 = 0;
-  delete m_combN;
-  m_combN = 0;
-} /* AudioFsf::~AudioFsf */
+  m_outputs.clear();
+  delete m_core;
+  m_core = 0;
+} /* AudioFsfBank::~AudioFsfBank */
+
+
+AudioSource *AudioFsfBank::addFilter(const float *coeff)
+{
+  m_core->addFilter(coeff);
+  Output *output = new Output(this, m_fifo_size);
+  m_outputs.push_back(output);
+  m_bufs.push_back(output->buffer());
+  return output->output();
+} /* AudioFsfBank::addFilter */
+
+
+int AudioFsfBank::writeSamples(const float *samples, int count)
+{
+  assert(count > 0);
+  m_is_flushing = false;
+
+    // Only take as many samples as all outputs can take care of
+  unsigned space = AudioFsf::Core::BLOCK_SIZE;
+  for (std::vector<Output*>::const_iterator it=m_outputs.begin();
+       it!=m_outputs.end();
+       ++it)
+  {
+    space = std::min(space, (*it)->spaceAvail());
+  }
+  count = std::min(static_cast<unsigned>(count), space);
+  if (count == 0)
+  {
+    m_input_stopped = true;
+    return 0;
+  }
+
+  m_core->processSamples(m_bufs.data(), samples, count);
+  for (std::vector<Output*>::iterator it=m_outputs.begin();
+       it!=m_outputs.end();
+       ++it)
+  {
+    int ret = (*it)->writeBuffer(count);
+    assert(ret == count);
+    (void)ret;
+  }
+
+  return count;
+} /* AudioFsfBank::writeSamples */
+
+
+void AudioFsfBank::flushSamples(void)
+{
+  if (m_outputs.empty())
+  {
+    sourceAllSamplesFlushed();
+    return;
+  }
+  m_is_flushing = true;
+  m_flush_pending = m_outputs.size();
+  for (std::vector<Output*>::iterator it=m_outputs.begin();
+       it!=m_outputs.end();
+       ++it)
+  {
+    (*it)->flush();
+  }
+} /* AudioFsfBank::flushSamples */
+
 
 
 /****************************************************************************
@@ -229,18 +408,7 @@ AudioFsf::~AudioFsf(void)
 
 void AudioFsf::processSamples(float *dest, const float *src, int count)
 {
-  for (int i=0; i<count; ++i)
-  {
-    float destN = m_combN->processSample(src[i]);
-    float dest2 = m_comb2->processSample(destN);
-    dest[i] = 0.0f;
-    for (std::vector<Resonator*>::iterator it=m_resonators.begin();
-         it!=m_resonators.end();
-         ++it)
-    {
-      dest[i] += (*it)->processSample(dest2);
-    }
-  }
+  m_core->processSamples(&dest, src, count);
 } /* AudioFsf::processSamples */
 
 
@@ -250,6 +418,25 @@ void AudioFsf::processSamples(float *dest, const float *src, int count)
  *
  ****************************************************************************/
 
+void AudioFsfBank::outputResumed(void)
+{
+  if (m_input_stopped)
+  {
+    m_input_stopped = false;
+    sourceResumeOutput();
+  }
+} /* AudioFsfBank::outputResumed */
+
+
+void AudioFsfBank::outputFlushed(void)
+{
+  if (m_is_flushing && (--m_flush_pending == 0))
+  {
+    m_is_flushing = false;
+    sourceAllSamplesFlushed();
+  }
+} /* AudioFsfBank::outputFlushed */
+
 
 
 /*
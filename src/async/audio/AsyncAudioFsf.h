@@ -48,6 +48,8 @@ An example of how to use the Async::AudioFsf class
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncAudioSink.h>
+#include <AsyncAudioSource.h>
 
 
 /****************************************************************************
@@ -204,11 +206,10 @@ class AudioFsf : public Async::AudioProcessor
 
   private:
     class CombFilter;
-    class Resonator;
+    class Core;
+    friend class AudioFsfBank;
 
-    CombFilter *            m_combN;
-    CombFilter *            m_comb2;
-    std::vector<Resonator*> m_resonators;
+    Core *                  m_core;
 
     AudioFsf(const AudioFsf&);
     AudioFsf& operator=(const AudioFsf&);
@@ -216,6 +217,85 @@ class AudioFsf : public Async::AudioProcessor
 };  /* class AudioFsf */
 
 
+/**
+@brief	A number of frequency sampling filters sharing the same input
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+When more than one frequency sampling filter with the same 'N' and 'r' is
+fed with the same audio, the comb filters and the resonators for the bins
+that the filters have in common do the exact same calculations. This class
+run them only once. Each filter added using addFilter get its own output
+where only the output gain of each resonator differ.
+
+Each output is buffered in an Async::AudioFifo. Samples are only accepted
+when there is room in all output FIFOs, so the slowest sink set the pace for
+all outputs, just like for an Async::AudioSplitter. A flush is reported back
+when all outputs have been flushed.
+
+Filters should be added before any audio is written to the bank. Bins added
+after that start from a zero state, which cause a short transient of about
+N samples in all outputs using them.
+*/
+class AudioFsfBank : public AudioSink
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param   N         The number of filter "bins"
+     * @param   r         The dampening factor
+     * @param   fifo_size The size of the FIFO for each output
+     *
+     * See Async::AudioFsf for how to choose N and r.
+     */
+    AudioFsfBank(size_t N, float r=0.99999, unsigned fifo_size=512);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~AudioFsfBank(void);
+
+    /**
+     * @brief   Add a filter to the bank
+     * @param   coeff The N/2+1 coefficients defining the filter
+     * @return  Returns the audio source for the output of the new filter
+     *
+     * The returned audio source is owned by the filter bank.
+     */
+    AudioSource *addFilter(const float *coeff);
+
+    /**
+     * @brief 	Write samples into the filter bank
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the filter bank to flush the previously written samples
+     */
+    virtual void flushSamples(void);
+
+  private:
+    class Output;
+
+    AudioFsf::Core *        m_core;
+    std::vector<Output*>    m_outputs;
+    std::vector<float*>     m_bufs;
+    const unsigned          m_fifo_size;
+    bool                    m_input_stopped;
+    bool                    m_is_flushing;
+    unsigned                m_flush_pending;
+
+    AudioFsfBank(const AudioFsfBank&);
+    AudioFsfBank& operator=(const AudioFsfBank&);
+    void outputResumed(void);
+    void outputFlushed(void);
+
+};  /* class AudioFsfBank */
+
+
 } /* namespace */
 
 #endif /* ASYNC_AUDIO_FSF_INCLUDED */
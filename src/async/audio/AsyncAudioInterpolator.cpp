@@ -27,7 +27,7 @@ ANY KIND. See http://www.dspguru.com/wol.htm for more information.
  *
  ****************************************************************************/
 
-#include <cstring>
+#include <cassert>
 
 
 /****************************************************************************
@@ -108,23 +108,19 @@ using namespace Async;
 
 AudioInterpolator::AudioInterpolator(int interpolation_factor,
       	      	      	      	     const float *filter_coeff, int taps)
-  : factor_L(interpolation_factor), L_size(taps), p_H(filter_coeff)
+  : factor_L(interpolation_factor)
 {
-  //p_H = new float[taps];
-  //memcpy(p_H, filter_coeff, taps * sizeof(*p_H));
-  
   setInputOutputSampleRate(1, factor_L);
 
-    // FIXME: What if L_size does not divide evenly with factor_L?
-  size_t p_Z_size = L_size / factor_L;
-  p_Z = new float[p_Z_size];
-  memset(p_Z, 0, sizeof(*p_Z) * p_Z_size);
+    // The gain factor_L compensate for the energy lost when stuffing zeros
+    // in between the input samples. It is folded into the coefficients.
+    // FIXME: What if taps does not divide evenly with factor_L?
+  interpolator.setFilter(factor_L, filter_coeff, taps, factor_L);
 } /* AudioInterpolator::AudioInterpolator */
 
 
 AudioInterpolator::~AudioInterpolator(void)
 {
-  delete [] p_Z;
 } /* AudioInterpolator::~AudioInterpolator */
 
 
@@ -138,39 +134,17 @@ AudioInterpolator::~AudioInterpolator(void)
 
 void AudioInterpolator::processSamples(float *dest, const float *src, int count)
 {
-  int orig_count = count;
-  int num_taps_per_phase = L_size / factor_L;
-  
-  int num_out = 0;
-  while (count-- > 0)
-  {
-      // shift Z delay line up to make room for next sample
-    memmove(p_Z + 1, p_Z, (num_taps_per_phase - 1) * sizeof(float));
-
-      // copy next sample from input buffer to bottom of Z delay line
-    p_Z[0] = *src++;
-
-      // calculate outputs
-    for (int phase_num = 0; phase_num < factor_L; phase_num++)
-    {
-      	// point to the current polyphase filter
-      const float *p_coeff = p_H + phase_num;
-
-      	// calculate FIR sum
-      float sum = 0.0;
-      for (int tap = 0; tap < num_taps_per_phase; tap++)
-      {
-        sum += *p_coeff * p_Z[tap];
-        p_coeff += factor_L;          /* point to next coefficient */
-      }
-      *dest++ = sum * factor_L; /* store scaled sum and point to next output */
-      num_out++;
-    }
-  }
-
-  //printf("num_out=%d  orig_count=%d\n", num_out, orig_count);
-  assert(num_out == orig_count * factor_L);
-  
+#ifdef USE_Q15_AUDIO
+  int16_t q15_src[count];
+  int16_t q15_dest[count * factor_L];
+  audioKernelToS16(q15_src, src, count);
+  int num_out = interpolator.interpolate(q15_dest, q15_src, count);
+  audioKernelFromS16(dest, q15_dest, num_out);
+#else
+  int num_out = interpolator.interpolate(dest, src, count);
+#endif
+  assert(num_out == count * factor_L);
+  (void)num_out;
 } /* AudioInterpolator::processSamples */
 
 
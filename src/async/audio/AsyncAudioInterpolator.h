@@ -38,6 +38,7 @@ ANY KIND. See http://www.dspguru.com/wol.htm for more information.
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncAudioPolyphase.h>
 
 
 
@@ -113,6 +114,9 @@ http://www.dsptutor.freeuk.com/remez/RemezFIRFilterDesign.html
 
 This implementation is based on the multirate FAQ at dspguru.com:
 http://dspguru.com/info/faqs/mrfaq.htm
+
+If compiled with USE_Q15_AUDIO defined, the filter is run using 16 bit fixed
+point arithmetic. The samples are then clipped to [-1, 1].
 */
 class AudioInterpolator : public Async::AudioProcessor
 {
@@ -148,10 +152,12 @@ class AudioInterpolator : public Async::AudioProcessor
 
     
   private:
-    const int 	factor_L;
-    float     	*p_Z;
-    int       	L_size;
-    const float *p_H;
+    const int 	      	      	      factor_L;
+#ifdef USE_Q15_AUDIO
+    AudioPolyphaseInterpolator<int16_t> interpolator;
+#else
+    AudioPolyphaseInterpolator<float> interpolator;
+#endif
 
     AudioInterpolator(const AudioInterpolator&);
     AudioInterpolator& operator=(const AudioInterpolator&);
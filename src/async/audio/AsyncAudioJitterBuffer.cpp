@@ -0,0 +1,617 @@
+/**
+@file	 AsyncAudioJitterBuffer.cpp
+@brief   An adaptive jitter buffer for audio received from a network
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncApplication.h>
+#include <AsyncAudioKernels.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioJitterBuffer.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+namespace {
+    // The lowest normalized correlation accepted for a splice point
+  const float MIN_CORR = 0.7f;
+
+    // Mean square level below which the signal is considered silent
+  const float SILENCE_LEVEL = 1.0e-6f;
+
+    // Writes closer in time than this belong to the same packet
+  const double PACKET_GAP = 0.001;
+
+    // Time constant for the decay of the peak delay estimate
+  const double PEAK_DECAY_TIME = 20.0;
+
+    // The longest run of lost packets that is concealed and the attenuation
+    // applied for each repetition of the last packet
+  const unsigned MAX_CONCEALED_PACKETS = 3;
+  const float CONCEAL_GAIN = 0.5f;
+};
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AudioJitterBuffer::AudioJitterBuffer(unsigned min_delay_ms,
+                                     unsigned max_delay_ms,
+                                     unsigned sample_rate)
+    // The range of pitch periods searched when doing time-scale
+    // modification is 2.5ms to 15ms
+  : sample_rate(sample_rate), pmin(sample_rate / 400),
+    pmax(3 * sample_rate / 200), fifo_mask(0), head(0), tail(0), out_pos(0),
+    work_buf(2 * pmax),
+    min_delay(0), max_delay(0), target_delay(0), prebuf_level(0),
+    output_stopped(false), prebuf(true), is_flushing(false),
+    flush_sent(false), stream_active(false),
+    packet_marked(false), have_seq(false), conceal_loss(false),
+    can_conceal(false), next_seq(0), last_write_time(0.0),
+    media_time(0.0), prev_transit(0.0), base_transit(0.0), delay_peak(0.0),
+    jitter(0.0), last_packet_samples(0), packet_samples(0), adapt_holdoff(0)
+{
+  resetStats();
+  setDelayLimits(min_delay_ms, max_delay_ms);
+} /* AudioJitterBuffer::AudioJitterBuffer */
+
+
+AudioJitterBuffer::~AudioJitterBuffer(void)
+{
+} /* AudioJitterBuffer::~AudioJitterBuffer */
+
+
+void AudioJitterBuffer::setDelayLimits(unsigned min_delay_ms,
+                                       unsigned max_delay_ms)
+{
+  min_delay = min_delay_ms * sample_rate / 1000;
+  max_delay = max(min_delay, max_delay_ms * sample_rate / 1000);
+
+    // Make room for twice the maximum delay so that there is time for the
+    // accelerate function to catch up with a burst of packets
+  unsigned size = 1;
+  while (size < 2 * max_delay + 4 * pmax)
+  {
+    size <<= 1;
+  }
+  fifo.assign(size, 0.0f);
+  fifo_mask = size - 1;
+  delay_peak = 0.0;
+  jitter = 0.0;
+  updateTargetDelay();
+  clear();
+} /* AudioJitterBuffer::setDelayLimits */
+
+
+void AudioJitterBuffer::markPacket(uint16_t seq)
+{
+  const double t = now();
+  if (have_seq && stream_active)
+  {
+    const uint16_t diff = seq - next_seq;
+    if (diff > 0x7fff)
+    {
+      m_stats.late += 1;
+      packet_marked = true;
+      return;
+    }
+    if (diff > 0)
+    {
+        // Account for the audio in the lost packets so that the arrival
+        // time of this packet is not mistaken for jitter
+      m_stats.lost += diff;
+      if (conceal_loss && can_conceal && (packet_samples > 0) &&
+          (diff <= MAX_CONCEALED_PACKETS))
+      {
+        concealLostPackets(diff);
+      }
+      else
+      {
+        media_time += static_cast<double>(diff) * last_packet_samples /
+                      sample_rate;
+      }
+    }
+  }
+  have_seq = true;
+  next_seq = seq + 1;
+  packetArrived(t);
+  packet_marked = true;
+} /* AudioJitterBuffer::markPacket */
+
+
+const AudioJitterBuffer::Stats& AudioJitterBuffer::stats(void) const
+{
+  m_stats.jitter_ms = 1000.0 * jitter;
+  m_stats.target_delay_ms = 1000.0f * target_delay / sample_rate;
+  m_stats.delay_ms = 1000.0f * samplesInFifo() / sample_rate;
+  return m_stats;
+} /* AudioJitterBuffer::stats */
+
+
+void AudioJitterBuffer::resetStats(void)
+{
+  m_stats.packets = 0;
+  m_stats.lost = 0;
+  m_stats.late = 0;
+  m_stats.concealed = 0;
+  m_stats.underruns = 0;
+  m_stats.accelerated = 0;
+  m_stats.expanded = 0;
+  m_stats.jitter_ms = 0.0f;
+  m_stats.target_delay_ms = 0.0f;
+  m_stats.delay_ms = 0.0f;
+} /* AudioJitterBuffer::resetStats */
+
+
+void AudioJitterBuffer::clear(void)
+{
+  head = tail = 0;
+  trace_queue.clear();
+  out_tag = AudioTrace::Tag();
+  can_conceal = false;
+  out_buf.clear();
+  out_pos = 0;
+  prebuf = true;
+  prebuf_level = target_delay;
+  output_stopped = false;
+  adapt_holdoff = 0;
+  if (is_flushing)
+  {
+    writeSamplesFromFifo();
+  }
+} /* AudioJitterBuffer::clear */
+
+
+int AudioJitterBuffer::writeSamples(const float *samples, int count)
+{
+  assert(count > 0);
+
+  const double t = now();
+  if (is_flushing)
+  {
+    is_flushing = false;
+    flush_sent = false;
+  }
+  if (!packet_marked &&
+      (!stream_active || (t - last_write_time > PACKET_GAP)))
+  {
+    packetArrived(t);
+  }
+  packet_marked = false;
+  last_write_time = t;
+  packet_samples += count;
+  stream_active = true;
+  can_conceal = true;
+
+    // If the buffer is full, throw away the oldest samples
+  const unsigned size = fifo.size();
+  if (samplesInFifo() + count > size)
+  {
+    tail += samplesInFifo() + count - size;
+  }
+  const float *end = samples + count;
+  while (samples < end)
+  {
+    const unsigned idx = head & fifo_mask;
+    const unsigned n = min(static_cast<unsigned>(end - samples), size - idx);
+    copy(samples, samples + n, &fifo[idx]);
+    samples += n;
+    head += n;
+  }
+  trace_queue.push(count);
+  trace_queue.trim(samplesInFifo());
+
+  writeSamplesFromFifo();
+
+  return count;
+} /* AudioJitterBuffer::writeSamples */
+
+
+void AudioJitterBuffer::flushSamples(void)
+{
+  is_flushing = true;
+  flush_sent = false;
+  writeSamplesFromFifo();
+} /* AudioJitterBuffer::flushSamples */
+
+
+unsigned AudioJitterBuffer::samplesBuffered(void) const
+{
+  return samplesInFifo() + (out_buf.size() - out_pos);
+} /* AudioJitterBuffer::samplesBuffered */
+
+
+void AudioJitterBuffer::resumeOutput(void)
+{
+  if (output_stopped)
+  {
+    output_stopped = false;
+
+      // The sink asking for more samples while there are none mean that the
+      // audio arrived too late. Build up a small buffer again before
+      // continuing so that the output do not stutter.
+    if (stream_active && !is_flushing && !prebuf && (samplesBuffered() == 0))
+    {
+      m_stats.underruns += 1;
+      prebuf = true;
+      prebuf_level = min(target_delay, 2 * pmax);
+    }
+    writeSamplesFromFifo();
+  }
+} /* AudioJitterBuffer::resumeOutput */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void AudioJitterBuffer::allSamplesFlushed(void)
+{
+  if (is_flushing && flush_sent && (samplesBuffered() == 0))
+  {
+    is_flushing = false;
+    flush_sent = false;
+    stream_active = false;
+    have_seq = false;
+    can_conceal = false;
+    prebuf = true;
+    prebuf_level = target_delay;
+      sourceAllSamplesFlushed();
+  }
+} /* AudioJitterBuffer::allSamplesFlushed */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void AudioJitterBuffer::packetArrived(double t)
+{
+  m_stats.packets += 1;
+
+  if (!stream_active)
+  {
+    media_time = 0.0;
+    packet_samples = 0;
+    prev_transit = base_transit = t;
+    updateTargetDelay();
+    prebuf_level = target_delay;
+    return;
+  }
+
+    // The transit time is the arrival time minus the media time of the
+    // packet, that is the amount of audio received before it. Only the
+    // variation of the transit time matter so the unknown offset between
+    // the sender and receiver clocks cancel out.
+  media_time += static_cast<double>(packet_samples) / sample_rate;
+  if (packet_samples > 0)
+  {
+    last_packet_samples = packet_samples;
+  }
+  packet_samples = 0;
+  const double transit = t - media_time;
+  jitter += (fabs(transit - prev_transit) - jitter) / 16.0;
+  prev_transit = transit;
+
+    // The packet with the shortest transit time seen in the stream is the
+    // reference. The peak of the delay relative to that packet is what the
+    // buffer need to absorb.
+  if (transit < base_transit)
+  {
+    base_transit = transit;
+  }
+  delay_peak -= delay_peak * last_packet_samples /
+                (PEAK_DECAY_TIME * sample_rate);
+  delay_peak = max(delay_peak, transit - base_transit);
+
+  updateTargetDelay();
+} /* AudioJitterBuffer::packetArrived */
+
+
+void AudioJitterBuffer::concealLostPackets(unsigned count)
+{
+    // The samples of the last packet are still in the FIFO memory even if
+    // they have been played out since the FIFO is much larger than a packet.
+    // The repetitions are accounted for in the media time here so that the
+    // length of the last packet is not changed.
+  const unsigned len = min(packet_samples, head);
+  const unsigned src = head - len;
+  const unsigned size = fifo.size();
+  float gain = 1.0f;
+  for (unsigned pkt=0; pkt<count; ++pkt)
+  {
+    gain *= CONCEAL_GAIN;
+    if (samplesInFifo() + len > size)
+    {
+      tail += samplesInFifo() + len - size;
+    }
+    for (unsigned i=0; i<len; ++i)
+    {
+      fifo[head & fifo_mask] = gain * fifo[(src + i) & fifo_mask];
+      ++head;
+    }
+  }
+  trace_queue.push(count * len);
+  trace_queue.trim(samplesInFifo());
+  media_time += static_cast<double>(count) * len / sample_rate;
+  m_stats.concealed += count;
+} /* AudioJitterBuffer::concealLostPackets */
+
+
+void AudioJitterBuffer::updateTargetDelay(void)
+{
+  const double target = delay_peak + jitter +
+                        static_cast<double>(last_packet_samples) /
+                        sample_rate;
+  target_delay = static_cast<unsigned>(target * sample_rate);
+  target_delay = min(max(target_delay, min_delay), max_delay);
+} /* AudioJitterBuffer::updateTargetDelay */
+
+
+void AudioJitterBuffer::writeSamplesFromFifo(void)
+{
+  while (!output_stopped)
+  {
+    if (out_pos < out_buf.size())
+    {
+      AudioTrace::Scope trace_scope(out_tag);
+      int ret = sinkWriteSamples(&out_buf[out_pos], out_buf.size() - out_pos);
+      if (ret == 0)
+      {
+        output_stopped = true;
+        break;
+      }
+      out_pos += ret;
+      continue;
+    }
+    out_buf.clear();
+    out_pos = 0;
+
+    const unsigned avail = samplesInFifo();
+    if (prebuf)
+    {
+      if (!is_flushing && (avail < prebuf_level))
+      {
+        break;
+      }
+      prebuf = false;
+    }
+
+    if (avail == 0)
+    {
+      if (is_flushing)
+      {
+        if (!flush_sent)
+        {
+          flush_sent = true;
+          sinkFlushSamples();
+        }
+      }
+      break;
+    }
+
+    produceOutput();
+  }
+} /* AudioJitterBuffer::writeSamplesFromFifo */
+
+
+void AudioJitterBuffer::produceOutput(void)
+{
+  out_tag = trace_queue.front();
+  const unsigned avail = samplesInFifo();
+  const unsigned hyst = max(target_delay / 4,
+                              unsigned(sample_rate / 200));
+  const bool accelerate = (avail > target_delay + hyst);
+  const bool expand = !is_flushing && (avail + hyst < target_delay);
+  if ((adapt_holdoff == 0) && (avail >= 2 * pmax) && (accelerate || expand))
+  {
+    for (unsigned i=0; i<2*pmax; ++i)
+    {
+      work_buf[i] = fifo[(tail + i) & fifo_mask];
+    }
+    const float *x = &work_buf[0];
+    const unsigned p = findPitchPeriod(x);
+    if (p > 0)
+    {
+      if (accelerate)
+      {
+          // Replace two pitch periods with one, cross fading from the first
+          // to the second period
+        out_buf.resize(p);
+        for (unsigned n=0; n<p; ++n)
+        {
+          const float w = (n + 0.5f) / p;
+          out_buf[n] = (1.0f - w) * x[n] + w * x[n + p];
+        }
+        tail += 2 * p;
+        trace_queue.pop(2 * p);
+        m_stats.accelerated += p;
+      }
+      else
+      {
+          // Output the first pitch period and then a cross fade from the
+          // second period back into the first. The second period then
+          // follow as normal.
+        out_buf.resize(2 * p);
+        copy(x, x + p, out_buf.begin());
+        for (unsigned n=0; n<p; ++n)
+        {
+          const float w = (n + 0.5f) / p;
+          out_buf[p + n] = (1.0f - w) * x[n + p] + w * x[n];
+        }
+        tail += p;
+        trace_queue.pop(p);
+        m_stats.expanded += p;
+      }
+      out_pos = 0;
+        // Output some samples before the next time-scale modification
+      adapt_holdoff = 4 * pmax;
+      return;
+    }
+  }
+
+  const unsigned cnt = min(avail, pmax);
+  out_buf.resize(cnt);
+  for (unsigned i=0; i<cnt; ++i)
+  {
+    out_buf[i] = fifo[(tail + i) & fifo_mask];
+  }
+  tail += cnt;
+  trace_queue.pop(cnt);
+  out_pos = 0;
+  adapt_holdoff = (adapt_holdoff > cnt) ? adapt_holdoff - cnt : 0;
+} /* AudioJitterBuffer::produceOutput */
+
+
+unsigned AudioJitterBuffer::findPitchPeriod(const float *x) const
+{
+  const unsigned corr_win = pmax / 2;
+  const float e0 = audioKernelDotProduct(x, x, corr_win);
+  const float e_all = audioKernelDotProduct(x, x, 2 * pmax);
+  if (e_all < SILENCE_LEVEL * 2 * pmax)
+  {
+      // The splice will not be heard in silence
+    return pmax;
+  }
+
+  unsigned best_p = 0;
+  float best_corr = MIN_CORR;
+  float ep = audioKernelDotProduct(x + pmin, x + pmin, corr_win);
+  for (unsigned p=pmin; p<=pmax; ++p)
+  {
+    const float c = audioKernelDotProduct(x, x + p, corr_win);
+    if ((c > 0.0f) && (ep > 0.0f))
+    {
+      const float corr = c / sqrt(e0 * ep);
+      if (corr > best_corr)
+      {
+        best_corr = corr;
+        best_p = p;
+      }
+    }
+    if (p + corr_win < 2 * pmax)
+    {
+      ep += x[p + corr_win] * x[p + corr_win] - x[p] * x[p];
+    }
+  }
+  return best_p;
+} /* AudioJitterBuffer::findPitchPeriod */
+
+
+double AudioJitterBuffer::now(void)
+{
+    // Use the main loop clock so that the pacing agree with the timers
+  return Application::app().monotonicTimeNs() / 1.0e9;
+} /* AudioJitterBuffer::now */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,309 @@
+/**
+@file	 AsyncAudioJitterBuffer.h
+@brief   An adaptive jitter buffer for audio received from a network
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_JITTER_BUFFER_INCLUDED
+#define ASYNC_AUDIO_JITTER_BUFFER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+#include <AsyncAudioSource.h>
+#include <AsyncAudioTrace.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	An adaptive jitter buffer for audio received from a network
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class implements a jitter buffer that adapt its delay to the network
+conditions. It is placed after the audio decoder and before a sink that
+consume samples in real time. The arrival time of each packet is compared to
+the amount of audio received so far to estimate the network jitter, both as
+the smoothed mean deviation used by RTP (RFC 3550) and as a slowly decaying
+peak of the packet delay. The target delay is set from these estimates,
+within configurable limits.
+
+When the buffer fill deviate from the target delay, the playout speed is
+changed using time-scale modification. Whole pitch periods are removed
+(accelerate) or repeated (expand) using an overlap-add at the point where the
+signal correlate best, so the adaption is mostly inaudible and no packets
+need to be thrown away. A new stream is prebuffered up to the target delay.
+If the buffer run dry anyway, it is counted as an underrun and prebuffering
+starts over.
+
+Packet boundaries are found automatically since all samples from one packet
+are written in a burst. If sequence numbers are available, markPacket should
+be called before writing the decoded samples of each packet. Lost and late
+packets are then counted too. If loss concealment is enabled, a short run of
+lost packets is replaced by repeating the audio of the last packet received,
+attenuated for each repetition.
+*/
+class AudioJitterBuffer : public AudioSink, public AudioSource
+{
+  public:
+    /**
+     * @brief   Statistics collected by the jitter buffer
+     */
+    struct Stats
+    {
+      unsigned long packets;            ///< Number of received packets
+      unsigned long lost;               ///< Packets never received
+      unsigned long late;               ///< Packets out of sequence
+      unsigned long concealed;          ///< Lost packets concealed
+      unsigned long underruns;          ///< Times the buffer ran dry
+      unsigned long accelerated;        ///< Samples removed by accelerate
+      unsigned long expanded;           ///< Samples added by expand
+      float         jitter_ms;          ///< RFC 3550 interarrival jitter
+      float         target_delay_ms;    ///< The current target delay
+      float         delay_ms;           ///< The current buffer delay
+    };
+
+    /**
+     * @brief 	Constuctor
+     * @param   min_delay_ms The smallest target delay to use
+     * @param   max_delay_ms The largest target delay to use
+     * @param   sample_rate  The sample rate of the audio
+     */
+    explicit AudioJitterBuffer(unsigned min_delay_ms=20,
+                               unsigned max_delay_ms=500,
+                               unsigned sample_rate=INTERNAL_SAMPLE_RATE);
+
+    /**
+     * @brief 	Destructor
+     */
+    virtual ~AudioJitterBuffer(void);
+
+    /**
+     * @brief   Set the limits for the target delay
+     * @param   min_delay_ms The smallest target delay to use
+     * @param   max_delay_ms The largest target delay to use
+     *
+     * The buffer is cleared when the limits are changed.
+     */
+    void setDelayLimits(unsigned min_delay_ms, unsigned max_delay_ms);
+
+    /**
+     * @brief   Enable or disable concealment of lost packets
+     * @param   enable Set to \em true to enable loss concealment
+     *
+     * Loss concealment require that markPacket is called for each packet.
+     * It is disabled by default.
+     */
+    void setLossConcealment(bool enable) { conceal_loss = enable; }
+
+    /**
+     * @brief   Tell the jitter buffer that a new packet has arrived
+     * @param   seq The sequence number of the packet
+     *
+     * Call this function before writing the samples decoded from a packet.
+     */
+    void markPacket(uint16_t seq);
+
+    /**
+     * @brief   Get the statistics
+     * @return  Returns the statistics collected since the last reset
+     */
+    const Stats& stats(void) const;
+
+    /**
+     * @brief   Reset the statistics
+     */
+    void resetStats(void);
+
+    /**
+     * @brief 	Clear all samples from the buffer
+     */
+    void clear(void);
+
+    /**
+     * @brief 	Write samples into the jitter buffer
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     *
+     * All samples are always taken care of. If the buffer is full, the
+     * oldest samples are thrown away.
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the jitter buffer to flush the previously written samples
+     */
+    virtual void flushSamples(void);
+
+    /**
+     * @brief   Get the number of samples buffered
+     * @return  Returns the number of samples currently buffered
+     */
+    virtual unsigned samplesBuffered(void) const;
+
+    /**
+     * @brief Resume audio output to the connected sink
+     */
+    virtual void resumeOutput(void);
+
+
+  protected:
+    /**
+     * @brief The registered sink has flushed all samples
+     */
+    virtual void allSamplesFlushed(void);
+
+
+  private:
+    const unsigned      sample_rate;
+    const unsigned      pmin;
+    const unsigned      pmax;
+    std::vector<float>  fifo;
+    unsigned            fifo_mask;
+    unsigned            head;
+    unsigned            tail;
+    std::vector<float>  out_buf;
+    unsigned            out_pos;
+    std::vector<float>  work_buf;
+    unsigned            min_delay;
+    unsigned            max_delay;
+    unsigned            target_delay;
+    unsigned            prebuf_level;
+    bool                output_stopped;
+    bool                prebuf;
+    bool                is_flushing;
+    bool                flush_sent;
+    bool                stream_active;
+    bool                packet_marked;
+    bool                have_seq;
+    bool                conceal_loss;
+    bool                can_conceal;
+    uint16_t            next_seq;
+    double              last_write_time;
+    double              media_time;
+    double              prev_transit;
+    double              base_transit;
+    double              delay_peak;
+    double              jitter;
+    unsigned            last_packet_samples;
+    unsigned            packet_samples;
+    unsigned            adapt_holdoff;
+    mutable Stats       m_stats;
+    AudioTrace::Queue   trace_queue;
+    AudioTrace::Tag     out_tag;
+
+    AudioJitterBuffer(const AudioJitterBuffer&);
+    AudioJitterBuffer& operator=(const AudioJitterBuffer&);
+    unsigned samplesInFifo(void) const { return head - tail; }
+    void packetArrived(double now);
+    void concealLostPackets(unsigned count);
+    void updateTargetDelay(void);
+    void writeSamplesFromFifo(void);
+    void produceOutput(void);
+    unsigned findPitchPeriod(const float *buf) const;
+    static double now(void);
+
+};  /* class AudioJitterBuffer */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_JITTER_BUFFER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
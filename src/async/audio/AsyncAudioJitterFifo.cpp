@@ -8,7 +8,7 @@ Implements a jitter-tolerant FIFO for storing samples.
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2003-2009  Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026  Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -167,6 +167,7 @@ void AudioJitterFifo::clear(void)
   bool was_empty = empty();
   
   tail = head = 0;
+  trace_queue.clear();
   prebuf = true;
   output_stopped = false;
   
@@ -202,6 +203,8 @@ int AudioJitterFifo::writeSamples(const float *samples, int count)
       tail = (tail + (fifo_size >> 1)) % fifo_size;
     }
   }
+  trace_queue.push(samples_written);
+  trace_queue.trim((head - tail + fifo_size) % fifo_size);
 
   if (samplesInFifo() > 0)
   {
@@ -294,7 +297,9 @@ void AudioJitterFifo::writeSamplesFromFifo(void)
       int samples_to_write = min(MAX_WRITE_SIZE, samplesInFifo());
       int to_end_of_fifo = fifo_size - tail;
       samples_to_write = min(samples_to_write, to_end_of_fifo);
+      AudioTrace::Scope trace_scope(trace_queue.front());
       samples_written = sinkWriteSamples(fifo+tail, samples_to_write);
+      trace_queue.pop(samples_written);
       tail = (tail + samples_written) % fifo_size;
     } while((samples_written > 0) && !empty());
   }
@@ -8,7 +8,7 @@ Implements a jitter-tolerant FIFO for storing samples.
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2003-2009  Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026  Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -47,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncAudioSink.h>
 #include <AsyncAudioSource.h>
+#include <AsyncAudioTrace.h>
 
 
 /****************************************************************************
@@ -183,6 +184,12 @@ class AudioJitterFifo : public AudioSink, public AudioSource
      * This function is normally only called from a connected source object.
      */
     virtual void flushSamples(void);
+
+    /**
+     * @brief   Get the number of samples buffered
+     * @return  Returns the number of samples currently buffered
+     */
+    virtual unsigned samplesBuffered(void) const { return samplesInFifo(); }
     
     /**
      * @brief Resume audio output to the connected sink
@@ -212,6 +219,7 @@ class AudioJitterFifo : public AudioSink, public AudioSource
     bool      	output_stopped;
     bool      	prebuf;
     bool      	is_flushing;
+    AudioTrace::Queue trace_queue;
     
     void writeSamplesFromFifo(void);
 
@@ -0,0 +1,1087 @@
+/**
+@file	 AsyncAudioKernels.h
+@brief   Vectorized sample processing kernels for the audio pipe classes
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_KERNELS_INCLUDED
+#define ASYNC_AUDIO_KERNELS_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <complex>
+#include <cmath>
+#include <stdint.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+/*
+The functions below are used by the audio pipe classes to process blocks of
+samples. The instruction set is selected at compile time: AVX if the compiler
+have been told that it is available (e.g. -mavx or -march=native), otherwise
+SSE which is always available on x86_64, or NEON on ARM. NEON is always
+available on 64 bit ARM. On 32 bit ARM it must be enabled using the USE_NEON
+build option, since the boards without it, like the Raspberry Pi Zero, use
+the same distribution packages. Loads and stores are unaligned so any buffer
+and any sample count may be given. The last few
+samples that do not fill up a vector are processed one at a time.
+
+The source and destination buffers may be the same but must not otherwise
+overlap.
+*/
+
+/**
+ * @brief   Multiply a block of samples with a constant gain
+ * @param   dest  The destination buffer
+ * @param   src   The source buffer
+ * @param   gain  The linear gain factor
+ * @param   count The number of samples to process
+ */
+inline void audioKernelGain(float *dest, const float *src, float gain,
+                            int count)
+{
+  int i = 0;
+#if defined(__AVX__)
+  const __m256 g = _mm256_set1_ps(gain);
+  for (; i+8 <= count; i += 8)
+  {
+    _mm256_storeu_ps(dest+i, _mm256_mul_ps(_mm256_loadu_ps(src+i), g));
+  }
+#elif defined(__SSE__)
+  const __m128 g = _mm_set1_ps(gain);
+  for (; i+4 <= count; i += 4)
+  {
+    _mm_storeu_ps(dest+i, _mm_mul_ps(_mm_loadu_ps(src+i), g));
+  }
+#elif defined(__ARM_NEON)
+  for (; i+4 <= count; i += 4)
+  {
+    vst1q_f32(dest+i, vmulq_n_f32(vld1q_f32(src+i), gain));
+  }
+#endif
+  for (; i<count; ++i)
+  {
+    dest[i] = src[i] * gain;
+  }
+} /* audioKernelGain */
+
+
+/**
+ * @brief   Clip a block of samples to a maximum absolute level
+ * @param   dest  The destination buffer
+ * @param   src   The source buffer
+ * @param   level The (positive) level to clip at
+ * @param   count The number of samples to process
+ */
+inline void audioKernelClip(float *dest, const float *src, float level,
+                            int count)
+{
+  int i = 0;
+#if defined(__AVX__)
+  const __m256 hi = _mm256_set1_ps(level);
+  const __m256 lo = _mm256_set1_ps(-level);
+  for (; i+8 <= count; i += 8)
+  {
+    __m256 v = _mm256_loadu_ps(src+i);
+    _mm256_storeu_ps(dest+i, _mm256_max_ps(_mm256_min_ps(v, hi), lo));
+  }
+#elif defined(__SSE__)
+  const __m128 hi = _mm_set1_ps(level);
+  const __m128 lo = _mm_set1_ps(-level);
+  for (; i+4 <= count; i += 4)
+  {
+    __m128 v = _mm_loadu_ps(src+i);
+    _mm_storeu_ps(dest+i, _mm_max_ps(_mm_min_ps(v, hi), lo));
+  }
+#elif defined(__ARM_NEON)
+  const float32x4_t hi = vdupq_n_f32(level);
+  const float32x4_t lo = vdupq_n_f32(-level);
+  for (; i+4 <= count; i += 4)
+  {
+    float32x4_t v = vld1q_f32(src+i);
+    vst1q_f32(dest+i, vmaxq_f32(vminq_f32(v, hi), lo));
+  }
+#endif
+  for (; i<count; ++i)
+  {
+    if (src[i] > level)
+    {
+      dest[i] = level;
+    }
+    else if (src[i] < -level)
+    {
+      dest[i] = -level;
+    }
+    else
+    {
+      dest[i] = src[i];
+    }
+  }
+} /* audioKernelClip */
+
+
+/**
+ * @brief   Add a block of samples to the samples in the destination buffer
+ * @param   dest  The destination buffer to accumulate into
+ * @param   src   The source buffer
+ * @param   count The number of samples to process
+ */
+inline void audioKernelAccumulate(float *dest, const float *src, int count)
+{
+  int i = 0;
+#if defined(__AVX__)
+  for (; i+8 <= count; i += 8)
+  {
+    _mm256_storeu_ps(dest+i,
+        _mm256_add_ps(_mm256_loadu_ps(dest+i), _mm256_loadu_ps(src+i)));
+  }
+#elif defined(__SSE__)
+  for (; i+4 <= count; i += 4)
+  {
+    _mm_storeu_ps(dest+i,
+        _mm_add_ps(_mm_loadu_ps(dest+i), _mm_loadu_ps(src+i)));
+  }
+#elif defined(__ARM_NEON)
+  for (; i+4 <= count; i += 4)
+  {
+    vst1q_f32(dest+i, vaddq_f32(vld1q_f32(dest+i), vld1q_f32(src+i)));
+  }
+#endif
+  for (; i<count; ++i)
+  {
+    dest[i] += src[i];
+  }
+} /* audioKernelAccumulate */
+
+
+/**
+ * @brief   Multiply a block of samples with a block of gain factors
+ * @param   dest  The destination buffer
+ * @param   src   The source buffer
+ * @param   gain  The linear gain factor for each sample
+ * @param   count The number of samples to process
+ */
+inline void audioKernelMultiply(float *dest, const float *src,
+                                const float *gain, int count)
+{
+  int i = 0;
+#if defined(__AVX__)
+  for (; i+8 <= count; i += 8)
+  {
+    _mm256_storeu_ps(dest+i,
+        _mm256_mul_ps(_mm256_loadu_ps(src+i), _mm256_loadu_ps(gain+i)));
+  }
+#elif defined(__SSE__)
+  for (; i+4 <= count; i += 4)
+  {
+    _mm_storeu_ps(dest+i,
+        _mm_mul_ps(_mm_loadu_ps(src+i), _mm_loadu_ps(gain+i)));
+  }
+#elif defined(__ARM_NEON)
+  for (; i+4 <= count; i += 4)
+  {
+    vst1q_f32(dest+i, vmulq_f32(vld1q_f32(src+i), vld1q_f32(gain+i)));
+  }
+#endif
+  for (; i<count; ++i)
+  {
+    dest[i] = src[i] * gain[i];
+  }
+} /* audioKernelMultiply */
+
+
+/**
+ * @brief   Multiply two blocks of complex samples
+ * @param   dest  The destination buffer
+ * @param   a     The first source buffer
+ * @param   b     The second source buffer
+ * @param   count The number of complex samples to process
+ *
+ * This is typically used to mix I/Q samples with a complex oscillator. The
+ * product is calculated without the NaN and infinity handling that the
+ * std::complex multiplication operator have to do.
+ */
+inline void audioKernelComplexMultiply(std::complex<float> *dest,
+    const std::complex<float> *a, const std::complex<float> *b, int count)
+{
+  float *df = reinterpret_cast<float*>(dest);
+  const float *af = reinterpret_cast<const float*>(a);
+  const float *bf = reinterpret_cast<const float*>(b);
+  int i = 0;
+#if defined(__AVX__)
+  for (; i+4 <= count; i += 4)
+  {
+    __m256 x = _mm256_loadu_ps(af+2*i);
+    __m256 y = _mm256_loadu_ps(bf+2*i);
+    __m256 re_im = _mm256_mul_ps(x, _mm256_moveldup_ps(y));
+    __m256 im_re = _mm256_mul_ps(_mm256_permute_ps(x, _MM_SHUFFLE(2, 3, 0, 1)),
+                                 _mm256_movehdup_ps(y));
+    _mm256_storeu_ps(df+2*i, _mm256_addsub_ps(re_im, im_re));
+  }
+#elif defined(__SSE__)
+  const __m128 neg_re = _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+  for (; i+2 <= count; i += 2)
+  {
+    __m128 x = _mm_loadu_ps(af+2*i);
+    __m128 y = _mm_loadu_ps(bf+2*i);
+    __m128 re_im = _mm_mul_ps(x, _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 2, 0, 0)));
+    __m128 im_re = _mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)),
+                              _mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 1, 1)));
+    _mm_storeu_ps(df+2*i, _mm_add_ps(re_im, _mm_xor_ps(im_re, neg_re)));
+  }
+#elif defined(__ARM_NEON)
+  for (; i+4 <= count; i += 4)
+  {
+    float32x4x2_t x = vld2q_f32(af+2*i);
+    float32x4x2_t y = vld2q_f32(bf+2*i);
+    float32x4x2_t z;
+    z.val[0] = vmlsq_f32(vmulq_f32(x.val[0], y.val[0]), x.val[1], y.val[1]);
+    z.val[1] = vmlaq_f32(vmulq_f32(x.val[0], y.val[1]), x.val[1], y.val[0]);
+    vst2q_f32(df+2*i, z);
+  }
+#endif
+  for (; i<count; ++i)
+  {
+    const float re = af[2*i] * bf[2*i] - af[2*i+1] * bf[2*i+1];
+    const float im = af[2*i] * bf[2*i+1] + af[2*i+1] * bf[2*i];
+    df[2*i] = re;
+    df[2*i+1] = im;
+  }
+} /* audioKernelComplexMultiply */
+
+
+#if !defined(__SSE__) && defined(__ARM_NEON)
+/**
+ * @brief   Convert floats to 32 bit integers rounding to the nearest integer
+ * @param   x The values to convert
+ * @return  Returns the rounded values
+ *
+ * The plain NEON conversion truncate toward zero. This function round like
+ * lrintf and the SSE conversion do so that all code paths produce the same
+ * output. On ARMv7, halfway cases are rounded away from zero instead of to
+ * even.
+ */
+inline int32x4_t audioKernelNeonRoundS32(float32x4_t x)
+{
+#if defined(__aarch64__)
+  return vcvtnq_s32_f32(x);
+#else
+  const float32x4_t half = vbslq_f32(vcltq_f32(x, vdupq_n_f32(0.0f)),
+                                     vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+  return vcvtq_s32_f32(vaddq_f32(x, half));
+#endif
+} /* audioKernelNeonRoundS32 */
+#endif
+
+
+/**
+ * @brief   Convert a block of samples to 16 bit integers
+ * @param   dest  The destination buffer
+ * @param   src   The source buffer
+ * @param   count The number of samples to process
+ *
+ * The samples are scaled by 32767 and values outside of [-1, 1] are clipped.
+ */
+inline void audioKernelToS16(int16_t *dest, const float *src, int count)
+{
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128 scale = _mm_set1_ps(32767.0f);
+  const __m128 lo = _mm_set1_ps(-32767.0f);
+  for (; i+8 <= count; i += 8)
+  {
+    __m128 a = _mm_mul_ps(_mm_loadu_ps(src+i), scale);
+    __m128 b = _mm_mul_ps(_mm_loadu_ps(src+i+4), scale);
+    a = _mm_max_ps(_mm_min_ps(a, scale), lo);
+    b = _mm_max_ps(_mm_min_ps(b, scale), lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest+i),
+        _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+  }
+#elif defined(__ARM_NEON)
+  const float32x4_t hi = vdupq_n_f32(32767.0f);
+  const float32x4_t lo = vdupq_n_f32(-32767.0f);
+  for (; i+8 <= count; i += 8)
+  {
+    float32x4_t a = vmulq_f32(vld1q_f32(src+i), hi);
+    float32x4_t b = vmulq_f32(vld1q_f32(src+i+4), hi);
+    a = vmaxq_f32(vminq_f32(a, hi), lo);
+    b = vmaxq_f32(vminq_f32(b, hi), lo);
+    vst1q_s16(dest+i, vcombine_s16(vqmovn_s32(audioKernelNeonRoundS32(a)),
+                                   vqmovn_s32(audioKernelNeonRoundS32(b))));
+  }
+#endif
+  for (; i<count; ++i)
+  {
+    float sample = src[i] * 32767.0f;
+    sample = (sample > 32767.0f) ? 32767.0f : sample;
+    sample = (sample < -32767.0f) ? -32767.0f : sample;
+    dest[i] = static_cast<int16_t>(lrintf(sample));
+  }
+} /* audioKernelToS16 */
+
+
+/**
+ * @brief   Convert a block of 16 bit integers to samples
+ * @param   dest  The destination buffer
+ * @param   src   The source buffer
+ * @param   count The number of samples to process
+ *
+ * This is the inverse of audioKernelToS16.
+ */
+inline void audioKernelFromS16(float *dest, const int16_t *src, int count)
+{
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128 scale = _mm_set1_ps(1.0f / 32767.0f);
+  for (; i+8 <= count; i += 8)
+  {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+    __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+    __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+    _mm_storeu_ps(dest+i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+    _mm_storeu_ps(dest+i+4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+  }
+#elif defined(__ARM_NEON)
+  for (; i+8 <= count; i += 8)
+  {
+    int16x8_t x = vld1q_s16(src+i);
+    vst1q_f32(dest+i, vmulq_n_f32(
+          vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), 1.0f / 32767.0f));
+    vst1q_f32(dest+i+4, vmulq_n_f32(
+          vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), 1.0f / 32767.0f));
+  }
+#endif
+  for (; i<count; ++i)
+  {
+    dest[i] = src[i] * (1.0f / 32767.0f);
+  }
+} /* audioKernelFromS16 */
+
+
+/**
+ * @brief   Split interleaved 16 bit frames into one sample buffer per channel
+ * @param   dest      One destination buffer for each channel
+ * @param   src       The source buffer containing frames*channels samples
+ * @param   channels  The number of channels in each frame
+ * @param   frames    The number of frames to process
+ *
+ * The samples are scaled by 1/32768 so that the full 16 bit range map to
+ * [-1, 1). All channels are written in a single pass over the source buffer.
+ * Mono and stereo, which are by far the most common, are vectorized. Other
+ * channel counts are handled one frame at a time.
+ */
+inline void audioKernelDeinterleaveS16(float *const *dest, const int16_t *src,
+                                       int channels, int frames)
+{
+  const float scale = 1.0f / 32768.0f;
+  int i = 0;
+  if (channels == 1)
+  {
+#if defined(__SSE2__)
+    const __m128 s = _mm_set1_ps(scale);
+    for (; i+8 <= frames; i += 8)
+    {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+      __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+      __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+      _mm_storeu_ps(dest[0]+i, _mm_mul_ps(_mm_cvtepi32_ps(a), s));
+      _mm_storeu_ps(dest[0]+i+4, _mm_mul_ps(_mm_cvtepi32_ps(b), s));
+    }
+#elif defined(__ARM_NEON)
+    for (; i+8 <= frames; i += 8)
+    {
+      int16x8_t x = vld1q_s16(src+i);
+      vst1q_f32(dest[0]+i,
+          vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+      vst1q_f32(dest[0]+i+4,
+          vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+    }
+#endif
+  }
+  else if (channels == 2)
+  {
+#if defined(__SSE2__)
+    const __m128 s = _mm_set1_ps(scale);
+    for (; i+4 <= frames; i += 4)
+    {
+        // Each 32 bit lane hold one frame, left in the low half
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+2*i));
+      __m128i l = _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+      __m128i r = _mm_srai_epi32(x, 16);
+      _mm_storeu_ps(dest[0]+i, _mm_mul_ps(_mm_cvtepi32_ps(l), s));
+      _mm_storeu_ps(dest[1]+i, _mm_mul_ps(_mm_cvtepi32_ps(r), s));
+    }
+#elif defined(__ARM_NEON)
+    for (; i+8 <= frames; i += 8)
+    {
+      int16x8x2_t x = vld2q_s16(src+2*i);
+      for (int ch=0; ch<2; ++ch)
+      {
+        vst1q_f32(dest[ch]+i, vmulq_n_f32(
+              vcvtq_f32_s32(vmovl_s16(vget_low_s16(x.val[ch]))), scale));
+        vst1q_f32(dest[ch]+i+4, vmulq_n_f32(
+              vcvtq_f32_s32(vmovl_s16(vget_high_s16(x.val[ch]))), scale));
+      }
+    }
+#endif
+  }
+  for (; i<frames; ++i)
+  {
+    const int16_t *frame = src + i*channels;
+    for (int ch=0; ch<channels; ++ch)
+    {
+      dest[ch][i] = frame[ch] * scale;
+    }
+  }
+} /* audioKernelDeinterleaveS16 */
+
+
+/**
+ * @brief   Merge one sample buffer per channel into interleaved 16 bit frames
+ * @param   dest      The destination buffer for frames*channels samples
+ * @param   src       One source buffer for each channel
+ * @param   channels  The number of channels in each frame
+ * @param   frames    The number of frames to process
+ *
+ * The samples are scaled by 32767 and values outside of [-1, 1] are clipped,
+ * like in audioKernelToS16. Mono and stereo are vectorized. Other channel
+ * counts are handled one frame at a time.
+ */
+inline void audioKernelInterleaveS16(int16_t *dest, const float *const *src,
+                                     int channels, int frames)
+{
+  if (channels == 1)
+  {
+    audioKernelToS16(dest, src[0], frames);
+    return;
+  }
+  int i = 0;
+  if (channels == 2)
+  {
+#if defined(__SSE2__)
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    const __m128 lo = _mm_set1_ps(-32767.0f);
+    for (; i+8 <= frames; i += 8)
+    {
+      __m128i ch16[2];
+      for (int ch=0; ch<2; ++ch)
+      {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(src[ch]+i), hi);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(src[ch]+i+4), hi);
+        a = _mm_max_ps(_mm_min_ps(a, hi), lo);
+        b = _mm_max_ps(_mm_min_ps(b, hi), lo);
+        ch16[ch] = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest+2*i),
+                       _mm_unpacklo_epi16(ch16[0], ch16[1]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest+2*i+8),
+                       _mm_unpackhi_epi16(ch16[0], ch16[1]));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t hi = vdupq_n_f32(32767.0f);
+    const float32x4_t lo = vdupq_n_f32(-32767.0f);
+    for (; i+8 <= frames; i += 8)
+    {
+      int16x8x2_t x;
+      for (int ch=0; ch<2; ++ch)
+      {
+        float32x4_t a = vmulq_f32(vld1q_f32(src[ch]+i), hi);
+        float32x4_t b = vmulq_f32(vld1q_f32(src[ch]+i+4), hi);
+        a = vmaxq_f32(vminq_f32(a, hi), lo);
+        b = vmaxq_f32(vminq_f32(b, hi), lo);
+        x.val[ch] = vcombine_s16(vqmovn_s32(audioKernelNeonRoundS32(a)),
+                                 vqmovn_s32(audioKernelNeonRoundS32(b)));
+      }
+      vst2q_s16(dest+2*i, x);
+    }
+#endif
+  }
+  for (; i<frames; ++i)
+  {
+    int16_t *frame = dest + i*channels;
+    for (int ch=0; ch<channels; ++ch)
+    {
+      float sample = src[ch][i] * 32767.0f;
+      sample = (sample > 32767.0f) ? 32767.0f : sample;
+      sample = (sample < -32767.0f) ? -32767.0f : sample;
+      frame[ch] = static_cast<int16_t>(lrintf(sample));
+    }
+  }
+} /* audioKernelInterleaveS16 */
+
+
+/**
+ * @brief   Split interleaved float frames into one buffer per channel
+ * @param   dest      One destination buffer for each channel
+ * @param   src       The source buffer containing frames*channels samples
+ * @param   channels  The number of channels in each frame
+ * @param   frames    The number of frames to process
+ *
+ * The channel buffers must not overlap the source buffer.
+ */
+inline void audioKernelDeinterleave(float *const *dest, const float *src,
+                                    int channels, int frames)
+{
+  int i = 0;
+  if (channels == 2)
+  {
+#if defined(__SSE__)
+    for (; i+4 <= frames; i += 4)
+    {
+      __m128 a = _mm_loadu_ps(src+2*i);
+      __m128 b = _mm_loadu_ps(src+2*i+4);
+      _mm_storeu_ps(dest[0]+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm_storeu_ps(dest[1]+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i+4 <= frames; i += 4)
+    {
+      float32x4x2_t x = vld2q_f32(src+2*i);
+      vst1q_f32(dest[0]+i, x.val[0]);
+      vst1q_f32(dest[1]+i, x.val[1]);
+    }
+#endif
+  }
+  for (; i<frames; ++i)
+  {
+    const float *frame = src + i*channels;
+    for (int ch=0; ch<channels; ++ch)
+    {
+      dest[ch][i] = frame[ch];
+    }
+  }
+} /* audioKernelDeinterleave */
+
+
+/**
+ * @brief   Merge one sample buffer per channel into interleaved float frames
+ * @param   dest      The destination buffer for frames*channels samples
+ * @param   src       One source buffer for each channel
+ * @param   channels  The number of channels in each frame
+ * @param   frames    The number of frames to process
+ *
+ * The samples are not clipped. The channel buffers must not overlap the
+ * destination buffer.
+ */
+inline void audioKernelInterleave(float *dest, const float *const *src,
+                                  int channels, int frames)
+{
+  int i = 0;
+  if (channels == 2)
+  {
+#if defined(__SSE__)
+    for (; i+4 <= frames; i += 4)
+    {
+      __m128 l = _mm_loadu_ps(src[0]+i);
+      __m128 r = _mm_loadu_ps(src[1]+i);
+      _mm_storeu_ps(dest+2*i, _mm_unpacklo_ps(l, r));
+      _mm_storeu_ps(dest+2*i+4, _mm_unpackhi_ps(l, r));
+    }
+#elif defined(__ARM_NEON)
+    for (; i+4 <= frames; i += 4)
+    {
+      float32x4x2_t x;
+      x.val[0] = vld1q_f32(src[0]+i);
+      x.val[1] = vld1q_f32(src[1]+i);
+      vst2q_f32(dest+2*i, x);
+    }
+#endif
+  }
+  for (; i<frames; ++i)
+  {
+    float *frame = dest + i*channels;
+    for (int ch=0; ch<channels; ++ch)
+    {
+      frame[ch] = src[ch][i];
+    }
+  }
+} /* audioKernelInterleave */
+
+
+/**
+ * @brief   Calculate the inner product of two blocks of Q15 samples
+ * @param   a     The first buffer, typically filter coefficients
+ * @param   b     The second buffer, typically a window of samples
+ * @param   count The number of samples in each buffer
+ * @return  Returns the sum of a[i]*b[i]
+ *
+ * The sum is accumulated in 32 bits without saturation so the caller must
+ * scale the coefficients so that the sum cannot overflow.
+ */
+inline int32_t audioKernelDotProductQ15(const int16_t *a, const int16_t *b,
+                                        int count)
+{
+  int i = 0;
+  int32_t sum = 0;
+#if defined(__SSE2__)
+  __m128i acc = _mm_setzero_si128();
+  for (; i+8 <= count; i += 8)
+  {
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(a+i)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(b+i))));
+  }
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  sum = _mm_cvtsi128_si32(acc);
+#elif defined(__ARM_NEON)
+  int32x4_t acc = vdupq_n_s32(0);
+  for (; i+8 <= count; i += 8)
+  {
+    const int16x8_t x = vld1q_s16(a+i);
+    const int16x8_t y = vld1q_s16(b+i);
+    acc = vmlal_s16(acc, vget_low_s16(x), vget_low_s16(y));
+    acc = vmlal_s16(acc, vget_high_s16(x), vget_high_s16(y));
+  }
+  int32x2_t sum2 = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+  sum = vget_lane_s32(vpadd_s32(sum2, sum2), 0);
+#endif
+  for (; i<count; ++i)
+  {
+    sum += static_cast<int32_t>(a[i]) * b[i];
+  }
+  return sum;
+} /* audioKernelDotProductQ15 */
+
+
+/**
+ * @brief   Calculate the inner product of two blocks of samples
+ * @param   a     The first buffer, typically filter coefficients
+ * @param   b     The second buffer, typically a window of samples
+ * @param   count The number of samples in each buffer
+ * @return  Returns the sum of a[i]*b[i]
+ *
+ * The partial sums are accumulated in vector registers so the result may
+ * differ slightly from a sequential sum due to rounding.
+ */
+inline float audioKernelDotProduct(const float *a, const float *b, int count)
+{
+  int i = 0;
+  float sum = 0.0f;
+#if defined(__AVX__)
+  __m256 acc = _mm256_setzero_ps();
+  for (; i+8 <= count; i += 8)
+  {
+#if defined(__FMA__)
+    acc = _mm256_fmadd_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i), acc);
+#else
+    acc = _mm256_add_ps(acc,
+        _mm256_mul_ps(_mm256_loadu_ps(a+i), _mm256_loadu_ps(b+i)));
+#endif
+  }
+  __m128 acc4 = _mm_add_ps(_mm256_castps256_ps128(acc),
+                           _mm256_extractf128_ps(acc, 1));
+  acc4 = _mm_add_ps(acc4, _mm_movehl_ps(acc4, acc4));
+  acc4 = _mm_add_ss(acc4, _mm_shuffle_ps(acc4, acc4, 1));
+  sum = _mm_cvtss_f32(acc4);
+#elif defined(__SSE__)
+  __m128 acc = _mm_setzero_ps();
+  for (; i+4 <= count; i += 4)
+  {
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i)));
+  }
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+  sum = _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON)
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  for (; i+4 <= count; i += 4)
+  {
+    acc = vmlaq_f32(acc, vld1q_f32(a+i), vld1q_f32(b+i));
+  }
+  float32x2_t acc2 = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  sum = vget_lane_f32(vpadd_f32(acc2, acc2), 0);
+#endif
+  for (; i<count; ++i)
+  {
+    sum += a[i] * b[i];
+  }
+  return sum;
+} /* audioKernelDotProduct */
+
+
+/**
+ * @brief   Calculate the inner product of real and complex samples
+ * @param   a     The real buffer, typically filter coefficients
+ * @param   b     The complex buffer, typically a window of I/Q samples
+ * @param   count The number of samples in each buffer
+ * @return  Returns the sum of a[i]*b[i]
+ *
+ * This is used when filtering complex samples with a real filter. The
+ * real and imaginary parts are handled in alternating vector lanes.
+ */
+inline std::complex<float> audioKernelDotProduct(const float *a,
+    const std::complex<float> *b, int count)
+{
+  const float *bf = reinterpret_cast<const float*>(b);
+  int i = 0;
+  float re = 0.0f;
+  float im = 0.0f;
+#if defined(__AVX__)
+  __m256 acc = _mm256_setzero_ps();
+  for (; i+4 <= count; i += 4)
+  {
+      // Duplicate each coefficient so that it match the re/im pairs
+    __m128 c = _mm_loadu_ps(a+i);
+    __m256 cc = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_unpacklo_ps(c, c)),
+        _mm_unpackhi_ps(c, c), 1);
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(cc, _mm256_loadu_ps(bf+2*i)));
+  }
+  __m128 acc4 = _mm_add_ps(_mm256_castps256_ps128(acc),
+                           _mm256_extractf128_ps(acc, 1));
+  acc4 = _mm_add_ps(acc4, _mm_movehl_ps(acc4, acc4));
+  re = _mm_cvtss_f32(acc4);
+  im = _mm_cvtss_f32(_mm_shuffle_ps(acc4, acc4, 1));
+#elif defined(__SSE__)
+  __m128 acc = _mm_setzero_ps();
+  for (; i+2 <= count; i += 2)
+  {
+    __m128 c = _mm_loadl_pi(_mm_setzero_ps(),
+                            reinterpret_cast<const __m64*>(a+i));
+    acc = _mm_add_ps(acc,
+        _mm_mul_ps(_mm_unpacklo_ps(c, c), _mm_loadu_ps(bf+2*i)));
+  }
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  re = _mm_cvtss_f32(acc);
+  im = _mm_cvtss_f32(_mm_shuffle_ps(acc, acc, 1));
+#elif defined(__ARM_NEON)
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  for (; i+2 <= count; i += 2)
+  {
+    float32x2_t c = vld1_f32(a+i);
+    float32x2x2_t cc = vzip_f32(c, c);
+    acc = vmlaq_f32(acc, vcombine_f32(cc.val[0], cc.val[1]),
+                    vld1q_f32(bf+2*i));
+  }
+  float32x2_t acc2 = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  re = vget_lane_f32(acc2, 0);
+  im = vget_lane_f32(acc2, 1);
+#endif
+  for (; i<count; ++i)
+  {
+    re += a[i] * bf[2*i];
+    im += a[i] * bf[2*i+1];
+  }
+  return std::complex<float>(re, im);
+} /* audioKernelDotProduct */
+
+
+/**
+ * @brief   Calculate the inner product of real and split complex samples
+ * @param   a     The real buffer, typically filter coefficients
+ * @param   re    The real parts of the complex samples
+ * @param   im    The imaginary parts of the complex samples
+ * @param   count The number of samples in each buffer
+ * @return  Returns the sum of a[i]*(re[i]+j*im[i])
+ *
+ * This is the same calculation as above but for complex samples stored as
+ * separate real and imaginary buffers. No shuffling is needed to match the
+ * coefficients to the samples so twice as many taps are processed for each
+ * vector operation.
+ */
+inline std::complex<float> audioKernelDotProduct(const float *a,
+    const float *re, const float *im, int count)
+{
+  int i = 0;
+  float sum_re = 0.0f;
+  float sum_im = 0.0f;
+#if defined(__AVX__)
+  __m256 acc_re = _mm256_setzero_ps();
+  __m256 acc_im = _mm256_setzero_ps();
+  for (; i+8 <= count; i += 8)
+  {
+    __m256 c = _mm256_loadu_ps(a+i);
+#if defined(__FMA__)
+    acc_re = _mm256_fmadd_ps(c, _mm256_loadu_ps(re+i), acc_re);
+    acc_im = _mm256_fmadd_ps(c, _mm256_loadu_ps(im+i), acc_im);
+#else
+    acc_re = _mm256_add_ps(acc_re, _mm256_mul_ps(c, _mm256_loadu_ps(re+i)));
+    acc_im = _mm256_add_ps(acc_im, _mm256_mul_ps(c, _mm256_loadu_ps(im+i)));
+#endif
+  }
+    // Reduce both accumulators at once, re in lane 0 and im in lane 1
+  __m128 r4 = _mm_add_ps(_mm256_castps256_ps128(acc_re),
+                         _mm256_extractf128_ps(acc_re, 1));
+  __m128 i4 = _mm_add_ps(_mm256_castps256_ps128(acc_im),
+                         _mm256_extractf128_ps(acc_im, 1));
+  __m128 ri = _mm_add_ps(_mm_unpacklo_ps(r4, i4), _mm_unpackhi_ps(r4, i4));
+  ri = _mm_add_ps(ri, _mm_movehl_ps(ri, ri));
+  sum_re = _mm_cvtss_f32(ri);
+  sum_im = _mm_cvtss_f32(_mm_shuffle_ps(ri, ri, 1));
+#elif defined(__SSE__)
+  __m128 acc_re = _mm_setzero_ps();
+  __m128 acc_im = _mm_setzero_ps();
+  for (; i+4 <= count; i += 4)
+  {
+    __m128 c = _mm_loadu_ps(a+i);
+    acc_re = _mm_add_ps(acc_re, _mm_mul_ps(c, _mm_loadu_ps(re+i)));
+    acc_im = _mm_add_ps(acc_im, _mm_mul_ps(c, _mm_loadu_ps(im+i)));
+  }
+  __m128 ri = _mm_add_ps(_mm_unpacklo_ps(acc_re, acc_im),
+                         _mm_unpackhi_ps(acc_re, acc_im));
+  ri = _mm_add_ps(ri, _mm_movehl_ps(ri, ri));
+  sum_re = _mm_cvtss_f32(ri);
+  sum_im = _mm_cvtss_f32(_mm_shuffle_ps(ri, ri, 1));
+#elif defined(__ARM_NEON)
+  float32x4_t acc_re = vdupq_n_f32(0.0f);
+  float32x4_t acc_im = vdupq_n_f32(0.0f);
+  for (; i+4 <= count; i += 4)
+  {
+    float32x4_t c = vld1q_f32(a+i);
+    acc_re = vmlaq_f32(acc_re, c, vld1q_f32(re+i));
+    acc_im = vmlaq_f32(acc_im, c, vld1q_f32(im+i));
+  }
+  float32x2_t ri = vpadd_f32(
+      vadd_f32(vget_low_f32(acc_re), vget_high_f32(acc_re)),
+      vadd_f32(vget_low_f32(acc_im), vget_high_f32(acc_im)));
+  sum_re = vget_lane_f32(ri, 0);
+  sum_im = vget_lane_f32(ri, 1);
+#endif
+  for (; i<count; ++i)
+  {
+    sum_re += a[i] * re[i];
+    sum_im += a[i] * im[i];
+  }
+  return std::complex<float>(sum_re, sum_im);
+} /* audioKernelDotProduct */
+
+
+/**
+ * @brief   Run a bank of parallel two pole resonators
+ * @param   dest    One destination buffer for each output
+ * @param   outputs The number of outputs
+ * @param   gain    The output gain for each output and resonator
+ * @param   src     The source buffer, fed to all resonators
+ * @param   count   The number of samples to process
+ * @param   z1      The last output of each resonator, updated
+ * @param   z2      The output before that of each resonator, updated
+ * @param   c1      The first feedback coefficient of each resonator
+ * @param   c2      The second feedback coefficient of each resonator
+ * @param   stages  The number of resonators
+ *
+ * Each resonator k calculate y[i] = src[i] + c1[k]*y[i-1] + c2[k]*y[i-2].
+ * Output o is the sum over all resonators of gain[o*stages+k]*y[i]. The
+ * resonators are stored as a structure of arrays so that one vector may
+ * update several resonators at once. Since a filter often only have a
+ * handful of resonators, SSE is used for the last four when AVX is enabled.
+ * The destination buffers are overwritten and must not overlap the source
+ * buffer.
+ */
+inline void audioKernelResonatorBank(float *const *dest, int outputs,
+    const float *gain, const float *src, int count, float *z1, float *z2,
+    const float *c1, const float *c2, int stages)
+{
+  for (int o=0; o<outputs; ++o)
+  {
+    for (int i=0; i<count; ++i)
+    {
+      dest[o][i] = 0.0f;
+    }
+  }
+  int k = 0;
+#if defined(__AVX__)
+  for (; k+8 <= stages; k += 8)
+  {
+    const __m256 a1 = _mm256_loadu_ps(c1+k);
+    const __m256 a2 = _mm256_loadu_ps(c2+k);
+    __m256 y1 = _mm256_loadu_ps(z1+k);
+    __m256 y2 = _mm256_loadu_ps(z2+k);
+    for (int i=0; i<count; ++i)
+    {
+      __m256 y = _mm256_add_ps(
+          _mm256_add_ps(_mm256_set1_ps(src[i]), _mm256_mul_ps(y1, a1)),
+          _mm256_mul_ps(y2, a2));
+      y2 = y1;
+      y1 = y;
+      for (int o=0; o<outputs; ++o)
+      {
+        __m256 p = _mm256_mul_ps(y, _mm256_loadu_ps(gain+o*stages+k));
+        __m128 p4 = _mm_add_ps(_mm256_castps256_ps128(p),
+                               _mm256_extractf128_ps(p, 1));
+        p4 = _mm_add_ps(p4, _mm_movehl_ps(p4, p4));
+        p4 = _mm_add_ss(p4, _mm_shuffle_ps(p4, p4, 1));
+        dest[o][i] += _mm_cvtss_f32(p4);
+      }
+    }
+    _mm256_storeu_ps(z1+k, y1);
+    _mm256_storeu_ps(z2+k, y2);
+  }
+#endif
+#if defined(__SSE__)
+  for (; k+4 <= stages; k += 4)
+  {
+    const __m128 a1 = _mm_loadu_ps(c1+k);
+    const __m128 a2 = _mm_loadu_ps(c2+k);
+    __m128 y1 = _mm_loadu_ps(z1+k);
+    __m128 y2 = _mm_loadu_ps(z2+k);
+    for (int i=0; i<count; ++i)
+    {
+      __m128 y = _mm_add_ps(
+          _mm_add_ps(_mm_set1_ps(src[i]), _mm_mul_ps(y1, a1)),
+          _mm_mul_ps(y2, a2));
+      y2 = y1;
+      y1 = y;
+      for (int o=0; o<outputs; ++o)
+      {
+        __m128 p = _mm_mul_ps(y, _mm_loadu_ps(gain+o*stages+k));
+        p = _mm_add_ps(p, _mm_movehl_ps(p, p));
+        p = _mm_add_ss(p, _mm_shuffle_ps(p, p, 1));
+        dest[o][i] += _mm_cvtss_f32(p);
+      }
+    }
+    _mm_storeu_ps(z1+k, y1);
+    _mm_storeu_ps(z2+k, y2);
+  }
+#elif defined(__ARM_NEON)
+  for (; k+4 <= stages; k += 4)
+  {
+    const float32x4_t a1 = vld1q_f32(c1+k);
+    const float32x4_t a2 = vld1q_f32(c2+k);
+    float32x4_t y1 = vld1q_f32(z1+k);
+    float32x4_t y2 = vld1q_f32(z2+k);
+    for (int i=0; i<count; ++i)
+    {
+      float32x4_t y = vmlaq_f32(vmlaq_f32(vdupq_n_f32(src[i]), y1, a1),
+                                y2, a2);
+      y2 = y1;
+      y1 = y;
+      for (int o=0; o<outputs; ++o)
+      {
+        float32x4_t p = vmulq_f32(y, vld1q_f32(gain+o*stages+k));
+        float32x2_t p2 = vadd_f32(vget_low_f32(p), vget_high_f32(p));
+        dest[o][i] += vget_lane_f32(vpadd_f32(p2, p2), 0);
+      }
+    }
+    vst1q_f32(z1+k, y1);
+    vst1q_f32(z2+k, y2);
+  }
+#endif
+  for (; k<stages; ++k)
+  {
+    float y1 = z1[k];
+    float y2 = z2[k];
+    for (int i=0; i<count; ++i)
+    {
+      float y = src[i] + y1*c1[k] + y2*c2[k];
+      y2 = y1;
+      y1 = y;
+      for (int o=0; o<outputs; ++o)
+      {
+        dest[o][i] += y * gain[o*stages+k];
+      }
+    }
+    z1[k] = y1;
+    z2[k] = y2;
+  }
+} /* audioKernelResonatorBank */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_KERNELS_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
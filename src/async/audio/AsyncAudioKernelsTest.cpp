@@ -0,0 +1,549 @@
+/**
+@file	 AsyncAudioKernelsTest.cpp
+@brief   Check that the SIMD code paths of the audio kernels match the scalar
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+The buffers are sized so that both the vectorized loop and the scalar tail of
+each kernel are used. The output is compared with a plain scalar reference
+computed in this file. Kernels that only do one operation per sample must
+match exactly. Sums may be added in another order by the vector code so they
+are compared with a small tolerance. The program exit with a non zero status
+if any sample differ.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioKernels.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // Not a multiple of the vector length so that the scalar tail is used too
+#define FRAMES  37
+
+  // More resonators than one AVX and one SSE vector so that all paths are used
+#define MAX_STAGES  13
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static float testSample(int idx);
+static int16_t refToS16(float sample);
+static int checkToS16(void);
+static int checkInterleaveS16(int channels);
+static bool isClose(double value, double expected, double scale);
+static int checkGain(void);
+static int checkAccumulate(void);
+static int checkComplexMultiply(bool in_place);
+static int checkDotProduct(void);
+static int checkDotProductQ15(void);
+static int checkComplexDotProduct(void);
+static int checkResonatorBank(int outputs, int stages);
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, const char **argv)
+{
+  int errors = checkToS16();
+  for (int channels=1; channels<=3; ++channels)
+  {
+    errors += checkInterleaveS16(channels);
+  }
+  errors += checkGain();
+  errors += checkAccumulate();
+  errors += checkComplexMultiply(false);
+  errors += checkComplexMultiply(true);
+  errors += checkDotProduct();
+  errors += checkDotProductQ15();
+  errors += checkComplexDotProduct();
+  for (int outputs=1; outputs<=2; ++outputs)
+  {
+    for (int stages=1; stages<=MAX_STAGES; ++stages)
+    {
+      errors += checkResonatorBank(outputs, stages);
+    }
+  }
+
+  if (errors > 0)
+  {
+    cerr << "*** ERROR: " << errors << " samples differ from the scalar "
+            "reference" << endl;
+    return 1;
+  }
+  cout << "All audio kernel checks passed" << endl;
+  return 0;
+} /* main */
+
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+/*
+ * Create a test sample that do not hit an integer, or a halfway case, when
+ * scaled to 16 bits. Some samples are out of range to check the clipping.
+ */
+static float testSample(int idx)
+{
+  if (idx % 11 == 5)
+  {
+    return (idx % 2 == 0) ? 1.5f : -1.5f;
+  }
+  const float frac = (idx % 2 == 0) ? 0.3f : 0.7f;
+  const float sign = (idx % 3 == 0) ? -1.0f : 1.0f;
+  return sign * ((idx * 677) % 32000 + frac) / 32767.0f;
+} /* testSample */
+
+
+static int16_t refToS16(float sample)
+{
+  sample *= 32767.0f;
+  sample = (sample > 32767.0f) ? 32767.0f : sample;
+  sample = (sample < -32767.0f) ? -32767.0f : sample;
+  return static_cast<int16_t>(lrintf(sample));
+} /* refToS16 */
+
+
+static int checkToS16(void)
+{
+  vector<float> src(FRAMES);
+  for (int i=0; i<FRAMES; ++i)
+  {
+    src[i] = testSample(i);
+  }
+  vector<int16_t> dest(FRAMES);
+  audioKernelToS16(&dest[0], &src[0], FRAMES);
+
+  int errors = 0;
+  for (int i=0; i<FRAMES; ++i)
+  {
+    if (dest[i] != refToS16(src[i]))
+    {
+      cerr << "*** ERROR: audioKernelToS16 sample " << i << ": got "
+           << dest[i] << ", expected " << refToS16(src[i]) << endl;
+      ++errors;
+    }
+  }
+  return errors;
+} /* checkToS16 */
+
+
+static int checkInterleaveS16(int channels)
+{
+  vector<vector<float> > planes(channels, vector<float>(FRAMES));
+  vector<const float*> src(channels);
+  for (int ch=0; ch<channels; ++ch)
+  {
+    for (int i=0; i<FRAMES; ++i)
+    {
+      planes[ch][i] = testSample(i * channels + ch);
+    }
+    src[ch] = &planes[ch][0];
+  }
+  vector<int16_t> dest(FRAMES * channels);
+  audioKernelInterleaveS16(&dest[0], &src[0], channels, FRAMES);
+
+  int errors = 0;
+  for (int i=0; i<FRAMES; ++i)
+  {
+    for (int ch=0; ch<channels; ++ch)
+    {
+      const int16_t expected = refToS16(planes[ch][i]);
+      if (dest[i * channels + ch] != expected)
+      {
+        cerr << "*** ERROR: audioKernelInterleaveS16 channels=" << channels
+             << " frame " << i << " channel " << ch << ": got "
+             << dest[i * channels + ch] << ", expected " << expected << endl;
+        ++errors;
+      }
+    }
+  }
+  return errors;
+} /* checkInterleaveS16 */
+
+
+/*
+ * Compare a value with a reference that may have been summed in another
+ * order. The scale should be the magnitude of the terms that were summed.
+ */
+static bool isClose(double value, double expected, double scale)
+{
+  return fabs(value - expected) <= 1.0e-5 * (scale + 1.0);
+} /* isClose */
+
+
+static int checkGain(void)
+{
+  const float gain = 0.37f;
+  vector<float> src(FRAMES);
+  for (int i=0; i<FRAMES; ++i)
+  {
+    src[i] = testSample(i);
+  }
+  vector<float> dest(FRAMES);
+  audioKernelGain(&dest[0], &src[0], gain, FRAMES);
+
+  int errors = 0;
+  for (int i=0; i<FRAMES; ++i)
+  {
+    const float expected = src[i] * gain;
+    if (dest[i] != expected)
+    {
+      cerr << "*** ERROR: audioKernelGain sample " << i << ": got "
+           << dest[i] << ", expected " << expected << endl;
+      ++errors;
+    }
+  }
+  return errors;
+} /* checkGain */
+
+
+static int checkAccumulate(void)
+{
+  vector<float> src(FRAMES);
+  vector<float> dest(FRAMES);
+  for (int i=0; i<FRAMES; ++i)
+  {
+    src[i] = testSample(i);
+    dest[i] = testSample(i + FRAMES);
+  }
+  vector<float> orig(dest);
+  audioKernelAccumulate(&dest[0], &src[0], FRAMES);
+
+  int errors = 0;
+  for (int i=0; i<FRAMES; ++i)
+  {
+    const float expected = orig[i] + src[i];
+    if (dest[i] != expected)
+    {
+      cerr << "*** ERROR: audioKernelAccumulate sample " << i << ": got "
+           << dest[i] << ", expected " << expected << endl;
+      ++errors;
+    }
+  }
+  return errors;
+} /* checkAccumulate */
+
+
+static int checkComplexMultiply(bool in_place)
+{
+  vector<complex<float> > a(FRAMES);
+  vector<complex<float> > b(FRAMES);
+  for (int i=0; i<FRAMES; ++i)
+  {
+    a[i] = complex<float>(testSample(2*i), testSample(2*i + 1));
+    b[i] = complex<float>(testSample(2*i + 2*FRAMES),
+                          testSample(2*i + 2*FRAMES + 1));
+  }
+  const vector<complex<float> > orig(a);
+  vector<complex<float> > out(FRAMES);
+  complex<float> *dest = in_place ? &a[0] : &out[0];
+  audioKernelComplexMultiply(dest, &a[0], &b[0], FRAMES);
+
+  int errors = 0;
+  for (int i=0; i<FRAMES; ++i)
+  {
+    const double re = static_cast<double>(orig[i].real()) * b[i].real() -
+                      static_cast<double>(orig[i].imag()) * b[i].imag();
+    const double im = static_cast<double>(orig[i].real()) * b[i].imag() +
+                      static_cast<double>(orig[i].imag()) * b[i].real();
+    const double scale = abs(orig[i]) * abs(b[i]);
+    if (!isClose(dest[i].real(), re, scale) ||
+        !isClose(dest[i].imag(), im, scale))
+    {
+      cerr << "*** ERROR: audioKernelComplexMultiply"
+           << (in_place ? " in place" : "") << " sample " << i << ": got "
+           << dest[i] << ", expected " << complex<double>(re, im) << endl;
+      ++errors;
+    }
+  }
+  return errors;
+} /* checkComplexMultiply */
+
+
+static int checkDotProduct(void)
+{
+  vector<float> a(FRAMES);
+  vector<float> b(FRAMES);
+  for (int i=0; i<FRAMES; ++i)
+  {
+    a[i] = testSample(i);
+    b[i] = testSample(i + FRAMES);
+  }
+
+  int errors = 0;
+  for (int count=0; count<=FRAMES; ++count)
+  {
+    double expected = 0.0;
+    double scale = 0.0;
+    for (int i=0; i<count; ++i)
+    {
+      expected += static_cast<double>(a[i]) * b[i];
+      scale += fabs(static_cast<double>(a[i]) * b[i]);
+    }
+    const float sum = audioKernelDotProduct(&a[0], &b[0], count);
+    if (!isClose(sum, expected, scale))
+    {
+      cerr << "*** ERROR: audioKernelDotProduct count=" << count << ": got "
+           << sum << ", expected " << expected << endl;
+      ++errors;
+    }
+  }
+  return errors;
+} /* checkDotProduct */
+
+
+static int checkDotProductQ15(void)
+{
+  vector<int16_t> a(FRAMES);
+  vector<int16_t> b(FRAMES);
+  for (int i=0; i<FRAMES; ++i)
+  {
+    a[i] = refToS16(testSample(i)) / 64;
+    b[i] = refToS16(testSample(i + FRAMES));
+  }
+
+  int errors = 0;
+  for (int count=0; count<=FRAMES; ++count)
+  {
+    int32_t expected = 0;
+    for (int i=0; i<count; ++i)
+    {
+      expected += static_cast<int32_t>(a[i]) * b[i];
+    }
+    const int32_t sum = audioKernelDotProductQ15(&a[0], &b[0], count);
+    if (sum != expected)
+    {
+      cerr << "*** ERROR: audioKernelDotProductQ15 count=" << count
+           << ": got " << sum << ", expected " << expected << endl;
+      ++errors;
+    }
+  }
+  return errors;
+} /* checkDotProductQ15 */
+
+
+static int checkComplexDotProduct(void)
+{
+  vector<float> a(FRAMES);
+  vector<complex<float> > b(FRAMES);
+  vector<float> re(FRAMES);
+  vector<float> im(FRAMES);
+  for (int i=0; i<FRAMES; ++i)
+  {
+    a[i] = testSample(i);
+    re[i] = testSample(2*i + FRAMES);
+    im[i] = testSample(2*i + FRAMES + 1);
+    b[i] = complex<float>(re[i], im[i]);
+  }
+
+  int errors = 0;
+  for (int count=0; count<=FRAMES; ++count)
+  {
+    complex<double> expected(0.0, 0.0);
+    double scale = 0.0;
+    for (int i=0; i<count; ++i)
+    {
+      expected += static_cast<double>(a[i]) * complex<double>(b[i]);
+      scale += fabs(a[i]) * abs(b[i]);
+    }
+    const complex<float> sums[2] = {
+      audioKernelDotProduct(&a[0], &b[0], count),
+      audioKernelDotProduct(&a[0], &re[0], &im[0], count)
+    };
+    for (int v=0; v<2; ++v)
+    {
+      if (!isClose(sums[v].real(), expected.real(), scale) ||
+          !isClose(sums[v].imag(), expected.imag(), scale))
+      {
+        cerr << "*** ERROR: audioKernelDotProduct "
+             << (v == 0 ? "complex" : "split complex") << " count=" << count
+             << ": got " << sums[v] << ", expected " << expected << endl;
+        ++errors;
+      }
+    }
+  }
+  return errors;
+} /* checkComplexDotProduct */
+
+
+static int checkResonatorBank(int outputs, int stages)
+{
+  vector<float> src(FRAMES);
+  for (int i=0; i<FRAMES; ++i)
+  {
+    src[i] = testSample(i);
+  }
+  vector<float> c1(stages);
+  vector<float> c2(stages);
+  vector<float> z1(stages);
+  vector<float> z2(stages);
+  for (int k=0; k<stages; ++k)
+  {
+      // Stable resonators with the poles at radius 0.9
+    c1[k] = 1.8f * cos(0.2f + 0.2f * k);
+    c2[k] = -0.81f;
+    z1[k] = testSample(3*k);
+    z2[k] = testSample(3*k + 1);
+  }
+  vector<float> gain(outputs * stages);
+  for (size_t i=0; i<gain.size(); ++i)
+  {
+    gain[i] = testSample(5*i + 2);
+  }
+
+    // The reference run each resonator on its own, in double precision
+  vector<vector<double> > expected(outputs, vector<double>(FRAMES, 0.0));
+  vector<vector<double> > scale(outputs, vector<double>(FRAMES, 0.0));
+  vector<double> ref_z1(stages);
+  vector<double> ref_z2(stages);
+  for (int k=0; k<stages; ++k)
+  {
+    double y1 = z1[k];
+    double y2 = z2[k];
+    for (int i=0; i<FRAMES; ++i)
+    {
+      const double y = src[i] + y1*c1[k] + y2*c2[k];
+      y2 = y1;
+      y1 = y;
+      for (int o=0; o<outputs; ++o)
+      {
+        expected[o][i] += y * gain[o*stages+k];
+        scale[o][i] += fabs(y * gain[o*stages+k]);
+      }
+    }
+    ref_z1[k] = y1;
+    ref_z2[k] = y2;
+  }
+
+  vector<vector<float> > planes(outputs, vector<float>(FRAMES, 1.0f));
+  vector<float*> dest(outputs);
+  for (int o=0; o<outputs; ++o)
+  {
+    dest[o] = &planes[o][0];
+  }
+  audioKernelResonatorBank(&dest[0], outputs, &gain[0], &src[0], FRAMES,
+                           &z1[0], &z2[0], &c1[0], &c2[0], stages);
+
+    // The recursion amplify the rounding errors so allow a little more
+  const double state_scale = 100.0;
+  int errors = 0;
+  for (int o=0; o<outputs; ++o)
+  {
+    for (int i=0; i<FRAMES; ++i)
+    {
+      if (!isClose(planes[o][i], expected[o][i], state_scale * scale[o][i]))
+      {
+        cerr << "*** ERROR: audioKernelResonatorBank outputs=" << outputs
+             << " stages=" << stages << " output " << o << " sample " << i
+             << ": got " << planes[o][i] << ", expected " << expected[o][i]
+             << endl;
+        ++errors;
+      }
+    }
+  }
+  for (int k=0; k<stages; ++k)
+  {
+    if (!isClose(z1[k], ref_z1[k], state_scale * fabs(ref_z1[k])) ||
+        !isClose(z2[k], ref_z2[k], state_scale * fabs(ref_z2[k])))
+    {
+      cerr << "*** ERROR: audioKernelResonatorBank outputs=" << outputs
+           << " stages=" << stages << " state " << k << ": got "
+           << z1[k] << "/" << z2[k] << ", expected " << ref_z1[k] << "/"
+           << ref_z2[k] << endl;
+      ++errors;
+    }
+  }
+  return errors;
+} /* checkResonatorBank */
+
+
+
+/*
+ * This file has not been truncated
+ */
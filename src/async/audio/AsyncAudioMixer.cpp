@@ -6,7 +6,7 @@
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2003-2015 Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <algorithm>
 #include <cstring>
+#include <cassert>
 
 
 /****************************************************************************
@@ -52,8 +53,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "AsyncAudioMixer.h"
-#include "AsyncAudioFifo.h"
-#include "AsyncAudioReader.h"
+#include "AsyncAudioSink.h"
+#include "AsyncAudioKernels.h"
 
 
 
@@ -88,32 +89,45 @@ class Async::AudioMixer::MixerSrc : public AudioSink
     static const int FIFO_SIZE = AudioMixer::OUTBUF_SIZE;
     
     MixerSrc(AudioMixer *mixer)
-      : fifo(FIFO_SIZE), mixer(mixer), is_flushed(true), do_flush(false)
+      : mixer(mixer), head(0), tail(0), fifo_cnt(0), is_flushed(true),
+        do_flush(false), input_stopped(false)
     {
-      AudioSink::setHandler(&fifo);
-      fifo.registerSink(&reader);
     }
     
     int writeSamples(const float *samples, int count)
     {
       //printf("Async::AudioMixer::MixerSrc::writeSamples: count=%d\n", count);
+      bool was_active = isActive();
       is_flushed = false;
       do_flush = false;
-      mixer->setAudioAvailable();
-      return fifo.writeSamples(samples, count);
+      int samples_to_write = min(count, FIFO_SIZE - fifo_cnt);
+      if (samples_to_write == 0)
+      {
+        input_stopped = true;
+        return 0;
+      }
+      int first_cnt = min(samples_to_write, FIFO_SIZE - head);
+      memcpy(fifo + head, samples, first_cnt * sizeof(*fifo));
+      memcpy(fifo, samples + first_cnt,
+             (samples_to_write - first_cnt) * sizeof(*fifo));
+      head = (head + samples_to_write) % FIFO_SIZE;
+      fifo_cnt += samples_to_write;
+      trace_queue.push(samples_to_write);
+      mixer->setAudioAvailable(!was_active);
+      return samples_to_write;
     }
     
     void flushSamples(void)
     {
-      if (is_flushed && !do_flush && fifo.empty())
+      if (is_flushed && !do_flush && (fifo_cnt == 0))
       {
-      	fifo.flushSamples();
+        sourceAllSamplesFlushed();
       }
       
       //printf("Async::AudioMixer::MixerSrc::flushSamples\n");
       is_flushed = true;
       do_flush = true;
-      if (fifo.empty())
+      if (fifo_cnt == 0)
       {
       	mixer->flushSamples();
       }
@@ -121,7 +135,7 @@ class Async::AudioMixer::MixerSrc : public AudioSink
     
     bool isActive(void) const
     {
-      return !is_flushed || !fifo.empty();
+      return !is_flushed || (fifo_cnt > 0);
     }
     
     void mixerFlushedAllSamples(void)
@@ -130,26 +144,56 @@ class Async::AudioMixer::MixerSrc : public AudioSink
       if (do_flush)
       {
       	do_flush = false;
-	//printf("\tFlushing FIFO\n");
-	fifo.flushSamples();
+        sourceAllSamplesFlushed();
       }
     }
     
     bool isFlushing(void) const { return do_flush; }
-    
-    int readSamples(float *samples, int count)
+
+      // Copy or add samples from the FIFO into the given buffer
+    void mixSamples(float *dest, int count, bool accumulate)
+    {
+      assert(count <= fifo_cnt);
+      int first_cnt = min(count, FIFO_SIZE - tail);
+      if (accumulate)
+      {
+        audioKernelAccumulate(dest, fifo + tail, first_cnt);
+        audioKernelAccumulate(dest + first_cnt, fifo, count - first_cnt);
+      }
+      else
+      {
+        memcpy(dest, fifo + tail, first_cnt * sizeof(*fifo));
+        memcpy(dest + first_cnt, fifo, (count - first_cnt) * sizeof(*fifo));
+      }
+      tail = (tail + count) % FIFO_SIZE;
+      fifo_cnt -= count;
+      trace_queue.pop(count);
+    }
+
+    void resumeInput(void)
     {
-      return reader.readSamples(samples, count);
+      if (input_stopped && (fifo_cnt < FIFO_SIZE))
+      {
+        input_stopped = false;
+        sourceResumeOutput();
+      }
     }
     
-    unsigned samplesInFifo(void) const { return fifo.samplesInFifo(); }
+    unsigned samplesInFifo(void) const { return fifo_cnt; }
+
+      // The trace tag of the oldest sample in the FIFO
+    AudioTrace::Tag traceTag(void) const { return trace_queue.front(); }
     
   private:
-    AudioFifo 	fifo;
-    AudioReader reader;
     AudioMixer  *mixer;
+    float       fifo[FIFO_SIZE];
+    int         head;
+    int         tail;
+    int         fifo_cnt;
     bool      	is_flushed;
     bool      	do_flush;
+    bool        input_stopped;
+    AudioTrace::Queue trace_queue;
     
 }; /* class Async::AudioMixer::MixerSrc */
 
@@ -189,7 +233,8 @@ class Async::AudioMixer::MixerSrc : public AudioSink
 
 AudioMixer::AudioMixer(void)
   : output_timer(0, Timer::TYPE_ONESHOT, false), outbuf_pos(0),
-    outbuf_cnt(0), is_flushed(true), output_stopped(false)
+    outbuf_cnt(0), is_flushed(true), output_stopped(false),
+    in_output_handler(false)
 {
   output_timer.expired.connect(mem_fun(*this, &AudioMixer::outputHandler));
 } /* AudioMixer::AudioMixer */
@@ -253,19 +298,28 @@ void AudioMixer::allSamplesFlushed(void)
  *----------------------------------------------------------------------------
  * Method:    AudioMixer::setAudioAvailable
  * Purpose:   Called by one of the incoming stream handlers when there is
- *            data available. This will trigger a delayed execution of the
- *            outputHandler method. The execution of the real output handler
- *            is delayed so that all input streams have a chance to fill up.
- * Input:     None
+ *            data available. The output handler is normally run directly.
+ *            It will only mix when all active input streams have data so
+ *            the input streams still wait for each other. When a stream
+ *            start, the execution of the output handler is delayed so that
+ *            other streams starting at the same time have a chance to fill
+ *            up. It is also delayed if called from within the output
+ *            handler, e.g. by a source that is resumed.
+ * Input:     stream_started - \em true if the calling stream just started
  * Output:    None
  * Created:   2007-10-07
  * Remarks:   
  * Bugs:      
  *----------------------------------------------------------------------------
  */
-void AudioMixer::setAudioAvailable(void)
+void AudioMixer::setAudioAvailable(bool stream_started)
 {
-  output_timer.setEnable(true);
+  if (stream_started)
+  {
+    output_timer.setEnable(true);
+    return;
+  }
+  outputHandler(0);
 } /* AudioMixer::setAudioAvailable */
 
 
@@ -307,6 +361,12 @@ void AudioMixer::outputHandler(Timer *t)
   {
     return;
   }
+  if (in_output_handler)
+  {
+    output_timer.setEnable(true);
+    return;
+  }
+  in_output_handler = true;
   
   unsigned samples_written;
   do
@@ -317,6 +377,7 @@ void AudioMixer::outputHandler(Timer *t)
     {
       //printf("Writing %d samples\n", outbuf_cnt-outbuf_pos);
       is_flushed = false;
+      AudioTrace::Scope trace_scope(outbuf_tag);
       samples_written = sinkWriteSamples(outbuf+outbuf_pos,
                                 	 outbuf_cnt-outbuf_pos);
       outbuf_pos += samples_written;
@@ -351,29 +412,40 @@ void AudioMixer::outputHandler(Timer *t)
 	break;
       }
 
-      	// Fill the output buffer with samples from all active FIFOs
-      memset(outbuf, 0, sizeof(outbuf));
-      float tmp[OUTBUF_SIZE];
+      	// Fill the output buffer with samples from all active FIFOs. The
+        // first source is copied and the rest are added to it. The mixed
+        // samples get the trace tag of the oldest audio.
+      bool accumulate = false;
+      outbuf_tag = AudioTrace::Tag();
       for (it = sources.begin(); it != sources.end(); ++it)
       {
 	if ((*it)->isActive())
 	{
-	  unsigned samples_read = (*it)->readSamples(tmp, samples_to_read);
-	  assert(samples_read == samples_to_read);
-
-	  for (unsigned i=0; i<samples_to_read; ++i)
-	  {
-      	    outbuf[i] += tmp[i];
-	  }
+          const AudioTrace::Tag tag = (*it)->traceTag();
+          if (tag.isValid() &&
+              (!outbuf_tag.isValid() || (tag.time < outbuf_tag.time)))
+          {
+            outbuf_tag = tag;
+          }
+	  (*it)->mixSamples(outbuf, samples_to_read, accumulate);
+          accumulate = true;
 	}
       }
 
       outbuf_pos = 0;
       outbuf_cnt = samples_to_read;
+
+        // Let stopped sources write more samples now when there is room
+        // in their FIFOs
+      for (it = sources.begin(); it != sources.end(); ++it)
+      {
+        (*it)->resumeInput();
+      }
     }
   } while (samples_written > 0);
   
   output_stopped = (samples_written == 0);
+  in_output_handler = false;
   
 } /* AudioMixer::outputHandler */
 
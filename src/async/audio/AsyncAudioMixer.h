@@ -6,7 +6,7 @@
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2004-2015 Tobias Blomberg / SM0SVX
+Copyright (C) 2004-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -45,6 +45,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncAudioSource.h>
+#include <AsyncAudioTrace.h>
 #include <AsyncTimer.h>
 
 
@@ -161,13 +162,15 @@ class AudioMixer : public sigc::trackable, public Async::AudioSource
     float     	      	  outbuf[OUTBUF_SIZE];
     unsigned       	  outbuf_pos;
     unsigned  	      	  outbuf_cnt;
+    AudioTrace::Tag       outbuf_tag;
     bool      	      	  is_flushed;
     bool      	      	  output_stopped;
+    bool                  in_output_handler;
     
     AudioMixer(const AudioMixer&);
     AudioMixer& operator=(const AudioMixer&);
     
-    void setAudioAvailable(void);
+    void setAudioAvailable(bool stream_started);
     void flushSamples(void);
     void outputHandler(Timer *t);
     void checkFlush(void);
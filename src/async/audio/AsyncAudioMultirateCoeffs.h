@@ -1,5 +1,52 @@
-#ifndef MULTIRATE_FILTER_COEFF_INCLUDED
-#define MULTIRATE_FILTER_COEFF_INCLUDED
+/**
+@file	 AsyncAudioMultirateCoeffs.h
+@brief   Filter coefficients for changing between common sample rates
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains FIR filter coefficients for use with AudioDecimator and
+AudioInterpolator when changing between 48kHz, 16kHz and 8kHz. All
+applications share this file instead of having their own copy.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_MULTIRATE_COEFFS_INCLUDED
+#define ASYNC_AUDIO_MULTIRATE_COEFFS_INCLUDED
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
 
 /**********************************************************************
  * The filters in this file have been designed using the filter
@@ -316,4 +363,12 @@ static const float coeff_16_8[coeff_16_8_taps] =
 };
 
 
-#endif /* MULTIRATE_FILTER_COEFF_INCLUDED */
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_MULTIRATE_COEFFS_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -53,6 +53,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncGaussianNoise.h>
 
 
 
@@ -124,6 +125,7 @@ class AudioNoiseAdder : public AudioProcessor
     /**
      * @brief 	Constuctor
      * @param   level_db The noise level in dB
+     * @param   seed The seed for the noise generator
      *
      * The level_db parameter deserve some clarification. A level of 0dB give
      * the same power as in a full scale sine wave. This make it possible to
@@ -131,13 +133,21 @@ class AudioNoiseAdder : public AudioProcessor
      * For example, if a sine wave is generated in SvxLink with a level of 0dB
      * and noise is added with a level of -10dB, we get a signal to noise ratio
      * (SNR) of 10dB.
+     * The same seed always give the same noise so that simulations can be
+     * reproduced.
      */
-    AudioNoiseAdder(float level_db);
+    AudioNoiseAdder(float level_db, uint64_t seed=0);
   
     /**
      * @brief 	Destructor
      */
     ~AudioNoiseAdder(void);
+
+    /**
+     * @brief   Seed the noise generator
+     * @param   seed The seed to use
+     */
+    void setSeed(uint64_t seed) { noise.setSeed(seed); }
     
   protected:
     /**
@@ -154,14 +164,11 @@ class AudioNoiseAdder : public AudioProcessor
     void processSamples(float *dest, const float *src, int count);
 
   private:
-    float sigma;        // Standard deviation of the generated noise
-    float z1;
-    bool generate;
-    unsigned int seed;
+    float         sigma;  // Standard deviation of the generated noise
+    GaussianNoise noise;
 
     AudioNoiseAdder(const AudioNoiseAdder&);
     AudioNoiseAdder& operator=(const AudioNoiseAdder&);
-    float generateGaussianNoise(void);
 
 };  /* class AudioNoiseAdder */
 
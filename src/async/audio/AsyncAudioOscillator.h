@@ -0,0 +1,282 @@
+/**
+@file    AsyncAudioOscillator.h
+@brief   A block based sine wave oscillator
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_OSCILLATOR_INCLUDED
+#define ASYNC_AUDIO_OSCILLATOR_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cmath>
+#include <cassert>
+#include <cstddef>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A block based sine wave oscillator
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class generate blocks of sine wave samples without calling a trigonometric
+function for each sample. The sine wave is produced by rotating a phasor one
+sample step at a time, which is just a complex multiplication. Four phasors,
+one sample apart, are rotated in parallel so that the compiler can vectorize
+the loop. To keep rounding errors from accumulating, the phasors are seeded
+from the exact phase every RESEED_INTERVAL samples.
+
+The oscillator does not keep track of time by itself. After generating a block,
+call advance with the number of samples that were actually used. A negative
+count can be used to step back, e.g. when a sink did not accept all samples.
+
+Several tones can be mixed in one pass using the generateSum function, which is
+what is needed for generating DTMF digits.
+
+\code
+Async::AudioOscillator osc;
+osc.setFq(1000.0, INTERNAL_SAMPLE_RATE);
+osc.setAmplitude(0.5f);
+float buf[256];
+osc.generate(buf, 256);
+osc.advance(256);
+\endcode
+*/
+class AudioOscillator
+{
+  public:
+      /// The maximum number of tones that can be mixed using generateSum
+    static const size_t MAX_MIX = 8;
+
+    /**
+     * @brief   Generate the sum of a number of oscillators
+     * @param   osc     An array of oscillators
+     * @param   osc_cnt The number of oscillators in the array
+     * @param   buf     The buffer to write samples to
+     * @param   count   The number of samples to generate
+     *
+     * The phase of the oscillators is not changed so advance must be called
+     * for each oscillator afterwards.
+     */
+    static void generateSum(const AudioOscillator *osc, size_t osc_cnt,
+                            float *buf, int count)
+    {
+      assert(osc_cnt <= MAX_MIX);
+      float re[MAX_MIX][LANES];
+      float im[MAX_MIX][LANES];
+      for (int start=0; start<count; start+=RESEED_INTERVAL)
+      {
+        const int len = (count - start < RESEED_INTERVAL)
+                      ? count - start : RESEED_INTERVAL;
+        for (size_t k=0; k<osc_cnt; ++k)
+        {
+          osc[k].seed(start, re[k], im[k]);
+        }
+        for (int i=0; i<len; i+=LANES)
+        {
+          float acc[LANES] = {0.0f};
+          for (size_t k=0; k<osc_cnt; ++k)
+          {
+            const float rot_re = osc[k].m_rot_re;
+            const float rot_im = osc[k].m_rot_im;
+            for (int l=0; l<LANES; ++l)
+            {
+              acc[l] += im[k][l];
+              const float next_re = re[k][l] * rot_re - im[k][l] * rot_im;
+              im[k][l] = im[k][l] * rot_re + re[k][l] * rot_im;
+              re[k][l] = next_re;
+            }
+          }
+          float *out = buf + start + i;
+          const int n = (len - i < LANES) ? len - i : LANES;
+          for (int l=0; l<n; ++l)
+          {
+            out[l] = acc[l];
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief   Default constructor
+     */
+    AudioOscillator(void)
+      : m_phase(0.0), m_phase_inc(0.0), m_amp(0.0f), m_rot_re(1.0f),
+        m_rot_im(0.0f)
+    {
+    }
+
+    /**
+     * @brief   Set the oscillator frequency
+     * @param   fq          The frequency in Hz
+     * @param   sample_rate The sample rate in Hz
+     */
+    void setFq(double fq, double sample_rate)
+    {
+      m_phase_inc = 2.0 * M_PI * fq / sample_rate;
+      m_rot_re = cos(LANES * m_phase_inc);
+      m_rot_im = sin(LANES * m_phase_inc);
+    }
+
+    /**
+     * @brief   Set the peak amplitude of the generated signal
+     * @param   amp The amplitude, 1.0 being full scale
+     */
+    void setAmplitude(float amp) { m_amp = amp; }
+
+    /**
+     * @brief   Get the peak amplitude of the generated signal
+     * @return  Returns the amplitude set using setAmplitude
+     */
+    float amplitude(void) const { return m_amp; }
+
+    /**
+     * @brief   Reset the phase of the oscillator to zero
+     */
+    void reset(void) { m_phase = 0.0; }
+
+    /**
+     * @brief   Move the phase of the oscillator forward
+     * @param   count The number of samples to move, may be negative
+     */
+    void advance(int count)
+    {
+      m_phase = fmod(m_phase + count * m_phase_inc, 2.0 * M_PI);
+      if (m_phase < 0.0)
+      {
+        m_phase += 2.0 * M_PI;
+      }
+    }
+
+    /**
+     * @brief   Generate samples starting at the current phase
+     * @param   buf   The buffer to write samples to
+     * @param   count The number of samples to generate
+     *
+     * The phase of the oscillator is not changed so advance must be called
+     * afterwards.
+     */
+    void generate(float *buf, int count) const
+    {
+      generateSum(this, 1, buf, count);
+    }
+
+  private:
+    static const int LANES = 4;
+    static const int RESEED_INTERVAL = 256;
+
+    double  m_phase;
+    double  m_phase_inc;
+    float   m_amp;
+    float   m_rot_re;
+    float   m_rot_im;
+
+    void seed(int offset, float *re, float *im) const
+    {
+      const double phase = m_phase + offset * m_phase_inc;
+      for (int l=0; l<LANES; ++l)
+      {
+        re[l] = m_amp * cos(phase + l * m_phase_inc);
+        im[l] = m_amp * sin(phase + l * m_phase_inc);
+      }
+    }
+
+};  /* class AudioOscillator */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_OSCILLATOR_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
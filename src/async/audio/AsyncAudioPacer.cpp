@@ -35,6 +35,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <stdio.h>
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <cassert>
 
@@ -45,6 +46,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncApplication.h>
 #include <AsyncTimer.h>
 
 
@@ -75,6 +77,8 @@ using namespace Async;
  *
  ****************************************************************************/
 
+  // The maximum amount of audio (ms) to output at once when catching up
+#define MAX_BURST_TIME 100
 
 
 /****************************************************************************
@@ -119,7 +123,10 @@ using namespace Async;
 
 AudioPacer::AudioPacer(int sample_rate, int block_size, int prebuf_time)
   : sample_rate(sample_rate), buf_size(block_size), prebuf_time(prebuf_time),
-    buf_pos(0), pace_timer(0), do_flush(false), input_stopped(false)
+    buf_pos(0), pace_timer(0), do_flush(false), input_stopped(false),
+    output_stopped(false), is_pacing(false), sink_clocked(false),
+    max_burst(1), pace_origin(0.0), samples_paced(0), max_lateness(0.0),
+    resync_cnt(0)
 {
   assert(sample_rate > 0);
   assert(block_size > 0);
@@ -127,16 +134,12 @@ AudioPacer::AudioPacer(int sample_rate, int block_size, int prebuf_time)
   
   buf = new float[buf_size];
   prebuf_samples = prebuf_time * sample_rate / 1000;
+  max_burst = max(1, MAX_BURST_TIME * sample_rate / 1000 / buf_size);
   
-  pace_timer = new Timer(buf_size * 1000 / sample_rate,
-       	      	      	 Timer::TYPE_PERIODIC);
-  pace_timer->expired.connect(mem_fun(*this, &AudioPacer::outputNextBlock));
-  
-  if (prebuf_samples > 0)
-  {
-    pace_timer->setEnable(false);
-  }
-  
+  pace_timer = new Timer(0, Timer::TYPE_ONESHOT);
+  pace_timer->setEnable(false);
+  pace_timer->expired.connect(
+      sigc::hide(mem_fun(*this, &AudioPacer::outputBlocks)));
 } /* AudioPacer::AudioPacer */
 
 
@@ -175,7 +178,10 @@ int AudioPacer::writeSamples(const float *samples, int count)
 	samples_written += writeSamples(samples + samples_written,
 	      	      	      	      	samples_left);
       }
-      pace_timer->setEnable(true);
+      if (!is_pacing && !output_stopped)
+      {
+        startPacing();
+      }
     }
     else
     {
@@ -192,9 +198,13 @@ int AudioPacer::writeSamples(const float *samples, int count)
     memcpy(buf + buf_pos, samples, samples_written * sizeof(*buf));
     buf_pos += samples_written;
     
-    if (!pace_timer->isEnabled())
+    if (!is_pacing && !output_stopped)
     {
-      pace_timer->setEnable(true);
+      startPacing();
+    }
+    else if (sink_clocked && !output_stopped && (buf_pos == buf_size))
+    {
+      outputBlocks();
     }
   }
   
@@ -217,17 +227,49 @@ void AudioPacer::flushSamples(void)
   {
     sinkFlushSamples();
   }
+  else if (sink_clocked && !output_stopped)
+  {
+    outputNextBlock();
+  }
 } /* AudioPacer::flushSamples */
 
 
 void AudioPacer::resumeOutput(void)
 {
+  output_stopped = false;
   if (prebuf_samples <= 0)
   {
-    pace_timer->setEnable(true);
-    outputNextBlock();
+      // Output the next block directly and then restart the schedule
+    is_pacing = true;
+    if (outputNextBlock())
+    {
+      startPacing();
+    }
+  }
+  else if (input_stopped)
+  {
+    input_stopped = false;
+    sourceResumeOutput();
   }
 } /* AudioPacer::resumeOutput */
+
+
+void AudioPacer::setSinkClocked(bool enable)
+{
+  sink_clocked = enable;
+  pace_timer->setEnable(false);
+  if (is_pacing && !output_stopped)
+  {
+    startPacing();
+  }
+} /* AudioPacer::setSinkClocked */
+
+
+void AudioPacer::resetPacingStats(void)
+{
+  max_lateness = 0.0;
+  resync_cnt = 0;
+} /* AudioPacer::resetPacingStats */
     
 
 
@@ -254,18 +296,84 @@ void AudioPacer::allSamplesFlushed(void)
  *
  ****************************************************************************/
 
+void AudioPacer::startPacing(void)
+{
+  is_pacing = true;
+  pace_origin = now();
+  samples_paced = 0;
+  if (sink_clocked)
+  {
+    outputBlocks();
+  }
+  else
+  {
+    schedule();
+  }
+} /* AudioPacer::startPacing */
+
+
+void AudioPacer::schedule(void)
+{
+    // A block is due when the time it takes to play it has passed
+  const double due = pace_origin +
+      static_cast<double>(samples_paced + buf_size) / sample_rate;
+  const int timeout = max(0, static_cast<int>(ceil(1000.0 * (due - now()))));
+  pace_timer->setEnable(false);
+  pace_timer->setTimeout(timeout);
+  pace_timer->setEnable(true);
+} /* AudioPacer::schedule */
+
 
-void AudioPacer::outputNextBlock(Timer *t)
+void AudioPacer::outputBlocks(void)
+{
+  const double t = now();
+  int burst = 0;
+  while (is_pacing && !output_stopped)
+  {
+    if (!sink_clocked)
+    {
+      const double due = pace_origin +
+          static_cast<double>(samples_paced + buf_size) / sample_rate;
+      if (t < due)
+      {
+        break;
+      }
+      if (burst == max_burst)
+      {
+          // We are too far behind, probably since the main loop has been
+          // blocked. Restart the schedule rather than sending a long burst.
+        pace_origin = t - static_cast<double>(samples_paced) / sample_rate;
+        resync_cnt += 1;
+        break;
+      }
+      max_lateness = max(max_lateness, t - due);
+    }
+    ++burst;
+    if (!outputNextBlock())
+    {
+      break;
+    }
+  }
+
+  if (is_pacing && !output_stopped && !sink_clocked)
+  {
+    schedule();
+  }
+} /* AudioPacer::outputBlocks */
+
+
+bool AudioPacer::outputNextBlock(void)
 {
   if (buf_pos < buf_size)
   {
+    is_pacing = false;
     pace_timer->setEnable(false);
     prebuf_samples = prebuf_time * sample_rate / 1000;
   }
   
   if (buf_pos == 0)
   {
-    return;
+    return false;
   }
   
   int samples_to_write = buf_pos;
@@ -277,6 +385,7 @@ void AudioPacer::outputNextBlock(Timer *t)
     tot_samples_written += samples_written;
     samples_to_write -= samples_written;
   } while ((samples_written > 0) && (samples_to_write > 0));
+  samples_paced += tot_samples_written;
 
   if (tot_samples_written < buf_pos)
   {
@@ -291,6 +400,7 @@ void AudioPacer::outputNextBlock(Timer *t)
   
   if (samples_written == 0)
   {
+    output_stopped = true;
     pace_timer->setEnable(false);
   }
   
@@ -304,10 +414,18 @@ void AudioPacer::outputNextBlock(Timer *t)
   {
     sinkFlushSamples();
   }
-  
+
+  return is_pacing && !output_stopped;
 } /* AudioPacer::outputNextBlock */
 
 
+double AudioPacer::now(void)
+{
+    // Use the main loop clock so that the pacing agree with the timers
+  return Application::app().monotonicTimeNs() / 1.0e9;
+} /* AudioPacer::now */
+
+
 
 
 /*
@@ -36,6 +36,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <sigc++/sigc++.h>
+#include <stdint.h>
 
 
 /****************************************************************************
@@ -111,6 +112,17 @@ class Timer;
 @date   2007-11-17
 
 This class is used in an audio pipe chain to pace audio output.
+
+The output is scheduled against the monotonic clock. Each block has a
+deadline calculated from the time the pacing started and the number of
+samples output since then, so timer jitter and main loop delays do not build
+up over long transmissions. After a delay, the blocks that are overdue are
+output in a burst of at most 100ms of audio. If the pacer is further behind
+than that, the schedule is restarted and the event is counted as a resync.
+
+The pacer can also be set up to be clocked by the connected sink instead of
+by a timer. Audio is then written as soon as the sink accept it so the pace is
+set by the consumption of a downstream audio device.
 */
 class AudioPacer : public AudioSink, public AudioSource, public sigc::trackable
 {
@@ -159,6 +171,41 @@ class AudioPacer : public AudioSink, public AudioSource, public sigc::trackable
      * This function is normally only called from a connected sink object.
      */
     virtual void resumeOutput(void);
+
+    /**
+     * @brief   Let the connected sink set the pace
+     * @param   enable Set to \em true to let the sink set the pace
+     *
+     * When enabled, no timer is used. Blocks are written to the sink as soon
+     * as it accept them so the output is paced by the sink, typically an
+     * audio device that consume the samples at the sample rate.
+     */
+    void setSinkClocked(bool enable);
+
+    /**
+     * @brief   Check if the pace is set by the connected sink
+     * @return  Returns \em true if the connected sink set the pace
+     */
+    bool isSinkClocked(void) const { return sink_clocked; }
+
+    /**
+     * @brief   Get the largest pacing error
+     * @return  Returns the largest time, in milliseconds, that a block has
+     *          been output after its deadline
+     */
+    double maxPacingError(void) const { return 1000.0 * max_lateness; }
+
+    /**
+     * @brief   Get the number of times the schedule has been restarted
+     * @return  Returns the number of times the pacer was too far behind to
+     *          catch up
+     */
+    unsigned long resyncCount(void) const { return resync_cnt; }
+
+    /**
+     * @brief   Reset the pacing statistics
+     */
+    void resetPacingStats(void);
     
 
   protected:
@@ -183,8 +230,20 @@ class AudioPacer : public AudioSink, public AudioSource, public sigc::trackable
     Async::Timer  *pace_timer;
     bool      	  do_flush;
     bool      	  input_stopped;
+    bool          output_stopped;
+    bool          is_pacing;
+    bool          sink_clocked;
+    int           max_burst;
+    double        pace_origin;
+    uint64_t      samples_paced;
+    double        max_lateness;
+    unsigned long resync_cnt;
     
-    void outputNextBlock(Async::Timer *t=0);
+    void startPacing(void);
+    void schedule(void);
+    void outputBlocks(void);
+    bool outputNextBlock(void);
+    static double now(void);
 
 };  /* class AudioPacer */
 
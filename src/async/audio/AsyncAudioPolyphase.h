@@ -0,0 +1,818 @@
+/**
+@file	 AsyncAudioPolyphase.h
+@brief   Polyphase FIR decimation and interpolation filters
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_POLYPHASE_INCLUDED
+#define ASYNC_AUDIO_POLYPHASE_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdint.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioKernels.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/*
+Both filters below keep the sample history in a buffer of twice the filter
+length where each sample is written twice, at pos and pos+len. That way the
+latest len samples are always available as one contiguous block, oldest
+first, without having to shift the history for each new sample. The
+coefficients are stored reversed to match so that each output sample is a
+plain inner product that can be calculated using audioKernelDotProduct.
+The sample type may be float or std::complex<float>. Complex samples are
+filtered by a specialization of the decimator that store the history with
+the real and imaginary parts in separate buffers. The sample type int16_t
+select specializations that filter Q15 samples using integer arithmetic.
+*/
+
+/**
+@brief	Filter coefficients converted to Q15
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+The coefficients are scaled by 2^shift where shift is at most 15. A smaller
+shift is used if any coefficient, or the sum of all coefficients, would
+otherwise not fit. The inner product of the coefficients and a window of
+Q15 samples then cannot overflow 32 bits.
+*/
+class AudioQ15Coeff
+{
+  public:
+    /**
+     * @brief 	Default constructor
+     */
+    AudioQ15Coeff(void) : m_shift(15) {}
+
+    /**
+     * @brief   Set the coefficients
+     * @param   coeff The coefficients as floating point values
+     */
+    void set(const std::vector<float>& coeff)
+    {
+      float max_abs = 0.0f;
+      float sum_abs = 0.0f;
+      for (size_t k=0; k<coeff.size(); ++k)
+      {
+        max_abs = std::max(max_abs, std::fabs(coeff[k]));
+        sum_abs += std::fabs(coeff[k]);
+      }
+      m_shift = 15;
+      while ((m_shift > 0) &&
+             ((max_abs * (1 << m_shift) > 32767.0f) ||
+              (sum_abs * (1 << m_shift) >= 65535.0f)))
+      {
+        --m_shift;
+      }
+      m_coeff.resize(coeff.size());
+      for (size_t k=0; k<coeff.size(); ++k)
+      {
+        m_coeff[k] = static_cast<int16_t>(lrintf(coeff[k] * (1 << m_shift)));
+      }
+    }
+
+    /**
+     * @brief   Filter a window of samples
+     * @param   first The offset of the first coefficient to use
+     * @param   window The samples, oldest first
+     * @param   count The number of samples in the window
+     * @return  Returns the filtered sample
+     */
+    int16_t filter(int first, const int16_t *window, int count) const
+    {
+      int32_t sum = audioKernelDotProductQ15(&m_coeff[first], window, count);
+      if (m_shift > 0)
+      {
+        sum = (sum + (1 << (m_shift - 1))) >> m_shift;
+      }
+      return static_cast<int16_t>(
+          std::min(std::max(sum, static_cast<int32_t>(-32768)),
+                   static_cast<int32_t>(32767)));
+    }
+
+  private:
+    std::vector<int16_t>  m_coeff;
+    int                   m_shift;
+
+};  /* class AudioQ15Coeff */
+
+
+/**
+@brief	A polyphase FIR decimator
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class implement a FIR decimation filter that only calculate the output
+samples that are kept. The number of input samples given to each call do not
+need to be a multiple of the decimation factor.
+*/
+template <class T>
+class AudioPolyphaseDecimator
+{
+  public:
+    /**
+     * @brief 	Default constructor
+     */
+    AudioPolyphaseDecimator(void) : m_factor(1), m_taps(0), m_pos(0), m_phase(0)
+    {
+    }
+
+    /**
+     * @brief 	Constructor
+     * @param   factor  The decimation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     */
+    AudioPolyphaseDecimator(int factor, const float *coeff, int taps)
+      : m_factor(1), m_taps(0), m_pos(0), m_phase(0)
+    {
+      setFilter(factor, coeff, taps);
+    }
+
+    /**
+     * @brief   Set up the filter
+     * @param   factor  The decimation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     *
+     * The sample history is cleared.
+     */
+    void setFilter(int factor, const float *coeff, int taps)
+    {
+      assert((factor > 0) && (taps > 0));
+      m_factor = factor;
+      m_taps = taps;
+      m_coeff.resize(taps);
+      setCoefficients(coeff);
+      m_hist.assign(2 * taps, T(0));
+      m_pos = 0;
+      m_phase = 0;
+    }
+
+    /**
+     * @brief   Change the filter coefficients
+     * @param   coeff   The new coefficients, same number as before
+     * @param   gain    A linear gain to apply to the coefficients
+     *
+     * The sample history is kept.
+     */
+    void setCoefficients(const float *coeff, float gain=1.0f)
+    {
+      for (int k=0; k<m_taps; ++k)
+      {
+        m_coeff[k] = gain * coeff[m_taps - 1 - k];
+      }
+    }
+
+    /**
+     * @brief   Get the decimation factor
+     * @return  Returns the decimation factor
+     */
+    int factor(void) const { return m_factor; }
+
+    /**
+     * @brief   Clear the sample history
+     */
+    void reset(void)
+    {
+      std::fill(m_hist.begin(), m_hist.end(), T(0));
+      m_pos = 0;
+      m_phase = 0;
+    }
+
+    /**
+     * @brief   Decimate a block of samples
+     * @param   dest  The destination buffer
+     * @param   src   The source buffer
+     * @param   count The number of samples in the source buffer
+     * @return  Returns the number of samples written to dest
+     *
+     * The destination buffer must have room for count/factor+1 samples.
+     */
+    int decimate(T *dest, const T *src, int count)
+    {
+      int num_out = 0;
+      for (int i=0; i<count; ++i)
+      {
+        m_hist[m_pos] = m_hist[m_pos + m_taps] = src[i];
+        if (++m_pos == m_taps)
+        {
+          m_pos = 0;
+        }
+        if (++m_phase == m_factor)
+        {
+          m_phase = 0;
+          dest[num_out++] = audioKernelDotProduct(&m_coeff[0], &m_hist[m_pos],
+                                                  m_taps);
+        }
+      }
+      return num_out;
+    }
+
+  private:
+    int                 m_factor;
+    int                 m_taps;
+    int                 m_pos;
+    int                 m_phase;
+    std::vector<float>  m_coeff;
+    std::vector<T>      m_hist;
+
+};  /* class AudioPolyphaseDecimator */
+
+
+/**
+@brief	A polyphase FIR decimator for complex samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This is a specialization of the decimator above for I/Q samples. The
+interface is the same but the sample history is stored as separate real and
+imaginary buffers so that the split complex audioKernelDotProduct can be
+used. The samples are split up when written to the history, which is done
+once per input sample, while the inner products that dominate the run time
+then do not need to shuffle the coefficients. The same class is used for
+channel filters, which are just decimators with a factor of one.
+*/
+template <>
+class AudioPolyphaseDecimator<std::complex<float> >
+{
+  public:
+    typedef std::complex<float> Sample;
+
+      // The filter length is padded with zero coefficients to a multiple
+      // of this so that no taps are left over for the scalar kernel code
+    static const int TAP_ALIGN = 8;
+
+    /**
+     * @brief 	Default constructor
+     */
+    AudioPolyphaseDecimator(void)
+      : m_factor(1), m_filter_taps(0), m_taps(0), m_pos(0), m_phase(0)
+    {
+    }
+
+    /**
+     * @brief 	Constructor
+     * @param   factor  The decimation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     */
+    AudioPolyphaseDecimator(int factor, const float *coeff, int taps)
+      : m_factor(1), m_filter_taps(0), m_taps(0), m_pos(0), m_phase(0)
+    {
+      setFilter(factor, coeff, taps);
+    }
+
+    /**
+     * @brief   Set up the filter
+     * @param   factor  The decimation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     *
+     * The sample history is cleared.
+     */
+    void setFilter(int factor, const float *coeff, int taps)
+    {
+      assert((factor > 0) && (taps > 0));
+      m_factor = factor;
+      m_filter_taps = taps;
+      m_taps = (taps + TAP_ALIGN - 1) / TAP_ALIGN * TAP_ALIGN;
+      m_coeff.assign(m_taps, 0.0f);
+      setCoefficients(coeff);
+      m_hist_re.assign(2 * m_taps, 0.0f);
+      m_hist_im.assign(2 * m_taps, 0.0f);
+      m_pos = 0;
+      m_phase = 0;
+    }
+
+    /**
+     * @brief   Change the filter coefficients
+     * @param   coeff   The new coefficients, same number as before
+     * @param   gain    A linear gain to apply to the coefficients
+     *
+     * The sample history is kept.
+     */
+    void setCoefficients(const float *coeff, float gain=1.0f)
+    {
+        // The padding goes first, where the oldest samples are
+      const int pad = m_taps - m_filter_taps;
+      for (int k=0; k<m_filter_taps; ++k)
+      {
+        m_coeff[pad + k] = gain * coeff[m_filter_taps - 1 - k];
+      }
+    }
+
+    /**
+     * @brief   Get the decimation factor
+     * @return  Returns the decimation factor
+     */
+    int factor(void) const { return m_factor; }
+
+    /**
+     * @brief   Clear the sample history
+     */
+    void reset(void)
+    {
+      std::fill(m_hist_re.begin(), m_hist_re.end(), 0.0f);
+      std::fill(m_hist_im.begin(), m_hist_im.end(), 0.0f);
+      m_pos = 0;
+      m_phase = 0;
+    }
+
+    /**
+     * @brief   Decimate a block of samples
+     * @param   dest  The destination buffer
+     * @param   src   The source buffer
+     * @param   count The number of samples in the source buffer
+     * @return  Returns the number of samples written to dest
+     *
+     * The destination buffer must have room for count/factor+1 samples.
+     */
+    int decimate(Sample *dest, const Sample *src, int count)
+    {
+      int num_out = 0;
+      for (int i=0; i<count; ++i)
+      {
+        m_hist_re[m_pos] = m_hist_re[m_pos + m_taps] = src[i].real();
+        m_hist_im[m_pos] = m_hist_im[m_pos + m_taps] = src[i].imag();
+        if (++m_pos == m_taps)
+        {
+          m_pos = 0;
+        }
+        if (++m_phase == m_factor)
+        {
+          m_phase = 0;
+          dest[num_out++] = audioKernelDotProduct(&m_coeff[0],
+              &m_hist_re[m_pos], &m_hist_im[m_pos], m_taps);
+        }
+      }
+      return num_out;
+    }
+
+  private:
+    int                 m_factor;
+    int                 m_filter_taps;
+    int                 m_taps;
+    int                 m_pos;
+    int                 m_phase;
+    std::vector<float>  m_coeff;
+    std::vector<float>  m_hist_re;
+    std::vector<float>  m_hist_im;
+
+};  /* class AudioPolyphaseDecimator<std::complex<float> > */
+
+
+/**
+@brief	A polyphase FIR decimator for Q15 samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+This is a specialization of the decimator for 16 bit fixed point samples.
+The interface is the same as for the floating point version. Multiplying
+eight 16 bit values at a time is faster than floating point on small ARM
+boards. The output is saturated to the 16 bit range.
+*/
+template <>
+class AudioPolyphaseDecimator<int16_t>
+{
+  public:
+    /**
+     * @brief 	Default constructor
+     */
+    AudioPolyphaseDecimator(void) : m_factor(1), m_taps(0), m_pos(0), m_phase(0)
+    {
+    }
+
+    /**
+     * @brief 	Constructor
+     * @param   factor  The decimation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     */
+    AudioPolyphaseDecimator(int factor, const float *coeff, int taps)
+      : m_factor(1), m_taps(0), m_pos(0), m_phase(0)
+    {
+      setFilter(factor, coeff, taps);
+    }
+
+    /**
+     * @brief   Set up the filter
+     * @param   factor  The decimation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     *
+     * The sample history is cleared.
+     */
+    void setFilter(int factor, const float *coeff, int taps)
+    {
+      assert((factor > 0) && (taps > 0));
+      m_factor = factor;
+      m_taps = taps;
+      setCoefficients(coeff);
+      m_hist.assign(2 * taps, 0);
+      m_pos = 0;
+      m_phase = 0;
+    }
+
+    /**
+     * @brief   Change the filter coefficients
+     * @param   coeff   The new coefficients, same number as before
+     * @param   gain    A linear gain to apply to the coefficients
+     *
+     * The sample history is kept.
+     */
+    void setCoefficients(const float *coeff, float gain=1.0f)
+    {
+      std::vector<float> rev(m_taps);
+      for (int k=0; k<m_taps; ++k)
+      {
+        rev[k] = gain * coeff[m_taps - 1 - k];
+      }
+      m_coeff.set(rev);
+    }
+
+    /**
+     * @brief   Get the decimation factor
+     * @return  Returns the decimation factor
+     */
+    int factor(void) const { return m_factor; }
+
+    /**
+     * @brief   Clear the sample history
+     */
+    void reset(void)
+    {
+      std::fill(m_hist.begin(), m_hist.end(), 0);
+      m_pos = 0;
+      m_phase = 0;
+    }
+
+    /**
+     * @brief   Decimate a block of samples
+     * @param   dest  The destination buffer
+     * @param   src   The source buffer
+     * @param   count The number of samples in the source buffer
+     * @return  Returns the number of samples written to dest
+     *
+     * The destination buffer must have room for count/factor+1 samples.
+     */
+    int decimate(int16_t *dest, const int16_t *src, int count)
+    {
+      int num_out = 0;
+      for (int i=0; i<count; ++i)
+      {
+        m_hist[m_pos] = m_hist[m_pos + m_taps] = src[i];
+        if (++m_pos == m_taps)
+        {
+          m_pos = 0;
+        }
+        if (++m_phase == m_factor)
+        {
+          m_phase = 0;
+          dest[num_out++] = m_coeff.filter(0, &m_hist[m_pos], m_taps);
+        }
+      }
+      return num_out;
+    }
+
+  private:
+    int                   m_factor;
+    int                   m_taps;
+    int                   m_pos;
+    int                   m_phase;
+    AudioQ15Coeff         m_coeff;
+    std::vector<int16_t>  m_hist;
+
+};  /* class AudioPolyphaseDecimator<int16_t> */
+
+
+/**
+@brief	A polyphase FIR interpolator
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class implement a FIR interpolation filter. The filter is split up into
+one sub filter per output phase so the zero samples that would be stuffed
+in between the input samples are never multiplied. If the number of taps is
+not a multiple of the interpolation factor, the last taps are ignored.
+*/
+template <class T>
+class AudioPolyphaseInterpolator
+{
+  public:
+    /**
+     * @brief 	Default constructor
+     */
+    AudioPolyphaseInterpolator(void) : m_factor(1), m_phase_taps(0), m_pos(0)
+    {
+    }
+
+    /**
+     * @brief 	Constructor
+     * @param   factor  The interpolation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     * @param   gain    A linear gain to apply to the coefficients
+     */
+    AudioPolyphaseInterpolator(int factor, const float *coeff, int taps,
+                               float gain=1.0f)
+      : m_factor(1), m_phase_taps(0), m_pos(0)
+    {
+      setFilter(factor, coeff, taps, gain);
+    }
+
+    /**
+     * @brief   Set up the filter
+     * @param   factor  The interpolation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     * @param   gain    A linear gain to apply to the coefficients
+     *
+     * The sample history is cleared.
+     */
+    void setFilter(int factor, const float *coeff, int taps, float gain=1.0f)
+    {
+      assert((factor > 0) && (taps >= factor));
+      m_factor = factor;
+      m_phase_taps = taps / factor;
+      m_coeff.resize(factor * m_phase_taps);
+      for (int phase=0; phase<factor; ++phase)
+      {
+        for (int k=0; k<m_phase_taps; ++k)
+        {
+          m_coeff[phase * m_phase_taps + k] =
+            gain * coeff[phase + factor * (m_phase_taps - 1 - k)];
+        }
+      }
+      m_hist.assign(2 * m_phase_taps, T(0));
+      m_pos = 0;
+    }
+
+    /**
+     * @brief   Get the interpolation factor
+     * @return  Returns the interpolation factor
+     */
+    int factor(void) const { return m_factor; }
+
+    /**
+     * @brief   Clear the sample history
+     */
+    void reset(void)
+    {
+      std::fill(m_hist.begin(), m_hist.end(), T(0));
+      m_pos = 0;
+    }
+
+    /**
+     * @brief   Interpolate a block of samples
+     * @param   dest  The destination buffer
+     * @param   src   The source buffer
+     * @param   count The number of samples in the source buffer
+     * @return  Returns the number of samples written to dest, which is
+     *          always count*factor
+     */
+    int interpolate(T *dest, const T *src, int count)
+    {
+      for (int i=0; i<count; ++i)
+      {
+        m_hist[m_pos] = m_hist[m_pos + m_phase_taps] = src[i];
+        if (++m_pos == m_phase_taps)
+        {
+          m_pos = 0;
+        }
+        const T *window = &m_hist[m_pos];
+        for (int phase=0; phase<m_factor; ++phase)
+        {
+          *dest++ = audioKernelDotProduct(&m_coeff[phase * m_phase_taps],
+                                          window, m_phase_taps);
+        }
+      }
+      return count * m_factor;
+    }
+
+  private:
+    int                 m_factor;
+    int                 m_phase_taps;
+    int                 m_pos;
+    std::vector<float>  m_coeff;
+    std::vector<T>      m_hist;
+
+};  /* class AudioPolyphaseInterpolator */
+
+
+/**
+@brief	A polyphase FIR interpolator for Q15 samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+This is a specialization of the interpolator for 16 bit fixed point samples.
+The interface is the same as for the floating point version. The output is
+saturated to the 16 bit range.
+*/
+template <>
+class AudioPolyphaseInterpolator<int16_t>
+{
+  public:
+    /**
+     * @brief 	Default constructor
+     */
+    AudioPolyphaseInterpolator(void) : m_factor(1), m_phase_taps(0), m_pos(0)
+    {
+    }
+
+    /**
+     * @brief 	Constructor
+     * @param   factor  The interpolation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     * @param   gain    A linear gain to apply to the coefficients
+     */
+    AudioPolyphaseInterpolator(int factor, const float *coeff, int taps,
+                               float gain=1.0f)
+      : m_factor(1), m_phase_taps(0), m_pos(0)
+    {
+      setFilter(factor, coeff, taps, gain);
+    }
+
+    /**
+     * @brief   Set up the filter
+     * @param   factor  The interpolation factor
+     * @param   coeff   The filter coefficients
+     * @param   taps    The number of filter coefficients
+     * @param   gain    A linear gain to apply to the coefficients
+     *
+     * The sample history is cleared.
+     */
+    void setFilter(int factor, const float *coeff, int taps, float gain=1.0f)
+    {
+      assert((factor > 0) && (taps >= factor));
+      m_factor = factor;
+      m_phase_taps = taps / factor;
+      std::vector<float> phase_coeff(factor * m_phase_taps);
+      for (int phase=0; phase<factor; ++phase)
+      {
+        for (int k=0; k<m_phase_taps; ++k)
+        {
+          phase_coeff[phase * m_phase_taps + k] =
+            gain * coeff[phase + factor * (m_phase_taps - 1 - k)];
+        }
+      }
+      m_coeff.set(phase_coeff);
+      m_hist.assign(2 * m_phase_taps, 0);
+      m_pos = 0;
+    }
+
+    /**
+     * @brief   Get the interpolation factor
+     * @return  Returns the interpolation factor
+     */
+    int factor(void) const { return m_factor; }
+
+    /**
+     * @brief   Clear the sample history
+     */
+    void reset(void)
+    {
+      std::fill(m_hist.begin(), m_hist.end(), 0);
+      m_pos = 0;
+    }
+
+    /**
+     * @brief   Interpolate a block of samples
+     * @param   dest  The destination buffer
+     * @param   src   The source buffer
+     * @param   count The number of samples in the source buffer
+     * @return  Returns the number of samples written to dest, which is
+     *          always count*factor
+     */
+    int interpolate(int16_t *dest, const int16_t *src, int count)
+    {
+      for (int i=0; i<count; ++i)
+      {
+        m_hist[m_pos] = m_hist[m_pos + m_phase_taps] = src[i];
+        if (++m_pos == m_phase_taps)
+        {
+          m_pos = 0;
+        }
+        const int16_t *window = &m_hist[m_pos];
+        for (int phase=0; phase<m_factor; ++phase)
+        {
+          *dest++ = m_coeff.filter(phase * m_phase_taps, window, m_phase_taps);
+        }
+      }
+      return count * m_factor;
+    }
+
+  private:
+    int                   m_factor;
+    int                   m_phase_taps;
+    int                   m_pos;
+    AudioQ15Coeff         m_coeff;
+    std::vector<int16_t>  m_hist;
+
+};  /* class AudioPolyphaseInterpolator<int16_t> */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_POLYPHASE_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <iostream>
 #include <algorithm>
+#include <typeinfo>
 
 #include <cstring>
 
@@ -54,6 +55,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "AsyncAudioProcessor.h"
+#include "AsyncAudioPassthrough.h"
 
 
 
@@ -118,7 +120,8 @@ using namespace Async;
 AudioProcessor::AudioProcessor(void)
   : buf_cnt(0), do_flush(false), input_stopped(false),
     output_stopped(false), input_rate(1), output_rate(1), input_buf(0),
-    input_buf_cnt(0), input_buf_size(0)
+    input_buf_cnt(0), input_buf_size(0), frame_size(0),
+    is_fused_stage(false)
 {
   
 } /* AudioProcessor::AudioProcessor */
@@ -126,6 +129,7 @@ AudioProcessor::AudioProcessor(void)
 
 AudioProcessor::~AudioProcessor(void)
 {
+  unfuseChain();
   delete [] input_buf;
 } /* AudioProcessor::~AudioProcessor */
 
@@ -137,12 +141,18 @@ int AudioProcessor::writeSamples(const float *samples, int len)
   assert(len > 0);
   
   do_flush = false;
+  is_fused_stage = false;
   int orig_len = len;
   
   writeFromBuf();
 
-    // Calculate the maximum number of samples we are able to process
+    // Calculate the maximum number of samples we are able to process. Only
+    // whole blocks are processed when using an input buffer.
   int max_proc = (BUFSIZE - buf_cnt) * input_rate / output_rate;
+  if (input_buf_size > 0)
+  {
+    max_proc -= max_proc % input_buf_size;
+  }
   if (max_proc == 0)
   {
     input_stopped = true;
@@ -160,8 +170,7 @@ int AudioProcessor::writeSamples(const float *samples, int len)
     
     if (input_buf_cnt == input_buf_size)
     {
-      processSamples(buf + buf_cnt, input_buf, input_buf_size);
-      buf_cnt += 1;
+      processToBuf(input_buf, input_buf_size);
       max_proc -= input_buf_size;
       input_buf_cnt = 0;
     }
@@ -176,12 +185,11 @@ int AudioProcessor::writeSamples(const float *samples, int len)
   int proc_cnt = min(max_proc, len-reminder);
   if (proc_cnt > 0)
   {
-    processSamples(buf + buf_cnt, samples, proc_cnt);
-    buf_cnt += proc_cnt * output_rate / input_rate;
+    processToBuf(samples, proc_cnt);
     samples += proc_cnt;
     len -= proc_cnt;
-    writeFromBuf();
   }
+  writeFromBuf();
 
   if ((len > 0) && (len < input_buf_size))
   {
@@ -211,11 +219,7 @@ void AudioProcessor::flushSamples(void)
   {
     if (input_buf_cnt > 0)
     {
-      memset(input_buf + input_buf_cnt, 0,
-      	     (input_buf_size - input_buf_cnt) * sizeof(*input_buf));
-      processSamples(buf, input_buf, input_buf_size);
-      buf_cnt += 1;
-      input_buf_cnt = 0;
+      processInputBuf();
       writeFromBuf();
     }
     else
@@ -232,6 +236,13 @@ void AudioProcessor::resumeOutput(void)
   //cout << "AudioProcessor::resumeOutput" << endl;
   output_stopped = false;
   writeFromBuf();
+
+    // A fused stage never get any samples written to it so it has to pass
+    // the resume on to the processor that it is fused into
+  if (is_fused_stage && (buf_cnt == 0))
+  {
+    sourceResumeOutput();
+  }
 } /* AudioProcessor::resumeOutput */
 
 
@@ -243,23 +254,90 @@ void AudioProcessor::allSamplesFlushed(void)
 } /* AudioProcessor::allSamplesFlushed */
 
 
-void AudioProcessor::setInputOutputSampleRate(int input_rate, int output_rate)
+void AudioProcessor::setFrameSize(int frame_size)
 {
-  assert((input_rate % output_rate == 0) || (output_rate % input_rate == 0));
-  this->input_rate = input_rate;
-  this->output_rate = output_rate;
-  
-  delete [] input_buf;
-  if (input_rate > output_rate)
+  assert(frame_size >= 0);
+  this->frame_size = frame_size;
+  setupInputBuf();
+} /* AudioProcessor::setFrameSize */
+
+
+int AudioProcessor::fuseChain(void)
+{
+  unfuseChain();
+
+  AudioSource *prev = this;
+  while (prev->sink() != 0)
   {
-    input_buf_size = input_rate / output_rate;
-    input_buf = new float[input_buf_size];
+    FusedHop hop;
+    hop.sink = prev->sink();
+      // Only plain passthrough objects are skipped. Classes inheriting
+      // AudioPassthrough usually do something with the samples.
+    if (typeid(*hop.sink) == typeid(AudioPassthrough))
+    {
+      AudioPassthrough *pass = static_cast<AudioPassthrough*>(hop.sink);
+      hop.source = pass;
+      hop.proc = 0;
+    }
+    else
+    {
+      AudioProcessor *proc = dynamic_cast<AudioProcessor*>(hop.sink);
+      if ((proc == 0) || (proc == this) || !proc->isSampleWise() ||
+          (proc->input_rate != proc->output_rate) ||
+          (proc->frame_size != 0) || (proc->buf_cnt > 0) ||
+          (proc->input_buf_cnt > 0))
+      {
+        break;
+      }
+      proc->unfuseChain();
+      hop.source = proc;
+      hop.proc = proc;
+    }
+    fused_hops.push_back(hop);
+    prev = hop.source;
   }
-  else
+
+  for (std::vector<FusedHop>::iterator it = fused_hops.begin();
+       it != fused_hops.end(); ++it)
   {
-    input_buf_size = 0;
-    input_buf = 0;
+    if (it->proc != 0)
+    {
+      it->proc->is_fused_stage = true;
+    }
+  }
+
+  return fused_hops.size();
+} /* AudioProcessor::fuseChain */
+
+
+void AudioProcessor::unfuseChain(void)
+{
+    // Only touch the stages that are still connected. The ones after a
+    // broken link may have been deleted.
+  AudioSource *prev = this;
+  for (std::vector<FusedHop>::iterator it = fused_hops.begin();
+       it != fused_hops.end(); ++it)
+  {
+    if (prev->sink() != it->sink)
+    {
+      break;
+    }
+    if (it->proc != 0)
+    {
+      it->proc->is_fused_stage = false;
+    }
+    prev = it->source;
   }
+  fused_hops.clear();
+} /* AudioProcessor::unfuseChain */
+
+
+void AudioProcessor::setInputOutputSampleRate(int input_rate, int output_rate)
+{
+  assert((input_rate % output_rate == 0) || (output_rate % input_rate == 0));
+  this->input_rate = input_rate;
+  this->output_rate = output_rate;
+  setupInputBuf();
 } /* AudioProcessor::setSampleRateRatio */
 
 
@@ -318,7 +396,7 @@ void AudioProcessor::writeFromBuf(void)
   int written;
   do
   {
-    written = sinkWriteSamples(buf, buf_cnt);
+    written = writeToSink(buf, buf_cnt);
     assert((written >= 0) && (written <= buf_cnt));
     if (written > 0)
     {
@@ -333,11 +411,7 @@ void AudioProcessor::writeFromBuf(void)
     {
       if (input_buf_cnt > 0)
       {
-	memset(input_buf + input_buf_cnt, 0,
-      	       (input_buf_size - input_buf_cnt) * sizeof(*input_buf));
-	processSamples(buf, input_buf, input_buf_size);
-	buf_cnt += 1;
-	input_buf_cnt = 0;
+        processInputBuf();
       }
       else
       {
@@ -360,6 +434,113 @@ void AudioProcessor::writeFromBuf(void)
 } /* AudioProcessor::writeFromBuf */
 
 
+void AudioProcessor::setupInputBuf(void)
+{
+    // Samples are processed in blocks of input_buf_size samples. When
+    // decimating, a block must contain a whole number of output samples.
+    // In framed mode, a block is one frame.
+  int block_size = 1;
+  if (frame_size > 0)
+  {
+    assert((input_rate <= output_rate) ||
+           (frame_size % (input_rate / output_rate) == 0));
+    assert(frame_size * output_rate / input_rate <= BUFSIZE);
+    block_size = frame_size;
+  }
+  else if (input_rate > output_rate)
+  {
+    block_size = input_rate / output_rate;
+  }
+
+  delete [] input_buf;
+  input_buf_cnt = 0;
+  if (block_size > 1)
+  {
+    input_buf_size = block_size;
+    input_buf = new float[input_buf_size];
+  }
+  else
+  {
+    input_buf_size = 0;
+    input_buf = 0;
+  }
+} /* AudioProcessor::setupInputBuf */
+
+
+void AudioProcessor::processInputBuf(void)
+{
+    // Process the samples left in the input buffer when flushing. When
+    // decimating, the buffer is zero padded to a whole number of output
+    // samples. In framed mode the rest of the frame is not padded but
+    // processed as a short block.
+  int cnt = input_buf_cnt;
+  if (input_rate > output_rate)
+  {
+    int ratio = input_rate / output_rate;
+    cnt = (cnt + ratio - 1) / ratio * ratio;
+    memset(input_buf + input_buf_cnt, 0,
+           (cnt - input_buf_cnt) * sizeof(*input_buf));
+  }
+  processToBuf(input_buf, cnt);
+  input_buf_cnt = 0;
+} /* AudioProcessor::processInputBuf */
+
+
+void AudioProcessor::processToBuf(const float *src, int count)
+{
+  float *dest = buf + buf_cnt;
+  processSamples(dest, src, count);
+  int out_cnt = count * output_rate / input_rate;
+  if (!fused_hops.empty() && fusedChainValid())
+  {
+    for (std::vector<FusedHop>::iterator it = fused_hops.begin();
+         it != fused_hops.end(); ++it)
+    {
+      if (it->proc != 0)
+      {
+        it->proc->processSamples(dest, dest, out_cnt);
+      }
+    }
+  }
+  buf_cnt += out_cnt;
+} /* AudioProcessor::processToBuf */
+
+
+int AudioProcessor::writeToSink(const float *samples, int count)
+{
+  if (fused_hops.empty() || !fusedChainValid())
+  {
+    return sinkWriteSamples(samples, count);
+  }
+
+    // Do what sinkWriteSamples would have done in each bypassed stage
+  is_flushing = false;
+  for (std::vector<FusedHop>::iterator it = fused_hops.begin();
+       it != fused_hops.end(); ++it)
+  {
+    it->source->is_flushing = false;
+  }
+  return fused_hops.back().source->sinkWriteSamples(samples, count);
+} /* AudioProcessor::writeToSink */
+
+
+bool AudioProcessor::fusedChainValid(void)
+{
+  AudioSource *prev = this;
+  for (std::vector<FusedHop>::iterator it = fused_hops.begin();
+       it != fused_hops.end(); ++it)
+  {
+    if (prev->m_sink != it->sink)
+    {
+      unfuseChain();
+      return false;
+    }
+    prev = it->source;
+  }
+  return true;
+} /* AudioProcessor::fusedChainValid */
+
+
 /*
  * This file has not been truncated
  */
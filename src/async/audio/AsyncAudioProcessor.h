@@ -37,6 +37,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <sigc++/sigc++.h>
 #include <string>
+#include <vector>
 
 
 /****************************************************************************
@@ -141,6 +142,15 @@ class AudioProcessor : public AudioSink, public AudioSource, public sigc::tracka
      */
     void flushSamples(void);
 
+    /**
+     * @brief   Get the number of samples buffered
+     * @return  Returns the number of samples currently buffered
+     */
+    unsigned samplesBuffered(void) const
+    {
+      return buf_cnt + input_buf_cnt;
+    }
+
     /**
      * @brief Resume output to the sink if previously stopped
      */
@@ -150,7 +160,59 @@ class AudioProcessor : public AudioSink, public AudioSource, public sigc::tracka
      * @brief All samples have been flushed by the sink
      */
     void allSamplesFlushed(void);
-    
+
+    /**
+     * @brief Set the frame size to use when calling processSamples
+     * @param frame_size The number of input samples in a frame, 0 to disable
+     *
+     * When a frame size is set, the processSamples function is only called
+     * with a sample count that is a multiple of the frame size. Samples that
+     * do not fill up a whole frame are kept until more samples are written,
+     * which adds up to frame_size-1 samples of delay. When flushing, the
+     * remaining samples are processed as a shorter block.
+     * Processors with vectorized inner loops run more efficiently in framed
+     * mode since there are no short blocks to handle in the middle of a
+     * stream. When resampling, the frame size must be a multiple of the
+     * decimation factor. This function should be called before any samples
+     * are written.
+     */
+    void setFrameSize(int frame_size);
+
+    /**
+     * @brief Get the frame size
+     * @return Returns the frame size or 0 if framed mode is not used
+     */
+    int frameSize(void) const { return frame_size; }
+
+    /**
+     * @brief Fuse the following sample-wise stages into this processor
+     * @return Returns the number of stages that was fused
+     *
+     * This function should be called after the audio pipe has been set up.
+     * It will follow the chain of sinks from this processor and find the
+     * longest run of plain AudioPassthrough objects and processors that
+     * process sample by sample (see isSampleWise). The fused processors are
+     * then run in place on the output buffer of this processor and the
+     * result is written directly to the sink of the last stage, removing
+     * the buffer handling and the virtual call for each hop.
+     * The fused objects stay in the audio pipe and keep their API so for
+     * example the gain of a fused AudioAmp can still be changed. Flushing
+     * and resumeOutput still go through all stages. If the pipe is
+     * rewired, the fusion is automatically undone.
+     */
+    int fuseChain(void);
+
+    /**
+     * @brief Undo a previous fuseChain
+     */
+    void unfuseChain(void);
+
+    /**
+     * @brief Get the number of stages fused into this processor
+     * @return Returns the number of fused stages
+     */
+    int fusedStageCount(void) const { return fused_hops.size(); }
+
 
   protected:
     /**
@@ -172,9 +234,29 @@ class AudioProcessor : public AudioSink, public AudioSource, public sigc::tracka
      * contain garbage.
      */
     virtual void processSamples(float *dest, const float *src, int count) = 0;
-    
-    
+
+    /**
+     * @brief Check if this processor can be fused into a preceding one
+     * @return Returns \em true if the processor is sample-wise
+     *
+     * A processor that return \em true here declare that all its processing
+     * is done in processSamples, that it can process samples in place
+     * (dest == src) and that it does not depend on how the samples are
+     * divided into blocks. The input and output sample rates must also be
+     * the same and framed mode must not be used, which is checked by
+     * fuseChain. The default is to return \em false.
+     */
+    virtual bool isSampleWise(void) const { return false; }
+
+
   private:
+    struct FusedHop
+    {
+      AudioSink       *sink;
+      AudioSource     *source;
+      AudioProcessor  *proc;
+    };
+
     static const int BUFSIZE = 256;
     
     float     	buf[BUFSIZE];
@@ -187,10 +269,18 @@ class AudioProcessor : public AudioSink, public AudioSource, public sigc::tracka
     float     	*input_buf;
     int       	input_buf_cnt;
     int       	input_buf_size;
+    int         frame_size;
+    std::vector<FusedHop> fused_hops;
+    bool        is_fused_stage;
     
     AudioProcessor(const AudioProcessor&);
     AudioProcessor& operator=(const AudioProcessor&);
     void writeFromBuf(void);
+    void setupInputBuf(void);
+    void processInputBuf(void);
+    void processToBuf(const float *src, int count);
+    int writeToSink(const float *samples, int count);
+    bool fusedChainValid(void);
 
 };  /* class AudioProcessor */
 
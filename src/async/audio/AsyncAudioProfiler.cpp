@@ -0,0 +1,299 @@
+/**
+@file	 AsyncAudioProfiler.cpp
+@brief   Collect performance statistics for nodes in an audio pipe
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <time.h>
+
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioProfiler.h"
+#include "AsyncAudioSink.h"
+#include "AsyncAudioTrace.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static bool nameLess(const AudioProfiler *a, const AudioProfiler *b);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+std::atomic<bool> AudioProfiler::is_enabled(false);
+std::mutex AudioProfiler::mutex;
+AudioProfiler::Nodes AudioProfiler::nodes;
+thread_local double *AudioProfiler::child_time = 0;
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+void AudioProfiler::setEnabled(bool enable)
+{
+  if (enable && !is_enabled.load())
+  {
+    resetAll();
+  }
+  is_enabled.store(enable);
+} /* AudioProfiler::setEnabled */
+
+
+void AudioProfiler::resetAll(void)
+{
+  std::lock_guard<std::mutex> lk(mutex);
+  for (Nodes::iterator it = nodes.begin(); it != nodes.end(); ++it)
+  {
+    (*it)->resetCounters();
+  }
+} /* AudioProfiler::resetAll */
+
+
+void AudioProfiler::dumpAll(std::ostream& os, const std::string& prefix)
+{
+  std::lock_guard<std::mutex> lk(mutex);
+  vector<AudioProfiler*> sorted(nodes.begin(), nodes.end());
+  sort(sorted.begin(), sorted.end(), nameLess);
+  for (vector<AudioProfiler*>::const_iterator it = sorted.begin();
+       it != sorted.end(); ++it)
+  {
+    (*it)->dumpCounters(os, prefix);
+  }
+} /* AudioProfiler::dumpAll */
+
+
+AudioProfiler::AudioProfiler(const std::string& name)
+  : m_name(name), m_trace_id(AudioTrace::nodeId(name))
+{
+  resetCounters();
+  std::lock_guard<std::mutex> lk(mutex);
+  nodes.insert(this);
+} /* AudioProfiler::AudioProfiler */
+
+
+AudioProfiler::~AudioProfiler(void)
+{
+  std::lock_guard<std::mutex> lk(mutex);
+  nodes.erase(this);
+} /* AudioProfiler::~AudioProfiler */
+
+
+void AudioProfiler::reset(void)
+{
+  std::lock_guard<std::mutex> lk(mutex);
+  resetCounters();
+} /* AudioProfiler::reset */
+
+
+int AudioProfiler::writeSamples(AudioSink *sink, const float *samples,
+                                int count)
+{
+    // The time spent in named sinks further down the pipe is accumulated
+    // into the local variable of the closest named sink up the pipe so
+    // that the exclusive time can be calculated for each node.
+  double children = 0.0;
+  double *parent_child_time = child_time;
+  child_time = &children;
+  const double start = now();
+  int ret = sink->writeSamples(samples, count);
+  const double elapsed = now() - start;
+  child_time = parent_child_time;
+  if (child_time != 0)
+  {
+    *child_time += elapsed;
+  }
+
+  const unsigned buffered = sink->samplesBuffered();
+
+  std::lock_guard<std::mutex> lk(mutex);
+  m_calls += 1;
+  m_samples += ret;
+  if (ret == 0)
+  {
+    m_zero_writes += 1;
+  }
+  else if (ret < count)
+  {
+    m_partial_writes += 1;
+  }
+  m_total_time += elapsed;
+  m_self_time += elapsed - children;
+  m_max_call_time = max(m_max_call_time, elapsed);
+  m_buffered_max = max(m_buffered_max, buffered);
+
+  return ret;
+} /* AudioProfiler::writeSamples */
+
+
+void AudioProfiler::dump(std::ostream& os, const std::string& prefix) const
+{
+  std::lock_guard<std::mutex> lk(mutex);
+  dumpCounters(os, prefix);
+} /* AudioProfiler::dump */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+double AudioProfiler::now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+} /* AudioProfiler::now */
+
+
+void AudioProfiler::resetCounters(void)
+{
+  m_reset_time = now();
+  m_calls = 0;
+  m_samples = 0;
+  m_partial_writes = 0;
+  m_zero_writes = 0;
+  m_total_time = 0.0;
+  m_self_time = 0.0;
+  m_max_call_time = 0.0;
+  m_buffered_max = 0;
+} /* AudioProfiler::resetCounters */
+
+
+void AudioProfiler::dumpCounters(std::ostream& os,
+                                 const std::string& prefix) const
+{
+  const double period = now() - m_reset_time;
+  const double us_per_call = (m_calls > 0) ? 1e6 / m_calls : 0.0;
+  const std::streamsize prec = os.precision();
+  os << prefix << m_name << ":"
+     << fixed << setprecision(0)
+     << " samples/s=" << ((period > 0.0) ? m_samples / period : 0.0)
+     << " calls=" << m_calls
+     << setprecision(2)
+     << " us/call=" << m_total_time * us_per_call
+     << " self_us/call=" << m_self_time * us_per_call
+     << " max_us=" << m_max_call_time * 1e6
+     << setprecision(3)
+     << " cpu%=" << ((period > 0.0) ? 100.0 * m_self_time / period : 0.0)
+     << " partial_writes=" << m_partial_writes
+     << " zero_writes=" << m_zero_writes
+     << " buffered_max=" << m_buffered_max
+     << endl;
+  os.unsetf(ios::floatfield);
+  os.precision(prec);
+} /* AudioProfiler::dumpCounters */
+
+
+static bool nameLess(const AudioProfiler *a, const AudioProfiler *b)
+{
+  return a->name() < b->name();
+} /* nameLess */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,244 @@
+/**
+@file	 AsyncAudioProfiler.h
+@brief   Collect performance statistics for nodes in an audio pipe
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_PROFILER_INCLUDED
+#define ASYNC_AUDIO_PROFILER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+#include <ostream>
+#include <set>
+#include <mutex>
+#include <atomic>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class AudioSink;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Performance statistics for one node in an audio pipe
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+An object of this class is created for an audio sink when it is given a
+name using AudioSink::setProfileName. When profiling is enabled, using the
+static setEnabled function, every write to the sink is timed and counted.
+The time is measured both inclusive and exclusive of the time spent in named
+sinks further down the audio pipe. When profiling is disabled, the only
+overhead is a check of a static flag.
+
+The statistics for all named sinks can be printed using the static dump
+function.
+
+Named sinks may be written from more than one thread, e.g. when logic cores
+run in threads of their own. The list of nodes and the counters are
+protected by a lock so statistics may be reset and printed from any thread.
+The bookkeeping of the exclusive time is kept per thread.
+*/
+class AudioProfiler
+{
+  public:
+    /**
+     * @brief   Enable or disable profiling of all named audio sinks
+     * @param   enable Set to \em true to enable profiling
+     *
+     * Enabling profiling will also reset the statistics.
+     */
+    static void setEnabled(bool enable);
+
+    /**
+     * @brief   Check if profiling is enabled
+     * @return  Returns \em true if profiling is enabled
+     */
+    static bool isEnabled(void) { return is_enabled.load(); }
+
+    /**
+     * @brief   Reset the statistics for all named audio sinks
+     */
+    static void resetAll(void);
+
+    /**
+     * @brief   Print the statistics for all named audio sinks
+     * @param   os      The stream to print to
+     * @param   prefix  A string to print at the start of each line
+     *
+     * One line is printed for each node, sorted by name.
+     */
+    static void dumpAll(std::ostream& os, const std::string& prefix="");
+
+    /**
+     * @brief   Constructor
+     * @param   name The name of the node
+     */
+    explicit AudioProfiler(const std::string& name);
+
+    /**
+     * @brief   Destructor
+     */
+    ~AudioProfiler(void);
+
+    /**
+     * @brief   Get the name of the node
+     * @return  Returns the name of the node
+     */
+    const std::string& name(void) const { return m_name; }
+
+    /**
+     * @brief   Get the id of the node in the audio latency tracer
+     * @return  Returns the AudioTrace node id
+     */
+    unsigned traceId(void) const { return m_trace_id; }
+
+    /**
+     * @brief   Reset the statistics for this node
+     */
+    void reset(void);
+
+    /**
+     * @brief   Write samples to a sink and record statistics
+     * @param   sink    The sink to write to
+     * @param   samples The buffer containing the samples
+     * @param   count   The number of samples in the buffer
+     * @return  Returns the return value from the writeSamples call
+     *
+     * This function is called by AudioSource::sinkWriteSamples when
+     * profiling is enabled.
+     */
+    int writeSamples(AudioSink *sink, const float *samples, int count);
+
+    /**
+     * @brief   Print the statistics for this node
+     * @param   os      The stream to print to
+     * @param   prefix  A string to print at the start of the line
+     */
+    void dump(std::ostream& os, const std::string& prefix="") const;
+
+  private:
+    typedef std::set<AudioProfiler*> Nodes;
+
+    static std::atomic<bool>      is_enabled;
+    static std::mutex             mutex;
+    static Nodes                  nodes;
+    static thread_local double    *child_time;
+
+    std::string     m_name;
+    unsigned        m_trace_id;
+    double          m_reset_time;
+    unsigned long   m_calls;
+    unsigned long   m_samples;
+    unsigned long   m_partial_writes;
+    unsigned long   m_zero_writes;
+    double          m_total_time;
+    double          m_self_time;
+    double          m_max_call_time;
+    unsigned        m_buffered_max;
+
+    AudioProfiler(const AudioProfiler&);
+    AudioProfiler& operator=(const AudioProfiler&);
+    static double now(void);
+    void resetCounters(void);
+    void dumpCounters(std::ostream& os, const std::string& prefix) const;
+
+};  /* class AudioProfiler */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_PROFILER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -32,12 +32,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <pthread.h>
+
 #include <cassert>
 #include <cstdio>
 #include <cstring>
 #include <cerrno>
 #include <algorithm>
 #include <sstream>
+#include <vector>
 #include <sys/time.h>
 
 
@@ -47,6 +50,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncTimer.h>
 
 
 /****************************************************************************
@@ -56,6 +60,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "AsyncAudioRecorder.h"
+#include "AsyncAudioFileWriter.h"
+#include "AsyncAudioContainer.h"
 
 
 
@@ -78,6 +84,12 @@ using namespace Async;
 
 #define WAVE_HEADER_SIZE  44
 
+  // How often to check if files closed in the background are complete
+#define CLOSE_POLL_INTERVAL   100
+
+  // How many seconds of audio the worker may fall behind
+#define MAX_PENDING_SECONDS   10
+
 
 /****************************************************************************
  *
@@ -85,6 +97,95 @@ using namespace Async;
  *
  ****************************************************************************/
 
+/**
+ * The worker convert or encode the audio and hand it over to the file writer.
+ * It runs in its own thread so that e.g. the Opus encoder do not load the
+ * main loop. The main thread only hand over blocks of samples. Everything
+ * else, including the file writer and the container, is only used by the
+ * worker thread once it has been started.
+ */
+class AudioRecorder::Worker
+{
+  public:
+    Worker(AudioRecorder::Format format, int sample_rate)
+      : format(format), sample_rate(sample_rate), writer(0), container(0),
+        thread_started(false), do_finish(false), is_done(false),
+        has_failed(false), success(true), samples_encoded(0)
+    {
+      pthread_mutex_init(&mutex, NULL);
+      pthread_cond_init(&cond, NULL);
+    }
+
+    ~Worker(void)
+    {
+      finish(true);
+      delete container;
+      delete writer;
+      pthread_cond_destroy(&cond);
+      pthread_mutex_destroy(&mutex);
+    }
+
+    bool start(const std::string& filename, std::string& errmsg);
+    void write(const float *samples, int count);
+    bool finish(bool wait);
+
+    bool hasFailed(void)
+    {
+      pthread_mutex_lock(&mutex);
+      const bool failed = has_failed;
+      pthread_mutex_unlock(&mutex);
+      return failed;
+    }
+
+    bool isDone(void)
+    {
+      pthread_mutex_lock(&mutex);
+      const bool done = is_done;
+      pthread_mutex_unlock(&mutex);
+      return done;
+    }
+
+    std::string errorMsg(void)
+    {
+      pthread_mutex_lock(&mutex);
+      const std::string msg(errmsg);
+      pthread_mutex_unlock(&mutex);
+      return msg;
+    }
+
+  private:
+    AudioRecorder::Format format;
+    int                   sample_rate;
+    AudioFileWriter       *writer;
+    AudioContainer        *container;
+    pthread_t             thread;
+    bool                  thread_started;
+
+      // Shared between the threads, protected by the mutex
+    pthread_mutex_t       mutex;
+    pthread_cond_t        cond;
+    std::vector<float>    pending;
+    bool                  do_finish;
+    bool                  is_done;
+    bool                  has_failed;
+    bool                  success;
+    std::string           errmsg;
+
+      // Only used by the worker thread
+    unsigned              samples_encoded;
+
+    Worker(const Worker&);
+    Worker& operator=(const Worker&);
+    void setError(const std::string& msg);
+    void encode(const std::vector<float>& samples);
+    bool finalize(void);
+    bool writeWaveHeader(void);
+    void onWriteBlock(const char *buf, size_t len);
+    static void *threadFunc(void *arg);
+    void workerThread(void);
+
+}; /* class AudioRecorder::Worker */
+
 
 
 /****************************************************************************
@@ -93,6 +194,9 @@ using namespace Async;
  *
  ****************************************************************************/
 
+static int store32bitValue(char *ptr, uint32_t val);
+static int store16bitValue(char *ptr, uint16_t val);
+
 
 
 /****************************************************************************
@@ -121,7 +225,8 @@ using namespace Async;
 AudioRecorder::AudioRecorder(const string& filename,
       	      	      	     AudioRecorder::Format fmt,
 			     int sample_rate)
-  : filename(filename), file(NULL), samples_written(0), format(fmt),
+  : filename(filename), worker(0), close_poll_timer(0), samples_written(0),
+    format(fmt),
     sample_rate(sample_rate), max_samples(0), high_water_mark(0),
     high_water_mark_reached(false)
 {
@@ -140,6 +245,10 @@ AudioRecorder::AudioRecorder(const string& filename,
       {
         format = FMT_WAV;
       }
+      else if (ext == "opus")
+      {
+        format = FMT_OPUS;
+      }
     }
   }
 } /* AudioRecorder::AudioRecorder */
@@ -148,38 +257,42 @@ AudioRecorder::AudioRecorder(const string& filename,
 AudioRecorder::~AudioRecorder(void)
 {
   closeFile();
+
+    // Wait for the files that are being closed in the background so that
+    // they are complete when the application exit
+  for (list<Worker*>::iterator it=closing_workers.begin();
+       it!=closing_workers.end(); ++it)
+  {
+    delete *it;
+  }
+  delete close_poll_timer;
 } /* AudioRecorder::~AudioRecorder */
 
 
 bool AudioRecorder::initialize(void)
 {
-  assert(file == NULL);
-  
-  file = fopen(filename.c_str(), "w");
-  if (file == NULL)
+  assert(worker == 0);
+
+  errmsg = "";
+  if ((format == FMT_OPUS) && (sample_rate != INTERNAL_SAMPLE_RATE))
   {
-    setErrMsgFromErrno("fopen");
+    errmsg = "The Opus format require the internal sample rate";
     return false;
   }
-  
-  if (format == FMT_WAV)
+
+  worker = new Worker(format, sample_rate);
+  if (!worker->start(filename, errmsg))
   {
-      // Leave room for the wave file header
-    if (fseek(file, WAVE_HEADER_SIZE, SEEK_SET) != 0)
-    {
-      setErrMsgFromErrno("fseek");
-      fclose(file);
-      file = NULL;
-      return false;
-    }
+    delete worker;
+    worker = 0;
+    return false;
   }
-  
+
   samples_written = 0;
   high_water_mark_reached = false;
   timerclear(&begin_timestamp);
   timerclear(&end_timestamp);
-  errmsg = "";
-  
+
   return true;
   
 } /* AudioRecorder::initialize */
@@ -195,28 +308,46 @@ void AudioRecorder::setMaxRecordingTime(unsigned time_ms, unsigned hw_time_ms)
 bool AudioRecorder::closeFile(void)
 {
   bool success = true;
-  if (file != NULL)
+  if (worker != 0)
   {
-    if (format == FMT_WAV)
-    {
-      success = writeWaveHeader();
-    }
-    if (fclose(file) != 0)
+    success = worker->finish(true);
+    if (!success)
     {
-      setErrMsgFromErrno("fclose");
-      success = false;
+      errmsg = worker->errorMsg();
     }
-    file = NULL;
+    delete worker;
+    worker = 0;
   }
   return success;
 } /* AudioRecorder::closeFile */
 
 
+void AudioRecorder::closeFileInBackground(void)
+{
+  if (worker == 0)
+  {
+    return;
+  }
+
+  worker->finish(false);
+  closing_workers.push_back(worker);
+  worker = 0;
+
+  if (close_poll_timer == 0)
+  {
+    close_poll_timer = new Timer(CLOSE_POLL_INTERVAL, Timer::TYPE_PERIODIC);
+    close_poll_timer->expired.connect(
+        mem_fun(*this, &AudioRecorder::checkClosingWorkers));
+  }
+  close_poll_timer->setEnable(true);
+} /* AudioRecorder::closeFileInBackground */
+
+
 int AudioRecorder::writeSamples(const float *samples, int count)
 {
   assert(count > 0);
 
-  if (file == NULL)
+  if (worker == 0)
   {
     return count;
   }
@@ -238,28 +369,12 @@ int AudioRecorder::writeSamples(const float *samples, int count)
     timersub(&end_timestamp, &block_time, &begin_timestamp);
   }
   
-  short buf[count];
-  for (int i=0; i<count; ++i)
-  {
-    float sample = samples[i];
-    if (sample > 1)
-    {
-      buf[i] = 32767;
-    }
-    else if (sample < -1)
-    {
-      buf[i] = -32767;
-    }
-    else
-    {
-      buf[i] = static_cast<short>(32767.0 * sample);
-    }
-  }
-  
-  int written = fwrite(buf, sizeof(*buf), count, file);
-  if ((written != count) && ferror(file))
+  int written = count;
+  worker->write(samples, count);
+
+  if (worker->hasFailed())
   {
-    setErrMsgFromErrno("fwrite");
+    errmsg = worker->errorMsg();
     errorOccurred();
     closeFile();
     return count;
@@ -275,7 +390,7 @@ int AudioRecorder::writeSamples(const float *samples, int count)
 
   if ((max_samples > 0) && (samples_written >= max_samples))
   {
-    closeFile();
+    closeFileInBackground();
     maxRecordingTimeReached();
   }
 
@@ -288,7 +403,7 @@ void AudioRecorder::flushSamples(void)
 {
   if (high_water_mark_reached)
   {
-    closeFile();
+    closeFileInBackground();
     sourceAllSamplesFlushed();
     maxRecordingTimeReached();
   }
@@ -317,10 +432,218 @@ void AudioRecorder::flushSamples(void)
  *
  ****************************************************************************/
 
-bool AudioRecorder::writeWaveHeader(void)
+void AudioRecorder::checkClosingWorkers(Timer *t)
+{
+    // The files are reported in the order they were closed. Only one file is
+    // reported each time since the recorder may be deleted by the slot.
+  assert(!closing_workers.empty());
+  Worker *closed = closing_workers.front();
+  if (!closed->isDone())
+  {
+    return;
+  }
+  closing_workers.pop_front();
+  const bool success = closed->finish(true);
+  const string msg(success ? "" : closed->errorMsg());
+  delete closed;
+  if (closing_workers.empty())
+  {
+    close_poll_timer->setEnable(false);
+  }
+  fileClosed(success, msg);
+} /* AudioRecorder::checkClosingWorkers */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions for class AudioRecorder::Worker
+ *
+ ****************************************************************************/
+
+bool AudioRecorder::Worker::start(const std::string& filename,
+                                  std::string& errmsg)
+{
+  assert(!thread_started);
+
+  if (format == FMT_OPUS)
+  {
+    container = createAudioContainer("opus");
+    if (container == 0)
+    {
+      errmsg = "Support for the Opus format is not available";
+      return false;
+    }
+    container->writeBlock.connect(
+        sigc::mem_fun(*this, &Worker::onWriteBlock));
+  }
+
+  writer = new AudioFileWriter;
+  if (!writer->open(filename))
+  {
+    errmsg = writer->errorMsg();
+    return false;
+  }
+
+    // Leave room for the file header
+  if (format == FMT_WAV)
+  {
+    writer->setPosition(WAVE_HEADER_SIZE);
+  }
+  else if (container != 0)
+  {
+    writer->setPosition(container->headerSize());
+  }
+
+    // The pending buffer is swapped with the worker so reserve room in
+    // both of them up front
+  pending.reserve(sample_rate);
+
+  int ret = pthread_create(&thread, NULL, threadFunc, this);
+  if (ret != 0)
+  {
+    errmsg = string("pthread_create: ") + strerror(ret);
+    writer->close();
+    return false;
+  }
+  thread_started = true;
+
+  return true;
+} /* AudioRecorder::Worker::start */
+
+
+void AudioRecorder::Worker::write(const float *samples, int count)
+{
+  pthread_mutex_lock(&mutex);
+  if (!has_failed && !do_finish)
+  {
+    if (pending.size() + count >
+        static_cast<size_t>(MAX_PENDING_SECONDS * sample_rate))
+    {
+      has_failed = true;
+      success = false;
+      errmsg = "The audio could not be encoded fast enough";
+    }
+    else
+    {
+      const bool was_empty = pending.empty();
+      pending.insert(pending.end(), samples, samples + count);
+      if (was_empty)
+      {
+        pthread_cond_signal(&cond);
+      }
+    }
+  }
+  pthread_mutex_unlock(&mutex);
+} /* AudioRecorder::Worker::write */
+
+
+bool AudioRecorder::Worker::finish(bool wait)
+{
+  if (!thread_started)
+  {
+    return success;
+  }
+
+  pthread_mutex_lock(&mutex);
+  do_finish = true;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&mutex);
+
+  if (!wait)
+  {
+    return true;
+  }
+
+  pthread_join(thread, NULL);
+  thread_started = false;
+  return success;
+} /* AudioRecorder::Worker::finish */
+
+
+void AudioRecorder::Worker::setError(const std::string& msg)
+{
+  pthread_mutex_lock(&mutex);
+  if (!has_failed)
+  {
+    has_failed = true;
+    errmsg = msg;
+  }
+  success = false;
+  pthread_mutex_unlock(&mutex);
+} /* AudioRecorder::Worker::setError */
+
+
+void AudioRecorder::Worker::encode(const std::vector<float>& samples)
+{
+  if (samples.empty())
+  {
+    return;
+  }
+
+  if (container != 0)
+  {
+    container->writeSamples(&samples[0], samples.size());
+  }
+  else
+  {
+    vector<short> buf(samples.size());
+    for (size_t i=0; i<samples.size(); ++i)
+    {
+      float sample = samples[i];
+      if (sample > 1)
+      {
+        buf[i] = 32767;
+      }
+      else if (sample < -1)
+      {
+        buf[i] = -32767;
+      }
+      else
+      {
+        buf[i] = static_cast<short>(32767.0 * sample);
+      }
+    }
+    writer->write(&buf[0], buf.size() * sizeof(short));
+  }
+  samples_encoded += samples.size();
+
+  if (!writer->errorMsg().empty())
+  {
+    setError(writer->errorMsg());
+  }
+} /* AudioRecorder::Worker::encode */
+
+
+bool AudioRecorder::Worker::finalize(void)
+{
+  bool ok = true;
+  if (format == FMT_WAV)
+  {
+    ok = writeWaveHeader();
+  }
+  else if (container != 0)
+  {
+    container->endStream();
+    if (container->headerSize() > 0)
+    {
+      ok = writer->writeAt(0, container->header(), container->headerSize());
+    }
+  }
+  if (!writer->close())
+  {
+    ok = false;
+  }
+  if (!ok)
+  {
+    setError(writer->errorMsg());
+  }
+  return ok;
+} /* AudioRecorder::Worker::finalize */
+
+
+bool AudioRecorder::Worker::writeWaveHeader(void)
 {
-  rewind(file);
- 
   char buf[WAVE_HEADER_SIZE];
   char *ptr = buf;
   
@@ -329,7 +652,7 @@ bool AudioRecorder::writeWaveHeader(void)
   ptr += 4;
   
     // ChunkSize
-  ptr += store32bitValue(ptr, 36 + samples_written * sizeof(short));
+  ptr += store32bitValue(ptr, 36 + samples_encoded * sizeof(short));
   
     // Format
   memcpy(ptr, "WAVE", 4);
@@ -365,20 +688,72 @@ bool AudioRecorder::writeWaveHeader(void)
   ptr += 4;
   
     // Subchunk2Size (num samples * num channels * bytes per sample)
-  ptr += store32bitValue(ptr, samples_written * 1 * sizeof(short));
+  ptr += store32bitValue(ptr, samples_encoded * 1 * sizeof(short));
   
   assert(ptr - buf == WAVE_HEADER_SIZE);
 
-  if (fwrite(buf, 1, WAVE_HEADER_SIZE, file) != WAVE_HEADER_SIZE)
+  return writer->writeAt(0, buf, WAVE_HEADER_SIZE);
+} /* AudioRecorder::Worker::writeWaveHeader */
+
+
+void AudioRecorder::Worker::onWriteBlock(const char *buf, size_t len)
+{
+  writer->write(buf, len);
+} /* AudioRecorder::Worker::onWriteBlock */
+
+
+void *AudioRecorder::Worker::threadFunc(void *arg)
+{
+  reinterpret_cast<Worker *>(arg)->workerThread();
+  return NULL;
+} /* AudioRecorder::Worker::threadFunc */
+
+
+void AudioRecorder::Worker::workerThread(void)
+{
+  vector<float> samples;
+  samples.reserve(sample_rate);
+  pthread_mutex_lock(&mutex);
+  for (;;)
   {
-    setErrMsgFromErrno("fwrite");
-    return false;
+    while (pending.empty() && !do_finish)
+    {
+      pthread_cond_wait(&cond, &mutex);
+    }
+    samples.swap(pending);
+    pending.clear();
+    const bool last = do_finish;
+    const bool failed = has_failed;
+    pthread_mutex_unlock(&mutex);
+
+      // Audio coming in after an error is thrown away
+    if (!failed)
+    {
+      encode(samples);
+    }
+    samples.clear();
+
+    if (last)
+    {
+      finalize();
+      pthread_mutex_lock(&mutex);
+      is_done = true;
+      break;
+    }
+    pthread_mutex_lock(&mutex);
   }
-  return true;
-} /* AudioRecorder::writeWaveHeader */
+  pthread_mutex_unlock(&mutex);
+} /* AudioRecorder::Worker::workerThread */
+
 
 
-int AudioRecorder::store32bitValue(char *ptr, uint32_t val)
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static int store32bitValue(char *ptr, uint32_t val)
 {
   *ptr++ = val & 0xff;
   val >>= 8;
@@ -388,28 +763,19 @@ int AudioRecorder::store32bitValue(char *ptr, uint32_t val)
   val >>= 8;
   *ptr++ = val & 0xff;
   return 4;
-} /* AudioRecorder::store32bitValue */
+} /* store32bitValue */
 
 
-int AudioRecorder::store16bitValue(char *ptr, uint16_t val)
+static int store16bitValue(char *ptr, uint16_t val)
 {
   *ptr++ = val & 0xff;
   val >>= 8;
   *ptr++ = val & 0xff;
   return 2;
-} /* AudioRecorder::store32bitValue */
-
-
-void AudioRecorder::setErrMsgFromErrno(const std::string &fname)
-{
-  ostringstream ss;
-  ss << fname << ": " << strerror(errno);
-  errmsg = ss.str();
-} /* AudioRecorder::setErrMsgFromErrno */
+} /* store16bitValue */
 
 
 
 /*
  * This file has not been truncated
  */
-
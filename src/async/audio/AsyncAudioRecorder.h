@@ -40,6 +40,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sys/time.h>
 
 #include <string>
+#include <list>
 
 #include <AsyncAudioSink.h>
 
@@ -84,7 +85,9 @@ namespace Async
  *
  ****************************************************************************/
 
-  
+class Timer;
+
+
 
 /****************************************************************************
  *
@@ -114,12 +117,20 @@ namespace Async
 @date   2005-08-29
 
 Use this class to stream audio into a file. The audio is stored in raw format,
-(only samples no header) or WAV format.
+(only samples no header), WAV format or, if SvxLink was built with Ogg and Opus
+support, as an Ogg/Opus file that is encoded on the fly. The audio is converted
+or encoded by a worker thread and the file is written in large blocks by a
+background thread, so that the main loop never wait for the encoder or the
+disk and so that storage devices like SD cards see few large writes.
+
+A file can be closed without waiting for the worker to finish the file using
+closeFileInBackground. The fileClosed signal is emitted when the file is
+complete.
 */
 class AudioRecorder : public Async::AudioSink
 {
   public:
-    typedef enum { FMT_AUTO, FMT_RAW, FMT_WAV } Format;
+    typedef enum { FMT_AUTO, FMT_RAW, FMT_WAV, FMT_OPUS } Format;
     
     /**
      * @brief 	Default constuctor
@@ -174,6 +185,24 @@ class AudioRecorder : public Async::AudioSink
      */
     bool closeFile(void);
 
+    /**
+     * @brief   Close the file without waiting for it to be finalized
+     *
+     * This function work like closeFile but it return directly. The audio
+     * that have not yet been encoded and written, and the file header, are
+     * taken care of in the background. The fileClosed signal is emitted when
+     * the file is complete. A new file may be opened using initialize directly
+     * after this call. Files that are closed when the maximum recording time
+     * is reached are also closed in the background.
+     */
+    void closeFileInBackground(void);
+
+    /**
+     * @brief   Check if any file is being closed in the background
+     * @return  Returns \em true if the fileClosed signal is pending
+     */
+    bool isClosing(void) const { return !closing_workers.empty(); }
+
     /**
      * @brief   Find out how many samples that have been written so far
      * @return  Returns the number of samples written so far
@@ -245,10 +274,27 @@ class AudioRecorder : public Async::AudioSink
      */
     sigc::signal<void> errorOccurred;
 
+    /**
+     * @brief   A signal that is emitted when a file closed in the background
+     *          is complete
+     * @param   success \em true if the file was successfully written
+     * @param   errmsg  The error message if writing failed
+     *
+     * The signal is emitted once for each file closed using
+     * closeFileInBackground or closed because the maximum recording time was
+     * reached, in the order the files were closed. It is safe to delete the
+     * audio recorder from the slot that is connected to this signal.
+     */
+    sigc::signal<void, bool, const std::string&> fileClosed;
+
   private:
-    std::string     filename;
-    FILE      	    *file;
-    unsigned        samples_written;
+    class Worker;
+
+    std::string         filename;
+    Worker              *worker;
+    std::list<Worker*>  closing_workers;
+    Timer               *close_poll_timer;
+    unsigned            samples_written;
     Format    	    format;
     int       	    sample_rate;
     unsigned        max_samples;
@@ -260,10 +306,7 @@ class AudioRecorder : public Async::AudioSink
     
     AudioRecorder(const AudioRecorder&);
     AudioRecorder& operator=(const AudioRecorder&);
-    bool writeWaveHeader(void);
-    int store32bitValue(char *ptr, uint32_t val);
-    int store16bitValue(char *ptr, uint16_t val);
-    void setErrMsgFromErrno(const std::string &fname);
+    void checkClosingWorkers(Timer *t);
 
 };  /* class AudioRecorder */
 
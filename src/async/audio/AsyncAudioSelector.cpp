@@ -82,24 +82,46 @@ using namespace Async;
 class Async::AudioSelector::Branch : public AudioSink
 {
   public:
-    Branch(AudioSelector *selector)
-      : m_selector(selector), m_auto_select(false), m_prio(0),
-        m_stream_state(STATE_IDLE), m_flush_wait(true)
+    Branch(AudioSelector *selector, AudioSource *source)
+      : m_selector(selector), m_source(source), m_auto_select(false),
+        m_prio(0), m_stream_state(STATE_IDLE), m_flush_wait(true),
+        m_is_active(false)
     {
       assert(selector != 0);
     }
 
+    AudioSource *source(void) const { return m_source; }
     StreamState streamState(void) const { return m_stream_state; }
-    void setSelectionPrio(int prio) { m_prio = prio; }
     int selectionPrio(void) const { return m_prio; }
-    void enableAutoSelect(void) { m_auto_select = true; }
     bool autoSelectEnabled(void) const { return m_auto_select; }
     void setFlushWait(bool flush_wait) { m_flush_wait = flush_wait; }
     bool flushWait(void) const { return m_flush_wait; }
+    bool isActive(void) const { return m_is_active; }
+
+    void setSelectionPrio(int prio)
+    {
+        // The priority is part of the sort key for active branches
+      if (m_is_active)
+      {
+        m_selector->setBranchActive(this, false);
+      }
+      m_prio = prio;
+      if (m_is_active)
+      {
+        m_selector->setBranchActive(this, true);
+      }
+    }
+
+    void enableAutoSelect(void)
+    {
+      m_auto_select = true;
+      updateActive();
+    }
 
     void disableAutoSelect(void)
     {
       m_auto_select = false;
+      updateActive();
       if (isSelected())
       {
         m_selector->selectHighestPrioActiveBranch(true);
@@ -114,7 +136,7 @@ class Async::AudioSelector::Branch : public AudioSink
     virtual int writeSamples(const float *samples, int count)
     {
       assert(count > 0);
-      m_stream_state = STATE_WRITING;
+      setStreamState(STATE_WRITING);
       if (m_auto_select && !isSelected())
       {
 	const Branch *selected_branch = m_selector->selectedBranch();
@@ -130,7 +152,7 @@ class Async::AudioSelector::Branch : public AudioSink
         ret = m_selector->branchWriteSamples(samples, count);
         if (ret == 0)
         {
-          m_stream_state = STATE_STOPPED;
+          setStreamState(STATE_STOPPED);
         }
       }
       return ret;
@@ -148,12 +170,12 @@ class Async::AudioSelector::Branch : public AudioSink
         case STATE_STOPPED:
           if (isSelected())
           {
-            m_stream_state = STATE_FLUSHING;
+            setStreamState(STATE_FLUSHING);
             m_selector->branchFlushSamples();
           }
           else
           {
-            m_stream_state = STATE_IDLE;
+            setStreamState(STATE_IDLE);
             sourceAllSamplesFlushed();
           }
           break;
@@ -167,7 +189,7 @@ class Async::AudioSelector::Branch : public AudioSink
     {
       if (m_stream_state == STATE_STOPPED)
       {
-        m_stream_state = STATE_WRITING;
+        setStreamState(STATE_WRITING);
         sourceResumeOutput();
       }
     }
@@ -176,7 +198,7 @@ class Async::AudioSelector::Branch : public AudioSink
     {
       if (m_stream_state == STATE_FLUSHING)
       {
-        m_stream_state = STATE_IDLE;
+        setStreamState(STATE_IDLE);
         if (m_auto_select)
         {
           m_selector->selectBranch(0);
@@ -194,12 +216,12 @@ class Async::AudioSelector::Branch : public AudioSink
           break;
 
         case STATE_STOPPED:
-          m_stream_state = STATE_WRITING;
+          setStreamState(STATE_WRITING);
           sourceResumeOutput();
           break;
 
         case STATE_FLUSHING:
-          m_stream_state = STATE_IDLE;
+          setStreamState(STATE_IDLE);
           sourceAllSamplesFlushed();
           break;
       }
@@ -207,14 +229,47 @@ class Async::AudioSelector::Branch : public AudioSink
 
   private:
     AudioSelector * m_selector;
+    AudioSource *   m_source;
     bool            m_auto_select;
     int             m_prio;
     StreamState     m_stream_state;
     bool            m_flush_wait;
+    bool            m_is_active;
+
+    void setStreamState(StreamState state)
+    {
+      m_stream_state = state;
+      updateActive();
+    }
+
+    void updateActive(void)
+    {
+      bool is_active = m_auto_select &&
+                       ((m_stream_state == STATE_WRITING) ||
+                        (m_stream_state == STATE_STOPPED));
+      if (is_active != m_is_active)
+      {
+        m_is_active = is_active;
+        m_selector->setBranchActive(this, is_active);
+      }
+    }
 
 }; /* class Async::AudioSelector::Branch */
 
 
+  // The highest priority first. Branches with the same priority are ordered
+  // on the source address to get a stable order.
+bool Async::AudioSelector::BranchPrioLess::operator()(const Branch *lhs,
+                                                      const Branch *rhs) const
+{
+  if (lhs->selectionPrio() != rhs->selectionPrio())
+  {
+    return lhs->selectionPrio() > rhs->selectionPrio();
+  }
+  return less<const AudioSource*>()(lhs->source(), rhs->source());
+} /* Async::AudioSelector::BranchPrioLess::operator() */
+
+
 /****************************************************************************
  *
  * Prototypes
@@ -267,7 +322,7 @@ void AudioSelector::addSource(Async::AudioSource *source)
 {
   assert(source != 0);
   assert(m_branch_map.find(source) == m_branch_map.end());
-  Branch *branch = new Branch(this);
+  Branch *branch = new Branch(this, source);
   source->registerSink(branch);
   m_branch_map[source] = branch;
 } /* AudioSelector::addSource */
@@ -280,6 +335,7 @@ void AudioSelector::removeSource(AudioSource *source)
   Branch *branch = (*it).second;
   m_branch_map.erase(it);
   assert(m_branch_map.find(source) == m_branch_map.end());
+  m_active_branches.erase(branch);
   if (branch == selectedBranch())
   {
     selectHighestPrioActiveBranch(true);
@@ -341,15 +397,7 @@ void AudioSelector::selectSource(AudioSource *source)
 
 AudioSource *AudioSelector::selectedSource(void) const
 {
-  for (BranchMap::const_iterator it = m_branch_map.begin();
-       it != m_branch_map.end(); ++it)
-  {
-    if (it->second == selectedBranch())
-    {
-      return it->first;
-    }
-  }
-  return 0;
+  return (m_selected_branch != 0) ? m_selected_branch->source() : 0;
 } /* AudioSelector::selectedSource */
 
 
@@ -481,20 +529,9 @@ void AudioSelector::selectBranch(Branch *branch)
 void AudioSelector::selectHighestPrioActiveBranch(bool clear_if_no_active)
 {
   Branch *new_branch = 0;
-  for (BranchMap::iterator it = m_branch_map.begin();
-       it != m_branch_map.end(); ++it)
+  if (!m_active_branches.empty())
   {
-    Branch *branch = (*it).second;
-    if (branch->autoSelectEnabled())
-    {
-      if (((branch->streamState() == STATE_WRITING) ||
-           (branch->streamState() == STATE_STOPPED)) &&
-          ((new_branch == 0) ||
-          (branch->selectionPrio() > new_branch->selectionPrio())))
-      {
-        new_branch = branch;
-      }
-    }
+    new_branch = *m_active_branches.begin();
   }
   if ((new_branch != 0) || clear_if_no_active)
   {
@@ -503,6 +540,19 @@ void AudioSelector::selectHighestPrioActiveBranch(bool clear_if_no_active)
 } /* AudioSelector::selectHighestPrioActiveBranch */
 
 
+void AudioSelector::setBranchActive(Branch *branch, bool active)
+{
+  if (active)
+  {
+    m_active_branches.insert(branch);
+  }
+  else
+  {
+    m_active_branches.erase(branch);
+  }
+} /* AudioSelector::setBranchActive */
+
+
 /*
  * This file has not been truncated
  */
@@ -36,6 +36,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <map>
+#include <set>
 
 
 /****************************************************************************
@@ -110,6 +111,12 @@ namespace Async
 
 This class is used to select one of many incoming audio streams. Incoming
 samples on non-selected branches will be thrown away.
+
+The auto select branches that are currently writing are kept sorted on
+priority so finding the branch to switch to when a stream starts or stops
+does not depend on the number of sources. Adding or removing a source does
+not affect the other branches, except that removing the selected source
+switch directly to the highest priority active source, if any.
 */
 class AudioSelector : public AudioSource
 {
@@ -211,8 +218,14 @@ class AudioSelector : public AudioSource
 
     class Branch;
     typedef std::map<Async::AudioSource *, Branch *> BranchMap;
+    struct BranchPrioLess
+    {
+      bool operator()(const Branch *lhs, const Branch *rhs) const;
+    };
+    typedef std::set<Branch *, BranchPrioLess> BranchSet;
     
     BranchMap 	m_branch_map;
+    BranchSet   m_active_branches;
     Branch *    m_selected_branch;
     StreamState m_stream_state;
     
@@ -221,6 +234,7 @@ class AudioSelector : public AudioSource
     void selectBranch(Branch *branch);
     Branch *selectedBranch(void) const { return m_selected_branch; }
     void selectHighestPrioActiveBranch(bool clear_if_no_active);
+    void setBranchActive(Branch *branch, bool active);
     int branchWriteSamples(const float *samples, int count);
     void branchFlushSamples(void);
     
@@ -0,0 +1,351 @@
+/**
+@file	 AsyncAudioSharedEncoder.cpp
+@brief   An audio encoder that can be shared by several consumers
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSource.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioSharedEncoder.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+/*
+One Stream object exist for each unique combination of stream id, codec and
+options. It owns the real encoder and act as the audio source for it. The
+first subscriber in the list is the primary.
+*/
+class AudioSharedEncoder::Stream : public AudioSource, public sigc::trackable
+{
+  public:
+    string                        key;
+    AudioEncoder                  *enc;
+    vector<AudioSharedEncoder*>   subscribers;
+
+    Stream(const string &key, AudioEncoder *enc) : key(key), enc(enc)
+    {
+      registerSink(enc, true);
+      enc->writeEncodedSamples.connect(
+          mem_fun(*this, &Stream::onWriteEncodedSamples));
+      enc->flushEncodedSamples.connect(
+          mem_fun(*this, &Stream::onFlushEncodedSamples));
+    }
+
+    AudioSharedEncoder *primary(void) const
+    {
+      return subscribers.empty() ? 0 : subscribers.front();
+    }
+
+    int write(const float *samples, int count)
+    {
+      return sinkWriteSamples(samples, count);
+    }
+
+    void flush(void) { sinkFlushSamples(); }
+
+    virtual void resumeOutput(void) {}
+
+    virtual void allSamplesFlushed(void)
+    {
+      if (primary() != 0)
+      {
+        primary()->encoderFlushed();
+      }
+    }
+
+  private:
+    void onWriteEncodedSamples(const void *buf, int size)
+    {
+        // Copy the list since a slot may delete its subscriber
+      vector<AudioSharedEncoder*> subs(subscribers);
+      for (vector<AudioSharedEncoder*>::iterator it = subs.begin();
+           it != subs.end(); ++it)
+      {
+        if (find(subscribers.begin(), subscribers.end(), *it) !=
+            subscribers.end())
+        {
+          (*it)->writeEncodedSamples(buf, size);
+        }
+      }
+    }
+
+    void onFlushEncodedSamples(void)
+    {
+      vector<AudioSharedEncoder*> subs(subscribers);
+      for (vector<AudioSharedEncoder*>::iterator it = subs.begin();
+           it != subs.end(); ++it)
+      {
+        if (find(subscribers.begin(), subscribers.end(), *it) !=
+            subscribers.end())
+        {
+          (*it)->flushEncodedSamples();
+        }
+      }
+    }
+};
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+AudioSharedEncoder::Streams AudioSharedEncoder::streams;
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AudioSharedEncoder *AudioSharedEncoder::create(const std::string &stream_id,
+                                               const std::string &codec,
+                                               const Options &options)
+{
+    // The options are sorted by the map so the key will be the same no
+    // matter in which order the options were given
+  string key = stream_id + '\0' + codec;
+  for (Options::const_iterator it = options.begin(); it != options.end(); ++it)
+  {
+    key += '\0' + it->first + '=' + it->second;
+  }
+
+  Stream *stream = 0;
+  Streams::iterator it = streams.find(key);
+  if (it != streams.end())
+  {
+    stream = it->second;
+  }
+  else
+  {
+    AudioEncoder *enc = AudioEncoder::create(codec);
+    if (enc == 0)
+    {
+      return 0;
+    }
+    for (Options::const_iterator oit = options.begin(); oit != options.end();
+         ++oit)
+    {
+      enc->setOption(oit->first, oit->second);
+    }
+    stream = new Stream(key, enc);
+    streams[key] = stream;
+  }
+
+  AudioSharedEncoder *shared_enc = new AudioSharedEncoder(stream);
+  stream->subscribers.push_back(shared_enc);
+  return shared_enc;
+} /* AudioSharedEncoder::create */
+
+
+unsigned AudioSharedEncoder::encoderCount(void)
+{
+  return streams.size();
+} /* AudioSharedEncoder::encoderCount */
+
+
+AudioSharedEncoder::~AudioSharedEncoder(void)
+{
+  vector<AudioSharedEncoder*> &subs = stream->subscribers;
+  subs.erase(find(subs.begin(), subs.end(), this));
+  if (subs.empty())
+  {
+    streams.erase(stream->key);
+    delete stream;
+  }
+} /* AudioSharedEncoder::~AudioSharedEncoder */
+
+
+const char *AudioSharedEncoder::name(void) const
+{
+  return stream->enc->name();
+} /* AudioSharedEncoder::name */
+
+
+void AudioSharedEncoder::setOption(const std::string &name,
+                                   const std::string &value)
+{
+  cerr << "*** WARNING: Option \"" << name << "\" ignored for shared "
+       << stream->enc->name() << " encoder. Options must be given when "
+          "the encoder is created.\n";
+} /* AudioSharedEncoder::setOption */
+
+
+void AudioSharedEncoder::printCodecParams(void)
+{
+  stream->enc->printCodecParams();
+} /* AudioSharedEncoder::printCodecParams */
+
+
+bool AudioSharedEncoder::isPrimary(void) const
+{
+  return stream->primary() == this;
+} /* AudioSharedEncoder::isPrimary */
+
+
+unsigned AudioSharedEncoder::subscriberCount(void) const
+{
+  return stream->subscribers.size();
+} /* AudioSharedEncoder::subscriberCount */
+
+
+int AudioSharedEncoder::writeSamples(const float *samples, int count)
+{
+  if (isPrimary())
+  {
+    return stream->write(samples, count);
+  }
+  return count;
+} /* AudioSharedEncoder::writeSamples */
+
+
+void AudioSharedEncoder::flushSamples(void)
+{
+  if (isPrimary())
+  {
+    flush_pending = true;
+    stream->flush();
+  }
+  else
+  {
+    sourceAllSamplesFlushed();
+  }
+} /* AudioSharedEncoder::flushSamples */
+
+
+void AudioSharedEncoder::allEncodedSamplesFlushed(void)
+{
+  if (isPrimary())
+  {
+    stream->enc->allEncodedSamplesFlushed();
+  }
+} /* AudioSharedEncoder::allEncodedSamplesFlushed */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+AudioSharedEncoder::AudioSharedEncoder(Stream *stream)
+  : stream(stream), flush_pending(false)
+{
+} /* AudioSharedEncoder::AudioSharedEncoder */
+
+
+void AudioSharedEncoder::encoderFlushed(void)
+{
+  if (flush_pending)
+  {
+    flush_pending = false;
+    sourceAllSamplesFlushed();
+  }
+} /* AudioSharedEncoder::encoderFlushed */
+
+
+
+/*
+ * This file has not been truncated
+ */
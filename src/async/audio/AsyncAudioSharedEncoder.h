@@ -0,0 +1,238 @@
+/**
+@file	 AsyncAudioSharedEncoder.h
+@brief   An audio encoder that can be shared by several consumers
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_SHARED_ENCODER_INCLUDED
+#define ASYNC_AUDIO_SHARED_ENCODER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+#include <map>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioEncoder.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	An audio encoder shared between consumers of the same audio stream
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+When the same audio stream is encoded using the same codec settings for
+several consumers, one encoder can do the job for all of them. Objects of
+this class are created using the create function, giving a stream id, the
+codec name and the codec options. All objects created with the same
+arguments share one real encoder. Each object is an AudioEncoder of its own
+so it can be used as a drop in replacement in code written for a normal
+encoder. The encoded frames are emitted on the writeEncodedSamples signal of
+all objects sharing the encoder.
+
+The first object created for a stream is the primary. Only the audio written
+to the primary is encoded. Audio written to the other objects is thrown away
+since it is assumed to be identical. It is up to the caller to choose a
+stream id that only identify one audio stream. If the primary is deleted,
+the next object in line is promoted. A flush of the primary is forwarded to
+all objects and is acknowledged when the primary consumer call
+allEncodedSamplesFlushed. A flush of any other object is acknowledged
+directly. The real encoder is deleted with the last object using it.
+*/
+class AudioSharedEncoder : public AudioEncoder
+{
+  public:
+    /**
+     * @brief   The type used for codec options
+     */
+    typedef std::map<std::string, std::string> Options;
+
+    /**
+     * @brief   Create a new shared encoder object
+     * @param   stream_id The id of the audio stream to encode
+     * @param   codec     The name of the codec to use
+     * @param   options   The codec options, as given to setOption
+     * @return  Returns a new object or 0 if the codec is unknown
+     */
+    static AudioSharedEncoder *create(const std::string &stream_id,
+                                      const std::string &codec,
+                                      const Options &options=Options());
+
+    /**
+     * @brief   Find out how many encoders that are running
+     * @return  Returns the number of real encoders that currently exist
+     */
+    static unsigned encoderCount(void);
+
+    /**
+     * @brief 	Destructor
+     */
+    virtual ~AudioSharedEncoder(void);
+
+    /**
+     * @brief   Get the name of the codec
+     * @returns Return the name of the codec
+     */
+    virtual const char *name(void) const;
+
+    /**
+     * @brief 	Set an option for the encoder
+     * @param 	name The name of the option
+     * @param 	value The value of the option
+     *
+     * The options are part of the key used to find a shared encoder so they
+     * must be given to the create function. Calling this function will only
+     * print a warning.
+     */
+    virtual void setOption(const std::string &name, const std::string &value);
+
+    /**
+     * @brief Print codec parameter settings
+     */
+    virtual void printCodecParams(void);
+
+    /**
+     * @brief   Check if this is the object that feed the encoder
+     * @return  Returns \em true if audio written to this object is encoded
+     */
+    bool isPrimary(void) const;
+
+    /**
+     * @brief   Get the number of objects sharing the encoder
+     * @return  Returns the number of objects using the same encoder
+     */
+    unsigned subscriberCount(void) const;
+
+    /**
+     * @brief 	Write samples into this audio sink
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the sink to flush the previously written samples
+     */
+    virtual void flushSamples(void);
+
+    /**
+     * @brief 	Call this function when all encoded samples have been flushed
+     */
+    virtual void allEncodedSamplesFlushed(void);
+
+  private:
+    class Stream;
+    friend class Stream;
+    typedef std::map<std::string, Stream*> Streams;
+
+    static Streams  streams;
+
+    Stream          *stream;
+    bool            flush_pending;
+
+    AudioSharedEncoder(Stream *stream);
+    AudioSharedEncoder(const AudioSharedEncoder&);
+    AudioSharedEncoder& operator=(const AudioSharedEncoder&);
+    void encoderFlushed(void);
+
+};  /* class AudioSharedEncoder */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_SHARED_ENCODER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
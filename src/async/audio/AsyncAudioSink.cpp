@@ -50,6 +50,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "AsyncAudioSink.h"
 #include "AsyncAudioSource.h"
+#include "AsyncAudioProfiler.h"
 
 
 
@@ -115,9 +116,17 @@ AudioSink::~AudioSink(void)
 {
   unregisterSource();
   clearHandler();
+  delete m_profiler;
 } /* AudioSink::~AudioSink */
 
 
+void AudioSink::setProfileName(const std::string& name)
+{
+  delete m_profiler;
+  m_profiler = new AudioProfiler(name);
+} /* AudioSink::setProfileName */
+
+
 bool AudioSink::registerSource(AudioSource *source)
 {
   return registerSourceInternal(source, true);
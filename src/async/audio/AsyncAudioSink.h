@@ -34,9 +34,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  * System Includes
  *
  ****************************************************************************/
-
-
 #include <cassert>
+#include <string>
 
 
 /****************************************************************************
@@ -80,6 +79,7 @@ namespace Async
  ****************************************************************************/
 
 class AudioSource;
+class AudioProfiler;
   
 
 /****************************************************************************
@@ -118,7 +118,8 @@ class AudioSink
     /**
      * @brief 	Default constuctor
      */
-    AudioSink(void) : m_source(0), m_handler(0), m_auto_unreg_sink(false) {}
+    AudioSink(void)
+      : m_source(0), m_handler(0), m_auto_unreg_sink(false), m_profiler(0) {}
   
     /**
      * @brief 	Destructor
@@ -180,6 +181,34 @@ class AudioSink
       assert(m_handler != 0);
       m_handler->flushSamples();    
     }
+
+    /**
+     * @brief   Get the number of samples buffered in this sink
+     * @return  Returns the number of samples currently buffered
+     *
+     * Sinks that buffer samples should reimplement this function. It is used
+     * to find the buffer high water mark when profiling the audio pipe.
+     */
+    virtual unsigned samplesBuffered(void) const { return 0; }
+
+    /**
+     * @brief   Give this sink a name in the audio pipe profiler
+     * @param   name The name, e.g. "Rx1:voiceband_filter"
+     *
+     * Naming a sink makes it show up in the statistics printed by
+     * AudioProfiler::dumpAll. Statistics are only collected while profiling
+     * is enabled using AudioProfiler::setEnabled. Stages that have been
+     * fused using AudioProcessor::fuseChain are bypassed so no statistics
+     * will be collected for them.
+     */
+    void setProfileName(const std::string& name);
+
+    /**
+     * @brief   Get the profiler object for this sink
+     * @return  Returns the profiler or 0 if setProfileName has not been
+     *          called
+     */
+    AudioProfiler *profiler(void) const { return m_profiler; }
     
     
   protected:
@@ -226,6 +255,7 @@ class AudioSink
     AudioSource *m_source;
     AudioSink 	*m_handler;
     bool      	m_auto_unreg_sink;
+    AudioProfiler *m_profiler;
     
     bool registerSourceInternal(AudioSource *source, bool reg_sink);
     
@@ -50,6 +50,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "AsyncAudioSource.h"
 #include "AsyncAudioSink.h"
+#include "AsyncAudioProfiler.h"
+#include "AsyncAudioTrace.h"
 
 
 
@@ -171,7 +173,18 @@ int AudioSource::sinkWriteSamples(const float *samples, int len)
   
   if (m_sink != 0)
   {
-    len = m_sink->writeSamples(samples, len);
+    if (AudioTrace::isEnabled() && (m_sink->profiler() != 0))
+    {
+      AudioTrace::record(m_sink->profiler()->traceId());
+    }
+    if (AudioProfiler::isEnabled() && (m_sink->profiler() != 0))
+    {
+      len = m_sink->profiler()->writeSamples(m_sink, samples, len);
+    }
+    else
+    {
+      len = m_sink->writeSamples(samples, len);
+    }
   }
   
   return len;
@@ -79,6 +79,7 @@ namespace Async
  ****************************************************************************/
 
 class AudioSink;
+class AudioProcessor;
   
 
 /****************************************************************************
@@ -259,6 +260,10 @@ class AudioSource
     
     
   private:
+      // AudioProcessor need access to the flushing state of the stages
+      // that it has fused, see AudioProcessor::fuseChain
+    friend class AudioProcessor;
+
     AudioSink 	*m_sink;
     bool      	m_sink_managed;
     AudioSource *m_handler;
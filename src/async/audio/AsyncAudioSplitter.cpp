@@ -6,7 +6,7 @@
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2004-2015 Tobias Blomberg / SM0SVX
+Copyright (C) 2004-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -35,6 +35,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cassert>
 #include <cstring>
 #include <iostream>
+#include <algorithm>
+#include <deque>
 
 
 /****************************************************************************
@@ -54,6 +56,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "AsyncAudioSource.h"
 #include "AsyncAudioSplitter.h"
+#include "AsyncAudioTrace.h"
 
 
 /****************************************************************************
@@ -84,17 +87,19 @@ using namespace Async;
 class Async::AudioSplitter::Branch : public AudioSource
 {
   public:
-    int   current_buf_pos;
     bool  is_flushed;
+    bool  flush_pending;
   
     Branch(AudioSplitter *splitter)
-      : current_buf_pos(0), is_flushed(true), is_enabled(true),
-	is_stopped(false), is_flushing(false), splitter(splitter)
+      : is_flushed(true), flush_pending(false), is_enabled(true),
+	is_stopped(false), is_flushing(false), splitter(splitter),
+        queue_pos(0), queued_samples(0)
     {
     }
     
     virtual ~Branch(void)
     {
+      clearQueue();
       if (is_stopped)
       {
       	splitter->branchResumeOutput();
@@ -111,6 +116,7 @@ class Async::AudioSplitter::Branch : public AudioSource
       
       if (!enabled)
       {
+        clearQueue();
 	if (is_stopped)
 	{
 	  is_stopped = false;
@@ -127,6 +133,8 @@ class Async::AudioSplitter::Branch : public AudioSource
 	}
       }
     }
+
+    bool isEnabled(void) const { return is_enabled; }
     
     int sinkWriteSamples(const float *samples, int len)
     {
@@ -144,14 +152,82 @@ class Async::AudioSplitter::Branch : public AudioSource
       	is_stopped = (len == 0);
       }
       
-      current_buf_pos += len;
-      
       return len;
       
     } /* sinkWriteSamples */
+
+    /**
+     * @brief Write a block of samples coming into the splitter
+     * @param samples The samples to write
+     * @param len     The number of samples
+     * @param shared  A shared copy of the samples, created when needed
+     *
+     * The samples are written directly to the sink if nothing is queued for
+     * this branch. Whatever the sink does not accept is queued as a
+     * reference to the shared copy of the samples.
+     */
+    void write(const float *samples, int len, SampleBuf& shared)
+    {
+      int written = 0;
+      if (queue.empty())
+      {
+        written = sinkWriteSamples(samples, len);
+        if (written == len)
+        {
+          return;
+        }
+      }
+      if (!shared)
+      {
+        shared = std::allocate_shared<Samples>(PoolAllocator<Samples>(),
+                                               samples, samples + len);
+      }
+      if (queue.empty())
+      {
+        queue_pos = written;
+      }
+      queue.push_back(shared);
+      queue_tags.push_back(AudioTrace::current());
+      queued_samples += len - written;
+      writeFromQueue();
+    } /* write */
+
+    /**
+     * @brief Write queued samples to the sink
+     * @return Returns \em true if the queue is empty
+     */
+    bool writeFromQueue(void)
+    {
+      while (!queue.empty())
+      {
+        const Samples& front = *queue.front();
+        int len = front.size() - queue_pos;
+        AudioTrace::Scope trace_scope(queue_tags.front());
+        int written = sinkWriteSamples(&front[queue_pos], len);
+        queue_pos += written;
+        queued_samples -= written;
+        if (written == len)
+        {
+          queue.pop_front();
+          queue_tags.pop_front();
+          queue_pos = 0;
+        }
+        else if (written == 0)
+        {
+          return false;
+        }
+      }
+      return true;
+    } /* writeFromQueue */
+
+    /**
+     * @brief Get the number of samples that are queued for this branch
+     */
+    int queuedSamples(void) const { return queued_samples; }
     
     void sinkFlushSamples(void)
     {
+      flush_pending = false;
       if (is_enabled)
       {
       	is_flushing = true;
@@ -166,11 +242,23 @@ class Async::AudioSplitter::Branch : public AudioSource
     
 
   private:
-    bool      	  is_enabled;
-    bool      	  is_stopped;
-    bool      	  is_flushing;
-    AudioSplitter *splitter;
+    bool      	          is_enabled;
+    bool      	          is_stopped;
+    bool      	          is_flushing;
+    AudioSplitter         *splitter;
+    std::deque<SampleBuf, PoolAllocator<SampleBuf> > queue;
+    std::deque<AudioTrace::Tag, PoolAllocator<AudioTrace::Tag> > queue_tags;
+    int                   queue_pos;
+    int                   queued_samples;
   
+    void clearQueue(void)
+    {
+      queue.clear();
+      queue_tags.clear();
+      queue_pos = 0;
+      queued_samples = 0;
+    } /* clearQueue */
+
     virtual void resumeOutput(void)
     {
       is_stopped = false;
@@ -227,8 +315,8 @@ class Async::AudioSplitter::Branch : public AudioSource
  ****************************************************************************/
 
 AudioSplitter::AudioSplitter(void)
-  : buf(0), buf_size(0), buf_len(0), do_flush(false), input_stopped(false),
-    flushed_branches(0), main_branch(0)
+  : do_flush(false), input_stopped(false), flushed_branches(0),
+    main_branch(0)
 {
   main_branch = new Branch(this);
   branches.push_back(main_branch);
@@ -238,7 +326,6 @@ AudioSplitter::AudioSplitter(void)
 
 AudioSplitter::~AudioSplitter(void)
 {
-  delete [] buf;
   removeAllSinks();
   AudioSource::clearHandler();
   delete main_branch;
@@ -330,38 +417,23 @@ int AudioSplitter::writeSamples(const float *samples, int len)
     return 0;
   }
   
-  if (buf_len > 0)
+    // Only stop the input when a branch fall too far behind
+  if (maxQueuedSamples() >= MAX_QUEUED_SAMPLES)
   {
     input_stopped = true;
     return 0;
   }
   
-  bool samples_written = false;
-  
+    // The samples are copied at most once, into a buffer that is shared by
+    // all branches that could not take all samples right away
+  SampleBuf shared;
   list<Branch *>::iterator it;
   for (it = branches.begin(); it != branches.end(); ++it)
   {
-    (*it)->current_buf_pos = 0;
-    int written = (*it)->sinkWriteSamples(samples, len);
-    if (written != len)
-    {
-      if (buf_len == 0) // Only copy the buffer one time
-      {
-	if (buf_size < len)
-	{
-	  delete [] buf;
-          buf_size = len;
-	  buf = new float[buf_size];
-	}
-	memcpy(buf, samples, len * sizeof(*samples));
-	buf_len = len;
-      }
-    }
-    samples_written |= (written > 0);
+    (*it)->flush_pending = false;
+    (*it)->write(samples, len, shared);
   }
   
-  writeFromBuffer();
-  
   return len;
   
 } /* AudioSplitter::writeSamples */
@@ -383,12 +455,13 @@ void AudioSplitter::flushSamples(void)
   do_flush = true;
   flushed_branches = 0;
   
-  if (buf_len > 0)
+    // Each branch is flushed as soon as its queue is empty
+  list<Branch *>::iterator it;
+  for (it = branches.begin(); it != branches.end(); ++it)
   {
-    return;
+    (*it)->flush_pending = true;
   }
-  
-  flushAllBranches();
+  writeFromBuffer();
   
 } /* AudioSplitter::flushSamples */
 
@@ -441,57 +514,34 @@ void AudioSplitter::flushSamples(void)
  */
 void AudioSplitter::writeFromBuffer(void)
 {
-  bool samples_written = true;
-  bool all_written = (buf_len == 0);
-  
-  //cout << "samples_written=" << samples_written << "  all_written="
-    //   << all_written << endl;
-  
-  while (samples_written && !all_written)
+  list<Branch *>::iterator it;
+  for (it = branches.begin(); it != branches.end(); ++it)
   {
-    samples_written = false;
-    all_written = true;
-    list<Branch *>::iterator it;
-    for (it = branches.begin(); it != branches.end(); ++it)
-    {
-      //cout << "(*it)->current_buf_pos=" << (*it)->current_buf_pos
-	//   << "  buf_len=" << buf_len << endl;
-      if ((*it)->current_buf_pos < buf_len)
-      {
-	int written = (*it)->sinkWriteSamples(buf+(*it)->current_buf_pos,
-	      	      	      	      	      buf_len-(*it)->current_buf_pos);
-	//cout << "written=" << written << endl;
-	samples_written |= (written > 0);
-	all_written &= ((*it)->current_buf_pos == buf_len);
-      }
-    }
-    
-    if (all_written)
+    Branch *branch = *it;
+    if (branch->writeFromQueue() && do_flush && branch->flush_pending)
     {
-      buf_len = 0;
-      if (do_flush)
-      {
-	flushAllBranches();
-      }
+      branch->sinkFlushSamples();
     }
   }
 } /* AudioSplitter::writeFromBuffer */
 
 
-void AudioSplitter::flushAllBranches(void)
+int AudioSplitter::maxQueuedSamples(void) const
 {
-  list<Branch *>::iterator it;
+  int max_queued = 0;
+  list<Branch *>::const_iterator it;
   for (it = branches.begin(); it != branches.end(); ++it)
   {
-    (*it)->sinkFlushSamples();
+    max_queued = max(max_queued, (*it)->queuedSamples());
   }
-} /* AudioSplitter::flushAllBranches */
+  return max_queued;
+} /* AudioSplitter::maxQueuedSamples */
 
 
 void AudioSplitter::branchResumeOutput(void)
 {
   writeFromBuffer();
-  if (input_stopped && (buf_len == 0))
+  if (input_stopped && (maxQueuedSamples() < MAX_QUEUED_SAMPLES))
   {
     input_stopped = false;
     sourceResumeOutput();
@@ -6,7 +6,7 @@
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2004-2015  Tobias Blomberg / SM0SVX
+Copyright (C) 2004-2026  Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -36,6 +36,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <list>
+#include <vector>
+#include <memory>
 #include <sigc++/sigc++.h>
 
 
@@ -46,6 +48,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncTimer.h>
+#include <AsyncMemPool.h>
 
 
 /****************************************************************************
@@ -113,6 +116,12 @@ namespace Async
 
 This class is part of the audio pipe framework. It is used to split one
 incoming audio source into multiple outgoing sources.
+
+The samples are written directly to each connected sink. If a sink does not
+accept all samples, the rest is queued for that branch as a reference to a
+shared copy of the samples, so the other branches are not held up by a slow
+sink. The input is only stopped when a branch have fallen more than
+MAX_QUEUED_SAMPLES samples behind.
 */
 class AudioSplitter : public Async::AudioSink, public Async::AudioSource,
                       public sigc::trackable
@@ -177,24 +186,33 @@ class AudioSplitter : public Async::AudioSink, public Async::AudioSource,
      * This function is normally only called from a connected source object.
      */
     void flushSamples(void);
+
+    /**
+     * @brief   Get the number of samples buffered
+     * @return  Returns the number of samples currently buffered
+     */
+    unsigned samplesBuffered(void) const { return maxQueuedSamples(); }
     
     
   protected:
     
   private:
     class Branch;
+    typedef std::vector<float, PoolAllocator<float> > Samples;
+    typedef std::shared_ptr<const Samples> SampleBuf;
+
+      // The number of samples a branch may fall behind before the input is
+      // stopped
+    static const int MAX_QUEUED_SAMPLES = INTERNAL_SAMPLE_RATE / 4;
     
     std::list<Branch *> branches;
-    float     	      	*buf;
-    int       	      	buf_size;
-    int       	      	buf_len;
     bool      	      	do_flush;
     bool      	      	input_stopped;
     int       	      	flushed_branches;
     Branch              *main_branch;
     
     void writeFromBuffer(void);
-    void flushAllBranches(void);
+    int maxQueuedSamples(void) const;
 
     friend class Branch;
     void branchResumeOutput(void);
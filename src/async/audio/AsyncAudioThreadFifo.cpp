@@ -0,0 +1,326 @@
+/**
+@file	 AsyncAudioThreadFifo.cpp
+@brief   A FIFO for passing audio samples from one thread to another
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+Implements a lock free single producer/single consumer FIFO for handing
+audio samples over from a worker thread to the Async main loop.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncFdWatch.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioThreadFifo.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AudioThreadFifo::AudioThreadFifo(unsigned fifo_size)
+  : head(0), flush_pos(0), flush_seq(0), overruns(0), tail(0), underruns(0),
+    flushed_seq(0), output_stopped(false), stream_active(false),
+    wakeup_pending(false), fifo(0), fifo_size(1), fifo_mask(0),
+    event_fd(-1), event_watch(0)
+{
+  assert(fifo_size > 0);
+  while (this->fifo_size < fifo_size)
+  {
+    this->fifo_size <<= 1;
+  }
+  fifo_mask = this->fifo_size - 1;
+  fifo = new float[this->fifo_size];
+
+  event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd < 0)
+  {
+    cerr << "*** ERROR: Could not create eventfd for AudioThreadFifo: "
+         << strerror(errno) << endl;
+    return;
+  }
+  event_watch = new FdWatch(event_fd, FdWatch::FD_WATCH_RD);
+  event_watch->activity.connect(mem_fun(*this, &AudioThreadFifo::onWakeup));
+} /* AudioThreadFifo::AudioThreadFifo */
+
+
+AudioThreadFifo::~AudioThreadFifo(void)
+{
+  delete event_watch;
+  if (event_fd >= 0)
+  {
+    close(event_fd);
+  }
+  delete [] fifo;
+} /* AudioThreadFifo::~AudioThreadFifo */
+
+
+unsigned AudioThreadFifo::samplesInFifo(void) const
+{
+  const unsigned t = tail.load(memory_order_acquire);
+  return head.load(memory_order_acquire) - t;
+} /* AudioThreadFifo::samplesInFifo */
+
+
+void AudioThreadFifo::resetCounters(void)
+{
+  overruns = 0;
+  underruns = 0;
+} /* AudioThreadFifo::resetCounters */
+
+
+int AudioThreadFifo::writeSamples(const float *samples, int count)
+{
+  assert(count > 0);
+
+    // The head and tail indexes are free running counters. Wrap around of
+    // the counters is handled by the unsigned arithmetic.
+  const unsigned h = head.load(memory_order_relaxed);
+  const unsigned t = tail.load(memory_order_acquire);
+  const unsigned space = fifo_size - (h - t);
+  const unsigned n = min(static_cast<unsigned>(count), space);
+  if (n < static_cast<unsigned>(count))
+  {
+    overruns.fetch_add(count - n, memory_order_relaxed);
+  }
+  if (n == 0)
+  {
+    return count;
+  }
+
+  const unsigned idx = h & fifo_mask;
+  const unsigned n1 = min(n, fifo_size - idx);
+  memcpy(fifo + idx, samples, n1 * sizeof(*fifo));
+  memcpy(fifo, samples + n1, (n - n1) * sizeof(*fifo));
+  head.store(h + n, memory_order_release);
+
+  wakeup();
+
+  return count;
+} /* AudioThreadFifo::writeSamples */
+
+
+void AudioThreadFifo::flushSamples(void)
+{
+  flush_pos.store(head.load(memory_order_relaxed), memory_order_release);
+  flush_seq.fetch_add(1, memory_order_release);
+  wakeup();
+  sourceAllSamplesFlushed();
+} /* AudioThreadFifo::flushSamples */
+
+
+void AudioThreadFifo::resumeOutput(void)
+{
+  output_stopped = false;
+  if (stream_active && (samplesInFifo() == 0) &&
+      (flush_seq.load(memory_order_acquire) == flushed_seq))
+  {
+    underruns.fetch_add(1, memory_order_relaxed);
+  }
+  writeSamplesFromFifo();
+} /* AudioThreadFifo::resumeOutput */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void AudioThreadFifo::allSamplesFlushed(void)
+{
+    // The flush was already acknowledged to the producer when it was
+    // requested so there is nothing more to do here
+} /* AudioThreadFifo::allSamplesFlushed */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void AudioThreadFifo::wakeup(void)
+{
+    // Only signal the eventfd if the main loop is not already about to wake
+    // up so that a system call is not needed for every write
+  if (!wakeup_pending.exchange(true, memory_order_acq_rel) && (event_fd >= 0))
+  {
+      // A failed write can only mean that the eventfd counter is about to
+      // overflow, in which case the main loop is already signalled
+    const uint64_t one = 1;
+    ssize_t ret = write(event_fd, &one, sizeof(one));
+    (void)ret;
+  }
+} /* AudioThreadFifo::wakeup */
+
+
+void AudioThreadFifo::onWakeup(FdWatch *watch)
+{
+  uint64_t cnt;
+  if (read(event_fd, &cnt, sizeof(cnt)) < 0)
+  {
+    if ((errno != EAGAIN) && (errno != EINTR))
+    {
+      cerr << "*** ERROR: Read error on AudioThreadFifo eventfd: "
+           << strerror(errno) << endl;
+    }
+  }
+  wakeup_pending.exchange(false, memory_order_acq_rel);
+  writeSamplesFromFifo();
+} /* AudioThreadFifo::onWakeup */
+
+
+void AudioThreadFifo::writeSamplesFromFifo(void)
+{
+  while (!output_stopped)
+  {
+      // If a flush is pending, only write the samples that were written
+      // before the flush was requested. Loading the flush position with
+      // acquire semantics also make the samples up to that point visible.
+    const unsigned t = tail.load(memory_order_relaxed);
+    const unsigned seq = flush_seq.load(memory_order_acquire);
+    const bool flush_pending = (seq != flushed_seq);
+    const unsigned end = flush_pending
+                         ? flush_pos.load(memory_order_acquire)
+                         : head.load(memory_order_acquire);
+    const unsigned avail = end - t;
+    if (avail == 0)
+    {
+      if (!flush_pending)
+      {
+        break;
+      }
+      flushed_seq = seq;
+      stream_active = false;
+      sinkFlushSamples();
+      continue;
+    }
+
+    const unsigned idx = t & fifo_mask;
+    const unsigned n = min(avail, fifo_size - idx);
+    int ret = sinkWriteSamples(fifo + idx, n);
+    assert(ret >= 0);
+    if (ret > 0)
+    {
+      stream_active = true;
+      tail.store(t + ret, memory_order_release);
+    }
+    else
+    {
+      output_stopped = true;
+    }
+  }
+} /* AudioThreadFifo::writeSamplesFromFifo */
+
+
+
+/*
+ * This file has not been truncated
+ */
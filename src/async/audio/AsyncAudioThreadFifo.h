@@ -0,0 +1,285 @@
+/**
+@file	 AsyncAudioThreadFifo.h
+@brief   A FIFO for passing audio samples from one thread to another
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+Implements a lock free single producer/single consumer FIFO for handing
+audio samples over from a worker thread to the Async main loop.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+#ifndef ASYNC_AUDIO_THREAD_FIFO_INCLUDED
+#define ASYNC_AUDIO_THREAD_FIFO_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <atomic>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+#include <AsyncAudioSource.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class FdWatch;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A FIFO for passing audio samples between threads
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class implements a wait free single producer/single consumer ring buffer
+for audio samples. The sink side (writeSamples, flushSamples) may be called
+from one thread, typically a thread reading from an audio device or running
+some heavy DSP processing, while the source side runs in the thread that
+run the Async main loop. The producer never block and never make any calls
+back into the audio pipe that it is connected to except for the flush
+acknowledge. The main loop is woken up through an eventfd when new samples
+are available.
+
+The pipe semantics differ a bit from Async::AudioFifo since a real time
+producer cannot wait for the consumer:
+
+- Samples that do not fit in the FIFO are thrown away and counted as an
+  overrun. The writeSamples function always report all samples as taken
+  care of.
+- A flush is acknowledged immediately to the producer. The flush is
+  forwarded to the connected sink when all samples written before it have
+  been written to the sink.
+
+The class may also be used as a replacement for an AudioFifo when both sides
+are in the main loop thread. Samples are then written to the sink on the next
+main loop iteration.
+*/
+class AudioThreadFifo : public AudioSink, public AudioSource
+{
+  public:
+    /**
+     * @brief 	Constuctor
+     * @param   fifo_size The size of the FIFO expressed in number of samples.
+     *                    It will be rounded up to the nearest power of two.
+     *
+     * The object must be created in the thread running the Async main loop.
+     */
+    explicit AudioThreadFifo(unsigned fifo_size);
+
+    /**
+     * @brief 	Destructor
+     *
+     * The producer thread must have stopped writing before the object is
+     * destroyed.
+     */
+    virtual ~AudioThreadFifo(void);
+
+    /**
+     * @brief   Get the size of the FIFO
+     * @return  Returns the number of samples the FIFO can hold
+     */
+    unsigned size(void) const { return fifo_size; }
+
+    /**
+     * @brief   Find out how many samples there are in the FIFO
+     * @return  Returns the number of samples in the FIFO
+     *
+     * This function may be called from any thread but the value is only
+     * a snapshot.
+     */
+    unsigned samplesInFifo(void) const;
+
+    /**
+     * @brief   Check if the FIFO is empty
+     * @return  Returns \em true if the FIFO is empty or else \em false
+     */
+    bool empty(void) const { return samplesInFifo() == 0; }
+
+    /**
+     * @brief   Get the number of samples that have been thrown away
+     * @return  Returns the number of samples that did not fit in the FIFO
+     */
+    unsigned long overrunCount(void) const { return overruns; }
+
+    /**
+     * @brief   Get the number of underruns
+     * @return  Returns the number of times the sink asked for more samples
+     *          while the FIFO was empty in the middle of a stream
+     */
+    unsigned long underrunCount(void) const { return underruns; }
+
+    /**
+     * @brief   Reset the overrun and underrun counters
+     */
+    void resetCounters(void);
+
+    /**
+     * @brief 	Write samples into the FIFO
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     *
+     * This function is called from the producer thread. It never block and
+     * always return count. Samples that do not fit are thrown away.
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the FIFO to flush the previously written samples
+     *
+     * This function is called from the producer thread. The flush is
+     * acknowledged directly and is forwarded to the sink by the main loop
+     * thread when all previously written samples have been output.
+     */
+    virtual void flushSamples(void);
+
+    /**
+     * @brief   Get the number of samples buffered
+     * @return  Returns the number of samples currently buffered
+     */
+    virtual unsigned samplesBuffered(void) const { return samplesInFifo(); }
+
+    /**
+     * @brief Resume audio output to the connected sink
+     *
+     * This function will be called when the registered audio sink is ready
+     * to accept more samples.
+     * This function is normally only called from a connected sink object.
+     */
+    virtual void resumeOutput(void);
+
+
+  protected:
+    /**
+     * @brief The registered sink has flushed all samples
+     *
+     * This function will be called when all samples have been flushed in the
+     * registered sink.
+     * This function is normally only called from a connected sink object.
+     */
+    virtual void allSamplesFlushed(void);
+
+
+  private:
+    static const unsigned CACHE_LINE_SIZE = 64;
+
+      // Written by the producer thread
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> head;
+    std::atomic<unsigned>   flush_pos;
+    std::atomic<unsigned>   flush_seq;
+    std::atomic<unsigned long> overruns;
+
+      // Written by the consumer thread
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> tail;
+    std::atomic<unsigned long> underruns;
+    unsigned                flushed_seq;
+    bool                    output_stopped;
+    bool                    stream_active;
+
+      // Shared by both threads
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> wakeup_pending;
+    float                   *fifo;
+    unsigned                fifo_size;
+    unsigned                fifo_mask;
+    int                     event_fd;
+    FdWatch                 *event_watch;
+
+    AudioThreadFifo(const AudioThreadFifo&);
+    AudioThreadFifo& operator=(const AudioThreadFifo&);
+    void wakeup(void);
+    void onWakeup(FdWatch *watch);
+    void writeSamplesFromFifo(void);
+
+};  /* class AudioThreadFifo */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_THREAD_FIFO_INCLUDED */
+
+
+/*
+ * This file has not been truncated
+ */
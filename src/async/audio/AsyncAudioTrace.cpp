@@ -0,0 +1,319 @@
+/**
+@file	 AsyncAudioTrace.cpp
+@brief   Trace the latency of audio through an audio pipe
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <time.h>
+
+#include <iomanip>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioTrace.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+std::atomic<bool> AudioTrace::is_enabled(false);
+std::atomic<unsigned> AudioTrace::generation(0);
+thread_local AudioTrace::Tag AudioTrace::current_tag;
+std::mutex AudioTrace::mutex;
+vector<string> AudioTrace::node_names;
+AudioTrace::StatsMap AudioTrace::stats;
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+void AudioTrace::Queue::push(unsigned count)
+{
+  if (!is_enabled || (count == 0))
+  {
+    return;
+  }
+  checkGeneration();
+
+  const Tag& tag = current_tag;
+  if (!m_segments.empty() && (m_segments.back().tag.origin == tag.origin) &&
+      (m_segments.back().tag.time == tag.time))
+  {
+    m_segments.back().count += count;
+  }
+  else
+  {
+    Segment segment;
+    segment.count = count;
+    segment.tag = tag;
+    m_segments.push_back(segment);
+  }
+  m_samples += count;
+} /* AudioTrace::Queue::push */
+
+
+AudioTrace::Tag AudioTrace::Queue::front(void) const
+{
+  if (!is_enabled || (m_generation != generation) || m_segments.empty())
+  {
+    return Tag();
+  }
+  return m_segments.front().tag;
+} /* AudioTrace::Queue::front */
+
+
+void AudioTrace::Queue::pop(unsigned count)
+{
+  if (!is_enabled)
+  {
+    return;
+  }
+  checkGeneration();
+
+  while ((count > 0) && !m_segments.empty())
+  {
+    Segment& segment = m_segments.front();
+    const unsigned n = min(count, segment.count);
+    segment.count -= n;
+    m_samples -= n;
+    count -= n;
+    if (segment.count == 0)
+    {
+      m_segments.pop_front();
+    }
+  }
+} /* AudioTrace::Queue::pop */
+
+
+void AudioTrace::Queue::trim(unsigned count)
+{
+  if (m_samples > count)
+  {
+    pop(m_samples - count);
+  }
+} /* AudioTrace::Queue::trim */
+
+
+void AudioTrace::Queue::clear(void)
+{
+  m_segments.clear();
+  m_samples = 0;
+} /* AudioTrace::Queue::clear */
+
+
+void AudioTrace::setEnabled(bool enable)
+{
+  if (enable && !is_enabled)
+  {
+      // Tags stored in the queues before tracing was disabled are stale
+    ++generation;
+    resetAll();
+  }
+  is_enabled = enable;
+} /* AudioTrace::setEnabled */
+
+
+unsigned AudioTrace::nodeId(const std::string& name)
+{
+  std::lock_guard<std::mutex> lk(mutex);
+  vector<string>::const_iterator it =
+    find(node_names.begin(), node_names.end(), name);
+  if (it != node_names.end())
+  {
+    return (it - node_names.begin()) + 1;
+  }
+  node_names.push_back(name);
+  return node_names.size();
+} /* AudioTrace::nodeId */
+
+
+void AudioTrace::record(unsigned node)
+{
+  if (!is_enabled || !current_tag.isValid() || (node == 0) ||
+      (node == current_tag.origin))
+  {
+    return;
+  }
+  const double latency = now() - current_tag.time;
+  std::lock_guard<std::mutex> lk(mutex);
+  Stats& s = stats[Path(current_tag.origin, node)];
+  s.count += 1;
+  s.sum += latency;
+  s.max = max(s.max, latency);
+} /* AudioTrace::record */
+
+
+void AudioTrace::resetAll(void)
+{
+  std::lock_guard<std::mutex> lk(mutex);
+  stats.clear();
+} /* AudioTrace::resetAll */
+
+
+void AudioTrace::dumpAll(std::ostream& os)
+{
+  std::lock_guard<std::mutex> lk(mutex);
+  const std::streamsize prec = os.precision();
+  os << fixed << setprecision(2);
+  StatsMap::const_iterator it = stats.begin();
+  while (it != stats.end())
+  {
+    const unsigned origin = it->first.first;
+    vector<pair<double, unsigned> > nodes;
+    for (; (it != stats.end()) && (it->first.first == origin); ++it)
+    {
+      nodes.push_back(make_pair(it->second.sum / it->second.count,
+                                it->first.second));
+    }
+    sort(nodes.begin(), nodes.end());
+
+    os << "Audio captured at " << node_names[origin-1] << ":" << endl;
+    double prev_mean = 0.0;
+    for (size_t i=0; i<nodes.size(); ++i)
+    {
+      const double mean = nodes[i].first;
+      const unsigned node = nodes[i].second;
+      const Stats& s = stats[Path(origin, node)];
+      os << "  " << node_names[node - 1] << ":"
+         << " writes=" << s.count
+         << " mean_ms=" << 1000.0 * mean
+         << " max_ms=" << 1000.0 * s.max
+         << " stage_ms=" << 1000.0 * (mean - prev_mean)
+         << endl;
+      prev_mean = mean;
+    }
+  }
+  os.unsetf(ios::floatfield);
+  os.precision(prec);
+} /* AudioTrace::dumpAll */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void AudioTrace::Queue::checkGeneration(void)
+{
+  if (m_generation != generation)
+  {
+    clear();
+    m_generation = generation;
+  }
+} /* AudioTrace::Queue::checkGeneration */
+
+
+double AudioTrace::now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+} /* AudioTrace::now */
+
+
+
+/*
+ * This file has not been truncated
+ */
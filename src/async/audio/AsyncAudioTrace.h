@@ -0,0 +1,341 @@
+/**
+@file	 AsyncAudioTrace.h
+@brief   Trace the latency of audio through an audio pipe
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_TRACE_INCLUDED
+#define ASYNC_AUDIO_TRACE_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+#include <ostream>
+#include <deque>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Trace the latency of audio through an audio pipe
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+When tracing is enabled, audio entering the pipe at a capture point, an
+AudioTraceTagger, is tagged with the name of the capture point and the time
+it was captured. The tag follow the audio through the pipe. Synchronous
+writes carry the tag of the write that caused them. The classes that buffer
+audio, like AudioFifo, AudioJitterFifo, AudioJitterBuffer, AudioDelayLine,
+AudioMixer and AudioSplitter, keep the tags of the buffered samples in a
+Queue and restore them when the samples are written out again.
+
+Each time tagged audio is written to a sink that has been given a name using
+AudioSink::setProfileName, the time since capture is recorded for that
+capture point and node. The statistics for each capture point is printed
+with the nodes sorted by their mean latency so that the latency added by
+each stage can be seen.
+
+Audio encoders tag the encoded data with the tag of the latest written
+samples so the time spent waiting for a full codec frame is not included
+after an encoder. Tags do not cross threads or the network. Audio received
+from the network is tagged again at its arrival.
+When tracing is disabled, the only overhead is a check of a static flag.
+
+Audio pipes in different threads may be traced at the same time. The
+current tag is kept per thread and the statistics are protected by a lock.
+*/
+class AudioTrace
+{
+  public:
+    /**
+     * @brief   The tag of a block of audio
+     */
+    struct Tag
+    {
+      unsigned  origin; ///< The node id of the capture point, 0 if untagged
+      double    time;   ///< The time of capture, in seconds
+
+      Tag(void) : origin(0), time(0.0) {}
+      Tag(unsigned origin, double time) : origin(origin), time(time) {}
+      bool isValid(void) const { return origin != 0; }
+    };
+
+    /**
+     * @brief   Make a tag current for the lifetime of this object
+     *
+     * Use an object of this class on the stack around a write of buffered
+     * samples so that the samples are written with the tag they had when
+     * they were buffered.
+     */
+    class Scope
+    {
+      public:
+        explicit Scope(const Tag& tag) : m_prev(current_tag)
+        {
+          current_tag = tag;
+        }
+        ~Scope(void) { current_tag = m_prev; }
+
+      private:
+        Tag m_prev;
+
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+    };
+
+    /**
+     * @brief   Keep track of the tags of the samples in a buffer
+     *
+     * The queue mirror the samples in a FIFO type buffer. The current tag is
+     * pushed when samples are stored in the buffer and the tag of the
+     * oldest sample is returned when samples are read from it. Nothing is
+     * stored while tracing is disabled.
+     */
+    class Queue
+    {
+      public:
+        Queue(void) : m_samples(0), m_generation(0) {}
+
+        /**
+         * @brief   Store the current tag for samples put in the buffer
+         * @param   count The number of samples put in the buffer
+         */
+        void push(unsigned count);
+
+        /**
+         * @brief   Get the tag of the oldest sample in the buffer
+         * @return  Returns the tag or an invalid tag if there is none
+         */
+        Tag front(void) const;
+
+        /**
+         * @brief   Remove tags for samples taken out of the buffer
+         * @param   count The number of samples read from the buffer
+         */
+        void pop(unsigned count);
+
+        /**
+         * @brief   Remove the oldest tags to match the buffer content
+         * @param   count The number of samples left in the buffer
+         *
+         * Use this when the oldest samples in the buffer have been thrown
+         * away, for example when a FIFO overflow.
+         */
+        void trim(unsigned count);
+
+        /**
+         * @brief   Remove all tags
+         */
+        void clear(void);
+
+        /**
+         * @brief   Get the number of samples that have tags stored
+         * @return  Returns the number of samples covered by the queue
+         */
+        unsigned size(void) const
+        {
+          return (m_generation == generation) ? m_samples : 0;
+        }
+
+      private:
+        struct Segment
+        {
+          unsigned  count;
+          Tag       tag;
+        };
+
+        std::deque<Segment> m_segments;
+        unsigned            m_samples;
+        unsigned            m_generation;
+
+        void checkGeneration(void);
+    };
+
+    /**
+     * @brief   Enable or disable tracing
+     * @param   enable Set to \em true to enable tracing
+     *
+     * Enabling tracing will also reset the statistics.
+     */
+    static void setEnabled(bool enable);
+
+    /**
+     * @brief   Check if tracing is enabled
+     * @return  Returns \em true if tracing is enabled
+     */
+    static bool isEnabled(void) { return is_enabled.load(); }
+
+    /**
+     * @brief   Get the id of a named node, creating it if needed
+     * @param   name The name of the node
+     * @return  Returns the id of the node, never 0
+     *
+     * A node keep its id for the lifetime of the application so that a
+     * node that is recreated with the same name continue its statistics.
+     */
+    static unsigned nodeId(const std::string& name);
+
+    /**
+     * @brief   Get the tag of the audio being written right now
+     * @return  Returns the current tag, which may be invalid
+     */
+    static const Tag& current(void) { return current_tag; }
+
+    /**
+     * @brief   Create a tag for audio captured right now
+     * @param   origin The node id of the capture point
+     * @return  Returns the new tag
+     */
+    static Tag capture(unsigned origin) { return Tag(origin, now()); }
+
+    /**
+     * @brief   Record the latency of the current tag at a node
+     * @param   node The id of the node
+     *
+     * This function is called by AudioSource::sinkWriteSamples for named
+     * sinks when tracing is enabled. It can also be called directly for
+     * points in the pipe that are not audio sinks.
+     */
+    static void record(unsigned node);
+
+    /**
+     * @brief   Reset the statistics
+     */
+    static void resetAll(void);
+
+    /**
+     * @brief   Print the statistics
+     * @param   os The stream to print to
+     *
+     * The nodes reached from each capture point are printed, one line for
+     * each node, sorted by the mean latency. The stage latency is the mean
+     * latency of the node minus the mean latency of the line before it.
+     */
+    static void dumpAll(std::ostream& os);
+
+  private:
+    struct Stats
+    {
+      unsigned long count;
+      double        sum;
+      double        max;
+
+      Stats(void) : count(0), sum(0.0), max(0.0) {}
+    };
+    typedef std::pair<unsigned, unsigned> Path;
+    typedef std::map<Path, Stats> StatsMap;
+
+    static std::atomic<bool>          is_enabled;
+    static std::atomic<unsigned>      generation;
+    static thread_local Tag           current_tag;
+    static std::mutex                 mutex;
+    static std::vector<std::string>   node_names;
+    static StatsMap                   stats;
+
+    static double now(void);
+
+    AudioTrace(void);
+
+};  /* class AudioTrace */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_TRACE_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
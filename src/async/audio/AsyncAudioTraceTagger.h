@@ -0,0 +1,164 @@
+/**
+@file	 AsyncAudioTraceTagger.h
+@brief   Tag audio passing through with its capture time
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_TRACE_TAGGER_INCLUDED
+#define ASYNC_AUDIO_TRACE_TAGGER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioPassthrough.h>
+#include <AsyncAudioTrace.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Tag audio passing through with its capture time
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class let the audio pass through unchanged. When tracing is enabled
+using AudioTrace::setEnabled, each block of samples is tagged with the name
+of this capture point and the current time before being written to the
+sink. Put it as close to where the audio enter the application as possible.
+*/
+class AudioTraceTagger : public AudioPassthrough
+{
+  public:
+    /**
+     * @brief 	Constuctor
+     * @param   name The name of the capture point
+     */
+    explicit AudioTraceTagger(const std::string& name)
+      : m_origin(AudioTrace::nodeId(name)) {}
+
+    /**
+     * @brief 	Destructor
+     */
+    virtual ~AudioTraceTagger(void) {}
+
+    /**
+     * @brief 	Write samples into this audio sink
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count)
+    {
+      if (!AudioTrace::isEnabled())
+      {
+        return sinkWriteSamples(samples, count);
+      }
+      AudioTrace::Scope scope(AudioTrace::capture(m_origin));
+      return sinkWriteSamples(samples, count);
+    }
+
+  private:
+    unsigned m_origin;
+
+    AudioTraceTagger(const AudioTraceTagger&);
+    AudioTraceTagger& operator=(const AudioTraceTagger&);
+
+};  /* class AudioTraceTagger */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_TRACE_TAGGER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
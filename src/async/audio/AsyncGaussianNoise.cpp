@@ -0,0 +1,269 @@
+/**
+@file	 AsyncGaussianNoise.cpp
+@brief   A fast generator for white gaussian noise
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cmath>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncGaussianNoise.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+#define ZIGGURAT_LAYERS 128
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+  /*
+   * The tables for the ziggurat method as described by Marsaglia and Tsang
+   * in "The Ziggurat Method for Generating Random Variables", 2000.
+   */
+  struct ZigguratTables
+  {
+    static constexpr double R = 3.442619855899;     // Start of the tail
+    static constexpr double V = 9.91256303526217e-3; // Area of each layer
+
+    uint32_t  kn[ZIGGURAT_LAYERS];
+    float     wn[ZIGGURAT_LAYERS];
+    float     fn[ZIGGURAT_LAYERS];
+
+    ZigguratTables(void)
+    {
+      const double m1 = 2147483648.0;
+      double dn = R;
+      double tn = dn;
+      const double q = V / exp(-0.5 * dn * dn);
+      kn[0] = static_cast<uint32_t>((dn / q) * m1);
+      kn[1] = 0;
+      wn[0] = q / m1;
+      wn[ZIGGURAT_LAYERS-1] = dn / m1;
+      fn[0] = 1.0;
+      fn[ZIGGURAT_LAYERS-1] = exp(-0.5 * dn * dn);
+      for (int i=ZIGGURAT_LAYERS-2; i>=1; --i)
+      {
+        dn = sqrt(-2.0 * log(V / dn + exp(-0.5 * dn * dn)));
+        kn[i+1] = static_cast<uint32_t>((dn / tn) * m1);
+        tn = dn;
+        fn[i] = exp(-0.5 * dn * dn);
+        wn[i] = dn / m1;
+      }
+    }
+  };
+};
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+static const ZigguratTables zig;
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+GaussianNoise::GaussianNoise(uint64_t seed)
+{
+  setSeed(seed);
+} /* GaussianNoise::GaussianNoise */
+
+
+void GaussianNoise::setSeed(uint64_t seed)
+{
+    // Expand the seed into the generator state using splitmix64, as
+    // recommended by the authors of xoshiro, so that the state never is
+    // all zeros
+  for (int i=0; i<4; i += 2)
+  {
+    seed += 0x9e3779b97f4a7c15ULL;
+    uint64_t z = seed;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    m_s[i] = static_cast<uint32_t>(z);
+    m_s[i+1] = static_cast<uint32_t>(z >> 32);
+  }
+} /* GaussianNoise::setSeed */
+
+
+float GaussianNoise::next(void)
+{
+  const int32_t hz = static_cast<int32_t>(nextU32());
+  const unsigned iz = hz & (ZIGGURAT_LAYERS - 1);
+  const uint32_t ahz = (hz < 0) ? 0U - static_cast<uint32_t>(hz) : hz;
+  if (ahz < zig.kn[iz])
+  {
+    return hz * zig.wn[iz];
+  }
+  return tail(hz, iz);
+} /* GaussianNoise::next */
+
+
+void GaussianNoise::generate(float *buf, int count, float sigma)
+{
+  for (int i=0; i<count; ++i)
+  {
+    buf[i] = sigma * next();
+  }
+} /* GaussianNoise::generate */
+
+
+void GaussianNoise::add(float *dest, const float *src, int count, float sigma)
+{
+  for (int i=0; i<count; ++i)
+  {
+    dest[i] = src[i] + sigma * next();
+  }
+} /* GaussianNoise::add */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+/**
+ * @brief   Handle the rare case when the fast path of the ziggurat fail
+ * @param   hz  The random number used for the fast path
+ * @param   iz  The layer selected by the random number
+ * @return  Returns a normally distributed random number
+ *
+ * This is reached for about 1.5% of the numbers. Either the number fall
+ * outside of the rectangle for the selected layer or, for the base layer, in
+ * the tail of the distribution.
+ */
+float GaussianNoise::tail(int32_t hz, unsigned iz)
+{
+  for (;;)
+  {
+    float x = hz * zig.wn[iz];
+    if (iz == 0)
+    {
+      float y;
+      do
+      {
+        x = -logf(uniform()) * (1.0f / ZigguratTables::R);
+        y = -logf(uniform());
+      } while (y + y < x * x);
+      return (hz > 0) ? ZigguratTables::R + x : -ZigguratTables::R - x;
+    }
+    if (zig.fn[iz] + uniform() * (zig.fn[iz-1] - zig.fn[iz]) <
+        expf(-0.5f * x * x))
+    {
+      return x;
+    }
+    hz = static_cast<int32_t>(nextU32());
+    iz = hz & (ZIGGURAT_LAYERS - 1);
+    const uint32_t ahz = (hz < 0) ? 0U - static_cast<uint32_t>(hz) : hz;
+    if (ahz < zig.kn[iz])
+    {
+      return hz * zig.wn[iz];
+    }
+  }
+} /* GaussianNoise::tail */
+
+
+
+/*
+ * This file has not been truncated
+ */
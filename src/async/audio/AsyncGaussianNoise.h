@@ -0,0 +1,217 @@
+/**
+@file	 AsyncGaussianNoise.h
+@brief   A fast generator for white gaussian noise
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains a class that generate normally distributed random numbers
+in blocks. It is used by the AudioNoiseAdder class but can also be used by
+other simulators that need a lot of gaussian noise.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_GAUSSIAN_NOISE_INCLUDED
+#define ASYNC_GAUSSIAN_NOISE_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A fast generator for white gaussian noise
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+This class generate normally distributed random numbers with zero mean. The
+uniform random numbers come from a xoshiro128** generator, which is a lot
+faster than rand_r and has much better statistical properties. They are
+turned into normally distributed numbers using the ziggurat method. Most
+numbers only need one random number, a table lookup and a compare so no
+logarithms or trigonometric functions have to be calculated, as with the
+Box-Muller method.
+
+The same seed always give the same sequence of numbers so simulations and
+benchmarks can be reproduced. An object must only be used by one thread at a
+time.
+
+\code
+Async::GaussianNoise noise(1234);
+float buf[256];
+noise.generate(buf, 256, 0.1f);
+\endcode
+*/
+class GaussianNoise
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   seed The seed for the random number generator
+     */
+    explicit GaussianNoise(uint64_t seed=0);
+
+    /**
+     * @brief   Seed the random number generator
+     * @param   seed The seed to use
+     */
+    void setSeed(uint64_t seed);
+
+    /**
+     * @brief   Get a normally distributed random number
+     * @return  Returns a random number with zero mean and a standard
+     *          deviation of one
+     */
+    float next(void);
+
+    /**
+     * @brief   Fill a buffer with gaussian noise
+     * @param   buf   The buffer to fill
+     * @param   count The number of samples to generate
+     * @param   sigma The standard deviation of the noise
+     */
+    void generate(float *buf, int count, float sigma=1.0f);
+
+    /**
+     * @brief   Add gaussian noise to a buffer
+     * @param   dest  The destination buffer
+     * @param   src   The source buffer, may be the same as dest
+     * @param   count The number of samples
+     * @param   sigma The standard deviation of the noise
+     */
+    void add(float *dest, const float *src, int count, float sigma);
+
+    /**
+     * @brief   Get a uniformly distributed random number
+     * @return  Returns a random number in the open interval (0, 1)
+     */
+    float uniform(void)
+    {
+      return (nextU32() >> 8) * (1.0f / 16777216.0f) + (0.5f / 16777216.0f);
+    }
+
+    /**
+     * @brief   Get a uniformly distributed 32 bit random number
+     * @return  Returns a random number
+     */
+    uint32_t nextU32(void)
+    {
+      const uint32_t result = rotl(m_s[1] * 5, 7) * 9;
+      const uint32_t t = m_s[1] << 9;
+      m_s[2] ^= m_s[0];
+      m_s[3] ^= m_s[1];
+      m_s[1] ^= m_s[2];
+      m_s[0] ^= m_s[3];
+      m_s[2] ^= t;
+      m_s[3] = rotl(m_s[3], 11);
+      return result;
+    }
+
+  private:
+    uint32_t m_s[4];
+
+    static uint32_t rotl(uint32_t x, int k)
+    {
+      return (x << k) | (x >> (32 - k));
+    }
+
+    float tail(int32_t hz, unsigned iz);
+
+};  /* class GaussianNoise */
+
+
+} /* namespace */
+
+#endif /* ASYNC_GAUSSIAN_NOISE_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -38,6 +38,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sys/types.h>
 #include <sys/select.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include <cassert>
 #include <algorithm>
@@ -105,6 +106,7 @@ using namespace Async;
  ****************************************************************************/
 
 Application *Application::app_ptr = 0;
+thread_local Application *Application::thread_app_ptr = 0;
 
 
 /****************************************************************************
@@ -124,6 +126,10 @@ Application *Application::app_ptr = 0;
 
 Application &Application::app(void)
 {
+  if (thread_app_ptr != 0)
+  {
+    return *thread_app_ptr;
+  }
   assert(app_ptr != 0);
   return *app_ptr;
 } /* Application::app */
@@ -143,9 +149,14 @@ Application &Application::app(void)
  */
 Application::Application(void)
 {
-  assert(app_ptr == 0);
-  app_ptr = this;  
+  assert(thread_app_ptr == 0);
+  thread_app_ptr = this;
+  if (app_ptr == 0)
+  {
+    app_ptr = this;
+  }
   task_timer = new Async::Timer(0, Timer::TYPE_ONESHOT, false);
+  task_timer->setLabel("Async::Application::runTask");
   task_timer->expired.connect(
       sigc::hide(mem_fun(*this, &Application::taskTimerExpired)));
 } /* Application::Application */
@@ -155,6 +166,14 @@ Application::~Application(void)
 {
   delete task_timer;
   task_timer = 0;
+  if (thread_app_ptr == this)
+  {
+    thread_app_ptr = 0;
+  }
+  if (app_ptr == this)
+  {
+    app_ptr = 0;
+  }
 } /* Application::~Application */
 
 
@@ -165,6 +184,14 @@ void Application::runTask(sigc::slot<void> task)
 } /* Application::runTask */
 
 
+uint64_t Application::monotonicTimeNs(void) const
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+} /* Application::monotonicTimeNs */
+
+
 
 /****************************************************************************
  *
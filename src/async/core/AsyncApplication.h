@@ -37,6 +37,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <stdint.h>
 #include <sigc++/sigc++.h>
 
 #include <string>
@@ -119,17 +120,26 @@ class Application : public sigc::trackable
 {
   public:
     /**
-     * @brief 	Get the one and only application instance
+     * @brief 	Get the application instance
      *
-     * Use this static member function to get the one and only instance of the
-     * application object. If an application object has not been previously
-     * created, the application will crash with a failed assertion.
+     * Use this static member function to get the instance of the application
+     * object. If an application object has not been previously created, the
+     * application will crash with a failed assertion.
+     *
+     * Normally there is only one application object. It is however possible
+     * to run additional event loops in other threads, e.g. using the
+     * Async::CppEventLoopThread class. In that case this function return the
+     * application object that was created in the calling thread. Threads that
+     * do not have an application object of their own get the first
+     * application object that was created, the main application.
      * @return	Returns a reference to the applicaton instance
      */
     static Application &app(void);
     
     /**
      * @brief Default constructor
+     *
+     * Only one application object may be created in each thread.
      */
     Application(void);
     
@@ -176,9 +186,32 @@ class Application : public sigc::trackable
      * and the second is an integer.
      */
     void runTask(sigc::slot<void> task);
+
+    /**
+     * @brief   Read the clock that the timers are based on
+     * @return  Returns the time in nanoseconds since an unspecified start
+     *
+     * Code that measure time intervals that must agree with the timers, like
+     * when pacing audio, should use this clock instead of reading a system
+     * clock directly. By default it is the monotonic system clock but an
+     * application class that simulate time will return the simulated time.
+     */
+    virtual uint64_t monotonicTimeNs(void) const;
     
   protected:
     void clearTasks(void);
+
+    /**
+     * @brief   Check if this is the main application object
+     * @return  Returns \em true if this was the first application created
+     */
+    bool isMainApplication(void) const { return app_ptr == this; }
+
+    /**
+     * @brief   Get the number of tasks waiting to be run
+     * @return  Returns the number of tasks queued using runTask
+     */
+    size_t pendingTaskCount(void) const { return task_list.size(); }
     
   private:
     friend class FdWatch;
@@ -188,6 +221,7 @@ class Application : public sigc::trackable
     typedef std::list<sigc::slot<void> > SlotList;
 
     static Application *app_ptr;
+    static thread_local Application *thread_app_ptr;
     
     SlotList task_list;
     Timer    *task_timer;
@@ -37,8 +37,14 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <sys/time.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <errno.h>
+
 #include <iostream>
 #include <cstdio>
+#include <cstring>
+#include <stdint.h>
 
 
 /****************************************************************************
@@ -117,18 +123,18 @@ using namespace Async;
  ****************************************************************************/
 
 AtTimer::AtTimer(void)
-  : m_expire_offset(0)
+  : m_timer_fd(-1), m_expire_offset(0), m_is_running(false),
+    m_is_armed(false)
 {
-  timerclear(&m_expire_at);
-  m_timer.expired.connect(mem_fun(*this, &AtTimer::onTimerExpired));
+  init();
 } /* AtTimer::AtTimer */
 
 
 AtTimer::AtTimer(struct tm &tm, bool do_start)
-  : m_expire_offset(0)
+  : m_timer_fd(-1), m_expire_offset(0), m_is_running(false),
+    m_is_armed(false)
 {
-  timerclear(&m_expire_at);
-  m_timer.expired.connect(mem_fun(*this, &AtTimer::onTimerExpired));
+  init();
   setTimeout(tm);
   if (do_start)
   {
@@ -139,14 +145,19 @@ AtTimer::AtTimer(struct tm &tm, bool do_start)
 
 AtTimer::~AtTimer(void)
 {
-
+  m_timer_watch.setFd(-1, FdWatch::FD_WATCH_RD);
+  if (m_timer_fd != -1)
+  {
+    close(m_timer_fd);
+  }
 } /* AtTimer::~AtTimer */
 
 
 bool AtTimer::setTimeout(time_t t)
 {
   m_expire_at.tv_sec = t;
-  if (m_timer.isEnabled())
+  m_expire_at.tv_usec = 0;
+  if (m_is_running)
   {
     return start();
   }
@@ -175,20 +186,22 @@ void AtTimer::setExpireOffset(int offset_ms)
 
 bool AtTimer::start(void)
 {
-  int msec = msecToTimeout();
-  if (msec == -1)
-  {
-    return false;
-  }
-  m_timer.setTimeout(msec);
-  m_timer.setEnable(true);
-  return true;
+  m_is_armed = armTimer();
+  m_is_running = m_is_armed;
+  return m_is_running;
 } /* AtTimer::start */
 
 
 void AtTimer::stop(void)
 {
-  m_timer.setEnable(false);
+  m_is_running = false;
+  m_is_armed = false;
+  if (m_timer_fd != -1)
+  {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    timerfd_settime(m_timer_fd, 0, &its, 0);
+  }
 } /* AtTimer::stop */
 
 
@@ -207,63 +220,93 @@ void AtTimer::stop(void)
  *
  ****************************************************************************/
 
-/**
- * @brief   This function will calculate what to set the timer to
- * @return  Returns the number of milliseconds to set the timer to
- *
- * This function will calculate how many milliseconds there is left to the
- * wanted timeout time. If the time is larger than one minute it will be
- * chopped up in 59 second chunks so as to not loose precision.
- * One second before the wanted timeout time occurrs, a last timer is
- * schedules so as to obtain good precision for the final timeout.
- */
-int AtTimer::msecToTimeout(void)
+void AtTimer::init(void)
 {
-  struct timeval now;
-  if (gettimeofday(&now, 0) == -1)
+  timerclear(&m_expire_at);
+  m_timer_fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (m_timer_fd == -1)
   {
-    perror("gettimeofday[AtTimer::msecToTimeout]");
-    return -1;
+    cerr << "*** ERROR: Could not create timerfd for Async::AtTimer: "
+         << strerror(errno) << endl;
+    return;
   }
+  m_timer_watch.activity.connect(mem_fun(*this, &AtTimer::onTimerExpired));
+  m_timer_watch.setFd(m_timer_fd, FdWatch::FD_WATCH_RD);
+} /* AtTimer::init */
 
-  struct timeval diff;
-  timersub(&m_expire_at, &now, &diff);
 
-  long long msec = static_cast<long long>(diff.tv_sec) * 1000
-                   + diff.tv_usec / 1000 + m_expire_offset + 1;
-  if (msec < 0)
+/**
+ * @brief   Arm the timerfd with the absolute expiration time
+ * @return  Returns \em true on success or else \em false
+ *
+ * The timer is armed with TFD_TIMER_CANCEL_ON_SET so that a read from the
+ * timerfd fail with ECANCELED if the realtime clock is set. The timer is then
+ * rearmed in onTimerExpired. If the expiration time already has passed, the
+ * timerfd will expire immediately.
+ */
+bool AtTimer::armTimer(void)
+{
+  if (m_timer_fd == -1)
   {
-    msec = 0;
+    return false;
   }
-  else if (msec > 60000)
+
+  long long expire_ns =
+    static_cast<long long>(m_expire_at.tv_sec) * 1000000000LL +
+    static_cast<long long>(m_expire_at.tv_usec) * 1000LL +
+    static_cast<long long>(m_expire_offset) * 1000000LL;
+  if (expire_ns <= 0)
   {
-    msec = 59000;
+      // A zero it_value would disarm the timer
+    expire_ns = 1;
   }
-  else if (msec > 1500)
+
+  struct itimerspec its;
+  memset(&its, 0, sizeof(its));
+  its.it_value.tv_sec = expire_ns / 1000000000LL;
+  its.it_value.tv_nsec = expire_ns % 1000000000LL;
+  if (timerfd_settime(m_timer_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET,
+                      &its, 0) == -1)
   {
-    msec -= 1000;
+    perror("timerfd_settime[AtTimer::armTimer]");
+    return false;
   }
 
-  return static_cast<int>(msec);
-} /* AtTimer::msecToTimeout */
+  return true;
+} /* AtTimer::armTimer */
 
 
 /**
- * @brief Called by the timer when it expires
- * @param t The timer object
+ * @brief Called when the timerfd expire or the realtime clock is set
+ * @param w The FdWatch for the timerfd
  *
- * This function will be called by the timer when it expires. If the specified
- * time of day have not been reached, the timer will be restarted.
+ * This function will be called when the timerfd is readable. If the read fail
+ * with ECANCELED, the system clock has been set and the timer is rearmed.
  */
-void AtTimer::onTimerExpired(Timer *t)
+void AtTimer::onTimerExpired(FdWatch *w)
 {
-  int msec = msecToTimeout();
-  if (msec > 0)
+  uint64_t expirations = 0;
+  if (read(m_timer_fd, &expirations, sizeof(expirations)) == -1)
   {
-    m_timer.setTimeout(msec);
+    if (errno == ECANCELED)
+    {
+      if (m_is_armed)
+      {
+        m_is_armed = armTimer();
+      }
+    }
+    else if (errno != EAGAIN)
+    {
+      perror("read[AtTimer::onTimerExpired]");
+    }
+    return;
   }
-  else
+
+    // Like a one shot Async::Timer, the timer is still running after it
+    // has expired so that setTimeout will rearm it
+  if (m_is_armed)
   {
+    m_is_armed = false;
     expired(this);
   }
 } /* AtTimer::onTimerExpired */
@@ -53,7 +53,7 @@ An example of how to use the AsyncAtTimer class
  *
  ****************************************************************************/
 
-#include <AsyncTimer.h>
+#include <AsyncFdWatch.h>
 
 
 /****************************************************************************
@@ -121,6 +121,13 @@ This class is used to get a timeout at a specified absolute time. That is,
 you can specify a time of day, like 2013-04-06 12:43:00, when you would
 like the timer to expire.
 
+The timer is implemented using a timerfd with an absolute expiration time
+on the realtime clock. The kernel wake the main loop when the time is
+reached so the timer does not drift due to system load and it is not
+affected by how long other timers or event handlers take to run. If the
+system clock is set, e.g. by NTP, the timer is rearmed so that it still
+expire at the specified time of day.
+
 This class use the gettimeofday() function as its time reference. If reading
 time using another function, like time(), in the expire callback, you can
 not be sure to get the same time value. The gettimeofday() and time()
@@ -202,14 +209,18 @@ class AtTimer : public sigc::trackable
   protected:
     
   private:
-    Timer           m_timer;
+    int             m_timer_fd;
+    FdWatch         m_timer_watch;
     struct timeval  m_expire_at;
     int             m_expire_offset;
+    bool            m_is_running;
+    bool            m_is_armed;
 
     AtTimer(const AtTimer&);
     AtTimer& operator=(const AtTimer&);
-    int msecToTimeout(void);
-    void onTimerExpired(Timer *t);
+    void init(void);
+    bool armTimer(void);
+    void onTimerExpired(FdWatch *w);
     
 };  /* class AtTimer */
 
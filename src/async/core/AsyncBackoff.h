@@ -0,0 +1,208 @@
+/**
+@file	 AsyncBackoff.h
+@brief   Jittered exponential backoff for reconnect delays
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains a small helper class for calculating the delay before the
+next reconnect attempt. The delay starts at a configurable initial value and
+is doubled for each failed attempt up to a maximum value. A random jitter is
+added to each delay so that many clients that lost their connection at the
+same time, e.g. when a server restarts, do not all reconnect at once.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_BACKOFF_INCLUDED
+#define ASYNC_BACKOFF_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstdlib>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Jittered exponential backoff
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+Call nextDelay each time a connection attempt has failed to get the time to
+wait before the next attempt. Call reset when a connection has been
+successfully established. An initial delay of zero make the first attempt
+happen at once. The following delays then start at MIN_DELAY_MS.
+
+\code
+Async::Backoff backoff(1000, 20000);
+reconnect_timer.setTimeout(backoff.nextDelay());
+\endcode
+*/
+class Backoff
+{
+  public:
+    /**
+     * @brief   The smallest delay after the first one
+     */
+    static const unsigned MIN_DELAY_MS = 100;
+
+    /**
+     * @brief   Constructor
+     * @param   initial_ms  The first delay in milliseconds
+     * @param   max_ms      The maximum delay in milliseconds
+     * @param   jitter_pct  The maximum jitter in percent of the delay
+     */
+    Backoff(unsigned initial_ms=1000, unsigned max_ms=20000,
+            unsigned jitter_pct=25)
+      : m_initial_ms(initial_ms), m_max_ms(std::max(initial_ms, max_ms)),
+        m_jitter_pct(jitter_pct), m_delay_ms(initial_ms) {}
+
+    /**
+     * @brief   Set the delay limits
+     * @param   initial_ms  The first delay in milliseconds
+     * @param   max_ms      The maximum delay in milliseconds
+     *
+     * The backoff is reset to the initial delay.
+     */
+    void setDelays(unsigned initial_ms, unsigned max_ms)
+    {
+      m_initial_ms = initial_ms;
+      m_max_ms = std::max(initial_ms, max_ms);
+      reset();
+    }
+
+    /**
+     * @brief   Get the delay to use for the next attempt
+     * @return  Returns the delay in milliseconds
+     *
+     * A random jitter of up to plus/minus the jitter percentage is added
+     * to the delay. The delay for the following attempt is then doubled,
+     * limited to the maximum delay.
+     */
+    unsigned nextDelay(void)
+    {
+      unsigned delay = m_delay_ms;
+      unsigned jitter = delay * m_jitter_pct / 100;
+      if (jitter > 0)
+      {
+        delay = delay - jitter + std::rand() % (2 * jitter + 1);
+      }
+      const unsigned min_delay = MIN_DELAY_MS;
+      m_delay_ms = std::min(std::max(2 * m_delay_ms, min_delay), m_max_ms);
+      return delay;
+    }
+
+    /**
+     * @brief   Get the current delay without jitter
+     * @return  Returns the delay that nextDelay is based on
+     */
+    unsigned delay(void) const { return m_delay_ms; }
+
+    /**
+     * @brief   Restart from the initial delay
+     */
+    void reset(void) { m_delay_ms = m_initial_ms; }
+
+  private:
+    unsigned m_initial_ms;
+    unsigned m_max_ms;
+    unsigned m_jitter_pct;
+    unsigned m_delay_ms;
+
+};  /* class Backoff */
+
+
+} /* namespace */
+
+#endif /* ASYNC_BACKOFF_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
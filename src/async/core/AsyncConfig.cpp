@@ -38,6 +38,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <ctype.h>
@@ -81,6 +85,11 @@ using namespace Async;
  *
  ****************************************************************************/
 
+  // The snapshot file format. Integers are stored in host byte order. The
+  // byte order marker make sure that a snapshot from another host is not used.
+#define SNAPSHOT_MAGIC          "ASYNCCFG"
+#define SNAPSHOT_VERSION        1
+#define SNAPSHOT_BYTE_ORDER     0x01020304
 
 
 /****************************************************************************
@@ -89,6 +98,60 @@ using namespace Async;
  *
  ****************************************************************************/
 
+namespace {
+  /**
+   * @brief A bounds checked reader for a snapshot mapped into memory
+   */
+  class SnapshotReader
+  {
+    public:
+      SnapshotReader(const char *buf, size_t size)
+        : m_buf(buf), m_size(size), m_pos(0) {}
+
+      template <typename T>
+      bool read(T& val)
+      {
+        if (m_size - m_pos < sizeof(T))
+        {
+          return false;
+        }
+        memcpy(&val, m_buf + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+      }
+
+      bool read(string& str)
+      {
+        uint32_t len = 0;
+        if (!read(len) || (m_size - m_pos < len))
+        {
+          return false;
+        }
+        str.assign(m_buf + m_pos, len);
+        m_pos += len;
+        return true;
+      }
+
+      bool readMagic(void)
+      {
+        const size_t len = sizeof(SNAPSHOT_MAGIC) - 1;
+        if ((m_size - m_pos < len) ||
+            (memcmp(m_buf + m_pos, SNAPSHOT_MAGIC, len) != 0))
+        {
+          return false;
+        }
+        m_pos += len;
+        return true;
+      }
+
+      bool atEnd(void) const { return m_pos == m_size; }
+
+    private:
+      const char* m_buf;
+      size_t      m_size;
+      size_t      m_pos;
+  };
+}
 
 
 /****************************************************************************
@@ -97,6 +160,11 @@ using namespace Async;
  *
  ****************************************************************************/
 
+template <typename T>
+static void snapshot_append(string& buf, const T& val);
+static void snapshot_append(string& buf, const string& str);
+static uint32_t snapshot_checksum(const char *buf, size_t len);
+
 
 
 /****************************************************************************
@@ -143,27 +211,183 @@ bool Config::open(const string& name)
   fclose(file);
   file = NULL;
 
+  if (success)
+  {
+    addDependency(name);
+  }
+
   return success;
 
 } /* Config::open */
 
 
-bool Config::getValue(const string& section, const string& tag,
-		      string& value) const
+void Config::addDependency(const string& path)
 {
-  Sections::const_iterator sec_it = sections.find(section);
-  if (sec_it == sections.end())
+  Source src;
+  if (statSource(path, src))
+  {
+    sources.push_back(src);
+  }
+} /* Config::addDependency */
+
+
+bool Config::saveSnapshot(const string& path) const
+{
+  string buf(SNAPSHOT_MAGIC);
+  snapshot_append(buf, static_cast<uint32_t>(SNAPSHOT_VERSION));
+  snapshot_append(buf, static_cast<uint32_t>(SNAPSHOT_BYTE_ORDER));
+  snapshot_append(buf, static_cast<uint32_t>(sources.size()));
+  for (Sources::const_iterator it=sources.begin(); it!=sources.end(); ++it)
+  {
+    snapshot_append(buf, it->path);
+    snapshot_append(buf, it->mtime_sec);
+    snapshot_append(buf, it->mtime_nsec);
+    snapshot_append(buf, it->size);
+  }
+  snapshot_append(buf, static_cast<uint32_t>(sections.size()));
+  for (Sections::const_iterator sit=sections.begin(); sit!=sections.end();
+       ++sit)
+  {
+    snapshot_append(buf, sit->first);
+    snapshot_append(buf, static_cast<uint32_t>(sit->second.size()));
+    for (Values::const_iterator vit=sit->second.begin();
+         vit!=sit->second.end(); ++vit)
+    {
+      snapshot_append(buf, vit->first);
+      snapshot_append(buf, vit->second.str);
+    }
+  }
+  snapshot_append(buf, snapshot_checksum(buf.data(), buf.size()));
+
+  const string tmp_path(path + ".tmp");
+  FILE *file = fopen(tmp_path.c_str(), "w");
+  if (file == NULL)
   {
     return false;
   }
+  bool success = (fwrite(buf.data(), 1, buf.size(), file) == buf.size());
+  success = (fclose(file) == 0) && success;
+  if (success)
+  {
+    success = (rename(tmp_path.c_str(), path.c_str()) == 0);
+  }
+  if (!success)
+  {
+    int errno_save = errno;
+    unlink(tmp_path.c_str());
+    errno = errno_save;
+  }
+  return success;
+} /* Config::saveSnapshot */
 
-  Values::const_iterator val_it = sec_it->second.find(tag);
-  if (val_it == sec_it->second.end())
+
+bool Config::loadSnapshot(const string& path, const string& name)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+  {
+    return false;
+  }
+  struct stat st;
+  if ((fstat(fd, &st) == -1) || (st.st_size == 0))
+  {
+    ::close(fd);
+    return false;
+  }
+  const size_t size = st.st_size;
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+  {
+    return false;
+  }
+  const char *buf = static_cast<const char*>(map);
+
+    // Verify the checksum before trusting anything in the file
+  uint32_t checksum = 0;
+  bool ok = (size > sizeof(checksum));
+  if (ok)
+  {
+    memcpy(&checksum, buf + size - sizeof(checksum), sizeof(checksum));
+    ok = (checksum == snapshot_checksum(buf, size - sizeof(checksum)));
+  }
+
+  SnapshotReader rd(buf, ok ? size - sizeof(checksum) : 0);
+  uint32_t version = 0;
+  uint32_t byte_order = 0;
+  uint32_t cnt = 0;
+  ok = ok && rd.readMagic() &&
+       rd.read(version) && (version == SNAPSHOT_VERSION) &&
+       rd.read(byte_order) && (byte_order == SNAPSHOT_BYTE_ORDER) &&
+       rd.read(cnt) && (cnt > 0);
+  Sources snap_sources;
+  for (uint32_t i=0; ok && (i<cnt); ++i)
+  {
+    Source src;
+    ok = rd.read(src.path) && rd.read(src.mtime_sec) &&
+         rd.read(src.mtime_nsec) && rd.read(src.size);
+    Source cur;
+    ok = ok && statSource(src.path, cur) &&
+         (cur.mtime_sec == src.mtime_sec) &&
+         (cur.mtime_nsec == src.mtime_nsec) && (cur.size == src.size);
+    snap_sources.push_back(src);
+  }
+  ok = ok && (snap_sources.front().path == name);
+
+  Sections snap_sections;
+  if (ok)
+  {
+    ok = rd.read(cnt);
+  }
+  for (uint32_t i=0; ok && (i<cnt); ++i)
+  {
+    string section;
+    uint32_t value_cnt = 0;
+    ok = rd.read(section) && rd.read(value_cnt);
+    Values& values = snap_sections[section];
+    for (uint32_t j=0; ok && (j<value_cnt); ++j)
+    {
+      string tag;
+      ok = rd.read(tag) && rd.read(values[tag].str);
+    }
+  }
+  ok = ok && rd.atEnd();
+
+  munmap(map, size);
+
+  if (!ok)
+  {
+    return false;
+  }
+
+  for (Sections::iterator sit=snap_sections.begin();
+       sit!=snap_sections.end(); ++sit)
+  {
+    Values& values = sections[sit->first];
+    for (Values::iterator vit=sit->second.begin(); vit!=sit->second.end();
+         ++vit)
+    {
+      Value& val = values[vit->first];
+      val.str.swap(vit->second.str);
+      val.clearCache();
+    }
+  }
+  sources.insert(sources.end(), snap_sources.begin(), snap_sources.end());
+
+  return true;
+} /* Config::loadSnapshot */
+
+
+bool Config::getValue(const string& section, const string& tag,
+		      string& value) const
+{
+  const Value *val = findValue(section, tag);
+  if (val == 0)
   {
     return false;
   }
 
-  value = val_it->second;
+  value = val->str;
   return true;
 } /* Config::getValue */
 
@@ -172,19 +396,13 @@ const string &Config::getValue(const string& section, const string& tag) const
 {
   static const string empty_strng;
   
-  Sections::const_iterator sec_it = sections.find(section);
-  if (sec_it == sections.end())
-  {
-    return empty_strng;
-  }
-
-  Values::const_iterator val_it = sec_it->second.find(tag);
-  if (val_it == sec_it->second.end())
+  const Value *val = findValue(section, tag);
+  if (val == 0)
   {
     return empty_strng;
   }
 
-  return val_it->second;
+  return val->str;
 } /* Config::getValue */
 
 
@@ -195,6 +413,7 @@ list<string> Config::listSections(void)
   {
     section_list.push_back((*it).first);
   }
+  section_list.sort();
   return section_list;
 } /* Config::listSections */
 
@@ -214,6 +433,7 @@ list<string> Config::listSection(const string& section)
   {
     tags.push_back(it->first);
   }
+  tags.sort();
   
   return tags;
   
@@ -223,15 +443,84 @@ list<string> Config::listSection(const string& section)
 void Config::setValue(const std::string& section, const std::string& tag,
       	      	      const std::string& value)
 {
-  Values &values = sections[section];
-  if (value != values[tag])
+  Value &val = sections[section][tag];
+  if (value != val.str)
   {
-    values[tag] = value;
+    val.str = value;
+    val.clearCache();
     valueUpdated(section, tag);
   }
 } /* Config::setValue */
 
 
+unsigned Config::update(const Config& new_cfg)
+{
+  typedef std::vector<std::pair<string, string> > Changes;
+  Changes changes;
+
+  Sections::iterator sec_it = sections.begin();
+  while (sec_it != sections.end())
+  {
+    Values& values = sec_it->second;
+    Values::iterator val_it = values.begin();
+    while (val_it != values.end())
+    {
+      if (new_cfg.findValue(sec_it->first, val_it->first) == 0)
+      {
+        changes.push_back(make_pair(sec_it->first, val_it->first));
+        val_it = values.erase(val_it);
+      }
+      else
+      {
+        ++val_it;
+      }
+    }
+    if (values.empty())
+    {
+      sec_it = sections.erase(sec_it);
+    }
+    else
+    {
+      ++sec_it;
+    }
+  }
+
+  Sections::const_iterator new_sec_it = new_cfg.sections.begin();
+  for (; new_sec_it != new_cfg.sections.end(); ++new_sec_it)
+  {
+    Values& values = sections[new_sec_it->first];
+    Values::const_iterator new_val_it = new_sec_it->second.begin();
+    for (; new_val_it != new_sec_it->second.end(); ++new_val_it)
+    {
+      Values::iterator val_it = values.find(new_val_it->first);
+      if (val_it == values.end())
+      {
+        values[new_val_it->first] = new_val_it->second;
+      }
+      else if (val_it->second.str != new_val_it->second.str)
+      {
+        val_it->second = new_val_it->second;
+      }
+      else
+      {
+        continue;
+      }
+      changes.push_back(make_pair(new_sec_it->first, new_val_it->first));
+    }
+  }
+
+  sources = new_cfg.sources;
+
+  for (Changes::const_iterator it = changes.begin(); it != changes.end(); ++it)
+  {
+    valueUpdated(it->first, it->second);
+  }
+
+  return changes.size();
+} /* Config::update */
+
+
+
 /****************************************************************************
  *
  * Protected member functions
@@ -263,6 +552,39 @@ void Config::setValue(const std::string& section, const std::string& tag,
  *
  ****************************************************************************/
 
+bool Config::statSource(const string& path, Source& src)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) == -1)
+  {
+    return false;
+  }
+  src.path = path;
+  src.mtime_sec = st.st_mtim.tv_sec;
+  src.mtime_nsec = st.st_mtim.tv_nsec;
+  src.size = st.st_size;
+  return true;
+} /* Config::statSource */
+
+
+const Config::Value *Config::findValue(const string& section,
+                                       const string& tag) const
+{
+  Sections::const_iterator sec_it = sections.find(section);
+  if (sec_it == sections.end())
+  {
+    return 0;
+  }
+
+  Values::const_iterator val_it = sec_it->second.find(tag);
+  if (val_it == sec_it->second.end())
+  {
+    return 0;
+  }
+
+  return &val_it->second;
+} /* Config::findValue */
+
 
 /*
  *----------------------------------------------------------------------------
@@ -336,9 +658,9 @@ bool Config::parseCfgFile(FILE *file)
 	}
 	assert(!current_sec.empty());
 	
-	Values &values = sections[current_sec];
-	string& value = values[current_tag];
-	value += val;
+	Value &value = sections[current_sec][current_tag];
+	value.str += val;
+	value.clearCache();
 	break;
       }
       
@@ -359,9 +681,10 @@ bool Config::parseCfgFile(FILE *file)
 	      	  "section on line " << line_no << endl;
 	  return false;
 	}
-	Values &values = sections[current_sec];
 	current_tag = tag;
-	values[current_tag] = value;
+	Value &val = sections[current_sec][current_tag];
+	val.str = value;
+	val.clearCache();
       	break;
       }
     }
@@ -516,6 +839,40 @@ char *Config::translateEscapedChars(char *val)
 
 
 
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+template <typename T>
+static void snapshot_append(string& buf, const T& val)
+{
+  buf.append(reinterpret_cast<const char*>(&val), sizeof(val));
+} /* snapshot_append */
+
+
+static void snapshot_append(string& buf, const string& str)
+{
+  snapshot_append(buf, static_cast<uint32_t>(str.size()));
+  buf.append(str);
+} /* snapshot_append */
+
+
+  // 32 bit FNV-1a, enough to detect a truncated or corrupted snapshot
+static uint32_t snapshot_checksum(const char *buf, size_t len)
+{
+  uint32_t hash = 2166136261U;
+  for (size_t i=0; i<len; ++i)
+  {
+    hash ^= static_cast<uint8_t>(buf[i]);
+    hash *= 16777619U;
+  }
+  return hash;
+} /* snapshot_checksum */
+
+
+
 /*
  * This file has not been truncated
  */
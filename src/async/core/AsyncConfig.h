@@ -46,10 +46,12 @@ An example of how to use the Config class
  ****************************************************************************/
 
 #include <stdio.h>
+#include <stdint.h>
 #include <sigc++/sigc++.h>
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <list>
 #include <memory>
 #include <sstream>
@@ -157,6 +159,46 @@ class Config
      * give a hint what the problem was.
      */
     bool open(const std::string& name);
+
+    /**
+     * @brief   Add a file or directory that the configuration depend on
+     * @param   path  The path to the file or directory
+     *
+     * All files read using the open function are automatically recorded as
+     * sources of the configuration. Use this function to add other paths
+     * that should invalidate a snapshot when they change, like a directory
+     * that configuration files are read from. For a directory, adding or
+     * removing files will change its modification time.
+     */
+    void addDependency(const std::string& path);
+
+    /**
+     * @brief   Save a snapshot of the parsed configuration
+     * @param   path  The path of the snapshot file to write
+     * @return  Returns \em true on success or else \em false
+     *
+     * Write all configuration variables to a binary snapshot file together
+     * with the modification time and size of all source files. A snapshot can
+     * be loaded much faster than the source files can be parsed. The file is
+     * written to a temporary file that is then renamed so a snapshot file is
+     * never seen half written.
+     */
+    bool saveSnapshot(const std::string& path) const;
+
+    /**
+     * @brief   Load a snapshot of a parsed configuration
+     * @param   path  The path of the snapshot file to load
+     * @param   name  The configuration file the snapshot must originate from
+     * @return  Returns \em true on success or else \em false
+     *
+     * Load a snapshot previously written by saveSnapshot. The snapshot is
+     * only used if it was created from the given configuration file and if
+     * none of the source files or dependencies have changed since. Otherwise
+     * \em false is returned and the configuration is left untouched so that
+     * the caller can fall back to the open function. A snapshot is tied to
+     * the host that created it.
+     */
+    bool loadSnapshot(const std::string& path, const std::string& name);
     
     /**
      * @brief 	Return the string value of the given configuration variable
@@ -212,23 +254,17 @@ class Config
     bool getValue(const std::string& section, const std::string& tag,
 		  Rsp &rsp, bool missing_ok = false) const
     {
-      std::string str_val;
-      if (!getValue(section, tag, str_val))
+      const Value *val = findValue(section, tag);
+      if (val == 0)
       {
 	return missing_ok;
       }
-      std::stringstream ssval(str_val);
-      Rsp tmp;
-      ssval >> tmp;
-      if(!ssval.eof())
-      {
-        ssval >> std::ws;
-      }
-      if (ssval.fail() || !ssval.eof())
+      const Rsp *tmp = parsedValue<Rsp>(*val);
+      if (tmp == 0)
       {
 	return false;
       }
-      rsp = tmp;
+      rsp = *tmp;
       return true;
     } /* Config::getValue */
 
@@ -253,37 +289,28 @@ class Config
      * still returns \em false if an illegal value is specified.
      */
     template <template <typename, typename> class Container,
-              typename Value>
+              typename Elem>
     bool getValue(const std::string& section, const std::string& tag,
-		  Container<Value, std::allocator<Value> > &c,
+		  Container<Elem, std::allocator<Elem> > &c,
                   bool missing_ok = false) const
     {
-      std::string str_val;
-      if (!getValue(section, tag, str_val))
+      typedef Container<Elem, std::allocator<Elem> > C;
+      const Value *val = findValue(section, tag);
+      if (val == 0)
       {
 	return missing_ok;
       }
-      if (str_val.empty())
+      if (val->str.empty())
       {
         c.clear();
         return true;
       }
-      std::stringstream ssval(str_val);
-      ssval.imbue(std::locale(ssval.getloc(), new csv_whitespace));
-      while (!ssval.eof())
+      const C *tmp = parsedValue<C>(*val);
+      if (tmp == 0)
       {
-        Value tmp;
-        ssval >> tmp;
-        if(!ssval.eof())
-        {
-          ssval >> std::ws;
-        }
-        if (ssval.fail())
-        {
-          return false;
-        }
-        c.push_back(tmp);
+        return false;
       }
+      c.insert(c.end(), tmp->begin(), tmp->end());
       return true;
     } /* Config::getValue */
 
@@ -314,31 +341,23 @@ class Config
                   Container<Key, std::less<Key>, std::allocator<Key> > &c,
                   bool missing_ok = false) const
     {
-      std::string str_val;
-      if (!getValue(section, tag, str_val))
+      typedef Container<Key, std::less<Key>, std::allocator<Key> > C;
+      const Value *val = findValue(section, tag);
+      if (val == 0)
       {
         return missing_ok;
       }
-      if (str_val.empty())
+      if (val->str.empty())
       {
         c.clear();
         return true;
       }
-      std::stringstream ssval(str_val);
-      while (!ssval.eof())
+      const C *tmp = parsedValue<C>(*val);
+      if (tmp == 0)
       {
-        Key tmp;
-        ssval >> tmp;
-        if(!ssval.eof())
-        {
-          ssval >> std::ws;
-        }
-        if (ssval.fail())
-        {
-          return false;
-        }
-        c.insert(tmp);
+        return false;
       }
+      c.insert(tmp->begin(), tmp->end());
       return true;
     } /* Config::getValue */
 
@@ -368,23 +387,17 @@ class Config
 		  const Rsp& min, const Rsp& max, Rsp &rsp,
 		  bool missing_ok = false) const
     {
-      std::string str_val;
-      if (!getValue(section, tag, str_val))
+      const Value *val = findValue(section, tag);
+      if (val == 0)
       {
 	return missing_ok;
       }
-      std::stringstream ssval(str_val);
-      Rsp tmp;
-      ssval >> tmp;
-      if(!ssval.eof())
-      {
-        ssval >> std::ws;
-      }
-      if (ssval.fail() || !ssval.eof() || (tmp < min) || (tmp > max))
+      const Rsp *tmp = parsedValue<Rsp>(*val);
+      if ((tmp == 0) || (*tmp < min) || (*tmp > max))
       {
 	return false;
       }
-      rsp = tmp;
+      rsp = *tmp;
       return true;
     } /* Config::getValue */
 
@@ -447,20 +460,122 @@ class Config
       setValue(section, tag, ss.str());
     }
 
+    /**
+     * @brief   Update this configuration to match another one
+     * @param   new_cfg The newly read configuration
+     * @return  Returns the number of variables that was added, changed or
+     *          removed
+     *
+     * This function is used to reload the configuration of a running
+     * application without restarting it. The values in this object are
+     * compared to the values in new_cfg. Variables that have been added or
+     * changed get the new value and variables that do not exist in new_cfg are
+     * removed. Variables that have not changed are left untouched, including
+     * their cached parsed values.
+     *
+     * The valueUpdated signal is emitted for each added, changed or removed
+     * variable. The signals are emitted after all changes have been applied
+     * so that a subscriber always see the complete new configuration.
+     */
+    unsigned update(const Config& new_cfg);
+
     /**
      * @brief   A signal that is emitted when a config value is updated
      * @param   section The config section of the update
      * @param   tag     The tag (variable name) of the update
      *
      * This signal is emitted whenever a configuration variable is changed
-     * by calling the setValue function. It will only be emitted if the value
-     * actually changes.
+     * by calling the setValue or the update function. It will only be emitted
+     * if the value actually changes. When a variable has been removed by the
+     * update function, getValue will return \em false for it when the signal
+     * is emitted.
      */
     sigc::signal<void, const std::string&, const std::string&> valueUpdated;
 
   private:
-    typedef std::map<std::string, std::string>  Values;
-    typedef std::map<std::string, Values>       Sections;
+    class CacheEntryBase
+    {
+      public:
+        virtual ~CacheEntryBase(void) {}
+    };
+
+    template <typename T>
+    class CacheEntry : public CacheEntryBase
+    {
+      public:
+        explicit CacheEntry(const T& v) : value(v) {}
+        T value;
+    };
+
+      // A configuration variable value. Beside the string value, the
+      // parsed value is cached for each type that it has been read as.
+      // The cache is not copied and it is cleared when the value change.
+    class Value
+    {
+      public:
+        std::string str;
+
+        Value(void) {}
+        Value(const Value& other) : str(other.str) {}
+        ~Value(void) { clearCache(); }
+        Value& operator=(const Value& other)
+        {
+          if (this != &other)
+          {
+            clearCache();
+            str = other.str;
+          }
+          return *this;
+        }
+
+        template <typename T>
+        const T *cached(void) const
+        {
+          const void *key = typeKey<T>();
+          for (Cache::const_iterator it = cache.begin(); it != cache.end();
+               ++it)
+          {
+            if (it->first == key)
+            {
+              return &static_cast<const CacheEntry<T>*>(it->second)->value;
+            }
+          }
+          return 0;
+        }
+
+        template <typename T>
+        const T *setCached(const T& v) const
+        {
+          CacheEntry<T> *entry = new CacheEntry<T>(v);
+          cache.push_back(std::make_pair(typeKey<T>(), entry));
+          return &entry->value;
+        }
+
+        void clearCache(void)
+        {
+          for (Cache::iterator it = cache.begin(); it != cache.end(); ++it)
+          {
+            delete it->second;
+          }
+          cache.clear();
+        }
+
+      private:
+        typedef std::vector<std::pair<const void*, CacheEntryBase*> > Cache;
+
+        mutable Cache cache;
+
+          // Return a unique key for each type
+        template <typename T>
+        static const void *typeKey(void)
+        {
+          static const char key = 0;
+          return &key;
+        }
+    };
+
+    typedef std::unordered_map<std::string, Value>   Values;
+    typedef std::unordered_map<std::string, Values>  Sections;
     struct csv_whitespace : std::ctype<char>
     {
       static const mask* make_table(void)
@@ -475,10 +590,102 @@ class Config
         : std::ctype<char>(make_table(), false, refs) {}
     };
 
+      // A file or directory that the configuration was created from
+    struct Source
+    {
+      std::string path;
+      int64_t     mtime_sec;
+      int64_t     mtime_nsec;
+      uint64_t    size;
+    };
+    typedef std::vector<Source> Sources;
+
     Sections  sections;
+    Sources   sources;
 
     //Config(const Config&);
     //Config& operator=(const Config&);
+    const Value *findValue(const std::string& section,
+                           const std::string& tag) const;
+
+    template <typename Rsp>
+    static bool fromString(const std::string& str_val, Rsp& rsp)
+    {
+      std::stringstream ssval(str_val);
+      ssval >> rsp;
+      if(!ssval.eof())
+      {
+        ssval >> std::ws;
+      }
+      return !ssval.fail() && ssval.eof();
+    }
+
+    template <template <typename, typename> class Container,
+              typename Elem>
+    static bool fromString(const std::string& str_val,
+                           Container<Elem, std::allocator<Elem> > &c)
+    {
+      std::stringstream ssval(str_val);
+      ssval.imbue(std::locale(ssval.getloc(), new csv_whitespace));
+      while (!ssval.eof())
+      {
+        Elem tmp;
+        ssval >> tmp;
+        if(!ssval.eof())
+        {
+          ssval >> std::ws;
+        }
+        if (ssval.fail())
+        {
+          return false;
+        }
+        c.push_back(tmp);
+      }
+      return true;
+    }
+
+    template <template <typename, typename, typename> class Container,
+              typename Key>
+    static bool fromString(const std::string& str_val,
+                   Container<Key, std::less<Key>, std::allocator<Key> > &c)
+    {
+      std::stringstream ssval(str_val);
+      while (!ssval.eof())
+      {
+        Key tmp;
+        ssval >> tmp;
+        if(!ssval.eof())
+        {
+          ssval >> std::ws;
+        }
+        if (ssval.fail())
+        {
+          return false;
+        }
+        c.insert(tmp);
+      }
+      return true;
+    }
+
+      // Return the value parsed as the given type, from the cache if
+      // possible. Returns 0 if the value could not be parsed.
+    template <typename T>
+    static const T *parsedValue(const Value& val)
+    {
+      const T *cached = val.cached<T>();
+      if (cached == 0)
+      {
+        T tmp;
+        if (!fromString(val.str, tmp))
+        {
+          return 0;
+        }
+        cached = val.setCached(tmp);
+      }
+      return cached;
+    }
+
+    static bool statSource(const std::string& path, Source& src);
     bool parseCfgFile(FILE *file);
     char *trimSpaces(char *line);
     char *parseSection(char *line);
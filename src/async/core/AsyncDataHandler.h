@@ -0,0 +1,250 @@
+/**
+@file	 AsyncDataHandler.h
+@brief   Direct data handler callbacks for hot paths
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains a lightweight alternative to sigc++ signals for delivering
+received data to exactly one consumer. A DataHandler is bound to an object and
+a member function at compile time. Calling it is a plain function pointer call
+into a small trampoline where the member function call can be inlined. Data is
+delivered as a DataView, a pointer and a size, so that the producer can hand
+out its own buffer without copying it into a container first.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_DATA_HANDLER_INCLUDED
+#define ASYNC_DATA_HANDLER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <cstddef>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A read only view of a buffer owned by someone else
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+The view is only valid during the callback it is given to. Copy the data if
+it is needed after the callback has returned.
+*/
+class DataView
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   data  A pointer to the first byte of the buffer
+     * @param   size  The number of bytes in the buffer
+     */
+    DataView(const void *data, size_t size)
+      : m_data(static_cast<const uint8_t*>(data)), m_size(size) {}
+
+    /**
+     * @brief   Get a pointer to the data
+     */
+    const uint8_t *data(void) const { return m_data; }
+
+    /**
+     * @brief   Get the number of bytes in the buffer
+     */
+    size_t size(void) const { return m_size; }
+
+    /**
+     * @brief   Check if the buffer is empty
+     */
+    bool empty(void) const { return m_size == 0; }
+
+    const uint8_t *begin(void) const { return m_data; }
+    const uint8_t *end(void) const { return m_data + m_size; }
+    const uint8_t& operator[](size_t i) const { return m_data[i]; }
+
+  private:
+    const uint8_t*  m_data;
+    size_t          m_size;
+
+};  /* class DataView */
+
+
+template <typename Sig> class DataHandler;
+
+/**
+@brief	A callback bound to exactly one member function of one object
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+A data handler is used where a sigc++ signal would otherwise be used but
+where there always is exactly one receiver and the call is on a hot path.
+The member function is a template argument so the compiler can inline it into
+the trampoline function that the handler calls through.
+
+\code
+class MyClass
+{
+  public:
+    MyClass(void)
+    {
+      m_handler.set<MyClass, &MyClass::onData>(this);
+    }
+  private:
+    Async::DataHandler<void(Async::DataView)> m_handler;
+    void onData(Async::DataView data) { ... }
+};
+\endcode
+
+Unlike a sigc++ slot, a data handler is not automatically disconnected when
+the receiving object is destroyed. The receiver must clear the handler, or
+destroy the object holding it, before it goes away.
+*/
+template <typename R, typename... Args>
+class DataHandler<R(Args...)>
+{
+  public:
+    /**
+     * @brief   Default constructor
+     */
+    DataHandler(void) : m_obj(0), m_fn(0) {}
+
+    /**
+     * @brief   Bind the handler to a member function
+     * @param   obj The object to call the member function on
+     */
+    template <typename T, R (T::*Method)(Args...)>
+    void set(T *obj)
+    {
+      m_obj = obj;
+      m_fn = &trampoline<T, Method>;
+    }
+
+    /**
+     * @brief   Unbind the handler
+     */
+    void clear(void)
+    {
+      m_obj = 0;
+      m_fn = 0;
+    }
+
+    /**
+     * @brief   Check if the handler is bound
+     */
+    bool isSet(void) const { return m_fn != 0; }
+
+    /**
+     * @brief   Call the bound member function
+     *
+     * Must only be called when isSet() return \em true.
+     */
+    R operator()(Args... args) const { return m_fn(m_obj, args...); }
+
+  private:
+    void* m_obj;
+    R     (*m_fn)(void*, Args...);
+
+    template <typename T, R (T::*Method)(Args...)>
+    static R trampoline(void *obj, Args... args)
+    {
+      return (static_cast<T*>(obj)->*Method)(args...);
+    }
+
+};  /* class DataHandler */
+
+
+} /* namespace */
+
+#endif /* ASYNC_DATA_HANDLER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
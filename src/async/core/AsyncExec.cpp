@@ -38,7 +38,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/resource.h>
-#include <sys/types.h>
+#include <spawn.h>
 
 #include <cstring>
 #include <cassert>
@@ -54,6 +54,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncTimer.h>
+#include <AsyncApplication.h>
 
 
 /****************************************************************************
@@ -99,6 +100,8 @@ using namespace Async;
  *
  ****************************************************************************/
 
+static void closePipe(int filedes[2]);
+
 
 
 /****************************************************************************
@@ -120,6 +123,8 @@ int               Exec::sigchld_pipe[2] = {-1, -1};
 Async::FdWatch    *Exec::sigchld_watch = 0;
 struct sigaction  Exec::old_sigact;
 
+extern char **environ;
+
 
 /****************************************************************************
  *
@@ -129,14 +134,15 @@ struct sigaction  Exec::old_sigact;
 
 Exec::Exec(const std::string &cmd)
   : pid(-1), stdout_watch(0), stderr_watch(0), stdin_fd(-1),
-    status(0), nice_value(0), timeout_timer(0), pending_term(false)
+    status(0), nice_value(0), timeout_timer(0), pending_term(false),
+    stdout_append(false), stderr_append(false)
 {
   setCommandLine(cmd);
 
     // Set up SIGCHLD signal handling on first usage of the class
   if (sigchld_watch == 0)
   {
-    int ret = pipe(sigchld_pipe);
+    int ret = pipe2(sigchld_pipe, O_CLOEXEC);
     if (ret == -1)
     {
       cerr << "*** ERROR: Could not set up SIGCHLD pipe for Async::Exec: "
@@ -239,12 +245,31 @@ void Exec::setTimeout(int time_s)
 } /* Exec::setTimeout */
 
 
+void Exec::setStdoutFile(const std::string &path, bool append)
+{
+  stdout_file = path;
+  stdout_append = append;
+} /* Exec::setStdoutFile */
+
+
+void Exec::setStderrFile(const std::string &path, bool append)
+{
+  stderr_file = path;
+  stderr_append = append;
+} /* Exec::setStderrFile */
+
+
 bool Exec::run(void)
 {
+    // All pipes are created with the close-on-exec flag set so that no pipe
+    // end is leaked into this or any other subprocess. The dup2 file actions
+    // below clear the flag on the stdin, stdout and stderr copies.
+  int in_filedes[2] = {-1, -1};
+  int out_filedes[2] = {-1, -1};
+  int err_filedes[2] = {-1, -1};
+
     // Create pipe file descriptor pair for handling stdin to subprocess
-  int in_filedes[2];
-  int ret = pipe(in_filedes);
-  if (ret == -1)
+  if (pipe2(in_filedes, O_CLOEXEC) == -1)
   {
     cerr << "*** ERROR: Could not set up stdin pipe for subprocess "
          << args[0] << ": " << strerror(errno) << endl;
@@ -252,97 +277,124 @@ bool Exec::run(void)
   }
 
     // Create pipe file descriptor pair for handling stdout from subprocess
-  int out_filedes[2];
-  ret = pipe(out_filedes);
-  if (ret == -1)
+  if (stdout_file.empty() && (pipe2(out_filedes, O_CLOEXEC) == -1))
   {
     cerr << "*** ERROR: Could not set up stdout pipe for subprocess "
          << args[0] << ": " << strerror(errno) << endl;
+    closePipe(in_filedes);
     return false;
   }
 
     // Create pipe file descriptor pair for handling stderr from subprocess
-  int err_filedes[2];
-  ret = pipe(err_filedes);
-  if (ret == -1)
+  if (stderr_file.empty() && (pipe2(err_filedes, O_CLOEXEC) == -1))
   {
     cerr << "*** ERROR: Could not set up stderr pipe for subprocess "
          << args[0] << ": " << strerror(errno) << endl;
+    closePipe(in_filedes);
+    closePipe(out_filedes);
     return false;
   }
 
-  pid = fork();
-  if (pid == -1)
+    // Describe how stdin, stdout and stderr should be set up in the child.
+    // An output file is opened by the child so that the data is written
+    // directly to the file without passing through this process.
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, in_filedes[0], STDIN_FILENO);
+  if (stdout_file.empty())
   {
-    cerr << "*** ERROR: The fork system call failed for subprocess "
-         << args[0] << ": " << strerror(errno) << endl;
-    return false;
+    posix_spawn_file_actions_adddup2(&actions, out_filedes[1], STDOUT_FILENO);
   }
-
-    // If pid is non-zero we're in the parent process
-  if (pid != 0)
+  else
   {
-      // Set up priority for child if specified
-    if (nice_value != 0)
-    {
-      nice(0);
-    }
+    int flags = O_WRONLY | O_CREAT | (stdout_append ? O_APPEND : O_TRUNC);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO,
+                                     stdout_file.c_str(), flags, 0644);
+  }
+  if (stderr_file.empty())
+  {
+    posix_spawn_file_actions_adddup2(&actions, err_filedes[1], STDERR_FILENO);
+  }
+  else
+  {
+    int flags = O_WRONLY | O_CREAT | (stderr_append ? O_APPEND : O_TRUNC);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO,
+                                     stderr_file.c_str(), flags, 0644);
+  }
 
-      // Add the new child to the global map
-    execs[pid] = this;
+  vector<char*> argv;
+  for (size_t i=0; i<args.size(); ++i)
+  {
+    argv.push_back(const_cast<char*>(args[i].c_str()));
+  }
+  argv.push_back(0);
 
-      // Set up handling for subprocess stdin
-    close(in_filedes[0]);
-    stdin_fd = in_filedes[1];
+    // posix_spawn does not copy the page tables of this process, like fork
+    // does, so starting a subprocess does not stall a large process.
+  int ret = posix_spawn(&pid, argv[0], &actions, 0, &argv[0], environ);
+  posix_spawn_file_actions_destroy(&actions);
 
-      // Set up handling for subprocess stdout
+    // The child ends of the pipes are not needed in this process
+  close(in_filedes[0]);
+  if (out_filedes[1] != -1)
+  {
     close(out_filedes[1]);
-    stdout_watch = new FdWatch(out_filedes[0], FdWatch::FD_WATCH_RD);
-    stdout_watch->activity.connect(mem_fun(*this, &Exec::stdoutActivity));
-
-      // Set up handling for subprocess stderr
+  }
+  if (err_filedes[1] != -1)
+  {
     close(err_filedes[1]);
-    stderr_watch = new FdWatch(err_filedes[0], FdWatch::FD_WATCH_RD);
-    stderr_watch->activity.connect(mem_fun(*this, &Exec::stderrActivity));
+  }
 
-    if (timeout_timer != 0)
+  if (ret != 0)
+  {
+    cerr << "*** ERROR: Failed to exec " << args[0]
+         << ": " << strerror(ret) << endl;
+    pid = -1;
+    close(in_filedes[1]);
+    if (out_filedes[0] != -1)
     {
-      timeout_timer->setEnable(true);
+      close(out_filedes[0]);
     }
-
+    if (err_filedes[0] != -1)
+    {
+      close(err_filedes[0]);
+    }
+    Application::app().runTask(mem_fun(*this, &Exec::spawnFailed));
     return true;
   }
 
-  /* From this point we are in the child process */
+    // Set up priority for child if specified
+  if (nice_value != 0)
+  {
+    nice(0);
+  }
 
-    // Set up stdin pipe
-  close(in_filedes[1]);
-  dup2(in_filedes[0], STDIN_FILENO);
-  close(in_filedes[0]);
+    // Add the new child to the global map
+  execs[pid] = this;
 
-    // Set up stdout pipe
-  close(out_filedes[0]);
-  dup2(out_filedes[1], STDOUT_FILENO);
-  close(out_filedes[1]);
+    // Set up handling for subprocess stdin
+  stdin_fd = in_filedes[1];
 
-    // Set up stderr pipe
-  close(err_filedes[0]);
-  dup2(err_filedes[1], STDERR_FILENO);
-  close(err_filedes[1]);
+    // Set up handling for subprocess stdout
+  if (out_filedes[0] != -1)
+  {
+    stdout_watch = new FdWatch(out_filedes[0], FdWatch::FD_WATCH_RD);
+    stdout_watch->activity.connect(mem_fun(*this, &Exec::stdoutActivity));
+  }
 
-  char *cmd[args.size()+1];
-  for (size_t i=0; i<args.size(); ++i)
+    // Set up handling for subprocess stderr
+  if (err_filedes[0] != -1)
   {
-    cmd[i] = strdup(args[i].c_str());
+    stderr_watch = new FdWatch(err_filedes[0], FdWatch::FD_WATCH_RD);
+    stderr_watch->activity.connect(mem_fun(*this, &Exec::stderrActivity));
   }
-  cmd[args.size()] = 0;
-  ret = execv(cmd[0], cmd);
-  assert (ret == -1);
 
-  cerr << "*** ERROR: Failed to exec " << args[0]
-       << ": " << strerror(errno) << endl;
+  if (timeout_timer != 0)
+  {
+    timeout_timer->setEnable(true);
+  }
 
-  exit(255);
+  return true;
 } /* Exec::run */
 
 
@@ -388,7 +440,13 @@ bool Exec::kill(int sig)
 
 bool Exec::closeStdin(void)
 {
-  return (close(stdin_fd) == 0);
+  if (stdin_fd == -1)
+  {
+    return false;
+  }
+  int ret = close(stdin_fd);
+  stdin_fd = -1;
+  return (ret == 0);
 } /* Exec::closeStdin */
 
 
@@ -433,7 +491,7 @@ int Exec::termSig(void) const
 
 void Exec::stdoutActivity(Async::FdWatch *w)
 {
-  char buf[4096];
+  char buf[16384];
   int cnt = read(w->fd(), buf, sizeof(buf)-1);
   if (cnt < 0)
   {
@@ -454,7 +512,7 @@ void Exec::stdoutActivity(Async::FdWatch *w)
 
 void Exec::stderrActivity(Async::FdWatch *w)
 {
-  char buf[4096];
+  char buf[16384];
   int cnt = read(w->fd(), buf, sizeof(buf)-1);
   if (cnt < 0)
   {
@@ -503,6 +561,15 @@ void Exec::subprocessExited(void)
 } /* Exec::subprocessExited */
 
 
+void Exec::spawnFailed(void)
+{
+    // Report the same status as when a command fail to execute in a forked
+    // child, an exit code of 255
+  status = 255 << 8;
+  subprocessExited();
+} /* Exec::spawnFailed */
+
+
 void Exec::handleTimeout(void)
 {
   if (!pending_term)
@@ -565,6 +632,26 @@ void Exec::sigchldReceived(void)
 
 
 
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static void closePipe(int filedes[2])
+{
+  for (int i=0; i<2; ++i)
+  {
+    if (filedes[i] != -1)
+    {
+      close(filedes[i]);
+      filedes[i] = -1;
+    }
+  }
+} /* closePipe */
+
+
+
 /*
  * This file has not been truncated
  */
@@ -187,16 +187,42 @@ class Exec : public sigc::trackable
      */
     void setTimeout(int time_s);
 
+    /**
+     * @brief   Write the stdout of the subprocess directly to a file
+     * @param   path    The file to write to
+     * @param   append  Set to \em true to append to an existing file
+     *
+     * Use this function before calling run when the output of the subprocess
+     * only should be stored. The file is opened by the subprocess itself so
+     * the data never pass through this process. The stdoutData and
+     * stdoutClosed signals are not emitted when a file is used. An empty path
+     * restore the default behaviour.
+     */
+    void setStdoutFile(const std::string &path, bool append=false);
+
+    /**
+     * @brief   Write the stderr of the subprocess directly to a file
+     * @param   path    The file to write to
+     * @param   append  Set to \em true to append to an existing file
+     *
+     * The same as setStdoutFile but for stderr. The stderrData and
+     * stderrClosed signals are not emitted when a file is used.
+     */
+    void setStderrFile(const std::string &path, bool append=false);
+
     /**
      * @brief   Run the command
      * @returns Returns \em true on success or \em false otherwise
      *
      * This method is used to run the command specified using the constructor,
-     * setCommandLine and appendArgument. This function will return success as
-     * long as the fork call succeeds. If the command cannot be run for some
-     * reason, this function will still return success. Errors that occurr
-     * after the fork call will be handled through the "exited" signal. If the
-     * command cannot run for some reason, the exit code will be 255.
+     * setCommandLine and appendArgument. The subprocess is started using
+     * posix_spawn so the memory of this process is not copied. The command
+     * must be given with a full path since no search in PATH is done. This
+     * function return \em false if the pipes to the subprocess cannot be
+     * created. If the command cannot be run for some reason, an error is
+     * printed and this function will still return success. The "exited"
+     * signal is then emitted from the main loop with the exit code set
+     * to 255.
      */
     bool run(void);
 
@@ -330,6 +356,10 @@ class Exec : public sigc::trackable
     int                       nice_value;
     Async::Timer              *timeout_timer;
     bool                      pending_term;
+    std::string               stdout_file;
+    bool                      stdout_append;
+    std::string               stderr_file;
+    bool                      stderr_append;
 
     static void handleSigChld(int signal_number, siginfo_t *info,
                               void *context);
@@ -340,6 +370,7 @@ class Exec : public sigc::trackable
     void stdoutActivity(Async::FdWatch *w);
     void stderrActivity(Async::FdWatch *w);
     void subprocessExited(void);
+    void spawnFailed(void);
     void handleTimeout(void);
     
 };  /* class Exec */
@@ -114,15 +114,15 @@ using namespace Async;
  ****************************************************************************/
 
 FdWatch::FdWatch(void)
-  : m_fd(-1), m_type(FD_WATCH_RD), m_enabled(false)
+  : m_fd(-1), m_type(FD_WATCH_RD), m_enabled(false), m_app(0)
 {
 } /* FdWatch::FdWatch */
 
 
 FdWatch::FdWatch(int fd, FdWatchType type)
-  : m_fd(fd), m_type(type), m_enabled(true)
+  : m_fd(fd), m_type(type), m_enabled(true), m_app(0)
 {
-  Application::app().addFdWatch(this);
+  app().addFdWatch(this);
 } /* FdWatch::FdWatch */
 
 
@@ -130,7 +130,7 @@ FdWatch::~FdWatch(void)
 {
   if (m_enabled)
   {
-    Application::app().delFdWatch(this);
+    app().delFdWatch(this);
   }
 } /* FdWatch::~FdWatch */
 
@@ -140,12 +140,12 @@ void FdWatch::setEnabled(bool enabled)
   if (!m_enabled && enabled)
   {
     assert(m_fd >= 0);
-    Application::app().addFdWatch(this);
+    app().addFdWatch(this);
     m_enabled = enabled;
   }
   else if (m_enabled && !enabled)
   {
-    Application::app().delFdWatch(this);
+    app().delFdWatch(this);
     m_enabled = enabled;
   }
 } /* FdWatch::setEnabled */
@@ -176,6 +176,17 @@ void FdWatch::setFd(int fd, FdWatchType type)
  *
  ****************************************************************************/
 
+Application &FdWatch::app(void)
+{
+    // The watch belong to the event loop it was first added to
+  if (m_app == 0)
+  {
+    m_app = &Application::app();
+  }
+  return *m_app;
+} /* FdWatch::app */
+
+
 
 
 /*
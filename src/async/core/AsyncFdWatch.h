@@ -44,6 +44,8 @@ An example of how to use the  Async::FdWatch class
 
 #include <sigc++/sigc++.h>
 
+#include <string>
+
 
 /****************************************************************************
  *
@@ -78,6 +80,9 @@ An example of how to use the  Async::FdWatch class
 namespace Async
 {
 
+class Application;
+
+
 /****************************************************************************
  *
  * Defines & typedefs
@@ -188,6 +193,22 @@ class FdWatch : public sigc::trackable
      */
     void setFd(int fd, FdWatchType type);
 
+    /**
+     * @brief Set a label used to identify the watch in statistics
+     * @param label The label to set
+     *
+     * The label is used when the event loop collects statistics about how
+     * long callbacks take to run. Watches that have the same label are
+     * counted together.
+     */
+    void setLabel(const std::string& label) { m_label = label; }
+
+    /**
+     * @brief Return the label of this watch
+     * @return Returns the label set using setLabel
+     */
+    const std::string& label(void) const { return m_label; }
+
     /**
      * @brief Signal to indicate that the descriptor is active
      * @param watch Pointer to the watch object
@@ -201,6 +222,10 @@ class FdWatch : public sigc::trackable
     int       	m_fd;
     FdWatchType m_type;
     bool      	m_enabled;
+    Application *m_app;
+    std::string m_label;
+
+    Application &app(void);
   
 };  /* class FdWatch */
 
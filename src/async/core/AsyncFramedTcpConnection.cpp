@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <cstring>
 #include <cerrno>
+#include <cassert>
 
 
 /****************************************************************************
@@ -79,6 +80,22 @@ using namespace Async;
  *
  ****************************************************************************/
 
+/*
+ * The free list of frames for one thread. The frames are deleted when the
+ * thread exit.
+ */
+class FramedTcpConnection::Frame::Pool : public std::vector<Frame*>
+{
+  public:
+    ~Pool(void)
+    {
+      for (iterator it=begin(); it!=end(); ++it)
+      {
+        delete *it;
+      }
+    }
+};
+
 
 
 /****************************************************************************
@@ -104,6 +121,8 @@ using namespace Async;
  *
  ****************************************************************************/
 
+thread_local FramedTcpConnection::Frame::Pool FramedTcpConnection::Frame::pool;
+
 
 
 /****************************************************************************
@@ -112,10 +131,61 @@ using namespace Async;
  *
  ****************************************************************************/
 
+FramedTcpConnection::Frame*
+FramedTcpConnection::Frame::create(const void *buf, uint32_t count)
+{
+  Frame *frame = 0;
+  if (!pool.empty())
+  {
+    frame = pool.back();
+    pool.pop_back();
+  }
+  else
+  {
+    frame = new Frame;
+  }
+
+  frame->m_size = HEADER_SIZE + count;
+  if (frame->m_buf.size() < frame->m_size)
+  {
+    frame->m_buf.resize(frame->m_size);
+  }
+  char *ptr = &frame->m_buf[0];
+  *ptr++ = count >> 24;
+  *ptr++ = (count >> 16) & 0xff;
+  *ptr++ = (count >> 8) & 0xff;
+  *ptr++ = count & 0xff;
+  if (count > 0)
+  {
+    std::memcpy(ptr, buf, count);
+  }
+  frame->m_refcnt = 1;
+  return frame;
+} /* FramedTcpConnection::Frame::create */
+
+
+void FramedTcpConnection::Frame::unref(void)
+{
+  assert(m_refcnt > 0);
+  if (--m_refcnt > 0)
+  {
+    return;
+  }
+  if ((pool.size() < MAX_POOL_SIZE) && (m_buf.size() <= MAX_POOLED_CAPACITY))
+  {
+    pool.push_back(this);
+  }
+  else
+  {
+    delete this;
+  }
+} /* FramedTcpConnection::Frame::unref */
+
+
 FramedTcpConnection::FramedTcpConnection(size_t recv_buf_len)
-  : TcpConnection(recv_buf_len), m_max_frame_size(DEFAULT_MAX_FRAME_SIZE),
-    m_size_received(false)
+  : TcpConnection(recv_buf_len), m_max_frame_size(DEFAULT_MAX_FRAME_SIZE)
 {
+  setMaxFrameSize(DEFAULT_MAX_FRAME_SIZE);
   TcpConnection::sendBufferFull.connect(
       sigc::mem_fun(*this, &FramedTcpConnection::onSendBufferFull));
 } /* FramedTcpConnection::FramedTcpConnection */
@@ -125,13 +195,17 @@ FramedTcpConnection::FramedTcpConnection(
     int sock, const IpAddress& remote_addr, uint16_t remote_port,
     size_t recv_buf_len)
   : TcpConnection(sock, remote_addr, remote_port, recv_buf_len),
-    m_max_frame_size(DEFAULT_MAX_FRAME_SIZE), m_size_received(false)
+    m_max_frame_size(DEFAULT_MAX_FRAME_SIZE)
 {
+  setMaxFrameSize(DEFAULT_MAX_FRAME_SIZE);
+  TcpConnection::sendBufferFull.connect(
+      sigc::mem_fun(*this, &FramedTcpConnection::onSendBufferFull));
 } /* FramedTcpConnection::FramedTcpConnection */
 
 
 FramedTcpConnection::~FramedTcpConnection(void)
 {
+  disconnectCleanup();
 } /* FramedTcpConnection::~FramedTcpConnection */
 
 
@@ -156,36 +230,42 @@ int FramedTcpConnection::write(const void *buf, int count)
     return -1;
   }
 
-  QueueItem *qi = new QueueItem(buf, count);
+  Frame *frame = Frame::create(buf, count);
+  int ret = write(frame);
+  frame->unref();
+  return ret;
+} /* FramedTcpConnection::write */
+
+
+int FramedTcpConnection::write(Frame *frame)
+{
+  if (frame->payloadSize() > m_max_frame_size)
+  {
+    errno = EMSGSIZE;
+    return -1;
+  }
+
+  size_t pos = 0;
   if (m_txq.empty())
   {
-    int ret = TcpConnection::write(qi->m_buf, qi->m_size);
-    //cout << "###   count=" << (qi->m_size-qi->m_pos) << " ret=" << ret << endl;
+    int ret = TcpConnection::write(frame->data(), frame->size());
+    //cout << "###   count=" << frame->size() << " ret=" << ret << endl;
     if (ret < 0)
     {
-      delete qi;
-      qi = 0;
       return -1;
     }
-    if (ret >= qi->m_size)
-    {
-      delete qi;
-      qi = 0;
-    }
-    else
-    {
-      //cout << "### Not all bytes were sent: count=" << count
-      //     << " ret=" << ret << endl;
-      qi->m_pos += ret;
-    }
+    pos = ret;
   }
 
-  if (qi != 0)
+  if (pos < frame->size())
   {
-    m_txq.push_back(qi);
+    //cout << "### Not all bytes were sent: count=" << frame->size()
+    //     << " pos=" << pos << endl;
+    frame->ref();
+    m_txq.push_back(QueueItem(frame, pos));
   }
 
-  return count;
+  return frame->payloadSize();
 } /* FramedTcpConnection::write */
 
 
@@ -209,42 +289,38 @@ int FramedTcpConnection::onDataReceived(void *buf, int count)
   int orig_count = count;
   uint8_t* ptr = reinterpret_cast<uint8_t*>(buf);
 
-  while (count > 0)
+  while (static_cast<size_t>(count) >= sizeof(uint32_t))
   {
-    if (!m_size_received)
+    uint32_t frame_size = static_cast<uint32_t>(ptr[0]) << 24;
+    frame_size |= static_cast<uint32_t>(ptr[1]) << 16;
+    frame_size |= static_cast<uint32_t>(ptr[2]) << 8;
+    frame_size |= static_cast<uint32_t>(ptr[3]);
+    if (frame_size > m_max_frame_size)
     {
-      if (static_cast<size_t>(count) < sizeof(m_frame_size))
-      {
-        break;
-      }
-      m_frame_size = static_cast<uint32_t>(*ptr++) << 24;
-      m_frame_size |= static_cast<uint32_t>(*ptr++) << 16;
-      m_frame_size |= static_cast<uint32_t>(*ptr++) << 8;
-      m_frame_size |= static_cast<uint32_t>(*ptr++);
-      if (m_frame_size > m_max_frame_size)
-      {
-        disconnect();
-        disconnected(this, DR_PROTOCOL_ERROR);
-        return orig_count - count;
-      }
-      m_frame.clear();
-      m_frame.reserve(m_frame_size);
-      count -= sizeof(m_frame_size);
-      m_size_received = true;
+      disconnect();
+      disconnected(this, DR_PROTOCOL_ERROR);
+      return orig_count - count;
+    }
+
+      // Leave a partly received frame in the receive buffer. It is parsed
+      // in place when the rest of it has arrived.
+    if (static_cast<size_t>(count) - sizeof(uint32_t) < frame_size)
+    {
+      break;
+    }
+    ptr += sizeof(uint32_t);
+    count -= sizeof(uint32_t) + frame_size;
+    uint8_t* frame = ptr;
+    ptr += frame_size;
+
+    if (m_frame_handler.isSet())
+    {
+      m_frame_handler(this, DataView(frame, frame_size));
     }
     else
     {
-      size_t cur_size = m_frame.size();
-      size_t copy_cnt = min(m_frame_size - cur_size, static_cast<size_t>(count));
-      m_frame.resize(cur_size + copy_cnt);
-      ::memcpy(m_frame.data()+cur_size, ptr, copy_cnt);
-      count -= copy_cnt;
-      ptr += copy_cnt;
-      if (m_frame.size() == m_frame_size)
-      {
-        frameReceived(this, m_frame);
-        m_size_received = false;
-      }
+      m_frame.assign(frame, frame + frame_size);
+      frameReceived(this, m_frame);
     }
   }
 
@@ -266,21 +342,46 @@ void FramedTcpConnection::onSendBufferFull(bool is_full)
   {
     while (!m_txq.empty())
     {
-      QueueItem *qi = m_txq.front();
-      int ret = TcpConnection::write(qi->m_buf+qi->m_pos, qi->m_size-qi->m_pos);
-      //cout << "###   count=" << (qi->m_size-qi->m_pos) << " ret=" << ret << endl;
+        // Gather as many queued frames as possible into one system call
+      struct iovec iov[MAX_WRITEV_FRAMES];
+      int iovcnt = 0;
+      size_t count = 0;
+      for (TxQueue::const_iterator it = m_txq.begin();
+           (it != m_txq.end()) && (iovcnt < MAX_WRITEV_FRAMES); ++it)
+      {
+        const QueueItem& qi = *it;
+        iov[iovcnt].iov_base = const_cast<char*>(qi.m_frame->data()) + qi.m_pos;
+        iov[iovcnt].iov_len = qi.m_frame->size() - qi.m_pos;
+        count += iov[iovcnt].iov_len;
+        ++iovcnt;
+      }
+
+      int ret = TcpConnection::writev(iov, iovcnt);
+      //cout << "###   count=" << count << " ret=" << ret << endl;
       if (ret <= 0)
       {
         return;
       }
-      qi->m_pos += ret;
-      if (qi->m_pos < qi->m_size)
+
+      size_t written = ret;
+      while (written > 0)
+      {
+        QueueItem& qi = m_txq.front();
+        size_t left = qi.m_frame->size() - qi.m_pos;
+        if (written < left)
+        {
+          qi.m_pos += written;
+          break;
+        }
+        written -= left;
+        qi.m_frame->unref();
+        m_txq.pop_front();
+      }
+
+      if (static_cast<size_t>(ret) < count)
       {
         break;
       }
-      m_txq.pop_front();
-      delete qi;
-      qi = 0;
     }
   }
 } /* FramedTcpConnection::onSendBufferFull */
@@ -290,7 +391,7 @@ void FramedTcpConnection::disconnectCleanup(void)
 {
   for (TxQueue::iterator it = m_txq.begin(); it != m_txq.end(); ++it)
   {
-    delete *it;
+    (*it).m_frame->unref();
   }
   m_txq.clear();
 } /* FramedTcpConnection::disconnectCleanup */
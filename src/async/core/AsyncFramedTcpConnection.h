@@ -6,7 +6,7 @@
 
 \verbatim
 Async - A library for programming event driven applications
-Copyright (C) 2003-2017 Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -56,6 +56,7 @@ An example of how to use the FramedTcpConnection class in a server
  ****************************************************************************/
 
 #include <AsyncTcpConnection.h>
+#include <AsyncMemPool.h>
 
 
 /****************************************************************************
@@ -131,6 +132,79 @@ that only want to see completely transfered messages at the other end.
 class FramedTcpConnection : public TcpConnection
 {
   public:
+    /**
+     * @brief   A reference counted, immutable frame buffer
+     *
+     * A frame contain the frame header and the payload, ready to be sent on
+     * the wire. The same frame can be queued on many connections at the same
+     * time which is useful when broadcasting a message, since the payload
+     * only have to be copied once. Frames are allocated from a free list so
+     * normally no heap allocation is needed when a frame is created.
+     *
+     * Each thread has a free list of its own, so connections may be used in
+     * many threads. The reference count is not thread safe though, so a
+     * frame must only be used by the thread that created it.
+     */
+    class Frame
+    {
+      public:
+        /**
+         * @brief   Create a new frame with a reference count of one
+         * @param   buf   The payload
+         * @param   count The number of bytes in the payload
+         * @return  Returns a pointer to the new frame
+         */
+        static Frame *create(const void *buf, uint32_t count);
+
+        /**
+         * @brief   Add a reference to the frame
+         */
+        void ref(void) { ++m_refcnt; }
+
+        /**
+         * @brief   Remove a reference to the frame
+         *
+         * The frame is returned to the free list when the last reference is
+         * removed.
+         */
+        void unref(void);
+
+        /**
+         * @brief   Get the raw frame data, including the frame header
+         * @return  Returns a pointer to the frame data
+         */
+        const char *data(void) const { return &m_buf[0]; }
+
+        /**
+         * @brief   Get the size of the frame, including the frame header
+         * @return  Returns the size of the frame in bytes
+         */
+        size_t size(void) const { return m_size; }
+
+        /**
+         * @brief   Get the size of the frame payload
+         * @return  Returns the size of the payload in bytes
+         */
+        uint32_t payloadSize(void) const { return m_size - HEADER_SIZE; }
+
+      private:
+        static const size_t HEADER_SIZE = 4;
+        static const size_t MAX_POOL_SIZE = 256;
+        static const size_t MAX_POOLED_CAPACITY = 65536;
+
+        class Pool;
+
+        static thread_local Pool pool;
+
+        std::vector<char> m_buf;
+        size_t            m_size;
+        unsigned          m_refcnt;
+
+        Frame(void) : m_size(0), m_refcnt(0) {}
+        Frame(const Frame&);
+        Frame& operator=(const Frame&);
+    };
+
     /**
      * @brief 	Constructor
      * @param 	recv_buf_len  The length of the receiver buffer to use
@@ -161,7 +235,11 @@ class FramedTcpConnection : public TcpConnection
      * number larger than this is received a disconnection is immediately
      * issued. The default maximum frame size is DEFAULT_MAX_FRAME_SIZE.
      */
-    void setMaxFrameSize(uint32_t frame_size) { m_max_frame_size = frame_size; }
+    void setMaxFrameSize(uint32_t frame_size)
+    {
+      m_max_frame_size = frame_size;
+      setMaxRecvBufLen(sizeof(uint32_t) + frame_size);
+    }
 
     /**
      * @brief 	Disconnect from the remote host
@@ -185,6 +263,43 @@ class FramedTcpConnection : public TcpConnection
      */
     virtual int write(const void *buf, int count);
 
+    /**
+     * @brief   Send a prepared frame to the remote host
+     * @param   frame The frame to send
+     * @return  Returns the payload size on success or -1 on failure
+     *
+     * The frame is not copied. A reference is added to the frame if it
+     * cannot be sent immediately so the caller still own its reference and
+     * may send the same frame on other connections.
+     */
+    int write(Frame *frame);
+
+    /**
+     * @brief   Set a direct handler for received frames
+     * @param   obj   The object to call the handler member function on
+     *
+     * Set a member function to call for each received frame instead of
+     * emitting the frameReceived signal. This avoid the overhead of the
+     * signal dispatch for connections with exactly one receiver. Frames are
+     * parsed in place in the receive buffer and handed to the handler
+     * without being copied. The frame view is not valid after the handler has
+     * returned. The receiver must call clearFrameHandler, or delete the
+     * connection, before it is destroyed.
+     *
+     * \code
+     * con->setFrameHandler<MyClass, &MyClass::onFrame>(this);
+     * \endcode
+     */
+    template <typename T, void (T::*Method)(FramedTcpConnection*, DataView)>
+    void setFrameHandler(T *obj) { m_frame_handler.set<T, Method>(obj); }
+
+    /**
+     * @brief   Remove the direct handler set using setFrameHandler
+     *
+     * After this call the frameReceived signal is emitted again.
+     */
+    void clearFrameHandler(void) { m_frame_handler.clear(); }
+
     /**
      * @brief 	A signal that is emitted when a connection has been terminated
      * @param 	con   	The connection object
@@ -199,6 +314,7 @@ class FramedTcpConnection : public TcpConnection
      * @param 	count The number of bytes in the buffer
      *
      * This signal is emitted when a frame has been received on this connection.
+     * It is not emitted when a handler has been set using setFrameHandler.
      */
     sigc::signal<void, FramedTcpConnection *,
                  std::vector<uint8_t>&> frameReceived;
@@ -235,32 +351,26 @@ class FramedTcpConnection : public TcpConnection
   private:
     static const uint32_t DEFAULT_MAX_FRAME_SIZE = 1024 * 1024; // 1MB
 
+    static const int MAX_WRITEV_FRAMES = 64;
+
     struct QueueItem
     {
-      char* m_buf;
-      int   m_size;
-      int   m_pos;
-
-      QueueItem(const void* buf, int count)
-        : m_buf(0), m_size(4+count), m_pos(0)
-      {
-        m_buf = new char[4+count];
-        char *ptr = m_buf;
-        *ptr++ = static_cast<uint32_t>(count) >> 24;
-        *ptr++ = (static_cast<uint32_t>(count) >> 16) & 0xff;
-        *ptr++ = (static_cast<uint32_t>(count) >> 8) & 0xff;
-        *ptr++ = (static_cast<uint32_t>(count)) & 0xff;
-        std::memcpy(ptr, buf, count);
-      }
-      ~QueueItem(void) { delete [] m_buf; }
+      Frame*  m_frame;
+      size_t  m_pos;
+
+      QueueItem(Frame *frame, size_t pos) : m_frame(frame), m_pos(pos) {}
     };
-    typedef std::deque<QueueItem*> TxQueue;
+    typedef std::deque<QueueItem, PoolAllocator<QueueItem> > TxQueue;
+    typedef DataHandler<void(FramedTcpConnection*, DataView)> FrameHandler;
 
     uint32_t              m_max_frame_size;
-    bool                  m_size_received;
-    uint32_t              m_frame_size;
     std::vector<uint8_t>  m_frame;
     TxQueue               m_txq;
+    FrameHandler          m_frame_handler;
+
+      // The raw data handler is not used since frames are parsed here
+    using TcpConnection::setDataHandler;
+    using TcpConnection::clearDataHandler;
 
     FramedTcpConnection(const FramedTcpConnection&);
     FramedTcpConnection& operator=(const FramedTcpConnection&);
@@ -30,10 +30,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+
 #include <cstring>
+#include <cstdio>
 #include <cerrno>
 #include <sstream>
+#include <iostream>
 #include <cassert>
+#include <cctype>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -114,7 +121,7 @@ using namespace Async;
 
 HttpServerConnection::HttpServerConnection(size_t recv_buf_len)
   : TcpConnection(recv_buf_len), m_state(STATE_DISCONNECTED),
-    m_chunked(false)
+    m_chunked(false), m_keep_alive(true)
 {
   TcpConnection::sendBufferFull.connect(
       sigc::mem_fun(*this, &HttpServerConnection::onSendBufferFull));
@@ -125,7 +132,7 @@ HttpServerConnection::HttpServerConnection(
     int sock, const IpAddress& remote_addr, uint16_t remote_port,
     size_t recv_buf_len)
   : TcpConnection(sock, remote_addr, remote_port, recv_buf_len),
-    m_state(STATE_EXPECT_START_LINE), m_chunked(false)
+    m_state(STATE_EXPECT_START_LINE), m_chunked(false), m_keep_alive(true)
 {
 } /* HttpServerConnection::HttpServerConnection */
 
@@ -186,26 +193,48 @@ void HttpServerConnection::disconnect(void)
 
 bool HttpServerConnection::write(const Response& res)
 {
+  unsigned code = res.code();
+  bool send_content = res.sendContent();
+  if ((code == 200) && etagMatches(res.etag()))
+  {
+    code = 304;
+    send_content = false;
+    m_chunked = false;
+  }
+
   std::ostringstream os;
-  os << "HTTP/1.1 " << res.code() << " " << codeToString(res.code()) << "\r\n";
+  os << "HTTP/1.1 " << code << " " << codeToString(code) << "\r\n";
   for (std::map<std::string, std::string>::const_iterator it=res.headers().begin();
        it!=res.headers().end(); ++it)
   {
+      // The length is given by the chunks and a 304 response have no content
+    if ((m_chunked || (code == 304)) &&
+        (strcasecmp((*it).first.c_str(), "Content-length") == 0))
+    {
+      continue;
+    }
     os << (*it).first << ": " << (*it).second << "\r\n";
   }
   if (m_chunked)
   {
     os << "Transfer-encoding: chunked\r\n";
   }
+  os << "Connection: " << (m_keep_alive ? "keep-alive" : "close") << "\r\n";
   os << "\r\n";
-  if (res.sendContent())
+  if (send_content)
   {
     os << res.content();
   }
   //std::cout << "### HttpServerConnection::write:" << std::endl;
   //std::cout << os.str() << std::endl;
-  int len = os.str().size();
-  return TcpConnection::write(os.str().c_str(), len) == len;
+  const std::string& str = os.str();
+  int len = str.size();
+  bool success = (TcpConnection::write(str.c_str(), len) == len);
+  if (!m_chunked)
+  {
+    responseDone();
+  }
+  return success;
 } /* HttpServerConnection::write */
 
 
@@ -216,13 +245,23 @@ bool HttpServerConnection::write(const char* buf, int len)
   int ret = -1;
   if (m_chunked)
   {
-    std::ostringstream os;
-    //os << hex << len << ";tg=240;talker=SM0SVX\r\n";
-    os << hex << len << "\r\n";
-    ret = TcpConnection::write(os.str().c_str(), os.str().size());
-    ret += TcpConnection::write(buf, len);
-    ret += TcpConnection::write("\r\n", 2);
-    len += os.str().size() + 2;
+      // Send the chunk header, data and trailer using one system call
+    char chunk_hdr[16];
+    int hdr_len = snprintf(chunk_hdr, sizeof(chunk_hdr), "%x\r\n", len);
+    struct iovec iov[3];
+    iov[0].iov_base = chunk_hdr;
+    iov[0].iov_len = hdr_len;
+    iov[1].iov_base = const_cast<char*>(buf);
+    iov[1].iov_len = len;
+    iov[2].iov_base = const_cast<char*>("\r\n");
+    iov[2].iov_len = 2;
+    ret = TcpConnection::writev(iov, 3);
+    bool last_chunk = (len == 0);
+    len += hdr_len + 2;
+    if (last_chunk)
+    {
+      responseDone();
+    }
   }
   else
   {
@@ -290,6 +329,15 @@ int HttpServerConnection::onDataReceived(void *buf, int count)
         data_pos += 2;
         handleHeader();
         m_row.clear();
+        if (m_state == STATE_REQ_COMPLETE)
+        {
+            // Handle the request before parsing the next, pipelined, one
+          handleRequest();
+          if (m_state == STATE_REQ_COMPLETE)
+          {
+            m_state = STATE_EXPECT_START_LINE;
+          }
+        }
       }
     }
     else
@@ -299,13 +347,6 @@ int HttpServerConnection::onDataReceived(void *buf, int count)
     }
   }
 
-  if (m_state == STATE_REQ_COMPLETE)
-  {
-    requestReceived(this, m_req);
-    m_req.clear();
-    m_state = STATE_EXPECT_START_LINE;
-  }
-
   return count;
 } /* HttpServerConnection::onDataReceived */
 
@@ -320,7 +361,7 @@ void HttpServerConnection::handleStartLine(void)
 {
   std::istringstream is(m_row);
   std::string protocol;
-  if (!(is >> m_req.method >> m_req.target >> protocol >> std::ws))
+  if (!(is >> m_req.method >> m_req.target >> protocol))
   {
     std::cerr << "*** ERROR: Could not parse HTTP header" << std::endl;
     disconnect();
@@ -338,7 +379,7 @@ void HttpServerConnection::handleStartLine(void)
   is.clear();
   is.str(protocol.substr(5));
   char dot;
-  if (!(is >> m_req.ver_major >> dot >> m_req.ver_minor >> std::ws) ||
+  if (!(is >> m_req.ver_major >> dot >> m_req.ver_minor) ||
       (dot != '.'))
   {
     std::cerr << "*** ERROR: Illegal protocol version specification \""
@@ -392,6 +433,78 @@ void HttpServerConnection::handleHeader(void)
 } /* HttpServerConnection::handleHeader */
 
 
+void HttpServerConnection::handleRequest(void)
+{
+  std::string connection(m_req.header("Connection"));
+  std::transform(connection.begin(), connection.end(), connection.begin(),
+                 ::tolower);
+  if ((m_req.ver_major > 1) || ((m_req.ver_major == 1) && (m_req.ver_minor >= 1)))
+  {
+    m_keep_alive = (connection.find("close") == std::string::npos);
+  }
+  else
+  {
+    m_keep_alive = (connection.find("keep-alive") != std::string::npos);
+  }
+  m_if_none_match = m_req.header("If-None-Match");
+
+  requestReceived(this, m_req);
+  m_req.clear();
+} /* HttpServerConnection::handleRequest */
+
+
+void HttpServerConnection::responseDone(void)
+{
+  m_chunked = false;
+  if (!m_keep_alive && !isIdle() && (m_state != STATE_CLOSING))
+  {
+      // Let the client close the connection when it has read the response.
+      // That way the normal disconnect handling will clean up.
+    m_state = STATE_CLOSING;
+    if (::shutdown(socket(), SHUT_WR) != 0)
+    {
+      std::cerr << "*** WARNING: HTTP connection shutdown failed: "
+                << std::strerror(errno) << std::endl;
+    }
+  }
+} /* HttpServerConnection::responseDone */
+
+
+bool HttpServerConnection::etagMatches(const std::string& etag) const
+{
+  if (etag.empty() || m_if_none_match.empty())
+  {
+    return false;
+  }
+
+  std::istringstream is(m_if_none_match);
+  std::string tag;
+  while (std::getline(is, tag, ','))
+  {
+    size_t begin = tag.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+    {
+      continue;
+    }
+    size_t end = tag.find_last_not_of(" \t");
+    tag = tag.substr(begin, end-begin+1);
+    if (tag == "*")
+    {
+      return true;
+    }
+    if (tag.compare(0, 2, "W/") == 0)
+    {
+      tag.erase(0, 2);
+    }
+    if (tag == "\"" + etag + "\"")
+    {
+      return true;
+    }
+  }
+  return false;
+} /* HttpServerConnection::etagMatches */
+
+
 void HttpServerConnection::onSendBufferFull(bool is_full)
 {
   cout << "### HttpServerConnection::onSendBufferFull: is_full="
@@ -438,6 +551,8 @@ const char* HttpServerConnection::codeToString(unsigned code)
   {
     case 200:
       return "OK";
+    case 304:
+      return "Not Modified";
     case 404:
       return "Not Found";
     case 406:
@@ -39,6 +39,7 @@ An example of how to use the HttpServerConnection class in a client
  ****************************************************************************/
 
 #include <stdint.h>
+#include <strings.h>
 #include <vector>
 #include <deque>
 #include <cstring>
@@ -120,6 +121,18 @@ namespace Async
 This class implement a VERY simple HTTP server side connection. It can be used
 together with the Async::TcpServer class to build a HTTP server.
 
+Persistent connections (keep-alive) are supported. A HTTP/1.1 connection is
+kept open after a response unless the client asked for it to be closed. A
+HTTP/1.0 connection is only kept open if the client asked for it. When a
+connection is to be closed, the sending direction is shut down after the
+response so that the client will close the connection.
+
+A response can be given an entity tag using Response::setETag. If the tag
+matches one given in the If-None-Match header of the request, a
+"304 Not Modified" response is sent instead, without any content. This can be
+used together with a cached response to avoid both rebuilding and resending
+content that has not changed.
+
 WARNING: This implementation is not suitable to be exposed to the public
 Internet. It contains a number of security flaws and probably also
 incompatibilities. Only use this class with known clients.
@@ -143,6 +156,24 @@ class HttpServerConnection : public TcpConnection
         clear();
       }
 
+      /**
+       * @brief   Get the value of a header
+       * @param   key The name of the header, matched case insensitively
+       * @return  Returns the header value or an empty string if not found
+       */
+      std::string header(const std::string& key) const
+      {
+        for (Headers::const_iterator it=headers.begin();
+             it!=headers.end(); ++it)
+        {
+          if (strcasecmp(it->first.c_str(), key.c_str()) == 0)
+          {
+            return it->second;
+          }
+        }
+        return "";
+      }
+
       void clear(void)
       {
         method.clear();
@@ -179,6 +210,22 @@ class HttpServerConnection : public TcpConnection
           setHeader("Content-length", m_content.size());
           setSendContent(true);
         }
+        const std::string& etag(void) const { return m_etag; }
+
+        /**
+         * @brief   Set the entity tag for the content
+         * @param   etag The tag, without the surrounding quotes
+         *
+         * The tag should change whenever the content change. If the tag
+         * match the If-None-Match header in the request, a 304 response
+         * without content will be sent instead of this response.
+         */
+        void setETag(const std::string& etag)
+        {
+          m_etag = etag;
+          setHeader("ETag", "\"" + etag + "\"");
+        }
+
         bool sendContent(void) const { return m_send_content; }
         void setSendContent(bool send_content)
         {
@@ -190,12 +237,14 @@ class HttpServerConnection : public TcpConnection
           m_code = 0;
           m_headers.clear();
           m_content.clear();
+          m_etag.clear();
         }
 
       private:
         unsigned    m_code;
         Headers     m_headers;
         std::string m_content;
+        std::string m_etag;
         bool        m_send_content;
     };
 
@@ -235,7 +284,9 @@ class HttpServerConnection : public TcpConnection
      *
      * Calling this function will enable data to be sent in chunks. The
      * "Transfer-encoding: chunked" will be set in the header and each call to
-     * write() will send a chunk.
+     * write() will send a chunk. Write a zero length chunk to finish the
+     * response. Chunked mode is then turned off again so that the next
+     * response on a persistent connection is sent normally.
      */
     void setChunked(void) { m_chunked = true; }
 
@@ -254,7 +305,7 @@ class HttpServerConnection : public TcpConnection
      *
      * If chunked mode has been set a chunked header and trailer will be added
      * to the data. If not in chunked mode, the raw buffer will be sent without
-     * modification.
+     * modification. In chunked mode, a zero length buffer finish the response.
      */
     virtual bool write(const char* buf, int len);
 
@@ -304,7 +355,7 @@ class HttpServerConnection : public TcpConnection
   private:
     enum State {
       STATE_DISCONNECTED, STATE_EXPECT_START_LINE, STATE_EXPECT_HEADER,
-      STATE_EXPECT_PAYLOAD, STATE_REQ_COMPLETE
+      STATE_EXPECT_PAYLOAD, STATE_REQ_COMPLETE, STATE_CLOSING
     };
     //struct QueueItem
     //{
@@ -332,11 +383,16 @@ class HttpServerConnection : public TcpConnection
     std::string             m_row;
     Request                 m_req;
     bool                    m_chunked;
+    bool                    m_keep_alive;
+    std::string             m_if_none_match;
 
     HttpServerConnection(const HttpServerConnection&);
     HttpServerConnection& operator=(const HttpServerConnection&);
     void handleStartLine(void);
     void handleHeader(void);
+    void handleRequest(void);
+    void responseDone(void);
+    bool etagMatches(const std::string& etag) const;
     void onSendBufferFull(bool is_full);
     void disconnectCleanup(void);
     const char* codeToString(unsigned code);
@@ -41,8 +41,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
-#include <cmath>
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 
 /****************************************************************************
@@ -136,7 +137,7 @@ using namespace Async;
  */
 IpAddress::IpAddress(void)
 {
-  m_addr.s_addr = INADDR_NONE;
+  clear();
 } /* IpAddress::IpAddress */
 
 
@@ -147,18 +148,54 @@ IpAddress::IpAddress(const string& addr)
 
 
 IpAddress::IpAddress(const Ip4Addr& addr)
-  : m_addr(addr)
 {
-  
+  setIp4(addr);
+} /* IpAddress::IpAddress */
+
+
+IpAddress::IpAddress(const Ip6Addr& addr)
+{
+  setIp6(addr);
 } /* IpAddress::IpAddress */
 
 
+IpAddress::Ip4Addr IpAddress::ip4Addr(void) const
+{
+  Ip4Addr addr;
+  if (m_family == AF_INET)
+  {
+    memcpy(&addr, reinterpret_cast<const uint8_t*>(m_addr) + 12,
+           sizeof(addr));
+  }
+  else
+  {
+    addr.s_addr = INADDR_NONE;
+  }
+  return addr;
+} /* IpAddress::ip4Addr */
+
+
+IpAddress::Ip6Addr IpAddress::ip6Addr(void) const
+{
+  Ip6Addr addr;
+  memcpy(&addr, m_addr, sizeof(addr));
+  return addr;
+} /* IpAddress::ip6Addr */
+
+
 bool IpAddress::isUnicast(void) const
 {
+  if (m_family == AF_INET6)
+  {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(m_addr);
+    return (bytes[0] != 0xff) && ((m_addr[0] != 0) || (m_addr[1] != 0));
+  }
+
+  uint32_t addr = ntohl(ip4Addr().s_addr);
   bool is_unicast;
-  is_unicast  = (ntohl(m_addr.s_addr) & 0x80000000) == 0x00000000;
-  is_unicast |= (ntohl(m_addr.s_addr) & 0xc0000000) == 0x80000000;
-  is_unicast |= (ntohl(m_addr.s_addr) & 0xe0000000) == 0xc0000000;
+  is_unicast  = (addr & 0x80000000) == 0x00000000;
+  is_unicast |= (addr & 0xc0000000) == 0x80000000;
+  is_unicast |= (addr & 0xe0000000) == 0xc0000000;
   
   return is_unicast;
   
@@ -174,9 +211,9 @@ bool IpAddress::isWithinSubet(const std::string& subnet) const
     return false;
   }
   
-  string ip_str(subnet.begin(), slash);
-  Ip4Addr ip;
-  if (inet_aton(ip_str.c_str(), &ip) == 0)  // Address is invalid
+  IpAddress ip;
+  if (!ip.setIpFromString(string(subnet.begin(), slash)) ||
+      (ip.m_family != m_family))
   {
     return false;
   }
@@ -185,31 +222,144 @@ bool IpAddress::isWithinSubet(const std::string& subnet) const
   {
     return false;
   }
-  string mask_str(slash, subnet.end());
-  uint32_t mask = 0xffffffff ^ ((uint32_t)pow(2.0, 32-atoi(mask_str.c_str())) - 1);
+  int prefix_len = atoi(string(slash, subnet.end()).c_str());
+  int max_len = (m_family == AF_INET) ? 32 : 128;
+  if ((prefix_len < 0) || (prefix_len > max_len))
+  {
+    return false;
+  }
+    // IPv4 addresses are stored in the last four bytes
+  prefix_len += 128 - max_len;
 
-  return (ntohl(m_addr.s_addr) & mask) == (ntohl(ip.s_addr) & mask);
+  const uint8_t *a = reinterpret_cast<const uint8_t*>(m_addr);
+  const uint8_t *b = reinterpret_cast<const uint8_t*>(ip.m_addr);
+  int i = 0;
+  for (; prefix_len >= 8; ++i, prefix_len -= 8)
+  {
+    if (a[i] != b[i])
+    {
+      return false;
+    }
+  }
+  if (prefix_len > 0)
+  {
+    uint8_t mask = 0xff << (8 - prefix_len);
+    return (a[i] & mask) == (b[i] & mask);
+  }
+  return true;
  
 } /* IpAddress::isWithinSubet */
 
 
+void IpAddress::clear(void)
+{
+  m_family = AF_UNSPEC;
+  m_addr[0] = m_addr[1] = 0;
+} /* IpAddress::clear */
+
+
 string IpAddress::toString(void) const
 {
-  return inet_ntoa(m_addr);
+  char buf[INET6_ADDRSTRLEN];
+  if (m_family == AF_INET)
+  {
+    Ip4Addr addr = ip4Addr();
+    return inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+  }
+  else if (m_family == AF_INET6)
+  {
+    return inet_ntop(AF_INET6, m_addr, buf, sizeof(buf));
+  }
+  return "255.255.255.255";
 } /* IpAddress::toString */
 
 
 bool IpAddress::setIpFromString(const string &str)
 {
-  if (inet_aton(str.c_str(), &m_addr) == 0)  // Address is invalid
+  Ip4Addr addr4;
+  Ip6Addr addr6;
+  if (inet_aton(str.c_str(), &addr4) != 0)
+  {
+    setIp4(addr4);
+  }
+  else if (inet_pton(AF_INET6, str.c_str(), &addr6) == 1)
   {
-    m_addr.s_addr = INADDR_NONE;
+    setIp6(addr6);
+  }
+  else  // Address is invalid
+  {
+    clear();
     return false;
   }
   return true;
 } /* IpAddress::setIpFromString */
 
 
+socklen_t IpAddress::toSockAddr(struct sockaddr_storage& addr, uint16_t port,
+                                int family) const
+{
+  if (family == AF_UNSPEC)
+  {
+    family = m_family;
+  }
+  memset(&addr, 0, sizeof(addr));
+  if ((family == AF_INET) && (m_family == AF_INET))
+  {
+    struct sockaddr_in& sin = reinterpret_cast<struct sockaddr_in&>(addr);
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    sin.sin_addr = ip4Addr();
+    return sizeof(sin);
+  }
+  else if ((family == AF_INET6) && !isEmpty())
+  {
+    struct sockaddr_in6& sin6 = reinterpret_cast<struct sockaddr_in6&>(addr);
+    sin6.sin6_family = AF_INET6;
+    sin6.sin6_port = htons(port);
+    sin6.sin6_addr = ip6Addr();
+    return sizeof(sin6);
+  }
+  return 0;
+} /* IpAddress::toSockAddr */
+
+
+bool IpAddress::setFromSockAddr(const struct sockaddr *addr, uint16_t *port)
+{
+  if (addr->sa_family == AF_INET)
+  {
+    const struct sockaddr_in *sin =
+      reinterpret_cast<const struct sockaddr_in*>(addr);
+    setIp4(sin->sin_addr);
+    if (port != 0)
+    {
+      *port = ntohs(sin->sin_port);
+    }
+    return true;
+  }
+  else if (addr->sa_family == AF_INET6)
+  {
+    const struct sockaddr_in6 *sin6 =
+      reinterpret_cast<const struct sockaddr_in6*>(addr);
+    setIp6(sin6->sin6_addr);
+    if (port != 0)
+    {
+      *port = ntohs(sin6->sin6_port);
+    }
+    return true;
+  }
+  clear();
+  return false;
+} /* IpAddress::setFromSockAddr */
+
+
+size_t IpAddress::hash(void) const
+{
+  uint64_t h = m_addr[0] * 0x9e3779b97f4a7c15ULL;
+  h ^= (m_addr[1] + m_family) * 0xc2b2ae3d27d4eb4fULL;
+  return static_cast<size_t>(h ^ (h >> 32));
+} /* IpAddress::hash */
+
+
 std::ostream& Async::operator<<(std::ostream& os, const Async::IpAddress& ip)
 {
   return os << ip.toString();
@@ -271,6 +421,26 @@ std::istream& Async::operator>>(std::istream& is, Async::IpAddress& ip)
  * Bugs:      
  *----------------------------------------------------------------------------
  */
+void IpAddress::setIp4(const Ip4Addr& addr)
+{
+  if (addr.s_addr == INADDR_NONE)
+  {
+    clear();
+    return;
+  }
+  uint8_t *bytes = reinterpret_cast<uint8_t*>(m_addr);
+  memset(bytes, 0, 10);
+  bytes[10] = bytes[11] = 0xff;
+  memcpy(bytes + 12, &addr, sizeof(addr));
+  m_family = AF_INET;
+} /* IpAddress::setIp4 */
+
+
+void IpAddress::setIp6(const Ip6Addr& addr)
+{
+  memcpy(m_addr, &addr, sizeof(addr));
+  m_family = IN6_IS_ADDR_V4MAPPED(&addr) ? AF_INET : AF_INET6;
+} /* IpAddress::setIp6 */
 
 
 
@@ -37,10 +37,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <sys/socket.h>
 #include <netinet/in.h>
+#include <stdint.h>
 
 #include <string>
 #include <iostream>
+#include <functional>
 
 
 /****************************************************************************
@@ -100,6 +103,12 @@ namespace Async
 
 /**
  * @brief A class for representing an IP address in an OS independent way.
+ *
+ * Both IPv4 and IPv6 addresses are supported. The address is stored as a
+ * 16 byte value plus the address family so that it is cheap to compare and
+ * hash. An IPv4-mapped IPv6 address (::ffff:a.b.c.d), like the ones reported
+ * by a dual-stack socket, is always stored as a plain IPv4 address so that
+ * the same host compare equal whichever socket type it was seen on.
  */
 class IpAddress
 {
@@ -109,6 +118,11 @@ class IpAddress
      */
     typedef struct in_addr Ip4Addr;
     
+    /**
+     * @brief The type for the OS specific representation of an IPv6 address
+     */
+    typedef struct in6_addr Ip6Addr;
+    
     /**
      * @brief Default constructor for the IpAddress class.
      */
@@ -126,6 +140,12 @@ class IpAddress
      */
     IpAddress(const Ip4Addr& addr);
     
+    /**
+     * @brief Constructor for the IpAddress class.
+     * @param addr The IPv6 address in OS specific representation
+     */
+    IpAddress(const Ip6Addr& addr);
+    
     /**
      * @brief Copy contructor
      * @param addr An IpAddress object to construct the new object from
@@ -139,9 +159,33 @@ class IpAddress
     
     /**
      * @brief Return the IP address in OS specific representation
-     * @return The IP address
+     * @return The IP address or INADDR_NONE if this is not an IPv4 address
+     */
+    Ip4Addr ip4Addr(void) const;
+    
+    /**
+     * @brief Return the IPv6 address in OS specific representation
+     * @return The IPv6 address. An IPv4 address is returned IPv4-mapped.
+     */
+    Ip6Addr ip6Addr(void) const;
+    
+    /**
+     * @brief   Get the address family
+     * @return  Returns AF_INET, AF_INET6 or AF_UNSPEC if empty
+     */
+    int family(void) const { return m_family; }
+    
+    /**
+     * @brief   Check if this is an IPv4 address
+     * @return  Returns \em true if this is an IPv4 address
+     */
+    bool isIpv4(void) const { return m_family == AF_INET; }
+    
+    /**
+     * @brief   Check if this is an IPv6 address
+     * @return  Returns \em true if this is an IPv6 address
      */
-    Ip4Addr ip4Addr(void) const { return m_addr; }
+    bool isIpv6(void) const { return m_family == AF_INET6; }
     
     /**
      * @brief 	Check if this is a unicast IP address
@@ -153,7 +197,8 @@ class IpAddress
     /**
      * @brief 	Check if the IP address is within the given netmask
      * @param 	subnet	The subnet to use in the check. The subnet should
-     *	      	      	be given on the form a.b.c.d/m (e.g. 192.168.1.0/24).
+     *	      	      	be given on the form a.b.c.d/m (e.g. 192.168.1.0/24)
+     *	      	      	or x:x::x/m (e.g. 2001:db8::/32).
      * @return	Return \em true if within the given subnet or \em false
      *	      	if it is not.
      */
@@ -164,12 +209,12 @@ class IpAddress
      * @return	Return \em true if this is an invalid address or \em false
      *		if a valid address has been assigned.
      */
-    bool isEmpty(void) const { return (m_addr.s_addr == INADDR_NONE); }
+    bool isEmpty(void) const { return (m_family == AF_UNSPEC); }
 
     /**
      * @brief	Invalidate the IP address value
      */    
-    void clear(void) { m_addr.s_addr = INADDR_NONE; }
+    void clear(void);
     
     /**
      * @brief 	Return the string representation of the IP address.
@@ -179,11 +224,41 @@ class IpAddress
     
     /**
      * @brief   Set the IP address from a string
-     * @param   str The string to parse (e.g. "192.168.0.1")
+     * @param   str The string to parse (e.g. "192.168.0.1" or "2001:db8::1")
      * @return  Returns \em true on success or else \em false
      */
     bool setIpFromString(const std::string &str);
 
+    /**
+     * @brief   Fill in a socket address structure
+     * @param   addr    The socket address structure to fill in
+     * @param   port    The port number to use
+     * @param   family  The address family of the socket the address is
+     *                  used with. Use AF_UNSPEC for the family of the address.
+     * @return  Returns the length of the socket address or 0 on failure
+     *
+     * An IPv4 address is given as an IPv4-mapped IPv6 address when the
+     * socket family is AF_INET6, like for a dual-stack socket. It is a
+     * failure to use an IPv6 address with an AF_INET socket.
+     */
+    socklen_t toSockAddr(struct sockaddr_storage& addr, uint16_t port,
+                         int family=AF_UNSPEC) const;
+
+    /**
+     * @brief   Set the IP address from a socket address structure
+     * @param   addr  The socket address (sockaddr_in or sockaddr_in6)
+     * @param   port  If not null, set to the port number of the address
+     * @return  Returns \em true on success or \em false if the family of
+     *          the socket address is not supported
+     */
+    bool setFromSockAddr(const struct sockaddr *addr, uint16_t *port=0);
+
+    /**
+     * @brief   Calculate a hash value for the address
+     * @return  Returns the hash value
+     */
+    size_t hash(void) const;
+
     /**
      * @brief 	Assignment operator.
      * @param 	rhs The address object to assign to this object
@@ -191,7 +266,9 @@ class IpAddress
      */
     IpAddress& operator=(const IpAddress& rhs)
     {
-      m_addr = rhs.m_addr;
+      m_family = rhs.m_family;
+      m_addr[0] = rhs.m_addr[0];
+      m_addr[1] = rhs.m_addr[1];
       return *this;
     }
     
@@ -203,7 +280,8 @@ class IpAddress
      */
     bool operator==(const IpAddress& rhs) const
     {
-      return m_addr.s_addr == rhs.m_addr.s_addr;
+      return (m_family == rhs.m_family) && (m_addr[0] == rhs.m_addr[0]) &&
+             (m_addr[1] == rhs.m_addr[1]);
     }
     
     /**
@@ -225,7 +303,15 @@ class IpAddress
      */
     bool operator<(const IpAddress& rhs) const
     {
-      return m_addr.s_addr < rhs.m_addr.s_addr;
+      if (m_family != rhs.m_family)
+      {
+        return m_family < rhs.m_family;
+      }
+      if (m_addr[0] != rhs.m_addr[0])
+      {
+        return m_addr[0] < rhs.m_addr[0];
+      }
+      return m_addr[1] < rhs.m_addr[1];
     }
     
     /**
@@ -247,7 +333,14 @@ class IpAddress
   protected:
     
   private:
-    Ip4Addr m_addr;
+      // The address bytes, in network byte order, stored in two words to
+      // make comparison and hashing cheap. IPv4 addresses are stored
+      // IPv4-mapped.
+    uint64_t  m_addr[2];
+    uint16_t  m_family;
+
+    void setIp4(const Ip4Addr& addr);
+    void setIp6(const Ip6Addr& addr);
   
 };  /* class IpAddress */
 
@@ -259,6 +352,19 @@ std::istream& operator>>(std::istream& is, IpAddress& ip);
 } /* namespace */
 
 
+namespace std
+{
+  /**
+   * @brief Hash support so that IpAddress can be used in unordered containers
+   */
+  template <>
+  struct hash<Async::IpAddress>
+  {
+    size_t operator()(const Async::IpAddress& ip) const { return ip.hash(); }
+  };
+} /* namespace std */
+
+
 #endif /* ASYNC_IP_ADDRESS_INCLUDED */
 
 
@@ -0,0 +1,213 @@
+/**
+@file	 AsyncMemArena.cpp
+@brief   A memory arena for short lived allocations
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <cassert>
+#include <new>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncMemArena.h"
+#include "AsyncMetrics.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+MemArena& MemArena::loopArena(void)
+{
+  static thread_local MemArena arena("loop");
+  return arena;
+} /* MemArena::loopArena */
+
+
+MemArena::MemArena(const string& name, size_t chunk_size)
+  : m_chunk_size(chunk_size), m_chunk(0), m_pos(0)
+{
+  m_heap_alloc_cnt = Metrics::instance().counter(
+      "async_memarena_heap_allocs_total",
+      "Number of heap allocations made to grow the memory arena",
+      Metric::Labels{{"arena", name}});
+} /* MemArena::MemArena */
+
+
+MemArena::~MemArena(void)
+{
+  for (vector<Chunk>::iterator it=m_chunks.begin(); it!=m_chunks.end(); ++it)
+  {
+    ::operator delete(it->buf);
+  }
+} /* MemArena::~MemArena */
+
+
+void *MemArena::alloc(size_t size, size_t align)
+{
+  assert((align > 0) && ((align & (align - 1)) == 0));
+
+  for (;;)
+  {
+      // Try the current chunk first and then the chunks after it. A chunk
+      // that is too small for the allocation is skipped.
+    while (m_chunk < m_chunks.size())
+    {
+      const Chunk& chunk = m_chunks[m_chunk];
+      const uintptr_t base = reinterpret_cast<uintptr_t>(chunk.buf);
+      const uintptr_t addr = (base + m_pos + align - 1) &
+                             ~static_cast<uintptr_t>(align - 1);
+      const size_t pos = addr - base;
+      if ((pos <= chunk.size) && (size <= chunk.size - pos))
+      {
+        m_pos = pos + size;
+        return chunk.buf + pos;
+      }
+      ++m_chunk;
+      m_pos = 0;
+    }
+
+      // No chunk could hold the allocation so a new one is added. It always
+      // have room for the allocation including the alignment padding.
+    Chunk chunk;
+    chunk.size = max(m_chunk_size, size + align);
+    chunk.buf = static_cast<char*>(::operator new(chunk.size));
+    m_chunks.push_back(chunk);
+    m_heap_alloc_cnt->inc();
+    m_chunk = m_chunks.size() - 1;
+    m_pos = 0;
+  }
+} /* MemArena::alloc */
+
+
+size_t MemArena::capacity(void) const
+{
+  size_t size = 0;
+  for (vector<Chunk>::const_iterator it=m_chunks.begin();
+       it!=m_chunks.end(); ++it)
+  {
+    size += it->size;
+  }
+  return size;
+} /* MemArena::capacity */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,268 @@
+/**
+@file	 AsyncMemArena.h
+@brief   A memory arena for short lived allocations
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This file contains a memory arena, a bump allocator where memory is freed all
+at once. It is used for scratch memory that only is needed while handling a
+single event in the main loop, like when packing a message that is to be
+sent. The memory chunks of the arena are kept when the arena is reset so an
+arena stop allocating from the heap when it has grown to the working set.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_MEM_ARENA_INCLUDED
+#define ASYNC_MEM_ARENA_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class MetricCounter;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A memory arena for short lived allocations
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+Memory is allocated from the arena by bumping a pointer in the current chunk.
+Nothing is freed individually. Instead, the arena is rolled back to an
+earlier position using a Mark or cleared using reset. Only memory for types
+that do not need to be destroyed, like plain buffers, should be allocated
+from an arena.
+
+Each thread has its own loop arena, returned by loopArena, that is used for
+scratch memory while handling an event in the main loop of that thread. A
+Mark should always be used so that the memory is released when the event
+handler return.
+
+The number of heap allocations made to grow an arena is published in the
+Metrics registry, labeled with the arena name.
+
+@code
+void MyClass::sendMsg(const Msg& msg)
+{
+  MemArena::Mark mark(MemArena::loopArena());
+  char *buf = mark.arena().allocArray<char>(msg.packedSize());
+  ...
+}
+@endcode
+*/
+class MemArena
+{
+  public:
+    /**
+     * @brief   Roll back the arena when going out of scope
+     *
+     * All memory allocated from the arena after the mark was created is
+     * released when the mark is destroyed. Marks must be destroyed in the
+     * reverse order of creation, which is what happens when they are
+     * created on the stack.
+     */
+    class Mark
+    {
+      public:
+        /**
+         * @brief   Constructor
+         * @param   arena The arena to mark the current position in
+         */
+        explicit Mark(MemArena& arena)
+          : m_arena(arena), m_chunk(arena.m_chunk), m_pos(arena.m_pos)
+        {
+        }
+
+        /**
+         * @brief   Destructor
+         */
+        ~Mark(void)
+        {
+          m_arena.m_chunk = m_chunk;
+          m_arena.m_pos = m_pos;
+        }
+
+        /**
+         * @brief   Get the marked arena
+         */
+        MemArena& arena(void) { return m_arena; }
+
+      private:
+        MemArena& m_arena;
+        size_t    m_chunk;
+        size_t    m_pos;
+
+        Mark(const Mark&);
+        Mark& operator=(const Mark&);
+    };
+
+    /**
+     * @brief   Get the loop arena of the calling thread
+     * @return  Returns the arena
+     */
+    static MemArena& loopArena(void);
+
+    /**
+     * @brief   Constructor
+     * @param   name        The name of the arena, used to label the metrics
+     * @param   chunk_size  The size of the chunks allocated from the heap
+     */
+    explicit MemArena(const std::string& name, size_t chunk_size=16384);
+
+    /**
+     * @brief   Destructor
+     */
+    ~MemArena(void);
+
+    /**
+     * @brief   Allocate memory from the arena
+     * @param   size  The number of bytes to allocate
+     * @param   align The alignment of the memory, must be a power of two
+     * @return  Returns a pointer to the memory
+     *
+     * An allocation that is larger than the chunk size get a chunk of its
+     * own. std::bad_alloc is thrown if the heap allocation fail.
+     */
+    void *alloc(size_t size, size_t align=alignof(std::max_align_t));
+
+    /**
+     * @brief   Allocate an array from the arena
+     * @param   n The number of elements
+     * @return  Returns a pointer to the uninitialized array
+     */
+    template <typename T>
+    T *allocArray(size_t n)
+    {
+      return static_cast<T*>(alloc(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief   Release all memory allocated from the arena
+     *
+     * The memory chunks are kept for later allocations.
+     */
+    void reset(void) { m_chunk = 0; m_pos = 0; }
+
+    /**
+     * @brief   Get the total size of the chunks in the arena
+     * @return  Returns the size in bytes
+     */
+    size_t capacity(void) const;
+
+  private:
+    struct Chunk
+    {
+      char*   buf;
+      size_t  size;
+    };
+
+    const size_t        m_chunk_size;
+    std::vector<Chunk>  m_chunks;
+    size_t              m_chunk;
+    size_t              m_pos;
+    MetricCounter*      m_heap_alloc_cnt;
+
+    MemArena(const MemArena&);
+    MemArena& operator=(const MemArena&);
+
+};  /* class MemArena */
+
+
+} /* namespace */
+
+#endif /* ASYNC_MEM_ARENA_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,316 @@
+/**
+@file	 AsyncMemPool.cpp
+@brief   Fixed size block memory pools
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <new>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncMemPool.h"
+#include "AsyncMetrics.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The block alignment. The blocks are also at least this big so that a
+  // free block can hold the free list pointer.
+#define BLOCK_ALIGN alignof(std::max_align_t)
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static size_t size_class_index(size_t size);
+static MemPool **create_size_classes(void);
+static MetricCounter *large_alloc_counter(void);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+void *MemPool::allocate(size_t size)
+{
+  MemPool *pool = forSize(size);
+  if (pool != 0)
+  {
+    return pool->alloc();
+  }
+  static MetricCounter *large_alloc_cnt = large_alloc_counter();
+  large_alloc_cnt->inc();
+  return ::operator new(size);
+} /* MemPool::allocate */
+
+
+void MemPool::deallocate(void *ptr, size_t size)
+{
+  MemPool *pool = forSize(size);
+  if (pool != 0)
+  {
+    pool->free(ptr);
+  }
+  else
+  {
+    ::operator delete(ptr);
+  }
+} /* MemPool::deallocate */
+
+
+MemPool *MemPool::forSize(size_t size)
+{
+  if (size > MAX_CLASS_SIZE)
+  {
+    return 0;
+  }
+
+    // The pools are never deleted since memory may be returned to them by
+    // other static objects being destroyed when the application exit
+  static MemPool **size_classes = create_size_classes();
+  return size_classes[size_class_index(size)];
+} /* MemPool::forSize */
+
+
+MemPool::MemPool(const string& name, size_t block_size, size_t chunk_size)
+  : m_name(name),
+    m_block_size((max(block_size, sizeof(FreeBlock)) + BLOCK_ALIGN - 1) /
+                 BLOCK_ALIGN * BLOCK_ALIGN),
+    m_blocks_per_chunk(max(chunk_size / m_block_size, size_t(1))),
+    m_free(0), m_in_use(0)
+{
+  const Metric::Labels labels{{"pool", m_name}};
+  m_alloc_cnt = Metrics::instance().counter("async_mempool_allocs_total",
+      "Number of blocks allocated from the memory pool", labels);
+  m_heap_alloc_cnt = Metrics::instance().counter(
+      "async_mempool_heap_allocs_total",
+      "Number of heap allocations made to grow the memory pool", labels);
+  m_in_use_gauge = Metrics::instance().gauge("async_mempool_blocks_in_use",
+      "Number of memory pool blocks currently in use", labels);
+} /* MemPool::MemPool */
+
+
+MemPool::~MemPool(void)
+{
+  m_in_use_gauge->add(-static_cast<double>(m_in_use));
+  for (vector<char*>::iterator it=m_chunks.begin(); it!=m_chunks.end(); ++it)
+  {
+    ::operator delete(*it);
+  }
+} /* MemPool::~MemPool */
+
+
+void *MemPool::alloc(void)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_free == 0)
+  {
+    grow();
+  }
+  FreeBlock *block = m_free;
+  m_free = block->next;
+  ++m_in_use;
+  m_alloc_cnt->inc();
+  m_in_use_gauge->add(1.0);
+  return block;
+} /* MemPool::alloc */
+
+
+void MemPool::free(void *ptr)
+{
+  if (ptr == 0)
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  assert(m_in_use > 0);
+  FreeBlock *block = static_cast<FreeBlock*>(ptr);
+  block->next = m_free;
+  m_free = block;
+  --m_in_use;
+  m_in_use_gauge->add(-1.0);
+} /* MemPool::free */
+
+
+size_t MemPool::blocksInUse(void) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_in_use;
+} /* MemPool::blocksInUse */
+
+
+size_t MemPool::capacity(void) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_chunks.size() * m_blocks_per_chunk;
+} /* MemPool::capacity */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void MemPool::grow(void)
+{
+  char *chunk = static_cast<char*>(
+      ::operator new(m_blocks_per_chunk * m_block_size));
+  m_chunks.push_back(chunk);
+  m_heap_alloc_cnt->inc();
+
+    // Put the new blocks on the free list so that they are handed out in
+    // address order
+  for (size_t i=m_blocks_per_chunk; i>0; --i)
+  {
+    FreeBlock *block = reinterpret_cast<FreeBlock*>(
+        chunk + (i - 1) * m_block_size);
+    block->next = m_free;
+    m_free = block;
+  }
+} /* MemPool::grow */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static size_t size_class_index(size_t size)
+{
+  size_t idx = 0;
+  for (size_t class_size=MemPool::MIN_CLASS_SIZE; class_size<size;
+       class_size<<=1)
+  {
+    ++idx;
+  }
+  return idx;
+} /* size_class_index */
+
+
+static MemPool **create_size_classes(void)
+{
+  const size_t class_cnt = size_class_index(MemPool::MAX_CLASS_SIZE) + 1;
+  MemPool **size_classes = new MemPool*[class_cnt];
+  size_t class_size = MemPool::MIN_CLASS_SIZE;
+  for (size_t idx=0; idx<class_cnt; ++idx)
+  {
+    size_classes[idx] = new MemPool(to_string(class_size), class_size);
+    class_size <<= 1;
+  }
+  return size_classes;
+} /* create_size_classes */
+
+
+static MetricCounter *large_alloc_counter(void)
+{
+  return Metrics::instance().counter("async_mempool_heap_allocs_total",
+      "Number of heap allocations made to grow the memory pool",
+      Metric::Labels{{"pool", "large"}});
+} /* large_alloc_counter */
+
+
+
+/*
+ * This file has not been truncated
+ */
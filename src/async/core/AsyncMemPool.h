@@ -0,0 +1,322 @@
+/**
+@file	 AsyncMemPool.h
+@brief   Fixed size block memory pools
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This file contains a pool allocator for fixed size memory blocks and an STL
+compatible allocator that use a set of process wide pools, one for each size
+class. Memory returned to a pool is kept in the pool and is reused for new
+allocations, so once the pools have grown to the working set of a running
+application, no more heap allocations are made. This avoid heap
+fragmentation in long running processes.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_MEM_POOL_INCLUDED
+#define ASYNC_MEM_POOL_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class MetricCounter;
+class MetricGauge;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A pool of fixed size memory blocks
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+A memory pool hand out blocks of a fixed size. The pool grow by allocating
+a chunk of blocks from the heap when it runs out of free blocks. Freed blocks
+are kept in the pool so the memory is never returned to the heap until the
+pool is destroyed. The blocks are aligned for any fundamental type.
+
+The static functions allocate and deallocate use a set of process wide pools
+with block sizes that are powers of two, from MIN_CLASS_SIZE up to
+MAX_CLASS_SIZE bytes. Larger allocations go directly to the heap.
+
+The number of allocations, the number of heap allocations (new chunks) and
+the number of blocks in use are published in the Metrics registry, labeled
+with the pool name. That way it is possible to verify that an application in
+steady state operation does not allocate any memory from the heap.
+
+The pools are thread safe. Memory may be freed in another thread than the one
+that allocated it.
+
+@code
+void *ptr = MemPool::allocate(100); // Taken from the 128 byte pool
+MemPool::deallocate(ptr, 100);
+@endcode
+*/
+class MemPool
+{
+  public:
+    /**
+     * @brief   The smallest size class used by allocate
+     */
+    static const size_t MIN_CLASS_SIZE = 16;
+
+    /**
+     * @brief   The largest size class used by allocate
+     */
+    static const size_t MAX_CLASS_SIZE = 16384;
+
+    /**
+     * @brief   Allocate memory from the process wide pools
+     * @param   size The number of bytes to allocate
+     * @return  Returns a pointer to the allocated memory
+     *
+     * Memory is taken from the pool of the smallest size class that can hold
+     * the requested number of bytes. Allocations larger than MAX_CLASS_SIZE
+     * are made directly from the heap. std::bad_alloc is thrown if the
+     * memory could not be allocated.
+     */
+    static void *allocate(size_t size);
+
+    /**
+     * @brief   Return memory allocated using allocate
+     * @param   ptr   The pointer returned from allocate
+     * @param   size  The size given to allocate
+     */
+    static void deallocate(void *ptr, size_t size);
+
+    /**
+     * @brief   Get the process wide pool for the given allocation size
+     * @param   size The number of bytes to allocate
+     * @return  Returns the pool or 0 if the size is larger than
+     *          MAX_CLASS_SIZE
+     */
+    static MemPool *forSize(size_t size);
+
+    /**
+     * @brief   Constructor
+     * @param   name        The name of the pool, used to label the metrics
+     * @param   block_size  The size of each block in bytes
+     * @param   chunk_size  The approximate number of bytes to allocate from
+     *                      the heap each time the pool need to grow
+     */
+    MemPool(const std::string& name, size_t block_size,
+            size_t chunk_size=16384);
+
+    /**
+     * @brief   Destructor
+     *
+     * All memory is returned to the heap, including blocks that still are in
+     * use.
+     */
+    ~MemPool(void);
+
+    /**
+     * @brief   Allocate a block
+     * @return  Returns a pointer to the block
+     *
+     * std::bad_alloc is thrown if the pool need to grow and the heap
+     * allocation fail.
+     */
+    void *alloc(void);
+
+    /**
+     * @brief   Return a block to the pool
+     * @param   ptr The block to return. Ignored if 0.
+     */
+    void free(void *ptr);
+
+    /**
+     * @brief   Get the name of the pool
+     */
+    const std::string& name(void) const { return m_name; }
+
+    /**
+     * @brief   Get the size of the blocks handed out by this pool
+     */
+    size_t blockSize(void) const { return m_block_size; }
+
+    /**
+     * @brief   Get the number of blocks currently in use
+     */
+    size_t blocksInUse(void) const;
+
+    /**
+     * @brief   Get the total number of blocks in the pool
+     */
+    size_t capacity(void) const;
+
+  private:
+    struct FreeBlock
+    {
+      FreeBlock *next;
+    };
+
+    const std::string   m_name;
+    const size_t        m_block_size;
+    const size_t        m_blocks_per_chunk;
+    mutable std::mutex  m_mutex;
+    FreeBlock*          m_free;
+    std::vector<char*>  m_chunks;
+    size_t              m_in_use;
+    MetricCounter*      m_alloc_cnt;
+    MetricCounter*      m_heap_alloc_cnt;
+    MetricGauge*        m_in_use_gauge;
+
+    MemPool(const MemPool&);
+    MemPool& operator=(const MemPool&);
+    void grow(void);
+
+};  /* class MemPool */
+
+
+/**
+@brief	An STL allocator that allocate memory from the memory pools
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This allocator may be used with the STL containers to get the container
+memory from the process wide memory pools. A container that keep about the
+same number of elements, like a queue, then stop allocating from the heap
+when the pools have grown to the working set.
+
+@code
+std::deque<Item, Async::PoolAllocator<Item> > queue;
+auto buf = std::allocate_shared<Buffer>(Async::PoolAllocator<Buffer>());
+@endcode
+*/
+template <typename T>
+class PoolAllocator
+{
+  public:
+    typedef T value_type;
+
+    PoolAllocator(void) noexcept {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T *allocate(size_t n)
+    {
+      return static_cast<T*>(MemPool::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, size_t n)
+    {
+      MemPool::deallocate(ptr, n * sizeof(T));
+    }
+
+};  /* class PoolAllocator */
+
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+  return true;
+}
+
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+  return false;
+}
+
+
+} /* namespace */
+
+#endif /* ASYNC_MEM_POOL_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
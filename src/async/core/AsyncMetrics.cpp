@@ -0,0 +1,423 @@
+/**
+@file	 AsyncMetrics.cpp
+@brief   A process wide registry of counters, gauges and histograms
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <algorithm>
+#include <sstream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncMetrics.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static void atomic_add(std::atomic<double>& value, double delta);
+static string join_labels(const string& labels, const string& extra);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+void MetricCounter::writePrometheus(std::ostream& os, const string& name,
+                                    const string& labels) const
+{
+  os << name << join_labels(labels, "") << " " << value() << "\n";
+} /* MetricCounter::writePrometheus */
+
+
+void MetricGauge::add(double delta)
+{
+  atomic_add(m_value, delta);
+} /* MetricGauge::add */
+
+
+void MetricGauge::writePrometheus(std::ostream& os, const string& name,
+                                  const string& labels) const
+{
+  os << name << join_labels(labels, "") << " " << value() << "\n";
+} /* MetricGauge::writePrometheus */
+
+
+MetricHistogram::MetricHistogram(const vector<double>& bounds)
+  : m_bounds(bounds), m_buckets(0), m_count(0), m_sum(0.0)
+{
+  assert(is_sorted(m_bounds.begin(), m_bounds.end()));
+  m_buckets = new std::atomic<uint64_t>[m_bounds.size() + 1];
+  for (size_t i=0; i<=m_bounds.size(); ++i)
+  {
+    m_buckets[i].store(0, memory_order_relaxed);
+  }
+} /* MetricHistogram::MetricHistogram */
+
+
+MetricHistogram::~MetricHistogram(void)
+{
+  delete [] m_buckets;
+} /* MetricHistogram::~MetricHistogram */
+
+
+void MetricHistogram::observe(double value)
+{
+  size_t idx = lower_bound(m_bounds.begin(), m_bounds.end(), value) -
+               m_bounds.begin();
+  m_buckets[idx].fetch_add(1, memory_order_relaxed);
+  m_count.fetch_add(1, memory_order_relaxed);
+  atomic_add(m_sum, value);
+} /* MetricHistogram::observe */
+
+
+void MetricHistogram::writePrometheus(std::ostream& os, const string& name,
+                                      const string& labels) const
+{
+    // The buckets are cumulative in the Prometheus format
+  uint64_t cnt = 0;
+  for (size_t i=0; i<m_bounds.size(); ++i)
+  {
+    cnt += m_buckets[i].load(memory_order_relaxed);
+    ostringstream le;
+    le << "le=\"" << m_bounds[i] << "\"";
+    os << name << "_bucket" << join_labels(labels, le.str()) << " "
+       << cnt << "\n";
+  }
+  cnt += m_buckets[m_bounds.size()].load(memory_order_relaxed);
+  os << name << "_bucket" << join_labels(labels, "le=\"+Inf\"") << " "
+     << cnt << "\n";
+  os << name << "_sum" << join_labels(labels, "") << " " << sum() << "\n";
+  os << name << "_count" << join_labels(labels, "") << " " << cnt << "\n";
+} /* MetricHistogram::writePrometheus */
+
+
+void MetricHistogram::writeCompact(std::ostream& os, const string& name,
+                                   const string& labels) const
+{
+  os << name << "_sum" << join_labels(labels, "") << " " << sum() << "\n";
+  os << name << "_count" << join_labels(labels, "") << " " << count() << "\n";
+} /* MetricHistogram::writeCompact */
+
+
+Metrics& Metrics::instance(void)
+{
+  static Metrics metrics;
+  return metrics;
+} /* Metrics::instance */
+
+
+MetricCounter *Metrics::counter(const string& name, const string& help,
+                                const Metric::Labels& labels)
+{
+  const string label_str = formatLabels(labels);
+  pthread_mutex_lock(&m_mutex);
+  Metric *metric = find(name, help, "counter", label_str);
+  if (metric == 0)
+  {
+    metric = new MetricCounter;
+    insert(name, label_str, metric);
+  }
+  pthread_mutex_unlock(&m_mutex);
+  return static_cast<MetricCounter*>(metric);
+} /* Metrics::counter */
+
+
+MetricGauge *Metrics::gauge(const string& name, const string& help,
+                            const Metric::Labels& labels)
+{
+  const string label_str = formatLabels(labels);
+  pthread_mutex_lock(&m_mutex);
+  Metric *metric = find(name, help, "gauge", label_str);
+  if (metric == 0)
+  {
+    metric = new MetricGauge;
+    insert(name, label_str, metric);
+  }
+  pthread_mutex_unlock(&m_mutex);
+  return static_cast<MetricGauge*>(metric);
+} /* Metrics::gauge */
+
+
+MetricHistogram *Metrics::histogram(const string& name, const string& help,
+                                    const vector<double>& bounds,
+                                    const Metric::Labels& labels)
+{
+  const string label_str = formatLabels(labels);
+  pthread_mutex_lock(&m_mutex);
+  Metric *metric = find(name, help, "histogram", label_str);
+  if (metric == 0)
+  {
+    metric = new MetricHistogram(bounds);
+    insert(name, label_str, metric);
+  }
+  pthread_mutex_unlock(&m_mutex);
+  return static_cast<MetricHistogram*>(metric);
+} /* Metrics::histogram */
+
+
+void Metrics::writePrometheus(std::ostream& os) const
+{
+  pthread_mutex_lock(&m_mutex);
+  for (FamilyMap::const_iterator fit=m_families.begin();
+       fit!=m_families.end(); ++fit)
+  {
+    const Family& family = fit->second;
+    os << "# HELP " << fit->first << " " << family.help << "\n"
+       << "# TYPE " << fit->first << " " << family.type << "\n";
+    map<string, Metric*>::const_iterator mit;
+    for (mit=family.metrics.begin(); mit!=family.metrics.end(); ++mit)
+    {
+      mit->second->writePrometheus(os, fit->first, mit->first);
+    }
+  }
+  pthread_mutex_unlock(&m_mutex);
+} /* Metrics::writePrometheus */
+
+
+string Metrics::prometheusText(void) const
+{
+  ostringstream os;
+  writePrometheus(os);
+  return os.str();
+} /* Metrics::prometheusText */
+
+
+void Metrics::writeCompact(std::ostream& os) const
+{
+  pthread_mutex_lock(&m_mutex);
+  for (FamilyMap::const_iterator fit=m_families.begin();
+       fit!=m_families.end(); ++fit)
+  {
+    const Family& family = fit->second;
+    map<string, Metric*>::const_iterator mit;
+    for (mit=family.metrics.begin(); mit!=family.metrics.end(); ++mit)
+    {
+      mit->second->writeCompact(os, fit->first, mit->first);
+    }
+  }
+  pthread_mutex_unlock(&m_mutex);
+} /* Metrics::writeCompact */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+Metrics::Metrics(void)
+{
+  pthread_mutex_init(&m_mutex, NULL);
+} /* Metrics::Metrics */
+
+
+Metrics::~Metrics(void)
+{
+  for (FamilyMap::iterator fit=m_families.begin();
+       fit!=m_families.end(); ++fit)
+  {
+    map<string, Metric*>::iterator mit;
+    for (mit=fit->second.metrics.begin(); mit!=fit->second.metrics.end();
+         ++mit)
+    {
+      delete mit->second;
+    }
+  }
+  pthread_mutex_destroy(&m_mutex);
+} /* Metrics::~Metrics */
+
+
+Metric *Metrics::find(const string& name, const string& help,
+                      const char *type, const string& label_str)
+{
+  Family& family = m_families[name];
+  if (family.type.empty())
+  {
+    family.help = help;
+    family.type = type;
+  }
+    // Using the same name for different types of metrics is a programming
+    // error
+  assert(family.type == type);
+
+  map<string, Metric*>::const_iterator it = family.metrics.find(label_str);
+  return (it != family.metrics.end()) ? it->second : 0;
+} /* Metrics::find */
+
+
+void Metrics::insert(const string& name, const string& label_str,
+                     Metric *metric)
+{
+  m_families[name].metrics[label_str] = metric;
+} /* Metrics::insert */
+
+
+string Metrics::formatLabels(const Metric::Labels& labels)
+{
+  string str;
+  for (Metric::Labels::const_iterator it=labels.begin();
+       it!=labels.end(); ++it)
+  {
+    if (!str.empty())
+    {
+      str += ",";
+    }
+    str += it->first + "=\"";
+    for (string::const_iterator cit=it->second.begin();
+         cit!=it->second.end(); ++cit)
+    {
+      switch (*cit)
+      {
+        case '\\': str += "\\\\"; break;
+        case '"':  str += "\\\""; break;
+        case '\n': str += "\\n";  break;
+        default:   str += *cit;   break;
+      }
+    }
+    str += "\"";
+  }
+  return str;
+} /* Metrics::formatLabels */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static void atomic_add(std::atomic<double>& value, double delta)
+{
+  double old_value = value.load(memory_order_relaxed);
+  while (!value.compare_exchange_weak(old_value, old_value + delta,
+                                      memory_order_relaxed))
+  {
+  }
+} /* atomic_add */
+
+
+static string join_labels(const string& labels, const string& extra)
+{
+  if (labels.empty() && extra.empty())
+  {
+    return "";
+  }
+  if (labels.empty())
+  {
+    return "{" + extra + "}";
+  }
+  if (extra.empty())
+  {
+    return "{" + labels + "}";
+  }
+  return "{" + labels + "," + extra + "}";
+} /* join_labels */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,429 @@
+/**
+@file	 AsyncMetrics.h
+@brief   A process wide registry of counters, gauges and histograms
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This file contains a registry for performance metrics. The metrics are
+updated using atomic operations so they may be updated from any thread. The
+registry can write all metrics in the Prometheus text exposition format.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_METRICS_INCLUDED
+#define ASYNC_METRICS_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Base class for a metric
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+*/
+class Metric
+{
+  public:
+    /**
+     * @brief   The type used for metric labels, name and value
+     */
+    typedef std::map<std::string, std::string> Labels;
+
+    /**
+     * @brief   Destructor
+     */
+    virtual ~Metric(void) {}
+
+    /**
+     * @brief   Get the Prometheus type name of the metric
+     */
+    virtual const char *typeName(void) const = 0;
+
+    /**
+     * @brief   Write the metric samples in the Prometheus text format
+     * @param   os      The stream to write to
+     * @param   name    The name of the metric
+     * @param   labels  The label set formatted as a comma separated list of
+     *                  name="value" pairs, without braces
+     */
+    virtual void writePrometheus(std::ostream& os, const std::string& name,
+                                 const std::string& labels) const = 0;
+
+    /**
+     * @brief   Write the metric samples in a compact text format
+     * @param   os      The stream to write to
+     * @param   name    The name of the metric
+     * @param   labels  The label set formatted as a comma separated list of
+     *                  name="value" pairs, without braces
+     *
+     * The format is the same as the Prometheus format but a metric may leave
+     * out samples, like the histogram buckets, to keep the output short.
+     */
+    virtual void writeCompact(std::ostream& os, const std::string& name,
+                              const std::string& labels) const
+    {
+      writePrometheus(os, name, labels);
+    }
+
+};  /* class Metric */
+
+
+/**
+@brief	A counter that can only increase
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+*/
+class MetricCounter : public Metric
+{
+  public:
+    /**
+     * @brief   Constructor
+     */
+    MetricCounter(void) : m_value(0) {}
+
+    /**
+     * @brief   Increase the counter
+     * @param   n The value to add
+     */
+    void inc(uint64_t n=1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+
+    /**
+     * @brief   Read the counter
+     */
+    uint64_t value(void) const
+    {
+      return m_value.load(std::memory_order_relaxed);
+    }
+
+    virtual const char *typeName(void) const { return "counter"; }
+    virtual void writePrometheus(std::ostream& os, const std::string& name,
+                                 const std::string& labels) const;
+
+  private:
+    std::atomic<uint64_t> m_value;
+
+};  /* class MetricCounter */
+
+
+/**
+@brief	A value that can go up and down
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+*/
+class MetricGauge : public Metric
+{
+  public:
+    /**
+     * @brief   Constructor
+     */
+    MetricGauge(void) : m_value(0.0) {}
+
+    /**
+     * @brief   Set the gauge value
+     * @param   value The new value
+     */
+    void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+
+    /**
+     * @brief   Add to the gauge value
+     * @param   delta The value to add, may be negative
+     */
+    void add(double delta);
+
+    /**
+     * @brief   Read the gauge
+     */
+    double value(void) const
+    {
+      return m_value.load(std::memory_order_relaxed);
+    }
+
+    virtual const char *typeName(void) const { return "gauge"; }
+    virtual void writePrometheus(std::ostream& os, const std::string& name,
+                                 const std::string& labels) const;
+
+  private:
+    std::atomic<double> m_value;
+
+};  /* class MetricGauge */
+
+
+/**
+@brief	A histogram with fixed bucket bounds
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+Each observed value is counted in the first bucket with an upper bound that
+is greater than or equal to the value. The sum and the count of all observed
+values are kept too.
+*/
+class MetricHistogram : public Metric
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   bounds The upper bounds of the buckets in increasing order
+     */
+    explicit MetricHistogram(const std::vector<double>& bounds);
+
+    /**
+     * @brief   Destructor
+     */
+    ~MetricHistogram(void);
+
+    /**
+     * @brief   Add a value to the histogram
+     * @param   value The observed value
+     */
+    void observe(double value);
+
+    /**
+     * @brief   Get the number of observed values
+     */
+    uint64_t count(void) const
+    {
+      return m_count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief   Get the sum of all observed values
+     */
+    double sum(void) const { return m_sum.load(std::memory_order_relaxed); }
+
+    virtual const char *typeName(void) const { return "histogram"; }
+    virtual void writePrometheus(std::ostream& os, const std::string& name,
+                                 const std::string& labels) const;
+    virtual void writeCompact(std::ostream& os, const std::string& name,
+                              const std::string& labels) const;
+
+  private:
+    std::vector<double>     m_bounds;
+    std::atomic<uint64_t>   *m_buckets;
+    std::atomic<uint64_t>   m_count;
+    std::atomic<double>     m_sum;
+
+    MetricHistogram(const MetricHistogram&);
+    MetricHistogram& operator=(const MetricHistogram&);
+
+};  /* class MetricHistogram */
+
+
+/**
+@brief	A process wide registry of metrics
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+Metrics are looked up by name and labels. The first lookup create the metric
+and later lookups with the same name and labels return the same object, so
+an object that is created again, e.g. when a logic is reloaded, continue to
+update the same metric. Metrics are never removed and the pointers stay
+valid for the lifetime of the process.
+
+Looking up a metric takes a lock so it should be done once, at setup, and
+the pointer kept. Updating a metric is lock free and may be done from any
+thread. The metric names should follow the Prometheus naming conventions,
+e.g. "svxlink_rx_squelch_open_total".
+
+@code
+MetricCounter *cnt = Metrics::instance().counter(
+    "svxlink_rx_squelch_open_total", "Number of squelch openings",
+    Metric::Labels{{"rx", name()}});
+cnt->inc();
+@endcode
+*/
+class Metrics
+{
+  public:
+    /**
+     * @brief   Get the registry
+     */
+    static Metrics& instance(void);
+
+    /**
+     * @brief   Find or create a counter
+     * @param   name    The name of the metric
+     * @param   help    A short description of the metric
+     * @param   labels  The labels of this instance of the metric
+     * @return  Returns the counter
+     */
+    MetricCounter *counter(const std::string& name, const std::string& help,
+                           const Metric::Labels& labels=Metric::Labels());
+
+    /**
+     * @brief   Find or create a gauge
+     * @param   name    The name of the metric
+     * @param   help    A short description of the metric
+     * @param   labels  The labels of this instance of the metric
+     * @return  Returns the gauge
+     */
+    MetricGauge *gauge(const std::string& name, const std::string& help,
+                       const Metric::Labels& labels=Metric::Labels());
+
+    /**
+     * @brief   Find or create a histogram
+     * @param   name    The name of the metric
+     * @param   help    A short description of the metric
+     * @param   bounds  The upper bounds of the buckets in increasing order
+     * @param   labels  The labels of this instance of the metric
+     * @return  Returns the histogram
+     *
+     * The bounds are only used when the histogram is created.
+     */
+    MetricHistogram *histogram(const std::string& name,
+                               const std::string& help,
+                               const std::vector<double>& bounds,
+                               const Metric::Labels& labels=Metric::Labels());
+
+    /**
+     * @brief   Write all metrics in the Prometheus text format
+     * @param   os The stream to write to
+     */
+    void writePrometheus(std::ostream& os) const;
+
+    /**
+     * @brief   Get all metrics in the Prometheus text format
+     * @return  Returns a string with all metrics
+     */
+    std::string prometheusText(void) const;
+
+    /**
+     * @brief   Write all metrics in a compact text format
+     * @param   os The stream to write to
+     *
+     * One line is written per sample, in the same format as the Prometheus
+     * text format, but without the HELP and TYPE comments and with only the
+     * sum and count for histograms. The format is easy to parse for simple
+     * monitoring scripts.
+     */
+    void writeCompact(std::ostream& os) const;
+
+  private:
+    struct Family
+    {
+      std::string                     help;
+      std::string                     type;
+      std::map<std::string, Metric*>  metrics;
+    };
+    typedef std::map<std::string, Family> FamilyMap;
+
+    mutable pthread_mutex_t m_mutex;
+    FamilyMap               m_families;
+
+    Metrics(void);
+    ~Metrics(void);
+    Metrics(const Metrics&);
+    Metrics& operator=(const Metrics&);
+    Metric *find(const std::string& name, const std::string& help,
+                 const char *type, const std::string& label_str);
+    void insert(const std::string& name, const std::string& label_str,
+                Metric *metric);
+    static std::string formatLabels(const Metric::Labels& labels);
+
+};  /* class Metrics */
+
+
+} /* namespace */
+
+#endif /* ASYNC_METRICS_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
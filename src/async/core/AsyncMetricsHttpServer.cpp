@@ -0,0 +1,192 @@
+/**
+@file	 AsyncMetricsHttpServer.cpp
+@brief   A HTTP server exporting the metrics registry
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncMetrics.h"
+#include "AsyncMetricsHttpServer.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+MetricsHttpServer::MetricsHttpServer(const string& port_str,
+                                     const IpAddress& bind_ip)
+  : m_server(port_str, bind_ip)
+{
+  m_server.clientConnected.connect(
+      sigc::mem_fun(*this, &MetricsHttpServer::clientConnected));
+} /* MetricsHttpServer::MetricsHttpServer */
+
+
+MetricsHttpServer::~MetricsHttpServer(void)
+{
+} /* MetricsHttpServer::~MetricsHttpServer */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void MetricsHttpServer::clientConnected(HttpServerConnection *con)
+{
+  con->requestReceived.connect(
+      sigc::mem_fun(*this, &MetricsHttpServer::requestReceived));
+} /* MetricsHttpServer::clientConnected */
+
+
+void MetricsHttpServer::requestReceived(HttpServerConnection *con,
+                                        HttpServerConnection::Request& req)
+{
+  HttpServerConnection::Response res;
+  if ((req.method != "GET") && (req.method != "HEAD"))
+  {
+    res.setCode(501);
+    res.setContent("text/plain", req.method + ": Method not implemented\n");
+    con->write(res);
+    return;
+  }
+
+  if (req.target != "/metrics")
+  {
+    res.setCode(404);
+    res.setContent("text/plain", "Not found!\n");
+    con->write(res);
+    return;
+  }
+
+  res.setContent("text/plain; version=0.0.4",
+                 Metrics::instance().prometheusText());
+  if (req.method == "HEAD")
+  {
+    res.setSendContent(false);
+  }
+  res.setCode(200);
+  con->write(res);
+} /* MetricsHttpServer::requestReceived */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
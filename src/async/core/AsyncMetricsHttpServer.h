@@ -0,0 +1,158 @@
+/**
+@file	 AsyncMetricsHttpServer.h
+@brief   A HTTP server exporting the metrics registry
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This file contains a small HTTP server that make the content of the
+Async::Metrics registry available to a Prometheus server.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_METRICS_HTTP_SERVER_INCLUDED
+#define ASYNC_METRICS_HTTP_SERVER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncTcpServer.h>
+#include <AsyncHttpServerConnection.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A HTTP server exporting the metrics registry
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+The server answer GET and HEAD requests for /metrics with all metrics in the
+Async::Metrics registry, in the Prometheus text exposition format. The
+server run in the event loop of the thread that created it. Formatting the
+metrics only take the registry lock briefly so threads updating metrics are
+not disturbed by a scrape.
+*/
+class MetricsHttpServer : public sigc::trackable
+{
+  public:
+    /**
+     * @brief 	Constuctor
+     * @param 	port_str A port number or service name to listen to
+     * @param 	bind_ip  The IP to bind the server to
+     */
+    MetricsHttpServer(const std::string& port_str,
+                      const IpAddress& bind_ip=IpAddress());
+
+    /**
+     * @brief 	Destructor
+     */
+    ~MetricsHttpServer(void);
+
+  private:
+    TcpServer<HttpServerConnection> m_server;
+
+    MetricsHttpServer(const MetricsHttpServer&);
+    MetricsHttpServer& operator=(const MetricsHttpServer&);
+    void clientConnected(HttpServerConnection *con);
+    void requestReceived(HttpServerConnection *con,
+                         HttpServerConnection::Request& req);
+
+};  /* class MetricsHttpServer */
+
+
+} /* namespace */
+
+#endif /* ASYNC_METRICS_HTTP_SERVER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -31,7 +31,8 @@ namespace Async
   class MsgPacker<std::pair<First, Second> >
   {
     public:
-      static bool pack(std::ostream& os, const std::pair<First, Second>& p)
+      template <typename OS>
+      static bool pack(OS& os, const std::pair<First, Second>& p)
       {
         return MsgPacker<First>::pack(os, p.first) &&
                MsgPacker<Second>::pack(os, p.second);
@@ -41,7 +42,8 @@ namespace Async
         return MsgPacker<First>::packedSize(p.first) +
                MsgPacker<Second>::packedSize(p.second);
       }
-      static bool unpack(std::istream& is, std::pair<First, Second>& p)
+      template <typename IS>
+      static bool unpack(IS& is, std::pair<First, Second>& p)
       {
         return MsgPacker<First>::unpack(is, p.first) &&
                MsgPacker<Second>::unpack(is, p.second);
@@ -86,6 +88,24 @@ MsgDerived d2;
 d2.unpack(ss);
 \endcode
 
+A message can also be packed directly into a caller supplied buffer, avoiding
+the overhead of the iostream machinery. Use packedSize() to find out how big
+the buffer need to be. The wire format is identical to the stream version.
+
+\code{.cpp}
+std::vector<char> buf(d1.packedSize());
+Async::MsgPackBuffer pb(&buf[0], buf.size());
+d1.pack(pb);
+
+MsgDerived d3;
+Async::MsgUnpackBuffer ub(&buf[0], pb.size());
+d3.unpack(ub);
+\endcode
+
+Note that the pack and unpack functions of a MsgPacker specialization must be
+templates taking the stream type as a parameter, like in the std::pair example
+above, for the type to be usable with both streams and buffers.
+
 For a working example, have a look at the demo application,
 \ref AsyncMsg_demo.cpp.
 
@@ -130,6 +150,7 @@ An example of how to use the AsyncMsg class
 #include <set>
 #include <map>
 #include <limits>
+#include <cstring>
 #include <endian.h>
 #include <stdint.h>
 
@@ -194,6 +215,10 @@ namespace Async
     { \
       return BASE_CLASS::pack(os); \
     } \
+    bool packParent(Async::MsgPackBuffer& buf) const \
+    { \
+      return BASE_CLASS::pack(buf); \
+    } \
     size_t packedSizeParent(void) const \
     { \
       return BASE_CLASS::packedSize(); \
@@ -201,6 +226,10 @@ namespace Async
     bool unpackParent(std::istream& is) \
     { \
       return BASE_CLASS::unpack(is); \
+    } \
+    bool unpackParent(Async::MsgUnpackBuffer& buf) \
+    { \
+      return BASE_CLASS::unpack(buf); \
     }
 
 /**
@@ -215,6 +244,10 @@ namespace Async
     { \
       return packParent(os) && Msg::pack(os, __VA_ARGS__); \
     } \
+    bool pack(Async::MsgPackBuffer& buf) const \
+    { \
+      return packParent(buf) && Msg::pack(buf, __VA_ARGS__); \
+    } \
     size_t packedSize(void) const \
     { \
       return packedSizeParent() + Msg::packedSize(__VA_ARGS__); \
@@ -222,6 +255,10 @@ namespace Async
     bool unpack(std::istream& is) \
     { \
       return unpackParent(is) && Msg::unpack(is, __VA_ARGS__); \
+    } \
+    bool unpack(Async::MsgUnpackBuffer& buf) \
+    { \
+      return unpackParent(buf) && Msg::unpack(buf, __VA_ARGS__); \
     }
 
 /**
@@ -234,10 +271,18 @@ namespace Async
     { \
       return packParent(os); \
     } \
+    bool pack(Async::MsgPackBuffer& buf) const \
+    { \
+      return packParent(buf); \
+    } \
     size_t packedSize(void) const { return packedSizeParent(); } \
     bool unpack(std::istream& is) \
     { \
       return unpackParent(is); \
+    } \
+    bool unpack(Async::MsgUnpackBuffer& buf) \
+    { \
+      return unpackParent(buf); \
     }
 
 
@@ -255,26 +300,172 @@ namespace Async
  *
  ****************************************************************************/
 
+/**
+@brief  A buffer to pack messages into
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class is used to pack messages directly into a caller supplied memory
+area instead of into a std::ostream. It implement the small subset of the
+std::ostream interface that the MsgPacker classes use. If a write would
+overflow the buffer, nothing is written and the buffer is put into a failed
+state. Use Msg::packedSize() to find out how big the buffer need to be.
+*/
+class MsgPackBuffer
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   buf   The buffer to pack data into
+     * @param   size  The size of the buffer
+     */
+    MsgPackBuffer(void *buf, size_t size)
+      : m_buf(reinterpret_cast<char*>(buf)), m_size(size), m_pos(0),
+        m_good(true)
+    {
+    }
+
+    /**
+     * @brief   Write data to the buffer
+     * @param   data  The data to write
+     * @param   len   The number of bytes to write
+     * @return  Returns a reference to this object
+     */
+    MsgPackBuffer& write(const char *data, size_t len)
+    {
+      if (!m_good || (len > m_size - m_pos))
+      {
+        m_good = false;
+        return *this;
+      }
+      std::memcpy(m_buf + m_pos, data, len);
+      m_pos += len;
+      return *this;
+    }
+
+    /**
+     * @brief   Check if all writes so far have been successful
+     * @return  Returns \em true if no write have failed
+     */
+    bool good(void) const { return m_good; }
+
+    /**
+     * @brief   Check if all writes so far have been successful
+     */
+    explicit operator bool(void) const { return m_good; }
+
+    /**
+     * @brief   Get the number of bytes written to the buffer
+     * @return  Returns the number of bytes written
+     */
+    size_t size(void) const { return m_pos; }
+
+    /**
+     * @brief   Get a pointer to the start of the buffer
+     * @return  Returns a pointer to the buffer
+     */
+    const char *data(void) const { return m_buf; }
+
+  private:
+    char*   m_buf;
+    size_t  m_size;
+    size_t  m_pos;
+    bool    m_good;
+};  /* class MsgPackBuffer */
+
+
+/**
+@brief  A buffer to unpack messages from
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class is used to unpack messages directly from a caller supplied memory
+area instead of from a std::istream. It implement the small subset of the
+std::istream interface that the MsgPacker classes use. Reading past the end of
+the buffer will put the buffer into a failed state. The buffer is not copied
+so it must be valid as long as this object is used.
+*/
+class MsgUnpackBuffer
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   buf   The buffer to unpack data from
+     * @param   size  The number of bytes in the buffer
+     */
+    MsgUnpackBuffer(const void *buf, size_t size)
+      : m_buf(reinterpret_cast<const char*>(buf)), m_size(size), m_pos(0),
+        m_good(true)
+    {
+    }
+
+    /**
+     * @brief   Read data from the buffer
+     * @param   data  The buffer to store the data in
+     * @param   len   The number of bytes to read
+     * @return  Returns a reference to this object
+     */
+    MsgUnpackBuffer& read(char *data, size_t len)
+    {
+      if (!m_good || (len > m_size - m_pos))
+      {
+        m_good = false;
+        return *this;
+      }
+      std::memcpy(data, m_buf + m_pos, len);
+      m_pos += len;
+      return *this;
+    }
+
+    /**
+     * @brief   Check if all reads so far have been successful
+     * @return  Returns \em true if no read have failed
+     */
+    bool good(void) const { return m_good; }
+
+    /**
+     * @brief   Check if all reads so far have been successful
+     */
+    explicit operator bool(void) const { return m_good; }
+
+    /**
+     * @brief   Get the number of bytes left to read
+     * @return  Returns the number of unread bytes in the buffer
+     */
+    size_t remaining(void) const { return m_size - m_pos; }
+
+  private:
+    const char* m_buf;
+    size_t      m_size;
+    size_t      m_pos;
+    bool        m_good;
+};  /* class MsgUnpackBuffer */
+
+
 template <typename T>
 class MsgPacker
 {
   public:
-    static bool pack(std::ostream& os, const T& val) { return val.pack(os); }
+    template <typename OS>
+    static bool pack(OS& os, const T& val) { return val.pack(os); }
     static size_t packedSize(const T& val) { return val.packedSize(); }
-    static bool unpack(std::istream& is, T& val) { return val.unpack(is); }
+    template <typename IS>
+    static bool unpack(IS& is, T& val) { return val.unpack(is); }
 };
 
 template <>
 class MsgPacker<char>
 {
   public:
-    static bool pack(std::ostream& os, char val)
+    template <typename OS>
+    static bool pack(OS& os, char val)
     {
       //std::cout << "pack<char>("<< int(val) << ")" << std::endl;
       return os.write(&val, 1).good();
     }
     static size_t packedSize(const char& val) { return sizeof(char); }
-    static bool unpack(std::istream& is, char& val)
+    template <typename IS>
+    static bool unpack(IS& is, char& val)
     {
       is.read(&val, 1);
       //std::cout << "unpack<char>(" << int(val) << ")" << std::endl;
@@ -286,7 +477,8 @@ template <typename T>
 class Packer64
 {
   public:
-    static bool pack(std::ostream& os, const T& val)
+    template <typename OS>
+    static bool pack(OS& os, const T& val)
     {
       //std::cout << "pack<64>(" << val << ")" << std::endl;
       Overlay o;
@@ -295,7 +487,8 @@ class Packer64
       return os.write(o.buf, sizeof(T)).good();
     }
     static size_t packedSize(const T& val) { return sizeof(T); }
-    static bool unpack(std::istream& is, T& val)
+    template <typename IS>
+    static bool unpack(IS& is, T& val)
     {
       Overlay o;
       is.read(o.buf, sizeof(T));
@@ -320,7 +513,8 @@ template <typename T>
 class Packer32
 {
   public:
-    static bool pack(std::ostream& os, const T& val)
+    template <typename OS>
+    static bool pack(OS& os, const T& val)
     {
       //std::cout << "pack<32>(" << val << ")" << std::endl;
       Overlay o;
@@ -329,7 +523,8 @@ class Packer32
       return os.write(o.buf, sizeof(T)).good();
     }
     static size_t packedSize(const T& val) { return sizeof(T); }
-    static bool unpack(std::istream& is, T& val)
+    template <typename IS>
+    static bool unpack(IS& is, T& val)
     {
       Overlay o;
       is.read(o.buf, sizeof(T));
@@ -354,7 +549,8 @@ template <typename T>
 class Packer16
 {
   public:
-    static bool pack(std::ostream& os, const T& val)
+    template <typename OS>
+    static bool pack(OS& os, const T& val)
     {
       //std::cout << "pack<16>(" << val << ")" << std::endl;
       Overlay o;
@@ -363,7 +559,8 @@ class Packer16
       return os.write(o.buf, sizeof(T)).good();
     }
     static size_t packedSize(const T& val) { return sizeof(T); }
-    static bool unpack(std::istream& is, T& val)
+    template <typename IS>
+    static bool unpack(IS& is, T& val)
     {
       Overlay o;
       is.read(o.buf, sizeof(T));
@@ -387,13 +584,15 @@ template <typename T>
 class Packer8
 {
   public:
-    static bool pack(std::ostream& os, const T& val)
+    template <typename OS>
+    static bool pack(OS& os, const T& val)
     {
       //std::cout << "pack<8>(" << int(val) << ")" << std::endl;
       return os.write(reinterpret_cast<const char*>(&val), sizeof(T)).good();
     }
     static size_t packedSize(const T& val) { return sizeof(T); }
-    static bool unpack(std::istream& is, T& val)
+    template <typename IS>
+    static bool unpack(IS& is, T& val)
     {
       is.read(reinterpret_cast<char*>(&val), sizeof(T));
       //std::cout << "unpack<8>(" << int(val) << ")" << std::endl;
@@ -407,7 +606,8 @@ template <>
 class MsgPacker<std::string>
 {
   public:
-    static bool pack(std::ostream& os, const std::string& val)
+    template <typename OS>
+    static bool pack(OS& os, const std::string& val)
     {
       //std::cout << "pack<string>(" << val << ")" << std::endl;
       if (val.size() > std::numeric_limits<uint16_t>::max())
@@ -422,7 +622,8 @@ class MsgPacker<std::string>
     {
       return sizeof(uint16_t) + val.size();
     }
-    static bool unpack(std::istream& is, std::string& val)
+    template <typename IS>
+    static bool unpack(IS& is, std::string& val)
     {
       uint16_t str_len;
       if (MsgPacker<uint16_t>::unpack(is, str_len))
@@ -447,19 +648,26 @@ template <typename I>
 class MsgPacker<std::vector<I> >
 {
   public:
-    static bool pack(std::ostream& os, const std::vector<I>& vec)
+    template <typename OS>
+    static bool pack(OS& os, const std::vector<I>& vec)
     {
       //std::cout << "pack<vector>(" << vec.size() << ")" << std::endl;
       if (vec.size() > std::numeric_limits<uint16_t>::max())
       {
         return false;
       }
-      MsgPacker<uint16_t>::pack(os, vec.size());
+      if (!MsgPacker<uint16_t>::pack(os, vec.size()))
+      {
+        return false;
+      }
       for (typename std::vector<I>::const_iterator it = vec.begin();
            it != vec.end();
            ++it)
       {
-        MsgPacker<I>::pack(os, *it);
+        if (!MsgPacker<I>::pack(os, *it))
+        {
+          return false;
+        }
       }
       return true;
     }
@@ -473,11 +681,12 @@ class MsgPacker<std::vector<I> >
       }
       return size;
     }
-    static bool unpack(std::istream& is, std::vector<I>& vec)
+    template <typename IS>
+    static bool unpack(IS& is, std::vector<I>& vec)
     {
       uint16_t vec_size;
-      MsgPacker<uint16_t>::unpack(is, vec_size);
-      if (vec_size > std::numeric_limits<uint16_t>::max())
+      if (!MsgPacker<uint16_t>::unpack(is, vec_size) ||
+          (vec_size > std::numeric_limits<uint16_t>::max()))
       {
         return false;
       }
@@ -487,7 +696,10 @@ class MsgPacker<std::vector<I> >
       for (int i=0; i<vec_size; ++i)
       {
         I val;
-        MsgPacker<I>::unpack(is, val);
+        if (!MsgPacker<I>::unpack(is, val))
+        {
+          return false;
+        }
         vec.push_back(val);
       }
       return true;
@@ -498,19 +710,26 @@ template <typename I>
 class MsgPacker<std::set<I> >
 {
   public:
-    static bool pack(std::ostream& os, const std::set<I>& s)
+    template <typename OS>
+    static bool pack(OS& os, const std::set<I>& s)
     {
       //std::cout << "pack<set>(" << s.size() << ")" << std::endl;
       if (s.size() > std::numeric_limits<uint16_t>::max())
       {
         return false;
       }
-      MsgPacker<uint16_t>::pack(os, s.size());
+      if (!MsgPacker<uint16_t>::pack(os, s.size()))
+      {
+        return false;
+      }
       for (typename std::set<I>::const_iterator it = s.begin();
            it != s.end();
            ++it)
       {
-        MsgPacker<I>::pack(os, *it);
+        if (!MsgPacker<I>::pack(os, *it))
+        {
+          return false;
+        }
       }
       return true;
     }
@@ -524,11 +743,12 @@ class MsgPacker<std::set<I> >
       }
       return size;
     }
-    static bool unpack(std::istream& is, std::set<I>& s)
+    template <typename IS>
+    static bool unpack(IS& is, std::set<I>& s)
     {
       uint16_t set_size;
-      MsgPacker<uint16_t>::unpack(is, set_size);
-      if (set_size > std::numeric_limits<uint16_t>::max())
+      if (!MsgPacker<uint16_t>::unpack(is, set_size) ||
+          (set_size > std::numeric_limits<uint16_t>::max()))
       {
         return false;
       }
@@ -537,7 +757,10 @@ class MsgPacker<std::set<I> >
       for (int i=0; i<set_size; ++i)
       {
         I val;
-        MsgPacker<I>::unpack(is, val);
+        if (!MsgPacker<I>::unpack(is, val))
+        {
+          return false;
+        }
         s.insert(val);
       }
       return true;
@@ -548,20 +771,27 @@ template <typename Tag, typename Value>
 class MsgPacker<std::map<Tag,Value> >
 {
   public:
-    static bool pack(std::ostream& os, const std::map<Tag, Value>& m)
+    template <typename OS>
+    static bool pack(OS& os, const std::map<Tag, Value>& m)
     {
       //std::cout << "pack<map>(" << m.size() << ")" << std::endl;
       if (m.size() > std::numeric_limits<uint16_t>::max())
       {
         return false;
       }
-      MsgPacker<uint16_t>::pack(os, m.size());
+      if (!MsgPacker<uint16_t>::pack(os, m.size()))
+      {
+        return false;
+      }
       for (typename std::map<Tag,Value>::const_iterator it = m.begin();
            it != m.end();
            ++it)
       {
-        MsgPacker<Tag>::pack(os, (*it).first);
-        MsgPacker<Value>::pack(os, (*it).second);
+        if (!MsgPacker<Tag>::pack(os, (*it).first) ||
+            !MsgPacker<Value>::pack(os, (*it).second))
+        {
+          return false;
+        }
       }
       return true;
     }
@@ -576,11 +806,12 @@ class MsgPacker<std::map<Tag,Value> >
       }
       return size;
     }
-    static bool unpack(std::istream& is, std::map<Tag,Value>& m)
+    template <typename IS>
+    static bool unpack(IS& is, std::map<Tag,Value>& m)
     {
       uint16_t map_size;
-      MsgPacker<uint16_t>::unpack(is, map_size);
-      if (map_size > std::numeric_limits<uint16_t>::max())
+      if (!MsgPacker<uint16_t>::unpack(is, map_size) ||
+          (map_size > std::numeric_limits<uint16_t>::max()))
       {
         return false;
       }
@@ -590,8 +821,11 @@ class MsgPacker<std::map<Tag,Value> >
       {
         Tag tag;
         Value val;
-        MsgPacker<Tag>::unpack(is, tag);
-        MsgPacker<Value>::unpack(is, val);
+        if (!MsgPacker<Tag>::unpack(is, tag) ||
+            !MsgPacker<Value>::unpack(is, val))
+        {
+          return false;
+        }
         m[tag] = val;
       }
       return true;
@@ -610,12 +844,37 @@ class Msg
     virtual ~Msg(void) {}
 
     bool packParent(std::ostream&) const { return true; }
+    bool packParent(MsgPackBuffer&) const { return true; }
     size_t packedSizeParent(void) const { return 0; }
     bool unpackParent(std::istream&) const { return true; }
+    bool unpackParent(MsgUnpackBuffer&) const { return true; }
 
     virtual bool pack(std::ostream&) const { return true; }
+    virtual bool pack(MsgPackBuffer&) const { return true; }
     virtual size_t packedSize(void) const { return 0; }
     virtual bool unpack(std::istream&) const { return true; }
+    virtual bool unpack(MsgUnpackBuffer&) { return true; }
+
+    template <typename T>
+    bool pack(MsgPackBuffer& buf, const T& val) const
+    {
+      return MsgPacker<T>::pack(buf, val);
+    }
+    template <typename T, typename... Ts>
+    bool pack(MsgPackBuffer& buf, const T& val, const Ts&... vals) const
+    {
+      return MsgPacker<T>::pack(buf, val) && pack(buf, vals...);
+    }
+    template <typename T>
+    bool unpack(MsgUnpackBuffer& buf, T& val)
+    {
+      return MsgPacker<T>::unpack(buf, val);
+    }
+    template <typename T, typename... Ts>
+    bool unpack(MsgUnpackBuffer& buf, T& val, Ts&... vals)
+    {
+      return MsgPacker<T>::unpack(buf, val) && unpack(buf, vals...);
+    }
 
     template <typename T>
     bool pack(std::ostream& os, const T& val) const
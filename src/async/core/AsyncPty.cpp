@@ -51,6 +51,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncFdWatch.h>
+#include <AsyncApplication.h>
 
 
 /****************************************************************************
@@ -242,6 +243,21 @@ bool Pty::reopen(void)
 
 ssize_t Pty::write(const void *buf, size_t count)
 {
+  if (m_is_write_buffered)
+  {
+    m_write_buffer.append(reinterpret_cast<const char*>(buf), count);
+    if (m_write_buffer.size() >= WRITE_BUFSIZE)
+    {
+      flush();
+    }
+    else if (!m_flush_pending)
+    {
+      m_flush_pending = true;
+      Application::app().runTask(mem_fun(*this, &Pty::flushPending));
+    }
+    return count;
+  }
+
   if ((pollMaster() & POLLHUP) != 0)
   {
     return count;
@@ -250,6 +266,35 @@ ssize_t Pty::write(const void *buf, size_t count)
 } /* Pty::write */
 
 
+void Pty::setWriteBuffered(bool buffered)
+{
+  if (!buffered)
+  {
+    flush();
+  }
+  m_is_write_buffered = buffered;
+} /* Pty::setWriteBuffered */
+
+
+bool Pty::flush(void)
+{
+  if (m_write_buffer.empty())
+  {
+    return true;
+  }
+  if ((master < 0) || ((pollMaster() & POLLHUP) != 0))
+  {
+    m_write_buffer.clear();
+    return master >= 0;
+  }
+  ssize_t written = ::write(master, m_write_buffer.data(),
+                            m_write_buffer.size());
+  bool success = (written == static_cast<ssize_t>(m_write_buffer.size()));
+  m_write_buffer.clear();
+  return success;
+} /* Pty::flush */
+
+
 
 /****************************************************************************
  *
@@ -289,46 +334,125 @@ void Pty::charactersReceived(void)
     return;
   }
 
-  char buf[256];
-  int rd = read(master, buf, sizeof(buf));
-  if (rd < 0)
-  {
-    std::cerr << "*** ERROR: Failed to read master PTY: "
-              << std::strerror(errno) << ". "
-              << "Trying to reopen the PTY.\n";
-    reopen();
-    return;
-  }
-  else if (rd == 0)
+    // Read until there is no more data available so that a burst of input
+    // is handled in as few calls as possible
+  char buf[READ_BUFSIZE];
+  for (;;)
   {
-    reopen();
-    return;
+    ssize_t rd = read(master, buf, sizeof(buf));
+    if (rd < 0)
+    {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        return;
+      }
+      std::cerr << "*** ERROR: Failed to read master PTY: "
+                << std::strerror(errno) << ". "
+                << "Trying to reopen the PTY.\n";
+      reopen();
+      return;
+    }
+    else if (rd == 0)
+    {
+      reopen();
+      return;
+    }
+
+    handleReceivedData(buf, rd);
+
+      // A connected slot may have closed the PTY. Reading a master PTY with
+      // no open slave end return an error so only read once in that case.
+    if ((master < 0) || ((revent & POLLHUP) != 0) ||
+        (static_cast<size_t>(rd) < sizeof(buf)))
+    {
+      return;
+    }
   }
+} /* Pty::charactersReceived */
 
+
+/**
+ * @brief   Deliver received data according to the read mode
+ * @param   buf The received data
+ * @param   count The number of bytes in the buffer
+ *
+ * Complete lines or records are delivered directly from the read buffer when
+ * there is no partial data left from a previous read.
+ */
+void Pty::handleReceivedData(const char *buf, size_t count)
+{
   if (m_is_line_buffered)
   {
-    for (int i = 0; i < rd; ++i)
+    const char *end = buf + count;
+    const char *line_begin = buf;
+    while (line_begin < end)
     {
-      const char& ch = buf[i];
-      if ((ch == '\r') || (ch == '\n'))
+      const char *line_end = line_begin;
+      while ((line_end < end) && (*line_end != '\r') && (*line_end != '\n'))
       {
-        if (!m_line_buffer.empty())
+        ++line_end;
+      }
+      if (line_end == end)
+      {
+          // Prevent the line buffer from growing without bounds
+        if (m_line_buffer.size() + (line_end - line_begin) > READ_BUFSIZE)
         {
-          dataReceived(m_line_buffer.c_str(), m_line_buffer.size());
           m_line_buffer.clear();
         }
+        m_line_buffer.append(line_begin, line_end);
+        break;
+      }
+      if (!m_line_buffer.empty())
+      {
+        m_line_buffer.append(line_begin, line_end);
+        dataReceived(m_line_buffer.c_str(), m_line_buffer.size());
+        m_line_buffer.clear();
       }
-      else
+      else if (line_end > line_begin)
       {
-        m_line_buffer += ch;
+        dataReceived(line_begin, line_end - line_begin);
       }
+      line_begin = line_end + 1;
     }
   }
+  else if (m_record_size > 0)
+  {
+    if (!m_line_buffer.empty())
+    {
+      size_t missing = m_record_size - m_line_buffer.size();
+      if (count < missing)
+      {
+        m_line_buffer.append(buf, count);
+        return;
+      }
+      m_line_buffer.append(buf, missing);
+      dataReceived(m_line_buffer.data(), m_line_buffer.size());
+      m_line_buffer.clear();
+      buf += missing;
+      count -= missing;
+    }
+    size_t whole = count - count % m_record_size;
+    if (whole > 0)
+    {
+      dataReceived(buf, whole);
+    }
+    m_line_buffer.assign(buf + whole, count - whole);
+  }
   else
   {
-    dataReceived(buf, rd);
+    dataReceived(buf, count);
   }
-} /* Pty::charactersReceived */
+} /* Pty::handleReceivedData */
+
+
+/**
+ * @brief   Flush the write buffer when control return to the main loop
+ */
+void Pty::flushPending(void)
+{
+  m_flush_pending = false;
+  flush();
+} /* Pty::flushPending */
 
 
 /**
@@ -369,6 +493,7 @@ void Pty::checkIfSlaveEndOpen(void)
   if ((revents & POLLHUP) == 0)
   {
     watch = new Async::FdWatch(master, Async::FdWatch::FD_WATCH_RD);
+    watch->setLabel("Async::Pty");
     assert(watch != 0);
     watch->activity.connect(
         sigc::hide(mem_fun(*this, &Pty::charactersReceived)));
@@ -134,12 +134,61 @@ class Pty : public sigc::trackable
      */
     ~Pty(void);
 
+    /**
+     * @brief   Enable or disable line buffered reading
+     * @param   line_buffered Set to \em true to enable line buffered mode
+     *
+     * In line buffered mode the dataReceived signal is emitted once for each
+     * complete, non-empty line. The line ending (CR or LF) is not included.
+     * Record buffered mode is disabled by this function.
+     */
     void setLineBuffered(bool line_buffered)
     {
       m_is_line_buffered = line_buffered;
+      m_record_size = 0;
       m_line_buffer.clear();
     }
 
+    /**
+     * @brief   Enable or disable record buffered reading
+     * @param   record_size The size of each record or 0 to disable
+     *
+     * In record buffered mode the dataReceived signal is only given whole
+     * records. All complete records that has been read are delivered in one
+     * call so the count is always a multiple of the record size. Incomplete
+     * records are held back until the rest of the data arrive. Line buffered
+     * mode is disabled by this function.
+     */
+    void setRecordBuffered(size_t record_size)
+    {
+      m_record_size = record_size;
+      m_is_line_buffered = false;
+      m_line_buffer.clear();
+    }
+
+    /**
+     * @brief   Enable or disable buffered writing
+     * @param   buffered Set to \em true to enable buffered writing
+     *
+     * When buffered writing is enabled, data written using the write function
+     * is collected in a buffer instead of being written to the PTY at once.
+     * The buffer is written to the PTY using a single system call when the
+     * flush function is called, when the buffer grow larger than
+     * WRITE_BUFSIZE or, at the latest, when control return to the main loop.
+     * Disabling buffered writing flush the buffer.
+     */
+    void setWriteBuffered(bool buffered);
+
+    /**
+     * @brief   Write buffered data to the PTY
+     * @return  Returns \em true on success or \em false on failure
+     *
+     * Write all data that has been buffered using the write function when
+     * buffered writing is enabled. If the slave end of the PTY is not open,
+     * the buffered data is discarded.
+     */
+    bool flush(void);
+
     /**
      * @brief   Open the PTY
      * @return  Returns \em true on success or \em false on failure
@@ -176,7 +225,8 @@ class Pty : public sigc::trackable
      * 
      * Use this function to write data to the PTY. If the slave end of the PTY
      * is not open, the written data will just be discarded and \em count is
-     * used as the return value.
+     * used as the return value. If buffered writing is enabled, the data is
+     * just stored in the write buffer and \em count is returned.
      */
     ssize_t write(const void *buf, size_t count);
 
@@ -193,10 +243,16 @@ class Pty : public sigc::trackable
      */
     sigc::signal<void, const void*, size_t> dataReceived;
     
+    /**
+     * @brief   The write buffer size that cause an immediate flush
+     */
+    static const size_t WRITE_BUFSIZE = 4096;
+
   protected:
     
   private:
     static const int POLLHUP_CHECK_INTERVAL = 100;
+    static const size_t READ_BUFSIZE = 4096;
 
     std::string     slave_link;
     int     	    master;
@@ -204,11 +260,17 @@ class Pty : public sigc::trackable
     Async::Timer    pollhup_timer;
     bool            m_is_line_buffered = false;
     std::string     m_line_buffer;
+    size_t          m_record_size = 0;
+    bool            m_is_write_buffered = false;
+    std::string     m_write_buffer;
+    bool            m_flush_pending = false;
 
     Pty(const Pty&);
     Pty& operator=(const Pty&);
     
     void charactersReceived(void);
+    void handleReceivedData(const char *buf, size_t count);
+    void flushPending(void);
     short pollMaster(void);
     void checkIfSlaveEndOpen(void);
 
@@ -160,7 +160,9 @@ PtyStreamBuf::int_type PtyStreamBuf::overflow(int_type ch)
 
 int PtyStreamBuf::sync(void)
 {
-  return (m_pty->isOpen() && writeToPty()) ? 0 : -1;
+    // A flush of the stream is an explicit flush point so also flush the
+    // write buffer in the PTY, if buffered writing is enabled
+  return (m_pty->isOpen() && writeToPty() && m_pty->flush()) ? 0 : -1;
 } /* PtyStreamBuf::sync */
 
 
@@ -0,0 +1,504 @@
+/**
+@file	 AsyncRealtime.cpp
+@brief   Realtime scheduling and memory locking support
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncRealtime.h"
+#include "AsyncMetrics.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The amount of stack to pre-fault in the main thread
+#define PREFAULT_STACK_SIZE (256 * 1024)
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static long long timespec_ns(const struct timespec& ts);
+static void prefault_stack(void);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+Realtime& Realtime::instance(void)
+{
+    // Never deleted since the watchdog thread may be running when the
+    // application exit
+  static Realtime *rt = new Realtime;
+  return *rt;
+} /* Realtime::instance */
+
+
+bool Realtime::setPolicy(const string& policy)
+{
+  if (policy == "FIFO")
+  {
+    m_policy = SCHED_FIFO;
+  }
+  else if (policy == "RR")
+  {
+    m_policy = SCHED_RR;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+} /* Realtime::setPolicy */
+
+
+void Realtime::setPriority(int prio)
+{
+  m_prio = prio;
+} /* Realtime::setPriority */
+
+
+bool Realtime::setCpuAffinity(const string& cpus)
+{
+  vector<int> cpu_list;
+  string list(cpus);
+  replace(list.begin(), list.end(), ',', ' ');
+  istringstream is(list);
+  string range;
+  while (is >> range)
+  {
+    int first = -1;
+    int last = -1;
+    char dash = 0;
+    istringstream ris(range);
+    ris >> first;
+    if (ris >> dash)
+    {
+      if ((dash != '-') || !(ris >> last))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      last = first;
+    }
+    if ((first < 0) || (last < first) || (last >= CPU_SETSIZE))
+    {
+      return false;
+    }
+    for (int cpu=first; cpu<=last; ++cpu)
+    {
+      cpu_list.push_back(cpu);
+    }
+  }
+  m_cpus.swap(cpu_list);
+  return true;
+} /* Realtime::setCpuAffinity */
+
+
+void Realtime::setWatchdog(unsigned period_ms, unsigned max_load)
+{
+  m_watchdog_period = period_ms;
+  m_watchdog_max_load = max_load;
+} /* Realtime::setWatchdog */
+
+
+bool Realtime::enable(void)
+{
+  if (m_enabled)
+  {
+    return true;
+  }
+  m_enabled = true;
+
+  if (m_lock_memory)
+  {
+    lockMemory();
+  }
+  prefault();
+  setAffinity();
+
+    // Leave room for audio I/O threads and the watchdog above the main loop
+  m_prio = max(m_prio, sched_get_priority_min(m_policy));
+  m_prio = min(m_prio, sched_get_priority_max(m_policy) - 2);
+
+  bool success = promoteCurrentThread("main loop");
+  if (m_watchdog_period > 0)
+  {
+    startWatchdog();
+  }
+  return success;
+} /* Realtime::enable */
+
+
+bool Realtime::promoteThread(pthread_t thread, const string& name,
+                             int prio_offset)
+{
+  if (!m_enabled || !setScheduling(thread, name, m_prio + prio_offset))
+  {
+    return false;
+  }
+
+  Thread t;
+  t.thread = thread;
+  t.name = name;
+  t.demoted = false;
+  t.last_cpu_ns = 0;
+  int ret = pthread_getcpuclockid(thread, &t.clock);
+  if (ret != 0)
+  {
+    cerr << "*** WARNING: Could not get the CPU clock for the " << name
+         << " thread: " << strerror(ret)
+         << ". The thread will not be watched.\n";
+    return true;
+  }
+  struct timespec ts;
+  if (clock_gettime(t.clock, &ts) == 0)
+  {
+    t.last_cpu_ns = timespec_ns(ts);
+  }
+
+  pthread_mutex_lock(&m_mutex);
+  m_threads.push_back(t);
+  pthread_mutex_unlock(&m_mutex);
+
+  return true;
+} /* Realtime::promoteThread */
+
+
+void Realtime::releaseThread(pthread_t thread)
+{
+  pthread_mutex_lock(&m_mutex);
+  for (vector<Thread>::iterator it=m_threads.begin(); it!=m_threads.end();
+       ++it)
+  {
+    if (pthread_equal(it->thread, thread))
+    {
+      m_threads.erase(it);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&m_mutex);
+} /* Realtime::releaseThread */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+Realtime::Realtime(void)
+  : m_enabled(false), m_policy(SCHED_FIFO), m_prio(DEFAULT_PRIORITY),
+    m_lock_memory(true), m_prefault_size(0), m_watchdog_period(1000),
+    m_watchdog_max_load(90), m_watchdog_started(false)
+{
+  pthread_mutex_init(&m_mutex, NULL);
+  m_demotions = Metrics::instance().counter("async_realtime_demotions_total",
+      "Number of realtime threads demoted by the watchdog");
+} /* Realtime::Realtime */
+
+
+void *Realtime::watchdogFunc(void *arg)
+{
+  Realtime *rt = reinterpret_cast<Realtime*>(arg);
+  struct timespec period;
+  period.tv_sec = rt->m_watchdog_period / 1000;
+  period.tv_nsec = (rt->m_watchdog_period % 1000) * 1000000L;
+  for (;;)
+  {
+    nanosleep(&period, NULL);
+    rt->checkThreads();
+  }
+  return NULL;
+} /* Realtime::watchdogFunc */
+
+
+void Realtime::lockMemory(void)
+{
+#ifdef __GLIBC__
+    // Keep freed memory in the process and do not use mmap for large
+    // allocations so that locked and pre-faulted memory is reused
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+#endif
+
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    cerr << "*** WARNING: Could not lock memory: " << strerror(errno)
+         << ". Check the memlock resource limit.\n";
+  }
+} /* Realtime::lockMemory */
+
+
+void Realtime::prefault(void)
+{
+  prefault_stack();
+
+  if (m_prefault_size == 0)
+  {
+    return;
+  }
+
+    // Touch every page of a heap block. Since trimming is disabled the pages
+    // stay in the process when the block is freed.
+  char *buf = static_cast<char*>(malloc(m_prefault_size));
+  if (buf == 0)
+  {
+    cerr << "*** WARNING: Could not allocate " << m_prefault_size
+         << " bytes of heap to pre-fault\n";
+    return;
+  }
+  const long page_size = sysconf(_SC_PAGESIZE);
+  for (size_t i=0; i<m_prefault_size; i+=page_size)
+  {
+    buf[i] = 0;
+  }
+  free(buf);
+} /* Realtime::prefault */
+
+
+void Realtime::setAffinity(void)
+{
+  if (m_cpus.empty())
+  {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (vector<int>::const_iterator it=m_cpus.begin(); it!=m_cpus.end(); ++it)
+  {
+    CPU_SET(*it, &set);
+  }
+  if (sched_setaffinity(0, sizeof(set), &set) != 0)
+  {
+    cerr << "*** WARNING: Could not set the CPU affinity: "
+         << strerror(errno) << endl;
+  }
+} /* Realtime::setAffinity */
+
+
+bool Realtime::setScheduling(pthread_t thread, const string& name, int prio)
+{
+  sched_param param;
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = min(prio, sched_get_priority_max(m_policy));
+  int ret = pthread_setschedparam(thread, m_policy, &param);
+  if (ret != 0)
+  {
+    cerr << "*** WARNING: Could not set "
+         << (m_policy == SCHED_RR ? "SCHED_RR" : "SCHED_FIFO")
+         << " priority " << param.sched_priority << " for the " << name
+         << " thread: " << strerror(ret)
+         << ". Check the rtprio resource limit.\n";
+    return false;
+  }
+  return true;
+} /* Realtime::setScheduling */
+
+
+void Realtime::startWatchdog(void)
+{
+  if (m_watchdog_started)
+  {
+    return;
+  }
+  int ret = pthread_create(&m_watchdog, NULL, watchdogFunc, this);
+  if (ret != 0)
+  {
+    cerr << "*** WARNING: Could not start the realtime watchdog thread: "
+         << strerror(ret) << endl;
+    return;
+  }
+  pthread_detach(m_watchdog);
+  m_watchdog_started = true;
+
+    // The watchdog must be able to preempt any spinning thread
+  sched_param param;
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+  ret = pthread_setschedparam(m_watchdog, SCHED_FIFO, &param);
+  if (ret != 0)
+  {
+    cerr << "*** WARNING: Could not set the priority of the realtime "
+            "watchdog thread: " << strerror(ret) << endl;
+  }
+} /* Realtime::startWatchdog */
+
+
+void Realtime::checkThreads(void)
+{
+  const long long limit_ns =
+    static_cast<long long>(m_watchdog_period) * 10000LL * m_watchdog_max_load;
+
+  pthread_mutex_lock(&m_mutex);
+  for (vector<Thread>::iterator it=m_threads.begin(); it!=m_threads.end();
+       ++it)
+  {
+    struct timespec ts;
+    if (it->demoted || (clock_gettime(it->clock, &ts) != 0))
+    {
+      continue;
+    }
+    const long long cpu_ns = timespec_ns(ts);
+    const long long used_ns = cpu_ns - it->last_cpu_ns;
+    it->last_cpu_ns = cpu_ns;
+    if (used_ns < limit_ns)
+    {
+      continue;
+    }
+
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+    pthread_setschedparam(it->thread, SCHED_OTHER, &param);
+    it->demoted = true;
+    m_demotions->inc();
+    cerr << "*** WARNING: The " << it->name << " thread used "
+         << (used_ns / (m_watchdog_period * 10000LL))
+         << "% CPU during the last " << m_watchdog_period
+         << "ms. Demoting it to normal scheduling.\n";
+  }
+  pthread_mutex_unlock(&m_mutex);
+} /* Realtime::checkThreads */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static long long timespec_ns(const struct timespec& ts)
+{
+  return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+} /* timespec_ns */
+
+
+static void prefault_stack(void)
+{
+  volatile char buf[PREFAULT_STACK_SIZE];
+  const long page_size = sysconf(_SC_PAGESIZE);
+  for (size_t i=0; i<sizeof(buf); i+=page_size)
+  {
+    buf[i] = 0;
+  }
+} /* prefault_stack */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,297 @@
+/**
+@file	 AsyncRealtime.h
+@brief   Realtime scheduling and memory locking support
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains a class used to run an application in a realtime mode,
+with locked and pre-faulted memory, realtime scheduling of the time critical
+threads, optional CPU affinity and a watchdog that demote threads that hog
+the CPU.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_REALTIME_INCLUDED
+#define ASYNC_REALTIME_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class MetricCounter;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Realtime operating mode for an application
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+This class is used to put an application into a realtime operating mode.
+When enabled, all current and future memory of the process is locked into
+RAM, a part of the heap and the stack is pre-faulted and the main loop thread
+is given a realtime scheduling policy (SCHED_FIFO or SCHED_RR). Other time
+critical threads, like audio I/O threads or worker event loops, register
+using promoteThread or promoteCurrentThread. An audio I/O thread should be
+given a priority offset of one so that it preempts the loop feeding it.
+
+A thread that spin in a realtime scheduling class may lock up the whole
+system. To guard against that, a watchdog thread running at a higher priority
+measure the CPU time used by each promoted thread. A thread that use more than
+the configured share of a CPU during a watchdog period is demoted to normal
+scheduling and a warning is printed. The number of demotions is published in
+the Metrics registry as async_realtime_demotions_total.
+
+The process need the privileges to use realtime scheduling and to lock
+memory, either by running as root or through the RLIMIT_RTPRIO and
+RLIMIT_MEMLOCK resource limits. If a step fail, a warning is printed and the
+application continue to run without it.
+
+@code
+Realtime& rt = Realtime::instance();
+rt.setPolicy("FIFO");
+rt.setPriority(50);
+rt.setCpuAffinity("2-3");
+rt.enable();
+@endcode
+*/
+class Realtime
+{
+  public:
+    /**
+     * @brief   The default realtime priority
+     */
+    static const int DEFAULT_PRIORITY = 50;
+
+    /**
+     * @brief   Get the application wide instance
+     */
+    static Realtime& instance(void);
+
+    /**
+     * @brief   Set the scheduling policy to use
+     * @param   policy Either "FIFO" or "RR"
+     * @return  Returns \em true on success or \em false if the policy is
+     *          unknown
+     */
+    bool setPolicy(const std::string& policy);
+
+    /**
+     * @brief   Set the realtime priority of the main loop
+     * @param   prio The priority
+     *
+     * The priority is clamped so that there is room above it for promoted
+     * threads with a priority offset and for the watchdog.
+     */
+    void setPriority(int prio);
+
+    /**
+     * @brief   Set which CPUs the process may run on
+     * @param   cpus A list of CPUs, like "1,3" or "2-3". Empty means all.
+     * @return  Returns \em true on success or \em false if the list could
+     *          not be parsed
+     */
+    bool setCpuAffinity(const std::string& cpus);
+
+    /**
+     * @brief   Set if all memory should be locked into RAM
+     * @param   lock Set to \em true to lock memory (the default)
+     */
+    void setLockMemory(bool lock) { m_lock_memory = lock; }
+
+    /**
+     * @brief   Set the amount of heap memory to pre-fault
+     * @param   size The size in bytes
+     */
+    void setPrefaultSize(size_t size) { m_prefault_size = size; }
+
+    /**
+     * @brief   Setup the watchdog
+     * @param   period_ms The watchdog period in milliseconds, 0 to disable
+     * @param   max_load  The share of a CPU, in percent, that a promoted
+     *                    thread may use during a period
+     */
+    void setWatchdog(unsigned period_ms, unsigned max_load);
+
+    /**
+     * @brief   Enter the realtime operating mode
+     * @return  Returns \em true if the main loop could be promoted
+     *
+     * This function should be called from the main thread after the
+     * configuration has been read and privileges have been dropped.
+     */
+    bool enable(void);
+
+    /**
+     * @brief   Check if the realtime operating mode is enabled
+     */
+    bool isEnabled(void) const { return m_enabled; }
+
+    /**
+     * @brief   Give a thread realtime scheduling
+     * @param   thread      The thread to promote
+     * @param   name        The name of the thread, used in messages
+     * @param   prio_offset Priority relative to the main loop
+     * @return  Returns \em true on success or \em false on failure
+     *
+     * The thread is monitored by the watchdog until releaseThread is called.
+     * That must be done before the thread is joined.
+     */
+    bool promoteThread(pthread_t thread, const std::string& name,
+                       int prio_offset=0);
+
+    /**
+     * @brief   Give the calling thread realtime scheduling
+     * @param   name        The name of the thread, used in messages
+     * @param   prio_offset Priority relative to the main loop
+     * @return  Returns \em true on success or \em false on failure
+     */
+    bool promoteCurrentThread(const std::string& name, int prio_offset=0)
+    {
+      return promoteThread(pthread_self(), name, prio_offset);
+    }
+
+    /**
+     * @brief   Stop monitoring a promoted thread
+     * @param   thread The thread to release
+     */
+    void releaseThread(pthread_t thread);
+
+  private:
+    struct Thread
+    {
+      pthread_t   thread;
+      std::string name;
+      clockid_t   clock;
+      long long   last_cpu_ns;
+      bool        demoted;
+    };
+
+    bool                  m_enabled;
+    int                   m_policy;
+    int                   m_prio;
+    std::vector<int>      m_cpus;
+    bool                  m_lock_memory;
+    size_t                m_prefault_size;
+    unsigned              m_watchdog_period;
+    unsigned              m_watchdog_max_load;
+    pthread_mutex_t       m_mutex;
+    std::vector<Thread>   m_threads;
+    pthread_t             m_watchdog;
+    bool                  m_watchdog_started;
+    MetricCounter*        m_demotions;
+
+    static void *watchdogFunc(void *arg);
+
+    Realtime(void);
+    Realtime(const Realtime&);
+    Realtime& operator=(const Realtime&);
+    void lockMemory(void);
+    void prefault(void);
+    void setAffinity(void);
+    bool setScheduling(pthread_t thread, const std::string& name, int prio);
+    void startWatchdog(void);
+    void checkThreads(void);
+
+};  /* class Realtime */
+
+
+} /* namespace */
+
+#endif /* ASYNC_REALTIME_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
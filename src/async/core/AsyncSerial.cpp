@@ -41,6 +41,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/ioctl.h>
+#include <pthread.h>
+#include <limits.h>
+#include <stdlib.h>
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
 
 #include <cstdio>
 #include <cstring>
@@ -55,6 +61,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncFdWatch.h>
+#include <AsyncTimer.h>
 
 
 /****************************************************************************
@@ -85,6 +92,11 @@ using namespace Async;
  *
  ****************************************************************************/
 
+  // The input pins that are watched for changes
+#define PIN_WATCH_MASK    (TIOCM_CTS | TIOCM_DSR | TIOCM_CD | TIOCM_RI)
+
+  // The poll interval used if the driver does not support TIOCMIWAIT
+#define PIN_POLL_INTERVAL 10
 
 
 /****************************************************************************
@@ -93,6 +105,154 @@ using namespace Async;
  *
  ****************************************************************************/
 
+/*
+ * Watch the input pins of a serial port for changes. The TIOCMIWAIT ioctl
+ * block until one of the pins change so it is run in a helper thread. The
+ * thread wake the main loop up by writing a byte into a pipe. The pins are
+ * then read and compared in the main thread so the helper thread never
+ * touch any shared state. If TIOCMIWAIT fail, e.g. because the driver does
+ * not support it, the helper thread exit and the pins are polled instead.
+ */
+class Serial::PinWatcher : public sigc::trackable
+{
+  public:
+    sigc::signal<void, int, int> pinsChanged;
+
+    PinWatcher(int fd)
+      : fd(fd), thread_started(false), pins(0), watch(0),
+        poll_timer(PIN_POLL_INTERVAL, Timer::TYPE_PERIODIC, false)
+    {
+      pipe_fd[0] = pipe_fd[1] = -1;
+      poll_timer.expired.connect(
+          sigc::hide(mem_fun(*this, &PinWatcher::checkPins)));
+    }
+
+    ~PinWatcher(void)
+    {
+      stopThread();
+      delete watch;
+      for (int i=0; i<2; ++i)
+      {
+        if (pipe_fd[i] != -1)
+        {
+          ::close(pipe_fd[i]);
+        }
+      }
+    }
+
+    bool start(void)
+    {
+      if (ioctl(fd, TIOCMGET, &pins) == -1)
+      {
+        return false;
+      }
+      if (pipe(pipe_fd) == -1)
+      {
+        return false;
+      }
+      for (int i=0; i<2; ++i)
+      {
+        fcntl(pipe_fd[i], F_SETFL, fcntl(pipe_fd[i], F_GETFL) | O_NONBLOCK);
+        fcntl(pipe_fd[i], F_SETFD, FD_CLOEXEC);
+      }
+      watch = new FdWatch(pipe_fd[0], FdWatch::FD_WATCH_RD);
+      watch->activity.connect(mem_fun(*this, &PinWatcher::wakeupReceived));
+
+      int ret = pthread_create(&thread, NULL, threadFunc, this);
+      if (ret != 0)
+      {
+        errno = ret;
+        return false;
+      }
+      thread_started = true;
+      return true;
+    }
+
+  private:
+    static const char MSG_CHANGED = 'C';
+    static const char MSG_FAILED  = 'F';
+
+    int       fd;
+    int       pipe_fd[2];
+    pthread_t thread;
+    bool      thread_started;
+    int       pins;
+    FdWatch   *watch;
+    Timer     poll_timer;
+
+    void stopThread(void)
+    {
+      if (thread_started)
+      {
+        pthread_cancel(thread);
+        pthread_join(thread, NULL);
+        thread_started = false;
+      }
+    }
+
+    void wakeupReceived(FdWatch *w)
+    {
+      bool failed = false;
+      char buf[16];
+      ssize_t cnt;
+      while ((cnt = ::read(pipe_fd[0], buf, sizeof(buf))) > 0)
+      {
+        failed = failed || (memchr(buf, MSG_FAILED, cnt) != 0);
+      }
+      if (failed)
+      {
+        stopThread();
+        poll_timer.setEnable(true);
+      }
+      checkPins();
+    }
+
+    void checkPins(void)
+    {
+      int new_pins = 0;
+      if (ioctl(fd, TIOCMGET, &new_pins) == -1)
+      {
+        return;
+      }
+      int changed = (new_pins ^ pins) & PIN_WATCH_MASK;
+      if (changed != 0)
+      {
+        pins = new_pins;
+        pinsChanged(pins, changed);
+      }
+    }
+
+    static void *threadFunc(void *arg)
+    {
+      PinWatcher *self = static_cast<PinWatcher *>(arg);
+      for (;;)
+      {
+          // The ioctl is not a cancellation point so asynchronous
+          // cancellation is only enabled while blocking in it
+        int oldtype;
+        pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &oldtype);
+        int ret = ioctl(self->fd, TIOCMIWAIT, PIN_WATCH_MASK);
+        int saved_errno = errno;
+        pthread_setcanceltype(oldtype, NULL);
+        if ((ret == -1) && (saved_errno == EINTR))
+        {
+          continue;
+        }
+        const char msg = (ret == -1) ? MSG_FAILED : MSG_CHANGED;
+        if ((::write(self->pipe_fd[1], &msg, 1) == -1) && (errno != EAGAIN))
+        {
+          break;
+        }
+        if (ret == -1)
+        {
+          break;
+        }
+      }
+      return NULL;
+    }
+
+};  /* class Serial::PinWatcher */
+
 
 
 /****************************************************************************
@@ -140,7 +300,8 @@ using namespace Async;
  *------------------------------------------------------------------------
  */
 Serial::Serial(const string& serial_port)
-  : serial_port(serial_port), canonical(false), fd(-1), port_settings(), dev(0)
+  : serial_port(serial_port), canonical(false), min_chars(1), fd(-1),
+    port_settings(), dev(0), pin_watcher(0)
 {
 
 } /* Serial::Serial */
@@ -410,6 +571,9 @@ bool Serial::close(void)
     return true;
   }
   
+  delete pin_watcher;
+  pin_watcher = 0;
+  
   bool success = SerialDevice::close(dev);
   dev = 0;
   fd = -1;
@@ -432,8 +596,8 @@ bool Serial::setCanonical(bool canonical)
     else
     {
       port_settings.c_lflag &= ~ICANON;
-      //port_settings.c_cc[VMIN] = 80;
-      //port_settings.c_cc[VTIME] = 1;
+      port_settings.c_cc[VMIN] = min_chars;
+      port_settings.c_cc[VTIME] = 0;
     }
 
     if (tcsetattr(fd, TCSAFLUSH, &port_settings) == -1)
@@ -447,6 +611,89 @@ bool Serial::setCanonical(bool canonical)
 } /* Serial::setCanonical */
 
 
+bool Serial::setMinCharacters(int cnt)
+{
+  if ((cnt < 1) || (cnt > 255))
+  {
+    errno = EINVAL;
+    return false;
+  }
+  min_chars = cnt;
+
+  if ((fd != -1) && !canonical)
+  {
+    return setCanonical(false);
+  }
+
+  return true;
+
+} /* Serial::setMinCharacters */
+
+
+bool Serial::setLowLatency(bool enable)
+{
+  if (fd == -1)
+  {
+    errno = EBADF;
+    return false;
+  }
+
+  bool success = false;
+  int saved_errno = 0;
+
+#if defined(TIOCGSERIAL) && defined(ASYNC_LOW_LATENCY)
+  struct serial_struct serinfo;
+  if (ioctl(fd, TIOCGSERIAL, &serinfo) == 0)
+  {
+    if (enable)
+    {
+      serinfo.flags |= ASYNC_LOW_LATENCY;
+    }
+    else
+    {
+      serinfo.flags &= ~ASYNC_LOW_LATENCY;
+    }
+    success = (ioctl(fd, TIOCSSERIAL, &serinfo) == 0);
+  }
+  if (!success)
+  {
+    saved_errno = errno;
+  }
+#else
+  saved_errno = ENOTSUP;
+#endif
+
+    // FTDI adapters have a latency timer that may be set through sysfs.
+    // The device name is resolved first since symlinks like the ones in
+    // /dev/serial/by-id are often used.
+  char real_port[PATH_MAX];
+  if (realpath(serial_port.c_str(), real_port) != 0)
+  {
+    const char *name = strrchr(real_port, '/');
+    name = (name != 0) ? name + 1 : real_port;
+    string path = string("/sys/class/tty/") + name + "/device/latency_timer";
+    int timer_fd = ::open(path.c_str(), O_WRONLY);
+    if (timer_fd != -1)
+    {
+      const char *value = enable ? "1" : "16";
+      if (::write(timer_fd, value, strlen(value)) != -1)
+      {
+        success = true;
+      }
+      ::close(timer_fd);
+    }
+  }
+
+  if (!success)
+  {
+    errno = saved_errno;
+  }
+
+  return success;
+
+} /* Serial::setLowLatency */
+
+
 bool Serial::stopInput(bool stop)
 {
   return tcflow(fd, stop ? TCIOFF : TCION) == 0;
@@ -529,6 +776,42 @@ bool Serial::getPin(Pin pin, bool &is_set)
 } /* Serial::getPin */
 
 
+bool Serial::setPinNotify(bool enable)
+{
+  if (!enable)
+  {
+    delete pin_watcher;
+    pin_watcher = 0;
+    return true;
+  }
+
+  if (pin_watcher != 0)
+  {
+    return true;
+  }
+  
+  if (fd == -1)
+  {
+    errno = EBADF;
+    return false;
+  }
+
+  pin_watcher = new PinWatcher(fd);
+  if (!pin_watcher->start())
+  {
+    int errno_tmp = errno;
+    delete pin_watcher;
+    pin_watcher = 0;
+    errno = errno_tmp;
+    return false;
+  }
+  pin_watcher->pinsChanged.connect(mem_fun(*this, &Serial::pinsChanged));
+  
+  return true;
+  
+} /* Serial::setPinNotify */
+
+
 
 
 /****************************************************************************
@@ -575,6 +858,23 @@ bool Serial::getPin(Pin pin, bool &is_set)
  * Bugs:      
  *----------------------------------------------------------------------------
  */
+void Serial::pinsChanged(int pins, int changed)
+{
+  static const struct { Pin pin; int mask; } pin_map[] =
+  {
+    { PIN_CTS, TIOCM_CTS },
+    { PIN_DSR, TIOCM_DSR },
+    { PIN_DCD, TIOCM_CD },
+    { PIN_RI,  TIOCM_RI }
+  };
+  for (size_t i=0; i<sizeof(pin_map)/sizeof(*pin_map); ++i)
+  {
+    if ((changed & pin_map[i].mask) != 0)
+    {
+      pinChanged(pin_map[i].pin, (pins & pin_map[i].mask) != 0);
+    }
+  }
+} /* Serial::pinsChanged */
 
 
 
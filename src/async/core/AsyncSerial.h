@@ -264,6 +264,44 @@ class Serial : public sigc::trackable
      */
     bool setCanonical(bool canonical);
     
+    /**
+     * @brief   Set the number of characters to wait for before reading
+     * @param   cnt The minimum number of characters to read at once
+     * @return	Return \em true on success or else \em false on failue. On
+     *	      	failure the global variable \em errno will be set to indicate
+     *	      	the cause of the error.
+     *
+     * In non-canonical mode the charactersReceived signal is normally emitted
+     * as soon as a single character has been received. Setting a higher count
+     * make the kernel hold back the data until at least \em cnt characters
+     * are available (the VMIN setting, with VTIME set to zero) so that bulk
+     * data is delivered in fewer and larger chunks. Since there is no timeout,
+     * only use this when the data is known to arrive in chunks of at least
+     * this size. The count is limited to 255. The default is 1.
+     *
+     * This function may be called both before or after the port has been
+     * opened and the setting is remembered after a close.
+     */
+    bool setMinCharacters(int cnt);
+
+    /**
+     * @brief   Enable or disable low latency mode for the serial port
+     * @param   enable Set to \em true to enable or \em false to disable
+     * @return	Return \em true on success or else \em false on failue. On
+     *	      	failure the global variable \em errno will be set to indicate
+     *	      	the cause of the error.
+     *
+     * USB serial adapters normally buffer received data, and input pin
+     * changes, for up to 16ms before sending them to the host. Enabling low
+     * latency mode set the ASYNC_LOW_LATENCY flag on the port. For FTDI
+     * adapters the latency_timer in sysfs is also set to 1ms, or back to
+     * 16ms when disabled, if it is writable. This reduce the delay for
+     * squelch input pins considerably at the cost of more USB traffic.
+     * Success is returned if at least one of the settings could be changed.
+     * The port must be open and the setting is not restored on close.
+     */
+    bool setLowLatency(bool enable);
+
     /**
      * @brief 	Stop/start input of data
      * @param 	stop  Stop input if \em true or start input if \em false
@@ -302,6 +340,23 @@ class Serial : public sigc::trackable
      */
     bool getPin(Pin pin, bool &is_set);
 
+    /**
+     * @brief   Enable or disable notification of input pin changes
+     * @param   enable Set to \em true to enable or \em false to disable
+     * @return  Return \em true on success or else \em false on failue. On
+     *          failure the global variable \em errno will be set to indicate
+     *          the cause of the error.
+     *
+     * When enabled, the @ref pinChanged signal is emitted as soon as one of
+     * the input pins (CTS, DSR, DCD or RI) change state. A small helper
+     * thread wait for the change using the TIOCMIWAIT ioctl so there is no
+     * need to poll the pins using @ref getPin. If the serial port driver
+     * does not support TIOCMIWAIT, the pins are polled every 10ms instead.
+     * The serial port must be open before notifications can be enabled.
+     * Notifications are disabled when the port is closed.
+     */
+    bool setPinNotify(bool enable);
+
     /**
      * @brief 	A signal that is emitted when there is data to read
      * @param 	buf   A buffer containing the data that has been read
@@ -313,6 +368,15 @@ class Serial : public sigc::trackable
      * but the null is not included in the count.
      */
     sigc::signal<void, char*, int> charactersReceived;
+
+    /**
+     * @brief   A signal that is emitted when an input pin change state
+     * @param   pin     The pin that changed state. See @ref Serial::Pin.
+     * @param   is_set  \em true if the pin is now set
+     *
+     * This signal is only emitted if enabled using @ref setPinNotify.
+     */
+    sigc::signal<void, Pin, bool> pinChanged;
     
       
   protected:
@@ -320,11 +384,17 @@ class Serial : public sigc::trackable
   private:    
     const std::string	serial_port;
     bool      	      	canonical;
+    int                 min_chars;
     
     int       	      	fd;
     struct termios    	port_settings;
     SerialDevice      	*dev;
     
+    class PinWatcher;
+    PinWatcher          *pin_watcher;
+
+    void pinsChanged(int pins, int changed);
+    
 
 };  /* class Serial */
 
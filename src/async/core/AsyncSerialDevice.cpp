@@ -148,7 +148,10 @@ SerialDevice *SerialDevice::open(const string& port, bool flush)
   {
     if (!dev->openPort(flush))
     {
+      int errno_tmp = errno;
+      dev_map.erase(port);
       delete dev;
+      errno = errno_tmp;
       dev = 0;
     }
   }
@@ -0,0 +1,348 @@
+/**
+@file	 AsyncSslContext.cpp
+@brief   TLS configuration shared by many TCP connections
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+#include <arpa/inet.h>
+
+#include <iostream>
+#include <fstream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncSslContext.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+namespace {
+  const unsigned char SESSION_ID_CONTEXT[] = "Async::SslContext";
+};
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+SslContext::SslContext(Role role)
+  : m_role(role), m_ctx(0), m_verify_peer(false)
+{
+  m_ctx = SSL_CTX_new((role == ROLE_SERVER) ? TLS_server_method()
+                                            : TLS_client_method());
+  if (m_ctx == 0)
+  {
+    cerr << "*** ERROR: Could not create TLS context: " << lastError() << endl;
+    return;
+  }
+  SSL_CTX_set_app_data(m_ctx, this);
+  SSL_CTX_set_min_proto_version(m_ctx, TLS1_2_VERSION);
+
+  if (role == ROLE_SERVER)
+  {
+      // Session tickets are enabled by default. The ticket keys are
+      // generated when the context is created so tickets are valid for as
+      // long as this context exist.
+    SSL_CTX_set_session_id_context(m_ctx, SESSION_ID_CONTEXT,
+                                   sizeof(SESSION_ID_CONTEXT) - 1);
+  }
+  else
+  {
+      // Sessions are stored per server address in m_sessions instead of in
+      // the internal cache
+    SSL_CTX_set_session_cache_mode(m_ctx,
+        SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(m_ctx, newSessionCallback);
+  }
+} /* SslContext::SslContext */
+
+
+SslContext::~SslContext(void)
+{
+  for (Sessions::iterator it=m_sessions.begin(); it!=m_sessions.end(); ++it)
+  {
+    SSL_SESSION_free((*it).second);
+  }
+  m_sessions.clear();
+  SSL_CTX_free(m_ctx);
+} /* SslContext::~SslContext */
+
+
+bool SslContext::setCertificateFiles(const string& cert_file,
+                                     const string& key_file)
+{
+  if (m_ctx == 0)
+  {
+    return false;
+  }
+  if (SSL_CTX_use_certificate_chain_file(m_ctx, cert_file.c_str()) != 1)
+  {
+    cerr << "*** ERROR: Could not load TLS certificate file \"" << cert_file
+         << "\": " << lastError() << endl;
+    return false;
+  }
+  if (SSL_CTX_use_PrivateKey_file(m_ctx, key_file.c_str(),
+                                  SSL_FILETYPE_PEM) != 1)
+  {
+    cerr << "*** ERROR: Could not load TLS key file \"" << key_file
+         << "\": " << lastError() << endl;
+    return false;
+  }
+  if (SSL_CTX_check_private_key(m_ctx) != 1)
+  {
+    cerr << "*** ERROR: The TLS key in \"" << key_file
+         << "\" does not match the certificate in \"" << cert_file << "\""
+         << endl;
+    return false;
+  }
+  return true;
+} /* SslContext::setCertificateFiles */
+
+
+bool SslContext::setCaCertificateFile(const string& ca_file)
+{
+  if (m_ctx == 0)
+  {
+    return false;
+  }
+  if (SSL_CTX_load_verify_locations(m_ctx, ca_file.c_str(), 0) != 1)
+  {
+    cerr << "*** ERROR: Could not load TLS CA certificate file \"" << ca_file
+         << "\": " << lastError() << endl;
+    return false;
+  }
+  int mode = SSL_VERIFY_PEER;
+  if (m_role == ROLE_SERVER)
+  {
+    mode |= SSL_VERIFY_FAIL_IF_NO_PEER_CERT;
+  }
+  SSL_CTX_set_verify(m_ctx, mode, 0);
+  m_verify_peer = true;
+  return true;
+} /* SslContext::setCaCertificateFile */
+
+
+bool SslContext::setSessionTicketKeyFile(const string& key_file)
+{
+  if (m_ctx == 0)
+  {
+    return false;
+  }
+  ifstream is(key_file.c_str(), ios::binary);
+  char keys[TICKET_KEY_FILE_SIZE];
+  if (!is.read(keys, sizeof(keys)))
+  {
+    cerr << "*** ERROR: Could not read " << TICKET_KEY_FILE_SIZE
+         << " bytes from TLS session ticket key file \"" << key_file << "\""
+         << endl;
+    return false;
+  }
+  if (SSL_CTX_set_tlsext_ticket_keys(m_ctx, keys, sizeof(keys)) != 1)
+  {
+    cerr << "*** ERROR: Could not set TLS session ticket keys: "
+         << lastError() << endl;
+    return false;
+  }
+  return true;
+} /* SslContext::setSessionTicketKeyFile */
+
+
+SSL *SslContext::createSsl(const string *session_key, const string& host_name)
+{
+  if (m_ctx == 0)
+  {
+    return 0;
+  }
+  SSL *ssl = SSL_new(m_ctx);
+  if (ssl == 0)
+  {
+    return 0;
+  }
+  SSL_set_app_data(ssl, const_cast<string*>(session_key));
+  if ((m_role == ROLE_CLIENT) && !host_name.empty())
+  {
+      // SNI is only allowed for host names. The name or address is also
+      // checked against the server certificate if peer verification has
+      // been enabled by loading CA certificates.
+    bool ok = true;
+    struct in6_addr addr;
+    if ((inet_pton(AF_INET, host_name.c_str(), &addr) == 1) ||
+        (inet_pton(AF_INET6, host_name.c_str(), &addr) == 1))
+    {
+      ok = (X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl),
+                                          host_name.c_str()) == 1);
+    }
+    else
+    {
+      SSL_set_hostflags(ssl, X509_CHECK_FLAG_NO_PARTIAL_WILDCARDS);
+      ok = (SSL_set_tlsext_host_name(ssl, host_name.c_str()) == 1) &&
+           (SSL_set1_host(ssl, host_name.c_str()) == 1);
+    }
+    if (!ok)
+    {
+      SSL_free(ssl);
+      return 0;
+    }
+  }
+  if ((m_role == ROLE_CLIENT) && (session_key != 0))
+  {
+    Sessions::const_iterator it = m_sessions.find(*session_key);
+    if (it != m_sessions.end())
+    {
+      SSL_set_session(ssl, (*it).second);
+    }
+  }
+  return ssl;
+} /* SslContext::createSsl */
+
+
+string SslContext::lastError(void)
+{
+  unsigned long err = ERR_get_error();
+  if (err == 0)
+  {
+    return "Unknown error";
+  }
+  char buf[256];
+  ERR_error_string_n(err, buf, sizeof(buf));
+  ERR_clear_error();
+  return buf;
+} /* SslContext::lastError */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+int SslContext::newSessionCallback(SSL *ssl, SSL_SESSION *session)
+{
+  SslContext *ctx =
+    static_cast<SslContext*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  const string *session_key = static_cast<const string*>(SSL_get_app_data(ssl));
+  if ((ctx == 0) || (session_key == 0))
+  {
+    return 0;
+  }
+
+    // Only the latest session is kept. We take over the reference to the
+    // session by returning 1.
+  SSL_SESSION *&stored = ctx->m_sessions[*session_key];
+  if (stored != 0)
+  {
+    SSL_SESSION_free(stored);
+  }
+  stored = session;
+  return 1;
+} /* SslContext::newSessionCallback */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,270 @@
+/**
+@file	 AsyncSslContext.h
+@brief   TLS configuration shared by many TCP connections
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains a class that hold the TLS configuration, like certificates
+and keys, that is used when TLS is enabled on an Async::TcpConnection. The
+configuration is loaded once and is then shared by all connections using it.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_SSL_CONTEXT_INCLUDED
+#define ASYNC_SSL_CONTEXT_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <openssl/ssl.h>
+
+#include <string>
+#include <map>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	TLS configuration for TCP connections
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+Create one context at startup, load the certificate and key into it and then
+set it on the server or client using setSslContext. Loading certificates is
+expensive so the same context should be used for all connections.
+
+Session resumption is enabled so that a client that reconnect to the same
+server can skip the full handshake. A server context send session tickets to
+its clients. A client context remember the last session for each server
+address and try to resume it on the next connection.
+
+If a CA certificate file is set, the peer must present a certificate signed
+by one of the CAs in the file. For a client this mean that the server
+certificate is verified. For a server it mean that clients must present a
+certificate. The host name in the server certificate is not checked.
+
+\code
+Async::SslContext ctx(Async::SslContext::ROLE_SERVER);
+if (!ctx.setCertificateFiles("/etc/ssl/cert.pem", "/etc/ssl/key.pem"))
+{
+  exit(1);
+}
+server->setSslContext(&ctx);
+\endcode
+*/
+class SslContext
+{
+  public:
+    /**
+     * @brief The side of the connection that the context is used for
+     */
+    typedef enum
+    {
+      ROLE_CLIENT,  ///< Used for connections that we initiate
+      ROLE_SERVER   ///< Used for accepted connections
+    } Role;
+
+    /**
+     * @brief   Constructor
+     * @param   role  The side of the connection that the context is used for
+     */
+    explicit SslContext(Role role);
+
+    /**
+     * @brief   Destructor
+     *
+     * All connections using the context must have been deleted first.
+     */
+    ~SslContext(void);
+
+    /**
+     * @brief   Check if the context was successfully created
+     * @return  Returns \em true on success or else \em false
+     */
+    bool initOk(void) const { return m_ctx != 0; }
+
+    /**
+     * @brief   Get the role of this context
+     * @return  Returns the role given to the constructor
+     */
+    Role role(void) const { return m_role; }
+
+    /**
+     * @brief   Load the certificate and private key
+     * @param   cert_file The PEM file containing the certificate chain
+     * @param   key_file  The PEM file containing the private key
+     * @return  Returns \em true on success or else \em false
+     *
+     * A server context must have a certificate. For a client context it is
+     * only needed if the server require client certificates.
+     */
+    bool setCertificateFiles(const std::string& cert_file,
+                             const std::string& key_file);
+
+    /**
+     * @brief   Load the CA certificates used to verify the peer
+     * @param   ca_file The PEM file containing the CA certificates
+     * @return  Returns \em true on success or else \em false
+     *
+     * After this call, a connection is only established if the peer present
+     * a certificate that can be verified using the given CA certificates.
+     */
+    bool setCaCertificateFile(const std::string& ca_file);
+
+    /**
+     * @brief   Check if the peer certificate is verified
+     * @return  Returns \em true if CA certificates have been loaded
+     */
+    bool verifiesPeer(void) const { return m_verify_peer; }
+
+    /**
+     * @brief   Load the keys used to encrypt session tickets
+     * @param   key_file  A file containing TICKET_KEY_FILE_SIZE random bytes
+     * @return  Returns \em true on success or else \em false
+     *
+     * By default a server context create random ticket keys so tickets
+     * cannot be used after a server restart. Loading the keys from a file
+     * make clients able to resume their sessions when they reconnect after
+     * a restart, which is when most clients reconnect at the same time. The
+     * file can be created using "head -c 80 /dev/urandom > file" and must be
+     * kept secret.
+     */
+    bool setSessionTicketKeyFile(const std::string& key_file);
+
+    /**
+     * @brief   Create a new TLS session object
+     * @param   session_key Identify the peer for session resumption
+     * @param   host_name   The host name or IP address of the server
+     * @return  Returns a new SSL object or 0 on failure
+     *
+     * This function is used by Async::TcpConnection. For a client context, a
+     * remembered session for the given key is set on the new object and new
+     * sessions are stored under the same key. The key must stay valid for as
+     * long as the returned object exist.
+     *
+     * For a client context, a host name is sent to the server using SNI. When
+     * CA certificates have been loaded, the server certificate must also
+     * match the given host name or IP address.
+     */
+    SSL *createSsl(const std::string *session_key,
+                   const std::string& host_name=std::string());
+
+    /**
+     * @brief   Get the last error from the TLS library as a string
+     * @return  Returns an error message
+     */
+    static std::string lastError(void);
+
+    /**
+     * @brief The size of a session ticket key file in bytes
+     */
+    static const size_t TICKET_KEY_FILE_SIZE = 80;
+
+  private:
+    typedef std::map<std::string, SSL_SESSION*> Sessions;
+
+    Role      m_role;
+    SSL_CTX*  m_ctx;
+    bool      m_verify_peer;
+    Sessions  m_sessions;
+
+    SslContext(const SslContext&);
+    SslContext& operator=(const SslContext&);
+    static int newSessionCallback(SSL *ssl, SSL_SESSION *session);
+
+};  /* class SslContext */
+
+
+} /* namespace */
+
+#endif /* ASYNC_SSL_CONTEXT_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
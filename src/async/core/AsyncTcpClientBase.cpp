@@ -101,6 +101,7 @@ using namespace Async;
 
 namespace {
   void deleteDnsObject(DnsLookup *dns) { delete dns; }
+  void deleteFdWatch(FdWatch *watch) { delete watch; }
 };
 
 
@@ -129,16 +130,20 @@ namespace {
 
 
 TcpClientBase::TcpClientBase(TcpConnection *con)
-  : con(con), dns(0), sock(-1), wr_watch(0)
+  : con(con), dns(0), next_addr(0),
+    attempt_timer(DEFAULT_CONNECT_ATTEMPT_DELAY, Timer::TYPE_ONESHOT, false),
+    last_errno(0)
 {
-  wr_watch = new FdWatch;
-  wr_watch->activity.connect(mem_fun(*this, &TcpClientBase::connectHandler));
+  attempt_timer.expired.connect(
+      sigc::hide(mem_fun(*this, &TcpClientBase::startNextAttempt)));
 } /* TcpClientBase::TcpClientBase */
 
 
 TcpClientBase::TcpClientBase(TcpConnection *con, const string& remote_host,
                              uint16_t remote_port)
-  : con(con), dns(0), remote_host(remote_host), sock(-1), wr_watch(0)
+  : con(con), dns(0), remote_host(remote_host), next_addr(0),
+    attempt_timer(DEFAULT_CONNECT_ATTEMPT_DELAY, Timer::TYPE_ONESHOT, false),
+    last_errno(0)
 {
   IpAddress ip_addr(remote_host);
   if (!ip_addr.isEmpty())
@@ -147,27 +152,27 @@ TcpClientBase::TcpClientBase(TcpConnection *con, const string& remote_host,
     this->remote_host = ip_addr.toString();
   }
   con->setRemotePort(remote_port);
-  wr_watch = new FdWatch;
-  wr_watch->activity.connect(mem_fun(*this, &TcpClientBase::connectHandler));
+  attempt_timer.expired.connect(
+      sigc::hide(mem_fun(*this, &TcpClientBase::startNextAttempt)));
 } /* TcpClientBase::TcpClientBase */
 
 
 TcpClientBase::TcpClientBase(TcpConnection *con, const IpAddress& remote_ip,
                              uint16_t remote_port)
-  : con(con), dns(0), remote_host(remote_ip.toString()), sock(-1), wr_watch(0)
+  : con(con), dns(0), remote_host(remote_ip.toString()), next_addr(0),
+    attempt_timer(DEFAULT_CONNECT_ATTEMPT_DELAY, Timer::TYPE_ONESHOT, false),
+    last_errno(0)
 {
   con->setRemoteAddr(remote_ip);
   con->setRemotePort(remote_port);
-  wr_watch = new FdWatch;
-  wr_watch->activity.connect(mem_fun(*this, &TcpClientBase::connectHandler));
+  attempt_timer.expired.connect(
+      sigc::hide(mem_fun(*this, &TcpClientBase::startNextAttempt)));
 } /* TcpClientBase::TcpClientBase */
 
 
 TcpClientBase::~TcpClientBase(void)
 {
   disconnect();
-  delete wr_watch;
-  wr_watch = 0;
 } /* TcpClientBase::~TcpClientBase */
 
 
@@ -204,11 +209,13 @@ void TcpClientBase::connect(void)
 {
     // Do nothing if DNS lookup is pending, connection is pending or if the
     // connection is already established
-  if ((dns != 0) || (sock != -1) || (con->socket() != -1))
+  if ((dns != 0) || !attempts.empty() || (con->socket() != -1))
   {
     return;
   }
 
+  con->setSslHostName(remote_host);
+
   if (con->remoteHost().isEmpty() ||
       (remote_host != con->remoteHost().toString()))
   {
@@ -225,16 +232,17 @@ void TcpClientBase::connect(void)
 
 void TcpClientBase::disconnect(void)
 {
-  wr_watch->setEnabled(false);
+  attempt_timer.setEnable(false);
 
   delete dns;
   dns = 0;
   
-  if (sock != -1)
+  while (!attempts.empty())
   {
-    ::close(sock);
-    sock = -1;
+    removeAttempt(attempts.begin());
   }
+  addrs.clear();
+  next_addr = 0;
 } /* TcpClientBase::disconnect */
 
 
@@ -268,114 +276,203 @@ void TcpClientBase::dnsResultsReady(DnsLookup& dns_lookup)
     return;
   }
   
-  con->setRemoteAddr(result[0]);
+    // Try the addresses alternating between the address families, starting
+    // with the family of the first address
+  vector<IpAddress> first, second;
+  for (vector<IpAddress>::const_iterator it = result.begin();
+       it != result.end(); ++it)
+  {
+    ((*it).family() == result[0].family() ? first : second).push_back(*it);
+  }
+  addrs.clear();
+  for (size_t i=0; i<max(first.size(), second.size()); ++i)
+  {
+    if (i < first.size())
+    {
+      addrs.push_back(first[i]);
+    }
+    if (i < second.size())
+    {
+      addrs.push_back(second[i]);
+    }
+  }
+  next_addr = 0;
+  con->setRemoteAddr(addrs[0]);
   
-  connectToRemote();
+  startNextAttempt();
 } /* TcpClientBase::dnsResultsReady */
 
 
 void TcpClientBase::connectToRemote(void)
 {
-  assert(sock == -1);
-  
-  struct sockaddr_in addr;
-  memset(&addr, 0, sizeof(addr));
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(con->remotePort());
-  addr.sin_addr = con->remoteHost().ip4Addr();
-
-    /* Create a TCP/IP socket to use */
-  sock = ::socket(PF_INET, SOCK_STREAM, 0);
-  if (sock == -1)
+  assert(attempts.empty());
+  addrs.assign(1, con->remoteHost());
+  next_addr = 0;
+  startNextAttempt();
+} /* TcpClientBase::connectToRemote */
+
+
+void TcpClientBase::startNextAttempt(void)
+{
+  attempt_timer.setEnable(false);
+  while (next_addr < addrs.size())
+  {
+    IpAddress addr = addrs[next_addr++];
+    int result = startAttempt(addr);
+    if (result > 0)
+    {
+        // Connected at once. This object may have been deleted.
+      return;
+    }
+    else if (result == 0)
+    {
+      if (next_addr < addrs.size())
+      {
+        attempt_timer.setEnable(true);
+      }
+      return;
+    }
+  }
+
+  if (attempts.empty())
   {
+    addrs.clear();
+    next_addr = 0;
+    errno = last_errno;
     con->onDisconnected(TcpConnection::DR_SYSTEM_ERROR);
-    return;
+  }
+} /* TcpClientBase::startNextAttempt */
+
+
+int TcpClientBase::startAttempt(const IpAddress& addr)
+{
+  struct sockaddr_storage remote_addr;
+  socklen_t remote_addr_len = addr.toSockAddr(remote_addr, con->remotePort());
+
+    /* Create a TCP/IP socket of the same family as the remote address */
+  int sock = ::socket(addr.family(), SOCK_STREAM, 0);
+  if (sock == -1)
+  {
+    last_errno = errno;
+    return -1;
   }
 
     /* Setup non-blocking operation */
   if (fcntl(sock, F_SETFL, O_NONBLOCK))
   {
-    int errno_tmp = errno;
-    disconnect();
-    errno = errno_tmp;
-    con->onDisconnected(TcpConnection::DR_SYSTEM_ERROR);
-    return;
+    last_errno = errno;
+    ::close(sock);
+    return -1;
   }
 
   if (!bind_ip.isEmpty())
   {
-    struct sockaddr_in addr = { 0 };
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(0);
-    addr.sin_addr = bind_ip.ip4Addr();
-    if (::bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    struct sockaddr_storage local_addr;
+    socklen_t local_addr_len = bind_ip.toSockAddr(local_addr, 0,
+                                                  addr.family());
+    if (local_addr_len == 0)
     {
-      int errno_tmp = errno;
-      disconnect();
-      errno = errno_tmp;
-      con->onDisconnected(TcpConnection::DR_SYSTEM_ERROR);
-      return;
+      errno = EAFNOSUPPORT;
+    }
+    if ((local_addr_len == 0) ||
+        (::bind(sock, (struct sockaddr *)&local_addr, local_addr_len) != 0))
+    {
+      last_errno = errno;
+      ::close(sock);
+      return -1;
     }
   }
     
     /* Connect to the server */
-  int result = ::connect(sock, reinterpret_cast<struct sockaddr *>(&addr),
-                         sizeof(addr));
+  int result = ::connect(sock,
+                         reinterpret_cast<struct sockaddr *>(&remote_addr),
+                         remote_addr_len);
   if (result == -1)
   {
-    if (errno == EINPROGRESS)
+    if (errno != EINPROGRESS)
     {
-      wr_watch->setFd(sock, FdWatch::FD_WATCH_WR);
-      wr_watch->setEnabled(true);
-    }
-    else
-    {
-      int errno_tmp = errno;
-      disconnect();
-      errno = errno_tmp;
-      con->onDisconnected(TcpConnection::DR_SYSTEM_ERROR);
-      return;
+      last_errno = errno;
+      ::close(sock);
+      return -1;
     }
+    Attempt attempt;
+    attempt.sock = sock;
+    attempt.watch = new FdWatch(sock, FdWatch::FD_WATCH_WR);
+    attempt.watch->activity.connect(
+        mem_fun(*this, &TcpClientBase::connectHandler));
+    attempt.addr = addr;
+    attempts.push_back(attempt);
+    return 0;
   }
-  else
+
+  connectionEstablished(sock, addr);
+  return 1;
+} /* TcpClientBase::startAttempt */
+
+
+void TcpClientBase::removeAttempt(list<Attempt>::iterator it, bool close_sock)
+{
+    // The watch may be the one currently signalling so it is deleted later
+  (*it).watch->setEnabled(false);
+  Application::app().runTask(sigc::bind(&deleteFdWatch, (*it).watch));
+  if (close_sock)
   {
-    con->setSocket(sock);
-    sock = -1;
-    
-    connected();
+    ::close((*it).sock);
   }
-
-} /* TcpClientBase::connectToRemote */
+  attempts.erase(it);
+} /* TcpClientBase::removeAttempt */
 
 
 void TcpClientBase::connectHandler(FdWatch *watch)
 {
-  wr_watch->setEnabled(false);
-  
+  list<Attempt>::iterator it = attempts.begin();
+  while ((it != attempts.end()) && ((*it).watch != watch))
+  {
+    ++it;
+  }
+  assert(it != attempts.end());
+
   int error;
   socklen_t error_size = sizeof(error);
-  if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &error_size) == -1)
+  if (getsockopt((*it).sock, SOL_SOCKET, SO_ERROR, &error, &error_size) == -1)
   {
-    int errno_tmp = errno;
-    disconnect();
-    errno = errno_tmp;
-    con->onDisconnected(TcpConnection::DR_SYSTEM_ERROR);
-    return;
+    error = errno;
   }
   if (error)
   {
-    disconnect();
-    errno = error;
-    con->onDisconnected(TcpConnection::DR_SYSTEM_ERROR);
+    last_errno = error;
+    removeAttempt(it);
+    if (attempts.empty() || (next_addr < addrs.size()))
+    {
+      startNextAttempt();
+    }
     return;
   }
   
+    // Hand the socket over to the connection and abort all other attempts
+  int sock = (*it).sock;
+  IpAddress addr = (*it).addr;
+  removeAttempt(it, false);
+  connectionEstablished(sock, addr);
+  
+} /* TcpClientBase::connectHandler */
+
+
+void TcpClientBase::connectionEstablished(int sock, const IpAddress& addr)
+{
+  attempt_timer.setEnable(false);
+  while (!attempts.empty())
+  {
+    removeAttempt(attempts.begin());
+  }
+  addrs.clear();
+  next_addr = 0;
+
+  con->setRemoteAddr(addr);
   con->setSocket(sock);
-  sock = -1;
   
   connected();
-  
-} /* TcpClientBase::connectHandler */
+} /* TcpClientBase::connectionEstablished */
 
 
 
@@ -41,6 +41,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <stdint.h>
 
 #include <string>
+#include <vector>
+#include <list>
 
 
 /****************************************************************************
@@ -50,6 +52,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncTcpConnection.h>
+#include <AsyncTimer.h>
 
 
 /****************************************************************************
@@ -121,6 +124,11 @@ not be used direclt but rather the TcpClient class should be used.
 class TcpClientBase
 {
   public:
+    /**
+     * @brief   The default delay between staggered connection attempts
+     */
+    static const unsigned DEFAULT_CONNECT_ATTEMPT_DELAY = 250;
+
     /**
      * @brief   Constructor
      * @param 	con The connection object associated with this client
@@ -170,6 +178,24 @@ class TcpClientBase
      */
     void bind(const IpAddress& bind_ip);
 
+    /**
+     * @brief   Set the delay between staggered connection attempts
+     * @param   delay_ms The delay in milliseconds
+     *
+     * When the remote host name resolve to more than one address, a
+     * connection attempt is started to the first address. If it has not
+     * succeeded or failed within the given delay, an attempt to the next
+     * address is started in parallel, and so on. The first attempt that
+     * succeed is used and all others are aborted. If an attempt fail, the
+     * next one is started at once. The addresses are tried alternating between
+     * IPv4 and IPv6, like the "happy eyeballs" algorithm (RFC 8305).
+     * The default is DEFAULT_CONNECT_ATTEMPT_DELAY.
+     */
+    void setConnectAttemptDelay(unsigned delay_ms)
+    {
+      attempt_timer.setTimeout(delay_ms);
+    }
+
     /**
      * @brief 	Connect to the remote host
      * @param 	remote_host   The hostname of the remote host
@@ -200,7 +226,9 @@ class TcpClientBase
      * This function will initiate a connection to the remote host. The
      * connection must not be written to before the connected signal
      * (see @ref TcpClient::connected) has been emitted. If the connection is
-     * already established or pending, nothing will be done.
+     * already established or pending, nothing will be done. If the host name
+     * resolve to many addresses they are all tried, see
+     * setConnectAttemptDelay.
      */
     void connect(void);
 
@@ -219,7 +247,7 @@ class TcpClientBase
      *
      * A connection being idle means that it is not connected nor connecting.
      */
-    bool isIdle(void) const { return (sock == -1); }
+    bool isIdle(void) const { return attempts.empty(); }
 
     /**
      * @brief 	A signal that is emitted when a connection has been established
@@ -229,16 +257,31 @@ class TcpClientBase
   protected:
 
   private:
-    TcpConnection *   con;
-    DnsLookup *       dns;
-    std::string       remote_host;
-    int       	      sock;
-    FdWatch *         wr_watch;
-    Async::IpAddress  bind_ip;
+    struct Attempt
+    {
+      int               sock;
+      FdWatch *         watch;
+      Async::IpAddress  addr;
+    };
+
+    TcpConnection *               con;
+    DnsLookup *                   dns;
+    std::string                   remote_host;
+    Async::IpAddress              bind_ip;
+    std::vector<Async::IpAddress> addrs;
+    size_t                        next_addr;
+    std::list<Attempt>            attempts;
+    Timer                         attempt_timer;
+    int                           last_errno;
 
     void dnsResultsReady(DnsLookup& dns_lookup);
     void connectToRemote(void);
+    void startNextAttempt(void);
+    int startAttempt(const IpAddress& addr);
+    void removeAttempt(std::list<Attempt>::iterator it,
+                       bool close_sock=true);
     void connectHandler(FdWatch *watch);
+    void connectionEstablished(int sock, const IpAddress& addr);
 
 };  /* class TcpClientBase */
 
@@ -35,13 +35,19 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <assert.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <iostream>
 
 
 /****************************************************************************
@@ -61,6 +67,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "AsyncFdWatch.h"
 #include "AsyncDnsLookup.h"
 #include "AsyncTcpConnection.h"
+#include "AsyncSslContext.h"
 
 
 
@@ -163,13 +170,17 @@ const char *TcpConnection::disconnectReasonStr(DisconnectReason reason)
  *------------------------------------------------------------------------
  */
 TcpConnection::TcpConnection(size_t recv_buf_len)
-  : remote_port(0), recv_buf_len(recv_buf_len), sock(-1), rd_watch(0),
-    wr_watch(0), recv_buf(0), recv_buf_cnt(0)
+  : remote_port(0), recv_buf_len(recv_buf_len),
+    recv_buf_max_len(recv_buf_len), sock(-1), rd_watch(0), wr_watch(0),
+    recv_buf(0), recv_buf_size(recv_buf_len), recv_buf_head(0),
+    recv_buf_cnt(0), ssl_ctx(0), ssl(0)
 {
   recv_buf = new char[recv_buf_len];
   rd_watch = new FdWatch;
+  rd_watch->setLabel("Async::TcpConnection read");
   rd_watch->activity.connect(mem_fun(*this, &TcpConnection::recvHandler));
   wr_watch = new FdWatch;
+  wr_watch->setLabel("Async::TcpConnection write");
   wr_watch->activity.connect(mem_fun(*this, &TcpConnection::writeHandler));
 } /* TcpConnection::TcpConnection */
 
@@ -177,13 +188,16 @@ TcpConnection::TcpConnection(size_t recv_buf_len)
 TcpConnection::TcpConnection(int sock, const IpAddress& remote_addr,
       	      	      	     uint16_t remote_port, size_t recv_buf_len)
   : remote_addr(remote_addr), remote_port(remote_port),
-    recv_buf_len(recv_buf_len), sock(sock), rd_watch(0), wr_watch(0),
-    recv_buf(0), recv_buf_cnt(0)
+    recv_buf_len(recv_buf_len), recv_buf_max_len(recv_buf_len), sock(sock),
+    rd_watch(0), wr_watch(0), recv_buf(0), recv_buf_size(recv_buf_len),
+    recv_buf_head(0), recv_buf_cnt(0), ssl_ctx(0), ssl(0)
 {
   recv_buf = new char[recv_buf_len];
   rd_watch = new FdWatch;
+  rd_watch->setLabel("Async::TcpConnection read");
   rd_watch->activity.connect(mem_fun(*this, &TcpConnection::recvHandler));
   wr_watch = new FdWatch;
+  wr_watch->setLabel("Async::TcpConnection write");
   wr_watch->activity.connect(mem_fun(*this, &TcpConnection::writeHandler));
   setSocket(sock);
 } /* TcpConnection::TcpConnection */
@@ -200,21 +214,45 @@ TcpConnection::~TcpConnection(void)
 
 void TcpConnection::setRecvBufLen(size_t recv_buf_len)
 {
-  if (recv_buf_cnt > recv_buf_len)
+  recv_buf_max_len = max(recv_buf_max_len, recv_buf_len);
+  if (recv_buf_cnt > recv_buf_max_len)
   {
       // This will on next reception cause an overflow error disconnection
-    recv_buf_cnt = recv_buf_len;
+    recv_buf_cnt = recv_buf_max_len;
   }
-  char *new_recv_buf = new char[recv_buf_len];
-  memcpy(new_recv_buf, recv_buf, recv_buf_cnt);
   this->recv_buf_len = recv_buf_len;
-  delete [] recv_buf;
-  recv_buf = new_recv_buf;
+  resizeRecvBuf(max(recv_buf_len, recv_buf_cnt));
 } /* TcpConnection::setRecvBufLen */
 
 
+void TcpConnection::setMaxRecvBufLen(size_t max_len)
+{
+  recv_buf_max_len = max(max_len, recv_buf_len);
+} /* TcpConnection::setMaxRecvBufLen */
+
+
+void TcpConnection::setSslContext(SslContext *ctx)
+{
+  sslStop();
+  ssl_ctx = ctx;
+  if ((ssl_ctx != 0) && (sock != -1) && !sslStart())
+  {
+    disconnect();
+  }
+} /* TcpConnection::setSslContext */
+
+
+bool TcpConnection::sslSessionReused(void) const
+{
+  return (ssl != 0) && (SSL_session_reused(ssl) == 1);
+} /* TcpConnection::sslSessionReused */
+
+
 void TcpConnection::disconnect(void)
 {
+  sslStop();
+
+  recv_buf_head = 0;
   recv_buf_cnt = 0;
   
   wr_watch->setEnabled(false);
@@ -231,6 +269,11 @@ void TcpConnection::disconnect(void)
 int TcpConnection::write(const void *buf, int count)
 {
   assert(sock != -1);
+  if (ssl != 0)
+  {
+    return sslWrite(buf, max(count, 0));
+  }
+
   int cnt = ::send(sock, buf, count, MSG_NOSIGNAL);
   if (cnt < 0)
   {
@@ -252,6 +295,82 @@ int TcpConnection::write(const void *buf, int count)
 } /* TcpConnection::write */
 
 
+int TcpConnection::writev(const struct iovec *iov, int iovcnt)
+{
+  assert(sock != -1);
+  if (ssl != 0)
+  {
+      // Gather the buffers so that they are encrypted as one TLS record
+    ssl_tx_gather.clear();
+    for (int i=0; i<iovcnt; ++i)
+    {
+      const char *ptr = static_cast<const char*>(iov[i].iov_base);
+      ssl_tx_gather.insert(ssl_tx_gather.end(), ptr, ptr + iov[i].iov_len);
+    }
+    return sslWrite(ssl_tx_gather.data(), ssl_tx_gather.size());
+  }
+
+  size_t count = 0;
+  for (int i=0; i<iovcnt; ++i)
+  {
+    count += iov[i].iov_len;
+  }
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = const_cast<struct iovec *>(iov);
+  msg.msg_iovlen = iovcnt;
+  ssize_t cnt = ::sendmsg(sock, &msg, MSG_NOSIGNAL);
+  if (cnt < 0)
+  {
+    if (errno != EAGAIN)
+    {
+      return -1;
+    }
+    cnt = 0;
+  }
+
+  if (static_cast<size_t>(cnt) < count)
+  {
+    sendBufferFull(true);
+    wr_watch->setEnabled(true);
+  }
+
+  return cnt;
+} /* TcpConnection::writev */
+
+
+bool TcpConnection::roundTripTime(double& rtt) const
+{
+#ifdef TCP_INFO
+  if (sock == -1)
+  {
+    return false;
+  }
+  struct tcp_info info;
+  socklen_t len = sizeof(info);
+  if (getsockopt(sock, IPPROTO_TCP, TCP_INFO, &info, &len) != 0)
+  {
+    return false;
+  }
+  rtt = info.tcpi_rtt / 1000000.0;
+  return true;
+#else
+  return false;
+#endif
+} /* TcpConnection::roundTripTime */
+
+
+bool TcpConnection::setSendBufferSize(int size)
+{
+  if (sock == -1)
+  {
+    return false;
+  }
+  return setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size)) == 0;
+} /* TcpConnection::setSendBufferSize */
+
+
 
 /****************************************************************************
  *
@@ -279,6 +398,10 @@ void TcpConnection::setSocket(int sock)
   rd_watch->setEnabled(true);
   wr_watch->setEnabled(false);
   wr_watch->setFd(sock, FdWatch::FD_WATCH_WR);
+  if ((ssl_ctx != 0) && !sslStart())
+  {
+    disconnect();
+  }
 } /* TcpConnection::setSocket */
 
 
@@ -340,19 +463,56 @@ void TcpConnection::setRemotePort(uint16_t remote_port)
  * Bugs:      
  *----------------------------------------------------------------------------
  */
+bool TcpConnection::makeRecvBufRoom(void)
+{
+  if (recv_buf_head > 0)
+  {
+      // Move the unprocessed bytes to the front of the buffer. This is only
+      // done when the end of the buffer has been reached, not after each read.
+    memmove(recv_buf, recv_buf + recv_buf_head, recv_buf_cnt);
+    recv_buf_head = 0;
+    return true;
+  }
+  if (recv_buf_size >= recv_buf_max_len)
+  {
+    return false;
+  }
+  resizeRecvBuf(min(2 * recv_buf_size, recv_buf_max_len));
+  return true;
+} /* TcpConnection::makeRecvBufRoom */
+
+
+void TcpConnection::resizeRecvBuf(size_t size)
+{
+  char *new_recv_buf = new char[size];
+  memcpy(new_recv_buf, recv_buf + recv_buf_head, recv_buf_cnt);
+  delete [] recv_buf;
+  recv_buf = new_recv_buf;
+  recv_buf_size = size;
+  recv_buf_head = 0;
+} /* TcpConnection::resizeRecvBuf */
+
+
 void TcpConnection::recvHandler(FdWatch *watch)
 {
   //cout << "recv_buf_cnt=" << recv_buf_cnt << endl;
-  //cout << "recv_buf_len=" << recv_buf_len << endl;
+  //cout << "recv_buf_size=" << recv_buf_size << endl;
   
-  if (recv_buf_cnt == recv_buf_len)
+  if (ssl != 0)
+  {
+    sslRecvHandler();
+    return;
+  }
+
+  if ((recv_buf_head + recv_buf_cnt == recv_buf_size) && !makeRecvBufRoom())
   {
     disconnect();
     onDisconnected(DR_RECV_BUFFER_OVERFLOW);
     return;
   }
   
-  int cnt = read(sock, recv_buf+recv_buf_cnt, recv_buf_len-recv_buf_cnt);
+  char *tail = recv_buf + recv_buf_head + recv_buf_cnt;
+  int cnt = read(sock, tail, recv_buf_size - recv_buf_head - recv_buf_cnt);
   if (cnt == -1)
   {
     int errno_tmp = errno;
@@ -370,26 +530,294 @@ void TcpConnection::recvHandler(FdWatch *watch)
   }
   
   recv_buf_cnt += cnt;
-  size_t processed = onDataReceived(recv_buf, recv_buf_cnt);
+  processRecvBuf();
+  
+} /* TcpConnection::recvHandler */
+
+
+void TcpConnection::writeHandler(FdWatch *watch)
+{
+  if (ssl != 0)
+  {
+    if (!sslFlush())
+    {
+      int errno_tmp = errno;
+      disconnect();
+      errno = errno_tmp;
+      onDisconnected(DR_SYSTEM_ERROR);
+      return;
+    }
+    if (!ssl_tx_buf.empty())
+    {
+      return;
+    }
+    if (!SSL_is_init_finished(ssl))
+    {
+        // The sendBufferFull signal is emitted when the handshake is done
+      watch->setEnabled(false);
+      return;
+    }
+  }
+
+  watch->setEnabled(false);
+  sendBufferFull(false);
+} /* TcpConnection::writeHandler */
+
+
+void TcpConnection::processRecvBuf(void)
+{
+  size_t processed = onDataReceived(recv_buf + recv_buf_head, recv_buf_cnt);
   //cout << "processed=" << processed << endl;
   if (processed >= recv_buf_cnt)
   {
+    recv_buf_head = 0;
     recv_buf_cnt = 0;
   }
   else
   {
-    memmove(recv_buf, recv_buf + processed, recv_buf_cnt - processed);
-    recv_buf_cnt = recv_buf_cnt - processed;
+      // Just consume the processed bytes. The rest stay where they are until
+      // more data arrive.
+    recv_buf_head += processed;
+    recv_buf_cnt -= processed;
   }
-  
-} /* TcpConnection::recvHandler */
+} /* TcpConnection::processRecvBuf */
 
 
-void TcpConnection::writeHandler(FdWatch *watch)
+bool TcpConnection::sslStart(void)
 {
-  watch->setEnabled(false);
-  sendBufferFull(false);
-} /* TcpConnection::writeHandler */
+  assert(ssl == 0);
+  ssl_session_key = remote_addr.toString() + ":" + to_string(remote_port);
+  ssl = ssl_ctx->createSsl(&ssl_session_key, ssl_host_name);
+  if (ssl == 0)
+  {
+    cerr << "*** ERROR: Could not create TLS session for connection with "
+         << remote_addr << ":" << remote_port << ": "
+         << SslContext::lastError() << endl;
+    return false;
+  }
+
+    // Encrypted data is passed through memory buffers so that the socket
+    // handling is the same as for an unencrypted connection
+  BIO *rbio = BIO_new(BIO_s_mem());
+  BIO *wbio = BIO_new(BIO_s_mem());
+  BIO_set_mem_eof_return(rbio, -1);
+  BIO_set_mem_eof_return(wbio, -1);
+  SSL_set_bio(ssl, rbio, wbio);
+
+  if (ssl_ctx->role() == SslContext::ROLE_SERVER)
+  {
+    SSL_set_accept_state(ssl);
+    return true;
+  }
+
+  SSL_set_connect_state(ssl);
+  ERR_clear_error();
+  SSL_do_handshake(ssl);
+  return sslFlush();
+} /* TcpConnection::sslStart */
+
+
+void TcpConnection::sslStop(void)
+{
+  if (ssl == 0)
+  {
+    return;
+  }
+  if ((sock != -1) && SSL_is_init_finished(ssl))
+  {
+    SSL_shutdown(ssl);
+    sslFlush();
+  }
+  SSL_free(ssl);
+  ssl = 0;
+  ssl_tx_buf.clear();
+  ssl_tx_early.clear();
+} /* TcpConnection::sslStop */
+
+
+int TcpConnection::sslWrite(const void *buf, size_t count)
+{
+  if (ssl_tx_buf.size() + ssl_tx_early.size() >= MAX_SSL_TX_PENDING)
+  {
+    sendBufferFull(true);
+    wr_watch->setEnabled(true);
+    return 0;
+  }
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  if (!SSL_is_init_finished(ssl))
+  {
+    const char *ptr = static_cast<const char*>(buf);
+    ssl_tx_early.insert(ssl_tx_early.end(), ptr, ptr + count);
+    return count;
+  }
+
+  ERR_clear_error();
+  if (SSL_write(ssl, buf, count) <= 0)
+  {
+    errno = EPROTO;
+    return -1;
+  }
+  if (!sslFlush())
+  {
+    return -1;
+  }
+  if (!ssl_tx_buf.empty())
+  {
+    sendBufferFull(true);
+  }
+
+  return count;
+} /* TcpConnection::sslWrite */
+
+
+bool TcpConnection::sslFlush(void)
+{
+  BIO *wbio = SSL_get_wbio(ssl);
+  size_t pending = BIO_ctrl_pending(wbio);
+  if (pending > 0)
+  {
+    size_t len = ssl_tx_buf.size();
+    ssl_tx_buf.resize(len + pending);
+    BIO_read(wbio, &ssl_tx_buf[len], pending);
+  }
+  if (ssl_tx_buf.empty())
+  {
+    return true;
+  }
+
+  ssize_t cnt = ::send(sock, ssl_tx_buf.data(), ssl_tx_buf.size(),
+                       MSG_NOSIGNAL);
+  if (cnt < 0)
+  {
+    if (errno != EAGAIN)
+    {
+      return false;
+    }
+    cnt = 0;
+  }
+  ssl_tx_buf.erase(ssl_tx_buf.begin(), ssl_tx_buf.begin() + cnt);
+  if (!ssl_tx_buf.empty())
+  {
+    wr_watch->setEnabled(true);
+  }
+  return true;
+} /* TcpConnection::sslFlush */
+
+
+void TcpConnection::sslRecvHandler(void)
+{
+  char buf[16384];
+  int cnt = read(sock, buf, sizeof(buf));
+  if (cnt == -1)
+  {
+    int errno_tmp = errno;
+    disconnect();
+    errno = errno_tmp;
+    onDisconnected(DR_SYSTEM_ERROR);
+    return;
+  }
+  else if (cnt == 0)
+  {
+    disconnect();
+    onDisconnected(DR_REMOTE_DISCONNECTED);
+    return;
+  }
+  BIO_write(SSL_get_rbio(ssl), buf, cnt);
+
+  if (!SSL_is_init_finished(ssl))
+  {
+    ERR_clear_error();
+    int ret = SSL_do_handshake(ssl);
+    if (ret != 1)
+    {
+      int err = SSL_get_error(ssl, ret);
+      if ((err != SSL_ERROR_WANT_READ) && (err != SSL_ERROR_WANT_WRITE))
+      {
+        sslError();
+        return;
+      }
+    }
+    else
+    {
+        // Data written during the handshake is sent as one record
+      if (!ssl_tx_early.empty())
+      {
+        if (SSL_write(ssl, ssl_tx_early.data(), ssl_tx_early.size()) <= 0)
+        {
+          sslError();
+          return;
+        }
+        ssl_tx_early.clear();
+      }
+      wr_watch->setEnabled(true);
+    }
+  }
+
+    // Decrypt directly into the receive buffer. More than one buffer full of
+    // data may be available if the receiver is slow.
+  while (SSL_is_init_finished(ssl))
+  {
+    if ((recv_buf_head + recv_buf_cnt == recv_buf_size) && !makeRecvBufRoom())
+    {
+      disconnect();
+      onDisconnected(DR_RECV_BUFFER_OVERFLOW);
+      return;
+    }
+
+    char *tail = recv_buf + recv_buf_head + recv_buf_cnt;
+    ERR_clear_error();
+    int ret = SSL_read(ssl, tail,
+                       recv_buf_size - recv_buf_head - recv_buf_cnt);
+    if (ret <= 0)
+    {
+      int err = SSL_get_error(ssl, ret);
+      if (err == SSL_ERROR_WANT_READ)
+      {
+        break;
+      }
+      if (err == SSL_ERROR_ZERO_RETURN)
+      {
+        disconnect();
+        onDisconnected(DR_REMOTE_DISCONNECTED);
+        return;
+      }
+      sslError();
+      return;
+    }
+
+    recv_buf_cnt += ret;
+    processRecvBuf();
+    if (ssl == 0)
+    {
+      return;
+    }
+  }
+
+    // Handshake messages, session tickets and key updates are written by
+    // the TLS library while reading
+  if (!sslFlush())
+  {
+    int errno_tmp = errno;
+    disconnect();
+    errno = errno_tmp;
+    onDisconnected(DR_SYSTEM_ERROR);
+  }
+} /* TcpConnection::sslRecvHandler */
+
+
+void TcpConnection::sslError(void)
+{
+  cerr << "*** WARNING: TLS error on connection with " << remote_addr << ":"
+       << remote_port << ": " << SslContext::lastError() << endl;
+    // No close notification may be sent after a fatal TLS error
+  SSL_set_quiet_shutdown(ssl, 1);
+  disconnect();
+  onDisconnected(DR_PROTOCOL_ERROR);
+} /* TcpConnection::sslError */
 
 
 
@@ -40,9 +40,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <sigc++/sigc++.h>
+#include <sys/uio.h>
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 
 /****************************************************************************
@@ -52,6 +54,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncIpAddress.h>
+#include <AsyncDataHandler.h>
 
 
 /****************************************************************************
@@ -68,6 +71,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+struct ssl_st;
 
 
 /****************************************************************************
@@ -87,6 +91,7 @@ namespace Async
 
 class FdWatch;
 class IpAddress;
+class SslContext;
 
 
 /****************************************************************************
@@ -140,6 +145,14 @@ class TcpConnection : public sigc::trackable
      * @brief The default length of the reception buffer
      */
     static const int DEFAULT_RECV_BUF_LEN = 1024;
+
+    /**
+     * @brief The maximum number of encrypted bytes waiting to be sent
+     *
+     * When TLS is enabled, writes are refused when there is more than this
+     * number of encrypted bytes that the socket have not accepted yet.
+     */
+    static const size_t MAX_SSL_TX_PENDING = 65536;
     
     /**
      * @brief Translate disconnect reason to a string
@@ -179,6 +192,65 @@ class TcpConnection : public sigc::trackable
      */
     void setRecvBufLen(size_t recv_buf_len);
 
+    /**
+     * @brief   Allow the receive buffer to grow
+     * @param   max_len The maximum receive buffer size in bytes
+     *
+     * When the receive buffer is full of unprocessed data it is normally an
+     * overflow error. After calling this function the buffer is instead
+     * grown, by doubling its size, up to the given maximum size. This make it
+     * possible for a subclass to leave a partly received message in the
+     * buffer, and parse it in place when it is complete, instead of copying it
+     * to a buffer of its own. The buffer is not shrunk again. The maximum size
+     * can never be less than the size set using setRecvBufLen.
+     */
+    void setMaxRecvBufLen(size_t max_len);
+
+    /**
+     * @brief   Enable TLS on the connection
+     * @param   ctx The TLS context to use or 0 to disable TLS
+     *
+     * The TLS handshake is started as soon as the connection has a socket.
+     * The role of the context decide if this end act as a TLS client or
+     * server. The context must not be deleted before the connection. Data
+     * written before the handshake has completed is buffered and sent when
+     * the handshake is done.
+     *
+     * Each call to write or writev is encrypted as one TLS record, so a
+     * message should be written using one call, e.g. using writev, to keep
+     * the per message overhead low. A write is either accepted completely or
+     * not at all. Writes are refused, and the sendBufferFull signal emitted,
+     * when more than MAX_SSL_TX_PENDING encrypted bytes are waiting to be
+     * sent.
+     */
+    void setSslContext(SslContext *ctx);
+
+    /**
+     * @brief   Set the name of the server used for TLS
+     * @param   host_name The host name or IP address of the server
+     *
+     * The name is sent to the server using SNI so that the server can select
+     * the right certificate. The server certificate is checked against the
+     * name if the TLS context verify the peer. Async::TcpClient set the name
+     * to the host it connects to.
+     */
+    void setSslHostName(const std::string& host_name)
+    {
+      ssl_host_name = host_name;
+    }
+
+    /**
+     * @brief   Check if TLS is enabled on the connection
+     * @return  Returns \em true if a TLS context has been set
+     */
+    bool sslEnabled(void) const { return ssl_ctx != 0; }
+
+    /**
+     * @brief   Check if the TLS session was resumed
+     * @return  Returns \em true if the handshake resumed an earlier session
+     */
+    bool sslSessionReused(void) const;
+
     /**
      * @brief 	Disconnect from the remote host
      *
@@ -195,6 +267,18 @@ class TcpConnection : public sigc::trackable
      * @return	Returns the number of bytes written or -1 on failure
      */
     virtual int write(const void *buf, int count);
+
+    /**
+     * @brief   Write data from multiple buffers to the TCP connection
+     * @param   iov     An array of buffers to send, in order
+     * @param   iovcnt  The number of buffers in the array
+     * @return  Returns the number of bytes written or -1 on failure
+     *
+     * This function works like the write function above but gather the data
+     * from many buffers using one system call. The sendBufferFull signal is
+     * emitted if not all data could be written.
+     */
+    int writev(const struct iovec *iov, int iovcnt);
     
     /**
      * @brief 	Return the IP-address of the remote host
@@ -225,7 +309,53 @@ class TcpConnection : public sigc::trackable
      * NOTE: This function is overridden in Async::TcpClient.
      */
     bool isIdle(void) const { return sock == -1; }
+
+    /**
+     * @brief   Get the round trip time estimated by the TCP stack
+     * @param   rtt   Set to the smoothed round trip time in seconds
+     * @return  Returns \em true on success or \em false if not connected or
+     *          if the information is not available on this platform
+     */
+    bool roundTripTime(double& rtt) const;
+
+    /**
+     * @brief   Set the size of the socket send buffer
+     * @param   size  The requested size in bytes
+     * @return  Returns \em true on success or \em false on failure
+     *
+     * A small send buffer make the sendBufferFull signal be emitted sooner
+     * when the network is congested, so that data can be queued in the
+     * application instead where it can be dropped if it get too old.
+     * The operating system may adjust the size.
+     */
+    bool setSendBufferSize(int size);
     
+    /**
+     * @brief   Set a direct handler for received data
+     * @param   obj   The object to call the handler member function on
+     *
+     * Set a member function to call when data has been received instead of
+     * emitting the dataReceived signal. This avoid the overhead of the signal
+     * dispatch for connections with exactly one receiver. The handler must
+     * return the number of processed bytes, just like the slots connected to
+     * the dataReceived signal. The data view is not valid after the handler
+     * has returned. The receiver must call clearDataHandler, or delete the
+     * connection, before it is destroyed.
+     *
+     * \code
+     * con->setDataHandler<MyClass, &MyClass::onData>(this);
+     * \endcode
+     */
+    template <typename T, int (T::*Method)(TcpConnection*, DataView)>
+    void setDataHandler(T *obj) { rx_handler.set<T, Method>(obj); }
+
+    /**
+     * @brief   Remove the direct handler set using setDataHandler
+     *
+     * After this call the dataReceived signal is emitted again.
+     */
+    void clearDataHandler(void) { rx_handler.clear(); }
+
     /**
      * @brief 	A signal that is emitted when a connection has been terminated
      * @param 	con   	The connection object
@@ -246,6 +376,8 @@ class TcpConnection : public sigc::trackable
      * bytes not processed will be stored in the receive buffer for this class
      * and presented again to the slot when more data arrives. The new data
      * will be appended to the old data.
+     * The signal is not emitted when a handler has been set using
+     * setDataHandler.
      */
     sigc::signal<int, TcpConnection *, void *, int> dataReceived;
     
@@ -315,27 +447,54 @@ class TcpConnection : public sigc::trackable
      * bytes not processed will be stored in the receive buffer for this class
      * and presented again to the slot when more data arrives. The new data
      * will be appended to the old data.
-     * The default action for this function is to emit the dataReceived signal.
+     * The default action for this function is to call the handler set using
+     * setDataHandler or, if not set, emit the dataReceived signal.
      */
     virtual int onDataReceived(void *buf, int count)
     {
+      if (rx_handler.isSet())
+      {
+        return rx_handler(this, DataView(buf, count));
+      }
       return dataReceived(this, buf, count);
     }
     
   private:
     friend class TcpClientBase;
 
+    typedef DataHandler<int(TcpConnection*, DataView)> RxHandler;
+
     IpAddress remote_addr;
     uint16_t  remote_port;
     size_t    recv_buf_len;
+    size_t    recv_buf_max_len;
     int       sock;
     FdWatch * rd_watch;
     FdWatch * wr_watch;
     char *    recv_buf;
+    size_t    recv_buf_size;
+    size_t    recv_buf_head;
     size_t    recv_buf_cnt;
+    RxHandler rx_handler;
+    SslContext *      ssl_ctx;
+    struct ssl_st *   ssl;
+    std::string       ssl_session_key;
+    std::string       ssl_host_name;
+    std::vector<char> ssl_tx_buf;
+    std::vector<char> ssl_tx_early;
+    std::vector<char> ssl_tx_gather;
     
+    bool makeRecvBufRoom(void);
+    void resizeRecvBuf(size_t size);
     void recvHandler(FdWatch *watch);
     void writeHandler(FdWatch *watch);
+    void processRecvBuf(void);
+    bool sslStart(void);
+    void sslStop(void);
+    int sslWrite(const void *buf, size_t count);
+    bool sslFlush(void);
+    void sslRecvHandler(void);
+    void sslError(void);
 
 };  /* class TcpConnection */
 
@@ -131,6 +131,9 @@ class TcpServer : public TcpServerBase
      * @brief 	Default constuctor
      * @param 	port_str A port number or service name to listen to
      * @param 	bind_ip The IP to bind the server to
+     *
+     * If no bind address is given, the server listen on a dual-stack socket
+     * that accept both IPv4 and IPv6 connections, if the system support IPv6.
      */
     TcpServer(const std::string& port_str,
               const Async::IpAddress &bind_ip=IpAddress())
@@ -173,6 +176,10 @@ class TcpServer : public TcpServerBase
                                   uint16_t remote_port)
     {
       ConT *con = new ConT(sock, remote_addr, remote_port);
+      if (sslContext() != 0)
+      {
+        con->setSslContext(sslContext());
+      }
       con->disconnected.connect(
           mem_fun(*this, &TcpServer<ConT>::onDisconnected));
       addConnection(con);
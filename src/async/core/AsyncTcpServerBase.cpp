@@ -40,6 +40,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <stdio.h>
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 
 
 /****************************************************************************
@@ -125,43 +126,11 @@ void delete_connection(TcpConnection *con);
 
 TcpServerBase::TcpServerBase(const string& port_str,
                              const Async::IpAddress &bind_ip)
-  : sock(-1), rd_watch(0)
+  : bind_ip(bind_ip), port(0), family(AF_UNSPEC), ssl_ctx(0)
 {
-  if ((sock = socket(AF_INET, SOCK_STREAM, 0)) == -1)
-  {
-    perror("socket");
-    cleanup();
-    return;
-  }
-  
-  /* Force close on exec */
-  if (fcntl(sock, F_SETFD, 1) == -1)
-  {
-    perror("fcntl(F_SETFD)");
-    cleanup();
-    return;
-  }
-  
-    /* Reuse address if server crashes */
-  const int on = 1;
-  if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *)&on, sizeof(on)) == -1)
-  {
-    perror("setsockopt(sock, SO_REUSEADDR)");
-    cleanup();
-    return;
-  }
-  
-    /* Send small packets at once. */
-  if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&on, sizeof(on)) == -1)
-  {
-    perror("setsockopt(sock, TCP_NODELAY)");
-    cleanup();
-    return;
-  }
-  
   char *endptr = 0;
   struct servent *se;
-  uint16_t port = strtol(port_str.c_str(), &endptr, 10);
+  port = strtol(port_str.c_str(), &endptr, 10);
   if (*endptr != '\0')
   {
     if ((se = getservbyname(port_str.c_str(), "tcp")) != NULL)
@@ -171,46 +140,47 @@ TcpServerBase::TcpServerBase(const string& port_str,
     else
     {
       cerr << "Could not find service " << port_str << endl;
-      cleanup();
       return;
     }
   }
 
-  struct sockaddr_in addr = { 0 };
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(port);
-  if (bind_ip.isEmpty())
-  {
-    addr.sin_addr.s_addr = INADDR_ANY;
-  }
-  else
+  openListener(false);
+} /* TcpServerBase::TcpServerBase */
+
+
+TcpServerBase::~TcpServerBase(void)
+{
+  cleanup();
+} /* TcpServerBase::~TcpServerBase */
+
+
+bool TcpServerBase::setListenerCount(unsigned count)
+{
+  if (count == 0)
   {
-    addr.sin_addr = bind_ip.ip4Addr();
+    count = 1;
   }
-  if (::bind(sock, (struct sockaddr *)&addr, sizeof(struct sockaddr_in)) != 0)
+  if (count == listeners.size())
   {
-    perror("bind");
-    cleanup();
-    return;
+    return true;
   }
 
-  if (listen(sock, 5) != 0)
+    // All listening sockets must have SO_REUSEPORT set before they are bound
+    // so the existing listener is closed and all of them are opened again
+  closeListeners();
+  for (unsigned i=0; i<count; ++i)
   {
-    perror("listen");
-    cleanup();
-    return;
+    if (!openListener(count > 1))
+    {
+      closeListeners();
+      openListener(false);
+      return false;
+    }
   }
 
-  rd_watch = new FdWatch(sock, FdWatch::FD_WATCH_RD);
-  rd_watch->activity.connect(mem_fun(*this, &TcpServerBase::onConnection));
-    
-} /* TcpServerBase::TcpServerBase */
+  return true;
 
-
-TcpServerBase::~TcpServerBase(void)
-{
-  cleanup();
-} /* TcpServerBase::~TcpServerBase */
+} /* TcpServerBase::setListenerCount */
 
 
 int TcpServerBase::numberOfClients(void)
@@ -315,17 +285,131 @@ void TcpServerBase::removeConnection(TcpConnection *con)
  *
  ****************************************************************************/
 
-void TcpServerBase::cleanup(void)
+bool TcpServerBase::openListener(bool reuse_port)
 {
-  delete rd_watch;
-  rd_watch = 0;
+    // Without a bind address, listen on a dual-stack IPv6 socket if the
+    // system support IPv6
+  int sock_family = bind_ip.isEmpty() ? AF_INET6 : bind_ip.family();
+  if (family != AF_UNSPEC)
+  {
+    sock_family = family;
+  }
+  int sock = socket(sock_family, SOCK_STREAM, 0);
+  if ((sock == -1) && bind_ip.isEmpty() && (sock_family == AF_INET6))
+  {
+    sock_family = AF_INET;
+    sock = socket(sock_family, SOCK_STREAM, 0);
+  }
+  if (sock == -1)
+  {
+    perror("socket");
+    return false;
+  }
+
+  if ((sock_family == AF_INET6) && bind_ip.isEmpty())
+  {
+    const int off = 0;
+    if (setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off)) == -1)
+    {
+      perror("setsockopt(sock, IPV6_V6ONLY)");
+      close(sock);
+      return false;
+    }
+  }
   
-  if (sock != -1)
+  /* Force close on exec */
+  if (fcntl(sock, F_SETFD, 1) == -1)
+  {
+    perror("fcntl(F_SETFD)");
+    close(sock);
+    return false;
+  }
+
+    // Accept must not block when the queue of pending connections is empty
+  if (fcntl(sock, F_SETFL, O_NONBLOCK) == -1)
   {
+    perror("fcntl(sock, F_SETFL)");
     close(sock);
-    sock = -1;
+    return false;
   }
   
+    /* Reuse address if server crashes */
+  const int on = 1;
+  if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *)&on, sizeof(on)) == -1)
+  {
+    perror("setsockopt(sock, SO_REUSEADDR)");
+    close(sock);
+    return false;
+  }
+
+    // Let the kernel spread incoming connections over all listening sockets
+    // bound to the same address and port
+  if (reuse_port &&
+      (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1))
+  {
+    perror("setsockopt(sock, SO_REUSEPORT)");
+    close(sock);
+    return false;
+  }
+  
+    /* Send small packets at once. */
+  if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&on, sizeof(on)) == -1)
+  {
+    perror("setsockopt(sock, TCP_NODELAY)");
+    close(sock);
+    return false;
+  }
+  
+  IpAddress local_ip(bind_ip);
+  if (local_ip.isEmpty())
+  {
+    local_ip = (sock_family == AF_INET6) ? IpAddress(in6addr_any)
+                                         : IpAddress("0.0.0.0");
+  }
+  struct sockaddr_storage addr;
+  socklen_t addr_len = local_ip.toSockAddr(addr, port, sock_family);
+  if (::bind(sock, (struct sockaddr *)&addr, addr_len) != 0)
+  {
+    perror("bind");
+    close(sock);
+    return false;
+  }
+
+    // Use the largest backlog allowed by the system so that incoming
+    // connections are not dropped when many clients connect at the same time
+  if (listen(sock, SOMAXCONN) != 0)
+  {
+    perror("listen");
+    close(sock);
+    return false;
+  }
+
+  family = sock_family;
+  FdWatch *rd_watch = new FdWatch(sock, FdWatch::FD_WATCH_RD);
+  rd_watch->activity.connect(mem_fun(*this, &TcpServerBase::onConnection));
+  listeners.push_back(rd_watch);
+
+  return true;
+
+} /* TcpServerBase::openListener */
+
+
+void TcpServerBase::closeListeners(void)
+{
+  for (ListenerList::iterator it=listeners.begin(); it!=listeners.end(); ++it)
+  {
+    int sock = (*it)->fd();
+    delete *it;
+    close(sock);
+  }
+  listeners.clear();
+} /* TcpServerBase::closeListeners */
+
+
+void TcpServerBase::cleanup(void)
+{
+  closeListeners();
+  
     // If there are any connected clients, disconnect them and clear the list
   TcpConnectionList::const_iterator it;
   for (it=tcpConnectionList.begin(); it!=tcpConnectionList.end(); ++it)
@@ -339,45 +423,59 @@ void TcpServerBase::cleanup(void)
 
 void TcpServerBase::onConnection(FdWatch *watch)
 {
-  int client_sock;
-  struct sockaddr_in client;
-  socklen_t addrlen = sizeof(client);
-  client_sock = accept(sock, (struct sockaddr *)&client, &addrlen);
-  if (client_sock == -1)
+    // Accept all pending connections so that a burst of clients connecting
+    // at the same time is handled in one wakeup
+  for (;;)
   {
-    perror("accept");
-    return;
-  }
+    struct sockaddr_storage client;
+    socklen_t addrlen = sizeof(client);
+    int client_sock = accept(watch->fd(), (struct sockaddr *)&client,
+                             &addrlen);
+    if (client_sock == -1)
+    {
+      if ((errno == ECONNABORTED) || (errno == EINTR))
+      {
+        continue;
+      }
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+      {
+        perror("accept");
+      }
+      return;
+    }
   
-    // Force close on exec
-  if (fcntl(client_sock, F_SETFD, 1) == -1)
-  {
-    perror("fcntl(F_SETFD)");
-    close(client_sock);
-    return;
-  }
+      // Force close on exec
+    if (fcntl(client_sock, F_SETFD, 1) == -1)
+    {
+      perror("fcntl(F_SETFD)");
+      close(client_sock);
+      continue;
+    }
   
-    // Write must not block!
-  if (fcntl(client_sock, F_SETFL, O_NONBLOCK) == -1)
-  {
-    perror("fcntl(client_sock, F_SETFL)");
-    close(client_sock);
-    return;
-  }
+      // Write must not block!
+    if (fcntl(client_sock, F_SETFL, O_NONBLOCK) == -1)
+    {
+      perror("fcntl(client_sock, F_SETFL)");
+      close(client_sock);
+      continue;
+    }
   
-    // Send small packets at once
-  const int on = 1;
-  if (setsockopt(client_sock, IPPROTO_TCP, TCP_NODELAY,
-                 (char *)&on, sizeof(on)) == -1)
-  {
-    perror("setsockopt(client_sock, TCP_NODELAY)");
-    close(client_sock);
-    return;
-  }
+      // Send small packets at once
+    const int on = 1;
+    if (setsockopt(client_sock, IPPROTO_TCP, TCP_NODELAY,
+                   (char *)&on, sizeof(on)) == -1)
+    {
+      perror("setsockopt(client_sock, TCP_NODELAY)");
+      close(client_sock);
+      continue;
+    }
   
-    // Create client object, add signal handling, add to client list
-  createConnection(client_sock, IpAddress(client.sin_addr),
-                   ntohs(client.sin_port));
+      // Create client object, add signal handling, add to client list
+    IpAddress client_ip;
+    uint16_t client_port = 0;
+    client_ip.setFromSockAddr((struct sockaddr *)&client, &client_port);
+    createConnection(client_sock, client_ip, client_port);
+  }
 } /* TcpServerBase::onConnection */
 
 
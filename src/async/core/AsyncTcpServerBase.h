@@ -80,6 +80,7 @@ namespace Async
  ****************************************************************************/
 
 class FdWatch;
+class SslContext;
 
 
 /****************************************************************************
@@ -116,6 +117,9 @@ class TcpServerBase : public sigc::trackable
      * @brief 	Default constuctor
      * @param 	port_str A port number or service name to listen to
      * @param 	bind_ip The IP to bind the server to
+     *
+     * If no bind address is given, the server listen on a dual-stack socket
+     * that accept both IPv4 and IPv6 connections, if the system support IPv6.
      */
     TcpServerBase(const std::string& port_str,
                   const Async::IpAddress &bind_ip);
@@ -125,6 +129,37 @@ class TcpServerBase : public sigc::trackable
      */
     virtual ~TcpServerBase(void);
 
+    /**
+     * @brief   Set the number of listening sockets to use
+     * @param   count The number of listening sockets
+     * @return  Returns \em true on success or \em false on failure
+     *
+     * When more than one listening socket is used, all of them are bound to
+     * the same address and port using SO_REUSEPORT and the kernel spread
+     * incoming connections between them. Each listening socket has its own
+     * backlog so a burst of connecting clients is less likely to overflow
+     * it. The existing listening socket is closed and reopened so this
+     * function should be called right after the server has been created.
+     * On failure, the server fall back to a single listening socket.
+     */
+    bool setListenerCount(unsigned count);
+
+    /**
+     * @brief   Get the number of listening sockets
+     * @return  Returns the number of open listening sockets
+     */
+    unsigned listenerCount(void) const { return listeners.size(); }
+
+    /**
+     * @brief   Enable TLS on all new connections
+     * @param   ctx A server TLS context or 0 to disable TLS
+     *
+     * The context is set on each connection when it is accepted, before the
+     * clientConnected signal is emitted. Already connected clients are not
+     * affected. The context must not be deleted before the server.
+     */
+    void setSslContext(SslContext *ctx) { ssl_ctx = ctx; }
+
     /**
      * @brief 	Get the number of clients that is connected to the server
      * @return 	The number of connected clients
@@ -169,14 +204,22 @@ class TcpServerBase : public sigc::trackable
                                   uint16_t remote_port) = 0;
     void addConnection(TcpConnection *con);
     void removeConnection(TcpConnection *con);
+    SslContext *sslContext(void) const { return ssl_ctx; }
 
   private:
     typedef std::vector<TcpConnection*> TcpConnectionList;
 
-    int       	      sock;
-    FdWatch   	      *rd_watch;
+    typedef std::vector<FdWatch*> ListenerList;
+
+    IpAddress         bind_ip;
+    uint16_t          port;
+    int               family;
+    ListenerList      listeners;
+    SslContext*       ssl_ctx;
     TcpConnectionList tcpConnectionList;
 
+    bool openListener(bool reuse_port);
+    void closeListeners(void);
     void cleanup(void);
     void onConnection(FdWatch *watch);
 
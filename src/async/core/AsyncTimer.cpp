@@ -119,7 +119,8 @@ using namespace Async;
 
 
 Timer::Timer(int timeout_ms, Type type, bool enabled)
-  : m_type(type), m_timeout_ms(timeout_ms), m_is_enabled(false)
+  : m_type(type), m_timeout_ms(timeout_ms), m_is_enabled(false), m_app(0),
+    m_wheel_next(0), m_wheel_prev(0), m_wheel_expire(0), m_wheel_slot(-1)
 {
   setEnable(enabled && (timeout_ms >= 0));
 } /* Timer::Timer */
@@ -150,12 +151,12 @@ void Timer::setEnable(bool do_enable)
   assert((m_timeout_ms >= 0) || !do_enable);
   if (do_enable && !m_is_enabled)
   {
-    Application::app().addTimer(this);
+    app().addTimer(this);
     m_is_enabled = true;
   }
   else if (!do_enable && m_is_enabled)
   {
-    Application::app().delTimer(this);
+    app().delTimer(this);
     m_is_enabled = false;
   }
 } /* Timer::setEnable */
@@ -166,8 +167,8 @@ void Timer::reset(void)
   if (m_is_enabled)
   {
     assert(m_timeout_ms >= 0);
-    Application::app().delTimer(this);
-    Application::app().addTimer(this);
+    app().delTimer(this);
+    app().addTimer(this);
   }
 } /* Timer::reset */
 
@@ -188,6 +189,16 @@ void Timer::reset(void)
  *
  ****************************************************************************/
 
+Application &Timer::app(void)
+{
+    // The timer belong to the event loop it was first added to
+  if (m_app == 0)
+  {
+    m_app = &Application::app();
+  }
+  return *m_app;
+} /* Timer::app */
+
 
 
 
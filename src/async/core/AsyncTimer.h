@@ -45,6 +45,9 @@ An example of how to use the Async::Timer class
  ****************************************************************************/
 
 #include <sigc++/sigc++.h>
+#include <stdint.h>
+
+#include <string>
 
 
 
@@ -81,6 +84,10 @@ An example of how to use the Async::Timer class
 namespace Async
 {
 
+class TimerWheel;
+class Application;
+
+
 /****************************************************************************
  *
  * Defines & typedefs
@@ -198,6 +205,22 @@ class Timer : public sigc::trackable
      * If the timer is disabled, this function will do nothing.
      */
     void reset(void);
+
+    /**
+     * @brief   Set a label used to identify the timer in statistics
+     * @param   label The label to set
+     *
+     * The label is used when the event loop collects statistics about how
+     * long callbacks take to run. Timers that have the same label are
+     * counted together.
+     */
+    void setLabel(const std::string& label) { m_label = label; }
+
+    /**
+     * @brief   Return the label of this timer
+     * @return  Returns the label set using setLabel
+     */
+    const std::string& label(void) const { return m_label; }
     
     /**
      * @brief 	A signal that is emitted when the timer expires
@@ -213,9 +236,21 @@ class Timer : public sigc::trackable
   protected:
     
   private:
-    Type  m_type;
-    int   m_timeout_ms;
-    bool  m_is_enabled;
+    friend class TimerWheel;
+
+    Type      m_type;
+    int       m_timeout_ms;
+    bool      m_is_enabled;
+    Application *m_app;
+    std::string m_label;
+
+      // Intrusive list links used by the application timer implementation
+    Timer*    m_wheel_next;
+    Timer*    m_wheel_prev;
+    uint64_t  m_wheel_expire;
+    int       m_wheel_slot;
+
+    Application &app(void);
   
 };  /* class Timer */
 
@@ -0,0 +1,97 @@
+/**
+@file	 AsyncTracepoint.h
+@brief   Static tracepoints for tracing a running application
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This file contains a macro used to put static tracepoints (USDT probes) into
+the code. The tracepoints are compiled out unless the build is configured
+with USE_USDT=ON. When compiled in, a tracepoint is a single nop instruction
+until a tracer, like bpftrace, perf or SystemTap, attach to it. The
+tracepoints of a running process can be listed using for example:
+
+  bpftrace -l 'usdt:/usr/bin/svxreflector:*'
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_TRACEPOINT_INCLUDED
+#define ASYNC_TRACEPOINT_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#ifdef USE_USDT
+#include <sys/sdt.h>
+#endif
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+/**
+ * @brief   Put a static tracepoint into the code
+ * @param   provider The provider name, e.g. svxlink or svxreflector
+ * @param   name The name of the tracepoint
+ * @param   ... Up to twelve integer or pointer arguments
+ *
+ * The arguments are not evaluated when the tracepoints are compiled out so
+ * they must not have any side effects. Strings are passed as a const char
+ * pointer which can be read by the tracer, e.g. using str(arg0) in bpftrace.
+ */
+#ifdef USE_USDT
+#define ASYNC_TRACEPOINT(provider, name, ...) \
+  STAP_PROBEV(provider, name, ##__VA_ARGS__)
+#else
+#define ASYNC_TRACEPOINT(provider, name, ...) do {} while (0)
+#endif
+
+
+#endif /* ASYNC_TRACEPOINT_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
+
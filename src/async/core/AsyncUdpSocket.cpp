@@ -42,9 +42,12 @@
 #include <fcntl.h>
 #include <assert.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <iostream>
+#include <vector>
 
 
 /****************************************************************************
@@ -95,17 +98,103 @@ using namespace Async;
 class UdpPacket
 {
   public:
-    const IpAddress ip;
-    int       	    port;
-    char    	    buf[65535];
-    int       	    len;
-    
-    UdpPacket(const IpAddress& ip, int port, const void *buf, int len)
-      : ip(ip), port(port), len(len)
+    IpAddress         ip;
+    int       	      port;
+    std::vector<char> buf;
+
+    UdpPacket(void) : port(0) {}
+
+    void assign(const IpAddress& ip, int port, const struct iovec *iov,
+                int iovcnt)
     {
-      memcpy(this->buf, buf, len);
+      this->ip = ip;
+      this->port = port;
+      buf.clear();
+      for (int i=0; i<iovcnt; ++i)
+      {
+        const char *ptr = reinterpret_cast<const char *>(iov[i].iov_base);
+        buf.insert(buf.end(), ptr, ptr + iov[i].iov_len);
+      }
+    }
+};
+
+
+class UdpSocket::SendQueue
+{
+  public:
+    std::vector<UdpPacket>  ring;
+    unsigned                head;
+    unsigned                cnt;
+    DropPolicy              policy;
+
+    SendQueue(unsigned size, DropPolicy policy)
+      : ring(size), head(0), cnt(0), policy(policy) {}
+
+    unsigned size(void) const { return ring.size(); }
+    bool empty(void) const { return cnt == 0; }
+    bool full(void) const { return cnt == ring.size(); }
+    UdpPacket& front(void) { return ring[head]; }
+    void pop(void) { head = (head + 1) % ring.size(); --cnt; }
+    UdpPacket& push(void)
+    {
+      UdpPacket& pkt = ring[(head + cnt) % ring.size()];
+      ++cnt;
+      return pkt;
+    }
+};
+
+
+class UdpSocket::Batch
+{
+  public:
+    unsigned                      size;
+    size_t                        max_size;
+    std::vector<char>             rx_buf;
+    std::vector<struct sockaddr_storage> rx_addr;
+    std::vector<char>             tx_buf;
+    std::vector<struct sockaddr_storage> tx_addr;
+    std::vector<socklen_t>        tx_addr_len;
+    std::vector<struct iovec>     tx_iov;
+    unsigned                      tx_cnt;
+    bool                          tx_active;
+#ifdef HAS_RECVMMSG
+    std::vector<struct iovec>     rx_iov;
+    std::vector<struct mmsghdr>   rx_msgs;
+    std::vector<struct mmsghdr>   tx_msgs;
+#endif
+
+    Batch(unsigned size, size_t max_size)
+      : size(size), max_size(max_size), rx_buf(size * max_size),
+        rx_addr(size), tx_buf(size * max_size), tx_addr(size),
+        tx_addr_len(size), tx_iov(size),
+        tx_cnt(0), tx_active(false)
+    {
+#ifdef HAS_RECVMMSG
+      rx_iov.resize(size);
+      rx_msgs.resize(size);
+      tx_msgs.resize(size);
+      for (unsigned i=0; i<size; ++i)
+      {
+        rx_iov[i].iov_base = &rx_buf[i * max_size];
+        rx_iov[i].iov_len = max_size;
+        memset(&rx_msgs[i], 0, sizeof(rx_msgs[i]));
+        rx_msgs[i].msg_hdr.msg_iov = &rx_iov[i];
+        rx_msgs[i].msg_hdr.msg_iovlen = 1;
+        rx_msgs[i].msg_hdr.msg_name = &rx_addr[i];
+
+        tx_iov[i].iov_base = &tx_buf[i * max_size];
+        memset(&tx_msgs[i], 0, sizeof(tx_msgs[i]));
+        tx_msgs[i].msg_hdr.msg_iov = &tx_iov[i];
+        tx_msgs[i].msg_hdr.msg_iovlen = 1;
+        tx_msgs[i].msg_hdr.msg_name = &tx_addr[i];
+      }
+#else
+      for (unsigned i=0; i<size; ++i)
+      {
+        tx_iov[i].iov_base = &tx_buf[i * max_size];
+      }
+#endif
     }
-  
 };
 
 
@@ -154,18 +243,38 @@ class UdpPacket
  *------------------------------------------------------------------------
  */
 UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip)
-  : sock(-1), rd_watch(0), wr_watch(0), send_buf(0)
+  : sock(-1), sock_family(AF_INET), rd_watch(0), wr_watch(0),
+    send_queue(0), batch(0), tx_queued(0), tx_dropped(0), deleted_flag(0)
 {
-  struct sockaddr_in addr;
-  
-    // Create UDP socket
-  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  send_queue = new SendQueue(DEFAULT_SEND_QUEUE_SIZE, DROP_NEWEST);
+
+    // Create UDP socket. If no bind address is given, a dual-stack IPv6
+    // socket is used if the system support IPv6.
+  sock_family = bind_ip.isEmpty() ? AF_INET6 : bind_ip.family();
+  sock = socket(sock_family, SOCK_DGRAM, 0);
+  if ((sock == -1) && bind_ip.isEmpty())
+  {
+    sock_family = AF_INET;
+    sock = socket(sock_family, SOCK_DGRAM, 0);
+  }
   if(sock == -1)
   {
     perror("socket");
     cleanup();
     return;
   }
+
+  if ((sock_family == AF_INET6) && bind_ip.isEmpty())
+  {
+    int v6only = 0;
+    if (setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &v6only,
+                   sizeof(v6only)) == -1)
+    {
+      perror("setsockopt(IPV6_V6ONLY)");
+      cleanup();
+      return;
+    }
+  }
   
     // Setup the socket for non-blocking operation
   if (fcntl(sock, F_SETFL, O_NONBLOCK) == -1)
@@ -178,18 +287,15 @@ UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip)
     // Bind the socket to a local port if one was specified
   if (local_port > 0)
   {
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(local_port);
-    if (bind_ip.isEmpty())
-    {
-      addr.sin_addr.s_addr = INADDR_ANY;
-    }
-    else
+    IpAddress local_ip(bind_ip);
+    if (local_ip.isEmpty())
     {
-      addr.sin_addr = bind_ip.ip4Addr();
+      local_ip = (sock_family == AF_INET6) ? IpAddress(in6addr_any)
+                                           : IpAddress("0.0.0.0");
     }
-    if(::bind(sock, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1)
+    struct sockaddr_storage addr;
+    socklen_t addr_len = local_ip.toSockAddr(addr, local_port, sock_family);
+    if(::bind(sock, reinterpret_cast<struct sockaddr *>(&addr), addr_len) == -1)
     {
       perror("bind");
       cleanup();
@@ -199,12 +305,14 @@ UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip)
   
     // Setup a watch for incoming data
   rd_watch = new FdWatch(sock, FdWatch::FD_WATCH_RD);
+  rd_watch->setLabel("Async::UdpSocket read");
   assert(rd_watch != 0);
   rd_watch->activity.connect(mem_fun(*this, &UdpSocket::handleInput));
 
     // Setup a watch for outgoing data (signals activity when a buffer full
     // condition occurs)
   wr_watch = new FdWatch(sock, FdWatch::FD_WATCH_WR);
+  wr_watch->setLabel("Async::UdpSocket write");
   assert(wr_watch != 0);
   wr_watch->activity.connect(mem_fun(*this, &UdpSocket::sendRest));
   wr_watch->setEnabled(false);
@@ -214,6 +322,10 @@ UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip)
 
 UdpSocket::~UdpSocket(void)
 {
+  if (deleted_flag != 0)
+  {
+    *deleted_flag = true;
+  }
   cleanup();
 } /* UdpSocket::~UdpSocket */
 
@@ -221,37 +333,173 @@ UdpSocket::~UdpSocket(void)
 bool UdpSocket::write(const IpAddress& remote_ip, int remote_port,
     const void *buf, int count)
 {
-  if (send_buf != 0)
+  struct iovec iov;
+  iov.iov_base = const_cast<void *>(buf);
+  iov.iov_len = count;
+  return writev(remote_ip, remote_port, &iov, 1);
+} /* UdpSocket::write */
+
+
+bool UdpSocket::writev(const IpAddress& remote_ip, int remote_port,
+                       const struct iovec *iov, int iovcnt)
+{
+  size_t count = 0;
+  for (int i=0; i<iovcnt; ++i)
+  {
+    count += iov[i].iov_len;
+  }
+
+  if ((batch != 0) && batch->tx_active)
   {
+    if (count <= batch->max_size)
+    {
+      socklen_t addr_len = remote_ip.toSockAddr(
+          batch->tx_addr[batch->tx_cnt], remote_port, sock_family);
+      if (addr_len == 0)
+      {
+        errno = EAFNOSUPPORT;
+        perror("UdpSocket::writev");
+        return false;
+      }
+      batch->tx_addr_len[batch->tx_cnt] = addr_len;
+      char *ptr =
+        reinterpret_cast<char *>(batch->tx_iov[batch->tx_cnt].iov_base);
+      for (int i=0; i<iovcnt; ++i)
+      {
+        memcpy(ptr, iov[i].iov_base, iov[i].iov_len);
+        ptr += iov[i].iov_len;
+      }
+      batch->tx_iov[batch->tx_cnt].iov_len = count;
+      if (++batch->tx_cnt < batch->size)
+      {
+        return true;
+      }
+      return sendBatch();
+    }
+
+      // Datagrams not fitting in a batch buffer are sent directly, after the
+      // already batched datagrams to keep the order
+    sendBatch();
+  }
+
+  if (!send_queue->empty())
+  {
+    return queueDatagram(remote_ip, remote_port, iov, iovcnt);
+  }
+
+  struct sockaddr_storage addr;
+  socklen_t addr_len = remote_ip.toSockAddr(addr, remote_port, sock_family);
+  if (addr_len == 0)
+  {
+    errno = EAFNOSUPPORT;
+    perror("UdpSocket::writev");
     return false;
   }
-  
-  struct sockaddr_in addr;
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(remote_port);
-  addr.sin_addr = remote_ip.ip4Addr();
-  int ret = sendto(sock, buf, count, 0,
-      reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &addr;
+  msg.msg_namelen = addr_len;
+  msg.msg_iov = const_cast<struct iovec *>(iov);
+  msg.msg_iovlen = iovcnt;
+  int ret = sendmsg(sock, &msg, 0);
   if (ret == -1)
   {
-    if (errno == EAGAIN)
+    if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
     {
-      send_buf = new UdpPacket(remote_ip, remote_port, buf, count);
-      wr_watch->setEnabled(true);
-      sendBufferFull(true);
-      return true;
+      return queueDatagram(remote_ip, remote_port, iov, iovcnt);
     }
     else
     {
-      perror("sendto in UdpSocket::write");
+      perror("sendmsg in UdpSocket::write");
       return false;
     }
   }
-  assert(ret == count);
+  assert(static_cast<size_t>(ret) == count);
   
   return true;
   
-} /* UdpSocket::write */
+} /* UdpSocket::writev */
+
+
+void UdpSocket::setBatchMode(unsigned batch_size, size_t max_datagram_size)
+{
+  if (batch != 0)
+  {
+    sendBatch();
+    delete batch;
+    batch = 0;
+  }
+  if (batch_size > 0)
+  {
+    batch = new Batch(batch_size, max_datagram_size);
+  }
+} /* UdpSocket::setBatchMode */
+
+
+void UdpSocket::beginWriteBatch(void)
+{
+  if (batch != 0)
+  {
+    batch->tx_active = true;
+  }
+} /* UdpSocket::beginWriteBatch */
+
+
+bool UdpSocket::flushWriteBatch(void)
+{
+  if (batch == 0)
+  {
+    return true;
+  }
+  batch->tx_active = false;
+  return sendBatch();
+} /* UdpSocket::flushWriteBatch */
+
+
+void UdpSocket::setSendQueueSize(unsigned max_datagrams, DropPolicy policy)
+{
+  SendQueue *queue = new SendQueue(max_datagrams, policy);
+  while (!send_queue->empty())
+  {
+    if (queue->full())
+    {
+      if (queue->empty())
+      {
+        tx_dropped += send_queue->cnt;
+        break;
+      }
+      queue->pop();
+      ++tx_dropped;
+    }
+    std::swap(queue->push(), send_queue->front());
+    send_queue->pop();
+  }
+  delete send_queue;
+  send_queue = queue;
+
+  if (send_queue->empty() && (wr_watch != 0) && wr_watch->isEnabled())
+  {
+    wr_watch->setEnabled(false);
+    sendBufferFull(false);
+  }
+} /* UdpSocket::setSendQueueSize */
+
+
+unsigned UdpSocket::sendQueueLength(void) const
+{
+  return send_queue->cnt;
+} /* UdpSocket::sendQueueLength */
+
+
+bool UdpSocket::setSendBufferSize(int bytes)
+{
+  if (setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes)) == -1)
+  {
+    perror("setsockopt(SO_SNDBUF)");
+    return false;
+  }
+  return true;
+} /* UdpSocket::setSendBufferSize */
 
 
 
@@ -307,8 +555,11 @@ void UdpSocket::cleanup(void)
   delete wr_watch;
   wr_watch = 0;
   
-  delete send_buf;
-  send_buf = 0;
+  delete send_queue;
+  send_queue = 0;
+
+  delete batch;
+  batch = 0;
   
   if (sock != -1)
   {
@@ -321,10 +572,174 @@ void UdpSocket::cleanup(void)
 } /* UdpSocket::cleanup */
 
 
+bool UdpSocket::sendBatch(void)
+{
+  if ((batch == 0) || (batch->tx_cnt == 0))
+  {
+    return true;
+  }
+
+  unsigned cnt = batch->tx_cnt;
+  batch->tx_cnt = 0;
+
+  bool success = true;
+  unsigned sent = 0;
+  while (send_queue->empty() && (sent < cnt))
+  {
+#ifdef HAS_RECVMMSG
+    for (unsigned i=sent; i<cnt; ++i)
+    {
+      batch->tx_msgs[i].msg_hdr.msg_namelen = batch->tx_addr_len[i];
+    }
+    int ret = sendmmsg(sock, &batch->tx_msgs[sent], cnt - sent, 0);
+#else
+    int ret = sendto(sock, batch->tx_iov[sent].iov_base,
+        batch->tx_iov[sent].iov_len, 0,
+        reinterpret_cast<struct sockaddr *>(&batch->tx_addr[sent]),
+        batch->tx_addr_len[sent]);
+    if (ret != -1)
+    {
+      ret = 1;
+    }
+#endif
+    if (ret == -1)
+    {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        break;
+      }
+      perror("sendmmsg in UdpSocket::sendBatch");
+        // Skip the failing datagram and try the rest so that one bad
+        // destination does not drop the datagrams to everyone after it
+      success = false;
+      ret = 1;
+    }
+    sent += ret;
+  }
+
+    // Queue the datagrams that could not be sent, after the ones already
+    // waiting in the send queue
+  for (; sent < cnt; ++sent)
+  {
+    IpAddress ip;
+    uint16_t port = 0;
+    ip.setFromSockAddr(
+        reinterpret_cast<struct sockaddr *>(&batch->tx_addr[sent]), &port);
+    if (!queueDatagram(ip, port,
+                       &batch->tx_iov[sent], 1))
+    {
+      success = false;
+    }
+  }
+
+  return success;
+} /* UdpSocket::sendBatch */
+
+
+bool UdpSocket::queueDatagram(const IpAddress& ip, int port,
+                              const struct iovec *iov, int iovcnt)
+{
+  if (send_queue->full())
+  {
+    ++tx_dropped;
+    if ((send_queue->policy == DROP_NEWEST) || send_queue->empty())
+    {
+      return false;
+    }
+    send_queue->pop();
+  }
+
+  bool was_empty = send_queue->empty();
+  send_queue->push().assign(ip, port, iov, iovcnt);
+  ++tx_queued;
+  if (was_empty)
+  {
+    wr_watch->setEnabled(true);
+    sendBufferFull(true);
+  }
+  return true;
+} /* UdpSocket::queueDatagram */
+
+
 void UdpSocket::handleInput(FdWatch *watch)
 {
+  if (batch != 0)
+  {
+    Batch *b = batch;
+    bool deleted = false;
+    deleted_flag = &deleted;
+    for (unsigned i=0; i<b->size; ++i)
+    {
+      unsigned cnt = 1;
+#ifdef HAS_RECVMMSG
+      for (unsigned j=0; j<b->size; ++j)
+      {
+        b->rx_msgs[j].msg_hdr.msg_namelen = sizeof(b->rx_addr[j]);
+      }
+      int ret = recvmmsg(sock, &b->rx_msgs[0], b->size, MSG_DONTWAIT,
+                         NULL);
+      if (ret > 0)
+      {
+        cnt = ret;
+      }
+#else
+      socklen_t addr_len = sizeof(b->rx_addr[0]);
+      int ret = recvfrom(sock, &b->rx_buf[0], b->max_size,
+          MSG_DONTWAIT | MSG_TRUNC,
+          reinterpret_cast<struct sockaddr *>(&b->rx_addr[0]), &addr_len);
+#endif
+      if (ret == -1)
+      {
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+        {
+          perror("recvmmsg in UdpSocket::handleInput");
+        }
+        break;
+      }
+
+      for (unsigned j=0; j<cnt; ++j)
+      {
+#ifdef HAS_RECVMMSG
+        size_t len = b->rx_msgs[j].msg_len;
+        bool truncated = (b->rx_msgs[j].msg_hdr.msg_flags & MSG_TRUNC);
+#else
+        size_t len = ret;
+        bool truncated = (len > b->max_size);
+#endif
+        if (truncated)
+        {
+          std::cerr << "*** WARNING: Dropping UDP datagram larger than "
+                    << b->max_size << " bytes" << std::endl;
+          continue;
+        }
+        IpAddress ip;
+        uint16_t port = 0;
+        ip.setFromSockAddr(
+            reinterpret_cast<struct sockaddr *>(&b->rx_addr[j]), &port);
+        emitDataReceived(ip, port,
+                         &b->rx_buf[j * b->max_size], len);
+        if (deleted || (batch != b))
+        {
+          if (!deleted)
+          {
+            deleted_flag = 0;
+          }
+          return;
+        }
+      }
+
+#ifdef HAS_RECVMMSG
+        // One recvmmsg call is enough. If there is more data available the
+        // watch will trigger again.
+      break;
+#endif
+    }
+    deleted_flag = 0;
+    return;
+  }
+
   char buf[65536];
-  struct sockaddr_in addr;
+  struct sockaddr_storage addr;
   socklen_t addr_len = sizeof(addr);
   
   int len = recvfrom(sock, buf, sizeof(buf), 0,
@@ -335,44 +750,40 @@ void UdpSocket::handleInput(FdWatch *watch)
     return;
   }
   
-  dataReceived(IpAddress(addr.sin_addr), ntohs(addr.sin_port), buf, len);
+  IpAddress ip;
+  uint16_t port = 0;
+  ip.setFromSockAddr(reinterpret_cast<struct sockaddr *>(&addr), &port);
+  emitDataReceived(ip, port, buf, len);
   
 } /* UdpSocket::handleInput */
 
 
 void UdpSocket::sendRest(FdWatch *watch)
 {
-  struct sockaddr_in addr;
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(send_buf->port);
-  addr.sin_addr = send_buf->ip.ip4Addr();
-  /*
-  cout << "sock=" << sock << "  port=" << send_buf->port
-      << "  ip=" << send_buf->ip.toString() << "  len=" << send_buf->len
-      << endl;
-  */
-  int ret = sendto(sock, send_buf->buf, send_buf->len, 0,
-      reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
-  if (ret == -1)
+  while (!send_queue->empty())
   {
-    if (errno == EAGAIN)
+    UdpPacket& pkt = send_queue->front();
+    struct sockaddr_storage addr;
+    socklen_t addr_len = pkt.ip.toSockAddr(addr, pkt.port, sock_family);
+    int ret = sendto(sock, pkt.buf.data(), pkt.buf.size(), 0,
+        reinterpret_cast<struct sockaddr *>(&addr), addr_len);
+    if (ret == -1)
     {
-      return;
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        return;
+      }
+      perror("sendto in UdpSocket::sendRest");
     }
     else
     {
-      perror("sendto in UdpSocket::sendRest");
+      assert(static_cast<size_t>(ret) == pkt.buf.size());
     }
+    send_queue->pop();
   }
-  else
-  {
-    assert(ret == send_buf->len);
-    sendBufferFull(false);
-  }
-  
-  delete send_buf;
-  send_buf = 0;
+
   wr_watch->setEnabled(false);
+  sendBufferFull(false);
   
 } /* UdpSocket::sendRest */
 
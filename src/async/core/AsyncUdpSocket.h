@@ -42,7 +42,9 @@ An example of how to use the Async::UdpSocket class
  ****************************************************************************/
 
 #include <sigc++/sigc++.h>
+#include <sys/uio.h>
 #include <stdint.h>
+#include <cstddef>
 
 
 /****************************************************************************
@@ -52,6 +54,7 @@ An example of how to use the Async::UdpSocket class
  ****************************************************************************/
 
 #include <AsyncIpAddress.h>
+#include <AsyncDataHandler.h>
 
 
 /****************************************************************************
@@ -68,7 +71,6 @@ An example of how to use the Async::UdpSocket class
  *
  ****************************************************************************/
 
-class UdpPacket;
 
 
 /****************************************************************************
@@ -124,12 +126,31 @@ This class is used to work with UDP sockets. An example usage is shown below.
 class UdpSocket : public sigc::trackable
 {
   public:
+    /**
+     * @brief   What to do when a datagram is written to a full send queue
+     */
+    typedef enum
+    {
+      DROP_NEWEST,  ///< Drop the datagram being written
+      DROP_OLDEST   ///< Drop the oldest queued datagram to make room
+    } DropPolicy;
+
+    /**
+     * @brief   The default maximum number of datagrams in the send queue
+     */
+    static const unsigned DEFAULT_SEND_QUEUE_SIZE = 64;
+
     /**
      * @brief 	Constructor
      * @param 	local_port  The local port to use. If not specified, a random
      *	      	      	    local port will be used.
      * @param  	bind_ip     Bind to the interface with the given IP address.
      *	      	            If left empty, bind to all interfaces.
+     *
+     * If no bind address is given, a dual-stack socket is created that can
+     * send to and receive from both IPv4 and IPv6 hosts. If the system do not
+     * support IPv6, an IPv4 socket is created. If a bind address is given,
+     * the socket only handle addresses of the same family.
      */
     UdpSocket(uint16_t local_port=0, const IpAddress &bind_ip=IpAddress());
   
@@ -159,19 +180,160 @@ class UdpSocket : public sigc::trackable
     bool write(const IpAddress& remote_ip, int remote_port, const void *buf,
 	int count);
 
+    /**
+     * @brief   Write a datagram gathered from multiple buffers
+     * @param   remote_ip   The IP-address of the remote host
+     * @param   remote_port The remote port to use
+     * @param   iov         An array of buffers making up the datagram
+     * @param   iovcnt      The number of buffers in the array
+     * @return  Return \em true on success or \em false on failure
+     *
+     * This function works like the write function above but the datagram is
+     * gathered from many buffers, e.g. a header and a payload that is shared
+     * between many datagrams. In batch mode, the buffers are copied into the
+     * batch so they do not need to be valid after the call.
+     */
+    bool writev(const IpAddress& remote_ip, int remote_port,
+                const struct iovec *iov, int iovcnt);
+
+    /**
+     * @brief   Enable or disable batched receive and transmit
+     * @param   batch_size        The maximum number of datagrams to handle in
+     *                            one system call. Set to 0 to disable.
+     * @param   max_datagram_size The maximum size of a datagram in batch mode
+     *
+     * In batch mode, up to batch_size datagrams are read from the socket using
+     * one call to recvmmsg when the socket become readable. The datagrams are
+     * read into a preallocated buffer ring and the dataReceived signal is
+     * emitted once for each datagram, just like in the normal mode. Received
+     * datagrams that are larger than max_datagram_size will be dropped.
+     *
+     * Batch mode is also required for write batching, see beginWriteBatch.
+     */
+    void setBatchMode(unsigned batch_size, size_t max_datagram_size=2048);
+
+    /**
+     * @brief   Check if batch mode is enabled
+     * @return  Returns \em true if batch mode is enabled
+     */
+    bool batchModeEnabled(void) const { return batch != 0; }
+
+    /**
+     * @brief   Start collecting outgoing datagrams
+     *
+     * After this function has been called, all calls to write will just queue
+     * the datagram in a preallocated buffer. The queued datagrams are sent
+     * using one call to sendmmsg when flushWriteBatch is called or when the
+     * batch is full. If batch mode is not enabled, this function does
+     * nothing and datagrams are sent directly.
+     */
+    void beginWriteBatch(void);
+
+    /**
+     * @brief   Send all queued datagrams and end the write batch
+     * @return  Returns \em false if one or more datagrams could not be sent
+     *
+     * If the send buffer become full, the unsent datagrams are put in the
+     * send queue just like for a normal write.
+     */
+    bool flushWriteBatch(void);
+
+    /**
+     * @brief   Set the maximum size of the send queue
+     * @param   max_datagrams The maximum number of queued datagrams
+     * @param   policy        What to do when the queue is full
+     *
+     * When the kernel send buffer is full, written datagrams are put in a
+     * queue that is drained when the socket become writable again. Datagrams
+     * written while the queue is non-empty are also queued to keep the order.
+     * If the queue is full, a datagram is dropped according to the given
+     * policy. Setting the size to 0 disable the queue so that datagrams
+     * are dropped directly when the send buffer is full. If the queue is
+     * shrunk, the oldest datagrams that do not fit are dropped.
+     */
+    void setSendQueueSize(unsigned max_datagrams,
+                          DropPolicy policy=DROP_NEWEST);
+
+    /**
+     * @brief   Get the number of datagrams waiting in the send queue
+     * @return  Returns the current length of the send queue
+     */
+    unsigned sendQueueLength(void) const;
+
+    /**
+     * @brief   Set the size of the kernel send buffer
+     * @param   bytes The requested size in bytes (SO_SNDBUF)
+     * @return  Returns \em true on success or \em false on failure
+     *
+     * The kernel may adjust the size. A larger send buffer make it less
+     * likely that the send queue has to be used on bursty traffic.
+     */
+    bool setSendBufferSize(int bytes);
+
+    /**
+     * @brief   Get the number of datagrams that have been queued
+     * @return  Returns the total number of datagrams put in the send queue
+     */
+    uint64_t datagramsQueued(void) const { return tx_queued; }
+
+    /**
+     * @brief   Get the number of datagrams that have been dropped
+     * @return  Returns the total number of datagrams dropped because the
+     *          send queue was full
+     */
+    uint64_t datagramsDropped(void) const { return tx_dropped; }
+
     /**
      * @brief   Get the file descriptor for the UDP socket
      * @return  Returns the file descriptor associated with the socket or
      *          -1 on error
      */
     int fd(void) const { return sock; }
+
+    /**
+     * @brief   Get the address family of the socket
+     * @return  Returns AF_INET or AF_INET6
+     *
+     * Use IpAddress::toSockAddr with this family when addresses for the
+     * socket have to be built outside of this class.
+     */
+    int family(void) const { return sock_family; }
     
+    /**
+     * @brief   Set a direct handler for received datagrams
+     * @param   obj   The object to call the handler member function on
+     *
+     * Set a member function to call for each received datagram instead of
+     * emitting the dataReceived signal. This avoid the overhead of the signal
+     * dispatch for sockets with exactly one receiver. The datagram is given as
+     * a view into the receive buffer of the socket. It is not valid after the
+     * handler has returned. The receiver must call clearDataHandler, or
+     * delete the socket, before it is destroyed.
+     *
+     * \code
+     * sock->setDataHandler<MyClass, &MyClass::onDatagram>(this);
+     * \endcode
+     */
+    template <typename T,
+              void (T::*Method)(const IpAddress&, uint16_t, DataView)>
+    void setDataHandler(T *obj) { rx_handler.set<T, Method>(obj); }
+
+    /**
+     * @brief   Remove the direct handler set using setDataHandler
+     *
+     * After this call the dataReceived signal is emitted again.
+     */
+    void clearDataHandler(void) { rx_handler.clear(); }
+
     /**
      * @brief 	A signal that is emitted when data has been received
      * @param 	ip    The IP-address the data was received from
      * @param   port  The remote port number
      * @param 	buf   The buffer containing the read data
      * @param 	count The number of bytes read
+     *
+     * The signal is not emitted when a handler has been set using
+     * setDataHandler.
      */
     sigc::signal<void, const IpAddress&, uint16_t, void*, int> dataReceived;
     
@@ -185,14 +347,39 @@ class UdpSocket : public sigc::trackable
   protected:
     
   private:
+    class Batch;
+    class SendQueue;
+    typedef DataHandler<void(const IpAddress&, uint16_t, DataView)> RxHandler;
+
     int       	sock;
+    int         sock_family;
     FdWatch * 	rd_watch;
     FdWatch * 	wr_watch;
-    UdpPacket * send_buf;
+    SendQueue * send_queue;
+    Batch *     batch;
+    uint64_t    tx_queued;
+    uint64_t    tx_dropped;
+    bool *      deleted_flag;
+    RxHandler   rx_handler;
     
     void cleanup(void);
+    bool sendBatch(void);
+    bool queueDatagram(const IpAddress& ip, int port, const struct iovec *iov,
+                       int iovcnt);
     void handleInput(FdWatch *watch);
     void sendRest(FdWatch *watch);
+    void emitDataReceived(const IpAddress& ip, uint16_t port, void *buf,
+                          int count)
+    {
+      if (rx_handler.isSet())
+      {
+        rx_handler(ip, port, DataView(buf, count));
+      }
+      else
+      {
+        dataReceived(ip, port, buf, count);
+      }
+    }
 
 };  /* class UdpSocket */
 
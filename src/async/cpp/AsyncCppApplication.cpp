@@ -39,12 +39,18 @@
 #include <sys/select.h>
 #include <signal.h>
 #include <unistd.h>
+#include <fcntl.h>
+#ifdef HAS_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #include <cstdlib>
 #include <cstdio>
 #include <cerrno>
 #include <cassert>
+#include <cstring>
 #include <algorithm>
+#include <iostream>
 
 
 /****************************************************************************
@@ -64,6 +70,7 @@
 #include "AsyncCppDnsLookupWorker.h"
 #include "AsyncFdWatch.h"
 #include "AsyncTimer.h"
+#include "AsyncTimerWheel.h"
 #include "AsyncCppApplication.h"
 
 
@@ -85,28 +92,6 @@ using namespace Async;
  *
  ****************************************************************************/
 
-# define clock_timeradd(a, b, result)                                         \
-  do {                                                                        \
-    (result)->tv_sec = (a)->tv_sec + (b)->tv_sec;                             \
-    (result)->tv_nsec = (a)->tv_nsec + (b)->tv_nsec;                          \
-    if ((result)->tv_nsec >= 1000000000)                                      \
-      {                                                                       \
-        ++(result)->tv_sec;                                                   \
-        (result)->tv_nsec -= 1000000000;                                      \
-      }                                                                       \
-  } while (0)
-
-# define clock_timersub(a, b, result)                                         \
-  do {                                                                        \
-    (result)->tv_sec = (a)->tv_sec - (b)->tv_sec;                             \
-    (result)->tv_nsec = (a)->tv_nsec - (b)->tv_nsec;                          \
-    if ((result)->tv_nsec < 0) {                                              \
-      --(result)->tv_sec;                                                     \
-      (result)->tv_nsec += 1000000000;                                        \
-    }                                                                         \
-  } while (0)
-
-
 
 
 /****************************************************************************
@@ -123,6 +108,7 @@ using namespace Async;
  *
  ****************************************************************************/
 
+static uint64_t monotonicNs(void);
 
 
 /****************************************************************************
@@ -161,79 +147,158 @@ int CppApplication::sighandler_pipe[2];
  * Bugs:      
  *------------------------------------------------------------------------
  */
-CppApplication::CppApplication(void)
-  : do_quit(false), max_desc(0), unix_signal_recv(-1), unix_signal_recv_cnt(0)
+CppApplication::CppApplication(BackendType backend)
+  : backend_type(BACKEND_SELECT), epoll_fd(-1), epoll_events(0),
+    epoll_events_size(0), epoll_event_cnt(0),
+    do_quit(false), max_desc(0), timer_wheel(0), firing_timer(0),
+    unix_signal_recv(-1), unix_signal_recv_cnt(0), stats_enabled(false),
+    stats_timer(0), stats_start_ns(0)
 {
   FD_ZERO(&rd_set);
   FD_ZERO(&wr_set);
-  sighandler_pipe[0] = sighandler_pipe[1] = -1;
+  if (isMainApplication())
+  {
+    sighandler_pipe[0] = sighandler_pipe[1] = -1;
+  }
+  timer_wheel = new TimerWheel(monotonicNs() / 1000000);
+
+  pthread_mutex_init(&post_mutex, NULL);
+  if (pipe2(post_pipe, O_NONBLOCK | O_CLOEXEC) == -1)
+  {
+    perror("pipe2");
+    exit(1);
+  }
+
+  if (backend == BACKEND_DEFAULT)
+  {
+    const char *backend_str = getenv("ASYNC_CPP_APPLICATION_BACKEND");
+    if ((backend_str != 0) && (strcmp(backend_str, "select") == 0))
+    {
+      backend = BACKEND_SELECT;
+    }
+    else
+    {
+      backend = BACKEND_EPOLL;
+    }
+  }
+
+#ifdef HAS_EPOLL
+  if (backend == BACKEND_EPOLL)
+  {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd >= 0)
+    {
+      backend_type = BACKEND_EPOLL;
+      epoll_events_size = 64;
+      epoll_events = new struct epoll_event[epoll_events_size];
+    }
+    else
+    {
+      perror("epoll_create1");
+    }
+  }
+#endif
+
+  const char *stats_str = getenv("ASYNC_CPP_APPLICATION_STATS");
+  if (stats_str != 0)
+  {
+    setStatsInterval(atoi(stats_str));
+  }
 } /* CppApplication::CppApplication */
 
 
 CppApplication::~CppApplication(void)
 {
   clearTasks();
+  delete stats_timer;
+  stats_timer = 0;
+#ifdef HAS_EPOLL
+  if (epoll_fd >= 0)
+  {
+    close(epoll_fd);
+  }
+  delete [] epoll_events;
+#endif
+  delete timer_wheel;
+  close(post_pipe[0]);
+  close(post_pipe[1]);
+  pthread_mutex_destroy(&post_mutex);
 } /* CppApplication::~CppApplication */
 
 
 void CppApplication::exec(void)
 {
-  if (pipe(sighandler_pipe) == -1)
+  FdWatch post_watch(post_pipe[0], FdWatch::FD_WATCH_RD);
+  post_watch.setLabel("Async::CppApplication::post");
+  post_watch.activity.connect(
+      hide(mem_fun(*this, &CppApplication::handlePostedTasks)));
+
+    // UNIX signals are process wide so they are only handled by the main
+    // application
+  const bool handle_signals = isMainApplication();
+  FdWatch watch;
+  if (handle_signals)
   {
-    perror("pipe");
-    exit(1);
-  }
+    if (pipe(sighandler_pipe) == -1)
+    {
+      perror("pipe");
+      exit(1);
+    }
 
-  FdWatch watch(sighandler_pipe[0], FdWatch::FD_WATCH_RD);
-  watch.activity.connect(
-      hide(mem_fun(*this, &CppApplication::handleUnixSignal)));
+    watch.setFd(sighandler_pipe[0], FdWatch::FD_WATCH_RD);
+    watch.setLabel("Async::CppApplication::unixSignalCaught");
+    watch.setEnabled(true);
+    watch.activity.connect(
+        hide(mem_fun(*this, &CppApplication::handleUnixSignal)));
 
-  for (UnixSignalMap::const_iterator it = unix_signals.begin();
-       it != unix_signals.end();
-       ++it)
-  {
-    struct sigaction act;
-    act.sa_handler = unixSignalHandler;
-    sigemptyset(&act.sa_mask);
-    act.sa_flags = 0;
-    if (sigaction((*it).first, &act, NULL) == -1)
+    for (UnixSignalMap::const_iterator it = unix_signals.begin();
+         it != unix_signals.end();
+         ++it)
     {
-      perror("sigaction");
-      exit(1);
+      struct sigaction act;
+      act.sa_handler = unixSignalHandler;
+      sigemptyset(&act.sa_mask);
+      act.sa_flags = 0;
+      if (sigaction((*it).first, &act, NULL) == -1)
+      {
+        perror("sigaction");
+        exit(1);
+      }
     }
   }
+
+    // Pick up tasks posted before the main loop was started
+  handlePostedTasks();
   
   while (!do_quit)
   {
     struct timespec *timeout_ptr = 0;
     struct timespec timeout;
-    TimerMap::iterator titer = timer_map.begin();
-    while (titer != timer_map.end())
+    uint64_t next_ms;
+    if (timer_wheel->nextEvent(next_ms))
     {
-      if (titer->second != 0)
-      {
-	struct timespec ts;
-	clock_gettime(CLOCK_MONOTONIC, &ts);
-	clock_timersub(&titer->first, &ts, &timeout);
-	if (timeout.tv_sec < 0)
-	{
-	  timeout.tv_sec = 0;
-	  timeout.tv_nsec = 0;
-	}
-	timeout_ptr = &timeout;
-	break;
-      }
-      else
-      {
-	timer_map.erase(titer);
-      }
-      titer = timer_map.begin();
+      uint64_t now_ns = monotonicNs();
+      uint64_t next_ns = next_ms * 1000000;
+      uint64_t wait_ns = (next_ns > now_ns) ? (next_ns - now_ns) : 0;
+      timeout.tv_sec = wait_ns / 1000000000;
+      timeout.tv_nsec = wait_ns % 1000000000;
+      timeout_ptr = &timeout;
     }
     
-    fd_set local_rd_set = rd_set;
-    fd_set local_wr_set = wr_set;
-    int dcnt = pselect(max_desc, &local_rd_set, &local_wr_set, NULL,
-	timeout_ptr, NULL);
+    fd_set local_rd_set;
+    fd_set local_wr_set;
+    int dcnt;
+    if (backend_type == BACKEND_EPOLL)
+    {
+      dcnt = epollWait(timeout_ptr);
+    }
+    else
+    {
+      local_rd_set = rd_set;
+      local_wr_set = wr_set;
+      dcnt = pselect(max_desc, &local_rd_set, &local_wr_set, NULL,
+                     timeout_ptr, NULL);
+    }
     if (dcnt == -1)
     {
       if ((errno == EINTR) || (errno == EAGAIN))
@@ -242,87 +307,49 @@ void CppApplication::exec(void)
       }
       else
       {
-        perror("pselect");
+        perror((backend_type == BACKEND_EPOLL) ? "epoll_wait" : "pselect");
         exit(1);
       }
     }
     
-    if ((timeout_ptr != 0)
-        && ((dcnt == 0)
-            || ((timeout_ptr->tv_sec == 0) && (timeout_ptr->tv_nsec == 0))
-           )
-       )
+    if (stats_enabled)
     {
-      titer->second->expired(titer->second);
-      if ((titer->second != 0) &&
-	  (titer->second->type() == Timer::TYPE_PERIODIC))
-      {
-	addTimerP(titer->second, titer->first);
-      }
-      timer_map.erase(titer);
+      pthread_mutex_lock(&post_mutex);
+      size_t posted = post_queue.size();
+      pthread_mutex_unlock(&post_mutex);
+      stats.addIteration(pendingTaskCount() + posted);
     }
-    
-    WatchMap::iterator witer, next_witer;
-    
-      /* Check for activity on the read watch file descriptors */
-    witer=rd_watch_map.begin();
-    while ((dcnt > 0) && (witer != rd_watch_map.end()))
+
+    processTimers();
+
+    if (backend_type == BACKEND_EPOLL)
     {
-      next_witer = witer;
-      ++next_witer;
-      if (FD_ISSET(witer->first, &local_rd_set))
-      {
-	if (witer->second != 0)
-	{
-	  witer->second->activity(witer->second);
-	}
-	else
-	{
-	  rd_watch_map.erase(witer);
-	}
-	--dcnt;
-      }
-      witer = next_witer;
+      dispatchEpollWatches();
     }
-    
-      /* Check for activity on the write watch file descriptors */
-    witer=wr_watch_map.begin();
-    while ((dcnt > 0) && (witer != wr_watch_map.end()))
+    else
     {
-      next_witer = witer;
-      ++next_witer;
-      if (FD_ISSET(witer->first, &local_wr_set))
-      {
-	if (witer->second != 0)
-	{
-	  witer->second->activity(witer->second);
-	}
-	else
-	{
-	  wr_watch_map.erase(witer);
-	}
-	--dcnt;
-      }
-      witer = next_witer;
+      dispatchSelectWatches(&local_rd_set, &local_wr_set, dcnt);
     }
-    
-    assert(dcnt == 0);
   }
 
-  for (UnixSignalMap::const_iterator it = unix_signals.begin();
-       it != unix_signals.end();
-       ++it)
+  if (handle_signals)
   {
-    if (sigaction((*it).first, &(*it).second, NULL) == -1)
+    for (UnixSignalMap::const_iterator it = unix_signals.begin();
+         it != unix_signals.end();
+         ++it)
     {
-      perror("sigaction");
-      exit(1);
+      if (sigaction((*it).first, &(*it).second, NULL) == -1)
+      {
+        perror("sigaction");
+        exit(1);
+      }
     }
-  }
 
-  close(sighandler_pipe[1]);
-  close(sighandler_pipe[0]);
-  sighandler_pipe[0] = sighandler_pipe[1] = -1;
+    watch.setEnabled(false);
+    close(sighandler_pipe[1]);
+    close(sighandler_pipe[0]);
+    sighandler_pipe[0] = sighandler_pipe[1] = -1;
+  }
 } /* CppApplication::exec */
 
 
@@ -334,6 +361,13 @@ void CppApplication::quit(void)
 
 void CppApplication::catchUnixSignal(int signum)
 {
+  if (!isMainApplication())
+  {
+    cerr << "*** WARNING: UNIX signals can only be caught by the main "
+            "application" << endl;
+    return;
+  }
+
   UnixSignalMap::iterator it = unix_signals.find(signum);
   if (it != unix_signals.end())
   {
@@ -378,6 +412,60 @@ void CppApplication::uncatchUnixSignal(int signum)
 } /* CppApplication::uncatchUnixSignal */
 
 
+void CppApplication::post(sigc::slot<void> task)
+{
+  pthread_mutex_lock(&post_mutex);
+  bool was_empty = post_queue.empty();
+  post_queue.push_back(task);
+  pthread_mutex_unlock(&post_mutex);
+
+    // Only wake the loop up for the first task. The pipe is drained and the
+    // whole queue is handled in one go by the loop thread.
+  if (was_empty)
+  {
+    char ch = 0;
+    if ((write(post_pipe[1], &ch, 1) == -1) && (errno != EAGAIN))
+    {
+      perror("write");
+    }
+  }
+} /* CppApplication::post */
+
+
+void CppApplication::setStatsInterval(int interval_ms)
+{
+  if (interval_ms <= 0)
+  {
+    delete stats_timer;
+    stats_timer = 0;
+    stats_enabled = false;
+    stats.clear();
+    return;
+  }
+
+  if (stats_timer == 0)
+  {
+    stats_timer = new Timer(interval_ms, Timer::TYPE_PERIODIC);
+    stats_timer->setLabel("Async::CppApplication::statsUpdated");
+    stats_timer->expired.connect(
+        mem_fun(*this, &CppApplication::statsTimerExpired));
+  }
+  else
+  {
+    stats_timer->setTimeout(interval_ms);
+  }
+  stats.clear();
+  stats_start_ns = monotonicNs();
+  stats_enabled = true;
+} /* CppApplication::setStatsInterval */
+
+
+int CppApplication::statsInterval(void) const
+{
+  return (stats_timer != 0) ? stats_timer->timeout() : 0;
+} /* CppApplication::statsInterval */
+
+
 
 /****************************************************************************
  *
@@ -420,6 +508,20 @@ void CppApplication::unixSignalHandler(int signum)
 void CppApplication::addFdWatch(FdWatch *fd_watch)
 {
   int fd = fd_watch->fd();
+
+  if (backend_type == BACKEND_EPOLL)
+  {
+    if (fd >= static_cast<int>(epoll_watches.size()))
+    {
+      epoll_watches.resize(fd + 1);
+    }
+    EpollWatch& ew = epoll_watches[fd];
+    FdWatch *&slot = (fd_watch->type() == FdWatch::FD_WATCH_RD) ? ew.rd : ew.wr;
+    assert(slot == 0);
+    slot = fd_watch;
+    epollUpdate(fd);
+    return;
+  }
   //printf("Adding watch for fd=%d (max_desc=%d)\n", fd, max_desc);
   
   WatchMap *watch_map = 0;
@@ -453,6 +555,17 @@ void CppApplication::addFdWatch(FdWatch *fd_watch)
 void CppApplication::delFdWatch(FdWatch *fd_watch)
 {
   int fd = fd_watch->fd();
+
+  if (backend_type == BACKEND_EPOLL)
+  {
+    assert(fd < static_cast<int>(epoll_watches.size()));
+    EpollWatch& ew = epoll_watches[fd];
+    FdWatch *&slot = (fd_watch->type() == FdWatch::FD_WATCH_RD) ? ew.rd : ew.wr;
+    assert(slot == fd_watch);
+    slot = 0;
+    epollUpdate(fd);
+    return;
+  }
   WatchMap *watch_map = 0;
   switch (fd_watch->type())
   {
@@ -500,41 +613,279 @@ void CppApplication::delFdWatch(FdWatch *fd_watch)
 } /* CppApplication::delFdWatch */
 
 
+void CppApplication::dispatchSelectWatches(fd_set *rd, fd_set *wr, int dcnt)
+{
+  WatchMap::iterator witer, next_witer;
+  
+    /* Check for activity on the read watch file descriptors */
+  witer=rd_watch_map.begin();
+  while ((dcnt > 0) && (witer != rd_watch_map.end()))
+  {
+    next_witer = witer;
+    ++next_witer;
+    if (FD_ISSET(witer->first, rd))
+    {
+      if (witer->second != 0)
+      {
+        dispatchActivity(witer->second);
+      }
+      else
+      {
+        rd_watch_map.erase(witer);
+      }
+      --dcnt;
+    }
+    witer = next_witer;
+  }
+  
+    /* Check for activity on the write watch file descriptors */
+  witer=wr_watch_map.begin();
+  while ((dcnt > 0) && (witer != wr_watch_map.end()))
+  {
+    next_witer = witer;
+    ++next_witer;
+    if (FD_ISSET(witer->first, wr))
+    {
+      if (witer->second != 0)
+      {
+        dispatchActivity(witer->second);
+      }
+      else
+      {
+        wr_watch_map.erase(witer);
+      }
+      --dcnt;
+    }
+    witer = next_witer;
+  }
+  
+  assert(dcnt == 0);
+} /* CppApplication::dispatchSelectWatches */
+
+
+int CppApplication::epollWait(const struct timespec *timeout)
+{
+#ifdef HAS_EPOLL
+  int timeout_ms = -1;
+  if (!unpollable_fds.empty())
+  {
+    timeout_ms = 0;
+  }
+  else if (timeout != 0)
+  {
+      // Round up so that we never wake up before the timer expire
+    timeout_ms = timeout->tv_sec * 1000 + (timeout->tv_nsec + 999999) / 1000000;
+  }
+  int nevents = epoll_wait(epoll_fd, epoll_events, epoll_events_size,
+                           timeout_ms);
+  if (nevents == -1)
+  {
+    epoll_event_cnt = 0;
+    return -1;
+  }
+  epoll_event_cnt = nevents;
+  if ((nevents == 0) && !unpollable_fds.empty() && (timeout != 0) &&
+      ((timeout->tv_sec != 0) || (timeout->tv_nsec != 0)))
+  {
+      // The unpollable watches are always ready, just like for select
+    return unpollable_fds.size();
+  }
+  return nevents;
+#else
+  assert(!"Epoll backend not available");
+  return -1;
+#endif
+} /* CppApplication::epollWait */
+
+
+void CppApplication::dispatchEpollWatches(void)
+{
+#ifdef HAS_EPOLL
+  for (int i=0; i<epoll_event_cnt; ++i)
+  {
+    int fd = epoll_events[i].data.fd;
+    uint32_t events = epoll_events[i].events;
+
+      // The watch may have been removed by a previously dispatched callback
+      // so the watch table must be checked again before each call.
+    if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) &&
+        (fd < static_cast<int>(epoll_watches.size())) &&
+        (epoll_watches[fd].rd != 0))
+    {
+      FdWatch *watch = epoll_watches[fd].rd;
+      dispatchActivity(watch);
+    }
+    if ((events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) &&
+        (fd < static_cast<int>(epoll_watches.size())) &&
+        (epoll_watches[fd].wr != 0))
+    {
+      FdWatch *watch = epoll_watches[fd].wr;
+      dispatchActivity(watch);
+    }
+  }
+
+    // File descriptors that epoll cannot handle, like regular files, are
+    // always reported as ready just like pselect would do
+  if (!unpollable_fds.empty())
+  {
+    std::vector<int> fds(unpollable_fds.begin(), unpollable_fds.end());
+    for (std::vector<int>::const_iterator it = fds.begin();
+         it != fds.end(); ++it)
+    {
+      if (epoll_watches[*it].rd != 0)
+      {
+        FdWatch *watch = epoll_watches[*it].rd;
+        dispatchActivity(watch);
+      }
+      if (epoll_watches[*it].wr != 0)
+      {
+        FdWatch *watch = epoll_watches[*it].wr;
+        dispatchActivity(watch);
+      }
+    }
+  }
+
+    // Grow the event buffer if it was filled up
+  if (epoll_event_cnt == epoll_events_size)
+  {
+    delete [] epoll_events;
+    epoll_events_size *= 2;
+    epoll_events = new struct epoll_event[epoll_events_size];
+    epoll_event_cnt = 0;
+  }
+#endif
+} /* CppApplication::dispatchEpollWatches */
+
+
+void CppApplication::epollUpdate(int fd)
+{
+#ifdef HAS_EPOLL
+  EpollWatch& ew = epoll_watches[fd];
+  uint32_t events = 0;
+  if (ew.rd != 0)
+  {
+    events |= EPOLLIN;
+  }
+  if (ew.wr != 0)
+  {
+    events |= EPOLLOUT;
+  }
+
+  if (!ew.pollable)
+  {
+    if (events == 0)
+    {
+      unpollable_fds.erase(fd);
+      ew.pollable = true;
+    }
+    return;
+  }
+
+  if (events == ew.events)
+  {
+    return;
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.fd = fd;
+  int op = EPOLL_CTL_MOD;
+  if (ew.events == 0)
+  {
+    op = EPOLL_CTL_ADD;
+  }
+  else if (events == 0)
+  {
+    op = EPOLL_CTL_DEL;
+  }
+  if (epoll_ctl(epoll_fd, op, fd, &ev) == -1)
+  {
+    if ((op == EPOLL_CTL_ADD) && (errno == EPERM))
+    {
+        // Regular files and some other types of files cannot be polled
+      ew.pollable = false;
+      ew.events = 0;
+      unpollable_fds.insert(fd);
+      return;
+    }
+    else if ((op == EPOLL_CTL_MOD) && (errno == ENOENT))
+    {
+        // The file descriptor have been closed and reopened without
+        // removing the watch first
+      if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+      {
+        perror("epoll_ctl");
+      }
+    }
+    else if ((op != EPOLL_CTL_DEL) || ((errno != EBADF) && (errno != ENOENT)))
+    {
+      perror("epoll_ctl");
+    }
+  }
+  ew.events = events;
+#endif
+} /* CppApplication::epollUpdate */
+
+
+
 void CppApplication::addTimer(Timer *timer)
 {
-  struct timespec current;
-  clock_gettime(CLOCK_MONOTONIC, &current);
-  addTimerP(timer, current);
+    // Round up to the next millisecond so that the timer never expire early
+  uint64_t expire_ns = monotonicNs() + uint64_t(timer->timeout()) * 1000000;
+  timer_wheel->add(timer, (expire_ns + 999999) / 1000000);
 } /* CppApplication::addTimer */
 
 
-void CppApplication::addTimerP(Timer *timer, const struct timespec& current)
+void CppApplication::delTimer(Timer *timer)
 {
-  struct timespec add;
-  struct timespec expiration;
-  int timeout = timer->timeout();
-  add.tv_sec = timeout / 1000;
-  timeout -= add.tv_sec * 1000;
-  add.tv_nsec = timeout * 1000000;
-  clock_timeradd(&current, &add, &expiration);
-  
-  timer_map.insert(pair<struct timespec, Timer *>(expiration, timer));
-} /* CppApplication::addTimerP */
+  if (timer == firing_timer)
+  {
+    firing_timer = 0;
+  }
+  timer_wheel->remove(timer);
+} /* CppApplication::delTimer */
 
 
-void CppApplication::delTimer(Timer *timer)
+void CppApplication::processTimers(void)
 {
-  TimerMap::iterator iter;
-  for (iter=timer_map.begin(); iter!=timer_map.end(); ++iter)
+  if (timer_wheel->isEmpty())
   {
-    if (iter->second == timer)
+    return;
+  }
+
+  timer_wheel->advance(monotonicNs() / 1000000);
+
+    // The expired timers have been moved out of the wheel so timers that are
+    // added from within a timer callback will not be processed until the
+    // next main loop iteration.
+  Timer *timer;
+  uint64_t expire_ms;
+  while ((timer = timer_wheel->popExpired(expire_ms)) != 0)
+  {
+    firing_timer = timer;
+    if (stats_enabled)
     {
-      //timer_map.erase(iter);
-      iter->second = 0;
-      break;
+        // The label is copied since the timer may be deleted by the callback
+      string label(timer->label().empty() ? "Timer" : timer->label());
+      uint64_t start_ns = monotonicNs();
+      uint64_t expire_ns = expire_ms * 1000000;
+      stats.timerLag().add(
+          (start_ns > expire_ns) ? (start_ns - expire_ns) / 1000 : 0);
+      timer->expired(timer);
+      stats.callback(label).add((monotonicNs() - start_ns) / 1000);
+    }
+    else
+    {
+      timer->expired(timer);
+    }
+    if ((firing_timer == timer) && (timer->type() == Timer::TYPE_PERIODIC))
+    {
+      timer_wheel->add(timer, expire_ms + timer->timeout());
     }
   }
-} /* CppApplication::delTimer */
+  firing_timer = 0;
+} /* CppApplication::processTimers */
 
 
 DnsLookupWorker *CppApplication::newDnsLookupWorker(const string& label)
@@ -560,6 +911,66 @@ void CppApplication::handleUnixSignal(void)
 } /* CppApplication::handleUnixSignal */
 
 
+void CppApplication::handlePostedTasks(void)
+{
+  TaskQueue tasks;
+  pthread_mutex_lock(&post_mutex);
+  char buf[64];
+  while (read(post_pipe[0], buf, sizeof(buf)) > 0)
+  {
+  }
+  tasks.swap(post_queue);
+  pthread_mutex_unlock(&post_mutex);
+
+  for (TaskQueue::iterator it = tasks.begin(); it != tasks.end(); ++it)
+  {
+    (*it)();
+  }
+} /* CppApplication::handlePostedTasks */
+
+
+void CppApplication::dispatchActivity(FdWatch *watch)
+{
+  if (!stats_enabled)
+  {
+    watch->activity(watch);
+    return;
+  }
+
+    // The label is copied since the watch may be deleted by the callback
+  string label(watch->label().empty() ? "FdWatch" : watch->label());
+  uint64_t start_ns = monotonicNs();
+  watch->activity(watch);
+  stats.callback(label).add((monotonicNs() - start_ns) / 1000);
+} /* CppApplication::dispatchActivity */
+
+
+void CppApplication::statsTimerExpired(Timer *t)
+{
+  uint64_t now_ns = monotonicNs();
+  stats.setIntervalUs((now_ns - stats_start_ns) / 1000);
+  if (statsUpdated.empty())
+  {
+    stats.print(cout);
+  }
+  else
+  {
+    statsUpdated(stats);
+  }
+  stats.clear();
+  stats_start_ns = now_ns;
+} /* CppApplication::statsTimerExpired */
+
+
+
+static uint64_t monotonicNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+} /* monotonicNs */
+
+
 
 /*
  * This file has not been truncated
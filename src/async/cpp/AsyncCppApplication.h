@@ -42,9 +42,12 @@
 #include <sys/select.h>
 #include <sys/time.h>
 #include <signal.h>
+#include <pthread.h>
 #include <sigc++/sigc++.h>
 
 #include <map>
+#include <set>
+#include <vector>
 #include <utility>
 
 
@@ -55,6 +58,7 @@
  ****************************************************************************/
 
 #include <AsyncApplication.h>
+#include <AsyncEventLoopStats.h>
 
 
 /****************************************************************************
@@ -71,6 +75,7 @@
  *
  ****************************************************************************/
 
+struct epoll_event;
 
 
 /****************************************************************************
@@ -82,6 +87,9 @@
 namespace Async
 {
 
+class TimerWheel;
+
+
 /****************************************************************************
  *
  * Defines & typedefs
@@ -136,10 +144,25 @@ namespace Async
 class CppApplication : public Application
 {
   public:
+    /**
+     * @brief The mechanism used to wait for file descriptor activity
+     */
+    typedef enum
+    {
+      BACKEND_DEFAULT,  ///< Use epoll if available, otherwise pselect
+      BACKEND_SELECT,   ///< Use pselect, limited to FD_SETSIZE descriptors
+      BACKEND_EPOLL     ///< Use epoll (Linux only)
+    } BackendType;
+
     /**
      * @brief Constructor
+     * @param backend The event backend to use (see @ref BackendType)
+     *
+     * If BACKEND_DEFAULT is given, the backend can be forced to pselect by
+     * setting the environment variable ASYNC_CPP_APPLICATION_BACKEND=select.
+     * If the epoll backend cannot be set up, pselect will be used instead.
      */
-    CppApplication(void);
+    explicit CppApplication(BackendType backend=BACKEND_DEFAULT);
 
     /**
      * @brief Destructor
@@ -149,6 +172,9 @@ class CppApplication : public Application
     /**
      * @brief   Catch the specified UNIX signal
      * @param   signum The signal number to catch
+     *
+     * UNIX signals can only be caught by the main application object, not by
+     * application objects running in other threads.
      */
     void catchUnixSignal(int signum);
 
@@ -183,45 +209,114 @@ class CppApplication : public Application
      * signal will be emitted.
      */
     sigc::signal<void, int> unixSignalCaught;
+
+    /**
+     * @brief   Find out which event backend that is in use
+     * @return  Returns BACKEND_SELECT or BACKEND_EPOLL
+     */
+    BackendType backend(void) const { return backend_type; }
+
+    /**
+     * @brief   Run a task in the thread running this application
+     * @param   task The task (SigC++ slot) to run
+     *
+     * This function is like Async::Application::runTask but it may be called
+     * from any thread. The task will be run by the thread executing the main
+     * loop of this application object. Tasks are run in the order they were
+     * posted. Tasks posted before exec is called are run when the main loop
+     * is started. The slot, including bound arguments, is copied to the loop
+     * thread so any objects it refer to must be safe to use from that thread.
+     */
+    void post(sigc::slot<void> task);
+
+    /**
+     * @brief   Enable or disable collection of event loop statistics
+     * @param   interval_ms The reporting interval in milliseconds or 0 to
+     *                      disable
+     *
+     * When enabled, the main loop measure how long each FdWatch, Timer and
+     * task callback take to run, how late timers are dispatched and how many
+     * tasks are waiting to be run. Callbacks are grouped on the label set
+     * using FdWatch::setLabel or Timer::setLabel. The statistics are reported
+     * through the statsUpdated signal each interval. If no slot is connected
+     * to the signal, the statistics are printed to standard output.
+     * Collection of statistics can also be enabled by setting the environment
+     * variable ASYNC_CPP_APPLICATION_STATS to the interval in milliseconds.
+     */
+    void setStatsInterval(int interval_ms);
+
+    /**
+     * @brief   Get the statistics reporting interval
+     * @return  Returns the interval in milliseconds or 0 if disabled
+     */
+    int statsInterval(void) const;
+
+    /**
+     * @brief   A signal that is emitted when new statistics are available
+     * @param   stats The statistics for the last interval
+     */
+    sigc::signal<void, const EventLoopStats&> statsUpdated;
     
   protected:
     
   private:
-    struct lttimespec
-    {
-      bool operator()(const struct timespec& t1, const struct timespec& t2) const
-      {
-        return ((t1.tv_sec == t2.tv_sec)
-                ? (t1.tv_nsec < t2.tv_nsec)
-                : (t1.tv_sec < t2.tv_sec));
-      }
-    };
     typedef std::map<int, FdWatch*>   	      	      	        WatchMap;
-    typedef std::multimap<struct timespec, Timer *, lttimespec> TimerMap;
     typedef std::map<int, struct sigaction>                     UnixSignalMap;
+    struct EpollWatch
+    {
+      FdWatch*  rd;
+      FdWatch*  wr;
+      uint32_t  events;
+      bool      pollable;
+      EpollWatch(void) : rd(0), wr(0), events(0), pollable(true) {}
+    };
+    typedef std::vector<EpollWatch>                             EpollWatches;
+    typedef std::vector<sigc::slot<void> >                      TaskQueue;
     
     static int          sighandler_pipe[2];
 
+    BackendType         backend_type;
+    int                 epoll_fd;
+    EpollWatches        epoll_watches;
+    struct epoll_event* epoll_events;
+    int                 epoll_events_size;
+    int                 epoll_event_cnt;
+    std::set<int>       unpollable_fds;
     bool      	      	do_quit;
     int       	      	max_desc;
     fd_set    	      	rd_set;
     fd_set    	      	wr_set;
     WatchMap  	      	rd_watch_map;
     WatchMap  	      	wr_watch_map;
-    TimerMap  	      	timer_map;
+    TimerWheel          *timer_wheel;
+    Timer               *firing_timer;
     UnixSignalMap       unix_signals;
     int                 unix_signal_recv;
     size_t              unix_signal_recv_cnt;
+    pthread_mutex_t     post_mutex;
+    TaskQueue           post_queue;
+    int                 post_pipe[2];
+    EventLoopStats      stats;
+    bool                stats_enabled;
+    Timer               *stats_timer;
+    uint64_t            stats_start_ns;
     
     static void unixSignalHandler(int signum);
 
     void addFdWatch(FdWatch *fd_watch);
     void delFdWatch(FdWatch *fd_watch);
+    void dispatchSelectWatches(fd_set *rd, fd_set *wr, int dcnt);
+    int epollWait(const struct timespec *timeout);
+    void dispatchEpollWatches(void);
+    void epollUpdate(int fd);
     void addTimer(Timer *timer);
-    void addTimerP(Timer *timer, const struct timespec& current);
-    void delTimer(Timer *timer);    
+    void delTimer(Timer *timer);
+    void processTimers(void);
     DnsLookupWorker *newDnsLookupWorker(const std::string& label);
     void handleUnixSignal(void);
+    void handlePostedTasks(void);
+    void dispatchActivity(FdWatch *watch);
+    void statsTimerExpired(Timer *t);
     
 };  /* class CppApplication */
 
@@ -41,8 +41,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <sigc++/sigc++.h>
-#include <pthread.h>
-#include <netdb.h>
 
 #include <string>
 #include <vector>
@@ -116,7 +114,7 @@ class FdWatch;
 
 This is the DNS lookup worker for the Cpp variant of the async environment.
 It is an internal class that should only be used from within the async
-library.
+library. The actual lookups are done by the shared Async::CppDnsResolver.
 */
 class CppDnsLookupWorker : public DnsLookupWorker, public sigc::trackable
 {
@@ -147,6 +145,15 @@ class CppDnsLookupWorker : public DnsLookupWorker, public sigc::trackable
      * the hostname in the query.
      */
     virtual std::vector<IpAddress> addresses(void) { return the_addresses; }
+
+    /**
+     * @brief   Called by the resolver when the lookup is done
+     * @param   addresses The addresses found for the label
+     *
+     * This function is called from a resolver thread, or from doLookup if
+     * the result was cached, with the resolver lock held.
+     */
+    void lookupDone(const std::vector<IpAddress>& addresses);
     
     
   protected:
@@ -154,16 +161,11 @@ class CppDnsLookupWorker : public DnsLookupWorker, public sigc::trackable
   private:
     std::string	      	    label;
     std::vector<IpAddress>  the_addresses;
-    pthread_t 	      	    worker_thread;
     int       	      	    notifier_rd;
     int       	      	    notifier_wr;
     Async::FdWatch    	    *notifier_watch;
-    bool      	      	    done;
-    struct addrinfo    	    *result;
+    bool      	      	    lookup_started;
   
-    static void *workerFunc(void *);
-
-    void onTimeout(Timer *t);
     void notificationReceived(FdWatch *w);
 
 };  /* class CppDnsLookupWorker */
@@ -0,0 +1,339 @@
+/**
+@file   AsyncCppDnsResolver.cpp
+@brief  A shared pool of resolver threads with a result cache
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <time.h>
+#include <cstring>
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncCppDnsResolver.h"
+#include "AsyncCppDnsLookupWorker.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Static class variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+CppDnsResolver& CppDnsResolver::instance(void)
+{
+    // Intentionally leaked. See the class documentation.
+  static CppDnsResolver *resolver = new CppDnsResolver;
+  return *resolver;
+} /* CppDnsResolver::instance */
+
+
+bool CppDnsResolver::lookup(const string& label, CppDnsLookupWorker *worker)
+{
+  pthread_mutex_lock(&m_mutex);
+
+  Cache::iterator cit = m_cache.find(label);
+  if (cit != m_cache.end())
+  {
+    if (cit->second.expire_ms > nowMs())
+    {
+      worker->lookupDone(cit->second.addresses);
+      pthread_mutex_unlock(&m_mutex);
+      return true;
+    }
+    m_cache.erase(cit);
+  }
+
+  Jobs::iterator jit = m_jobs.find(label);
+  if (jit != m_jobs.end())
+  {
+    jit->second->waiters.push_back(worker);
+    pthread_mutex_unlock(&m_mutex);
+    return true;
+  }
+
+  if ((m_idle_threads == 0) && (m_threads < THREADS))
+  {
+    pthread_t thread;
+    int ret = pthread_create(&thread, NULL, threadFunc, this);
+    if (ret == 0)
+    {
+      pthread_detach(thread);
+      ++m_threads;
+    }
+    else if (m_threads == 0)
+    {
+      pthread_mutex_unlock(&m_mutex);
+      cerr << "*** ERROR: pthread_create: " << strerror(ret) << endl;
+      return false;
+    }
+  }
+
+  Job *job = new Job;
+  job->label = label;
+  job->waiters.push_back(worker);
+  m_jobs[label] = job;
+  m_queue.push_back(job);
+  pthread_cond_signal(&m_cond);
+  pthread_mutex_unlock(&m_mutex);
+
+  return true;
+} /* CppDnsResolver::lookup */
+
+
+void CppDnsResolver::cancel(const string& label, CppDnsLookupWorker *worker)
+{
+  pthread_mutex_lock(&m_mutex);
+  Jobs::iterator it = m_jobs.find(label);
+  if (it != m_jobs.end())
+  {
+    vector<CppDnsLookupWorker*>& waiters = it->second->waiters;
+    waiters.erase(remove(waiters.begin(), waiters.end(), worker),
+                  waiters.end());
+  }
+  pthread_mutex_unlock(&m_mutex);
+} /* CppDnsResolver::cancel */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void *CppDnsResolver::threadFunc(void *r)
+{
+  reinterpret_cast<CppDnsResolver *>(r)->run();
+  return NULL;
+} /* CppDnsResolver::threadFunc */
+
+
+uint64_t CppDnsResolver::nowMs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+} /* CppDnsResolver::nowMs */
+
+
+CppDnsResolver::CppDnsResolver(void)
+  : m_threads(0), m_idle_threads(0)
+{
+  pthread_mutex_init(&m_mutex, NULL);
+  pthread_cond_init(&m_cond, NULL);
+} /* CppDnsResolver::CppDnsResolver */
+
+
+CppDnsResolver::~CppDnsResolver(void)
+{
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_mutex);
+} /* CppDnsResolver::~CppDnsResolver */
+
+
+void CppDnsResolver::run(void)
+{
+  pthread_mutex_lock(&m_mutex);
+  for (;;)
+  {
+    while (m_queue.empty())
+    {
+      ++m_idle_threads;
+      pthread_cond_wait(&m_cond, &m_mutex);
+      --m_idle_threads;
+    }
+    Job *job = m_queue.front();
+    m_queue.pop_front();
+    pthread_mutex_unlock(&m_mutex);
+
+    Addresses addresses;
+    bool cacheable = resolve(job->label, addresses);
+
+    pthread_mutex_lock(&m_mutex);
+    m_jobs.erase(job->label);
+    if (cacheable)
+    {
+      uint64_t now = nowMs();
+      pruneCache(now);
+      CacheEntry& entry = m_cache[job->label];
+      entry.addresses = addresses;
+      entry.expire_ms = now +
+        (addresses.empty() ? NEGATIVE_TTL : POSITIVE_TTL);
+    }
+    for (vector<CppDnsLookupWorker*>::iterator it = job->waiters.begin();
+         it != job->waiters.end(); ++it)
+    {
+      (*it)->lookupDone(addresses);
+    }
+    delete job;
+  }
+} /* CppDnsResolver::run */
+
+
+/*
+ *----------------------------------------------------------------------------
+ * Method:    CppDnsResolver::resolve
+ * Purpose:   Do the actual, blocking, lookup.
+ * Input:     label     - The name to look up
+ *            addresses - Filled in with the unique addresses found
+ * Output:    Returns true if the result may be cached
+ * Author:    Tobias Blomberg / SM0SVX
+ * Created:   2026-10-14
+ * Remarks:   Called without the resolver lock held
+ * Bugs:
+ *----------------------------------------------------------------------------
+ */
+bool CppDnsResolver::resolve(const string& label, Addresses& addresses)
+{
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_ADDRCONFIG;
+  struct addrinfo *result = 0;
+  int ret = getaddrinfo(label.c_str(), NULL, &hints, &result);
+  if (ret != 0)
+  {
+    cerr << "*** WARNING: Could not look up host \"" << label
+         << "\": " << gai_strerror(ret) << endl;
+    return (ret == EAI_NONAME);
+  }
+
+  for (struct addrinfo *entry = result; entry != 0; entry = entry->ai_next)
+  {
+    IpAddress ip_addr;
+    if (ip_addr.setFromSockAddr(entry->ai_addr) &&
+        (find(addresses.begin(), addresses.end(), ip_addr) == addresses.end()))
+    {
+      addresses.push_back(ip_addr);
+    }
+  }
+  freeaddrinfo(result);
+
+    // IPv4 addresses first since not all sockets are dual-stack
+  stable_partition(addresses.begin(), addresses.end(),
+                   mem_fn(&IpAddress::isIpv4));
+
+  return true;
+} /* CppDnsResolver::resolve */
+
+
+void CppDnsResolver::pruneCache(uint64_t now)
+{
+  if (m_cache.size() < MAX_CACHE_SIZE)
+  {
+    return;
+  }
+
+  for (Cache::iterator it = m_cache.begin(); it != m_cache.end(); )
+  {
+    if (it->second.expire_ms <= now)
+    {
+      it = m_cache.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+    // Still full of valid entries. Just start over.
+  if (m_cache.size() >= MAX_CACHE_SIZE)
+  {
+    m_cache.clear();
+  }
+} /* CppDnsResolver::pruneCache */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,226 @@
+/**
+@file   AsyncCppDnsResolver.h
+@brief  A shared pool of resolver threads with a result cache
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This file contains the resolver used by the Async::CppDnsLookupWorker class.
+The blocking lookups are executed by a small, fixed set of threads that are
+shared by all event loops in the process. Results are cached for a while and
+identical queries that are in progress at the same time are only executed
+once.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_CPP_DNS_RESOLVER_INCLUDED
+#define ASYNC_CPP_DNS_RESOLVER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncIpAddress.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class CppDnsLookupWorker;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A pool of resolver threads with a positive and negative cache
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This is an internal class used by Async::CppDnsLookupWorker. There is only
+one instance of this class in a process. It is created on first use and is
+never destroyed since a resolver thread may be blocked in getaddrinfo at the
+time the process exits.
+
+The system resolver does not report the TTL of the records, so successful
+lookups are cached for POSITIVE_TTL milliseconds and lookups where the name
+did not exist are cached for NEGATIVE_TTL milliseconds. Temporary errors are
+not cached at all.
+
+Workers waiting for the same label are attached to the same job so that only
+one query is sent. The result is delivered to each worker by calling
+CppDnsLookupWorker::lookupDone from the resolver thread, with the resolver
+lock held.
+*/
+class CppDnsResolver
+{
+  public:
+    static const unsigned THREADS       = 4;
+    static const unsigned POSITIVE_TTL  = 60000;
+    static const unsigned NEGATIVE_TTL  = 10000;
+    static const size_t   MAX_CACHE_SIZE = 256;
+
+    /**
+     * @brief   Get the resolver instance
+     * @return  Returns a reference to the process wide resolver
+     */
+    static CppDnsResolver& instance(void);
+
+    /**
+     * @brief   Disallow copy construction
+     */
+    CppDnsResolver(const CppDnsResolver&) = delete;
+
+    /**
+     * @brief   Disallow copy assignment
+     */
+    CppDnsResolver& operator=(const CppDnsResolver&) = delete;
+
+    /**
+     * @brief   Start a lookup
+     * @param   label   The name to look up
+     * @param   worker  The worker to deliver the result to
+     * @return  Returns \em true on success or \em false on failure
+     *
+     * If the result is found in the cache it is delivered to the worker
+     * before this function returns.
+     */
+    bool lookup(const std::string& label, CppDnsLookupWorker *worker);
+
+    /**
+     * @brief   Stop delivering results to a worker
+     * @param   label   The name that was looked up
+     * @param   worker  The worker that should not be called anymore
+     *
+     * The query itself is not aborted. Its result will still be cached when
+     * it completes.
+     */
+    void cancel(const std::string& label, CppDnsLookupWorker *worker);
+
+  private:
+    typedef std::vector<IpAddress> Addresses;
+
+    struct CacheEntry
+    {
+      Addresses addresses;
+      uint64_t  expire_ms;
+    };
+    typedef std::unordered_map<std::string, CacheEntry> Cache;
+
+    struct Job
+    {
+      std::string                       label;
+      std::vector<CppDnsLookupWorker*>  waiters;
+    };
+    typedef std::unordered_map<std::string, Job*> Jobs;
+
+    pthread_mutex_t   m_mutex;
+    pthread_cond_t    m_cond;
+    Cache             m_cache;
+    Jobs              m_jobs;
+    std::deque<Job*>  m_queue;
+    unsigned          m_threads;
+    unsigned          m_idle_threads;
+
+    static void *threadFunc(void *r);
+    static uint64_t nowMs(void);
+
+    CppDnsResolver(void);
+    ~CppDnsResolver(void);
+    void run(void);
+    bool resolve(const std::string& label, Addresses& addresses);
+    void pruneCache(uint64_t now);
+
+};  /* class CppDnsResolver */
+
+
+} /* namespace Async */
+
+#endif /* ASYNC_CPP_DNS_RESOLVER_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,261 @@
+/**
+@file   AsyncCppEventLoopThread.cpp
+@brief  Run an Async event loop in a separate thread
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstring>
+#include <cassert>
+#include <iostream>
+#include <future>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncCppEventLoopThread.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Static class variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static void run_and_notify(sigc::slot<void> task, std::promise<void> *done);
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+CppEventLoopThread::CppEventLoopThread(CppApplication::BackendType backend)
+  : m_backend(backend), m_app(0), m_running(false)
+{
+  pthread_mutex_init(&m_mutex, NULL);
+  pthread_cond_init(&m_cond, NULL);
+} /* CppEventLoopThread::CppEventLoopThread */
+
+
+CppEventLoopThread::~CppEventLoopThread(void)
+{
+  stop();
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_mutex);
+} /* CppEventLoopThread::~CppEventLoopThread */
+
+
+bool CppEventLoopThread::start(void)
+{
+  if (m_running)
+  {
+    return true;
+  }
+
+  int ret = pthread_create(&m_thread, NULL, threadFunc, this);
+  if (ret != 0)
+  {
+    cerr << "*** ERROR: pthread_create: " << strerror(ret) << endl;
+    return false;
+  }
+  m_running = true;
+
+    // Wait until the loop thread has created its application object
+  pthread_mutex_lock(&m_mutex);
+  while (m_app == 0)
+  {
+    pthread_cond_wait(&m_cond, &m_mutex);
+  }
+  pthread_mutex_unlock(&m_mutex);
+
+  return true;
+} /* CppEventLoopThread::start */
+
+
+void CppEventLoopThread::stop(void)
+{
+  if (!m_running)
+  {
+    return;
+  }
+  assert(!pthread_equal(pthread_self(), m_thread));
+
+  pthread_mutex_lock(&m_mutex);
+  if (m_app != 0)
+  {
+    m_app->post(mem_fun(*m_app, &CppApplication::quit));
+  }
+  pthread_mutex_unlock(&m_mutex);
+
+  int ret = pthread_join(m_thread, NULL);
+  if (ret != 0)
+  {
+    cerr << "*** WARNING: pthread_join: " << strerror(ret) << endl;
+  }
+  m_running = false;
+} /* CppEventLoopThread::stop */
+
+
+bool CppEventLoopThread::post(sigc::slot<void> task)
+{
+  bool posted = false;
+  pthread_mutex_lock(&m_mutex);
+  if (m_app != 0)
+  {
+    m_app->post(task);
+    posted = true;
+  }
+  pthread_mutex_unlock(&m_mutex);
+  return posted;
+} /* CppEventLoopThread::post */
+
+
+bool CppEventLoopThread::postAndWait(sigc::slot<void> task)
+{
+  if (m_running && pthread_equal(pthread_self(), m_thread))
+  {
+    task();
+    return true;
+  }
+
+  std::promise<void> done;
+  std::future<void> done_future = done.get_future();
+  if (!post(sigc::bind(sigc::ptr_fun(&run_and_notify), task, &done)))
+  {
+    return false;
+  }
+  done_future.wait();
+  return true;
+} /* CppEventLoopThread::postAndWait */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void *CppEventLoopThread::threadFunc(void *arg)
+{
+  CppEventLoopThread *self = reinterpret_cast<CppEventLoopThread*>(arg);
+
+    // The application object is created in this thread so that all Async
+    // objects created by tasks run in this thread will belong to it
+  CppApplication app(self->m_backend);
+
+  pthread_mutex_lock(&self->m_mutex);
+  self->m_app = &app;
+  pthread_cond_signal(&self->m_cond);
+  pthread_mutex_unlock(&self->m_mutex);
+
+  app.exec();
+
+  pthread_mutex_lock(&self->m_mutex);
+  self->m_app = 0;
+  pthread_mutex_unlock(&self->m_mutex);
+
+  return NULL;
+} /* CppEventLoopThread::threadFunc */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static void run_and_notify(sigc::slot<void> task, std::promise<void> *done)
+{
+  task();
+  done->set_value();
+} /* run_and_notify */
+
+
+
+/*
+ * This file has not been truncated
+ */
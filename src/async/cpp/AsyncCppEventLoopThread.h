@@ -0,0 +1,235 @@
+/**
+@file   AsyncCppEventLoopThread.h
+@brief  Run an Async event loop in a separate thread
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This file contains a class that run an Async::CppApplication main loop in a
+thread of its own. This makes it possible to spread independent parts of an
+application, each with its own sockets and timers, over multiple CPU cores.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_CPP_EVENT_LOOP_THREAD_INCLUDED
+#define ASYNC_CPP_EVENT_LOOP_THREAD_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <pthread.h>
+#include <sigc++/sigc++.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppApplication.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Run an Async event loop in a separate thread
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class start a new thread running an Async::CppApplication main loop.
+The main application object must have been created before any loop thread is
+started. Work is handed over to the loop thread using the post function.
+Async objects, like FdWatch, Timer, sockets and connections, belong to the
+event loop of the thread where they were created. They must only be used and
+deleted in that thread. The typical way to create objects in the loop thread
+is to post a task that create them.
+
+\code{.cpp}
+Async::CppApplication app;
+std::vector<Async::CppEventLoopThread*> loops;
+for (unsigned i=0; i<4; ++i)
+{
+  Async::CppEventLoopThread *loop = new Async::CppEventLoopThread;
+  loop->start();
+  loop->post(sigc::bind(sigc::ptr_fun(createShard), i));
+  loops.push_back(loop);
+}
+app.exec();
+\endcode
+
+Signals emitted by objects running in a loop thread are emitted in that
+thread. Use post, on the loop thread object or on the main application
+object, to hand results back to another loop.
+*/
+class CppEventLoopThread
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   backend The event backend to use for the loop
+     */
+    explicit CppEventLoopThread(
+        CppApplication::BackendType backend=CppApplication::BACKEND_DEFAULT);
+
+    /**
+     * @brief   Disallow copy construction
+     */
+    CppEventLoopThread(const CppEventLoopThread&) = delete;
+
+    /**
+     * @brief   Disallow copy assignment
+     */
+    CppEventLoopThread& operator=(const CppEventLoopThread&) = delete;
+
+    /**
+     * @brief   Destructor
+     *
+     * The loop thread is stopped if it is running.
+     */
+    ~CppEventLoopThread(void);
+
+    /**
+     * @brief   Start the loop thread
+     * @return  Returns \em true on success or else \em false
+     *
+     * This function return when the loop thread has created its application
+     * object and is ready to accept tasks.
+     */
+    bool start(void);
+
+    /**
+     * @brief   Stop the loop thread
+     *
+     * All tasks posted before this call are run before the loop is stopped.
+     * This function return when the loop thread has exited. It must not be
+     * called from the loop thread itself.
+     */
+    void stop(void);
+
+    /**
+     * @brief   Check if the loop thread is running
+     * @return  Returns \em true if the loop thread is running
+     */
+    bool isRunning(void) const { return m_running; }
+
+    /**
+     * @brief   Run a task in the loop thread
+     * @param   task The task (SigC++ slot) to run
+     * @return  Returns \em true if the task was posted
+     *
+     * This function may be called from any thread. The task is queued and
+     * will be run by the loop thread. Tasks are run in the order they were
+     * posted. If the loop thread is not running, the task is discarded.
+     */
+    bool post(sigc::slot<void> task);
+
+    /**
+     * @brief   Run a task in the loop thread and wait for it to finish
+     * @param   task The task (SigC++ slot) to run
+     * @return  Returns \em true if the task was run
+     *
+     * This function may be called from any thread. It return when the task
+     * have been run by the loop thread. Tasks posted before this one are run
+     * first. If called from the loop thread itself, the task is run directly.
+     * If the loop thread is not running, the task is discarded.
+     */
+    bool postAndWait(sigc::slot<void> task);
+
+  protected:
+
+  private:
+    CppApplication::BackendType m_backend;
+    pthread_t                   m_thread;
+    pthread_mutex_t             m_mutex;
+    pthread_cond_t              m_cond;
+    CppApplication*             m_app;
+    bool                        m_running;
+
+    static void *threadFunc(void *arg);
+
+};  /* class CppEventLoopThread */
+
+
+} /* namespace Async */
+
+#endif /* ASYNC_CPP_EVENT_LOOP_THREAD_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
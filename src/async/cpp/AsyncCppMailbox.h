@@ -0,0 +1,236 @@
+/**
+@file   AsyncCppMailbox.h
+@brief  Pass messages from any thread to an Async event loop thread
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+This file contains a class template that queue messages posted from any
+thread and deliver them, in order, in the thread running a given
+Async::CppApplication main loop.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_CPP_MAILBOX_INCLUDED
+#define ASYNC_CPP_MAILBOX_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <pthread.h>
+#include <sigc++/sigc++.h>
+
+#include <deque>
+#include <memory>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppApplication.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Pass messages from any thread to an Async event loop thread
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+This class template queue messages posted from any thread and call a handler
+for each of them in the thread running the given application main loop.
+Messages are delivered in the order they were posted. Only the first message
+in a batch wake the receiving loop up so a burst of messages cost one post
+to the loop.
+
+The mailbox object must be created and deleted in the receiving thread.
+Messages that have not been delivered when the mailbox is deleted are
+discarded and the handler is never called after that, even if a wakeup is
+already queued in the receiving loop.
+
+\code{.cpp}
+Async::CppMailbox<std::string> mailbox(main_app,
+    sigc::ptr_fun(&handleMsg));
+loop_thread->post(sigc::bind(sigc::ptr_fun(&work), &mailbox));
+\endcode
+*/
+template <typename Msg>
+class CppMailbox
+{
+  public:
+    /**
+     * @brief The type of the function called for each delivered message
+     */
+    typedef sigc::slot<void, const Msg&> Handler;
+
+    /**
+     * @brief   Constructor
+     * @param   app     The application running the receiving main loop
+     * @param   handler The function to call for each delivered message
+     */
+    CppMailbox(CppApplication *app, const Handler& handler)
+      : m_state(new State(app, handler))
+    {
+    }
+
+    /**
+     * @brief   Disallow copy construction
+     */
+    CppMailbox(const CppMailbox&) = delete;
+
+    /**
+     * @brief   Disallow copy assignment
+     */
+    CppMailbox& operator=(const CppMailbox&) = delete;
+
+    /**
+     * @brief   Destructor
+     */
+    ~CppMailbox(void)
+    {
+      m_state->active = false;
+    }
+
+    /**
+     * @brief   Post a message to the receiving thread
+     * @param   msg The message to post
+     *
+     * This function may be called from any thread.
+     */
+    void post(const Msg& msg)
+    {
+      pthread_mutex_lock(&m_state->mutex);
+      bool was_empty = m_state->msgs.empty();
+      m_state->msgs.push_back(msg);
+      pthread_mutex_unlock(&m_state->mutex);
+      if (was_empty)
+      {
+        m_state->app->post(sigc::bind(sigc::ptr_fun(&CppMailbox::deliver),
+                                      m_state));
+      }
+    }
+
+  private:
+      // The state is shared with queued wakeups so that it outlive the
+      // mailbox object until the last wakeup has been run
+    struct State
+    {
+      pthread_mutex_t mutex;
+      std::deque<Msg> msgs;
+      CppApplication  *app;
+      Handler         handler;
+      bool            active;
+
+      State(CppApplication *app, const Handler& handler)
+        : app(app), handler(handler), active(true)
+      {
+        pthread_mutex_init(&mutex, NULL);
+      }
+      ~State(void) { pthread_mutex_destroy(&mutex); }
+    };
+
+    std::shared_ptr<State> m_state;
+
+    static void deliver(std::shared_ptr<State> state)
+    {
+      std::deque<Msg> msgs;
+      pthread_mutex_lock(&state->mutex);
+      msgs.swap(state->msgs);
+      pthread_mutex_unlock(&state->mutex);
+
+        // The handler may delete the mailbox so check before each message
+      while (!msgs.empty() && state->active)
+      {
+        state->handler(msgs.front());
+        msgs.pop_front();
+      }
+    }
+
+};  /* class CppMailbox */
+
+
+} /* namespace Async */
+
+#endif /* ASYNC_CPP_MAILBOX_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,209 @@
+/**
+@file   AsyncEventLoopStats.cpp
+@brief  Statistics collected by the event loop
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <iomanip>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncEventLoopStats.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Static class variables
+ *
+ ****************************************************************************/
+
+const unsigned EventLoopStats::Histogram::BINS;
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+namespace {
+  void printHistogram(ostream& os, const string& name,
+                      const EventLoopStats::Histogram& h)
+  {
+    if (h.count() == 0)
+    {
+      return;
+    }
+    os << "  " << left << setw(32) << name << right
+       << " n=" << setw(8) << h.count()
+       << " avg=" << setw(8) << (h.totalUs() / h.count())
+       << " p99<" << setw(8) << h.percentileUs(99.0)
+       << " max=" << setw(8) << h.maxUs()
+       << " total=" << h.totalUs() << "us" << endl;
+  }
+} /* anonymous namespace */
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+void EventLoopStats::Histogram::add(uint64_t us)
+{
+  unsigned bin = 0;
+  if (us > 0)
+  {
+    bin = 64 - __builtin_clzll(us);
+    if (bin >= BINS)
+    {
+      bin = BINS - 1;
+    }
+  }
+  ++m_bins[bin];
+  ++m_count;
+  m_total_us += us;
+  if (us > m_max_us)
+  {
+    m_max_us = us;
+  }
+} /* EventLoopStats::Histogram::add */
+
+
+void EventLoopStats::Histogram::clear(void)
+{
+  m_count = m_total_us = m_max_us = 0;
+  for (unsigned i=0; i<BINS; ++i)
+  {
+    m_bins[i] = 0;
+  }
+} /* EventLoopStats::Histogram::clear */
+
+
+uint64_t EventLoopStats::Histogram::percentileUs(double pct) const
+{
+  uint64_t limit = static_cast<uint64_t>(m_count * pct / 100.0);
+  uint64_t sum = 0;
+  for (unsigned i=0; i<BINS-1; ++i)
+  {
+    sum += m_bins[i];
+    if (sum >= limit)
+    {
+      uint64_t upper = uint64_t(1) << i;
+      return (upper < m_max_us) ? upper : m_max_us;
+    }
+  }
+  return m_max_us;
+} /* EventLoopStats::Histogram::percentileUs */
+
+
+void EventLoopStats::clear(void)
+{
+  m_callbacks.clear();
+  m_timer_lag.clear();
+  m_interval_us = 0;
+  m_iterations = 0;
+  m_max_pending_tasks = 0;
+} /* EventLoopStats::clear */
+
+
+void EventLoopStats::print(ostream& os) const
+{
+  os << "### Event loop statistics for the last "
+     << (m_interval_us / 1000) << "ms: iterations=" << m_iterations
+     << " max_pending_tasks=" << m_max_pending_tasks << endl;
+  printHistogram(os, "(timer lag)", m_timer_lag);
+  for (CallbackMap::const_iterator it = m_callbacks.begin();
+       it != m_callbacks.end(); ++it)
+  {
+    printHistogram(os, it->first, it->second);
+  }
+} /* EventLoopStats::print */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,287 @@
+/**
+@file   AsyncEventLoopStats.h
+@brief  Statistics collected by the event loop
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This file contains a class that hold statistics collected by the
+Async::CppApplication main loop. The statistics can be used to find out which
+callbacks are holding up the main loop, e.g. when audio is stuttering.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_EVENT_LOOP_STATS_INCLUDED
+#define ASYNC_EVENT_LOOP_STATS_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <string>
+#include <map>
+#include <ostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Statistics collected by the event loop
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+An object of this class hold the statistics collected by the
+Async::CppApplication main loop during one reporting interval. It contain a
+duration histogram for each callback label, a histogram of how late timers
+were dispatched compared to their expiration time and the largest number of
+pending tasks seen. Use CppApplication::setStatsInterval to enable the
+collection of statistics.
+*/
+class EventLoopStats
+{
+  public:
+    /**
+     * @brief   A histogram with logarithmic bins
+     *
+     * Bin 0 count values below one microsecond. Bin n, for n > 0, count
+     * values in the range [2^(n-1), 2^n) microseconds. The last bin also
+     * count all larger values.
+     */
+    class Histogram
+    {
+      public:
+        static const unsigned BINS = 24;
+
+        /**
+         * @brief   Constructor
+         */
+        Histogram(void) { clear(); }
+
+        /**
+         * @brief   Add a value to the histogram
+         * @param   us The value in microseconds
+         */
+        void add(uint64_t us);
+
+        /**
+         * @brief   Remove all values from the histogram
+         */
+        void clear(void);
+
+        /**
+         * @brief   Get the number of values added
+         * @return  Returns the number of values in the histogram
+         */
+        uint64_t count(void) const { return m_count; }
+
+        /**
+         * @brief   Get the sum of all values
+         * @return  Returns the sum of all values, in microseconds
+         */
+        uint64_t totalUs(void) const { return m_total_us; }
+
+        /**
+         * @brief   Get the largest value
+         * @return  Returns the largest value, in microseconds
+         */
+        uint64_t maxUs(void) const { return m_max_us; }
+
+        /**
+         * @brief   Get the number of values in a bin
+         * @param   bin The bin number
+         * @return  Returns the number of values in the given bin
+         */
+        uint64_t bin(unsigned bin) const { return m_bins[bin]; }
+
+        /**
+         * @brief   Get an upper bound for a percentile
+         * @param   pct The percentile to get (0-100)
+         * @return  Returns the upper limit, in microseconds, of the bin that
+         *          contain the given percentile
+         */
+        uint64_t percentileUs(double pct) const;
+
+      private:
+        uint64_t m_count;
+        uint64_t m_total_us;
+        uint64_t m_max_us;
+        uint64_t m_bins[BINS];
+    };
+
+    typedef std::map<std::string, Histogram> CallbackMap;
+
+    /**
+     * @brief   Default constructor
+     */
+    EventLoopStats(void) : m_interval_us(0), m_iterations(0),
+                           m_max_pending_tasks(0) {}
+
+    /**
+     * @brief   Reset all statistics
+     */
+    void clear(void);
+
+    /**
+     * @brief   Get the histogram for the given callback label
+     * @param   label The callback label
+     * @return  Returns the histogram, which is created if it does not exist
+     */
+    Histogram& callback(const std::string& label) { return m_callbacks[label]; }
+
+    /**
+     * @brief   Get the callback histograms
+     * @return  Returns the callback duration histograms keyed on label
+     */
+    const CallbackMap& callbacks(void) const { return m_callbacks; }
+
+    /**
+     * @brief   Get the timer lag histogram
+     * @return  Returns how late timers were dispatched
+     */
+    Histogram& timerLag(void) { return m_timer_lag; }
+    const Histogram& timerLag(void) const { return m_timer_lag; }
+
+    /**
+     * @brief   Register one main loop iteration
+     * @param   pending_tasks The number of tasks waiting to be run
+     */
+    void addIteration(size_t pending_tasks)
+    {
+      ++m_iterations;
+      if (pending_tasks > m_max_pending_tasks)
+      {
+        m_max_pending_tasks = pending_tasks;
+      }
+    }
+
+    /**
+     * @brief   Get the number of main loop iterations
+     * @return  Returns the number of iterations during the interval
+     */
+    uint64_t iterations(void) const { return m_iterations; }
+
+    /**
+     * @brief   Get the largest number of pending tasks
+     * @return  Returns the largest number of tasks seen waiting to be run
+     */
+    size_t maxPendingTasks(void) const { return m_max_pending_tasks; }
+
+    /**
+     * @brief   Set the length of the measurement interval
+     * @param   us The interval length in microseconds
+     */
+    void setIntervalUs(uint64_t us) { m_interval_us = us; }
+
+    /**
+     * @brief   Get the length of the measurement interval
+     * @return  Returns the interval length in microseconds
+     */
+    uint64_t intervalUs(void) const { return m_interval_us; }
+
+    /**
+     * @brief   Print the statistics in human readable form
+     * @param   os The stream to print to
+     */
+    void print(std::ostream& os) const;
+
+  private:
+    CallbackMap m_callbacks;
+    Histogram   m_timer_lag;
+    uint64_t    m_interval_us;
+    uint64_t    m_iterations;
+    size_t      m_max_pending_tasks;
+
+};  /* class EventLoopStats */
+
+
+} /* namespace Async */
+
+#endif /* ASYNC_EVENT_LOOP_STATS_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,232 @@
+/**
+@file   AsyncSimApplication.cpp
+@brief  An application class that run the main loop on a simulated clock
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncDnsLookupWorker.h>
+#include <AsyncIpAddress.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncFdWatch.h"
+#include "AsyncTimer.h"
+#include "AsyncTimerWheel.h"
+#include "AsyncSimApplication.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+  /**
+   * A DNS lookup worker that never complete. A real lookup would be done
+   * in real time which would make the result of a simulation depend on the
+   * network.
+   */
+  class SimDnsLookupWorker : public DnsLookupWorker
+  {
+    public:
+      std::vector<IpAddress> addresses(void)
+      {
+        return std::vector<IpAddress>();
+      }
+  };
+};
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+SimApplication::SimApplication(void)
+  : timer_wheel(new TimerWheel(0)), firing_timer(0), now_ms(0),
+    timer_event_cnt(0), do_quit(false)
+{
+} /* SimApplication::SimApplication */
+
+
+SimApplication::~SimApplication(void)
+{
+  clearTasks();
+  delete timer_wheel;
+  timer_wheel = 0;
+} /* SimApplication::~SimApplication */
+
+
+void SimApplication::exec(void)
+{
+  do_quit = false;
+  uint64_t next_ms;
+  while (!do_quit && timer_wheel->nextEvent(next_ms))
+  {
+    if (next_ms > now_ms)
+    {
+      now_ms = next_ms;
+    }
+    timer_wheel->advance(now_ms);
+
+      // Just like in the CppApplication, timers added from within a timer
+      // callback are not expired until the next loop iteration, even if
+      // they have a zero timeout
+    Timer *timer;
+    uint64_t expire_ms;
+    while (!do_quit && ((timer = timer_wheel->popExpired(expire_ms)) != 0))
+    {
+      firing_timer = timer;
+      ++timer_event_cnt;
+      timer->expired(timer);
+      if ((firing_timer == timer) && (timer->type() == Timer::TYPE_PERIODIC))
+      {
+        timer_wheel->add(timer, expire_ms + timer->timeout());
+      }
+    }
+    firing_timer = 0;
+  }
+} /* SimApplication::exec */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void SimApplication::addFdWatch(FdWatch *fd_watch)
+{
+  fd_watches.insert(fd_watch);
+} /* SimApplication::addFdWatch */
+
+
+void SimApplication::delFdWatch(FdWatch *fd_watch)
+{
+  fd_watches.erase(fd_watch);
+} /* SimApplication::delFdWatch */
+
+
+void SimApplication::addTimer(Timer *timer)
+{
+  timer_wheel->add(timer, now_ms + timer->timeout());
+} /* SimApplication::addTimer */
+
+
+void SimApplication::delTimer(Timer *timer)
+{
+  if (timer == firing_timer)
+  {
+    firing_timer = 0;
+  }
+  timer_wheel->remove(timer);
+} /* SimApplication::delTimer */
+
+
+DnsLookupWorker *SimApplication::newDnsLookupWorker(const string& label)
+{
+  return new SimDnsLookupWorker;
+} /* SimApplication::newDnsLookupWorker */
+
+
+
+/*
+ * This file has not been truncated
+ */
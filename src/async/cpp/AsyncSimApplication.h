@@ -0,0 +1,218 @@
+/**
+@file   AsyncSimApplication.h
+@brief  An application class that run the main loop on a simulated clock
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This file contains an application class where time is simulated. Instead of
+waiting for timers to expire, the clock is advanced directly to the time of
+the next timer event. It is used to replay recorded input through a complete
+application as fast as possible with deterministic timing.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_SIM_APPLICATION_INCLUDED
+#define ASYNC_SIM_APPLICATION_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <set>
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncApplication.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class TimerWheel;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  An application class that run the main loop on a simulated clock
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This application class keep its own millisecond clock which start at zero.
+The main loop never sleep. It advance the clock to the expiration time of the
+next timer and then expire all timers that are due, in the same order as the
+Async::CppApplication would have done. The main loop exit when quit is called
+or when there are no more active timers since nothing can happen after that.
+
+Activity on file descriptors is never reported. It is not possible to mix
+real I/O with simulated time and still get a deterministic result, so
+everything that should happen during a simulation must be driven by timers.
+DNS lookups never complete for the same reason. Code that measure time must
+use Application::monotonicTimeNs to see the simulated time. Code that read a
+system clock directly, e.g. using gettimeofday, will see the real time.
+*/
+class SimApplication : public Application
+{
+  public:
+    /**
+     * @brief   Constructor
+     */
+    SimApplication(void);
+
+    /**
+     * @brief   Destructor
+     */
+    ~SimApplication(void);
+
+    /**
+     * @brief   Execute the application main loop
+     *
+     * Run the main loop until quit is called or until there are no more
+     * active timers.
+     */
+    void exec(void);
+
+    /**
+     * @brief   Exit the application main loop
+     *
+     * The main loop exit when the current timer callback return. Timers that
+     * are due at the same time will not be expired.
+     */
+    void quit(void) { do_quit = true; }
+
+    /**
+     * @brief   Get the current simulated time
+     * @return  Returns the number of milliseconds since the application was
+     *          created
+     */
+    uint64_t now(void) const { return now_ms; }
+
+    /**
+     * @brief   Read the clock that the timers are based on
+     * @return  Returns the simulated time in nanoseconds
+     */
+    uint64_t monotonicTimeNs(void) const { return now_ms * 1000000; }
+
+    /**
+     * @brief   Get the number of expired timers
+     * @return  Returns the number of timer callbacks that have been run
+     */
+    uint64_t timerEventCount(void) const { return timer_event_cnt; }
+
+    /**
+     * @brief   Get the number of file descriptors that are watched
+     * @return  Returns the number of active FdWatch objects
+     *
+     * Since file descriptor activity is never reported, this can be used to
+     * warn the user if the simulated application wait for I/O.
+     */
+    size_t fdWatchCount(void) const { return fd_watches.size(); }
+
+  protected:
+
+  private:
+    TimerWheel          *timer_wheel;
+    Timer               *firing_timer;
+    uint64_t            now_ms;
+    uint64_t            timer_event_cnt;
+    bool                do_quit;
+    std::set<FdWatch*>  fd_watches;
+
+    SimApplication(const SimApplication&);
+    SimApplication& operator=(const SimApplication&);
+    void addFdWatch(FdWatch *fd_watch);
+    void delFdWatch(FdWatch *fd_watch);
+    void addTimer(Timer *timer);
+    void delTimer(Timer *timer);
+    DnsLookupWorker *newDnsLookupWorker(const std::string& label);
+
+};  /* class SimApplication */
+
+
+} /* namespace */
+
+#endif /* ASYNC_SIM_APPLICATION_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
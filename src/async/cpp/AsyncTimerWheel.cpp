@@ -0,0 +1,376 @@
+/**
+@file   AsyncTimerWheel.cpp
+@brief  A hierarchical timer wheel used by the CppApplication main loop
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncTimer.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncTimerWheel.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Static class variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+inline uint64_t rotr64(uint64_t x, unsigned n)
+{
+  n &= 63;
+  return (n == 0) ? x : ((x >> n) | (x << (64 - n)));
+} /* rotr64 */
+
+
+} /* End of anonymous namespace */
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+TimerWheel::TimerWheel(uint64_t now_ms)
+  : m_now(now_ms), m_count(0)
+{
+  for (unsigned level=0; level<LEVELS; ++level)
+  {
+    m_used[level] = 0;
+  }
+  for (unsigned slot=0; slot<=EXPIRED_SLOT; ++slot)
+  {
+    m_slots[slot].head = m_slots[slot].tail = 0;
+  }
+} /* TimerWheel::TimerWheel */
+
+
+TimerWheel::~TimerWheel(void)
+{
+  for (unsigned slot=0; slot<=EXPIRED_SLOT; ++slot)
+  {
+    while (m_slots[slot].head != 0)
+    {
+      unlink(m_slots[slot].head);
+    }
+  }
+} /* TimerWheel::~TimerWheel */
+
+
+void TimerWheel::add(Timer *timer, uint64_t expire_ms)
+{
+  assert(timer->m_wheel_slot < 0);
+  timer->m_wheel_expire = expire_ms;
+  place(timer);
+} /* TimerWheel::add */
+
+
+void TimerWheel::remove(Timer *timer)
+{
+  if (timer->m_wheel_slot >= 0)
+  {
+    unlink(timer);
+  }
+} /* TimerWheel::remove */
+
+
+bool TimerWheel::nextEvent(uint64_t& next_ms) const
+{
+  if (m_count == 0)
+  {
+    return false;
+  }
+
+    // The first level contain the exact expiration times for the coming
+    // LEVEL_SLOTS milliseconds
+  uint64_t best = UINT64_MAX;
+  uint64_t used = rotr64(m_used[0], m_now & LEVEL_MASK);
+  if (used != 0)
+  {
+    best = m_now + __builtin_ctzll(used);
+  }
+
+    // For the higher levels we need to wake up when a slot is to be cascaded.
+    // The current slot in each level have already been cascaded so any
+    // timers in it belong to the next lap.
+  for (unsigned level=1; level<LEVELS; ++level)
+  {
+    unsigned shift = level * LEVEL_BITS;
+    uint64_t pos = m_now >> shift;
+    used = rotr64(m_used[level], (pos + 1) & LEVEL_MASK);
+    if (used != 0)
+    {
+      uint64_t cascade_ms = (pos + 1 + __builtin_ctzll(used)) << shift;
+      if (cascade_ms < best)
+      {
+        best = cascade_ms;
+      }
+    }
+  }
+
+  assert(best != UINT64_MAX);
+  next_ms = best;
+  return true;
+} /* TimerWheel::nextEvent */
+
+
+void TimerWheel::advance(uint64_t now_ms)
+{
+  while (m_now <= now_ms)
+  {
+    if (m_count == 0)
+    {
+      m_now = now_ms + 1;
+      break;
+    }
+
+    unsigned idx = m_now & LEVEL_MASK;
+    if (idx == 0)
+    {
+      for (unsigned level=1; level<LEVELS; ++level)
+      {
+        cascade(level);
+        if (((m_now >> (level * LEVEL_BITS)) & LEVEL_MASK) != 0)
+        {
+          break;
+        }
+      }
+    }
+
+    Slot& slot = m_slots[idx];
+    while (slot.head != 0)
+    {
+      Timer *timer = slot.head;
+      unlink(timer);
+      link(timer, EXPIRED_SLOT);
+    }
+
+      // Skip empty slots up to the next occupied slot or the next boundary
+      // where a cascade may be needed
+    uint64_t next = (m_now | LEVEL_MASK) + 1;
+    if (idx < LEVEL_MASK)
+    {
+      uint64_t rest = m_used[0] >> (idx + 1);
+      if (rest != 0)
+      {
+        next = m_now + 1 + __builtin_ctzll(rest);
+      }
+    }
+    m_now = (next <= now_ms) ? next : now_ms + 1;
+  }
+} /* TimerWheel::advance */
+
+
+Timer *TimerWheel::popExpired(uint64_t& expire_ms)
+{
+  Timer *timer = m_slots[EXPIRED_SLOT].head;
+  if (timer != 0)
+  {
+    unlink(timer);
+    expire_ms = timer->m_wheel_expire;
+  }
+  return timer;
+} /* TimerWheel::popExpired */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void TimerWheel::link(Timer *timer, unsigned slot)
+{
+  assert(slot <= EXPIRED_SLOT);
+  Slot& s = m_slots[slot];
+  timer->m_wheel_slot = slot;
+  timer->m_wheel_next = 0;
+  timer->m_wheel_prev = s.tail;
+  if (s.tail != 0)
+  {
+    s.tail->m_wheel_next = timer;
+  }
+  else
+  {
+    s.head = timer;
+  }
+  s.tail = timer;
+
+  if (slot != EXPIRED_SLOT)
+  {
+    m_used[slot / LEVEL_SLOTS] |= uint64_t(1) << (slot & LEVEL_MASK);
+    ++m_count;
+  }
+} /* TimerWheel::link */
+
+
+void TimerWheel::unlink(Timer *timer)
+{
+  unsigned slot = timer->m_wheel_slot;
+  assert(slot <= EXPIRED_SLOT);
+  Slot& s = m_slots[slot];
+  if (timer->m_wheel_prev != 0)
+  {
+    timer->m_wheel_prev->m_wheel_next = timer->m_wheel_next;
+  }
+  else
+  {
+    s.head = timer->m_wheel_next;
+  }
+  if (timer->m_wheel_next != 0)
+  {
+    timer->m_wheel_next->m_wheel_prev = timer->m_wheel_prev;
+  }
+  else
+  {
+    s.tail = timer->m_wheel_prev;
+  }
+  timer->m_wheel_next = timer->m_wheel_prev = 0;
+  timer->m_wheel_slot = -1;
+
+  if (slot != EXPIRED_SLOT)
+  {
+    if (s.head == 0)
+    {
+      m_used[slot / LEVEL_SLOTS] &= ~(uint64_t(1) << (slot & LEVEL_MASK));
+    }
+    assert(m_count > 0);
+    --m_count;
+  }
+} /* TimerWheel::unlink */
+
+
+void TimerWheel::place(Timer *timer)
+{
+  uint64_t expire = timer->m_wheel_expire;
+  if (expire < m_now)
+  {
+    expire = m_now;
+  }
+  uint64_t delta = expire - m_now;
+
+  for (unsigned level=0; level<LEVELS; ++level)
+  {
+    unsigned shift = level * LEVEL_BITS;
+    if ((delta >> (shift + LEVEL_BITS)) == 0)
+    {
+      link(timer, level * LEVEL_SLOTS + ((expire >> shift) & LEVEL_MASK));
+      return;
+    }
+  }
+
+    // Too far into the future for the wheel. Put it in the last slot of the
+    // top level. It will be placed again when that slot is cascaded.
+  unsigned shift = (LEVELS - 1) * LEVEL_BITS;
+  link(timer, (LEVELS - 1) * LEVEL_SLOTS +
+              (((m_now >> shift) + LEVEL_MASK) & LEVEL_MASK));
+} /* TimerWheel::place */
+
+
+void TimerWheel::cascade(unsigned level)
+{
+  unsigned idx = (m_now >> (level * LEVEL_BITS)) & LEVEL_MASK;
+  Slot& slot = m_slots[level * LEVEL_SLOTS + idx];
+  Timer *timer = slot.head;
+  slot.head = slot.tail = 0;
+  m_used[level] &= ~(uint64_t(1) << idx);
+  while (timer != 0)
+  {
+    Timer *next = timer->m_wheel_next;
+    timer->m_wheel_next = timer->m_wheel_prev = 0;
+    timer->m_wheel_slot = -1;
+    --m_count;
+    place(timer);
+    timer = next;
+  }
+} /* TimerWheel::cascade */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,235 @@
+/**
+@file   AsyncTimerWheel.h
+@brief  A hierarchical timer wheel used by the CppApplication main loop
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This file contains a hierarchical timer wheel used to keep track of all
+active Async::Timer objects in the Async::CppApplication main loop. Arming and
+cancelling a timer are O(1) operations and no memory is allocated since the
+list links are stored in the Timer objects themselves.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_TIMER_WHEEL_INCLUDED
+#define ASYNC_TIMER_WHEEL_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <cstddef>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class Timer;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A hierarchical timer wheel with millisecond resolution
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+The wheel consist of a number of levels, each with 64 slots. The first level
+have a resolution of one millisecond and each following level have a
+resolution that is 64 times coarser than the level below. A timer is placed in
+the level where it fits given the time left until it expires. When the wheel
+advance past a slot boundary, the timers in the corresponding higher level
+slot are redistributed to the lower levels ("cascaded"). Timers that expire in
+the same millisecond are expired in the order they were added.
+
+All times are given as absolute milliseconds on the monotonic clock.
+*/
+class TimerWheel
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   now_ms The current time in milliseconds
+     */
+    explicit TimerWheel(uint64_t now_ms);
+
+    /**
+     * @brief   Disallow copy construction
+     */
+    TimerWheel(const TimerWheel&) = delete;
+
+    /**
+     * @brief   Disallow copy assignment
+     */
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief   Destructor
+     */
+    ~TimerWheel(void);
+
+    /**
+     * @brief   Add a timer to the wheel
+     * @param   timer     The timer to add
+     * @param   expire_ms The absolute time when the timer should expire
+     *
+     * If the expiration time already have passed, the timer will expire the
+     * next time the wheel is advanced.
+     */
+    void add(Timer *timer, uint64_t expire_ms);
+
+    /**
+     * @brief   Remove a timer from the wheel
+     * @param   timer The timer to remove
+     *
+     * It is safe to call this function for a timer that is not in the wheel.
+     */
+    void remove(Timer *timer);
+
+    /**
+     * @brief   Find out when the wheel need to be advanced next time
+     * @param   next_ms Set to the absolute time of the next wheel event
+     * @return  Returns \em true if there are timers in the wheel
+     *
+     * The returned time is never later than the expiration time of the first
+     * timer to expire. It may be earlier if the wheel need to cascade timers
+     * from a higher level before that.
+     */
+    bool nextEvent(uint64_t& next_ms) const;
+
+    /**
+     * @brief   Advance the wheel and collect all expired timers
+     * @param   now_ms The current time in milliseconds
+     *
+     * All timers that have expired up to, and including, the given time will
+     * be moved to the expired list. Use popExpired to fetch them.
+     */
+    void advance(uint64_t now_ms);
+
+    /**
+     * @brief   Fetch the next timer from the expired list
+     * @param   expire_ms Set to the time when the timer was set to expire
+     * @return  Returns the timer or 0 if there are no more expired timers
+     *
+     * The returned timer is not part of the wheel anymore.
+     */
+    Timer *popExpired(uint64_t& expire_ms);
+
+    /**
+     * @brief   Check if the wheel is empty
+     * @return  Returns \em true if there are no timers in the wheel
+     */
+    bool isEmpty(void) const { return m_count == 0; }
+
+  private:
+    static const unsigned LEVEL_BITS  = 6;
+    static const unsigned LEVEL_SLOTS = 1 << LEVEL_BITS;
+    static const unsigned LEVEL_MASK  = LEVEL_SLOTS - 1;
+    static const unsigned LEVELS      = 6;
+    static const unsigned EXPIRED_SLOT = LEVELS * LEVEL_SLOTS;
+
+    struct Slot
+    {
+      Timer *head;
+      Timer *tail;
+    };
+
+    uint64_t  m_now;
+    size_t    m_count;
+    uint64_t  m_used[LEVELS];
+    Slot      m_slots[EXPIRED_SLOT + 1];
+
+    void link(Timer *timer, unsigned slot);
+    void unlink(Timer *timer);
+    void place(Timer *timer);
+    void cascade(unsigned level);
+
+};  /* class TimerWheel */
+
+
+} /* namespace Async */
+
+#endif /* ASYNC_TIMER_WHEEL_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
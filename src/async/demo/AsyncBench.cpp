@@ -0,0 +1,1007 @@
+/**
+@file	 AsyncBench.cpp
+@brief   Microbenchmarks for the hot classes of the Async library
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This program measures the CPU cost of the classes in the Async library that
+run for every audio block or every event, like filters, resamplers, the
+splitter, mixer and selector, the FIFOs, the audio codecs, message packing
+and the timer and file descriptor dispatch in the main loop. Each benchmark
+processes a fixed workload, generated from a fixed random seed, a number of
+times and the median CPU time is reported together with the time per item and
+the throughput. The machine, compiler and sample rate are printed in the
+header so that results from different commits and CPU architectures can be
+compared. The results can also be written to a CSV file.
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <random>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppApplication.h>
+#include <AsyncTimer.h>
+#include <AsyncFdWatch.h>
+#include <AsyncMsg.h>
+#include <AsyncAudioSink.h>
+#include <AsyncAudioPassthrough.h>
+#include <AsyncAudioFilter.h>
+#include <AsyncAudioDecimator.h>
+#include <AsyncAudioInterpolator.h>
+#include <AsyncAudioSplitter.h>
+#include <AsyncAudioMixer.h>
+#include <AsyncAudioSelector.h>
+#include <AsyncAudioFifo.h>
+#include <AsyncAudioJitterFifo.h>
+#include <AsyncAudioEncoder.h>
+#include <AsyncAudioDecoder.h>
+#include <BenchUtil.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace SvxLink;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The length of the audio workload, in seconds of audio at the internal
+  // sample rate
+#define AUDIO_TIME        20
+
+  // The number of samples written in each call, about the same as the
+  // block size used by the audio device
+#define BLOCK_SIZE        256
+
+  // The number of fan-in or fan-out branches for the splitter, mixer and
+  // selector benchmarks
+#define BRANCH_CNT        4
+
+  // The number of messages packed and unpacked
+#define MSG_CNT           100000
+
+  // The number of file descriptor wakeups
+#define DISPATCH_CNT      100000
+
+  // The number of timer expirations. Timers have a resolution of one
+  // millisecond so this is also about the run time in milliseconds.
+#define TIMER_CNT         2000
+
+  // The number of idle timers armed while measuring timer dispatch
+#define IDLE_TIMER_CNT    1000
+
+  // The seed used for all generated workloads
+#define RNG_SEED          4711
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+/**
+ * The base class for all benchmarks. The setup function is called from the
+ * main loop before each run and the run function in the next main loop
+ * iteration, so that timers started in setup have been dispatched when the
+ * run start. A synchronous benchmark return the number of items processed
+ * from run. An asynchronous benchmark return 0 and emit the done signal with
+ * the number of items from the main loop when finished.
+ */
+class Benchmark : public sigc::trackable
+{
+  public:
+    Benchmark(const string &name, const string &unit)
+      : m_name(name), m_unit(unit) {}
+    virtual ~Benchmark(void) {}
+    const string &name(void) const { return m_name; }
+    const string &unit(void) const { return m_unit; }
+    virtual void setup(void) {}
+    virtual uint64_t run(void) = 0;
+    sigc::signal<void, uint64_t> done;
+
+  private:
+    string m_name;
+    string m_unit;
+}; /* class Benchmark */
+
+
+/**
+ * A sink that accept and count all samples
+ */
+class NullSink : public AudioSink
+{
+  public:
+    NullSink(void) : sample_cnt(0) {}
+    virtual int writeSamples(const float *samples, int count)
+    {
+      sample_cnt += count;
+      return count;
+    }
+    virtual void flushSamples(void) { sourceAllSamplesFlushed(); }
+    uint64_t sample_cnt;
+}; /* class NullSink */
+
+
+/**
+ * Write a whole buffer to a sink in blocks, retrying partial writes
+ */
+static void writeAll(AudioSink &sink, const vector<float> &samples,
+                     unsigned block_size=BLOCK_SIZE)
+{
+  size_t pos = 0;
+  while (pos < samples.size())
+  {
+    int count = min(static_cast<size_t>(block_size), samples.size() - pos);
+    int written = sink.writeSamples(&samples[pos], count);
+    if (written <= 0)
+    {
+      cerr << "*** ERROR: Benchmark sink stopped accepting samples\n";
+      exit(1);
+    }
+    pos += written;
+  }
+} /* writeAll */
+
+
+class ProcessorBench : public Benchmark
+{
+  public:
+    ProcessorBench(const string &name, AudioProcessor *proc,
+                   const vector<float> &input)
+      : Benchmark(name, "sample"), proc(proc), input(input)
+    {
+      proc->registerSink(&sink);
+    }
+    ~ProcessorBench(void) { delete proc; }
+    virtual uint64_t run(void)
+    {
+      writeAll(*proc, input);
+      return input.size();
+    }
+
+  private:
+    AudioProcessor *      proc;
+    const vector<float> & input;
+    NullSink              sink;
+}; /* class ProcessorBench */
+
+
+class SplitterBench : public Benchmark
+{
+  public:
+    SplitterBench(const vector<float> &input)
+      : Benchmark("splitter/1to4", "sample"), input(input)
+    {
+      for (int i=0; i<BRANCH_CNT; ++i)
+      {
+        splitter.addSink(&sinks[i]);
+      }
+    }
+    virtual uint64_t run(void)
+    {
+      writeAll(splitter, input);
+      return input.size();
+    }
+
+  private:
+    const vector<float> & input;
+    NullSink              sinks[BRANCH_CNT];
+    AudioSplitter         splitter;
+}; /* class SplitterBench */
+
+
+class MixerBench : public Benchmark
+{
+  public:
+    MixerBench(const vector<float> &input)
+      : Benchmark("mixer/4to1", "sample"), input(input)
+    {
+      for (int i=0; i<BRANCH_CNT; ++i)
+      {
+        mixer.addSource(&srcs[i]);
+      }
+      mixer.registerSink(&sink);
+    }
+      // The mixer start a new stream from a timer so all sources are made
+      // active, one loop iteration before the run
+    virtual void setup(void)
+    {
+      for (int i=0; i<BRANCH_CNT; ++i)
+      {
+        srcs[i].writeSamples(&input[0], BLOCK_SIZE);
+      }
+    }
+    virtual uint64_t run(void)
+    {
+      for (size_t pos=0; pos+BLOCK_SIZE<=input.size(); pos+=BLOCK_SIZE)
+      {
+        for (int i=0; i<BRANCH_CNT; ++i)
+        {
+          if (srcs[i].writeSamples(&input[pos], BLOCK_SIZE) != BLOCK_SIZE)
+          {
+            cerr << "*** ERROR: The mixer stopped accepting samples\n";
+            exit(1);
+          }
+        }
+      }
+      return input.size() / BLOCK_SIZE * BLOCK_SIZE * BRANCH_CNT;
+    }
+
+  private:
+    const vector<float> & input;
+    AudioPassthrough      srcs[BRANCH_CNT];
+    NullSink              sink;
+    AudioMixer            mixer;
+}; /* class MixerBench */
+
+
+class SelectorBench : public Benchmark
+{
+  public:
+    SelectorBench(const vector<float> &input)
+      : Benchmark("selector/4to1", "sample"), input(input)
+    {
+      for (int i=0; i<BRANCH_CNT; ++i)
+      {
+        selector.addSource(&srcs[i]);
+        selector.enableAutoSelect(&srcs[i], i);
+      }
+      selector.registerSink(&sink);
+    }
+      // All sources write, only the one with the highest priority is passed
+      // through
+    virtual uint64_t run(void)
+    {
+      for (size_t pos=0; pos+BLOCK_SIZE<=input.size(); pos+=BLOCK_SIZE)
+      {
+        for (int i=0; i<BRANCH_CNT; ++i)
+        {
+          srcs[i].writeSamples(&input[pos], BLOCK_SIZE);
+        }
+      }
+      return input.size() / BLOCK_SIZE * BLOCK_SIZE * BRANCH_CNT;
+    }
+
+  private:
+    const vector<float> & input;
+    AudioPassthrough      srcs[BRANCH_CNT];
+    NullSink              sink;
+    AudioSelector         selector;
+}; /* class SelectorBench */
+
+
+class FifoBench : public Benchmark
+{
+  public:
+    FifoBench(const string &name, AudioSink *fifo, AudioSource *fifo_src,
+              const vector<float> &input)
+      : Benchmark(name, "sample"), fifo(fifo), input(input)
+    {
+      fifo_src->registerSink(&sink);
+    }
+    ~FifoBench(void) { delete fifo; }
+    virtual uint64_t run(void)
+    {
+      writeAll(*fifo, input);
+      return input.size();
+    }
+
+  private:
+    AudioSink *           fifo;
+    const vector<float> & input;
+    NullSink              sink;
+}; /* class FifoBench */
+
+
+class EncoderBench : public Benchmark
+{
+  public:
+    EncoderBench(const string &codec, const vector<float> &input)
+      : Benchmark("encode/" + codec, "sample"), input(input),
+        enc(AudioEncoder::create(codec)), byte_cnt(0)
+    {
+      enc->writeEncodedSamples.connect(
+          sigc::mem_fun(*this, &EncoderBench::onEncoded));
+    }
+    ~EncoderBench(void) { delete enc; }
+    virtual uint64_t run(void)
+    {
+      writeAll(*enc, input);
+      return input.size();
+    }
+
+  private:
+    const vector<float> & input;
+    AudioEncoder *        enc;
+    uint64_t              byte_cnt;
+
+    void onEncoded(const void *buf, int size) { byte_cnt += size; }
+}; /* class EncoderBench */
+
+
+class DecoderBench : public Benchmark
+{
+  public:
+    DecoderBench(const string &codec, const vector<float> &input)
+      : Benchmark("decode/" + codec, "sample"),
+        dec(AudioDecoder::create(codec))
+    {
+      AudioEncoder *enc = AudioEncoder::create(codec);
+      enc->writeEncodedSamples.connect(
+          sigc::mem_fun(*this, &DecoderBench::onEncoded));
+      writeAll(*enc, input);
+      enc->flushSamples();
+      delete enc;
+      dec->registerSink(&sink);
+    }
+    ~DecoderBench(void) { delete dec; }
+    virtual uint64_t run(void)
+    {
+      const uint64_t start_cnt = sink.sample_cnt;
+      for (size_t i=0; i<packets.size(); ++i)
+      {
+        dec->writeEncodedSamples(&packets[i][0], packets[i].size());
+      }
+      return sink.sample_cnt - start_cnt;
+    }
+
+  private:
+    AudioDecoder *        dec;
+    vector<vector<char> > packets;
+    NullSink              sink;
+
+    void onEncoded(const void *buf, int size)
+    {
+      const char *ptr = static_cast<const char *>(buf);
+      packets.push_back(vector<char>(ptr, ptr + size));
+    }
+}; /* class DecoderBench */
+
+
+class BenchMsg : public Msg
+{
+  public:
+    uint32_t              seq;
+    string                callsign;
+    vector<uint8_t>       data;
+    map<string, float>    levels;
+    ASYNC_MSG_MEMBERS(seq, callsign, data, levels)
+}; /* class BenchMsg */
+
+
+class MsgBench : public Benchmark
+{
+  public:
+    enum Mode { PACK_STREAM, UNPACK_STREAM, PACK_BUFFER, UNPACK_BUFFER };
+
+    MsgBench(const string &name, Mode mode, mt19937 &rng)
+      : Benchmark(name, "msg"), mode(mode)
+    {
+      uniform_int_distribution<int> byte(0, 255);
+      msg.seq = 0;
+      msg.callsign = "SM0SVX";
+      msg.data.resize(160);
+      for (size_t i=0; i<msg.data.size(); ++i)
+      {
+        msg.data[i] = byte(rng);
+      }
+      msg.levels["Rx1"] = -12.5f;
+      msg.levels["Rx2"] = -30.0f;
+      buf.resize(msg.packedSize());
+      MsgPackBuffer pb(&buf[0], buf.size());
+      msg.pack(pb);
+      ostringstream os;
+      msg.pack(os);
+      packed_str = os.str();
+    }
+    virtual uint64_t run(void)
+    {
+      for (unsigned i=0; i<MSG_CNT; ++i)
+      {
+        switch (mode)
+        {
+          case PACK_STREAM:
+          {
+            ostringstream os;
+            msg.seq = i;
+            msg.pack(os);
+            break;
+          }
+          case UNPACK_STREAM:
+          {
+            istringstream is(packed_str);
+            msg.unpack(is);
+            break;
+          }
+          case PACK_BUFFER:
+          {
+            MsgPackBuffer pb(&buf[0], buf.size());
+            msg.seq = i;
+            msg.pack(pb);
+            break;
+          }
+          case UNPACK_BUFFER:
+          {
+            MsgUnpackBuffer ub(&buf[0], buf.size());
+            msg.unpack(ub);
+            break;
+          }
+        }
+      }
+      return MSG_CNT;
+    }
+
+  private:
+    Mode          mode;
+    BenchMsg      msg;
+    vector<char>  buf;
+    string        packed_str;
+}; /* class MsgBench */
+
+
+class TimerBench : public Benchmark
+{
+  public:
+    TimerBench(const string &name, unsigned idle_cnt)
+      : Benchmark(name, "event"), idle_cnt(idle_cnt),
+        timer(0, Timer::TYPE_ONESHOT, false), cnt(0)
+    {
+      timer.expired.connect(sigc::mem_fun(*this, &TimerBench::onExpired));
+    }
+    ~TimerBench(void) { clearIdle(); }
+    virtual void setup(void)
+    {
+      clearIdle();
+      for (unsigned i=0; i<idle_cnt; ++i)
+      {
+        idle.push_back(new Timer(3600000 + i));
+      }
+    }
+    virtual uint64_t run(void)
+    {
+      cnt = 0;
+      timer.setEnable(true);
+      return 0;
+    }
+
+  private:
+    unsigned        idle_cnt;
+    Timer           timer;
+    unsigned        cnt;
+    vector<Timer*>  idle;
+
+    void onExpired(Timer *t)
+    {
+      timer.setEnable(false);
+      if (++cnt < TIMER_CNT)
+      {
+        timer.setEnable(true);
+      }
+      else
+      {
+        clearIdle();
+        done(cnt);
+      }
+    }
+
+    void clearIdle(void)
+    {
+      for (size_t i=0; i<idle.size(); ++i)
+      {
+        delete idle[i];
+      }
+      idle.clear();
+    }
+}; /* class TimerBench */
+
+
+class FdWatchBench : public Benchmark
+{
+  public:
+    FdWatchBench(void)
+      : Benchmark("fdwatch/pipe", "event"), watch(0), cnt(0)
+    {
+      if (pipe(fds) != 0)
+      {
+        perror("pipe");
+        exit(1);
+      }
+      watch = new FdWatch(fds[0], FdWatch::FD_WATCH_RD);
+      watch->setEnabled(false);
+      watch->activity.connect(
+          sigc::mem_fun(*this, &FdWatchBench::onActivity));
+    }
+    ~FdWatchBench(void)
+    {
+      delete watch;
+      close(fds[0]);
+      close(fds[1]);
+    }
+    virtual uint64_t run(void)
+    {
+      cnt = 0;
+      watch->setEnabled(true);
+      kick();
+      return 0;
+    }
+
+  private:
+    int       fds[2];
+    FdWatch * watch;
+    unsigned  cnt;
+
+    void kick(void)
+    {
+      char ch = 0;
+      if (write(fds[1], &ch, 1) != 1)
+      {
+        perror("write");
+        exit(1);
+      }
+    }
+
+    void onActivity(FdWatch *w)
+    {
+      char ch;
+      if (read(fds[0], &ch, 1) != 1)
+      {
+        perror("read");
+        exit(1);
+      }
+      if (++cnt < DISPATCH_CNT)
+      {
+        kick();
+      }
+      else
+      {
+        watch->setEnabled(false);
+        done(cnt);
+      }
+    }
+}; /* class FdWatchBench */
+
+
+/**
+ * Run the benchmarks one by one from the main loop
+ */
+class Runner : public sigc::trackable
+{
+  public:
+    Runner(const vector<Benchmark*> &benches, unsigned runs, ostream *csv,
+           const string &machine)
+      : benches(benches), runs(runs), csv(csv), machine(machine), idx(0),
+        run_cnt(0), in_setup(true), start(0),
+        step_timer(0, Timer::TYPE_ONESHOT, false)
+    {
+      step_timer.expired.connect(sigc::mem_fun(*this, &Runner::step));
+      for (size_t i=0; i<benches.size(); ++i)
+      {
+        benches[i]->done.connect(sigc::mem_fun(*this, &Runner::runDone));
+      }
+    }
+    void start_runs(void) { step_timer.setEnable(true); }
+
+  private:
+    const vector<Benchmark*> &  benches;
+    unsigned                    runs;
+    ostream *                   csv;
+    string                      machine;
+    size_t                      idx;
+    unsigned                    run_cnt;
+    bool                        in_setup;
+    uint64_t                    start;
+    Timer                       step_timer;
+    vector<double>              times;
+    uint64_t                    items;
+
+    void step(Timer *t);
+    void runDone(uint64_t item_cnt);
+    void report(void);
+}; /* class Runner */
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static void makeWorkload(vector<float> &samples, size_t len, mt19937 &rng);
+static void makeLowpass(vector<float> &coeff, int factor, int taps);
+static void printUsage(void);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+  // Typical filter specifications used in SvxLink
+static const char *filter_specs[] =
+{
+  "LpCh10/-0.5/4500", "BpCh12/-0.1/300-5000", "BpBu8/5400-6500", "HpBu20/300"
+};
+
+static const char *codecs[] = { "RAW", "S16", "GSM", "SPEEX", "OPUS" };
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  unsigned runs = 5;
+  string filter;
+  string csv_filename;
+  bool list_only = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "r:f:c:lh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'r':
+        runs = atoi(optarg);
+        if (runs < 1)
+        {
+          cerr << "*** ERROR: The number of runs must be at least 1\n";
+          exit(1);
+        }
+        break;
+      case 'f':
+        filter = optarg;
+        break;
+      case 'c':
+        csv_filename = optarg;
+        break;
+      case 'l':
+        list_only = true;
+        break;
+      default:
+        printUsage();
+        exit(1);
+    }
+  }
+  if (optind < argc)
+  {
+    printUsage();
+    exit(1);
+  }
+
+  CppApplication app;
+
+  mt19937 rng(RNG_SEED);
+  vector<float> audio;
+  makeWorkload(audio, AUDIO_TIME * INTERNAL_SAMPLE_RATE, rng);
+  vector<float> audio_48k;
+  makeWorkload(audio_48k, AUDIO_TIME * 48000, rng);
+  vector<float> audio_8k;
+  makeWorkload(audio_8k, AUDIO_TIME * 8000, rng);
+
+    // The same kind of resampling filters as used between the audio device,
+    // the internal sample rate and 8kHz codecs
+  vector<float> coeff_3(54);
+  makeLowpass(coeff_3, 3, coeff_3.size());
+  vector<float> coeff_2(90);
+  makeLowpass(coeff_2, 2, coeff_2.size());
+
+  vector<Benchmark*> all;
+  for (size_t i=0; i<sizeof(filter_specs)/sizeof(*filter_specs); ++i)
+  {
+    all.push_back(new ProcessorBench(string("filter/") + filter_specs[i],
+          new AudioFilter(filter_specs[i], INTERNAL_SAMPLE_RATE), audio));
+  }
+  all.push_back(new ProcessorBench("decimator/3x54",
+        new AudioDecimator(3, &coeff_3[0], coeff_3.size()), audio_48k));
+  all.push_back(new ProcessorBench("decimator/2x90",
+        new AudioDecimator(2, &coeff_2[0], coeff_2.size()), audio));
+  all.push_back(new ProcessorBench("interpolator/3x54",
+        new AudioInterpolator(3, &coeff_3[0], coeff_3.size()), audio));
+  all.push_back(new ProcessorBench("interpolator/2x90",
+        new AudioInterpolator(2, &coeff_2[0], coeff_2.size()), audio_8k));
+  all.push_back(new SplitterBench(audio));
+  all.push_back(new MixerBench(audio));
+  all.push_back(new SelectorBench(audio));
+
+  AudioFifo *fifo = new AudioFifo(INTERNAL_SAMPLE_RATE);
+  all.push_back(new FifoBench("fifo", fifo, fifo, audio));
+  fifo = new AudioFifo(INTERNAL_SAMPLE_RATE);
+  fifo->setOverwrite(true);
+  fifo->setPrebufSamples(4 * BLOCK_SIZE);
+  all.push_back(new FifoBench("fifo/prebuf", fifo, fifo, audio));
+  AudioJitterFifo *jfifo = new AudioJitterFifo(INTERNAL_SAMPLE_RATE / 5);
+  all.push_back(new FifoBench("jitterfifo", jfifo, jfifo, audio));
+
+  for (size_t i=0; i<sizeof(codecs)/sizeof(*codecs); ++i)
+  {
+    if (AudioEncoder::isAvailable(codecs[i]))
+    {
+      all.push_back(new EncoderBench(codecs[i], audio));
+    }
+    if (AudioEncoder::isAvailable(codecs[i]) &&
+        AudioDecoder::isAvailable(codecs[i]))
+    {
+      all.push_back(new DecoderBench(codecs[i], audio));
+    }
+  }
+
+  all.push_back(new MsgBench("msg/pack-stream", MsgBench::PACK_STREAM, rng));
+  all.push_back(
+      new MsgBench("msg/unpack-stream", MsgBench::UNPACK_STREAM, rng));
+  all.push_back(new MsgBench("msg/pack-buffer", MsgBench::PACK_BUFFER, rng));
+  all.push_back(
+      new MsgBench("msg/unpack-buffer", MsgBench::UNPACK_BUFFER, rng));
+
+  all.push_back(new TimerBench("timer/0ms", 0));
+  all.push_back(new TimerBench("timer/0ms-1000idle", IDLE_TIMER_CNT));
+  all.push_back(new FdWatchBench);
+
+  vector<Benchmark*> benches;
+  for (size_t i=0; i<all.size(); ++i)
+  {
+    if (all[i]->name().find(filter) != string::npos)
+    {
+      benches.push_back(all[i]);
+    }
+  }
+
+  if (list_only)
+  {
+    for (size_t i=0; i<benches.size(); ++i)
+    {
+      cout << benches[i]->name() << endl;
+    }
+    exit(0);
+  }
+
+  struct utsname uts;
+  ostringstream machine;
+  if (uname(&uts) == 0)
+  {
+    machine << uts.sysname << " " << uts.release << " " << uts.machine;
+  }
+  cout << "machine:     " << machine.str() << endl;
+#ifdef __VERSION__
+  cout << "compiler:    " << __VERSION__ << endl;
+#endif
+  cout << "sample rate: " << INTERNAL_SAMPLE_RATE << endl;
+  cout << "runs:        " << runs << " (median CPU time reported)" << endl;
+  cout << endl;
+  cout << setw(32) << left << "benchmark" << right
+       << setw(12) << "items"
+       << setw(12) << "median ms"
+       << setw(12) << "min ms"
+       << setw(12) << "ns/item"
+       << setw(14) << "Mitems/s" << endl;
+
+  ofstream csv;
+  if (!csv_filename.empty())
+  {
+    csv.open(csv_filename.c_str());
+    if (!csv)
+    {
+      cerr << "*** ERROR: Could not open CSV file \"" << csv_filename
+           << "\"\n";
+      exit(1);
+    }
+    csv << "machine,benchmark,unit,items,median_s,min_s,ns_per_item\n";
+  }
+
+  Runner runner(benches, runs, csv_filename.empty() ? 0 : &csv,
+                machine.str());
+  runner.start_runs();
+  app.exec();
+
+  for (size_t i=0; i<all.size(); ++i)
+  {
+    delete all[i];
+  }
+
+  return 0;
+
+} /* main */
+
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+void Runner::step(Timer *t)
+{
+  if (idx >= benches.size())
+  {
+    Application::app().quit();
+    return;
+  }
+
+  Benchmark *bench = benches[idx];
+  if (in_setup)
+  {
+    bench->setup();
+    in_setup = false;
+    step_timer.setEnable(false);
+    step_timer.setEnable(true);
+    return;
+  }
+
+  start = benchCpuTimeUs();
+  uint64_t item_cnt = bench->run();
+  if (item_cnt > 0)
+  {
+    runDone(item_cnt);
+  }
+} /* Runner::step */
+
+
+void Runner::runDone(uint64_t item_cnt)
+{
+  times.push_back((benchCpuTimeUs() - start) / 1.0e6);
+  items = item_cnt;
+  if (++run_cnt >= runs)
+  {
+    report();
+    times.clear();
+    run_cnt = 0;
+    ++idx;
+  }
+  in_setup = true;
+  step_timer.setEnable(false);
+  step_timer.setEnable(true);
+} /* Runner::runDone */
+
+
+void Runner::report(void)
+{
+  const Benchmark *bench = benches[idx];
+  vector<double> sorted(times);
+  sort(sorted.begin(), sorted.end());
+  const double median = sorted[sorted.size() / 2];
+  const double min_time = sorted.front();
+  const double ns_per_item = 1.0e9 * median / items;
+
+  cout << setw(32) << left << bench->name() << right
+       << setw(12) << items
+       << fixed << setprecision(2)
+       << setw(12) << 1000.0 * median
+       << setw(12) << 1000.0 * min_time
+       << setw(12) << ns_per_item
+       << setprecision(3)
+       << setw(14) << items / median / 1.0e6 << endl;
+  cout.unsetf(ios::floatfield);
+
+  if (csv != 0)
+  {
+    *csv << "\"" << machine << "\"," << bench->name() << ","
+         << bench->unit() << "," << items << ","
+         << setprecision(9) << median << "," << min_time << ","
+         << setprecision(6) << ns_per_item << "\n";
+  }
+} /* Runner::report */
+
+
+  // Generate band limited noise with a mix of tones, about like the level
+  // of speech in the audio chain
+static void makeWorkload(vector<float> &samples, size_t len, mt19937 &rng)
+{
+  normal_distribution<float> noise(0.0f, 0.05f);
+  samples.resize(len);
+  float lp = 0.0f;
+  for (size_t i=0; i<len; ++i)
+  {
+    lp = 0.7f * lp + 0.3f * noise(rng);
+    samples[i] = lp + 0.2f * sin(2.0 * M_PI * 0.0625 * i) +
+                      0.1f * sin(2.0 * M_PI * 0.1 * i);
+  }
+} /* makeWorkload */
+
+
+  // A Hamming windowed sinc lowpass filter for a multirate converter with
+  // the given factor. The gain is the factor so that the same coefficients
+  // can be used for interpolation.
+static void makeLowpass(vector<float> &coeff, int factor, int taps)
+{
+  const double fc = 0.5 / factor;
+  for (int i=0; i<taps; ++i)
+  {
+    const double x = i - (taps - 1) / 2.0;
+    const double sinc = (x == 0.0) ? 2.0 * fc
+                                   : sin(2.0 * M_PI * fc * x) / (M_PI * x);
+    const double win = 0.54 - 0.46 * cos(2.0 * M_PI * i / (taps - 1));
+    coeff[i] = factor * sinc * win;
+  }
+} /* makeLowpass */
+
+
+static void printUsage(void)
+{
+  cerr << "Usage: AsyncBench [-r runs] [-f name filter] [-c CSV file] [-l]\n"
+          "  -r  The number of runs of each benchmark (default 5)\n"
+          "  -f  Only run benchmarks with names containing the string\n"
+          "  -c  Also write the results to the given CSV file\n"
+          "  -l  List the benchmarks and exit\n";
+} /* printUsage */
+
+
+
+/*
+ * This file has not been truncated
+ */
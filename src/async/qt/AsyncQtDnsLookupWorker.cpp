@@ -149,6 +149,7 @@ QtDnsLookupWorker::~QtDnsLookupWorker(void)
 vector<IpAddress> QtDnsLookupWorker::addresses(void)
 {
   vector<IpAddress> addr_list;
+  vector<IpAddress> ip6_addr_list;
   
   QList<QHostAddress> list = host_info.addresses();
   QList<QHostAddress>::Iterator it = list.begin();
@@ -158,8 +159,16 @@ vector<IpAddress> QtDnsLookupWorker::addresses(void)
     {
       addr_list.push_back(IpAddress((*it).toString().toStdString()));
     }
+    else if ((*it).protocol() == QAbstractSocket::IPv6Protocol)
+    {
+      ip6_addr_list.push_back(IpAddress((*it).toString().toStdString()));
+    }
     ++it;
   }
+
+    // IPv4 addresses first since not all sockets are dual-stack
+  addr_list.insert(addr_list.end(), ip6_addr_list.begin(),
+                   ip6_addr_list.end());
   
   return addr_list;
   
@@ -0,0 +1,91 @@
+#.rst:
+# FindJACK
+# --------
+# Find the JACK audio connection kit library and include directory
+#
+#  JACK_FOUND         - Set to true if the JACK library is found
+#  JACK_INCLUDE_DIRS  - The directory where jack/jack.h can be found
+#  JACK_LIBRARIES     - Libraries to link with to use JACK
+#  JACK_VERSION       - Full version string (if available)
+#  JACK_VERSION_MAJOR - Major version (if available)
+#  JACK_VERSION_MINOR - Minor version (if available)
+
+#=============================================================================
+# Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#=============================================================================
+
+if(CMAKE_MINIMUM_REQUIRED_VERSION VERSION_LESS 2.6)
+  message(AUTHOR_WARNING
+    "Your project should require at least CMake 2.6 to use FindJACK.cmake")
+endif()
+
+# use pkg-config to get the directories and then use these values
+# in the FIND_PATH() and FIND_LIBRARY() calls
+find_package(PkgConfig)
+if(CMAKE_VERSION VERSION_LESS 2.8.2)
+  pkg_check_modules(PC_JACK jack)
+else()
+  pkg_check_modules(PC_JACK QUIET jack)
+endif()
+
+# Try to find the directory where the jack/jack.h header file is located
+find_path(JACK_INCLUDE_DIR
+  NAMES jack/jack.h
+  PATHS ${PC_JACK_INCLUDE_DIRS}
+  DOC "JACK include directory"
+)
+
+# Try to find the JACK library
+find_library(JACK_LIBRARY
+  NAMES jack
+  DOC "JACK library path"
+  PATHS ${PC_JACK_LIBRARY_DIRS}
+)
+
+# Set up version variables
+if(PC_JACK_VERSION)
+  set(JACK_VERSION ${PC_JACK_VERSION})
+  string(REGEX MATCHALL "[0-9]+" _JACK_VERSION_PARTS "${PC_JACK_VERSION}")
+  list(GET _JACK_VERSION_PARTS 0 JACK_VERSION_MAJOR)
+  list(GET _JACK_VERSION_PARTS 1 JACK_VERSION_MINOR)
+endif()
+
+# Handle the QUIETLY and REQUIRED arguments and set JACK_FOUND to TRUE if 
+# all listed variables are TRUE
+include(FindPackageHandleStandardArgs)
+if(CMAKE_VERSION VERSION_LESS 2.8.12)
+  find_package_handle_standard_args(JACK
+    DEFAULT_MSG
+    JACK_LIBRARY JACK_INCLUDE_DIR
+  )
+else()
+  find_package_handle_standard_args(JACK
+    FOUND_VAR JACK_FOUND
+    REQUIRED_VARS JACK_LIBRARY JACK_INCLUDE_DIR
+    VERSION_VAR JACK_VERSION
+  )
+endif()
+
+if(JACK_FOUND)
+  set(JACK_FOUND 1)
+  set(JACK_LIBRARIES ${JACK_LIBRARY})
+  set(JACK_INCLUDE_DIRS ${JACK_INCLUDE_DIR})
+  set(JACK_DEFINITIONS ${PC_JACK_CFLAGS_OTHER})
+endif()
+
+mark_as_advanced(JACK_INCLUDE_DIR JACK_LIBRARY)
+
@@ -40,6 +40,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <unordered_set>
 #include <functional>
 
 #include <cstdio>
@@ -110,6 +111,7 @@ struct Cmd
  *
  ****************************************************************************/
 
+static bool station_changed(const StationData& a, const StationData& b);
 
 
 /****************************************************************************
@@ -207,10 +209,7 @@ void Directory::getCalls(void)
   }
   else
   {
-    the_links.clear();
-    the_repeaters.clear();
-    the_conferences.clear();
-    the_stations.clear();
+    clearStationLists();
     error("Trying to update the directory list while not registered with the "
       	  "directory server");
     //stationListUpdated();
@@ -251,140 +250,50 @@ void Directory::setDescription(const string& description)
 
 const StationData *Directory::findCall(const string& call)
 {
-  list<StationData> calls;
-  list<StationData>::const_iterator iter;
-  
-  for (iter=the_links.begin(); iter!=the_links.end(); ++iter)
-  {
-    if (iter->callsign() == call)
-    {
-      return &(*iter);
-    }
-  }
-  
-  for (iter=the_repeaters.begin(); iter!=the_repeaters.end(); ++iter)
-  {
-    if (iter->callsign() == call)
-    {
-      return &(*iter);
-    }
-  }
-  
-  for (iter=the_conferences.begin(); iter!=the_conferences.end(); ++iter)
-  {
-    if (iter->callsign() == call)
-    {
-      return &(*iter);
-    }
-  }
-  
-  for (iter=the_stations.begin(); iter!=the_stations.end(); ++iter)
-  {
-    if (iter->callsign() == call)
-    {
-      return &(*iter);
-    }
-  }
-  
-  return 0;
-  
+  unordered_map<string, const StationData*>::const_iterator it =
+    call_index.find(call);
+  return (it != call_index.end()) ? it->second : 0;
 } /* Directory::findCall */
 
 
 const StationData *Directory::findStation(int id)
 {
-  list<StationData> calls;
-  list<StationData>::const_iterator iter;
-  
-  for (iter=the_links.begin(); iter!=the_links.end(); ++iter)
-  {
-    if (iter->id() == id)
-    {
-      return &(*iter);
-    }
-  }
-  
-  for (iter=the_repeaters.begin(); iter!=the_repeaters.end(); ++iter)
-  {
-    if (iter->id() == id)
-    {
-      return &(*iter);
-    }
-  }
-  
-  for (iter=the_conferences.begin(); iter!=the_conferences.end(); ++iter)
-  {
-    if (iter->id() == id)
-    {
-      return &(*iter);
-    }
-  }
-  
-  for (iter=the_stations.begin(); iter!=the_stations.end(); ++iter)
-  {
-    if (iter->id() == id)
-    {
-      return &(*iter);
-    }
-  }
-  
-  return 0;
-  
+  unordered_map<int, const StationData*>::const_iterator it =
+    id_index.find(id);
+  return (it != id_index.end()) ? it->second : 0;
 } /* Directory::findStation */
 
 
-bool Directory::stationCodeEq(const StationData& stn, string code, bool exact)
-{
-  if (exact)
-  {
-    return (stn.code() == code);
-  }
-  else
-  {
-    return (stn.code().find(code) == 0);
-  }
-} /* Directory::stationCodeEq  */
-
-
 void Directory::findStationsByCode(vector<StationData> &stns,
 		const string& code, bool exact)
 {
-  list<StationData>::const_iterator iter;
-  
   stns.clear();
 
-  for (iter=the_links.begin(); iter!=the_links.end(); ++iter)
-  {
-    if (stationCodeEq(*iter, code, exact))
-    {
-      stns.push_back(*iter);
-    }
-  }
-  
-  for (iter=the_repeaters.begin(); iter!=the_repeaters.end(); ++iter)
-  {
-    if (stationCodeEq(*iter, code, exact))
-    {
-      stns.push_back(*iter);
-    }
-  }
-  
-  for (iter=the_conferences.begin(); iter!=the_conferences.end(); ++iter)
-  {
-    if (stationCodeEq(*iter, code, exact))
+    // All codes having the given code as a prefix are stored right after
+    // the code itself in the sorted index
+  vector<unsigned> matches;
+  vector<CodeIndexEntry>::const_iterator it =
+    lower_bound(code_index.begin(), code_index.end(), CodeIndexEntry(code, 0));
+  for (; it != code_index.end(); ++it)
+  {
+    const string& stn_code = it->first;
+    bool match = exact ? (stn_code == code)
+                       : (stn_code.compare(0, code.size(), code) == 0);
+    if (!match)
     {
-      stns.push_back(*iter);
+      break;
     }
+    matches.push_back(it->second);
   }
-  
-  for (iter=the_stations.begin(); iter!=the_stations.end(); ++iter)
+
+    // Return the stations in the same order as they appear in the lists
+  sort(matches.begin(), matches.end());
+  stns.reserve(matches.size());
+  vector<unsigned>::const_iterator mit;
+  for (mit = matches.begin(); mit != matches.end(); ++mit)
   {
-    if (stationCodeEq(*iter, code, exact))
-    {
-      stns.push_back(*iter);
-    }
+    stns.push_back(*index_order[*mit]);
   }
-
 } /* Directory::findStationsByCode  */
 
 
@@ -607,32 +516,31 @@ int Directory::handleCallList(char *buf, int len)
 	if (memcmp(buf, "+++", 3) == 0)
 	{
 	  //printf("End received!\n");
-	  the_links.clear();
-	  the_repeaters.clear();
-	  the_conferences.clear();
-	  the_stations.clear();
-	  list<StationData>::const_iterator it;
-	  for (it = get_call_list.begin(); it != get_call_list.end(); ++it)
+	  if (!stationListChanged.empty())
 	  {
-	    const string &callsign = it->callsign();
+	    diffStationLists();
+	  }
+	  clearStationLists();
+	    // The entries are moved, not copied, into the station lists
+	  while (!get_call_list.empty())
+	  {
+	    const string &callsign = get_call_list.front().callsign();
+	    list<StationData> *dest = &the_stations;
 	    if (callsign.rfind("-L") == callsign.size()-2)
 	    {
-	      the_links.push_back(*it);
+	      dest = &the_links;
 	    }
 	    else if (callsign.rfind("-R") == callsign.size()-2)
 	    {
-	      the_repeaters.push_back(*it);
+	      dest = &the_repeaters;
 	    }
 	    else if (callsign.find("*") == 0)
 	    {
-	      the_conferences.push_back(*it);
-	    }
-	    else
-	    {
-	      the_stations.push_back(*it);
+	      dest = &the_conferences;
 	    }
+	    dest->splice(dest->end(), get_call_list, get_call_list.begin());
 	  }
-	  get_call_list.clear();
+	  buildIndexes();
 	  com_state = CS_IDLE;
 	  read_len = 3;
 	}
@@ -796,6 +704,14 @@ int Directory::ctrlSockDataReceived(void *ptr, unsigned len)
 	}
 	else
 	{
+	  if (!added_stns.empty() || !removed_stns.empty() ||
+	      !changed_stns.empty())
+	  {
+	    stationListChanged(added_stns, removed_stns, changed_stns);
+	  }
+	  added_stns.clear();
+	  removed_stns.clear();
+	  changed_stns.clear();
 	  stationListUpdated();
 	}
 	sendNextCmd();
@@ -1006,8 +922,99 @@ void Directory::onCmdTimeout(Timer *timer)
 } /* Directory::onCmdTimeout */
 
 
+void Directory::clearStationLists(void)
+{
+  the_links.clear();
+  the_repeaters.clear();
+  the_conferences.clear();
+  the_stations.clear();
+  buildIndexes();
+} /* Directory::clearStationLists */
+
+
+void Directory::buildIndexes(void)
+{
+  call_index.clear();
+  id_index.clear();
+  code_index.clear();
+  index_order.clear();
+
+  const list<StationData>* lists[] =
+  {
+    &the_links, &the_repeaters, &the_conferences, &the_stations
+  };
+  for (size_t i = 0; i < sizeof(lists) / sizeof(*lists); ++i)
+  {
+    list<StationData>::const_iterator it;
+    for (it = lists[i]->begin(); it != lists[i]->end(); ++it)
+    {
+      const StationData *stn = &(*it);
+        // The first station found is kept if there are duplicates, like
+        // the list search did
+      call_index.insert(make_pair(stn->callsign(), stn));
+      id_index.insert(make_pair(stn->id(), stn));
+      code_index.push_back(CodeIndexEntry(stn->code(), index_order.size()));
+      index_order.push_back(stn);
+    }
+  }
+  sort(code_index.begin(), code_index.end());
+} /* Directory::buildIndexes */
+
+
+void Directory::diffStationLists(void)
+{
+  added_stns.clear();
+  removed_stns.clear();
+  changed_stns.clear();
+
+  unordered_set<string> new_calls;
+  list<StationData>::const_iterator it;
+  for (it = get_call_list.begin(); it != get_call_list.end(); ++it)
+  {
+    if (!new_calls.insert(it->callsign()).second)
+    {
+      continue;
+    }
+    const StationData *old_stn = findCall(it->callsign());
+    if (old_stn == 0)
+    {
+      added_stns.push_back(*it);
+    }
+    else if (station_changed(*old_stn, *it))
+    {
+      changed_stns.push_back(*it);
+    }
+  }
+
+  vector<const StationData*>::const_iterator oit;
+  for (oit = index_order.begin(); oit != index_order.end(); ++oit)
+  {
+    const StationData *old_stn = *oit;
+    if ((findCall(old_stn->callsign()) == old_stn) &&
+        (new_calls.find(old_stn->callsign()) == new_calls.end()))
+    {
+      removed_stns.push_back(*old_stn);
+    }
+  }
+} /* Directory::diffStationLists */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static bool station_changed(const StationData& a, const StationData& b)
+{
+  return (a.status() != b.status()) || (a.time() != b.time()) ||
+         (a.description() != b.description()) || (a.id() != b.id()) ||
+         (a.ip() != b.ip());
+} /* station_changed */
+
+
 
 /*
  * This file has not been truncated
  */
-
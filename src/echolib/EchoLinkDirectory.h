@@ -48,6 +48,8 @@ An example of how to use the EchoLink::Directory class
 #include <string>
 #include <list>
 #include <vector>
+#include <unordered_map>
+#include <utility>
 #include <iostream>
 
 
@@ -352,6 +354,21 @@ class Directory : public sigc::trackable
      * @brief A signal that is emitted when the station list has been updated
      */
     sigc::signal<void> stationListUpdated;
+
+    /**
+     * @brief A signal that is emitted when the station list has changed
+     * @param added   Stations that were not in the previous list
+     * @param removed Stations that are not in the new list
+     * @param changed Stations that have a new status, description, id or IP
+     *
+     * The stations are matched on callsign. This signal is emitted right
+     * before the stationListUpdated signal if anything has changed since
+     * the previous update. The comparison is only done if this signal is
+     * connected.
+     */
+    sigc::signal<void, const std::vector<StationData>&,
+                 const std::vector<StationData>&,
+                 const std::vector<StationData>&> stationListChanged;
     
     /**
      * @brief A signal that is emitted when an error occurs
@@ -383,6 +400,18 @@ class Directory : public sigc::trackable
     std::list<StationData>    the_stations;
     std::list<StationData>    the_conferences;
     std::string       	      the_message;
+
+      // Lookup indexes into the station lists above. They are rebuilt each
+      // time the lists change. The code index is sorted on code and then
+      // on the position in index_order, which is the list order.
+    typedef std::pair<std::string, unsigned> CodeIndexEntry;
+    std::unordered_map<std::string, const StationData*> call_index;
+    std::unordered_map<int, const StationData*>         id_index;
+    std::vector<CodeIndexEntry>                         code_index;
+    std::vector<const StationData*>                     index_order;
+    std::vector<StationData>                            added_stns;
+    std::vector<StationData>                            removed_stns;
+    std::vector<StationData>                            changed_stns;
     std::string       	      error_str;
     
     int       	      	      get_call_cnt;
@@ -414,7 +443,9 @@ class Directory : public sigc::trackable
     void createClientObject(void);
     void onRefreshRegistration(Async::Timer *timer);
     void onCmdTimeout(Async::Timer *timer);
-    bool stationCodeEq(const StationData& stn, std::string code, bool exact);
+    void clearStationLists(void);
+    void buildIndexes(void);
+    void diffStationLists(void);
 
 };  /* class Directory */
 
@@ -290,6 +290,11 @@ Dispatcher::Dispatcher(void)
       audio_sock = 0;
       return;
     }
+
+      // Read all datagrams that are waiting using as few system calls as
+      // possible. Conference servers may receive from many stations at once.
+    ctrl_sock->setBatchMode(CTRL_BATCH_SIZE);
+    audio_sock->setBatchMode(AUDIO_BATCH_SIZE);
     
     ctrl_sock->dataReceived.connect(
         mem_fun(*this, &Dispatcher::ctrlDataReceived));
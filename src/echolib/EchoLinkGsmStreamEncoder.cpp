@@ -0,0 +1,210 @@
+/**
+@file	 EchoLinkGsmStreamEncoder.cpp
+@brief   Encode one audio stream into GSM packets for many connections
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+\verbatim
+EchoLib - A library for EchoLink communication
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <cstring>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "EchoLinkGsmStreamEncoder.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace EchoLink;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+GsmStreamEncoder::GsmStreamEncoder(void)
+  : gsmh(gsm_create()), buffer_cnt(0)
+{
+  memset(&packet.header, 0, sizeof(packet.header));
+  packet.header.version = 0xc0;
+  packet.header.pt = 0x03;
+  packet.header.time = htonl(0);
+  packet.header.ssrc = htonl(0);
+
+  raw_packet.voice_packet = &packet;
+  raw_packet.length = sizeof(packet.header) + FRAME_COUNT * 33;
+  raw_packet.samples = buffer;
+} /* GsmStreamEncoder::GsmStreamEncoder */
+
+
+GsmStreamEncoder::~GsmStreamEncoder(void)
+{
+  gsm_destroy(gsmh);
+} /* GsmStreamEncoder::~GsmStreamEncoder */
+
+
+int GsmStreamEncoder::writeSamples(const float *samples, int count)
+{
+  int samples_read = 0;
+  while (samples_read < count)
+  {
+    int read_cnt = min(BUFFER_SIZE - buffer_cnt, count - samples_read);
+    for (int i=0; i<read_cnt; ++i)
+    {
+      float sample = samples[samples_read++];
+      if (sample > 1)
+      {
+        buffer[buffer_cnt++] = 32767;
+      }
+      else if (sample < -1)
+      {
+        buffer[buffer_cnt++] = -32767;
+      }
+      else
+      {
+        buffer[buffer_cnt++] = static_cast<int16_t>(32767.0 * sample);
+      }
+    }
+
+    if (buffer_cnt == BUFFER_SIZE)
+    {
+      encodePacket();
+    }
+  }
+
+  return samples_read;
+} /* GsmStreamEncoder::writeSamples */
+
+
+void GsmStreamEncoder::flushSamples(void)
+{
+  if (buffer_cnt > 0)
+  {
+    memset(buffer + buffer_cnt, 0,
+           sizeof(buffer) - sizeof(*buffer) * buffer_cnt);
+    encodePacket();
+  }
+  sourceAllSamplesFlushed();
+} /* GsmStreamEncoder::flushSamples */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void GsmStreamEncoder::encodePacket(void)
+{
+  for (int i=0; i<FRAME_COUNT; ++i)
+  {
+    gsm_encode(gsmh, buffer + i*160, packet.data + i*33);
+  }
+  buffer_cnt = 0;
+  packetEncoded(&raw_packet);
+} /* GsmStreamEncoder::encodePacket */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,190 @@
+/**
+@file	 EchoLinkGsmStreamEncoder.h
+@brief   Encode one audio stream into GSM packets for many connections
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains a class that GSM encode an audio stream once so that the
+encoded packets can be sent to all connections that should receive the same
+audio. For more information, see the documentation for class
+EchoLink::GsmStreamEncoder.
+
+\verbatim
+EchoLib - A library for EchoLink communication
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+#ifndef ECHOLINK_GSM_STREAM_ENCODER_INCLUDED
+#define ECHOLINK_GSM_STREAM_ENCODER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+extern "C" {
+#include <gsm.h>
+}
+#include <AsyncAudioSink.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "EchoLinkQso.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace EchoLink
+{
+
+/****************************************************************************
+ *
+ * Forward declarations inside the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Encode one audio stream into GSM packets for many connections
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+On a conference node the same audio is usually sent to many stations. Instead
+of letting each Qso object encode its own copy of the audio, the audio can be
+written to an object of this class. The audio is encoded using one GSM
+encoder and each encoded packet is handed out using the packetEncoded signal.
+Send the packet to each connection using Qso::sendAudioRaw.
+
+Since one encoder is used for the whole stream, the encoder state always
+match the audio that has been encoded, just like when a Qso encode the audio
+itself. The audio must be sampled at 8kHz.
+*/
+class GsmStreamEncoder : public Async::AudioSink, public sigc::trackable
+{
+  public:
+    /**
+     * @brief 	Constructor
+     */
+    GsmStreamEncoder(void);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~GsmStreamEncoder(void);
+
+    /**
+     * @brief 	Write samples into this audio sink
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the sink to flush the previously written samples
+     *
+     * The last, incomplete, packet is padded with silence and sent.
+     */
+    virtual void flushSamples(void);
+
+    /**
+     * @brief   A signal that is emitted when a packet has been encoded
+     * @param   packet The encoded packet, ready to be sent
+     *
+     * The packet is only valid while the signal is being emitted.
+     */
+    sigc::signal<void, Qso::RawPacket*> packetEncoded;
+
+  private:
+    static const int    FRAME_COUNT = 4;
+    static const int    BUFFER_SIZE = FRAME_COUNT*160;
+
+    gsm                 gsmh;
+    short               buffer[BUFFER_SIZE];
+    int                 buffer_cnt;
+    Qso::VoicePacket    packet;
+    Qso::RawPacket      raw_packet;
+
+    GsmStreamEncoder(const GsmStreamEncoder&);
+    GsmStreamEncoder& operator=(const GsmStreamEncoder&);
+    void encodePacket(void);
+
+};  /* class GsmStreamEncoder */
+
+
+} /* namespace */
+
+#endif /* ECHOLINK_GSM_STREAM_ENCODER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -167,6 +167,13 @@ Qso::Qso(const IpAddress& addr, const string& callsign, const string& name,
     return;
   }
   
+    // Only the payload type and the sequence number change between the
+    // audio packets that are sent
+  memset(&send_packet.header, 0, sizeof(send_packet.header));
+  send_packet.header.version = 0xc0;
+  send_packet.header.time = htonl(0);
+  send_packet.header.ssrc = htonl(0);
+
   setLocalCallsign(callsign);
       
   gsmh = gsm_create();
@@ -227,48 +234,17 @@ Qso::~Qso(void)
 
 bool Qso::setLocalCallsign(const string& callsign)
 {
-#ifdef SPEEX_MAJOR
-  const char *priv = "SPEEX";
-#else
-  const char *priv = 0;
-#endif  
   this->callsign.resize(callsign.size());
   transform(callsign.begin(), callsign.end(), this->callsign.begin(),
       	   ::toupper);
-  sdes_length = rtp_make_sdes(sdes_packet, callsign.c_str(),
-      name.c_str(), priv);
-  if(sdes_length <= 0)
-  {
-    cerr << "Could not create SDES packet\n";
-    return false;
-  }
-  
-  return true;
-  
+  return buildSdesPacket();
 } /* Qso::setLocalCallsign */
 
 
 bool Qso::setLocalName(const string& name)
 {
-  const char *priv = 0;
-#ifdef SPEEX_MAJOR
-  if (!use_gsm_only)
-  {
-    priv = "SPEEX";
-  }
-#endif  
-
   this->name = name;
-  sdes_length = rtp_make_sdes(sdes_packet, callsign.c_str(),
-      name.c_str(), priv);
-  if(sdes_length <= 0)
-  {
-    cerr << "Could not create SDES packet\n";
-    return false;
-  }
-  
-  return true;
-  
+  return buildSdesPacket();
 } /* Qso::setLocalName */
 
 
@@ -403,22 +379,13 @@ bool Qso::sendAudioRaw(RawPacket *raw_packet)
       (p->remote_codec == Private::CODEC_GSM))
   {
     // transcode SPEEX -> GSM
-    VoicePacket voice_packet;
-    size_t nbytes = 0;
+    size_t nbytes = FRAME_COUNT * 33;
+    encodeGsmFrames(raw_packet->samples, send_packet.data);
+    send_packet.header.pt = 0x03;
+    send_packet.header.seqNum = htons(next_audio_seq++);
     
-    for(int i=0; i<FRAME_COUNT; i++)
-    {
-      gsm_encode(gsmh, raw_packet->samples + i*160, voice_packet.data + i*33);
-      nbytes += 33;
-    }
-    voice_packet.header.version = 0xc0;
-    voice_packet.header.pt = 0x03;
-    voice_packet.header.time = htonl(0);
-    voice_packet.header.ssrc = htonl(0);
-    voice_packet.header.seqNum = htons(next_audio_seq++);
-    
-    bool success = Dispatcher::instance()->sendAudioMsg(remote_ip, &voice_packet,
-        nbytes + sizeof(voice_packet.header));
+    bool success = Dispatcher::instance()->sendAudioMsg(remote_ip, &send_packet,
+        nbytes + sizeof(send_packet.header));
     if (!success)
     {
       perror("sendAudioMsg in Qso::sendAudioRaw");
@@ -531,10 +498,20 @@ void Qso::resumeOutput(void)
 
 void Qso::setUseGsmOnly(void)
 {
-  use_gsm_only = true;
+  if (!use_gsm_only)
+  {
+    use_gsm_only = true;
+    buildSdesPacket();
+  }
 } /* Qso::setGsmCodec */
 
 
+bool Qso::usesGsmCodec(void) const
+{
+  return p->remote_codec == Private::CODEC_GSM;
+} /* Qso::usesGsmCodec */
+
+
 /****************************************************************************
  *
  * Protected member functions
@@ -779,6 +756,8 @@ inline void Qso::handleAudioPacket(unsigned char *buf, int len)
     return;
   }
 
+  audioPacketReceived(ntohs(voice_packet->header.seqNum));
+
 #ifdef SPEEX_MAJOR
   if (voice_packet->header.pt == 0x96)
   {
@@ -870,6 +849,31 @@ inline void Qso::handleAudioPacket(unsigned char *buf, int len)
 } /* Qso::handleAudioPacket */
 
 
+bool Qso::buildSdesPacket(void)
+{
+  const char *priv = 0;
+#ifdef SPEEX_MAJOR
+  if (!use_gsm_only)
+  {
+    priv = "SPEEX";
+  }
+#endif
+
+    // The packet is only built when the station description change and is
+    // then sent as is by sendSdesPacket
+  sdes_length = rtp_make_sdes(sdes_packet, callsign.c_str(),
+      name.c_str(), priv);
+  if(sdes_length <= 0)
+  {
+    cerr << "Could not create SDES packet\n";
+    return false;
+  }
+  
+  return true;
+  
+} /* Qso::buildSdesPacket */
+
+
 bool Qso::sendSdesPacket(void)
 {
   bool success = Dispatcher::instance()->sendCtrlMsg(remote_ip, sdes_packet,
@@ -960,11 +964,7 @@ bool Qso::sendVoicePacket(void)
   assert(send_buffer_cnt == BUFFER_SIZE);
 
   size_t nbytes = 0;
-  VoicePacket voice_packet;
-  voice_packet.header.version = 0xc0;
-  voice_packet.header.time = htonl(0);
-  voice_packet.header.ssrc = htonl(0);
-  voice_packet.header.seqNum = htons(next_audio_seq++);
+  send_packet.header.seqNum = htons(next_audio_seq++);
 
 #ifdef SPEEX_MAJOR
   if (p->remote_codec == Private::CODEC_SPEEX)
@@ -975,22 +975,19 @@ bool Qso::sendVoicePacket(void)
     }
     speex_bits_insert_terminator(&p->enc_bits);
     size_t nsize = speex_bits_nbytes(&p->enc_bits);
-    if (nsize < sizeof(voice_packet.data))
+    if (nsize < sizeof(send_packet.data))
     {
-      nbytes = speex_bits_write(&p->enc_bits, (char*)voice_packet.data, nsize);
+      nbytes = speex_bits_write(&p->enc_bits, (char*)send_packet.data, nsize);
     }
     speex_bits_reset(&p->enc_bits);
-    voice_packet.header.pt = 0x96;
+    send_packet.header.pt = 0x96;
   }
   else
 #endif
   {
-    for(int i=0; i<FRAME_COUNT; i++)
-    {
-      gsm_encode(gsmh, send_buffer + i*160, voice_packet.data + i*33);
-      nbytes += 33;
-    }
-    voice_packet.header.pt = 0x03;
+    encodeGsmFrames(send_buffer, send_packet.data);
+    nbytes = FRAME_COUNT * 33;
+    send_packet.header.pt = 0x03;
   }
   if (!nbytes)
   {
@@ -998,8 +995,8 @@ bool Qso::sendVoicePacket(void)
     return false;
   }
 
-  bool success = Dispatcher::instance()->sendAudioMsg(remote_ip, &voice_packet,
-      nbytes + sizeof(voice_packet.header));
+  bool success = Dispatcher::instance()->sendAudioMsg(remote_ip, &send_packet,
+      nbytes + sizeof(send_packet.header));
   if (!success)
   {
     perror("sendAudioMsg in Qso::sendVoicePacket");
@@ -1011,6 +1008,15 @@ bool Qso::sendVoicePacket(void)
 } /* Qso::sendVoicePacket */
 
 
+void Qso::encodeGsmFrames(const short *samples, unsigned char *data)
+{
+  for(int i=0; i<FRAME_COUNT; i++)
+  {
+    gsm_encode(gsmh, const_cast<short *>(samples) + i*160, data + i*33);
+  }
+} /* Qso::encodeGsmFrames */
+
+
 void Qso::checkRxActivity(Timer *timer)
 {
   //cout << "### Qso::checkRxActivity: rx_timeout_left="
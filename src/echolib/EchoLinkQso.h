@@ -405,6 +405,16 @@ class Qso
      * not good to decode and then encode the data again. It will sound awful.
      */
     sigc::signal<void, RawPacket*>  audioReceivedRaw;
+
+    /**
+     * @brief A signal that is emitted when an audio packet has arrived
+     * @param seq The RTP sequence number of the packet
+     *
+     * This signal is emitted before the decoded audio of the packet is
+     * written to the audio sink. It can be used to feed a jitter buffer
+     * with the packet sequence numbers.
+     */
+    sigc::signal<void, uint16_t>    audioPacketReceived;
     
 
     /**
@@ -453,6 +463,15 @@ class Qso
      */
     void setUseGsmOnly(void);
 
+    /**
+     * @brief   Check if audio is sent to the remote station using GSM
+     * @return  Returns \em true if the GSM codec is used
+     *
+     * Audio encoded by a GsmStreamEncoder may be sent to connections that
+     * use the GSM codec.
+     */
+    bool usesGsmCodec(void) const;
+
   protected:
     /**
      * @brief The registered sink has flushed all samples
@@ -481,6 +500,7 @@ class Qso
     bool      	      	init_ok;
     unsigned char      	sdes_packet[1500];
     int       	      	sdes_length;
+    VoicePacket         send_packet;
     State     	      	state;
     gsm       	      	gsmh;
     uint16_t    	next_audio_seq;
@@ -513,6 +533,7 @@ class Qso
     inline void handleNonAudioPacket(unsigned char *buf, int len);
     inline void handleAudioPacket(unsigned char *buf, int len);
     void micAudioRead(void *buf, size_t len);
+    bool buildSdesPacket(void);
     bool sendSdesPacket(void);
     void sendKeepAlive(Async::Timer *timer);
     void setState(State state);
@@ -520,6 +541,7 @@ class Qso
     bool setupConnection(void);
     void cleanupConnection(void);
     bool sendVoicePacket(void);
+    void encodeGsmFrames(const short *samples, unsigned char *data);
     void checkRxActivity(Async::Timer *timer);
     bool sendByePacket(void);
     
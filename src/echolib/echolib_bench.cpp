@@ -0,0 +1,929 @@
+/**
+@file	 echolib_bench.cpp
+@brief   Measure how many simultaneous EchoLink connections a node can handle
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This program simulate a number of EchoLink stations that connect to a running
+node, typically SvxLink with the EchoLink module, over the loopback
+interface. Each station talk the EchoLink protocol, RTCP SDES to connect and
+keep the connection alive, RTP GSM audio and RTCP BYE to disconnect. The
+stations take turns talking so that the node relay the audio of one station
+to all the others, like in a conference. The audio latency through the node,
+the frame loss and the CPU usage of the node process are reported. This is
+repeated with an increasing number of stations.
+
+Since the EchoLink protocol use fixed port numbers, each simulated station
+use an address of its own in the 127.0.0.0/8 network. The node must be
+bound to 127.0.0.1 and accept connections from the simulated stations
+without asking the directory server. For ModuleEchoLink this mean:
+
+  BIND_ADDR=127.0.0.1
+  ALLOW_IP=127.0.0.0/8
+  MAX_QSOS=<at least the maximum number of stations>
+  MAX_CONNECTIONS=<MAX_QSOS+1>
+
+\verbatim
+EchoLib - A library for EchoLink communication
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <popt.h>
+#include <sigc++/sigc++.h>
+
+extern "C" {
+#include <gsm.h>
+}
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppApplication.h>
+#include <AsyncUdpSocket.h>
+#include <AsyncTimer.h>
+#include <BenchUtil.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "EchoLinkQso.h"
+#include "rtpacket.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace EchoLink;
+using namespace SvxLink;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+#define PROGRAM_NAME "EchoLibBench"
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+  // The EchoLink audio packet interval, four GSM frames of 20ms each
+const unsigned FRAME_INTERVAL_MS = 80;
+const unsigned GSM_FRAME_SIZE = 33;
+const unsigned GSM_FRAME_COUNT = 4;
+
+  // The keep alive interval used by EchoLink stations and the retry interval
+  // used while connecting
+const unsigned KEEP_ALIVE_MS = 10000;
+const unsigned CONNECT_RETRY_MS = 1000;
+
+  // The longest time to wait for the stations in a step to connect
+const unsigned CONNECT_TIMEOUT_MS = 15000;
+
+  // The time to wait for audio still in transit at the end of a step
+const unsigned DRAIN_MS = 1000;
+
+  // The highest number of stations. Each station need an address of its own.
+const unsigned MAX_STATIONS = 1000;
+
+  // The SSRC of the audio packets sent by a simulated station is set to this
+  // tag ored with the station index. The node relay the RTP header as is,
+  // except for the sequence number, so audio from the node itself, like
+  // announcements, can be told apart.
+const uint32_t SSRC_TAG = 0x45420000; // "EB"
+
+
+struct Stats : public BenchStats
+{
+  uint64_t          frames_expected;
+  uint64_t          node_frames;
+
+  Stats(void) : frames_expected(0), node_frames(0) {}
+  void reset(void)
+  {
+    BenchStats::reset();
+    frames_expected = node_frames = 0;
+  }
+}; /* Stats */
+
+
+class Bench;
+
+
+/**
+ * One simulated EchoLink station
+ */
+class Station : public sigc::trackable
+{
+  public:
+    Station(Bench *bench, unsigned idx, const IpAddress& ip);
+    ~Station(void);
+
+    bool initOk(void) const { return m_ctrl_sock != 0; }
+    bool isConnected(void) const { return m_connected; }
+    unsigned index(void) const { return m_idx; }
+    void connect(void);
+    void disconnect(void);
+    void sendAudio(void);
+
+  private:
+    Bench *           m_bench;
+    unsigned          m_idx;
+    IpAddress         m_ip;
+    UdpSocket *       m_ctrl_sock;
+    UdpSocket *       m_audio_sock;
+    Timer             m_keep_alive_timer;
+    bool              m_connecting;
+    bool              m_connected;
+    uint16_t          m_audio_seq;
+    unsigned char     m_sdes[1500];
+    int               m_sdes_len;
+
+    void sendSdes(Timer *t=0);
+    void ctrlDataReceived(const IpAddress& ip, uint16_t port, void *buf,
+                          int len);
+    void audioDataReceived(const IpAddress& ip, uint16_t port, void *buf,
+                           int len);
+}; /* Station */
+
+
+/**
+ * The benchmark controller
+ */
+class Bench : public sigc::trackable
+{
+  public:
+    std::string       node_host;
+    int               port_base;
+    unsigned          start_cnt;
+    unsigned          max_cnt;
+    unsigned          step_time_s;
+    unsigned          warmup_time_s;
+    unsigned          talk_time_ms;
+    unsigned          pause_time_ms;
+    std::string       callsign_prefix;
+    pid_t             node_pid;
+
+    Bench(void);
+    ~Bench(void);
+
+    void start(void);
+    const IpAddress& nodeIp(void) const { return m_node_ip; }
+    const std::string& callsign(unsigned idx) const;
+    const unsigned char *audioData(void) const { return m_gsm_data; }
+    void stationConnected(Station *stn);
+    void stationDisconnected(Station *stn);
+    void audioReceived(Station *stn, const Qso::VoicePacket& pkt);
+    void audioSent(Station *stn, uint32_t tx_time);
+    void stop(void);
+
+  private:
+    typedef enum
+    {
+      PHASE_CONNECT, PHASE_WARMUP, PHASE_MEASURE, PHASE_DRAIN
+    } Phase;
+
+    IpAddress               m_node_ip;
+    std::vector<Station*>   m_stations;
+    std::vector<std::string> m_callsigns;
+    unsigned                m_target_cnt;
+    unsigned                m_connected_cnt;
+    Phase                   m_phase;
+    Timer                   m_phase_timer;
+    Timer                   m_frame_timer;
+    Timer                   m_talk_timer;
+    Station *               m_talker;
+    unsigned                m_next_talker;
+    bool                    m_talking;
+    uint32_t                m_measure_start;
+    uint64_t                m_measure_start_us;
+    Stats                   m_stats;
+    ProcSampler             m_node_sampler;
+    ProcSampler             m_self_sampler;
+    unsigned char           m_gsm_data[GSM_FRAME_COUNT * GSM_FRAME_SIZE];
+
+    void encodeAudio(void);
+    void startStep(unsigned cnt);
+    void setPhase(Phase phase, unsigned timeout_ms);
+    void phaseTimeout(Timer *t);
+    void beginMeasure(void);
+    void sendFrame(Timer *t);
+    void talkTimeout(Timer *t);
+    void printStats(double elapsed_s);
+}; /* Bench */
+
+
+Station::Station(Bench *bench, unsigned idx, const IpAddress& ip)
+  : m_bench(bench), m_idx(idx), m_ip(ip), m_ctrl_sock(0), m_audio_sock(0),
+    m_keep_alive_timer(CONNECT_RETRY_MS, Timer::TYPE_PERIODIC, false),
+    m_connecting(false), m_connected(false), m_audio_seq(0), m_sdes_len(0)
+{
+  m_ctrl_sock = new UdpSocket(bench->port_base + 1, ip);
+  m_audio_sock = new UdpSocket(bench->port_base, ip);
+  if (!m_ctrl_sock->initOk() || !m_audio_sock->initOk())
+  {
+    cerr << "*** ERROR: Could not bind the UDP ports for station "
+         << bench->callsign(idx) << " to " << ip << endl;
+    delete m_ctrl_sock;
+    m_ctrl_sock = 0;
+    delete m_audio_sock;
+    m_audio_sock = 0;
+    return;
+  }
+  m_ctrl_sock->dataReceived.connect(
+      mem_fun(*this, &Station::ctrlDataReceived));
+  m_audio_sock->dataReceived.connect(
+      mem_fun(*this, &Station::audioDataReceived));
+  m_keep_alive_timer.expired.connect(mem_fun(*this, &Station::sendSdes));
+
+  m_sdes_len = rtp_make_sdes(m_sdes, bench->callsign(idx).c_str(),
+                             "Bench", 0);
+} /* Station::Station */
+
+
+Station::~Station(void)
+{
+  delete m_ctrl_sock;
+  delete m_audio_sock;
+} /* Station::~Station */
+
+
+void Station::connect(void)
+{
+  if (m_connecting || m_connected)
+  {
+    return;
+  }
+  m_connecting = true;
+  m_keep_alive_timer.setTimeout(CONNECT_RETRY_MS);
+  m_keep_alive_timer.setEnable(true);
+  sendSdes();
+} /* Station::connect */
+
+
+void Station::disconnect(void)
+{
+  if (!m_connecting && !m_connected)
+  {
+    return;
+  }
+  unsigned char bye[64];
+  int len = rtp_make_bye(bye);
+  m_ctrl_sock->write(m_bench->nodeIp(), m_bench->port_base + 1, bye, len);
+  m_keep_alive_timer.setEnable(false);
+  m_connecting = false;
+  m_connected = false;
+} /* Station::disconnect */
+
+
+void Station::sendAudio(void)
+{
+  Qso::VoicePacket pkt;
+  const size_t payload_size = GSM_FRAME_COUNT * GSM_FRAME_SIZE;
+  const uint32_t tx_time = static_cast<uint32_t>(benchNowUs());
+  pkt.header.version = 0xc0;
+  pkt.header.pt = 0x03;
+  pkt.header.seqNum = htons(m_audio_seq++);
+  pkt.header.time = htonl(tx_time);
+  pkt.header.ssrc = htonl(SSRC_TAG | m_idx);
+  memcpy(pkt.data, m_bench->audioData(), payload_size);
+  m_audio_sock->write(m_bench->nodeIp(), m_bench->port_base, &pkt,
+                      sizeof(pkt.header) + payload_size);
+  m_bench->audioSent(this, tx_time);
+} /* Station::sendAudio */
+
+
+void Station::sendSdes(Timer *t)
+{
+  m_ctrl_sock->write(m_bench->nodeIp(), m_bench->port_base + 1, m_sdes,
+                     m_sdes_len);
+} /* Station::sendSdes */
+
+
+void Station::ctrlDataReceived(const IpAddress& ip, uint16_t port, void *buf,
+                               int len)
+{
+  if (ip != m_bench->nodeIp())
+  {
+    return;
+  }
+
+  unsigned char *pkt = reinterpret_cast<unsigned char *>(buf);
+  if (isRTCPByepacket(pkt, len))
+  {
+    if (m_connecting || m_connected)
+    {
+      m_keep_alive_timer.setEnable(false);
+      bool was_connected = m_connected;
+      m_connecting = false;
+      m_connected = false;
+      if (was_connected)
+      {
+        m_bench->stationDisconnected(this);
+      }
+    }
+  }
+  else if (isRTCPSdespacket(pkt, len))
+  {
+    if (m_connecting)
+    {
+      m_connecting = false;
+      m_connected = true;
+      m_keep_alive_timer.setTimeout(KEEP_ALIVE_MS);
+      m_bench->stationConnected(this);
+    }
+  }
+} /* Station::ctrlDataReceived */
+
+
+void Station::audioDataReceived(const IpAddress& ip, uint16_t port, void *buf,
+                                int len)
+{
+  if ((ip != m_bench->nodeIp()) || !m_connected)
+  {
+    return;
+  }
+
+  const Qso::VoicePacket *pkt = reinterpret_cast<const Qso::VoicePacket *>(buf);
+  if ((static_cast<size_t>(len) < sizeof(pkt->header)) ||
+      (pkt->header.version != 0xc0))
+  {
+      // Info and chat packets are sent on the audio port too
+    return;
+  }
+  m_bench->audioReceived(this, *pkt);
+} /* Station::audioDataReceived */
+
+
+Bench::Bench(void)
+  : node_host("127.0.0.1"), port_base(5198), start_cnt(2), max_cnt(64),
+    step_time_s(20), warmup_time_s(5), talk_time_ms(3000),
+    pause_time_ms(500), callsign_prefix("BENCH"), node_pid(0),
+    m_target_cnt(0), m_connected_cnt(0), m_phase(PHASE_CONNECT),
+    m_phase_timer(0, Timer::TYPE_ONESHOT, false),
+    m_frame_timer(FRAME_INTERVAL_MS, Timer::TYPE_PERIODIC, false),
+    m_talk_timer(0, Timer::TYPE_ONESHOT, false),
+    m_talker(0), m_next_talker(0), m_talking(false), m_measure_start(0),
+    m_measure_start_us(0)
+{
+  m_phase_timer.expired.connect(mem_fun(*this, &Bench::phaseTimeout));
+  m_frame_timer.expired.connect(mem_fun(*this, &Bench::sendFrame));
+  m_talk_timer.expired.connect(mem_fun(*this, &Bench::talkTimeout));
+} /* Bench::Bench */
+
+
+Bench::~Bench(void)
+{
+  for (size_t i=0; i<m_stations.size(); ++i)
+  {
+    delete m_stations[i];
+  }
+} /* Bench::~Bench */
+
+
+void Bench::start(void)
+{
+  m_node_ip = IpAddress(node_host);
+  if (m_node_ip.isEmpty())
+  {
+    cerr << "*** ERROR: Illegal node address: " << node_host << endl;
+    exit(1);
+  }
+
+  encodeAudio();
+
+  m_node_sampler = ProcSampler(node_pid);
+  m_self_sampler = ProcSampler(getpid());
+  if (m_node_sampler.isValid())
+  {
+    uint64_t rss_kb = 0;
+    if (!m_node_sampler.rssKb(rss_kb))
+    {
+      cerr << "*** WARNING: Could not read memory usage for process "
+           << node_pid << endl;
+    }
+  }
+
+  cout << "Benchmarking EchoLink node at " << m_node_ip << " port "
+       << port_base << " with " << start_cnt << " to " << max_cnt
+       << " stations" << endl;
+
+  m_frame_timer.setEnable(true);
+  startStep(start_cnt);
+} /* Bench::start */
+
+
+const std::string& Bench::callsign(unsigned idx) const
+{
+  return m_callsigns[idx];
+} /* Bench::callsign */
+
+
+void Bench::stationConnected(Station *stn)
+{
+  m_connected_cnt += 1;
+  if ((m_phase == PHASE_CONNECT) && (m_connected_cnt >= m_target_cnt))
+  {
+    setPhase(PHASE_WARMUP, warmup_time_s * 1000);
+  }
+} /* Bench::stationConnected */
+
+
+void Bench::stationDisconnected(Station *stn)
+{
+  m_connected_cnt -= 1;
+  if (m_phase != PHASE_CONNECT)
+  {
+    m_stats.disconnects += 1;
+  }
+  if (stn == m_talker)
+  {
+    m_talker = 0;
+  }
+  cerr << "*** WARNING: Station " << callsign(stn->index())
+       << " was disconnected by the node" << endl;
+} /* Bench::stationDisconnected */
+
+
+void Bench::audioReceived(Station *stn, const Qso::VoicePacket& pkt)
+{
+  const uint32_t ssrc = ntohl(pkt.header.ssrc);
+  if ((ssrc & 0xffff0000) != SSRC_TAG)
+  {
+    if (m_phase == PHASE_MEASURE)
+    {
+      m_stats.node_frames += 1;
+    }
+    return;
+  }
+
+    // Only count audio that was sent during the measurement. The time stamp
+    // is the lower 32 bits of the monotonic clock in microseconds so the
+    // differences are calculated modulo 2^32.
+  const uint32_t tx_time = ntohl(pkt.header.time);
+  if (((m_phase != PHASE_MEASURE) && (m_phase != PHASE_DRAIN)) ||
+      (static_cast<int32_t>(tx_time - m_measure_start) < 0) ||
+      ((ssrc & 0xffff) == stn->index()))
+  {
+    return;
+  }
+  const uint32_t now = static_cast<uint32_t>(benchNowUs());
+  m_stats.frames_rx += 1;
+  m_stats.latency.add(static_cast<uint32_t>(now - tx_time));
+} /* Bench::audioReceived */
+
+
+void Bench::audioSent(Station *stn, uint32_t tx_time)
+{
+  if (m_phase == PHASE_MEASURE)
+  {
+    m_stats.frames_tx += 1;
+    m_stats.frames_expected += m_connected_cnt - 1;
+  }
+} /* Bench::audioSent */
+
+
+void Bench::encodeAudio(void)
+{
+    // A 440Hz tone at about -20dBFS is more realistic than silence
+  gsm gsmh = gsm_create();
+  gsm_signal samples[160];
+  unsigned pos = 0;
+  for (unsigned frame=0; frame<GSM_FRAME_COUNT; ++frame)
+  {
+    for (unsigned i=0; i<160; ++i, ++pos)
+    {
+      samples[i] = static_cast<gsm_signal>(
+          3277.0 * sin(2.0 * M_PI * 440.0 * pos / 8000.0));
+    }
+    gsm_encode(gsmh, samples, m_gsm_data + frame * GSM_FRAME_SIZE);
+  }
+  gsm_destroy(gsmh);
+} /* Bench::encodeAudio */
+
+
+void Bench::startStep(unsigned cnt)
+{
+  m_target_cnt = cnt;
+  while (m_stations.size() < m_target_cnt)
+  {
+    const unsigned idx = m_stations.size();
+    ostringstream ss;
+    ss << callsign_prefix << idx;
+    m_callsigns.push_back(ss.str());
+
+      // Skip the 127.0.0.0/16 network where the node is normally bound
+    struct in_addr addr;
+    addr.s_addr = htonl(0x7f010000 + ((idx / 254) << 8) + (idx % 254) + 1);
+    Station *stn = new Station(this, idx, IpAddress(addr));
+    if (!stn->initOk())
+    {
+      delete stn;
+      exit(1);
+    }
+    m_stations.push_back(stn);
+  }
+
+    // Stations that have been disconnected by the node are connected again
+  for (size_t i=0; i<m_stations.size(); ++i)
+  {
+    m_stations[i]->connect();
+  }
+
+  cout << "--- Connecting " << m_target_cnt << " stations" << endl;
+  setPhase(PHASE_CONNECT, CONNECT_TIMEOUT_MS);
+  if (m_connected_cnt >= m_target_cnt)
+  {
+    setPhase(PHASE_WARMUP, warmup_time_s * 1000);
+  }
+} /* Bench::startStep */
+
+
+void Bench::setPhase(Phase phase, unsigned timeout_ms)
+{
+  m_phase = phase;
+  m_phase_timer.setEnable(false);
+  m_phase_timer.setTimeout(timeout_ms);
+  m_phase_timer.setEnable(true);
+} /* Bench::setPhase */
+
+
+void Bench::phaseTimeout(Timer *t)
+{
+  switch (m_phase)
+  {
+    case PHASE_CONNECT:
+      cerr << "*** WARNING: Only " << m_connected_cnt << " of "
+           << m_target_cnt << " stations connected" << endl;
+      if (m_connected_cnt < 2)
+      {
+        cerr << "*** ERROR: At least two connected stations are needed"
+             << endl;
+        stop();
+        return;
+      }
+      setPhase(PHASE_WARMUP, warmup_time_s * 1000);
+      break;
+
+    case PHASE_WARMUP:
+      beginMeasure();
+      break;
+
+    case PHASE_MEASURE:
+        // Stop talking and wait for the audio in transit
+      m_talk_timer.setEnable(false);
+      m_talking = false;
+      m_talker = 0;
+      setPhase(PHASE_DRAIN, DRAIN_MS);
+      break;
+
+    case PHASE_DRAIN:
+    {
+      double elapsed_s = (benchNowUs() - m_measure_start_us) / 1000000.0;
+      printStats(elapsed_s);
+      if (m_target_cnt >= max_cnt)
+      {
+        stop();
+        return;
+      }
+      startStep(std::min(2 * m_target_cnt, max_cnt));
+      break;
+    }
+  }
+} /* Bench::phaseTimeout */
+
+
+void Bench::beginMeasure(void)
+{
+  m_stats.reset();
+  m_measure_start_us = benchNowUs();
+  m_measure_start = static_cast<uint32_t>(m_measure_start_us);
+  m_node_sampler.cpuPercent();
+  m_self_sampler.cpuPercent();
+  setPhase(PHASE_MEASURE, step_time_s * 1000);
+  if (!m_talking && !m_talk_timer.isEnabled())
+  {
+    talkTimeout(0);
+  }
+} /* Bench::beginMeasure */
+
+
+void Bench::sendFrame(Timer *t)
+{
+  if (m_talking && (m_talker != 0))
+  {
+    m_talker->sendAudio();
+  }
+} /* Bench::sendFrame */
+
+
+void Bench::talkTimeout(Timer *t)
+{
+  if (m_talking)
+  {
+      // Pause long enough for the node to notice that the talker has
+      // stopped so that the next station get the floor
+    m_talking = false;
+    m_talker = 0;
+    m_talk_timer.setTimeout(pause_time_ms);
+    m_talk_timer.setEnable(true);
+    return;
+  }
+
+  if ((m_phase != PHASE_WARMUP) && (m_phase != PHASE_MEASURE))
+  {
+    return;
+  }
+
+  for (size_t i=0; i<m_stations.size(); ++i)
+  {
+    Station *stn = m_stations[(m_next_talker + i) % m_stations.size()];
+    if (stn->isConnected())
+    {
+      m_talker = stn;
+      m_next_talker = (stn->index() + 1) % m_stations.size();
+      break;
+    }
+  }
+  m_talking = (m_talker != 0);
+  m_talk_timer.setTimeout(talk_time_ms);
+  m_talk_timer.setEnable(true);
+} /* Bench::talkTimeout */
+
+
+void Bench::printStats(double elapsed_s)
+{
+  int64_t lost = static_cast<int64_t>(m_stats.frames_expected) -
+                 static_cast<int64_t>(m_stats.frames_rx);
+  lost = std::max<int64_t>(lost, 0);
+  double loss_pct = (m_stats.frames_expected > 0) ?
+                    100.0 * lost / m_stats.frames_expected : 0.0;
+  unsigned stations = std::max(m_connected_cnt, 1U);
+  cout << std::fixed << std::setprecision(2)
+       << "stations=" << m_connected_cnt << "/" << m_target_cnt
+       << " tx=" << m_stats.frames_tx
+       << " rx=" << m_stats.frames_rx
+       << " (" << (elapsed_s > 0 ? m_stats.frames_rx / elapsed_s : 0) << "/s)"
+       << " lost=" << lost << " (" << loss_pct << "%)"
+       << " node_frames=" << m_stats.node_frames
+       << " disc=" << m_stats.disconnects
+       << " latency p50=" << m_stats.latency.percentileMs(50)
+       << "ms p90=" << m_stats.latency.percentileMs(90)
+       << "ms p99=" << m_stats.latency.percentileMs(99)
+       << "ms max=" << m_stats.latency.maxMs() << "ms";
+  if (m_node_sampler.isValid())
+  {
+    double cpu = m_node_sampler.cpuPercent();
+    uint64_t rss_kb = 0;
+    m_node_sampler.rssKb(rss_kb);
+    cout << " node cpu=" << cpu << "% (" << std::setprecision(4)
+         << cpu / stations << "%/station)" << std::setprecision(2)
+         << " rss=" << rss_kb / 1024.0 << "MB";
+  }
+  cout << " bench cpu=" << m_self_sampler.cpuPercent() << "%" << endl;
+  cout.unsetf(std::ios::floatfield);
+} /* Bench::printStats */
+
+
+void Bench::stop(void)
+{
+  m_frame_timer.setEnable(false);
+  m_talk_timer.setEnable(false);
+  m_phase_timer.setEnable(false);
+  for (size_t i=0; i<m_stations.size(); ++i)
+  {
+    m_stations[i]->disconnect();
+  }
+  cout << "Benchmark finished" << endl;
+  Application::app().quit();
+} /* Bench::stop */
+
+
+} /* End of anonymous namespace */
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static void parse_arguments(int argc, const char **argv, Bench& bench);
+static void handle_unix_signal(int signum);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+static Bench *the_bench = 0;
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, const char *argv[])
+{
+  CppApplication app;
+  app.catchUnixSignal(SIGINT);
+  app.catchUnixSignal(SIGTERM);
+  app.unixSignalCaught.connect(sigc::ptr_fun(&handle_unix_signal));
+
+  Bench bench;
+  parse_arguments(argc, argv, bench);
+  the_bench = &bench;
+
+  bench.start();
+  app.exec();
+
+  the_bench = 0;
+  return 0;
+} /* main */
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+static void parse_arguments(int argc, const char **argv, Bench& bench)
+{
+  char *node_host = NULL;
+  char *callsign_prefix = NULL;
+  int port_base = bench.port_base;
+  int start_cnt = bench.start_cnt;
+  int max_cnt = bench.max_cnt;
+  int step_time_s = bench.step_time_s;
+  int warmup_time_s = bench.warmup_time_s;
+  int talk_time_ms = bench.talk_time_ms;
+  int pause_time_ms = bench.pause_time_ms;
+  int node_pid = 0;
+
+  poptContext optCon;
+  const struct poptOption optionsTable[] =
+  {
+    POPT_AUTOHELP
+    {"node", 0, POPT_ARG_STRING, &node_host, 0,
+            "The IP address of the node (default 127.0.0.1)", "<ip>"},
+    {"port-base", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &port_base, 0,
+            "The EchoLink UDP port base", "<port>"},
+    {"start", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &start_cnt, 0,
+            "The number of stations in the first step", "<count>"},
+    {"max", 'n', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &max_cnt, 0,
+            "The number of stations in the last step. The number of stations "
+            "is doubled for each step", "<count>"},
+    {"step-time", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &step_time_s,
+            0, "The measurement time for each step", "<s>"},
+    {"warmup-time", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+            &warmup_time_s, 0,
+            "The time to wait after the stations have connected", "<s>"},
+    {"talk-time", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &talk_time_ms,
+            0, "The length of each transmission", "<ms>"},
+    {"pause-time", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+            &pause_time_ms, 0, "The pause between transmissions", "<ms>"},
+    {"callsign-prefix", 0, POPT_ARG_STRING, &callsign_prefix, 0,
+            "The callsign prefix for the stations (default BENCH)",
+            "<prefix>"},
+    {"pid", 0, POPT_ARG_INT, &node_pid, 0,
+            "The pid of a local node process to measure CPU and memory "
+            "usage for", "<pid>"},
+    {NULL, 0, 0, NULL, 0}
+  };
+  int err;
+
+  optCon = poptGetContext(PROGRAM_NAME, argc, argv, optionsTable, 0);
+  poptReadDefaultConfig(optCon, 0);
+
+  err = poptGetNextOpt(optCon);
+  if (err != -1)
+  {
+    fprintf(stderr, "\t%s: %s\n",
+	    poptBadOption(optCon, POPT_BADOPTION_NOALIAS),
+	    poptStrerror(err));
+    exit(1);
+  }
+
+  poptFreeContext(optCon);
+
+  if ((port_base <= 0) || (port_base > 65534) || (start_cnt < 2) ||
+      (max_cnt < start_cnt) || (max_cnt > static_cast<int>(MAX_STATIONS)) ||
+      (step_time_s <= 0) || (warmup_time_s < 0) || (talk_time_ms <= 0) ||
+      (pause_time_ms < 0) || (node_pid < 0))
+  {
+    cerr << "*** ERROR: Illegal argument value" << endl;
+    exit(1);
+  }
+
+  if (node_host != NULL)
+  {
+    bench.node_host = node_host;
+  }
+  if (callsign_prefix != NULL)
+  {
+    bench.callsign_prefix = callsign_prefix;
+  }
+  bench.port_base = port_base;
+  bench.start_cnt = start_cnt;
+  bench.max_cnt = max_cnt;
+  bench.step_time_s = step_time_s;
+  bench.warmup_time_s = warmup_time_s;
+  bench.talk_time_ms = talk_time_ms;
+  bench.pause_time_ms = pause_time_ms;
+  bench.node_pid = node_pid;
+} /* parse_arguments */
+
+
+static void handle_unix_signal(int signum)
+{
+  switch (signum)
+  {
+    case SIGINT:
+    case SIGTERM:
+      cout << endl << "Benchmark interrupted" << endl;
+      if (the_bench != 0)
+      {
+        the_bench->stop();
+      }
+      else
+      {
+        Application::app().quit();
+      }
+      break;
+  }
+} /* handle_unix_signal */
+
+
+/*
+ * This file has not been truncated
+ */
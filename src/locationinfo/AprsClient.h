@@ -109,6 +109,9 @@ class AprsClient
     virtual void update3rdState(const std::string& call, const std::string& info) = 0;
     virtual void igateMessage(const std::string& info) = 0;
 
+      // Called by LocationInfo when it is time for this client to beacon
+    virtual void sendBeacon(void) = 0;
+
 };  /* class AprsClient */
 
 
@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <sys/time.h>
 
@@ -119,8 +120,9 @@ using namespace SvxLink;
 
 AprsTcpClient::AprsTcpClient(LocationInfo::Cfg &loc_cfg,
                             const std::string &server, int port)
-  : loc_cfg(loc_cfg), server(server), port(port), con(0), beacon_timer(0),
-    reconnect_timer(0), offset_timer(0), num_connected(0)
+  : loc_cfg(loc_cfg), server(server), port(port), con(0),
+    reconnect_timer(0), offset_timer(0), num_connected(0),
+    beacon_enabled(false), reconnect_time(RECONNECT_MIN_TIME), send_offset(0)
 {
    StrList str_list;
 
@@ -133,18 +135,15 @@ AprsTcpClient::AprsTcpClient(LocationInfo::Cfg &loc_cfg,
    con->connected.connect(mem_fun(*this, &AprsTcpClient::tcpConnected));
    con->disconnected.connect(mem_fun(*this, &AprsTcpClient::tcpDisconnected));
    con->dataReceived.connect(mem_fun(*this, &AprsTcpClient::tcpDataReceived));
+   con->sendBufferFull.connect(mem_fun(*this, &AprsTcpClient::onSendBufferFull));
    con->connect();
 
-   beacon_timer = new Timer(loc_cfg.interval, Timer::TYPE_PERIODIC);
-   beacon_timer->setEnable(false);
-   beacon_timer->expired.connect(mem_fun(*this, &AprsTcpClient::sendAprsBeacon));
-
    offset_timer = new Timer(10000, Timer::TYPE_ONESHOT);
    offset_timer->setEnable(false);
    offset_timer->expired.connect(mem_fun(*this,
                  &AprsTcpClient::startNormalSequence));
 
-   reconnect_timer = new Timer(5000);
+   reconnect_timer = new Timer(reconnect_time);
    reconnect_timer->setEnable(false);
    reconnect_timer->expired.connect(mem_fun(*this,
                  &AprsTcpClient::reconnectAprsServer));
@@ -156,14 +155,18 @@ AprsTcpClient::~AprsTcpClient(void)
    delete con;
    delete reconnect_timer;
    delete offset_timer;
-   delete beacon_timer;
 } /* AprsTcpClient::~AprsTcpClient */
 
 
 void AprsTcpClient::updateQsoStatus(int action, const string& call,
   const string& info, list<string>& call_list)
 {
-  num_connected = call_list.size();
+  if (call_list.size() != static_cast<size_t>(num_connected))
+  {
+      // The number of connected stations is part of the beacon position
+    num_connected = call_list.size();
+    beacon_msg.clear();
+  }
 
   char msg[80];
   switch(action)
@@ -191,7 +194,7 @@ void AprsTcpClient::updateQsoStatus(int action, const string& call,
   sprintf(aprsmsg, "%s>%s,%s:;%s%-6.6s*111111z%s%s\r\n",
           el_call.c_str(), destination.c_str(), loc_cfg.path.c_str(),
           el_prefix.c_str(), el_call.c_str(), pos, msg);
-  sendMsg(aprsmsg);
+  sendMsg(aprsmsg, MSG_POSITION);
 
   // APRS status message, connected calls
   string status = el_prefix + el_call+">"+destination+","+loc_cfg.path+":>";
@@ -202,7 +205,7 @@ void AprsTcpClient::updateQsoStatus(int action, const string& call,
     status += *it + " ";
   }
   status += "\r\n";
-  sendMsg(status.c_str());
+  sendMsg(status.c_str(), MSG_STATUS);
 
 } /* AprsTcpClient::updateQsoStatus */
 
@@ -222,6 +225,15 @@ void AprsTcpClient::igateMessage(const string& info)
 } /* AprsTcpClient::igateMessage */
 
 
+void AprsTcpClient::sendBeacon(void)
+{
+  if (beacon_enabled)
+  {
+    sendAprsBeacon(0);
+  }
+} /* AprsTcpClient::sendBeacon */
+
+
 
 /****************************************************************************
  *
@@ -259,29 +271,35 @@ void AprsTcpClient::posStr(char *pos)
 
 void AprsTcpClient::sendAprsBeacon(Timer *t)
 {
-    // Geographic position
-  char pos[128];
-  posStr(pos);
-
-    // CTCSS/1750Hz tone
-  char tone[5];
-  sprintf(tone, (loc_cfg.tone < 1000) ? "T%03d" : "%04d", loc_cfg.tone);
-
-    // APRS message
-  char aprsmsg[150 + loc_cfg.comment.length()];
-  sprintf(aprsmsg, "%s>%s,%s:;%s%-6.6s*111111z%s%03d.%03dMHz %s R%02d%c %s\r\n",
+    // The beacon only change when the number of connected stations change
+  if (beacon_msg.empty())
+  {
+      // Geographic position
+    char pos[128];
+    posStr(pos);
+
+      // CTCSS/1750Hz tone
+    char tone[5];
+    sprintf(tone, (loc_cfg.tone < 1000) ? "T%03d" : "%04d", loc_cfg.tone);
+
+      // APRS message
+    char aprsmsg[150 + loc_cfg.comment.length()];
+    sprintf(aprsmsg,
+            "%s>%s,%s:;%s%-6.6s*111111z%s%03d.%03dMHz %s R%02d%c %s\r\n",
             el_call.c_str(), destination.c_str(), loc_cfg.path.c_str(),
             el_prefix.c_str(), el_call.c_str(), pos, loc_cfg.frequency / 1000,
             loc_cfg.frequency % 1000, tone, loc_cfg.range,
             loc_cfg.range_unit, loc_cfg.comment.c_str());
-  //cout << aprsmsg;
+    beacon_msg = aprsmsg;
+  }
+  //cout << beacon_msg;
 
-  sendMsg(aprsmsg);
+  sendMsg(beacon_msg.c_str(), MSG_POSITION);
 
 } /* AprsTcpClient::sendAprsBeacon*/
 
 
-void AprsTcpClient::sendMsg(const char *aprsmsg)
+void AprsTcpClient::sendMsg(const char *aprsmsg, MsgType type)
 {
    //cout << aprsmsg << endl;
 
@@ -290,29 +308,90 @@ void AprsTcpClient::sendMsg(const char *aprsmsg)
     return;
   }
 
-  int written = con->write(aprsmsg, strlen(aprsmsg));
-  if (written < 0)
+    // An unsent position or status is stale when a new one is queued. The
+    // first message may be partly written so it is left alone.
+  if (type != MSG_OTHER)
   {
-    cerr << "*** ERROR: TCP write error" << endl;
+    SendQueue::iterator it = send_queue.begin();
+    if ((it != send_queue.end()) && (send_offset > 0))
+    {
+      ++it;
+    }
+    while (it != send_queue.end())
+    {
+      it = (it->type == type) ? send_queue.erase(it) : it + 1;
+    }
   }
-  else if ((size_t)written != strlen(aprsmsg))
+
+  if (send_queue.size() >= SEND_QUEUE_MAX_SIZE)
   {
-    cerr << "*** ERROR: TCP transmit buffer overflow, reconnecting." << endl;
-    con->disconnect();
+    cerr << "*** WARNING: APRS server " << server << " is not keeping up, "
+         << "dropping message" << endl;
+    return;
+  }
+
+  send_queue.push_back(QueuedMsg(type, aprsmsg));
+  if (send_queue.size() == 1)
+  {
+    flushSendQueue();
   }
 } /* AprsTcpClient::sendMsg */
 
 
+void AprsTcpClient::flushSendQueue(void)
+{
+  while (!send_queue.empty())
+  {
+    const string& msg = send_queue.front().msg;
+    int written = con->write(msg.c_str() + send_offset,
+                             msg.size() - send_offset);
+    if (written < 0)
+    {
+      cerr << "*** ERROR: TCP write error" << endl;
+      con->disconnect();
+      tcpDisconnected(con, TcpConnection::DR_SYSTEM_ERROR);
+      return;
+    }
+    send_offset += written;
+    if (send_offset < msg.size())
+    {
+        // Wait for the send buffer to empty
+      return;
+    }
+    send_queue.pop_front();
+    send_offset = 0;
+  }
+} /* AprsTcpClient::flushSendQueue */
+
+
+void AprsTcpClient::onSendBufferFull(bool is_full)
+{
+  if (!is_full)
+  {
+    flushSendQueue();
+  }
+} /* AprsTcpClient::onSendBufferFull */
+
+
 
 void AprsTcpClient::aprsLogin(void)
 {
    char loginmsg[150];
-   const char *format = "user %s pass %d vers SvxLink %s filter m/10\n";
+   const char *format = "user %s pass %d vers SvxLink %s";
 
    sprintf(loginmsg, format, el_call.c_str(), getPasswd(el_call),
            SVXLINK_VERSION);
-   //cout << loginmsg;
-   sendMsg(loginmsg);
+
+     // The server side filter decide which packets the server send to us.
+     // Nothing received is used so the filter should be kept narrow.
+   string login(loginmsg);
+   if (!loc_cfg.filter.empty())
+   {
+     login += " filter " + loc_cfg.filter;
+   }
+   login += "\n";
+   //cout << login;
+   sendMsg(login.c_str());
 
 } /* AprsTcpClient::aprsLogin */
 
@@ -345,6 +424,10 @@ void AprsTcpClient::tcpConnected(void)
   cout << "Connected to APRS server " << con->remoteHost() <<
           " on port " << con->remotePort() << endl;
 
+  reconnect_time = RECONNECT_MIN_TIME;
+  send_queue.clear();
+  send_offset = 0;
+
   aprsLogin();                    // login
   offset_timer->reset();          // reset the offset_timer
   offset_timer->setEnable(true);  // restart the offset_timer
@@ -354,7 +437,7 @@ void AprsTcpClient::tcpConnected(void)
 void AprsTcpClient::startNormalSequence(Timer *t)
 {
   sendAprsBeacon(t);
-  beacon_timer->setEnable(true);		// start the beaconinterval
+  beacon_enabled = true;		// join the beacon schedule
 } /* AprsTcpClient::startNormalSequence */
 
 
@@ -374,10 +457,24 @@ void AprsTcpClient::tcpDisconnected(TcpClient<>::TcpConnection *con,
 {
   cout << "*** WARNING: Disconnected from APRS server" << endl;
 
-  beacon_timer->setEnable(false);		// no beacon while disconnected
-  reconnect_timer->setEnable(true);		// start the reconnect-timer
+  beacon_enabled = false;		// no beacon while disconnected
   offset_timer->setEnable(false);
   offset_timer->reset();
+  send_queue.clear();
+  send_offset = 0;
+
+    // Exponential backoff with +/-25% jitter so that nodes that lost the
+    // server at the same time do not reconnect at the same time
+  unsigned jitter = reconnect_time / 2;
+  unsigned timeout = reconnect_time - jitter / 2 +
+                     static_cast<unsigned>(jitter * (rand() / (1.0 + RAND_MAX)));
+  reconnect_timer->setTimeout(timeout);
+  reconnect_timer->setEnable(true);		// start the reconnect-timer
+  reconnect_time *= 2;
+  if (reconnect_time > RECONNECT_MAX_TIME)
+  {
+    reconnect_time = RECONNECT_MAX_TIME;
+  }
 } /* AprsTcpClient::tcpDisconnected */
 
 
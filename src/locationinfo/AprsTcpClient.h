@@ -37,6 +37,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <string>
 #include <vector>
+#include <deque>
 
 
 /****************************************************************************
@@ -125,26 +126,51 @@ class AprsTcpClient : public AprsClient, public sigc::trackable
        const std::string& info, std::list<std::string>& call_list);
       void update3rdState(const std::string& call, const std::string& info);
      void igateMessage(const std::string& info);
+     void sendBeacon(void);
 
 
   private:
     typedef std::vector<std::string> StrList;
 
+      // Position and status messages are replaced by newer ones of the same
+      // type if they have not been sent yet
+    typedef enum
+    {
+      MSG_OTHER, MSG_POSITION, MSG_STATUS
+    } MsgType;
+    struct QueuedMsg
+    {
+      MsgType     type;
+      std::string msg;
+      QueuedMsg(MsgType type, const std::string& msg) : type(type), msg(msg) {}
+    };
+    typedef std::deque<QueuedMsg> SendQueue;
+
+    static const unsigned RECONNECT_MIN_TIME  = 5000;
+    static const unsigned RECONNECT_MAX_TIME  = 300000;
+    static const size_t   SEND_QUEUE_MAX_SIZE = 32;
+
     LocationInfo::Cfg   &loc_cfg;
     std::string		server;
     int			port;
     Async::TcpClient<>* con;
-    Async::Timer        *beacon_timer;
     Async::Timer        *reconnect_timer;
     Async::Timer        *offset_timer;
 
     int			num_connected;
+    bool		beacon_enabled;
+    std::string		beacon_msg;
+    unsigned		reconnect_time;
+    SendQueue		send_queue;
+    size_t		send_offset;
 
     std::string		el_call;
     std::string		el_prefix;
     std::string		destination;
 
-    void  sendMsg(const char *aprsmsg);
+    void  sendMsg(const char *aprsmsg, MsgType type=MSG_OTHER);
+    void  flushSendQueue(void);
+    void  onSendBufferFull(bool is_full);
     void  posStr(char *pos);
     void  sendAprsBeacon(Async::Timer *t);
 
@@ -46,7 +46,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
-#include <AsyncTimer.h>
 #include <rtp.h>
 
 
@@ -120,71 +119,69 @@ using namespace EchoLink;
 
 AprsUdpClient::AprsUdpClient(LocationInfo::Cfg &loc_cfg,
             const std::string &server, int port)
-  : loc_cfg(loc_cfg), server(server), port(port), dns(0), beacon_timer(0),
-    curr_status(StationData::STAT_UNKNOWN), num_connected(0)
+  : loc_cfg(loc_cfg), server(server), port(port), dns(0), is_active(false),
+    last_sent(0), curr_status(StationData::STAT_UNKNOWN), num_connected(0)
 {
-   beacon_timer = new Timer(loc_cfg.interval, Timer::TYPE_PERIODIC);
-   beacon_timer->setEnable(false);
-   beacon_timer->expired.connect(
-     mem_fun(*this, &AprsUdpClient::sendLocationInfo));
+    // The callsign and position part of the packet never change
+  char tmp[256];
+  sprintf(tmp, "%s-%s/%d", loc_cfg.mycall.c_str(), loc_cfg.prefix.c_str(),
+                           getPasswd(loc_cfg.mycall));
+  cname = tmp;
+
+  sprintf(tmp, "%02d%02d.%02d%cE%03d%02d.%02d%c",
+               loc_cfg.lat_pos.deg, loc_cfg.lat_pos.min,
+               (loc_cfg.lat_pos.sec * 100) / 60, loc_cfg.lat_pos.dir,
+               loc_cfg.lon_pos.deg, loc_cfg.lon_pos.min,
+               (loc_cfg.lon_pos.sec * 100) / 60, loc_cfg.lon_pos.dir);
+  pos = tmp;
 } /* AprsUdpClient::AprsUdpClient */
 
 
 AprsUdpClient::~AprsUdpClient(void)
 {
   updateDirectoryStatus(StationData::STAT_OFFLINE);
-  delete beacon_timer;
 } /* AprsUdpClient::~AprsUdpClient */
 
 
 void AprsUdpClient::updateDirectoryStatus(StationData::Status status)
 {
-    // Check if system is properly initialized
-  if (!beacon_timer)
-  {
-    return;
-  }
-
-    // Stop automatic beacon timer
-  beacon_timer->reset();
-
     // Update status
   curr_status = status;
 
-    // Build and send the packet
+    // Build and send the packet. Beacons are sent from now on.
+  is_active = true;
   sendLocationInfo();
 
-    // Re-enable timer
-  beacon_timer->setEnable(true);
-
 } /* AprsUdpClient::updateDirectoryStatus */
 
 
 void AprsUdpClient::updateQsoStatus(int action, const string& call,
   const string& info, list<string>& call_list)
 {
-    // Check if system is properly initialized
-  if (!beacon_timer)
-  {
-    return;
-  }
-
-    // Stop automatic beacon timer
-  beacon_timer->reset();
-
     // Update QSO connection status
   num_connected = call_list.size();
   curr_call = num_connected ? call_list.back() : "";
 
     // Build and send the packet
+  is_active = true;
   sendLocationInfo();
 
-    // Re-enable timer
-  beacon_timer->setEnable(true);
-
 } /* AprsUdpClient::updateQsoStatus */
 
 
+void AprsUdpClient::sendBeacon(void)
+{
+    // No beacon until the status is known and not if a status update was
+    // sent less than half an interval ago
+  if (!is_active ||
+      (difftime(time(0), last_sent) < loc_cfg.interval / 2000))
+  {
+    return;
+  }
+  sendLocationInfo();
+} /* AprsUdpClient::sendBeacon */
+
+
 void AprsUdpClient::update3rdState(const string& call, const string& info)
 {
    // do nothing
@@ -206,7 +203,7 @@ void AprsUdpClient::update3rdState(const string& call, const string& info)
  *
  ****************************************************************************/
 
-void AprsUdpClient::sendLocationInfo(Timer *t)
+void AprsUdpClient::sendLocationInfo(void)
 {
   if (ip_addr.isEmpty())
   {
@@ -224,6 +221,7 @@ void AprsUdpClient::sendLocationInfo(Timer *t)
     int sdes_len = buildSdesPacket(sdes_packet);
 
     sock.write(ip_addr, port, sdes_packet, sdes_len);
+    last_sent = time(0);
   }
 } /* AprsUdpClient::sendLocationInfo */
 
@@ -260,7 +258,7 @@ int AprsUdpClient::buildSdesPacket(char *p)
 {
   time_t update;
   struct tm utc;
-  char pos[128], info[80], tmp[256];
+  char info[80], tmp[256];
   char *ap;
   int ver, len;
 
@@ -296,13 +294,6 @@ int AprsUdpClient::buildSdesPacket(char *p)
   time(&update);
   gmtime_r(&update, &utc);
 
-    // Geographic position
-  sprintf(pos, "%02d%02d.%02d%cE%03d%02d.%02d%c",
-               loc_cfg.lat_pos.deg, loc_cfg.lat_pos.min,
-               (loc_cfg.lat_pos.sec * 100) / 60, loc_cfg.lat_pos.dir,
-               loc_cfg.lon_pos.deg, loc_cfg.lon_pos.min,
-               (loc_cfg.lon_pos.sec * 100) / 60, loc_cfg.lon_pos.dir);
-
     // Set SDES version/misc data
   ver = (RTP_VERSION << 14) | RTCP_SDES | (1 << 8);
   p[0] = ver >> 8;
@@ -318,13 +309,11 @@ int AprsUdpClient::buildSdesPacket(char *p)
   ap = p + 8;
 
   *ap++ = RTCP_SDES_CNAME;
-  sprintf(tmp, "%s-%s/%d", loc_cfg.mycall.c_str(), loc_cfg.prefix.c_str(),
-                           getPasswd(loc_cfg.mycall));
-  addText(ap, tmp);
+  addText(ap, cname.c_str());
 
   *ap++ = RTCP_SDES_LOC;
   sprintf(tmp, ")EL-%.6s!%s0PHG%d%d%d%d/%06d/%03d%6s%02d%02d\r\n",
-               loc_cfg.mycall.c_str(), pos,
+               loc_cfg.mycall.c_str(), pos.c_str(),
                getPowerParam(), getHeightParam(), getGainParam(),
                getDirectionParam(), loc_cfg.frequency, getToneParam(),
                info, utc.tm_hour, utc.tm_min);
@@ -124,6 +124,7 @@ class AprsUdpClient : public AprsClient, public sigc::trackable
        const std::string& info, std::list<std::string>& call_list);
      void update3rdState(const std::string& call, const std::string& info);
      void igateMessage(const std::string& info) {}
+     void sendBeacon(void);
 
   private:
     LocationInfo::Cfg	&loc_cfg;
@@ -132,14 +133,17 @@ class AprsUdpClient : public AprsClient, public sigc::trackable
     Async::UdpSocket	sock;
     Async::IpAddress	ip_addr;
     Async::DnsLookup	*dns;
-    Async::Timer        *beacon_timer;
+    bool		is_active;
+    time_t		last_sent;
+    std::string		cname;
+    std::string		pos;
 
     EchoLink::StationData::Status	curr_status;
 
     int			num_connected;
     std::string		curr_call;
 
-    void  sendLocationInfo(Async::Timer *t = 0);
+    void  sendLocationInfo(void);
     void  dnsResultsReady(Async::DnsLookup &dns_lookup);
 
     int   buildSdesPacket(char *p);
@@ -32,6 +32,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
@@ -168,6 +169,8 @@ bool LocationInfo::initialize(const Async::Config &cfg, const std::string &cfg_n
 
   LocationInfo::_instance->loc_cfg.mycall  = value;
   LocationInfo::_instance->loc_cfg.comment = cfg.getValue(cfg_name, "COMMENT");
+  cfg.getValue(cfg_name, "APRS_FILTER", LocationInfo::_instance->loc_cfg.filter,
+               true);
 
   init_ok &= LocationInfo::_instance->parsePosition(cfg, cfg_name);
   init_ok &= LocationInfo::_instance->parseStationHW(cfg, cfg_name);
@@ -182,6 +185,7 @@ bool LocationInfo::initialize(const Async::Config &cfg, const std::string &cfg_n
   }
   LocationInfo::_instance->sinterval = iv;
   LocationInfo::_instance->startStatisticsTimer(iv*60000);
+  LocationInfo::_instance->startBeaconTimer();
 
   value = cfg.getValue(cfg_name, "PTY_PATH");
   LocationInfo::_instance->initExtPty(value);
@@ -611,19 +615,50 @@ void LocationInfo::startStatisticsTimer(int interval) {
 } /* LocationInfo::statStatisticsTimer */
 
 
+void LocationInfo::startBeaconTimer(void)
+{
+  if (clients.empty())
+  {
+    return;
+  }
+
+    // One timer for all clients. The beacons are spread evenly over the
+    // beacon interval instead of all clients sending at the same time.
+  delete beacon_timer;
+  unsigned slot_interval =
+    max(loc_cfg.interval / static_cast<unsigned>(clients.size()), 1U);
+  beacon_timer = new Timer(slot_interval, Timer::TYPE_PERIODIC);
+  beacon_timer->expired.connect(mem_fun(*this, &LocationInfo::sendNextBeacon));
+  next_beacon_client = clients.begin();
+} /* LocationInfo::startBeaconTimer */
+
+
+void LocationInfo::sendNextBeacon(Timer *t)
+{
+  (*next_beacon_client)->sendBeacon();
+  if (++next_beacon_client == clients.end())
+  {
+    next_beacon_client = clients.begin();
+  }
+} /* LocationInfo::sendNextBeacon */
+
+
 void LocationInfo::sendAprsStatistics(Timer *t)
 {
   char info[255];
-  info[0] ='\0';
-  string head ="UNIT.RX Erlang,TX Erlang,RXcount/10m,TXcount/10m,none1,STxxxxxx,logic";
 
-  sprintf(info, "E%s-%s>RXTLM-1,TCPIP,qAR,%s::E%s-%-6s:%s\n",
-       loc_cfg.prefix.c_str(), loc_cfg.mycall.c_str(), loc_cfg.mycall.c_str(),
-       loc_cfg.prefix.c_str(), loc_cfg.mycall.c_str(), head.c_str());
+    // The header is the same each time
+  if (aprs_stats_head.empty())
+  {
+    string head ="UNIT.RX Erlang,TX Erlang,RXcount/10m,TXcount/10m,none1,STxxxxxx,logic";
+    sprintf(info, "E%s-%s>RXTLM-1,TCPIP,qAR,%s::E%s-%-6s:%s\n",
+         loc_cfg.prefix.c_str(), loc_cfg.mycall.c_str(), loc_cfg.mycall.c_str(),
+         loc_cfg.prefix.c_str(), loc_cfg.mycall.c_str(), head.c_str());
+    aprs_stats_head = info;
+  }
 
-   // sends the Aprs stats header
-  string message = info;
-  igateMessage(message);
+    // The header and the statistics for all logics are sent in one batch
+  string message = aprs_stats_head;
 
   struct timeval tv;
   gettimeofday(&tv, NULL);
@@ -655,10 +690,7 @@ void LocationInfo::sendAprsStatistics(Timer *t)
       (*it).second.tx_on_nr, ((*it).second.squelch_on ? 1 : 0),
       ((*it).second.tx_on ? 1 : 0), (*it).first.c_str());
 
-    // sends the Aprs stats information
-    message = info;
-    //cout << message;
-    igateMessage(message);
+    message += info;
 
      // reset statistics if needed
     (*it).second.reset();
@@ -680,6 +712,10 @@ void LocationInfo::sendAprsStatistics(Timer *t)
       sequence = 0;
     }
   }
+
+    // sends the Aprs stats information
+  //cout << message;
+  igateMessage(message);
 } /* LocationInfo::sendAprsStatistics */
 
 
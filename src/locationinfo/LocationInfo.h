@@ -173,7 +173,7 @@ class LocationInfo
     {
       Cfg() : interval(600000), frequency(0), power(0), tone(0), height(10),
               gain(0), beam_dir(-1), range(0), range_unit('m'), lat_pos('N'),
-              lon_pos('E') {};
+              lon_pos('E'), filter("m/10") {};
 
       unsigned int interval;
       unsigned int frequency;
@@ -192,6 +192,7 @@ class LocationInfo
       std::string prefix;
       std::string path;
       std::string comment;
+      std::string filter;
     };
 
     static bool initialize(const Async::Config &cfg, const std::string &cfg_name);
@@ -208,9 +209,14 @@ class LocationInfo
 
   private:
     static LocationInfo* _instance;
-    LocationInfo() : sequence(0), aprs_stats_timer(0), sinterval(0) {}
+    LocationInfo() : sequence(0), aprs_stats_timer(0), sinterval(0),
+                     beacon_timer(0) {}
     LocationInfo(const LocationInfo&);
-    ~LocationInfo(void) { delete aprs_stats_timer; };
+    ~LocationInfo(void)
+    {
+      delete aprs_stats_timer;
+      delete beacon_timer;
+    }
 
     typedef std::list<AprsClient*> ClientList;
 
@@ -219,6 +225,9 @@ class LocationInfo
     int         sequence;
     Async::Timer *aprs_stats_timer;
     unsigned int sinterval;
+    Async::Timer *beacon_timer;
+    ClientList::iterator next_beacon_client;
+    std::string  aprs_stats_head;
 
     bool parsePosition(const Async::Config &cfg, const std::string &name);
     bool parseLatitude(Coordinate &pos, const std::string &value);
@@ -232,6 +241,8 @@ class LocationInfo
     bool parseClients(const Async::Config &cfg, const std::string &name);
     void startStatisticsTimer(int interval);
     void sendAprsStatistics(Async::Timer *t);
+    void startBeaconTimer(void);
+    void sendNextBeacon(Async::Timer *t);
     void initExtPty(std::string ptydevice);
     void mesReceived(std::string message);
 
@@ -0,0 +1,338 @@
+/**
+@file	 BenchUtil.h
+@brief   Helpers shared by the benchmark programs
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains the latency histogram, the traffic statistics and the
+process CPU and memory sampler used by the benchmark programs.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef BENCH_UTIL_INCLUDED
+#define BENCH_UTIL_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace SvxLink
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+/**
+ * @brief   Read the monotonic clock
+ * @return  Returns the current time in microseconds
+ */
+inline uint64_t benchNowUs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+} /* benchNowUs */
+
+
+/**
+ * @brief   Read the CPU time used by the process
+ * @return  Returns the CPU time in microseconds
+ *
+ * Time spent waiting, like for a timer to expire in a main loop, is not
+ * included.
+ */
+inline uint64_t benchCpuTimeUs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+} /* benchCpuTimeUs */
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+ * A latency histogram with a resolution of 0.1ms
+ */
+class LatencyHistogram
+{
+  public:
+    static const unsigned BUCKET_US = 100;
+    static const unsigned BUCKETS   = 20000; // Up to two seconds
+
+    LatencyHistogram(void) : m_buckets(BUCKETS + 1, 0) { reset(); }
+
+    void reset(void)
+    {
+      std::fill(m_buckets.begin(), m_buckets.end(), 0);
+      m_count = 0;
+      m_max_us = 0;
+    }
+
+    void add(uint64_t us)
+    {
+      m_buckets[std::min<uint64_t>(us / BUCKET_US, BUCKETS)] += 1;
+      m_count += 1;
+      m_max_us = std::max(m_max_us, us);
+    }
+
+    uint64_t count(void) const { return m_count; }
+
+    double percentileMs(double p) const
+    {
+      if (m_count == 0)
+      {
+        return 0.0;
+      }
+      uint64_t limit = static_cast<uint64_t>(p / 100.0 * m_count);
+      uint64_t sum = 0;
+      for (size_t i=0; i<m_buckets.size(); ++i)
+      {
+        sum += m_buckets[i];
+        if (sum > limit)
+        {
+          return (i + 1) * BUCKET_US / 1000.0;
+        }
+      }
+      return maxMs();
+    }
+
+    double maxMs(void) const { return m_max_us / 1000.0; }
+
+    void merge(const LatencyHistogram& other)
+    {
+      for (size_t i=0; i<m_buckets.size(); ++i)
+      {
+        m_buckets[i] += other.m_buckets[i];
+      }
+      m_count += other.m_count;
+      m_max_us = std::max(m_max_us, other.m_max_us);
+    }
+
+  private:
+    std::vector<uint64_t> m_buckets;
+    uint64_t              m_count;
+    uint64_t              m_max_us;
+}; /* LatencyHistogram */
+
+
+/**
+ * The traffic counters common to all benchmarks. A benchmark that need more
+ * counters inherit this struct and extend reset and merge.
+ */
+struct BenchStats
+{
+  uint64_t          frames_tx;
+  uint64_t          frames_rx;
+  uint64_t          disconnects;
+  LatencyHistogram  latency;
+
+  BenchStats(void) { reset(); }
+
+  void reset(void)
+  {
+    frames_tx = frames_rx = disconnects = 0;
+    latency.reset();
+  }
+
+  void merge(const BenchStats& other)
+  {
+    frames_tx += other.frames_tx;
+    frames_rx += other.frames_rx;
+    disconnects += other.disconnects;
+    latency.merge(other.latency);
+  }
+}; /* BenchStats */
+
+
+/**
+ * Sample CPU and memory usage for a process from /proc
+ */
+class ProcSampler
+{
+  public:
+    ProcSampler(pid_t pid=0)
+      : m_pid(pid), m_last_ticks(0), m_last_time_us(0),
+        m_ticks_per_s(sysconf(_SC_CLK_TCK)) {}
+
+    bool isValid(void) const { return m_pid > 0; }
+
+    bool cpuTicks(uint64_t& ticks) const
+    {
+      std::ostringstream path;
+      path << "/proc/" << m_pid << "/stat";
+      std::ifstream is(path.str().c_str());
+      std::string line;
+      if (!std::getline(is, line))
+      {
+        return false;
+      }
+        // The command name may contain spaces so start after the last ')'
+      size_t pos = line.rfind(')');
+      if (pos == std::string::npos)
+      {
+        return false;
+      }
+      std::istringstream ss(line.substr(pos + 2));
+      std::string field;
+      for (int i=3; i<14; ++i)
+      {
+        ss >> field;
+      }
+      uint64_t utime = 0, stime = 0;
+      ss >> utime >> stime;
+      ticks = utime + stime;
+      return !ss.fail();
+    }
+
+    bool rssKb(uint64_t& kb) const
+    {
+      std::ostringstream path;
+      path << "/proc/" << m_pid << "/status";
+      std::ifstream is(path.str().c_str());
+      std::string line;
+      while (std::getline(is, line))
+      {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+        {
+          std::istringstream ss(line.substr(6));
+          ss >> kb;
+          return !ss.fail();
+        }
+      }
+      return false;
+    }
+
+      // Return the CPU usage in percent of one core since the last call
+    double cpuPercent(void)
+    {
+      uint64_t ticks = 0;
+      if (!cpuTicks(ticks))
+      {
+        return 0.0;
+      }
+      uint64_t t = benchNowUs();
+      double pct = 0.0;
+      if (m_last_time_us > 0)
+      {
+        double dt = (t - m_last_time_us) / 1000000.0;
+        pct = 100.0 * (ticks - m_last_ticks) / m_ticks_per_s / dt;
+      }
+      m_last_ticks = ticks;
+      m_last_time_us = t;
+      return pct;
+    }
+
+  private:
+    pid_t     m_pid;
+    uint64_t  m_last_ticks;
+    uint64_t  m_last_time_us;
+    long      m_ticks_per_s;
+}; /* ProcSampler */
+
+
+} /* namespace */
+
+#endif /* BENCH_UTIL_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
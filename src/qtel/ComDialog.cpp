@@ -68,6 +68,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioSplitter.h>
 #include <AsyncAudioInterpolator.h>
 #include <AsyncAudioDecimator.h>
+#include <AsyncAudioMultirateCoeffs.h>
 
 
 /****************************************************************************
@@ -79,7 +80,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "MyMessageBox.h"
 #include "Settings.h"
 #include "ComDialog.h"
-#include "multirate_filter_coeff.h"
 
 
 
@@ -307,7 +307,13 @@ void ComDialog::init(const QString& remote_name)
   AudioSource *prev_src = 0;
   rem_audio_fifo = new AudioFifo(INTERNAL_SAMPLE_RATE);
   rem_audio_fifo->setOverwrite(true);
-  rem_audio_fifo->setPrebufSamples(1280 * INTERNAL_SAMPLE_RATE / 8000);
+    // Prebuffer two EchoLink packets, or one in low latency mode
+  int prebuf_samples = 1280 * INTERNAL_SAMPLE_RATE / 8000;
+  if (Settings::instance()->lowLatency())
+  {
+    prebuf_samples /= 2;
+  }
+  rem_audio_fifo->setPrebufSamples(prebuf_samples);
   prev_src = rem_audio_fifo;
   
   rem_audio_valve = new AudioValve;
@@ -37,7 +37,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <algorithm>
 #include <iostream>
 
-#include <QtAlgorithms>
 #include <QtGlobal>
 
 
@@ -92,6 +91,7 @@ using namespace EchoLink;
  *
  ****************************************************************************/
 
+static bool station_ptr_less(const StationData *lhs, const StationData *rhs);
 
 
 /****************************************************************************
@@ -133,90 +133,67 @@ EchoLinkDirectoryModel::~EchoLinkDirectoryModel(void)
 void EchoLinkDirectoryModel::updateStationList(
 				    const list<StationData> &stn_list)
 {
-#if QT_VERSION >= 0x050e00
-  QList<StationData> updated_stations(stn_list.begin(), stn_list.end());
-  std::stable_sort(updated_stations.begin(), updated_stations.end());
-#else
-  QList<StationData> updated_stations =
-      QList<StationData>::fromStdList(stn_list);
-  qStableSort(updated_stations);
-#endif
-  
-  //cout << "### updated_stations=" << updated_stations.count() << endl;  
+    // Sort pointers to the stations so that only the stations that are
+    // inserted into the model have to be copied
+  vector<const StationData*> updated_stations;
+  updated_stations.reserve(stn_list.size());
+  list<StationData>::const_iterator it;
+  for (it=stn_list.begin(); it!=stn_list.end(); ++it)
+  {
+    updated_stations.push_back(&(*it));
+  }
+  std::stable_sort(updated_stations.begin(), updated_stations.end(),
+                   station_ptr_less);
   
+    // Merge the sorted lists. Runs of inserted or removed stations are
+    // handled as one change so that the views do not have to relayout
+    // once per row.
+  size_t pos = 0;
   int row = 0;
-  while (!updated_stations.isEmpty() && (row < stations.count()))
+  while ((pos < updated_stations.size()) && (row < stations.count()))
   {
-    const StationData &updated_stn = updated_stations.first();
-    StationData &stn = stations[row];
+    const StationData &updated_stn = *updated_stations[pos];
+    const StationData &stn = stations.at(row);
     if (updated_stn.callsign() == stn.callsign())
     {
-      if (updated_stn.description() != stn.description())
-      {
-	QModelIndex stn_index = index(row, 1);
-	stn.setDescription(updated_stn.description());
-	dataChanged(stn_index, stn_index);
-      }
-      if (updated_stn.status() != stn.status())
-      {
-	QModelIndex stn_index = index(row, 2);
-	stn.setStatus(updated_stn.status());
-	dataChanged(stn_index, stn_index);
-      }
-      if (updated_stn.time() != stn.time())
-      {
-	QModelIndex stn_index = index(row, 3);
-	stn.setTime(updated_stn.time());
-	dataChanged(stn_index, stn_index);
-      }
-      if (updated_stn.id() != stn.id())
-      {
-	QModelIndex stn_index = index(row, 4);
-	stn.setId(updated_stn.id());
-	dataChanged(stn_index, stn_index);
-      }
-      if (updated_stn.ip() != stn.ip())
-      {
-	QModelIndex stn_index = index(row, 5);
-	stn.setIp(updated_stn.ip());
-	dataChanged(stn_index, stn_index);
-      }
+      updateRow(row, updated_stn);
       row += 1;
-      updated_stations.removeFirst();
+      pos += 1;
     }
     else if (updated_stn.callsign() < stn.callsign())
     {
-      //cout << "### Inserting 1 row starting at row " << row << endl;
-      beginInsertRows(QModelIndex(), row, row);
-      stations.insert(row, updated_stn);
-      endInsertRows();
-      row += 1;
-      updated_stations.removeFirst();
+      size_t end = pos + 1;
+      while ((end < updated_stations.size()) &&
+             (updated_stations[end]->callsign() < stn.callsign()))
+      {
+        end += 1;
+      }
+      insertStations(row, updated_stations, pos, end);
+      row += end - pos;
+      pos = end;
     }
     else
     {
-      removeRows(row, 1);
+      int end = row + 1;
+      while ((end < stations.count()) &&
+             (stations.at(end).callsign() < updated_stn.callsign()))
+      {
+        end += 1;
+      }
+      removeRows(row, end - row);
     }
   }
   
-  if (!updated_stations.isEmpty())
+  if (pos < updated_stations.size())
   {
-    int first = stations.count();
-    int last = stations.count()+updated_stations.count()-1;
-    //cout << "### Inserting " << last-first+1 << " rows starting at row " << row << endl;
-    beginInsertRows(QModelIndex(), first, last);
-    //stations.append(updated_stations);
-    copy(updated_stations.begin(), updated_stations.end(),
-         back_inserter(stations));
-    endInsertRows();
+    insertStations(stations.count(), updated_stations, pos,
+                   updated_stations.size());
   }
   else if (row < stations.count())
   {
     removeRows(row, stations.count()-row);
   }
   
-  //cout << "### stations=" << rowCount() << endl;
-  
 } /* EchoLinkDirectoryModel::updateStationList */
 
 
@@ -362,6 +339,72 @@ bool EchoLinkDirectoryModel::removeRows(int row, int count,
  *
  ****************************************************************************/
 
+void EchoLinkDirectoryModel::updateRow(int row, const StationData &updated_stn)
+{
+  StationData &stn = stations[row];
+  int first = columnCount();
+  int last = -1;
+  if (updated_stn.description() != stn.description())
+  {
+    stn.setDescription(updated_stn.description());
+    first = min(first, 1);
+    last = max(last, 1);
+  }
+  if (updated_stn.status() != stn.status())
+  {
+    stn.setStatus(updated_stn.status());
+    first = min(first, 2);
+    last = max(last, 2);
+  }
+  if (updated_stn.time() != stn.time())
+  {
+    stn.setTime(updated_stn.time());
+    first = min(first, 3);
+    last = max(last, 3);
+  }
+  if (updated_stn.id() != stn.id())
+  {
+    stn.setId(updated_stn.id());
+    first = min(first, 4);
+    last = max(last, 4);
+  }
+  if (updated_stn.ip() != stn.ip())
+  {
+    stn.setIp(updated_stn.ip());
+    first = min(first, 5);
+    last = max(last, 5);
+  }
+  if (last >= first)
+  {
+    dataChanged(index(row, first), index(row, last));
+  }
+} /* EchoLinkDirectoryModel::updateRow */
+
+
+void EchoLinkDirectoryModel::insertStations(int row,
+    const vector<const StationData*> &stns, size_t begin, size_t end)
+{
+  beginInsertRows(QModelIndex(), row, row + (end - begin) - 1);
+  for (size_t i=begin; i<end; ++i)
+  {
+    stations.insert(row + (i - begin), *stns[i]);
+  }
+  endInsertRows();
+} /* EchoLinkDirectoryModel::insertStations */
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static bool station_ptr_less(const StationData *lhs, const StationData *rhs)
+{
+  return *lhs < *rhs;
+} /* station_ptr_less */
+
+
 
 
 /*
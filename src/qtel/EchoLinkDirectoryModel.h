@@ -41,6 +41,8 @@ An example of how to use the EchoLinkDirectoryModel class
  *
  ****************************************************************************/
 
+#include <vector>
+
 #include <QList>
 #include <QAbstractItemModel>
 
@@ -162,6 +164,10 @@ class EchoLinkDirectoryModel : public QAbstractItemModel
     
     EchoLinkDirectoryModel(const EchoLinkDirectoryModel&);
     EchoLinkDirectoryModel& operator=(const EchoLinkDirectoryModel&);
+    void updateRow(int row, const EchoLink::StationData &updated_stn);
+    void insertStations(int row,
+                        const std::vector<const EchoLink::StationData*> &stns,
+                        size_t begin, size_t end);
     
 };  /* class EchoLinkDirectoryModel */
 
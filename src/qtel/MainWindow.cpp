@@ -49,6 +49,14 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <QInputDialog>
 #include <QSplitter>
 #include <QCloseEvent>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#if QT_VERSION >= 0x050000
+#include <QStandardPaths>
+#endif
 #undef emit
 
 
@@ -60,6 +68,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncIpAddress.h>
 #include <AsyncAudioInterpolator.h>
+#include <AsyncAudioMultirateCoeffs.h>
 #include <EchoLinkDirectory.h>
 #include <EchoLinkProxy.h>
 #include <common.h>
@@ -78,7 +87,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "MainWindow.h"
 #include "MsgHandler.h"
 #include "EchoLinkDirectoryModel.h"
-#include "multirate_filter_coeff.h"
 
 
 /****************************************************************************
@@ -131,6 +139,10 @@ using namespace EchoLink;
  *
  ****************************************************************************/
 
+  // Identify the binary directory cache file format. The version must be
+  // increased when the record layout is changed.
+static const quint32 DIRECTORY_CACHE_MAGIC = 0x51444331;  // "QDC1"
+static const quint32 DIRECTORY_CACHE_VERSION = 1;
 
 
 /****************************************************************************
@@ -234,6 +246,7 @@ MainWindow::MainWindow(void)
   link_model = new EchoLinkDirectoryModel(this);
   repeater_model = new EchoLinkDirectoryModel(this);
   station_model = new EchoLinkDirectoryModel(this);
+  loadDirectoryCache();
   updateBookmarkModel();
   station_view_selector->setCurrentRow(0);
 
@@ -473,23 +486,34 @@ void MainWindow::initMsgAudioIo(void)
 void MainWindow::setupAudioParams(void)
 {
   int rate = Settings::instance()->cardSampleRate();
+  int blocksize = 0;
+  int block_count = 2;
   if (rate == 48000)
   {
-    AudioIO::setBlocksize(1024);
-    AudioIO::setBlockCount(4);
+    blocksize = 1024;
+    block_count = 4;
   }
   else if (rate == 16000)
   {
-    AudioIO::setBlocksize(512);
-    AudioIO::setBlockCount(2);
+    blocksize = 512;
   }
 #if INTERNAL_SAMPLE_RATE <= 8000
   else if (rate == 8000)
   {
-    AudioIO::setBlocksize(256);
-    AudioIO::setBlockCount(2);
+    blocksize = 256;
   }
 #endif
+  if (blocksize > 0)
+  {
+      // Use a quarter of the normal block size in low latency mode
+    if (Settings::instance()->lowLatency())
+    {
+      blocksize /= 4;
+      block_count = 2;
+    }
+    AudioIO::setBlocksize(blocksize);
+    AudioIO::setBlockCount(block_count);
+  }
   AudioIO::setSampleRate(rate);
   AudioIO::setChannels(1);
 } /* MainWindow::setupAudioParams */
@@ -575,6 +599,124 @@ void MainWindow::updateBookmarkModel(void)
 
 
 
+QString MainWindow::directoryCacheFile(void) const
+{
+#if QT_VERSION >= 0x050000
+  QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+#else
+  QString dir = QDir::homePath() + "/.qtel";
+#endif
+  return dir + "/directory_cache";
+} /* MainWindow::directoryCacheFile */
+
+
+void MainWindow::loadDirectoryCache(void)
+{
+    // The station list from the last run is shown until the first refresh
+    // from the directory server. The refresh is then applied as a change to
+    // the cached list.
+  QFile file(directoryCacheFile());
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_4_6);
+  quint32 magic = 0;
+  quint32 version = 0;
+  in >> magic >> version;
+  if ((magic != DIRECTORY_CACHE_MAGIC) || (version != DIRECTORY_CACHE_VERSION))
+  {
+    return;
+  }
+
+  list<StationData> lists[4];
+  for (unsigned list_idx=0; list_idx<4; ++list_idx)
+  {
+    quint32 count = 0;
+    in >> count;
+    for (quint32 i=0; (i<count) && (in.status() == QDataStream::Ok); ++i)
+    {
+      QByteArray callsign, time, desc, ip;
+      qint8 status;
+      qint32 id;
+      in >> callsign >> status >> time >> desc >> id >> ip;
+      StationData stn;
+      stn.setCallsign(callsign.constData());
+      stn.setStatus(static_cast<StationData::Status>(status));
+      stn.setTime(time.constData());
+      stn.setDescription(desc.constData());
+      stn.setId(id);
+      stn.setIp(Async::IpAddress(ip.constData()));
+      lists[list_idx].push_back(stn);
+    }
+  }
+  if (in.status() != QDataStream::Ok)
+  {
+    return;
+  }
+
+  conf_model->updateStationList(lists[0]);
+  link_model->updateStationList(lists[1]);
+  repeater_model->updateStationList(lists[2]);
+  station_model->updateStationList(lists[3]);
+
+  QDateTime cache_time = QFileInfo(file).lastModified();
+  statusBar()->showMessage(
+      tr("Showing the station list from %1").arg(cache_time.toString()),
+      5000);
+} /* MainWindow::loadDirectoryCache */
+
+
+void MainWindow::saveDirectoryCache(void)
+{
+  const QString filename = directoryCacheFile();
+  QDir().mkpath(QFileInfo(filename).path());
+
+    // Write to a temporary file first so that a crash while writing does
+    // not leave a truncated cache behind
+  const QString tmp_filename = filename + ".new";
+  QFile file(tmp_filename);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    return;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_4_6);
+  out << DIRECTORY_CACHE_MAGIC << DIRECTORY_CACHE_VERSION;
+
+  const list<StationData> *lists[4] =
+  {
+    &dir->conferences(), &dir->links(), &dir->repeaters(), &dir->stations()
+  };
+  for (unsigned list_idx=0; list_idx<4; ++list_idx)
+  {
+    out << static_cast<quint32>(lists[list_idx]->size());
+    list<StationData>::const_iterator it;
+    for (it=lists[list_idx]->begin(); it!=lists[list_idx]->end(); ++it)
+    {
+      out << QByteArray(it->callsign().c_str())
+          << static_cast<qint8>(it->status())
+          << QByteArray(it->time().c_str())
+          << QByteArray(it->description().c_str())
+          << static_cast<qint32>(it->id())
+          << QByteArray(it->ipStr().c_str());
+    }
+  }
+  if ((out.status() != QDataStream::Ok) || !file.flush())
+  {
+    file.close();
+    QFile::remove(tmp_filename);
+    return;
+  }
+  file.close();
+  QFile::remove(filename);
+  QFile::rename(tmp_filename, filename);
+} /* MainWindow::saveDirectoryCache */
+
+
 void MainWindow::stationViewSelectorCurrentItemChanged(QListWidgetItem *current,
 						       QListWidgetItem *previous
 						      )
@@ -658,6 +800,7 @@ void MainWindow::callsignListUpdated(void)
   link_model->updateStationList(dir->links());
   repeater_model->updateStationList(dir->repeaters());
   station_model->updateStationList(dir->stations());
+  saveDirectoryCache();
   
   statusBar()->showMessage(tr("Station list has been refreshed"), 5000);
   
@@ -196,6 +196,9 @@ class MainWindow : public QMainWindow, private Ui::MainWindowBase,
     void setupAudioParams(void);
     void initEchoLink(void);
     void updateBookmarkModel(void);
+    QString directoryCacheFile(void) const;
+    void loadDirectoryCache(void);
+    void saveDirectoryCache(void);
     
   private slots:
     void stationViewSelectorCurrentItemChanged(QListWidgetItem *current,
@@ -103,6 +103,7 @@ using namespace std;
 #define CONF_MIC_AUDIO_DEVICE         "MicAudioDevice"
 #define CONF_SPKR_AUDIO_DEVICE        "SpkrAudioDevice"
 #define CONF_USE_FULL_DUPLEX          "UseFullDuplex"
+#define CONF_LOW_LATENCY              "LowLatency"
 #define CONF_CONNECT_SOUND            "ConnectSound"
 #define CONF_CARD_SAMPLE_RATE         "CardSampleRate"
 
@@ -134,6 +135,7 @@ using namespace std;
 
 #define CONF_AUDIO_DEVICE_DEFAULT 	"alsa:default"
 #define CONF_USE_FULL_DUPLEX_DEFAULT    false
+#define CONF_LOW_LATENCY_DEFAULT        false
 #define CONF_CONNECT_SOUND_DEFAULT 	SHARE_INSTALL_PREFIX \
                                         "/qtel/sounds/connect.raw"
 #define CONF_CARD_SAMPLE_RATE_DEFAULT   48000
@@ -219,6 +221,7 @@ Settings::Settings(void)
     m_proxy_enabled(CONF_PROXY_ENABLED_DEFAULT),
     m_proxy_port(CONF_PROXY_PORT_DEFAULT),
     m_use_full_duplex(CONF_USE_FULL_DUPLEX_DEFAULT),
+    m_low_latency(CONF_LOW_LATENCY_DEFAULT),
     m_card_sample_rate(CONF_CARD_SAMPLE_RATE_DEFAULT),
     m_chat_encoding(0),
     m_vox_enabled(CONF_VOX_ENABLED_DEFAULT),
@@ -336,6 +339,7 @@ void Settings::showDialog(void)
   settings_dialog.mic_audio_device->setText(m_mic_audio_device);
   settings_dialog.spkr_audio_device->setText(m_spkr_audio_device);
   settings_dialog.use_full_duplex->setChecked(m_use_full_duplex);
+  settings_dialog.low_latency->setChecked(m_low_latency);
   settings_dialog.connect_sound->setText(m_connect_sound);
   QString card_sample_rate_str = QString::number(m_card_sample_rate);
   int card_sample_rate_idx =
@@ -397,6 +401,7 @@ void Settings::showDialog(void)
 	m_mic_audio_device = settings_dialog.mic_audio_device->text();
 	m_spkr_audio_device = settings_dialog.spkr_audio_device->text();
 	m_use_full_duplex = settings_dialog.use_full_duplex->isChecked();
+	m_low_latency = settings_dialog.low_latency->isChecked();
 	m_connect_sound = settings_dialog.connect_sound->text();
         m_card_sample_rate =
                 settings_dialog.card_sample_rate->currentText().toInt();
@@ -422,6 +427,7 @@ void Settings::showDialog(void)
 	qsettings.setValue(CONF_MIC_AUDIO_DEVICE, m_mic_audio_device);
 	qsettings.setValue(CONF_SPKR_AUDIO_DEVICE, m_spkr_audio_device);
 	qsettings.setValue(CONF_USE_FULL_DUPLEX, m_use_full_duplex);
+	qsettings.setValue(CONF_LOW_LATENCY, m_low_latency);
 	qsettings.setValue(CONF_CONNECT_SOUND, m_connect_sound);
 	qsettings.setValue(CONF_CARD_SAMPLE_RATE, m_card_sample_rate);
       	
@@ -473,6 +479,8 @@ void Settings::readSettings(void)
       CONF_AUDIO_DEVICE_DEFAULT).toString();
   m_use_full_duplex = qsettings.value(CONF_USE_FULL_DUPLEX,
       CONF_USE_FULL_DUPLEX_DEFAULT).toBool();
+  m_low_latency = qsettings.value(CONF_LOW_LATENCY,
+      CONF_LOW_LATENCY_DEFAULT).toBool();
   m_connect_sound = qsettings.value(CONF_CONNECT_SOUND,
       CONF_CONNECT_SOUND_DEFAULT).toString();
   m_card_sample_rate = qsettings.value(CONF_CARD_SAMPLE_RATE,
@@ -165,6 +165,7 @@ class Settings : public sigc::trackable
     const QString& micAudioDevice(void) const { return m_mic_audio_device; }
     const QString& spkrAudioDevice(void) const { return m_spkr_audio_device; }
     bool useFullDuplex(void) const { return m_use_full_duplex; }
+    bool lowLatency(void) const { return m_low_latency; }
     const QString& connectSound(void) const { return m_connect_sound; }
     int cardSampleRate(void) const { return m_card_sample_rate; }
     
@@ -232,6 +233,7 @@ class Settings : public sigc::trackable
     QString   	            m_mic_audio_device;
     QString   	            m_spkr_audio_device;
     bool      	            m_use_full_duplex;
+    bool                    m_low_latency;
     QString   	            m_connect_sound;
     int                     m_card_sample_rate;
     
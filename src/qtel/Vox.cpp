@@ -117,7 +117,8 @@ using namespace Async;
 
 Vox::Vox(void)
   : m_threshold(0), m_delay(0), m_vox_timer(0), m_vox_state(IDLE),
-    m_enabled(false)
+    m_enabled(false), m_dc_offset(0.0f), m_sum(0.0f), m_abs_sum(0.0f),
+    m_window_cnt(0), m_level_db(-60)
 {
   m_vox_timer = new QTimer;
   connect(m_vox_timer, SIGNAL(timeout()),
@@ -140,46 +141,16 @@ int Vox::writeSamples(const float *samples, int count)
     return count;
   }
   
-    // Calculate DC offset
-  float dc_offset = 0.0f;
+    // The DC offset measured over the previous window is removed so that
+    // the level can be calculated in one pass
   for (int i=0; i < count; i++)
   {
-    dc_offset += samples[i] / count;
-  }
-
-    // Calculate absolute average level sans offset
-  float avg = 0.0f;
-  for (int i=0; i < count; i++)
-  {
-    float sample = (samples[i] - dc_offset) / count;
-    if (sample > 0)
+    m_sum += samples[i];
+    m_abs_sum += fabsf(samples[i] - m_dc_offset);
+    if (++m_window_cnt == LEVEL_WINDOW_LEN)
     {
-      avg += sample;
+      updateLevel();
     }
-    else
-    {
-      avg -= sample;
-    }
-  }
-
-  int db_level = -60;
-  if (avg > 1.0f)
-  {
-    db_level = 0;
-  }
-  else if (avg > 0.001f)
-  {
-    db_level = (int)(20.0f * log10f(avg));
-  }
-  levelChanged(db_level);
-
-  if (db_level > m_threshold)
-  {
-    setState(ACTIVE);
-  }
-  else if (m_vox_state == ACTIVE)
-  {
-    setState(HANG);
   }
 
   return count;
@@ -222,6 +193,9 @@ void Vox::setEnabled(bool enable)
   m_enabled = enable;
   if (!m_enabled)
   {
+    m_sum = m_abs_sum = 0.0f;
+    m_window_cnt = 0;
+    m_level_db = -60;
     levelChanged(-60);
     setState(IDLE);
   }
@@ -282,6 +256,43 @@ void Vox::setState(State new_state)
 } /* Vox::setState */
 
 
+/**
+ * @brief   Calculate the level for the last window and update the VOX state
+ */
+void Vox::updateLevel(void)
+{
+  m_dc_offset = m_sum / m_window_cnt;
+  float avg = m_abs_sum / m_window_cnt;
+  m_sum = m_abs_sum = 0.0f;
+  m_window_cnt = 0;
+
+  int db_level = -60;
+  if (avg > 1.0f)
+  {
+    db_level = 0;
+  }
+  else if (avg > 0.001f)
+  {
+    db_level = (int)(20.0f * log10f(avg));
+  }
+
+  if (db_level != m_level_db)
+  {
+    m_level_db = db_level;
+    levelChanged(db_level);
+  }
+
+  if (db_level > m_threshold)
+  {
+    setState(ACTIVE);
+  }
+  else if (m_vox_state == ACTIVE)
+  {
+    setState(HANG);
+  }
+} /* Vox::updateLevel */
+
+
 
 /*
  * This file has not been truncated
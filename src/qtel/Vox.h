@@ -110,7 +110,9 @@ class QTimer;
 @date   2008-03-07
 
 This class implements the logic for a voice operated transmission control
-(VOX).
+(VOX). The level is measured over windows of LEVEL_WINDOW_MS so that the
+level calculation, the VOX decision and the level meter update are done at
+a low fixed rate, independent of the size of the incoming audio blocks.
 */
 class Vox : public QObject, public Async::AudioSink
 {
@@ -219,15 +221,25 @@ class Vox : public QObject, public Async::AudioSink
   protected:
     
   private:
+    static const int LEVEL_WINDOW_MS = 20;
+    static const int LEVEL_WINDOW_LEN =
+      LEVEL_WINDOW_MS * INTERNAL_SAMPLE_RATE / 1000;
+
     int  	  m_threshold;
     int       	  m_delay;
     QTimer    	  *m_vox_timer;
     State     	  m_vox_state;
     bool      	  m_enabled;
+    float         m_dc_offset;
+    float         m_sum;
+    float         m_abs_sum;
+    int           m_window_cnt;
+    int           m_level_db;
     
     Vox(const Vox&);
     Vox& operator=(const Vox&);
     void setState(State new_state);
+    void updateLevel(void);
 
 
   private slots:
@@ -41,6 +41,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sys/time.h>
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
 #include <map>
 
 
@@ -50,6 +51,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncApplication.h>
 #include <AsyncCppApplication.h>
 #include <AsyncConfig.h>
 #include <AsyncTimer.h>
@@ -80,6 +82,18 @@ using namespace sigc;
 using namespace NetTrxMsg;
 
 
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The maximum number of bytes to queue for a slow client before it is
+  // disconnected
+#define MAX_TXQ_BYTES   65536
+
+
 /****************************************************************************
  *
  * Public member functions
@@ -180,6 +194,8 @@ void SvxServer::clientConnected(Async::TcpConnection *con)
        << con->remotePort() << endl;
 
   con->dataReceived.connect(mem_fun(*this, &SvxServer::tcpDataReceived));
+  con->sendBufferFull.connect(
+      sigc::bind(mem_fun(*this, &SvxServer::sendBufferFull), con));
 
   pair<const string, uint16_t> key(con->remoteHost().toString(),
                                    con->remotePort());
@@ -190,10 +206,15 @@ void SvxServer::clientConnected(Async::TcpConnection *con)
   clpair.blocked = false;   // node is not blocked as default
   clpair.recv_exp = sizeof(Msg);
   clpair.recv_cnt = 0;
+  clpair.txq_bytes = 0;
   gettimeofday(&clpair.last_msg, NULL);
   gettimeofday(&clpair.sent_msg, NULL);
 
-  clients[key] = clpair;
+    // The map node is never moved so the pointer is valid until the client
+    // is erased
+  Cons &client = clients[key];
+  client = clpair;
+  con_list.push_back(&client);
 
   MsgProtoVer *ver_msg = new MsgProtoVer;
   sendMsg(con, ver_msg);
@@ -202,15 +223,14 @@ void SvxServer::clientConnected(Async::TcpConnection *con)
   {
     MsgAuthOk *auth_ok = new MsgAuthOk;
     sendMsg(con, auth_ok);
-    clpair.state = STATE_VER_WAIT;
+    client.state = STATE_VER_WAIT;
   }
   else
   {
     sendMsg(con, auth_msg);
-    clpair.state = STATE_AUTH_WAIT;
+    client.state = STATE_AUTH_WAIT;
   }
 
-  clients[key] = clpair;
   heartbeat_timer->setEnable(true);
 
 } /* SvxServer::clientConnected */
@@ -253,6 +273,13 @@ void SvxServer::clientDisconnected(Async::TcpConnection *con,
   {
     cout << "-X- removing client " << con->remoteHost() << ":"
          << con->remotePort()  << " from client list" << endl;
+    ConList::iterator lit = find(con_list.begin(), con_list.end(),
+                                 &(*it).second);
+    if (lit != con_list.end())
+    {
+      *lit = con_list.back();
+      con_list.pop_back();
+    }
     clients.erase(it);
   }
 } /* SvxServer::clientDisconnected */
@@ -704,18 +731,16 @@ void SvxServer::hbtimeout(Timer *t)
 
 void SvxServer::sendExcept(Async::TcpConnection *con, Msg *msg)
 {
-
-    // copy map to prevent a segfault by erasing a connection
-    // that exists anymore
-  Clients t_clients = clients;
-  Clients::iterator it;
-
-    // sending data to connected clients without the source client
-  for (it = t_clients.begin(); it != t_clients.end(); it++)
+    // The message is copied into a shared buffer only if some client cannot
+    // take it right away. Failing clients are disconnected later so the
+    // client list cannot change while iterating it.
+  SharedBuf buf;
+  for (ConList::const_iterator it = con_list.begin(); it != con_list.end();
+       ++it)
   {
-    if ((*it).second.con != con)
+    if ((*it)->con != con)
     {
-      sendMsg((*it).second.con, msg);
+      sendMsg(**it, msg, buf);
     }
   }
 } /* SvxServer::sendExcept */
@@ -723,26 +748,134 @@ void SvxServer::sendExcept(Async::TcpConnection *con, Msg *msg)
 
 void SvxServer::sendMsg(Async::TcpConnection *con, Msg *msg)
 {
+  Cons *client = findClient(con);
+  if (client == 0)
+  {
+    return;
+  }
+  SharedBuf buf;
+  sendMsg(*client, msg, buf);
+} /* SvxServer::sendMsg */
 
-  assert(con->isConnected());
-  if (clients.size() < 1)
+
+void SvxServer::sendMsg(Cons &client, const Msg *msg, SharedBuf &buf)
+{
+  Async::TcpConnection *con = client.con;
+  if (!con->isConnected())
   {
     return;
   }
 
-  int written = con->write(msg, msg->size());
-  if (written != static_cast<int>(msg->size()))
+  size_t pos = 0;
+  if (client.txq.empty())
+  {
+    int written = con->write(msg, msg->size());
+    if (written == -1)
+    {
+      cout << "*** ERROR: (" << con->remoteHost() << ":"
+           << con->remotePort() << ") TCP transmit error." << endl;
+      scheduleDisconnect(con);
+      return;
+    }
+    pos = written;
+    if (pos == msg->size())
+    {
+      return;
+    }
+  }
+
+  if (client.txq_bytes + msg->size() - pos > MAX_TXQ_BYTES)
   {
     cout << "*** ERROR: (" << con->remoteHost() << ":"
-         << con->remotePort() << ") TCP transmit "
-         << (written == -1 ? "error." : "buffer overflow.")
-         << endl;
-    con->disconnect();
-    clientDisconnected(con, TcpConnection::DR_ORDERED_DISCONNECT);
+         << con->remotePort() << ") TCP transmit buffer overflow." << endl;
+    scheduleDisconnect(con);
+    return;
   }
+  if (!buf)
+  {
+    const uint8_t *ptr = reinterpret_cast<const uint8_t*>(msg);
+    buf = make_shared<const vector<uint8_t> >(ptr, ptr + msg->size());
+  }
+  client.txq.push_back(TxItem(buf, pos));
+  client.txq_bytes += msg->size() - pos;
 } /* SvxServer::sendMsg */
 
 
+void SvxServer::sendBufferFull(bool is_full, Async::TcpConnection *con)
+{
+  if (is_full)
+  {
+    return;
+  }
+  Cons *client = findClient(con);
+  if (client == 0)
+  {
+    return;
+  }
+  while (!client->txq.empty())
+  {
+    TxItem &item = client->txq.front();
+    size_t len = item.buf->size() - item.pos;
+    int written = con->write(&(*item.buf)[item.pos], len);
+    if (written == -1)
+    {
+      cout << "*** ERROR: (" << con->remoteHost() << ":"
+           << con->remotePort() << ") TCP transmit error." << endl;
+      scheduleDisconnect(con);
+      return;
+    }
+    client->txq_bytes -= written;
+    if (static_cast<size_t>(written) < len)
+    {
+      item.pos += written;
+      return;
+    }
+    client->txq.pop_front();
+  }
+} /* SvxServer::sendBufferFull */
+
+
+SvxServer::Cons *SvxServer::findClient(Async::TcpConnection *con)
+{
+  for (ConList::const_iterator it = con_list.begin(); it != con_list.end();
+       ++it)
+  {
+    if ((*it)->con == con)
+    {
+      return *it;
+    }
+  }
+  return 0;
+} /* SvxServer::findClient */
+
+
+void SvxServer::scheduleDisconnect(Async::TcpConnection *con)
+{
+  con->disconnect();
+  if (disc_pending.empty())
+  {
+    Application::app().runTask(
+        mem_fun(*this, &SvxServer::processDisconnects));
+  }
+  disc_pending.push_back(con);
+} /* SvxServer::scheduleDisconnect */
+
+
+void SvxServer::processDisconnects(void)
+{
+  vector<Async::TcpConnection*> cons;
+  cons.swap(disc_pending);
+  for (vector<Async::TcpConnection*>::iterator it = cons.begin();
+       it != cons.end(); ++it)
+  {
+    if (findClient(*it) != 0)
+    {
+      clientDisconnected(*it, TcpConnection::DR_ORDERED_DISCONNECT);
+    }
+  }
+} /* SvxServer::processDisconnects */
+
+
 bool SvxServer::hasMaster()
 {
   return (master != 0);
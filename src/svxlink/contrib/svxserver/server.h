@@ -34,6 +34,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
 
 /****************************************************************************
@@ -142,6 +149,17 @@ class SvxServer : public sigc::trackable
       STATE_DISC, STATE_VER_WAIT, STATE_AUTH_WAIT, STATE_READY
     } State;
 
+      // A message that is shared between all connections that it is queued on
+    typedef std::shared_ptr<const std::vector<uint8_t> > SharedBuf;
+
+    struct TxItem
+    {
+      SharedBuf buf;
+      size_t    pos;
+
+      TxItem(const SharedBuf& buf, size_t pos) : buf(buf), pos(pos) {}
+    };
+
     struct Cons
     {
       Async::TcpConnection *con;
@@ -159,10 +177,15 @@ class SvxServer : public sigc::trackable
       unsigned  recv_cnt;
       unsigned  recv_exp;
       bool  blocked;
+      std::deque<TxItem> txq;
+      size_t    txq_bytes;
     };
 
     typedef std::map<std::pair<const std::string, uint16_t>, Cons> Clients;
+    typedef std::vector<Cons*> ConList;
     Clients clients;
+    ConList con_list;
+    std::vector<Async::TcpConnection*> disc_pending;
 
     std::string     auth_key;
     NetTrxMsg::MsgAuthChallenge *auth_msg;
@@ -180,6 +203,11 @@ class SvxServer : public sigc::trackable
     int tcpDataReceived(Async::TcpConnection *con, void *data, int size);
     void handleMsg(Async::TcpConnection *con, NetTrxMsg::Msg *msg);
     void sendMsg(Async::TcpConnection *con, NetTrxMsg::Msg *msg);
+    void sendMsg(Cons &client, const NetTrxMsg::Msg *msg, SharedBuf &buf);
+    void sendBufferFull(bool is_full, Async::TcpConnection *con);
+    Cons *findClient(Async::TcpConnection *con);
+    void scheduleDisconnect(Async::TcpConnection *con);
+    void processDisconnects(void);
     void hbtimeout(Async::Timer *t);
     void sqltimeout(Async::Timer *t);
     void sqlresettimeout(Async::Timer *t);
@@ -6,7 +6,7 @@
 
 \verbatim
 SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
-Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -42,6 +42,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <vector>
 #include <algorithm>
 #include <iterator>
+#include <complex>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 
 /****************************************************************************
@@ -55,6 +59,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioSplitter.h>
 #include <AsyncConfig.h>
 #include <AsyncFdWatch.h>
+#include <AsyncTimer.h>
 #include <Tx.h>
 #include <Rx.h>
 #include <common.h>
@@ -97,6 +102,7 @@ using namespace Async;
 #define DEFAULT_HEADROOM_DB   6.0f
 #define DEFAULT_CALDEV        2404.8f
 #define DEFAULT_MAXDEV        5000.0f
+#define DEFAULT_FFT_AVG       4
 
 
 /****************************************************************************
@@ -271,21 +277,13 @@ class FlatTopWindow : public Window
 };
 
 
-class DevPrinter : public AudioSink
+class DevMeter : public AudioSink
 {
   public:
-    DevPrinter(unsigned samp_rate, const vector<float> &mod_fqs,
-               float max_dev=1.0f, float headroom_db=0.0f)
-      : block_size(samp_rate / 20), w(block_size),
-        g(mod_fqs.size()), samp_cnt(0), max_dev(max_dev),
-        headroom(pow(10.0, headroom_db/20.0)), adj_level(1.0f), dev_est(0.0),
-        block_cnt(0), pwr_sum(0.0), tot_dev_est(0.0f), amp_sum(0.0),
-        fqerr_est(0.0), carrier_fq(0.0)
+    DevMeter(float max_dev, float headroom_db)
+      : max_dev(max_dev), headroom(pow(10.0, headroom_db/20.0)),
+        adj_level(1.0f), carrier_fq(0.0)
     {
-      for (size_t i=0; i<mod_fqs.size(); ++i)
-      {
-        g[i].initialize(mod_fqs[i], samp_rate);
-      }
     }
 
     void adjustLevel(double adj_db)
@@ -308,7 +306,54 @@ class DevPrinter : public AudioSink
     }
 
     double carrierFq(void) const { return carrier_fq; }
-    
+
+    virtual void writeIq(const vector<RtlSdr::Sample> &iq) {}
+
+    virtual void flushSamples(void)
+    {
+      sourceAllSamplesFlushed();
+    }
+
+  protected:
+    double scale(void) const { return adj_level * headroom * max_dev; }
+
+    void printDev(double dev, double tot_dev, double fqerr)
+    {
+      cout << "\r\033[K" "Tone dev=" << dev
+           << "  Full bw dev=" << tot_dev
+           << "  Carrier freq err=" << fqerr;
+      if (carrier_fq > 0.0)
+      {
+        int ppm_err =
+          static_cast<int>(round(1000000.0 * fqerr / carrier_fq));
+        cout << "(" << ppm_err << "ppm)";
+      }
+    }
+
+  private:
+    float         max_dev;
+    double        headroom;
+    double        adj_level;
+    double        carrier_fq;
+};
+
+
+class DevPrinter : public DevMeter
+{
+  public:
+    DevPrinter(unsigned samp_rate, const vector<float> &mod_fqs,
+               float max_dev=1.0f, float headroom_db=0.0f)
+      : DevMeter(max_dev, headroom_db), block_size(samp_rate / 20),
+        w(block_size), g(mod_fqs.size()), samp_cnt(0), dev_est(0.0),
+        block_cnt(0), pwr_sum(0.0), tot_dev_est(0.0f), amp_sum(0.0),
+        fqerr_est(0.0)
+    {
+      for (size_t i=0; i<mod_fqs.size(); ++i)
+      {
+        g[i].initialize(mod_fqs[i], samp_rate);
+      }
+    }
+
     virtual int writeSamples(const float *samples, int count)
     {
       for (int i=0; i<count; ++i)
@@ -325,8 +370,7 @@ class DevPrinter : public AudioSink
         {
           double avg_power = pwr_sum / block_size;
           double tot_dev = sqrt(avg_power) * sqrt(2);
-          tot_dev *= adj_level;
-          tot_dev *= headroom * max_dev;
+          tot_dev *= scale();
           tot_dev_est = (1.0-ALPHA) * tot_dev + ALPHA * tot_dev_est;
           pwr_sum = 0.0;
 
@@ -336,27 +380,17 @@ class DevPrinter : public AudioSink
             dev += g[i].magnitudeSquared();
           }
           dev = 2 * sqrt(dev) / block_size;
-          dev *= adj_level;
-          dev *= headroom * max_dev;
+          dev *= scale();
           dev_est = (1.0-ALPHA) * dev + ALPHA * dev_est;
 
           double fqerr = amp_sum / block_size;
-          fqerr *= adj_level;
-          fqerr *= headroom * max_dev;
+          fqerr *= scale();
           amp_sum = 0.0;
           fqerr_est = (1.0-ALPHA) * fqerr + ALPHA * fqerr_est;
 
           if (++block_cnt >= PRINT_INTERVAL)
           {
-            cout << "\r\033[K" "Tone dev=" << dev_est
-                 << "  Full bw dev=" << tot_dev_est 
-                 << "  Carrier freq err=" << fqerr_est;
-            if (carrier_fq > 0.0)
-            {
-              int ppm_err =
-                static_cast<int>(round(1000000.0 * fqerr_est / carrier_fq));
-              cout << "(" << ppm_err << "ppm)";
-            }
+            printDev(dev_est, tot_dev_est, fqerr_est);
             cout.flush();
             block_cnt = 0;
           }
@@ -370,11 +404,6 @@ class DevPrinter : public AudioSink
       return count;
     }
 
-    virtual void flushSamples(void)
-    {
-      sourceAllSamplesFlushed();
-    }
-
   private:
     static CONSTEXPR double ALPHA = 0.9;        //!< IIR filter coeff
     static CONSTEXPR size_t PRINT_INTERVAL = 5; //!< Block count
@@ -383,28 +412,532 @@ class DevPrinter : public AudioSink
     FlatTopWindow w;
     vector<Goertzel> g;
     int           samp_cnt;
-    float         max_dev;
-    double        headroom;
-    double        adj_level;
     double        dev_est;
     size_t        block_cnt;
     double        pwr_sum;
     double        tot_dev_est;
     double        amp_sum;
     double        fqerr_est;
-    double        carrier_fq;
+};
+
+
+class Fft
+{
+  public:
+    typedef complex<float> Complex;
+
+    explicit Fft(size_t N)
+      : N(N), twiddles(N/2), rev(N)
+    {
+      for (size_t k=0; k<N/2; ++k)
+      {
+        twiddles[k] = polar(1.0f, static_cast<float>(-2.0 * M_PI * k / N));
+      }
+      unsigned bits = 0;
+      while ((1U << bits) < N)
+      {
+        ++bits;
+      }
+      for (size_t i=0; i<N; ++i)
+      {
+        size_t r = 0;
+        for (unsigned b=0; b<bits; ++b)
+        {
+          r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        rev[i] = r;
+      }
+    }
+
+    inline size_t size(void) const { return N; }
+
+      // In place radix-2 FFT. The size of x must be N.
+    void transform(vector<Complex> &x) const
+    {
+      for (size_t i=0; i<N; ++i)
+      {
+        if (i < rev[i])
+        {
+          swap(x[i], x[rev[i]]);
+        }
+      }
+      for (size_t len=2; len<=N; len <<= 1)
+      {
+        const size_t half = len / 2;
+        const size_t step = N / len;
+        for (size_t i=0; i<N; i+=len)
+        {
+          for (size_t j=0; j<half; ++j)
+          {
+            const Complex t = twiddles[j*step] * x[i+j+half];
+            x[i+j+half] = x[i+j] - t;
+            x[i+j] += t;
+          }
+        }
+      }
+    }
+
+  private:
+    size_t          N;
+    vector<Complex> twiddles;
+    vector<size_t>  rev;
+};
+
+
+class RealFft
+{
+  public:
+    typedef Fft::Complex Complex;
+
+    explicit RealFft(size_t N)
+      : N(N), fft(N/2), twiddles(N/2+1), z(N/2)
+    {
+      for (size_t k=0; k<=N/2; ++k)
+      {
+        twiddles[k] = polar(1.0f, static_cast<float>(-2.0 * M_PI * k / N));
+      }
+    }
+
+    inline size_t size(void) const { return N; }
+
+      // Transform N real samples, using an FFT of half the size, into the
+      // N/2+1 non-negative frequency bins
+    void transform(const float *x, vector<Complex> &X)
+    {
+      const size_t M = N / 2;
+      for (size_t n=0; n<M; ++n)
+      {
+        z[n] = Complex(x[2*n], x[2*n+1]);
+      }
+      fft.transform(z);
+      X.resize(M + 1);
+      for (size_t k=0; k<=M; ++k)
+      {
+        const Complex zk = z[k % M];
+        const Complex zc = conj(z[(M - k) % M]);
+        const Complex even = 0.5f * (zk + zc);
+        const Complex odd = Complex(0.0f, -0.5f) * (zk - zc);
+        X[k] = even + twiddles[k] * odd;
+      }
+    }
+
+  private:
+    size_t          N;
+    Fft             fft;
+    vector<Complex> twiddles;
+    vector<Complex> z;
+};
+
+
+/*
+ * Measure the deviation using an averaged power spectrum. The FFT work is
+ * done in a separate thread and the result is printed at a fixed rate.
+ * If the pre-demodulation I/Q samples are given using writeIq and a single
+ * modulation frequency is used, the modulation index is also estimated from
+ * the carrier and sideband levels, and Bessel nulls are detected.
+ */
+class FftDevPrinter : public DevMeter
+{
+  public:
+    FftDevPrinter(unsigned samp_rate, const vector<float> &mod_fqs,
+                  unsigned avg_cnt, float max_dev=1.0f,
+                  float headroom_db=0.0f, unsigned iq_samp_rate=0)
+      : DevMeter(max_dev, headroom_db), samp_rate(samp_rate),
+        iq_samp_rate(iq_samp_rate), mod_fqs(mod_fqs),
+        avg_cnt(max(avg_cnt, 1U)), N(fftSize(samp_rate)), w(N), fft(N),
+        pwr(N/2+1, 0.0), spec_cnt(0), mean(0.0), mean_sq(0.0), iq_N(0),
+        iq_w(0), iq_fft(0), iq_spec_cnt(0), stop(false), has_result(false),
+        print_timer(1000 / REFRESH_RATE, Timer::TYPE_PERIODIC)
+    {
+      if ((iq_samp_rate > 0) && (mod_fqs.size() == 1))
+      {
+        iq_N = fftSize(iq_samp_rate);
+        iq_w = new FlatTopWindow(iq_N);
+        iq_fft = new Fft(iq_N);
+        iq_pwr.assign(iq_N, 0.0);
+      }
+      print_timer.expired.connect(
+          sigc::mem_fun(*this, &FftDevPrinter::printResult));
+      worker = std::thread(&FftDevPrinter::workerFunc, this);
+    }
+
+    ~FftDevPrinter(void)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      cond.notify_one();
+      worker.join();
+      delete iq_fft;
+      delete iq_w;
+    }
+
+    virtual int writeSamples(const float *samples, int count)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        audio_fifo.insert(audio_fifo.end(), samples, samples + count);
+        if (audio_fifo.size() > samp_rate)
+        {
+          audio_fifo.erase(audio_fifo.begin(),
+                           audio_fifo.end() - samp_rate);
+        }
+      }
+      cond.notify_one();
+      return count;
+    }
+
+    virtual void writeIq(const vector<RtlSdr::Sample> &iq)
+    {
+      if (iq_fft == 0)
+      {
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        iq_fifo.insert(iq_fifo.end(), iq.begin(), iq.end());
+        if (iq_fifo.size() > iq_samp_rate)
+        {
+          iq_fifo.erase(iq_fifo.begin(), iq_fifo.end() - iq_samp_rate);
+        }
+      }
+      cond.notify_one();
+    }
+
+  private:
+    static CONSTEXPR double FFT_RESOLUTION = 4.0;     //!< Max bin width [Hz]
+    static CONSTEXPR size_t MAX_FFT_SIZE = 65536;
+    static CONSTEXPR int    REFRESH_RATE = 5;         //!< Prints per second
+    static CONSTEXPR int    BESSEL_ORDERS = 8;        //!< Sidebands to fit
+    static CONSTEXPR double MAX_MOD_INDEX = 6.0;
+    static CONSTEXPR double BESSEL_NULL_LEVEL = -30.0; //!< Carrier level [dB]
+
+    struct Result
+    {
+      double dev;
+      double tot_dev;
+      double fqerr;
+      bool   has_mod_idx;
+      double mod_idx;
+      double carrier_db;
+    };
+
+    const unsigned          samp_rate;
+    const unsigned          iq_samp_rate;
+    const vector<float>     mod_fqs;
+    const unsigned          avg_cnt;
+
+      // Only used by the worker thread
+    const size_t            N;
+    FlatTopWindow           w;
+    RealFft                 fft;
+    vector<float>           block;
+    vector<float>           win_block;
+    vector<Fft::Complex>    spec;
+    vector<double>          pwr;
+    unsigned                spec_cnt;
+    double                  mean;
+    double                  mean_sq;
+    size_t                  iq_N;
+    FlatTopWindow *         iq_w;
+    Fft *                   iq_fft;
+    vector<Fft::Complex>    iq_block;
+    vector<Fft::Complex>    iq_spec;
+    vector<double>          iq_pwr;
+    unsigned                iq_spec_cnt;
+
+      // Protected by the mutex
+    std::mutex              mutex;
+    std::condition_variable cond;
+    vector<float>           audio_fifo;
+    vector<RtlSdr::Sample>  iq_fifo;
+    bool                    stop;
+    bool                    has_result;
+    Result                  result;
+
+    std::thread             worker;
+    Timer                   print_timer;
+
+    static size_t fftSize(unsigned rate)
+    {
+      size_t size = 2;
+      while ((size < MAX_FFT_SIZE) && (rate > FFT_RESOLUTION * size))
+      {
+        size <<= 1;
+      }
+      return size;
+    }
+
+    void average(vector<double> &avg, const vector<Fft::Complex> &X,
+                 unsigned cnt)
+    {
+      for (size_t k=0; k<avg.size(); ++k)
+      {
+        avg[k] += (norm(X[k]) - avg[k]) / cnt;
+      }
+    }
+
+    bool processAudio(const vector<float> &samples)
+    {
+      bool updated = false;
+      block.insert(block.end(), samples.begin(), samples.end());
+      win_block.resize(N);
+      while (block.size() >= N)
+      {
+        double sum = 0.0;
+        double sum_sq = 0.0;
+        for (size_t n=0; n<N; ++n)
+        {
+          sum += block[n];
+          sum_sq += static_cast<double>(block[n]) * block[n];
+          win_block[n] = w[n] * block[n];
+        }
+        fft.transform(&win_block[0], spec);
+        if (spec_cnt < avg_cnt)
+        {
+          ++spec_cnt;
+        }
+        average(pwr, spec, spec_cnt);
+        mean += (sum / N - mean) / spec_cnt;
+        mean_sq += (sum_sq / N - mean_sq) / spec_cnt;
+        block.erase(block.begin(), block.begin() + N/2);
+        updated = true;
+      }
+      return updated;
+    }
+
+    void processIq(const vector<RtlSdr::Sample> &samples)
+    {
+      if (iq_fft == 0)
+      {
+        return;
+      }
+      iq_block.insert(iq_block.end(), samples.begin(), samples.end());
+      iq_spec.resize(iq_N);
+      while (iq_block.size() >= iq_N)
+      {
+        for (size_t n=0; n<iq_N; ++n)
+        {
+          iq_spec[n] = (*iq_w)[n] * iq_block[n];
+        }
+        iq_fft->transform(iq_spec);
+        if (iq_spec_cnt < avg_cnt)
+        {
+          ++iq_spec_cnt;
+        }
+        average(iq_pwr, iq_spec, iq_spec_cnt);
+        iq_block.erase(iq_block.begin(), iq_block.begin() + iq_N/2);
+      }
+    }
+
+      // The largest power within one bin from the given frequency
+    static double peakPower(const vector<double> &p, double fq,
+                            double bin_width, bool wrap)
+    {
+      const long size = p.size();
+      const long center = lround(fq / bin_width);
+      double peak = 0.0;
+      for (long k=center-1; k<=center+1; ++k)
+      {
+        long idx = k;
+        if (wrap)
+        {
+          idx = ((k % size) + size) % size;
+        }
+        else if ((idx < 0) || (idx >= size))
+        {
+          continue;
+        }
+        peak = max(peak, p[idx]);
+      }
+      return peak;
+    }
+
+      // Find the modulation index that best fit the measured carrier and
+      // sideband amplitudes, which must be normalized to unit total power.
+      // Amplitudes that are not measured are negative.
+    static double fitModIndex(const vector<double> &amp)
+    {
+      double best_idx = 0.0;
+      double best_err = -1.0;
+      double step = 0.01;
+      double lo = 0.0;
+      double hi = MAX_MOD_INDEX;
+      for (int pass=0; pass<2; ++pass)
+      {
+        for (double idx=lo; idx<=hi; idx+=step)
+        {
+          double model_pwr = 0.0;
+          for (int n=-BESSEL_ORDERS; n<=BESSEL_ORDERS; ++n)
+          {
+            if (amp[n + BESSEL_ORDERS] >= 0.0)
+            {
+              const double j = jn(abs(n), idx);
+              model_pwr += j * j;
+            }
+          }
+          const double model_scale = 1.0 / sqrt(model_pwr);
+          double err = 0.0;
+          for (int n=-BESSEL_ORDERS; n<=BESSEL_ORDERS; ++n)
+          {
+            const double a = amp[n + BESSEL_ORDERS];
+            if (a >= 0.0)
+            {
+              const double d = a - model_scale * fabs(jn(abs(n), idx));
+              err += d * d;
+            }
+          }
+          if ((best_err < 0.0) || (err < best_err))
+          {
+            best_err = err;
+            best_idx = idx;
+          }
+        }
+        lo = max(0.0, best_idx - step);
+        hi = best_idx + step;
+        step /= 50.0;
+      }
+      return best_idx;
+    }
+
+    Result calcResult(void)
+    {
+      Result r;
+      const double bin_width = static_cast<double>(samp_rate) / N;
+      double tone_pwr = 0.0;
+      for (size_t i=0; i<mod_fqs.size(); ++i)
+      {
+        tone_pwr += peakPower(pwr, mod_fqs[i], bin_width, false);
+      }
+      r.dev = 2.0 * sqrt(tone_pwr) / N;
+      r.tot_dev = sqrt(mean_sq) * sqrt(2);
+      r.fqerr = mean;
+
+      r.has_mod_idx = (iq_spec_cnt > 0);
+      r.mod_idx = 0.0;
+      r.carrier_db = 0.0;
+      if (r.has_mod_idx)
+      {
+          // The demodulated audio is in Hz when I/Q samples are available
+          // so the mean is the carrier frequency offset
+        const double iq_bin_width = static_cast<double>(iq_samp_rate) / iq_N;
+        const double fm = mod_fqs[0];
+        vector<double> amp(2 * BESSEL_ORDERS + 1, -1.0);
+        double tot_pwr = 0.0;
+        for (int n=-BESSEL_ORDERS; n<=BESSEL_ORDERS; ++n)
+        {
+            // Only use sideband pairs that are both below the Nyquist
+            // frequency since a sideband above it alias onto another one
+          const double fq = mean + n * fm;
+          if (fabs(mean) + abs(n) * fm < iq_samp_rate / 2.0)
+          {
+            const double p = peakPower(iq_pwr, fq, iq_bin_width, true);
+            amp[n + BESSEL_ORDERS] = sqrt(p);
+            tot_pwr += p;
+          }
+        }
+        if (tot_pwr > 0.0)
+        {
+          for (size_t i=0; i<amp.size(); ++i)
+          {
+            if (amp[i] >= 0.0)
+            {
+              amp[i] /= sqrt(tot_pwr);
+            }
+          }
+          r.mod_idx = fitModIndex(amp);
+          r.carrier_db = 20.0 * log10(max(amp[BESSEL_ORDERS], 1.0e-5));
+        }
+      }
+      return r;
+    }
+
+    void workerFunc(void)
+    {
+      vector<float> audio;
+      vector<RtlSdr::Sample> iq;
+      for (;;)
+      {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          while (!stop && audio_fifo.empty() && iq_fifo.empty())
+          {
+            cond.wait(lock);
+          }
+          if (stop)
+          {
+            return;
+          }
+          audio.swap(audio_fifo);
+          iq.swap(iq_fifo);
+        }
+
+        processIq(iq);
+        const bool updated = processAudio(audio);
+        audio.clear();
+        iq.clear();
+
+        if (updated)
+        {
+          const Result r = calcResult();
+          std::lock_guard<std::mutex> lock(mutex);
+          result = r;
+          has_result = true;
+        }
+      }
+    }
+
+    void printResult(Timer *t)
+    {
+      Result r;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!has_result)
+        {
+          return;
+        }
+        r = result;
+      }
+
+      printDev(r.dev * scale(), r.tot_dev * scale(), r.fqerr * scale());
+      if (r.has_mod_idx)
+      {
+        static const double nulls[] = { 2.4048, 5.5201, 8.6537 };
+        cout << "  Mod index=" << r.mod_idx
+             << "(" << (r.mod_idx * mod_fqs[0]) << "Hz)"
+             << "  Carrier=" << r.carrier_db << "dB";
+        if (r.carrier_db < BESSEL_NULL_LEVEL)
+        {
+          size_t null_idx = 0;
+          for (size_t i=1; i<sizeof(nulls)/sizeof(*nulls); ++i)
+          {
+            if (fabs(nulls[i] - r.mod_idx) < fabs(nulls[null_idx] - r.mod_idx))
+            {
+              null_idx = i;
+            }
+          }
+          cout << "  [Bessel null " << (null_idx + 1) << "]";
+        }
+      }
+      cout.flush();
+    }
 };
 
 
 class DevMeasure : public sigc::trackable
 {
   public:
-    DevMeasure(unsigned samp_rate, const vector<float> &mod_fqs,
+    DevMeasure(unsigned samp_rate, DevMeter *dev_meter,
                double carrier_fq=0.0)
-      : iold(0.0f), qold(0.0f), dev_print(samp_rate, mod_fqs),
-        samp_rate(samp_rate)
+      : iold(0.0f), qold(0.0f), dev_meter(dev_meter), samp_rate(samp_rate)
+    {
+      dev_meter->setCarrierFq(carrier_fq);
+    }
+
+    ~DevMeasure(void)
     {
-      dev_print.setCarrierFq(carrier_fq);
+      delete dev_meter;
     }
 
     void processPreDemod(const vector<RtlSdr::Sample> &preDemod)
@@ -423,13 +956,14 @@ class DevMeasure : public sigc::trackable
         qold = Q;
         audio.push_back(samp_rate * demod / (2.0 * M_PI));
       }
-      dev_print.writeSamples(&audio[0], audio.size());
+      dev_meter->writeIq(preDemod);
+      dev_meter->writeSamples(&audio[0], audio.size());
     }
 
   private:
     float         iold;
     float         qold;
-    DevPrinter    dev_print;
+    DevMeter      *dev_meter;
     unsigned      samp_rate;
 };
 
@@ -461,11 +995,13 @@ static int cal_tx = false;
 static int measure = false;
 static bool wb_mode = false;
 static int flat_fq_response = false;
+static int fft_mode = false;
+static int fft_avg = DEFAULT_FFT_AVG;
 static string cfgfile;
 static string cfgsect;
 static FdWatch *stdin_watch = 0;
 static SineGenerator *gen = 0;
-static DevPrinter *dp = 0;
+static DevMeter *dp = 0;
 static Tx *tx = 0;
 static Rx *rx = 0;
 static float level_adjust_offset = 0.0f;
@@ -484,7 +1020,7 @@ static const unsigned audio_ch = 0;
 int main(int argc, const char *argv[])
 {
   cout << PROGRAM_NAME " v" DEVCAL_VERSION
-          " Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX\n\n";
+          " Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX\n\n";
   cout << PROGRAM_NAME " comes with ABSOLUTELY NO WARRANTY. "
           "This is free software, and you\n";
   cout << "are welcome to redistribute it in accordance with the "
@@ -590,7 +1126,15 @@ int main(int argc, const char *argv[])
       prev_src = preemph;
     }
     
-    dp = new DevPrinter(INTERNAL_SAMPLE_RATE, mod_fqs, maxdev, headroom_db);
+    if (fft_mode)
+    {
+      dp = new FftDevPrinter(INTERNAL_SAMPLE_RATE, mod_fqs, fft_avg, maxdev,
+                             headroom_db);
+    }
+    else
+    {
+      dp = new DevPrinter(INTERNAL_SAMPLE_RATE, mod_fqs, maxdev, headroom_db);
+    }
     prev_src->registerSink(dp, true);
     prev_src = 0;
 
@@ -642,8 +1186,19 @@ int main(int argc, const char *argv[])
     {
       ddr->setModulation(Modulation::MOD_WBFM);
     }
-    DevMeasure *dev_measure = new DevMeasure(ddr->preDemodSampleRate(), 
-                                             mod_fqs, ddr->nbFq());
+    const unsigned samp_rate = ddr->preDemodSampleRate();
+    DevMeter *dev_meter = 0;
+    if (fft_mode)
+    {
+      dev_meter = new FftDevPrinter(samp_rate, mod_fqs, fft_avg, 1.0f, 0.0f,
+                                    samp_rate);
+    }
+    else
+    {
+      dev_meter = new DevPrinter(samp_rate, mod_fqs);
+    }
+    DevMeasure *dev_measure = new DevMeasure(samp_rate, dev_meter,
+                                             ddr->nbFq());
     ddr->preDemod.connect(mem_fun(dev_measure, &DevMeasure::processPreDemod));
 
     if (audio_dev[0] != '\0')
@@ -740,6 +1295,10 @@ static void parse_arguments(int argc, const char **argv)
             "Flat TX/RX frequency response (no emphasis)", NULL},
     {"measure", 'M', POPT_ARG_NONE, &measure, 0, "Measure deviation", NULL},
     {"wide", 'w', POPT_ARG_NONE, &wb_mode, 0, "Wideband mode", NULL},
+    {"fft", 'S', POPT_ARG_NONE, &fft_mode, 0,
+            "Measure using an averaged FFT spectrum", NULL},
+    {"fftavg", 'A', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &fft_avg, 0,
+            "The number of FFT spectra to average", "<count>"},
     {"audiodev", 'a', POPT_ARG_STRING | POPT_ARGFLAG_SHOW_DEFAULT,
             &audio_dev, 0,
 	    "The audio device to use for audio output",
@@ -798,6 +1357,19 @@ static void parse_arguments(int argc, const char **argv)
     }
   }
 
+  if (fft_mode && cal_tx)
+  {
+    cerr << "*** ERROR: FFT mode is only valid in receiver calibration and "
+            "measure mode\n";
+    exit(1);
+  }
+
+  if (fft_avg < 1)
+  {
+    cerr << "*** ERROR: The FFT average count must be at least 1\n";
+    exit(1);
+  }
+
   SvxLink::splitStr(mod_fqs, mod_fqs_str, ",");
   /*
   for (vector<float>::iterator it = mod_fqs.begin(); it != mod_fqs.end(); ++it)
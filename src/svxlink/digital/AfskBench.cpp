@@ -0,0 +1,561 @@
+/**
+@file	 AfskBench.cpp
+@brief   Measure the frame error rate and CPU usage of the AFSK receiver
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This program modulates random HDLC frames using the AfskModulator, degrade
+the audio with noise, twist or a clock offset and then decode it again. For
+each test tape the number of correctly received frames and the throughput
+of the demodulator, bit synchronizer and HDLC deframer are printed. The
+results can also be written to a CSV file.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+#include <AsyncAudioNoiseAdder.h>
+#include <BenchUtil.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AfskModulator.h"
+#include "AfskDemodulator.h"
+#include "AfskMultiDecoder.h"
+#include "Synchronizer.h"
+#include "HdlcFramer.h"
+#include "HdlcDeframer.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace SvxLink;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The number of frames on each tape and the number of data bytes in each
+  // frame
+#define FRAME_CNT         40
+#define FRAME_SIZE        32
+
+  // The silence between the frames on a tape, in milliseconds
+#define FRAME_SPACING     200
+
+  // The level of the modulated signal, in dB relative to a full scale sine
+#define SIGNAL_LEVEL      -6.0
+
+  // The number of samples written to the receiver in each call
+#define BLOCK_SIZE        256
+
+struct Profile
+{
+  const char  *name;
+  unsigned    f0;
+  unsigned    f1;
+  unsigned    baudrate;
+  bool        twist;
+};
+
+struct Tape
+{
+  string                    name;
+  double                    snr_db;
+  double                    twist_db;
+  double                    clock_percent;
+  vector<float>             samples;
+  vector<vector<uint8_t> >  frames;
+};
+
+struct Result
+{
+  unsigned      frames_ok;
+  unsigned      frames_extra;
+  double        demod_time;
+  double        sync_time;
+  double        deframe_time;
+  double        total_time;
+};
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+class SampleCollector : public AudioSink
+{
+  public:
+    vector<float> samples;
+
+    virtual int writeSamples(const float *buf, int count)
+    {
+      samples.insert(samples.end(), buf, buf + count);
+      return count;
+    }
+
+    virtual void flushSamples(void)
+    {
+      sourceAllSamplesFlushed();
+    }
+};
+
+
+class FrameLog : public sigc::trackable
+{
+  public:
+    vector<vector<uint8_t> >  frames;
+    vector<vector<uint8_t> >  bit_blocks;
+
+    void frameReceived(vector<uint8_t> &frame)
+    {
+      frames.push_back(frame);
+    }
+
+    void bitsReceived(const vector<uint8_t> &bits)
+    {
+      bit_blocks.push_back(bits);
+    }
+};
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static void applyTwist(vector<float> &samples, const Profile &profile,
+                       double twist_db);
+static void makeTape(Tape &tape, const Profile &profile, double snr_db,
+                     double twist_db, unsigned mod_sample_rate,
+                     mt19937 &rng);
+static void countFrames(const Tape &tape,
+                        const vector<vector<uint8_t> > &frames,
+                        Result &result);
+static void runSingle(const Profile &profile, const Tape &tape,
+                      Result &result);
+static void runMulti(const Profile &profile, const Tape &tape,
+                     Result &result);
+static void printResult(const Profile &profile, const string &decoder,
+                        const Tape &tape, const Result &result,
+                        ostream *csv);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+  // The in-band and out-of-band AFSK used by SvxLink. The out-of-band tones
+  // are too close for the twist to matter.
+static const Profile profiles[] =
+{
+  { "IB",   1200, 2200, 1200, true  },
+  { "OB",   5415, 5585,  300, false }
+};
+static const int profile_cnt = sizeof(profiles) / sizeof(*profiles);
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  if (argc > 2)
+  {
+    cerr << "Usage: AfskBench [results.csv]\n";
+    exit(1);
+  }
+
+  ofstream csv;
+  if (argc > 1)
+  {
+    csv.open(argv[1]);
+    if (!csv)
+    {
+      cerr << "*** ERROR: Could not open \"" << argv[1]
+           << "\" for writing\n";
+      exit(1);
+    }
+    csv << "profile,decoder,tape,snr_db,twist_db,clock_percent,"
+           "frames_sent,frames_ok,frames_extra,samples,demod_s,sync_s,"
+           "deframe_s,total_s,msps\n";
+  }
+
+  for (int p=0; p<profile_cnt; ++p)
+  {
+    const Profile &profile = profiles[p];
+    mt19937 rng(4711);
+    vector<Tape> tapes;
+
+    const double snrs[] = { 20, 15, 12, 9, 6, 3, 0, -3 };
+    for (size_t i=0; i<sizeof(snrs)/sizeof(*snrs); ++i)
+    {
+      Tape tape;
+      ostringstream name;
+      name << "snr " << snrs[i] << "dB";
+      tape.name = name.str();
+      makeTape(tape, profile, snrs[i], 0.0, INTERNAL_SAMPLE_RATE, rng);
+      tapes.push_back(tape);
+    }
+
+    if (profile.twist)
+    {
+      const double twists[] = { -9, -6, -3, 3, 6, 9 };
+      for (size_t i=0; i<sizeof(twists)/sizeof(*twists); ++i)
+      {
+        Tape tape;
+        ostringstream name;
+        name << "twist " << showpos << twists[i] << "dB";
+        tape.name = name.str();
+        makeTape(tape, profile, 12.0, twists[i], INTERNAL_SAMPLE_RATE, rng);
+        tapes.push_back(tape);
+      }
+    }
+
+      // A modulator that think the sample rate is higher than it is will
+      // produce a signal with a lower baudrate and lower tone frequencies
+    const unsigned mod_rates[] = { 15840, 15920, 16080, 16160 };
+    for (size_t i=0; i<sizeof(mod_rates)/sizeof(*mod_rates); ++i)
+    {
+      Tape tape;
+      makeTape(tape, profile, 12.0, 0.0, mod_rates[i], rng);
+      ostringstream name;
+      name << "clock " << showpos << fixed << setprecision(1)
+           << tape.clock_percent << "%";
+      tape.name = name.str();
+      tapes.push_back(tape);
+    }
+
+    cout << setw(8) << left << "Profile" << setw(8) << "Decoder"
+         << setw(14) << "Tape" << right << setw(8) << "Frame%"
+         << setw(7) << "Extra" << setw(9) << "Demod" << setw(9) << "Sync"
+         << setw(9) << "Deframe" << setw(9) << "Total" << "  (MS/s)"
+         << endl;
+    for (size_t i=0; i<tapes.size(); ++i)
+    {
+      Result result;
+      runSingle(profile, tapes[i], result);
+      printResult(profile, "single", tapes[i], result,
+                  csv.is_open() ? &csv : 0);
+    }
+    for (size_t i=0; i<tapes.size(); ++i)
+    {
+      Result result;
+      runMulti(profile, tapes[i], result);
+      printResult(profile, "multi", tapes[i], result,
+                  csv.is_open() ? &csv : 0);
+    }
+  }
+
+  return 0;
+} /* main */
+
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+  // Apply a first order filter, y[n] = x[n] + a * x[n-1], with the
+  // coefficient chosen so that the upper tone is twist_db stronger than the
+  // lower tone. The filter gain is normalized to keep the signal power.
+static void applyTwist(vector<float> &samples, const Profile &profile,
+                       double twist_db)
+{
+  const double w0 = 2.0 * M_PI * profile.f0 / INTERNAL_SAMPLE_RATE;
+  const double w1 = 2.0 * M_PI * profile.f1 / INTERNAL_SAMPLE_RATE;
+  double lo = -0.95;
+  double hi = 0.95;
+  double a = 0.0;
+  for (int i=0; i<50; ++i)
+  {
+    a = (lo + hi) / 2.0;
+    const double pwr0 = 1.0 + a * a + 2.0 * a * cos(w0);
+    const double pwr1 = 1.0 + a * a + 2.0 * a * cos(w1);
+      // The upper tone get weaker as a increase
+    if (10.0 * log10(pwr1 / pwr0) > twist_db)
+    {
+      lo = a;
+    }
+    else
+    {
+      hi = a;
+    }
+  }
+  const double pwr0 = 1.0 + a * a + 2.0 * a * cos(w0);
+  const double pwr1 = 1.0 + a * a + 2.0 * a * cos(w1);
+  const float gain = sqrt(2.0 / (pwr0 + pwr1));
+
+  float prev = 0.0f;
+  for (size_t i=0; i<samples.size(); ++i)
+  {
+    const float x = samples[i];
+    samples[i] = gain * (x + a * prev);
+    prev = x;
+  }
+} /* applyTwist */
+
+
+static void makeTape(Tape &tape, const Profile &profile, double snr_db,
+                     double twist_db, unsigned mod_sample_rate,
+                     mt19937 &rng)
+{
+  tape.snr_db = snr_db;
+  tape.twist_db = twist_db;
+  tape.clock_percent =
+    100.0 * INTERNAL_SAMPLE_RATE / mod_sample_rate - 100.0;
+
+  SampleCollector collector;
+  AfskModulator mod(profile.f0, profile.f1, profile.baudrate, SIGNAL_LEVEL,
+                    mod_sample_rate);
+  mod.registerSink(&collector);
+  HdlcFramer framer;
+  framer.sendBits.connect(mem_fun(mod, &AfskModulator::sendBits));
+
+  const size_t spacing = FRAME_SPACING * INTERNAL_SAMPLE_RATE / 1000;
+  uniform_int_distribution<int> byte_dist(0, 255);
+  collector.samples.assign(spacing, 0.0f);
+  for (int f=0; f<FRAME_CNT; ++f)
+  {
+    vector<uint8_t> frame(FRAME_SIZE);
+    for (size_t i=0; i<frame.size(); ++i)
+    {
+      frame[i] = byte_dist(rng);
+    }
+    framer.sendBytes(frame);
+    tape.frames.push_back(frame);
+    collector.samples.resize(collector.samples.size() + spacing, 0.0f);
+  }
+  mod.unregisterSink();
+
+  if (twist_db != 0.0)
+  {
+    applyTwist(collector.samples, profile, twist_db);
+  }
+
+    // The noise level is given relative to the power of a full scale sine
+    // so it is the signal level minus the SNR
+  SampleCollector noisy;
+  AudioNoiseAdder noise(SIGNAL_LEVEL - snr_db);
+  noise.registerSink(&noisy);
+  for (size_t pos=0; pos<collector.samples.size(); pos+=BLOCK_SIZE)
+  {
+    const size_t cnt = min(static_cast<size_t>(BLOCK_SIZE),
+                           collector.samples.size() - pos);
+    noise.writeSamples(&collector.samples[pos], cnt);
+  }
+  noise.unregisterSink();
+  tape.samples.swap(noisy.samples);
+} /* makeTape */
+
+
+  // The frames are sent in order so each received frame is matched against
+  // the sent frames from where the previous match was found
+static void countFrames(const Tape &tape,
+                        const vector<vector<uint8_t> > &frames,
+                        Result &result)
+{
+  result.frames_ok = 0;
+  result.frames_extra = 0;
+  size_t next = 0;
+  for (size_t i=0; i<frames.size(); ++i)
+  {
+    size_t idx = next;
+    while ((idx < tape.frames.size()) && (tape.frames[idx] != frames[i]))
+    {
+      ++idx;
+    }
+    if (idx < tape.frames.size())
+    {
+      ++result.frames_ok;
+      next = idx + 1;
+    }
+    else
+    {
+      ++result.frames_extra;
+    }
+  }
+} /* countFrames */
+
+
+  // Each receiver stage is run over the whole tape on its own so that the
+  // time spent in each stage can be measured
+static void runSingle(const Profile &profile, const Tape &tape,
+                      Result &result)
+{
+  const size_t len = tape.samples.size();
+
+  AfskDemodulator demod(profile.f0, profile.f1, profile.baudrate);
+  SampleCollector demodulated;
+  demodulated.samples.reserve(len);
+  demod.registerSink(&demodulated);
+  uint64_t start = benchNowUs();
+  for (size_t pos=0; pos<len; pos+=BLOCK_SIZE)
+  {
+    demod.writeSamples(&tape.samples[pos],
+                       min(static_cast<size_t>(BLOCK_SIZE), len - pos));
+  }
+  result.demod_time = (benchNowUs() - start) / 1.0e6;
+  demod.unregisterSink();
+
+  FrameLog log;
+  Synchronizer sync(profile.baudrate);
+  sync.bitsReceived.connect(mem_fun(log, &FrameLog::bitsReceived));
+  const vector<float> &dem = demodulated.samples;
+  start = benchNowUs();
+  for (size_t pos=0; pos<dem.size(); pos+=BLOCK_SIZE)
+  {
+    sync.writeSamples(&dem[pos],
+                      min(static_cast<size_t>(BLOCK_SIZE), dem.size() - pos));
+  }
+  result.sync_time = (benchNowUs() - start) / 1.0e6;
+
+  HdlcDeframer deframer;
+  deframer.frameReceived.connect(mem_fun(log, &FrameLog::frameReceived));
+  start = benchNowUs();
+  for (size_t i=0; i<log.bit_blocks.size(); ++i)
+  {
+    deframer.bitsReceived(log.bit_blocks[i]);
+  }
+  result.deframe_time = (benchNowUs() - start) / 1.0e6;
+
+  result.total_time =
+    result.demod_time + result.sync_time + result.deframe_time;
+  countFrames(tape, log.frames, result);
+} /* runSingle */
+
+
+static void runMulti(const Profile &profile, const Tape &tape,
+                     Result &result)
+{
+  const size_t len = tape.samples.size();
+  FrameLog log;
+  AfskMultiDecoder dec(profile.f0, profile.f1, profile.baudrate,
+                       AfskMultiDecoder::MAX_DECODERS);
+  dec.frameReceived.connect(mem_fun(log, &FrameLog::frameReceived));
+  const uint64_t start = benchNowUs();
+  for (size_t pos=0; pos<len; pos+=BLOCK_SIZE)
+  {
+    dec.writeSamples(&tape.samples[pos],
+                     min(static_cast<size_t>(BLOCK_SIZE), len - pos));
+  }
+  result.total_time = (benchNowUs() - start) / 1.0e6;
+  result.demod_time = result.sync_time = result.deframe_time = 0.0;
+  countFrames(tape, log.frames, result);
+} /* runMulti */
+
+
+static void printResult(const Profile &profile, const string &decoder,
+                        const Tape &tape, const Result &result,
+                        ostream *csv)
+{
+  const double len = tape.samples.size();
+  cout << setw(8) << left << profile.name << setw(8) << decoder
+       << setw(14) << tape.name << right << fixed << setprecision(1)
+       << setw(8) << 100.0 * result.frames_ok / tape.frames.size()
+       << setw(7) << result.frames_extra << setprecision(2);
+  if (result.demod_time > 0.0)
+  {
+    cout << setw(9) << len / result.demod_time / 1.0e6
+         << setw(9) << len / result.sync_time / 1.0e6
+         << setw(9) << len / result.deframe_time / 1.0e6;
+  }
+  else
+  {
+    cout << setw(9) << "-" << setw(9) << "-" << setw(9) << "-";
+  }
+  cout << setw(9) << len / result.total_time / 1.0e6 << endl;
+
+  if (csv != 0)
+  {
+    *csv << profile.name << "," << decoder << "," << tape.name << ","
+         << tape.snr_db << "," << tape.twist_db << ","
+         << tape.clock_percent << "," << tape.frames.size() << ","
+         << result.frames_ok << "," << result.frames_extra << ","
+         << tape.samples.size() << "," << result.demod_time << ","
+         << result.sync_time << "," << result.deframe_time << ","
+         << result.total_time << ","
+         << len / result.total_time / 1.0e6 << "\n";
+  }
+} /* printResult */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -36,6 +36,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iomanip>
 #include <sstream>
 #include <deque>
+#include <vector>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -45,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncAudioPassthrough.h>
 //#include <AsyncAudioClipper.h>
 #include <AsyncAudioFilter.h>
 
@@ -88,8 +91,19 @@ namespace {
     public:
       Correlator(float f0, float f1, unsigned baudrate,
           unsigned sample_rate=INTERNAL_SAMPLE_RATE)
-        : delay(0), head(0)
+        : delay(0), head(0),
+          sub_block_len(max(sample_rate / baudrate / 2, 1U)),
+          sub_block_pos(0), window_len(sample_rate / 50), window_pos(0),
+          hangover_len(sample_rate / 2), hangover(0), sub_sum(0.0f),
+          abs_sum(0.0f), energy_sum(0.0f), carrier_threshold(0.0f),
+          carrier_detected(true)
       {
+          // For white noise, the normalized correlation is about
+          // sqrt(2/pi) / sqrt(sub_block_len). An AFSK signal give a value
+          // close to one.
+        carrier_threshold = CARRIER_THRESHOLD_FACTOR * sqrt(2.0 / M_PI) /
+                            sqrt(static_cast<double>(sub_block_len));
+
           // Calculate the optimum value for the delay
         unsigned samples_per_symbol = sample_rate / baudrate;
         double max_k_val = 0.0;
@@ -114,21 +128,113 @@ namespace {
         delete [] buf;
       }
 
+      /**
+       * @brief Check if there is an AFSK signal in the input
+       * @return Returns \em true if an AFSK signal may be present
+       */
+      bool carrierDetected(void) const { return carrier_detected; }
+
     protected:
       void processSamples(float *out, const float *in, int len)
       {
         for (int i=0; i<len; ++i)
         {
-          out[i] = in[i] * buf[head];
-          buf[head] = in[i];
-          head = (head+1) % delay;
+          const float x = in[i];
+          const float corr = x * buf[head];
+          out[i] = corr;
+          buf[head] = x;
+          if (++head == delay)
+          {
+            head = 0;
+          }
+
+            // The correlator output is summed over half symbol periods so
+            // that mark and space periods do not cancel each other out
+          sub_sum += corr;
+          energy_sum += x * x;
+          if (++sub_block_pos == sub_block_len)
+          {
+            abs_sum += fabsf(sub_sum);
+            sub_sum = 0.0f;
+            sub_block_pos = 0;
+          }
+          if (++window_pos == window_len)
+          {
+            updateCarrierDetect();
+          }
         }
       }
 
     private:
+        // The lowest signal power, per sample, considered to be a signal
+      static const float MIN_ENERGY;
+        // The lowest normalized correlation considered to be an AFSK
+        // signal, relative to the value for white noise
+      static const float CARRIER_THRESHOLD_FACTOR;
+
       unsigned  delay;
       float *   buf;
       unsigned  head;
+      unsigned  sub_block_len;
+      unsigned  sub_block_pos;
+      unsigned  window_len;
+      unsigned  window_pos;
+      unsigned  hangover_len;
+      unsigned  hangover;
+      float     sub_sum;
+      float     abs_sum;
+      float     energy_sum;
+      float     carrier_threshold;
+      bool      carrier_detected;
+
+        // A tone at one of the AFSK frequencies give a strong correlation at
+        // the correlator delay. Noise and silence do not.
+      void updateCarrierDetect(void)
+      {
+        if ((energy_sum > MIN_ENERGY * window_len) &&
+            (abs_sum > carrier_threshold * energy_sum))
+        {
+          hangover = hangover_len;
+          carrier_detected = true;
+        }
+        else if (hangover > window_len)
+        {
+          hangover -= window_len;
+        }
+        else
+        {
+          hangover = 0;
+          carrier_detected = false;
+        }
+        abs_sum = 0.0f;
+        energy_sum = 0.0f;
+        window_pos = 0;
+      }
+  };
+
+  const float Correlator::MIN_ENERGY = 1.0e-8f;
+  const float Correlator::CARRIER_THRESHOLD_FACTOR = 1.6f;
+
+
+    // Only let the correlator output through to the rest of the demodulator
+    // while the correlator detect an AFSK signal. The correlator filter, bit
+    // synchronizer and deframer are idle while nothing is received.
+  class CarrierGate : public AudioPassthrough
+  {
+    public:
+      CarrierGate(const Correlator &corr) : corr(corr) {}
+
+      virtual int writeSamples(const float *samples, int count)
+      {
+        if (!corr.carrierDetected())
+        {
+          return count;
+        }
+        return AudioPassthrough::writeSamples(samples, count);
+      }
+
+    private:
+      const Correlator &corr;
   };
 
 #if 0
@@ -165,7 +271,8 @@ namespace {
   {
     public:
       DcBlocker(size_t order)
-        : order(order), delay(order, 0.0f), prev(0.0f)
+        : order(order), gain(1.0f / order), delay(order, 0.0f), pos(0),
+          prev(0.0f)
       {
       }
 
@@ -183,21 +290,28 @@ namespace {
        */
       virtual void processSamples(float *dest, const float *src, int count)
       {
+          // The delay line is a ring buffer where the oldest sample is at
+          // the current position
         for (int i=0; i<count; ++i)
         {
           float in = src[i];
-          float out = (in - delay.back()) / order + prev;
+          float out = (in - delay[pos]) * gain + prev;
           //dest[i] = delay[order/2]-out;
           dest[i] = in-out;
           prev = out;
-          delay.pop_back();
-          delay.push_front(in);
+          delay[pos] = in;
+          if (++pos == order)
+          {
+            pos = 0;
+          }
         }
       }
 
     private:
       const size_t  order;
-      deque<float>  delay;
+      const float   gain;
+      vector<float> delay;
+      size_t        pos;
       float         prev;
 
   }; /* class DcBlocker */
@@ -376,6 +490,11 @@ AfskDemodulator::AfskDemodulator(unsigned f0, unsigned f1, unsigned baudrate,
   prev_src->registerSink(corr, true);
   prev_src = corr;
 
+    // Skip the rest of the demodulator while there is no AFSK signal
+  CarrierGate *gate = new CarrierGate(*corr);
+  prev_src->registerSink(gate, true);
+  prev_src = gate;
+
     // Low pass out the constant component from the correlator
   stringstream ss("");
   ss << "LpBu5/" << baudrate;
@@ -6,7 +6,7 @@
 
 \verbatim
 SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
-Copyright (C) 2003-2018 Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -35,6 +35,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sstream>
 #include <cstring>
 #include <iomanip>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -162,7 +163,8 @@ namespace {
 AfskModulator::AfskModulator(unsigned f0, unsigned f1, unsigned baudrate,
                              float level, unsigned sample_rate)
   : baudrate(baudrate), sample_rate(sample_rate), phi(0), bitclock(0),
-    buf_pos(BUFSIZE), sigc_src(0), fade_len(0), fade_pos(0), fade_dir(0)
+    symbol_len(0), symbol_lookup(0), samples_pos(0), sigc_src(0),
+    fade_len(0), exp_lookup(0), active(false), last_bit(false)
 {
 #if 0
   unsigned N0 = findMultiplier(f0, sample_rate);
@@ -199,6 +201,27 @@ AfskModulator::AfskModulator(unsigned f0, unsigned f1, unsigned baudrate,
   k0 = N * f0 / sample_rate;
   k1 = N * f1 / sample_rate;
 
+    // Precalculate the waveform of both symbols for all start phases. A
+    // symbol is at most symbol_len samples long. If the table would get too
+    // big, the symbols are calculated from the sine table instead.
+  symbol_len = (sample_rate + baudrate - 1) / baudrate;
+  if (2 * N * symbol_len <= MAX_SYMBOL_LOOKUP_SIZE)
+  {
+    symbol_lookup = new float[2 * N * symbol_len];
+    for (unsigned bit=0; bit<2; ++bit)
+    {
+      const unsigned k = bit ? k1 : k0;
+      for (unsigned p=0; p<N; ++p)
+      {
+        float *sym = symbol_lookup + (bit * N + p) * symbol_len;
+        for (unsigned n=0; n<symbol_len; ++n)
+        {
+          sym[n] = sin_lookup[(p + n * k) % N];
+        }
+      }
+    }
+  }
+
   fade_len = FADE_SYMBOLS * sample_rate / baudrate;
   exp_lookup = new float[fade_len];
   for (unsigned i=0; i<fade_len; ++i)
@@ -284,6 +307,9 @@ AfskModulator::~AfskModulator(void)
 {
   AudioSource::clearHandler();
   delete sigc_src;
+  delete [] symbol_lookup;
+  delete [] exp_lookup;
+  delete [] sin_lookup;
 } /* AfskModulator::~AfskModulator */
 
 
@@ -302,13 +328,25 @@ void AfskModulator::sendBits(const vector<bool> &bits)
   }
   cout << endl;
   */
-  if (bitbuf.empty() && (fade_pos < fade_len-1))
+
+    // Throw away the samples that have already been written
+  samples.erase(samples.begin(), samples.begin() + samples_pos);
+  samples_pos = 0;
+
+  if (!active)
   {
-    fade_dir = 1;
-    bitbuf.resize(FADE_SYMBOLS);
-    fill_n(bitbuf.begin(), FADE_SYMBOLS, bits.front());
+    const size_t fade_start = samples.size();
+    for (unsigned sym=0; sym<FADE_SYMBOLS; ++sym)
+    {
+      renderSymbol(bits.front());
+    }
+    fadeIn(fade_start);
+    active = true;
+  }
+  for (vector<bool>::const_iterator it=bits.begin(); it!=bits.end(); ++it)
+  {
+    renderSymbol(*it);
   }
-  bitbuf.insert(bitbuf.end(), bits.begin(), bits.end());
   writeToSink();
 } /* AfskModulator::sendBits */
 
@@ -339,76 +377,95 @@ void AfskModulator::onAllSamplesFlushed(void)
  *
  ****************************************************************************/
 
-void AfskModulator::writeToSink(void)
+void AfskModulator::renderSymbol(bool bit)
 {
-  for (;;)
+    // The symbol end at the sample where the bit clock wrap
+  const unsigned len = (sample_rate - bitclock + baudrate - 1) / baudrate;
+  bitclock = bitclock + len * baudrate - sample_rate;
+
+  const unsigned k = bit ? k1 : k0;
+  const size_t pos = samples.size();
+  samples.resize(pos + len);
+  float *dest = &samples[pos];
+  if (symbol_lookup != 0)
   {
-    if (buf_pos >= BUFSIZE)
+    const float *sym = symbol_lookup + (bit * N + phi) * symbol_len;
+    copy(sym, sym + len, dest);
+  }
+  else
+  {
+    unsigned p = phi;
+    for (unsigned n=0; n<len; ++n)
     {
-      if (bitbuf.empty())
+      dest[n] = sin_lookup[p];
+      p += k;
+      if (p >= N)
       {
-        phi = 0;
-        //fade_pos = 0;
-        //fade_dir = 0;
-        sigc_src->flushSamples();
-        return;
+        p -= N;
       }
-      for (size_t i=0; i<BUFSIZE; ++i)
-      {
-        buf[i] = sin_lookup[phi];
-        if (fade_pos < fade_len-1)
-        {
-          //cout << fade_pos << endl;
-          buf[i] *= exp_lookup[fade_pos];
-        }
-        if (fade_dir != 0)
-        {
-          fade_pos += fade_dir;
-          if ((fade_pos == 0) || (fade_pos == fade_len-1))
-          {
-            fade_dir = 0;
-          }
-        }
-        phi += bitbuf.front() ? k1 : k0;
-        if (phi >= N)
-        {
-          phi -= N;
-        }
+    }
+  }
+  phi = (phi + len * k) % N;
+  last_bit = bit;
+} /* AfskModulator::renderSymbol */
+
+
+void AfskModulator::fadeIn(size_t start)
+{
+  const size_t len = min(samples.size() - start, size_t(fade_len - 1));
+  float *dest = &samples[start];
+  for (size_t i=0; i<len; ++i)
+  {
+    dest[i] *= exp_lookup[i];
+  }
+} /* AfskModulator::fadeIn */
+
 
-        bitclock += baudrate;
-        if (bitclock >= sample_rate)
+void AfskModulator::fadeOut(size_t start)
+{
+  const size_t len = samples.size() - start;
+  float *dest = &samples[start];
+  for (size_t i=1; i<len; ++i)
+  {
+    dest[i] *= exp_lookup[(i < fade_len) ? (fade_len - 1 - i) : 0];
+  }
+} /* AfskModulator::fadeOut */
+
+
+void AfskModulator::writeToSink(void)
+{
+  for (;;)
+  {
+    if (samples_pos >= samples.size())
+    {
+        // When all samples have been written and no more bits have arrived,
+        // the transmission is ended by fading out the last symbol
+      if (active)
+      {
+        samples.clear();
+        samples_pos = 0;
+        for (unsigned sym=0; sym<FADE_SYMBOLS; ++sym)
         {
-          bitclock -= sample_rate;
-          bitbuf.pop_front();
-          if (bitbuf.empty())
-          {
-            if (fade_pos == fade_len-1)
-            {
-              fade_dir = -1;
-              for (unsigned sym=0; sym<FADE_SYMBOLS; ++sym)
-              {
-                bitbuf.push_back(bitbuf.back());
-              }
-            }
-            else
-            {
-              i += 1;
-              memset(buf+i, 0, sizeof(*buf)*(BUFSIZE-i));
-              break;
-            }
-          }
+          renderSymbol(last_bit);
         }
+        fadeOut(0);
+        active = false;
+        continue;
       }
-      buf_pos = 0;
+      samples.clear();
+      samples_pos = 0;
+      phi = 0;
+      sigc_src->flushSamples();
+      return;
     }
 
-    int to_write = BUFSIZE-buf_pos;
-    int written = sigc_src->writeSamples(buf+buf_pos, to_write);
-    buf_pos += written;
+    int written = sigc_src->writeSamples(&samples[samples_pos],
+                                         samples.size() - samples_pos);
     if (written == 0)
     {
       break;
     }
+    samples_pos += written;
   }
 } /* AfskModulator::writeToSink */
 
@@ -6,7 +6,7 @@
 
 \verbatim
 SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
-Copyright (C) 2003-2018 Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -34,7 +34,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
-#include <deque>
 #include <vector>
 #include <sigc++/sigc++.h>
 
@@ -116,6 +115,11 @@ namespace Async
 
 This class implement an Audio Frequency Shift Keying modulator. It will
 generate an audio sample stream from the given bitstream.
+
+The waveform for each symbol is copied from a table holding all symbols for
+all phase states so the samples for a complete frame are generated in one
+go when sendBits is called. The samples are then written to the sink as fast
+as it will accept them.
 */
 class AfskModulator : public Async::AudioSource, public sigc::trackable
 {
@@ -137,14 +141,18 @@ class AfskModulator : public Async::AudioSource, public sigc::trackable
 
     /**
      * @brief 	Generate audio samples from the given bits
-     * @param 	bit The bit vector to send
+     * @param 	bits The bit vector to send
+     *
+     * All samples for the given bits are generated at once. If the bits are
+     * sent before all samples for the previous call have been written, they
+     * will follow on directly without a fade out in between.
      */
     void sendBits(const std::vector<bool> &bits);
 
   private:
-    static CONSTEXPR unsigned BUFSIZE = 256;
     static CONSTEXPR unsigned FADE_SYMBOLS = 1;
     static CONSTEXPR float    FADE_START_VAL = 0.01f;
+    static CONSTEXPR size_t   MAX_SYMBOL_LOOKUP_SIZE = 65536;
 
     const unsigned          baudrate;
     const unsigned          sample_rate;
@@ -153,18 +161,22 @@ class AfskModulator : public Async::AudioSource, public sigc::trackable
     unsigned                k0;
     unsigned                k1;
     unsigned                phi;
-    std::deque<bool>        bitbuf;
     unsigned                bitclock;
-    float                   buf[BUFSIZE];
-    unsigned                buf_pos;
+    unsigned                symbol_len;
+    float                   *symbol_lookup;
+    std::vector<float>      samples;
+    size_t                  samples_pos;
     Async::SigCAudioSource  *sigc_src;
     unsigned                fade_len;
-    unsigned                fade_pos;
-    int                     fade_dir;
     float                   *exp_lookup;
+    bool                    active;
+    bool                    last_bit;
 
     AfskModulator(const AfskModulator&);
     AfskModulator& operator=(const AfskModulator&);
+    void renderSymbol(bool bit);
+    void fadeIn(size_t start);
+    void fadeOut(size_t start);
     void writeToSink(void);
     void onResumeOutput(void);
     void onAllSamplesFlushed(void);
@@ -0,0 +1,405 @@
+/**
+@file	 AfskMultiDecoder.cpp
+@brief   Decode AFSK using several demodulator variants in parallel
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <cassert>
+#include <system_error>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AfskMultiDecoder.h"
+#include "AfskDemodulator.h"
+#include "Synchronizer.h"
+#include "HdlcDeframer.h"
+#include "Fcs.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+  struct Variant
+  {
+    float emphasis;
+    float slicer_level;
+  };
+
+    // The decoder variants in the order they are used. The first one is the
+    // standard decoder. A positive emphasis boost the higher frequency and
+    // a negative emphasis boost the lower frequency.
+  const Variant variants[] =
+  {
+    {  0.0f,  0.0f },
+    {  0.6f,  0.0f },
+    { -0.6f,  0.0f },
+    {  0.0f,  0.2f },
+    {  0.0f, -0.2f },
+    {  0.6f,  0.2f },
+    {  0.6f, -0.2f },
+    { -0.6f,  0.2f },
+    { -0.6f, -0.2f }
+  };
+}; /* anonymous namespace */
+
+
+class AfskMultiDecoder::Decoder : public sigc::trackable
+{
+  public:
+    Decoder(unsigned f0, unsigned f1, unsigned baudrate,
+            unsigned sample_rate, const Variant &variant)
+      : emphasis(variant.emphasis), prev(0.0f),
+        demod(f0, f1, baudrate, sample_rate), sync(baudrate, sample_rate)
+    {
+      demod.registerSink(&sync);
+      sync.setSlicerLevel(variant.slicer_level);
+      sync.bitsReceived.connect(
+          mem_fun(deframer, &HdlcDeframer::bitsReceived));
+      deframer.frameReceived.connect(
+          mem_fun(*this, &Decoder::onFrameReceived));
+    }
+
+    ~Decoder(void)
+    {
+      demod.unregisterSink();
+    }
+
+    void process(const float *samples, int count)
+    {
+      if (emphasis == 0.0f)
+      {
+        demod.writeSamples(samples, count);
+        return;
+      }
+
+        // First order emphasis filter, y[n] = x[n] - a * x[n-1]
+      buf.resize(count);
+      for (int i=0; i<count; ++i)
+      {
+        buf[i] = samples[i] - emphasis * prev;
+        prev = samples[i];
+      }
+      demod.writeSamples(&buf[0], count);
+    }
+
+    vector<vector<uint8_t> > frames;
+
+  private:
+    const float     emphasis;
+    float           prev;
+    vector<float>   buf;
+    AfskDemodulator demod;
+    Synchronizer    sync;
+    HdlcDeframer    deframer;
+
+    void onFrameReceived(vector<uint8_t> &frame)
+    {
+      frames.push_back(frame);
+    }
+}; /* AfskMultiDecoder::Decoder */
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AfskMultiDecoder::AfskMultiDecoder(unsigned f0, unsigned f1,
+                                   unsigned baudrate, unsigned decoder_cnt,
+                                   unsigned thread_cnt, unsigned sample_rate)
+  : sample_rate(sample_rate), block(0), block_len(0), generation(0),
+    pending(0), stop(false), sample_cnt(0)
+{
+  assert(sizeof(variants) / sizeof(*variants) == MAX_DECODERS);
+  if (decoder_cnt == 0)
+  {
+    decoder_cnt = 1;
+  }
+  else if (decoder_cnt > MAX_DECODERS)
+  {
+    decoder_cnt = MAX_DECODERS;
+  }
+  for (unsigned i=0; i<decoder_cnt; ++i)
+  {
+    decoders.push_back(
+        new Decoder(f0, f1, baudrate, sample_rate, variants[i]));
+  }
+
+  if (thread_cnt == 0)
+  {
+    thread_cnt = std::thread::hardware_concurrency();
+  }
+  if (thread_cnt > decoder_cnt)
+  {
+    thread_cnt = decoder_cnt;
+  }
+  for (unsigned idx=1; idx<thread_cnt; ++idx)
+  {
+    try
+    {
+      workers.push_back(std::thread(&AfskMultiDecoder::workerFunc, this, idx));
+    }
+    catch (const std::system_error &e)
+    {
+      cerr << "*** WARNING: Could not start AFSK decoder thread: "
+           << e.what() << endl;
+      break;
+    }
+  }
+} /* AfskMultiDecoder::AfskMultiDecoder */
+
+
+AfskMultiDecoder::~AfskMultiDecoder(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  work_cond.notify_all();
+  for (vector<std::thread>::iterator it=workers.begin();
+       it!=workers.end(); ++it)
+  {
+    it->join();
+  }
+
+  for (vector<Decoder*>::iterator it=decoders.begin();
+       it!=decoders.end(); ++it)
+  {
+    delete *it;
+  }
+} /* AfskMultiDecoder::~AfskMultiDecoder */
+
+
+int AfskMultiDecoder::writeSamples(const float *samples, int count)
+{
+  if (workers.empty())
+  {
+    processDecoders(0, samples, count);
+  }
+  else
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      block = samples;
+      block_len = count;
+      pending = workers.size();
+      ++generation;
+    }
+    work_cond.notify_all();
+
+    processDecoders(0, samples, count);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (pending > 0)
+    {
+      done_cond.wait(lock);
+    }
+  }
+
+  sample_cnt += count;
+  emitFrames();
+
+  return count;
+} /* AfskMultiDecoder::writeSamples */
+
+
+void AfskMultiDecoder::flushSamples(void)
+{
+  sourceAllSamplesFlushed();
+} /* AfskMultiDecoder::flushSamples */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void AfskMultiDecoder::processDecoders(unsigned thread_idx,
+                                       const float *samples, int count)
+{
+    // The decoders are spread evenly over the threads
+  for (size_t i=thread_idx; i<decoders.size(); i+=workers.size()+1)
+  {
+    decoders[i]->process(samples, count);
+  }
+} /* AfskMultiDecoder::processDecoders */
+
+
+void AfskMultiDecoder::workerFunc(unsigned thread_idx)
+{
+  unsigned handled_generation = 0;
+  for (;;)
+  {
+    const float *samples;
+    int count;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!stop && (generation == handled_generation))
+      {
+        work_cond.wait(lock);
+      }
+      if (stop)
+      {
+        return;
+      }
+      handled_generation = generation;
+      samples = block;
+      count = block_len;
+    }
+
+    processDecoders(thread_idx, samples, count);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--pending == 0)
+    {
+      done_cond.notify_one();
+    }
+  }
+} /* AfskMultiDecoder::workerFunc */
+
+
+void AfskMultiDecoder::emitFrames(void)
+{
+    // A frame received by more than one decoder normally end within a few
+    // milliseconds, depending on the filter delays of the decoders
+  const uint64_t window = sample_rate / 4;
+  while (!recent.empty() && (recent.front().time + window < sample_cnt))
+  {
+    recent.pop_front();
+  }
+
+  for (vector<Decoder*>::iterator it=decoders.begin();
+       it!=decoders.end(); ++it)
+  {
+    vector<vector<uint8_t> > &frames = (*it)->frames;
+    for (size_t i=0; i<frames.size(); ++i)
+    {
+      vector<uint8_t> &frame = frames[i];
+      const uint16_t fcs = fcsCalc(frame);
+      bool is_dup = false;
+      for (deque<RecentFrame>::const_iterator rit=recent.begin();
+           rit!=recent.end(); ++rit)
+      {
+        if ((rit->fcs == fcs) && (rit->len == frame.size()))
+        {
+          is_dup = true;
+          break;
+        }
+      }
+      if (!is_dup)
+      {
+        RecentFrame recent_frame;
+        recent_frame.fcs = fcs;
+        recent_frame.len = frame.size();
+        recent_frame.time = sample_cnt;
+        recent.push_back(recent_frame);
+        frameReceived(frame);
+      }
+    }
+    frames.clear();
+  }
+} /* AfskMultiDecoder::emitFrames */
+
+
+
+/*
+ * This file has not been truncated
+ */
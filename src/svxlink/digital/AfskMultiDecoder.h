@@ -0,0 +1,233 @@
+/**
+@file	 AfskMultiDecoder.h
+@brief   Decode AFSK using several demodulator variants in parallel
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef AFSK_MULTI_DECODER_INCLUDED
+#define AFSK_MULTI_DECODER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sigc++/sigc++.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Decode AFSK using several demodulator variants in parallel
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class run the same audio through several AFSK decoders, each made up of
+an AfskDemodulator, a Synchronizer and an HdlcDeframer. The decoders differ in
+the pre-emphasis applied before the demodulator and in the decision level of
+the bit slicer, so a frame that is lost by one decoder, due to a skewed
+frequency response or a DC offset, may still be received by another one.
+The first decoder is always the same as a single standard decoder.
+
+Only frames that pass the FCS check are received by a decoder. The same frame
+is normally received by more than one decoder so a frame is only emitted once
+within a short time window. Frames are compared using their FCS and length.
+
+The decoders are divided between the calling thread and a number of worker
+threads. Each block of samples is processed by all threads in parallel and
+writeSamples return when all decoders have processed the block, so the
+frameReceived signal is always emitted in the calling thread.
+*/
+class AfskMultiDecoder : public Async::AudioSink, public sigc::trackable
+{
+  public:
+    /**
+     * @brief   The maximum number of decoder variants
+     */
+    static const unsigned MAX_DECODERS = 9;
+
+    /**
+     * @brief 	Constuctor
+     * @param   f0          Lower audio frequency
+     * @param   f1          Upper audio frequency
+     * @param   baudrate    The baudrate of the datastream
+     * @param   decoder_cnt The number of decoder variants to run
+     * @param   thread_cnt  The maximum number of threads to use, including
+     *                      the calling thread. 0 mean one thread per
+     *                      available CPU core.
+     * @param   sample_rate The sample rate of the audio stream
+     */
+    AfskMultiDecoder(unsigned f0, unsigned f1, unsigned baudrate,
+                     unsigned decoder_cnt, unsigned thread_cnt=0,
+                     unsigned sample_rate=INTERNAL_SAMPLE_RATE);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~AfskMultiDecoder(void);
+
+    /**
+     * @brief   Get the number of decoder variants
+     * @return  Returns the number of decoders
+     */
+    unsigned decoderCount(void) const { return decoders.size(); }
+
+    /**
+     * @brief   Get the number of threads used, including the calling thread
+     * @return  Returns the number of threads
+     */
+    unsigned threadCount(void) const { return workers.size() + 1; }
+
+    /**
+     * @brief 	Write samples into this audio sink
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the sink to flush the previously written samples
+     */
+    virtual void flushSamples(void);
+
+    /**
+     * @brief 	Signal that is emitted when a complete frame have been received
+     * @param 	frame The received frame bytes, without the FCS
+     */
+    sigc::signal<void, std::vector<uint8_t>&> frameReceived;
+
+  private:
+    class Decoder;
+
+    struct RecentFrame
+    {
+      uint16_t  fcs;
+      size_t    len;
+      uint64_t  time;
+    };
+
+    const unsigned            sample_rate;
+    std::vector<Decoder*>     decoders;
+    std::vector<std::thread>  workers;
+    std::mutex                mutex;
+    std::condition_variable   work_cond;
+    std::condition_variable   done_cond;
+    const float *             block;
+    int                       block_len;
+    unsigned                  generation;
+    unsigned                  pending;
+    bool                      stop;
+    uint64_t                  sample_cnt;
+    std::deque<RecentFrame>   recent;
+
+    AfskMultiDecoder(const AfskMultiDecoder&);
+    AfskMultiDecoder& operator=(const AfskMultiDecoder&);
+    void processDecoders(unsigned thread_idx, const float *samples, int count);
+    void workerFunc(unsigned thread_idx);
+    void emitFrames(void);
+
+};  /* class AfskMultiDecoder */
+
+
+//} /* namespace */
+
+#endif /* AFSK_MULTI_DECODER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
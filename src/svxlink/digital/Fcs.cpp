@@ -6,7 +6,7 @@
 
 \verbatim
 SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
-Copyright (C) 2003-2018 Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -64,8 +64,6 @@ using namespace std;
  *
  ****************************************************************************/
 
-#define PPPINITFCS      0xffff	/* Initial FCS value */
-#define PPPGOODFCS      0xf0b8	/* Good final FCS value */
 
 
 /****************************************************************************
@@ -82,9 +80,6 @@ using namespace std;
  *
  ****************************************************************************/
 
-namespace {
-  uint16_t pppfcs(uint16_t fcs, const uint8_t *cp, size_t len);
-};
 
 
 /****************************************************************************
@@ -141,6 +136,34 @@ namespace {
     0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
     0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
   };
+
+  /*
+   * Tables for calculating the FCS eight bytes at a time (slicing-by-8).
+   * Entry i in table k is the FCS contribution of byte value i followed
+   * by k zero bytes.
+   */
+  struct SliceTables
+  {
+    uint16_t tab[8][256];
+
+    SliceTables(void)
+    {
+      for (unsigned i=0; i<256; ++i)
+      {
+        tab[0][i] = fcstab[i];
+      }
+      for (unsigned k=1; k<8; ++k)
+      {
+        for (unsigned i=0; i<256; ++i)
+        {
+          const uint16_t prev = tab[k-1][i];
+          tab[k][i] = (prev >> 8) ^ fcstab[prev & 0xff];
+        }
+      }
+    }
+  };
+
+  const SliceTables slice;
 };
 
 
@@ -151,45 +174,44 @@ namespace {
  *
  ****************************************************************************/
 
-uint16_t fcsCalc(const std::vector<uint8_t> buf)
+uint16_t fcsUpdate(uint16_t fcs, const uint8_t *buf, size_t len)
 {
-  uint16_t fcs = PPPINITFCS;
-  fcs = pppfcs(fcs, buf.data(), buf.size());
-  fcs ^= 0xffff;
+  const uint16_t (*tab)[256] = slice.tab;
+  while (len >= 8)
+  {
+    fcs ^= buf[0] | (buf[1] << 8);
+    fcs = tab[7][fcs & 0xff] ^ tab[6][fcs >> 8] ^
+          tab[5][buf[2]] ^ tab[4][buf[3]] ^ tab[3][buf[4]] ^
+          tab[2][buf[5]] ^ tab[1][buf[6]] ^ tab[0][buf[7]];
+    buf += 8;
+    len -= 8;
+  }
+  while (len-- > 0)
+  {
+    fcs = (fcs >> 8) ^ fcstab[(fcs ^ *buf++) & 0xff];
+  }
   return fcs;
-} /* fcsCalc */
+} /* fcsUpdate */
 
 
-bool fcsOk(const std::vector<uint8_t> buf)
+uint16_t fcsUpdate(uint16_t fcs, uint8_t byte)
 {
-  uint16_t fcs = PPPINITFCS;
-  fcs = pppfcs(fcs, buf.data(), buf.size());
-  return (fcs == PPPGOODFCS);
-} /* fcsOk */
+  return (fcs >> 8) ^ fcstab[(fcs ^ byte) & 0xff];
+} /* fcsUpdate */
 
 
-/****************************************************************************
- *
- * Private functions
- *
- ****************************************************************************/
+uint16_t fcsCalc(const uint8_t *buf, size_t len)
+{
+  return fcsUpdate(FCS_INIT, buf, len) ^ 0xffff;
+} /* fcsCalc */
 
-namespace {
 
-/*
- * Calculate a new fcs given the current fcs and the new data.
- */
-uint16_t pppfcs(uint16_t fcs, const uint8_t *cp, size_t len)
+bool fcsOk(const uint8_t *buf, size_t len)
 {
-  while (len--)
-  {
-    fcs = (fcs >> 8) ^ fcstab[(fcs ^ *cp++) & 0xff];
-  }
+  return (fcsUpdate(FCS_INIT, buf, len) == FCS_GOOD);
+} /* fcsOk */
 
-  return (fcs);
-}
 
-}; /* namespace */
 
 /*
  * This file has not been truncated
@@ -6,7 +6,7 @@
 
 \verbatim
 SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
-Copyright (C) 2003-2018 Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -35,6 +35,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <stdint.h>
+#include <stddef.h>
+
 #include <vector>
 
 
@@ -102,20 +104,71 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+/**
+ * @brief   The FCS value to start an incremental calculation with
+ */
+const uint16_t FCS_INIT = 0xffff;
+
+/**
+ * @brief   The FCS value after a frame including its FCS has been processed
+ */
+const uint16_t FCS_GOOD = 0xf0b8;
+
+/**
+ * @brief   Add data to an incremental frame check sequence calculation
+ * @param   fcs The current FCS value, FCS_INIT for the first call
+ * @param   buf Pointer to the data bytes
+ * @param   len The number of data bytes
+ * @return  Return the updated FCS value
+ *
+ * When all bytes of a frame, including the transmitted FCS, have been added
+ * the returned value will be FCS_GOOD if the frame is valid.
+ */
+uint16_t fcsUpdate(uint16_t fcs, const uint8_t *buf, size_t len);
+
+/**
+ * @brief   Add one byte to an incremental frame check sequence calculation
+ * @param   fcs   The current FCS value, FCS_INIT for the first call
+ * @param   byte  The data byte
+ * @return  Return the updated FCS value
+ */
+uint16_t fcsUpdate(uint16_t fcs, uint8_t byte);
+
+/**
+ * @brief   Calculate the frame check sequence for the given data
+ * @param   buf Pointer to the data bytes
+ * @param   len The number of data bytes
+ * @return  Return the 16 bit frame check sequence
+ */
+uint16_t fcsCalc(const uint8_t *buf, size_t len);
+
 /**
  * @brief   Calculate the frame check sequence for the given frame buffer
  * @param   buf The buffer containing the data bytes
  * @return  Return the 16 bit frame check sequence
  */
-uint16_t fcsCalc(const std::vector<uint8_t> buf);
+inline uint16_t fcsCalc(const std::vector<uint8_t> &buf)
+{
+  return fcsCalc(buf.data(), buf.size());
+}
+
+/**
+ * @brief   Check if the data contain a valid data stream
+ * @param   buf Pointer to the data bytes followed by the transmitted FCS
+ * @param   len The number of bytes, including the FCS
+ * @return  Returns \em true on success or \em false on failure
+ */
+bool fcsOk(const uint8_t *buf, size_t len);
 
 /**
  * @brief   Check if the buffer contain a valid data stream
  * @param   buf The buffer containing the data bytes and the transmitted FCS
  * @return  Returns \em true on success or \em false on failure
  * */
-bool fcsOk(const std::vector<uint8_t> buf);
-
+inline bool fcsOk(const std::vector<uint8_t> &buf)
+{
+  return fcsOk(buf.data(), buf.size());
+}
 
 //} /* namespace */
 
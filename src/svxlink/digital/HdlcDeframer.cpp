@@ -75,6 +75,48 @@ using namespace std;
  *
  ****************************************************************************/
 
+namespace {
+  /*
+   * For each number of preceeding one bits (0-4) and each received byte,
+   * the number of trailing one bits after the byte has been received. If
+   * the byte contain a stuffed zero or a flag, NOT_CLEAN is stored instead.
+   */
+  class ByteTable
+  {
+    public:
+      static const uint8_t NOT_CLEAN = 0xff;
+
+      uint8_t ones_after[5][256];
+
+      ByteTable(void)
+      {
+        for (unsigned ones_in=0; ones_in<5; ++ones_in)
+        {
+          for (unsigned byte=0; byte<256; ++byte)
+          {
+            unsigned ones = ones_in;
+            bool clean = true;
+            for (unsigned i=0; i<8; ++i)
+            {
+              if ((byte >> i) & 1)
+              {
+                if (++ones >= 5)
+                {
+                  clean = false;
+                }
+              }
+              else
+              {
+                ones = 0;
+              }
+            }
+            ones_after[ones_in][byte] = clean ? ones : NOT_CLEAN;
+          }
+        }
+      }
+  };
+}; /* Anonymous namespace */
+
 
 
 /****************************************************************************
@@ -99,6 +141,8 @@ using namespace std;
  *
  ****************************************************************************/
 
+static const ByteTable byte_table;
+
 
 
 /****************************************************************************
@@ -108,7 +152,8 @@ using namespace std;
  ****************************************************************************/
 
 HdlcDeframer::HdlcDeframer(void)
-  : state(STATE_SYNCHRONIZING), next_byte(0), bit_cnt(0), ones(0)
+  : state(STATE_SYNCHRONIZING), next_byte(0), bit_cnt(0), ones(0),
+    fcs(FCS_INIT)
 {
 } /* HdlcDeframer::HdlcDeframer */
 
@@ -118,113 +163,47 @@ HdlcDeframer::~HdlcDeframer(void)
 } /* HdlcDeframer::~HdlcDeframer */
 
 
-void HdlcDeframer::bitsReceived(vector<bool> &bits)
+void HdlcDeframer::bitsReceived(const vector<uint8_t> &bits)
 {
-  for (size_t i=0; i<bits.size(); ++i)
+  for (vector<uint8_t>::const_iterator it=bits.begin(); it!=bits.end(); ++it)
   {
-    bool flag_detected = false;
+    const uint8_t byte = *it;
 
-      // Undo bitstuffing. If we receive a zero and the previous five bits
-      // have been ones, the zero should be thrown away.
-    if (bits[i])
+      // Most bytes do not contain a flag or a stuffed bit. Those bytes
+      // are handled a whole byte at a time.
+    if ((ones < 5) && (state != STATE_FRAME_START_WAIT))
     {
-      ones += 1;
-    }
-    else
-    {
-      if (ones == 5)
-      {
-        ones = 0;
-        continue;
-      }
-      else if (ones == 6)
+      const uint8_t ones_after = byte_table.ones_after[ones][byte];
+      if (ones_after != ByteTable::NOT_CLEAN)
       {
-        flag_detected = true;
-      }
-      ones = 0;
-    }
-
-    next_byte >>= 1;
-    next_byte |= (bits[i] << 7);
-    switch (state)
-    {
-      case STATE_SYNCHRONIZING:
-        if (next_byte == 0x7e)
+        ones = ones_after;
+        if (state == STATE_SYNCHRONIZING)
         {
-          state = STATE_FRAME_START_WAIT;
-          bit_cnt = 0;
+          next_byte = byte;
         }
-        break;
-
-      case STATE_FRAME_START_WAIT:
-        if (++bit_cnt >= 8)
+        else if (frame.size() < MAX_FRAME_SIZE)
         {
-          if (next_byte != 0x7e)
-          {
-            state = STATE_RECEIVING;
-            frame.clear();
-            frame.push_back(next_byte);
-          }
-          //frame.push_back(next_byte);
-          bit_cnt = 0;
+            // The bit_cnt bits already received go first, then the first
+            // 8 - bit_cnt bits of this byte. The rest start the next byte.
+          const uint8_t data =
+            (next_byte >> (8 - bit_cnt)) | (byte << bit_cnt);
+          frame.push_back(data);
+          fcs = fcsUpdate(fcs, data);
+          next_byte = byte & static_cast<uint8_t>(0xff << (8 - bit_cnt));
         }
-        else if (next_byte == 0x7e)
+        else
         {
+          state = STATE_SYNCHRONIZING;
+          next_byte = byte;
           bit_cnt = 0;
-          //frame.clear();
-          //frame.push_back(next_byte);
         }
-        break;
+        continue;
+      }
+    }
 
-      case STATE_RECEIVING:
-        if (++bit_cnt >= 8)
-        {
-          if (flag_detected)
-          {
-            state = STATE_FRAME_START_WAIT;
-            /*
-            for (size_t i=0; i<frame.size(); ++i)
-            {
-              if (isprint(frame[i]))
-              {
-                cout << setw(2) << setfill(' ') << (char)frame[i];
-              }
-              else
-              {
-                cout << hex << setw(2) << setfill('0')
-                     << (int)frame[i] << " ";
-              }
-            }
-            cout << endl << endl;
-            */
-            if ((frame.size() > 2) && fcsOk(frame))
-            {
-                // Remove CRC from frame
-              frame.pop_back();
-              frame.pop_back();
-              frameReceived(frame);
-            }
-          }
-          else
-          {
-            if(frame.size() < 330)
-            {
-              frame.push_back(next_byte);
-              next_byte = 0;
-            }
-            else
-            {
-              state = STATE_SYNCHRONIZING;
-            }
-          }
-          bit_cnt = 0;
-        }
-        else if (flag_detected)
-        {
-          state = STATE_FRAME_START_WAIT;
-          bit_cnt = 0;
-        }
-        break;
+    for (int i=0; i<8; ++i)
+    {
+      bitReceived((byte >> i) & 1);
     }
   }
 } /* HdlcDeframer::bitsReceived */
@@ -244,6 +223,118 @@ void HdlcDeframer::bitsReceived(vector<bool> &bits)
  *
  ****************************************************************************/
 
+void HdlcDeframer::bitReceived(bool bit)
+{
+  bool flag_detected = false;
+
+    // Undo bitstuffing. If we receive a zero and the previous five bits
+    // have been ones, the zero should be thrown away.
+  if (bit)
+  {
+    ones += 1;
+  }
+  else
+  {
+    if (ones == 5)
+    {
+      ones = 0;
+      return;
+    }
+    else if (ones == 6)
+    {
+      flag_detected = true;
+    }
+    ones = 0;
+  }
+
+  next_byte >>= 1;
+  next_byte |= (bit << 7);
+  switch (state)
+  {
+    case STATE_SYNCHRONIZING:
+      if (next_byte == 0x7e)
+      {
+        state = STATE_FRAME_START_WAIT;
+        bit_cnt = 0;
+      }
+      break;
+
+    case STATE_FRAME_START_WAIT:
+      if (++bit_cnt >= 8)
+      {
+        if (next_byte != 0x7e)
+        {
+          state = STATE_RECEIVING;
+          frame.clear();
+          frame.push_back(next_byte);
+          fcs = fcsUpdate(FCS_INIT, next_byte);
+        }
+        //frame.push_back(next_byte);
+        bit_cnt = 0;
+      }
+      else if (next_byte == 0x7e)
+      {
+        bit_cnt = 0;
+        //frame.clear();
+        //frame.push_back(next_byte);
+      }
+      break;
+
+    case STATE_RECEIVING:
+      if (++bit_cnt >= 8)
+      {
+        if (flag_detected)
+        {
+          state = STATE_FRAME_START_WAIT;
+          /*
+          for (size_t i=0; i<frame.size(); ++i)
+          {
+            if (isprint(frame[i]))
+            {
+              cout << setw(2) << setfill(' ') << (char)frame[i];
+            }
+            else
+            {
+              cout << hex << setw(2) << setfill('0')
+                   << (int)frame[i] << " ";
+            }
+          }
+          cout << endl << endl;
+          */
+            // The FCS has been updated with each received byte, including
+            // the two transmitted FCS bytes
+          if ((frame.size() > 2) && (fcs == FCS_GOOD))
+          {
+              // Remove CRC from frame
+            frame.pop_back();
+            frame.pop_back();
+            frameReceived(frame);
+          }
+        }
+        else
+        {
+          if (frame.size() < MAX_FRAME_SIZE)
+          {
+            frame.push_back(next_byte);
+            fcs = fcsUpdate(fcs, next_byte);
+            next_byte = 0;
+          }
+          else
+          {
+            state = STATE_SYNCHRONIZING;
+          }
+        }
+        bit_cnt = 0;
+      }
+      else if (flag_detected)
+      {
+        state = STATE_FRAME_START_WAIT;
+        bit_cnt = 0;
+      }
+      break;
+  }
+} /* HdlcDeframer::bitReceived */
+
 
 
 /*
@@ -128,9 +128,12 @@ class HdlcDeframer : public sigc::trackable
 
     /**
      * @brief 	Process bitstream
-     * @param 	bits The bitstream to process
+     * @param 	bits The bitstream to process, packed eight bits to a byte
+     *
+     * The first bit in each byte is the least significant bit, which is
+     * the format produced by the Synchronizer.
      */
-    void bitsReceived(std::vector<bool> &bits);
+    void bitsReceived(const std::vector<uint8_t> &bits);
 
     /**
      * @brief 	Signal that is emitted when a complete frame have been received
@@ -143,14 +146,18 @@ class HdlcDeframer : public sigc::trackable
       STATE_SYNCHRONIZING, STATE_FRAME_START_WAIT, STATE_RECEIVING
     } State;
 
+    static const size_t   MAX_FRAME_SIZE = 330;
+
     State                 state;
     uint8_t               next_byte;
     uint8_t               bit_cnt;
     std::vector<uint8_t>  frame;
     unsigned              ones;
+    uint16_t              fcs;
 
     HdlcDeframer(const HdlcDeframer&);
     HdlcDeframer& operator=(const HdlcDeframer&);
+    void bitReceived(bool bit);
 
 };  /* class HdlcDeframer */
 
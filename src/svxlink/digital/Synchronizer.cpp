@@ -31,6 +31,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <iostream>
+#include <cmath>
 
 
 /****************************************************************************
@@ -107,10 +108,11 @@ using namespace std;
 
 Synchronizer::Synchronizer(unsigned baudrate, unsigned sample_rate)
   : baudrate(baudrate), sample_rate(sample_rate),
-    shift_pos(sample_rate / 2), pos(0), was_mark(false),
+    shift_pos(sample_rate / 2), pos(0), next_byte(0), bit_cnt(0),
+    was_mark(false), slicer_level(0.0f), avg_mag(0.0f),
     last_stored_was_mark(false)
 {
-  bitbuf.reserve(8);
+  bitbuf.reserve(64);
 } /* Synchronizer::Synchronizer */
 
 
@@ -129,6 +131,13 @@ int Synchronizer::writeSamples(const float *samples, int len)
       // Find out if it's a mark or space
     //bool is_mark = was_mark ? (samples[i] > -0.005) : (samples[i] > 0.005);
     bool is_mark = (samples[i] > 0);
+    if (slicer_level != 0.0f)
+    {
+        // Track the average magnitude over about ten symbols
+      avg_mag += (fabsf(samples[i]) - avg_mag) *
+                 (0.1f * baudrate / sample_rate);
+      is_mark = (samples[i] > slicer_level * avg_mag);
+    }
 
       // If it's a transition, adjust bit clock
     if (is_mark != was_mark)
@@ -145,25 +154,24 @@ int Synchronizer::writeSamples(const float *samples, int len)
       // Extract bit if pos >= sample_rate
     if (pos >= sample_rate)
     {
-      bitbuf.push_back(is_mark == last_stored_was_mark);
+      next_byte |= (is_mark == last_stored_was_mark) << bit_cnt;
       last_stored_was_mark = is_mark;
-      if (bitbuf.size() >= 8)
+      if (++bit_cnt == 8)
       {
-        /*
-        for (size_t i=0; i<bitbuf.size(); ++i)
-        {
-          cout << (bitbuf[i] ? '1' : '0');
-        }
-        float err_percent = 100.0 * static_cast<float>(err) / sample_rate;
-        cout << "  " << err << " " << err_percent << "%" << endl;
-        */
-        bitsReceived(bitbuf);
-        bitbuf.clear();
+        bitbuf.push_back(next_byte);
+        next_byte = 0;
+        bit_cnt = 0;
       }
       pos -= sample_rate;
     }
   }
 
+  if (!bitbuf.empty())
+  {
+    bitsReceived(bitbuf);
+    bitbuf.clear();
+  }
+
   return len;
 } /* Synchronizer::writeSamples */
 
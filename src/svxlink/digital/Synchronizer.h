@@ -36,6 +36,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <vector>
 #include <sigc++/sigc++.h>
+#include <stdint.h>
 
 
 /****************************************************************************
@@ -150,19 +151,38 @@ class Synchronizer : public Async::AudioSink, public sigc::trackable
      */
     void flushSamples(void);
 
+    /**
+     * @brief   Set the decision level of the bit slicer
+     * @param   level The level relative to the average signal magnitude
+     *
+     * By default a sample is a mark if it is above zero. A non zero level
+     * move the decision level up or down by the given fraction of the
+     * average magnitude of the incoming samples. This is used to run
+     * several synchronizers with different decision levels in parallel.
+     */
+    void setSlicerLevel(float level) { slicer_level = level; }
+
     /**
      * @brief   A signal emitted when new bits have been received
-     * @param   A vector of received bits
+     * @param   bits The received bits packed eight to a byte
+     *
+     * The first received bit in each byte is the least significant bit.
+     * Only whole bytes are emitted. The bits received in one call to
+     * writeSamples are emitted together.
      */
-    sigc::signal<void, std::vector<bool>&> bitsReceived;
+    sigc::signal<void, const std::vector<uint8_t>&> bitsReceived;
 
   private:
-    const unsigned    baudrate;
-    const unsigned    sample_rate;
-    const unsigned    shift_pos;
-    unsigned          pos;
-    std::vector<bool> bitbuf;
-    bool              was_mark;
+    const unsigned        baudrate;
+    const unsigned        sample_rate;
+    const unsigned        shift_pos;
+    unsigned              pos;
+    std::vector<uint8_t>  bitbuf;
+    uint8_t               next_byte;
+    unsigned              bit_cnt;
+    bool                  was_mark;
+    float                 slicer_level;
+    float                 avg_mag;
     bool              last_stored_was_mark;
     int               err;
 
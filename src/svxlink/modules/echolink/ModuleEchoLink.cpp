@@ -52,15 +52,21 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioSplitter.h>
 #include <AsyncAudioValve.h>
 #include <AsyncAudioSelector.h>
+#include <AsyncAudioDecimator.h>
+#include <AsyncAudioInterpolator.h>
 #include <EchoLinkDirectory.h>
 #include <EchoLinkDispatcher.h>
 #include <EchoLinkProxy.h>
+#include <EchoLinkGsmStreamEncoder.h>
 #include <LocationInfo.h>
 #include <common.h>
+#include <EventHandler.h>
+#include <MsgHandler.h>
 
 
 #include <AsyncPty.h>
 #include <AsyncPtyStreamBuf.h>
+#include <AsyncAudioMultirateCoeffs.h>
 
 /****************************************************************************
  *
@@ -166,10 +172,11 @@ ModuleEchoLink::ModuleEchoLink(void *dl_handle, Logic *logic,
     state(STATE_NORMAL), cbc_timer(0), dbc_timer(0), drop_incoming_regex(0),
     reject_incoming_regex(0), accept_incoming_regex(0),
     reject_outgoing_regex(0), accept_outgoing_regex(0), splitter(0),
-    listen_only_valve(0), selector(0), num_con_max(0), num_con_ttl(5*60),
+    gsm_encoder(0), listen_only_valve(0), selector(0), num_con_max(0), num_con_ttl(5*60),
     num_con_block_time(120*60), num_con_update_timer(0), reject_conf(false),
     autocon_echolink_id(0), autocon_time(DEFAULT_AUTOCON_TIME),
-    autocon_timer(0), proxy(0), pty(0)
+    autocon_timer(0), proxy(0), pty(0), remote_event_handler(0),
+    remote_event_qso(0), remote_event_msg_begun(false), link_idle_timer(0)
 {
   cout << "\tModule EchoLink v" MODULE_ECHO_LINK_VERSION " starting...\n";
   
@@ -368,18 +375,63 @@ bool ModuleEchoLink::initialize(void)
         mem_fun(*this, &ModuleEchoLink::onIncomingConnection));
   }
 
+  if (!createRemoteEventHandler())
+  {
+    moduleCleanup();
+    return false;
+  }
+
+    // One timer check the idle timeout for all connections
+  int link_idle_timeout = 0;
+  if (cfg().getValue(cfgName(), "LINK_IDLE_TIMEOUT", link_idle_timeout) &&
+      (link_idle_timeout > 0))
+  {
+    link_idle_timer = new Timer(1000, Timer::TYPE_PERIODIC);
+    link_idle_timer->expired.connect(
+        sigc::hide(mem_fun(*this, &ModuleEchoLink::checkLinkIdle)));
+  }
+
     // Create audio pipe chain for audio transmitted to the remote EchoLink
-    // stations: <from core> -> Valve -> Splitter (-> QsoImpl ...)
+    // stations: <from core> -> Valve -> Decimator -> Splitter (-> QsoImpl ...)
+    // The audio is down sampled to the EchoLink rate before it is split so
+    // that it is done once, not once per connection. All listening stations
+    // that use the GSM codec share one encoder, fed by the splitter.
   listen_only_valve = new AudioValve;
   AudioSink::setHandler(listen_only_valve);
-  
+  AudioSource *prev_src = listen_only_valve;
+
+#if INTERNAL_SAMPLE_RATE == 16000
+  AudioDecimator *down_sampler = new AudioDecimator(
+          2, coeff_16_8, coeff_16_8_taps);
+  prev_src->registerSink(down_sampler, true);
+  prev_src = down_sampler;
+#endif
+
   splitter = new AudioSplitter;
-  listen_only_valve->registerSink(splitter);
+  prev_src->registerSink(splitter);
+  prev_src = 0;
+
+  gsm_encoder = new GsmStreamEncoder;
+  gsm_encoder->packetEncoded.connect(
+      mem_fun(*this, &ModuleEchoLink::sendSharedGsmAudio));
+  splitter->addSink(gsm_encoder);
 
     // Create audio pipe chain for audio received from the remove EchoLink
-    // stations: (QsoImpl -> ) Selector -> Fifo -> <to core>
+    // stations: (QsoImpl -> ) Selector -> Interpolator -> <to core>
+    // The connections deliver audio at the EchoLink rate so it is only up
+    // sampled once, after the selector.
   selector = new AudioSelector;
-  AudioSource::setHandler(selector);
+  prev_src = selector;
+
+#if INTERNAL_SAMPLE_RATE == 16000
+  AudioInterpolator *up_sampler = new AudioInterpolator(
+          2, coeff_16_8, coeff_16_8_taps);
+  prev_src->registerSink(up_sampler, true);
+  prev_src = up_sampler;
+#endif
+
+  AudioSource::setHandler(prev_src);
+  prev_src = 0;
   
     // Periodic updates of the "watch num connects" list
   if (num_con_max > 0)
@@ -408,6 +460,7 @@ bool ModuleEchoLink::initialize(void)
            << name() << "/" << "COMMAND_PTY" << endl;
       return false;
     }
+    pty->setLineBuffered(true);
     pty->dataReceived.connect(
         sigc::mem_fun(*this, &ModuleEchoLink::onCommandPtyInput));
   }
@@ -420,6 +473,27 @@ bool ModuleEchoLink::initialize(void)
 } /* ModuleEchoLink::initialize */
 
 
+void ModuleEchoLink::processRemoteEvent(QsoImpl *qso, const string& event)
+{
+    // Save the current target since ending a message may cause events for
+    // other connections
+  QsoImpl *prev_qso = remote_event_qso;
+  bool prev_msg_begun = remote_event_msg_begun;
+  remote_event_qso = qso;
+  remote_event_msg_begun = false;
+  remote_event_handler->setVariable(name() + "::listen_only_active",
+                                    qso->isListenOnly() ? "1" : "0");
+  remote_event_handler->processEvent(event);
+  bool msg_begun = remote_event_msg_begun;
+  remote_event_qso = prev_qso;
+  remote_event_msg_begun = prev_msg_begun;
+  if (msg_begun)
+  {
+    qso->msgHandler()->end();
+  }
+} /* ModuleEchoLink::processRemoteEvent */
+
+
 
 /****************************************************************************
  *
@@ -509,29 +583,9 @@ void ModuleEchoLink::handlePtyCommand(const std::string &full_command)
 
 void ModuleEchoLink::onCommandPtyInput(const void *buf, size_t count)
 {
+    // The PTY is line buffered so each call contain exactly one command
   const char *buffer = reinterpret_cast<const char*>(buf);
-  for (size_t i=0; i<count; ++i)
-  {
-    char ch = buffer[i];
-    switch (ch)
-    {
-      case '\n':  // Execute command on NL
-        handlePtyCommand(command_buf);
-        command_buf.clear();
-        break;
-
-      case '\r':  // Ignore CR
-        break;
-
-      default:    // Append character to command buffer
-        if (command_buf.size() >= 256)  // Prevent cmd buffer growing too big
-        {
-          command_buf.clear();
-        }
-        command_buf += ch;
-        break;
-    }
-  }
+  handlePtyCommand(std::string(buffer, buffer + count));
 } /* ModuleEchoLink::onCommandPtyInput */
 
 
@@ -591,12 +645,19 @@ void ModuleEchoLink::moduleCleanup(void)
   AudioSink::clearHandler();
   delete splitter;
   splitter = 0;
+  delete gsm_encoder;
+  gsm_encoder = 0;
   delete listen_only_valve;
   listen_only_valve = 0;
   
   AudioSource::clearHandler();
   delete selector;
   selector = 0;
+
+  delete link_idle_timer;
+  link_idle_timer = 0;
+  delete remote_event_handler;
+  remote_event_handler = 0;
 } /* ModuleEchoLink::moduleCleanup */
 
 
@@ -1052,6 +1113,7 @@ void ModuleEchoLink::onIncomingConnection(const IpAddress& ip,
   splitter->addSink(qso);
   selector->addSource(qso);
   selector->enableAutoSelect(qso, 0);
+  updateSharedGsmEncoder();
 
   if (qsos.size() > max_qsos)
   {
@@ -1122,6 +1184,8 @@ void ModuleEchoLink::onIncomingConnection(const IpAddress& ip,
  */
 void ModuleEchoLink::onStateChange(QsoImpl *qso, Qso::State qso_state)
 {
+  updateSharedGsmEncoder();
+
   switch (qso_state)
   {
     case Qso::STATE_DISCONNECTED:
@@ -1294,6 +1358,8 @@ void ModuleEchoLink::onIsReceiving(bool is_receiving, QsoImpl *qso)
       broadcastTalkerStatus();
     }
   }
+
+  updateSharedGsmEncoder();
 } /* onIsReceiving */
 
 
@@ -1315,6 +1381,7 @@ void ModuleEchoLink::destroyQsoObject(QsoImpl *qso)
   if (talker == qso)
   {
     talker = findFirstTalker();
+    updateSharedGsmEncoder();
   }
 
   it = find(outgoing_con_pending.begin(), outgoing_con_pending.end(), qso);
@@ -1457,6 +1524,7 @@ void ModuleEchoLink::createOutgoingConnection(const StationData &station)
     splitter->addSink(qso);
     selector->addSource(qso);
     selector->enableAutoSelect(qso, 0);
+    updateSharedGsmEncoder();
   }
     
   stringstream ss;
@@ -1503,6 +1571,42 @@ void ModuleEchoLink::audioFromRemoteRaw(Qso::RawPacket *packet,
 } /* ModuleEchoLink::audioFromRemoteRaw */
 
 
+void ModuleEchoLink::sendSharedGsmAudio(Qso::RawPacket *packet)
+{
+  vector<QsoImpl*>::iterator it;
+  for (it=qsos.begin(); it!=qsos.end(); ++it)
+  {
+    if (usesSharedGsmEncoder(*it))
+    {
+      (*it)->sendEncodedAudio(packet);
+    }
+  }
+} /* ModuleEchoLink::sendSharedGsmAudio */
+
+
+bool ModuleEchoLink::usesSharedGsmEncoder(QsoImpl *qso) const
+{
+    // The talking station keep its own encoder. Stations using SPEEX also
+    // encode their own audio since a SPEEX encoder keep per stream state.
+  return (qso != talker) &&
+         (qso->currentState() == Qso::STATE_CONNECTED) &&
+         qso->usesGsmCodec();
+} /* ModuleEchoLink::usesSharedGsmEncoder */
+
+
+void ModuleEchoLink::updateSharedGsmEncoder(void)
+{
+    // A connection that use the shared encoder must not get the audio from
+    // the splitter too. Disabling a splitter branch flush that connection
+    // so that no half filled block is left in its own encoder.
+  vector<QsoImpl*>::iterator it;
+  for (it=qsos.begin(); it!=qsos.end(); ++it)
+  {
+    splitter->enableSink(*it, !usesSharedGsmEncoder(*it));
+  }
+} /* ModuleEchoLink::updateSharedGsmEncoder */
+
+
 QsoImpl *ModuleEchoLink::findFirstTalker(void) const
 {
   vector<QsoImpl*>::const_iterator it;
@@ -2266,6 +2370,110 @@ void ModuleEchoLink::cfgValueUpdated(const std::string& section,
 } /* ModuleEchoLink::cfgValueUpdated */
 
 
+bool ModuleEchoLink::createRemoteEventHandler(void)
+{
+  string event_handler_script;
+  if (!cfg().getValue(logicName(), "EVENT_HANDLER", event_handler_script))
+  {
+    cerr << "*** ERROR: Config variable " << logicName()
+      	 << "/EVENT_HANDLER not set\n";
+    return false;
+  }
+
+    // The messages played to the remote stations are handled by an event
+    // handler of their own. It is shared by all connections to keep the
+    // cost of a new connection down.
+  remote_event_handler = new EventHandler(event_handler_script,
+      logicName() + ", module " + name() + " (remote)");
+  remote_event_handler->playFile.connect(
+      mem_fun(*this, &ModuleEchoLink::remotePlayFile));
+  remote_event_handler->playSilence.connect(
+      mem_fun(*this, &ModuleEchoLink::remotePlaySilence));
+  remote_event_handler->playTone.connect(
+      mem_fun(*this, &ModuleEchoLink::remotePlayTone));
+
+    // Workaround: Need to set the ID config variable and "logic_name"
+    // variable to load the TCL script.
+  remote_event_handler->processEvent("namespace eval EchoLink {}");
+  remote_event_handler->setVariable("EchoLink::CFG_ID", "0");
+  remote_event_handler->setVariable("logic_name", "Default");
+
+  remote_event_handler->processEvent("namespace eval Logic {}");
+  string default_lang;
+  if (cfg().getValue(cfgName(), "DEFAULT_LANG", default_lang))
+  {
+    remote_event_handler->setVariable("Logic::CFG_DEFAULT_LANG",
+                                      default_lang);
+  }
+  bool remote_rgr_sound = false;
+  cfg().getValue(cfgName(), "REMOTE_RGR_SOUND", remote_rgr_sound);
+  remote_event_handler->setVariable(name() + "::CFG_REMOTE_RGR_SOUND",
+                                    remote_rgr_sound ? "1" : "0");
+  remote_event_handler->setVariable(name() + "::listen_only_active", "0");
+
+  return remote_event_handler->initialize();
+} /* ModuleEchoLink::createRemoteEventHandler */
+
+
+MsgHandler *ModuleEchoLink::remoteEventMsgHandler(void)
+{
+  if (remote_event_qso == 0)
+  {
+    return 0;
+  }
+  MsgHandler *msg_handler = remote_event_qso->msgHandler();
+  if (!remote_event_msg_begun)
+  {
+    msg_handler->begin();
+    remote_event_msg_begun = true;
+  }
+  return msg_handler;
+} /* ModuleEchoLink::remoteEventMsgHandler */
+
+
+void ModuleEchoLink::remotePlayFile(const string& path)
+{
+  MsgHandler *msg_handler = remoteEventMsgHandler();
+  if (msg_handler != 0)
+  {
+    msg_handler->playFile(path, false);
+  }
+} /* ModuleEchoLink::remotePlayFile */
+
+
+void ModuleEchoLink::remotePlaySilence(int length)
+{
+  MsgHandler *msg_handler = remoteEventMsgHandler();
+  if (msg_handler != 0)
+  {
+    msg_handler->playSilence(length, false);
+  }
+} /* ModuleEchoLink::remotePlaySilence */
+
+
+void ModuleEchoLink::remotePlayTone(int fq, int amp, int length)
+{
+  MsgHandler *msg_handler = remoteEventMsgHandler();
+  if (msg_handler != 0)
+  {
+    msg_handler->playTone(fq, amp, length, false);
+  }
+} /* ModuleEchoLink::remotePlayTone */
+
+
+void ModuleEchoLink::checkLinkIdle(void)
+{
+    // A connection may be disconnected by the check so a copy of the list
+    // is iterated
+  vector<QsoImpl*> qsos_copy(qsos);
+  vector<QsoImpl*>::iterator it;
+  for (it=qsos_copy.begin(); it!=qsos_copy.end(); ++it)
+  {
+    (*it)->idleTimeoutCheck();
+  }
+} /* ModuleEchoLink::checkLinkIdle */
+
+
 /*
  * This file has not been truncated
  */
@@ -82,6 +82,7 @@ namespace EchoLink
   class Directory;
   class StationData;
   class Proxy;
+  class GsmStreamEncoder;
 };
 
 
@@ -102,6 +103,7 @@ namespace EchoLink
  ****************************************************************************/
 
 class MsgHandler;
+class EventHandler;
 class QsoImpl;
 class LocationInfo;
   
@@ -141,6 +143,16 @@ class ModuleEchoLink : public Module
     bool initialize(void);
     const char *compiledForVersion(void) const { return SVXLINK_VERSION; }
 
+    /**
+     * @brief   Run an event handler function for a connected station
+     * @param   qso   The connection that the event belong to
+     * @param   event The Tcl command to run
+     *
+     * All connections share one Tcl interpreter. Messages played by the
+     * event handler function are sent to the given connection only.
+     * Messages played later, e.g. from a Tcl timer, are thrown away.
+     */
+    void processRemoteEvent(QsoImpl *qso, const std::string& event);
     
   protected:
     /**
@@ -199,6 +211,7 @@ class ModuleEchoLink : public Module
     regex_t   	      	  *accept_outgoing_regex;
     EchoLink::StationData last_disc_stn;
     Async::AudioSplitter  *splitter;
+    EchoLink::GsmStreamEncoder *gsm_encoder;
     Async::AudioValve 	  *listen_only_valve;
     Async::AudioSelector  *selector;
     unsigned              num_con_max;
@@ -212,7 +225,10 @@ class ModuleEchoLink : public Module
     Async::Timer	  *autocon_timer;
     EchoLink::Proxy       *proxy;
     Async::Pty            *pty;
-    std::string           command_buf;
+    EventHandler          *remote_event_handler;
+    QsoImpl               *remote_event_qso;
+    bool                  remote_event_msg_begun;
+    Async::Timer          *link_idle_timer;
 
     void moduleCleanup(void);
     void activateInit(void);
@@ -238,6 +254,12 @@ class ModuleEchoLink : public Module
     void onInfoMsgReceived(QsoImpl *qso, const std::string& msg);
     void onIsReceiving(bool is_receiving, QsoImpl *qso);
     void destroyQsoObject(QsoImpl *qso);
+    bool createRemoteEventHandler(void);
+    MsgHandler *remoteEventMsgHandler(void);
+    void remotePlayFile(const std::string& path);
+    void remotePlaySilence(int length);
+    void remotePlayTone(int fq, int amp, int length);
+    void checkLinkIdle(void);
 
     void getDirectoryList(Async::Timer *timer=0);
 
@@ -245,6 +267,9 @@ class ModuleEchoLink : public Module
     int audioFromRemote(float *samples, int count, QsoImpl *qso);
     void audioFromRemoteRaw(EchoLink::Qso::RawPacket *packet,
       	      	      	    QsoImpl *qso);
+    void sendSharedGsmAudio(EchoLink::Qso::RawPacket *packet);
+    bool usesSharedGsmEncoder(QsoImpl *qso) const;
+    void updateSharedGsmEncoder(void);
     QsoImpl *findFirstTalker(void) const;
     void broadcastTalkerStatus(void);
     void updateDescription(void);
@@ -39,6 +39,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cstdlib>
 #include <sigc++/bind.h>
 #include <sstream>
+#include <iomanip>
 
 
 /****************************************************************************
@@ -53,11 +54,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioPassthrough.h>
 #include <AsyncAudioFifo.h>
 #include <AsyncAudioDecimator.h>
-#include <AsyncAudioInterpolator.h>
+#include <AsyncAudioJitterBuffer.h>
 #include <AsyncAudioDebugger.h>
+#include <AsyncAudioMultirateCoeffs.h>
 
 #include <MsgHandler.h>
-#include <EventHandler.h>
 
 
 /****************************************************************************
@@ -68,7 +69,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "ModuleEchoLink.h"
 #include "QsoImpl.h"
-#include "multirate_filter_coeff.h"
 
 
 /****************************************************************************
@@ -133,11 +133,11 @@ using namespace sigc;
 
 
 QsoImpl::QsoImpl(const StationData &station, ModuleEchoLink *module)
-  : m_qso(station.ip()), module(module), event_handler(0), msg_handler(0),
+  : m_qso(station.ip()), module(module), msg_handler(0),
     output_sel(0), init_ok(false), reject_qso(false), last_message(""),
-    last_info_msg(""), idle_timer(0), disc_when_done(false), idle_timer_cnt(0),
+    last_info_msg(""), disc_when_done(false), idle_timer_cnt(0),
     idle_timeout(0), destroy_timer(0), station(station), sink_handler(0),
-    logic_is_idle(true)
+    logic_is_idle(true), listen_only(false), jitter_buffer(0)
 {
   assert(module != 0);
 
@@ -176,78 +176,22 @@ QsoImpl::QsoImpl(const StationData &station, ModuleEchoLink *module)
   }
   m_qso.setLocalInfo(description);
   
-  string event_handler_script;
-  if (!cfg.getValue(module->logicName(), "EVENT_HANDLER", event_handler_script))
-  {
-    cerr << "*** ERROR: Config variable " << module->logicName()
-      	 << "/EVENT_HANDLER not set\n";
-    return;
-  }
-  
   string idle_timeout_str;
   if (cfg.getValue(cfg_name, "LINK_IDLE_TIMEOUT", idle_timeout_str))
   {
     idle_timeout = atoi(idle_timeout_str.c_str());
-    idle_timer = new Timer(1000, Timer::TYPE_PERIODIC);
-    idle_timer->expired.connect(mem_fun(*this, &QsoImpl::idleTimeoutCheck));
   }
   
   sink_handler = new AudioPassthrough;
   AudioSink::setHandler(sink_handler);
 
-  msg_handler = new MsgHandler(INTERNAL_SAMPLE_RATE);
-  msg_handler->allMsgsWritten.connect(
-      	  mem_fun(*this, &QsoImpl::allRemoteMsgsWritten));
-	  
-  AudioPacer *msg_pacer = new AudioPacer(INTERNAL_SAMPLE_RATE,
-      	      	                         160*4*(INTERNAL_SAMPLE_RATE / 8000),
-					 500);
-  msg_handler->registerSink(msg_pacer, true);
-  
+    // The audio from the logic core is already down sampled to 8kHz by
+    // the module, once for all connections. The message handler is added
+    // to the selector when the first message is played to this connection.
   output_sel = new AudioSelector;
   output_sel->addSource(sink_handler);
   output_sel->enableAutoSelect(sink_handler, 0);
-  output_sel->addSource(msg_pacer);
-  output_sel->enableAutoSelect(msg_pacer, 10);
-  AudioSource *prev_src = output_sel;
-
-#if INTERNAL_SAMPLE_RATE == 16000
-  AudioDecimator *down_sampler = new AudioDecimator(
-          2, coeff_16_8, coeff_16_8_taps);
-  prev_src->registerSink(down_sampler, true);
-  prev_src = down_sampler;
-#endif
-
-  prev_src->registerSink(&m_qso);
-  prev_src = 0;
-
-  event_handler = new EventHandler(event_handler_script,
-      module->logicName() + ", module " + module->name());
-  event_handler->playFile.connect(
-      sigc::bind(mem_fun(*msg_handler, &MsgHandler::playFile), false));
-  event_handler->playSilence.connect(
-      sigc::bind(mem_fun(*msg_handler, &MsgHandler::playSilence), false));
-  event_handler->playTone.connect(
-      sigc::bind(mem_fun(*msg_handler, &MsgHandler::playTone), false));
-
-    // Workaround: Need to set the ID config variable and "logic_name"
-    // variable to load the TCL script.
-  event_handler->processEvent("namespace eval EchoLink {}");
-  event_handler->setVariable("EchoLink::CFG_ID", "0");
-  event_handler->setVariable("logic_name", "Default");
-
-  event_handler->processEvent("namespace eval Logic {}");
-  string default_lang;
-  if (cfg.getValue(cfg_name, "DEFAULT_LANG", default_lang))
-  {
-    event_handler->setVariable("Logic::CFG_DEFAULT_LANG", default_lang);
-  }
-  bool remote_rgr_sound = false;
-  cfg.getValue(cfg_name, "REMOTE_RGR_SOUND", remote_rgr_sound);
-  event_handler->setVariable(module->name() + "::CFG_REMOTE_RGR_SOUND",
-                             remote_rgr_sound ? "1" : "0");
-  
-  event_handler->initialize();
+  output_sel->registerSink(&m_qso);
   
   m_qso.infoMsgReceived.connect(mem_fun(*this, &QsoImpl::onInfoMsgReceived));
   m_qso.chatMsgReceived.connect(mem_fun(*this, &QsoImpl::onChatMsgReceived));
@@ -256,20 +200,43 @@ QsoImpl::QsoImpl(const StationData &station, ModuleEchoLink *module)
   m_qso.audioReceivedRaw.connect(
       sigc::bind(audioReceivedRaw.make_slot(), this));
   
-  prev_src = &m_qso;
+  AudioSource *prev_src = &m_qso;
   
-  AudioFifo *input_fifo = new AudioFifo(2048);
-  input_fifo->setOverwrite(true);
-  input_fifo->setPrebufSamples(1024);
-  prev_src->registerSink(input_fifo, true);
-  prev_src = input_fifo;
-  
-#if INTERNAL_SAMPLE_RATE == 16000
-  AudioInterpolator *up_sampler = new AudioInterpolator(
-          2, coeff_16_8, coeff_16_8_taps);
-  prev_src->registerSink(up_sampler, true);
-  prev_src = up_sampler;
-#endif
+    // Each connection get a jitter buffer of its own so that the delay is
+    // adapted to the network path to that station. The audio is kept at the
+    // EchoLink rate here. It is up sampled by the module once for all
+    // connections.
+  bool jitter_buffer_adaptive = true;
+  cfg.getValue(cfg_name, "JITTER_BUFFER_ADAPTIVE", jitter_buffer_adaptive);
+  if (jitter_buffer_adaptive)
+  {
+    unsigned jitter_buffer_delay = 60;
+    cfg.getValue(cfg_name, "JITTER_BUFFER_DELAY", jitter_buffer_delay);
+    unsigned jitter_buffer_max_delay = 500;
+    cfg.getValue(cfg_name, "JITTER_BUFFER_MAX_DELAY", jitter_buffer_max_delay);
+    if (jitter_buffer_max_delay < jitter_buffer_delay)
+    {
+      cerr << "*** ERROR: Config variable " << cfg_name
+           << "/JITTER_BUFFER_MAX_DELAY must not be smaller than "
+              "JITTER_BUFFER_DELAY\n";
+      return;
+    }
+    jitter_buffer = new AudioJitterBuffer(jitter_buffer_delay,
+                                          jitter_buffer_max_delay, 8000);
+    jitter_buffer->setLossConcealment(true);
+    m_qso.audioPacketReceived.connect(
+        mem_fun(*jitter_buffer, &AudioJitterBuffer::markPacket));
+    prev_src->registerSink(jitter_buffer, true);
+    prev_src = jitter_buffer;
+  }
+  else
+  {
+    AudioFifo *input_fifo = new AudioFifo(2048);
+    input_fifo->setOverwrite(true);
+    input_fifo->setPrebufSamples(1024);
+    prev_src->registerSink(input_fifo, true);
+    prev_src = input_fifo;
+  }
 
   AudioSource::setHandler(prev_src);
   
@@ -282,11 +249,9 @@ QsoImpl::~QsoImpl(void)
 {
   AudioSink::clearHandler();
   AudioSource::clearHandler();
-  delete event_handler;
   delete output_sel;
   delete msg_handler;
   delete sink_handler;
-  delete idle_timer;
   delete destroy_timer;
 } /* QsoImpl::~QsoImpl */
 
@@ -312,7 +277,7 @@ bool QsoImpl::sendAudioRaw(Qso::RawPacket *packet)
 {
   idle_timer_cnt = 0;
   
-  if (!msg_handler->isWritingMessage())
+  if (!isWritingMessage())
   {
     return m_qso.sendAudioRaw(packet);
   }
@@ -322,6 +287,18 @@ bool QsoImpl::sendAudioRaw(Qso::RawPacket *packet)
 } /* QsoImpl::sendAudioRaw */
 
 
+bool QsoImpl::sendEncodedAudio(Qso::RawPacket *packet)
+{
+  if (!isWritingMessage())
+  {
+    return m_qso.sendAudioRaw(packet);
+  }
+
+  return true;
+
+} /* QsoImpl::sendEncodedAudio */
+
+
 bool QsoImpl::connect(void)
 {
   if (destroy_timer != 0)
@@ -340,10 +317,8 @@ bool QsoImpl::accept(void)
   bool success = m_qso.accept();
   if (success)
   {
-    msg_handler->begin();
-    event_handler->processEvent(string(module->name()) + "::remote_greeting " +
-                                remoteCallsign());
-    msg_handler->end();
+    module->processRemoteEvent(this,
+        string(module->name()) + "::remote_greeting " + remoteCallsign());
   }
   
   return success;
@@ -360,20 +335,17 @@ void QsoImpl::reject(bool perm)
   if (success)
   {
     sendChatData("The connection was rejected");
-    msg_handler->begin();
     stringstream ss;
     ss << module->name() << "::reject_remote_connection "
        << (perm ? "1" : "0");
-    event_handler->processEvent(ss.str());
-    msg_handler->end();
+    module->processRemoteEvent(this, ss.str());
   }
 } /* QsoImpl::reject */
 
 
 void QsoImpl::setListenOnly(bool enable)
 {
-  event_handler->setVariable(string(module->name()) + "::listen_only_active",
-                             enable ? "1" : "0");
+  listen_only = enable;
   if (enable)
   {
     string str("[listen only] ");
@@ -391,14 +363,70 @@ void QsoImpl::squelchOpen(bool is_open)
 {
   if (currentState() == Qso::STATE_CONNECTED)
   {
-    msg_handler->begin();
-    event_handler->processEvent(string(module->name()) + "::squelch_open " +
-         (is_open ? "1": "0"));
-    msg_handler->end();
+    module->processRemoteEvent(this,
+        string(module->name()) + "::squelch_open " + (is_open ? "1": "0"));
   }
 } /* QsoImpl::squelchOpen */
 
 
+MsgHandler *QsoImpl::msgHandler(void)
+{
+  if (msg_handler == 0)
+  {
+    msg_handler = new MsgHandler(INTERNAL_SAMPLE_RATE);
+    msg_handler->allMsgsWritten.connect(
+            mem_fun(*this, &QsoImpl::allRemoteMsgsWritten));
+
+    AudioPacer *msg_pacer = new AudioPacer(INTERNAL_SAMPLE_RATE,
+                                           160*4*(INTERNAL_SAMPLE_RATE / 8000),
+                                           500);
+    msg_handler->registerSink(msg_pacer, true);
+    AudioSource *prev_src = msg_pacer;
+
+#if INTERNAL_SAMPLE_RATE == 16000
+    AudioDecimator *down_sampler = new AudioDecimator(
+            2, coeff_16_8, coeff_16_8_taps);
+    prev_src->registerSink(down_sampler, true);
+    prev_src = down_sampler;
+#endif
+
+    output_sel->addSource(prev_src);
+    output_sel->enableAutoSelect(prev_src, 10);
+  }
+  return msg_handler;
+} /* QsoImpl::msgHandler */
+
+
+bool QsoImpl::isWritingMessage(void) const
+{
+  return (msg_handler != 0) && msg_handler->isWritingMessage();
+} /* QsoImpl::isWritingMessage */
+
+
+void QsoImpl::idleTimeoutCheck(void)
+{
+  if (receivingAudio() || !logic_is_idle)
+  {
+    idle_timer_cnt = 0;
+    return;
+  }
+
+  if (++idle_timer_cnt == idle_timeout)
+  {
+    cout << remoteCallsign()
+         << ": EchoLink connection idle timeout. Disconnecting..." << endl;
+    module->processEvent("link_inactivity_timeout");
+    disc_when_done = true;
+    module->processRemoteEvent(this,
+        string(module->name()) + "::remote_timeout");
+    if (!isWritingMessage())
+    {
+      disconnect();
+    }
+  }
+} /* QsoImpl::idleTimeoutCheck */
+
+
 /****************************************************************************
  *
  * Protected member functions
@@ -496,6 +524,27 @@ void QsoImpl::onChatMsgReceived(const string& msg)
  * Bugs:      
  *----------------------------------------------------------------------------
  */
+void QsoImpl::printJitterStats(void)
+{
+  if ((jitter_buffer == 0) || (jitter_buffer->stats().packets == 0))
+  {
+    return;
+  }
+
+  const AudioJitterBuffer::Stats& stats = jitter_buffer->stats();
+  cout << remoteCallsign() << ": Jitter buffer statistics:"
+       << " packets=" << stats.packets
+       << " lost=" << stats.lost
+       << " concealed=" << stats.concealed
+       << " underruns=" << stats.underruns
+       << " jitter=" << fixed << setprecision(1) << stats.jitter_ms << "ms"
+       << " target_delay=" << stats.target_delay_ms << "ms"
+       << endl;
+  cout.unsetf(ios::floatfield);
+  jitter_buffer->resetStats();
+} /* printJitterStats */
+
+
 void QsoImpl::onStateChange(Qso::State state)
 {
   cout << remoteCallsign() << ": EchoLink QSO state changed to ";
@@ -503,6 +552,7 @@ void QsoImpl::onStateChange(Qso::State state)
   {
     case Qso::STATE_DISCONNECTED:
       cout << "DISCONNECTED\n";
+      printJitterStats();
       if (!reject_qso)
       {
       	stringstream ss;
@@ -544,31 +594,6 @@ void QsoImpl::onStateChange(Qso::State state)
 } /* onStateChange */
 
 
-void QsoImpl::idleTimeoutCheck(Timer *t)
-{
-  if (receivingAudio() || !logic_is_idle)
-  {
-    idle_timer_cnt = 0;
-    return;
-  }
-
-  if (++idle_timer_cnt == idle_timeout)
-  {
-    cout << remoteCallsign()
-         << ": EchoLink connection idle timeout. Disconnecting..." << endl;
-    module->processEvent("link_inactivity_timeout");
-    disc_when_done = true;
-    msg_handler->begin();
-    event_handler->processEvent(string(module->name()) + "::remote_timeout");
-    msg_handler->end();
-    if (!msg_handler->isWritingMessage())
-    {
-      disconnect();
-    }
-  }
-} /* idleTimeoutCheck */
-
-
 void QsoImpl::destroyMeNow(Timer *t)
 {
   destroyMe(this);
@@ -72,6 +72,7 @@ namespace Async
   class Config;
   class AudioPacer;
   class AudioPassthrough;
+  class AudioJitterBuffer;
 };
 
 
@@ -92,7 +93,6 @@ namespace Async
  ****************************************************************************/
 
 class MsgHandler;
-class EventHandler;
 class AsyncTimer;
 class ModuleEchoLink;
 
@@ -167,6 +167,17 @@ class QsoImpl
      * audioReceivedRaw signal.
      */
     bool sendAudioRaw(EchoLink::Qso::RawPacket *packet);
+
+    /**
+     * @brief 	Send a GSM packet encoded from the local audio
+     * @param 	packet The packet to send
+     *
+     * This function is used to send packets from an encoder that is shared
+     * by many connections. Unlike sendAudioRaw, the packet does not count
+     * as activity on the link. Nothing is sent while a message is played
+     * to the remote station.
+     */
+    bool sendEncodedAudio(EchoLink::Qso::RawPacket *packet);
     
     /**
      * @brief 	Initiate a connection to the remote station
@@ -220,6 +231,8 @@ class QsoImpl
       return m_qso.currentState();
     }
 
+    bool usesGsmCodec(void) const { return m_qso.usesGsmCodec(); }
+
     void setRemoteParams(const std::string& priv) { m_qso.setRemoteParams(priv); }
 
     void setRemoteName(const std::string& name) { m_qso.setRemoteName(name); }
@@ -270,6 +283,32 @@ class QsoImpl
      */
     void squelchOpen(bool is_open);
 
+    /**
+     * @brief   Check if listen only mode is active
+     * @return  Returns \em true if listen only mode is active
+     */
+    bool isListenOnly(void) const { return listen_only; }
+
+    /**
+     * @brief   Get the handler for messages played to the remote station
+     * @return  Returns the message handler, which is created on first use
+     */
+    MsgHandler *msgHandler(void);
+
+    /**
+     * @brief   Check if a message is being played to the remote station
+     * @return  Returns \em true if a message is being played
+     */
+    bool isWritingMessage(void) const;
+
+    /**
+     * @brief   Check if the connection has been idle for too long
+     *
+     * This function should be called once every second. The connection is
+     * disconnected when it has been idle for LINK_IDLE_TIMEOUT seconds.
+     */
+    void idleTimeoutCheck(void);
+
     /**
      * @brief A signal that is emitted when the connection state changes
      * @param qso The QSO object
@@ -319,14 +358,12 @@ class QsoImpl
   private:
     EchoLink::Qso     	    m_qso;
     ModuleEchoLink    	    *module;
-    EventHandler      	    *event_handler;
     MsgHandler	      	    *msg_handler;
     Async::AudioSelector    *output_sel;
     bool      	      	    init_ok;
     bool      	      	    reject_qso;
     std::string       	    last_message;
     std::string       	    last_info_msg;
-    Async::Timer      	    *idle_timer;
     bool      	      	    disc_when_done;
     int       	      	    idle_timer_cnt;
     int       	      	    idle_timeout;
@@ -335,12 +372,14 @@ class QsoImpl
     Async::AudioPassthrough *sink_handler;
     std::string             sysop_name;
     bool                    logic_is_idle;
+    bool                    listen_only;
+    Async::AudioJitterBuffer *jitter_buffer;
     
     void allRemoteMsgsWritten(void);
     void onInfoMsgReceived(const std::string& msg);
     void onChatMsgReceived(const std::string& msg);
     void onStateChange(EchoLink::Qso::State state);
-    void idleTimeoutCheck(Async::Timer *t);
+    void printJitterStats(void);
     void destroyMeNow(Async::Timer *t);
 
 };  /* class QsoImpl */
@@ -135,6 +135,25 @@ proc rf_disable {status activate} {
   playMsg "rf_disable";
 }
 
+
+#
+# Executed when a client has joined the channel. Nothing is reported for
+# the clients that are on the channel when connecting to the server.
+#   client - The callsign and name of the client
+#
+proc client_joined {client} {
+  printInfo "Client joined: $client";
+}
+
+
+#
+# Executed when a client has left the channel
+#   client - The callsign and name of the client
+#
+proc client_left {client} {
+  printInfo "Client left: $client";
+}
+
 # end of namespace
 }
 
@@ -48,6 +48,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioJitterFifo.h>
 #include <AsyncAudioDecimator.h>
 #include <AsyncAudioInterpolator.h>
+#include <AsyncAudioMultirateCoeffs.h>
 
 
 /****************************************************************************
@@ -57,7 +58,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 #include <version/MODULE_FRN.h>
 #include "ModuleFrn.h"
-#include "multirate_filter_coeff.h"
 
 
 /****************************************************************************
@@ -193,6 +193,10 @@ bool ModuleFrn::initialize(void)
   qso = new QsoFrn(this);
   qso->error.connect(
       mem_fun(*this, &ModuleFrn::onQsoError));
+  qso->clientJoined.connect(
+      mem_fun(*this, &ModuleFrn::onClientJoined));
+  qso->clientLeft.connect(
+      mem_fun(*this, &ModuleFrn::onClientLeft));
 
   // rig/mic -> frn
   audio_valve = new AudioValve;
@@ -485,6 +489,34 @@ void ModuleFrn::onQsoError(void)
   deactivateMe();
 }
 
+
+void ModuleFrn::onClientJoined(const string& client)
+{
+  clientEvent("client_joined", client);
+}
+
+
+void ModuleFrn::onClientLeft(const string& client)
+{
+  clientEvent("client_left", client);
+}
+
+
+void ModuleFrn::clientEvent(const char *event, const string& client)
+{
+    // Escape TCL control characters
+  string escaped;
+  for (string::const_iterator it = client.begin(); it != client.end(); ++it)
+  {
+    if ((*it == '\\') || (*it == '{') || (*it == '}'))
+      escaped += '\\';
+    escaped += *it;
+  }
+  stringstream ss;
+  ss << event << " [subst -nocommands -novariables {" << escaped << "}]";
+  processEvent(ss.str());
+}
+
 /*
  * This file has not been truncated
  */
@@ -138,6 +138,9 @@ class ModuleFrn : public Module
     void reportState(void);
     bool validateCommand(const std::string& cmd, size_t argc);
     void onQsoError(void);
+    void onClientJoined(const std::string& client);
+    void onClientLeft(const std::string& client);
+    void clientEvent(const char *event, const std::string& client);
 
   private:
     QsoFrn *qso;
@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  * System Includes
  *
  ****************************************************************************/
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <cstdlib>
@@ -67,7 +68,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Utils.h"
 #include "ModuleFrn.h"
 #include "QsoFrn.h"
-#include "multirate_filter_coeff.h"
 
 
 /****************************************************************************
@@ -103,6 +103,9 @@ using namespace FrnUtils;
  *
  ****************************************************************************/
 
+static void float_to_s16(short *dst, const float *src, int count);
+static void s16_to_float(float *dst, const short *src, int count);
+static std::string client_name(const std::string &line);
 
 
 /****************************************************************************
@@ -137,8 +140,12 @@ QsoFrn::QsoFrn(ModuleFrn *module)
   , state(STATE_DISCONNECTED)
   , connect_retry_cnt(0)
   , send_buffer_cnt(0)
-  , gsmh(gsm_create())
+  , gsm_enc(gsm_create())
+  , gsm_dec(gsm_create())
+  , is_tx_blocked(false)
   , lines_to_read(-1)
+  , client_list_gen(0)
+  , is_client_table_valid(false)
   , is_receiving_voice(false)
   , is_rf_disabled(false)
   , reconnect_timeout_ms(RECONNECT_TIMEOUT_TIME)
@@ -240,8 +247,11 @@ QsoFrn::QsoFrn(ModuleFrn *module)
     return;
   }
 
+    // The WAV49 frame pairing is kept in the codec state so the encoder and
+    // the decoder must have a state each
   int gsm_one = 1;
-  assert(gsm_option(gsmh, GSM_OPT_WAV49, &gsm_one) != -1);
+  assert(gsm_option(gsm_enc, GSM_OPT_WAV49, &gsm_one) != -1);
+  assert(gsm_option(gsm_dec, GSM_OPT_WAV49, &gsm_one) != -1);
 
   tcp_client->connected.connect(
       mem_fun(*this, &QsoFrn::onConnected));
@@ -296,8 +306,10 @@ QsoFrn::~QsoFrn(void)
   delete keepalive_timer;
   keepalive_timer = 0;
 
-  gsm_destroy(gsmh);
-  gsmh = 0;
+  gsm_destroy(gsm_enc);
+  gsm_enc = 0;
+  gsm_destroy(gsm_dec);
+  gsm_dec = 0;
 }
 
 
@@ -329,6 +341,9 @@ void QsoFrn::disconnect(void)
   {
     tcp_client->disconnect();
   }
+  clearTxQueue();
+  client_table.clear();
+  is_client_table_valid = false;
 }
 
 
@@ -386,16 +401,10 @@ int QsoFrn::writeSamples(const float *samples, int count)
   while (samples_read < count)
   {
     int read_cnt = min(BUFFER_SIZE - send_buffer_cnt, count-samples_read);
-    for (int i = 0; i < read_cnt; i++)
-    {
-      float sample = samples[samples_read++];
-      if (sample > 1)
-        send_buffer[send_buffer_cnt++] = 32767;
-      else if (sample < -1)
-        send_buffer[send_buffer_cnt++] = -32767;
-      else
-        send_buffer[send_buffer_cnt++] = static_cast<int16_t>(32767.0 * sample);
-    }
+    float_to_s16(send_buffer + send_buffer_cnt, samples + samples_read,
+                 read_cnt);
+    send_buffer_cnt += read_cnt;
+    samples_read += read_cnt;
     if (send_buffer_cnt == BUFFER_SIZE)
     {
       if (state == STATE_TX_AUDIO)
@@ -502,34 +511,78 @@ void QsoFrn::login(void)
   s << endl;
 
   std::string req = s.str();
-  tcp_client->write(req.c_str(), req.length());
+  sendData(req.c_str(), req.length());
 }
 
 void QsoFrn::sendVoiceData(short *data, int len)
 {
   assert(len == BUFFER_SIZE);
 
-  size_t nbytes = 0;
-  unsigned char gsm_data[FRN_AUDIO_PACKET_SIZE];
+  if (!tcp_client->isConnected())
+  {
+    return;
+  }
 
+    // The server is not keeping up. Drop the packet rather than letting the
+    // delay grow.
+  if (tx_queue.size() > TX_QUEUE_MAX_SIZE)
+  {
+    cerr << "FRN server is not keeping up, dropping voice packet" << endl;
+    return;
+  }
+
+    // The TX1 request and the voice data is sent in one write
+  unsigned char packet[TX1_REQUEST_SIZE + FRN_AUDIO_PACKET_SIZE];
+  memcpy(packet, "TX1\r\n", TX1_REQUEST_SIZE);
+  unsigned char *gsm_data = packet + TX1_REQUEST_SIZE;
   for (int nframe = 0; nframe < FRAME_COUNT; nframe++)
   {
     short * src = data + nframe * PCM_FRAME_SIZE;
     unsigned char * dst = gsm_data + nframe * GSM_FRAME_SIZE;
 
     // GSM_OPT_WAV49, produce alternating frames 32, 33, 32, 33, ..
-    gsm_encode(gsmh, src, dst);
-    gsm_encode(gsmh, src + PCM_FRAME_SIZE / 2, dst + 32);
+    gsm_encode(gsm_enc, src, dst);
+    gsm_encode(gsm_enc, src + PCM_FRAME_SIZE / 2, dst + 32);
+  }
+  if (opt_frn_debug)
+    cout << "req:   TX1" << endl;
+  sendData(packet, sizeof(packet));
+}
 
-    nbytes += GSM_FRAME_SIZE;
+
+void QsoFrn::sendData(const void *data, size_t len)
+{
+  tx_queue.append(static_cast<const char*>(data), len);
+  if (!is_tx_blocked)
+  {
+    flushTxQueue();
+  }
+}
+
+
+void QsoFrn::flushTxQueue(void)
+{
+  if (tx_queue.empty() || !tcp_client->isConnected())
+  {
+    return;
   }
-  sendRequest(RQ_TX1);
-  size_t written = tcp_client->write(gsm_data, nbytes);
-  if (written != nbytes)
+
+    // Everything queued while the server was behind is written at once
+  int written = tcp_client->write(tx_queue.data(), tx_queue.size());
+  if (written < 0)
   {
-    cerr << "not all voice data was written to FRN: "
-         << written << "\\" << nbytes << endl;
+    cerr << "failed to write to FRN server" << endl;
+    tx_queue.clear();
+    return;
   }
+  tx_queue.erase(0, written);
+}
+
+
+void QsoFrn::clearTxQueue(void)
+{
+  tx_queue.clear();
+  is_tx_blocked = false;
 }
 
 
@@ -589,12 +642,7 @@ void QsoFrn::sendRequest(Request rq)
   {
     s << "\r\n";
     std::string rq_s = s.str();
-    size_t written = tcp_client->write(rq_s.c_str(), rq_s.length());
-    if (written != rq_s.length())
-    {
-      cerr << "request " << rq_s << " was not written to FRN: "
-           << written << "\\" << rq_s.length() << endl;
-    }
+    sendData(rq_s.c_str(), rq_s.length());
   }
 }
 
@@ -602,8 +650,7 @@ void QsoFrn::sendRequest(Request rq)
 int QsoFrn::handleAudioData(unsigned char *data, int len)
 {
   unsigned char *gsm_data = data + CLIENT_INDEX_SIZE;
-  short *pcm_buffer = receive_buffer;
-  float pcm_samples[PCM_FRAME_SIZE];
+  float pcm_samples[BUFFER_SIZE];
 
   if (len < FRN_AUDIO_PACKET_SIZE + CLIENT_INDEX_SIZE)
     return 0;
@@ -621,36 +668,34 @@ int QsoFrn::handleAudioData(unsigned char *data, int len)
     for (int frameno = 0; frameno < FRAME_COUNT; frameno++)
     {
       unsigned char *src = gsm_data + frameno * GSM_FRAME_SIZE;
-      short *dst = pcm_buffer;
+      short *dst = receive_buffer + frameno * PCM_FRAME_SIZE;
       bool is_gsm_decode_success = true;
 
       // GSM_OPT_WAV49, consume alternating frames of size 33, 32, 33, 32, ..
-      if (gsm_decode(gsmh, src, dst) == -1)
+      if (gsm_decode(gsm_dec, src, dst) == -1)
         is_gsm_decode_success = false;
 
-      if (gsm_decode(gsmh, src + 33, dst + PCM_FRAME_SIZE / 2) == -1)
+      if (gsm_decode(gsm_dec, src + 33, dst + PCM_FRAME_SIZE / 2) == -1)
         is_gsm_decode_success = false;
 
       if (!is_gsm_decode_success)
         cerr << "gsm decoder failed to decode frame " << frameno << endl;
+    }
 
-      for (int i = 0; i < PCM_FRAME_SIZE; i++)
-         pcm_samples[i] = static_cast<float>(pcm_buffer[i]) / 32768.0;
-
-      int all_written = 0;
-      while (all_written < PCM_FRAME_SIZE)
+      // The whole packet is converted and written to the sink at once
+    s16_to_float(pcm_samples, receive_buffer, BUFFER_SIZE);
+    int all_written = 0;
+    while (all_written < BUFFER_SIZE)
+    {
+      int written = sinkWriteSamples(pcm_samples + all_written,
+          BUFFER_SIZE - all_written);
+      if (written == 0)
       {
-        int written = sinkWriteSamples(pcm_samples + all_written,
-            PCM_FRAME_SIZE - all_written);
-        if (written == 0)
-        {
-          cerr << "cannot write frame to sink, dropping sample "
-               << (PCM_FRAME_SIZE - all_written) << endl;
-          break;
-        }
-        all_written += written;
+        cerr << "cannot write frame to sink, dropping sample "
+             << (BUFFER_SIZE - all_written) << endl;
+        break;
       }
-      pcm_buffer += PCM_FRAME_SIZE;
+      all_written += written;
     }
   }
   setState(STATE_IDLE);
@@ -728,28 +773,53 @@ int QsoFrn::handleListHeader(unsigned char *data, int len)
 int QsoFrn::handleList(unsigned char *data, int len)
 {
   int bytes_read = 0;
-  std::string line;
-  std::istringstream lines(std::string((char*)data, len));
-  bool has_win_newline = hasWinNewline(lines);
 
-  if (hasLine(lines) && safeGetline(lines, line))
+    // Consume all complete lines in the buffer without copying it. A large
+    // list is often received in a few big chunks.
+  while ((lines_to_read != 0) && (bytes_read < len))
   {
+    const char *begin = reinterpret_cast<const char*>(data) + bytes_read;
+    const char *nl = static_cast<const char*>(
+        memchr(begin, '\n', len - bytes_read));
+    if (nl == 0)
+    {
+      break;
+    }
+    bytes_read += nl - begin + 1;
+    if ((bytes_read < len) && (data[bytes_read] == '\r'))
+    {
+      bytes_read += 1;
+    }
+    const char *end = nl;
+    if ((end > begin) && (end[-1] == '\r'))
+    {
+      --end;
+    }
+    std::string line(begin, end);
+
     if (lines_to_read == -1)
     {
       lines_to_read = atoi(line.c_str());
     }
     else
     {
+      if (state == STATE_RX_CLIENT_LIST)
+        updateClient(line);
       cur_item_list.push_back(line);
       lines_to_read--;
     }
-    bytes_read += line.length() + (has_win_newline ? 2 : 1);
   }
   if (lines_to_read == 0)
   {
     if (state == STATE_RX_CLIENT_LIST)
+    {
+      removeLeftClients();
       frnClientListReceived(cur_item_list);
-    frnListReceived(cur_item_list);
+    }
+    else
+    {
+      frnListReceived(cur_item_list);
+    }
     cur_item_list.clear();
     lines_to_read = -1;
     setState(STATE_IDLE);
@@ -759,6 +829,43 @@ int QsoFrn::handleList(unsigned char *data, int len)
 }
 
 
+void QsoFrn::updateClient(const std::string &line)
+{
+  std::pair<ClientTable::iterator, bool> res =
+    client_table.insert(std::make_pair(client_name(line), client_list_gen));
+  if (res.second)
+  {
+    if (is_client_table_valid)
+      clientJoined(res.first->first);
+  }
+  else
+  {
+    res.first->second = client_list_gen;
+  }
+}
+
+
+void QsoFrn::removeLeftClients(void)
+{
+  ClientTable::iterator it = client_table.begin();
+  while (it != client_table.end())
+  {
+    if (it->second != client_list_gen)
+    {
+      if (is_client_table_valid)
+        clientLeft(it->first);
+      client_table.erase(it++);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  is_client_table_valid = true;
+  ++client_list_gen;
+}
+
+
 int QsoFrn::handleLogin(unsigned char *data, int len, bool stage_one)
 {
   int bytes_read = 0;
@@ -824,6 +931,9 @@ void QsoFrn::onDisconnected(TcpConnection *conn,
   setState(STATE_DISCONNECTED);
 
   con_timeout_timer->setEnable(false);
+  clearTxQueue();
+  client_table.clear();
+  is_client_table_valid = false;
 
   switch (reason)
   {
@@ -931,7 +1041,13 @@ int QsoFrn::onDataReceived(TcpConnection *con, void *data, int len)
 
 void QsoFrn::onSendBufferFull(bool is_full)
 {
-  cerr << "send buffer is full " << is_full << endl;
+  if (opt_frn_debug)
+    cout << "send buffer is full " << is_full << endl;
+  is_tx_blocked = is_full;
+  if (!is_full)
+  {
+    flushTxQueue();
+  }
 }
 
 
@@ -984,7 +1100,9 @@ void QsoFrn::onFrnListReceived(const FrnList &list) const
 
 void QsoFrn::onFrnClientListReceived(const FrnList &list)
 {
-  cout << "FRN active client list updated" << endl;
+  if (opt_frn_debug)
+    cout << "FRN active client list updated: " << list.size()
+         << " clients" << endl;
   client_list = list;
 }
 
@@ -994,6 +1112,46 @@ void QsoFrn::onDelayedReconnect(Async::Timer *timer)
   reconnect();
 }
 
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static void float_to_s16(short *dst, const float *src, int count)
+{
+    // No branches in the loop so that the compiler can vectorize it
+  for (int i = 0; i < count; i++)
+  {
+    float sample = max(-1.0f, min(1.0f, src[i]));
+    dst[i] = static_cast<short>(32767.0f * sample);
+  }
+}
+
+
+static void s16_to_float(float *dst, const short *src, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    dst[i] = static_cast<float>(src[i]) * (1.0f / 32768.0f);
+  }
+}
+
+
+static std::string client_name(const std::string &line)
+{
+  std::string::size_type begin = line.find("<ON>");
+  if (begin == std::string::npos)
+    return line;
+  begin += 4;
+  std::string::size_type end = line.find("</ON>", begin);
+  if (end == std::string::npos)
+    return line;
+  return line.substr(begin, end - begin);
+}
+
+
 /*
  * This file has not been truncated
  */
@@ -38,6 +38,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 #include <string>
 #include <vector>
+#include <map>
 #include <sigc++/sigc++.h>
 
 
@@ -285,6 +286,21 @@ class QsoFrn
       */
      sigc::signal<void, State> stateChange;
 
+     /**
+      * @brief A client has joined the channel
+      * @param The callsign and name of the client
+      *
+      * Only emitted for changes after the first client list has been
+      * received.
+      */
+     sigc::signal<void, const std::string&> clientJoined;
+
+     /**
+      * @brief A client has left the channel
+      * @param The callsign and name of the client
+      */
+     sigc::signal<void, const std::string&> clientLeft;
+
  protected:
      /**
       * @brief The registered sink has flushed all samples
@@ -382,6 +398,28 @@ class QsoFrn
      */
     void sendVoiceData(short *data, int len);
 
+    /**
+     * @brief Queue data for sending to the FRN server
+     *
+     * @param Data to send
+     * @param Size of data
+     *
+     * The data is written directly if the TCP send buffer is not full. If it
+     * is, the data is queued and everything queued is written in one go when
+     * there is room in the send buffer again.
+     */
+    void sendData(const void *data, size_t len);
+
+    /**
+     * @brief Write as much of the transmit queue as possible to the server
+     */
+    void flushTxQueue(void);
+
+    /**
+     * @brief Throw away all queued data
+     */
+    void clearTxQueue(void);
+
     /**
      * @brief Sends FRN client request to the server
      *
@@ -451,6 +489,18 @@ class QsoFrn
      */
     int handleList(unsigned char *data, int len);
 
+    /**
+     * @brief Update the client table with one line of the client list
+     *
+     * @param xml FRN format client description line
+     */
+    void updateClient(const std::string &line);
+
+    /**
+     * @brief Remove the clients that were not in the last client list
+     */
+    void removeLeftClients(void);
+
     /**
      * @brief Called when connection to FRN server is established
      *
@@ -521,6 +571,9 @@ class QsoFrn
     void onDelayedReconnect(Async::Timer *timer);
 
   private:
+      // Client name to the generation of the client list it was last seen in
+    typedef std::map<std::string, unsigned> ClientTable;
+
     static const int        CLIENT_INDEX_SIZE       = 2;
     static const int        TCP_BUFFER_SIZE         = 65536;
     static const int        FRAME_COUNT             = 5;
@@ -528,6 +581,9 @@ class QsoFrn
     static const int        GSM_FRAME_SIZE          = 65;     // WAV49 has 65
     static const int        BUFFER_SIZE             = FRAME_COUNT*PCM_FRAME_SIZE;
     static const int        FRN_AUDIO_PACKET_SIZE   = FRAME_COUNT*GSM_FRAME_SIZE;
+    static const int        TX1_REQUEST_SIZE        = 5;      // "TX1\r\n"
+    static const size_t     TX_QUEUE_MAX_SIZE       =
+      5 * (TX1_REQUEST_SIZE + FRN_AUDIO_PACKET_SIZE);
 
     static const int        CON_TIMEOUT_TIME        = 30000;
     static const int        RX_TIMEOUT_TIME         = 1000;
@@ -550,10 +606,16 @@ class QsoFrn
     short               receive_buffer[BUFFER_SIZE];
     short               send_buffer[BUFFER_SIZE];
     int                 send_buffer_cnt;
-    gsm                 gsmh;
+    gsm                 gsm_enc;
+    gsm                 gsm_dec;
+    std::string         tx_queue;
+    bool                is_tx_blocked;
     int                 lines_to_read;
     FrnList             cur_item_list;
     FrnList             client_list;
+    ClientTable         client_table;
+    unsigned            client_list_gen;
+    bool                is_client_table_valid;
     bool                is_receiving_voice;
     bool                is_rf_disabled;
     int                 reconnect_timeout_ms;
@@ -40,7 +40,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sstream>
 #include <time.h>
 #include <algorithm>
-#include <queue>
+#include <cassert>
 #include <regex.h>
 
 
@@ -152,6 +152,13 @@ using namespace SvxLink;
  *
  ****************************************************************************/
 
+/*
+ * A process wide fetcher for the weather reports. All module instances share
+ * one curl multi handle. Requests for an URL that is already being fetched
+ * are coalesced into the ongoing transfer and successful responses are kept
+ * in a cache so that logics asking for the same airport do not fetch the
+ * same report again.
+ */
 class ModuleMetarInfo::Http : public sigc::trackable
 {
    struct WatchSet
@@ -165,15 +172,96 @@ class ModuleMetarInfo::Http : public sigc::trackable
      Async::FdWatch wr;
    };
    typedef std::map<int, WatchSet> WatchMap;
-   CURLM* multi_handle; 
+   typedef sigc::signal<void, bool, const std::string&> ResultSignal;
+   struct Request
+   {
+     std::string  url;
+     std::string  body;
+     ResultSignal done;
+     CURL*        curl;
+     Request(void) : curl(0) {}
+   };
+   typedef std::map<std::string, Request> RequestMap;
+   struct CacheEntry
+   {
+     time_t       fetched;
+     std::string  body;
+   };
+   typedef std::map<std::string, CacheEntry> CacheMap;
+
+   static const long TRANSFER_TIMEOUT = 30;
+
+   static Http     *instance;
+   static unsigned ref_cnt;
+
+   CURLM* multi_handle;
    Async::Timer update_timer;
    WatchMap watch_map;
-   std::queue<CURL*> url_queue;
-   CURL* pending_curl;
+   RequestMap requests;
+   CacheMap cache;
 
   public:
 
-   Http() : multi_handle(0), pending_curl(0)
+   // get the shared fetcher, release must be called when done with it
+   static Http *acquire(void)
+   {
+     if (ref_cnt++ == 0)
+     {
+       instance = new Http;
+     }
+     return instance;
+   } /* acquire */
+
+   static void release(void)
+   {
+     assert(ref_cnt > 0);
+     if (--ref_cnt == 0)
+     {
+       delete instance;
+       instance = 0;
+     }
+   } /* release */
+
+   // fetch an URL, the slot is called with the result when done. A cached
+   // response younger than max_age seconds is delivered directly.
+   sigc::connection fetch(const std::string& url, unsigned max_age,
+                          const ResultSignal::slot_type& slot)
+   {
+     CacheMap::iterator cit = cache.find(url);
+     if (cit != cache.end())
+     {
+       if (difftime(time(0), cit->second.fetched) < max_age)
+       {
+         std::string body(cit->second.body);
+         slot(true, body);
+         return sigc::connection();
+       }
+       cache.erase(cit);
+     }
+
+     std::pair<RequestMap::iterator, bool> res =
+       requests.insert(std::make_pair(url, Request()));
+     Request& req = res.first->second;
+     sigc::connection con = req.done.connect(slot);
+     if (res.second)
+     {
+       req.url = url;
+       CURL* curl = curl_easy_init();
+       curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+       curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &Http::callback);
+       curl_easy_setopt(curl, CURLOPT_WRITEDATA, &req);
+       curl_easy_setopt(curl, CURLOPT_PRIVATE, &req);
+       curl_easy_setopt(curl, CURLOPT_TIMEOUT, TRANSFER_TIMEOUT);
+       req.curl = curl;
+       curl_multi_add_handle(multi_handle, curl);
+       perform();
+     }
+     return con;
+   } /* fetch */
+
+  private:
+
+   Http() : multi_handle(0)
    {
      multi_handle = curl_multi_init();
      long curl_timeout = -1;
@@ -185,108 +273,86 @@ class ModuleMetarInfo::Http : public sigc::trackable
 
    ~Http()
    {
-     if (pending_curl)
-       curl_easy_cleanup(pending_curl);
-     while (!url_queue.empty())
+     disableAllWatches();
+     for (RequestMap::iterator it = requests.begin(); it != requests.end();
+          ++it)
      {
-       curl_easy_cleanup(url_queue.front());
-       url_queue.pop();
+       curl_multi_remove_handle(multi_handle, it->second.curl);
+       curl_easy_cleanup(it->second.curl);
      }
-     disableAllWatches();
      curl_multi_cleanup(multi_handle);
    } /* ~Http */
 
-   // a signal when a metar has been available
-   sigc::signal<void, std::string, size_t> metarInfo;
-
-   // a signal when a metar has a timeout
-   sigc::signal<void> metarTimeout;
-
-
    // update the html handler periodically
    void onTimeout(Async::Timer *timer)
+   {
+     perform();
+   } /* onTimeout */
+
+   void onActivity(Async::FdWatch *watch)
+   {
+     perform();
+   } /* onActivity */
+
+   void perform(void)
    {
      int handle_count;
      curl_multi_perform(multi_handle, &handle_count);
-     if (handle_count == 0) 
+
+     CURLMsg *msg;
+     int msgs_left;
+     while ((msg = curl_multi_info_read(multi_handle, &msgs_left)) != 0)
      {
-       disableAllWatches();
-       curl_easy_cleanup(pending_curl);
-       if (url_queue.empty())
+       if (msg->msg != CURLMSG_DONE)
        {
-         pending_curl = 0;
-         update_timer.setEnable(false);
-       }
-       else
-       {
-         pending_curl = url_queue.front();
-         url_queue.pop();
-         curl_multi_add_handle(multi_handle, pending_curl);
-         update_timer.setEnable(true);
+         continue;
        }
+       CURL* curl = msg->easy_handle;
+       CURLcode result = msg->data.result;
+       char *priv = 0;
+       curl_easy_getinfo(curl, CURLINFO_PRIVATE, &priv);
+       long response_code = 0;
+       curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+       curl_multi_remove_handle(multi_handle, curl);
+       curl_easy_cleanup(curl);
+       finish(reinterpret_cast<Request*>(priv), result == CURLE_OK,
+              response_code == 200);
      }
+
+     disableAllWatches();
      updateWatchMap();
+     update_timer.setEnable(!requests.empty());
      update_timer.reset();
-   } /* Update */
+   } /* perform */
 
-   void onActivity(Async::FdWatch *watch)
+   void finish(Request* req, bool success, bool cacheable)
    {
-     int handle_count;
-     curl_multi_perform(multi_handle, &handle_count);
-     if (handle_count == 0)
+       // The request is removed before the result is delivered so that a
+       // receiver may request the same URL again
+     RequestMap::iterator it = requests.find(req->url);
+     assert(it != requests.end());
+     ResultSignal done(it->second.done);
+     std::string body;
+     body.swap(it->second.body);
+     if (success && cacheable)
      {
-       disableAllWatches();
-       curl_easy_cleanup(pending_curl);
-       if (url_queue.empty())
-       {
-         pending_curl = 0;
-         update_timer.setEnable(false);
-       }
-       else
-       {
-         pending_curl = url_queue.front();
-         url_queue.pop();
-         curl_multi_add_handle(multi_handle, pending_curl);
-         updateWatchMap();
-         update_timer.setEnable(true);
-       }
+       CacheEntry& entry = cache[it->first];
+       entry.fetched = time(0);
+       entry.body = body;
      }
-     update_timer.reset();
-   } /* onActivity */
+     requests.erase(it);
+     done(success, body);
+   } /* finish */
 
    static size_t callback(char *contents, size_t size, size_t nmemb,
                                        void *userp)
    {
      if (userp == NULL) return 0;
      size_t written = size * nmemb;
-     std::string html((const char *)contents, written);
-     static_cast<Http*>(userp)->metarInfo(html, html.size());
+     static_cast<Request*>(userp)->body.append(contents, written);
      return written;
    } /* callback */
 
-   void AddRequest(const char* uri)
-   {
-     CURL* curl = curl_easy_init();
-     curl_easy_setopt(curl, CURLOPT_URL, uri);
-     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &Http::callback);
-     curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
-
-     if (!pending_curl)
-     {
-       pending_curl = curl;
-       curl_multi_add_handle(multi_handle, pending_curl);
-       updateWatchMap();
-       update_timer.reset();
-       update_timer.setEnable(true);
-     }
-     else
-     {
-       url_queue.push(curl);
-     }
-   } /* AddRequest */
-
-  private:
-
    void updateWatchMap()
    {
      fd_set fdread;
@@ -299,7 +365,7 @@ class ModuleMetarInfo::Http : public sigc::trackable
      FD_ZERO(&fdexcep);
      curl_multi_fdset(multi_handle, &fdread, &fdwrite, &fdexcep, &maxfd);
 
-     for (int fd = 0; fd <= maxfd; fd++) 
+     for (int fd = 0; fd <= maxfd; fd++)
      {
        bool read_isset = FD_ISSET(fd, &fdread);
        bool write_isset = FD_ISSET(fd, &fdwrite);
@@ -316,17 +382,17 @@ class ModuleMetarInfo::Http : public sigc::trackable
            continue;
          }
          ws = &(watch_map[fd]);
+         ws->rd.activity.connect(mem_fun(*this, &Http::onActivity));
+         ws->wr.activity.connect(mem_fun(*this, &Http::onActivity));
        }
        if (read_isset && !ws->rd.isEnabled())
        {
          ws->rd.setFd(fd, Async::FdWatch::FD_WATCH_RD);
-         ws->rd.activity.connect(mem_fun(*this, &Http::onActivity));
          ws->rd.setEnabled(true);
        }
        if (write_isset && !ws->wr.isEnabled())
        {
          ws->wr.setFd(fd, Async::FdWatch::FD_WATCH_WR);
-         ws->wr.activity.connect(mem_fun(*this, &Http::onActivity));
          ws->wr.setEnabled(true);
        }
      }
@@ -343,6 +409,9 @@ class ModuleMetarInfo::Http : public sigc::trackable
    } /* disableAllWatches */
 };
 
+ModuleMetarInfo::Http *ModuleMetarInfo::Http::instance = 0;
+unsigned ModuleMetarInfo::Http::ref_cnt = 0;
+
 
 /****************************************************************************
  *
@@ -410,7 +479,8 @@ extern "C" {
 
 ModuleMetarInfo::ModuleMetarInfo(void *dl_handle, Logic *logic,
                                  const string& cfg_name)
-  : Module(dl_handle, logic, cfg_name), remarks(false), debug(false), http(0)
+  : Module(dl_handle, logic, cfg_name), remarks(false), debug(false),
+    cache_ttl(DEFAULT_CACHE_TTL), http(Http::acquire())
 {
   cout << "\tModule MetarInfo v" MODULE_METAR_INFO_VERSION " starting...\n";
 
@@ -419,7 +489,9 @@ ModuleMetarInfo::ModuleMetarInfo(void *dl_handle, Logic *logic,
 
 ModuleMetarInfo::~ModuleMetarInfo(void)
 {
-
+  closeConnection();
+  http = 0;
+  Http::release();
 } /* ~ModuleMetarInfo */
 
 
@@ -596,6 +668,8 @@ bool ModuleMetarInfo::initialize(void)
 
   cfg().getValue(cfgName(), "LINK", link);
 
+  cfg().getValue(cfgName(), "CACHE_TTL", cache_ttl);
+
   // long messages or short messages
   // nosig -> "nosig"  == short message
   //       -> "no significant change" == long message
@@ -857,28 +931,36 @@ void ModuleMetarInfo::openConnection(void)
 {
   closeConnection();
 
-  http = new Http();
-
   html = "";
   std::string path = server;
               path += link;
               path += icao;
 
-  http->AddRequest(path.c_str());
   cout << path << endl;
-  http->metarInfo.connect(mem_fun(*this, &ModuleMetarInfo::onData));
-  http->metarTimeout.connect(mem_fun(*this, &ModuleMetarInfo::onTimeout));
+  http_request = http->fetch(path, cache_ttl,
+      mem_fun(*this, &ModuleMetarInfo::onFetchDone));
 
 } /* openConnection */
 
 
 void ModuleMetarInfo::closeConnection(void)
 {
-  delete http;
-  http = 0;
+  http_request.disconnect();
 } /* ModuleMetarInfo::closeConnection */
 
 
+void ModuleMetarInfo::onFetchDone(bool success, const std::string& body)
+{
+  http_request.disconnect();
+  if (!success)
+  {
+    onTimeout();
+    return;
+  }
+  onData(body, body.size());
+} /* ModuleMetarInfo::onFetchDone */
+
+
 void ModuleMetarInfo::onTimeout(void)
 {
   stringstream temp;
@@ -158,7 +158,11 @@ class ModuleMetarInfo : public Module
     std::string type;
     std::string server;
     std::string link;
+    unsigned cache_ttl;
     Http* http;
+    sigc::connection http_request;
+
+    static const unsigned DEFAULT_CACHE_TTL = 300;
 
     bool initialize(void);
     void activateInit(void);
@@ -171,6 +175,7 @@ class ModuleMetarInfo : public Module
     void openConnection(void);
     void closeConnection(void);
     void onTimeout(void);
+    void onFetchDone(bool success, const std::string& body);
     std::string getSlp(std::string token);
     std::string getTempTime(std::string token);
     std::string getTempinRmk(std::string token);
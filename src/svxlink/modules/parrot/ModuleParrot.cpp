@@ -36,10 +36,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <stdint.h>
+
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <deque>
+#include <vector>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -50,7 +55,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncConfig.h>
 #include <AsyncTimer.h>
-#include <AsyncAudioFifo.h>
 #include <AsyncAudioPassthrough.h>
 #include <AsyncAudioValve.h>
 
@@ -113,6 +117,215 @@ class ModuleParrot::FifoAdapter : public AudioPassthrough
 }; /* class ModuleParrot::FifoAdapter */
 
 
+/*
+ * The recording buffer. It only hold memory for the audio actually recorded,
+ * allocated in fixed size chunks as the recording grows. The samples are
+ * stored as 16 bit integers to halve the memory use. When the buffer is
+ * full, the oldest audio is thrown away.
+ */
+class ModuleParrot::RecordingBuffer : public AudioSink, public AudioSource
+{
+  public:
+    RecordingBuffer(unsigned max_samples)
+      : max_samples(max_samples), samples_in_buffer(0), read_pos(0),
+        write_pos(CHUNK_SIZE), output_stopped(false), is_flushing(false)
+    {
+    }
+
+    ~RecordingBuffer(void)
+    {
+      clear();
+      freeMemory();
+    }
+
+    bool empty(void) const { return samples_in_buffer == 0; }
+
+    void clear(void)
+    {
+      bool was_empty = empty();
+      free_chunks.insert(free_chunks.end(), chunks.begin(), chunks.end());
+      chunks.clear();
+      samples_in_buffer = 0;
+      read_pos = 0;
+      write_pos = CHUNK_SIZE;
+      output_stopped = false;
+      if (is_flushing && !was_empty)
+      {
+        sinkFlushSamples();
+      }
+    }
+
+      // Give the memory of unused chunks back to the system
+    void freeMemory(void)
+    {
+      for (std::vector<Chunk*>::iterator it = free_chunks.begin();
+           it != free_chunks.end(); ++it)
+      {
+        delete *it;
+      }
+      free_chunks.clear();
+    }
+
+    virtual int writeSamples(const float *samples, int count)
+    {
+      is_flushing = false;
+
+      int samples_written = 0;
+      if (empty())
+      {
+        samples_written = sinkWriteSamples(samples, count);
+      }
+
+      while (samples_written < count)
+      {
+        if (write_pos == CHUNK_SIZE)
+        {
+          chunks.push_back(allocChunk());
+          write_pos = 0;
+        }
+        int16_t *dst = chunks.back()->samples + write_pos;
+        unsigned cnt = min(CHUNK_SIZE - write_pos,
+                           static_cast<unsigned>(count - samples_written));
+        for (unsigned i = 0; i < cnt; ++i)
+        {
+          float sample = max(-1.0f, min(1.0f, samples[samples_written + i]));
+          dst[i] = static_cast<int16_t>(sample * 32767.0f);
+        }
+        write_pos += cnt;
+        samples_written += cnt;
+        samples_in_buffer += cnt;
+      }
+
+      while (samples_in_buffer > max_samples)
+      {
+        consume(min(samples_in_buffer - max_samples, availableInFront()));
+      }
+
+      writeFromBuffer();
+
+      return count;
+    }
+
+    virtual void flushSamples(void)
+    {
+      is_flushing = true;
+      if (empty())
+      {
+        sinkFlushSamples();
+      }
+      else
+      {
+        writeFromBuffer();
+      }
+    }
+
+    virtual void resumeOutput(void)
+    {
+      if (output_stopped)
+      {
+        output_stopped = false;
+        writeFromBuffer();
+      }
+    }
+
+    virtual void allSamplesFlushed(void)
+    {
+      if (empty() && is_flushing)
+      {
+        is_flushing = false;
+        sourceAllSamplesFlushed();
+      }
+    }
+
+  private:
+    static const unsigned CHUNK_SIZE = 4096;
+    static const unsigned MAX_WRITE_SIZE = 512;
+
+    struct Chunk
+    {
+      int16_t samples[CHUNK_SIZE];
+    };
+
+    unsigned            max_samples;
+    unsigned            samples_in_buffer;
+    unsigned            read_pos;
+    unsigned            write_pos;
+    bool                output_stopped;
+    bool                is_flushing;
+    std::deque<Chunk*>  chunks;
+    std::vector<Chunk*> free_chunks;
+
+    Chunk *allocChunk(void)
+    {
+      if (free_chunks.empty())
+      {
+        return new Chunk;
+      }
+      Chunk *chunk = free_chunks.back();
+      free_chunks.pop_back();
+      return chunk;
+    }
+
+    unsigned availableInFront(void) const
+    {
+      unsigned end = (chunks.size() == 1) ? write_pos : CHUNK_SIZE;
+      return end - read_pos;
+    }
+
+    void consume(unsigned count)
+    {
+      read_pos += count;
+      samples_in_buffer -= count;
+      if (availableInFront() == 0)
+      {
+        free_chunks.push_back(chunks.front());
+        chunks.pop_front();
+        read_pos = 0;
+        if (chunks.empty())
+        {
+          write_pos = CHUNK_SIZE;
+        }
+      }
+    }
+
+    void writeFromBuffer(void)
+    {
+      if (output_stopped || empty())
+      {
+        return;
+      }
+
+      int samples_written;
+      do
+      {
+        float buf[MAX_WRITE_SIZE];
+        unsigned cnt = min(MAX_WRITE_SIZE, availableInFront());
+        const int16_t *src = chunks.front()->samples + read_pos;
+        for (unsigned i = 0; i < cnt; ++i)
+        {
+          buf[i] = static_cast<float>(src[i]) / 32768.0f;
+        }
+        samples_written = sinkWriteSamples(buf, cnt);
+        if (samples_written > 0)
+        {
+          consume(samples_written);
+        }
+      } while ((samples_written > 0) && !empty());
+
+      if (samples_written == 0)
+      {
+        output_stopped = true;
+      }
+
+      if (is_flushing && empty())
+      {
+        sinkFlushSamples();
+      }
+    }
+
+}; /* class ModuleParrot::RecordingBuffer */
+
+
 /****************************************************************************
  *
  * Prototypes
@@ -203,8 +416,7 @@ bool ModuleParrot::initialize(void)
   adapter = new FifoAdapter(this);
   AudioSink::setHandler(adapter);
   
-  fifo = new AudioFifo(atoi(fifo_len.c_str())*INTERNAL_SAMPLE_RATE);
-  fifo->setOverwrite(true);
+  fifo = new RecordingBuffer(atoi(fifo_len.c_str())*INTERNAL_SAMPLE_RATE);
   adapter->registerSink(fifo, true);
   
   valve = new AudioValve;
@@ -310,6 +522,7 @@ void ModuleParrot::deactivateCleanup(void)
 {
   valve->setOpen(true);
   fifo->clear();
+  fifo->freeMemory();
   repeat_delay_timer.setEnable(false);
 } /* deactivateCleanup */
 
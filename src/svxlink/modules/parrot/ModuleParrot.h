@@ -71,7 +71,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 namespace Async
 {
-  class SampleFifo;
   class AudioValve;
 };
 
@@ -143,9 +142,10 @@ class ModuleParrot : public Module
   private:
     class FifoAdapter;
     friend class FifoAdapter;
+    class RecordingBuffer;
     
     FifoAdapter       	    *adapter;
-    Async::AudioFifo	    *fifo;
+    RecordingBuffer	    *fifo;
     Async::AudioValve 	    *valve;
     bool      	      	    squelch_is_open;
     Async::Timer      	    repeat_delay_timer;
@@ -254,19 +254,57 @@ proc handle_vhfdx {msg_file} {
 }
 
 
+#
+# Handle a received alert message and then move it to the archive
+#
+#   dir      - The spool directory the message was found in
+#   msg_file - The path of the message file
+#
+proc handle_msg {dir msg_file} {
+  handle_$dir "$msg_file"
+  set target "[file dirname $msg_file]/archive/[file tail $msg_file]"
+  file delete "$target"
+  file rename "$msg_file" "$target"
+}
+
+
 proc check_dir {dir} {
   variable CFG_SPOOL_DIR
 
   foreach msg_file [glob -nocomplain -directory "$CFG_SPOOL_DIR/$dir" msg.*] {
-    handle_$dir "$msg_file"
-    set target "[file dirname $msg_file]/archive/[file tail $msg_file]"
-    file delete "$target"
-    file rename "$msg_file" "$target"
+    handle_msg $dir "$msg_file"
+  }
+}
+
+
+#
+# Called by the watchDirectory command as soon as procmail has written a new
+# file to one of the spool directories
+#
+#   dir      - The spool directory the message was written to
+#   msg_file - The path of the new file
+#
+proc msg_received {dir msg_file} {
+  if {[string match "msg.*" [file tail $msg_file]] &&
+      [file exists "$msg_file"]} {
+    handle_msg $dir "$msg_file"
   }
 }
 
 
+#
+# Executed once every minute. When the spool directories are watched, the
+# directories are only scanned the first time, to pick up alerts that were
+# received while SvxLink was not running.
+#
 proc check_for_alerts {} {
+  variable dirs_watched
+  variable initial_check_done
+
+  if {$dirs_watched && $initial_check_done} {
+    return
+  }
+  set initial_check_done 1
   check_dir vhfdx
   check_dir dxrobot
 }
@@ -280,6 +318,18 @@ if {![file exists $CFG_SPOOL_DIR/vhfdx/archive]} {
   file mkdir $CFG_SPOOL_DIR/vhfdx/archive
 }
 
+set initial_check_done 0
+set dirs_watched 1
+foreach dir {vhfdx dxrobot} {
+  set callback [list [namespace current]::msg_received $dir]
+  if {![watchDirectory "$CFG_SPOOL_DIR/$dir" $callback]} {
+    set dirs_watched 0
+  }
+}
+if {!$dirs_watched} {
+  printInfo "*** WARNING: Could not watch the spool directories. Checking for new alerts once every minute instead."
+}
+
 append func $module_name "::check_for_alerts";
 Logic::addMinuteTickSubscriber $func;
 
@@ -35,7 +35,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <stdio.h>
 
 #include <iostream>
-#include <sstream>
 
 
 /****************************************************************************
@@ -44,6 +43,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <Logic.h>
 
 
 /****************************************************************************
@@ -204,7 +204,7 @@ void ModuleTcl::flushSamples(void)
  */
 void ModuleTcl::activateInit(void)
 {
-  processEvent("activateInit");
+  dispatchEvent("activateInit", 0, 0);
 } /* activateInit */
 
 
@@ -223,7 +223,7 @@ void ModuleTcl::activateInit(void)
  */
 void ModuleTcl::deactivateCleanup(void)
 {
-  processEvent("deactivateCleanup");
+  dispatchEvent("deactivateCleanup", 0, 0);
 } /* deactivateCleanup */
 
 
@@ -243,9 +243,11 @@ void ModuleTcl::deactivateCleanup(void)
  */
 bool ModuleTcl::dtmfDigitReceived(char digit, int duration)
 {
-  stringstream ss;
-  ss << "dtmfDigitReceived " << digit << " " << duration;
-  processEvent(ss.str());
+  if (isSubscribed("dtmfDigitReceived"))
+  {
+    Tcl_Obj *args[] = { Tcl_NewStringObj(&digit, 1), Tcl_NewIntObj(duration) };
+    dispatchEvent("dtmfDigitReceived", 2, args);
+  }
   return false;
 } /* dtmfDigitReceived */
 
@@ -267,9 +269,11 @@ bool ModuleTcl::dtmfDigitReceived(char digit, int duration)
  */
 void ModuleTcl::dtmfCmdReceived(const string& cmd)
 {
-  stringstream ss;
-  ss << "dtmfCmdReceived \"" << cmd << "\"";
-  processEvent(ss.str());
+  if (isSubscribed("dtmfCmdReceived"))
+  {
+    Tcl_Obj *args[] = { Tcl_NewStringObj(cmd.data(), cmd.size()) };
+    dispatchEvent("dtmfCmdReceived", 1, args);
+  }
 } /* dtmfCmdReceived */
 
 
@@ -295,9 +299,11 @@ void ModuleTcl::dtmfCmdReceived(const string& cmd)
  */
 void ModuleTcl::dtmfCmdReceivedWhenIdle(const std::string &cmd)
 {
-  stringstream ss;
-  ss << "dtmfCmdReceivedWhenIdle \"" << cmd << "\"";
-  processEvent(ss.str());
+  if (isSubscribed("dtmfCmdReceivedWhenIdle"))
+  {
+    Tcl_Obj *args[] = { Tcl_NewStringObj(cmd.data(), cmd.size()) };
+    dispatchEvent("dtmfCmdReceivedWhenIdle", 1, args);
+  }
 } /* dtmfCmdReceivedWhenIdle  */
 
 
@@ -316,9 +322,11 @@ void ModuleTcl::dtmfCmdReceivedWhenIdle(const std::string &cmd)
  */
 void ModuleTcl::squelchOpen(bool is_open)
 {
-  stringstream ss;
-  ss << "squelchOpen " << (is_open ? 1 : 0);
-  processEvent(ss.str());
+  if (isSubscribed("squelchOpen"))
+  {
+    Tcl_Obj *args[] = { Tcl_NewIntObj(is_open ? 1 : 0) };
+    dispatchEvent("squelchOpen", 1, args);
+  }
 } /* squelchOpen */
 
 
@@ -338,10 +346,61 @@ void ModuleTcl::squelchOpen(bool is_open)
  */
 void ModuleTcl::allMsgsWritten(void)
 {
-  processEvent("allMsgsWritten");
+  dispatchEvent("allMsgsWritten", 0, 0);
 } /* allMsgsWritten */
 
 
+/*
+ *----------------------------------------------------------------------------
+ * Method:    isSubscribed
+ * Purpose:   Check if the TCL module has defined a function for the given
+ *    	      event. Events that have no function are not dispatched.
+ * Input:     event - The name of the event
+ * Output:    Returns true if the event function exist
+ * Author:    Tobias Blomberg / SM0SVX
+ * Created:   2026-10-14
+ * Remarks:   
+ * Bugs:      
+ *----------------------------------------------------------------------------
+ */
+bool ModuleTcl::isSubscribed(const char *event) const
+{
+  return logic()->eventIsHandled(event, this);
+} /* isSubscribed */
+
+
+/*
+ *----------------------------------------------------------------------------
+ * Method:    dispatchEvent
+ * Purpose:   Call the TCL function for the given event, if it is defined.
+ * Input:     event - The name of the event
+ *    	      objc  - The number of arguments
+ *    	      objv  - The arguments
+ * Output:    None
+ * Author:    Tobias Blomberg / SM0SVX
+ * Created:   2026-10-14
+ * Remarks:   The arguments are always freed if they are not used
+ * Bugs:      
+ *----------------------------------------------------------------------------
+ */
+void ModuleTcl::dispatchEvent(const char *event, int objc,
+                              Tcl_Obj *const objv[])
+{
+  if (isSubscribed(event))
+  {
+    logic()->processEvent(event, objc, objv, this);
+  }
+  else
+  {
+    for (int i=0; i<objc; ++i)
+    {
+      Tcl_IncrRefCount(objv[i]);
+      Tcl_DecrRefCount(objv[i]);
+    }
+  }
+} /* dispatchEvent */
+
+
 
 /*
  * This file has not been truncated
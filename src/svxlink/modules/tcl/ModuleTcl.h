@@ -36,6 +36,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <tcl.h>
+
 #include <string>
 
 
@@ -133,6 +135,8 @@ class ModuleTcl : public Module
     void dtmfCmdReceivedWhenIdle(const std::string &cmd);
     void squelchOpen(bool is_open);
     void allMsgsWritten(void);
+    bool isSubscribed(const char *event) const;
+    void dispatchEvent(const char *event, int objc, Tcl_Obj *const objv[]);
 
 };  /* class ModuleTcl */
 
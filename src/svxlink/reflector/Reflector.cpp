@@ -31,6 +31,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <cassert>
+#include <ctime>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <list>
 #include <json/json.h>
 
 
@@ -43,7 +48,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncConfig.h>
 #include <AsyncTcpServer.h>
 #include <AsyncUdpSocket.h>
+#include <AsyncSslContext.h>
 #include <AsyncApplication.h>
+#include <AsyncMetrics.h>
+#include <AsyncTracepoint.h>
 #include <common.h>
 
 
@@ -56,6 +64,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Reflector.h"
 #include "ReflectorClient.h"
 #include "TGHandler.h"
+#include "TrunkMsg.h"
 
 
 /****************************************************************************
@@ -91,6 +100,8 @@ using namespace Async;
  *
  ****************************************************************************/
 
+static std::string promLabelValue(const std::string& str);
+static std::string compactJson(const Json::Value& value);
 
 
 /****************************************************************************
@@ -122,24 +133,74 @@ namespace {
  ****************************************************************************/
 
 Reflector::Reflector(void)
-  : m_srv(0), m_udp_sock(0), m_tg_for_v1_clients(1), m_random_qsy_lo(0),
-    m_random_qsy_hi(0), m_random_qsy_tg(0), m_http_server(0)
+  : m_srv(0), m_ssl_ctx(0), m_udp_sock(0), m_tg_for_v1_clients(1), m_random_qsy_lo(0),
+    m_random_qsy_hi(0), m_random_qsy_tg(0), m_http_server(0),
+    m_start_time(time(NULL)), m_status_gen(1), m_status_cache_gen(0),
+    m_status_keepalive_cnt(0),
+    m_trunk_srv(0), m_trunk_timer(1000, Timer::TYPE_PERIODIC, false),
+    m_heartbeat_timer(1000, Timer::TYPE_PERIODIC),
+    m_transcode(false), m_auth_keys_dirty(true), m_capture(0),
+    m_recorder(0), m_sessions(0), m_sessions_save_cnt(0),
+    m_sessions_save_gen(0),
+    m_trunk_reload_pending(false)
 {
   TGHandler::instance()->talkerUpdated.connect(
       mem_fun(*this, &Reflector::onTalkerUpdated));
   TGHandler::instance()->requestAutoQsy.connect(
       mem_fun(*this, &Reflector::onRequestAutoQsy));
+  TGHandler::instance()->activeTGsChanged.connect(
+      mem_fun(*this, &Reflector::onActiveTGsChanged));
+  m_trunk_timer.expired.connect(
+      mem_fun(*this, &Reflector::checkTrunkTalkers));
+  m_heartbeat_timer.expired.connect(
+      mem_fun(*this, &Reflector::handleHeartbeats));
 } /* Reflector::Reflector */
 
 
 Reflector::~Reflector(void)
 {
+  m_status_streams.clear();
   delete m_http_server;
   m_http_server = 0;
+    // The links must go before the trunk server since they may be using
+    // connections owned by the server
+  while (!m_trunk_links.empty())
+  {
+    TrunkLink *link = m_trunk_links.back();
+    m_trunk_links.pop_back();
+    delete link;
+  }
+  delete m_trunk_srv;
+  m_trunk_srv = 0;
+  for (TranscoderMap::iterator it = m_transcoders.begin();
+       it != m_transcoders.end(); ++it)
+  {
+    delete it->second;
+  }
+  m_transcoders.clear();
+  clearAuthKeys();
+  for (std::vector<ReflectorShard*>::iterator it = m_shards.begin();
+       it != m_shards.end(); ++it)
+  {
+    delete *it;
+  }
+  m_shards.clear();
+  delete m_capture;
+  m_capture = 0;
+  delete m_recorder;
+  m_recorder = 0;
+  if (m_sessions != 0)
+  {
+    saveSessions();
+    delete m_sessions;
+    m_sessions = 0;
+  }
   delete m_udp_sock;
   m_udp_sock = 0;
   delete m_srv;
   m_srv = 0;
+  delete m_ssl_ctx;
+  m_ssl_ctx = 0;
 
   for (ReflectorClientMap::iterator it = m_client_map.begin();
        it != m_client_map.end(); ++it)
@@ -186,6 +247,46 @@ bool Reflector::initialize(Async::Config &cfg)
       mem_fun(*this, &Reflector::clientConnected));
   m_srv->clientDisconnected.connect(
       mem_fun(*this, &Reflector::clientDisconnected));
+  unsigned tcp_listeners = 1;
+  cfg.getValue("GLOBAL", "TCP_LISTENERS", tcp_listeners);
+  if ((tcp_listeners > 1) && !m_srv->setListenerCount(tcp_listeners))
+  {
+    cerr << "*** WARNING: Could not open " << tcp_listeners
+         << " TCP listening sockets. Using one." << endl;
+  }
+
+  std::string tls_cert_file;
+  if (cfg.getValue("GLOBAL", "TLS_CERT_FILE", tls_cert_file) &&
+      !tls_cert_file.empty())
+  {
+    std::string tls_key_file;
+    if (!cfg.getValue("GLOBAL", "TLS_KEY_FILE", tls_key_file))
+    {
+      cerr << "*** ERROR: GLOBAL/TLS_KEY_FILE must be set when "
+              "GLOBAL/TLS_CERT_FILE is set" << endl;
+      return false;
+    }
+    m_ssl_ctx = new SslContext(SslContext::ROLE_SERVER);
+    if (!m_ssl_ctx->initOk() ||
+        !m_ssl_ctx->setCertificateFiles(tls_cert_file, tls_key_file))
+    {
+      return false;
+    }
+    std::string tls_ca_file;
+    if (cfg.getValue("GLOBAL", "TLS_CA_FILE", tls_ca_file) &&
+        !m_ssl_ctx->setCaCertificateFile(tls_ca_file))
+    {
+      return false;
+    }
+    std::string tls_ticket_key_file;
+    if (cfg.getValue("GLOBAL", "TLS_TICKET_KEY_FILE", tls_ticket_key_file) &&
+        !m_ssl_ctx->setSessionTicketKeyFile(tls_ticket_key_file))
+    {
+      return false;
+    }
+    m_srv->setSslContext(m_ssl_ctx);
+    cout << "Using TLS for client connections" << endl;
+  }
 
   uint16_t udp_listen_port = 5300;
   cfg.getValue("GLOBAL", "LISTEN_PORT", udp_listen_port);
@@ -195,8 +296,72 @@ bool Reflector::initialize(Async::Config &cfg)
     cerr << "*** ERROR: Could not initialize UDP socket" << endl;
     return false;
   }
-  m_udp_sock->dataReceived.connect(
-      mem_fun(*this, &Reflector::udpDatagramReceived));
+  m_udp_sock->setDataHandler<Reflector, &Reflector::udpDatagramReceived>(this);
+  m_udp_sock->setBatchMode(UDP_BATCH_SIZE);
+  setupUdpSendQueue();
+
+  unsigned udp_shards = 0;
+  cfg.getValue("GLOBAL", "UDP_SHARDS", udp_shards);
+  for (unsigned i=0; i<udp_shards; ++i)
+  {
+    ReflectorShard *shard = new ReflectorShard(m_udp_sock->fd());
+    if (!shard->start())
+    {
+      cerr << "*** ERROR: Could not start UDP shard thread" << endl;
+      delete shard;
+      return false;
+    }
+    m_shards.push_back(shard);
+  }
+  if (!m_shards.empty())
+  {
+    cout << "Sending UDP audio using " << m_shards.size()
+         << " shard threads" << endl;
+  }
+
+  std::string capture_file;
+  if (cfg.getValue("GLOBAL", "CAPTURE_FILE", capture_file) &&
+      !capture_file.empty())
+  {
+    uint64_t capture_max_size = 0;
+    cfg.getValue("GLOBAL", "CAPTURE_MAX_SIZE", capture_max_size);
+    m_capture = new ReflectorCaptureWriter;
+    if (!m_capture->open(capture_file, capture_max_size * 1024 * 1024))
+    {
+      return false;
+    }
+  }
+
+  std::set<uint32_t> record_tgs;
+  if (cfg.getValue("GLOBAL", "RECORD_TGS", record_tgs) && !record_tgs.empty())
+  {
+    std::string record_dir;
+    if (!cfg.getValue("GLOBAL", "RECORD_DIR", record_dir) ||
+        record_dir.empty())
+    {
+      cerr << "*** ERROR: GLOBAL/RECORD_DIR must be set when RECORD_TGS "
+              "is set" << endl;
+      return false;
+    }
+    m_recorder = new ReflectorRecorder;
+    if (!m_recorder->initialize(record_dir, record_tgs))
+    {
+      return false;
+    }
+  }
+
+  std::string session_file;
+  if (cfg.getValue("GLOBAL", "SESSION_FILE", session_file) &&
+      !session_file.empty())
+  {
+    unsigned session_timeout = 300;
+    cfg.getValue("GLOBAL", "SESSION_TIMEOUT", session_timeout);
+    m_sessions = new ReflectorSessions;
+    if (!m_sessions->load(session_file, session_timeout))
+    {
+      return false;
+    }
+  }
 
   unsigned sql_timeout = 0;
   cfg.getValue("GLOBAL", "SQL_TIMEOUT", sql_timeout);
@@ -208,30 +373,23 @@ bool Reflector::initialize(Async::Config &cfg)
 
   m_cfg->getValue("GLOBAL", "TG_FOR_V1_CLIENTS", m_tg_for_v1_clients);
 
-  SvxLink::SepPair<uint32_t, uint32_t> random_qsy_range;
-  if (m_cfg->getValue("GLOBAL", "RANDOM_QSY_RANGE", random_qsy_range))
+  if (!initCodecs())
   {
-    m_random_qsy_lo = random_qsy_range.first;
-    m_random_qsy_hi = m_random_qsy_lo + random_qsy_range.second-1;
-    if ((m_random_qsy_lo < 1) || (m_random_qsy_hi < m_random_qsy_lo))
-    {
-      cout << "*** WARNING: Illegal RANDOM_QSY_RANGE specified. Ignored."
-           << endl;
-      m_random_qsy_hi = m_random_qsy_lo = 0;
-    }
-    m_random_qsy_tg = m_random_qsy_hi;
+    return false;
   }
 
-  std::string http_srv_port;
-  if (m_cfg->getValue("GLOBAL", "HTTP_SRV_PORT", http_srv_port))
+  setupRandomQsy();
+  initHttpServer();
+
+  if (!initTrunks())
   {
-    m_http_server = new Async::TcpServer<Async::HttpServerConnection>(http_srv_port);
-    m_http_server->clientConnected.connect(
-        sigc::mem_fun(*this, &Reflector::httpClientConnected));
-    m_http_server->clientDisconnected.connect(
-        sigc::mem_fun(*this, &Reflector::httpClientDisconnected));
+    return false;
   }
 
+  m_cfg->valueUpdated.connect(
+      sigc::mem_fun(*this, &Reflector::cfgValueUpdated));
+  updateAuthKeys();
+
   return true;
 } /* Reflector::initialize */
 
@@ -248,12 +406,15 @@ void Reflector::nodeList(std::vector<std::string>& nodes) const
       nodes.push_back(callsign);
     }
   }
+  std::sort(nodes.begin(), nodes.end());
 } /* Reflector::nodeList */
 
 
 void Reflector::broadcastMsg(const ReflectorMsg& msg,
                              const ReflectorClient::Filter& filter)
 {
+    // Pack the message once and share the frame between all clients
+  FramedTcpConnection::Frame *frame = 0;
   ReflectorClientMap::const_iterator it = m_client_map.begin();
   for (; it != m_client_map.end(); ++it)
   {
@@ -261,23 +422,126 @@ void Reflector::broadcastMsg(const ReflectorMsg& msg,
     if (filter(client) &&
         (client->conState() == ReflectorClient::STATE_CONNECTED))
     {
-      (*it).second->sendMsg(msg);
+      if (frame == 0)
+      {
+        frame = ReflectorClient::packMsg(msg);
+        if (frame == 0)
+        {
+          return;
+        }
+      }
+      client->sendFrame(msg.type(), frame);
+    }
+  }
+  if (frame != 0)
+  {
+    frame->unref();
+  }
+} /* Reflector::broadcastMsg */
+
+
+void Reflector::broadcastMsg(const ReflectorMsg& msg, uint32_t tg,
+                             const ReflectorClient::Filter& filter)
+{
+  const TGHandler::ClientSet& clients = TGHandler::instance()->clientsForTG(tg);
+  const TGHandler::ClientSet& monitors =
+    TGHandler::instance()->monitorsForTG(tg);
+  FramedTcpConnection::Frame *frame = 0;
+  const TGHandler::ClientSet* sets[] = { &clients, &monitors };
+  for (size_t i=0; i<2; ++i)
+  {
+    for (TGHandler::ClientSet::const_iterator it = sets[i]->begin();
+         it != sets[i]->end(); ++it)
+    {
+      ReflectorClient *client = *it;
+      if (((i == 0) || (clients.count(client) == 0)) && filter(client) &&
+          (client->conState() == ReflectorClient::STATE_CONNECTED))
+      {
+        if (frame == 0)
+        {
+          frame = ReflectorClient::packMsg(msg);
+          if (frame == 0)
+          {
+            return;
+          }
+        }
+        client->sendFrame(msg.type(), frame);
+      }
     }
   }
+  if (frame != 0)
+  {
+    frame->unref();
+  }
 } /* Reflector::broadcastMsg */
 
 
 bool Reflector::sendUdpDatagram(ReflectorClient *client, const void *buf,
                                 size_t count)
 {
-  return m_udp_sock->write(client->remoteHost(), client->remoteUdpPort(), buf,
-                           count);
+  struct iovec iov[2];
+  iov[0].iov_base = 0;
+  iov[0].iov_len = 0;
+  iov[1].iov_base = const_cast<void *>(buf);
+  iov[1].iov_len = count;
+  return sendUdpDatagram(client, iov, 2);
+} /* Reflector::sendUdpDatagram */
+
+
+bool Reflector::sendUdpDatagram(ReflectorClient *client,
+                                const struct iovec *iov, int iovcnt)
+{
+  if (m_shards.empty())
+  {
+    return m_udp_sock->writev(client->remoteHost(), client->remoteUdpPort(),
+                              iov, iovcnt);
+  }
+
+    // In sharded mode the first buffer is the header and the rest is the
+    // payload. The payload of a broadcast is shared, not copied.
+  assert(iovcnt >= 1);
+  ReflectorShard::Payload payload;
+  if (m_bcast_payload && (iovcnt == 2) &&
+      (iov[1].iov_base == m_bcast_payload->data()))
+  {
+    payload = m_bcast_payload;
+  }
+  else
+  {
+    std::shared_ptr<ReflectorShard::PayloadBuf> buf =
+      std::allocate_shared<ReflectorShard::PayloadBuf>(
+          Async::PoolAllocator<ReflectorShard::PayloadBuf>());
+    for (int i=1; i<iovcnt; ++i)
+    {
+      const char *ptr = reinterpret_cast<const char *>(iov[i].iov_base);
+      buf->insert(buf->end(), ptr, ptr + iov[i].iov_len);
+    }
+    payload = buf;
+  }
+  struct sockaddr_storage addr;
+  socklen_t addr_len = client->remoteHost().toSockAddr(
+      addr, client->remoteUdpPort(), m_udp_sock->family());
+  if (addr_len == 0)
+  {
+    return false;
+  }
+  ReflectorShard *shard = m_shards[client->clientId() % m_shards.size()];
+  shard->queue(reinterpret_cast<struct sockaddr *>(&addr), addr_len,
+               iov[0].iov_base, iov[0].iov_len, payload);
+  if (!m_bcast_payload)
+  {
+    shard->flush();
+  }
+  return true;
 } /* Reflector::sendUdpDatagram */
 
 
 void Reflector::broadcastUdpMsg(const ReflectorUdpMsg& msg,
                                 const ReflectorClient::Filter& filter)
 {
+    // Pack the payload once and send all datagrams in one batch
+  bool packed = false;
+  beginUdpBatch();
   for (ReflectorClientMap::iterator it = m_client_map.begin();
        it != m_client_map.end(); ++it)
   {
@@ -285,9 +549,49 @@ void Reflector::broadcastUdpMsg(const ReflectorUdpMsg& msg,
     if (filter(client) &&
         (client->conState() == ReflectorClient::STATE_CONNECTED))
     {
-      client->sendUdpMsg(msg);
+      if (!packed && !(packed = packUdpPayload(msg)))
+      {
+        break;
+      }
+      client->sendUdpPayload(msg.type(), m_bcast_payload->data(),
+                             m_bcast_payload->size());
+    }
+  }
+  flushUdpBatch();
+} /* Reflector::broadcastUdpMsg */
+
+
+void Reflector::broadcastUdpMsg(const ReflectorUdpMsg& msg, uint32_t tg,
+                                const ReflectorClient::Filter& filter)
+{
+  const TGHandler::ClientSet& clients = TGHandler::instance()->clientsForTG(tg);
+  bool packed = false;
+  uint64_t tx_cnt = 0;
+  beginUdpBatch();
+  for (TGHandler::ClientSet::const_iterator it = clients.begin();
+       it != clients.end(); ++it)
+  {
+    ReflectorClient *client = *it;
+    if (filter(client) &&
+        (client->conState() == ReflectorClient::STATE_CONNECTED))
+    {
+      if (!packed && !(packed = packUdpPayload(msg)))
+      {
+        break;
+      }
+      client->sendUdpPayload(msg.type(), m_bcast_payload->data(),
+                             m_bcast_payload->size());
+      ++tx_cnt;
     }
   }
+  if ((tx_cnt > 0) && (msg.type() == MsgUdpAudio::TYPE))
+  {
+    TGHandler::TGStats& tg_stats = TGHandler::instance()->tgStats(tg);
+    tg_stats.audio_tx_frames += tx_cnt;
+    tg_stats.audio_tx_bytes += tx_cnt * m_bcast_payload->size();
+  }
+  flushUdpBatch();
+  ASYNC_TRACEPOINT(svxreflector, udp_broadcast, msg.type(), tg, tx_cnt);
 } /* Reflector::broadcastUdpMsg */
 
 
@@ -317,6 +621,78 @@ void Reflector::requestQsy(ReflectorClient *client, uint32_t tg)
 } /* Reflector::requestQsy */
 
 
+void Reflector::statusEvent(const std::string& event, const Json::Value& data)
+{
+  if (m_status_streams.empty())
+  {
+    return;
+  }
+  const std::string msg("event: " + event + "\ndata: " + compactJson(data) +
+                        "\n\n");
+  for (std::set<Async::HttpServerConnection*>::const_iterator it =
+         m_status_streams.begin();
+       it != m_status_streams.end(); ++it)
+  {
+    (*it)->write(msg.data(), msg.size());
+  }
+} /* Reflector::statusEvent */
+
+
+bool Reflector::verifyAuthResponse(const MsgAuthResponse& msg,
+                                   const unsigned char *challenge)
+{
+  if (m_auth_keys_dirty)
+  {
+    updateAuthKeys();
+  }
+
+  UserGroupMap::const_iterator user_it = m_user_groups.find(msg.callsign());
+  if ((user_it == m_user_groups.end()) || user_it->second.empty())
+  {
+    cout << "*** WARNING: Unknown user \"" << msg.callsign() << "\""
+         << endl;
+    return false;
+  }
+  AuthKeyMap::const_iterator key_it = m_auth_keys.find(user_it->second);
+  if (key_it == m_auth_keys.end())
+  {
+    cout << "*** ERROR: User \"" << msg.callsign() << "\" found in "
+         << "SvxReflector configuration but password with groupname \""
+         << user_it->second << "\" not found." << endl;
+    return false;
+  }
+  return msg.verify(key_it->second, challenge);
+} /* Reflector::verifyAuthResponse */
+
+
+bool Reflector::resumeSession(const MsgSessionResume& msg,
+                              const unsigned char *challenge,
+                              ReflectorSessions::Session& session)
+{
+  if ((m_sessions == 0) || !m_sessions->find(msg.callsign(), session))
+  {
+    return false;
+  }
+  if (m_auth_keys_dirty)
+  {
+    updateAuthKeys();
+  }
+  UserGroupMap::const_iterator user_it = m_user_groups.find(msg.callsign());
+  if ((user_it == m_user_groups.end()) || user_it->second.empty())
+  {
+    cout << "*** WARNING: Unknown user \"" << msg.callsign() << "\""
+         << endl;
+    return false;
+  }
+  if (!msg.verify(session.token, challenge))
+  {
+    return false;
+  }
+  m_sessions->remove(msg.callsign());
+  return true;
+} /* Reflector::resumeSession */
+
+
 /****************************************************************************
  *
  * Protected member functions
@@ -338,6 +714,7 @@ void Reflector::clientConnected(Async::FramedTcpConnection *con)
   ReflectorClient *rc = new ReflectorClient(this, con, m_cfg);
   m_client_map[rc->clientId()] = rc;
   m_client_con_map[con] = rc;
+  statusChanged();
 } /* Reflector::clientConnected */
 
 
@@ -361,26 +738,34 @@ void Reflector::clientDisconnected(Async::FramedTcpConnection *con,
   cout << "disconnected: " << TcpConnection::disconnectReasonStr(reason)
        << endl;
 
+  if ((m_capture != 0) && !client->callsign().empty())
+  {
+    m_capture->logout(client->clientId());
+  }
+
   m_client_map.erase(client->clientId());
   m_client_con_map.erase(it);
+  statusChanged();
 
   if (!client->callsign().empty())
   {
     broadcastMsg(MsgNodeLeft(client->callsign()),
         ReflectorClient::ExceptFilter(client));
+    Json::Value event(Json::objectValue);
+    event["callsign"] = client->callsign();
+    statusEvent("node_left", event);
   }
   Application::app().runTask([=]{ delete client; });
 } /* Reflector::clientDisconnected */
 
 
 void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
-                                    void *buf, int count)
+                                    Async::DataView data)
 {
-  stringstream ss;
-  ss.write(reinterpret_cast<const char *>(buf), count);
+  Async::MsgUnpackBuffer ub(data.data(), data.size());
 
   ReflectorUdpMsg header;
-  if (!header.unpack(ss))
+  if (!header.unpack(ub))
   {
     cout << "*** WARNING: Unpacking message header failed for UDP datagram "
             "from " << addr << ":" << port << endl;
@@ -424,6 +809,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
          << ": Dropping out of sequence frame with seq="
          << header.sequenceNum() << ". Expected seq="
          << client->nextUdpRxSeq() << endl;
+    client->udpMsgOutOfSequence();
     return;
   }
   else if (udp_rx_seq_diff > 0) // Frame(s) lost
@@ -433,7 +819,14 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
          << ". Received seq=" << header.sequenceNum() << endl;
   }
 
-  client->udpMsgReceived(header);
+  ASYNC_TRACEPOINT(svxreflector, udp_receive, header.clientId(),
+                   client->callsign().c_str(), header.type(),
+                   data.size());
+  if (m_capture != 0)
+  {
+    m_capture->udpDatagram(client->clientId(), data.data(), data.size());
+  }
+  client->udpMsgReceived(header, data.size());
 
   switch (header.type())
   {
@@ -444,18 +837,26 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
     {
       if (!client->isBlocked())
       {
-        MsgUdpAudio msg;
-        if (!msg.unpack(ss))
+          // The audio is not unpacked into a MsgUdpAudio object. The packed
+          // message, a 16 bit length followed by the audio data, is
+          // validated and then forwarded straight from the datagram buffer.
+        const uint8_t *payload = data.data() +
+                                 (data.size() - ub.remaining());
+        uint16_t audio_len = 0;
+        if (!Async::MsgPacker<uint16_t>::unpack(ub, audio_len) ||
+            (audio_len > ub.remaining()))
         {
           cerr << "*** WARNING[" << client->callsign()
                << "]: Could not unpack incoming MsgUdpAudioV1 message" << endl;
           return;
         }
+        size_t payload_len = sizeof(audio_len) + audio_len;
         uint32_t tg = TGHandler::instance()->TGForClient(client);
-        if (!msg.audioData().empty() && (tg > 0))
+        if ((audio_len > 0) && (tg > 0))
         {
+          TGHandler::TGStats& tg_stats = TGHandler::instance()->tgStats(tg);
           ReflectorClient* talker = TGHandler::instance()->talkerForTG(tg);
-          if (talker == 0)
+          if ((talker == 0) && (m_trunk_talkers.count(tg) == 0))
           {
             TGHandler::instance()->setTalkerForTG(tg, client);
             talker = TGHandler::instance()->talkerForTG(tg);
@@ -463,10 +864,27 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
           if (talker == client)
           {
             TGHandler::instance()->setTalkerForTG(tg, client);
-            broadcastUdpMsg(msg,
-                ReflectorClient::mkAndFilter(
-                  ReflectorClient::ExceptFilter(client),
-                  ReflectorClient::TgFilter(tg)));
+            tg_stats.audio_rx_frames += 1;
+            tg_stats.audio_rx_bytes += audio_len;
+            if (m_transcode)
+            {
+              broadcastUdpPayload(MsgUdpAudio::TYPE, payload, payload_len, tg,
+                  ReflectorClient::mkAndFilter(
+                    ReflectorClient::ExceptFilter(client),
+                    ReflectorClient::CodecFilter(client->codec())));
+              transcodeAudio(tg, client, payload + sizeof(audio_len),
+                             audio_len);
+            }
+            else
+            {
+              broadcastUdpPayload(MsgUdpAudio::TYPE, payload, payload_len, tg,
+                                  ReflectorClient::ExceptFilter(client));
+            }
+            forwardTrunkAudio(tg, payload + sizeof(audio_len), audio_len);
+            if (m_recorder != 0)
+            {
+              m_recorder->audio(tg, payload + sizeof(audio_len), audio_len);
+            }
             //broadcastUdpMsgExcept(tg, client, msg,
             //    ProtoVerRange(ProtoVer(0, 6),
             //                  ProtoVer(1, ProtoVer::max().minor())));
@@ -539,7 +957,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
       if (!client->isBlocked())
       {
         MsgUdpSignalStrengthValues msg;
-        if (!msg.unpack(ss))
+        if (!msg.unpack(ub))
         {
           cerr << "*** WARNING[" << client->callsign()
                << "]: Could not unpack incoming "
@@ -562,6 +980,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
           client->setRxSqlOpen(rx.id(), rx.sqlOpen());
           client->setRxActive(rx.id(), rx.active());
         }
+        statusChanged();
       }
       break;
     }
@@ -581,37 +1000,47 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
 void Reflector::onTalkerUpdated(uint32_t tg, ReflectorClient* old_talker,
                                 ReflectorClient *new_talker)
 {
+  statusChanged();
   if (old_talker != 0)
   {
     cout << old_talker->callsign() << ": Talker stop on TG #" << tg << endl;
-    broadcastMsg(MsgTalkerStop(tg, old_talker->callsign()),
-        ReflectorClient::mkAndFilter(
-          v2_client_filter,
-          ReflectorClient::mkOrFilter(
-            ReflectorClient::TgFilter(tg),
-            ReflectorClient::TgMonitorFilter(tg))));
+    broadcastMsg(MsgTalkerStop(tg, old_talker->callsign()), tg,
+                 v2_client_filter);
     if (tg == tgForV1Clients())
     {
       broadcastMsg(MsgTalkerStopV1(old_talker->callsign()), v1_client_filter);
     }
-    broadcastUdpMsg(MsgUdpFlushSamples(),
-          ReflectorClient::mkAndFilter(
-            ReflectorClient::TgFilter(tg),
-            ReflectorClient::ExceptFilter(old_talker)));
+    stopTranscoding(tg);
+    if (m_recorder != 0)
+    {
+      m_recorder->talkerStop(tg);
+    }
+    broadcastUdpMsg(MsgUdpFlushSamples(), tg,
+                    ReflectorClient::ExceptFilter(old_talker));
+    broadcastTrunkMsg(MsgTrunkTalkerStop(tg));
+    Json::Value event(Json::objectValue);
+    event["tg"] = tg;
+    event["callsign"] = old_talker->callsign();
+    statusEvent("talker_stop", event);
   }
   if (new_talker != 0)
   {
     cout << new_talker->callsign() << ": Talker start on TG #" << tg << endl;
-    broadcastMsg(MsgTalkerStart(tg, new_talker->callsign()),
-        ReflectorClient::mkAndFilter(
-          v2_client_filter,
-          ReflectorClient::mkOrFilter(
-            ReflectorClient::TgFilter(tg),
-            ReflectorClient::TgMonitorFilter(tg))));
+    broadcastMsg(MsgTalkerStart(tg, new_talker->callsign()), tg,
+                 v2_client_filter);
     if (tg == tgForV1Clients())
     {
       broadcastMsg(MsgTalkerStartV1(new_talker->callsign()), v1_client_filter);
     }
+    broadcastTrunkMsg(MsgTrunkTalkerStart(tg, new_talker->callsign()));
+    if (m_recorder != 0)
+    {
+      m_recorder->talkerStart(tg, new_talker->callsign(), new_talker->codec());
+    }
+    Json::Value event(Json::objectValue);
+    event["tg"] = tg;
+    event["callsign"] = new_talker->callsign();
+    statusEvent("talker_start", event);
   }
 } /* Reflector::setTalker */
 
@@ -631,7 +1060,46 @@ void Reflector::httpRequestReceived(Async::HttpServerConnection *con,
     return;
   }
 
-  if (req.target != "/status")
+  if (req.target == "/metrics")
+  {
+      // Counters change with every audio frame so nothing is cached here
+    res.setContent("text/plain; version=0.0.4",
+        buildMetrics() + Async::Metrics::instance().prometheusText());
+  }
+  else if (req.target == "/status")
+  {
+    if (m_status_cache_gen != m_status_gen)
+    {
+      updateStatusCache();
+    }
+    res.setContent("application/json", m_status_cache);
+    res.setETag(m_status_etag);
+  }
+  else if (req.target == "/status/events")
+  {
+      // A Server-Sent Events stream starting with the full status followed
+      // by events when something change
+    res.setCode(200);
+    res.setHeader("Content-type", "text/event-stream");
+    res.setHeader("Cache-control", "no-cache");
+    if (req.method == "HEAD")
+    {
+      con->write(res);
+      return;
+    }
+    if (m_status_cache_gen != m_status_gen)
+    {
+      updateStatusCache();
+    }
+    con->setChunked();
+    con->write(res);
+    const std::string snapshot("event: status\ndata: " + m_status_cache +
+                               "\n\n");
+    con->write(snapshot.data(), snapshot.size());
+    m_status_streams.insert(con);
+    return;
+  }
+  else
   {
     res.setCode(404);
     res.setContent("application/json",
@@ -640,6 +1108,101 @@ void Reflector::httpRequestReceived(Async::HttpServerConnection *con,
     return;
   }
 
+  if (req.method == "HEAD")
+  {
+    res.setSendContent(false);
+  }
+  res.setCode(200);
+  con->write(res);
+} /* Reflector::requestReceived */
+
+
+bool Reflector::packUdpPayload(const ReflectorUdpMsg& msg)
+{
+  std::shared_ptr<ReflectorShard::PayloadBuf> buf =
+    std::allocate_shared<ReflectorShard::PayloadBuf>(
+        Async::PoolAllocator<ReflectorShard::PayloadBuf>(),
+        msg.packedSize() + 1);
+  Async::MsgPackBuffer pb(&(*buf)[0], buf->size());
+  if (!msg.pack(pb))
+  {
+    cerr << "*** ERROR: Failed to pack reflector UDP message" << endl;
+    return false;
+  }
+  buf->resize(pb.size());
+  m_bcast_payload = buf;
+  return true;
+} /* Reflector::packUdpPayload */
+
+
+void Reflector::broadcastUdpPayload(uint16_t type, const void *buf,
+                                    size_t len, uint32_t tg,
+                                    const ReflectorClient::Filter& filter)
+{
+  const TGHandler::ClientSet& clients = TGHandler::instance()->clientsForTG(tg);
+  uint64_t tx_cnt = 0;
+  beginUdpBatch();
+  for (TGHandler::ClientSet::const_iterator it = clients.begin();
+       it != clients.end(); ++it)
+  {
+    ReflectorClient *client = *it;
+    if (filter(client) &&
+        (client->conState() == ReflectorClient::STATE_CONNECTED))
+    {
+        // The shard threads send the datagrams after this function have
+        // returned so the payload have to be copied once in sharded mode.
+        // Otherwise it is sent directly from the buffer of the caller.
+      if (!m_shards.empty() && !m_bcast_payload)
+      {
+        const char *ptr = reinterpret_cast<const char*>(buf);
+        m_bcast_payload = std::allocate_shared<ReflectorShard::PayloadBuf>(
+            Async::PoolAllocator<ReflectorShard::PayloadBuf>(), ptr, ptr + len);
+      }
+      client->sendUdpPayload(type,
+          m_bcast_payload ? m_bcast_payload->data() : buf, len);
+      ++tx_cnt;
+    }
+  }
+  flushUdpBatch();
+  ASYNC_TRACEPOINT(svxreflector, udp_broadcast, type, tg, tx_cnt);
+  if ((tx_cnt > 0) && (type == MsgUdpAudio::TYPE))
+  {
+    TGHandler::TGStats& tg_stats = TGHandler::instance()->tgStats(tg);
+    tg_stats.audio_tx_frames += tx_cnt;
+    tg_stats.audio_tx_bytes += tx_cnt * len;
+  }
+} /* Reflector::broadcastUdpPayload */
+
+
+void Reflector::beginUdpBatch(void)
+{
+  if (m_shards.empty())
+  {
+    m_udp_sock->beginWriteBatch();
+  }
+} /* Reflector::beginUdpBatch */
+
+
+void Reflector::flushUdpBatch(void)
+{
+  if (m_shards.empty())
+  {
+    m_udp_sock->flushWriteBatch();
+  }
+  else
+  {
+    for (std::vector<ReflectorShard*>::iterator it = m_shards.begin();
+         it != m_shards.end(); ++it)
+    {
+      (*it)->flush();
+    }
+  }
+  m_bcast_payload.reset();
+} /* Reflector::flushUdpBatch */
+
+
+void Reflector::updateStatusCache(void)
+{
   Json::Value status;
   status["nodes"] = Json::Value(Json::objectValue);
   ReflectorClientMap::const_iterator client_it;
@@ -652,8 +1215,8 @@ void Reflector::httpRequestReceived(Async::HttpServerConnection *con,
     node["protoVer"]["minorVer"] = client->protoVer().minorVer();
     node["tg"] = client->currentTG();
     Json::Value tgs = Json::Value(Json::arrayValue);
-    const std::set<uint32_t>& monitored_tgs = client->monitoredTGs();
-    for (std::set<uint32_t>::const_iterator mtg_it=monitored_tgs.begin();
+    const ReflectorClient::TgList& monitored_tgs = client->monitoredTGs();
+    for (ReflectorClient::TgList::const_iterator mtg_it=monitored_tgs.begin();
          mtg_it!=monitored_tgs.end(); ++mtg_it)
     {
       tgs.append(*mtg_it);
@@ -715,21 +1278,199 @@ void Reflector::httpRequestReceived(Async::HttpServerConnection *con,
     }
     status["nodes"][client->callsign()] = node;
   }
-  std::ostringstream os;
-  Json::StreamWriterBuilder builder;
-  builder["commentStyle"] = "None";
-  builder["indentation"] = ""; //The JSON document is written on a single line
-  Json::StreamWriter* writer = builder.newStreamWriter();
-  writer->write(status, &os);
-  delete writer;
-  res.setContent("application/json", os.str());
-  if (req.method == "HEAD")
+  if (!m_trunk_links.empty())
   {
-    res.setSendContent(false);
-  }
-  res.setCode(200);
-  con->write(res);
-} /* Reflector::requestReceived */
+    status["trunks"] = Json::Value(Json::objectValue);
+    for (std::vector<TrunkLink*>::const_iterator it = m_trunk_links.begin();
+         it != m_trunk_links.end(); ++it)
+    {
+      const TrunkLink *link = *it;
+      Json::Value trunk(Json::objectValue);
+      trunk["peerId"] = link->peerId();
+      trunk["isUp"] = link->isUp();
+      Json::Value talkers(Json::arrayValue);
+      for (TrunkTalkerMap::const_iterator tit = m_trunk_talkers.begin();
+           tit != m_trunk_talkers.end(); ++tit)
+      {
+        if (tit->second.link == link)
+        {
+          Json::Value talker(Json::objectValue);
+          talker["tg"] = tit->first;
+          talker["callsign"] = tit->second.callsign;
+          talkers.append(talker);
+        }
+      }
+      trunk["talkers"] = talkers;
+      status["trunks"][link->name()] = trunk;
+    }
+  }
+  m_status_cache = compactJson(status);
+  m_status_cache_gen = m_status_gen;
+  std::ostringstream etag;
+  etag << std::hex << m_start_time << "-" << m_status_gen;
+  m_status_etag = etag.str();
+} /* Reflector::updateStatusCache */
+
+
+std::string Reflector::buildMetrics(void)
+{
+  std::ostringstream os;
+  os << "# HELP svxreflector_clients Number of connected clients\n"
+     << "# TYPE svxreflector_clients gauge\n"
+     << "svxreflector_clients " << m_client_map.size() << "\n";
+  os << "# HELP svxreflector_udp_tx_queued_total "
+        "Number of UDP datagrams put in the send queue\n"
+     << "# TYPE svxreflector_udp_tx_queued_total counter\n"
+     << "svxreflector_udp_tx_queued_total "
+     << m_udp_sock->datagramsQueued() << "\n";
+  os << "# HELP svxreflector_udp_tx_dropped_total "
+        "Number of UDP datagrams dropped because the send queue was full\n"
+     << "# TYPE svxreflector_udp_tx_dropped_total counter\n"
+     << "svxreflector_udp_tx_dropped_total "
+     << m_udp_sock->datagramsDropped() << "\n";
+  os << "# HELP svxreflector_udp_tx_queue_length "
+        "Number of UDP datagrams waiting in the send queue\n"
+     << "# TYPE svxreflector_udp_tx_queue_length gauge\n"
+     << "svxreflector_udp_tx_queue_length "
+     << m_udp_sock->sendQueueLength() << "\n";
+
+  static const struct
+  {
+    const char *name;
+    const char *type;
+    const char *help;
+  } client_metrics[] = {
+    { "svxreflector_client_udp_rx_frames_total", "counter",
+      "Number of UDP frames received from the client" },
+    { "svxreflector_client_udp_rx_bytes_total", "counter",
+      "Number of UDP bytes received from the client" },
+    { "svxreflector_client_udp_rx_lost_total", "counter",
+      "Number of UDP frames from the client detected as lost" },
+    { "svxreflector_client_udp_rx_out_of_sequence_total", "counter",
+      "Number of UDP frames from the client dropped as out of sequence" },
+    { "svxreflector_client_udp_tx_frames_total", "counter",
+      "Number of UDP frames sent to the client" },
+    { "svxreflector_client_udp_tx_bytes_total", "counter",
+      "Number of UDP bytes sent to the client" },
+    { "svxreflector_client_audio_jitter_seconds", "gauge",
+      "Interarrival jitter of the audio frames from the client" },
+    { "svxreflector_client_rtt_seconds", "gauge",
+      "Smoothed round trip time of the TCP connection to the client" },
+  };
+  static const size_t client_metrics_cnt =
+    sizeof(client_metrics) / sizeof(client_metrics[0]);
+
+  std::map<uint32_t, unsigned> tg_clients;
+  for (size_t i=0; i<client_metrics_cnt; ++i)
+  {
+    os << "# HELP " << client_metrics[i].name << " "
+       << client_metrics[i].help << "\n"
+       << "# TYPE " << client_metrics[i].name << " "
+       << client_metrics[i].type << "\n";
+    for (ReflectorClientMap::const_iterator it = m_client_map.begin();
+         it != m_client_map.end(); ++it)
+    {
+      const ReflectorClient *client = it->second;
+      if (client->callsign().empty())
+      {
+        continue;
+      }
+      if ((i == 0) && (client->currentTG() > 0))
+      {
+        tg_clients[client->currentTG()] += 1;
+      }
+      const ReflectorClient::NetStats& st = client->netStats();
+      std::ostringstream val;
+      switch (i)
+      {
+        case 0: val << st.udp_rx_frames; break;
+        case 1: val << st.udp_rx_bytes; break;
+        case 2: val << st.udp_rx_lost; break;
+        case 3: val << st.udp_rx_out_of_seq; break;
+        case 4: val << st.udp_tx_frames; break;
+        case 5: val << st.udp_tx_bytes; break;
+        case 6: val << st.audio_jitter; break;
+        case 7:
+        {
+          double rtt = 0.0;
+          if (!client->tcpRtt(rtt))
+          {
+            continue;
+          }
+          val << rtt;
+          break;
+        }
+      }
+      os << client_metrics[i].name << "{callsign=\""
+         << promLabelValue(client->callsign()) << "\"} " << val.str() << "\n";
+    }
+  }
+
+  const TGHandler::TGStatsMap& tg_stats = TGHandler::instance()->allTGStats();
+  os << "# HELP svxreflector_tg_clients Number of clients on the talk group\n"
+     << "# TYPE svxreflector_tg_clients gauge\n";
+  for (std::map<uint32_t, unsigned>::const_iterator it = tg_clients.begin();
+       it != tg_clients.end(); ++it)
+  {
+    os << "svxreflector_tg_clients{tg=\"" << it->first << "\"} "
+       << it->second << "\n";
+  }
+  os << "# HELP svxreflector_tg_audio_rx_frames_total "
+        "Number of audio frames received from talkers on the talk group\n"
+     << "# TYPE svxreflector_tg_audio_rx_frames_total counter\n";
+  for (TGHandler::TGStatsMap::const_iterator it = tg_stats.begin();
+       it != tg_stats.end(); ++it)
+  {
+    os << "svxreflector_tg_audio_rx_frames_total{tg=\"" << it->first << "\"} "
+       << it->second.audio_rx_frames << "\n";
+  }
+  os << "# HELP svxreflector_tg_audio_rx_bytes_total "
+        "Number of audio bytes received from talkers on the talk group\n"
+     << "# TYPE svxreflector_tg_audio_rx_bytes_total counter\n";
+  for (TGHandler::TGStatsMap::const_iterator it = tg_stats.begin();
+       it != tg_stats.end(); ++it)
+  {
+    os << "svxreflector_tg_audio_rx_bytes_total{tg=\"" << it->first << "\"} "
+       << it->second.audio_rx_bytes << "\n";
+  }
+  os << "# HELP svxreflector_tg_audio_tx_frames_total "
+        "Number of audio frames sent to clients on the talk group\n"
+     << "# TYPE svxreflector_tg_audio_tx_frames_total counter\n";
+  for (TGHandler::TGStatsMap::const_iterator it = tg_stats.begin();
+       it != tg_stats.end(); ++it)
+  {
+    os << "svxreflector_tg_audio_tx_frames_total{tg=\"" << it->first << "\"} "
+       << it->second.audio_tx_frames << "\n";
+  }
+  os << "# HELP svxreflector_tg_audio_tx_bytes_total "
+        "Number of audio bytes sent to clients on the talk group\n"
+     << "# TYPE svxreflector_tg_audio_tx_bytes_total counter\n";
+  for (TGHandler::TGStatsMap::const_iterator it = tg_stats.begin();
+       it != tg_stats.end(); ++it)
+  {
+    os << "svxreflector_tg_audio_tx_bytes_total{tg=\"" << it->first << "\"} "
+       << it->second.audio_tx_bytes << "\n";
+  }
+  os << "# HELP svxreflector_tg_talker_sessions_total "
+        "Number of talker sessions on the talk group\n"
+     << "# TYPE svxreflector_tg_talker_sessions_total counter\n";
+  for (TGHandler::TGStatsMap::const_iterator it = tg_stats.begin();
+       it != tg_stats.end(); ++it)
+  {
+    os << "svxreflector_tg_talker_sessions_total{tg=\"" << it->first << "\"} "
+       << it->second.talker_sessions << "\n";
+  }
+  os << "# HELP svxreflector_tg_talker_seconds_total "
+        "Time with an active talker on the talk group\n"
+     << "# TYPE svxreflector_tg_talker_seconds_total counter\n";
+  for (TGHandler::TGStatsMap::const_iterator it = tg_stats.begin();
+       it != tg_stats.end(); ++it)
+  {
+    os << "svxreflector_tg_talker_seconds_total{tg=\"" << it->first << "\"} "
+       << it->second.talker_time << "\n";
+  }
+  return os.str();
+} /* Reflector::buildMetrics */
 
 
 void Reflector::httpClientConnected(Async::HttpServerConnection *con)
@@ -747,6 +1488,7 @@ void Reflector::httpClientDisconnected(Async::HttpServerConnection *con,
   //          << con->remoteHost() << ":" << con->remotePort()
   //          << ": " << Async::HttpServerConnection::disconnectReasonStr(reason)
   //          << std::endl;
+  m_status_streams.erase(con);
 } /* Reflector::httpClientDisconnected */
 
 
@@ -792,7 +1534,862 @@ uint32_t Reflector::nextRandomQsyTg(void)
 } /* Reflector::nextRandomQsyTg */
 
 
+bool Reflector::initTrunks(void)
+{
+  std::vector<std::string> trunks;
+  m_cfg->getValue("GLOBAL", "TRUNKS", trunks);
+  if (trunks.empty())
+  {
+    return true;
+  }
+
+  if (!m_cfg->getValue("GLOBAL", "TRUNK_ID", m_trunk_id) || m_trunk_id.empty())
+  {
+    cerr << "*** ERROR: GLOBAL/TRUNK_ID must be set when GLOBAL/TRUNKS is "
+            "used" << endl;
+    return false;
+  }
+
+  for (std::vector<std::string>::const_iterator it = trunks.begin();
+       it != trunks.end(); ++it)
+  {
+    TrunkLink *link = createTrunkLink(*it);
+    if (!link->initialize())
+    {
+      return false;
+    }
+  }
+
+  initTrunkServer();
+
+  m_trunk_timer.setEnable(true);
+
+  return true;
+} /* Reflector::initTrunks */
+
+
+TrunkLink *Reflector::createTrunkLink(const std::string& name)
+{
+  TrunkLink *link = new TrunkLink(*m_cfg, name, m_trunk_id);
+  link->linkStateChanged.connect(
+      mem_fun(*this, &Reflector::onTrunkLinkStateChanged));
+  link->talkerStartReceived.connect(
+      mem_fun(*this, &Reflector::onTrunkTalkerStart));
+  link->talkerStopReceived.connect(
+      mem_fun(*this, &Reflector::onTrunkTalkerStop));
+  link->audioReceived.connect(mem_fun(*this, &Reflector::onTrunkAudio));
+  m_trunk_links.push_back(link);
+  return link;
+} /* Reflector::createTrunkLink */
+
+
+void Reflector::removeTrunkLink(TrunkLink *link)
+{
+    // Stop the talkers received over the link before it goes away
+  onTrunkLinkStateChanged(link, false);
+  m_trunk_links.erase(
+      std::find(m_trunk_links.begin(), m_trunk_links.end(), link));
+  delete link;
+} /* Reflector::removeTrunkLink */
+
+
+void Reflector::initTrunkServer(void)
+{
+  delete m_trunk_srv;
+  m_trunk_srv = 0;
+  m_trunk_listen_port.clear();
+  if (m_cfg->getValue("GLOBAL", "TRUNK_LISTEN_PORT", m_trunk_listen_port) &&
+      !m_trunk_listen_port.empty())
+  {
+    m_trunk_srv = new FramedTcpServer(m_trunk_listen_port);
+    m_trunk_srv->clientConnected.connect(
+        mem_fun(*this, &Reflector::trunkClientConnected));
+    m_trunk_srv->clientDisconnected.connect(
+        mem_fun(*this, &Reflector::trunkClientDisconnected));
+  }
+} /* Reflector::initTrunkServer */
+
+
+void Reflector::scheduleTrunkReload(const std::string& link_name)
+{
+  m_dirty_trunk_links.insert(link_name);
+  if (!m_trunk_reload_pending)
+  {
+      // Wait until all changes from a configuration reload have been applied
+    m_trunk_reload_pending = true;
+    Application::app().runTask(mem_fun(*this, &Reflector::reloadTrunks));
+  }
+} /* Reflector::scheduleTrunkReload */
+
+
+void Reflector::reloadTrunks(void)
+{
+  m_trunk_reload_pending = false;
+  std::set<std::string> dirty;
+  dirty.swap(m_dirty_trunk_links);
+
+  std::vector<std::string> trunks;
+  m_cfg->getValue("GLOBAL", "TRUNKS", trunks);
+  std::string trunk_id;
+  m_cfg->getValue("GLOBAL", "TRUNK_ID", trunk_id);
+  if (!trunks.empty() && trunk_id.empty())
+  {
+    cerr << "*** WARNING: GLOBAL/TRUNK_ID must be set when GLOBAL/TRUNKS is "
+            "used. Trunk configuration not reloaded." << endl;
+    return;
+  }
+
+  std::string trunk_listen_port;
+  m_cfg->getValue("GLOBAL", "TRUNK_LISTEN_PORT", trunk_listen_port);
+  bool restart_srv = (trunk_listen_port != m_trunk_listen_port);
+
+    // Incoming trunk connections are owned by the trunk server so all links
+    // must go before the server is replaced
+  bool reinit_all = restart_srv || (trunk_id != m_trunk_id);
+  m_trunk_id = trunk_id;
+
+  std::vector<TrunkLink*> links(m_trunk_links);
+  for (std::vector<TrunkLink*>::iterator it = links.begin();
+       it != links.end(); ++it)
+  {
+    TrunkLink *link = *it;
+    if (reinit_all || (dirty.count(link->name()) > 0) ||
+        (std::find(trunks.begin(), trunks.end(), link->name()) ==
+         trunks.end()))
+    {
+      cout << link->name() << ": Trunk configuration changed. "
+              "Restarting trunk link." << endl;
+      removeTrunkLink(link);
+    }
+  }
+
+  if (restart_srv)
+  {
+    initTrunkServer();
+  }
+
+  for (std::vector<std::string>::const_iterator it = trunks.begin();
+       it != trunks.end(); ++it)
+  {
+    bool exists = false;
+    for (std::vector<TrunkLink*>::const_iterator lit = m_trunk_links.begin();
+         lit != m_trunk_links.end(); ++lit)
+    {
+      exists = exists || ((*lit)->name() == *it);
+    }
+    if (exists)
+    {
+      continue;
+    }
+    TrunkLink *link = createTrunkLink(*it);
+    if (!link->initialize())
+    {
+      cerr << "*** WARNING: Could not initialize trunk link " << *it
+           << ". Skipping it." << endl;
+      removeTrunkLink(link);
+    }
+  }
+
+  m_trunk_timer.setEnable(!m_trunk_links.empty());
+  statusChanged();
+} /* Reflector::reloadTrunks */
+
+
+void Reflector::trunkClientConnected(Async::FramedTcpConnection *con)
+{
+  cout << "Trunk connection from " << con->remoteHost() << ":"
+       << con->remotePort() << endl;
+  con->setMaxFrameSize(TrunkLink::MAX_PREAUTH_FRAME_SIZE);
+  con->setFrameHandler<Reflector, &Reflector::trunkFrameReceived>(this);
+} /* Reflector::trunkClientConnected */
+
+
+void Reflector::trunkClientDisconnected(Async::FramedTcpConnection *con,
+                           Async::FramedTcpConnection::DisconnectReason reason)
+{
+  for (std::vector<TrunkLink*>::iterator it = m_trunk_links.begin();
+       it != m_trunk_links.end(); ++it)
+  {
+    (*it)->connectionClosed(con, reason);
+  }
+} /* Reflector::trunkClientDisconnected */
+
+
+void Reflector::trunkFrameReceived(Async::FramedTcpConnection *con,
+                                   Async::DataView data)
+{
+    // Only the first frame on an incoming trunk connection end up here. It
+    // must be a hello message which tell us which link it belong to.
+  con->clearFrameHandler();
+
+  stringstream ss;
+  ss.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+  ReflectorMsg header;
+  MsgTrunkHello hello;
+  if (!header.unpack(ss) || (header.type() != MsgTrunkHello::TYPE) ||
+      !hello.unpack(ss))
+  {
+    cerr << "*** WARNING: Illegal trunk hello from " << con->remoteHost()
+         << ":" << con->remotePort() << endl;
+    con->disconnect();
+    con->disconnected(con, FramedTcpConnection::DR_ORDERED_DISCONNECT);
+    return;
+  }
+
+  for (std::vector<TrunkLink*>::iterator it = m_trunk_links.begin();
+       it != m_trunk_links.end(); ++it)
+  {
+    TrunkLink *link = *it;
+    if (link->peerId() == hello.id())
+    {
+      if (!link->acceptConnection(con, hello))
+      {
+        con->disconnect();
+        con->disconnected(con, FramedTcpConnection::DR_ORDERED_DISCONNECT);
+      }
+      return;
+    }
+  }
+
+  cerr << "*** WARNING: Trunk connection from " << con->remoteHost() << ":"
+       << con->remotePort() << " has unknown peer id \"" << hello.id()
+       << "\"" << endl;
+  con->disconnect();
+  con->disconnected(con, FramedTcpConnection::DR_ORDERED_DISCONNECT);
+} /* Reflector::trunkFrameReceived */
+
+
+void Reflector::onTrunkLinkStateChanged(TrunkLink *link, bool is_up)
+{
+  statusChanged();
+  if (is_up)
+  {
+      // Bring the peer up to date with our subscriptions and talkers
+    std::set<uint32_t> tgs;
+    TGHandler::instance()->activeTGs(tgs);
+    link->sendMsg(MsgTrunkSubscribe(tgs));
+    for (std::set<uint32_t>::const_iterator it = tgs.begin();
+         it != tgs.end(); ++it)
+    {
+      ReflectorClient *talker = TGHandler::instance()->talkerForTG(*it);
+      if (talker != 0)
+      {
+        link->sendMsg(MsgTrunkTalkerStart(*it, talker->callsign()));
+      }
+    }
+    return;
+  }
+
+  TrunkTalkerMap::iterator it = m_trunk_talkers.begin();
+  while (it != m_trunk_talkers.end())
+  {
+    TrunkTalkerMap::iterator next = it;
+    ++next;
+    if (it->second.link == link)
+    {
+      trunkTalkerStopped(it);
+    }
+    it = next;
+  }
+} /* Reflector::onTrunkLinkStateChanged */
+
+
+void Reflector::onTrunkTalkerStart(TrunkLink *link, uint32_t tg,
+                                   const std::string& callsign)
+{
+  if (tg == 0)
+  {
+    return;
+  }
+
+  TrunkTalkerMap::iterator it = m_trunk_talkers.find(tg);
+  if (it != m_trunk_talkers.end())
+  {
+    if (it->second.link == link)
+    {
+      it->second.callsign = callsign;
+      it->second.last_audio = time(NULL);
+      return;
+    }
+      // Two peers claim the same TG. The one with the lowest id win.
+    if (it->second.link->peerId() < link->peerId())
+    {
+      return;
+    }
+    trunkTalkerStopped(it);
+  }
+
+  ReflectorClient *talker = TGHandler::instance()->talkerForTG(tg);
+  if ((talker != 0) && (m_trunk_id < link->peerId()))
+  {
+      // We win. The peer will yield when it receive our talker start.
+    return;
+  }
+
+  TrunkTalker& trunk_talker = m_trunk_talkers[tg];
+  trunk_talker.link = link;
+  trunk_talker.callsign = callsign;
+  trunk_talker.last_audio = time(NULL);
+  if (talker != 0)
+  {
+    cout << talker->callsign() << ": Yielding TG #" << tg << " to "
+         << callsign << " on trunk peer " << link->peerId() << endl;
+    TGHandler::instance()->setTalkerForTG(tg, 0);
+  }
+
+  cout << callsign << "@" << link->peerId() << ": Talker start on TG #"
+       << tg << endl;
+  statusChanged();
+  broadcastMsg(MsgTalkerStart(tg, callsign), tg, v2_client_filter);
+  if (tg == tgForV1Clients())
+  {
+    broadcastMsg(MsgTalkerStartV1(callsign), v1_client_filter);
+  }
+} /* Reflector::onTrunkTalkerStart */
+
+
+void Reflector::onTrunkTalkerStop(TrunkLink *link, uint32_t tg)
+{
+  TrunkTalkerMap::iterator it = m_trunk_talkers.find(tg);
+  if ((it != m_trunk_talkers.end()) && (it->second.link == link))
+  {
+    trunkTalkerStopped(it);
+  }
+} /* Reflector::onTrunkTalkerStop */
+
+
+void Reflector::onTrunkAudio(TrunkLink *link, uint32_t tg,
+                             const std::vector<uint8_t>& data)
+{
+  TrunkTalkerMap::iterator it = m_trunk_talkers.find(tg);
+  if ((it == m_trunk_talkers.end()) || (it->second.link != link))
+  {
+    return;
+  }
+  it->second.last_audio = time(NULL);
+  broadcastUdpMsg(MsgUdpAudio(data), tg);
+} /* Reflector::onTrunkAudio */
+
+
+void Reflector::onActiveTGsChanged(void)
+{
+  if (m_trunk_links.empty())
+  {
+    return;
+  }
+  std::set<uint32_t> tgs;
+  TGHandler::instance()->activeTGs(tgs);
+  broadcastTrunkMsg(MsgTrunkSubscribe(tgs));
+} /* Reflector::onActiveTGsChanged */
+
+
+void Reflector::broadcastTrunkMsg(const ReflectorMsg& msg)
+{
+  for (std::vector<TrunkLink*>::iterator it = m_trunk_links.begin();
+       it != m_trunk_links.end(); ++it)
+  {
+    (*it)->sendMsg(msg);
+  }
+} /* Reflector::broadcastTrunkMsg */
+
+
+void Reflector::forwardTrunkAudio(uint32_t tg, const uint8_t *data,
+                                  size_t len)
+{
+    // Pack the message once and share the frame between all peers
+  FramedTcpConnection::Frame *frame = 0;
+  for (std::vector<TrunkLink*>::iterator it = m_trunk_links.begin();
+       it != m_trunk_links.end(); ++it)
+  {
+    TrunkLink *link = *it;
+    if (link->isUp() && link->peerSubscribed(tg))
+    {
+      if (frame == 0)
+      {
+        frame = ReflectorClient::packMsg(
+            MsgTrunkAudio(tg, std::vector<uint8_t>(data, data + len)));
+        if (frame == 0)
+        {
+          return;
+        }
+      }
+      link->sendFrame(frame);
+    }
+  }
+  if (frame != 0)
+  {
+    frame->unref();
+  }
+} /* Reflector::forwardTrunkAudio */
+
+
+void Reflector::trunkTalkerStopped(TrunkTalkerMap::iterator it)
+{
+  uint32_t tg = it->first;
+  std::string callsign = it->second.callsign;
+  cout << callsign << "@" << it->second.link->peerId()
+       << ": Talker stop on TG #" << tg << endl;
+  m_trunk_talkers.erase(it);
+  statusChanged();
+  broadcastMsg(MsgTalkerStop(tg, callsign), tg, v2_client_filter);
+  if (tg == tgForV1Clients())
+  {
+    broadcastMsg(MsgTalkerStopV1(callsign), v1_client_filter);
+  }
+  broadcastUdpMsg(MsgUdpFlushSamples(), tg);
+} /* Reflector::trunkTalkerStopped */
+
+
+void Reflector::checkTrunkTalkers(Async::Timer *t)
+{
+  time_t now = time(NULL);
+  TrunkTalkerMap::iterator it = m_trunk_talkers.begin();
+  while (it != m_trunk_talkers.end())
+  {
+    TrunkTalkerMap::iterator next = it;
+    ++next;
+    if (now - it->second.last_audio > TRUNK_TALKER_TIMEOUT)
+    {
+      cout << it->second.callsign << "@" << it->second.link->peerId()
+           << ": Talker audio timeout on TG #" << it->first << endl;
+      trunkTalkerStopped(it);
+    }
+    it = next;
+  }
+} /* Reflector::checkTrunkTalkers */
+
+
+void Reflector::handleHeartbeats(Async::Timer *t)
+{
+    // One timer for all clients instead of one per client. A client may
+    // disconnect while handling its heartbeat, which remove it from the
+    // client map, so iterate over a copy. The client objects are deleted
+    // later so the pointers stay valid during the sweep.
+  std::vector<ReflectorClient*> clients;
+  clients.reserve(m_client_map.size());
+  for (ReflectorClientMap::const_iterator it = m_client_map.begin();
+       it != m_client_map.end(); ++it)
+  {
+    clients.push_back(it->second);
+  }
+  for (std::vector<ReflectorClient*>::const_iterator it = clients.begin();
+       it != clients.end(); ++it)
+  {
+    (*it)->handleHeartbeat();
+  }
+
+    // Keep idle status streams from being closed by proxies
+  if (++m_status_keepalive_cnt >= STATUS_KEEPALIVE_INTERVAL)
+  {
+    m_status_keepalive_cnt = 0;
+    static const char keepalive[] = ":\n\n";
+    for (std::set<Async::HttpServerConnection*>::const_iterator it =
+           m_status_streams.begin();
+         it != m_status_streams.end(); ++it)
+    {
+      (*it)->write(keepalive, sizeof(keepalive) - 1);
+    }
+  }
+
+    // Save the sessions regularly so that they survive a crash too
+  if ((m_sessions != 0) && (++m_sessions_save_cnt >= SESSION_SAVE_INTERVAL))
+  {
+    m_sessions_save_cnt = 0;
+    if (m_status_gen != m_sessions_save_gen)
+    {
+      saveSessions();
+    }
+  }
+} /* Reflector::handleHeartbeats */
+
+
+void Reflector::saveSessions(void)
+{
+  const time_t now = time(NULL);
+  ReflectorSessions::SessionMap sessions;
+  for (ReflectorClientMap::const_iterator it = m_client_map.begin();
+       it != m_client_map.end(); ++it)
+  {
+    const ReflectorClient *client = it->second;
+    if ((client->conState() != ReflectorClient::STATE_CONNECTED) ||
+        client->sessionToken().empty())
+    {
+      continue;
+    }
+    ReflectorSessions::Session& session = sessions[client->callsign()];
+    session.token = client->sessionToken();
+    session.time = now;
+    session.tg = client->currentTG();
+    session.monitored_tgs.assign(client->monitoredTGs().begin(),
+                                 client->monitoredTGs().end());
+    session.node_info_json = client->nodeInfoJson();
+  }
+  m_sessions->save(sessions);
+  m_sessions_save_gen = m_status_gen;
+} /* Reflector::saveSessions */
+
+
+bool Reflector::initCodecs(void)
+{
+  m_cfg->getValue("GLOBAL", "TRANSCODE", m_transcode);
+
+  m_codecs.clear();
+  std::string codecs;
+  if (m_cfg->getValue("GLOBAL", "CODECS", codecs))
+  {
+    SvxLink::splitStr(m_codecs, codecs, ",");
+  }
+
+  if (m_transcode)
+  {
+    if (m_codecs.empty())
+    {
+      const char *default_codecs[] = { "OPUS", "SPEEX", "GSM" };
+      m_codecs.assign(default_codecs, default_codecs + 3);
+    }
+    std::vector<std::string>::iterator it = m_codecs.begin();
+    while (it != m_codecs.end())
+    {
+      if (!TGTranscoder::codecIsAvailable(*it))
+      {
+        cout << "*** WARNING: Codec \"" << *it << "\" is not available for "
+                "transcoding. Removing it from GLOBAL/CODECS." << endl;
+        it = m_codecs.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+    if (m_codecs.empty())
+    {
+      cerr << "*** ERROR: No codecs available for transcoding" << endl;
+      return false;
+    }
+    cout << "Transcoding between codecs:";
+    for (it = m_codecs.begin(); it != m_codecs.end(); ++it)
+    {
+      cout << " " << *it;
+    }
+    cout << endl;
+    return true;
+  }
+
+  if (m_codecs.size() > 1)
+  {
+    m_codecs.erase(m_codecs.begin()+1, m_codecs.end());
+    cout << "*** WARNING: The GLOBAL/CODECS configuration "
+            "variable can only take one codec unless transcoding is "
+            "enabled. Using the first one: \"" << m_codecs.front() << "\""
+         << endl;
+  }
+  else if (m_codecs.empty())
+  {
+    string codec = "GSM";
+    if (TGTranscoder::codecIsAvailable("OPUS"))
+    {
+      codec = "OPUS";
+    }
+    else if (TGTranscoder::codecIsAvailable("SPEEX"))
+    {
+      codec = "SPEEX";
+    }
+    m_codecs.push_back(codec);
+  }
+  return true;
+} /* Reflector::initCodecs */
+
+
+void Reflector::transcodeAudio(uint32_t tg, ReflectorClient *talker,
+                               const uint8_t *data, size_t len)
+{
+    // Find out which other codecs are in use on the talk group. Each codec
+    // is only encoded once, no matter how many clients that use it.
+  std::set<std::string> codecs;
+  const TGHandler::ClientSet& clients = TGHandler::instance()->clientsForTG(tg);
+  for (TGHandler::ClientSet::const_iterator it = clients.begin();
+       it != clients.end(); ++it)
+  {
+    ReflectorClient *client = *it;
+    if ((client->codec() != talker->codec()) &&
+        (client->conState() == ReflectorClient::STATE_CONNECTED))
+    {
+      codecs.insert(client->codec());
+    }
+  }
+
+  TranscoderMap::iterator it = m_transcoders.find(tg);
+  if (it == m_transcoders.end())
+  {
+    if (codecs.empty())
+    {
+      return;
+    }
+    TGTranscoder *transcoder = new TGTranscoder(*m_cfg, tg, talker->codec());
+    transcoder->audioEncoded.connect(
+        mem_fun(*this, &Reflector::onTranscodedAudio));
+    it = m_transcoders.insert(std::make_pair(tg, transcoder)).first;
+  }
+  it->second->writeEncodedAudio(data, len, codecs);
+} /* Reflector::transcodeAudio */
+
+
+void Reflector::onTranscodedAudio(uint32_t tg, const std::string& codec,
+                                  const void *buf, int len)
+{
+  broadcastUdpMsg(MsgUdpAudio(buf, len), tg,
+                  ReflectorClient::CodecFilter(codec));
+} /* Reflector::onTranscodedAudio */
+
+
+void Reflector::stopTranscoding(uint32_t tg)
+{
+  TranscoderMap::iterator it = m_transcoders.find(tg);
+  if (it != m_transcoders.end())
+  {
+    TGTranscoder *transcoder = it->second;
+    m_transcoders.erase(it);
+    transcoder->flush();
+    delete transcoder;
+  }
+} /* Reflector::stopTranscoding */
+
+
+void Reflector::updateAuthKeys(void)
+{
+    // The HMAC key setup is done once for each password group so that only
+    // the challenge have to be hashed when a client authenticate
+  clearAuthKeys();
+  std::list<std::string> groups = m_cfg->listSection("PASSWORDS");
+  for (std::list<std::string>::const_iterator it = groups.begin();
+       it != groups.end(); ++it)
+  {
+    std::string auth_key;
+    if (!m_cfg->getValue("PASSWORDS", *it, auth_key) || auth_key.empty())
+    {
+      continue;
+    }
+    gcry_md_hd_t hd = { 0 };
+    gcry_error_t err = gcry_md_open(&hd, MsgAuthResponse::ALGO,
+                                    GCRY_MD_FLAG_HMAC);
+    if (!err)
+    {
+      err = gcry_md_setkey(hd, auth_key.c_str(), auth_key.size());
+    }
+    if (err)
+    {
+      gcry_md_close(hd);
+      cerr << "*** ERROR: gcrypt error: "
+           << gcry_strsource(err) << "/" << gcry_strerror(err) << endl;
+      continue;
+    }
+    m_auth_keys[*it] = hd;
+  }
+
+  std::list<std::string> users = m_cfg->listSection("USERS");
+  m_user_groups.reserve(users.size());
+  for (std::list<std::string>::const_iterator it = users.begin();
+       it != users.end(); ++it)
+  {
+    m_cfg->getValue("USERS", *it, m_user_groups[*it]);
+  }
+  m_auth_keys_dirty = false;
+} /* Reflector::updateAuthKeys */
+
+
+void Reflector::clearAuthKeys(void)
+{
+  for (AuthKeyMap::iterator it = m_auth_keys.begin();
+       it != m_auth_keys.end(); ++it)
+  {
+    gcry_md_close(it->second);
+  }
+  m_auth_keys.clear();
+  m_user_groups.clear();
+  m_auth_keys_dirty = true;
+} /* Reflector::clearAuthKeys */
+
+
+void Reflector::cfgValueUpdated(const std::string& section,
+                                const std::string& tag)
+{
+    // The key table is rebuilt on the next login so that many updates in a
+    // row only cause one rebuild
+  if ((section == "USERS") || (section == "PASSWORDS"))
+  {
+    m_auth_keys_dirty = true;
+  }
+  else if (section == "GLOBAL")
+  {
+    if (tag == "TG_FOR_V1_CLIENTS")
+    {
+      m_tg_for_v1_clients = 1;
+      m_cfg->getValue("GLOBAL", "TG_FOR_V1_CLIENTS", m_tg_for_v1_clients);
+    }
+    else if (tag == "RANDOM_QSY_RANGE")
+    {
+      setupRandomQsy();
+    }
+    else if (tag == "SQL_TIMEOUT")
+    {
+      unsigned sql_timeout = 0;
+      m_cfg->getValue("GLOBAL", "SQL_TIMEOUT", sql_timeout);
+      TGHandler::instance()->setSqlTimeout(sql_timeout);
+    }
+    else if (tag == "SQL_TIMEOUT_BLOCKTIME")
+    {
+      unsigned sql_timeout_blocktime = 60;
+      m_cfg->getValue("GLOBAL", "SQL_TIMEOUT_BLOCKTIME",
+                      sql_timeout_blocktime);
+      TGHandler::instance()->setSqlTimeoutBlocktime(sql_timeout_blocktime);
+    }
+    else if (tag == "HTTP_SRV_PORT")
+    {
+      initHttpServer();
+    }
+    else if ((tag == "UDP_SEND_QUEUE_SIZE") ||
+             (tag == "UDP_SEND_QUEUE_DROP") || (tag == "UDP_SNDBUF"))
+    {
+      setupUdpSendQueue();
+    }
+    else if ((tag == "TRUNKS") || (tag == "TRUNK_ID") ||
+             (tag == "TRUNK_LISTEN_PORT"))
+    {
+      scheduleTrunkReload("");
+    }
+    else if ((tag == "LISTEN_PORT") || (tag == "UDP_SHARDS") ||
+             (tag == "TRANSCODE") || (tag == "CODECS") ||
+             (tag == "CAPTURE_FILE") || (tag == "CAPTURE_MAX_SIZE"))
+    {
+      cout << "*** WARNING: The reflector must be restarted for a change "
+              "of GLOBAL/" << tag << " to take effect" << endl;
+    }
+  }
+  else if (section.compare(0, 3, "TG#") == 0)
+  {
+    uint32_t tg = 0;
+    if ((tag == "AUTO_QSY_AFTER") &&
+        SvxLink::setValueFromString(tg, section.substr(3)))
+    {
+      TGHandler::instance()->updateAutoQsyAfter(tg);
+    }
+  }
+  else
+  {
+    for (std::vector<TrunkLink*>::const_iterator it = m_trunk_links.begin();
+         it != m_trunk_links.end(); ++it)
+    {
+      if ((*it)->name() == section)
+      {
+        scheduleTrunkReload(section);
+        break;
+      }
+    }
+  }
+} /* Reflector::cfgValueUpdated */
+
+
+void Reflector::setupRandomQsy(void)
+{
+  m_random_qsy_lo = m_random_qsy_hi = m_random_qsy_tg = 0;
+  SvxLink::SepPair<uint32_t, uint32_t> random_qsy_range;
+  if (m_cfg->getValue("GLOBAL", "RANDOM_QSY_RANGE", random_qsy_range))
+  {
+    m_random_qsy_lo = random_qsy_range.first;
+    m_random_qsy_hi = m_random_qsy_lo + random_qsy_range.second-1;
+    if ((m_random_qsy_lo < 1) || (m_random_qsy_hi < m_random_qsy_lo))
+    {
+      cout << "*** WARNING: Illegal RANDOM_QSY_RANGE specified. Ignored."
+           << endl;
+      m_random_qsy_hi = m_random_qsy_lo = 0;
+    }
+    m_random_qsy_tg = m_random_qsy_hi;
+  }
+} /* Reflector::setupRandomQsy */
+
+
+void Reflector::setupUdpSendQueue(void)
+{
+  unsigned queue_size = UdpSocket::DEFAULT_SEND_QUEUE_SIZE;
+  m_cfg->getValue("GLOBAL", "UDP_SEND_QUEUE_SIZE", queue_size);
+  UdpSocket::DropPolicy policy = UdpSocket::DROP_NEWEST;
+  std::string drop = "NEWEST";
+  m_cfg->getValue("GLOBAL", "UDP_SEND_QUEUE_DROP", drop);
+  if (drop == "OLDEST")
+  {
+    policy = UdpSocket::DROP_OLDEST;
+  }
+  else if (drop != "NEWEST")
+  {
+    cout << "*** WARNING: Illegal UDP_SEND_QUEUE_DROP \"" << drop
+         << "\" specified. Valid values are NEWEST and OLDEST. "
+            "Using NEWEST." << endl;
+  }
+  m_udp_sock->setSendQueueSize(queue_size, policy);
+
+  int sndbuf = 0;
+  if (m_cfg->getValue("GLOBAL", "UDP_SNDBUF", sndbuf) && (sndbuf > 0))
+  {
+    m_udp_sock->setSendBufferSize(sndbuf);
+  }
+} /* Reflector::setupUdpSendQueue */
+
+
+void Reflector::initHttpServer(void)
+{
+  m_status_streams.clear();
+  delete m_http_server;
+  m_http_server = 0;
+  std::string http_srv_port;
+  if (m_cfg->getValue("GLOBAL", "HTTP_SRV_PORT", http_srv_port) &&
+      !http_srv_port.empty())
+  {
+    m_http_server = new Async::TcpServer<Async::HttpServerConnection>(http_srv_port);
+    m_http_server->clientConnected.connect(
+        sigc::mem_fun(*this, &Reflector::httpClientConnected));
+    m_http_server->clientDisconnected.connect(
+        sigc::mem_fun(*this, &Reflector::httpClientDisconnected));
+  }
+} /* Reflector::initHttpServer */
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static std::string promLabelValue(const std::string& str)
+{
+  std::string escaped;
+  for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+  {
+    switch (*it)
+    {
+      case '\\': escaped += "\\\\"; break;
+      case '"':  escaped += "\\\""; break;
+      case '\n': escaped += "\\n"; break;
+      default:   escaped += *it; break;
+    }
+  }
+  return escaped;
+} /* promLabelValue */
+
+
+static std::string compactJson(const Json::Value& value)
+{
+  std::ostringstream os;
+  Json::StreamWriterBuilder builder;
+  builder["commentStyle"] = "None";
+  builder["indentation"] = ""; //The JSON document is written on a single line
+  Json::StreamWriter* writer = builder.newStreamWriter();
+  writer->write(value, &os);
+  delete writer;
+  return os.str();
+} /* compactJson */
+
+
 /*
  * This file has not been truncated
  */
-
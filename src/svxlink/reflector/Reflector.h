@@ -38,6 +38,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sys/time.h>
 #include <vector>
 #include <string>
+#include <set>
+#include <unordered_map>
 
 
 /****************************************************************************
@@ -60,6 +62,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "ProtoVer.h"
 #include "ReflectorClient.h"
+#include "ReflectorShard.h"
+#include "TrunkLink.h"
+#include "TGTranscoder.h"
+#include "ReflectorCapture.h"
+#include "ReflectorRecorder.h"
+#include "ReflectorSessions.h"
 
 
 /****************************************************************************
@@ -72,6 +80,7 @@ namespace Async
 {
   class UdpSocket;
   class Config;
+  class SslContext;
 };
 
 class ReflectorMsg;
@@ -157,6 +166,20 @@ class Reflector : public sigc::trackable
     void broadcastMsg(const ReflectorMsg& msg,
         const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
 
+    /**
+     * @brief   Broadcast a TCP message to the clients of a talk group
+     * @param   msg The message to broadcast
+     * @param   tg The talk group
+     * @param   filter The client filter to apply
+     *
+     * The message is sent to all clients that have selected or are
+     * monitoring the given talk group. Only those clients are visited so
+     * this is a lot cheaper than using a TgFilter when there are many
+     * connected clients.
+     */
+    void broadcastMsg(const ReflectorMsg& msg, uint32_t tg,
+        const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
+
     /**
      * @brief   Send a UDP datagram to the specificed ReflectorClient
      * @param   client The client to the send datagram to
@@ -166,9 +189,30 @@ class Reflector : public sigc::trackable
      */
     bool sendUdpDatagram(ReflectorClient *client, const void *buf, size_t count);
 
+    /**
+     * @brief   Send a UDP datagram gathered from multiple buffers
+     * @param   client The client to the send datagram to
+     * @param   iov The buffers making up the datagram
+     * @param   iovcnt The number of buffers
+     * @return  Returns \em true on success or else \em false
+     */
+    bool sendUdpDatagram(ReflectorClient *client, const struct iovec *iov,
+                         int iovcnt);
+
     void broadcastUdpMsg(const ReflectorUdpMsg& msg,
         const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
 
+    /**
+     * @brief   Broadcast a UDP message to the clients on a talk group
+     * @param   msg The message to broadcast
+     * @param   tg The talk group
+     * @param   filter The client filter to apply
+     *
+     * Only the clients that have selected the given talk group are visited.
+     */
+    void broadcastUdpMsg(const ReflectorUdpMsg& msg, uint32_t tg,
+        const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
+
     /**
      * @brief   Get the TG for protocol V1 clients
      * @return  Returns the TG used for protocol V1 clients
@@ -181,13 +225,100 @@ class Reflector : public sigc::trackable
      */
     void requestQsy(ReflectorClient *client, uint32_t tg);
 
+    /**
+     * @brief   Mark the status information as changed
+     *
+     * Call this function when something shown in the HTTP status document
+     * has changed so that it is rebuilt on the next request.
+     */
+    void statusChanged(void) { ++m_status_gen; }
+
+    /**
+     * @brief   Send an event to the status stream subscribers
+     * @param   event The name of the event
+     * @param   data  The event data
+     *
+     * The event is sent to all HTTP clients that have requested the
+     * /status/events Server-Sent Events stream. Call this function when a
+     * talker start or stop, a node join or leave or a node select a new TG.
+     */
+    void statusEvent(const std::string& event, const Json::Value& data);
+
+    /**
+     * @brief   Get the audio codecs offered to the clients
+     * @return  Returns the codecs in order of preference
+     *
+     * The list contain more than one codec only if transcoding is enabled.
+     */
+    const std::vector<std::string>& codecs(void) const { return m_codecs; }
+
+    /**
+     * @brief   Verify an authentication response from a client
+     * @param   msg       The received authentication response
+     * @param   challenge The challenge previously sent to the client
+     * @return  Returns \em true if the user is known and the digest is correct
+     *
+     * The keys are looked up in a table that is built from the USERS and
+     * PASSWORDS configuration sections. The table is rebuilt when any of
+     * these sections are changed.
+     */
+    bool verifyAuthResponse(const MsgAuthResponse& msg,
+                            const unsigned char *challenge);
+
+    /**
+     * @brief   Check if client sessions are stored for resumption
+     * @return  Returns \em true if GLOBAL/SESSION_FILE is set
+     */
+    bool sessionsEnabled(void) const { return m_sessions != 0; }
+
+    /**
+     * @brief   Look up and verify a stored session for a resuming client
+     * @param   msg       The received session resumption message
+     * @param   challenge The challenge previously sent to the client
+     * @param   session   Set to the stored session on success
+     * @return  Returns \em true if the session was found and the digest is
+     *          correct
+     *
+     * A stored session is removed when it has been successfully verified so
+     * it can only be used once. The user must still be present in the
+     * configuration.
+     */
+    bool resumeSession(const MsgSessionResume& msg,
+                       const unsigned char *challenge,
+                       ReflectorSessions::Session& session);
+
+    /**
+     * @brief   Get the capture file writer
+     * @return  Returns the writer or 0 if capturing is not enabled
+     *
+     * The clients record the traffic they receive through this object when
+     * GLOBAL/CAPTURE_FILE is set.
+     */
+    ReflectorCaptureWriter *capture(void) { return m_capture; }
+
   private:
-    typedef std::map<uint32_t, ReflectorClient*> ReflectorClientMap;
+    static const unsigned UDP_BATCH_SIZE = 64;
+    static const time_t   TRUNK_TALKER_TIMEOUT = 3; // Max three seconds gap
+    static const unsigned STATUS_KEEPALIVE_INTERVAL = 30; // Seconds
+    static const unsigned SESSION_SAVE_INTERVAL = 60;     // Seconds
+
+    typedef std::unordered_map<uint32_t, ReflectorClient*> ReflectorClientMap;
     typedef std::map<Async::FramedTcpConnection*,
                      ReflectorClient*> ReflectorClientConMap;
     typedef Async::TcpServer<Async::FramedTcpConnection> FramedTcpServer;
+    struct TrunkTalker
+    {
+      TrunkLink*  link;
+      std::string callsign;
+      time_t      last_audio;
+    };
+    typedef std::map<uint32_t, TrunkTalker> TrunkTalkerMap;
+    typedef std::map<uint32_t, TGTranscoder*> TranscoderMap;
+    typedef std::unordered_map<std::string, std::string> UserGroupMap;
+    typedef std::unordered_map<std::string, gcry_md_hd_t> AuthKeyMap;
 
     FramedTcpServer*                                m_srv;
+    Async::SslContext*                              m_ssl_ctx;
     Async::UdpSocket*                               m_udp_sock;
     ReflectorClientMap                              m_client_map;
     ReflectorClientConMap                           m_client_con_map;
@@ -197,6 +328,35 @@ class Reflector : public sigc::trackable
     uint32_t                                        m_random_qsy_hi;
     uint32_t                                        m_random_qsy_tg;
     Async::TcpServer<Async::HttpServerConnection>*  m_http_server;
+    std::vector<ReflectorShard*>                    m_shards;
+    ReflectorShard::Payload                         m_bcast_payload;
+    time_t                                          m_start_time;
+    unsigned                                        m_status_gen;
+    unsigned                                        m_status_cache_gen;
+    std::string                                     m_status_cache;
+    std::set<Async::HttpServerConnection*>          m_status_streams;
+    unsigned                                        m_status_keepalive_cnt;
+    std::string                                     m_status_etag;
+    FramedTcpServer*                                m_trunk_srv;
+    std::string                                     m_trunk_id;
+    std::vector<TrunkLink*>                         m_trunk_links;
+    TrunkTalkerMap                                  m_trunk_talkers;
+    Async::Timer                                    m_trunk_timer;
+    Async::Timer                                    m_heartbeat_timer;
+    std::vector<std::string>                        m_codecs;
+    bool                                            m_transcode;
+    TranscoderMap                                   m_transcoders;
+    UserGroupMap                                    m_user_groups;
+    AuthKeyMap                                      m_auth_keys;
+    bool                                            m_auth_keys_dirty;
+    ReflectorCaptureWriter*                         m_capture;
+    ReflectorRecorder*                              m_recorder;
+    ReflectorSessions*                              m_sessions;
+    unsigned                                        m_sessions_save_cnt;
+    unsigned                                        m_sessions_save_gen;
+    std::string                                     m_trunk_listen_port;
+    std::set<std::string>                           m_dirty_trunk_links;
+    bool                                            m_trunk_reload_pending;
 
     Reflector(const Reflector&);
     Reflector& operator=(const Reflector&);
@@ -204,16 +364,59 @@ class Reflector : public sigc::trackable
     void clientDisconnected(Async::FramedTcpConnection *con,
                             Async::FramedTcpConnection::DisconnectReason reason);
     void udpDatagramReceived(const Async::IpAddress& addr, uint16_t port,
-                             void *buf, int count);
+                             Async::DataView data);
     void onTalkerUpdated(uint32_t tg, ReflectorClient* old_talker,
                          ReflectorClient *new_talker);
     void httpRequestReceived(Async::HttpServerConnection *con,
                              Async::HttpServerConnection::Request& req);
+    bool packUdpPayload(const ReflectorUdpMsg& msg);
+    void broadcastUdpPayload(uint16_t type, const void *buf, size_t len,
+        uint32_t tg, const ReflectorClient::Filter& filter);
+    void beginUdpBatch(void);
+    void flushUdpBatch(void);
+    void updateStatusCache(void);
+    std::string buildMetrics(void);
+    void updateAuthKeys(void);
+    void clearAuthKeys(void);
+    void cfgValueUpdated(const std::string& section, const std::string& tag);
     void httpClientConnected(Async::HttpServerConnection *con);
     void httpClientDisconnected(Async::HttpServerConnection *con,
         Async::HttpServerConnection::DisconnectReason reason);
     void onRequestAutoQsy(uint32_t from_tg);
+    bool initTrunks(void);
+    TrunkLink *createTrunkLink(const std::string& name);
+    void removeTrunkLink(TrunkLink *link);
+    void initTrunkServer(void);
+    void scheduleTrunkReload(const std::string& link_name);
+    void reloadTrunks(void);
+    void setupRandomQsy(void);
+    void setupUdpSendQueue(void);
+    void initHttpServer(void);
+    void trunkClientConnected(Async::FramedTcpConnection *con);
+    void trunkClientDisconnected(Async::FramedTcpConnection *con,
+                           Async::FramedTcpConnection::DisconnectReason reason);
+    void trunkFrameReceived(Async::FramedTcpConnection *con,
+                            Async::DataView data);
+    void onTrunkLinkStateChanged(TrunkLink *link, bool is_up);
+    void onTrunkTalkerStart(TrunkLink *link, uint32_t tg,
+                            const std::string& callsign);
+    void onTrunkTalkerStop(TrunkLink *link, uint32_t tg);
+    void onTrunkAudio(TrunkLink *link, uint32_t tg,
+                      const std::vector<uint8_t>& data);
+    void onActiveTGsChanged(void);
+    void broadcastTrunkMsg(const ReflectorMsg& msg);
+    void forwardTrunkAudio(uint32_t tg, const uint8_t *data, size_t len);
+    void trunkTalkerStopped(TrunkTalkerMap::iterator it);
+    void checkTrunkTalkers(Async::Timer *t);
+    void handleHeartbeats(Async::Timer *t);
+    void saveSessions(void);
     uint32_t nextRandomQsyTg(void);
+    bool initCodecs(void);
+    void transcodeAudio(uint32_t tg, ReflectorClient *talker,
+                        const uint8_t *data, size_t len);
+    void onTranscodedAudio(uint32_t tg, const std::string& codec,
+                           const void *buf, int len);
+    void stopTranscoding(uint32_t tg);
 
 };  /* class Reflector */
 
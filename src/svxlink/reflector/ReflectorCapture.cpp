@@ -0,0 +1,394 @@
+/**
+@file   ReflectorCapture.cpp
+@brief  Capture of incoming reflector traffic to a file
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <time.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorCapture.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // A LEB128 encoded 64 bit integer is at most ten bytes long
+#define MAX_VARINT_SIZE 10
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static uint64_t now_us(void);
+static size_t encode_varint(uint64_t value, char *buf);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+const char ReflectorCapture::MAGIC[8] = {'S','V','X','R','C','A','P','\0'};
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+bool ReflectorCapture::decodeLogin(const Record& rec, std::string& callsign,
+                                   ProtoVer& ver)
+{
+  if ((rec.type != RECORD_LOGIN) || (rec.data.size() < 4))
+  {
+    return false;
+  }
+  const uint8_t *p = &rec.data[0];
+  ver.set((p[0] << 8) | p[1], (p[2] << 8) | p[3]);
+  callsign.assign(rec.data.begin() + 4, rec.data.end());
+  return !callsign.empty();
+} /* ReflectorCapture::decodeLogin */
+
+
+ReflectorCaptureWriter::ReflectorCaptureWriter(void)
+  : m_file_buf(FILE_BUF_SIZE), m_max_size(0), m_size(0), m_last_time_us(0),
+    m_flush_timer(1000, Timer::TYPE_PERIODIC, false)
+{
+  m_flush_timer.expired.connect(
+      sigc::mem_fun(*this, &ReflectorCaptureWriter::flush));
+} /* ReflectorCaptureWriter::ReflectorCaptureWriter */
+
+
+ReflectorCaptureWriter::~ReflectorCaptureWriter(void)
+{
+  close("reflector shutting down");
+} /* ReflectorCaptureWriter::~ReflectorCaptureWriter */
+
+
+bool ReflectorCaptureWriter::open(const std::string& path, uint64_t max_size)
+{
+  close("new capture file opened");
+  m_os.rdbuf()->pubsetbuf(&m_file_buf[0], m_file_buf.size());
+  m_os.open(path.c_str(), ios::out | ios::binary | ios::trunc);
+  if (!m_os.is_open())
+  {
+    cerr << "*** ERROR: Could not open capture file \"" << path << "\": "
+         << strerror(errno) << endl;
+    return false;
+  }
+  m_path = path;
+  m_max_size = max_size;
+  m_last_time_us = now_us();
+
+  const char version[2] = { char(ReflectorCapture::VERSION >> 8),
+                            char(ReflectorCapture::VERSION & 0xff) };
+  m_os.write(ReflectorCapture::MAGIC, sizeof(ReflectorCapture::MAGIC));
+  m_os.write(version, sizeof(version));
+  m_size = sizeof(ReflectorCapture::MAGIC) + sizeof(version);
+  m_flush_timer.setEnable(true);
+
+  cout << "Capturing incoming client traffic to \"" << path << "\"" << endl;
+  return true;
+} /* ReflectorCaptureWriter::open */
+
+
+void ReflectorCaptureWriter::login(uint32_t client_id,
+                                   const std::string& callsign,
+                                   const ProtoVer& ver)
+{
+  if (!isActive())
+  {
+    return;
+  }
+  std::vector<char> buf;
+  buf.reserve(4 + callsign.size());
+  buf.push_back(ver.majorVer() >> 8);
+  buf.push_back(ver.majorVer() & 0xff);
+  buf.push_back(ver.minorVer() >> 8);
+  buf.push_back(ver.minorVer() & 0xff);
+  buf.insert(buf.end(), callsign.begin(), callsign.end());
+  writeRecord(ReflectorCapture::RECORD_LOGIN, client_id, &buf[0], buf.size());
+} /* ReflectorCaptureWriter::login */
+
+
+void ReflectorCaptureWriter::logout(uint32_t client_id)
+{
+  writeRecord(ReflectorCapture::RECORD_LOGOUT, client_id, 0, 0);
+} /* ReflectorCaptureWriter::logout */
+
+
+void ReflectorCaptureWriter::tcpFrame(uint32_t client_id, const void *buf,
+                                      size_t len)
+{
+  writeRecord(ReflectorCapture::RECORD_TCP_FRAME, client_id, buf, len);
+} /* ReflectorCaptureWriter::tcpFrame */
+
+
+void ReflectorCaptureWriter::udpDatagram(uint32_t client_id, const void *buf,
+                                         size_t len)
+{
+  writeRecord(ReflectorCapture::RECORD_UDP_DATAGRAM, client_id, buf, len);
+} /* ReflectorCaptureWriter::udpDatagram */
+
+
+bool ReflectorCaptureReader::open(const std::string& path)
+{
+  m_is.open(path.c_str(), ios::in | ios::binary);
+  if (!m_is.is_open())
+  {
+    cerr << "*** ERROR: Could not open capture file \"" << path << "\": "
+         << strerror(errno) << endl;
+    return false;
+  }
+  char magic[sizeof(ReflectorCapture::MAGIC)];
+  unsigned char version[2];
+  m_is.read(magic, sizeof(magic));
+  m_is.read(reinterpret_cast<char*>(version), sizeof(version));
+  if (!m_is ||
+      (memcmp(magic, ReflectorCapture::MAGIC, sizeof(magic)) != 0))
+  {
+    cerr << "*** ERROR: \"" << path << "\" is not a reflector capture file"
+         << endl;
+    return false;
+  }
+  if (((version[0] << 8) | version[1]) != ReflectorCapture::VERSION)
+  {
+    cerr << "*** ERROR: Unsupported capture file version "
+         << ((version[0] << 8) | version[1]) << " in \"" << path << "\""
+         << endl;
+    return false;
+  }
+  m_time_us = 0;
+  return true;
+} /* ReflectorCaptureReader::open */
+
+
+bool ReflectorCaptureReader::read(ReflectorCapture::Record& rec)
+{
+  char type = 0;
+  uint64_t dt_us = 0;
+  uint64_t client_id = 0;
+  uint64_t len = 0;
+  if (!m_is.get(type) || !readVarint(dt_us) || !readVarint(client_id) ||
+      !readVarint(len) || (len > 0x100000))
+  {
+    return false;
+  }
+  rec.type = static_cast<ReflectorCapture::RecordType>(type);
+  m_time_us += dt_us;
+  rec.time_us = m_time_us;
+  rec.client_id = client_id;
+  rec.data.resize(len);
+  if (len > 0)
+  {
+    m_is.read(reinterpret_cast<char*>(&rec.data[0]), len);
+  }
+  return !m_is.fail();
+} /* ReflectorCaptureReader::read */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ReflectorCaptureWriter::writeRecord(ReflectorCapture::RecordType type,
+                                         uint32_t client_id, const void *buf,
+                                         size_t len)
+{
+  if (!isActive())
+  {
+    return;
+  }
+
+  char hdr[1 + 3 * MAX_VARINT_SIZE];
+  const uint64_t t = now_us();
+  size_t hdr_len = 0;
+  hdr[hdr_len++] = type;
+  hdr_len += encode_varint(t - m_last_time_us, hdr + hdr_len);
+  hdr_len += encode_varint(client_id, hdr + hdr_len);
+  hdr_len += encode_varint(len, hdr + hdr_len);
+  if ((m_max_size > 0) && (m_size + hdr_len + len > m_max_size))
+  {
+    close("maximum size reached");
+    return;
+  }
+  m_last_time_us = t;
+
+  m_os.write(hdr, hdr_len);
+  if (len > 0)
+  {
+    m_os.write(reinterpret_cast<const char*>(buf), len);
+  }
+  m_size += hdr_len + len;
+  if (!m_os)
+  {
+    close(strerror(errno));
+  }
+} /* ReflectorCaptureWriter::writeRecord */
+
+
+void ReflectorCaptureWriter::close(const char *reason)
+{
+  if (!isActive())
+  {
+    return;
+  }
+  m_flush_timer.setEnable(false);
+  m_os.close();
+  cout << "Capture to \"" << m_path << "\" stopped after " << m_size
+       << " bytes: " << reason << endl;
+} /* ReflectorCaptureWriter::close */
+
+
+void ReflectorCaptureWriter::flush(Async::Timer *t)
+{
+  m_os.flush();
+} /* ReflectorCaptureWriter::flush */
+
+
+bool ReflectorCaptureReader::readVarint(uint64_t& value)
+{
+  value = 0;
+  for (unsigned shift=0; shift<7*MAX_VARINT_SIZE; shift+=7)
+  {
+    char ch = 0;
+    if (!m_is.get(ch))
+    {
+      return false;
+    }
+    value |= static_cast<uint64_t>(ch & 0x7f) << shift;
+    if ((ch & 0x80) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+} /* ReflectorCaptureReader::readVarint */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+} /* now_us */
+
+
+static size_t encode_varint(uint64_t value, char *buf)
+{
+  size_t len = 0;
+  while (value >= 0x80)
+  {
+    buf[len++] = (value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+  buf[len++] = value;
+  return len;
+} /* encode_varint */
+
+
+
+/*
+ * This file has not been truncated
+ */
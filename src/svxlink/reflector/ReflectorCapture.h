@@ -0,0 +1,301 @@
+/**
+@file   ReflectorCapture.h
+@brief  Capture of incoming reflector traffic to a file
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef REFLECTOR_CAPTURE_INCLUDED
+#define REFLECTOR_CAPTURE_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncTimer.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ProtoVer.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  The capture file format
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+A capture file start with the eight byte magic "SVXRCAP" followed by a zero
+byte and a 16 bit format version. After that follow the records. Each record
+start with a one byte record type followed by the time since the previous
+record in microseconds, the client id and the payload length, all three
+encoded as unsigned LEB128 variable length integers. Then follow the payload.
+Multi byte integers in payloads are stored in network byte order.
+
+RECORD_LOGIN is written when a client has been authenticated. The payload is
+the major and minor protocol version, 16 bits each, followed by the callsign.
+RECORD_LOGOUT, with an empty payload, is written when the client disconnect.
+RECORD_TCP_FRAME and RECORD_UDP_DATAGRAM contain the complete received frame
+or datagram. Only traffic from authenticated clients is captured.
+*/
+class ReflectorCapture
+{
+  public:
+    static const char     MAGIC[8];
+    static const uint16_t VERSION = 1;
+
+    typedef enum
+    {
+      RECORD_LOGIN = 1, RECORD_LOGOUT, RECORD_TCP_FRAME, RECORD_UDP_DATAGRAM
+    } RecordType;
+
+    struct Record
+    {
+      RecordType            type;
+      uint64_t              time_us;  //!< Time since the start of capture
+      uint32_t              client_id;
+      std::vector<uint8_t>  data;
+    };
+
+    /**
+     * @brief   Decode the payload of a login record
+     * @param   rec       The record to decode
+     * @param   callsign  Set to the callsign of the client
+     * @param   ver       Set to the protocol version used by the client
+     * @return  Returns \em true on success or \em false if malformed
+     */
+    static bool decodeLogin(const Record& rec, std::string& callsign,
+                            ProtoVer& ver);
+
+  private:
+    ReflectorCapture(void);
+
+};  /* class ReflectorCapture */
+
+
+/**
+@brief  Write incoming reflector traffic to a capture file
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+An object of this class is created by the reflector when GLOBAL/CAPTURE_FILE
+is set. The file is flushed once a second so that a capture is usable even if
+the reflector is killed. Capturing stop when the file reach the maximum size.
+*/
+class ReflectorCaptureWriter
+{
+  public:
+    /**
+     * @brief   Default constructor
+     */
+    ReflectorCaptureWriter(void);
+
+    /**
+     * @brief   Destructor
+     */
+    ~ReflectorCaptureWriter(void);
+
+    /**
+     * @brief   Create the capture file
+     * @param   path      The path of the file to create
+     * @param   max_size  Stop capturing when the file reach this size in
+     *                    bytes, 0 for no limit
+     * @return  Returns \em true on success or \em false on failure
+     */
+    bool open(const std::string& path, uint64_t max_size=0);
+
+    /**
+     * @brief   Check if capturing is active
+     */
+    bool isActive(void) const { return m_os.is_open(); }
+
+    /**
+     * @brief   Record that a client has logged in
+     * @param   client_id The client id
+     * @param   callsign  The callsign of the client
+     * @param   ver       The protocol version used by the client
+     */
+    void login(uint32_t client_id, const std::string& callsign,
+               const ProtoVer& ver);
+
+    /**
+     * @brief   Record that a client has disconnected
+     * @param   client_id The client id
+     */
+    void logout(uint32_t client_id);
+
+    /**
+     * @brief   Record a received TCP frame
+     * @param   client_id The client id
+     * @param   buf       The frame data
+     * @param   len       The size of the frame
+     */
+    void tcpFrame(uint32_t client_id, const void *buf, size_t len);
+
+    /**
+     * @brief   Record a received UDP datagram
+     * @param   client_id The client id
+     * @param   buf       The datagram data
+     * @param   len       The size of the datagram
+     */
+    void udpDatagram(uint32_t client_id, const void *buf, size_t len);
+
+  private:
+    static const size_t FILE_BUF_SIZE = 65536;
+
+    std::ofstream       m_os;
+    std::string         m_path;
+    std::vector<char>   m_file_buf;
+    uint64_t            m_max_size;
+    uint64_t            m_size;
+    uint64_t            m_last_time_us;
+    Async::Timer        m_flush_timer;
+
+    ReflectorCaptureWriter(const ReflectorCaptureWriter&);
+    ReflectorCaptureWriter& operator=(const ReflectorCaptureWriter&);
+    void writeRecord(ReflectorCapture::RecordType type, uint32_t client_id,
+                     const void *buf, size_t len);
+    void close(const char *reason);
+    void flush(Async::Timer *t);
+
+};  /* class ReflectorCaptureWriter */
+
+
+/**
+@brief  Read the records from a capture file
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+*/
+class ReflectorCaptureReader
+{
+  public:
+    /**
+     * @brief   Default constructor
+     */
+    ReflectorCaptureReader(void) : m_time_us(0) {}
+
+    /**
+     * @brief   Open a capture file
+     * @param   path The path of the file to open
+     * @return  Returns \em true on success or \em false on failure
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief   Read the next record
+     * @param   rec Filled in with the record
+     * @return  Returns \em true on success or \em false at end of file or
+     *          if the file is truncated or corrupt
+     */
+    bool read(ReflectorCapture::Record& rec);
+
+    /**
+     * @brief   Check if the end of the file has been reached
+     */
+    bool eof(void) { return m_is.peek() == std::ifstream::traits_type::eof(); }
+
+  private:
+    std::ifstream m_is;
+    uint64_t      m_time_us;
+
+    bool readVarint(uint64_t& value);
+
+};  /* class ReflectorCaptureReader */
+
+
+//} /* namespace */
+
+#endif /* REFLECTOR_CAPTURE_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
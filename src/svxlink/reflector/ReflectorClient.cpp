@@ -36,6 +36,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <algorithm>
 #include <cerrno>
 #include <iterator>
+#include <cmath>
+#include <ctime>
 
 
 /****************************************************************************
@@ -45,8 +47,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncTimer.h>
-#include <AsyncAudioEncoder.h>
-#include <AsyncAudioDecoder.h>
+#include <AsyncMemArena.h>
+#include <AsyncTracepoint.h>
 #include <common.h>
 
 
@@ -112,6 +114,7 @@ using namespace Async;
  ****************************************************************************/
 
 uint32_t ReflectorClient::next_client_id = 0;
+std::vector<char> ReflectorClient::udp_tx_buf;
 
 
 /****************************************************************************
@@ -134,50 +137,19 @@ ReflectorClient::ReflectorClient(Reflector *ref, Async::FramedTcpConnection *con
     m_disc_timer(10000, Timer::TYPE_ONESHOT, false),
     m_client_id(next_client_id++), m_remote_udp_port(0), m_cfg(cfg),
     m_next_udp_tx_seq(0), m_next_udp_rx_seq(0),
-    m_heartbeat_timer(1000, Timer::TYPE_PERIODIC),
+    m_heartbeat_enabled(true),
     m_heartbeat_tx_cnt(HEARTBEAT_TX_CNT_RESET),
     m_heartbeat_rx_cnt(HEARTBEAT_RX_CNT_RESET),
     m_udp_heartbeat_tx_cnt(UDP_HEARTBEAT_TX_CNT_RESET),
     m_udp_heartbeat_rx_cnt(UDP_HEARTBEAT_RX_CNT_RESET),
     m_reflector(ref), m_blocktime(0), m_remaining_blocktime(0),
-    m_current_tg(0)
+    m_current_tg(0), m_node_info_valid(true)
 {
   m_con->setMaxFrameSize(ReflectorMsg::MAX_PREAUTH_FRAME_SIZE);
-  m_con->frameReceived.connect(
-      mem_fun(*this, &ReflectorClient::onFrameReceived));
+  m_con->setFrameHandler<ReflectorClient,
+                         &ReflectorClient::onFrameReceived>(this);
   m_disc_timer.expired.connect(
       mem_fun(*this, &ReflectorClient::onDiscTimeout));
-  m_heartbeat_timer.expired.connect(
-      mem_fun(*this, &ReflectorClient::handleHeartbeat));
-
-  string codecs;
-  if (m_cfg->getValue("GLOBAL", "CODECS", codecs))
-  {
-    SvxLink::splitStr(m_supported_codecs, codecs, ",");
-  }
-  if (m_supported_codecs.size() > 1)
-  {
-    m_supported_codecs.erase(m_supported_codecs.begin()+1,
-                             m_supported_codecs.end());
-    cout << "*** WARNING: The GLOBAL/CODECS configuration "
-            "variable can only take one codec at the moment. Using the first "
-            "one: \"" << m_supported_codecs.front() << "\"" << endl;
-  }
-  else if (m_supported_codecs.empty())
-  {
-    string codec = "GSM";
-    if (AudioDecoder::isAvailable("OPUS") &&
-        AudioEncoder::isAvailable("OPUS"))
-    {
-      codec = "OPUS";
-    }
-    else if (AudioDecoder::isAvailable("SPEEX") &&
-             AudioEncoder::isAvailable("SPEEX"))
-    {
-      codec = "SPEEX";
-    }
-    m_supported_codecs.push_back(codec);
-  }
 } /* ReflectorClient::ReflectorClient */
 
 
@@ -196,24 +168,63 @@ int ReflectorClient::sendMsg(const ReflectorMsg& msg)
     return -1;
   }
 
+  FramedTcpConnection::Frame *frame = packMsg(msg);
+  if (frame == 0)
+  {
+    errno = EBADMSG;
+    return -1;
+  }
+  int ret = sendFrame(msg.type(), frame);
+  frame->unref();
+  return ret;
+} /* ReflectorClient::sendMsg */
+
+
+int ReflectorClient::sendFrame(uint16_t msg_type,
+                               FramedTcpConnection::Frame *frame)
+{
+  if (((m_con_state != STATE_CONNECTED) && (msg_type >= 100)) ||
+      !m_con->isConnected())
+  {
+    errno = ENOTCONN;
+    return -1;
+  }
+
   m_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
 
+  return m_con->write(frame);
+} /* ReflectorClient::sendFrame */
+
+
+FramedTcpConnection::Frame *ReflectorClient::packMsg(const ReflectorMsg& msg)
+{
   ReflectorMsg header(msg.type());
-  ostringstream ss;
-  if (!header.pack(ss) || !msg.pack(ss))
+  const size_t size = header.packedSize() + msg.packedSize();
+  MemArena::Mark mark(MemArena::loopArena());
+  Async::MsgPackBuffer pb(mark.arena().allocArray<char>(size), size);
+  if (!header.pack(pb) || !msg.pack(pb))
   {
     cerr << "*** ERROR: Failed to pack TCP message\n";
-    errno = EBADMSG;
-    return -1;
+    return 0;
   }
-  return m_con->write(ss.str().data(), ss.str().size());
-} /* ReflectorClient::sendMsg */
+  return FramedTcpConnection::Frame::create(pb.data(), pb.size());
+} /* ReflectorClient::packMsg */
 
 
-void ReflectorClient::udpMsgReceived(const ReflectorUdpMsg &header)
+void ReflectorClient::udpMsgReceived(const ReflectorUdpMsg &header,
+                                     size_t len)
 {
+  m_net_stats.udp_rx_lost +=
+    static_cast<uint16_t>(header.sequenceNum() - m_next_udp_rx_seq);
+  m_net_stats.udp_rx_frames += 1;
+  m_net_stats.udp_rx_bytes += len;
   m_next_udp_rx_seq = header.sequenceNum() + 1;
 
+  if (header.type() == MsgUdpAudio::TYPE)
+  {
+    updateAudioJitter();
+  }
+
   m_udp_heartbeat_rx_cnt = UDP_HEARTBEAT_RX_CNT_RESET;
 
   if ((m_blocktime > 0) && (header.type() == MsgUdpAudio::TYPE))
@@ -230,13 +241,56 @@ void ReflectorClient::sendUdpMsg(const ReflectorUdpMsg &msg)
     return;
   }
 
+  size_t size = msg.packedSize() + 1;
+  if (udp_tx_buf.size() < size)
+  {
+    udp_tx_buf.resize(size);
+  }
+  Async::MsgPackBuffer pb(&udp_tx_buf[0], udp_tx_buf.size());
+  if (!msg.pack(pb))
+  {
+    cerr << "*** ERROR: Failed to pack reflector UDP message\n";
+    return;
+  }
+  sendUdpPayload(msg.type(), pb.data(), pb.size());
+} /* ReflectorClient::sendUdpMsg */
+
+
+void ReflectorClient::sendUdpPayload(uint16_t type, const void *payload,
+                                     size_t len)
+{
+  if (remoteUdpPort() == 0)
+  {
+    return;
+  }
+
   m_udp_heartbeat_tx_cnt = UDP_HEARTBEAT_TX_CNT_RESET;
 
-  ReflectorUdpMsg header(msg.type(), clientId(), nextUdpTxSeq());
-  ostringstream ss;
-  assert(header.pack(ss) && msg.pack(ss));
-  (void)m_reflector->sendUdpDatagram(this, ss.str().data(), ss.str().size());
-} /* ReflectorClient::sendUdpMsg */
+  ReflectorUdpMsg header(type, clientId(), nextUdpTxSeq());
+  char header_buf[16];
+  Async::MsgPackBuffer hb(header_buf, sizeof(header_buf));
+  if (!header.pack(hb))
+  {
+    cerr << "*** ERROR: Failed to pack reflector UDP message header\n";
+    return;
+  }
+  struct iovec iov[2];
+  iov[0].iov_base = header_buf;
+  iov[0].iov_len = hb.size();
+  iov[1].iov_base = const_cast<void *>(payload);
+  iov[1].iov_len = len;
+  if (m_reflector->sendUdpDatagram(this, iov, 2))
+  {
+    m_net_stats.udp_tx_frames += 1;
+    m_net_stats.udp_tx_bytes += hb.size() + len;
+  }
+} /* ReflectorClient::sendUdpPayload */
+
+
+bool ReflectorClient::tcpRtt(double& rtt) const
+{
+  return m_con->roundTripTime(rtt);
+} /* ReflectorClient::tcpRtt */
 
 
 void ReflectorClient::setBlock(unsigned blocktime)
@@ -246,6 +300,90 @@ void ReflectorClient::setBlock(unsigned blocktime)
 } /* ReflectorClient::setBlock */
 
 
+const Json::Value& ReflectorClient::nodeInfo(void) const
+{
+  if (!m_node_info_valid)
+  {
+    m_node_info_valid = true;
+    m_node_info = Json::Value();
+    try
+    {
+      std::istringstream is(m_node_info_json);
+      is >> m_node_info;
+    }
+    catch (const Json::Exception& e)
+    {
+      std::cerr << "*** WARNING[" << m_callsign
+                << "]: Failed to parse MsgNodeInfo JSON object: "
+                << e.what() << std::endl;
+      m_node_info = Json::Value();
+    }
+  }
+  return m_node_info;
+} /* ReflectorClient::nodeInfo */
+
+
+void ReflectorClient::handleHeartbeat(void)
+{
+  if (!m_heartbeat_enabled)
+  {
+    return;
+  }
+
+  if (--m_heartbeat_tx_cnt == 0)
+  {
+    sendMsg(MsgHeartbeat());
+  }
+
+  if (--m_udp_heartbeat_tx_cnt == 0)
+  {
+    sendUdpMsg(MsgUdpHeartbeat());
+  }
+
+  if (--m_heartbeat_rx_cnt == 0)
+  {
+    if (!callsign().empty())
+    {
+      cout << callsign() << ": ";
+    }
+    else
+    {
+      cout << "Client " << m_con->remoteHost() << ":"
+           << m_con->remotePort() << " ";
+    }
+    cout << "TCP heartbeat timeout" << endl;
+    sendError("TCP heartbeat timeout");
+  }
+
+  if (--m_udp_heartbeat_rx_cnt == 0)
+  {
+    if (!callsign().empty())
+    {
+      cout << callsign() << ": ";
+    }
+    else
+    {
+      cout << "Client " << m_con->remoteHost() << ":"
+           << m_con->remotePort() << " ";
+    }
+    cout << "UDP heartbeat timeout" << endl;
+    sendError("UDP heartbeat timeout");
+  }
+
+  if (m_blocktime > 0)
+  {
+    if (m_remaining_blocktime == 0)
+    {
+      m_blocktime = 0;
+    }
+    else
+    {
+      m_remaining_blocktime -= 1;
+    }
+  }
+} /* ReflectorClient::handleHeartbeat */
+
+
 /****************************************************************************
  *
  * Protected member functions
@@ -261,25 +399,27 @@ void ReflectorClient::setBlock(unsigned blocktime)
  ****************************************************************************/
 
 void ReflectorClient::onFrameReceived(FramedTcpConnection *con,
-                                      std::vector<uint8_t>& data)
+                                      Async::DataView data)
 {
-  int len = data.size();
+  const size_t len = data.size();
   //cout << "### ReflectorClient::onFrameReceived: len=" << len << endl;
 
-  assert(len >= 0);
-
   if ((m_con_state == STATE_DISCONNECTED) ||
       (m_con_state == STATE_EXPECT_DISCONNECT))
   {
     return;
   }
 
-  char *buf = reinterpret_cast<char*>(&data.front());
-  stringstream ss;
-  ss.write(buf, len);
+  if ((m_con_state == STATE_CONNECTED) && (m_reflector->capture() != 0))
+  {
+    m_reflector->capture()->tcpFrame(m_client_id, data.data(), len);
+  }
+
+    // The message is unpacked straight from the frame buffer
+  Async::MsgUnpackBuffer ub(data.data(), len);
 
   ReflectorMsg header;
-  if (!header.unpack(ss))
+  if (!header.unpack(ub))
   {
     if (!m_callsign.empty())
     {
@@ -301,39 +441,45 @@ void ReflectorClient::onFrameReceived(FramedTcpConnection *con,
     case MsgHeartbeat::TYPE:
       break;
     case MsgProtoVer::TYPE:
-      handleMsgProtoVer(ss);
+      handleMsgProtoVer(ub);
       break;
     case MsgAuthResponse::TYPE:
-      handleMsgAuthResponse(ss);
+      handleMsgAuthResponse(ub);
+      break;
+    case MsgSessionResume::TYPE:
+      handleMsgSessionResume(ub);
       break;
     case MsgSelectTG::TYPE:
-      handleSelectTG(ss);
+      handleSelectTG(ub);
       break;
     case MsgTgMonitor::TYPE:
-      handleTgMonitor(ss);
+      handleTgMonitor(ub);
       break;
     case MsgNodeInfo::TYPE:
-      handleNodeInfo(ss);
+      handleNodeInfo(ub);
       break;
     case MsgSignalStrengthValues::TYPE:
-      handleMsgSignalStrengthValues(ss);
+      handleMsgSignalStrengthValues(ub);
       break;
     case MsgTxStatus::TYPE:
-      handleMsgTxStatus(ss);
+      handleMsgTxStatus(ub);
+      break;
+    case MsgSelectCodec::TYPE:
+      handleSelectCodec(ub);
       break;
 #if 0
     case MsgNodeInfo::TYPE:
-      handleNodeInfo(ss);
+      handleNodeInfo(ub);
       break;
 #endif
     case MsgRequestQsy::TYPE:
-      handleRequestQsy(ss);
+      handleRequestQsy(ub);
       break;
     case MsgStateEvent::TYPE:
-      handleStateEvent(ss);
+      handleStateEvent(ub);
       break;
     case MsgError::TYPE:
-      handleMsgError(ss);
+      handleMsgError(ub);
       break;
     default:
       // Better just ignoring unknown protocol messages for making it easier to
@@ -343,10 +489,15 @@ void ReflectorClient::onFrameReceived(FramedTcpConnection *con,
       //     << header.type() << endl;
       break;
   }
+
+  if (header.type() != MsgHeartbeat::TYPE)
+  {
+    m_reflector->statusChanged();
+  }
 } /* ReflectorClient::onFrameReceived */
 
 
-void ReflectorClient::handleMsgProtoVer(std::istream& is)
+void ReflectorClient::handleMsgProtoVer(Async::MsgUnpackBuffer& is)
 {
   if (m_con_state != STATE_EXPECT_PROTO_VER)
   {
@@ -390,15 +541,11 @@ void ReflectorClient::handleMsgProtoVer(std::istream& is)
     return;
   }
 
-  MsgAuthChallenge challenge_msg;
-  memcpy(m_auth_challenge, challenge_msg.challenge(),
-         MsgAuthChallenge::CHALLENGE_LEN);
-  sendMsg(challenge_msg);
-  m_con_state = STATE_EXPECT_AUTH_RESPONSE;
+  sendAuthChallenge();
 } /* ReflectorClient::handleMsgProtoVer */
 
 
-void ReflectorClient::handleMsgAuthResponse(std::istream& is)
+void ReflectorClient::handleMsgAuthResponse(Async::MsgUnpackBuffer& is)
 {
   if (m_con_state != STATE_EXPECT_AUTH_RESPONSE)
   {
@@ -417,8 +564,7 @@ void ReflectorClient::handleMsgAuthResponse(std::istream& is)
     return;
   }
 
-  string auth_key = lookupUserKey(msg.callsign());
-  if (!auth_key.empty() && msg.verify(auth_key, m_auth_challenge))
+  if (m_reflector->verifyAuthResponse(msg, m_auth_challenge))
   {
     vector<string> connected_nodes;
     m_reflector->nodeList(connected_nodes);
@@ -433,31 +579,8 @@ void ReflectorClient::handleMsgAuthResponse(std::istream& is)
            << " with protocol version " << m_client_proto_ver.majorVer()
            << "." << m_client_proto_ver.minorVer()
            << endl;
-      m_con_state = STATE_CONNECTED;
-      MsgServerInfo msg_srv_info(m_client_id, m_supported_codecs);
-      m_reflector->nodeList(msg_srv_info.nodes());
-      sendMsg(msg_srv_info);
-      if (m_client_proto_ver < ProtoVer(0, 7))
-      {
-        MsgNodeList msg_node_list(msg_srv_info.nodes());
-        sendMsg(msg_node_list);
-      }
-      if (m_client_proto_ver < ProtoVer(2, 0))
-      {
-        if (TGHandler::instance()->switchTo(this, m_reflector->tgForV1Clients()))
-        {
-          std::cout << m_callsign << ": Select TG #"
-                    << m_reflector->tgForV1Clients() << std::endl;
-          m_current_tg = m_reflector->tgForV1Clients();
-        }
-        else
-        {
-          std::cout << m_callsign
-                    << ": V1 client not allowed to use default TG #"
-                    << m_reflector->tgForV1Clients() << std::endl;
-        }
-      }
-      m_reflector->broadcastMsg(MsgNodeJoined(m_callsign), ExceptFilter(this));
+      setConState(STATE_CONNECTED);
+      loggedIn();
     }
     else
     {
@@ -475,7 +598,143 @@ void ReflectorClient::handleMsgAuthResponse(std::istream& is)
 } /* ReflectorClient::handleMsgAuthResponse */
 
 
-void ReflectorClient::handleSelectTG(std::istream& is)
+void ReflectorClient::handleMsgSessionResume(Async::MsgUnpackBuffer& is)
+{
+  if (m_con_state != STATE_EXPECT_AUTH_RESPONSE)
+  {
+    cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
+         << " Session resumption unexpected" << endl;
+    sendError("Session resumption unexpected");
+    return;
+  }
+
+  MsgSessionResume msg;
+  if (!msg.unpack(is))
+  {
+    cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
+         << " ERROR: Could not unpack MsgSessionResume" << endl;
+    sendError("Illegal MsgSessionResume protocol message received");
+    return;
+  }
+
+  ReflectorSessions::Session session;
+  vector<string> connected_nodes;
+  m_reflector->nodeList(connected_nodes);
+  if (!m_reflector->resumeSession(msg, m_auth_challenge, session) ||
+      (find(connected_nodes.begin(), connected_nodes.end(),
+            msg.callsign()) != connected_nodes.end()))
+  {
+      // Not fatal. The client fall back to a normal login when it receive
+      // a new challenge.
+    cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
+         << " Could not resume session for user \"" << msg.callsign()
+         << "\"" << endl;
+    sendAuthChallenge();
+    return;
+  }
+
+  m_con->setMaxFrameSize(ReflectorMsg::MAX_POSTAUTH_FRAME_SIZE);
+  m_callsign = msg.callsign();
+  sendMsg(MsgAuthOk());
+  cout << m_callsign << ": Session resumed from "
+       << m_con->remoteHost() << ":" << m_con->remotePort()
+       << " with protocol version " << m_client_proto_ver.majorVer()
+       << "." << m_client_proto_ver.minorVer()
+       << endl;
+  setConState(STATE_CONNECTED);
+
+    // Restore the stored state. The node information is only restored if
+    // the client still has the same information as when it was stored.
+  bool node_info_ok = !session.node_info_json.empty() &&
+      (MsgSessionResume::nodeInfoDigest(session.node_info_json) ==
+       msg.nodeInfoDigest());
+  if (node_info_ok)
+  {
+    m_node_info_json = session.node_info_json;
+    m_node_info = Json::Value();
+    m_node_info_valid = false;
+  }
+  if ((session.tg > 0) && TGHandler::instance()->switchTo(this, session.tg))
+  {
+    cout << m_callsign << ": Select TG #" << session.tg << endl;
+    m_current_tg = session.tg;
+  }
+  std::set<uint32_t> tgs;
+  for (std::vector<uint32_t>::const_iterator it =
+         session.monitored_tgs.begin();
+       it != session.monitored_tgs.end(); ++it)
+  {
+    if (TGHandler::instance()->allowTgSelection(this, *it))
+    {
+      tgs.insert(*it);
+    }
+  }
+  if (!tgs.empty())
+  {
+    TGHandler::instance()->setMonitoredTGs(this, tgs);
+    m_monitored_tgs.assign(tgs.begin(), tgs.end());
+  }
+  sendMsg(MsgSessionResumed(m_current_tg, tgs, node_info_ok));
+
+  loggedIn();
+} /* ReflectorClient::handleMsgSessionResume */
+
+
+void ReflectorClient::sendAuthChallenge(void)
+{
+  MsgAuthChallenge challenge_msg;
+  memcpy(m_auth_challenge, challenge_msg.challenge(),
+         MsgAuthChallenge::CHALLENGE_LEN);
+  sendMsg(challenge_msg);
+  setConState(STATE_EXPECT_AUTH_RESPONSE);
+} /* ReflectorClient::sendAuthChallenge */
+
+
+void ReflectorClient::loggedIn(void)
+{
+  if (m_reflector->capture() != 0)
+  {
+    m_reflector->capture()->login(m_client_id, m_callsign,
+                                  m_client_proto_ver);
+  }
+  m_codec = m_reflector->codecs().front();
+  MsgServerInfo msg_srv_info(m_client_id, m_reflector->codecs());
+  m_reflector->nodeList(msg_srv_info.nodes());
+  sendMsg(msg_srv_info);
+  if (m_client_proto_ver < ProtoVer(0, 7))
+  {
+    MsgNodeList msg_node_list(msg_srv_info.nodes());
+    sendMsg(msg_node_list);
+  }
+  if (m_client_proto_ver < ProtoVer(2, 0))
+  {
+    if (TGHandler::instance()->switchTo(this, m_reflector->tgForV1Clients()))
+    {
+      std::cout << m_callsign << ": Select TG #"
+                << m_reflector->tgForV1Clients() << std::endl;
+      m_current_tg = m_reflector->tgForV1Clients();
+    }
+    else
+    {
+      std::cout << m_callsign
+                << ": V1 client not allowed to use default TG #"
+                << m_reflector->tgForV1Clients() << std::endl;
+    }
+  }
+  else if (m_reflector->sessionsEnabled())
+  {
+    m_session_token = ReflectorSessions::createToken();
+    sendMsg(MsgSessionToken(m_session_token));
+  }
+  m_reflector->broadcastMsg(MsgNodeJoined(m_callsign), ExceptFilter(this));
+  Json::Value event(Json::objectValue);
+  event["callsign"] = m_callsign;
+  event["tg"] = m_current_tg;
+  m_reflector->statusEvent("node_joined", event);
+} /* ReflectorClient::loggedIn */
+
+
+void ReflectorClient::handleSelectTG(Async::MsgUnpackBuffer& is)
 {
   MsgSelectTG msg;
   if (!msg.unpack(is))
@@ -490,10 +749,8 @@ void ReflectorClient::handleSelectTG(std::istream& is)
     ReflectorClient *talker = TGHandler::instance()->talkerForTG(m_current_tg);
     if (talker == this)
     {
-      m_reflector->broadcastUdpMsg(MsgUdpFlushSamples(),
-          mkAndFilter(
-            TgFilter(m_current_tg),
-            ExceptFilter(this)));
+      m_reflector->broadcastUdpMsg(MsgUdpFlushSamples(), m_current_tg,
+                                   ExceptFilter(this));
     }
     else if (talker != 0)
     {
@@ -503,6 +760,10 @@ void ReflectorClient::handleSelectTG(std::istream& is)
     {
       cout << m_callsign << ": Select TG #" << msg.tg() << endl;
       m_current_tg = msg.tg();
+      Json::Value event(Json::objectValue);
+      event["callsign"] = m_callsign;
+      event["tg"] = m_current_tg;
+      m_reflector->statusEvent("tg_select", event);
     }
     else
     {
@@ -514,7 +775,7 @@ void ReflectorClient::handleSelectTG(std::istream& is)
 } /* ReflectorClient::handleSelectTG */
 
 
-void ReflectorClient::handleTgMonitor(std::istream& is)
+void ReflectorClient::handleTgMonitor(Async::MsgUnpackBuffer& is)
 {
   MsgTgMonitor msg;
   if (!msg.unpack(is))
@@ -525,49 +786,69 @@ void ReflectorClient::handleTgMonitor(std::istream& is)
     return;
   }
   std::set<uint32_t> tgs = msg.tgs();
-  for (auto it=tgs.begin(); it!=tgs.end(); ++it)
+  for (auto it=tgs.begin(); it!=tgs.end(); )
   {
     if (!TGHandler::instance()->allowTgSelection(this, *it))
     {
       std::cout << m_callsign << ": Not allowed to monitor TG #"
                 << *it << std::endl;
-      tgs.erase(it);
+      it = tgs.erase(it);
+    }
+    else
+    {
+      ++it;
     }
   }
   cout << m_callsign << ": Monitor TG#: [ ";
   std::copy(tgs.begin(), tgs.end(), std::ostream_iterator<uint32_t>(cout, " "));
   cout << "]" << endl;
 
-  m_monitored_tgs = tgs;
+  TGHandler::instance()->setMonitoredTGs(this, tgs);
+  m_monitored_tgs.assign(tgs.begin(), tgs.end());
 } /* ReflectorClient::handleTgMonitor */
 
 
-void ReflectorClient::handleNodeInfo(std::istream& is)
+void ReflectorClient::handleSelectCodec(Async::MsgUnpackBuffer& is)
 {
-  MsgNodeInfo msg;
+  MsgSelectCodec msg;
   if (!msg.unpack(is))
   {
     cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
-         << " ERROR: Could not unpack MsgNodeInfo" << endl;
-    sendError("Illegal MsgNodeInfo protocol message received");
+         << " ERROR: Could not unpack MsgSelectCodec" << endl;
+    sendError("Illegal MsgSelectCodec protocol message received");
     return;
   }
-  //std::cout << "### handleNodeInfo: " << msg.json() << std::endl;
-  try
+  const std::vector<std::string>& codecs = m_reflector->codecs();
+  if (find(codecs.begin(), codecs.end(), msg.codec()) == codecs.end())
   {
-    std::istringstream is(msg.json());
-    is >> m_node_info;
+    cout << m_callsign << ": Selected codec \"" << msg.codec()
+         << "\" is not supported. Using \"" << m_codec << "\"" << endl;
+    return;
   }
-  catch (const Json::Exception& e)
+  cout << m_callsign << ": Using codec \"" << msg.codec() << "\"" << endl;
+  m_codec = msg.codec();
+} /* ReflectorClient::handleSelectCodec */
+
+
+void ReflectorClient::handleNodeInfo(Async::MsgUnpackBuffer& is)
+{
+  MsgNodeInfo msg;
+  if (!msg.unpack(is))
   {
-    std::cerr << "*** WARNING[" << m_callsign
-              << "]: Failed to parse MsgNodeInfo JSON object: "
-              << e.what() << std::endl;
+    cout << "Client " << m_con->remoteHost() << ":" << m_con->remotePort()
+         << " ERROR: Could not unpack MsgNodeInfo" << endl;
+    sendError("Illegal MsgNodeInfo protocol message received");
+    return;
   }
+  //std::cout << "### handleNodeInfo: " << msg.json() << std::endl;
+    // The JSON object is parsed when it is needed, see nodeInfo()
+  m_node_info_json = msg.json();
+  m_node_info = Json::Value();
+  m_node_info_valid = false;
 } /* ReflectorClient::handleNodeInfo */
 
 
-void ReflectorClient::handleMsgSignalStrengthValues(std::istream& is)
+void ReflectorClient::handleMsgSignalStrengthValues(Async::MsgUnpackBuffer& is)
 {
   MsgSignalStrengthValues msg;
   if (!msg.unpack(is))
@@ -596,7 +877,7 @@ void ReflectorClient::handleMsgSignalStrengthValues(std::istream& is)
 } /* ReflectorClient::handleMsgSignalStrengthValues */
 
 
-void ReflectorClient::handleMsgTxStatus(std::istream& is)
+void ReflectorClient::handleMsgTxStatus(Async::MsgUnpackBuffer& is)
 {
   MsgTxStatus msg;
   if (!msg.unpack(is))
@@ -618,7 +899,7 @@ void ReflectorClient::handleMsgTxStatus(std::istream& is)
 } /* ReflectorClient::handleMsgTxStatus */
 
 
-void ReflectorClient::handleRequestQsy(std::istream& is)
+void ReflectorClient::handleRequestQsy(Async::MsgUnpackBuffer& is)
 {
   MsgRequestQsy msg;
   if (!msg.unpack(is))
@@ -632,7 +913,7 @@ void ReflectorClient::handleRequestQsy(std::istream& is)
 } /* ReflectorClient::handleRequestQsy */
 
 
-void ReflectorClient::handleStateEvent(std::istream& is)
+void ReflectorClient::handleStateEvent(Async::MsgUnpackBuffer& is)
 {
   MsgStateEvent msg;
   if (!msg.unpack(is))
@@ -651,7 +932,7 @@ void ReflectorClient::handleStateEvent(std::istream& is)
 
 
 #if 0
-void ReflectorClient::handleNodeInfo(std::istream& is)
+void ReflectorClient::handleNodeInfo(Async::MsgUnpackBuffer& is)
 {
   MsgNodeInfo msg;
   if (!msg.unpack(is))
@@ -732,7 +1013,7 @@ void ReflectorClient::handleNodeInfo(std::istream& is)
 #endif
 
 
-void ReflectorClient::handleMsgError(std::istream& is)
+void ReflectorClient::handleMsgError(Async::MsgUnpackBuffer& is)
 {
   MsgError msg;
   string message;
@@ -756,10 +1037,10 @@ void ReflectorClient::handleMsgError(std::istream& is)
 void ReflectorClient::sendError(const std::string& msg)
 {
   sendMsg(MsgError(msg));
-  m_heartbeat_timer.setEnable(false);
+  m_heartbeat_enabled = false;
   m_remote_udp_port = 0;
   m_disc_timer.setEnable(true);
-  m_con_state = STATE_EXPECT_DISCONNECT;
+  setConState(STATE_EXPECT_DISCONNECT);
 } /* ReflectorClient::sendError */
 
 
@@ -770,91 +1051,118 @@ void ReflectorClient::onDiscTimeout(Timer *t)
 } /* ReflectorClient::onDiscTimeout */
 
 
+void ReflectorClient::setConState(ConState new_state)
+{
+  ASYNC_TRACEPOINT(svxreflector, client_state, m_client_id,
+                   m_callsign.c_str(), m_con_state, new_state);
+  m_con_state = new_state;
+} /* ReflectorClient::setConState */
+
+
 void ReflectorClient::disconnect(void)
 {
-  m_heartbeat_timer.setEnable(false);
+  m_heartbeat_enabled = false;
   m_remote_udp_port = 0;
   m_con->disconnect();
-  m_con_state = STATE_DISCONNECTED;
+  setConState(STATE_DISCONNECTED);
   m_con->disconnected(m_con, FramedTcpConnection::DR_ORDERED_DISCONNECT);
 } /* ReflectorClient::disconnect */
 
 
-void ReflectorClient::handleHeartbeat(Async::Timer *t)
+void ReflectorClient::updateAudioJitter(void)
 {
-  if (--m_heartbeat_tx_cnt == 0)
+    // There is no timestamp in the audio frames so the jitter is estimated
+    // as the smoothed deviation of the inter-arrival time from its smoothed
+    // mean, using the same gain as the RFC 3550 interarrival jitter.
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  double now = ts.tv_sec + ts.tv_nsec / 1000000000.0;
+  double interval = now - m_net_stats.last_audio_time;
+  m_net_stats.last_audio_time = now;
+  if (interval > 1.0)
   {
-    sendMsg(MsgHeartbeat());
+      // A new transmission
+    m_net_stats.audio_interval = 0.0;
+    return;
   }
-
-  if (--m_udp_heartbeat_tx_cnt == 0)
+  if (m_net_stats.audio_interval == 0.0)
   {
-    sendUdpMsg(MsgUdpHeartbeat());
+    m_net_stats.audio_interval = interval;
+    return;
   }
+  double deviation = interval - m_net_stats.audio_interval;
+  m_net_stats.audio_interval += deviation / 16.0;
+  m_net_stats.audio_jitter +=
+    (std::fabs(deviation) - m_net_stats.audio_jitter) / 16.0;
+} /* ReflectorClient::updateAudioJitter */
 
-  if (--m_heartbeat_rx_cnt == 0)
+
+const ReflectorClient::Rx *ReflectorClient::findRx(char id) const
+{
+  for (RxList::const_iterator it=m_rx_list.begin(); it!=m_rx_list.end(); ++it)
   {
-    if (!callsign().empty())
+    if (it->id == id)
     {
-      cout << callsign() << ": ";
+      return &(*it);
     }
-    else
-    {
-      cout << "Client " << m_con->remoteHost() << ":"
-           << m_con->remotePort() << " ";
-    }
-    cout << "TCP heartbeat timeout" << endl;
-    sendError("TCP heartbeat timeout");
   }
+  return 0;
+} /* ReflectorClient::findRx */
 
-  if (--m_udp_heartbeat_rx_cnt == 0)
+
+const ReflectorClient::Rx& ReflectorClient::rxOrDefault(char id) const
+{
+  static const Rx default_rx = Rx();
+  const Rx *r = findRx(id);
+  return (r != 0) ? *r : default_rx;
+} /* ReflectorClient::rxOrDefault */
+
+
+ReflectorClient::Rx& ReflectorClient::rx(char id)
+{
+  RxList::iterator it = m_rx_list.begin();
+  while ((it != m_rx_list.end()) && (it->id < id))
   {
-    if (!callsign().empty())
-    {
-      cout << callsign() << ": ";
-    }
-    else
-    {
-      cout << "Client " << m_con->remoteHost() << ":"
-           << m_con->remotePort() << " ";
-    }
-    cout << "UDP heartbeat timeout" << endl;
-    sendError("UDP heartbeat timeout");
+    ++it;
   }
+  if ((it == m_rx_list.end()) || (it->id != id))
+  {
+    Rx new_rx = Rx();
+    new_rx.id = id;
+    it = m_rx_list.insert(it, new_rx);
+  }
+  return *it;
+} /* ReflectorClient::rx */
 
-  if (m_blocktime > 0)
+
+const ReflectorClient::Tx *ReflectorClient::findTx(char id) const
+{
+  for (TxList::const_iterator it=m_tx_list.begin(); it!=m_tx_list.end(); ++it)
   {
-    if (m_remaining_blocktime == 0)
-    {
-      m_blocktime = 0;
-    }
-    else
+    if (it->id == id)
     {
-      m_remaining_blocktime -= 1;
+      return &(*it);
     }
   }
-} /* ReflectorClient::handleHeartbeat */
+  return 0;
+} /* ReflectorClient::findTx */
 
 
-std::string ReflectorClient::lookupUserKey(const std::string& callsign)
+ReflectorClient::Tx& ReflectorClient::tx(char id)
 {
-  string auth_group;
-  if (!m_cfg->getValue("USERS", callsign, auth_group) || auth_group.empty())
+  TxList::iterator it = m_tx_list.begin();
+  while ((it != m_tx_list.end()) && (it->id < id))
   {
-    cout << "*** WARNING: Unknown user \"" << callsign << "\""
-         << endl;
-    return "";
+    ++it;
   }
-  string auth_key;
-  if (!m_cfg->getValue("PASSWORDS", auth_group, auth_key) || auth_key.empty())
+  if ((it == m_tx_list.end()) || (it->id != id))
   {
-    cout << "*** ERROR: User \"" << callsign << "\" found in SvxReflector "
-         << "configuration but password with groupname \"" << auth_group
-         << "\" not found." << endl;
-    return "";
+    Tx new_tx = Tx();
+    new_tx.id = id;
+    it = m_tx_list.insert(it, new_tx);
   }
-  return auth_key;
-} /* ReflectorClient::lookupUserKey */
+  return *it;
+} /* ReflectorClient::tx */
 
 
 /*
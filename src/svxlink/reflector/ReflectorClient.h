@@ -35,6 +35,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <json/json.h>
 
 
@@ -116,23 +118,47 @@ class ReflectorClient
       STATE_CONNECTED, STATE_EXPECT_DISCONNECT
     } ConState;
 
+      // The receivers and transmitters are kept in small vectors sorted on
+      // id since a node typically only have a few of them
     struct Rx
     {
-      std::string name;
-      //char        id;
+      char        id;
       uint8_t     siglev;
       bool        enabled;
       bool        sql_open;
       bool        active;
     };
-    typedef std::map<char, Rx> RxMap;
+    typedef std::vector<Rx> RxList;
 
     struct Tx
     {
-      std::string name;
+      char        id;
       bool        transmit;
     };
-    typedef std::map<char, Tx> TxMap;
+    typedef std::vector<Tx> TxList;
+
+      // The monitored talk groups in ascending order
+    typedef std::vector<uint32_t> TgList;
+
+      // Network quality counters. They are only updated and read from the
+      // main thread so no locking is needed.
+    struct NetStats
+    {
+      uint64_t  udp_rx_frames;
+      uint64_t  udp_rx_bytes;
+      uint64_t  udp_rx_lost;
+      uint64_t  udp_rx_out_of_seq;
+      uint64_t  udp_tx_frames;
+      uint64_t  udp_tx_bytes;
+      double    audio_jitter;       // Seconds
+      double    audio_interval;     // Seconds, smoothed
+      double    last_audio_time;    // Seconds, monotonic clock
+
+      NetStats(void)
+        : udp_rx_frames(0), udp_rx_bytes(0), udp_rx_lost(0),
+          udp_rx_out_of_seq(0), udp_tx_frames(0), udp_tx_bytes(0),
+          audio_jitter(0.0), audio_interval(0.0), last_audio_time(0.0) {}
+    };
 
     class Filter
     {
@@ -189,12 +215,25 @@ class ReflectorClient
         TgMonitorFilter(uint32_t tg) : m_tg(tg) {}
         virtual bool operator ()(ReflectorClient *client) const
         {
-          return client->m_monitored_tgs.count(m_tg) > 0;
+          return std::binary_search(client->m_monitored_tgs.begin(),
+                                    client->m_monitored_tgs.end(), m_tg);
         }
       private:
         uint32_t m_tg;
     };
 
+    class CodecFilter : public Filter
+    {
+      public:
+        CodecFilter(const std::string& codec) : m_codec(codec) {}
+        virtual bool operator ()(ReflectorClient *client) const
+        {
+          return client->m_codec == m_codec;
+        }
+      private:
+        std::string m_codec;
+    };
+
     template <class F1, class F2>
     class AndFilter : public Filter
     {
@@ -318,6 +357,26 @@ class ReflectorClient
      */
     int sendMsg(const ReflectorMsg& msg);
 
+    /**
+     * @brief   Send an already packed TCP message to the remote end
+     * @param   msg_type  The type of the packed message
+     * @param   frame     The packed message, as returned by packMsg
+     * @return  On success 0 is returned or else -1
+     *
+     * The frame is not copied so the same frame can be sent to many clients.
+     * The caller keep its reference to the frame.
+     */
+    int sendFrame(uint16_t msg_type, Async::FramedTcpConnection::Frame *frame);
+
+    /**
+     * @brief   Pack a TCP message into a frame ready for sending
+     * @param   msg The message to pack
+     * @return  Returns a new frame or 0 if the message could not be packed
+     *
+     * The caller own the returned frame and must call unref on it when done.
+     */
+    static Async::FramedTcpConnection::Frame *packMsg(const ReflectorMsg& msg);
+
     /**
      * @brief   Handle a received UDP message
      * @param   The received UDP message
@@ -325,7 +384,31 @@ class ReflectorClient
      * This function is called by the Reflector when a UDP packet is received.
      * The purpose is to handle packet related timers and sequence numbers.
      */
-    void udpMsgReceived(const ReflectorUdpMsg &header);
+    void udpMsgReceived(const ReflectorUdpMsg &header, size_t len);
+
+    /**
+     * @brief   Tell the client object that a datagram was out of sequence
+     *
+     * Out of sequence datagrams are dropped without calling udpMsgReceived.
+     * This function is used to count them.
+     */
+    void udpMsgOutOfSequence(void) { m_net_stats.udp_rx_out_of_seq += 1; }
+
+    /**
+     * @brief   Get the network quality counters for this client
+     * @return  Returns the network statistics
+     */
+    const NetStats& netStats(void) const { return m_net_stats; }
+
+    /**
+     * @brief   Get the round trip time for the TCP connection
+     * @param   rtt The round trip time, in seconds, is returned here
+     * @return  Returns \em true if the round trip time could be read
+     *
+     * The smoothed round trip time estimate of the operating system TCP
+     * stack is used.
+     */
+    bool tcpRtt(double& rtt) const;
 
     /**
      * @brief   Send a UDP message to the client
@@ -333,6 +416,18 @@ class ReflectorClient
      */
     void sendUdpMsg(const ReflectorUdpMsg &msg);
 
+    /**
+     * @brief   Send an already packed UDP message to the client
+     * @param   type    The message type
+     * @param   payload The packed message, without the header
+     * @param   len     The length of the packed message
+     *
+     * The header, containing the client id and sequence number for this
+     * client, is packed and sent together with the given payload. This makes
+     * it possible to pack a message once when sending it to many clients.
+     */
+    void sendUdpPayload(uint16_t type, const void *payload, size_t len);
+
     /**
      * @brief   Block client audio for the specified time
      * @param   The number of seconds to block
@@ -343,6 +438,15 @@ class ReflectorClient
      */
     void setBlock(unsigned blocktime);
 
+    /**
+     * @brief   Update the heartbeat counters
+     *
+     * This function is called once per second by the reflector for all
+     * clients. It send heartbeats when nothing else has been sent for a while
+     * and disconnect the client if no heartbeats have been received.
+     */
+    void handleHeartbeat(void);
+
     /**
      * @brief   Check if a client is blocked
      * @return  Returns \em true if the client is blocked or else \em false
@@ -369,52 +473,74 @@ class ReflectorClient
 
     /**
      * @brief   Get the monitored talk groups
-     * @return  Returns the monitored talk groups
+     * @return  Returns the monitored talk groups in ascending order
      */
-    const std::set<uint32_t>& monitoredTGs(void) const
-    {
-      return m_monitored_tgs;
-    }
+    const TgList& monitoredTGs(void) const { return m_monitored_tgs; }
 
     std::vector<char> rxIdList(void) const
     {
       std::vector<char> ids;
-      ids.reserve(m_rx_map.size());
-      for (RxMap::const_iterator it=m_rx_map.begin(); it!=m_rx_map.end(); ++it)
+      ids.reserve(m_rx_list.size());
+      for (RxList::const_iterator it=m_rx_list.begin(); it!=m_rx_list.end(); ++it)
       {
-        ids.push_back(it->first);
+        ids.push_back(it->id);
       }
       return ids;
     }
-    bool rxExist(char rx_id) const
-    {
-      return m_rx_map.find(rx_id) != m_rx_map.end();
-    }
-    const std::string& rxName(char id) { return m_rx_map[id].name; }
-    void setRxSiglev(char id, uint8_t siglev) { m_rx_map[id].siglev = siglev; }
-    uint8_t rxSiglev(char id) { return m_rx_map[id].siglev; }
-    void setRxEnabled(char id, bool enab) { m_rx_map[id].enabled = enab; }
-    bool rxEnabled(char id) { return m_rx_map[id].enabled; }
-    void setRxSqlOpen(char id, bool open) { m_rx_map[id].sql_open = open; }
-    bool rxSqlOpen(char id) { return m_rx_map[id].sql_open; }
-    void setRxActive(char id, bool active) { m_rx_map[id].active = active; }
-    bool rxActive(char id) { return m_rx_map[id].active; }
-    //RxMap& rxMap(void) { return m_rx_map; }
-    //const RxMap& rxMap(void) const { return m_rx_map; }
-
-    bool txExist(char tx_id) const
+    bool rxExist(char rx_id) const { return findRx(rx_id) != 0; }
+    void setRxSiglev(char id, uint8_t siglev) { rx(id).siglev = siglev; }
+    uint8_t rxSiglev(char id) const { return rxOrDefault(id).siglev; }
+    void setRxEnabled(char id, bool enab) { rx(id).enabled = enab; }
+    bool rxEnabled(char id) const { return rxOrDefault(id).enabled; }
+    void setRxSqlOpen(char id, bool open) { rx(id).sql_open = open; }
+    bool rxSqlOpen(char id) const { return rxOrDefault(id).sql_open; }
+    void setRxActive(char id, bool active) { rx(id).active = active; }
+    bool rxActive(char id) const { return rxOrDefault(id).active; }
+
+    bool txExist(char tx_id) const { return findTx(tx_id) != 0; }
+    void setTxTransmit(char id, bool transmit) { tx(id).transmit = transmit; }
+    bool txTransmit(char id) const
     {
-      return m_tx_map.find(tx_id) != m_tx_map.end();
+      const Tx *t = findTx(id);
+      return (t != 0) && t->transmit;
     }
-    void setTxTransmit(char id, bool transmit) { m_tx_map[id].transmit = transmit; }
-    bool txTransmit(char id) { return m_tx_map[id].transmit; }
 
-    const Json::Value& nodeInfo(void) const { return m_node_info; }
+    /**
+     * @brief   Get the node information sent by the client
+     * @return  Returns the node information JSON object
+     *
+     * The node information is stored in its serialized form when received
+     * and is only parsed when this function is called. The parsed object is
+     * then kept until the client send new node information.
+     */
+    const Json::Value& nodeInfo(void) const;
+
+    /**
+     * @brief   Get the node information in the form sent by the client
+     * @return  Returns the node information JSON document
+     */
+    const std::string& nodeInfoJson(void) const { return m_node_info_json; }
+
+    /**
+     * @brief   Get the token that can be used to resume this session
+     * @return  Returns the token or an empty string if sessions are not stored
+     */
+    const std::string& sessionToken(void) const { return m_session_token; }
+
+    /**
+     * @brief   Get the audio codec used by the client
+     * @return  Returns the name of the codec
+     *
+     * This is the first codec offered by the reflector unless the client
+     * have selected another one.
+     */
+    const std::string& codec(void) const { return m_codec; }
 
   private:
     static const uint16_t MIN_MAJOR_VER = 0;
     static const uint16_t MIN_MINOR_VER = 6;
     static uint32_t next_client_id;
+    static std::vector<char> udp_tx_buf;
 
     static const unsigned HEARTBEAT_TX_CNT_RESET      = 10;
     static const unsigned HEARTBEAT_RX_CNT_RESET      = 15;
@@ -431,7 +557,7 @@ class ReflectorClient
     Async::Config*              m_cfg;
     uint16_t                    m_next_udp_tx_seq;
     uint16_t                    m_next_udp_rx_seq;
-    Async::Timer                m_heartbeat_timer;
+    bool                        m_heartbeat_enabled;
     unsigned                    m_heartbeat_tx_cnt;
     unsigned                    m_heartbeat_rx_cnt;
     unsigned                    m_udp_heartbeat_tx_cnt;
@@ -440,32 +566,45 @@ class ReflectorClient
     unsigned                    m_blocktime;
     unsigned                    m_remaining_blocktime;
     ProtoVer                    m_client_proto_ver;
-    std::vector<std::string>    m_supported_codecs;
+    std::string                 m_codec;
     uint32_t                    m_current_tg;
-    std::set<uint32_t>          m_monitored_tgs;
-    RxMap                       m_rx_map;
-    TxMap                       m_tx_map;
-    Json::Value                 m_node_info;
+    TgList                      m_monitored_tgs;
+    RxList                      m_rx_list;
+    TxList                      m_tx_list;
+    std::string                 m_node_info_json;
+    mutable Json::Value         m_node_info;
+    mutable bool                m_node_info_valid;
+    NetStats                    m_net_stats;
+    std::string                 m_session_token;
 
     ReflectorClient(const ReflectorClient&);
     ReflectorClient& operator=(const ReflectorClient&);
     void onFrameReceived(Async::FramedTcpConnection *con,
-                         std::vector<uint8_t>& data);
-    void handleMsgProtoVer(std::istream& is);
-    void handleMsgAuthResponse(std::istream& is);
-    void handleSelectTG(std::istream& is);
-    void handleTgMonitor(std::istream& is);
-    void handleNodeInfo(std::istream& is);
-    void handleMsgSignalStrengthValues(std::istream& is);
-    void handleMsgTxStatus(std::istream& is);
-    void handleRequestQsy(std::istream& is);
-    void handleStateEvent(std::istream& is);
-    void handleMsgError(std::istream& is);
+                         Async::DataView data);
+    void handleMsgProtoVer(Async::MsgUnpackBuffer& is);
+    void handleMsgAuthResponse(Async::MsgUnpackBuffer& is);
+    void handleMsgSessionResume(Async::MsgUnpackBuffer& is);
+    void sendAuthChallenge(void);
+    void loggedIn(void);
+    void handleSelectTG(Async::MsgUnpackBuffer& is);
+    void handleTgMonitor(Async::MsgUnpackBuffer& is);
+    void handleSelectCodec(Async::MsgUnpackBuffer& is);
+    void handleNodeInfo(Async::MsgUnpackBuffer& is);
+    void handleMsgSignalStrengthValues(Async::MsgUnpackBuffer& is);
+    void handleMsgTxStatus(Async::MsgUnpackBuffer& is);
+    void handleRequestQsy(Async::MsgUnpackBuffer& is);
+    void handleStateEvent(Async::MsgUnpackBuffer& is);
+    void handleMsgError(Async::MsgUnpackBuffer& is);
     void sendError(const std::string& msg);
     void onDiscTimeout(Async::Timer *t);
+    void setConState(ConState new_state);
     void disconnect(void);
-    void handleHeartbeat(Async::Timer *t);
-    std::string lookupUserKey(const std::string& callsign);
+    void updateAudioJitter(void);
+    const Rx *findRx(char id) const;
+    const Rx& rxOrDefault(char id) const;
+    Rx& rx(char id);
+    const Tx *findTx(char id) const;
+    Tx& tx(char id);
 
 };  /* class ReflectorClient */
 
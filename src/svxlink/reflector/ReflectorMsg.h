@@ -396,6 +396,35 @@ class MsgAuthResponse : public ReflectorMsgBase<11>
              (memcmp(&m_digest.front(), digest, DIGEST_LEN) == 0);
     }
 
+    /**
+     * @brief   Verify the digest using a precomputed HMAC state
+     * @param   keyed_hd  A HMAC handle that have been keyed using the
+     *                    authentication key but not written to
+     * @param   challenge The previously transmitted authentication challenge
+     *
+     * This function work like the verify function above but the HMAC key
+     * setup is done once in advance. The keyed handle is copied so that it
+     * can be used for any number of verifications.
+     */
+    bool verify(gcry_md_hd_t keyed_hd, const unsigned char *challenge) const
+    {
+      gcry_md_hd_t hd = { 0 };
+      gcry_error_t err = gcry_md_copy(&hd, keyed_hd);
+      if (err)
+      {
+        std::cerr << "*** ERROR: gcrypt error: "
+                  << gcry_strsource(err) << "/" << gcry_strerror(err)
+                  << std::endl;
+        return false;
+      }
+      gcry_md_write(hd, challenge, MsgAuthChallenge::CHALLENGE_LEN);
+      bool ok = (m_digest.size() == DIGEST_LEN) &&
+                (memcmp(&m_digest.front(), gcry_md_read(hd, 0),
+                        DIGEST_LEN) == 0);
+      gcry_md_close(hd);
+      return ok;
+    }
+
     ASYNC_MSG_MEMBERS(m_callsign, m_digest);
 
   private:
@@ -464,6 +493,122 @@ class MsgError : public ReflectorMsgBase<13>
 }; /* MsgError */
 
 
+/**
+@brief	 Session resumption TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-15
+
+This message is sent by the client instead of MsgAuthResponse when it have a
+session token from an earlier connection, received in a MsgSessionToken
+message. The digest is calculated in the same way as for MsgAuthResponse but
+the session token is used as the key. A digest of the node information that
+the client sent on the earlier connection is included so that the server can
+tell if its stored copy is still up to date.
+
+If the server accept the session, MsgAuthOk is followed by MsgSessionResumed.
+If not, the server send a new MsgAuthChallenge and the client has to use
+MsgAuthResponse.
+*/
+class MsgSessionResume : public ReflectorMsgBase<14>
+{
+  public:
+    static const size_t DIGEST_LEN = MsgAuthResponse::DIGEST_LEN;
+
+    MsgSessionResume(void) {}
+
+    /**
+     * @brief   Constructor
+     * @param   callsign  The callsign (username) of the client
+     * @param   token     The session token received from the server
+     * @param   challenge The authentication challenge received from the server
+     * @param   node_info_digest The digest of the last sent node information
+     */
+    MsgSessionResume(const std::string& callsign, const std::string& token,
+                     const unsigned char *challenge,
+                     const std::vector<uint8_t>& node_info_digest)
+      : m_callsign(callsign), m_node_info_digest(node_info_digest)
+    {
+      MsgAuthResponse auth(callsign, token, challenge);
+      m_digest.assign(auth.digest(), auth.digest() + DIGEST_LEN);
+    }
+
+    /**
+     * @brief   Get the callsign
+     */
+    const std::string& callsign(void) const { return m_callsign; }
+
+    /**
+     * @brief   Get the digest of the node information known by the client
+     */
+    const std::vector<uint8_t>& nodeInfoDigest(void) const
+    {
+      return m_node_info_digest;
+    }
+
+    /**
+     * @brief   Verify that the given token and challenge match the digest
+     * @param   token     The session token stored by the server
+     * @param   challenge The previously transmitted authentication challenge
+     */
+    bool verify(const std::string& token, const unsigned char *challenge) const
+    {
+      MsgAuthResponse auth(m_callsign, token, challenge);
+      return (m_digest.size() == DIGEST_LEN) &&
+             (memcmp(&m_digest.front(), auth.digest(), DIGEST_LEN) == 0);
+    }
+
+    /**
+     * @brief   Calculate the digest of a node information JSON document
+     * @param   json The node information as sent in MsgNodeInfo
+     */
+    static std::vector<uint8_t> nodeInfoDigest(const std::string& json)
+    {
+      std::vector<uint8_t> digest(gcry_md_get_algo_dlen(GCRY_MD_SHA1));
+      gcry_md_hash_buffer(GCRY_MD_SHA1, &digest.front(), json.data(),
+                          json.size());
+      return digest;
+    }
+
+    ASYNC_MSG_MEMBERS(m_callsign, m_digest, m_node_info_digest);
+
+  private:
+    std::string          m_callsign;
+    std::vector<uint8_t> m_digest;
+    std::vector<uint8_t> m_node_info_digest;
+}; /* MsgSessionResume */
+
+
+/**
+@brief	 Session resumed TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-15
+
+This message is sent by the server between MsgAuthOk and MsgServerInfo when a
+session has been resumed. It tell the client which talk group and monitored
+talk groups that have been restored and if the stored node information was
+still valid. The client then only need to send the state that differ.
+*/
+class MsgSessionResumed : public ReflectorMsgBase<15>
+{
+  public:
+    MsgSessionResumed(uint32_t tg=0,
+                      const std::set<uint32_t>& tgs=std::set<uint32_t>(),
+                      bool node_info_ok=false)
+      : m_tg(tg), m_tgs(tgs), m_node_info_ok(node_info_ok ? 1 : 0) {}
+
+    uint32_t tg(void) const { return m_tg; }
+    const std::set<uint32_t>& tgs(void) const { return m_tgs; }
+    bool nodeInfoOk(void) const { return m_node_info_ok != 0; }
+
+    ASYNC_MSG_MEMBERS(m_tg, m_tgs, m_node_info_ok);
+
+  private:
+    uint32_t            m_tg;
+    std::set<uint32_t>  m_tgs;
+    uint8_t             m_node_info_ok;
+}; /* MsgSessionResumed */
+
+
 /**
 @brief	 Server information TCP network message
 @author  Tobias Blomberg / SM0SVX
@@ -1106,6 +1251,60 @@ class MsgTxStatus : public ReflectorMsgBase<113>
 }; /* class MsgTxStatus */
 
 
+/**
+@brief  Select codec TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-14
+
+This message is used by a client to tell the reflector which of the codecs in
+the MsgServerInfo message it have selected. It is only sent if the reflector
+offered more than one codec, which it only do if transcoding is enabled. A
+client that do not send this message is assumed to use the first codec in the
+list.
+*/
+class MsgSelectCodec : public ReflectorMsgBase<114>
+{
+  public:
+    MsgSelectCodec(const std::string& codec="") : m_codec(codec) {}
+    const std::string& codec(void) const { return m_codec; }
+
+    ASYNC_MSG_MEMBERS(m_codec)
+
+  private:
+    std::string m_codec;
+}; /* MsgSelectCodec */
+
+
+/**
+@brief	 Session token TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-15
+
+This message is sent by the server after MsgServerInfo if it store sessions
+so that they can be resumed after a restart. The client keep the token and
+use it in a MsgSessionResume message the next time it connect. A new token is
+sent on each connection and a token can only be used once.
+*/
+class MsgSessionToken : public ReflectorMsgBase<115>
+{
+  public:
+    static const size_t TOKEN_LEN = 20;
+
+    MsgSessionToken(const std::string& token="")
+      : m_token(token.begin(), token.end()) {}
+
+    std::string token(void) const
+    {
+      return std::string(m_token.begin(), m_token.end());
+    }
+
+    ASYNC_MSG_MEMBERS(m_token)
+
+  private:
+    std::vector<uint8_t> m_token;
+}; /* MsgSessionToken */
+
+
 /***************************** UDP Messages *****************************/
 
 /**
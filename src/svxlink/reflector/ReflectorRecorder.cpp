@@ -0,0 +1,588 @@
+/**
+@file   ReflectorRecorder.cpp
+@brief  Record the talker audio of selected talk groups to Ogg/Opus files
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <unistd.h>
+#include <errno.h>
+#ifdef OGG_MAJOR
+#include <ogg/ogg.h>
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorRecorder.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+  // The state of one recording. Only used by the writer thread.
+struct ReflectorRecorder::Stream
+{
+#ifdef OGG_MAJOR
+  ogg_stream_state      os;
+#endif
+  std::ofstream         file;
+  std::vector<char>     file_buf;
+  std::string           path;
+  int64_t               granulepos;
+  int64_t               packetno;
+  std::vector<uint8_t>  pending;
+};
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+#ifdef OGG_MAJOR
+static unsigned opusPacketSamples(const uint8_t *data, size_t len);
+static void putLe16(std::vector<uint8_t>& buf, uint16_t val);
+static void putLe32(std::vector<uint8_t>& buf, uint32_t val);
+static void putString(std::vector<uint8_t>& buf, const std::string& str);
+static bool writePackets(ogg_stream_state& os, std::ofstream& file,
+                         bool flush);
+#endif
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+  // The Opus encoder delay at 48kHz that libopus use by default
+static const uint16_t OPUS_PRE_SKIP = 312;
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+ReflectorRecorder::ReflectorRecorder(void)
+  : m_flush_timer(JOB_FLUSH_MS, Timer::TYPE_PERIODIC, false)
+{
+  m_flush_timer.expired.connect(
+      sigc::mem_fun(*this, &ReflectorRecorder::flush));
+} /* ReflectorRecorder::ReflectorRecorder */
+
+
+ReflectorRecorder::~ReflectorRecorder(void)
+{
+  while (!m_active.empty())
+  {
+    talkerStop(*m_active.begin());
+  }
+  flush();
+  m_thread.stop();
+
+    // The writer thread has exited so it is safe to touch its state here
+  while (!m_streams.empty())
+  {
+    stopStream(m_streams.begin()->first);
+  }
+} /* ReflectorRecorder::~ReflectorRecorder */
+
+
+bool ReflectorRecorder::initialize(const std::string& dir,
+                                   const std::set<uint32_t>& tgs)
+{
+#ifdef OGG_MAJOR
+  if (access(dir.c_str(), W_OK | X_OK) != 0)
+  {
+    cerr << "*** ERROR: Recording directory \"" << dir
+         << "\" is not writable: " << strerror(errno) << endl;
+    return false;
+  }
+  if (!m_thread.start())
+  {
+    cerr << "*** ERROR: Could not start the recorder thread" << endl;
+    return false;
+  }
+  m_dir = dir;
+  m_tgs = tgs;
+  m_flush_timer.setEnable(true);
+
+  cout << "Recording TG#: [ ";
+  for (std::set<uint32_t>::const_iterator it = m_tgs.begin();
+       it != m_tgs.end(); ++it)
+  {
+    cout << *it << " ";
+  }
+  cout << "] to \"" << m_dir << "\"" << endl;
+  return true;
+#else
+  cerr << "*** ERROR: SvxReflector was built without Ogg support so "
+          "recording is not available" << endl;
+  return false;
+#endif
+} /* ReflectorRecorder::initialize */
+
+
+void ReflectorRecorder::talkerStart(uint32_t tg, const std::string& callsign,
+                                    const std::string& codec)
+{
+  if (!isRecorded(tg))
+  {
+    return;
+  }
+  if (codec != "OPUS")
+  {
+    cout << callsign << ": Not recording TG #" << tg << " since codec "
+         << codec << " is used" << endl;
+    return;
+  }
+  m_active.insert(tg);
+  addCommand(CMD_START, tg, callsign.data(), callsign.size(), time(NULL));
+} /* ReflectorRecorder::talkerStart */
+
+
+void ReflectorRecorder::talkerStop(uint32_t tg)
+{
+  if (m_active.erase(tg) > 0)
+  {
+    addCommand(CMD_STOP, tg, 0, 0);
+  }
+} /* ReflectorRecorder::talkerStop */
+
+
+void ReflectorRecorder::audio(uint32_t tg, const uint8_t *data, size_t len)
+{
+  if ((len == 0) || (m_active.count(tg) == 0))
+  {
+    return;
+  }
+  addCommand(CMD_AUDIO, tg, data, len);
+  if (m_job->data.size() >= JOB_FLUSH_SIZE)
+  {
+    flush();
+  }
+} /* ReflectorRecorder::audio */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ReflectorRecorder::addCommand(CommandType type, uint32_t tg,
+                                   const void *data, size_t len, time_t t)
+{
+  if (!m_job)
+  {
+    m_job = std::make_shared<Job>();
+  }
+  Command cmd;
+  cmd.type = type;
+  cmd.tg = tg;
+  cmd.pos = m_job->data.size();
+  cmd.len = len;
+  cmd.time = t;
+  m_job->commands.push_back(cmd);
+  const uint8_t *ptr = reinterpret_cast<const uint8_t*>(data);
+  m_job->data.insert(m_job->data.end(), ptr, ptr + len);
+} /* ReflectorRecorder::addCommand */
+
+
+void ReflectorRecorder::flush(Async::Timer *t)
+{
+  if (m_job)
+  {
+    m_thread.post(sigc::bind(sigc::mem_fun(*this, &ReflectorRecorder::write),
+                             m_job));
+    m_job.reset();
+  }
+} /* ReflectorRecorder::flush */
+
+
+/*
+ *----------------------------------------------------------------------------
+ * Method:    ReflectorRecorder::write
+ * Purpose:   Execute all commands in a job. Run in the writer thread.
+ * Input:     job - The job to execute
+ * Output:    None
+ * Author:    Tobias Blomberg / SM0SVX
+ * Created:   2026-10-15
+ * Remarks:   The files are flushed once per job so there is one write
+ *            system call per file and job.
+ * Bugs:
+ *----------------------------------------------------------------------------
+ */
+void ReflectorRecorder::write(JobPtr job)
+{
+  for (std::vector<Command>::const_iterator it = job->commands.begin();
+       it != job->commands.end(); ++it)
+  {
+    const uint8_t *data = (it->len > 0) ? &job->data[it->pos] : 0;
+    switch (it->type)
+    {
+      case CMD_START:
+        startStream(it->tg,
+            std::string(job->data.begin() + it->pos,
+                        job->data.begin() + it->pos + it->len),
+            it->time);
+        break;
+      case CMD_AUDIO:
+        writePacket(it->tg, data, it->len);
+        break;
+      case CMD_STOP:
+        stopStream(it->tg);
+        break;
+    }
+  }
+  for (StreamMap::iterator it = m_streams.begin(); it != m_streams.end(); ++it)
+  {
+    it->second->file.flush();
+  }
+} /* ReflectorRecorder::write */
+
+
+void ReflectorRecorder::startStream(uint32_t tg, const std::string& callsign,
+                                    time_t t)
+{
+#ifdef OGG_MAJOR
+  stopStream(tg);
+
+  struct tm tm;
+  localtime_r(&t, &tm);
+  char file_time[32];
+  strftime(file_time, sizeof(file_time), "%Y-%m-%d_%H-%M-%S", &tm);
+  char tag_time[32];
+  strftime(tag_time, sizeof(tag_time), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    // Callsigns may contain characters, like '/', that cannot be used in a
+    // file name
+  std::string file_callsign(callsign);
+  for (std::string::iterator it = file_callsign.begin();
+       it != file_callsign.end(); ++it)
+  {
+    if (!isalnum(static_cast<unsigned char>(*it)) && (*it != '-'))
+    {
+      *it = '_';
+    }
+  }
+  std::ostringstream ss;
+  ss << m_dir << "/TG" << tg << "_" << file_time << "_" << file_callsign
+     << ".opus";
+
+  Stream *stream = new Stream;
+  stream->path = ss.str();
+  stream->file_buf.resize(FILE_BUF_SIZE);
+  stream->file.rdbuf()->pubsetbuf(&stream->file_buf[0],
+                                  stream->file_buf.size());
+  stream->file.open(stream->path.c_str(),
+                    ios::out | ios::binary | ios::trunc);
+  if (!stream->file.is_open())
+  {
+    cerr << "*** ERROR: Could not create recording file \"" << stream->path
+         << "\": " << strerror(errno) << endl;
+    delete stream;
+    return;
+  }
+  ogg_stream_init(&stream->os, rand());
+  stream->granulepos = 0;
+  stream->packetno = 0;
+
+    // The Opus identification header, RFC 7845 section 5.1
+  std::vector<uint8_t> head;
+  putString(head, "OpusHead");
+  head.push_back(1);                      // Version
+  head.push_back(1);                      // Channel count
+  putLe16(head, OPUS_PRE_SKIP);
+  putLe32(head, 0);                       // Input sample rate, unspecified
+  putLe16(head, 0);                       // Output gain
+  head.push_back(0);                      // Channel mapping family
+
+    // The comment header, RFC 7845 section 5.2
+  std::ostringstream tg_ss;
+  tg_ss << tg;
+  std::vector<std::string> comments;
+  comments.push_back("TITLE=TG #" + tg_ss.str());
+  comments.push_back("ARTIST=" + callsign);
+  comments.push_back("DATE=" + std::string(tag_time));
+  comments.push_back("TALKGROUP=" + tg_ss.str());
+  std::vector<uint8_t> tags;
+  putString(tags, "OpusTags");
+  putLe32(tags, 12);
+  putString(tags, "SvxReflector");
+  putLe32(tags, comments.size());
+  for (std::vector<std::string>::const_iterator it = comments.begin();
+       it != comments.end(); ++it)
+  {
+    putLe32(tags, it->size());
+    putString(tags, *it);
+  }
+
+  std::vector<uint8_t>* headers[] = { &head, &tags };
+  for (size_t i=0; i<2; ++i)
+  {
+    ogg_packet pkt;
+    pkt.packet = &(*headers[i])[0];
+    pkt.bytes = headers[i]->size();
+    pkt.b_o_s = (i == 0) ? 1 : 0;
+    pkt.e_o_s = 0;
+    pkt.granulepos = 0;
+    pkt.packetno = stream->packetno++;
+    ogg_stream_packetin(&stream->os, &pkt);
+      // The headers must be on pages of their own
+    writePackets(stream->os, stream->file, true);
+  }
+
+  m_streams[tg] = stream;
+#endif
+} /* ReflectorRecorder::startStream */
+
+
+void ReflectorRecorder::writePacket(uint32_t tg, const uint8_t *data,
+                                    size_t len)
+{
+#ifdef OGG_MAJOR
+  StreamMap::iterator it = m_streams.find(tg);
+  if (it == m_streams.end())
+  {
+    return;
+  }
+  Stream *stream = it->second;
+
+    // The last packet is held back so that it can be marked as the end of
+    // the stream when the talker stop
+  if (!stream->pending.empty())
+  {
+    stream->granulepos += opusPacketSamples(&stream->pending[0],
+                                            stream->pending.size());
+    ogg_packet pkt;
+    pkt.packet = &stream->pending[0];
+    pkt.bytes = stream->pending.size();
+    pkt.b_o_s = 0;
+    pkt.e_o_s = 0;
+    pkt.granulepos = stream->granulepos;
+    pkt.packetno = stream->packetno++;
+    ogg_stream_packetin(&stream->os, &pkt);
+    writePackets(stream->os, stream->file, false);
+  }
+  stream->pending.assign(data, data + len);
+#endif
+} /* ReflectorRecorder::writePacket */
+
+
+void ReflectorRecorder::stopStream(uint32_t tg)
+{
+  StreamMap::iterator it = m_streams.find(tg);
+  if (it == m_streams.end())
+  {
+    return;
+  }
+  Stream *stream = it->second;
+  m_streams.erase(it);
+
+#ifdef OGG_MAJOR
+  if (!stream->pending.empty())
+  {
+    stream->granulepos += opusPacketSamples(&stream->pending[0],
+                                            stream->pending.size());
+    ogg_packet pkt;
+    pkt.packet = &stream->pending[0];
+    pkt.bytes = stream->pending.size();
+    pkt.b_o_s = 0;
+    pkt.e_o_s = 1;
+    pkt.granulepos = stream->granulepos;
+    pkt.packetno = stream->packetno++;
+    ogg_stream_packetin(&stream->os, &pkt);
+  }
+  if (!writePackets(stream->os, stream->file, true))
+  {
+    cerr << "*** ERROR: Failed to write recording file \"" << stream->path
+         << "\"" << endl;
+  }
+  ogg_stream_clear(&stream->os);
+#endif
+  stream->file.close();
+  delete stream;
+} /* ReflectorRecorder::stopStream */
+
+
+#ifdef OGG_MAJOR
+
+/*
+ *----------------------------------------------------------------------------
+ * Function:  opusPacketSamples
+ * Purpose:   Find out the duration of an Opus packet from its TOC byte,
+ *            RFC 6716 section 3.1.
+ * Input:     data  - The Opus packet
+ *            len   - The size of the Opus packet
+ * Output:    Returns the number of samples at 48kHz in the packet
+ * Author:    Tobias Blomberg / SM0SVX
+ * Created:   2026-10-15
+ * Remarks:
+ * Bugs:
+ *----------------------------------------------------------------------------
+ */
+static unsigned opusPacketSamples(const uint8_t *data, size_t len)
+{
+  if (len < 1)
+  {
+    return 0;
+  }
+  const unsigned config = data[0] >> 3;
+  unsigned frame_samples;
+  if (config < 12)        // SILK-only: 10, 20, 40 or 60ms
+  {
+    static const unsigned silk_samples[] = { 480, 960, 1920, 2880 };
+    frame_samples = silk_samples[config & 3];
+  }
+  else if (config < 16)   // Hybrid: 10 or 20ms
+  {
+    frame_samples = (config & 1) ? 960 : 480;
+  }
+  else                    // CELT-only: 2.5, 5, 10 or 20ms
+  {
+    frame_samples = 120 << (config & 3);
+  }
+
+  unsigned frame_cnt = 1;
+  switch (data[0] & 3)
+  {
+    case 0:
+      break;
+    case 1:
+    case 2:
+      frame_cnt = 2;
+      break;
+    case 3:
+      frame_cnt = (len < 2) ? 0 : (data[1] & 0x3f);
+      break;
+  }
+  return frame_cnt * frame_samples;
+} /* opusPacketSamples */
+
+
+static void putLe16(std::vector<uint8_t>& buf, uint16_t val)
+{
+  buf.push_back(val & 0xff);
+  buf.push_back(val >> 8);
+} /* putLe16 */
+
+
+static void putLe32(std::vector<uint8_t>& buf, uint32_t val)
+{
+  putLe16(buf, val & 0xffff);
+  putLe16(buf, val >> 16);
+} /* putLe32 */
+
+
+static void putString(std::vector<uint8_t>& buf, const std::string& str)
+{
+  buf.insert(buf.end(), str.begin(), str.end());
+} /* putString */
+
+
+static bool writePackets(ogg_stream_state& os, std::ofstream& file,
+                         bool flush)
+{
+  ogg_page page;
+  while (flush ? (ogg_stream_flush(&os, &page) != 0)
+               : (ogg_stream_pageout(&os, &page) != 0))
+  {
+    file.write(reinterpret_cast<const char*>(page.header), page.header_len);
+    file.write(reinterpret_cast<const char*>(page.body), page.body_len);
+  }
+  return file.good();
+} /* writePackets */
+
+#endif /* OGG_MAJOR */
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,248 @@
+/**
+@file   ReflectorRecorder.h
+@brief  Record the talker audio of selected talk groups to Ogg/Opus files
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef REFLECTOR_RECORDER_INCLUDED
+#define REFLECTOR_RECORDER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <memory>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppEventLoopThread.h>
+#include <AsyncTimer.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Record the talker audio of selected talk groups to Ogg/Opus files
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+An object of this class is created by the reflector when GLOBAL/RECORD_TGS is
+set. Each transmission on a recorded talk group is written to its own file,
+named after the talk group, the start time and the callsign of the talker.
+The callsign, talk group and start time are also stored as Opus comments.
+
+The audio is stored in the codec it was received in so no decoding or
+encoding is needed. Only Opus is supported, transmissions from talkers using
+other codecs are not recorded. The main thread only copy the audio packets
+into a job that is handed over to a writer thread twice a second. The writer
+thread put the packets into Ogg pages and write them to the files.
+*/
+class ReflectorRecorder
+{
+  public:
+    /**
+     * @brief   Default constructor
+     */
+    ReflectorRecorder(void);
+
+    /**
+     * @brief   Disallow copy construction
+     */
+    ReflectorRecorder(const ReflectorRecorder&) = delete;
+
+    /**
+     * @brief   Disallow copy assignment
+     */
+    ReflectorRecorder& operator=(const ReflectorRecorder&) = delete;
+
+    /**
+     * @brief   Destructor
+     *
+     * Ongoing recordings are finished and the writer thread is stopped after
+     * all queued audio has been written.
+     */
+    ~ReflectorRecorder(void);
+
+    /**
+     * @brief   Start recording
+     * @param   dir The directory to write the recordings to
+     * @param   tgs The talk groups to record
+     * @return  Returns \em true on success or \em false on failure
+     */
+    bool initialize(const std::string& dir, const std::set<uint32_t>& tgs);
+
+    /**
+     * @brief   Check if a talk group is recorded
+     * @param   tg  The talk group to check
+     */
+    bool isRecorded(uint32_t tg) const { return m_tgs.count(tg) > 0; }
+
+    /**
+     * @brief   Indicate that a talker has started on a talk group
+     * @param   tg        The talk group
+     * @param   callsign  The callsign of the talker
+     * @param   codec     The name of the codec used by the talker
+     */
+    void talkerStart(uint32_t tg, const std::string& callsign,
+                     const std::string& codec);
+
+    /**
+     * @brief   Indicate that the talker on a talk group has stopped
+     * @param   tg        The talk group
+     */
+    void talkerStop(uint32_t tg);
+
+    /**
+     * @brief   Record an audio packet
+     * @param   tg    The talk group the audio was received on
+     * @param   data  The encoded audio
+     * @param   len   The size of the encoded audio
+     *
+     * The packet is ignored if no recording is active on the talk group.
+     */
+    void audio(uint32_t tg, const uint8_t *data, size_t len);
+
+  private:
+    static const size_t   JOB_FLUSH_SIZE  = 65536;
+    static const unsigned JOB_FLUSH_MS    = 500;
+    static const size_t   FILE_BUF_SIZE   = 65536;
+
+    typedef enum
+    {
+      CMD_START, CMD_AUDIO, CMD_STOP
+    } CommandType;
+
+    struct Command
+    {
+      CommandType type;
+      uint32_t    tg;
+      size_t      pos;    //!< Start of the data in the job buffer
+      size_t      len;    //!< Size of the data in the job buffer
+      time_t      time;   //!< The start time for CMD_START
+    };
+
+    struct Job
+    {
+      std::vector<Command>  commands;
+      std::vector<uint8_t>  data;
+    };
+    typedef std::shared_ptr<Job> JobPtr;
+
+    struct Stream;
+    typedef std::map<uint32_t, Stream*> StreamMap;
+
+    Async::CppEventLoopThread m_thread;
+    Async::Timer              m_flush_timer;
+    std::string               m_dir;
+    std::set<uint32_t>        m_tgs;
+    std::set<uint32_t>        m_active;
+    JobPtr                    m_job;
+    StreamMap                 m_streams;    //!< Only used by the writer thread
+
+    void addCommand(CommandType type, uint32_t tg, const void *data,
+                    size_t len, time_t t=0);
+    void flush(Async::Timer *t=0);
+    void write(JobPtr job);
+    void startStream(uint32_t tg, const std::string& callsign, time_t t);
+    void writePacket(uint32_t tg, const uint8_t *data, size_t len);
+    void stopStream(uint32_t tg);
+
+};  /* class ReflectorRecorder */
+
+
+//} /* namespace */
+
+#endif /* REFLECTOR_RECORDER_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,347 @@
+/**
+@file   ReflectorSessions.cpp
+@brief  Store client sessions so that they can be resumed after a restart
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <gcrypt.h>
+#include <json/json.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorSessions.h"
+#include "ReflectorMsg.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static std::string toHex(const std::string& str);
+static std::string fromHex(const std::string& hex);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+bool ReflectorSessions::load(const std::string& path, unsigned timeout)
+{
+  m_path = path;
+  m_timeout = timeout;
+  m_sessions.clear();
+
+  std::ifstream is(path.c_str());
+  if (!is)
+  {
+    if (errno == ENOENT)
+    {
+      return true;
+    }
+    cerr << "*** ERROR: Could not open session file \"" << path << "\": "
+         << strerror(errno) << endl;
+    return false;
+  }
+
+  Json::Value root;
+  Json::CharReaderBuilder builder;
+  std::string errs;
+  if (!Json::parseFromStream(builder, is, &root, &errs) || !root.isArray())
+  {
+    cerr << "*** WARNING: Ignoring malformed session file \"" << path
+         << "\"" << endl;
+    return true;
+  }
+
+  for (Json::Value::const_iterator it = root.begin(); it != root.end(); ++it)
+  {
+    const Json::Value& entry = *it;
+    const std::string callsign = entry.get("callsign", "").asString();
+    Session session;
+    session.token = fromHex(entry.get("token", "").asString());
+    session.time = entry.get("time", 0).asInt64();
+    session.tg = entry.get("tg", 0).asUInt();
+    const Json::Value& tgs = entry["monitored_tgs"];
+    for (Json::Value::const_iterator tg_it = tgs.begin();
+         tg_it != tgs.end(); ++tg_it)
+    {
+      session.monitored_tgs.push_back((*tg_it).asUInt());
+    }
+    std::sort(session.monitored_tgs.begin(), session.monitored_tgs.end());
+    session.node_info_json = entry.get("node_info", "").asString();
+    if (!callsign.empty() &&
+        (session.token.size() == MsgSessionToken::TOKEN_LEN))
+    {
+      m_sessions[callsign] = session;
+    }
+  }
+  expire();
+  cout << "Loaded " << m_sessions.size() << " resumable sessions from \""
+       << path << "\"" << endl;
+
+  return true;
+} /* ReflectorSessions::load */
+
+
+bool ReflectorSessions::save(const SessionMap& sessions)
+{
+  expire();
+
+  Json::Value root(Json::arrayValue);
+  SessionMap all(sessions);
+  all.insert(m_sessions.begin(), m_sessions.end());
+  for (SessionMap::const_iterator it = all.begin(); it != all.end(); ++it)
+  {
+    const Session& session = it->second;
+    Json::Value entry(Json::objectValue);
+    entry["callsign"] = it->first;
+    entry["token"] = toHex(session.token);
+    entry["time"] = static_cast<Json::Int64>(session.time);
+    entry["tg"] = session.tg;
+    Json::Value tgs(Json::arrayValue);
+    for (std::vector<uint32_t>::const_iterator tg_it =
+           session.monitored_tgs.begin();
+         tg_it != session.monitored_tgs.end(); ++tg_it)
+    {
+      tgs.append(*tg_it);
+    }
+    entry["monitored_tgs"] = tgs;
+    entry["node_info"] = session.node_info_json;
+    root.append(entry);
+  }
+
+  Json::StreamWriterBuilder builder;
+  builder["commentStyle"] = "None";
+  builder["indentation"] = "";
+  const std::string data = Json::writeString(builder, root);
+
+    // The file contain the session tokens so it must only be readable by us.
+    // It is written to a temporary file that is then renamed so that a crash
+    // while writing does not leave a truncated file behind.
+  const std::string tmp_path = m_path + ".tmp";
+  int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0)
+  {
+    cerr << "*** ERROR: Could not open session file \"" << tmp_path
+         << "\" for writing: " << strerror(errno) << endl;
+    return false;
+  }
+  size_t pos = 0;
+  while (pos < data.size())
+  {
+    ssize_t ret = ::write(fd, data.data() + pos, data.size() - pos);
+    if (ret < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      cerr << "*** ERROR: Could not write session file \"" << tmp_path
+           << "\": " << strerror(errno) << endl;
+      ::close(fd);
+      ::unlink(tmp_path.c_str());
+      return false;
+    }
+    pos += ret;
+  }
+  if ((::close(fd) < 0) || (::rename(tmp_path.c_str(), m_path.c_str()) < 0))
+  {
+    cerr << "*** ERROR: Could not save session file \"" << m_path << "\": "
+         << strerror(errno) << endl;
+    ::unlink(tmp_path.c_str());
+    return false;
+  }
+
+  return true;
+} /* ReflectorSessions::save */
+
+
+bool ReflectorSessions::find(const std::string& callsign, Session& session)
+{
+  expire();
+  SessionMap::const_iterator it = m_sessions.find(callsign);
+  if (it == m_sessions.end())
+  {
+    return false;
+  }
+  session = it->second;
+  return true;
+} /* ReflectorSessions::find */
+
+
+std::string ReflectorSessions::createToken(void)
+{
+  std::string token(MsgSessionToken::TOKEN_LEN, '\0');
+  gcry_randomize(&token[0], token.size(), GCRY_STRONG_RANDOM);
+  return token;
+} /* ReflectorSessions::createToken */
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ReflectorSessions::expire(void)
+{
+  const time_t now = time(NULL);
+  SessionMap::iterator it = m_sessions.begin();
+  while (it != m_sessions.end())
+  {
+    if ((now < it->second.time) ||
+        (now - it->second.time > static_cast<time_t>(m_timeout)))
+    {
+      it = m_sessions.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+} /* ReflectorSessions::expire */
+
+
+static std::string toHex(const std::string& str)
+{
+  static const char digits[] = "0123456789abcdef";
+  std::string hex;
+  hex.reserve(2 * str.size());
+  for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+  {
+    const uint8_t ch = static_cast<uint8_t>(*it);
+    hex += digits[ch >> 4];
+    hex += digits[ch & 0x0f];
+  }
+  return hex;
+} /* toHex */
+
+
+static std::string fromHex(const std::string& hex)
+{
+  std::string str;
+  if (hex.size() % 2 != 0)
+  {
+    return str;
+  }
+  str.reserve(hex.size() / 2);
+  for (size_t i = 0; i < hex.size(); i += 2)
+  {
+    char *end = 0;
+    const std::string byte = hex.substr(i, 2);
+    long val = strtol(byte.c_str(), &end, 16);
+    if (*end != '\0')
+    {
+      return std::string();
+    }
+    str += static_cast<char>(val);
+  }
+  return str;
+} /* fromHex */
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,218 @@
+/**
+@file   ReflectorSessions.h
+@brief  Store client sessions so that they can be resumed after a restart
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef REFLECTOR_SESSIONS_INCLUDED
+#define REFLECTOR_SESSIONS_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <map>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Store client sessions so that they can be resumed after a restart
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+An object of this class is created by the reflector when GLOBAL/SESSION_FILE
+is set. The reflector save the state of all logged in clients to the file on
+shutdown and at regular intervals. After a restart the file is loaded and a
+client presenting the session token of a stored session get its selected talk
+group, monitored talk groups and node information back without having to
+authenticate and upload it all again.
+
+The file contain the session tokens so it is created readable by the owner
+only. A stored session can only be resumed once and only within the timeout
+from when it was saved.
+*/
+class ReflectorSessions
+{
+  public:
+    /**
+     * @brief The stored state of one client
+     */
+    struct Session
+    {
+      std::string             token;          //!< The session token
+      time_t                  time;           //!< When the state was saved
+      uint32_t                tg;             //!< The selected talk group
+      std::vector<uint32_t>   monitored_tgs;  //!< Sorted monitored TGs
+      std::string             node_info_json; //!< As received in MsgNodeInfo
+      Session(void) : time(0), tg(0) {}
+    };
+
+    /**
+     * @brief Sessions indexed on callsign
+     */
+    typedef std::map<std::string, Session> SessionMap;
+
+    /**
+     * @brief   Default constructor
+     */
+    ReflectorSessions(void) : m_timeout(0) {}
+
+    /**
+     * @brief   Disallow copy construction
+     */
+    ReflectorSessions(const ReflectorSessions&) = delete;
+
+    /**
+     * @brief   Disallow copy assignment
+     */
+    ReflectorSessions& operator=(const ReflectorSessions&) = delete;
+
+    /**
+     * @brief   Load stored sessions
+     * @param   path    The path to the session file
+     * @param   timeout The time in seconds a stored session can be resumed
+     * @return  Returns \em true on success or \em false on failure
+     *
+     * It is not an error if the file does not exist. Sessions that have
+     * already timed out are not loaded.
+     */
+    bool load(const std::string& path, unsigned timeout);
+
+    /**
+     * @brief   Save sessions to the file
+     * @param   sessions The sessions of the logged in clients
+     * @return  Returns \em true on success or \em false on failure
+     *
+     * Loaded sessions that have not yet been resumed or timed out are saved
+     * too. The file is replaced atomically.
+     */
+    bool save(const SessionMap& sessions);
+
+    /**
+     * @brief   Find a stored session
+     * @param   callsign  The callsign of the client
+     * @param   session   Set to the stored session
+     * @return  Returns \em true if a session that has not timed out was found
+     */
+    bool find(const std::string& callsign, Session& session);
+
+    /**
+     * @brief   Remove a stored session
+     * @param   callsign  The callsign of the client
+     */
+    void remove(const std::string& callsign) { m_sessions.erase(callsign); }
+
+    /**
+     * @brief   Create a new random session token
+     * @return  Returns a token of MsgSessionToken::TOKEN_LEN bytes
+     */
+    static std::string createToken(void);
+
+  private:
+    std::string   m_path;
+    unsigned      m_timeout;
+    SessionMap    m_sessions;
+
+    void expire(void);
+
+};  /* class ReflectorSessions */
+
+
+//} /* namespace */
+
+#endif /* REFLECTOR_SESSIONS_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
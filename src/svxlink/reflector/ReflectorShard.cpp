@@ -0,0 +1,267 @@
+/**
+@file   ReflectorShard.cpp
+@brief  A worker thread sending UDP datagrams for a subset of the clients
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <errno.h>
+
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorShard.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+ReflectorShard::ReflectorShard(int udp_fd)
+  : m_fd(udp_fd)
+{
+} /* ReflectorShard::ReflectorShard */
+
+
+ReflectorShard::~ReflectorShard(void)
+{
+  flush();
+  m_thread.stop();
+} /* ReflectorShard::~ReflectorShard */
+
+
+void ReflectorShard::queue(const struct sockaddr *addr, socklen_t addr_len,
+                           const void *header, size_t hdr_len,
+                           const Payload& payload)
+{
+  assert(hdr_len <= MAX_HEADER_SIZE);
+  assert(addr_len <= sizeof(Datagram::addr));
+  if (!m_job)
+  {
+    m_job = std::make_shared<Job>();
+  }
+  if (m_job->payloads.empty() || (m_job->payloads.back() != payload))
+  {
+    m_job->payloads.push_back(payload);
+  }
+  m_job->datagrams.resize(m_job->datagrams.size() + 1);
+  Datagram& dgram = m_job->datagrams.back();
+  memcpy(&dgram.addr, addr, addr_len);
+  dgram.addr_len = addr_len;
+  memcpy(dgram.header, header, hdr_len);
+  dgram.hdr_len = hdr_len;
+  dgram.payload = m_job->payloads.size() - 1;
+} /* ReflectorShard::queue */
+
+
+void ReflectorShard::flush(void)
+{
+  if (m_job)
+  {
+    m_thread.post(sigc::bind(sigc::mem_fun(*this, &ReflectorShard::send),
+                             m_job));
+    m_job.reset();
+  }
+} /* ReflectorShard::flush */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+/*
+ *----------------------------------------------------------------------------
+ * Method:    ReflectorShard::send
+ * Purpose:   Send all datagrams in a job. Run in the worker thread.
+ * Input:     job - The job to send
+ * Output:    None
+ * Author:    Tobias Blomberg / SM0SVX
+ * Created:   2026-10-14
+ * Remarks:   If the socket send buffer is full, the worker wait for a short
+ *            while. If it is still full the rest of the job is dropped,
+ *            just like datagrams are dropped by the main thread.
+ * Bugs:
+ *----------------------------------------------------------------------------
+ */
+void ReflectorShard::send(JobPtr job)
+{
+  const size_t cnt = job->datagrams.size();
+  struct iovec iov[2 * SEND_BATCH_SIZE];
+#ifdef HAS_SENDMMSG
+  struct mmsghdr msgs[SEND_BATCH_SIZE];
+#endif
+  size_t pos = 0;
+  while (pos < cnt)
+  {
+    unsigned batch = 0;
+    for (; (batch < SEND_BATCH_SIZE) && (pos + batch < cnt); ++batch)
+    {
+      Datagram& dgram = job->datagrams[pos + batch];
+      const Payload& payload = job->payloads[dgram.payload];
+      iov[2*batch].iov_base = dgram.header;
+      iov[2*batch].iov_len = dgram.hdr_len;
+      iov[2*batch+1].iov_base = const_cast<char *>(payload->data());
+      iov[2*batch+1].iov_len = payload->size();
+#ifdef HAS_SENDMMSG
+      memset(&msgs[batch], 0, sizeof(msgs[batch]));
+      msgs[batch].msg_hdr.msg_name = &dgram.addr;
+      msgs[batch].msg_hdr.msg_namelen = dgram.addr_len;
+      msgs[batch].msg_hdr.msg_iov = &iov[2*batch];
+      msgs[batch].msg_hdr.msg_iovlen = 2;
+#endif
+    }
+
+#ifdef HAS_SENDMMSG
+    int ret = sendmmsg(m_fd, msgs, batch, 0);
+#else
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &job->datagrams[pos].addr;
+    msg.msg_namelen = job->datagrams[pos].addr_len;
+    msg.msg_iov = &iov[0];
+    msg.msg_iovlen = 2;
+    int ret = sendmsg(m_fd, &msg, 0);
+    if (ret != -1)
+    {
+      ret = 1;
+    }
+#endif
+    if (ret == -1)
+    {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        struct pollfd pfd;
+        pfd.fd = m_fd;
+        pfd.events = POLLOUT;
+        if (poll(&pfd, 1, SEND_WAIT_MS) > 0)
+        {
+          continue;
+        }
+        cerr << "*** WARNING: UDP send buffer full. Dropping "
+             << (cnt - pos) << " datagram(s) in shard" << endl;
+        return;
+      }
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      perror("sendmmsg in ReflectorShard::send");
+        // Skip the failing datagram and try the rest
+      ret = 1;
+    }
+    pos += ret;
+  }
+} /* ReflectorShard::send */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,218 @@
+/**
+@file   ReflectorShard.h
+@brief  A worker thread sending UDP datagrams for a subset of the clients
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef REFLECTOR_SHARD_INCLUDED
+#define REFLECTOR_SHARD_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <netinet/in.h>
+#include <stdint.h>
+
+#include <vector>
+#include <memory>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppEventLoopThread.h>
+#include <AsyncMemPool.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A worker thread sending UDP datagrams for a subset of the clients
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+When the reflector run in sharded mode, the clients are spread over a number
+of shards based on their client id. All UDP datagrams to a client are sent by
+the worker thread of its shard so the kernel work for the audio fan-out is
+spread over multiple CPU cores.
+
+All reflector state, like the TG membership and talker arbitration, stay in
+the main thread. The main thread queue complete datagrams, header and payload,
+to the shards and the shards only send them. A payload that is sent to many
+clients is shared between the shards. The datagrams are sent on the UDP socket
+owned by the main thread so they all originate from the reflector port.
+*/
+class ReflectorShard
+{
+  public:
+    typedef std::vector<char, Async::PoolAllocator<char> > PayloadBuf;
+    typedef std::shared_ptr<const PayloadBuf> Payload;
+
+    /**
+     * @brief   Constructor
+     * @param   udp_fd The file descriptor of the UDP socket to send on
+     */
+    explicit ReflectorShard(int udp_fd);
+
+    /**
+     * @brief   Disallow copy construction
+     */
+    ReflectorShard(const ReflectorShard&) = delete;
+
+    /**
+     * @brief   Disallow copy assignment
+     */
+    ReflectorShard& operator=(const ReflectorShard&) = delete;
+
+    /**
+     * @brief   Destructor
+     *
+     * The worker thread is stopped after all queued datagrams have been sent.
+     */
+    ~ReflectorShard(void);
+
+    /**
+     * @brief   Start the worker thread
+     * @return  Returns \em true on success or else \em false
+     */
+    bool start(void) { return m_thread.start(); }
+
+    /**
+     * @brief   Queue a datagram
+     * @param   addr    The destination address
+     * @param   addr_len The length of the destination address
+     * @param   header  The packed message header
+     * @param   hdr_len The length of the header
+     * @param   payload The packed message payload
+     *
+     * The datagram is not handed over to the worker thread until flush is
+     * called. This function must only be called from the main thread.
+     */
+    void queue(const struct sockaddr *addr, socklen_t addr_len,
+               const void *header, size_t hdr_len, const Payload& payload);
+
+    /**
+     * @brief   Hand all queued datagrams over to the worker thread
+     *
+     * This function must only be called from the main thread.
+     */
+    void flush(void);
+
+  private:
+    static const size_t   MAX_HEADER_SIZE = 16;
+    static const unsigned SEND_BATCH_SIZE = 64;
+    static const int      SEND_WAIT_MS    = 10;
+
+    struct Datagram
+    {
+      struct sockaddr_in6 addr;
+      socklen_t           addr_len;
+      char                header[MAX_HEADER_SIZE];
+      size_t              hdr_len;
+      size_t              payload;
+    };
+
+    struct Job
+    {
+      std::vector<Datagram> datagrams;
+      std::vector<Payload>  payloads;
+    };
+    typedef std::shared_ptr<Job> JobPtr;
+
+    Async::CppEventLoopThread m_thread;
+    int                       m_fd;
+    JobPtr                    m_job;
+
+    void send(JobPtr job);
+
+};  /* class ReflectorShard */
+
+
+//} /* namespace */
+
+#endif /* REFLECTOR_SHARD_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
@@ -43,6 +43,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncTracepoint.h>
 
 
 /****************************************************************************
@@ -110,11 +111,8 @@ using namespace std;
  ****************************************************************************/
 
 TGHandler::TGHandler(void)
-  : m_cfg(0), m_timeout_timer(1000, Async::Timer::TYPE_PERIODIC),
-    m_sql_timeout(0), m_sql_timeout_blocktime(60)
+  : m_cfg(0), m_sql_timeout(0), m_sql_timeout_blocktime(60)
 {
-  m_timeout_timer.expired.connect(
-      mem_fun(*this, &TGHandler::checkTimers));
 } /* TGHandler::TGHandler */
 
 
@@ -155,6 +153,7 @@ bool TGHandler::switchTo(ReflectorClient *client, uint32_t tg)
     {
       return false;
     }
+    bool new_tg = false;
     IdMap::iterator id_map_it = m_id_map.find(tg);
     if (id_map_it != m_id_map.end())
     {
@@ -163,6 +162,8 @@ bool TGHandler::switchTo(ReflectorClient *client, uint32_t tg)
     else
     {
       tg_info = new TGInfo(tg);
+      tg_info->timeout_timer.expired.connect(sigc::bind(
+          mem_fun(*this, &TGHandler::checkTalkerTimeout), tg_info));
       std::ostringstream ss;
       ss << "TG#" << tg;
       m_cfg->getValue(ss.str(), "AUTO_QSY_AFTER", tg_info->auto_qsy_after_s);
@@ -171,9 +172,14 @@ bool TGHandler::switchTo(ReflectorClient *client, uint32_t tg)
         tg_info->auto_qsy_time = time(NULL) + tg_info->auto_qsy_after_s;
       }
       m_id_map[tg] = tg_info;
+      new_tg = true;
     }
     tg_info->clients.insert(client);
     m_client_map[client] = tg_info;
+    if (new_tg)
+    {
+      activeTGsChanged();
+    }
   }
 
   //printTGStatus();
@@ -195,6 +201,7 @@ void TGHandler::removeClient(ReflectorClient* client)
     removeClientP(tg_info, client);
     //printTGStatus();
   }
+  setMonitoredTGs(client, std::set<uint32_t>());
 } /* TGHandler::removeClient */
 
 
@@ -210,6 +217,56 @@ const TGHandler::ClientSet& TGHandler::clientsForTG(uint32_t tg) const
 } /* TGHandler::clientsForTG */
 
 
+void TGHandler::activeTGs(std::set<uint32_t>& tgs) const
+{
+  tgs.clear();
+  for (IdMap::const_iterator it = m_id_map.begin(); it != m_id_map.end(); ++it)
+  {
+    tgs.insert(tgs.end(), it->first);
+  }
+} /* TGHandler::activeTGs */
+
+
+void TGHandler::setMonitoredTGs(ReflectorClient* client,
+                                const std::set<uint32_t>& tgs)
+{
+  const ReflectorClient::TgList& old_tgs = client->monitoredTGs();
+  for (ReflectorClient::TgList::const_iterator it = old_tgs.begin();
+       it != old_tgs.end(); ++it)
+  {
+    if (tgs.count(*it) == 0)
+    {
+      MonitorMap::iterator mit = m_monitor_map.find(*it);
+      if (mit != m_monitor_map.end())
+      {
+        mit->second.erase(client);
+        if (mit->second.empty())
+        {
+          m_monitor_map.erase(mit);
+        }
+      }
+    }
+  }
+  for (std::set<uint32_t>::const_iterator it = tgs.begin();
+       it != tgs.end(); ++it)
+  {
+    m_monitor_map[*it].insert(client);
+  }
+} /* TGHandler::setMonitoredTGs */
+
+
+const TGHandler::ClientSet& TGHandler::monitorsForTG(uint32_t tg) const
+{
+  static const TGHandler::ClientSet empty_set;
+  MonitorMap::const_iterator it = m_monitor_map.find(tg);
+  if (it == m_monitor_map.end())
+  {
+    return empty_set;
+  }
+  return it->second;
+} /* TGHandler::monitorsForTG */
+
+
 void TGHandler::setTalkerForTG(uint32_t tg, ReflectorClient* new_talker)
 {
   IdMap::const_iterator id_map_it = m_id_map.find(tg);
@@ -219,13 +276,41 @@ void TGHandler::setTalkerForTG(uint32_t tg, ReflectorClient* new_talker)
   }
   TGInfo* tg_info = id_map_it->second;
   ReflectorClient* old_talker = tg_info->talker;
+  gettimeofday(&tg_info->last_talker_timestamp, NULL);
   if (new_talker == old_talker)
   {
-    gettimeofday(&tg_info->last_talker_timestamp, NULL);
+      // The timeout timer is not touched for every audio frame. When it
+      // expire, it is rescheduled using the latest timestamp.
     return;
   }
-  tg_info->sql_timeout_cnt = (new_talker != 0) ? m_sql_timeout : 0;
-  id_map_it->second->talker = new_talker;
+  ASYNC_TRACEPOINT(svxreflector, talker_change, tg,
+                   (old_talker != 0) ? old_talker->callsign().c_str() : "",
+                   (new_talker != 0) ? new_talker->callsign().c_str() : "");
+  if (old_talker != 0)
+  {
+    addTalkerTime(tg_info);
+  }
+  if (new_talker != 0)
+  {
+    tg_info->talker_start = tg_info->last_talker_timestamp;
+    tgStats(tg).talker_sessions += 1;
+  }
+  timerclear(&tg_info->sql_timeout_deadline);
+  if ((new_talker != 0) && (m_sql_timeout > 0))
+  {
+    struct timeval sql_timeout = { static_cast<time_t>(m_sql_timeout), 0 };
+    timeradd(&tg_info->last_talker_timestamp, &sql_timeout,
+             &tg_info->sql_timeout_deadline);
+  }
+  tg_info->talker = new_talker;
+  if (new_talker != 0)
+  {
+    scheduleTalkerTimeout(tg_info);
+  }
+  else
+  {
+    tg_info->timeout_timer.setEnable(false);
+  }
   talkerUpdated(tg, old_talker, new_talker);
 
   time_t now = time(NULL);
@@ -239,6 +324,26 @@ void TGHandler::setTalkerForTG(uint32_t tg, ReflectorClient* new_talker)
 } /* TGHandler::setTalkerForTG */
 
 
+void TGHandler::updateAutoQsyAfter(uint32_t tg)
+{
+  IdMap::iterator id_map_it = m_id_map.find(tg);
+  if (id_map_it == m_id_map.end())
+  {
+    return;
+  }
+  TGInfo *tg_info = id_map_it->second;
+  std::ostringstream ss;
+  ss << "TG#" << tg;
+  tg_info->auto_qsy_after_s = 0;
+  m_cfg->getValue(ss.str(), "AUTO_QSY_AFTER", tg_info->auto_qsy_after_s);
+  tg_info->auto_qsy_time = -1;
+  if (tg_info->auto_qsy_after_s > 0)
+  {
+    tg_info->auto_qsy_time = time(NULL) + tg_info->auto_qsy_after_s;
+  }
+} /* TGHandler::updateAutoQsyAfter */
+
+
 ReflectorClient* TGHandler::talkerForTG(uint32_t tg) const
 {
   IdMap::const_iterator id_map_it = m_id_map.find(tg);
@@ -301,43 +406,75 @@ bool TGHandler::allowTgSelection(ReflectorClient *client, uint32_t tg)
  *
  ****************************************************************************/
 
-void TGHandler::checkTimers(Async::Timer *t)
+void TGHandler::checkTalkerTimeout(Async::Timer *t, TGInfo *tg_info)
 {
-  for (IdMap::iterator it = m_id_map.begin(); it != m_id_map.end(); ++it)
+  assert(tg_info != 0);
+  if (tg_info->talker == 0)
   {
-    struct timeval now;
-    gettimeofday(&now, NULL);
+    return;
+  }
 
-    TGInfo *tg_info = it->second;
-    assert(tg_info != 0);
-    if (tg_info->talker != 0)
-    {
-      struct timeval diff;
-      timersub(&now, &tg_info->last_talker_timestamp, &diff);
-      if (diff.tv_sec > TALKER_AUDIO_TIMEOUT)
-      {
-        cout << tg_info->talker->callsign() << ": Talker audio timeout on TG #"
-             << tg_info->id << endl;
-        setTalkerForTG(tg_info->id, 0);
-      }
+  struct timeval now;
+  gettimeofday(&now, NULL);
 
-      if ((tg_info->sql_timeout_cnt > 0) && (--tg_info->sql_timeout_cnt == 0))
-      {
-        cout << tg_info->talker->callsign() << ": Talker audio timeout on TG #"
-             << tg_info->id << endl;
-        tg_info->talker->setBlock(m_sql_timeout_blocktime);
-        setTalkerForTG(tg_info->id, 0);
-      }
-    }
+    // Note that the TGInfo object may be deleted when the talker is reset so
+    // it must not be touched after the calls to setTalkerForTG.
+  struct timeval diff;
+  timersub(&now, &tg_info->last_talker_timestamp, &diff);
+  if (diff.tv_sec >= TALKER_AUDIO_TIMEOUT)
+  {
+    cout << tg_info->talker->callsign() << ": Talker audio timeout on TG #"
+         << tg_info->id << endl;
+    setTalkerForTG(tg_info->id, 0);
+    return;
+  }
+
+  if (timerisset(&tg_info->sql_timeout_deadline) &&
+      !timercmp(&now, &tg_info->sql_timeout_deadline, <))
+  {
+    cout << tg_info->talker->callsign() << ": Talker audio timeout on TG #"
+         << tg_info->id << endl;
+    tg_info->talker->setBlock(m_sql_timeout_blocktime);
+    setTalkerForTG(tg_info->id, 0);
+    return;
+  }
+
+    // Audio have been received since the timer was started
+  scheduleTalkerTimeout(tg_info);
+} /* TGHandler::checkTalkerTimeout */
 
-    //if ((tg_info->auto_qsy_time > 0) &&
-    //    (now.tv_sec > tg_info->auto_qsy_time))
-    //{
-    //  requestAutoQsy(tg_info->id);
-    //  tg_info->auto_qsy_time = time(NULL) + tg_info->auto_qsy_after_s;
-    //}
+
+void TGHandler::scheduleTalkerTimeout(TGInfo *tg_info)
+{
+  struct timeval audio_timeout = { TALKER_AUDIO_TIMEOUT, 0 };
+  struct timeval deadline;
+  timeradd(&tg_info->last_talker_timestamp, &audio_timeout, &deadline);
+  if (timerisset(&tg_info->sql_timeout_deadline) &&
+      timercmp(&tg_info->sql_timeout_deadline, &deadline, <))
+  {
+    deadline = tg_info->sql_timeout_deadline;
   }
-} /* TGHandler::checkTimers */
+
+  struct timeval now, diff;
+  gettimeofday(&now, NULL);
+  int timeout_ms = 0;
+  if (timercmp(&deadline, &now, >))
+  {
+    timersub(&deadline, &now, &diff);
+    timeout_ms = diff.tv_sec * 1000 + (diff.tv_usec + 999) / 1000;
+  }
+  tg_info->timeout_timer.setTimeout(timeout_ms);
+  tg_info->timeout_timer.setEnable(true);
+} /* TGHandler::scheduleTalkerTimeout */
+
+
+void TGHandler::addTalkerTime(TGInfo *tg_info)
+{
+  struct timeval now, diff;
+  gettimeofday(&now, NULL);
+  timersub(&now, &tg_info->talker_start, &diff);
+  tgStats(tg_info->id).talker_time += diff.tv_sec + diff.tv_usec / 1000000.0;
+} /* TGHandler::addTalkerTime */
 
 
 void TGHandler::removeClientP(TGInfo *tg_info, ReflectorClient* client)
@@ -346,7 +483,9 @@ void TGHandler::removeClientP(TGInfo *tg_info, ReflectorClient* client)
   assert(client != 0);
   if (client == tg_info->talker)
   {
+    addTalkerTime(tg_info);
     tg_info->talker = 0;
+    tg_info->timeout_timer.setEnable(false);
   }
   tg_info->clients.erase(client);
   m_client_map.erase(client);
@@ -354,6 +493,7 @@ void TGHandler::removeClientP(TGInfo *tg_info, ReflectorClient* client)
   {
     m_id_map.erase(tg_info->id);
     delete tg_info;
+    activeTGsChanged();
   }
 } /* TGHandler::removeClientP */
 
@@ -36,6 +36,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <sigc++/sigc++.h>
 #include <sys/time.h>
 
@@ -47,6 +49,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncConfig.h>
+#include <AsyncTimer.h>
 
 
 /****************************************************************************
@@ -113,11 +116,34 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 This class is responsible for keeping track of all talk groups that are used in
 the system.
+
+The talk groups and the client memberships are stored in hash tables since
+they are looked up for every received audio frame. Talker timeouts are handled
+using one timer per talk group that is only armed while the talk group have a
+talker, so idle talk groups cost nothing.
 */
 class TGHandler : public sigc::trackable
 {
   public:
-    typedef std::set<ReflectorClient*> ClientSet;
+    typedef std::unordered_set<ReflectorClient*> ClientSet;
+
+      // Traffic counters for a talk group. They are kept for every talk
+      // group that has been used, also after the last client has left, so
+      // that they can be exported as monotonic counters.
+    struct TGStats
+    {
+      uint64_t  audio_rx_frames;
+      uint64_t  audio_rx_bytes;
+      uint64_t  audio_tx_frames;
+      uint64_t  audio_tx_bytes;
+      uint64_t  talker_sessions;
+      double    talker_time;        // Seconds
+
+      TGStats(void)
+        : audio_rx_frames(0), audio_rx_bytes(0), audio_tx_frames(0),
+          audio_tx_bytes(0), talker_sessions(0), talker_time(0.0) {}
+    };
+    typedef std::map<uint32_t, TGStats> TGStatsMap;
 
     static TGHandler* instance(void)
     {
@@ -146,18 +172,65 @@ class TGHandler : public sigc::trackable
 
     void setSqlTimeoutBlocktime(unsigned sql_timeout_blocktime);
 
+    /**
+     * @brief   Reread the AUTO_QSY_AFTER configuration for a talk group
+     * @param   tg The talk group
+     *
+     * This function is called when the configuration variable has been
+     * changed. New talk groups read the variable when they are created so
+     * only an already active talk group need to be updated.
+     */
+    void updateAutoQsyAfter(uint32_t tg);
+
     bool switchTo(ReflectorClient *client, uint32_t tg);
 
     void removeClient(ReflectorClient* client);
 
     const ClientSet& clientsForTG(uint32_t tg) const;
 
+    /**
+     * @brief   Get all talk groups that have at least one client
+     * @param   tgs The set to return the talk groups in
+     */
+    void activeTGs(std::set<uint32_t>& tgs) const;
+
+    /**
+     * @brief   Update the set of talk groups monitored by a client
+     * @param   client  The client
+     * @param   tgs     The new set of monitored talk groups
+     *
+     * This function must be called before the set of monitored talk groups
+     * is updated in the client object since the old set is read from there.
+     */
+    void setMonitoredTGs(ReflectorClient* client,
+                         const std::set<uint32_t>& tgs);
+
+    /**
+     * @brief   Get the clients monitoring a talk group
+     * @param   tg The talk group
+     * @return  Returns the set of clients monitoring the given talk group
+     */
+    const ClientSet& monitorsForTG(uint32_t tg) const;
+
     void setTalkerForTG(uint32_t tg, ReflectorClient* client);
 
     ReflectorClient* talkerForTG(uint32_t tg) const;
 
     uint32_t TGForClient(ReflectorClient* client);
 
+    /**
+     * @brief   Get the traffic counters for a talk group
+     * @param   tg The talk group
+     * @return  Returns the counters, which are created if needed
+     */
+    TGStats& tgStats(uint32_t tg) { return m_tg_stats[tg]; }
+
+    /**
+     * @brief   Get the traffic counters for all talk groups
+     * @return  Returns the counters for all talk groups that have been used
+     */
+    const TGStatsMap& allTGStats(void) const { return m_tg_stats; }
+
     bool allowTgSelection(ReflectorClient *client, uint32_t tg);
 
     sigc::signal<void, uint32_t,
@@ -165,6 +238,14 @@ class TGHandler : public sigc::trackable
 
     sigc::signal<void, uint32_t> requestAutoQsy;
 
+    /**
+     * @brief   A signal that is emitted when the set of active TGs change
+     *
+     * The signal is emitted when the first client select a talk group and
+     * when the last client leave it. Use activeTGs to get the new set.
+     */
+    sigc::signal<void> activeTGsChanged;
+
   private:
     static const time_t TALKER_AUDIO_TIMEOUT = 3; // Max three seconds gap
 
@@ -174,30 +255,38 @@ class TGHandler : public sigc::trackable
       ClientSet         clients;
       ReflectorClient*  talker;
       struct timeval    last_talker_timestamp;
-      unsigned          sql_timeout_cnt;
+      struct timeval    talker_start;
+      struct timeval    sql_timeout_deadline;
       time_t            auto_qsy_after_s;
       time_t            auto_qsy_time;
+      Async::Timer      timeout_timer;
 
       TGInfo(uint32_t tg)
-        : id(tg), talker(0), sql_timeout_cnt(0), auto_qsy_after_s(0),
-          auto_qsy_time(-1)
+        : id(tg), talker(0), auto_qsy_after_s(0), auto_qsy_time(-1),
+          timeout_timer(0, Async::Timer::TYPE_ONESHOT, false)
       {
         timerclear(&last_talker_timestamp);
+        timerclear(&talker_start);
+        timerclear(&sql_timeout_deadline);
       }
     };
-    typedef std::map<uint32_t, TGInfo*>               IdMap;
-    typedef std::map<const ReflectorClient*, TGInfo*> ClientMap;
+    typedef std::unordered_map<uint32_t, TGInfo*>               IdMap;
+    typedef std::unordered_map<const ReflectorClient*, TGInfo*> ClientMap;
+    typedef std::unordered_map<uint32_t, ClientSet>             MonitorMap;
 
     const Async::Config*  m_cfg;
     IdMap                 m_id_map;
     ClientMap             m_client_map;
-    Async::Timer          m_timeout_timer;
+    MonitorMap            m_monitor_map;
+    TGStatsMap            m_tg_stats;
     unsigned              m_sql_timeout;
     unsigned              m_sql_timeout_blocktime;
 
     TGHandler(const TGHandler&);
     TGHandler& operator=(const TGHandler&);
-    void checkTimers(Async::Timer *t);
+    void checkTalkerTimeout(Async::Timer *t, TGInfo *tg_info);
+    void scheduleTalkerTimeout(TGInfo *tg_info);
+    void addTalkerTime(TGInfo *tg_info);
     void removeClientP(TGInfo *tg_info, ReflectorClient* client);
     void printTGStatus(void);
 };  /* class TGHandler */
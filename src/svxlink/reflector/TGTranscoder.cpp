@@ -0,0 +1,255 @@
+/**
+@file   TGTranscoder.cpp
+@brief  Transcode the audio from a talker to the codecs used on a talk group
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <list>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncConfig.h>
+#include <AsyncAudioDecoder.h>
+#include <AsyncAudioEncoder.h>
+#include <AsyncAudioSplitter.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "TGTranscoder.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+bool TGTranscoder::codecIsAvailable(const std::string& codec)
+{
+  return AudioEncoder::isAvailable(codec) && AudioDecoder::isAvailable(codec);
+} /* TGTranscoder::codecIsAvailable */
+
+
+TGTranscoder::TGTranscoder(Async::Config &cfg, uint32_t tg,
+                           const std::string& src_codec)
+  : m_cfg(cfg), m_tg(tg), m_src_codec(src_codec), m_dec(0), m_splitter(0)
+{
+  m_dec = AudioDecoder::create(src_codec);
+  if (m_dec == 0)
+  {
+    cerr << "*** ERROR: Failed to initialize " << src_codec
+         << " audio decoder for transcoding on TG #" << tg << endl;
+    return;
+  }
+  setCodecOptions(m_dec, "_DEC_");
+  m_splitter = new AudioSplitter;
+  m_dec->registerSink(m_splitter, false);
+} /* TGTranscoder::TGTranscoder */
+
+
+TGTranscoder::~TGTranscoder(void)
+{
+  if (m_dec != 0)
+  {
+    m_dec->unregisterSink();
+    delete m_dec;
+  }
+  delete m_splitter;
+  for (EncoderMap::iterator it = m_encoders.begin();
+       it != m_encoders.end(); ++it)
+  {
+    delete it->second;
+  }
+} /* TGTranscoder::~TGTranscoder */
+
+
+void TGTranscoder::writeEncodedAudio(const void *buf, int len,
+                                     const std::set<std::string>& codecs)
+{
+  if (m_dec == 0)
+  {
+    return;
+  }
+  for (std::set<std::string>::const_iterator it = codecs.begin();
+       it != codecs.end(); ++it)
+  {
+    if ((*it != m_src_codec) && (m_encoders.count(*it) == 0))
+    {
+      addEncoder(*it);
+    }
+  }
+  if (m_encoders.empty())
+  {
+    return;
+  }
+  m_dec->writeEncodedSamples(const_cast<void*>(buf), len);
+} /* TGTranscoder::writeEncodedAudio */
+
+
+void TGTranscoder::flush(void)
+{
+  if (m_dec != 0)
+  {
+    m_dec->flushEncodedSamples();
+  }
+} /* TGTranscoder::flush */
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+Async::AudioEncoder* TGTranscoder::addEncoder(const std::string& codec)
+{
+    // A null pointer is stored on failure so that we do not retry for every
+    // audio frame
+  AudioEncoder *enc = AudioEncoder::create(codec);
+  m_encoders[codec] = enc;
+  if (enc == 0)
+  {
+    cerr << "*** ERROR: Failed to initialize " << codec
+         << " audio encoder for transcoding on TG #" << m_tg << endl;
+    return 0;
+  }
+  setCodecOptions(enc, "_ENC_");
+  enc->writeEncodedSamples.connect(sigc::bind(
+      mem_fun(*this, &TGTranscoder::onEncodedSamples), codec));
+  enc->flushEncodedSamples.connect(sigc::bind(
+      mem_fun(*this, &TGTranscoder::onEncoderFlushed), enc));
+  m_splitter->addSink(enc, false);
+  return enc;
+} /* TGTranscoder::addEncoder */
+
+
+void TGTranscoder::onEncodedSamples(const void *buf, int len,
+                                    std::string codec)
+{
+  audioEncoded(m_tg, codec, buf, len);
+} /* TGTranscoder::onEncodedSamples */
+
+
+void TGTranscoder::onEncoderFlushed(Async::AudioEncoder *enc)
+{
+    // The flush is complete as soon as the last frame has been emitted
+  enc->allEncodedSamplesFlushed();
+} /* TGTranscoder::onEncoderFlushed */
+
+
+template <class Codec>
+void TGTranscoder::setCodecOptions(Codec *codec, const std::string& suffix)
+{
+  std::string opt_prefix = std::string(codec->name()) + suffix;
+  std::list<std::string> names = m_cfg.listSection("GLOBAL");
+  for (std::list<std::string>::const_iterator it = names.begin();
+       it != names.end(); ++it)
+  {
+    if ((*it).find(opt_prefix) == 0)
+    {
+      std::string opt_value;
+      m_cfg.getValue("GLOBAL", *it, opt_value);
+      codec->setOption((*it).substr(opt_prefix.size()), opt_value);
+    }
+  }
+} /* TGTranscoder::setCodecOptions */
+
+
+/*
+ * This file has not been truncated
+ */
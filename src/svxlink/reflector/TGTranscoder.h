@@ -0,0 +1,231 @@
+/**
+@file   TGTranscoder.h
+@brief  Transcode the audio from a talker to the codecs used on a talk group
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef TG_TRANSCODER_INCLUDED
+#define TG_TRANSCODER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+#include <stdint.h>
+
+#include <string>
+#include <map>
+#include <set>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class Config;
+  class AudioDecoder;
+  class AudioEncoder;
+  class AudioSplitter;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  Transcode the audio from a talker to the codecs used on a talk group
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+One object of this class is created for a talk group when the talker use
+another codec than some of the other clients on the talk group. The audio
+from the talker is decoded once and then encoded once for each target codec.
+The encoded audio is emitted using the audioEncoded signal so that it can be
+sent to all clients using that codec. The object only live for one talker
+session. It should be flushed and deleted when the talker stop.
+
+Codec options are read from the GLOBAL configuration section, using the same
+naming as in the ReflectorLogic configuration, e.g. OPUS_ENC_BITRATE.
+*/
+class TGTranscoder : public sigc::trackable
+{
+  public:
+    /**
+     * @brief   Check if a codec can be used for transcoding
+     * @param   codec The name of the codec
+     * @return  Returns \em true if both an encoder and a decoder exist
+     */
+    static bool codecIsAvailable(const std::string& codec);
+
+    /**
+     * @brief   Constructor
+     * @param   cfg       The configuration object to read codec options from
+     * @param   tg        The talk group
+     * @param   src_codec The codec used by the talker
+     */
+    TGTranscoder(Async::Config &cfg, uint32_t tg, const std::string& src_codec);
+
+    /**
+     * @brief   Destructor
+     */
+    ~TGTranscoder(void);
+
+    /**
+     * @brief   Check if the transcoder was successfully set up
+     * @return  Returns \em true if the source codec decoder was created
+     */
+    bool initOk(void) const { return m_dec != 0; }
+
+    /**
+     * @brief   Get the talk group for this transcoder
+     * @return  Returns the talk group
+     */
+    uint32_t tg(void) const { return m_tg; }
+
+    /**
+     * @brief   Get the codec used by the talker
+     * @return  Returns the name of the source codec
+     */
+    const std::string& srcCodec(void) const { return m_src_codec; }
+
+    /**
+     * @brief   Transcode a frame of encoded audio from the talker
+     * @param   buf   The encoded audio
+     * @param   len   The number of bytes in the buffer
+     * @param   codecs The codecs to encode the audio to
+     *
+     * An encoder is created the first time a target codec is seen. Codecs
+     * that are not in the given set are still encoded to, once created, so
+     * that the encoder state stay continuous if a client leave and rejoin
+     * during the talker session.
+     */
+    void writeEncodedAudio(const void *buf, int len,
+                           const std::set<std::string>& codecs);
+
+    /**
+     * @brief   Flush all buffered audio
+     *
+     * The remaining audio of all encoders is emitted using the audioEncoded
+     * signal before this function return.
+     */
+    void flush(void);
+
+    /**
+     * @brief   A signal that is emitted when a frame of audio has been encoded
+     * @param   tg    The talk group
+     * @param   codec The name of the codec
+     * @param   buf   The encoded audio
+     * @param   len   The number of bytes in the buffer
+     */
+    sigc::signal<void, uint32_t, const std::string&, const void*, int>
+      audioEncoded;
+
+  private:
+    typedef std::map<std::string, Async::AudioEncoder*> EncoderMap;
+
+    Async::Config&        m_cfg;
+    uint32_t              m_tg;
+    std::string           m_src_codec;
+    Async::AudioDecoder*  m_dec;
+    Async::AudioSplitter* m_splitter;
+    EncoderMap            m_encoders;
+
+    TGTranscoder(const TGTranscoder&);
+    TGTranscoder& operator=(const TGTranscoder&);
+    Async::AudioEncoder* addEncoder(const std::string& codec);
+    void onEncodedSamples(const void *buf, int len, std::string codec);
+    void onEncoderFlushed(Async::AudioEncoder *enc);
+    template <class Codec>
+    void setCodecOptions(Codec *codec, const std::string& suffix);
+
+};  /* class TGTranscoder */
+
+
+//} /* namespace */
+
+#endif /* TG_TRANSCODER_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
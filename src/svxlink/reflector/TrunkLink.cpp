@@ -0,0 +1,566 @@
+/**
+@file   TrunkLink.cpp
+@brief  A trunk link to another reflector instance
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <cerrno>
+#include <sstream>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncConfig.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "TrunkLink.h"
+#include "ReflectorClient.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+TrunkLink::TrunkLink(Async::Config &cfg, const std::string& name,
+                     const std::string& local_id)
+  : m_cfg(cfg), m_name(name), m_local_id(local_id), m_port(5302),
+    m_client(0), m_con(0), m_state(STATE_DISCONNECTED),
+    m_heartbeat_timer(1000, Timer::TYPE_PERIODIC, false),
+    m_reconnect_timer(RECONNECT_INTERVAL, Timer::TYPE_ONESHOT, false),
+    m_heartbeat_tx_cnt(0), m_heartbeat_rx_cnt(0)
+{
+  m_heartbeat_timer.expired.connect(
+      mem_fun(*this, &TrunkLink::handleHeartbeat));
+  m_reconnect_timer.expired.connect(mem_fun(*this, &TrunkLink::connect));
+} /* TrunkLink::TrunkLink */
+
+
+TrunkLink::~TrunkLink(void)
+{
+    // An incoming connection is owned by the trunk server so it must be
+    // closed here, or it would be left calling into a deleted object
+  if ((m_con != 0) && (m_con != m_client))
+  {
+    m_con->clearFrameHandler();
+    disconnect();
+  }
+  delete m_client;
+  m_client = 0;
+} /* TrunkLink::~TrunkLink */
+
+
+bool TrunkLink::initialize(void)
+{
+  if (!m_cfg.getValue(m_name, "PEER_ID", m_peer_id) || m_peer_id.empty())
+  {
+    cerr << "*** ERROR: " << m_name << "/PEER_ID missing in configuration"
+         << endl;
+    return false;
+  }
+  if (m_peer_id == m_local_id)
+  {
+    cerr << "*** ERROR: " << m_name << "/PEER_ID must not be the same as "
+         << "GLOBAL/TRUNK_ID" << endl;
+    return false;
+  }
+  if (!m_cfg.getValue(m_name, "SECRET", m_secret) || m_secret.empty())
+  {
+    cerr << "*** ERROR: " << m_name << "/SECRET missing in configuration"
+         << endl;
+    return false;
+  }
+  m_cfg.getValue(m_name, "PORT", m_port);
+
+  if (m_cfg.getValue(m_name, "HOST", m_host) && !m_host.empty())
+  {
+    connect();
+  }
+
+  return true;
+} /* TrunkLink::initialize */
+
+
+bool TrunkLink::acceptConnection(Async::FramedTcpConnection *con,
+                                 const MsgTrunkHello& hello)
+{
+  assert(hello.id() == m_peer_id);
+  if (hello.challenge() == 0)
+  {
+    cerr << "*** WARNING[" << m_name << "]: Malformed trunk hello from "
+         << con->remoteHost() << ":" << con->remotePort() << endl;
+    return false;
+  }
+
+  if (m_con != 0)
+  {
+      // Both sides connected at the same time. Keep the connection initiated
+      // by the reflector with the lowest id.
+    if ((m_con == m_client) && (m_local_id < m_peer_id))
+    {
+      return false;
+    }
+    cout << m_name << ": Replacing trunk connection to " << m_peer_id << endl;
+    disconnect();
+  }
+
+  cout << m_name << ": Incoming trunk connection from " << m_peer_id
+       << " at " << con->remoteHost() << ":" << con->remotePort() << endl;
+  m_con = con;
+  m_con->setFrameHandler<TrunkLink, &TrunkLink::onFrameReceived>(this);
+  m_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+  m_heartbeat_rx_cnt = HEARTBEAT_RX_CNT_RESET;
+  m_heartbeat_timer.setEnable(true);
+  sendHello();
+  sendAuthResponse(hello.challenge());
+  m_state = STATE_EXPECT_AUTH;
+  return true;
+} /* TrunkLink::acceptConnection */
+
+
+void TrunkLink::connectionClosed(Async::FramedTcpConnection *con,
+                     Async::FramedTcpConnection::DisconnectReason reason)
+{
+  if (con != m_con)
+  {
+    return;
+  }
+
+  cout << m_name << ": Trunk connection to " << m_peer_id << " closed: "
+       << TcpConnection::disconnectReasonStr(reason) << endl;
+
+  bool was_up = (m_state == STATE_UP);
+  m_con = 0;
+  m_state = STATE_DISCONNECTED;
+  m_peer_tgs.clear();
+  m_heartbeat_timer.setEnable(false);
+  if (m_client != 0)
+  {
+    m_reconnect_timer.setEnable(true);
+  }
+  if (was_up)
+  {
+    linkStateChanged(this, false);
+  }
+} /* TrunkLink::connectionClosed */
+
+
+int TrunkLink::sendMsg(const ReflectorMsg& msg)
+{
+  if (m_state != STATE_UP)
+  {
+    errno = ENOTCONN;
+    return -1;
+  }
+  return sendMsgP(msg);
+} /* TrunkLink::sendMsg */
+
+
+int TrunkLink::sendFrame(Async::FramedTcpConnection::Frame *frame)
+{
+  if (m_state != STATE_UP)
+  {
+    errno = ENOTCONN;
+    return -1;
+  }
+  m_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+  return m_con->write(frame);
+} /* TrunkLink::sendFrame */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void TrunkLink::connect(Async::Timer *t)
+{
+  if (m_con != 0)
+  {
+    return;
+  }
+
+  cout << m_name << ": Connecting to trunk peer " << m_peer_id << " at "
+       << m_host << ":" << m_port << endl;
+  delete m_client;
+  m_client = new FramedTcpClient(m_host, m_port);
+  m_client->connected.connect(mem_fun(*this, &TrunkLink::onConnected));
+  m_client->disconnected.connect(mem_fun(*this, &TrunkLink::onDisconnected));
+  m_client->setFrameHandler<TrunkLink, &TrunkLink::onFrameReceived>(this);
+  m_client->setMaxFrameSize(MAX_PREAUTH_FRAME_SIZE);
+  m_con = m_client;
+  m_client->connect();
+} /* TrunkLink::connect */
+
+
+void TrunkLink::onConnected(void)
+{
+  cout << m_name << ": Trunk connection established to "
+       << m_client->remoteHost() << ":" << m_client->remotePort() << endl;
+  m_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+  m_heartbeat_rx_cnt = HEARTBEAT_RX_CNT_RESET;
+  m_heartbeat_timer.setEnable(true);
+  sendHello();
+  m_state = STATE_EXPECT_HELLO;
+} /* TrunkLink::onConnected */
+
+
+void TrunkLink::onDisconnected(Async::FramedTcpConnection *con,
+                   Async::FramedTcpConnection::DisconnectReason reason)
+{
+  if (con != m_con)
+  {
+      // A connection attempt that was superseded by an incoming connection
+    return;
+  }
+  connectionClosed(con, reason);
+} /* TrunkLink::onDisconnected */
+
+
+void TrunkLink::onFrameReceived(Async::FramedTcpConnection *con,
+                                Async::DataView data)
+{
+  if ((con != m_con) || (m_state == STATE_DISCONNECTED))
+  {
+    return;
+  }
+
+  Async::MsgUnpackBuffer ub(data.data(), data.size());
+
+  ReflectorMsg header;
+  if (!header.unpack(ub))
+  {
+    cerr << "*** WARNING[" << m_name
+         << "]: Unpacking failed for trunk message header" << endl;
+    disconnect();
+    return;
+  }
+
+  m_heartbeat_rx_cnt = HEARTBEAT_RX_CNT_RESET;
+
+  switch (header.type())
+  {
+    case MsgHeartbeat::TYPE:
+      break;
+    case MsgTrunkHello::TYPE:
+      handleMsgTrunkHello(ub);
+      break;
+    case MsgAuthResponse::TYPE:
+      handleMsgAuthResponse(ub);
+      break;
+    case MsgTrunkSubscribe::TYPE:
+      handleMsgTrunkSubscribe(ub);
+      break;
+    case MsgTrunkTalkerStart::TYPE:
+      handleMsgTrunkTalkerStart(ub);
+      break;
+    case MsgTrunkTalkerStop::TYPE:
+      handleMsgTrunkTalkerStop(ub);
+      break;
+    case MsgTrunkAudio::TYPE:
+      handleMsgTrunkAudio(ub);
+      break;
+    default:
+        // Ignore unknown messages to make it possible to extend the protocol
+      break;
+  }
+} /* TrunkLink::onFrameReceived */
+
+
+void TrunkLink::handleMsgTrunkHello(Async::MsgUnpackBuffer& is)
+{
+  if (m_state != STATE_EXPECT_HELLO)
+  {
+    cerr << "*** WARNING[" << m_name << "]: Unexpected trunk hello" << endl;
+    disconnect();
+    return;
+  }
+  MsgTrunkHello msg;
+  if (!msg.unpack(is) || (msg.challenge() == 0))
+  {
+    cerr << "*** WARNING[" << m_name
+         << "]: Could not unpack MsgTrunkHello" << endl;
+    disconnect();
+    return;
+  }
+  if (msg.id() != m_peer_id)
+  {
+    cerr << "*** WARNING[" << m_name << "]: Trunk peer identified itself as "
+         << msg.id() << ". Expected " << m_peer_id << "." << endl;
+    disconnect();
+    return;
+  }
+  sendAuthResponse(msg.challenge());
+  m_state = STATE_EXPECT_AUTH;
+} /* TrunkLink::handleMsgTrunkHello */
+
+
+void TrunkLink::handleMsgAuthResponse(Async::MsgUnpackBuffer& is)
+{
+  if (m_state != STATE_EXPECT_AUTH)
+  {
+    cerr << "*** WARNING[" << m_name
+         << "]: Unexpected trunk authentication response" << endl;
+    disconnect();
+    return;
+  }
+  MsgAuthResponse msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** WARNING[" << m_name
+         << "]: Could not unpack trunk MsgAuthResponse" << endl;
+    disconnect();
+    return;
+  }
+  if ((msg.callsign() != m_peer_id) ||
+      !msg.verify(m_secret, m_hello.challenge()))
+  {
+    cerr << "*** WARNING[" << m_name
+         << "]: Trunk authentication failed for peer " << m_peer_id << endl;
+    disconnect();
+    return;
+  }
+
+  cout << m_name << ": Trunk link to " << m_peer_id << " is up" << endl;
+  m_con->setMaxFrameSize(ReflectorMsg::MAX_POSTAUTH_FRAME_SIZE);
+  m_state = STATE_UP;
+  linkStateChanged(this, true);
+} /* TrunkLink::handleMsgAuthResponse */
+
+
+void TrunkLink::handleMsgTrunkSubscribe(Async::MsgUnpackBuffer& is)
+{
+  if (m_state != STATE_UP)
+  {
+    return;
+  }
+  MsgTrunkSubscribe msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** WARNING[" << m_name
+         << "]: Could not unpack MsgTrunkSubscribe" << endl;
+    disconnect();
+    return;
+  }
+  m_peer_tgs = msg.tgs();
+} /* TrunkLink::handleMsgTrunkSubscribe */
+
+
+void TrunkLink::handleMsgTrunkTalkerStart(Async::MsgUnpackBuffer& is)
+{
+  if (m_state != STATE_UP)
+  {
+    return;
+  }
+  MsgTrunkTalkerStart msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** WARNING[" << m_name
+         << "]: Could not unpack MsgTrunkTalkerStart" << endl;
+    disconnect();
+    return;
+  }
+  talkerStartReceived(this, msg.tg(), msg.callsign());
+} /* TrunkLink::handleMsgTrunkTalkerStart */
+
+
+void TrunkLink::handleMsgTrunkTalkerStop(Async::MsgUnpackBuffer& is)
+{
+  if (m_state != STATE_UP)
+  {
+    return;
+  }
+  MsgTrunkTalkerStop msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** WARNING[" << m_name
+         << "]: Could not unpack MsgTrunkTalkerStop" << endl;
+    disconnect();
+    return;
+  }
+  talkerStopReceived(this, msg.tg());
+} /* TrunkLink::handleMsgTrunkTalkerStop */
+
+
+void TrunkLink::handleMsgTrunkAudio(Async::MsgUnpackBuffer& is)
+{
+  if (m_state != STATE_UP)
+  {
+    return;
+  }
+  MsgTrunkAudio msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** WARNING[" << m_name
+         << "]: Could not unpack MsgTrunkAudio" << endl;
+    disconnect();
+    return;
+  }
+  if (!msg.audioData().empty())
+  {
+    audioReceived(this, msg.tg(), msg.audioData());
+  }
+} /* TrunkLink::handleMsgTrunkAudio */
+
+
+void TrunkLink::sendHello(void)
+{
+  m_hello = MsgTrunkHello(m_local_id);
+  sendMsgP(m_hello);
+} /* TrunkLink::sendHello */
+
+
+void TrunkLink::sendAuthResponse(const uint8_t *challenge)
+{
+  sendMsgP(MsgAuthResponse(m_local_id, m_secret, challenge));
+} /* TrunkLink::sendAuthResponse */
+
+
+int TrunkLink::sendMsgP(const ReflectorMsg& msg)
+{
+  if ((m_con == 0) || !m_con->isConnected())
+  {
+    errno = ENOTCONN;
+    return -1;
+  }
+
+  FramedTcpConnection::Frame *frame = ReflectorClient::packMsg(msg);
+  if (frame == 0)
+  {
+    errno = EBADMSG;
+    return -1;
+  }
+  m_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+  int ret = m_con->write(frame);
+  frame->unref();
+  return ret;
+} /* TrunkLink::sendMsgP */
+
+
+void TrunkLink::disconnect(void)
+{
+  assert(m_con != 0);
+  FramedTcpConnection *con = m_con;
+  con->disconnect();
+  con->disconnected(con, FramedTcpConnection::DR_ORDERED_DISCONNECT);
+} /* TrunkLink::disconnect */
+
+
+void TrunkLink::handleHeartbeat(Async::Timer *t)
+{
+  if (--m_heartbeat_tx_cnt == 0)
+  {
+    sendMsgP(MsgHeartbeat());
+  }
+
+  if (--m_heartbeat_rx_cnt == 0)
+  {
+    cerr << "*** WARNING[" << m_name << "]: Trunk heartbeat timeout" << endl;
+    disconnect();
+  }
+} /* TrunkLink::handleHeartbeat */
+
+
+/*
+ * This file has not been truncated
+ */
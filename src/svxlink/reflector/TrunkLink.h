@@ -0,0 +1,312 @@
+/**
+@file   TrunkLink.h
+@brief  A trunk link to another reflector instance
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef TRUNK_LINK_INCLUDED
+#define TRUNK_LINK_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <set>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncTcpClient.h>
+#include <AsyncFramedTcpConnection.h>
+#include <AsyncTimer.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "TrunkMsg.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class Config;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  A trunk link to another reflector instance
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class handle the connection to one peer reflector. If a host is
+configured for the peer, the link connect to it and reconnect if the
+connection is lost. Incoming trunk connections are accepted by the Reflector
+object and handed over to the link matching the peer id in the hello message.
+If both sides connect at the same time, the connection initiated by the
+reflector with the lowest id is kept.
+
+When the link is up, the talker and audio messages received from the peer are
+passed on using the signals. The link also keep track of which talk groups the
+peer have local nodes on so that audio is only sent for those.
+*/
+class TrunkLink : public sigc::trackable
+{
+  public:
+    static const uint32_t MAX_PREAUTH_FRAME_SIZE = 256;
+
+    /**
+     * @brief   Constructor
+     * @param   cfg       The configuration object to read the link setup from
+     * @param   name      The name of the configuration section for the link
+     * @param   local_id  The trunk id of this reflector
+     */
+    TrunkLink(Async::Config &cfg, const std::string& name,
+              const std::string& local_id);
+
+    /**
+     * @brief   Destructor
+     */
+    ~TrunkLink(void);
+
+    /**
+     * @brief   Initialize the link
+     * @return  Returns \em true on success or else \em false
+     */
+    bool initialize(void);
+
+    /**
+     * @brief   Get the name of the link
+     * @return  Returns the name of the configuration section for the link
+     */
+    const std::string& name(void) const { return m_name; }
+
+    /**
+     * @brief   Get the id of the peer reflector
+     * @return  Returns the configured trunk id of the peer
+     */
+    const std::string& peerId(void) const { return m_peer_id; }
+
+    /**
+     * @brief   Check if the link is up
+     * @return  Returns \em true if the link is authenticated and usable
+     */
+    bool isUp(void) const { return m_state == STATE_UP; }
+
+    /**
+     * @brief   Take over an incoming trunk connection
+     * @param   con   The incoming connection
+     * @param   hello The hello message received on the connection
+     * @return  Returns \em true if the connection was accepted
+     *
+     * If the connection is not accepted, the caller should disconnect it.
+     */
+    bool acceptConnection(Async::FramedTcpConnection *con,
+                          const MsgTrunkHello& hello);
+
+    /**
+     * @brief   Tell the link that an incoming connection has been closed
+     * @param   con     The connection that was closed
+     * @param   reason  The reason for the disconnect
+     *
+     * Nothing is done if the connection does not belong to this link.
+     */
+    void connectionClosed(Async::FramedTcpConnection *con,
+                          Async::FramedTcpConnection::DisconnectReason reason);
+
+    /**
+     * @brief   Check if the peer have local nodes on a talk group
+     * @param   tg The talk group
+     * @return  Returns \em true if audio for the talk group should be sent
+     */
+    bool peerSubscribed(uint32_t tg) const
+    {
+      return m_peer_tgs.count(tg) > 0;
+    }
+
+    /**
+     * @brief   Send a message to the peer
+     * @param   msg The message to send
+     * @return  Returns 0 on success or -1 on failure
+     *
+     * Messages are only sent when the link is up.
+     */
+    int sendMsg(const ReflectorMsg& msg);
+
+    /**
+     * @brief   Send an already packed message to the peer
+     * @param   frame The frame to send
+     * @return  Returns 0 on success or -1 on failure
+     */
+    int sendFrame(Async::FramedTcpConnection::Frame *frame);
+
+    /**
+     * @brief   A signal that is emitted when the link go up or down
+     * @param   link  The link object
+     * @param   is_up \em true if the link went up
+     */
+    sigc::signal<void, TrunkLink*, bool> linkStateChanged;
+
+    /**
+     * @brief   A signal that is emitted when a talker start on the peer
+     * @param   link      The link object
+     * @param   tg        The talk group
+     * @param   callsign  The callsign of the talker
+     */
+    sigc::signal<void, TrunkLink*, uint32_t, const std::string&>
+      talkerStartReceived;
+
+    /**
+     * @brief   A signal that is emitted when a talker stop on the peer
+     * @param   link  The link object
+     * @param   tg    The talk group
+     */
+    sigc::signal<void, TrunkLink*, uint32_t> talkerStopReceived;
+
+    /**
+     * @brief   A signal that is emitted when audio is received from the peer
+     * @param   link  The link object
+     * @param   tg    The talk group
+     * @param   data  The encoded audio
+     */
+    sigc::signal<void, TrunkLink*, uint32_t, const std::vector<uint8_t>&>
+      audioReceived;
+
+  private:
+    static const unsigned HEARTBEAT_TX_CNT_RESET  = 10;
+    static const unsigned HEARTBEAT_RX_CNT_RESET  = 15;
+    static const unsigned RECONNECT_INTERVAL      = 5000;
+
+    typedef Async::TcpClient<Async::FramedTcpConnection> FramedTcpClient;
+    typedef enum
+    {
+      STATE_DISCONNECTED, STATE_EXPECT_HELLO, STATE_EXPECT_AUTH, STATE_UP
+    } State;
+
+    Async::Config&              m_cfg;
+    std::string                 m_name;
+    std::string                 m_local_id;
+    std::string                 m_peer_id;
+    std::string                 m_secret;
+    std::string                 m_host;
+    uint16_t                    m_port;
+    FramedTcpClient*            m_client;
+    Async::FramedTcpConnection* m_con;
+    State                       m_state;
+    MsgTrunkHello               m_hello;
+    std::set<uint32_t>          m_peer_tgs;
+    Async::Timer                m_heartbeat_timer;
+    Async::Timer                m_reconnect_timer;
+    unsigned                    m_heartbeat_tx_cnt;
+    unsigned                    m_heartbeat_rx_cnt;
+
+    TrunkLink(const TrunkLink&);
+    TrunkLink& operator=(const TrunkLink&);
+    void connect(Async::Timer *t=0);
+    void onConnected(void);
+    void onDisconnected(Async::FramedTcpConnection *con,
+                        Async::FramedTcpConnection::DisconnectReason reason);
+    void onFrameReceived(Async::FramedTcpConnection *con,
+                         Async::DataView data);
+    void handleMsgTrunkHello(Async::MsgUnpackBuffer& is);
+    void handleMsgAuthResponse(Async::MsgUnpackBuffer& is);
+    void handleMsgTrunkSubscribe(Async::MsgUnpackBuffer& is);
+    void handleMsgTrunkTalkerStart(Async::MsgUnpackBuffer& is);
+    void handleMsgTrunkTalkerStop(Async::MsgUnpackBuffer& is);
+    void handleMsgTrunkAudio(Async::MsgUnpackBuffer& is);
+    void sendHello(void);
+    void sendAuthResponse(const uint8_t *challenge);
+    int sendMsgP(const ReflectorMsg& msg);
+    void disconnect(void);
+    void handleHeartbeat(Async::Timer *t);
+
+};  /* class TrunkLink */
+
+
+//} /* namespace */
+
+#endif /* TRUNK_LINK_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
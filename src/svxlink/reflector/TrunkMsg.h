@@ -0,0 +1,257 @@
+/**
+@file   TrunkMsg.h
+@brief  Reflector trunk protocol message definitions
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+The trunk protocol is used between two reflector instances. It use the same
+framing and message header as the client TCP protocol, see ReflectorMsg.h.
+The heartbeat and authentication response messages of the client protocol are
+reused as is.
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef TRUNK_MSG_INCLUDED
+#define TRUNK_MSG_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <set>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorMsg.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief   Trunk hello TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-14
+
+This is the first message sent by both sides of a trunk link. It contain the
+id of the sending reflector and an authentication challenge. The receiver
+answer with a MsgAuthResponse message, calculated using the shared trunk
+secret, in the same way as a node answer a MsgAuthChallenge.
+*/
+class MsgTrunkHello : public ReflectorMsgBase<200>
+{
+  public:
+    static const size_t CHALLENGE_LEN = MsgAuthChallenge::CHALLENGE_LEN;
+    MsgTrunkHello(const std::string& id="")
+      : m_id(id), m_challenge(CHALLENGE_LEN)
+    {
+      gcry_create_nonce(&m_challenge.front(), CHALLENGE_LEN);
+    }
+
+    const std::string& id(void) const { return m_id; }
+
+    const uint8_t *challenge(void) const
+    {
+      if (m_challenge.size() != CHALLENGE_LEN)
+      {
+        return 0;
+      }
+      return &m_challenge[0];
+    }
+
+    ASYNC_MSG_MEMBERS(m_id, m_challenge);
+
+  private:
+    std::string           m_id;
+    std::vector<uint8_t>  m_challenge;
+}; /* MsgTrunkHello */
+
+
+/**
+@brief   Trunk subscription TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-14
+
+This message contain all talk groups that have local nodes on the sending
+reflector. It is sent when the link come up and then every time the set
+change. Audio is only forwarded over the trunk for the talk groups in the
+latest set received from the peer.
+*/
+class MsgTrunkSubscribe : public ReflectorMsgBase<201>
+{
+  public:
+    MsgTrunkSubscribe(void) {}
+    MsgTrunkSubscribe(const std::set<uint32_t>& tgs) : m_tgs(tgs) {}
+
+    const std::set<uint32_t>& tgs(void) const { return m_tgs; }
+
+    ASYNC_MSG_MEMBERS(m_tgs);
+
+  private:
+    std::set<uint32_t> m_tgs;
+}; /* MsgTrunkSubscribe */
+
+
+/**
+@brief   Trunk talker start TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-14
+
+This message is sent to all peers when a local node become the talker on a
+talk group. It is sent regardless of the peer subscriptions since talker
+arbitration is done over all peers.
+*/
+class MsgTrunkTalkerStart : public ReflectorMsgBase<202>
+{
+  public:
+    MsgTrunkTalkerStart(uint32_t tg=0, const std::string& callsign="")
+      : m_tg(tg), m_callsign(callsign) {}
+
+    uint32_t tg(void) const { return m_tg; }
+    const std::string& callsign(void) const { return m_callsign; }
+
+    ASYNC_MSG_MEMBERS(m_tg, m_callsign);
+
+  private:
+    uint32_t    m_tg;
+    std::string m_callsign;
+}; /* MsgTrunkTalkerStart */
+
+
+/**
+@brief   Trunk talker stop TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-14
+
+This message is sent to all peers when a local talker stop talking.
+*/
+class MsgTrunkTalkerStop : public ReflectorMsgBase<203>
+{
+  public:
+    MsgTrunkTalkerStop(uint32_t tg=0) : m_tg(tg) {}
+
+    uint32_t tg(void) const { return m_tg; }
+
+    ASYNC_MSG_MEMBERS(m_tg);
+
+  private:
+    uint32_t    m_tg;
+}; /* MsgTrunkTalkerStop */
+
+
+/**
+@brief   Trunk audio TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2026-10-14
+
+This message carry one encoded audio frame from the local talker on a talk
+group. It is only sent to peers that have subscribed to the talk group.
+*/
+class MsgTrunkAudio : public ReflectorMsgBase<204>
+{
+  public:
+    MsgTrunkAudio(uint32_t tg=0) : m_tg(tg) {}
+    MsgTrunkAudio(uint32_t tg, const std::vector<uint8_t>& audio_data)
+      : m_tg(tg), m_audio_data(audio_data) {}
+
+    uint32_t tg(void) const { return m_tg; }
+    const std::vector<uint8_t>& audioData(void) const { return m_audio_data; }
+
+    ASYNC_MSG_MEMBERS(m_tg, m_audio_data);
+
+  private:
+    uint32_t              m_tg;
+    std::vector<uint8_t>  m_audio_data;
+}; /* MsgTrunkAudio */
+
+
+//} /* namespace */
+
+#endif /* TRUNK_MSG_INCLUDED */
+
+/*
+ * This file has not been truncated
+ */
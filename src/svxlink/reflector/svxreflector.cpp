@@ -122,6 +122,8 @@ static void logfile_reopen(const char *reason);
 static bool logfile_write_timestamp(void);
 static void logfile_write(const char *buf);
 static void logfile_flush(void);
+static bool read_cfg_dir(Config &cfg, const string& main_cfg_file);
+static void reload_config(void);
 
 
 /****************************************************************************
@@ -147,6 +149,8 @@ static int    	      	logfd = -1;
 static FdWatch	      	*stdin_watch = 0;
 static FdWatch	      	*stdout_watch = 0;
 static string         	tstamp_format;
+static string           main_cfg_filename;
+static Config           *running_cfg = 0;
 
 
 /****************************************************************************
@@ -358,56 +362,12 @@ int main(int argc, const char *argv[])
       }
     }
   }
-  string main_cfg_filename(cfg_filename);
-
-  string cfg_dir;
-  if (cfg.getValue("GLOBAL", "CFG_DIR", cfg_dir))
+  main_cfg_filename = cfg_filename;
+  if (!read_cfg_dir(cfg, main_cfg_filename))
   {
-    if (cfg_dir[0] != '/')
-    {
-      int slash_pos = main_cfg_filename.rfind('/');
-      if (slash_pos != -1)
-      {
-        cfg_dir = main_cfg_filename.substr(0, slash_pos+1) + cfg_dir;
-      }
-      else
-      {
-        cfg_dir = string("./") + cfg_dir;
-      }
-    }
-
-    DIR *dir = opendir(cfg_dir.c_str());
-    if (dir == NULL)
-    {
-      cerr << "*** ERROR: Could not read from directory spcified by "
-           << "configuration variable GLOBAL/CFG_DIR=" << cfg_dir << endl;
-      exit(1);
-    }
-
-    struct dirent *dirent;
-    while ((dirent = readdir(dir)) != NULL)
-    {
-      char *dot = strrchr(dirent->d_name, '.');
-      if ((dot == NULL) || (strcmp(dot, ".conf") != 0))
-      {
-        continue;
-      }
-      cfg_filename = cfg_dir + "/" + dirent->d_name;
-      if (!cfg.open(cfg_filename))
-       {
-	 cerr << "*** ERROR: Could not open configuration file: "
-	      << cfg_filename << endl;
-	 exit(1);
-       }
-    }
-
-    if (closedir(dir) == -1)
-    {
-      cerr << "*** ERROR: Error closing directory specified by"
-           << "configuration variable GLOBAL/CFG_DIR=" << cfg_dir << endl;
-      exit(1);
-    }
+    exit(1);
   }
+  running_cfg = &cfg;
 
   cfg.getValue("GLOBAL", "TIMESTAMP_FORMAT", tstamp_format);
 
@@ -598,12 +558,15 @@ static void stdout_handler(FdWatch *w)
 
 static void sighup_handler(int signal)
 {
-  if (logfile_name == 0)
+  if (logfile_name != 0)
   {
-    cout << "Ignoring SIGHUP\n";
-    return;
+    logfile_reopen("SIGHUP received");
+  }
+  else
+  {
+    cout << "SIGHUP received" << endl;
   }
-  logfile_reopen("SIGHUP received");
+  reload_config();
 } /* sighup_handler */
 
 
@@ -773,6 +736,89 @@ static void logfile_flush(void)
 } /*  logfile_flush */
 
 
+static bool read_cfg_dir(Config &cfg, const string& main_cfg_file)
+{
+  string cfg_dir;
+  if (!cfg.getValue("GLOBAL", "CFG_DIR", cfg_dir))
+  {
+    return true;
+  }
+
+  if (cfg_dir[0] != '/')
+  {
+    int slash_pos = main_cfg_file.rfind('/');
+    if (slash_pos != -1)
+    {
+      cfg_dir = main_cfg_file.substr(0, slash_pos+1) + cfg_dir;
+    }
+    else
+    {
+      cfg_dir = string("./") + cfg_dir;
+    }
+  }
+
+  DIR *dir = opendir(cfg_dir.c_str());
+  if (dir == NULL)
+  {
+    cerr << "*** ERROR: Could not read from directory spcified by "
+         << "configuration variable GLOBAL/CFG_DIR=" << cfg_dir << endl;
+    return false;
+  }
+
+  bool success = true;
+  struct dirent *dirent;
+  while (success && ((dirent = readdir(dir)) != NULL))
+  {
+    char *dot = strrchr(dirent->d_name, '.');
+    if ((dot == NULL) || (strcmp(dot, ".conf") != 0))
+    {
+      continue;
+    }
+    string cfg_filename = cfg_dir + "/" + dirent->d_name;
+    if (!cfg.open(cfg_filename))
+    {
+      cerr << "*** ERROR: Could not open configuration file: "
+           << cfg_filename << endl;
+      success = false;
+    }
+  }
+
+  if (closedir(dir) == -1)
+  {
+    cerr << "*** ERROR: Error closing directory specified by"
+         << "configuration variable GLOBAL/CFG_DIR=" << cfg_dir << endl;
+    return false;
+  }
+
+  return success;
+} /* read_cfg_dir */
+
+
+static void reload_config(void)
+{
+  if (running_cfg == 0)
+  {
+    return;
+  }
+
+    // Read the whole configuration into a new object first so that a broken
+    // file does not leave the running configuration half updated
+  Config new_cfg;
+  if (!new_cfg.open(main_cfg_filename) ||
+      !read_cfg_dir(new_cfg, main_cfg_filename))
+  {
+    cerr << "*** WARNING: Could not reload the configuration from "
+         << main_cfg_filename << ". Keeping the running configuration."
+         << endl;
+    return;
+  }
+  unsigned changes = running_cfg->update(new_cfg);
+  cout << "Configuration reloaded from " << main_cfg_filename << ": "
+       << changes << " variable(s) changed" << endl;
+} /* reload_config */
+
+
+
 /*
  * This file has not been truncated
  */
@@ -0,0 +1,1076 @@
+/**
+@file	 svxreflector_bench.cpp
+@brief   A load generator and benchmark tool for the SvxReflector
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This program simulate a large number of SvxLink nodes connecting to a
+SvxReflector. It implement the client side of the reflector protocol, login,
+talk group selection and monitoring and UDP audio, and let the simulated nodes
+talk according to a configurable pattern. The fan-out latency, packet loss and
+the CPU and memory usage of the reflector process are reported so that the
+capacity of the reflector can be measured in a repeatable way.
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <popt.h>
+#include <sigc++/sigc++.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppApplication.h>
+#include <AsyncTcpClient.h>
+#include <AsyncFramedTcpConnection.h>
+#include <AsyncUdpSocket.h>
+#include <AsyncTimer.h>
+#include <BenchUtil.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorMsg.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace SvxLink;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+#define PROGRAM_NAME "SvxReflectorBench"
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+  // The first bytes of every audio frame sent by a simulated node. The rest
+  // of the frame is padding up to the configured frame size.
+struct AudioStamp
+{
+  static const uint32_t MAGIC = 0x53564242; // "SVBB"
+  uint32_t magic;
+  uint64_t tx_time_us;
+} __attribute__((packed));
+
+
+struct Stats : public BenchStats
+{
+  uint64_t          frames_lost;
+
+  Stats(void) : frames_lost(0) {}
+  void reset(void)
+  {
+    BenchStats::reset();
+    frames_lost = 0;
+  }
+  void merge(const Stats& other)
+  {
+    BenchStats::merge(other);
+    frames_lost += other.frames_lost;
+  }
+}; /* Stats */
+
+
+class Bench;
+
+
+/**
+ * One simulated node
+ */
+class BenchNode : public sigc::trackable
+{
+  public:
+    BenchNode(Bench *bench, const std::string& callsign, uint32_t tg,
+              const std::set<uint32_t>& monitor_tgs);
+    ~BenchNode(void);
+
+    void connect(const std::string& host, uint16_t port);
+    bool isReady(void) const { return m_state == STATE_READY; }
+    bool isConnecting(void) const
+    {
+      return (m_state != STATE_DISCONNECTED) && (m_state != STATE_READY);
+    }
+    uint32_t tg(void) const { return m_tg; }
+    void setCodec(const std::string& codec) { m_codec = codec; }
+    void tick(void);
+    void sendAudio(const std::vector<uint8_t>& frame);
+    void sendFlush(void);
+
+  private:
+    static const unsigned TCP_HEARTBEAT_TX_CNT_RESET = 10;
+    static const unsigned UDP_HEARTBEAT_TX_CNT_RESET = 15;
+    static const uint32_t MAX_FRAME_SIZE = 1024 * 1024;
+
+    typedef enum
+    {
+      STATE_DISCONNECTED, STATE_EXPECT_AUTH_CHALLENGE, STATE_EXPECT_AUTH_OK,
+      STATE_EXPECT_SERVER_INFO, STATE_READY
+    } State;
+    typedef TcpClient<FramedTcpConnection> FramedTcpClient;
+
+    Bench*              m_bench;
+    std::string         m_callsign;
+    uint32_t            m_tg;
+    std::set<uint32_t>  m_monitor_tgs;
+    std::string         m_codec;
+    FramedTcpClient*    m_con;
+    UdpSocket*          m_udp_sock;
+    State               m_state;
+    uint32_t            m_client_id;
+    uint16_t            m_next_udp_tx_seq;
+    uint16_t            m_next_udp_rx_seq;
+    unsigned            m_tcp_heartbeat_tx_cnt;
+    unsigned            m_udp_heartbeat_tx_cnt;
+    std::vector<char>   m_udp_tx_buf;
+
+    void onConnected(void);
+    void onDisconnected(TcpConnection *con,
+                        TcpConnection::DisconnectReason reason);
+    void onFrameReceived(FramedTcpConnection *con, std::vector<uint8_t>& data);
+    void udpDatagramReceived(const IpAddress& addr, uint16_t port,
+                             void *buf, int count);
+    void sendMsg(const ReflectorMsg& msg);
+    void sendUdpMsg(const ReflectorUdpMsg& msg);
+}; /* BenchNode */
+
+
+/**
+ * The benchmark controller
+ */
+class Bench : public sigc::trackable
+{
+  public:
+    std::string host;
+    uint16_t    port;
+    std::string callsign_prefix;
+    std::string auth_key;
+    std::vector<std::string> codecs;
+    unsigned    node_cnt;
+    unsigned    connect_rate;
+    unsigned    tg_cnt;
+    uint32_t    tg_base;
+    unsigned    active_tg_cnt;
+    unsigned    talkers_per_tg;
+    unsigned    monitor_tg_cnt;
+    unsigned    talk_time_ms;
+    unsigned    pause_time_ms;
+    unsigned    frame_interval_ms;
+    unsigned    frame_size;
+    unsigned    duration_s;
+    unsigned    report_interval_s;
+    pid_t       reflector_pid;
+
+    Bench(void);
+    ~Bench(void);
+    void start(void);
+    void printUsers(void);
+    Stats& stats(void) { return m_stats; }
+    void nodeReady(BenchNode *node);
+    void nodeLost(BenchNode *node);
+
+  private:
+    struct TgState
+    {
+      uint32_t                tg;
+      std::vector<BenchNode*> nodes;
+      std::vector<BenchNode*> talkers;
+      uint64_t                next_change_us;
+    };
+
+    std::vector<BenchNode*> m_nodes;
+    std::vector<TgState>    m_tgs;
+    size_t                  m_next_connect;
+    double                  m_connect_credit;
+    unsigned                m_ready_cnt;
+    Timer                   m_connect_timer;
+    Timer                   m_heartbeat_timer;
+    Timer                   m_audio_timer;
+    Timer                   m_report_timer;
+    Timer                   m_duration_timer;
+    Stats                   m_stats;
+    Stats                   m_total;
+    ProcSampler             m_refl_sampler;
+    ProcSampler             m_self_sampler;
+    ProcSampler             m_refl_total_sampler;
+    ProcSampler             m_self_total_sampler;
+    uint64_t                m_refl_rss_baseline_kb;
+    uint64_t                m_start_us;
+    std::vector<uint8_t>    m_frame;
+
+    void connectNodes(Timer *t);
+    void heartbeatTick(Timer *t);
+    void audioTick(Timer *t);
+    void report(Timer *t);
+    void finish(Timer *t);
+    void mergeStats(void);
+    void printStats(const char *label, const Stats& stats, double elapsed_s,
+                    ProcSampler& refl_sampler, ProcSampler& self_sampler);
+}; /* Bench */
+
+
+BenchNode::BenchNode(Bench *bench, const std::string& callsign, uint32_t tg,
+                     const std::set<uint32_t>& monitor_tgs)
+  : m_bench(bench), m_callsign(callsign), m_tg(tg),
+    m_monitor_tgs(monitor_tgs), m_con(0), m_udp_sock(0),
+    m_state(STATE_DISCONNECTED), m_client_id(0), m_next_udp_tx_seq(0),
+    m_next_udp_rx_seq(0), m_tcp_heartbeat_tx_cnt(0),
+    m_udp_heartbeat_tx_cnt(0)
+{
+} /* BenchNode::BenchNode */
+
+
+BenchNode::~BenchNode(void)
+{
+  delete m_udp_sock;
+  delete m_con;
+} /* BenchNode::~BenchNode */
+
+
+void BenchNode::connect(const std::string& host, uint16_t port)
+{
+  delete m_con;
+  m_con = new FramedTcpClient(host, port);
+  m_con->connected.connect(mem_fun(*this, &BenchNode::onConnected));
+  m_con->disconnected.connect(mem_fun(*this, &BenchNode::onDisconnected));
+  m_con->frameReceived.connect(mem_fun(*this, &BenchNode::onFrameReceived));
+  m_con->setMaxFrameSize(MAX_FRAME_SIZE);
+  m_state = STATE_EXPECT_AUTH_CHALLENGE;
+  m_con->connect();
+} /* BenchNode::connect */
+
+
+void BenchNode::tick(void)
+{
+  if (m_state != STATE_READY)
+  {
+    return;
+  }
+  if (--m_tcp_heartbeat_tx_cnt == 0)
+  {
+    sendMsg(MsgHeartbeat());
+  }
+  if (--m_udp_heartbeat_tx_cnt == 0)
+  {
+    sendUdpMsg(MsgUdpHeartbeat());
+  }
+} /* BenchNode::tick */
+
+
+void BenchNode::sendAudio(const std::vector<uint8_t>& frame)
+{
+  sendUdpMsg(MsgUdpAudio(frame));
+} /* BenchNode::sendAudio */
+
+
+void BenchNode::sendFlush(void)
+{
+  sendUdpMsg(MsgUdpFlushSamples());
+} /* BenchNode::sendFlush */
+
+
+void BenchNode::onConnected(void)
+{
+  m_next_udp_tx_seq = 0;
+  m_next_udp_rx_seq = 0;
+  m_tcp_heartbeat_tx_cnt = TCP_HEARTBEAT_TX_CNT_RESET;
+  sendMsg(MsgProtoVer());
+} /* BenchNode::onConnected */
+
+
+void BenchNode::onDisconnected(TcpConnection *con,
+                               TcpConnection::DisconnectReason reason)
+{
+  cerr << "*** WARNING[" << m_callsign << "]: Disconnected: "
+       << TcpConnection::disconnectReasonStr(reason) << endl;
+  bool was_ready = (m_state == STATE_READY);
+  m_state = STATE_DISCONNECTED;
+  delete m_udp_sock;
+  m_udp_sock = 0;
+  if (was_ready)
+  {
+    m_bench->nodeLost(this);
+  }
+} /* BenchNode::onDisconnected */
+
+
+void BenchNode::onFrameReceived(FramedTcpConnection *con,
+                                std::vector<uint8_t>& data)
+{
+  char *buf = reinterpret_cast<char*>(&data.front());
+  stringstream ss;
+  ss.write(buf, data.size());
+
+  ReflectorMsg header;
+  if (!header.unpack(ss))
+  {
+    cerr << "*** ERROR[" << m_callsign
+         << "]: Unpacking failed for TCP message header" << endl;
+    return;
+  }
+
+  switch (header.type())
+  {
+    case MsgAuthChallenge::TYPE:
+    {
+      MsgAuthChallenge msg;
+      if ((m_state != STATE_EXPECT_AUTH_CHALLENGE) || !msg.unpack(ss) ||
+          (msg.challenge() == 0))
+      {
+        cerr << "*** ERROR[" << m_callsign
+             << "]: Unexpected or illegal MsgAuthChallenge" << endl;
+        m_con->disconnect();
+        onDisconnected(m_con, TcpConnection::DR_ORDERED_DISCONNECT);
+        return;
+      }
+      sendMsg(MsgAuthResponse(m_callsign, m_bench->auth_key,
+                              msg.challenge()));
+      m_state = STATE_EXPECT_AUTH_OK;
+      break;
+    }
+
+    case MsgAuthOk::TYPE:
+      m_state = STATE_EXPECT_SERVER_INFO;
+      break;
+
+    case MsgServerInfo::TYPE:
+    {
+      MsgServerInfo msg;
+      if ((m_state != STATE_EXPECT_SERVER_INFO) || !msg.unpack(ss))
+      {
+        cerr << "*** ERROR[" << m_callsign
+             << "]: Unexpected or illegal MsgServerInfo" << endl;
+        m_con->disconnect();
+        onDisconnected(m_con, TcpConnection::DR_ORDERED_DISCONNECT);
+        return;
+      }
+      m_client_id = msg.clientId();
+      delete m_udp_sock;
+      m_udp_sock = new UdpSocket;
+      m_udp_sock->dataReceived.connect(
+          mem_fun(*this, &BenchNode::udpDatagramReceived));
+      m_state = STATE_READY;
+      const std::vector<std::string>& codecs = msg.codecs();
+      if (!m_codec.empty() && (codecs.size() > 1) &&
+          (std::find(codecs.begin(), codecs.end(), m_codec) != codecs.end()))
+      {
+        sendMsg(MsgSelectCodec(m_codec));
+      }
+      sendMsg(MsgSelectTG(m_tg));
+      if (!m_monitor_tgs.empty())
+      {
+        sendMsg(MsgTgMonitor(m_monitor_tgs));
+      }
+      sendUdpMsg(MsgUdpHeartbeat());
+      m_bench->nodeReady(this);
+      break;
+    }
+
+    case MsgError::TYPE:
+    {
+      MsgError msg;
+      msg.unpack(ss);
+      cerr << "*** ERROR[" << m_callsign << "]: Error message received "
+           << "from reflector: " << msg.message() << endl;
+      break;
+    }
+
+    default:
+        // Node list, talker and QSY messages are of no interest here
+      break;
+  }
+} /* BenchNode::onFrameReceived */
+
+
+void BenchNode::udpDatagramReceived(const IpAddress& addr, uint16_t port,
+                                    void *buf, int count)
+{
+  uint64_t rx_time_us = benchNowUs();
+  Async::MsgUnpackBuffer ub(buf, count);
+  ReflectorUdpMsg header;
+  if (!header.unpack(ub))
+  {
+    return;
+  }
+
+  Stats& stats = m_bench->stats();
+  uint16_t udp_rx_seq_diff = header.sequenceNum() - m_next_udp_rx_seq;
+  if (udp_rx_seq_diff > 0x7fff)
+  {
+    return;
+  }
+  stats.frames_lost += udp_rx_seq_diff;
+  m_next_udp_rx_seq = header.sequenceNum() + 1;
+
+  switch (header.type())
+  {
+    case MsgUdpAudio::TYPE:
+    {
+      MsgUdpAudio msg;
+      if (!msg.unpack(ub))
+      {
+        return;
+      }
+      stats.frames_rx += 1;
+      const std::vector<uint8_t>& audio = msg.audioData();
+      if (audio.size() >= sizeof(AudioStamp))
+      {
+        AudioStamp stamp;
+        memcpy(&stamp, &audio[0], sizeof(stamp));
+        if ((stamp.magic == AudioStamp::MAGIC) &&
+            (rx_time_us >= stamp.tx_time_us))
+        {
+          stats.latency.add(rx_time_us - stamp.tx_time_us);
+        }
+      }
+      break;
+    }
+
+    case MsgUdpFlushSamples::TYPE:
+      sendUdpMsg(MsgUdpAllSamplesFlushed());
+      break;
+
+    default:
+      break;
+  }
+} /* BenchNode::udpDatagramReceived */
+
+
+void BenchNode::sendMsg(const ReflectorMsg& msg)
+{
+  if ((m_con == 0) || !m_con->isConnected())
+  {
+    return;
+  }
+  m_tcp_heartbeat_tx_cnt = TCP_HEARTBEAT_TX_CNT_RESET;
+  ReflectorMsg header(msg.type());
+  ostringstream ss;
+  if (!header.pack(ss) || !msg.pack(ss))
+  {
+    cerr << "*** ERROR[" << m_callsign << "]: Failed to pack TCP message"
+         << endl;
+    return;
+  }
+  const std::string& str = ss.str();
+  m_con->write(str.data(), str.size());
+} /* BenchNode::sendMsg */
+
+
+void BenchNode::sendUdpMsg(const ReflectorUdpMsg& msg)
+{
+  if ((m_udp_sock == 0) || (m_state != STATE_READY))
+  {
+    return;
+  }
+  m_udp_heartbeat_tx_cnt = UDP_HEARTBEAT_TX_CNT_RESET;
+  ReflectorUdpMsg header(msg.type(), m_client_id, m_next_udp_tx_seq++);
+  size_t size = header.packedSize() + msg.packedSize();
+  if (m_udp_tx_buf.size() < size)
+  {
+    m_udp_tx_buf.resize(size);
+  }
+  Async::MsgPackBuffer pb(&m_udp_tx_buf[0], m_udp_tx_buf.size());
+  if (!header.pack(pb) || !msg.pack(pb))
+  {
+    cerr << "*** ERROR[" << m_callsign << "]: Failed to pack UDP message"
+         << endl;
+    return;
+  }
+  m_udp_sock->write(m_con->remoteHost(), m_con->remotePort(),
+                    pb.data(), pb.size());
+} /* BenchNode::sendUdpMsg */
+
+
+Bench::Bench(void)
+  : host("localhost"), port(5300), callsign_prefix("BENCH"),
+    auth_key("bench"), node_cnt(100), connect_rate(100), tg_cnt(10),
+    tg_base(1000), active_tg_cnt(0), talkers_per_tg(1), monitor_tg_cnt(0),
+    talk_time_ms(10000), pause_time_ms(2000), frame_interval_ms(20),
+    frame_size(40), duration_s(60), report_interval_s(5), reflector_pid(0),
+    m_next_connect(0), m_connect_credit(0.0), m_ready_cnt(0),
+    m_connect_timer(100, Timer::TYPE_PERIODIC, false),
+    m_heartbeat_timer(1000, Timer::TYPE_PERIODIC, false),
+    m_audio_timer(20, Timer::TYPE_PERIODIC, false),
+    m_report_timer(5000, Timer::TYPE_PERIODIC, false),
+    m_duration_timer(60000, Timer::TYPE_ONESHOT, false),
+    m_refl_rss_baseline_kb(0), m_start_us(0)
+{
+  m_connect_timer.expired.connect(mem_fun(*this, &Bench::connectNodes));
+  m_heartbeat_timer.expired.connect(mem_fun(*this, &Bench::heartbeatTick));
+  m_audio_timer.expired.connect(mem_fun(*this, &Bench::audioTick));
+  m_report_timer.expired.connect(mem_fun(*this, &Bench::report));
+  m_duration_timer.expired.connect(mem_fun(*this, &Bench::finish));
+} /* Bench::Bench */
+
+
+Bench::~Bench(void)
+{
+  for (std::vector<BenchNode*>::iterator it = m_nodes.begin();
+       it != m_nodes.end(); ++it)
+  {
+    delete *it;
+  }
+} /* Bench::~Bench */
+
+
+void Bench::start(void)
+{
+  tg_cnt = std::max(tg_cnt, 1U);
+  if ((active_tg_cnt == 0) || (active_tg_cnt > tg_cnt))
+  {
+    active_tg_cnt = tg_cnt;
+  }
+  monitor_tg_cnt = std::min(monitor_tg_cnt, tg_cnt - 1);
+  frame_size = std::max<unsigned>(frame_size, sizeof(AudioStamp));
+
+  m_tgs.resize(tg_cnt);
+  for (unsigned i=0; i<tg_cnt; ++i)
+  {
+    m_tgs[i].tg = tg_base + i;
+    m_tgs[i].next_change_us = 0;
+  }
+  for (unsigned i=0; i<node_cnt; ++i)
+  {
+    std::ostringstream callsign;
+    callsign << callsign_prefix << (i + 1);
+    unsigned tg_idx = i % tg_cnt;
+    std::set<uint32_t> monitor_tgs;
+    for (unsigned m=1; m<=monitor_tg_cnt; ++m)
+    {
+      monitor_tgs.insert(tg_base + (tg_idx + m) % tg_cnt);
+    }
+    BenchNode *node = new BenchNode(this, callsign.str(), m_tgs[tg_idx].tg,
+                                    monitor_tgs);
+    if (!codecs.empty())
+    {
+      node->setCodec(codecs[i % codecs.size()]);
+    }
+    m_nodes.push_back(node);
+    m_tgs[tg_idx].nodes.push_back(node);
+  }
+  m_frame.assign(frame_size, 0);
+
+    // Every node use one TCP and one UDP socket
+  struct rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0)
+  {
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < 2 * node_cnt + 64)
+    {
+      cerr << "*** WARNING: The open file limit (" << rl.rlim_cur
+           << ") is too low for " << node_cnt << " nodes" << endl;
+    }
+  }
+
+  m_refl_sampler = ProcSampler(reflector_pid);
+  m_self_sampler = ProcSampler(getpid());
+  if (m_refl_sampler.isValid())
+  {
+    if (!m_refl_sampler.rssKb(m_refl_rss_baseline_kb))
+    {
+      cerr << "*** WARNING: Could not read memory usage for process "
+           << reflector_pid << endl;
+      m_refl_sampler = ProcSampler();
+    }
+    else
+    {
+      m_refl_sampler.cpuPercent();
+    }
+  }
+  m_self_sampler.cpuPercent();
+  m_refl_total_sampler = m_refl_sampler;
+  m_self_total_sampler = m_self_sampler;
+
+  cout << "Connecting " << node_cnt << " nodes to " << host << ":" << port
+       << " on " << tg_cnt << " talk groups (" << active_tg_cnt
+       << " active, " << talkers_per_tg << " talker(s) per TG)" << endl;
+
+  m_start_us = benchNowUs();
+  m_connect_timer.setEnable(true);
+  m_heartbeat_timer.setEnable(true);
+  m_audio_timer.setTimeout(frame_interval_ms);
+  m_audio_timer.setEnable(true);
+  m_report_timer.setTimeout(1000 * report_interval_s);
+  m_report_timer.setEnable(report_interval_s > 0);
+  if (duration_s > 0)
+  {
+    m_duration_timer.setTimeout(1000 * duration_s);
+    m_duration_timer.setEnable(true);
+  }
+} /* Bench::start */
+
+
+void Bench::printUsers(void)
+{
+  cout << "[USERS]" << endl;
+  for (unsigned i=0; i<node_cnt; ++i)
+  {
+    cout << callsign_prefix << (i + 1) << "=BenchNodes" << endl;
+  }
+  cout << endl << "[PASSWORDS]" << endl;
+  cout << "BenchNodes=\"" << auth_key << "\"" << endl;
+} /* Bench::printUsers */
+
+
+void Bench::nodeReady(BenchNode *node)
+{
+  if (++m_ready_cnt == node_cnt)
+  {
+    cout << "All " << node_cnt << " nodes logged in after "
+         << std::fixed << std::setprecision(1)
+         << (benchNowUs() - m_start_us) / 1000000.0 << "s" << endl;
+  }
+} /* Bench::nodeReady */
+
+
+void Bench::nodeLost(BenchNode *node)
+{
+  m_ready_cnt -= 1;
+  m_stats.disconnects += 1;
+  for (std::vector<TgState>::iterator it = m_tgs.begin();
+       it != m_tgs.end(); ++it)
+  {
+    std::vector<BenchNode*>& talkers = it->talkers;
+    talkers.erase(std::remove(talkers.begin(), talkers.end(), node),
+                  talkers.end());
+  }
+} /* Bench::nodeLost */
+
+
+void Bench::connectNodes(Timer *t)
+{
+  m_connect_credit += connect_rate / 10.0;
+  while ((m_connect_credit >= 1.0) && (m_next_connect < m_nodes.size()))
+  {
+    m_nodes[m_next_connect++]->connect(host, port);
+    m_connect_credit -= 1.0;
+  }
+  if (m_next_connect >= m_nodes.size())
+  {
+    m_connect_timer.setEnable(false);
+  }
+} /* Bench::connectNodes */
+
+
+void Bench::heartbeatTick(Timer *t)
+{
+  for (std::vector<BenchNode*>::iterator it = m_nodes.begin();
+       it != m_nodes.end(); ++it)
+  {
+    (*it)->tick();
+  }
+} /* Bench::heartbeatTick */
+
+
+void Bench::audioTick(Timer *t)
+{
+  uint64_t now = benchNowUs();
+  for (unsigned i=0; i<active_tg_cnt; ++i)
+  {
+    TgState& tg = m_tgs[i];
+    if (now >= tg.next_change_us)
+    {
+      if (!tg.talkers.empty())
+      {
+        for (std::vector<BenchNode*>::iterator it = tg.talkers.begin();
+             it != tg.talkers.end(); ++it)
+        {
+          (*it)->sendFlush();
+        }
+        tg.talkers.clear();
+        tg.next_change_us = now + 1000ULL * pause_time_ms;
+      }
+      else
+      {
+          // Pick random talkers among the logged in nodes on the TG. At
+          // least one other node must be there to receive the audio.
+        std::vector<BenchNode*> ready;
+        for (std::vector<BenchNode*>::iterator it = tg.nodes.begin();
+             it != tg.nodes.end(); ++it)
+        {
+          if ((*it)->isReady())
+          {
+            ready.push_back(*it);
+          }
+        }
+        if (ready.size() >= 2)
+        {
+          size_t cnt = std::min<size_t>(talkers_per_tg, ready.size() - 1);
+          for (size_t j=0; j<cnt; ++j)
+          {
+            std::swap(ready[j], ready[j + rand() % (ready.size() - j)]);
+          }
+          tg.talkers.assign(ready.begin(), ready.begin() + cnt);
+          tg.next_change_us = now + 1000ULL * talk_time_ms;
+        }
+      }
+    }
+
+    if (!tg.talkers.empty())
+    {
+      AudioStamp stamp;
+      stamp.magic = AudioStamp::MAGIC;
+      for (std::vector<BenchNode*>::iterator it = tg.talkers.begin();
+           it != tg.talkers.end(); ++it)
+      {
+        stamp.tx_time_us = benchNowUs();
+        memcpy(&m_frame[0], &stamp, sizeof(stamp));
+        (*it)->sendAudio(m_frame);
+        m_stats.frames_tx += 1;
+      }
+    }
+  }
+} /* Bench::audioTick */
+
+
+void Bench::report(Timer *t)
+{
+  printStats("interval", m_stats, report_interval_s, m_refl_sampler,
+             m_self_sampler);
+  mergeStats();
+} /* Bench::report */
+
+
+void Bench::finish(Timer *t)
+{
+  mergeStats();
+  printStats("total", m_total, (benchNowUs() - m_start_us) / 1000000.0,
+             m_refl_total_sampler, m_self_total_sampler);
+  Application::app().quit();
+} /* Bench::finish */
+
+
+void Bench::mergeStats(void)
+{
+  m_total.merge(m_stats);
+  m_stats.reset();
+} /* Bench::mergeStats */
+
+
+void Bench::printStats(const char *label, const Stats& stats,
+                       double elapsed_s, ProcSampler& refl_sampler,
+                       ProcSampler& self_sampler)
+{
+  uint64_t expected = stats.frames_rx + stats.frames_lost;
+  double loss_pct = (expected > 0) ? 100.0 * stats.frames_lost / expected : 0;
+  cout << std::fixed << std::setprecision(2)
+       << label << ": nodes=" << m_ready_cnt << "/" << node_cnt
+       << " tx=" << stats.frames_tx
+       << " rx=" << stats.frames_rx
+       << " (" << (elapsed_s > 0 ? stats.frames_rx / elapsed_s : 0) << "/s)"
+       << " lost=" << stats.frames_lost << " (" << loss_pct << "%)"
+       << " disc=" << stats.disconnects
+       << " latency p50=" << stats.latency.percentileMs(50)
+       << "ms p90=" << stats.latency.percentileMs(90)
+       << "ms p99=" << stats.latency.percentileMs(99)
+       << "ms max=" << stats.latency.maxMs() << "ms";
+  if (refl_sampler.isValid())
+  {
+    double cpu = refl_sampler.cpuPercent();
+    uint64_t rss_kb = 0;
+    refl_sampler.rssKb(rss_kb);
+    unsigned nodes = std::max(m_ready_cnt, 1U);
+    cout << " reflector cpu=" << cpu << "% (" << std::setprecision(4)
+         << cpu / nodes << "%/node)" << std::setprecision(2)
+         << " rss=" << rss_kb / 1024.0 << "MB ("
+         << (rss_kb > m_refl_rss_baseline_kb ?
+               (rss_kb - m_refl_rss_baseline_kb) / double(nodes) : 0.0)
+         << "kB/node)";
+  }
+  cout << " bench cpu=" << self_sampler.cpuPercent() << "%" << endl;
+} /* Bench::printStats */
+
+
+} /* End of anonymous namespace */
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static void parse_arguments(int argc, const char **argv, Bench& bench,
+                            int& print_users);
+static void handle_unix_signal(int signum);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, const char *argv[])
+{
+  CppApplication app;
+  app.catchUnixSignal(SIGINT);
+  app.catchUnixSignal(SIGTERM);
+  app.unixSignalCaught.connect(sigc::ptr_fun(&handle_unix_signal));
+
+  Bench bench;
+  int print_users = 0;
+  parse_arguments(argc, argv, bench, print_users);
+
+  if (print_users)
+  {
+    bench.printUsers();
+    return 0;
+  }
+
+    // Initialize the GCrypt library
+  gcry_check_version(NULL);
+  gcry_control(GCRYCTL_DISABLE_SECMEM, 0);
+  gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+
+  bench.start();
+  app.exec();
+
+  return 0;
+} /* main */
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+static void parse_arguments(int argc, const char **argv, Bench& bench,
+                            int& print_users)
+{
+  char *host = NULL;
+  char *callsign_prefix = NULL;
+  char *auth_key = NULL;
+  char *codecs = NULL;
+  int port = bench.port;
+  int node_cnt = bench.node_cnt;
+  int connect_rate = bench.connect_rate;
+  int tg_cnt = bench.tg_cnt;
+  int tg_base = bench.tg_base;
+  int active_tg_cnt = bench.active_tg_cnt;
+  int talkers_per_tg = bench.talkers_per_tg;
+  int monitor_tg_cnt = bench.monitor_tg_cnt;
+  int talk_time_ms = bench.talk_time_ms;
+  int pause_time_ms = bench.pause_time_ms;
+  int frame_interval_ms = bench.frame_interval_ms;
+  int frame_size = bench.frame_size;
+  int duration_s = bench.duration_s;
+  int report_interval_s = bench.report_interval_s;
+  int reflector_pid = 0;
+
+  poptContext optCon;
+  const struct poptOption optionsTable[] =
+  {
+    POPT_AUTOHELP
+    {"host", 0, POPT_ARG_STRING, &host, 0,
+            "The reflector host (default localhost)", "<host>"},
+    {"port", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &port, 0,
+            "The reflector TCP/UDP port", "<port>"},
+    {"nodes", 'n', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &node_cnt, 0,
+            "The number of simulated nodes", "<count>"},
+    {"rate", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &connect_rate, 0,
+            "The number of nodes to connect per second", "<nodes/s>"},
+    {"callsign-prefix", 0, POPT_ARG_STRING, &callsign_prefix, 0,
+            "The callsign prefix for the nodes (default BENCH)", "<prefix>"},
+    {"auth-key", 0, POPT_ARG_STRING, &auth_key, 0,
+            "The authentication key for all nodes (default bench)", "<key>"},
+    {"codecs", 0, POPT_ARG_STRING, &codecs, 0,
+            "A comma separated list of codecs to assign to the nodes in turn "
+            "when the reflector is transcoding", "<codecs>"},
+    {"tgs", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &tg_cnt, 0,
+            "The number of talk groups to spread the nodes over", "<count>"},
+    {"tg-base", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &tg_base, 0,
+            "The first talk group to use", "<tg>"},
+    {"active-tgs", 0, POPT_ARG_INT, &active_tg_cnt, 0,
+            "The number of talk groups with talkers (default all)", "<count>"},
+    {"talkers", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &talkers_per_tg,
+            0, "The number of nodes talking at the same time on each active "
+               "talk group", "<count>"},
+    {"monitor-tgs", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+            &monitor_tg_cnt, 0,
+            "The number of other talk groups each node monitor", "<count>"},
+    {"talk-time", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &talk_time_ms,
+            0, "The length of each transmission", "<ms>"},
+    {"pause-time", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+            &pause_time_ms, 0, "The pause between transmissions", "<ms>"},
+    {"frame-interval", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+            &frame_interval_ms, 0, "The time between audio frames", "<ms>"},
+    {"frame-size", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &frame_size,
+            0, "The size of each audio frame", "<bytes>"},
+    {"duration", 'd', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &duration_s,
+            0, "The length of the benchmark run, 0 to run forever", "<s>"},
+    {"report-interval", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+            &report_interval_s, 0, "The time between reports", "<s>"},
+    {"pid", 0, POPT_ARG_INT, &reflector_pid, 0,
+            "The pid of a local reflector process to measure CPU and memory "
+            "usage for", "<pid>"},
+    {"print-users", 0, POPT_ARG_NONE, &print_users, 0,
+            "Print the USERS and PASSWORDS configuration needed in "
+            "svxreflector.conf and exit", NULL},
+    {NULL, 0, 0, NULL, 0}
+  };
+  int err;
+
+  optCon = poptGetContext(PROGRAM_NAME, argc, argv, optionsTable, 0);
+  poptReadDefaultConfig(optCon, 0);
+
+  err = poptGetNextOpt(optCon);
+  if (err != -1)
+  {
+    fprintf(stderr, "\t%s: %s\n",
+	    poptBadOption(optCon, POPT_BADOPTION_NOALIAS),
+	    poptStrerror(err));
+    exit(1);
+  }
+
+  poptFreeContext(optCon);
+
+  if ((port <= 0) || (port > 65535) || (node_cnt <= 0) || (connect_rate <= 0)
+      || (tg_cnt <= 0) || (tg_base <= 0) || (active_tg_cnt < 0) ||
+      (talkers_per_tg <= 0) || (monitor_tg_cnt < 0) || (talk_time_ms <= 0) ||
+      (pause_time_ms < 0) || (frame_interval_ms <= 0) || (frame_size <= 0) ||
+      (duration_s < 0) || (report_interval_s < 0) || (reflector_pid < 0))
+  {
+    cerr << "*** ERROR: Illegal argument value" << endl;
+    exit(1);
+  }
+
+  if (host != NULL)
+  {
+    bench.host = host;
+  }
+  if (callsign_prefix != NULL)
+  {
+    bench.callsign_prefix = callsign_prefix;
+  }
+  if (auth_key != NULL)
+  {
+    bench.auth_key = auth_key;
+  }
+  if (codecs != NULL)
+  {
+    std::istringstream ss(codecs);
+    std::string codec;
+    while (std::getline(ss, codec, ','))
+    {
+      if (!codec.empty())
+      {
+        bench.codecs.push_back(codec);
+      }
+    }
+  }
+  bench.port = port;
+  bench.node_cnt = node_cnt;
+  bench.connect_rate = connect_rate;
+  bench.tg_cnt = tg_cnt;
+  bench.tg_base = tg_base;
+  bench.active_tg_cnt = active_tg_cnt;
+  bench.talkers_per_tg = talkers_per_tg;
+  bench.monitor_tg_cnt = monitor_tg_cnt;
+  bench.talk_time_ms = talk_time_ms;
+  bench.pause_time_ms = pause_time_ms;
+  bench.frame_interval_ms = frame_interval_ms;
+  bench.frame_size = frame_size;
+  bench.duration_s = duration_s;
+  bench.report_interval_s = report_interval_s;
+  bench.reflector_pid = reflector_pid;
+} /* parse_arguments */
+
+
+static void handle_unix_signal(int signum)
+{
+  switch (signum)
+  {
+    case SIGINT:
+    case SIGTERM:
+      cout << endl << "Benchmark interrupted" << endl;
+      Application::app().quit();
+      break;
+  }
+} /* handle_unix_signal */
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,840 @@
+/**
+@file	 svxreflector_replay.cpp
+@brief   Replay captured client traffic against a SvxReflector
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This program read a capture file written by a SvxReflector with
+GLOBAL/CAPTURE_FILE set and replay the captured client traffic against a test
+reflector. Each captured client is simulated by logging in with the captured
+callsign and protocol version. Then the captured TCP frames and UDP datagrams
+are sent with the original timing, optionally accelerated. Together with the
+svxreflector_bench load generator this make it possible to run realistic
+performance scenarios in a repeatable way.
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+#include <popt.h>
+#include <sigc++/sigc++.h>
+
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppApplication.h>
+#include <AsyncTcpClient.h>
+#include <AsyncFramedTcpConnection.h>
+#include <AsyncUdpSocket.h>
+#include <AsyncTimer.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorMsg.h"
+#include "ReflectorCapture.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+#define PROGRAM_NAME "SvxReflectorReplay"
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+} /* now_us */
+
+
+struct Stats
+{
+  uint64_t  logins;
+  uint64_t  tcp_tx;
+  uint64_t  udp_tx;
+  uint64_t  udp_rx;
+  uint64_t  skipped;
+  uint64_t  disconnects;
+  uint64_t  lag_sum_us;
+  uint64_t  lag_max_us;
+  uint64_t  lag_cnt;
+
+  Stats(void) { reset(); }
+  void reset(void)
+  {
+    logins = tcp_tx = udp_tx = udp_rx = skipped = disconnects = 0;
+    lag_sum_us = lag_max_us = lag_cnt = 0;
+  }
+}; /* Stats */
+
+
+class Replay;
+
+
+/**
+ * One replayed client
+ */
+class ReplayNode : public sigc::trackable
+{
+  public:
+    ReplayNode(Replay *replay, const std::string& callsign,
+               const ProtoVer& proto_ver);
+    ~ReplayNode(void);
+
+    void connect(const std::string& host, uint16_t port);
+    bool isReady(void) const { return m_state == STATE_READY; }
+    void sendFrame(const std::vector<uint8_t>& frame);
+    bool sendDatagram(const std::vector<uint8_t>& datagram);
+
+  private:
+    static const uint32_t MAX_FRAME_SIZE = 1024 * 1024;
+    static const size_t   MAX_PENDING_FRAMES = 1000;
+
+    typedef enum
+    {
+      STATE_DISCONNECTED, STATE_EXPECT_AUTH_CHALLENGE, STATE_EXPECT_AUTH_OK,
+      STATE_EXPECT_SERVER_INFO, STATE_READY
+    } State;
+    typedef TcpClient<FramedTcpConnection> FramedTcpClient;
+
+    Replay*                           m_replay;
+    std::string                       m_callsign;
+    ProtoVer                          m_proto_ver;
+    FramedTcpClient*                  m_con;
+    UdpSocket*                        m_udp_sock;
+    State                             m_state;
+    uint32_t                          m_client_id;
+    uint16_t                          m_next_udp_tx_seq;
+    std::deque<std::vector<uint8_t> > m_pending_frames;
+    std::vector<char>                 m_udp_tx_buf;
+
+    void onConnected(void);
+    void onDisconnected(TcpConnection *con,
+                        TcpConnection::DisconnectReason reason);
+    void onFrameReceived(FramedTcpConnection *con, std::vector<uint8_t>& data);
+    void udpDatagramReceived(const IpAddress& addr, uint16_t port,
+                             void *buf, int count);
+    void sendMsg(const ReflectorMsg& msg);
+}; /* ReplayNode */
+
+
+/**
+ * The replay controller
+ */
+class Replay : public sigc::trackable
+{
+  public:
+    std::string host;
+    uint16_t    port;
+    std::string auth_key;
+    std::string callsign_prefix;
+    double      speed;
+    unsigned    report_interval_s;
+
+    Replay(void);
+    ~Replay(void);
+    bool start(const std::string& path);
+    bool printUsers(const std::string& path);
+    Stats& stats(void) { return m_stats; }
+    void nodeLost(ReplayNode *node) { m_stats.disconnects += 1; }
+
+  private:
+    typedef std::map<uint32_t, ReplayNode*> NodeMap;
+
+    ReflectorCaptureReader    m_reader;
+    ReflectorCapture::Record  m_rec;
+    bool                      m_have_rec;
+    NodeMap                   m_nodes;
+    Timer                     m_replay_timer;
+    Timer                     m_report_timer;
+    Timer                     m_finish_timer;
+    uint64_t                  m_start_us;
+    Stats                     m_stats;
+    Stats                     m_total;
+
+    void replayRecords(Timer *t);
+    void replayRecord(const ReflectorCapture::Record& rec);
+    void scheduleNext(void);
+    void report(Timer *t);
+    void finish(Timer *t);
+    void mergeStats(void);
+    void printStats(const char *label, const Stats& stats);
+}; /* Replay */
+
+
+ReplayNode::ReplayNode(Replay *replay, const std::string& callsign,
+                       const ProtoVer& proto_ver)
+  : m_replay(replay), m_callsign(callsign), m_proto_ver(proto_ver),
+    m_con(0), m_udp_sock(0), m_state(STATE_DISCONNECTED), m_client_id(0),
+    m_next_udp_tx_seq(0)
+{
+} /* ReplayNode::ReplayNode */
+
+
+ReplayNode::~ReplayNode(void)
+{
+  delete m_udp_sock;
+  delete m_con;
+} /* ReplayNode::~ReplayNode */
+
+
+void ReplayNode::connect(const std::string& host, uint16_t port)
+{
+  delete m_con;
+  m_con = new FramedTcpClient(host, port);
+  m_con->connected.connect(mem_fun(*this, &ReplayNode::onConnected));
+  m_con->disconnected.connect(mem_fun(*this, &ReplayNode::onDisconnected));
+  m_con->frameReceived.connect(mem_fun(*this, &ReplayNode::onFrameReceived));
+  m_con->setMaxFrameSize(MAX_FRAME_SIZE);
+  m_state = STATE_EXPECT_AUTH_CHALLENGE;
+  m_con->connect();
+} /* ReplayNode::connect */
+
+
+void ReplayNode::sendFrame(const std::vector<uint8_t>& frame)
+{
+  if (m_state == STATE_READY)
+  {
+    m_con->write(&frame[0], frame.size());
+    m_replay->stats().tcp_tx += 1;
+  }
+  else if ((m_state != STATE_DISCONNECTED) &&
+           (m_pending_frames.size() < MAX_PENDING_FRAMES))
+  {
+      // Frames captured right after login may arrive before the replayed
+      // login is done. They are sent as soon as the node is ready.
+    m_pending_frames.push_back(frame);
+  }
+  else
+  {
+    m_replay->stats().skipped += 1;
+  }
+} /* ReplayNode::sendFrame */
+
+
+bool ReplayNode::sendDatagram(const std::vector<uint8_t>& datagram)
+{
+  if ((m_udp_sock == 0) || (m_state != STATE_READY))
+  {
+    return false;
+  }
+
+    // The client id and sequence number in the captured header belong to
+    // the capturing reflector so a new header is packed
+  Async::MsgUnpackBuffer ub(&datagram[0], datagram.size());
+  ReflectorUdpMsg captured_header;
+  if (!captured_header.unpack(ub))
+  {
+    return false;
+  }
+  ReflectorUdpMsg header(captured_header.type(), m_client_id,
+                         m_next_udp_tx_seq++);
+  const size_t body_len = ub.remaining();
+  const size_t size = header.packedSize() + body_len;
+  if (m_udp_tx_buf.size() < size)
+  {
+    m_udp_tx_buf.resize(size);
+  }
+  Async::MsgPackBuffer pb(&m_udp_tx_buf[0], m_udp_tx_buf.size());
+  if (!header.pack(pb))
+  {
+    return false;
+  }
+  std::copy(datagram.end() - body_len, datagram.end(),
+            m_udp_tx_buf.begin() + pb.size());
+  m_udp_sock->write(m_con->remoteHost(), m_con->remotePort(),
+                    &m_udp_tx_buf[0], size);
+  return true;
+} /* ReplayNode::sendDatagram */
+
+
+void ReplayNode::onConnected(void)
+{
+  m_next_udp_tx_seq = 0;
+  sendMsg(MsgProtoVer(m_proto_ver.majorVer(), m_proto_ver.minorVer()));
+} /* ReplayNode::onConnected */
+
+
+void ReplayNode::onDisconnected(TcpConnection *con,
+                                TcpConnection::DisconnectReason reason)
+{
+  cerr << "*** WARNING[" << m_callsign << "]: Disconnected: "
+       << TcpConnection::disconnectReasonStr(reason) << endl;
+  m_state = STATE_DISCONNECTED;
+  m_pending_frames.clear();
+  delete m_udp_sock;
+  m_udp_sock = 0;
+  m_replay->nodeLost(this);
+} /* ReplayNode::onDisconnected */
+
+
+void ReplayNode::onFrameReceived(FramedTcpConnection *con,
+                                 std::vector<uint8_t>& data)
+{
+  Async::MsgUnpackBuffer ub(data.data(), data.size());
+
+  ReflectorMsg header;
+  if (!header.unpack(ub))
+  {
+    cerr << "*** ERROR[" << m_callsign
+         << "]: Unpacking failed for TCP message header" << endl;
+    return;
+  }
+
+  switch (header.type())
+  {
+    case MsgAuthChallenge::TYPE:
+    {
+      MsgAuthChallenge msg;
+      if ((m_state != STATE_EXPECT_AUTH_CHALLENGE) || !msg.unpack(ub) ||
+          (msg.challenge() == 0))
+      {
+        cerr << "*** ERROR[" << m_callsign
+             << "]: Unexpected or illegal MsgAuthChallenge" << endl;
+        m_con->disconnect();
+        onDisconnected(m_con, TcpConnection::DR_ORDERED_DISCONNECT);
+        return;
+      }
+      sendMsg(MsgAuthResponse(m_callsign, m_replay->auth_key,
+                              msg.challenge()));
+      m_state = STATE_EXPECT_AUTH_OK;
+      break;
+    }
+
+    case MsgAuthOk::TYPE:
+      m_state = STATE_EXPECT_SERVER_INFO;
+      break;
+
+    case MsgServerInfo::TYPE:
+    {
+      MsgServerInfo msg;
+      if ((m_state != STATE_EXPECT_SERVER_INFO) || !msg.unpack(ub))
+      {
+        cerr << "*** ERROR[" << m_callsign
+             << "]: Unexpected or illegal MsgServerInfo" << endl;
+        m_con->disconnect();
+        onDisconnected(m_con, TcpConnection::DR_ORDERED_DISCONNECT);
+        return;
+      }
+      m_client_id = msg.clientId();
+      delete m_udp_sock;
+      m_udp_sock = new UdpSocket;
+      m_udp_sock->dataReceived.connect(
+          mem_fun(*this, &ReplayNode::udpDatagramReceived));
+      m_state = STATE_READY;
+      m_replay->stats().logins += 1;
+      while (!m_pending_frames.empty())
+      {
+        sendFrame(m_pending_frames.front());
+        m_pending_frames.pop_front();
+      }
+      break;
+    }
+
+    case MsgError::TYPE:
+    {
+      MsgError msg;
+      msg.unpack(ub);
+      cerr << "*** ERROR[" << m_callsign << "]: Error message received "
+           << "from reflector: " << msg.message() << endl;
+      break;
+    }
+
+    default:
+      break;
+  }
+} /* ReplayNode::onFrameReceived */
+
+
+void ReplayNode::udpDatagramReceived(const IpAddress& addr, uint16_t port,
+                                     void *buf, int count)
+{
+  m_replay->stats().udp_rx += 1;
+} /* ReplayNode::udpDatagramReceived */
+
+
+void ReplayNode::sendMsg(const ReflectorMsg& msg)
+{
+  if ((m_con == 0) || !m_con->isConnected())
+  {
+    return;
+  }
+  ReflectorMsg header(msg.type());
+  ostringstream ss;
+  if (!header.pack(ss) || !msg.pack(ss))
+  {
+    cerr << "*** ERROR[" << m_callsign << "]: Failed to pack TCP message"
+         << endl;
+    return;
+  }
+  const std::string& str = ss.str();
+  m_con->write(str.data(), str.size());
+} /* ReplayNode::sendMsg */
+
+
+Replay::Replay(void)
+  : host("localhost"), port(5300), auth_key("replay"), speed(1.0),
+    report_interval_s(5), m_have_rec(false),
+    m_replay_timer(0, Timer::TYPE_ONESHOT, false),
+    m_report_timer(5000, Timer::TYPE_PERIODIC, false),
+    m_finish_timer(2000, Timer::TYPE_ONESHOT, false), m_start_us(0)
+{
+  m_replay_timer.expired.connect(mem_fun(*this, &Replay::replayRecords));
+  m_report_timer.expired.connect(mem_fun(*this, &Replay::report));
+  m_finish_timer.expired.connect(mem_fun(*this, &Replay::finish));
+} /* Replay::Replay */
+
+
+Replay::~Replay(void)
+{
+  for (NodeMap::iterator it = m_nodes.begin(); it != m_nodes.end(); ++it)
+  {
+    delete it->second;
+  }
+} /* Replay::~Replay */
+
+
+bool Replay::start(const std::string& path)
+{
+  if (!m_reader.open(path))
+  {
+    return false;
+  }
+  m_have_rec = m_reader.read(m_rec);
+  if (!m_have_rec)
+  {
+    cerr << "*** ERROR: The capture file \"" << path << "\" is empty" << endl;
+    return false;
+  }
+
+  cout << "Replaying \"" << path << "\" to " << host << ":" << port
+       << " at " << speed << "x speed" << endl;
+
+  m_start_us = now_us();
+  m_report_timer.setTimeout(1000 * report_interval_s);
+  m_report_timer.setEnable(report_interval_s > 0);
+  scheduleNext();
+  return true;
+} /* Replay::start */
+
+
+bool Replay::printUsers(const std::string& path)
+{
+  ReflectorCaptureReader reader;
+  if (!reader.open(path))
+  {
+    return false;
+  }
+  std::set<std::string> callsigns;
+  ReflectorCapture::Record rec;
+  while (reader.read(rec))
+  {
+    std::string callsign;
+    ProtoVer ver;
+    if (ReflectorCapture::decodeLogin(rec, callsign, ver))
+    {
+      callsigns.insert(callsign_prefix + callsign);
+    }
+  }
+  cout << "[USERS]" << endl;
+  for (std::set<std::string>::const_iterator it = callsigns.begin();
+       it != callsigns.end(); ++it)
+  {
+    cout << *it << "=ReplayNodes" << endl;
+  }
+  cout << endl << "[PASSWORDS]" << endl;
+  cout << "ReplayNodes=\"" << auth_key << "\"" << endl;
+  return true;
+} /* Replay::printUsers */
+
+
+void Replay::replayRecords(Timer *t)
+{
+  const uint64_t now = now_us();
+  while (m_have_rec)
+  {
+    const uint64_t due_us = m_start_us + m_rec.time_us / speed;
+    if (due_us > now)
+    {
+      break;
+    }
+    const uint64_t lag_us = now - due_us;
+    m_stats.lag_sum_us += lag_us;
+    m_stats.lag_max_us = std::max(m_stats.lag_max_us, lag_us);
+    m_stats.lag_cnt += 1;
+    replayRecord(m_rec);
+    m_have_rec = m_reader.read(m_rec);
+  }
+  scheduleNext();
+} /* Replay::replayRecords */
+
+
+void Replay::replayRecord(const ReflectorCapture::Record& rec)
+{
+  NodeMap::iterator it = m_nodes.find(rec.client_id);
+  switch (rec.type)
+  {
+    case ReflectorCapture::RECORD_LOGIN:
+    {
+      std::string callsign;
+      ProtoVer ver;
+      if (!ReflectorCapture::decodeLogin(rec, callsign, ver))
+      {
+        m_stats.skipped += 1;
+        break;
+      }
+      if (it != m_nodes.end())
+      {
+        delete it->second;
+        m_nodes.erase(it);
+      }
+      ReplayNode *node = new ReplayNode(this, callsign_prefix + callsign, ver);
+      m_nodes[rec.client_id] = node;
+      node->connect(host, port);
+      break;
+    }
+
+    case ReflectorCapture::RECORD_LOGOUT:
+      if (it != m_nodes.end())
+      {
+        delete it->second;
+        m_nodes.erase(it);
+      }
+      break;
+
+    case ReflectorCapture::RECORD_TCP_FRAME:
+      if ((it != m_nodes.end()) && !rec.data.empty())
+      {
+        it->second->sendFrame(rec.data);
+      }
+      else
+      {
+        m_stats.skipped += 1;
+      }
+      break;
+
+    case ReflectorCapture::RECORD_UDP_DATAGRAM:
+      if ((it != m_nodes.end()) && it->second->sendDatagram(rec.data))
+      {
+        m_stats.udp_tx += 1;
+      }
+      else
+      {
+        m_stats.skipped += 1;
+      }
+      break;
+
+    default:
+      m_stats.skipped += 1;
+      break;
+  }
+} /* Replay::replayRecord */
+
+
+void Replay::scheduleNext(void)
+{
+  if (!m_have_rec)
+  {
+    if (!m_reader.eof())
+    {
+      cerr << "*** WARNING: The capture file is truncated or corrupt" << endl;
+    }
+    cout << "End of capture reached" << endl;
+    m_finish_timer.setEnable(true);
+    return;
+  }
+  const uint64_t due_us = m_start_us + m_rec.time_us / speed;
+  const uint64_t now = now_us();
+  m_replay_timer.setTimeout(due_us > now ? (due_us - now) / 1000 : 0);
+  m_replay_timer.setEnable(true);
+} /* Replay::scheduleNext */
+
+
+void Replay::report(Timer *t)
+{
+  printStats("interval", m_stats);
+  mergeStats();
+} /* Replay::report */
+
+
+void Replay::finish(Timer *t)
+{
+  mergeStats();
+  printStats("total", m_total);
+  Application::app().quit();
+} /* Replay::finish */
+
+
+void Replay::mergeStats(void)
+{
+  m_total.logins += m_stats.logins;
+  m_total.tcp_tx += m_stats.tcp_tx;
+  m_total.udp_tx += m_stats.udp_tx;
+  m_total.udp_rx += m_stats.udp_rx;
+  m_total.skipped += m_stats.skipped;
+  m_total.disconnects += m_stats.disconnects;
+  m_total.lag_sum_us += m_stats.lag_sum_us;
+  m_total.lag_max_us = std::max(m_total.lag_max_us, m_stats.lag_max_us);
+  m_total.lag_cnt += m_stats.lag_cnt;
+  m_stats.reset();
+} /* Replay::mergeStats */
+
+
+void Replay::printStats(const char *label, const Stats& stats)
+{
+  const double elapsed_s = (now_us() - m_start_us) / 1000000.0;
+  cout << std::fixed << std::setprecision(2)
+       << label << ": t=" << elapsed_s << "s capture_t="
+       << (m_have_rec ? m_rec.time_us / 1000000.0 : 0.0) << "s"
+       << " nodes=" << m_nodes.size()
+       << " logins=" << stats.logins
+       << " tcp_tx=" << stats.tcp_tx
+       << " udp_tx=" << stats.udp_tx
+       << " udp_rx=" << stats.udp_rx
+       << " skipped=" << stats.skipped
+       << " disc=" << stats.disconnects
+       << " lag avg="
+       << (stats.lag_cnt > 0 ? stats.lag_sum_us / 1000.0 / stats.lag_cnt : 0)
+       << "ms max=" << stats.lag_max_us / 1000.0 << "ms" << endl;
+} /* Replay::printStats */
+
+
+} /* End of anonymous namespace */
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static void parse_arguments(int argc, const char **argv, Replay& replay,
+                            std::string& path, int& print_users);
+static void handle_unix_signal(int signum);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, const char *argv[])
+{
+  CppApplication app;
+  app.catchUnixSignal(SIGINT);
+  app.catchUnixSignal(SIGTERM);
+  app.unixSignalCaught.connect(sigc::ptr_fun(&handle_unix_signal));
+
+  Replay replay;
+  std::string path;
+  int print_users = 0;
+  parse_arguments(argc, argv, replay, path, print_users);
+
+  if (print_users)
+  {
+    return replay.printUsers(path) ? 0 : 1;
+  }
+
+    // Initialize the GCrypt library
+  gcry_check_version(NULL);
+  gcry_control(GCRYCTL_DISABLE_SECMEM, 0);
+  gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+
+  if (!replay.start(path))
+  {
+    return 1;
+  }
+  app.exec();
+
+  return 0;
+} /* main */
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+static void parse_arguments(int argc, const char **argv, Replay& replay,
+                            std::string& path, int& print_users)
+{
+  char *host = NULL;
+  char *auth_key = NULL;
+  char *callsign_prefix = NULL;
+  int port = replay.port;
+  double speed = replay.speed;
+  int report_interval_s = replay.report_interval_s;
+
+  poptContext optCon;
+  const struct poptOption optionsTable[] =
+  {
+    POPT_AUTOHELP
+    {"host", 0, POPT_ARG_STRING, &host, 0,
+            "The reflector host (default localhost)", "<host>"},
+    {"port", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &port, 0,
+            "The reflector TCP/UDP port", "<port>"},
+    {"auth-key", 0, POPT_ARG_STRING, &auth_key, 0,
+            "The authentication key for all nodes (default replay)", "<key>"},
+    {"callsign-prefix", 0, POPT_ARG_STRING, &callsign_prefix, 0,
+            "A prefix to add to the captured callsigns", "<prefix>"},
+    {"speed", 's', POPT_ARG_DOUBLE | POPT_ARGFLAG_SHOW_DEFAULT, &speed, 0,
+            "The replay speed relative to the captured timing", "<factor>"},
+    {"report-interval", 0, POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+            &report_interval_s, 0, "The time between reports", "<s>"},
+    {"print-users", 0, POPT_ARG_NONE, &print_users, 0,
+            "Print the USERS and PASSWORDS configuration needed in "
+            "svxreflector.conf and exit", NULL},
+    {NULL, 0, 0, NULL, 0}
+  };
+  int err;
+
+  optCon = poptGetContext(PROGRAM_NAME, argc, argv, optionsTable, 0);
+  poptSetOtherOptionHelp(optCon, "[OPTIONS] <capture file>");
+  poptReadDefaultConfig(optCon, 0);
+
+  err = poptGetNextOpt(optCon);
+  if (err != -1)
+  {
+    fprintf(stderr, "\t%s: %s\n",
+	    poptBadOption(optCon, POPT_BADOPTION_NOALIAS),
+	    poptStrerror(err));
+    exit(1);
+  }
+
+  const char *arg = poptGetArg(optCon);
+  if ((arg == NULL) || (poptPeekArg(optCon) != NULL))
+  {
+    poptPrintUsage(optCon, stderr, 0);
+    exit(1);
+  }
+  path = arg;
+
+  poptFreeContext(optCon);
+
+  if ((port <= 0) || (port > 65535) || (speed <= 0.0) ||
+      (report_interval_s < 0))
+  {
+    cerr << "*** ERROR: Illegal argument value" << endl;
+    exit(1);
+  }
+
+  if (host != NULL)
+  {
+    replay.host = host;
+  }
+  if (auth_key != NULL)
+  {
+    replay.auth_key = auth_key;
+  }
+  if (callsign_prefix != NULL)
+  {
+    replay.callsign_prefix = callsign_prefix;
+  }
+  replay.port = port;
+  replay.speed = speed;
+  replay.report_interval_s = report_interval_s;
+} /* parse_arguments */
+
+
+static void handle_unix_signal(int signum)
+{
+  switch (signum)
+  {
+    case SIGINT:
+    case SIGTERM:
+      cout << endl << "Replay interrupted" << endl;
+      Application::app().quit();
+      break;
+  }
+} /* handle_unix_signal */
+
+
+/*
+ * This file has not been truncated
+ */
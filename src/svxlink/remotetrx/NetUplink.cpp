@@ -33,8 +33,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <iostream>
+#include <cmath>
 #include <cstring>
 #include <cerrno>
+#include <ctime>
 
 
 /****************************************************************************
@@ -45,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncApplication.h>
 #include <AsyncTcpServer.h>
+#include <AsyncSslContext.h>
 #include <AsyncAudioFifo.h>
 #include <AsyncTimer.h>
 #include <AsyncAudioEncoder.h>
@@ -82,6 +85,17 @@ using namespace NetTrxMsg;
  *
  ****************************************************************************/
 
+  // The socket send buffer size to use when MAX_QUEUED_AUDIO is set. The
+  // queued audio must be kept in our own queue where it can be dropped.
+#define LIMITED_SNDBUF_SIZE   8192
+
+  // Disconnect if this many messages pile up during congestion
+#define MAX_QUEUED_MSGS       1000
+
+  // The lifetime of a session token in seconds. A new token is sent when
+  // half of the lifetime has passed.
+#define SESSION_TOKEN_LIFETIME  3600
+
 
 
 /****************************************************************************
@@ -115,6 +129,8 @@ using namespace NetTrxMsg;
  *
  ****************************************************************************/
 
+thread_local NetUplink::Owners NetUplink::owners;
+
 
 
 /****************************************************************************
@@ -125,16 +141,26 @@ using namespace NetTrxMsg;
 
 NetUplink::NetUplink(Config &cfg, const string &name, Rx *rx, Tx *tx,
       	      	     const string& port_str)
-  : server(0), con(0), recv_cnt(0), recv_exp(0), rx(rx), tx(tx), fifo(0),
-    cfg(cfg), name(name), last_msg_timestamp(), heartbeat_timer(0),
+  : server(0), ssl_ctx(0), con(0), recv_cnt(0), recv_exp(0), rx(rx), tx(tx),
+    fifo(0), cfg(cfg), name(name), last_msg_timestamp(), heartbeat_timer(0),
     audio_enc(0), audio_dec(0), loopback_con(0), rx_splitter(0),
     tx_selector(0), state(STATE_DISC), mute_tx_timer(0), tx_muted(false),
-    fallback_enabled(false), tx_ctrl_mode(Tx::TX_OFF)
+    fallback_enabled(false), tx_ctrl_mode(Tx::TX_OFF), use_timestamps(false),
+    flush_pending(false), udp_chan(name), audio_lost_cnt(0), channel(0),
+    owner(0), tx_channel(0), rx_channel(0), use_channels(false),
+    max_queued_audio(0), tx_blocked(false), dropped_audio_cnt(0),
+    total_dropped_audio_cnt(0), tx_passthrough(false), siglev_min_change(0.0f),
+    siglev_max_interval(1000), siglev_reported(false), last_siglev(0.0f),
+    last_siglev_rx_id('\0'), last_siglev_time(0), batch_siglev(false),
+    session_resume(false), session_token_expiry(0)
 {
   heartbeat_timer = new Timer(10000);
   heartbeat_timer->setEnable(false);
   heartbeat_timer->expired.connect(mem_fun(*this, &NetUplink::heartbeat));
 
+  udp_chan.msgReceived.connect(mem_fun(*this, &NetUplink::udpMsgReceived));
+  udp_chan.packetsLost.connect(mem_fun(*this, &NetUplink::audioPacketsLost));
+
     // FIXME: Shouldn't we use the updates directly from the receiver instead?
     // Why is this even here?!
   //siglev_check_timer = new Timer(1000, Timer::TYPE_PERIODIC);
@@ -146,6 +172,19 @@ NetUplink::NetUplink(Config &cfg, const string &name, Rx *rx, Tx *tx,
 
 NetUplink::~NetUplink(void)
 {
+  if (owner == this)
+  {
+    owners.erase(listen_port);
+    for (Channels::iterator it=channels.begin(); it!=channels.end(); ++it)
+    {
+      (*it).second->owner = 0;
+    }
+  }
+  else if (owner != 0)
+  {
+    owner->channels.erase(channel);
+  }
+
   delete audio_enc;
   delete audio_dec;
   delete fifo;
@@ -153,6 +192,7 @@ NetUplink::~NetUplink(void)
   delete rx_splitter;
   delete loopback_con;
   delete server;
+  delete ssl_ctx;
   delete heartbeat_timer;
   delete mute_tx_timer;
   //delete siglev_check_timer;
@@ -183,13 +223,19 @@ bool NetUplink::initialize(void)
     }
   }
 
-  string listen_port;
   if (!cfg.getValue(name, "LISTEN_PORT", listen_port))
   {
     cerr << "*** ERROR: Configuration variable " << name
       	 << "/LISTEN_PORT is missing.\n";
     return false;
   }
+
+  if (!cfg.getValue(name, "CHANNEL", 0U, 255U, channel, true))
+  {
+    cerr << "*** ERROR: Configuration variable " << name
+         << "/CHANNEL must be in the range 0-255.\n";
+    return false;
+  }
   
   cfg.getValue(name, "FALLBACK_REPEATER", fallback_enabled, true);
   cfg.getValue(name, "AUTH_KEY", auth_key, true);
@@ -202,11 +248,74 @@ bool NetUplink::initialize(void)
     mute_tx_timer->setEnable(false);
     mute_tx_timer->expired.connect(mem_fun(*this, &NetUplink::unmuteTx));
   }
+
+  cfg.getValue(name, "SIGLEV_MIN_CHANGE", siglev_min_change, true);
+  cfg.getValue(name, "SIGLEV_MAX_INTERVAL", siglev_max_interval, true);
   
-  server = new TcpServer<>(listen_port);
-  server->clientConnected.connect(mem_fun(*this, &NetUplink::clientConnected));
-  server->clientDisconnected.connect(
-      mem_fun(*this, &NetUplink::clientDisconnected));
+  Owners::iterator oit = owners.find(listen_port);
+  if (oit != owners.end())
+  {
+      // Another uplink already listen on this port so share its connection
+    NetUplink *port_owner = (*oit).second;
+    Channels::iterator cit = port_owner->channels.find(channel);
+    if (cit != port_owner->channels.end())
+    {
+      cerr << "*** ERROR: Channel " << channel << " on port " << listen_port
+           << " is used by both " << (*cit).second->name << " and "
+           << name << ".\n";
+      return false;
+    }
+    owner = port_owner;
+    owner->channels[channel] = this;
+    state = owner->state;
+  }
+  else
+  {
+    cfg.getValue(name, "MAX_QUEUED_AUDIO", max_queued_audio, true);
+
+    bool udp_audio = false;
+    cfg.getValue(name, "UDP_AUDIO", udp_audio);
+    if (udp_audio && !udp_chan.open(atoi(listen_port.c_str())))
+    {
+      return false;
+    }
+
+    server = new TcpServer<>(listen_port);
+    server->clientConnected.connect(
+        mem_fun(*this, &NetUplink::clientConnected));
+    server->clientDisconnected.connect(
+        mem_fun(*this, &NetUplink::clientDisconnected));
+
+    string tls_cert_file;
+    if (cfg.getValue(name, "TLS_CERT_FILE", tls_cert_file))
+    {
+      string tls_key_file;
+      cfg.getValue(name, "TLS_KEY_FILE", tls_key_file);
+      ssl_ctx = new SslContext(SslContext::ROLE_SERVER);
+      if (!ssl_ctx->initOk() ||
+          !ssl_ctx->setCertificateFiles(tls_cert_file, tls_key_file))
+      {
+        return false;
+      }
+      string tls_ca_file;
+      if (cfg.getValue(name, "TLS_CA_FILE", tls_ca_file) &&
+          !ssl_ctx->setCaCertificateFile(tls_ca_file))
+      {
+        return false;
+      }
+      string tls_ticket_key_file;
+      if (cfg.getValue(name, "TLS_TICKET_KEY_FILE", tls_ticket_key_file) &&
+          !ssl_ctx->setSessionTicketKeyFile(tls_ticket_key_file))
+      {
+        return false;
+      }
+      server->setSslContext(ssl_ctx);
+    }
+
+    owner = this;
+    owners[listen_port] = this;
+    channels[channel] = this;
+  }
   
   rx->reset();
   rx->squelchOpen.connect(mem_fun(*this, &NetUplink::squelchOpen));
@@ -217,6 +326,8 @@ bool NetUplink::initialize(void)
       mem_fun(*this, &NetUplink::selcallSequenceDetected));
   
   tx->txTimeout.connect(mem_fun(*this, &NetUplink::txTimeout));
+  tx->allEncodedAudioFlushed.connect(
+      mem_fun(*this, &NetUplink::allEncodedSamplesFlushed));
   tx->transmitterStateChange.connect(
       mem_fun(*this, &NetUplink::transmitterStateChange));
   
@@ -269,38 +380,45 @@ bool NetUplink::initialize(void)
 void NetUplink::handleIncomingConnection(TcpConnection *incoming_con)
 {
   assert(con == 0);
-  rx->reset();
-  if (fallback_enabled) // Deactivate fallback repeater mode
-  {
-    setFallbackActive(false);
-  }
-  
-  if (audio_enc != 0)
+  for (Channels::iterator it=channels.begin(); it!=channels.end(); ++it)
   {
-    rx_splitter->removeSink(audio_enc);
-    delete audio_enc;
-    audio_enc = 0;
+    (*it).second->channelConnected();
   }
   
-  delete audio_dec;
-  audio_dec = 0;
-  
   con = incoming_con;
   con->dataReceived.connect(mem_fun(*this, &NetUplink::tcpDataReceived));
+  con->sendBufferFull.connect(mem_fun(*this, &NetUplink::tcpSendBufferFull));
+  if (max_queued_audio > 0)
+  {
+    if (!con->setSendBufferSize(LIMITED_SNDBUF_SIZE))
+    {
+      cerr << "*** WARNING: Could not set the TCP send buffer size in "
+              "NetUplink " << name << ": " << strerror(errno) << endl;
+    }
+  }
+  clearSendQueue();
+  total_dropped_audio_cnt = 0;
   recv_exp = sizeof(Msg);
   recv_cnt = 0;
   heartbeat_timer->setEnable(true);
   gettimeofday(&last_msg_timestamp, NULL);
+  tx_channel = 0;
+  rx_channel = 0;
+  use_channels = false;
+  batch_siglev = false;
+  pending_siglev.clear();
+  session_resume = false;
   
   setState(STATE_CON_SETUP);
 
-  MsgProtoVer *ver_msg = new MsgProtoVer;
-  sendMsg(ver_msg);
+  MsgProtoVer *ver_msg = new MsgProtoVer(MsgProtoVer::MAJOR,
+                                         MsgProtoVer::MIN_MINOR);
+  queueMsg(ver_msg);
   
   if (auth_key.empty())
   {
     MsgAuthOk *auth_msg = new MsgAuthOk;
-    sendMsg(auth_msg);
+    queueMsg(auth_msg);
     setState(STATE_READY);
   }
   else
@@ -308,11 +426,36 @@ void NetUplink::handleIncomingConnection(TcpConnection *incoming_con)
     MsgAuthChallenge *auth_msg = new MsgAuthChallenge;
     memcpy(auth_challenge, auth_msg->challenge(),
            MsgAuthChallenge::CHALLENGE_LEN);
-    sendMsg(auth_msg);
+    queueMsg(auth_msg);
   }
 } /* NetUplink::handleIncomingConnection */
 
 
+void NetUplink::channelConnected(void)
+{
+  rx->reset();
+  if (fallback_enabled) // Deactivate fallback repeater mode
+  {
+    setFallbackActive(false);
+  }
+  
+  if (audio_enc != 0)
+  {
+    rx_splitter->removeSink(audio_enc);
+    delete audio_enc;
+    audio_enc = 0;
+  }
+  
+  delete audio_dec;
+  audio_dec = 0;
+  tx_passthrough = false;
+
+  use_timestamps = false;
+  audio_lost_cnt = 0;
+  siglev_reported = false;
+} /* NetUplink::channelConnected */
+
+
 void NetUplink::clientConnected(TcpConnection *incoming_con)
 {
   cout << name << ": Client connected: " << incoming_con->remoteHost() << ":"
@@ -339,7 +482,17 @@ void NetUplink::disconnectCleanup(void)
   con = 0;
   recv_exp = 0;
   setState(STATE_DISC);
+  heartbeat_timer->setEnable(false);
+
+  for (Channels::iterator it=channels.begin(); it!=channels.end(); ++it)
+  {
+    (*it).second->channelDisconnected();
+  }
+} /* NetUplink::disconnectCleanup */
 
+
+void NetUplink::channelDisconnected(void)
+{
   rx->reset();
   tx->enableCtcss(false);
   fifo->clear();
@@ -347,8 +500,12 @@ void NetUplink::disconnectCleanup(void)
   {
     audio_dec->flushEncodedSamples();
   }
+  if (tx_passthrough)
+  {
+    tx->flushEncodedAudio();
+    tx_passthrough = false;
+  }
   tx->setTxCtrlMode(Tx::TX_OFF);
-  heartbeat_timer->setEnable(false);
 
   if (mute_tx_timer != 0)
   {
@@ -366,7 +523,7 @@ void NetUplink::disconnectCleanup(void)
   {
     rx->setMuteState(Rx::MUTE_CONTENT);
   }
-} /* NetUplink::disconnectCleanup */
+} /* NetUplink::channelDisconnected */
 
 
 void NetUplink::clientDisconnected(TcpConnection *the_con,
@@ -376,6 +533,14 @@ void NetUplink::clientDisconnected(TcpConnection *the_con,
        << the_con->remotePort() << endl;
   con = 0;
   setState(STATE_DISC_CLEANUP);
+  out_buf.clear();
+  clearSendQueue();
+  if (total_dropped_audio_cnt > 0)
+  {
+    cout << name << ": " << total_dropped_audio_cnt
+         << " audio frames were dropped due to network congestion\n";
+  }
+  udp_chan.stopSession();
   Application::app().runTask(mem_fun(*this, &NetUplink::disconnectCleanup));
 } /* NetUplink::clientDisconnected */
 
@@ -481,10 +646,30 @@ void NetUplink::handleMsg(Msg *msg)
         else
         {
           MsgAuthOk *ok_msg = new MsgAuthOk;
-          sendMsg(ok_msg);
+          queueMsg(ok_msg);
         }
         setState(STATE_READY);
       }
+      else if ((msg->type() == MsgSessionResume::TYPE) &&
+               (msg->size() == sizeof(MsgSessionResume)))
+      {
+        MsgSessionResume *resume_msg =
+            reinterpret_cast<MsgSessionResume *>(msg);
+        if (resume_msg->verify(auth_key, con->remoteHost().toString(),
+                               time(NULL)))
+        {
+          cout << name << ": Session resumed\n";
+          MsgAuthOk *ok_msg = new MsgAuthOk;
+          queueMsg(ok_msg);
+          setState(STATE_READY);
+        }
+        else
+        {
+            // The client answer the challenge too so just wait for that
+          cout << name << ": Session token rejected. Waiting for the "
+                          "authentication challenge response.\n";
+        }
+      }
       else
       {
         cerr << "*** ERROR: Protocol error in NetUplink " << name << ".\n";
@@ -505,6 +690,95 @@ void NetUplink::handleMsg(Msg *msg)
       break;
     }
     
+    case MsgProtoVer::TYPE:
+    {
+      MsgProtoVer *ver_msg = reinterpret_cast<MsgProtoVer *>(msg);
+      if ((msg->size() != sizeof(MsgProtoVer)) ||
+          (ver_msg->majorVer() != MsgProtoVer::MAJOR))
+      {
+        cerr << "*** ERROR: Incompatible protocol version announced in "
+                "NetUplink " << name << ".\n";
+        forceDisconnect();
+        return;
+      }
+      uint16_t minor = ver_msg->minorVer();
+      if (minor > MsgProtoVer::MINOR)
+      {
+        minor = MsgProtoVer::MINOR;
+      }
+      for (Channels::iterator it=channels.begin(); it!=channels.end(); ++it)
+      {
+        (*it).second->use_timestamps =
+          (minor >= MsgProtoVer::MINOR_TIMESTAMPS);
+      }
+      use_channels = (minor >= MsgProtoVer::MINOR_CHANNELS);
+      batch_siglev = (minor >= MsgProtoVer::MINOR_SIGLEV_BATCH);
+      cout << name << ": Using RemoteTrx protocol version "
+           << MsgProtoVer::MAJOR << "." << minor << endl;
+      MsgProtoVer *reply_msg = new MsgProtoVer(MsgProtoVer::MAJOR, minor);
+      queueMsg(reply_msg);
+      if ((minor >= MsgProtoVer::MINOR_UDP_AUDIO) && udp_chan.isOpen())
+      {
+          // The session id make it hard for anyone else to inject audio
+        uint32_t session_id;
+        gcry_randomize(&session_id, sizeof(session_id), GCRY_STRONG_RANDOM);
+        udp_chan.startSession(session_id, con->remoteHost());
+        MsgUdpAudioSetup *setup_msg = new MsgUdpAudioSetup(
+            session_id, udp_chan.localPort());
+        queueMsg(setup_msg);
+      }
+      session_resume = (minor >= MsgProtoVer::MINOR_SESSION_RESUME) &&
+                       !auth_key.empty();
+      if (session_resume)
+      {
+        sendSessionToken();
+      }
+      break;
+    }
+
+    case MsgAuthResponse::TYPE:
+    case MsgSessionResume::TYPE:
+    {
+        // A client resuming a session still answer the challenge in case
+        // the token would be rejected
+      break;
+    }
+
+    case MsgSelectChannel::TYPE:
+    {
+      if (msg->size() != sizeof(MsgSelectChannel))
+      {
+        cerr << "*** ERROR: Protocol error in NetUplink " << name << ".\n";
+        forceDisconnect();
+        return;
+      }
+      rx_channel = reinterpret_cast<MsgSelectChannel *>(msg)->channel();
+      if (channels.find(rx_channel) == channels.end())
+      {
+        cerr << "*** WARNING: Messages for unknown channel " << rx_channel
+             << " received in NetUplink " << name << ". Ignoring them.\n";
+      }
+      break;
+    }
+
+    default:
+    {
+      Channels::iterator it = channels.find(rx_channel);
+      if (it != channels.end())
+      {
+        (*it).second->handleChannelMsg(msg);
+      }
+      break;
+    }
+  }
+  
+} /* NetUplink::handleMsg */
+
+
+void NetUplink::handleChannelMsg(Msg *msg)
+{
+  switch (msg->type())
+  {
     case MsgReset::TYPE:
     {
       rx->reset();
@@ -617,6 +891,20 @@ void NetUplink::handleMsg(Msg *msg)
       MsgTxAudioCodecSelect *codec_msg = 
           reinterpret_cast<MsgTxAudioCodecSelect *>(msg);
       delete audio_dec;
+      audio_dec = 0;
+
+        // If the transmitter is going to encode the audio again using the
+        // same codec, there is no need to decode it
+      MsgTxAudioCodecSelect::Opts opts;
+      codec_msg->options(opts);
+      tx_passthrough = tx->canWriteEncodedAudio(codec_msg->name(), opts);
+      if (tx_passthrough)
+      {
+        cout << name << ": Passing encoded TX audio (CODEC \""
+             << codec_msg->name() << "\") through to " << tx->name() << endl;
+        break;
+      }
+
       audio_dec = AudioDecoder::create(codec_msg->name());
       if (audio_dec != 0)
       {
@@ -626,8 +914,6 @@ void NetUplink::handleMsg(Msg *msg)
         cout << name << ": Using CODEC \"" << audio_dec->name()
              << "\" to decode TX audio\n";
 	
-	MsgRxAudioCodecSelect::Opts opts;
-	codec_msg->options(opts);
 	MsgTxAudioCodecSelect::Opts::const_iterator it;
 	for (it=opts.begin(); it!=opts.end(); ++it)
 	{
@@ -646,9 +932,22 @@ void NetUplink::handleMsg(Msg *msg)
     case MsgAudio::TYPE:
     {
       //cout << "NetUplink [MsgAudio]\n";
-      if (!tx_muted && (audio_dec != 0))
+      if (!tx_muted && tx_passthrough)
+      {
+          // The remote decoder will have to conceal lost audio by itself
+        audio_lost_cnt = 0;
+        MsgAudio *audio_msg = reinterpret_cast<MsgAudio*>(msg);
+        tx->writeEncodedAudio(audio_msg->buf(), audio_msg->size());
+      }
+      else if (!tx_muted && (audio_dec != 0))
       {
         MsgAudio *audio_msg = reinterpret_cast<MsgAudio*>(msg);
+        if (audio_lost_cnt > 0)
+        {
+          audio_dec->packetLost(audio_msg->buf(), audio_msg->size(),
+                                audio_lost_cnt);
+          audio_lost_cnt = 0;
+        }
         audio_dec->writeEncodedSamples(audio_msg->buf(), audio_msg->size());
       }
       break;
@@ -656,7 +955,16 @@ void NetUplink::handleMsg(Msg *msg)
     
     case MsgFlush::TYPE:
     {
-      if (audio_dec != 0)
+      if (channel == 0)
+      {
+        owner->udp_chan.flushReceived();
+      }
+      audio_lost_cnt = 0;
+      if (tx_passthrough)
+      {
+        tx->flushEncodedAudio();
+      }
+      else if (audio_dec != 0)
       {
         audio_dec->flushEncodedSamples();
       }
@@ -696,31 +1004,282 @@ void NetUplink::handleMsg(Msg *msg)
       break;
   }
   
-} /* NetUplink::handleMsg */
+} /* NetUplink::handleChannelMsg */
 
 
 void NetUplink::sendMsg(Msg *msg)
+{
+  if (!canSend())
+  {
+    delete msg;
+    return;
+  }
+  owner->queueMsg(msg, channel);
+  
+} /* NetUplink::sendMsg */
+
+
+void NetUplink::queueMsg(Msg *msg, unsigned ch)
 {
   if ((state == STATE_CON_SETUP) || (state == STATE_READY))
   {
-    int written = con->write(msg, msg->size());
-    if (written == -1)
+    if (tx_blocked)
     {
-      cerr << "*** ERROR: TCP transmit error in NetUplink \"" << name
-           << "\": " << strerror(errno) << ".\n";
-      forceDisconnect();
+        // Control messages are never dropped. They are kept in order with
+        // the audio since e.g. a MsgFlush must follow the audio it flush.
+      send_queue.push_back(QueuedMsg(ch, Application::app().monotonicTimeNs(),
+                                     false, msg, msg->size()));
+      if (send_queue.size() > MAX_QUEUED_MSGS)
+      {
+        cerr << "*** ERROR: TCP send queue overflow in NetUplink "
+             << name << ".\n";
+        forceDisconnect();
+      }
+    }
+    else
+    {
+      if (ch != ANY_CHANNEL)
+      {
+        selectTxChannel(ch);
+      }
+      out_buf.addMsg(msg);
+      scheduleFlush();
     }
-    else if (written != static_cast<int>(msg->size()))
+  }
+  delete msg;
+} /* NetUplink::queueMsg */
+
+
+void NetUplink::queueAudio(unsigned ch, const void *buf, int size,
+                           bool add_timestamp)
+{
+  MsgBuffer& dest = tx_blocked ? ser_buf : out_buf;
+  if (!tx_blocked)
+  {
+    selectTxChannel(ch);
+  }
+  if (add_timestamp)
+  {
+    struct timeval capture_time;
+    gettimeofday(&capture_time, NULL);
+    dest.addTimestampedAudio(capture_time, buf, size);
+  }
+  else
+  {
+    dest.addAudio(buf, size);
+  }
+  if (tx_blocked)
+  {
+    send_queue.push_back(QueuedMsg(ch, Application::app().monotonicTimeNs(),
+                                   true, ser_buf.data(), ser_buf.size()));
+    ser_buf.clear();
+    dropOldAudio();
+  }
+  else
+  {
+    scheduleFlush();
+  }
+} /* NetUplink::queueAudio */
+
+
+void NetUplink::selectTxChannel(unsigned ch)
+{
+  if (ch != tx_channel)
+  {
+    MsgSelectChannel msg(ch);
+    out_buf.addMsg(&msg);
+    tx_channel = ch;
+  }
+} /* NetUplink::selectTxChannel */
+
+
+void NetUplink::scheduleFlush(void)
+{
+    // Messages produced during the same main loop iteration are sent using
+    // a single write, e.g. the squelch and signal level updates from all
+    // channels
+  if (!flush_pending)
+  {
+    flush_pending = true;
+    Application::app().runTask(mem_fun(*this, &NetUplink::flushOutput));
+  }
+} /* NetUplink::scheduleFlush */
+
+
+void NetUplink::writeData(const void *buf, unsigned size)
+{
+  int written = con->write(buf, size);
+  if (written == -1)
+  {
+    cerr << "*** ERROR: TCP transmit error in NetUplink \"" << name
+         << "\": " << strerror(errno) << ".\n";
+    forceDisconnect();
+  }
+  else if (written != static_cast<int>(size))
+  {
+    if (max_queued_audio == 0)
     {
       cerr << "*** ERROR: TCP transmit buffer overflow in NetUplink "
            << name << ".\n";
       forceDisconnect();
+      return;
+    }
+
+      // The rest of a message that has been partly written must always be
+      // sent. Everything after that is queued until the socket is writable.
+    const uint8_t *ptr = static_cast<const uint8_t*>(buf);
+    tx_pending.assign(ptr + written, ptr + size);
+    if (!tx_blocked)
+    {
+      tx_blocked = true;
+      dropped_audio_cnt = 0;
     }
   }
-  
-  delete msg;
-  
-} /* NetUplink::sendMsg */
+} /* NetUplink::writeData */
+
+
+void NetUplink::flushOutput(void)
+{
+  if (!pending_siglev.empty())
+  {
+    sendPendingSiglev();
+  }
+  flush_pending = false;
+  if (out_buf.empty())
+  {
+    return;
+  }
+  if (((state == STATE_CON_SETUP) || (state == STATE_READY)) && !tx_blocked)
+  {
+    writeData(out_buf.data(), out_buf.size());
+  }
+  out_buf.clear();
+} /* NetUplink::flushOutput */
+
+
+void NetUplink::queueSiglev(unsigned ch, float siglev, char rx_id)
+{
+  pending_siglev[ch] = MsgSiglevBatch::Entry(ch, siglev, rx_id);
+  scheduleFlush();
+} /* NetUplink::queueSiglev */
+
+
+void NetUplink::sendPendingSiglev(void)
+{
+  if (pending_siglev.size() == 1)
+  {
+    const MsgSiglevBatch::Entry& entry = (*pending_siglev.begin()).second;
+    MsgSiglevUpdate *msg = new MsgSiglevUpdate(entry.signalStrength(),
+                                               entry.sqlRxId());
+    queueMsg(msg, entry.channel());
+  }
+  else
+  {
+    MsgSiglevBatch *msg = new MsgSiglevBatch;
+    for (PendingSiglev::const_iterator it=pending_siglev.begin();
+         it!=pending_siglev.end(); ++it)
+    {
+      msg->addEntry((*it).second);
+    }
+    queueMsg(msg);
+  }
+  pending_siglev.clear();
+} /* NetUplink::sendPendingSiglev */
+
+
+void NetUplink::tcpSendBufferFull(bool is_full)
+{
+  if (!is_full && tx_blocked && (con != 0))
+  {
+    drainSendQueue();
+  }
+} /* NetUplink::tcpSendBufferFull */
+
+
+void NetUplink::drainSendQueue(void)
+{
+  int written = con->write(&tx_pending[0], tx_pending.size());
+  if (written == -1)
+  {
+    cerr << "*** ERROR: TCP transmit error in NetUplink \"" << name
+         << "\": " << strerror(errno) << ".\n";
+    forceDisconnect();
+    return;
+  }
+  tx_pending.erase(tx_pending.begin(), tx_pending.begin() + written);
+  if (!tx_pending.empty())
+  {
+    return;
+  }
+
+    // The socket is writable again. Send what is left in the queue using
+    // one write.
+  dropOldAudio();
+  tx_blocked = false;
+  for (MsgQueue::const_iterator it=send_queue.begin();
+       it!=send_queue.end(); ++it)
+  {
+    if ((*it).channel != ANY_CHANNEL)
+    {
+      selectTxChannel((*it).channel);
+    }
+    out_buf.addData(&(*it).data[0], (*it).data.size());
+  }
+  send_queue.clear();
+  if (dropped_audio_cnt > 0)
+  {
+    cout << name << ": Network congestion cleared. " << dropped_audio_cnt
+         << " audio frames were dropped\n";
+  }
+  flushOutput();
+} /* NetUplink::drainSendQueue */
+
+
+void NetUplink::dropOldAudio(void)
+{
+  const uint64_t max_age = static_cast<uint64_t>(max_queued_audio) * 1000000;
+  const uint64_t now = Application::app().monotonicTimeNs();
+  MsgQueue::iterator it = send_queue.begin();
+  while ((it != send_queue.end()) && (now - (*it).timestamp > max_age))
+  {
+    if ((*it).is_audio)
+    {
+      it = send_queue.erase(it);
+      ++dropped_audio_cnt;
+      ++total_dropped_audio_cnt;
+    }
+    else
+    {
+      ++it;
+    }
+  }
+} /* NetUplink::dropOldAudio */
+
+
+void NetUplink::clearSendQueue(void)
+{
+  tx_blocked = false;
+  tx_pending.clear();
+  send_queue.clear();
+  dropped_audio_cnt = 0;
+} /* NetUplink::clearSendQueue */
+
+
+void NetUplink::udpMsgReceived(Msg *msg)
+{
+  if (state != STATE_READY)
+  {
+    return;
+  }
+
+    // Only channel 0 use the UDP channel
+  Channels::iterator it = channels.find(0);
+  if (it != channels.end())
+  {
+    gettimeofday(&last_msg_timestamp, NULL);
+    (*it).second->handleChannelMsg(msg);
+  }
+} /* NetUplink::udpMsgReceived */
 
 
 void NetUplink::squelchOpen(bool is_open)
@@ -738,6 +1297,17 @@ void NetUplink::squelchOpen(bool is_open)
     }
   }
 
+    // The squelch message also carry the signal level so a pending update
+    // would only be older news
+  if (owner != 0)
+  {
+    owner->pending_siglev.erase(channel);
+  }
+  siglev_reported = true;
+  last_siglev = rx->signalStrength();
+  last_siglev_rx_id = rx->sqlRxId();
+  last_siglev_time = Application::app().monotonicTimeNs();
+
   MsgSquelch *msg = new MsgSquelch(is_open, rx->signalStrength(),
                                    rx->sqlRxId(), rx->squelchActivityInfo());
   sendMsg(msg);
@@ -772,16 +1342,27 @@ void NetUplink::selcallSequenceDetected(std::string sequence)
 void NetUplink::writeEncodedSamples(const void *buf, int size)
 {
   //cout << "NetUplink::writeEncodedSamples: size=" << size << endl;
-  const char *ptr = reinterpret_cast<const char *>(buf);
-  while (size > 0)
+  if (!canSend())
   {
-    const int bufsize = MsgAudio::BUFSIZE;
-    int len = min(size, bufsize);
-    MsgAudio *msg = new MsgAudio(ptr, len);
-    sendMsg(msg);
-    size -= len;
-    ptr += len;
+    return;
+  }
+  if ((channel == 0) && owner->udp_chan.isActive())
+  {
+      // Messages already queued for TCP must go out first
+    owner->flushOutput();
+    if (use_timestamps)
+    {
+      struct timeval capture_time;
+      gettimeofday(&capture_time, NULL);
+      owner->udp_chan.sendTimestampedAudio(capture_time, buf, size);
+    }
+    else
+    {
+      owner->udp_chan.sendAudio(buf, size);
+    }
+    return;
   }
+  owner->queueAudio(channel, buf, size, use_timestamps);
 } /* NetUplink::writeEncodedSamples */
 
 
@@ -810,7 +1391,15 @@ void NetUplink::allEncodedSamplesFlushed(void)
 void NetUplink::heartbeat(Timer *t)
 {
   MsgHeartbeat *msg = new MsgHeartbeat;
-  sendMsg(msg);
+  queueMsg(msg);
+
+  udp_chan.checkTimeout();
+
+  if (session_resume &&
+      (time(NULL) + SESSION_TOKEN_LIFETIME / 2 >= session_token_expiry))
+  {
+    sendSessionToken();
+  }
   
   struct timeval diff_tv;
   struct timeval now;
@@ -829,6 +1418,15 @@ void NetUplink::heartbeat(Timer *t)
 } /* NetTrxTcpClient::heartbeat */
 
 
+void NetUplink::sendSessionToken(void)
+{
+  session_token_expiry = time(NULL) + SESSION_TOKEN_LIFETIME;
+  MsgSessionToken *token_msg = new MsgSessionToken(
+      auth_key, session_token_expiry, con->remoteHost().toString());
+  queueMsg(token_msg);
+} /* NetUplink::sendSessionToken */
+
+
 #if 0
 void NetUplink::checkSiglev(Timer *t)
 {
@@ -866,6 +1464,44 @@ void NetUplink::setFallbackActive(bool activate)
 
 void NetUplink::signalLevelUpdated(float siglev)
 {
+  if (!canSend())
+  {
+    return;
+  }
+
+    // In delta mode, only report changes that are large enough. The level is
+    // still reported now and then so that the last value is never too old.
+  const float signal_strength = rx->signalStrength();
+  const char rx_id = rx->sqlRxId();
+  const uint64_t now = Application::app().monotonicTimeNs();
+  if ((siglev_min_change > 0.0f) && siglev_reported &&
+      (rx_id == last_siglev_rx_id) &&
+      (fabs(signal_strength - last_siglev) < siglev_min_change) &&
+      (now - last_siglev_time <
+        static_cast<uint64_t>(siglev_max_interval) * 1000000))
+  {
+    return;
+  }
+  siglev_reported = true;
+  last_siglev = signal_strength;
+  last_siglev_rx_id = rx_id;
+  last_siglev_time = now;
+
+  if (owner->batch_siglev)
+  {
+    owner->queueSiglev(channel, signal_strength, rx_id);
+    return;
+  }
+
+  if (use_timestamps)
+  {
+    struct timeval capture_time;
+    gettimeofday(&capture_time, NULL);
+    MsgTimestampedSiglevUpdate *msg = new MsgTimestampedSiglevUpdate(
+        capture_time, rx->signalStrength(), rx->sqlRxId());
+    sendMsg(msg);
+    return;
+  }
   MsgSiglevUpdate *msg = new MsgSiglevUpdate(rx->signalStrength(),
 					     rx->sqlRxId());
   sendMsg(msg);  
@@ -879,6 +1515,23 @@ void NetUplink::forceDisconnect(void)
 } /* NetUplink::forceDisconnect */
 
 
+void NetUplink::setState(State new_state)
+{
+  for (Channels::iterator it=channels.begin(); it!=channels.end(); ++it)
+  {
+    (*it).second->state = new_state;
+  }
+} /* NetUplink::setState */
+
+
+bool NetUplink::canSend(void) const
+{
+  return (owner != 0) &&
+         ((state == STATE_CON_SETUP) || (state == STATE_READY)) &&
+         ((channel == 0) || owner->use_channels);
+} /* NetUplink::canSend */
+
+
 /*
  * This file has not been truncated
  */
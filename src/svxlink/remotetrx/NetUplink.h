@@ -36,8 +36,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <sys/time.h>
+#include <stdint.h>
 
 #include <string>
+#include <map>
+#include <deque>
+#include <vector>
 
 
 /****************************************************************************
@@ -48,6 +52,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncTcpConnection.h>
 #include <NetTrxMsg.h>
+#include <NetTrxUdpChannel.h>
 
 
 /****************************************************************************
@@ -70,6 +75,7 @@ namespace Async
 {
   class Config;
   template <typename ConT> class TcpServer;
+  class SslContext;
   class AudioFifo;
   class Timer;
   class AudioEncoder;
@@ -130,6 +136,12 @@ namespace NetTrxMsg
 @date   2006-04-14
 
 This class implements a remote transceiver uplink via an IP network.
+
+Several uplinks can share one listen port, and thereby one client connection,
+by giving each of them a unique channel number. The first uplink that is
+initialized for a port own the TCP server and the connection. Each message
+on the connection belong to the channel that was last selected by a
+MsgSelectChannel message in the same direction.
 */
 class NetUplink : public Uplink
 {
@@ -164,8 +176,31 @@ class NetUplink : public Uplink
     {
       STATE_DISC, STATE_CON_SETUP, STATE_READY, STATE_DISC_CLEANUP
     } State;
+    typedef std::map<unsigned, NetUplink*>    Channels;
+    typedef std::map<std::string, NetUplink*> Owners;
+    struct QueuedMsg
+    {
+      unsigned              channel;
+      uint64_t              timestamp;
+      bool                  is_audio;
+      std::vector<uint8_t>  data;
+
+      QueuedMsg(unsigned channel, uint64_t timestamp, bool is_audio,
+                const void *buf, size_t size)
+        : channel(channel), timestamp(timestamp), is_audio(is_audio),
+          data(static_cast<const uint8_t*>(buf),
+               static_cast<const uint8_t*>(buf) + size) {}
+    };
+    typedef std::deque<QueuedMsg> MsgQueue;
+    typedef std::map<unsigned, NetTrxMsg::MsgSiglevBatch::Entry> PendingSiglev;
+
+    static const unsigned ANY_CHANNEL = ~0U;
+
+      // Uplinks in different threads can not share a connection
+    static thread_local Owners owners;
     
     Async::TcpServer<Async::TcpConnection>*  server;
+    Async::SslContext       *ssl_ctx;
     Async::TcpConnection    *con;
     char      	      	    recv_buf[4096];
     unsigned       	    recv_cnt;
@@ -190,6 +225,36 @@ class NetUplink : public Uplink
     bool		    tx_muted;
     bool                    fallback_enabled;
     Tx::TxCtrlMode	    tx_ctrl_mode;
+    bool                    use_timestamps;
+    NetTrxMsg::MsgBuffer    out_buf;
+    bool                    flush_pending;
+    NetTrxUdpChannel        udp_chan;
+    unsigned                audio_lost_cnt;
+    std::string             listen_port;
+    unsigned                channel;
+    NetUplink               *owner;
+    Channels                channels;
+    unsigned                tx_channel;
+    unsigned                rx_channel;
+    bool                    use_channels;
+    unsigned                max_queued_audio;
+    bool                    tx_blocked;
+    std::vector<uint8_t>    tx_pending;
+    MsgQueue                send_queue;
+    NetTrxMsg::MsgBuffer    ser_buf;
+    unsigned long           dropped_audio_cnt;
+    unsigned long           total_dropped_audio_cnt;
+    bool                    tx_passthrough;
+    float                   siglev_min_change;
+    unsigned                siglev_max_interval;
+    bool                    siglev_reported;
+    float                   last_siglev;
+    char                    last_siglev_rx_id;
+    uint64_t                last_siglev_time;
+    bool                    batch_siglev;
+    PendingSiglev           pending_siglev;
+    bool                    session_resume;
+    time_t                  session_token_expiry;
     
     NetUplink(const NetUplink&);
     NetUplink& operator=(const NetUplink&);
@@ -200,7 +265,26 @@ class NetUplink : public Uplink
       	      	      	    Async::TcpConnection::DisconnectReason reason);
     int tcpDataReceived(Async::TcpConnection *con, void *data, int size);
     void handleMsg(NetTrxMsg::Msg *msg);
+    void handleChannelMsg(NetTrxMsg::Msg *msg);
+    void channelConnected(void);
+    void channelDisconnected(void);
     void sendMsg(NetTrxMsg::Msg *msg);
+    void queueMsg(NetTrxMsg::Msg *msg, unsigned ch=ANY_CHANNEL);
+    void queueAudio(unsigned ch, const void *buf, int size,
+                    bool add_timestamp);
+    void selectTxChannel(unsigned ch);
+    void scheduleFlush(void);
+    void writeData(const void *buf, unsigned size);
+    void flushOutput(void);
+    void queueSiglev(unsigned ch, float siglev, char rx_id);
+    void sendPendingSiglev(void);
+    void tcpSendBufferFull(bool is_full);
+    void drainSendQueue(void);
+    void dropOldAudio(void);
+    void clearSendQueue(void);
+    void udpMsgReceived(NetTrxMsg::Msg *msg);
+    void sendSessionToken(void);
+    void audioPacketsLost(unsigned lost_cnt) { audio_lost_cnt += lost_cnt; }
 
     /**
      * @brief 	Set squelch state to open/closed
@@ -237,7 +321,8 @@ class NetUplink : public Uplink
     void setFallbackActive(bool activate);
     void signalLevelUpdated(float siglev);
     void forceDisconnect(void);
-    void setState(State new_state) { state = new_state; }
+    void setState(State new_state);
+    bool canSend(void) const;
 
 };  /* class NetUplink */
 
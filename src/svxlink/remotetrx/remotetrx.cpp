@@ -53,7 +53,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cstring>
 #include <cstdlib>
 #include <vector>
+#include <map>
 #include <sstream>
+#include <future>
 
 
 /****************************************************************************
@@ -63,9 +65,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncCppApplication.h>
+#include <AsyncCppEventLoopThread.h>
 #include <AsyncConfig.h>
 #include <AsyncFdWatch.h>
 #include <AsyncAudioIO.h>
+#include <AsyncRealtime.h>
 #include <Rx.h>
 #include <Tx.h>
 #include <common.h>
@@ -166,6 +170,14 @@ static void logfile_reopen(const char *reason);
 static bool logfile_write_timestamp(void);
 static void logfile_write(const char *buf);
 static void logfile_flush(void);
+static void run_in_thread(CppEventLoopThread *loop, sigc::slot<void> task);
+static void run_and_notify(sigc::slot<void> task, std::promise<void> *done);
+static void init_trx_handler(TrxHandler *trx_handler, bool *success);
+static void delete_trx_handler(TrxHandler *trx_handler);
+static bool open_config(Config &cfg, const string& cfg_filename);
+static void setup_realtime(Config &cfg);
+static void promote_trx_thread(unsigned thread_no);
+static void release_trx_thread(void);
 
 
 /****************************************************************************
@@ -187,6 +199,8 @@ static char             *pidfile_name = NULL;
 static char             *logfile_name = NULL;
 static char             *runasuser = NULL;
 static char   	      	*config = NULL;
+static char             *config_cache = NULL;
+static bool             config_from_cache = false;
 static int    	      	daemonize = 0;
 static int    	      	logfd = -1;
 static FdWatch	      	*stdin_watch = 0;
@@ -383,7 +397,7 @@ int main(int argc, char **argv)
   if (config != NULL)
   {
     cfg_filename = string(config);
-    if (!cfg.open(cfg_filename))
+    if (!open_config(cfg, cfg_filename))
     {
       cerr << "*** ERROR: Could not open configuration file: "
       	   << config << endl;
@@ -394,13 +408,13 @@ int main(int argc, char **argv)
   {
     cfg_filename = string(home_dir);
     cfg_filename += "/.svxlink/remotetrx.conf";
-    if (!cfg.open(cfg_filename))
+    if (!open_config(cfg, cfg_filename))
     {
       cfg_filename = SVX_SYSCONF_INSTALL_DIR "/remotetrx.conf";
-      if (!cfg.open(cfg_filename))
+      if (!open_config(cfg, cfg_filename))
       {
 	cfg_filename = SYSCONF_INSTALL_DIR "/remotetrx.conf";
-	if (!cfg.open(cfg_filename))
+	if (!open_config(cfg, cfg_filename))
 	{
 	  cerr << "*** ERROR: Could not open configuration file";
           if (errno != 0)
@@ -423,7 +437,7 @@ int main(int argc, char **argv)
   string main_cfg_filename(cfg_filename);
   
   string cfg_dir;
-  if (cfg.getValue("GLOBAL", "CFG_DIR", cfg_dir))
+  if (!config_from_cache && cfg.getValue("GLOBAL", "CFG_DIR", cfg_dir))
   {
     if (cfg_dir[0] != '/')
     {
@@ -469,6 +483,14 @@ int main(int argc, char **argv)
       	   << "configuration variable GLOBAL/CFG_DIR=" << cfg_dir << endl;
       exit(1);
     }
+    cfg.addDependency(cfg_dir);
+  }
+
+  if ((config_cache != NULL) && !config_from_cache &&
+      !cfg.saveSnapshot(config_cache))
+  {
+    cerr << "*** WARNING: Could not write the configuration cache file "
+         << config_cache << ": " << strerror(errno) << endl;
   }
   
   cfg.getValue("GLOBAL", "TIMESTAMP_FORMAT", tstamp_format);
@@ -482,6 +504,10 @@ int main(int argc, char **argv)
   cout << "GNU GPL (General Public License) version 2 or later.\n";
 
   cout << "\nUsing configuration file: " << main_cfg_filename << endl;
+  if (config_from_cache)
+  {
+    cout << "Configuration loaded from cache file " << config_cache << endl;
+  }
   
   string value;
   if (cfg.getValue("GLOBAL", "CARD_SAMPLE_RATE", value))
@@ -535,10 +561,17 @@ int main(int argc, char **argv)
     stdin_watch->activity.connect(sigc::ptr_fun(&stdinHandler));
   }
   
+  setup_realtime(cfg);
+
   NetRxAdapterFactory net_rx_adapter_factory;
   NetTxAdapterFactory net_tx_adapter_factory;
 
-  vector<TrxHandler*> trx_handlers;
+    // Each trx run in the main thread or, if THREAD is set, in a worker
+    // thread with its own event loop. All objects belonging to a trx are
+    // created, used and deleted in the thread that run it.
+  typedef vector<pair<TrxHandler*, CppEventLoopThread*> > TrxHandlers;
+  TrxHandlers trx_handlers;
+  map<unsigned, CppEventLoopThread*> trx_threads;
   vector<string> trxs;
   value = "";
   cfg.getValue("GLOBAL", "TRXS", value);
@@ -546,14 +579,69 @@ int main(int argc, char **argv)
   for (unsigned i=0; i<trxs.size(); ++i)
   {
     cout << "Setting up trx \"" << trxs[i] << "\"\n";
+    unsigned thread_no = 0;
+    if (!cfg.getValue(trxs[i], "THREAD", thread_no, true))
+    {
+      cerr << "*** ERROR: Illegal value for configuration variable "
+           << trxs[i] << "/THREAD\n";
+      continue;
+    }
+    CppEventLoopThread *loop = 0;
+    if (thread_no > 0)
+    {
+      map<unsigned, CppEventLoopThread*>::iterator tit =
+        trx_threads.find(thread_no);
+      if (tit != trx_threads.end())
+      {
+        loop = (*tit).second;
+      }
+      else
+      {
+        loop = new CppEventLoopThread;
+        if (!loop->start())
+        {
+          cerr << "*** ERROR: Could not start thread " << thread_no
+               << " for trx " << trxs[i] << endl;
+          delete loop;
+          continue;
+        }
+        trx_threads[thread_no] = loop;
+        if (Realtime::instance().isEnabled())
+        {
+          run_in_thread(loop, sigc::bind(sigc::ptr_fun(&promote_trx_thread),
+                                         thread_no));
+        }
+      }
+    }
     TrxHandler *trx_handler = new TrxHandler(cfg, trxs[i]);
-    if (!trx_handler->initialize())
+    bool init_ok = false;
+    if (loop != 0)
+    {
+        // The trxs are initialized one at a time so that the configuration
+        // and other process wide state is never accessed concurrently
+        // during setup
+      run_in_thread(loop, sigc::bind(sigc::ptr_fun(&init_trx_handler),
+                                     trx_handler, &init_ok));
+    }
+    else
+    {
+      init_ok = trx_handler->initialize();
+    }
+    if (!init_ok)
     {
       cerr << "*** ERROR: Failed to setup trx " << trxs[i] << endl;
-      delete trx_handler;
+      if (loop != 0)
+      {
+        run_in_thread(loop, sigc::bind(sigc::ptr_fun(&delete_trx_handler),
+                                       trx_handler));
+      }
+      else
+      {
+        delete trx_handler;
+      }
       continue;
     }
-    trx_handlers.push_back(trx_handler);
+    trx_handlers.push_back(make_pair(trx_handler, loop));
     cout << endl;
   }
   
@@ -566,14 +654,36 @@ int main(int argc, char **argv)
     cerr << "*** ERROR: No trxs successfully initialized. Bailing out...\n";
   }
 
-  for (vector<TrxHandler*>::iterator it = trx_handlers.begin();
+  for (TrxHandlers::iterator it = trx_handlers.begin();
        it != trx_handlers.end();
        ++it)
   {
-    delete *it;
+    if ((*it).second != 0)
+    {
+      run_in_thread((*it).second,
+                    sigc::bind(sigc::ptr_fun(&delete_trx_handler),
+                               (*it).first));
+    }
+    else
+    {
+      delete (*it).first;
+    }
   }
   trx_handlers.clear();
 
+  for (map<unsigned, CppEventLoopThread*>::iterator it = trx_threads.begin();
+       it != trx_threads.end();
+       ++it)
+  {
+    if (Realtime::instance().isEnabled())
+    {
+      run_in_thread((*it).second, sigc::ptr_fun(&release_trx_thread));
+    }
+    (*it).second->stop();
+    delete (*it).second;
+  }
+  trx_threads.clear();
+
   logfile_flush();
   
   if (stdin_watch != 0)
@@ -634,6 +744,9 @@ static void parse_arguments(int argc, const char **argv)
             "Specify the user to run SvxLink as", "<username>"},
     {"config", 0, POPT_ARG_STRING, &config, 0,
 	    "Specify the configuration file to use", "<filename>"},
+    {"config-cache", 0, POPT_ARG_STRING, &config_cache, 0,
+	    "Specify a file used to cache the parsed configuration",
+            "<filename>"},
     /*
     {"int_arg", 'i', POPT_ARG_INT, &int_arg, 0,
 	    "Description of int argument", "<an int>"},
@@ -914,6 +1027,123 @@ static void logfile_flush(void)
 
 
 
+/*
+ *----------------------------------------------------------------------------
+ * Function:  run_in_thread
+ * Purpose:   Run a task in a trx worker thread and wait for it to finish.
+ * Input:     loop - The event loop thread to run the task in
+ *            task - The task to run
+ * Output:    None
+ * Author:    Tobias Blomberg / SM0SVX
+ * Created:   2026-10-14
+ * Remarks:   
+ * Bugs:      
+ *----------------------------------------------------------------------------
+ */
+static void run_in_thread(CppEventLoopThread *loop, sigc::slot<void> task)
+{
+  std::promise<void> done;
+  std::future<void> done_future = done.get_future();
+  if (loop->post(sigc::bind(sigc::ptr_fun(&run_and_notify), task, &done)))
+  {
+    done_future.wait();
+  }
+} /* run_in_thread */
+
+
+static void run_and_notify(sigc::slot<void> task, std::promise<void> *done)
+{
+  task();
+  done->set_value();
+} /* run_and_notify */
+
+
+static void init_trx_handler(TrxHandler *trx_handler, bool *success)
+{
+  *success = trx_handler->initialize();
+} /* init_trx_handler */
+
+
+static void delete_trx_handler(TrxHandler *trx_handler)
+{
+  delete trx_handler;
+} /* delete_trx_handler */
+
+
+static bool open_config(Config &cfg, const string& cfg_filename)
+{
+    // A configuration cache snapshot is only used if it was created from
+    // the same main configuration file and no source file has changed since
+  if ((config_cache != NULL) && cfg.loadSnapshot(config_cache, cfg_filename))
+  {
+    config_from_cache = true;
+    return true;
+  }
+  return cfg.open(cfg_filename);
+} /* open_config */
+
+
+static void setup_realtime(Config &cfg)
+{
+  bool realtime = false;
+  cfg.getValue("GLOBAL", "REALTIME", realtime);
+  if (!realtime)
+  {
+    return;
+  }
+
+  Realtime& rt = Realtime::instance();
+  string value;
+  if (cfg.getValue("GLOBAL", "REALTIME_POLICY", value) &&
+      !rt.setPolicy(value))
+  {
+    cerr << "*** ERROR: Illegal value for config variable "
+            "GLOBAL/REALTIME_POLICY=" << value
+         << ". Valid values are FIFO and RR.\n";
+    exit(1);
+  }
+  int prio = Realtime::DEFAULT_PRIORITY;
+  cfg.getValue("GLOBAL", "REALTIME_PRIO", prio);
+  rt.setPriority(prio);
+  if (cfg.getValue("GLOBAL", "REALTIME_CPU_AFFINITY", value) &&
+      !rt.setCpuAffinity(value))
+  {
+    cerr << "*** ERROR: Illegal value for config variable "
+            "GLOBAL/REALTIME_CPU_AFFINITY=" << value << ".\n";
+    exit(1);
+  }
+  bool lock_memory = true;
+  cfg.getValue("GLOBAL", "REALTIME_LOCK_MEMORY", lock_memory);
+  rt.setLockMemory(lock_memory);
+  size_t prefault_kb = 4096;
+  cfg.getValue("GLOBAL", "REALTIME_PREFAULT_HEAP", prefault_kb);
+  rt.setPrefaultSize(prefault_kb * 1024);
+  unsigned watchdog_period = 1000;
+  cfg.getValue("GLOBAL", "REALTIME_WATCHDOG_PERIOD", watchdog_period);
+  unsigned watchdog_load = 90;
+  cfg.getValue("GLOBAL", "REALTIME_WATCHDOG_LOAD", watchdog_load);
+  rt.setWatchdog(watchdog_period, watchdog_load);
+
+  cout << "--- Entering realtime mode\n";
+  rt.enable();
+} /* setup_realtime */
+
+
+static void promote_trx_thread(unsigned thread_no)
+{
+  ostringstream ss;
+  ss << "trx thread " << thread_no;
+  Realtime::instance().promoteCurrentThread(ss.str());
+} /* promote_trx_thread */
+
+
+static void release_trx_thread(void)
+{
+  Realtime::instance().releaseThread(pthread_self());
+} /* release_trx_thread */
+
+
+
 /*
  * This file has not been truncated
  */
@@ -1,5 +1,11 @@
+#include <popt.h>
+
 #include <iostream>
+#include <fstream>
 #include <cstdlib>
+#include <cstdio>
+#include <vector>
+#include <list>
 
 #include <AsyncCppApplication.h>
 #include <AsyncConfig.h>
@@ -20,87 +26,113 @@ using namespace Async;
 static const int INTERVAL = 100;
 static const int ITERATIONS = 150;
 
+  // The calibration state for one receiver
+struct RxCal : public sigc::trackable
+{
+  RxCal(void)
+    : rx(0), siglev_slope(10.0), siglev_offset(0.0), open_sum(0.0),
+      close_sum(0.0), ctcss_snr_sum(0.0), ctcss_snr_cnt(0),
+      ctcss_open_snr(0.0f), ctcss_close_snr(0.0f)
+  {
+  }
+
+  ~RxCal(void)
+  {
+    delete rx;
+  }
+
+  void ctcssSnrUpdated(float snr)
+  {
+    ctcss_snr_sum += snr;
+    ctcss_snr_cnt += 1;
+  }
+
+  LocalRxBase *rx;
+  float     siglev_slope;
+  float     siglev_offset;
+  double    open_sum;
+  double    close_sum;
+  double    ctcss_snr_sum;
+  unsigned  ctcss_snr_cnt;
+  float     ctcss_open_snr;
+  float     ctcss_close_snr;
+};
+
 static Config cfg;
-static LocalRxBase *rx;
-static double open_sum = 0.0f;
-static double close_sum = 0.0f;
-static float siglev_slope = 10.0;
-static float siglev_offset = 0.0;
-static double ctcss_snr_sum = 0.0;
-static unsigned ctcss_snr_cnt = 0;
-static float ctcss_open_snr = 0.0f;
-static float ctcss_close_snr = 0.0f;
-
-
-#if 0
-void squelchOpen(bool is_open)
+static vector<RxCal*> rxs;
+static int iterations = ITERATIONS;
+static int meas_time = ITERATIONS * INTERVAL / 1000;
+static int cal_all = false;
+static const char *output_file = 0;
+static string cfg_file;
+static list<string> rx_names;
+
+
+static void print_signal_strength(void)
 {
-  if (is_open)
+  if (rxs.size() == 1)
   {
-    last_open_siglev = rx->signalStrength();
-    cout << "--- Release the PTT\n";
+    const RxCal *cal = rxs.front();
+    printf("Signal strength=%.3f\n",
+           cal->siglev_offset + cal->siglev_slope * cal->rx->signalStrength());
+    return;
   }
-  else
+
+  printf("Signal strength:");
+  for (vector<RxCal*>::const_iterator it=rxs.begin(); it!=rxs.end(); ++it)
   {
-    open_close_sum += last_open_siglev - rx->signalStrength();
-    close_sum += rx->signalStrength();
-    if (++open_close_cnt == ITERATIONS)
-    {
-      float open_close_mean = open_close_sum / ITERATIONS;
-      float close_mean = close_sum / ITERATIONS;
-      
-      open_close_mean /= siglev_slope;
-      close_mean -= siglev_offset;
-      close_mean /= siglev_slope;
-    
-      float new_siglev_slope = 100.0 / open_close_mean;
-      float new_siglev_offset = -close_mean * new_siglev_slope;
-      
-      printf("\n");
-      printf("SIGLEV_SLOPE=%.2f\n", new_siglev_slope);
-      printf("SIGLEV_OFFSET=%.2f\n", new_siglev_offset);
-      printf("\n");
-      exit(0);
-    }
-    else
-    {
-      cout << "--- Press the PTT (" << (ITERATIONS - open_close_cnt)
-      	   << " more times)\n";
-    }
+    const RxCal *cal = *it;
+    printf(" %s=%.3f", cal->rx->name().c_str(),
+           cal->siglev_offset + cal->siglev_slope * cal->rx->signalStrength());
   }
-} /* squelchOpen */
-#endif
+  printf("\n");
+} /* print_signal_strength */
 
 
-void sample_squelch_close(Timer *t)
+static void reset_ctcss_snr(void)
 {
-  static int count = 0;
-  printf("Signal strength=%.3f\n",
-         siglev_offset + siglev_slope * rx->signalStrength());
-  
-  close_sum += rx->signalStrength();
-  
-  if (++count == ITERATIONS)
+  for (vector<RxCal*>::iterator it=rxs.begin(); it!=rxs.end(); ++it)
   {
-    delete t;
+    (*it)->ctcss_snr_sum = 0.0;
+    (*it)->ctcss_snr_cnt = 0;
+  }
+} /* reset_ctcss_snr */
+
+
+static void print_results(void)
+{
+  ofstream out;
+  if (output_file != 0)
+  {
+    out.open(output_file);
+    if (!out)
+    {
+      cerr << "*** ERROR: Could not open output file \"" << output_file
+           << "\"\n";
+    }
+  }
+
+  for (vector<RxCal*>::const_iterator it=rxs.begin(); it!=rxs.end(); ++it)
+  {
+    RxCal *cal = *it;
 
-    float open_close_mean = (open_sum - close_sum) / ITERATIONS;
-    float close_mean = close_sum / ITERATIONS;
+    float open_close_mean = (cal->open_sum - cal->close_sum) / iterations;
+    float close_mean = cal->close_sum / iterations;
 
     float new_siglev_slope = 100.0 / open_close_mean;
     float new_siglev_offset = -close_mean * new_siglev_slope;
-    if (ctcss_snr_cnt > 0)
+    if (cal->ctcss_snr_cnt > 0)
     {
-      ctcss_close_snr = ctcss_snr_sum / ctcss_snr_cnt;
+      cal->ctcss_close_snr = cal->ctcss_snr_sum / cal->ctcss_snr_cnt;
     }
 
     cout << endl;
-    cout << "--- Results\n";
+    cout << "--- Results for " << cal->rx->name() << endl;
     printf("Mean SNR for the CTCSS tone              : ");
-    if (ctcss_snr_cnt > 0)
+    if (cal->ctcss_snr_cnt > 0)
     {
       printf("%.1fdB\n",
-             ctcss_open_snr - ctcss_close_snr);
+             cal->ctcss_open_snr - cal->ctcss_close_snr);
     }
     else
     {
@@ -111,17 +143,58 @@ void sample_squelch_close(Timer *t)
 
     cout << endl;
     cout << "--- Put the config variables below in the configuration file\n";
-    cout << "--- section for " << rx->name() << ".\n";
+    cout << "--- section for " << cal->rx->name() << ".\n";
     printf("SIGLEV_SLOPE=%.2f\n", new_siglev_slope);
     printf("SIGLEV_OFFSET=%.2f\n", new_siglev_offset);
-    if (ctcss_snr_cnt > 0)
+    if (cal->ctcss_snr_cnt > 0)
     {
-      printf("CTCSS_SNR_OFFSET=%.2f\n", ctcss_close_snr);
+      printf("CTCSS_SNR_OFFSET=%.2f\n", cal->ctcss_close_snr);
     }
     cout << endl;
-    
+
+    if (out)
+    {
+      char buf[64];
+      out << "[" << cal->rx->name() << "]\n";
+      snprintf(buf, sizeof(buf), "SIGLEV_SLOPE=%.2f\n", new_siglev_slope);
+      out << buf;
+      snprintf(buf, sizeof(buf), "SIGLEV_OFFSET=%.2f\n", new_siglev_offset);
+      out << buf;
+      if (cal->ctcss_snr_cnt > 0)
+      {
+        snprintf(buf, sizeof(buf), "CTCSS_SNR_OFFSET=%.2f\n",
+                 cal->ctcss_close_snr);
+        out << buf;
+      }
+      out << "\n";
+    }
+  }
+
+  if (out)
+  {
+    cout << "--- The results have been written to " << output_file << endl;
+  }
+} /* print_results */
+
+
+void sample_squelch_close(Timer *t)
+{
+  static int count = 0;
+  print_signal_strength();
+
+  for (vector<RxCal*>::iterator it=rxs.begin(); it!=rxs.end(); ++it)
+  {
+    (*it)->close_sum += (*it)->rx->signalStrength();
+  }
+
+  if (++count == iterations)
+  {
+    delete t;
+
+    print_results();
+
     //rx->setVerbose(true);
-    
+
     Application::app().quit();
   }
   else
@@ -134,14 +207,13 @@ void sample_squelch_close(Timer *t)
 void start_squelch_close_measurement(FdWatch *w)
 {
   int ch = getchar();
-  
+
   if (ch == '\n')
   {
     cout << "--- Starting squelch close measurement\n";
     delete w;
 
-    ctcss_snr_sum = 0.0;
-    ctcss_snr_cnt = 0;
+    reset_ctcss_snr();
 
     Timer *timer = new Timer(INTERVAL);
     // must explicitly specify name space for ptr_fun() to avoid conflict
@@ -154,25 +226,31 @@ void start_squelch_close_measurement(FdWatch *w)
 void sample_squelch_open(Timer *t)
 {
   static int count = 0;
-  printf("Signal strength=%.3f\n",
-      siglev_offset + siglev_slope * rx->signalStrength());
-  
-  open_sum += rx->signalStrength();
-  
-  if (++count == ITERATIONS)
+  print_signal_strength();
+
+  for (vector<RxCal*>::iterator it=rxs.begin(); it!=rxs.end(); ++it)
+  {
+    (*it)->open_sum += (*it)->rx->signalStrength();
+  }
+
+  if (++count == iterations)
   {
     delete t;
-    
-    if (ctcss_snr_cnt > 0)
+
+    for (vector<RxCal*>::iterator it=rxs.begin(); it!=rxs.end(); ++it)
     {
-      ctcss_open_snr = ctcss_snr_sum / ctcss_snr_cnt;
+      RxCal *cal = *it;
+      if (cal->ctcss_snr_cnt > 0)
+      {
+        cal->ctcss_open_snr = cal->ctcss_snr_sum / cal->ctcss_snr_cnt;
+      }
     }
 
     FdWatch *w = new FdWatch(0, FdWatch::FD_WATCH_RD);
     // must explicitly specify name space for ptr_fun() to avoid conflict
     // with ptr_fun() in /usr/include/c++/4.5/bits/stl_function.h
     w->activity.connect(sigc::ptr_fun(&start_squelch_close_measurement));
-    
+
     cout << endl;
     cout << "--- Release the PTT.\n";
     cout << "--- Open the squelch on the SvxLink receiver with no input signal\n";
@@ -190,55 +268,109 @@ void sample_squelch_open(Timer *t)
 void start_squelch_open_measurement(FdWatch *w)
 {
   int ch = getchar();
-  
+
   if (ch == '\n')
   {
     cout << "--- Starting squelch open measurement\n";
     delete w;
-    ctcss_snr_sum = 0.0;
-    ctcss_snr_cnt = 0;
+    reset_ctcss_snr();
     Timer *timer = new Timer(INTERVAL);
     // must explicitly specify name space for ptr_fun() to avoid conflict
     // with ptr_fun() in /usr/include/c++/4.5/bits/stl_function.h
     timer->expired.connect(sigc::ptr_fun(&sample_squelch_open));
   }
-  
+
 } /* start_squelch_open_measurement */
 
 
-void ctcss_snr_updated(float snr)
+static void parse_arguments(int argc, const char **argv)
 {
-  ctcss_snr_sum += snr;
-  ctcss_snr_cnt += 1;
-}
+  poptContext optCon;
+  const struct poptOption optionsTable[] =
+  {
+    POPT_AUTOHELP
+    {"all", 'a', POPT_ARG_NONE, &cal_all, 0,
+            "Calibrate all local receivers in the configuration", NULL},
+    {"time", 't', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT, &meas_time, 0,
+            "The length of each measurement", "<seconds>"},
+    {"output", 'o', POPT_ARG_STRING, &output_file, 0,
+            "Write the resulting config variables to a file", "<filename>"},
+    {NULL, 0, 0, NULL, 0}
+  };
+  int err;
+
+  optCon = poptGetContext(PROGRAM_NAME, argc, argv, optionsTable, 0);
+  poptSetOtherOptionHelp(optCon,
+      "<config file> [<receiver section>...]");
+  poptReadDefaultConfig(optCon, 0);
+
+  err = poptGetNextOpt(optCon);
+  if (err != -1)
+  {
+    cerr << "*** ERROR: " << poptBadOption(optCon, POPT_BADOPTION_NOALIAS)
+         << ": " << poptStrerror(err) << endl;
+    poptPrintUsage(optCon, stderr, 0);
+    exit(1);
+  }
 
+    /* Parse arguments that do not begin with '-' (leftovers) */
+  const char *arg = 0;
+  while ((arg = poptGetArg(optCon)) != NULL)
+  {
+    if (cfg_file.empty())
+    {
+      cfg_file = arg;
+    }
+    else
+    {
+      rx_names.push_back(arg);
+    }
+  }
+
+  if (cfg_file.empty() || (rx_names.empty() && !cal_all))
+  {
+    poptPrintUsage(optCon, stderr, 0);
+    exit(1);
+  }
+  if (cal_all && !rx_names.empty())
+  {
+    cerr << "*** ERROR: Receiver sections cannot be given together with "
+            "the --all command line option\n";
+    exit(1);
+  }
+
+  if (meas_time < 1)
+  {
+    cerr << "*** ERROR: The measurement time must be at least one second\n";
+    exit(1);
+  }
+  iterations = meas_time * 1000 / INTERVAL;
+
+  poptFreeContext(optCon);
+
+} /* parse_arguments */
 
-int main(int argc, char **argv)
+
+int main(int argc, const char **argv)
 {
   CppApplication app;
-  
+
   cout << PROGRAM_NAME " v" SIGLEV_DET_CAL_VERSION
-          " Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX\n\n";
+          " Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX\n\n";
   cout << PROGRAM_NAME " comes with ABSOLUTELY NO WARRANTY. "
           "This is free software, and you\n";
   cout << "are welcome to redistribute it in accordance with the "
           "terms and conditions in\n";
   cout << "the GNU GPL (General Public License) version 2 or later.\n\n";
 
-  if (argc < 3)
-  {
-    cerr << "Usage: siglevdetcal <config file> <receiver section>\n";
-    exit(1);
-  }
-  string cfg_file(argv[1]);
-  string rx_name(argv[2]);
-  
+  parse_arguments(argc, argv);
+
   if (!cfg.open(cfg_file))
   {
     cerr << "*** ERROR: Could not open config file \"" << cfg_file << "\"\n";
     exit(1);
   }
-  
+
   string value;
   if (cfg.getValue("GLOBAL", "CARD_SAMPLE_RATE", value))
   {
@@ -273,67 +405,112 @@ int main(int argc, char **argv)
     AudioIO::setSampleRate(rate);
     cout << "--- Using sample rate " << rate << "Hz\n";
   }
-  
-  string rx_type;
-  if (!cfg.getValue(rx_name, "TYPE", rx_type))
+
+  if (cal_all)
   {
-    cerr << "*** ERROR: Config variable " << rx_name << "/TYPE not set. "
-         << "Are you sure \"" << rx_name << "\" is an existing receiver config "
-	 << "section?\n";
-    exit(1);
+    list<string> sections = cfg.listSections();
+    for (list<string>::const_iterator it=sections.begin();
+         it!=sections.end(); ++it)
+    {
+      string rx_type;
+      if (cfg.getValue(*it, "TYPE", rx_type) &&
+          ((rx_type == "Local") || (rx_type == "Ddr")))
+      {
+        rx_names.push_back(*it);
+      }
+    }
+    if (rx_names.empty())
+    {
+      cerr << "*** ERROR: No local receivers found in the configuration\n";
+      exit(1);
+    }
   }
 
-    // Make sure we have CTCSS squelch enabled
-  //cfg.setValue(rx_name, "SQL_DET", "CTCSS");
-
-    // Make sure that the squelch will not open during calibration
-  cfg.setValue(rx_name, "CTCSS_OPEN_THRESH", "100");
-  cfg.setValue(rx_name, "SIGLEV_OPEN_THRESH", "10000");
-  
-    // Make sure we are using the "Noise" siglev detector
-  //cfg.setValue(rx_name, "SIGLEV_DET", "NOISE");
-
-    // Read the configured siglev slope and offset, then clear them so that
-    // they cannot affect the measurement.
-  cfg.getValue(rx_name, "SIGLEV_SLOPE", siglev_slope);
-  cfg.setValue(rx_name, "SIGLEV_SLOPE", "1.0");
-  cfg.getValue(rx_name, "SIGLEV_OFFSET", siglev_offset);
-  cfg.setValue(rx_name, "SIGLEV_OFFSET", "0.0");
-  
-  rx = dynamic_cast<LocalRxBase*>(RxFactory::createNamedRx(cfg, rx_name));
-  if (rx == 0)
+  for (list<string>::const_iterator it=rx_names.begin();
+       it!=rx_names.end(); ++it)
   {
-    cerr << "*** ERROR: The given receiver config section is not for a "
-         << "local receiver. Calibration can only be done locally.\n";
-    exit(1);
+    const string &rx_name = *it;
+    string rx_type;
+    if (!cfg.getValue(rx_name, "TYPE", rx_type))
+    {
+      cerr << "*** ERROR: Config variable " << rx_name << "/TYPE not set. "
+           << "Are you sure \"" << rx_name << "\" is an existing receiver "
+           << "config section?\n";
+      exit(1);
+    }
+
+      // Make sure we have CTCSS squelch enabled
+    //cfg.setValue(rx_name, "SQL_DET", "CTCSS");
+
+      // Make sure that the squelch will not open during calibration
+    cfg.setValue(rx_name, "CTCSS_OPEN_THRESH", "100");
+    cfg.setValue(rx_name, "SIGLEV_OPEN_THRESH", "10000");
+
+      // Make sure we are using the "Noise" siglev detector
+    //cfg.setValue(rx_name, "SIGLEV_DET", "NOISE");
+
+    RxCal *cal = new RxCal;
+    rxs.push_back(cal);
+
+      // Read the configured siglev slope and offset, then clear them so that
+      // they cannot affect the measurement.
+    cfg.getValue(rx_name, "SIGLEV_SLOPE", cal->siglev_slope);
+    cfg.setValue(rx_name, "SIGLEV_SLOPE", "1.0");
+    cfg.getValue(rx_name, "SIGLEV_OFFSET", cal->siglev_offset);
+    cfg.setValue(rx_name, "SIGLEV_OFFSET", "0.0");
+
+    cal->rx = dynamic_cast<LocalRxBase*>(
+        RxFactory::createNamedRx(cfg, rx_name));
+    if (cal->rx == 0)
+    {
+      cerr << "*** ERROR: The config section \"" << rx_name << "\" is not "
+           << "for a local receiver. Calibration can only be done locally.\n";
+      exit(1);
+    }
+    if (!cal->rx->initialize())
+    {
+      cerr << "*** ERROR: Could not initialize receiver \"" << rx_name
+           << "\"\n";
+      exit(1);
+    }
+    // must explicitly specify name space for ptr_fun() to avoid conflict
+    // with ptr_fun() in /usr/include/c++/4.5/bits/stl_function.h
+    //rx->squelchOpen.connect(sigc::ptr_fun(&squelchOpen));
+    cal->rx->ctcssSnrUpdated.connect(
+        sigc::mem_fun(*cal, &RxCal::ctcssSnrUpdated));
+    cal->rx->setMuteState(Rx::MUTE_NONE);
+    cal->rx->setVerbose(false);
   }
-  if (!rx->initialize())
+
+  if (rxs.size() > 1)
   {
-    cerr << "*** ERROR: Could not initialize receiver \"" << rx_name << "\"\n";
-    exit(1);
+    cout << "--- Calibrating " << rxs.size()
+         << " receivers at the same time:";
+    for (vector<RxCal*>::const_iterator it=rxs.begin(); it!=rxs.end(); ++it)
+    {
+      cout << " " << (*it)->rx->name();
+    }
+    cout << endl;
   }
-  // must explicitly specify name space for ptr_fun() to avoid conflict
-  // with ptr_fun() in /usr/include/c++/4.5/bits/stl_function.h
-  //rx->squelchOpen.connect(sigc::ptr_fun(&squelchOpen));
-  rx->ctcssSnrUpdated.connect(sigc::ptr_fun(&ctcss_snr_updated));
-  rx->setMuteState(Rx::MUTE_NONE);
-  rx->setVerbose(false);
-  
+
   FdWatch *w = new FdWatch(0, FdWatch::FD_WATCH_RD);
   // must explicitly specify name space for ptr_fun() to avoid conflict
   // with ptr_fun() in /usr/include/c++/4.5/bits/stl_function.h
   w->activity.connect(sigc::ptr_fun(&start_squelch_open_measurement));
-  
+
   //cout << "--- Press the PTT (" << ITERATIONS << " more times)\n";
-  
+
   cout << "--- Adjust the audio input level to a suitable level.\n";
   cout << "--- Transmit a strong signal into the SvxLink receiver.\n";
   cout << "--- This will represent the strongest possible input signal.\n";
   cout << "--- Don't release the PTT until told so.\n";
   cout << "--- Press ENTER when ready.\n";
-  
+
   app.exec();
-  
-  delete rx;
-  
+
+  for (vector<RxCal*>::iterator it=rxs.begin(); it!=rxs.end(); ++it)
+  {
+    delete *it;
+  }
+
 } /* main */
@@ -112,21 +112,37 @@ using namespace std;
 
 CmdParser::~CmdParser(void)
 {
-  CmdMap cmds_copy = cmds;
-  CmdMap::iterator it;
-  for (it = cmds_copy.begin(); it != cmds_copy.end(); ++it)
+    // Deleting a command will remove it from the parser so the commands are
+    // collected first
+  vector<Command*> cmds;
+  collectCmds(root, cmds);
+  vector<Command*>::iterator it;
+  for (it = cmds.begin(); it != cmds.end(); ++it)
   {
-    delete (*it).second;
+    delete *it;
   }
+  delete root;
 } /* CmdParser::~CmdParser */
 
 
 bool CmdParser::addCmd(Command *cmd)
 {
-  bool cmd_undefined = (cmds.count(cmd->cmdStr()) == 0);
+  const string& cmd_str = cmd->cmdStr();
+  Node *node = root;
+  for (string::const_iterator it = cmd_str.begin(); it != cmd_str.end(); ++it)
+  {
+    Node *&child = node->children[*it];
+    if (child == 0)
+    {
+      child = new Node;
+    }
+    node = child;
+  }
+
+  bool cmd_undefined = (node->cmd == 0);
   if (cmd_undefined)
   {
-    cmds[cmd->cmdStr()] = cmd;
+    node->cmd = cmd;
   }
   return cmd_undefined;
 } /* CmdParser::addCmd */
@@ -134,33 +150,77 @@ bool CmdParser::addCmd(Command *cmd)
 
 bool CmdParser::removeCmd(Command *cmd)
 {
-  CmdMap::iterator cmd_it = cmds.find(cmd->cmdStr());
-  bool cmd_exist = (cmd_it != cmds.end());
-  if (cmd_exist)
+  const string& cmd_str = cmd->cmdStr();
+  vector<Node*> path;
+  path.reserve(cmd_str.size() + 1);
+  Node *node = root;
+  path.push_back(node);
+  for (string::const_iterator it = cmd_str.begin(); it != cmd_str.end(); ++it)
   {
-    cmds.erase(cmd_it);
+    Node::Children::iterator child_it = node->children.find(*it);
+    if (child_it == node->children.end())
+    {
+      return false;
+    }
+    node = child_it->second;
+    path.push_back(node);
   }
-  return cmd_exist;
+
+  if (node->cmd != cmd)
+  {
+    return false;
+  }
+  node->cmd = 0;
+
+    // Prune the branch that no longer lead to any command
+  for (size_t i = path.size() - 1; i > 0; --i)
+  {
+    Node *n = path[i];
+    if ((n->cmd != 0) || !n->children.empty())
+    {
+      break;
+    }
+    path[i-1]->children.erase(cmd_str[i-1]);
+    delete n;
+  }
+
+  return true;
 } /* CmdParser::removeCmd */
 
 
 bool CmdParser::processCmd(const string& cmd_str)
 {
-  int len = cmd_str.size();
-  while (len > 0)
+  size_t len = 0;
+  Command *cmd = findLongestMatch(cmd_str, len);
+  if (cmd == 0)
   {
-    if (cmds.count(cmd_str.substr(0, len)) > 0)
-    {
-      Command *cmd = cmds[cmd_str.substr(0, len)];
-      (*cmd)(cmd_str.substr(len, cmd_str.size()-len));
-      return true;
-    }
-    --len;
+    return false;
   }
 
-  return false;
-  
+  (*cmd)(cmd_str.substr(len));
+  return true;
 } /* CmdParser::processCmd */
+
+
+bool CmdParser::cmdIsComplete(const string& cmd_str) const
+{
+  size_t len = 0;
+  const Node *last_node = 0;
+  Command *cmd = findLongestMatch(cmd_str, len, &last_node);
+  if (cmd == 0)
+  {
+    return false;
+  }
+
+    // Some other command may still be entered if all digits were consumed
+    // by the tree and there are longer commands below the last node
+  if ((last_node != 0) && !last_node->children.empty())
+  {
+    return false;
+  }
+
+  return cmd->subcmdIsComplete(cmd_str.substr(len));
+} /* CmdParser::cmdIsComplete */
     
 
 
@@ -196,6 +256,60 @@ bool CmdParser::processCmd(const string& cmd_str)
  *
  ****************************************************************************/
 
+CmdParser::Node::~Node(void)
+{
+  for (Children::iterator it = children.begin(); it != children.end(); ++it)
+  {
+    delete it->second;
+  }
+} /* CmdParser::Node::~Node */
+
+
+Command *CmdParser::findLongestMatch(const string& cmd_str, size_t& len,
+                                     const Node **last_node) const
+{
+  Command *cmd = 0;
+  len = 0;
+  const Node *node = root;
+  size_t pos = 0;
+  while (pos < cmd_str.size())
+  {
+    Node::Children::const_iterator it = node->children.find(cmd_str[pos]);
+    if (it == node->children.end())
+    {
+      node = 0;
+      break;
+    }
+    node = it->second;
+    ++pos;
+    if (node->cmd != 0)
+    {
+      cmd = node->cmd;
+      len = pos;
+    }
+  }
+
+  if (last_node != 0)
+  {
+    *last_node = node;
+  }
+  return cmd;
+} /* CmdParser::findLongestMatch */
+
+
+void CmdParser::collectCmds(const Node *node, vector<Command*>& cmds)
+{
+  if (node->cmd != 0)
+  {
+    cmds.push_back(node->cmd);
+  }
+  Node::Children::const_iterator it;
+  for (it = node->children.begin(); it != node->children.end(); ++it)
+  {
+    collectCmds(it->second, cmds);
+  }
+} /* CmdParser::collectCmds */
+
 
 /*
  *----------------------------------------------------------------------------
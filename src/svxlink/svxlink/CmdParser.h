@@ -38,6 +38,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <map>
 #include <string>
+#include <vector>
 #include <cassert>
 
 
@@ -113,6 +114,10 @@ class Command;
 
 This is the DTMF command parser engine implementation. Add commands based on
 the Command class.
+
+The commands are stored in a prefix tree with one node per command digit so
+that the longest matching command is found in a single pass over the received
+digits.
 */
 class CmdParser
 {
@@ -120,7 +125,7 @@ class CmdParser
     /**
      * @brief 	Default constuctor
      */
-    CmdParser(void) {}
+    CmdParser(void) : root(new Node) {}
   
     /**
      * @brief 	Destructor
@@ -147,13 +152,38 @@ class CmdParser
      * @return	Returns \em true if the command was found or else \em false
      */
     bool processCmd(const std::string& cmd_str);
-    
+
+    /**
+     * @brief   Check if a command string can be executed right away
+     * @param   cmd_str The digits received so far
+     * @return  Returns \em true if more digits cannot change the outcome
+     *
+     * A command string is considered complete if it match a command that
+     * consider its subcommand complete and no other command begin with the
+     * given digits. Entering more digits would in that case only produce an
+     * invalid subcommand so the command can be executed without waiting for
+     * the end of command to be signalled.
+     */
+    bool cmdIsComplete(const std::string& cmd_str) const;
     
   protected:
     
   private:
-    typedef std::map<std::string, Command *> CmdMap;
-    CmdMap cmds;
+    struct Node
+    {
+      typedef std::map<char, Node *> Children;
+      Command  *cmd;
+      Children children;
+      Node(void) : cmd(0) {}
+      ~Node(void);
+    };
+    Node *root;
+
+    CmdParser(const CmdParser&);
+    CmdParser& operator=(const CmdParser&);
+    Command *findLongestMatch(const std::string& cmd_str, size_t& len,
+                              const Node **last_node=0) const;
+    static void collectCmds(const Node *node, std::vector<Command*>& cmds);
     
 };  /* class CmdParser */
 
@@ -217,6 +247,21 @@ class Command : public sigc::trackable
     {
       handleCmd(this, subcmd);
     }
+
+    /**
+     * @brief   Check if a subcommand is complete
+     * @param   subcmd The subcommand received so far
+     * @return  Returns \em true if no more digits can follow the subcommand
+     *
+     * Reimplement this function in commands that have a fixed set of
+     * subcommands to allow the command to be executed as soon as the last
+     * digit has been received. The default is to always wait for the end of
+     * command to be signalled.
+     */
+    virtual bool subcmdIsComplete(const std::string& subcmd) const
+    {
+      return false;
+    }
     
     /**
      * @brief	A signal that is emitted to handle the command
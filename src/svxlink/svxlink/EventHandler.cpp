@@ -32,10 +32,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+
 #include <iostream>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -45,6 +50,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncApplication.h>
+#include <AsyncFdWatch.h>
 
 
 
@@ -76,6 +82,9 @@ using namespace Async;
  *
  ****************************************************************************/
 
+  // The maximum number of different events to keep compiled. Events with
+  // varying arguments would otherwise make the cache grow without bounds.
+#define EVENT_CACHE_SIZE    256
 
 
 /****************************************************************************
@@ -119,7 +128,8 @@ using namespace Async;
 
 
 EventHandler::EventHandler(const string& event_script, const string& logic_name)
-  : event_script(event_script), logic_name(logic_name), interp(0)
+  : event_script(event_script), logic_name(logic_name), interp(0),
+    inotify_fd(-1), inotify_watch(0)
 {
   interp = Tcl_CreateInterp();
   if (interp == 0)
@@ -143,6 +153,8 @@ EventHandler::EventHandler(const string& event_script, const string& logic_name)
   Tcl_CreateCommand(interp, "playTone", playToneHandler, this, NULL);
   Tcl_CreateCommand(interp, "recordStart", recordHandler, this, NULL);
   Tcl_CreateCommand(interp, "recordStop", recordHandler, this, NULL);
+  Tcl_CreateCommand(interp, "beginSequence", sequenceHandler, this, NULL);
+  Tcl_CreateCommand(interp, "endSequence", sequenceHandler, this, NULL);
   Tcl_CreateCommand(interp, "deactivateModule", deactivateModuleHandler,
                     this, NULL);
   Tcl_CreateCommand(interp, "publishStateEvent", publishStateEventHandler,
@@ -151,6 +163,8 @@ EventHandler::EventHandler(const string& event_script, const string& logic_name)
   Tcl_CreateCommand(interp, "injectDtmf", injectDtmfHandler, this, NULL);
   Tcl_CreateCommand(interp, "setConfigValue", setConfigValueHandler,
                     this, NULL);
+  Tcl_CreateCommand(interp, "watchDirectory", watchDirectoryHandler,
+                    this, NULL);
 
   setVariable("script_path", event_script);
 
@@ -159,6 +173,12 @@ EventHandler::EventHandler(const string& event_script, const string& logic_name)
 
 EventHandler::~EventHandler(void)
 {
+  delete inotify_watch;
+  if (inotify_fd >= 0)
+  {
+    close(inotify_fd);
+  }
+  clearEventCache();
   if (interp != 0)
   {
     Tcl_Preserve(interp);
@@ -217,13 +237,19 @@ bool EventHandler::processEvent(const string& event)
   
   bool success = true;
   Tcl_Preserve(interp);
-  if (Tcl_Eval(interp, (event + ";").c_str()) != TCL_OK)
+
+    // Hold a reference since the event may cause other events to be
+    // processed, which may clear the cache
+  Tcl_Obj *event_obj = eventObj(event);
+  Tcl_IncrRefCount(event_obj);
+  if (Tcl_EvalObjEx(interp, event_obj, 0) != TCL_OK)
   {
     cerr << "*** ERROR: Unable to handle event: " << event
          << " in logic " << logic_name << " ("
          << Tcl_GetStringResult(interp) << ")" << endl;
     success = false;
   }
+  Tcl_DecrRefCount(event_obj);
   Tcl_Release(interp);
   
   return success;
@@ -231,6 +257,54 @@ bool EventHandler::processEvent(const string& event)
 } /* EventHandler::processEvent */
 
 
+bool EventHandler::processEvent(const string& name, int objc,
+                                Tcl_Obj *const objv[])
+{
+  assert((objc >= 0) && (objc <= MAX_EVENT_ARGS));
+
+  for (int i=0; i<objc; ++i)
+  {
+    Tcl_IncrRefCount(objv[i]);
+  }
+
+  bool success = (interp != 0);
+  if (success)
+  {
+    Tcl_Preserve(interp);
+
+      // The cached name object keep the resolved command between calls
+    Tcl_Obj *cmd[MAX_EVENT_ARGS + 1];
+    cmd[0] = eventObj(name);
+    Tcl_IncrRefCount(cmd[0]);
+    copy(objv, objv + objc, cmd + 1);
+    if (Tcl_EvalObjv(interp, objc + 1, cmd, TCL_EVAL_GLOBAL) != TCL_OK)
+    {
+      cerr << "*** ERROR: Unable to handle event: " << name
+           << " in logic " << logic_name << " ("
+           << Tcl_GetStringResult(interp) << ")" << endl;
+      success = false;
+    }
+    Tcl_DecrRefCount(cmd[0]);
+    Tcl_Release(interp);
+  }
+
+  for (int i=0; i<objc; ++i)
+  {
+    Tcl_DecrRefCount(objv[i]);
+  }
+
+  return success;
+
+} /* EventHandler::processEvent */
+
+
+bool EventHandler::hasHandler(const string& name) const
+{
+  Tcl_CmdInfo info;
+  return (interp != 0) && (Tcl_GetCommandInfo(interp, name.c_str(), &info) != 0);
+} /* EventHandler::hasHandler */
+
+
 const string EventHandler::eventResult(void) const
 {
   if (interp == 0)
@@ -274,6 +348,128 @@ const string EventHandler::eventResult(void) const
  *
  ****************************************************************************/
 
+Tcl_Obj *EventHandler::eventObj(const string& event)
+{
+  EventCache::iterator it = event_cache.find(event);
+  if (it != event_cache.end())
+  {
+    return (*it).second;
+  }
+
+  if (event_cache.size() >= EVENT_CACHE_SIZE)
+  {
+    clearEventCache();
+  }
+  Tcl_Obj *event_obj = Tcl_NewStringObj(event.data(), event.size());
+  Tcl_IncrRefCount(event_obj);
+  event_cache[event] = event_obj;
+  return event_obj;
+} /* EventHandler::eventObj */
+
+
+void EventHandler::clearEventCache(void)
+{
+  for (EventCache::iterator it=event_cache.begin(); it!=event_cache.end();
+       ++it)
+  {
+    Tcl_DecrRefCount((*it).second);
+  }
+  event_cache.clear();
+} /* EventHandler::clearEventCache */
+
+
+bool EventHandler::watchDirectory(const string& dir, const string& callback)
+{
+  if (inotify_fd < 0)
+  {
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0)
+    {
+      cerr << "*** WARNING: Could not create inotify instance in logic "
+           << logic_name << ": " << strerror(errno) << endl;
+      return false;
+    }
+    inotify_watch = new FdWatch(inotify_fd, FdWatch::FD_WATCH_RD);
+    inotify_watch->activity.connect(
+        mem_fun(*this, &EventHandler::onDirActivity));
+  }
+
+    // Files are reported when they have been completely written or when
+    // they have been moved into the directory
+  int wd = inotify_add_watch(inotify_fd, dir.c_str(),
+                             IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+  if (wd < 0)
+  {
+    cerr << "*** WARNING: Could not watch directory \"" << dir
+         << "\" in logic " << logic_name << ": " << strerror(errno) << endl;
+    return false;
+  }
+  DirWatch& dir_watch = dir_watches[wd];
+  dir_watch.dir = dir;
+  dir_watch.callback = callback;
+  return true;
+} /* EventHandler::watchDirectory */
+
+
+void EventHandler::onDirActivity(FdWatch *watch)
+{
+  char buf[4096]
+    __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  for (;;)
+  {
+    ssize_t len = read(inotify_fd, buf, sizeof(buf));
+    if (len <= 0)
+    {
+      if ((len < 0) && (errno != EAGAIN) && (errno != EINTR))
+      {
+        cerr << "*** WARNING: Could not read inotify events in logic "
+             << logic_name << ": " << strerror(errno) << endl;
+      }
+      return;
+    }
+
+    for (char *ptr = buf; ptr < buf + len; )
+    {
+      const struct inotify_event *event =
+        reinterpret_cast<const struct inotify_event *>(ptr);
+      ptr += sizeof(struct inotify_event) + event->len;
+
+      DirWatchMap::iterator it = dir_watches.find(event->wd);
+      if (it == dir_watches.end())
+      {
+        continue;
+      }
+      if (event->mask & IN_IGNORED)
+      {
+          // The directory has been removed
+        dir_watches.erase(it);
+        continue;
+      }
+      if (event->len == 0)
+      {
+        continue;
+      }
+
+      const string path = it->second.dir + "/" + event->name;
+      Tcl_Obj *cmd = Tcl_NewStringObj(it->second.callback.data(),
+                                      it->second.callback.size());
+      Tcl_IncrRefCount(cmd);
+      Tcl_Preserve(interp);
+      if ((Tcl_ListObjAppendElement(interp, cmd,
+              Tcl_NewStringObj(path.data(), path.size())) != TCL_OK) ||
+          (Tcl_EvalObjEx(interp, cmd, TCL_EVAL_GLOBAL) != TCL_OK))
+      {
+        cerr << "*** ERROR: Unable to handle new file " << path
+             << " in logic " << logic_name << " ("
+             << Tcl_GetStringResult(interp) << ")" << endl;
+      }
+      Tcl_Release(interp);
+      Tcl_DecrRefCount(cmd);
+    }
+  }
+} /* EventHandler::onDirActivity */
+
+
 int EventHandler::playFileHandler(ClientData cdata, Tcl_Interp *irp, int argc,
       	      	      	   const char *argv[])
 {
@@ -368,6 +564,30 @@ int EventHandler::recordHandler(ClientData cdata, Tcl_Interp *irp,
 }
 
 
+int EventHandler::sequenceHandler(ClientData cdata, Tcl_Interp *irp,
+      	      	      	      int argc, const char *argv[])
+{
+  if(argc != 1)
+  {
+    static char msg[] = "Usage: beginSequence | endSequence";
+    Tcl_SetResult(irp, msg, TCL_STATIC);
+    return TCL_ERROR;
+  }
+
+  EventHandler *self = static_cast<EventHandler *>(cdata);
+  if (strcmp(argv[0], "beginSequence") == 0)
+  {
+    self->beginSequence();
+  }
+  else
+  {
+    self->endSequence();
+  }
+
+  return TCL_OK;
+}
+
+
 int EventHandler::deactivateModuleHandler(ClientData cdata, Tcl_Interp *irp,
       	      	      	      int argc, const char *argv[])
 {
@@ -464,6 +684,23 @@ int EventHandler::setConfigValueHandler(ClientData cdata, Tcl_Interp *irp,
 } /* EventHandler::setConfigValueHandler */
 
 
+int EventHandler::watchDirectoryHandler(ClientData cdata, Tcl_Interp *irp,
+                                        int argc, const char *argv[])
+{
+  if(argc != 3)
+  {
+    static char msg[] = "Usage: watchDirectory <directory> <callback>";
+    Tcl_SetResult(irp, msg, TCL_STATIC);
+    return TCL_ERROR;
+  }
+  EventHandler *self = static_cast<EventHandler *>(cdata);
+  bool success = self->watchDirectory(argv[1], argv[2]);
+  Tcl_SetObjResult(irp, Tcl_NewBooleanObj(success));
+
+  return TCL_OK;
+} /* EventHandler::watchDirectoryHandler */
+
+
 /*
  * This file has not been truncated
  */
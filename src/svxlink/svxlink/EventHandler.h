@@ -39,6 +39,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <string>
 #include <sstream>
+#include <map>
 
 
 /****************************************************************************
@@ -63,6 +64,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+namespace Async
+{
+  class FdWatch;
+};
 
 
 /****************************************************************************
@@ -148,8 +153,34 @@ class EventHandler : public sigc::trackable
      * @brief 	Process the given event
      * @param 	event The event must be a valid TCL function call
      * @return	Returns \em true on success or else \em false
+     *
+     * The event is evaluated as a script object that is kept in a cache so
+     * that TCL can reuse the compiled byte code the next time the same
+     * event is processed.
      */
     bool processEvent(const std::string& event);
+
+    /**
+     * @brief 	Call an event function with the given arguments
+     * @param 	name  The name of the TCL function to call
+     * @param 	objc  The number of arguments
+     * @param 	objv  The arguments
+     * @return	Returns \em true on success or else \em false
+     *
+     * The arguments are passed to the function as they are so nothing have
+     * to be quoted or parsed. The reference count of each argument is
+     * increased during the call and then decreased again so newly created
+     * objects are freed when the call returns.
+     */
+    bool processEvent(const std::string& name, int objc,
+                      Tcl_Obj *const objv[]);
+
+    /**
+     * @brief 	Check if a TCL function or command is defined
+     * @param 	name The name of the function
+     * @return	Returns \em true if the function exist or else \em false
+     */
+    bool hasHandler(const std::string& name) const;
   
     /**
      * @brief 	Return the event result from the last call
@@ -189,6 +220,21 @@ class EventHandler : public sigc::trackable
      */
     sigc::signal<void, const std::string&, int, int> playDtmf;
 
+    /**
+     * @brief 	A signal that is emitted when the TCL script want to start
+     *	      	an announcement sequence
+     *
+     * All audio played until endSequence is emitted should be rendered and
+     * cached as one announcement.
+     */
+    sigc::signal<void>       	      	    beginSequence;
+
+    /**
+     * @brief 	A signal that is emitted when the TCL script want to end
+     *	      	an announcement sequence
+     */
+    sigc::signal<void>       	      	    endSequence;
+
     /**
      * @brief 	A signal that is emitted when the TCL script want to start
      *	      	a recording
@@ -239,9 +285,28 @@ class EventHandler : public sigc::trackable
   protected:
 
   private:
-    std::string   event_script;
-    std::string   logic_name;
-    Tcl_Interp *  interp;
+    typedef std::map<std::string, Tcl_Obj*> EventCache;
+    struct DirWatch
+    {
+      std::string dir;
+      std::string callback;
+    };
+    typedef std::map<int, DirWatch> DirWatchMap;
+
+    static const int MAX_EVENT_ARGS = 8;
+
+    std::string     event_script;
+    std::string     logic_name;
+    Tcl_Interp *    interp;
+    EventCache      event_cache;
+    int             inotify_fd;
+    Async::FdWatch *inotify_watch;
+    DirWatchMap     dir_watches;
+
+    Tcl_Obj *eventObj(const std::string& event);
+    void clearEventCache(void);
+    bool watchDirectory(const std::string& dir, const std::string& callback);
+    void onDirActivity(Async::FdWatch *watch);
 
     static int playFileHandler(ClientData cdata, Tcl_Interp *irp,
       	      	    int argc, const char *argv[]);
@@ -251,6 +316,8 @@ class EventHandler : public sigc::trackable
       	      	    int argc, const char *argv[]);
     static int recordHandler(ClientData cdata, Tcl_Interp *irp,
       	      	    int argc, const char *argv[]);
+    static int sequenceHandler(ClientData cdata, Tcl_Interp *irp,
+      	      	    int argc, const char *argv[]);
     static int deactivateModuleHandler(ClientData cdata, Tcl_Interp *irp,
       	      	    int argc, const char *argv[]);
     static int publishStateEventHandler(ClientData cdata, Tcl_Interp *irp,
@@ -261,6 +328,8 @@ class EventHandler : public sigc::trackable
                     int argc, const char *argv[]);
     static int setConfigValueHandler(ClientData cdata, Tcl_Interp *irp,
                     int argc, const char *argv[]);
+    static int watchDirectoryHandler(ClientData cdata, Tcl_Interp *irp,
+                    int argc, const char *argv[]);
 
 };  /* class EventHandler */
 
@@ -100,6 +100,7 @@ namespace
  *
  ****************************************************************************/
 
+unsigned find_root(vector<unsigned> &groups, unsigned id);
 
 
 /****************************************************************************
@@ -117,6 +118,25 @@ namespace
  ****************************************************************************/
 
 
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+  // Find the root of a union-find tree, halving the path on the way
+unsigned find_root(vector<unsigned> &groups, unsigned id)
+{
+  while (groups[id] != id)
+  {
+    groups[id] = groups[groups[id]];
+    id = groups[id];
+  }
+  return id;
+} /* find_root */
+
+
 } // End of anonymous namespace
 
 /****************************************************************************
@@ -289,27 +309,40 @@ void LinkManager::addLogic(LogicBase *logic)
   sinks[logic->name()].sink = logic->logicConIn();
   sinks[logic->name()].selector = selector;
 
+    // The logic is given an integer id which is used when the connections
+    // are updated
+  const unsigned id = logic_ids.size();
+  logic_ids.push_back(0);
+
     // Now create a connection from the new logic source to each sink.
   for (SinkMap::iterator it=sinks.begin(); it != sinks.end(); ++it)
   {
     AudioPassthrough *connector = new AudioPassthrough;
     splitter->addSink(connector, true);
+    splitter->enableSink(connector, false);
     AudioSelector *other_selector = (*it).second.selector;
     other_selector->addSource(connector);
     (*it).second.connectors[logic->name()] = connector;
+    (*it).second.connectors_by_id.resize(logic_ids.size(), 0);
+    (*it).second.connectors_by_id[id] = connector;
   }
 
     // Now create a connection from each existing logic source to the new sink.
+  SinkInfo &sink_info = sinks[logic->name()];
   for (SourceMap::iterator it=sources.begin(); it!=sources.end(); ++it)
   {
     AudioPassthrough *connector = new AudioPassthrough;
     (*it).second.splitter->addSink(connector, true);
+    (*it).second.splitter->enableSink(connector, false);
     selector->addSource(connector);
-    sinks[logic->name()].connectors[(*it).first] = connector;
+    sink_info.connectors[(*it).first] = connector;
+    unsigned src_id =
+      ((*it).first == logic->name()) ? id : logic_map.at((*it).first).id;
+    sink_info.connectors_by_id[src_id] = connector;
   }
 
     // Create new object containing metadata for this logic core
-  LogicInfo logic_info(logic);
+  LogicInfo logic_info(logic, id, &sources[logic->name()], &sink_info);
 
     // Keep track of the newly added logics idle state so that we can start
     // and stop timeout timers.
@@ -325,33 +358,42 @@ void LinkManager::addLogic(LogicBase *logic)
         sigc::mem_fun(*this, &LinkManager::onPublishStateEvent), logic));
 
     // Add the logic core to the logic map
-  logic_map.emplace(logic->name(), logic_info);
+  LogicMap::iterator lmit = logic_map.emplace(logic->name(), logic_info).first;
+  logic_ids[id] = &(*lmit).second;
 
-    // Create command objects associated with this logic
-    // FIXME: We should not reference to a specific logic core type in this
-    //        class
-  Logic *cmd_logic = dynamic_cast<Logic*>(logic);
-  if (cmd_logic != 0)
+  bool in_active_link = false;
+  for (LinkMap::iterator it = links.begin(); it != links.end(); ++it)
   {
-    for (LinkMap::iterator it = links.begin(); it != links.end(); ++it)
+    Link &link = it->second;
+    if (link.logic_props.find(logic->name()) != link.logic_props.end())
     {
-      Link &link = it->second;
-      LogicPropMap::const_iterator prop_it(link.logic_props.find(logic->name()));
-      if (prop_it != link.logic_props.end())
+      link.logic_ids.push_back(id);
+      in_active_link |= link.is_activated;
+    }
+  }
+
+    // Create command objects associated with this logic. The commands are
+    // created in the thread that the logic run in.
+  for (LinkMap::iterator it = links.begin(); it != links.end(); ++it)
+  {
+    Link &link = it->second;
+    LogicPropMap::const_iterator prop_it(link.logic_props.find(logic->name()));
+    if (prop_it != link.logic_props.end())
+    {
+      const LogicProperties &logic_props = prop_it->second;
+      if (atoi(logic_props.cmd.c_str()) > 0)
       {
-        const LogicProperties &logic_props = prop_it->second;
-        if (atoi(logic_props.cmd.c_str()) > 0)
-        {
-          LinkCmd *link_cmd = new LinkCmd(cmd_logic, link);
-          if (!link_cmd->initialize(logic_props.cmd))
-          {
-            cout << "*** WARNING: Can not setup command " << logic_props.cmd
-                 << " for the logic " << logic->name() << endl;
-          }
-        }
+        logic->postToLogicThread(
+            sigc::bind(sigc::ptr_fun(&LinkManager::addLinkCmd),
+                       &link, logic_props.cmd));
       }
     }
   }
+
+  if (in_active_link)
+  {
+    updateConnections();
+  }
 } /* LinkManager::addLogic */
 
 
@@ -365,6 +407,7 @@ void LinkManager::deleteLogic(LogicBase *logic)
 
   LogicInfo &logic_info = (*lmit).second;
   assert(logic_info.logic == logic);
+  const unsigned id = logic_info.id;
   assert(sources.find(logic->name()) != sources.end());
   assert(sinks.find(logic->name()) != sinks.end());
 
@@ -387,6 +430,7 @@ void LinkManager::deleteLogic(LogicBase *logic)
     AudioPassthrough *connector = (*cmit).second;
     sink_info.selector->removeSource(connector);
     sink_info.connectors.erase(logic->name());
+    sink_info.connectors_by_id[id] = 0;
     splitter->removeSink(connector);
     //delete connector;
   }
@@ -407,8 +451,28 @@ void LinkManager::deleteLogic(LogicBase *logic)
   delete selector;
   sinks.erase(logic->name());
 
-    // Finally remove the logic from the logic_map
+    // Finally remove the logic from the logic_map and from all links
   logic_map.erase(logic->name());
+  logic_ids[id] = 0;
+  bool in_active_link = false;
+  for (LinkMap::iterator it = links.begin(); it != links.end(); ++it)
+  {
+    Link &link = it->second;
+    vector<unsigned>::iterator idit =
+      find(link.logic_ids.begin(), link.logic_ids.end(), id);
+    if (idit != link.logic_ids.end())
+    {
+      link.logic_ids.erase(idit);
+      in_active_link |= link.is_activated;
+    }
+  }
+
+    // Logics that were connected through the deleted logic may have to be
+    // disconnected from each other
+  if (in_active_link)
+  {
+    updateConnections();
+  }
 
 } /* LinkManager::deleteLogic */
 
@@ -450,6 +514,18 @@ void LinkManager::allLogicsStarted(void)
 } /* LinkManager::allLogicsStarted */
 
 
+string LinkManager::cmdReceived(const string& link_name, LogicBase *logic,
+                                const string &subcmd)
+{
+  LinkMap::iterator it = links.find(link_name);
+  if (it == links.end())
+  {
+    return "";
+  }
+  return cmdReceived((*it).second, logic, subcmd);
+} /* LinkManager::cmdReceived */
+
+
 string LinkManager::cmdReceived(LinkRef link, LogicBase *logic,
                                 const string &subcmd)
 {
@@ -627,146 +703,136 @@ LinkManager::~LinkManager(void)
 
 /**
  * @brief Find out which logics that should be connected
- * @param want The connections we want
+ * @param groups The group of each logic, indexed by logic id
  *
- * This function will calculate which logic connections that should currently
- * be established to get the correct audio flow in the currently activated
- * logic links. It will not set up the logic connections though so the caller
- * have to figure out which currently active connections to break and which to
- * establish to get to the set of connections reported by this function.
+ * Logics that are connected to each other, directly through an activated
+ * link or via other logics, form a group. All logics in a group should have
+ * audio connections to all other logics in the same group. The group number
+ * is the lowest logic id in the group so a logic that is not connected to
+ * any other logic is in a group of its own, with its own id as the number.
  */
-void LinkManager::wantedConnections(LogicConSet &want)
+void LinkManager::wantedGroups(vector<unsigned> &groups)
 {
-    // Fill "want" with the base set of connections that are explicitly
-    // specified in the link configuration for active links. The connection
-    // graph will not be complete if two links share one or more logics. This
-    // will be solved in the next step below.
-  for (LinkMap::iterator lit = links.begin(); lit != links.end(); ++lit)
-  {
-    Link &link = (*lit).second;
-    if (link.is_activated)
+    // Union-find where the root of each tree is the lowest id in the tree
+  groups.resize(logic_ids.size());
+  for (unsigned id=0; id<groups.size(); ++id)
+  {
+    groups[id] = id;
+  }
+  for (LinkMap::const_iterator lit = links.begin(); lit != links.end(); ++lit)
+  {
+    const Link &link = (*lit).second;
+    if (!link.is_activated)
     {
-        // oit=outer iterator
-      for (LogicPropMap::iterator oit = link.logic_props.begin();
-           oit != link.logic_props.end();
-           ++oit)
-      {
-          // iit=inner iterator
-        LogicPropMap::iterator iit = oit;
-        for (++iit; iit != link.logic_props.end(); ++iit)
-        {
-          const std::string& l1_name = (*oit).first;
-          const std::string& l2_name = (*iit).first;
-          const LogicInfo &l1_info = logic_map.at(l1_name);
-          const LogicInfo &l2_info = logic_map.at(l2_name);
-          if ((l1_name != l2_name) && !l1_info.is_muted && !l2_info.is_muted)
-          {
-            want.insert(make_pair(l1_name, l2_name));
-            want.insert(make_pair(l2_name, l1_name));
-          }
-        }
-      }
+      continue;
     }
-  }
-
-    // Now we need to complete the graph with connections between logics that
-    // are implicitly connected. That is, logics that are connected to each
-    // other via other logics.
-    //
-    // The algoritm below is not very optimized but that should not be needed
-    // since SvxLink most often just have a few logics defined. If a lot of
-    // logics is used, the code below may have to be optimized.
-    //
-    // The outer loop (do {} while) is needed since new connections may be
-    // added and then new implicit connections may appear. We are done when
-    // all connections have been gone through and no new connections was
-    // added.
-  size_t prev_size;
-  do
-  {
-      // Store the current size of the connection set so that we can check
-      // later if new connections have been added.
-    prev_size = want.size();
-
-      // Now compare all connections to each other. This requires two loops,
-      // an outer (oit=outer iterator) and an inner (iit=inner iterator).
-    for (LogicConSet::iterator oit = want.begin();
-         oit != want.end();
-         ++oit)
+    int first = -1;
+    for (vector<unsigned>::const_iterator it = link.logic_ids.begin();
+         it != link.logic_ids.end(); ++it)
     {
-      for (LogicConSet::iterator iit = want.begin();
-           iit != want.end();
-           ++iit)
+      if (logic_ids[*it]->is_muted)
       {
-          // If the sink of the outer connection belongs to the same logic
-          // as the source of the inner connection, then we need to also
-          // connect the source of the outer connection to the sink of the
-          // inner connection. To exemplify, if the set contains the
-          // connections: <L1,L2>,<L2,L3> we also need to add <L1,L3> since
-          // L1 is implicitly connected to L3 via L2.
-          // The comparison below also make sure that a connection is not
-          // added which connect back to the same logic. To exemplify this,
-          // if the set contains the connections: <L1,L2>,<L2,L1> we should
-          // not connect <L1,L1>.
-        if ((oit->second == iit->first) && (oit->first != iit->second))
-        {
-          want.insert(make_pair(oit->first, iit->second));
-        }
+        continue;
+      }
+      if (first < 0)
+      {
+        first = *it;
+        continue;
+      }
+      unsigned root1 = find_root(groups, first);
+      unsigned root2 = find_root(groups, *it);
+      if (root1 < root2)
+      {
+        groups[root2] = root1;
+      }
+      else
+      {
+        groups[root1] = root2;
       }
     }
-  } while (want.size() > prev_size);
-} /* LinkManager::wantedConnections */
+  }
+
+  for (unsigned id=0; id<groups.size(); ++id)
+  {
+    groups[id] = find_root(groups, id);
+  }
+} /* LinkManager::wantedGroups */
 
 
 void LinkManager::updateConnections(void)
 {
-    // Get the wanted logic connections based on which links that are activated
-  LogicConSet want;
-  wantedConnections(want);
-
-    // Calculate which of the current connections should be broken.
-    // This is easily done with a simple difference set operation.
-    // After this operation the "to_disconnect" variable will contain
-    // the set of logic connections that have to be broken.
-  LogicConSet to_disconnect;
-  set_difference(current_cons.begin(), current_cons.end(),
-                 want.begin(), want.end(),
-                 inserter(to_disconnect, to_disconnect.end()));
-
-  for (auto it = to_disconnect.begin(); it != to_disconnect.end(); ++it)
+    // Get the wanted logic groups based on which links that are activated
+  vector<unsigned> groups;
+  wantedGroups(groups);
+
+    // Two logics are connected if they are in the same group. If neither of
+    // them has changed group, their connection is unchanged too so only the
+    // connections of the logics that have changed group need to be updated.
+  vector<unsigned> changed;
+  for (unsigned id=0; id<logic_ids.size(); ++id)
   {
-    const string &src_name = it->first;
-    const string &sink_name = it->second;
-    SinkInfo &sink = sinks.at(sink_name);
+    if ((logic_ids[id] != 0) && (logic_ids[id]->group != groups[id]))
+    {
+      changed.push_back(id);
+    }
+  }
 
-      // Disconnect the audio path from source logic to sink logic
-    sink.selector->disableAutoSelect(sink.connectors.at(src_name));
+  for (vector<unsigned>::const_iterator it = changed.begin();
+       it != changed.end(); ++it)
+  {
+    const unsigned id = *it;
+    const LogicInfo *info = logic_ids[id];
+    for (unsigned other_id=0; other_id<logic_ids.size(); ++other_id)
+    {
+      const LogicInfo *other_info = logic_ids[other_id];
+      if ((other_id == id) || (other_info == 0))
+      {
+        continue;
+      }
+        // Pairs where both logics changed group are only handled once
+      if ((other_id < id) && (other_info->group != groups[other_id]))
+      {
+        continue;
+      }
+      bool is_connected = (info->group == other_info->group);
+      bool want_connected = (groups[id] == groups[other_id]);
+      if (want_connected != is_connected)
+      {
+        setConnected(id, other_id, want_connected);
+        setConnected(other_id, id, want_connected);
+      }
+    }
+  }
 
-      // Delete the link connect information
-    current_cons.erase(*it);
+  for (vector<unsigned>::const_iterator it = changed.begin();
+       it != changed.end(); ++it)
+  {
+    logic_ids[*it]->group = groups[*it];
   }
+} /* LinkManager::updateConnections */
 
-    // Calculate the difference between the wanted connection set and the
-    // current connection set. This is easily done using the difference set
-    // operation. After this operation the "to_connect" variable will contain
-    // the set of logic connections that have to be established.
-  LogicConSet to_connect;
-  set_difference(want.begin(), want.end(),
-                 current_cons.begin(), current_cons.end(),
-                 inserter(to_connect, to_connect.end()));
 
-    // Establish missing connections
-  for (auto it = to_connect.begin(); it != to_connect.end(); ++it)
+void LinkManager::setConnected(unsigned src_id, unsigned sink_id,
+                               bool connect)
+{
+  SinkInfo *sink = logic_ids[sink_id]->sink;
+  AudioPassthrough *connector = sink->connectors_by_id[src_id];
+  assert(connector != 0);
+  AudioSplitter *splitter = logic_ids[src_id]->source->splitter;
+  if (connect)
   {
-    const string &src_name = it->first;
-    const string &sink_name = it->second;
-    SinkInfo &sink = sinks.at(sink_name);
-    sink.selector->enableAutoSelect(sink.connectors.at(src_name), 0);
-
-      // Store all connections in "current_cons" (current connections)
-    current_cons.insert(*it);
+    splitter->enableSink(connector, true);
+    sink->selector->enableAutoSelect(connector, 0);
   }
-} /* LinkManager::updateConnections */
+  else
+  {
+      // Disconnect the audio path from source logic to sink logic. The
+      // splitter branch is disabled too so that no audio is written into
+      // connectors that lead nowhere.
+    sink->selector->disableAutoSelect(connector);
+    splitter->enableSink(connector, false);
+  }
+} /* LinkManager::setConnected */
 
 
 void LinkManager::activateLink(Link &link)
@@ -965,6 +1031,24 @@ void LinkManager::onPublishStateEvent(LogicBase *src_logic,
 } /* LinkManager::onPublishStateEvent */
 
 
+void LinkManager::addLinkCmd(LogicBase *logic, Link *link, std::string cmd)
+{
+    // FIXME: We should not reference to a specific logic core type in this
+    //        class
+  Logic *cmd_logic = dynamic_cast<Logic*>(logic);
+  if (cmd_logic == 0)
+  {
+    return;
+  }
+  LinkCmd *link_cmd = new LinkCmd(cmd_logic, *link);
+  if (!link_cmd->initialize(cmd))
+  {
+    cout << "*** WARNING: Can not setup command " << cmd
+         << " for the logic " << logic->name() << endl;
+  }
+} /* LinkManager::addLinkCmd */
+
+
 /*
  * This file has not been truncated
  */
@@ -228,6 +228,20 @@ class LinkManager : public sigc::trackable
     std::string cmdReceived(LinkRef link, LogicBase *logic,
                             const std::string &subcmd);
 
+    /**
+     * @brief   Called when a link command has been received
+     * @param   link_name The name of the link associated with this command
+     * @param   logic     The logic core associated with this command
+     * @param   subcmd    The subcommand
+     * @return  Returns an event handler command to be executed by the logic
+     *
+     * This function is used for commands received by logic cores running in
+     * a worker thread, which only refer to the link by name. An empty string
+     * is returned if the link does not exist.
+     */
+    std::string cmdReceived(const std::string& link_name, LogicBase *logic,
+                            const std::string &subcmd);
+
     /**
      * @brief   Get the current talker for the given logic core
      * @param   logic_name The name of the sink logic
@@ -297,13 +311,13 @@ class LinkManager : public sigc::trackable
 
       std::string  name;
       LogicPropMap logic_props;
+      std::vector<unsigned> logic_ids;
       StrSet       auto_activate;
       bool         default_active;
       bool         is_activated;
       Async::Timer *timeout_timer;
     };
     typedef std::map<std::string, Link> LinkMap;
-    typedef std::set<std::pair<std::string, std::string> > LogicConSet;
     struct SourceInfo
     {
       Async::AudioSource      *source;
@@ -315,25 +329,34 @@ class LinkManager : public sigc::trackable
       Async::AudioSink      *sink;
       Async::AudioSelector  *selector;
       ConMap                connectors;
+      std::vector<Async::AudioPassthrough *> connectors_by_id;
     };
     typedef std::map<std::string, SourceInfo> SourceMap;
     typedef std::map<std::string, SinkInfo>   SinkMap;
     struct LogicInfo
     {
-      LogicInfo(LogicBase* logic) : logic(logic), is_muted(false) {}
+      LogicInfo(LogicBase* logic, unsigned id, SourceInfo *source,
+                SinkInfo *sink)
+        : logic(logic), is_muted(false), id(id), group(id), source(source),
+          sink(sink) {}
       LogicBase         *logic;
       sigc::connection  idle_state_changed_con;
       sigc::connection  received_tg_update_con;
       sigc::connection  received_publish_state_event_con;
       bool              is_muted;
+      unsigned          id;
+      unsigned          group;
+      SourceInfo        *source;
+      SinkInfo          *sink;
     };
     typedef std::map<std::string, LogicInfo> LogicMap;
+    typedef std::vector<LogicInfo*> LogicIdMap;
 
     static LinkManager *_instance;
 
     LinkMap     links;
     LogicMap    logic_map;
-    LogicConSet current_cons;
+    LogicIdMap  logic_ids;
     SourceMap   sources;
     SinkMap     sinks;
     bool        all_logics_started;
@@ -343,8 +366,9 @@ class LinkManager : public sigc::trackable
     ~LinkManager(void);
 
     std::vector<std::string> getLinkNames(const std::string& logicname);
-    void wantedConnections(LogicConSet &want);
+    void wantedGroups(std::vector<unsigned> &groups);
     void updateConnections(void);
+    void setConnected(unsigned src_id, unsigned sink_id, bool connect);
     void activateLink(Link &link);
     void deactivateLink(Link &link);
     void sendCmdToLogics(Link &link, LogicBase *src_logic,
@@ -359,6 +383,7 @@ class LinkManager : public sigc::trackable
     void onReceivedTgUpdated(LogicBase *src_logic, uint32_t tg);
     void onPublishStateEvent(LogicBase *src_logic,
         const std::string& event_name, const std::string& msg);
+    static void addLinkCmd(LogicBase *logic, Link *link, std::string cmd);
 
 };  /* class LinkManager */
 
@@ -73,6 +73,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioPacer.h>
 #include <AsyncAudioDebugger.h>
 #include <AsyncAudioRecorder.h>
+#include <AsyncAudioProfiler.h>
+#include <AsyncAudioTrace.h>
+#include <AsyncTracepoint.h>
+#include <AsyncMetrics.h>
 #include <common.h>
 #include <config.h>
 
@@ -91,6 +95,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "QsoRecorder.h"
 #include "LinkManager.h"
 #include "DtmfDigitHandler.h"
+#include "TxLatencyMonitor.h"
 
 
 /****************************************************************************
@@ -128,6 +133,7 @@ using namespace SvxLink;
  *
  ****************************************************************************/
 
+static bool isDtmfDigit(char ch);
 
 
 /****************************************************************************
@@ -144,6 +150,9 @@ using namespace SvxLink;
  *
  ****************************************************************************/
 
+  // The resolved path of each loaded module plugin. Logics loading the same
+  // plugin do not have to search for it again.
+static map<string, string> plugin_paths;
 
 
 /****************************************************************************
@@ -166,12 +175,25 @@ Logic::Logic(Config &cfg, const string& name)
     state_det(0),
     fx_gain_normal(0),                      fx_gain_low(-12),
     long_cmd_digits(100),                   report_events_as_idle(false),
+    exec_complete_cmd(false),
     qso_recorder(0),                        tx_ctcss(TX_CTCSS_ALWAYS),
     tx_ctcss_mask(0),
     currently_set_tx_ctrl_mode(Tx::TX_OFF), is_online(true),
     dtmf_digit_handler(0),                  state_pty(0),
-    dtmf_ctrl_pty(0),                       command_pty(0)
+    dtmf_ctrl_pty(0),                       command_pty(0),
+    tx_latency(0),                          sql_open_duration(0),
+    dtmf_cmd_cnt(0)
 {
+  timerclear(&sql_open_time);
+  tx_latency = new TxLatencyMonitor(name);
+  const Metric::Labels labels{{"logic", name}};
+  sql_open_duration = Metrics::instance().histogram(
+      "svxlink_logic_squelch_open_seconds",
+      "Time the receiver squelch has been open for each transmission",
+      {0.5, 1.0, 2.0, 5.0, 10.0, 30.0, 60.0, 180.0}, labels);
+  dtmf_cmd_cnt = Metrics::instance().counter(
+      "svxlink_logic_dtmf_commands_total", "Number of received DTMF commands",
+      labels);
   rgr_sound_timer.expired.connect(sigc::hide(
         mem_fun(*this, &Logic::sendRgrSound)));
   logic_con_in = new AudioSplitter;
@@ -185,6 +207,7 @@ Logic::~Logic(void)
   delete logic_con_out;
   delete logic_con_in;
   delete dtmf_digit_handler;
+  delete tx_latency;
 } /* Logic::~Logic */
 
 
@@ -255,6 +278,7 @@ bool Logic::initialize(void)
   {
     exec_cmd_on_sql_close_timer.setTimeout(exec_cmd_on_sql_close);
   }
+  cfg().getValue(name(), "EXEC_CMD_WHEN_COMPLETE", exec_complete_cmd);
   int rgr_sound_delay = -1;
   if (cfg().getValue(name(), "RGR_SOUND_DELAY", rgr_sound_delay))
   {
@@ -275,6 +299,9 @@ bool Logic::initialize(void)
       cleanup();
       return false;
     }
+      // Events often come in bursts so write them all at once when control
+      // return to the main loop
+    state_pty->setWriteBuffered(true);
   }
 
   string dtmf_ctrl_pty_path;
@@ -426,11 +453,13 @@ bool Logic::initialize(void)
   rx_valve = new AudioValve;
   rx_valve->setOpen(false);
   prev_rx_src->registerSink(rx_valve, true);
+  rx_valve->setProfileName(name() + ":rx_valve");
   prev_rx_src = rx_valve;
 
     // Split the RX audio stream to multiple sinks
   rx_splitter = new AudioSplitter;
   prev_rx_src->registerSink(rx_splitter, true);
+  rx_splitter->setProfileName(name() + ":rx_splitter");
   prev_rx_src = 0;
 
     // Create a selector for audio to the module
@@ -463,6 +492,7 @@ bool Logic::initialize(void)
   rpt_valve = new AudioValve;
   rpt_valve->setOpen(false);
   rx_splitter->addSink(rpt_valve, true);
+  rx_splitter->enableSink(rpt_valve, false);
 
     // This selector is used to select audio source for TX audio
   tx_audio_selector = new AudioSelector;
@@ -551,12 +581,14 @@ bool Logic::initialize(void)
   state_det->sigStreamStateChanged.connect(
     mem_fun(*this, &Logic::audioStreamStateChange));
   prev_tx_src->registerSink(state_det, true);
+  state_det->setProfileName(name() + ":tx_state_det");
   prev_tx_src = state_det;
 
     // Add a pre-buffered FIFO to avoid underrun
   AudioFifo *tx_fifo = new AudioFifo(1024 * INTERNAL_SAMPLE_RATE / 8000);
   tx_fifo->setPrebufSamples(512 * INTERNAL_SAMPLE_RATE / 8000);
   prev_tx_src->registerSink(tx_fifo, true);
+  tx_fifo->setProfileName(name() + ":tx_fifo");
   prev_tx_src = tx_fifo;
 
     // Create the TX audio mixer
@@ -564,6 +596,13 @@ bool Logic::initialize(void)
   tx_audio_mixer->addSource(prev_tx_src);
   prev_tx_src = tx_audio_mixer;
 
+    // Detect when audio start flowing into the TX to measure TX latency
+  AudioStreamStateDetector *tx_in_det = new AudioStreamStateDetector;
+  tx_in_det->sigStreamStateChanged.connect(
+      mem_fun(*tx_latency, &TxLatencyMonitor::txInputStateChanged));
+  prev_tx_src->registerSink(tx_in_det, true);
+  prev_tx_src = tx_in_det;
+
     // Create the TX object
   cout << "Loading TX: " << tx_name << endl;
   m_tx = TxFactory::createNamedTx(cfg(), tx_name);
@@ -578,7 +617,10 @@ bool Logic::initialize(void)
   tx().transmitterStateChange.connect(
       mem_fun(*this, &Logic::transmitterStateChange));
   tx().publishStateEvent.connect(mem_fun(*this, &Logic::onPublishStateEvent));
+  tx().txAudioStarted.connect(
+      mem_fun(*tx_latency, &TxLatencyMonitor::txAudioStarted));
   prev_tx_src->registerSink(m_tx);
+  m_tx->setProfileName(name() + ":tx");
   prev_tx_src = 0;
 
     // Create the message handler
@@ -591,12 +633,14 @@ bool Logic::initialize(void)
   fx_gain_ctrl = new AudioAmp;
   fx_gain_ctrl->setGain(fx_gain_normal);
   prev_tx_src->registerSink(fx_gain_ctrl, true);
+  fx_gain_ctrl->setProfileName(name() + ":fx_gain_ctrl");
   prev_tx_src = fx_gain_ctrl;
 
     // Pace the audio so that we don't fill up the audio output pipe.
   AudioPacer *msg_pacer = new AudioPacer(INTERNAL_SAMPLE_RATE,
       	      	      	      	      	 256 * INTERNAL_SAMPLE_RATE / 8000, 0);
   prev_tx_src->registerSink(msg_pacer, true);
+  msg_pacer->setProfileName(name() + ":msg_pacer");
   tx_audio_mixer->addSource(msg_pacer);
   prev_tx_src = 0;
 
@@ -606,6 +650,9 @@ bool Logic::initialize(void)
   event_handler->playTone.connect(mem_fun(*this, &Logic::playTone));
   event_handler->recordStart.connect(mem_fun(*this, &Logic::recordStart));
   event_handler->recordStop.connect(mem_fun(*this, &Logic::recordStop));
+  event_handler->beginSequence.connect(
+          mem_fun(*this, &Logic::beginSequence));
+  event_handler->endSequence.connect(mem_fun(*this, &Logic::endSequence));
   event_handler->deactivateModule.connect(
           bind(mem_fun(*this, &Logic::deactivateModule), (Module *)0));
   event_handler->publishStateEvent.connect(
@@ -720,18 +767,28 @@ bool Logic::initialize(void)
 void Logic::processEvent(const string& event, const Module *module)
 {
   msg_handler->begin();
-  if (module == 0)
-  {
-    event_handler->processEvent(name() + "::" + event);
-  }
-  else
-  {
-    event_handler->processEvent(string(module->name()) + "::" + event);
-  }
+  event_handler->processEvent(eventName(event, module));
   msg_handler->end();
 }
 
 
+bool Logic::processEvent(const string& event, int objc, Tcl_Obj *const objv[],
+                         const Module *module)
+{
+  msg_handler->begin();
+  bool success = event_handler->processEvent(eventName(event, module), objc,
+                                             objv);
+  msg_handler->end();
+  return success;
+} /* Logic::processEvent */
+
+
+bool Logic::eventIsHandled(const string& event, const Module *module) const
+{
+  return event_handler->hasHandler(eventName(event, module));
+} /* Logic::eventIsHandled */
+
+
 void Logic::setEventVariable(const string& name, const string& value)
 {
   event_handler->setVariable(name, value);
@@ -818,12 +875,28 @@ void Logic::recordStop(void)
 } /* Logic::recordStop */
 
 
-void Logic::injectDtmf(const std::string& digits, int len)
+void Logic::beginSequence(void)
 {
-  for (string::size_type i=0; i < digits.size(); ++i)
+  msg_handler->beginSequence();
+} /* Logic::beginSequence */
+
+
+void Logic::endSequence(void)
+{
+  msg_handler->endSequence();
+
+  if (!msg_handler->isIdle())
   {
-    dtmfDigitDetected(digits[i], len);
+    updateTxCtcss(true, TX_CTCSS_ANNOUNCEMENT);
   }
+
+  checkIdle();
+} /* Logic::endSequence */
+
+
+void Logic::injectDtmf(const std::string& digits, int len)
+{
+  dtmfDigitsDetected(digits, len);
 } /* Logic::injectDtmf */
 
 
@@ -836,6 +909,10 @@ bool Logic::activateModule(Module *module)
 
   if ((active_module == 0) && is_online)
   {
+    if (!initModule(module))
+    {
+      return false;
+    }
     active_module = module;
     audio_to_module_splitter->enableSink(module, true);
     module->activate();
@@ -848,6 +925,31 @@ bool Logic::activateModule(Module *module)
 } /* Logic::activateModule */
 
 
+bool Logic::initModule(Module *module)
+{
+  map<Module*, bool>::iterator it = deferred_modules.find(module);
+  if (it == deferred_modules.end())
+  {
+    return true;
+  }
+  if (it->second)
+  {
+    return false;
+  }
+
+  cout << name() << ": Initializing module " << module->name() << "\n";
+  if (!module->initialize())
+  {
+    cerr << "*** ERROR: Initialization failed for module "
+         << module->cfgName() << " in logic " << name() << endl;
+    it->second = true;
+    return false;
+  }
+  deferred_modules.erase(it);
+  return true;
+} /* Logic::initModule */
+
+
 void Logic::deactivateModule(Module *module)
 {
   if (module == 0)
@@ -913,12 +1015,37 @@ void Logic::dtmfDigitDetected(char digit, int duration)
 
   dtmf_digit_handler->digitReceived(digit);
 
+  if (exec_complete_cmd && is_online && (active_module == 0))
+  {
+      // Only core commands are checked. Commands for modules, macros and
+      // forced core commands are still executed when they are terminated.
+    const string received_digits = dtmf_digit_handler->command();
+    if (!received_digits.empty() && (received_digits[0] != '*') &&
+        (received_digits[0] != 'D') &&
+        (received_digits.size() < long_cmd_digits) &&
+        cmd_parser.cmdIsComplete(received_digits))
+    {
+      dtmf_digit_handler->forceCommandComplete();
+    }
+  }
+} /* Logic::dtmfDigitDetected */
+
+
+void Logic::dtmfDigitsDetected(const std::string& digits, int duration)
+{
+    // Each digit is handled on its own since a completed command may
+    // activate a module that should receive the digits that follow. Commands
+    // left on the queue are processed once the whole batch has been handled.
+  for (string::size_type i=0; i < digits.size(); ++i)
+  {
+    dtmfDigitDetected(digits[i], duration);
+  }
+
   if (!cmd_queue.empty() && !rx().squelchIsOpen())
   {
     processCommandQueue();
   }
-
-} /* Logic::dtmfDigitDetected */
+} /* Logic::dtmfDigitsDetected */
 
 
 void Logic::selcallSequenceDetected(std::string sequence)
@@ -999,6 +1126,22 @@ Async::AudioSource *Logic::logicConOut(void)
 
 void Logic::squelchOpen(bool is_open)
 {
+  ASYNC_TRACEPOINT(svxlink, squelch_open, name().c_str(), rx().sqlRxId(),
+                   is_open);
+  if (is_open)
+  {
+    tx_latency->squelchOpened();
+    gettimeofday(&sql_open_time, NULL);
+  }
+  else if (timerisset(&sql_open_time))
+  {
+    struct timeval now, diff;
+    gettimeofday(&now, NULL);
+    timersub(&now, &sql_open_time, &diff);
+    sql_open_duration->observe(diff.tv_sec + diff.tv_usec / 1000000.0);
+    timerclear(&sql_open_time);
+  }
+
   if (active_module != 0)
   {
     active_module->squelchOpen(is_open);
@@ -1042,6 +1185,11 @@ void Logic::squelchOpen(bool is_open)
 
   checkIdle();
 
+  if (is_open)
+  {
+    tx_latency->squelchOpenHandled();
+  }
+
 } /* Logic::squelchOpen */
 
 
@@ -1056,6 +1204,9 @@ bool Logic::getIdleState(void) const
 
 void Logic::transmitterStateChange(bool is_transmitting)
 {
+  ASYNC_TRACEPOINT(svxlink, transmit, name().c_str(), is_transmitting);
+  tx_latency->transmitterStateChanged(is_transmitting);
+
   if (LocationInfo::has_instance() &&
       (LocationInfo::instance()->getTransmitting(name()) != is_transmitting))
   {
@@ -1073,15 +1224,20 @@ void Logic::transmitterStateChange(bool is_transmitting)
 void Logic::dtmfCtrlPtyCmdReceived(const void *buf, size_t count)
 {
   const char *buffer = reinterpret_cast<const char*>(buf);
+  string digits;
   for (size_t i=0; i<count; ++i)
   {
     const char &ch = buffer[i];
     if (::isdigit(ch) || (ch == '*') || (ch == '#') ||
         ((ch >= 'A') && (ch <= 'F')))
     {
-      dtmfDigitDetectedP(ch, 100);
+      digits += ch;
     }
   }
+  if (!digits.empty())
+  {
+    dtmfDigitsDetectedP(digits, 100);
+  }
 } /* Logic::dtmfCtrlPtyCmdReceived */
 
 
@@ -1111,16 +1267,162 @@ void Logic::commandPtyCmdReceived(const void *buf, size_t count)
     }
     cfg().setValue(section, tag, value);
   }
+  else if (cmd == "RELOAD")
+  {
+    std::string arg;
+    if (ss >> arg)
+    {
+      std::cerr << "*** ERROR: Invalid PTY command in logic "
+                << name() << ": \"" << cmdline << "\". "
+                << "Usage: RELOAD"
+                << std::endl;
+      return;
+    }
+    configReloadRequested();
+  }
+  else if (cmd == "STATS")
+  {
+    std::string arg;
+    if (ss >> arg)
+    {
+      std::cerr << "*** ERROR: Invalid PTY command in logic "
+                << name() << ": \"" << cmdline << "\". "
+                << "Usage: STATS"
+                << std::endl;
+      return;
+    }
+    writePerfStats();
+  }
+  else if (cmd == "PROFILE")
+  {
+    std::string action;
+    if (!(ss >> action) || !ss.eof())
+    {
+      action.clear();
+    }
+    if (action == "ON")
+    {
+      AudioProfiler::setEnabled(true);
+      std::cout << name() << ": Audio pipe profiling enabled" << std::endl;
+    }
+    else if (action == "OFF")
+    {
+      AudioProfiler::setEnabled(false);
+      std::cout << name() << ": Audio pipe profiling disabled" << std::endl;
+    }
+    else if (action == "RESET")
+    {
+      AudioProfiler::resetAll();
+    }
+    else if (action == "DUMP")
+    {
+      std::cout << "--- Audio pipe profile ("
+                << (AudioProfiler::isEnabled() ? "enabled" : "disabled")
+                << ")" << std::endl;
+      AudioProfiler::dumpAll(std::cout);
+    }
+    else
+    {
+      std::cerr << "*** ERROR: Invalid PTY command in logic "
+                << name() << ": \"" << cmdline << "\". "
+                << "Usage: PROFILE ON|OFF|RESET|DUMP"
+                << std::endl;
+    }
+  }
+  else if (cmd == "LATENCY")
+  {
+    std::string action;
+    if (!(ss >> action) || !ss.eof())
+    {
+      action.clear();
+    }
+    if (action == "RESET")
+    {
+      tx_latency->reset();
+    }
+    else if (action == "DUMP")
+    {
+      tx_latency->dump(std::cout);
+    }
+    else
+    {
+      std::cerr << "*** ERROR: Invalid PTY command in logic "
+                << name() << ": \"" << cmdline << "\". "
+                << "Usage: LATENCY RESET|DUMP"
+                << std::endl;
+    }
+  }
+  else if (cmd == "TRACE")
+  {
+    std::string action;
+    if (!(ss >> action) || !ss.eof())
+    {
+      action.clear();
+    }
+    if (action == "ON")
+    {
+      AudioTrace::setEnabled(true);
+      std::cout << name() << ": Audio latency tracing enabled" << std::endl;
+    }
+    else if (action == "OFF")
+    {
+      AudioTrace::setEnabled(false);
+      std::cout << name() << ": Audio latency tracing disabled" << std::endl;
+    }
+    else if (action == "RESET")
+    {
+      AudioTrace::resetAll();
+    }
+    else if (action == "DUMP")
+    {
+      std::cout << "--- Audio latency trace ("
+                << (AudioTrace::isEnabled() ? "enabled" : "disabled")
+                << ")" << std::endl;
+      AudioTrace::dumpAll(std::cout);
+    }
+    else
+    {
+      std::cerr << "*** ERROR: Invalid PTY command in logic "
+                << name() << ": \"" << cmdline << "\". "
+                << "Usage: TRACE ON|OFF|RESET|DUMP"
+                << std::endl;
+    }
+  }
   else
   {
     std::cerr << "*** ERROR: Unknown PTY command in logic "
               << name() << ": \"" << cmdline << "\". "
-              << "Valid commands are: CFG"
+              << "Valid commands are: CFG, RELOAD, STATS, PROFILE, LATENCY, "
+                 "TRACE"
               << std::endl;
   }
 } /* Logic::commandPtyCmdReceived */
 
 
+void Logic::writePerfStats(void)
+{
+    // The statistics are written back on the command PTY so that a
+    // monitoring script can read them without parsing the log
+  std::ostringstream os;
+  os << "STATS BEGIN " << name() << " " << time(NULL) << "\n";
+  os << "profile_enabled " << (AudioProfiler::isEnabled() ? 1 : 0) << "\n";
+  if (AudioProfiler::isEnabled())
+  {
+    AudioProfiler::dumpAll(os, "node ");
+  }
+  Metrics::instance().writeCompact(os);
+  os << "STATS END\n";
+
+  const std::string stats(os.str());
+  if (command_pty->write(stats.data(), stats.size()) !=
+      static_cast<ssize_t>(stats.size()))
+  {
+    std::cerr << "*** WARNING[" << name() << "]: Could not write all "
+              << "statistics to the command PTY" << std::endl;
+  }
+} /* Logic::writePerfStats */
+
+
 void Logic::clearPendingSamples(void)
 {
   msg_handler->clear();
@@ -1166,7 +1468,18 @@ void Logic::rxValveSetOpen(bool do_open)
 
 void Logic::rptValveSetOpen(bool do_open)
 {
-  rpt_valve->setOpen(do_open);
+    // The splitter branch is only enabled while the valve is open so that
+    // no RX audio is written into it while it would be thrown away anyway
+  if (do_open)
+  {
+    rx_splitter->enableSink(rpt_valve, true);
+    rpt_valve->setOpen(true);
+  }
+  else
+  {
+    rpt_valve->setOpen(false);
+    rx_splitter->enableSink(rpt_valve, false);
+  }
 } /* Logic::rptValveSetOpen */
 
 
@@ -1193,6 +1506,15 @@ void Logic::setTxCtrlMode(Tx::TxCtrlMode mode)
  *
  ****************************************************************************/
 
+string Logic::eventName(const string& event, const Module *module) const
+{
+  if (module == 0)
+  {
+    return name() + "::" + event;
+  }
+  return string(module->name()) + "::" + event;
+} /* Logic::eventName */
+
 
 /*
  *----------------------------------------------------------------------------
@@ -1271,10 +1593,11 @@ void Logic::loadModule(const string& module_cfg_name)
 
   void *handle = NULL;
   string plugin_filename = "Module" + plugin_name + ".so";
-  if (!module_path.empty())
+  map<string, string>::const_iterator pit = plugin_paths.find(plugin_filename);
+  if (pit != plugin_paths.end())
   {
-    string plugin_abs_filename = module_path + "/" + plugin_filename;
-    handle = dlopen(plugin_abs_filename.c_str(), RTLD_NOW);
+      // Already loaded so this will only increase the reference count
+    handle = dlopen(pit->second.c_str(), RTLD_NOW);
     if (handle == NULL)
     {
       cerr << "*** ERROR: Failed to load module "
@@ -1285,11 +1608,9 @@ void Logic::loadModule(const string& module_cfg_name)
   }
   else
   {
-    handle = dlopen(plugin_filename.c_str(), RTLD_NOW);
-    if (handle == NULL)
+    if (!module_path.empty())
     {
-      string plugin_abs_filename = string(SVX_MODULE_INSTALL_DIR "/")
-                                   + plugin_filename;
+      string plugin_abs_filename = module_path + "/" + plugin_filename;
       handle = dlopen(plugin_abs_filename.c_str(), RTLD_NOW);
       if (handle == NULL)
       {
@@ -1299,18 +1620,36 @@ void Logic::loadModule(const string& module_cfg_name)
         return;
       }
     }
-  }
+    else
+    {
+      handle = dlopen(plugin_filename.c_str(), RTLD_NOW);
+      if (handle == NULL)
+      {
+        string plugin_abs_filename = string(SVX_MODULE_INSTALL_DIR "/")
+                                     + plugin_filename;
+        handle = dlopen(plugin_abs_filename.c_str(), RTLD_NOW);
+        if (handle == NULL)
+        {
+          cerr << "*** ERROR: Failed to load module "
+            << module_cfg_name.c_str() << " into logic " << name() << ": "
+            << dlerror() << endl;
+          return;
+        }
+      }
+    }
 
-  struct link_map *link_map;
-  if (dlinfo(handle, RTLD_DI_LINKMAP, &link_map) == -1)
-  {
-    cerr << "*** ERROR: Could not read information for module "
-      	 << module_cfg_name.c_str() << " in logic " << name() << ": "
-         << dlerror() << endl;
-    dlclose(handle);
-    return;
+    struct link_map *link_map;
+    if (dlinfo(handle, RTLD_DI_LINKMAP, &link_map) == -1)
+    {
+      cerr << "*** ERROR: Could not read information for module "
+        	 << module_cfg_name.c_str() << " in logic " << name() << ": "
+           << dlerror() << endl;
+      dlclose(handle);
+      return;
+    }
+    cout << "\tFound " << link_map->l_name << endl;
+    plugin_paths[plugin_filename] = link_map->l_name;
   }
-  cout << "\tFound " << link_map->l_name << endl;
 
   Module::InitFunc init = (Module::InitFunc)dlsym(handle, "module_init");
   if (init == NULL)
@@ -1331,7 +1670,14 @@ void Logic::loadModule(const string& module_cfg_name)
     return;
   }
 
-  if (!module->initialize())
+  bool defer_init = false;
+  cfg().getValue(module_cfg_name, "DEFER_INIT", defer_init);
+  if (defer_init)
+  {
+    cout << "\tInitialization deferred until first use\n";
+    deferred_modules[module] = false;
+  }
+  else if (!module->initialize())
   {
     cerr << "*** ERROR: Initialization failed for module "
       	 << module_cfg_name.c_str() << " in logic " << name() << endl;
@@ -1353,6 +1699,7 @@ void Logic::loadModule(const string& module_cfg_name)
            << "same module id or choosing a module id that is the same as "
            << "another command.\n\n";
       delete cmd;
+      deferred_modules.erase(module);
       delete module;
       dlclose(handle);
       return;
@@ -1384,6 +1731,7 @@ void Logic::unloadModules(void)
     dlclose(plugin_handle);
   }
   modules.clear();
+  deferred_modules.clear();
 } /* logic::unloadModules */
 
 
@@ -1398,6 +1746,7 @@ void Logic::processCommandQueue(void)
   {
     string cmd(cmd_queue.front());
     cmd_queue.pop_front();
+    dtmf_cmd_cnt->inc();
 
     stringstream ss;
     ss << "dtmf_cmd_received \"" << cmd << "\"";
@@ -1535,10 +1884,7 @@ void Logic::processMacroCmd(const string& macro_cmd)
     }
   }
 
-  for (unsigned i=0; i<module_cmd.size(); ++i)
-  {
-    dtmfDigitDetected(module_cmd[i], 100);
-  }
+  dtmfDigitsDetected(module_cmd, 100);
 } /* Logic::processMacroCmd */
 
 
@@ -1615,29 +1961,73 @@ void Logic::everySecond(AtTimer *t)
 
 void Logic::dtmfDigitDetectedP(char digit, int duration)
 {
-  cout << name() << ": digit=" << digit << endl;
+  dtmfDigitsDetectedP(string(1, digit), duration);
+} /* Logic::dtmfDigitDetectedP */
+
+
+void Logic::dtmfDigitsDetectedP(const std::string& digits, int duration)
+{
+  cout << name() << ": " << (digits.size() == 1 ? "digit=" : "digits=")
+       << digits << endl;
 
   if (!is_online)
   {
-    dtmf_digit_handler->digitReceived(digit);
+    for (string::size_type i=0; i < digits.size(); ++i)
+    {
+      dtmf_digit_handler->digitReceived(digits[i]);
+    }
     return;
   }
 
-  stringstream ss;
-  ss << "dtmf_digit_received " << digit << " " << duration;
-  processEvent(ss.str());
-  if (atoi(event_handler->eventResult().c_str()) != 0)
+    // The whole batch is passed to TCL in one event. Event handler scripts
+    // that predate the batch event, or a failing batch event, get one event
+    // per digit.
+  string passed_digits;
+  bool batch_handled = false;
+  if (eventIsHandled("dtmf_digits_received"))
+  {
+    Tcl_Obj *args[] = {
+      Tcl_NewStringObj(digits.data(), digits.size()),
+      Tcl_NewIntObj(duration)
+    };
+    if (processEvent("dtmf_digits_received", 2, args))
+    {
+      batch_handled = true;
+      const string result = event_handler->eventResult();
+      for (string::size_type i=0; i < result.size(); ++i)
+      {
+        if (isDtmfDigit(result[i]))
+        {
+          passed_digits += result[i];
+        }
+      }
+    }
+  }
+  if (!batch_handled)
+  {
+    for (string::size_type i=0; i < digits.size(); ++i)
+    {
+      stringstream ss;
+      ss << "dtmf_digit_received " << digits[i] << " " << duration;
+      processEvent(ss.str());
+      if (atoi(event_handler->eventResult().c_str()) == 0)
+      {
+        passed_digits += digits[i];
+      }
+    }
+  }
+  if (passed_digits.empty())
   {
     return;
   }
 
-  dtmfDigitDetected(digit, duration);
+  dtmfDigitsDetected(passed_digits, duration);
 
   if (dtmf_ctrl_pty != 0)
   {
-    dtmf_ctrl_pty->write(&digit, 1);
+    dtmf_ctrl_pty->write(passed_digits.data(), passed_digits.size());
   }
-} /* Logic::dtmfDigitDetectedP */
+} /* Logic::dtmfDigitsDetectedP */
 
 
 void Logic::audioStreamStateChange(bool is_active, bool is_idle)
@@ -1672,7 +2062,7 @@ void Logic::cleanup(void)
   rgr_sound_timer.setEnable(false);
   every_minute_timer.stop();
 
-  if (LinkManager::hasInstance())
+  if ((linkProxy() == 0) && LinkManager::hasInstance())
   {
     LinkManager::instance()->deleteLogic(this);
   }
@@ -1775,6 +2165,13 @@ void Logic::cfgUpdated(const std::string& section, const std::string& tag)
 } /* Logic::cfgUpdated */
 
 
+static bool isDtmfDigit(char ch)
+{
+  return ::isdigit(ch) || ((ch >= 'A') && (ch <= 'F')) || (ch == '*') ||
+         (ch == '#') || (ch == 'H');
+} /* isDtmfDigit */
+
+
 /*
  * This file has not been truncated
  */
@@ -44,6 +44,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <map>
 #include <vector>
 #include <stdint.h>
+#include <sys/time.h>
 
 #include <sigc++/sigc++.h>
 
@@ -90,8 +91,12 @@ namespace Async
   class AudioSource;
   class AudioSink;
   class Pty;
+  class MetricCounter;
+  class MetricHistogram;
 };
 
+struct Tcl_Obj;
+
 
 /****************************************************************************
  *
@@ -116,6 +121,7 @@ class EventHandler;
 class Command;
 class QsoRecorder;
 class DtmfDigitHandler;
+class TxLatencyMonitor;
 
 
 /****************************************************************************
@@ -168,6 +174,30 @@ class Logic : public LogicBase
     virtual bool initialize(void);
 
     virtual void processEvent(const std::string& event, const Module *module=0);
+
+    /**
+     * @brief   Process an event with the arguments given as Tcl objects
+     * @param   event   The name of the event function
+     * @param   objc    The number of arguments
+     * @param   objv    The arguments
+     * @param   module  The module the event belongs to or 0 for the logic
+     *
+     * The arguments are passed to the event function without being
+     * formatted into a script and parsed again. See
+     * EventHandler::processEvent for how the reference counts are handled.
+     * @return  Returns \em true on success or \em false if the event failed
+     */
+    bool processEvent(const std::string& event, int objc,
+                      struct Tcl_Obj *const objv[], const Module *module=0);
+
+    /**
+     * @brief   Check if an event function has been defined
+     * @param   event   The name of the event function
+     * @param   module  The module the event belongs to or 0 for the logic
+     * @return  Returns \em true if the event function exists
+     */
+    bool eventIsHandled(const std::string& event,
+                        const Module *module=0) const;
     void setEventVariable(const std::string& name, const std::string& value);
     virtual void playFile(const std::string& path);
     virtual void playSilence(int length);
@@ -175,6 +205,8 @@ class Logic : public LogicBase
     virtual void playDtmf(const std::string& digits, int amp, int len);
     void recordStart(const std::string& filename, unsigned max_time);
     void recordStop(void);
+    void beginSequence(void);
+    void endSequence(void);
     void injectDtmf(const std::string& digits, int len);
 
     virtual bool activateModule(Module *module);
@@ -184,6 +216,18 @@ class Logic : public LogicBase
     Module *findModule(const std::string& name);
     std::list<Module*> moduleList(void) const { return modules; }
 
+    /**
+     * @brief   Initialize a module that has deferred its initialization
+     * @param   module The module to initialize
+     * @return  Returns \em true if the module is ready to be used
+     *
+     * A module configured with DEFER_INIT=1 is not initialized when it is
+     * loaded. This function is called before the module is activated or
+     * receive a command for the first time. It is a no-op for modules that
+     * have already been initialized.
+     */
+    bool initModule(Module *module);
+
     const std::string& callsign(void) const { return m_callsign; }
 
     Rx &rx(void) const { return *m_rx; }
@@ -210,6 +254,7 @@ class Logic : public LogicBase
     virtual void squelchOpen(bool is_open);
     virtual void allMsgsWritten(void);
     virtual void dtmfDigitDetected(char digit, int duration);
+    void dtmfDigitsDetected(const std::string& digits, int duration);
     virtual void audioStreamStateChange(bool is_active, bool is_idle);
     virtual bool getIdleState(void) const;
     virtual void transmitterStateChange(bool is_transmitting);
@@ -243,6 +288,7 @@ class Logic : public LogicBase
     MsgHandler	      	      	    *msg_handler;
     Module    	      	      	    *active_module;
     std::list<Module*>	      	    modules;
+    std::map<Module*, bool>         deferred_modules;
     std::string       	      	    m_callsign;
     std::list<std::string>    	    cmd_queue;
     Async::Timer      	      	    exec_cmd_on_sql_close_timer;
@@ -271,6 +317,7 @@ class Logic : public LogicBase
     unsigned       	      	    long_cmd_digits;
     std::string       	      	    long_cmd_module;
     bool      	      	      	    report_events_as_idle;
+    bool                            exec_complete_cmd;
     QsoRecorder                     *qso_recorder;
     uint8_t			    tx_ctcss;
     uint8_t			    tx_ctcss_mask;
@@ -285,6 +332,10 @@ class Logic : public LogicBase
     Async::Pty                      *dtmf_ctrl_pty;
     std::map<uint16_t, uint32_t>    m_ctcss_to_tg;
     Async::Pty                      *command_pty;
+    TxLatencyMonitor                *tx_latency;
+    struct timeval                  sql_open_time;
+    Async::MetricHistogram          *sql_open_duration;
+    Async::MetricCounter            *dtmf_cmd_cnt;
 
     void loadModules(void);
     void loadModule(const std::string& module_name);
@@ -299,6 +350,7 @@ class Logic : public LogicBase
     void everyMinute(Async::AtTimer *t);
 	void everySecond(Async::AtTimer *t);
     void dtmfDigitDetectedP(char digit, int duration);
+    void dtmfDigitsDetectedP(const std::string& digits, int duration);
     void cleanup(void);
     void updateTxCtcss(bool do_set, TxCtcssType type);
     void logicConInStreamStateChanged(bool is_active, bool is_idle);
@@ -307,6 +359,9 @@ class Logic : public LogicBase
                              const std::string &msg);
     void detectedTone(float fq);
     void cfgUpdated(const std::string& section, const std::string& tag);
+    void writePerfStats(void);
+    std::string eventName(const std::string& event,
+                          const Module *module) const;
 
 };  /* class Logic */
 
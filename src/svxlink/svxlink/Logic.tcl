@@ -145,6 +145,9 @@ proc send_short_ident {{hour -1} {minute -1}} {
   variable short_voice_id_enable
   variable short_cw_id_enable
 
+  # The identification is rendered and cached as one announcement
+  beginSequence
+
   # Play voice id if enabled
   if {$short_voice_id_enable} {
     puts "Playing short voice ID"
@@ -175,6 +178,8 @@ proc send_short_ident {{hour -1} {minute -1}} {
     }
     playSilence 500;
   }
+
+  endSequence
 }
 
 
@@ -193,6 +198,9 @@ proc send_long_ident {hour minute} {
   variable long_voice_id_enable
   variable long_cw_id_enable
 
+  # The identification is rendered and cached as one announcement
+  beginSequence
+
   # Play the voice ID if enabled
   if {$long_voice_id_enable} {
     puts "Playing Long voice ID"
@@ -240,6 +248,8 @@ proc send_long_ident {hour minute} {
     }
     playSilence 100
   }
+
+  endSequence
 }
 
 
@@ -426,6 +436,30 @@ proc dtmf_digit_received {digit duration} {
 }
 
 
+#
+# Executed when one or more DTMF digits have been received at once, e.g. from
+# the DTMF control PTY. The default implementation call dtmf_digit_received in
+# the given namespace for each digit.
+#   digits    - The detected DTMF digits
+#   duration  - The duration, in milliseconds, of each digit
+#   ns        - The namespace of the logic
+#
+# Return the digits that SvxLink should continue processing. Return an empty
+# string to hide all of them.
+#
+proc dtmf_digits_received {digits duration {ns "::Logic"}} {
+  set passed_digits "";
+  foreach digit [split $digits ""] {
+      # Interpret the return value like SvxLink does, i.e. like atoi
+    set result [${ns}::dtmf_digit_received $digit $duration];
+    if {[scan $result %d hide] != 1 || $hide == 0} {
+      append passed_digits $digit;
+    }
+  }
+  return $passed_digits;
+}
+
+
 #
 # Executed when a DTMF command has been received
 #   cmd - The command
@@ -136,7 +136,8 @@ class LogicBase : public sigc::trackable
      * @param   name The name of the logic core
      */
     LogicBase(Async::Config& cfg, const std::string& name)
-      : m_cfg(cfg), m_name(name), m_is_idle(true), m_received_tg(0) {}
+      : m_cfg(cfg), m_name(name), m_is_idle(true), m_received_tg(0),
+        m_link_proxy(0) {}
 
     /**
      * @brief 	Destructor
@@ -149,7 +150,7 @@ class LogicBase : public sigc::trackable
      */
     virtual bool initialize(void)
     {
-      if (LinkManager::hasInstance())
+      if ((m_link_proxy == 0) && LinkManager::hasInstance())
       {
           // Register this logic in the link manager
         LinkManager::instance()->addLogic(this);
@@ -182,10 +183,60 @@ class LogicBase : public sigc::trackable
      */
     void setMuteLinking(bool mute)
     {
-      if (LinkManager::hasInstance())
+      linkManagerRequest(
+          sigc::bind(sigc::ptr_fun(&LogicBase::setLogicMute), mute));
+    }
+
+    /**
+     * @brief   Set the logic that represent this logic in the link manager
+     * @param   proxy The logic registered in the link manager
+     *
+     * A logic running in a worker thread is not registered in the link
+     * manager. A proxy logic in the main thread is registered instead, see
+     * ThreadedLogic. This function must be called before initialize.
+     */
+    void setLinkProxy(LogicBase *proxy) { m_link_proxy = proxy; }
+
+    /**
+     * @brief   Get the logic that represent this logic in the link manager
+     * @return  Returns the proxy logic or 0 if this logic is registered itself
+     */
+    LogicBase *linkProxy(void) const { return m_link_proxy; }
+
+    /**
+     * @brief   Run a request in the link manager
+     * @param   request The request to run
+     *
+     * The link manager must only be used from the main thread. This function
+     * call the request in the main thread with the logic that is registered
+     * in the link manager as argument. For a logic running in the main
+     * thread, the request is called directly. Nothing is done if there is no
+     * link manager.
+     */
+    void linkManagerRequest(const sigc::slot<void, LogicBase*>& request)
+    {
+      if (m_link_proxy != 0)
       {
-        LinkManager::instance()->setLogicMute(this, mute);
+        m_link_proxy->postLinkManagerRequest(request);
       }
+      else if (LinkManager::hasInstance())
+      {
+        request(this);
+      }
+    }
+
+    /**
+     * @brief   Run a task in the thread that this logic run in
+     * @param   task The task to run
+     *
+     * This function must be called from the main thread on the logic that is
+     * registered in the link manager. The task is called in the thread of the
+     * logic doing the actual work, with that logic as argument. For a logic
+     * running in the main thread, the task is called directly.
+     */
+    virtual void postToLogicThread(const sigc::slot<void, LogicBase*>& task)
+    {
+      task(this);
     }
 
     /**
@@ -294,7 +345,29 @@ class LogicBase : public sigc::trackable
     sigc::signal<void, const std::string&,
                  const std::string&> publishStateEvent;
 
+    /**
+     * @brief   A signal that is emitted to request a configuration reload
+     *
+     * The configuration files are reread by the main program and any changes
+     * are applied to the running configuration, which will cause the
+     * valueUpdated signal to be emitted for each changed variable.
+     */
+    sigc::signal<void> configReloadRequested;
+
   protected:
+    /**
+     * @brief   Forward a link manager request to the main thread
+     * @param   request The request to run
+     *
+     * This function is called on the proxy logic from the thread of the logic
+     * that it represent. The proxy must call the request in the main thread.
+     */
+    virtual void postLinkManagerRequest(
+        const sigc::slot<void, LogicBase*>& request)
+    {
+      request(this);
+    }
+
     /**
      * @brief   Used by derived classes to set the idle state of the logic core
      * @param   set_idle \em True to set to idle or \em false to set to active
@@ -329,6 +402,12 @@ class LogicBase : public sigc::trackable
     std::string       	  m_name;
     bool      	      	  m_is_idle;
     uint32_t              m_received_tg;
+    LogicBase*            m_link_proxy;
+
+    static void setLogicMute(LogicBase *logic, bool mute)
+    {
+      LinkManager::instance()->setLogicMute(logic, mute);
+    }
 
 };  /* class LogicBase */
 
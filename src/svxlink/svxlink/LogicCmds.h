@@ -144,7 +144,16 @@ class ModuleActivateCmd : public Command
       assert(module != 0);
       if (!subcmd.empty())
       {
-	module->dtmfCmdReceivedWhenIdle(subcmd);
+        if (logic->initModule(module))
+        {
+          module->dtmfCmdReceivedWhenIdle(subcmd);
+        }
+        else
+        {
+          std::stringstream ss;
+          ss << "command_failed " << cmdStr() << subcmd;
+          logic->processEvent(ss.str());
+        }
       }
       else
       {
@@ -221,12 +230,11 @@ class LinkCmd : public Command
      */
     void operator ()(const std::string& subcmd)
     {
-      std::string event =
-          LinkManager::instance()->cmdReceived(link, logic, subcmd);
-      if (!event.empty())
-      {
-        logic->processEvent(event);
-      }
+        // The request may run after this object has been deleted so only the
+        // name of the link is passed on
+      logic->linkManagerRequest(
+          sigc::bind(sigc::ptr_fun(&LinkCmd::linkCmdReceived),
+                     link.name, subcmd));
     }
 
   protected:
@@ -235,6 +243,27 @@ class LinkCmd : public Command
     Logic                 *logic;
     LinkManager::LinkRef  link;
 
+    static void linkCmdReceived(LogicBase *link_logic, std::string link_name,
+                                std::string subcmd)
+    {
+      if (!LinkManager::hasInstance())
+      {
+        return;
+      }
+      std::string event =
+          LinkManager::instance()->cmdReceived(link_name, link_logic, subcmd);
+      if (!event.empty())
+      {
+        link_logic->postToLogicThread(
+            sigc::bind(sigc::ptr_fun(&LinkCmd::processLinkEvent), event));
+      }
+    }
+
+    static void processLinkEvent(LogicBase *logic, std::string event)
+    {
+      static_cast<Logic*>(logic)->processEvent(event);
+    }
+
 };  /* class LinkCmd */
 
 
@@ -312,6 +341,11 @@ class QsoRecorderCmd : public Command
       }
     }
 
+    bool subcmdIsComplete(const std::string& subcmd) const
+    {
+      return (subcmd == "0") || (subcmd == "1");
+    }
+
   private:
     Logic       *logic;
     QsoRecorder *recorder;
@@ -398,6 +432,11 @@ class OnlineCmd : public Command
       }
     }
 
+    bool subcmdIsComplete(const std::string& subcmd) const
+    {
+      return (subcmd == "0");
+    }
+
   private:
     Logic       *logic;
 
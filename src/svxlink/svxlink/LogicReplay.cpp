@@ -0,0 +1,867 @@
+/**
+@file	 LogicReplay.cpp
+@brief   Replay recorded receiver input through complete logic cores
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This program run the logic cores configured in an ordinary SvxLink
+configuration file on a simulated clock. Receivers of type "Replay" feed
+recorded audio and a trace of squelch and DTMF events into the logic and
+transmitters of type "Replay" consume the transmitted audio at the internal
+sample rate. No real time is involved so the replay run as fast as the CPU
+allow and the result is the same every time. All logic events, squelch and
+DTMF input and transmitter state changes are printed with a time stamp and a
+summary with the real time factor is printed when the replay is done.
+Time of day events, like the every_minute event, still follow the wall clock
+since they are scheduled using Async::AtTimer.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncSimApplication.h>
+#include <AsyncConfig.h>
+#include <AsyncTimer.h>
+#include <AsyncAudioPacer.h>
+#include <AsyncAudioStreamStateDetector.h>
+#include <Rx.h>
+#include <Tx.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "SimplexLogic.h"
+#include "RepeaterLogic.h"
+#include "DummyLogic.h"
+#include "LinkManager.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The interval between the audio blocks written by a replay receiver
+#define RX_BLOCK_MS       20
+
+  // The block size of the pacer that consume the audio in a replay
+  // transmitter. This is the same as for the message pacer in the logic core.
+#define TX_BLOCK_SIZE     (256 * INTERNAL_SAMPLE_RATE / 8000)
+
+  // The time, in seconds, that the replay continue after the last recorded
+  // event so that the logic core get time to finish what it is doing
+#define DEFAULT_TAIL      10.0
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static void printEvent(const string& source, const string& text);
+static double monotonicTime(void);
+static double cpuTime(void);
+static void usage(void);
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+static SimApplication *sim_app = 0;
+static bool quiet = false;
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+/**
+ * A receiver that replay recorded audio and a trace of squelch and DTMF
+ * events. The audio file contain raw 16 bit signed little endian samples at
+ * the internal sample rate and sample N is played at time N/rate. Audio is
+ * only written to the logic while the squelch is open, just like for a real
+ * receiver. Each line in the event file has the format
+ *
+ *   <time in seconds> SQL 1|0 [info]
+ *   <time in seconds> DTMF <digit> [duration in milliseconds]
+ *
+ * Empty lines and lines starting with a # character are ignored.
+ */
+class ReplayRx : public Rx
+{
+  public:
+    static vector<ReplayRx*> instances;
+
+    ReplayRx(Config &cfg, const string &name)
+      : Rx(cfg, name), mute_state(MUTE_ALL), trace_sql_open(false),
+        next_event(0), audio_pos(0), written_cnt(0), dropped_cnt(0),
+        event_timer(-1), audio_timer(RX_BLOCK_MS, Timer::TYPE_PERIODIC, false)
+    {
+        // The squelch state changes are printed with a time stamp instead
+      setVerbose(false);
+      instances.push_back(this);
+    }
+
+    ~ReplayRx(void)
+    {
+      instances.erase(find(instances.begin(), instances.end(), this));
+    }
+
+    bool initialize(void)
+    {
+      if (!Rx::initialize())
+      {
+        return false;
+      }
+
+      string value;
+      if (cfg().getValue(name(), "AUDIO_FILE", value) && !readAudio(value))
+      {
+        return false;
+      }
+      if (cfg().getValue(name(), "EVENT_FILE", value) && !readEvents(value))
+      {
+        return false;
+      }
+
+      event_timer.expired.connect(
+          hide(mem_fun(*this, &ReplayRx::handleEvents)));
+      audio_timer.expired.connect(hide(mem_fun(*this, &ReplayRx::writeAudio)));
+      audio_timer.setEnable(true);
+      scheduleNextEvent();
+
+      return true;
+    }
+
+    void setMuteState(MuteState new_mute_state)
+    {
+      writeAudio();
+      mute_state = new_mute_state;
+      updateSquelch();
+    }
+
+    void reset(void)
+    {
+      setMuteState(MUTE_ALL);
+    }
+
+    void resumeOutput(void) {}
+    void allSamplesFlushed(void) {}
+
+    double endTime(void) const
+    {
+      double end_time = double(audio.size()) / INTERNAL_SAMPLE_RATE;
+      if (!events.empty())
+      {
+        end_time = max(end_time, events.back().time_ms / 1000.0);
+      }
+      return end_time;
+    }
+
+    void printStats(ostream& os) const
+    {
+      os << name() << ": " << events.size() << " input events, "
+         << fixed << setprecision(3)
+         << double(written_cnt) / INTERNAL_SAMPLE_RATE << "s audio written";
+      if (dropped_cnt > 0)
+      {
+        os << ", " << double(dropped_cnt) / INTERNAL_SAMPLE_RATE
+           << "s audio dropped";
+      }
+      os << endl;
+    }
+
+  private:
+    struct Event
+    {
+      uint64_t    time_ms;
+      bool        is_sql;
+      bool        sql_open;
+      char        digit;
+      int         duration;
+      string      info;
+
+      bool operator<(const Event& other) const
+      {
+        return time_ms < other.time_ms;
+      }
+    };
+
+    MuteState       mute_state;
+    bool            trace_sql_open;
+    string          sql_info;
+    vector<int16_t> audio;
+    vector<Event>   events;
+    size_t          next_event;
+    uint64_t        audio_pos;
+    uint64_t        written_cnt;
+    uint64_t        dropped_cnt;
+    Timer           event_timer;
+    Timer           audio_timer;
+
+    bool readAudio(const string& filename)
+    {
+      ifstream is(filename.c_str(), ios::binary);
+      if (!is)
+      {
+        cerr << "*** ERROR: Could not open audio file \"" << filename
+             << "\" for receiver " << name() << endl;
+        return false;
+      }
+      is.seekg(0, ios::end);
+      audio.resize(is.tellg() / sizeof(int16_t));
+      is.seekg(0, ios::beg);
+      is.read(reinterpret_cast<char *>(audio.data()),
+              audio.size() * sizeof(int16_t));
+      if (!is)
+      {
+        cerr << "*** ERROR: Could not read audio file \"" << filename
+             << "\" for receiver " << name() << endl;
+        return false;
+      }
+      return true;
+    }
+
+    bool readEvents(const string& filename)
+    {
+      ifstream is(filename.c_str());
+      if (!is)
+      {
+        cerr << "*** ERROR: Could not open event file \"" << filename
+             << "\" for receiver " << name() << endl;
+        return false;
+      }
+      string line;
+      for (int lineno=1; getline(is, line); ++lineno)
+      {
+        istringstream ss(line);
+        double time;
+        string cmd;
+        if (!(ss >> time))
+        {
+          ss.clear();
+          if ((ss >> cmd) && (cmd[0] != '#'))
+          {
+            cerr << "*** ERROR: " << filename << ":" << lineno
+                 << ": Missing event time\n";
+            return false;
+          }
+          continue;
+        }
+        Event event;
+        event.time_ms = llround(time * 1000.0);
+        event.is_sql = false;
+        event.sql_open = false;
+        event.digit = '?';
+        event.duration = 100;
+        ss >> cmd;
+        if ((time < 0.0) || ((cmd != "SQL") && (cmd != "DTMF")))
+        {
+          cerr << "*** ERROR: " << filename << ":" << lineno
+               << ": Invalid event. Valid events are: SQL, DTMF.\n";
+          return false;
+        }
+        if (cmd == "SQL")
+        {
+          int is_open;
+          if (!(ss >> is_open))
+          {
+            cerr << "*** ERROR: " << filename << ":" << lineno
+                 << ": The SQL event require a 1 or 0 argument\n";
+            return false;
+          }
+          event.is_sql = true;
+          event.sql_open = (is_open != 0);
+          ss >> ws;
+          getline(ss, event.info);
+        }
+        else
+        {
+          string digit;
+          if (!(ss >> digit) || (digit.size() != 1) ||
+              (string("0123456789ABCD*#").find(digit[0]) == string::npos))
+          {
+            cerr << "*** ERROR: " << filename << ":" << lineno
+                 << ": The DTMF event require a digit argument\n";
+            return false;
+          }
+          event.digit = digit[0];
+          ss >> event.duration;
+        }
+        events.push_back(event);
+      }
+      stable_sort(events.begin(), events.end());
+      return true;
+    }
+
+    void scheduleNextEvent(void)
+    {
+      if (next_event < events.size())
+      {
+        uint64_t time_ms = events[next_event].time_ms;
+        event_timer.setTimeout(
+            (time_ms > sim_app->now()) ? (time_ms - sim_app->now()) : 0);
+        event_timer.setEnable(true);
+      }
+      else
+      {
+        event_timer.setEnable(false);
+      }
+    }
+
+    void handleEvents(void)
+    {
+        // Write the audio up to the time of the event first so that the
+        // audio is aligned with the squelch events
+      writeAudio();
+      while ((next_event < events.size()) &&
+             (events[next_event].time_ms <= sim_app->now()))
+      {
+        const Event& event = events[next_event++];
+        if (event.is_sql)
+        {
+          trace_sql_open = event.sql_open;
+          sql_info = event.info;
+          updateSquelch();
+        }
+        else if (mute_state == MUTE_NONE)
+        {
+          ostringstream ss;
+          ss << "DTMF " << event.digit << " (" << event.duration << "ms)";
+          printEvent(name(), ss.str());
+          dtmfDigitDetected(event.digit, event.duration);
+        }
+      }
+      scheduleNextEvent();
+    }
+
+    void updateSquelch(void)
+    {
+      bool is_open = trace_sql_open && (mute_state != MUTE_ALL);
+      if (is_open == squelchIsOpen())
+      {
+        return;
+      }
+      printEvent(name(), is_open ? "SQL OPEN" : "SQL CLOSED");
+      if (!is_open)
+      {
+        sinkFlushSamples();
+      }
+      setSquelchState(is_open, sql_info);
+    }
+
+    void writeAudio(void)
+    {
+      const uint64_t end = sim_app->now() * INTERNAL_SAMPLE_RATE / 1000;
+      if (squelchIsOpen() && (mute_state == MUTE_NONE))
+      {
+        float buf[RX_BLOCK_MS * INTERNAL_SAMPLE_RATE / 1000];
+        const int buf_size = sizeof(buf) / sizeof(*buf);
+        while (audio_pos < end)
+        {
+          int count = min(uint64_t(buf_size), end - audio_pos);
+          for (int i=0; i<count; ++i)
+          {
+            uint64_t pos = audio_pos + i;
+            buf[i] = (pos < audio.size()) ? audio[pos] / 32768.0f : 0.0f;
+          }
+          int written = sinkWriteSamples(buf, count);
+          written_cnt += written;
+          dropped_cnt += count - written;
+          audio_pos += count;
+        }
+      }
+      audio_pos = end;
+    }
+
+};  /* class ReplayRx */
+
+
+vector<ReplayRx*> ReplayRx::instances;
+
+
+class ReplayRxFactory : public RxFactory
+{
+  public:
+    ReplayRxFactory(void) : RxFactory("Replay") {}
+
+  protected:
+    Rx *createRx(Config& cfg, const string& name)
+    {
+      return new ReplayRx(cfg, name);
+    }
+}; /* class ReplayRxFactory */
+
+
+/**
+ * A transmitter that consume the audio at the internal sample rate, just
+ * like a sound card would do. The transmissions are counted and a hash is
+ * calculated over the transmitted audio so that two replays can easily be
+ * compared.
+ */
+class ReplayTx : public Tx
+{
+  public:
+    static vector<ReplayTx*> instances;
+
+    ReplayTx(const string& name)
+      : Tx(name), state_det(0), ctrl_mode(TX_OFF), audio_started(false),
+        tx_cnt(0), tx_start(0), tx_time(0), sample_cnt(0),
+        audio_hash(2166136261U), output(this)
+    {
+        // The transmitter state changes are printed with a time stamp instead
+      setVerbose(false);
+      instances.push_back(this);
+    }
+
+    ~ReplayTx(void)
+    {
+      clearHandler();
+      delete state_det;
+      instances.erase(find(instances.begin(), instances.end(), this));
+    }
+
+    bool initialize(void)
+    {
+      state_det = new AudioStreamStateDetector;
+      state_det->sigStreamStateChanged.connect(
+          mem_fun(*this, &ReplayTx::audioStreamStateChanged));
+      setHandler(state_det);
+      AudioPacer *pacer = new AudioPacer(INTERNAL_SAMPLE_RATE, TX_BLOCK_SIZE, 0);
+      state_det->registerSink(pacer, true);
+      pacer->registerSink(&output);
+      return true;
+    }
+
+    void setTxCtrlMode(TxCtrlMode mode)
+    {
+      ctrl_mode = mode;
+      updateTransmitter();
+    }
+
+    void sendDtmf(const string& digits, unsigned duration)
+    {
+      printEvent(name(), "DTMF " + digits);
+    }
+
+    void printStats(ostream& os) const
+    {
+        // Include a transmission that is still in progress
+      uint64_t on_air = tx_time;
+      if (isTransmitting())
+      {
+        on_air += sim_app->now() - tx_start;
+      }
+      os << name() << ": " << tx_cnt << " transmissions, " << fixed
+         << setprecision(3) << on_air / 1000.0 << "s on air, "
+         << double(sample_cnt) / INTERNAL_SAMPLE_RATE << "s audio, "
+         << "audio hash " << hex << setw(8) << setfill('0') << audio_hash
+         << dec << setfill(' ') << endl;
+    }
+
+  private:
+    class Output : public AudioSink
+    {
+      public:
+        Output(ReplayTx *tx) : tx(tx) {}
+        int writeSamples(const float *samples, int count)
+        {
+          return tx->writeOutput(samples, count);
+        }
+        void flushSamples(void)
+        {
+          sourceAllSamplesFlushed();
+        }
+      private:
+        ReplayTx *tx;
+    };
+
+    AudioStreamStateDetector  *state_det;
+    TxCtrlMode                ctrl_mode;
+    bool                      audio_started;
+    unsigned                  tx_cnt;
+    uint64_t                  tx_start;
+    uint64_t                  tx_time;
+    uint64_t                  sample_cnt;
+    uint32_t                  audio_hash;
+    Output                    output;
+
+    void updateTransmitter(void)
+    {
+      bool do_transmit = (ctrl_mode == TX_ON) ||
+        ((ctrl_mode == TX_AUTO) && (state_det != 0) && !state_det->isIdle());
+      if (do_transmit == isTransmitting())
+      {
+        return;
+      }
+      printEvent(name(), do_transmit ? "TX ON" : "TX OFF");
+      if (do_transmit)
+      {
+        ++tx_cnt;
+        tx_start = sim_app->now();
+        audio_started = false;
+      }
+      else
+      {
+        tx_time += sim_app->now() - tx_start;
+      }
+      setIsTransmitting(do_transmit);
+    }
+
+    void audioStreamStateChanged(bool is_active, bool is_idle)
+    {
+      updateTransmitter();
+    }
+
+    int writeOutput(const float *samples, int count)
+    {
+      if (!isTransmitting())
+      {
+        return count;
+      }
+      if (!audio_started && (count > 0))
+      {
+        audio_started = true;
+        txAudioStarted();
+      }
+      sample_cnt += count;
+      for (int i=0; i<count; ++i)
+      {
+        float sample = max(-1.0f, min(1.0f, samples[i]));
+        uint16_t quant = static_cast<uint16_t>(lrintf(sample * 32767.0f));
+        audio_hash = (audio_hash ^ (quant & 0xff)) * 16777619U;
+        audio_hash = (audio_hash ^ (quant >> 8)) * 16777619U;
+      }
+      return count;
+    }
+
+};  /* class ReplayTx */
+
+
+vector<ReplayTx*> ReplayTx::instances;
+
+
+class ReplayTxFactory : public TxFactory
+{
+  public:
+    ReplayTxFactory(void) : TxFactory("Replay") {}
+
+  protected:
+    Tx *createTx(Config& cfg, const string& name)
+    {
+      return new ReplayTx(name);
+    }
+}; /* class ReplayTxFactory */
+
+
+/**
+ * A wrapper for a logic core class that print all events
+ */
+template <class LogicT>
+class ReplayLogic : public LogicT
+{
+  public:
+    static unsigned event_cnt;
+
+    ReplayLogic(Config& cfg, const string& name) : LogicT(cfg, name) {}
+
+    void processEvent(const string& event, const Module *module=0)
+    {
+      ++event_cnt;
+      printEvent(this->name(), event);
+      LogicT::processEvent(event, module);
+    }
+};
+
+template <class LogicT>
+unsigned ReplayLogic<LogicT>::event_cnt = 0;
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  double duration = -1.0;
+  double tail = DEFAULT_TAIL;
+  static const struct option long_options[] =
+  {
+    { "duration", required_argument, 0, 'd' },
+    { "tail",     required_argument, 0, 't' },
+    { "quiet",    no_argument,       0, 'q' },
+    { "help",     no_argument,       0, 'h' },
+    { 0, 0, 0, 0 }
+  };
+  int opt;
+  while ((opt = getopt_long(argc, argv, "d:t:qh", long_options, 0)) != -1)
+  {
+    switch (opt)
+    {
+      case 'd':
+        duration = atof(optarg);
+        break;
+      case 't':
+        tail = atof(optarg);
+        break;
+      case 'q':
+        quiet = true;
+        break;
+      default:
+        usage();
+        exit((opt == 'h') ? 0 : 1);
+    }
+  }
+  if (optind != argc - 1)
+  {
+    usage();
+    exit(1);
+  }
+
+  SimApplication app;
+  sim_app = &app;
+
+  Config cfg;
+  if (!cfg.open(argv[optind]))
+  {
+    cerr << "*** ERROR: Could not open configuration file: "
+         << argv[optind] << endl;
+    exit(1);
+  }
+
+  string value;
+  if (cfg.getValue("GLOBAL", "LINKS", value))
+  {
+    if (!LinkManager::initialize(cfg, value))
+    {
+      cerr << "*** ERROR: Could not initialize link manager. "
+           << "GLOBAL/LINKS=" << value << ".\n";
+      exit(1);
+    }
+  }
+
+  ReplayRxFactory replay_rx_factory;
+  ReplayTxFactory replay_tx_factory;
+
+  vector<LogicBase*> logics;
+  string logic_names;
+  cfg.getValue("GLOBAL", "LOGICS", logic_names);
+  istringstream ss(logic_names);
+  string logic_name;
+  while (getline(ss, logic_name, ','))
+  {
+    string logic_type;
+    cfg.getValue(logic_name, "TYPE", logic_type);
+    LogicBase *logic = 0;
+    if (logic_type == "Simplex")
+    {
+      logic = new ReplayLogic<SimplexLogic>(cfg, logic_name);
+    }
+    else if (logic_type == "Repeater")
+    {
+      logic = new ReplayLogic<RepeaterLogic>(cfg, logic_name);
+    }
+    else if (logic_type == "Dummy")
+    {
+      logic = new DummyLogic(cfg, logic_name);
+    }
+    else
+    {
+      cerr << "*** ERROR: Logic type \"" << logic_type << "\" of logic "
+           << logic_name << " can not be replayed. Valid types are: "
+           << "Simplex, Repeater, Dummy.\n";
+      exit(1);
+    }
+    if (!logic->initialize())
+    {
+      cerr << "*** ERROR: Could not initialize Logic object \""
+           << logic_name << "\"\n";
+      exit(1);
+    }
+    logics.push_back(logic);
+  }
+  if (logics.empty())
+  {
+    cerr << "*** ERROR: No logics specified in GLOBAL/LOGICS\n";
+    exit(1);
+  }
+
+  if (LinkManager::hasInstance())
+  {
+    LinkManager::instance()->allLogicsStarted();
+  }
+
+  if (duration < 0.0)
+  {
+    duration = 0.0;
+    for (size_t i=0; i<ReplayRx::instances.size(); ++i)
+    {
+      duration = max(duration, ReplayRx::instances[i]->endTime());
+    }
+    duration += tail;
+  }
+  Timer end_timer(llround(duration * 1000.0));
+  end_timer.expired.connect(hide(mem_fun(app, &SimApplication::quit)));
+
+  if (app.fdWatchCount() > 0)
+  {
+    cerr << "*** WARNING: " << app.fdWatchCount() << " file descriptors are "
+            "watched but no I/O will take place during the replay\n";
+  }
+
+  const double real_start = monotonicTime();
+  const double cpu_start = cpuTime();
+  const uint64_t sim_start = app.now();
+  app.exec();
+  const double real_time = monotonicTime() - real_start;
+  const double cpu_time = cpuTime() - cpu_start;
+  const double sim_time = (app.now() - sim_start) / 1000.0;
+
+  cout << "\n--- Replay summary\n";
+  for (size_t i=0; i<ReplayRx::instances.size(); ++i)
+  {
+    ReplayRx::instances[i]->printStats(cout);
+  }
+  for (size_t i=0; i<ReplayTx::instances.size(); ++i)
+  {
+    ReplayTx::instances[i]->printStats(cout);
+  }
+  cout << "Logic events:     "
+       << ReplayLogic<SimplexLogic>::event_cnt +
+          ReplayLogic<RepeaterLogic>::event_cnt << endl;
+  cout << "Timer events:     " << app.timerEventCount() << endl;
+  cout << fixed << setprecision(3);
+  cout << "Simulated time:   " << sim_time << "s\n";
+  cout << "Real time:        " << real_time << "s\n";
+  cout << "CPU time:         " << cpu_time << "s\n";
+  cout << "Real time factor: " << setprecision(1)
+       << ((real_time > 0.0) ? sim_time / real_time : 0.0) << endl;
+
+    // Transmitters are turned off when the logics are deleted. That is not
+    // part of the replay so it should not be printed.
+  quiet = true;
+  LinkManager::deleteInstance();
+  for (size_t i=0; i<logics.size(); ++i)
+  {
+    delete logics[i];
+  }
+
+  return 0;
+} /* main */
+
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+static void printEvent(const string& source, const string& text)
+{
+  if (!quiet)
+  {
+    cout << "[" << fixed << setprecision(3) << setw(10)
+         << sim_app->now() / 1000.0 << "] " << source << ": " << text << endl;
+  }
+} /* printEvent */
+
+
+static double monotonicTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+} /* monotonicTime */
+
+
+static double cpuTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+} /* cpuTime */
+
+
+static void usage(void)
+{
+  cerr << "Usage: LogicReplay [options] <config file>\n"
+          "  -d, --duration=<s>  Replay this many seconds of simulated time\n"
+          "  -t, --tail=<s>      Time to run after the last recorded event "
+          "(default " << DEFAULT_TAIL << "s)\n"
+          "  -q, --quiet         Only print the summary\n"
+          "  -h, --help          Print this help\n";
+} /* usage */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -51,7 +51,10 @@ Module::Module(void *dl_handle, Logic *logic, const string& cfg_name)
     m_is_transmitting(false), m_is_active(false), m_cfg_name(cfg_name),
     m_tmo_timer(0), m_mute_linking(true)
 {
-  
+    // The id and name are needed to find the module even if the
+    // initialization is deferred until the module is activated
+  cfg().getValue(cfgName(), "ID", m_id);
+  cfg().getValue(cfgName(), "NAME", m_name);
 } /* Module::Module */
 
 
@@ -38,6 +38,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <dirent.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <math.h>
@@ -51,7 +52,11 @@ extern "C" {
 #include <iostream>
 #include <cstring>
 #include <fstream>
+#include <sstream>
 #include <cerrno>
+#include <vector>
+#include <memory>
+#include <mutex>
 
 
 
@@ -61,6 +66,7 @@ extern "C" {
  *
  ****************************************************************************/
 
+#include <AsyncAudioOscillator.h>
 
 
 /****************************************************************************
@@ -80,6 +86,7 @@ extern "C" {
  ****************************************************************************/
 
 using namespace std;
+using namespace Async;
 
 
 
@@ -108,6 +115,10 @@ class QueueItem
     virtual bool initialize(void) { return true; }
     virtual int readSamples(float *samples, int len) = 0;
     virtual void unreadSamples(int len) = 0;
+
+      // A string that uniquely describe the audio of this item. An empty
+      // string mean that the item cannot be part of a cached sequence.
+    virtual std::string key(void) const { return std::string(); }
     
     bool idleMarked(void) const { return idle_marked; }
   
@@ -123,6 +134,7 @@ class SilenceQueueItem : public QueueItem
       	silence_left(sample_rate * len / 1000) {}
     int readSamples(float *samples, int len);
     void unreadSamples(int len);
+    std::string key(void) const;
 
   private:
     int len;
@@ -135,16 +147,21 @@ class ToneQueueItem : public QueueItem
   public:
     ToneQueueItem(int fq, int amp, int len, int sample_rate, bool idle_marked)
       : QueueItem(idle_marked), fq(fq), amp(amp),
-      	tone_len(sample_rate * len / 1000), pos(0), sample_rate(sample_rate) {}
+        tone_len(sample_rate * len / 1000), pos(0)
+    {
+      osc.setFq(fq, sample_rate);
+      osc.setAmplitude(amp / 1000.0);
+    }
     int readSamples(float *samples, int len);
     void unreadSamples(int len);
+    std::string key(void) const;
 
   private:
-    int fq;
-    int amp;
-    int tone_len;
-    int pos;
-    int sample_rate;
+    int             fq;
+    int             amp;
+    int             tone_len;
+    int             pos;
+    AudioOscillator osc;
     
 };
 
@@ -154,17 +171,26 @@ class DtmfQueueItem : public QueueItem
     DtmfQueueItem(int fqh, int fql, int amp, int len, int sample_rate,
                   bool idle_marked)
       : QueueItem(idle_marked), fqh(fqh), fql(fql), amp(amp),
-        tone_len(sample_rate * len / 1000), pos(0), sample_rate(sample_rate) {}
+        tone_len(sample_rate * len / 1000), pos(0)
+    {
+      tones[0].setFq(fqh, sample_rate);
+      tones[1].setFq(fql, sample_rate);
+      for (int i=0; i<2; ++i)
+      {
+        tones[i].setAmplitude(amp / 1000.0);
+      }
+    }
     int readSamples(float *samples, int len);
     void unreadSamples(int len);
+    std::string key(void) const;
 
   private:
-    int fqh;
-    int fql;
-    int amp;
-    int tone_len;
-    int pos;
-    int sample_rate;
+    int             fqh;
+    int             fql;
+    int             amp;
+    int             tone_len;
+    int             pos;
+    AudioOscillator tones[2];
 
 };
 
@@ -242,6 +268,80 @@ class WavFileQueueItem : public QueueItem
     int read16bitValue(uint8_t *ptr, uint16_t *val);
 };
 
+/*
+ * The clip cache is shared by all logics. Logics may run in different
+ * threads so all access to the cache is serialized by a mutex.
+ */
+class ClipCache
+{
+  public:
+    typedef std::shared_ptr<const std::vector<float> > Clip;
+
+    ClipCache(void) : max_size(DEFAULT_MAX_SIZE), used_size(0) {}
+    void setMaxSize(size_t max_bytes);
+    Clip find(const std::string& path);
+    bool load(const std::string& path, Clip& clip, bool allow_evict=true);
+    bool insert(const std::string& key, const Clip& clip);
+
+  private:
+    static const size_t DEFAULT_MAX_SIZE = 4 * 1024 * 1024;
+
+    typedef std::list<std::string> LruList;
+    struct Entry
+    {
+      Clip              clip;
+      LruList::iterator lru_it;
+    };
+    typedef std::map<std::string, Entry> ClipMap;
+
+    std::mutex  mutex;
+    size_t      max_size;
+    size_t      used_size;
+    ClipMap     clips;
+    LruList     lru;
+
+    void evict(size_t max_used);
+};
+
+class ClipQueueItem : public QueueItem
+{
+  public:
+    ClipQueueItem(const std::string& filename, bool idle_marked)
+      : QueueItem(idle_marked), filename(filename), pos(0), file_item(0) {}
+    ~ClipQueueItem(void) { delete file_item; }
+    bool initialize(void);
+    int readSamples(float *samples, int len);
+    void unreadSamples(int len);
+    std::string key(void) const { return "file:" + filename; }
+
+  private:
+    string          filename;
+    ClipCache::Clip clip;
+    size_t          pos;
+    QueueItem       *file_item;
+};
+
+class SequenceQueueItem : public QueueItem
+{
+  public:
+    SequenceQueueItem(const std::vector<QueueItem*>& items, int sample_rate,
+                      bool idle_marked)
+      : QueueItem(idle_marked), items(items), sample_rate(sample_rate),
+        pos(0) {}
+    ~SequenceQueueItem(void) { deleteItems(); }
+    bool initialize(void);
+    int readSamples(float *samples, int len);
+    void unreadSamples(int len);
+
+  private:
+    std::vector<QueueItem*> items;
+    int                     sample_rate;
+    ClipCache::Clip         clip;
+    size_t                  pos;
+
+    void deleteItems(void);
+};
+
 
 
 /****************************************************************************
@@ -250,6 +350,8 @@ class WavFileQueueItem : public QueueItem
  *
  ****************************************************************************/
 
+static QueueItem *createFileQueueItem(const string& path, bool idle_marked);
+static unsigned preloadDirectory(const string& dir);
 
 
 /****************************************************************************
@@ -267,6 +369,7 @@ class WavFileQueueItem : public QueueItem
  *
  ****************************************************************************/
 
+static ClipCache clip_cache;
 
 
 /****************************************************************************
@@ -275,9 +378,21 @@ class WavFileQueueItem : public QueueItem
  *
  ****************************************************************************/
 
+void MsgHandler::setClipCacheSize(size_t max_bytes)
+{
+  clip_cache.setMaxSize(max_bytes);
+} /* MsgHandler::setClipCacheSize */
+
+
+unsigned MsgHandler::preloadClips(const std::string& dir)
+{
+  return preloadDirectory(dir);
+} /* MsgHandler::preloadClips */
+
+
 MsgHandler::MsgHandler(int sample_rate)
   : sample_rate(sample_rate), nesting_level(0), pending_play_next(false),
-    current(0), is_writing_message(false), non_idle_cnt(0)
+    current(0), is_writing_message(false), non_idle_cnt(0), seq_level(0)
 {
   
 }
@@ -291,20 +406,7 @@ MsgHandler::~MsgHandler(void)
 
 void MsgHandler::playFile(const string& path, bool idle_marked)
 {
-  QueueItem *item = 0;
-  const char *ext = strrchr(path.c_str(), '.');
-  if (strcmp(ext, ".gsm") == 0)
-  {
-    item = new GsmFileQueueItem(path, idle_marked);
-  }
-  else if (strcmp(ext, ".wav") == 0)
-  {
-    item = new WavFileQueueItem(path, idle_marked);
-  }
-  else
-  {
-    item = new RawFileQueueItem(path, idle_marked);
-  }
+  QueueItem *item = new ClipQueueItem(path, idle_marked);
   addItemToQueue(item);
 } /* MsgHandler::playFile */
 
@@ -356,6 +458,37 @@ void MsgHandler::playDtmf(char digit, int amp, int length, bool idle_marked)
 } /* MsgHandler::playDtmf */
 
 
+void MsgHandler::beginSequence(void)
+{
+  ++seq_level;
+} /* MsgHandler::beginSequence */
+
+
+void MsgHandler::endSequence(void)
+{
+  assert(seq_level > 0);
+  if (--seq_level > 0)
+  {
+    return;
+  }
+  if (seq_items.empty())
+  {
+    return;
+  }
+
+  bool idle_marked = true;
+  for (vector<QueueItem*>::const_iterator it=seq_items.begin();
+       it!=seq_items.end(); ++it)
+  {
+    idle_marked = idle_marked && (*it)->idleMarked();
+  }
+  QueueItem *item = new SequenceQueueItem(seq_items, sample_rate,
+                                          idle_marked);
+  seq_items.clear();
+  addItemToQueue(item);
+} /* MsgHandler::endSequence */
+
+
 void MsgHandler::clear(void)
 {
   clearP();
@@ -381,6 +514,15 @@ void MsgHandler::end(void)
   --nesting_level;
   if (nesting_level == 0)
   {
+      // A sequence that was not ended, e.g. because of a script error, is
+      // ended here so that the audio is not held back forever
+    if (seq_level > 0)
+    {
+      cerr << "*** WARNING: Announcement sequence not ended. Missing call "
+              "to endSequence?\n";
+      seq_level = 1;
+      endSequence();
+    }
     if (pending_play_next)
     {
       pending_play_next = false;
@@ -431,6 +573,12 @@ void MsgHandler::allSamplesFlushed(void)
 
 void MsgHandler::addItemToQueue(QueueItem *item)
 {
+  if (seq_level > 0)
+  {
+    seq_items.push_back(item);
+    return;
+  }
+
   is_writing_message = true;
   if (!item->idleMarked())
   {
@@ -547,6 +695,14 @@ void MsgHandler::clearP(void)
   non_idle_cnt = 0;
 
   msg_queue.clear();
+
+    // Items collected for a sequence have not been counted as non idle
+  for (vector<QueueItem*>::iterator it=seq_items.begin();
+       it!=seq_items.end(); ++it)
+  {
+    delete *it;
+  }
+  seq_items.clear();
 } /* MsgHandler::clearP */
 
 
@@ -997,6 +1153,356 @@ int WavFileQueueItem::read16bitValue(uint8_t *ptr, uint16_t *val)
 
 
 
+/****************************************************************************
+ *
+ * Private member functions for class ClipCache
+ *
+ ****************************************************************************/
+
+void ClipCache::setMaxSize(size_t max_bytes)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  max_size = max_bytes;
+  evict(max_size);
+} /* ClipCache::setMaxSize */
+
+
+ClipCache::Clip ClipCache::find(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  ClipMap::iterator it = clips.find(path);
+  if (it == clips.end())
+  {
+    return Clip();
+  }
+  lru.splice(lru.begin(), lru, it->second.lru_it);
+  return it->second.clip;
+} /* ClipCache::find */
+
+
+bool ClipCache::load(const std::string& path, Clip& clip, bool allow_evict)
+{
+  clip.reset();
+
+    // Estimate the decoded size from the file size to find out if the clip
+    // should be cached at all before spending time on decoding it
+  struct stat st;
+  if ((stat(path.c_str(), &st) != 0) || !S_ISREG(st.st_mode))
+  {
+    return true;
+  }
+  size_t est_samples = st.st_size / sizeof(short);
+  const char *ext = strrchr(path.c_str(), '.');
+  if ((ext != 0) && (strcmp(ext, ".gsm") == 0))
+  {
+    est_samples = st.st_size / sizeof(gsm_frame) * 160;
+  }
+  const size_t est_size = est_samples * sizeof(float);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if ((est_size > max_size / 4) ||
+        (!allow_evict && (used_size + est_size > max_size)))
+    {
+      return true;
+    }
+  }
+
+    // The clip is decoded without holding the lock. If another thread load
+    // the same clip at the same time, the last one inserted is kept.
+  QueueItem *item = createFileQueueItem(path, true);
+  if (!item->initialize())
+  {
+    delete item;
+    return false;
+  }
+  std::vector<float> *samples = new std::vector<float>;
+  samples->reserve(est_samples);
+  float buf[WRITE_BLOCK_SIZE];
+  int cnt;
+  while ((cnt = item->readSamples(buf, WRITE_BLOCK_SIZE)) > 0)
+  {
+    samples->insert(samples->end(), buf, buf + cnt);
+  }
+  delete item;
+  samples->shrink_to_fit();
+  clip.reset(samples);
+  insert(path, clip);
+
+  return true;
+} /* ClipCache::load */
+
+
+bool ClipCache::insert(const std::string& key, const Clip& clip)
+{
+  const size_t size = clip->size() * sizeof(float);
+  std::lock_guard<std::mutex> lock(mutex);
+  if ((max_size == 0) || (size > max_size / 4))
+  {
+    return false;
+  }
+
+  ClipMap::iterator it = clips.find(key);
+  if (it != clips.end())
+  {
+    used_size -= it->second.clip->size() * sizeof(float);
+    lru.erase(it->second.lru_it);
+    clips.erase(it);
+  }
+
+  evict(max_size - size);
+  lru.push_front(key);
+  Entry& entry = clips[key];
+  entry.clip = clip;
+  entry.lru_it = lru.begin();
+  used_size += size;
+
+  return true;
+} /* ClipCache::insert */
+
+
+void ClipCache::evict(size_t max_used)
+{
+  while ((used_size > max_used) && !lru.empty())
+  {
+    ClipMap::iterator it = clips.find(lru.back());
+    assert(it != clips.end());
+    used_size -= it->second.clip->size() * sizeof(float);
+    clips.erase(it);
+    lru.pop_back();
+  }
+} /* ClipCache::evict */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions for class ClipQueueItem
+ *
+ ****************************************************************************/
+
+bool ClipQueueItem::initialize(void)
+{
+  assert((clip == 0) && (file_item == 0));
+
+  clip = clip_cache.find(filename);
+  if (clip != 0)
+  {
+    return true;
+  }
+
+  if (!clip_cache.load(filename, clip))
+  {
+    return false;
+  }
+  if (clip != 0)
+  {
+    return true;
+  }
+
+    // The clip could not be cached so play it directly from the file
+  file_item = createFileQueueItem(filename, idleMarked());
+  return file_item->initialize();
+} /* ClipQueueItem::initialize */
+
+
+int ClipQueueItem::readSamples(float *samples, int len)
+{
+  if (file_item != 0)
+  {
+    return file_item->readSamples(samples, len);
+  }
+
+  assert(clip != 0);
+  const int cnt = min(static_cast<size_t>(len), clip->size() - pos);
+  memcpy(samples, &(*clip)[pos], cnt * sizeof(*samples));
+  pos += cnt;
+  return cnt;
+} /* ClipQueueItem::readSamples */
+
+
+void ClipQueueItem::unreadSamples(int len)
+{
+  if (file_item != 0)
+  {
+    file_item->unreadSamples(len);
+    return;
+  }
+
+  assert(static_cast<size_t>(len) <= pos);
+  pos -= len;
+} /* ClipQueueItem::unreadSamples */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions for class SequenceQueueItem
+ *
+ ****************************************************************************/
+
+bool SequenceQueueItem::initialize(void)
+{
+  assert(clip == 0);
+
+    // The sample rate is part of the key since the silence and tone
+    // lengths depend on it
+  ostringstream ss;
+  ss << "sequence:" << sample_rate;
+  bool cacheable = true;
+  for (vector<QueueItem*>::const_iterator it=items.begin();
+       it!=items.end(); ++it)
+  {
+    const string item_key = (*it)->key();
+    cacheable = cacheable && !item_key.empty();
+    ss << "\n" << item_key;
+  }
+  const string seq_key = ss.str();
+
+  if (cacheable)
+  {
+    clip = clip_cache.find(seq_key);
+    if (clip != 0)
+    {
+      deleteItems();
+      return true;
+    }
+  }
+
+    // Render the whole sequence. A sequence with an item that could not be
+    // played, e.g. a missing file, is not cached so that it is rendered
+    // again the next time.
+  std::vector<float> *samples = new std::vector<float>;
+  float buf[WRITE_BLOCK_SIZE];
+  for (vector<QueueItem*>::iterator it=items.begin(); it!=items.end(); ++it)
+  {
+    if (!(*it)->initialize())
+    {
+      cacheable = false;
+      continue;
+    }
+    int cnt;
+    while ((cnt = (*it)->readSamples(buf, WRITE_BLOCK_SIZE)) > 0)
+    {
+      samples->insert(samples->end(), buf, buf + cnt);
+    }
+  }
+  deleteItems();
+  samples->shrink_to_fit();
+  clip.reset(samples);
+
+  if (cacheable)
+  {
+    clip_cache.insert(seq_key, clip);
+  }
+
+  return true;
+} /* SequenceQueueItem::initialize */
+
+
+int SequenceQueueItem::readSamples(float *samples, int len)
+{
+  assert(clip != 0);
+  const int cnt = min(static_cast<size_t>(len), clip->size() - pos);
+  memcpy(samples, &(*clip)[pos], cnt * sizeof(*samples));
+  pos += cnt;
+  return cnt;
+} /* SequenceQueueItem::readSamples */
+
+
+void SequenceQueueItem::unreadSamples(int len)
+{
+  assert(static_cast<size_t>(len) <= pos);
+  pos -= len;
+} /* SequenceQueueItem::unreadSamples */
+
+
+void SequenceQueueItem::deleteItems(void)
+{
+  for (vector<QueueItem*>::iterator it=items.begin(); it!=items.end(); ++it)
+  {
+    delete *it;
+  }
+  items.clear();
+} /* SequenceQueueItem::deleteItems */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+static QueueItem *createFileQueueItem(const string& path, bool idle_marked)
+{
+  const char *ext = strrchr(path.c_str(), '.');
+  if ((ext != 0) && (strcmp(ext, ".gsm") == 0))
+  {
+    return new GsmFileQueueItem(path, idle_marked);
+  }
+  else if ((ext != 0) && (strcmp(ext, ".wav") == 0))
+  {
+    return new WavFileQueueItem(path, idle_marked);
+  }
+  return new RawFileQueueItem(path, idle_marked);
+} /* createFileQueueItem */
+
+
+static unsigned preloadDirectory(const string& dir)
+{
+  DIR *d = opendir(dir.c_str());
+  if (d == 0)
+  {
+    cerr << "*** WARNING: Could not open audio clip directory \"" << dir
+         << "\" for preloading: " << strerror(errno) << endl;
+    return 0;
+  }
+
+  unsigned cnt = 0;
+  vector<string> subdirs;
+  struct dirent *ent;
+  while ((ent = readdir(d)) != 0)
+  {
+    if (ent->d_name[0] == '.')
+    {
+      continue;
+    }
+    string path(dir + "/" + ent->d_name);
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+      continue;
+    }
+    if (S_ISDIR(st.st_mode))
+    {
+      subdirs.push_back(path);
+      continue;
+    }
+    const char *ext = strrchr(ent->d_name, '.');
+    if ((ext != 0) && ((strcmp(ext, ".wav") == 0) ||
+                       (strcmp(ext, ".gsm") == 0) ||
+                       (strcmp(ext, ".raw") == 0)))
+    {
+      ClipCache::Clip clip;
+      if (clip_cache.load(path, clip, false) && (clip != 0))
+      {
+        ++cnt;
+      }
+    }
+  }
+  closedir(d);
+
+  for (vector<string>::const_iterator it=subdirs.begin();
+       it!=subdirs.end(); ++it)
+  {
+    cnt += preloadDirectory(*it);
+  }
+
+  return cnt;
+} /* preloadDirectory */
+
+
+
 /****************************************************************************
  *
  * Private member functions for class SilenceQueueItem
@@ -1029,6 +1535,14 @@ void SilenceQueueItem::unreadSamples(int len)
 } /* SilenceQueueItem::unreadSamples */
 
 
+std::string SilenceQueueItem::key(void) const
+{
+  ostringstream ss;
+  ss << "silence:" << len;
+  return ss.str();
+} /* SilenceQueueItem::key */
+
+
 
 /****************************************************************************
  *
@@ -1039,11 +1553,9 @@ void SilenceQueueItem::unreadSamples(int len)
 int ToneQueueItem::readSamples(float *samples, int len)
 {
   int read_cnt = min(len, tone_len-pos);
-  for (int i=0; i<read_cnt; ++i)
-  {
-    samples[i] = amp / 1000.0 * sin(2 * M_PI * fq * pos / sample_rate);
-    ++pos;
-  }
+  osc.generate(samples, read_cnt);
+  osc.advance(read_cnt);
+  pos += read_cnt;
   
   return read_cnt;
   
@@ -1053,9 +1565,18 @@ int ToneQueueItem::readSamples(float *samples, int len)
 void ToneQueueItem::unreadSamples(int len)
 {
   pos -= len;
+  osc.advance(-len);
 } /* ToneQueueItem::unreadSamples */
 
 
+std::string ToneQueueItem::key(void) const
+{
+  ostringstream ss;
+  ss << "tone:" << fq << ":" << amp << ":" << tone_len;
+  return ss.str();
+} /* ToneQueueItem::key */
+
+
 
 /****************************************************************************
  *
@@ -1066,13 +1587,12 @@ void ToneQueueItem::unreadSamples(int len)
 int DtmfQueueItem::readSamples(float *samples, int len)
 {
   int read_cnt = min(len, tone_len-pos);
-  for (int i=0; i<read_cnt; ++i)
+  AudioOscillator::generateSum(tones, 2, samples, read_cnt);
+  for (int i=0; i<2; ++i)
   {
-    samples[i] = amp / 1000.0 * (
-                sin(2 * M_PI * fqh * pos / sample_rate) +
-                sin(2 * M_PI * fql * pos / sample_rate));
-    ++pos;
+    tones[i].advance(read_cnt);
   }
+  pos += read_cnt;
 
   return read_cnt;
 } /* DtmfQueueItem::readSamples */
@@ -1081,9 +1601,21 @@ int DtmfQueueItem::readSamples(float *samples, int len)
 void DtmfQueueItem::unreadSamples(int len)
 {
   pos -= len;
+  for (int i=0; i<2; ++i)
+  {
+    tones[i].advance(-len);
+  }
 } /* DtmfQueueItem::unreadSamples */
 
 
+std::string DtmfQueueItem::key(void) const
+{
+  ostringstream ss;
+  ss << "dtmf:" << fqh << ":" << fql << ":" << amp << ":" << tone_len;
+  return ss.str();
+} /* DtmfQueueItem::key */
+
+
 
 /*
  * This file has not been truncated
@@ -41,6 +41,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
 
 #include <sigc++/sigc++.h>
 
@@ -123,6 +124,30 @@ This class handles the playback of audio clips.
 class MsgHandler : public sigc::trackable, public Async::AudioSource
 {
   public:
+    /**
+     * @brief   Set the maximum size of the audio clip cache
+     * @param   max_bytes The maximum size in bytes. 0 disable the cache.
+     *
+     * Audio clips played using playFile are decoded once and then kept in
+     * memory, shared by all message handlers, so that playing a clip again
+     * do not need any file access or decoding. When the cache is full, the
+     * least recently used clips are thrown out. Clips larger than a quarter
+     * of the cache size are always played directly from the file.
+     * Note that a changed file on disk is not noticed once it is cached.
+     */
+    static void setClipCacheSize(size_t max_bytes);
+
+    /**
+     * @brief   Load audio clips into the cache
+     * @param   dir The directory to search for audio clips
+     * @return  Returns the number of clips that were loaded
+     *
+     * All audio clips found in the given directory and its subdirectories
+     * are loaded into the clip cache until it is full. Clips already in the
+     * cache are never thrown out to make room for a preloaded clip.
+     */
+    static unsigned preloadClips(const std::string& dir);
+
     /**
      * @brief 	Default constuctor
      * @param	sample_rate The sample rate of the playback system
@@ -212,6 +237,26 @@ class MsgHandler : public sigc::trackable, public Async::AudioSource
      * executed.
      */
     void end(void);    
+
+    /**
+     * @brief   Mark the beginning of an announcement sequence
+     *
+     * All the playXxx functions called until endSequence is called are
+     * collected into one announcement. When the announcement is played, it
+     * is rendered into one buffer which is kept in the audio clip cache,
+     * using the content of the sequence as the key. An identical
+     * announcement, e.g. an identification, is then played directly from
+     * memory the next time. Multiple beginSequence/endSequence can be nested.
+     */
+    void beginSequence(void);
+
+    /**
+     * @brief   Mark the end of an announcement sequence
+     *
+     * The announcement collected since the outermost beginSequence call is
+     * queued for playback. It is idle marked only if all its parts were.
+     */
+    void endSequence(void);
     
     /**
      * @brief 	A signal that is emitted when all messages has been written
@@ -245,6 +290,8 @@ class MsgHandler : public sigc::trackable, public Async::AudioSource
     QueueItem 	      	    *current;
     bool      	      	    is_writing_message;
     int       	      	    non_idle_cnt;
+    int                     seq_level;
+    std::vector<QueueItem*> seq_items;
     
     MsgHandler(const MsgHandler&);
     MsgHandler& operator=(const MsgHandler&);
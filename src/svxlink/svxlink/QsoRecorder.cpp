@@ -142,7 +142,7 @@ namespace {
 QsoRecorder::QsoRecorder(Logic *logic)
   : recorder(0), hard_chunk_limit(0), soft_chunk_limit(0), max_dirsize(0),
     default_active(false), tmo_timer(0), logic(logic), qso_tmo_timer(0),
-    min_samples(0)
+    min_samples(0), file_ext("wav")
 {
   selector = new AudioSelector;
 } /* QsoRecorder::QsoRecorder */
@@ -151,6 +151,15 @@ QsoRecorder::QsoRecorder(Logic *logic)
 QsoRecorder::~QsoRecorder(void)
 {
   setEnabled(false);
+
+    // Deleting the recorders wait for the files to be completed
+  for (set<AudioRecorder*>::iterator it=closing_recorders.begin();
+       it!=closing_recorders.end(); ++it)
+  {
+    delete *it;
+  }
+  closing_recorders.clear();
+
   delete selector;
   delete tmo_timer;
   delete qso_tmo_timer;
@@ -165,6 +174,14 @@ bool QsoRecorder::initialize(const Config &cfg, const string &name)
     return false;
   }
 
+  cfg.getValue(name, "FORMAT", file_ext);
+  if ((file_ext != "wav") && (file_ext != "opus"))
+  {
+    cerr << "*** ERROR: Illegal value for config variable " << name
+         << "/FORMAT: " << file_ext << ". Valid values are wav and opus.\n";
+    return false;
+  }
+
   unsigned max_time = 0;
   cfg.getValue(name, "MAX_TIME", max_time);
   unsigned soft_time = 0;
@@ -280,7 +297,7 @@ void QsoRecorder::openFile(void)
     string filename(rec_dir);
     filename += "/.qsorec_";
     filename += logic->name();
-    filename += ".wav";
+    filename += "." + file_ext;
     recorder = new AudioRecorder(filename);
     recorder->setMaxRecordingTime(hard_chunk_limit, soft_chunk_limit);
     recorder->maxRecordingTimeReached.connect(
@@ -301,20 +318,23 @@ void QsoRecorder::closeFile(void)
 {
   if (recorder != 0)
   {
-    string oldpath(rec_dir + "/.qsorec_" + logic->name() + ".wav");
+    string oldpath(rec_dir + "/.qsorec_" + logic->name() + "." + file_ext);
 
-    if (!recorder->closeFile())
-    {
-      cerr << "*** ERROR: Failed to close QsoRecorder file \"" << oldpath
-           << "\" in logic " << logic->name() << ": " << recorder->errorMsg()
-           << endl;
-    }
+      // The file is finalized in the background so that neither the
+      // remaining encoding nor the disk I/O hold up the main loop. The
+      // recorder is kept until the file is complete.
+    AudioRecorder *rec = recorder;
+    recorder = 0;
+    rec->unregisterSource();
+    rec->closeFileInBackground();
 
-    if (recorder->samplesWritten() > min_samples)
+    string newpath;
+    string basename;
+    if (rec->samplesWritten() > min_samples)
     {
-      string basename("qsorec_" + logic->name() + "_");
+      basename = "qsorec_" + logic->name() + "_";
 
-      const struct timeval &begin_time = recorder->beginTimestamp();
+      const struct timeval &begin_time = rec->beginTimestamp();
       struct tm tm;
       localtime_r(&begin_time.tv_sec, &tm);
       char timestamp[256];
@@ -323,47 +343,17 @@ void QsoRecorder::closeFile(void)
 
       basename += "_";
 
-      const struct timeval &end_time = recorder->endTimestamp();
+      const struct timeval &end_time = rec->endTimestamp();
       localtime_r(&end_time.tv_sec, &tm);
       strftime(timestamp, sizeof(timestamp), "%Y-%m-%d_%H%M%S", &tm);
       basename += timestamp;
-      string newpath = rec_dir + "/" + basename + ".wav";
+
+        // It is safe to rename the file while it is still being written
+      newpath = rec_dir + "/" + basename + "." + file_ext;
       if (rename(oldpath.c_str(), newpath.c_str()) != 0)
       {
         perror("QsoRecorder rename");
       }
-
-      cout << logic->name() << ": Wrote QSO recorder file "
-           << basename << ".wav\n";
-
-        // Execute external audio file handler (e.g. encoder) if configured
-      if (!encoder_cmd.empty())
-      {
-        cout << logic->name() << ": Starting encoding for file "
-             << basename << ".wav\n";
-        const char *shell = getenv("SHELL");
-        if (shell == NULL)
-        {
-          shell = "/bin/sh";
-        }
-        FileEncoder *enc = new FileEncoder(shell, basename);
-        enc->appendArgument("-c");
-        string cmdline(encoder_cmd);
-        replace_all(cmdline, "%f", newpath);
-        replace_all(cmdline, "%d", rec_dir);
-        replace_all(cmdline, "%b", basename);
-        replace_all(cmdline, "%n", basename + ".wav");
-        enc->appendArgument(cmdline);
-        enc->stdoutData.connect(
-            mem_fun(*this, &QsoRecorder::handleEncoderPrintouts));
-        enc->stderrData.connect(
-            mem_fun(*this, &QsoRecorder::handleEncoderPrintouts));
-        enc->exited.connect(
-            sigc::bind(mem_fun(*this, &QsoRecorder::encoderExited), enc));
-        enc->nice();
-        enc->setTimeout(60*60); // One hour timeout
-        enc->run();
-      }
     }
     else
     {
@@ -373,14 +363,93 @@ void QsoRecorder::closeFile(void)
       }
     }
 
-    delete recorder;
-    recorder = 0;
+    if (rec->isClosing())
+    {
+      rec->fileClosed.connect(sigc::bind(
+            mem_fun(*this, &QsoRecorder::fileClosed), rec, newpath, basename));
+      closing_recorders.insert(rec);
+    }
+    else
+    {
+      if (!rec->errorMsg().empty())
+      {
+        cerr << "*** ERROR: Failed to close QsoRecorder file \"" << oldpath
+             << "\" in logic " << logic->name() << ": " << rec->errorMsg()
+             << endl;
+      }
+      else if (!basename.empty())
+      {
+        cout << logic->name() << ": Wrote QSO recorder file "
+             << basename << "." << file_ext << "\n";
+        startEncoder(newpath, basename);
+      }
+      delete rec;
+    }
 
     cleanupDirectory();
   }
 } /* QsoRecorder::closeFile */
 
 
+void QsoRecorder::fileClosed(bool success, const std::string& errmsg,
+                             AudioRecorder *rec, std::string path,
+                             std::string basename)
+{
+  closing_recorders.erase(rec);
+  delete rec;
+
+  if (!success)
+  {
+    cerr << "*** ERROR: Failed to close QsoRecorder file in logic "
+         << logic->name() << ": " << errmsg << endl;
+    return;
+  }
+
+  if (!basename.empty())
+  {
+    cout << logic->name() << ": Wrote QSO recorder file "
+         << basename << "." << file_ext << "\n";
+    startEncoder(path, basename);
+  }
+} /* QsoRecorder::fileClosed */
+
+
+void QsoRecorder::startEncoder(const std::string& path,
+                               const std::string& basename)
+{
+    // Execute external audio file handler (e.g. encoder) if configured
+  if (encoder_cmd.empty())
+  {
+    return;
+  }
+
+  cout << logic->name() << ": Starting encoding for file "
+       << basename << "." << file_ext << "\n";
+  const char *shell = getenv("SHELL");
+  if (shell == NULL)
+  {
+    shell = "/bin/sh";
+  }
+  FileEncoder *enc = new FileEncoder(shell, basename);
+  enc->appendArgument("-c");
+  string cmdline(encoder_cmd);
+  replace_all(cmdline, "%f", path);
+  replace_all(cmdline, "%d", rec_dir);
+  replace_all(cmdline, "%b", basename);
+  replace_all(cmdline, "%n", basename + "." + file_ext);
+  enc->appendArgument(cmdline);
+  enc->stdoutData.connect(
+      mem_fun(*this, &QsoRecorder::handleEncoderPrintouts));
+  enc->stderrData.connect(
+      mem_fun(*this, &QsoRecorder::handleEncoderPrintouts));
+  enc->exited.connect(
+      sigc::bind(mem_fun(*this, &QsoRecorder::encoderExited), enc));
+  enc->nice();
+  enc->setTimeout(60*60); // One hour timeout
+  enc->run();
+} /* QsoRecorder::startEncoder */
+
+
 void QsoRecorder::cleanupDirectory(void)
 {
   if (max_dirsize == 0)
@@ -465,7 +534,7 @@ void QsoRecorder::handleEncoderPrintouts(const char *buf, int cnt)
 void QsoRecorder::encoderExited(QsoRecorder::FileEncoder *enc)
 {
   cout << logic->name() << ": Encoding done for file "
-             << enc->basename << ".wav\n";
+             << enc->basename << "." << file_ext << "\n";
   if (enc->ifExited() && (enc->exitStatus() != 0))
   {
     cerr << "*** ERROR: QSO recorder external audio file handler in logic "
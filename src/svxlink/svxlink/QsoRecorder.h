@@ -35,6 +35,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <string>
+#include <set>
 
 
 /****************************************************************************
@@ -191,12 +192,18 @@ class QsoRecorder
     Async::Timer          *qso_tmo_timer;
     unsigned              min_samples;
     std::string           encoder_cmd;
+    std::string           file_ext;
+    std::set<Async::AudioRecorder*> closing_recorders;
 
     QsoRecorder(const QsoRecorder&);
     QsoRecorder& operator=(const QsoRecorder&);
     void openNewFile(void);
     void openFile(void);
     void closeFile(void);
+    void fileClosed(bool success, const std::string& errmsg,
+                    Async::AudioRecorder *rec, std::string path,
+                    std::string basename);
+    void startEncoder(const std::string& path, const std::string& basename);
     void cleanupDirectory(void);
     void timerExpired(void);
     void checkTimeoutTimers(void);
@@ -0,0 +1,755 @@
+/**
+@file	 ReflectorConnection.cpp
+@brief   One connection from a ReflectorLogic to a SvxReflector server
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sstream>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncUdpSocket.h>
+#include <AsyncSslContext.h>
+#include <AsyncMetrics.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorConnection.h"
+#include "../reflector/ReflectorMsg.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+ReflectorConnection::ReflectorConnection(const std::string& name,
+                                         const std::string& host,
+                                         uint16_t port)
+  : m_name(name), m_host(host), m_port(port), m_con(0), m_ssl_ctx(0),
+    m_udp_sock(0), m_con_state(STATE_DISCONNECTED), m_client_id(0),
+    m_reconnect_timer(20000, Timer::TYPE_ONESHOT, false),
+    m_heartbeat_timer(1000, Timer::TYPE_PERIODIC, false),
+    m_next_udp_tx_seq(0), m_next_udp_rx_seq(0), m_udp_rx_lost_cnt(0),
+    m_udp_heartbeat_tx_cnt_reset(DEFAULT_UDP_HEARTBEAT_TX_CNT_RESET),
+    m_udp_heartbeat_tx_cnt(0), m_udp_heartbeat_rx_cnt(0),
+    m_tcp_heartbeat_tx_cnt(0), m_tcp_heartbeat_rx_cnt(0), m_selected_tg(0),
+    m_resuming(false), m_session_resumed(false), m_resumed_tg(0),
+    m_resumed_node_info(false), m_udp_rx_cnt(0), m_udp_lost_cnt(0),
+    m_reconnect_cnt(0)
+{
+  timerclear(&m_talker_start);
+  timerclear(&m_last_audio);
+  m_reconnect_timer.expired.connect(
+      sigc::hide(mem_fun(*this, &ReflectorConnection::reconnect)));
+  m_heartbeat_timer.expired.connect(
+      mem_fun(*this, &ReflectorConnection::handleTimerTick));
+} /* ReflectorConnection::ReflectorConnection */
+
+
+ReflectorConnection::~ReflectorConnection(void)
+{
+  delete m_udp_sock;
+  m_udp_sock = 0;
+  delete m_con;
+  m_con = 0;
+} /* ReflectorConnection::~ReflectorConnection */
+
+
+void ReflectorConnection::setCredentials(const std::string& callsign,
+                                         const std::string& auth_key)
+{
+  m_callsign = callsign;
+  m_auth_key = auth_key;
+} /* ReflectorConnection::setCredentials */
+
+
+void ReflectorConnection::setReconnectDelays(unsigned initial_ms,
+                                             unsigned max_ms)
+{
+  m_reconnect_backoff.setDelays(initial_ms, max_ms);
+} /* ReflectorConnection::setReconnectDelays */
+
+
+void ReflectorConnection::setUdpHeartbeatInterval(unsigned interval)
+{
+  m_udp_heartbeat_tx_cnt_reset = interval;
+} /* ReflectorConnection::setUdpHeartbeatInterval */
+
+
+void ReflectorConnection::setMetrics(Async::MetricCounter *rx_cnt,
+                                     Async::MetricCounter *lost_cnt,
+                                     Async::MetricCounter *reconnect_cnt)
+{
+  m_udp_rx_cnt = rx_cnt;
+  m_udp_lost_cnt = lost_cnt;
+  m_reconnect_cnt = reconnect_cnt;
+} /* ReflectorConnection::setMetrics */
+
+
+void ReflectorConnection::selectTg(uint32_t tg)
+{
+  m_selected_tg = tg;
+  if (isLoggedIn())
+  {
+    sendMsg(MsgSelectTG(tg));
+  }
+} /* ReflectorConnection::selectTg */
+
+
+void ReflectorConnection::setMonitorTgs(const std::set<uint32_t>& tgs)
+{
+  m_monitor_tgs = tgs;
+  if (isLoggedIn())
+  {
+    sendMsg(MsgTgMonitor(tgs));
+  }
+} /* ReflectorConnection::setMonitorTgs */
+
+
+void ReflectorConnection::connect(void)
+{
+  if (!isConnected())
+  {
+    cout << m_name << ": Connecting to " << m_host << ":" << m_port << endl;
+    m_reconnect_timer.setEnable(false);
+    m_con = new FramedTcpClient(m_host, m_port);
+    m_con->connected.connect(
+        mem_fun(*this, &ReflectorConnection::onConnected));
+    m_con->disconnected.connect(
+        mem_fun(*this, &ReflectorConnection::onDisconnected));
+    m_con->setFrameHandler<ReflectorConnection,
+                           &ReflectorConnection::onFrameReceived>(this);
+    m_con->setSslContext(m_ssl_ctx);
+    m_con->connect();
+  }
+} /* ReflectorConnection::connect */
+
+
+void ReflectorConnection::disconnect(void)
+{
+  if (m_con != 0)
+  {
+    if (m_con->isConnected())
+    {
+      m_con->disconnect();
+      onDisconnected(m_con, TcpConnection::DR_ORDERED_DISCONNECT);
+    }
+    delete m_con;
+    m_con = 0;
+    m_con_state = STATE_DISCONNECTED;
+  }
+} /* ReflectorConnection::disconnect */
+
+
+void ReflectorConnection::sendMsg(const ReflectorMsg& msg)
+{
+  if (!isConnected())
+  {
+    return;
+  }
+
+  m_tcp_heartbeat_tx_cnt = TCP_HEARTBEAT_TX_CNT_RESET;
+
+  ostringstream ss;
+  ReflectorMsg header(msg.type());
+  if (!header.pack(ss) || !msg.pack(ss))
+  {
+    cerr << "*** ERROR[" << m_name
+         << "]: Failed to pack reflector TCP message\n";
+    disconnect();
+    return;
+  }
+  if (m_con->write(ss.str().data(), ss.str().size()) == -1)
+  {
+    disconnect();
+  }
+} /* ReflectorConnection::sendMsg */
+
+
+void ReflectorConnection::sendUdpMsg(const ReflectorUdpMsg& msg)
+{
+  if (!isLoggedIn())
+  {
+    return;
+  }
+
+  m_udp_heartbeat_tx_cnt = m_udp_heartbeat_tx_cnt_reset;
+
+  if (m_udp_sock == 0)
+  {
+    return;
+  }
+
+  ReflectorUdpMsg header(msg.type(), m_client_id, m_next_udp_tx_seq++);
+  size_t size = header.packedSize() + msg.packedSize();
+  if (m_udp_tx_buf.size() < size)
+  {
+    m_udp_tx_buf.resize(size);
+  }
+  Async::MsgPackBuffer pb(&m_udp_tx_buf[0], m_udp_tx_buf.size());
+  if (!header.pack(pb) || !msg.pack(pb))
+  {
+    cerr << "*** ERROR[" << m_name
+         << "]: Failed to pack reflector UDP message\n";
+    return;
+  }
+  m_udp_sock->write(m_con->remoteHost(), m_con->remotePort(),
+                    pb.data(), pb.size());
+} /* ReflectorConnection::sendUdpMsg */
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ReflectorConnection::onConnected(void)
+{
+  cout << m_name << ": Connection established to " << m_con->remoteHost()
+       << ":" << m_con->remotePort() << endl;
+  sendMsg(MsgProtoVer());
+  m_udp_heartbeat_tx_cnt = m_udp_heartbeat_tx_cnt_reset;
+  m_udp_heartbeat_rx_cnt = UDP_HEARTBEAT_RX_CNT_RESET;
+  m_tcp_heartbeat_tx_cnt = TCP_HEARTBEAT_TX_CNT_RESET;
+  m_tcp_heartbeat_rx_cnt = TCP_HEARTBEAT_RX_CNT_RESET;
+  m_heartbeat_timer.setEnable(true);
+  m_next_udp_tx_seq = 0;
+  m_next_udp_rx_seq = 0;
+  m_udp_rx_lost_cnt = 0;
+  timerclear(&m_talker_start);
+  m_resuming = false;
+  m_session_resumed = false;
+  m_con_state = STATE_EXPECT_AUTH_CHALLENGE;
+  m_con->setMaxFrameSize(ReflectorMsg::MAX_PREAUTH_FRAME_SIZE);
+} /* ReflectorConnection::onConnected */
+
+
+void ReflectorConnection::onDisconnected(TcpConnection *con,
+                                         TcpConnection::DisconnectReason reason)
+{
+  cout << m_name << ": Disconnected from " << m_con->remoteHost() << ":"
+       << m_con->remotePort() << ": "
+       << TcpConnection::disconnectReasonStr(reason) << endl;
+  m_reconnect_timer.setTimeout(m_reconnect_backoff.nextDelay());
+  m_reconnect_timer.setEnable(true);
+  delete m_udp_sock;
+  m_udp_sock = 0;
+  m_next_udp_tx_seq = 0;
+  m_next_udp_rx_seq = 0;
+  m_udp_rx_lost_cnt = 0;
+  m_heartbeat_timer.setEnable(false);
+  timerclear(&m_talker_start);
+  m_con_state = STATE_DISCONNECTED;
+  disconnected(this);
+} /* ReflectorConnection::onDisconnected */
+
+
+void ReflectorConnection::onFrameReceived(FramedTcpConnection *con,
+                                          Async::DataView data)
+{
+  stringstream ss;
+  ss.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+  ReflectorMsg header;
+  if (!header.unpack(ss))
+  {
+    cout << "*** ERROR[" << m_name
+         << "]: Unpacking failed for TCP message header\n";
+    disconnect();
+    return;
+  }
+
+  if ((header.type() > 100) && !isLoggedIn())
+  {
+    cerr << "*** ERROR[" << m_name << "]: Unexpected protocol message received"
+         << endl;
+    disconnect();
+    return;
+  }
+
+  m_tcp_heartbeat_rx_cnt = TCP_HEARTBEAT_RX_CNT_RESET;
+
+  switch (header.type())
+  {
+    case MsgHeartbeat::TYPE:
+      break;
+    case MsgError::TYPE:
+      handleMsgError(ss);
+      break;
+    case MsgProtoVerDowngrade::TYPE:
+      handleMsgProtoVerDowngrade(ss);
+      break;
+    case MsgAuthChallenge::TYPE:
+      handleMsgAuthChallenge(ss);
+      break;
+    case MsgAuthOk::TYPE:
+      handleMsgAuthOk();
+      break;
+    case MsgSessionResumed::TYPE:
+      handleMsgSessionResumed(ss);
+      break;
+    case MsgServerInfo::TYPE:
+      handleMsgServerInfo(ss);
+      break;
+    case MsgSessionToken::TYPE:
+      handleMsgSessionToken(ss);
+      break;
+    default:
+      if (header.type() > 100)
+      {
+        msgReceived(this, header.type(), ss);
+      }
+      break;
+  }
+} /* ReflectorConnection::onFrameReceived */
+
+
+void ReflectorConnection::handleMsgError(std::istream& is)
+{
+  MsgError msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** ERROR[" << m_name << "]: Could not unpack MsgAuthError"
+         << endl;
+    disconnect();
+    return;
+  }
+  cout << m_name << ": Error message received from server: "
+       << msg.message() << endl;
+  disconnect();
+} /* ReflectorConnection::handleMsgError */
+
+
+void ReflectorConnection::handleMsgProtoVerDowngrade(std::istream& is)
+{
+  MsgProtoVerDowngrade msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** ERROR[" << m_name
+         << "]: Could not unpack MsgProtoVerDowngrade" << endl;
+    disconnect();
+    return;
+  }
+  cout << m_name
+       << ": Server too old and we cannot downgrade to protocol version "
+       << msg.majorVer() << "." << msg.minorVer() << " from "
+       << MsgProtoVer::MAJOR << "." << MsgProtoVer::MINOR
+       << endl;
+  disconnect();
+} /* ReflectorConnection::handleMsgProtoVerDowngrade */
+
+
+void ReflectorConnection::handleMsgAuthChallenge(std::istream& is)
+{
+    // A new challenge after a session resumption attempt mean that the
+    // server did not accept the session so a normal login is needed
+  if ((m_con_state != STATE_EXPECT_AUTH_CHALLENGE) &&
+      !((m_con_state == STATE_EXPECT_AUTH_OK) && m_resuming))
+  {
+    cerr << "*** ERROR[" << m_name << "]: Unexpected MsgAuthChallenge\n";
+    disconnect();
+    return;
+  }
+
+  MsgAuthChallenge msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** ERROR[" << m_name << "]: Could not unpack MsgAuthChallenge\n";
+    disconnect();
+    return;
+  }
+  const uint8_t *challenge = msg.challenge();
+  if (challenge == 0)
+  {
+    cerr << "*** ERROR[" << m_name << "]: Illegal challenge received\n";
+    disconnect();
+    return;
+  }
+  if (!m_session_token.empty())
+  {
+      // A token can only be used once so forget it. If the server does not
+      // answer, e.g. because it does not support resumption, the next
+      // connection attempt will use a normal login.
+    sendMsg(MsgSessionResume(m_callsign, m_session_token, challenge,
+                             m_node_info_digest));
+    m_session_token.clear();
+    m_resuming = true;
+  }
+  else
+  {
+    sendMsg(MsgAuthResponse(m_callsign, m_auth_key, challenge));
+    m_resuming = false;
+  }
+  m_con_state = STATE_EXPECT_AUTH_OK;
+} /* ReflectorConnection::handleMsgAuthChallenge */
+
+
+void ReflectorConnection::handleMsgAuthOk(void)
+{
+  if (m_con_state != STATE_EXPECT_AUTH_OK)
+  {
+    cerr << "*** ERROR[" << m_name << "]: Unexpected MsgAuthOk\n";
+    disconnect();
+    return;
+  }
+  cout << m_name << ": Authentication OK" << endl;
+  m_con_state = STATE_EXPECT_SERVER_INFO;
+  m_con->setMaxFrameSize(ReflectorMsg::MAX_POSTAUTH_FRAME_SIZE);
+} /* ReflectorConnection::handleMsgAuthOk */
+
+
+void ReflectorConnection::handleMsgSessionResumed(std::istream& is)
+{
+  if ((m_con_state != STATE_EXPECT_SERVER_INFO) || !m_resuming)
+  {
+    cerr << "*** ERROR[" << m_name << "]: Unexpected MsgSessionResumed\n";
+    disconnect();
+    return;
+  }
+  MsgSessionResumed msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** ERROR[" << m_name
+         << "]: Could not unpack MsgSessionResumed\n";
+    disconnect();
+    return;
+  }
+  m_resumed_tg = msg.tg();
+  m_resumed_monitor_tgs = msg.tgs();
+  m_resumed_node_info = msg.nodeInfoOk();
+  cout << m_name << ": Session resumed" << endl;
+  m_session_resumed = true;
+} /* ReflectorConnection::handleMsgSessionResumed */
+
+
+void ReflectorConnection::handleMsgServerInfo(std::istream& is)
+{
+  if (m_con_state != STATE_EXPECT_SERVER_INFO)
+  {
+    cerr << "*** ERROR[" << m_name << "]: Unexpected MsgServerInfo\n";
+    disconnect();
+    return;
+  }
+  MsgServerInfo msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** ERROR[" << m_name << "]: Could not unpack MsgServerInfo\n";
+    disconnect();
+    return;
+  }
+  m_client_id = msg.clientId();
+  m_codecs = msg.codecs();
+
+  cout << m_name << ": Connected nodes: ";
+  const vector<string>& nodes = msg.nodes();
+  if (!nodes.empty())
+  {
+    vector<string>::const_iterator it = nodes.begin();
+    cout << *it++;
+    for (; it != nodes.end(); ++it)
+    {
+      cout << ", " << *it;
+    }
+  }
+  cout << endl;
+
+  delete m_udp_sock;
+  m_udp_sock = new UdpSocket;
+  m_udp_sock->setDataHandler<ReflectorConnection,
+                             &ReflectorConnection::udpDatagramReceived>(this);
+
+  m_con_state = STATE_CONNECTED;
+  m_reconnect_backoff.reset();
+
+    // The owner select the codec before the rest of the state is sent
+  loggedIn(this);
+  if (!isLoggedIn())
+  {
+    return;
+  }
+
+  m_node_info_digest = MsgSessionResume::nodeInfoDigest(m_node_info_json);
+
+    // When a session has been resumed, only the state that the server did
+    // not restore need to be sent
+  if (!m_session_resumed || !m_resumed_node_info)
+  {
+    sendMsg(MsgNodeInfo(m_node_info_json));
+  }
+
+  const bool restored_tg = m_session_resumed &&
+                           (m_resumed_tg == m_selected_tg);
+  if (!restored_tg && ((m_selected_tg > 0) || m_session_resumed))
+  {
+    cout << m_name << ": Selecting TG #" << m_selected_tg << endl;
+    sendMsg(MsgSelectTG(m_selected_tg));
+  }
+
+  const bool restored_monitor_tgs = m_session_resumed &&
+                                    (m_resumed_monitor_tgs == m_monitor_tgs);
+  if (!restored_monitor_tgs && (!m_monitor_tgs.empty() || m_session_resumed))
+  {
+    sendMsg(MsgTgMonitor(m_monitor_tgs));
+  }
+  m_session_resumed = false;
+  m_resuming = false;
+  sendUdpMsg(MsgUdpHeartbeat());
+} /* ReflectorConnection::handleMsgServerInfo */
+
+
+void ReflectorConnection::handleMsgSessionToken(std::istream& is)
+{
+  MsgSessionToken msg;
+  if (!msg.unpack(is))
+  {
+    cerr << "*** ERROR[" << m_name << "]: Could not unpack MsgSessionToken\n";
+    disconnect();
+    return;
+  }
+  m_session_token = msg.token();
+} /* ReflectorConnection::handleMsgSessionToken */
+
+
+void ReflectorConnection::udpDatagramReceived(const IpAddress& addr,
+                                              uint16_t port,
+                                              Async::DataView data)
+{
+  if (!isLoggedIn())
+  {
+    return;
+  }
+
+  if (addr != m_con->remoteHost())
+  {
+    cout << "*** WARNING[" << m_name
+         << "]: UDP packet received from wrong source address "
+         << addr << ". Should be " << m_con->remoteHost() << "." << endl;
+    return;
+  }
+  if (port != m_con->remotePort())
+  {
+    cout << "*** WARNING[" << m_name
+         << "]: UDP packet received with wrong source port number "
+         << port << ". Should be " << m_con->remotePort() << "." << endl;
+    return;
+  }
+
+  Async::MsgUnpackBuffer ub(data.data(), data.size());
+
+  ReflectorUdpMsg header;
+  if (!header.unpack(ub))
+  {
+    cout << "*** WARNING[" << m_name
+         << "]: Unpacking failed for UDP message header" << endl;
+    return;
+  }
+
+  if (header.clientId() != m_client_id)
+  {
+    cout << "*** WARNING[" << m_name
+         << "]: UDP packet received with wrong client id "
+         << header.clientId() << ". Should be " << m_client_id << "." << endl;
+    return;
+  }
+
+    // Check sequence number
+  uint16_t udp_rx_seq_diff = header.sequenceNum() - m_next_udp_rx_seq;
+  if (udp_rx_seq_diff > 0x7fff) // Frame out of sequence (ignore)
+  {
+    cout << m_name
+         << ": Dropping out of sequence UDP frame with seq="
+         << header.sequenceNum() << endl;
+    return;
+  }
+  else if (udp_rx_seq_diff > 0) // Frame lost
+  {
+    if (m_udp_lost_cnt != 0)
+    {
+      m_udp_lost_cnt->inc(udp_rx_seq_diff);
+    }
+    cout << m_name << ": UDP frame(s) lost. Expected seq="
+         << m_next_udp_rx_seq
+         << " but received " << header.sequenceNum()
+         << ". Resetting next expected sequence number to "
+         << (header.sequenceNum() + 1) << endl;
+  }
+  m_udp_rx_lost_cnt = udp_rx_seq_diff;
+  m_next_udp_rx_seq = header.sequenceNum() + 1;
+  if (m_udp_rx_cnt != 0)
+  {
+    m_udp_rx_cnt->inc();
+  }
+
+  m_udp_heartbeat_rx_cnt = UDP_HEARTBEAT_RX_CNT_RESET;
+
+  switch (header.type())
+  {
+    case MsgUdpHeartbeat::TYPE:
+      return;
+    case MsgUdpAudio::TYPE:
+      gettimeofday(&m_last_audio, NULL);
+      if (!timerisset(&m_talker_start))
+      {
+        m_talker_start = m_last_audio;
+      }
+      break;
+    case MsgUdpFlushSamples::TYPE:
+      timerclear(&m_talker_start);
+      break;
+    default:
+      break;
+  }
+
+  udpMsgReceived(this, header.type(), header.sequenceNum(), ub);
+} /* ReflectorConnection::udpDatagramReceived */
+
+
+void ReflectorConnection::reconnect(void)
+{
+  if (m_reconnect_cnt != 0)
+  {
+    m_reconnect_cnt->inc();
+  }
+  disconnect();
+  connect();
+} /* ReflectorConnection::reconnect */
+
+
+bool ReflectorConnection::isConnected(void) const
+{
+  return (m_con != 0) && m_con->isConnected();
+} /* ReflectorConnection::isConnected */
+
+
+void ReflectorConnection::handleTimerTick(Async::Timer *t)
+{
+  if (--m_udp_heartbeat_tx_cnt == 0)
+  {
+    sendUdpMsg(MsgUdpHeartbeat());
+  }
+
+  if (--m_tcp_heartbeat_tx_cnt == 0)
+  {
+    sendMsg(MsgHeartbeat());
+  }
+
+  if (--m_udp_heartbeat_rx_cnt == 0)
+  {
+    cout << m_name << ": UDP Heartbeat timeout" << endl;
+    disconnect();
+    return;
+  }
+
+  if (--m_tcp_heartbeat_rx_cnt == 0)
+  {
+    cout << m_name << ": Heartbeat timeout" << endl;
+    disconnect();
+  }
+} /* ReflectorConnection::handleTimerTick */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,406 @@
+/**
+@file	 ReflectorConnection.h
+@brief   One connection from a ReflectorLogic to a SvxReflector server
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef REFLECTOR_CONNECTION_INCLUDED
+#define REFLECTOR_CONNECTION_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+#include <set>
+#include <iosfwd>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncTcpClient.h>
+#include <AsyncFramedTcpConnection.h>
+#include <AsyncTimer.h>
+#include <AsyncBackoff.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class UdpSocket;
+  class SslContext;
+  class MetricCounter;
+  class MsgUnpackBuffer;
+  class IpAddress;
+};
+
+class ReflectorMsg;
+class ReflectorUdpMsg;
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	One connection from a ReflectorLogic to a SvxReflector server
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+This class handle the protocol mechanics of one reflector connection. That is
+connecting and reconnecting, authentication and session resumption,
+heartbeats and the UDP sequence numbers. The talk group selection, monitored
+talk groups and node information are kept by the connection so that they can
+be sent again each time it log in.
+
+All audio handling is left to the owner. Messages that are not part of the
+connection handling are passed on through the msgReceived and
+udpMsgReceived signals. A ReflectorLogic can hold several connections to
+different reflectors and send the same encoded audio to all of them.
+*/
+class ReflectorConnection : public sigc::trackable
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   name  The name to use when printing messages
+     * @param   host  The host name or IP address of the reflector
+     * @param   port  The TCP and UDP port of the reflector
+     */
+    ReflectorConnection(const std::string& name, const std::string& host,
+                        uint16_t port);
+
+    /**
+     * @brief   Destructor
+     */
+    ~ReflectorConnection(void);
+
+    /**
+     * @brief   Set the credentials used to log in
+     * @param   callsign  The callsign (username) of this node
+     * @param   auth_key  The authentication key
+     */
+    void setCredentials(const std::string& callsign,
+                        const std::string& auth_key);
+
+    /**
+     * @brief   Set the TLS context to use
+     * @param   ctx The context or 0 to not use TLS
+     */
+    void setSslContext(Async::SslContext *ctx) { m_ssl_ctx = ctx; }
+
+    /**
+     * @brief   Set the reconnect delay limits
+     * @param   initial_ms  The first delay in milliseconds
+     * @param   max_ms      The maximum delay in milliseconds
+     */
+    void setReconnectDelays(unsigned initial_ms, unsigned max_ms);
+
+    /**
+     * @brief   Set the UDP heartbeat interval
+     * @param   interval  The interval in seconds
+     */
+    void setUdpHeartbeatInterval(unsigned interval);
+
+    /**
+     * @brief   Set the counters to update for received and lost UDP frames
+     * @param   rx_cnt        Counter for received frames
+     * @param   lost_cnt      Counter for lost frames
+     * @param   reconnect_cnt Counter for reconnects
+     */
+    void setMetrics(Async::MetricCounter *rx_cnt,
+                    Async::MetricCounter *lost_cnt,
+                    Async::MetricCounter *reconnect_cnt);
+
+    /**
+     * @brief   Set the node information to send after login
+     * @param   json  The node information JSON document
+     */
+    void setNodeInfo(const std::string& json) { m_node_info_json = json; }
+
+    /**
+     * @brief   Select a talk group
+     * @param   tg  The talk group to select, 0 for none
+     *
+     * The selection is sent directly if logged in and is resent after each
+     * login.
+     */
+    void selectTg(uint32_t tg);
+
+    /**
+     * @brief   Set the talk groups to monitor
+     * @param   tgs The talk groups to monitor
+     *
+     * The talk groups are sent directly if logged in and are resent after
+     * each login.
+     */
+    void setMonitorTgs(const std::set<uint32_t>& tgs);
+
+    /**
+     * @brief   Connect to the reflector
+     */
+    void connect(void);
+
+    /**
+     * @brief   Disconnect from the reflector
+     *
+     * A disconnect is also followed by a reconnect after a while.
+     */
+    void disconnect(void);
+
+    /**
+     * @brief   Check if the login to the reflector is complete
+     */
+    bool isLoggedIn(void) const { return m_con_state == STATE_CONNECTED; }
+
+    /**
+     * @brief   Get the host name of the reflector
+     */
+    const std::string& host(void) const { return m_host; }
+
+    /**
+     * @brief   Get the codecs offered by the reflector at login
+     */
+    const std::vector<std::string>& codecs(void) const { return m_codecs; }
+
+    /**
+     * @brief   Send a TCP message to the reflector
+     * @param   msg The message to send
+     */
+    void sendMsg(const ReflectorMsg& msg);
+
+    /**
+     * @brief   Send a UDP message to the reflector
+     * @param   msg The message to send
+     *
+     * The message is only sent if logged in.
+     */
+    void sendUdpMsg(const ReflectorUdpMsg& msg);
+
+    /**
+     * @brief   Get the number of frames lost before the last received frame
+     */
+    unsigned udpRxLostCnt(void) const { return m_udp_rx_lost_cnt; }
+
+    /**
+     * @brief   Check if talker audio is being received
+     *
+     * This is true from the first audio frame of a transmission until the
+     * reflector flush the samples or the connection is lost.
+     */
+    bool talkerActive(void) const { return timerisset(&m_talker_start); }
+
+    /**
+     * @brief   Get the time the current transmission started to arrive
+     */
+    const struct timeval& talkerStart(void) const { return m_talker_start; }
+
+    /**
+     * @brief   Get the time of the last received audio frame
+     */
+    const struct timeval& lastAudio(void) const { return m_last_audio; }
+
+    /**
+     * @brief   A signal that is emitted when the login is complete
+     * @param   con The connection
+     *
+     * The signal is emitted before the talk group selection and node
+     * information are sent.
+     */
+    sigc::signal<void, ReflectorConnection*> loggedIn;
+
+    /**
+     * @brief   A signal that is emitted when the connection is lost
+     * @param   con The connection
+     */
+    sigc::signal<void, ReflectorConnection*> disconnected;
+
+    /**
+     * @brief   A signal that is emitted when a TCP message is received
+     * @param   con   The connection
+     * @param   type  The message type
+     * @param   is    The stream to unpack the message from
+     *
+     * Only messages received after login that are not handled by the
+     * connection itself are passed on.
+     */
+    sigc::signal<void, ReflectorConnection*, unsigned, std::istream&>
+      msgReceived;
+
+    /**
+     * @brief   A signal that is emitted when a UDP message is received
+     * @param   con   The connection
+     * @param   type  The message type
+     * @param   seq   The sequence number of the message
+     * @param   ub    The buffer to unpack the message from
+     *
+     * Heartbeats are not passed on.
+     */
+    sigc::signal<void, ReflectorConnection*, unsigned, uint16_t,
+                 Async::MsgUnpackBuffer&> udpMsgReceived;
+
+  private:
+    typedef enum
+    {
+      STATE_DISCONNECTED, STATE_EXPECT_AUTH_CHALLENGE, STATE_EXPECT_AUTH_OK,
+      STATE_EXPECT_SERVER_INFO, STATE_CONNECTED
+    } ConState;
+
+    typedef Async::TcpClient<Async::FramedTcpConnection> FramedTcpClient;
+
+    static const unsigned DEFAULT_UDP_HEARTBEAT_TX_CNT_RESET  = 15;
+    static const unsigned UDP_HEARTBEAT_RX_CNT_RESET          = 60;
+    static const unsigned TCP_HEARTBEAT_TX_CNT_RESET          = 10;
+    static const unsigned TCP_HEARTBEAT_RX_CNT_RESET          = 15;
+
+    std::string               m_name;
+    std::string               m_host;
+    uint16_t                  m_port;
+    std::string               m_callsign;
+    std::string               m_auth_key;
+    FramedTcpClient*          m_con;
+    Async::SslContext*        m_ssl_ctx;
+    Async::UdpSocket*         m_udp_sock;
+    std::vector<char>         m_udp_tx_buf;
+    ConState                  m_con_state;
+    uint32_t                  m_client_id;
+    std::vector<std::string>  m_codecs;
+    Async::Timer              m_reconnect_timer;
+    Async::Backoff            m_reconnect_backoff;
+    Async::Timer              m_heartbeat_timer;
+    uint16_t                  m_next_udp_tx_seq;
+    uint16_t                  m_next_udp_rx_seq;
+    unsigned                  m_udp_rx_lost_cnt;
+    unsigned                  m_udp_heartbeat_tx_cnt_reset;
+    unsigned                  m_udp_heartbeat_tx_cnt;
+    unsigned                  m_udp_heartbeat_rx_cnt;
+    unsigned                  m_tcp_heartbeat_tx_cnt;
+    unsigned                  m_tcp_heartbeat_rx_cnt;
+    struct timeval            m_talker_start;
+    struct timeval            m_last_audio;
+    uint32_t                  m_selected_tg;
+    std::set<uint32_t>        m_monitor_tgs;
+    std::string               m_node_info_json;
+    std::vector<uint8_t>      m_node_info_digest;
+    std::string               m_session_token;
+    bool                      m_resuming;
+    bool                      m_session_resumed;
+    uint32_t                  m_resumed_tg;
+    std::set<uint32_t>        m_resumed_monitor_tgs;
+    bool                      m_resumed_node_info;
+    Async::MetricCounter*     m_udp_rx_cnt;
+    Async::MetricCounter*     m_udp_lost_cnt;
+    Async::MetricCounter*     m_reconnect_cnt;
+
+    ReflectorConnection(const ReflectorConnection&);
+    ReflectorConnection& operator=(const ReflectorConnection&);
+    void onConnected(void);
+    void onDisconnected(Async::TcpConnection *con,
+                        Async::TcpConnection::DisconnectReason reason);
+    void onFrameReceived(Async::FramedTcpConnection *con,
+                         Async::DataView data);
+    void handleMsgError(std::istream& is);
+    void handleMsgProtoVerDowngrade(std::istream& is);
+    void handleMsgAuthChallenge(std::istream& is);
+    void handleMsgAuthOk(void);
+    void handleMsgSessionResumed(std::istream& is);
+    void handleMsgServerInfo(std::istream& is);
+    void handleMsgSessionToken(std::istream& is);
+    void udpDatagramReceived(const Async::IpAddress& addr, uint16_t port,
+                             Async::DataView data);
+    void reconnect(void);
+    bool isConnected(void) const;
+    void handleTimerTick(Async::Timer *t);
+
+};  /* class ReflectorConnection */
+
+
+//} /* namespace */
+
+#endif /* REFLECTOR_CONNECTION_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
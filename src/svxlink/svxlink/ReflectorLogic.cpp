@@ -30,12 +30,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <time.h>
+
 #include <sstream>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <algorithm>
 #include <iterator>
+#include <limits>
+#include <json/json.h>
 
 
 /****************************************************************************
@@ -46,8 +50,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncTcpClient.h>
 #include <AsyncUdpSocket.h>
+#include <AsyncSslContext.h>
 #include <AsyncAudioPassthrough.h>
 #include <AsyncAudioValve.h>
+#include <AsyncAudioJitterBuffer.h>
+#include <AsyncAudioTraceTagger.h>
+#include <AsyncMetrics.h>
 #include <version/SVXLINK.h>
 
 
@@ -58,6 +66,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "ReflectorLogic.h"
+#include "ReflectorConnection.h"
 #include "../reflector/ReflectorMsg.h"
 #include "EventHandler.h"
 
@@ -95,6 +104,16 @@ using namespace Async;
  *
  ****************************************************************************/
 
+static unsigned msSince(const struct timeval& tv, const struct timeval& now)
+{
+  if (!timerisset(&tv))
+  {
+    return std::numeric_limits<unsigned>::max();
+  }
+  struct timeval diff;
+  timersub(&now, &tv, &diff);
+  return diff.tv_sec * 1000 + diff.tv_usec / 1000;
+} /* msSince */
 
 
 /****************************************************************************
@@ -120,16 +139,12 @@ using namespace Async;
  ****************************************************************************/
 
 ReflectorLogic::ReflectorLogic(Async::Config& cfg, const std::string& name)
-  : LogicBase(cfg, name), m_con(0), m_msg_type(0), m_udp_sock(0),
+  : LogicBase(cfg, name), m_ssl_ctx(0), m_active(0), m_failover_ms(0),
+    m_rx_seq_resync(true), m_rx_seq_offset(0), m_next_rx_seq(0),
     m_logic_con_in(0), m_logic_con_out(0),
-    m_reconnect_timer(20000, Timer::TYPE_ONESHOT, false),
-    m_next_udp_tx_seq(0), m_next_udp_rx_seq(0),
     m_heartbeat_timer(1000, Timer::TYPE_PERIODIC, false), m_dec(0),
     m_flush_timeout_timer(3000, Timer::TYPE_ONESHOT, false),
-    m_udp_heartbeat_tx_cnt_reset(DEFAULT_UDP_HEARTBEAT_TX_CNT_RESET),
-    m_udp_heartbeat_tx_cnt(0), m_udp_heartbeat_rx_cnt(0),
-    m_tcp_heartbeat_tx_cnt(0), m_tcp_heartbeat_rx_cnt(0),
-    m_con_state(STATE_DISCONNECTED), m_enc(0), m_default_tg(0),
+    m_enc(0), m_default_tg(0),
     m_tg_select_timeout(DEFAULT_TG_SELECT_TIMEOUT),
     m_tg_select_timer(1000, Async::Timer::TYPE_PERIODIC),
     m_tg_select_timeout_cnt(0), m_selected_tg(0), m_previous_tg(0),
@@ -139,10 +154,33 @@ ReflectorLogic::ReflectorLogic(Async::Config& cfg, const std::string& name)
     m_mute_first_tx_loc(true), m_mute_first_tx_rem(false),
     m_tmp_monitor_timer(1000, Async::Timer::TYPE_PERIODIC),
     m_tmp_monitor_timeout(DEFAULT_TMP_MONITOR_TIMEOUT), m_use_prio(true),
-    m_qsy_pending_timer(-1)
+    m_qsy_pending_timer(-1), m_jitter_buffer(0)
 {
-  m_reconnect_timer.expired.connect(
-      sigc::hide(mem_fun(*this, &ReflectorLogic::reconnect)));
+  const Metric::Labels labels{{"logic", name}};
+  m_udp_rx_cnt = Metrics::instance().counter(
+      "svxlink_reflector_udp_frames_received_total",
+      "Number of UDP frames received from the reflector", labels);
+  m_udp_lost_cnt = Metrics::instance().counter(
+      "svxlink_reflector_udp_frames_lost_total",
+      "Number of UDP frames from the reflector detected as lost", labels);
+  m_reconnect_cnt = Metrics::instance().counter(
+      "svxlink_reflector_reconnects_total",
+      "Number of reconnects to the reflector", labels);
+  m_connected_gauge = Metrics::instance().gauge(
+      "svxlink_reflector_connected",
+      "Set to 1 when logged in to the reflector", labels);
+  m_connected_gauge->set(0);
+  m_jitter_gauge = Metrics::instance().gauge(
+      "svxlink_reflector_jitter_seconds",
+      "Interarrival jitter of the audio frames from the reflector", labels);
+  m_jitter_delay_gauge = Metrics::instance().gauge(
+      "svxlink_reflector_jitter_buffer_delay_seconds",
+      "Current delay of the adaptive jitter buffer", labels);
+  m_decode_time = Metrics::instance().histogram(
+      "svxlink_reflector_decode_seconds",
+      "Time to decode a received audio frame and pass it on",
+      {0.0001, 0.0002, 0.0005, 0.001, 0.002, 0.005, 0.01}, labels);
+
   m_heartbeat_timer.expired.connect(
       mem_fun(*this, &ReflectorLogic::handleTimerTick));
   m_flush_timeout_timer.expired.connect(
@@ -162,46 +200,120 @@ ReflectorLogic::ReflectorLogic(Async::Config& cfg, const std::string& name)
 
 ReflectorLogic::~ReflectorLogic(void)
 {
+  for (Connections::iterator it=m_cons.begin(); it!=m_cons.end(); ++it)
+  {
+    delete *it;
+  }
+  m_cons.clear();
+  m_active = 0;
   delete m_event_handler;
   m_event_handler = 0;
-  delete m_udp_sock;
-  m_udp_sock = 0;
   delete m_logic_con_in;
   m_logic_con_in = 0;
-  delete m_enc;
+  for (CodecMap::iterator it=m_codecs.begin(); it!=m_codecs.end(); ++it)
+  {
+    delete it->second.enc;
+    delete it->second.dec;
+  }
+  m_codecs.clear();
   m_enc = 0;
-  delete m_dec;
   m_dec = 0;
-  delete m_con;
-  m_con = 0;
+  delete m_ssl_ctx;
+  m_ssl_ctx = 0;
 } /* ReflectorLogic::~ReflectorLogic */
 
 
 bool ReflectorLogic::initialize(void)
 {
-  if (!cfg().getValue(name(), "HOST", m_reflector_host))
+  std::string reflector_host;
+  if (!cfg().getValue(name(), "HOST", reflector_host))
   {
     cerr << "*** ERROR: " << name() << "/HOST missing in configuration" << endl;
     return false;
   }
 
-  m_reflector_port = 5300;
-  cfg().getValue(name(), "PORT", m_reflector_port);
+  uint16_t reflector_port = 5300;
+  cfg().getValue(name(), "PORT", reflector_port);
+
+    // The primary reflector is first followed by the standby reflectors
+  std::vector<std::pair<std::string, uint16_t> > reflectors;
+  reflectors.push_back(make_pair(reflector_host, reflector_port));
+  std::vector<std::string> standby_hosts;
+  cfg().getValue(name(), "STANDBY_HOSTS", standby_hosts);
+  for (std::vector<std::string>::const_iterator it=standby_hosts.begin();
+       it!=standby_hosts.end(); ++it)
+  {
+    std::string host(*it);
+    uint16_t port = reflector_port;
+    std::string::size_type colon = host.rfind(':');
+    if (colon != std::string::npos)
+    {
+      std::istringstream is(host.substr(colon + 1));
+      if (!(is >> port) || !is.eof() || (port == 0))
+      {
+        cerr << "*** ERROR: Illegal format for config variable "
+             << name() << "/STANDBY_HOSTS entry \"" << *it << "\"" << endl;
+        return false;
+      }
+      host.erase(colon);
+    }
+    reflectors.push_back(make_pair(host, port));
+  }
+
+  unsigned reconnect_delay = 1000;
+  cfg().getValue(name(), "RECONNECT_DELAY", reconnect_delay);
+  unsigned reconnect_max_delay = 20000;
+  cfg().getValue(name(), "RECONNECT_MAX_DELAY", reconnect_max_delay);
 
-  if (!cfg().getValue(name(), "CALLSIGN", m_callsign))
+  bool use_tls = false;
+  cfg().getValue(name(), "TLS", use_tls);
+  if (use_tls)
+  {
+    m_ssl_ctx = new SslContext(SslContext::ROLE_CLIENT);
+    if (!m_ssl_ctx->initOk())
+    {
+      return false;
+    }
+    std::string tls_ca_file;
+    if (cfg().getValue(name(), "TLS_CA_FILE", tls_ca_file) &&
+        !m_ssl_ctx->setCaCertificateFile(tls_ca_file))
+    {
+      return false;
+    }
+    if (!m_ssl_ctx->verifiesPeer())
+    {
+      cerr << "*** WARNING: " << name() << ": TLS is enabled but TLS_CA_FILE "
+              "is not set. The reflector certificate will not be verified."
+           << endl;
+    }
+    std::string tls_cert_file;
+    if (cfg().getValue(name(), "TLS_CERT_FILE", tls_cert_file))
+    {
+      std::string tls_key_file;
+      cfg().getValue(name(), "TLS_KEY_FILE", tls_key_file);
+      if (!m_ssl_ctx->setCertificateFiles(tls_cert_file, tls_key_file))
+      {
+        return false;
+      }
+    }
+  }
+
+  std::string callsign;
+  if (!cfg().getValue(name(), "CALLSIGN", callsign))
   {
     cerr << "*** ERROR: " << name() << "/CALLSIGN missing in configuration"
          << endl;
     return false;
   }
 
-  if (!cfg().getValue(name(), "AUTH_KEY", m_auth_key))
+  std::string auth_key;
+  if (!cfg().getValue(name(), "AUTH_KEY", auth_key))
   {
     cerr << "*** ERROR: " << name() << "/AUTH_KEY missing in configuration"
          << endl;
     return false;
   }
-  if (m_auth_key == "Change this key now!")
+  if (auth_key == "Change this key now!")
   {
     cerr << "*** ERROR: You must change " << name() << "/AUTH_KEY from the "
             "default value" << endl;
@@ -278,15 +390,44 @@ bool ReflectorLogic::initialize(void)
   if (!setAudioCodec("DUMMY")) { return false; }
   prev_src = m_dec;
 
+    // Tag the received audio when tracing the audio latency. The tagger
+    // follow the decoder sink when the codec is changed.
+  AudioTraceTagger *net_in_tagger = new AudioTraceTagger(name() + ":net_in");
+  prev_src->registerSink(net_in_tagger, true);
+  prev_src = net_in_tagger;
+
     // Create jitter buffer
-  AudioFifo *fifo = new Async::AudioFifo(2*INTERNAL_SAMPLE_RATE);
-  prev_src->registerSink(fifo, true);
-  prev_src = fifo;
   unsigned jitter_buffer_delay = 0;
   cfg().getValue(name(), "JITTER_BUFFER_DELAY", jitter_buffer_delay);
-  if (jitter_buffer_delay > 0)
+  m_failover_ms = (jitter_buffer_delay > 0) ? jitter_buffer_delay : 100;
+  cfg().getValue(name(), "FAILOVER_TIMEOUT", m_failover_ms);
+  bool jitter_buffer_adaptive = false;
+  cfg().getValue(name(), "JITTER_BUFFER_ADAPTIVE", jitter_buffer_adaptive);
+  if (jitter_buffer_adaptive)
+  {
+    unsigned jitter_buffer_max_delay = 500;
+    cfg().getValue(name(), "JITTER_BUFFER_MAX_DELAY", jitter_buffer_max_delay);
+    if (jitter_buffer_max_delay < jitter_buffer_delay)
+    {
+      std::cout << "*** ERROR[" << name()
+                << "]: JITTER_BUFFER_MAX_DELAY must not be smaller than "
+                   "JITTER_BUFFER_DELAY" << std::endl;
+      return false;
+    }
+    m_jitter_buffer = new Async::AudioJitterBuffer(jitter_buffer_delay,
+                                                   jitter_buffer_max_delay);
+    prev_src->registerSink(m_jitter_buffer, true);
+    prev_src = m_jitter_buffer;
+  }
+  else
   {
-    fifo->setPrebufSamples(jitter_buffer_delay * INTERNAL_SAMPLE_RATE / 1000);
+    AudioFifo *fifo = new Async::AudioFifo(2*INTERNAL_SAMPLE_RATE);
+    prev_src->registerSink(fifo, true);
+    prev_src = fifo;
+    if (jitter_buffer_delay > 0)
+    {
+      fifo->setPrebufSamples(jitter_buffer_delay * INTERNAL_SAMPLE_RATE / 1000);
+    }
   }
 
   m_logic_con_out = new Async::AudioStreamStateDetector;
@@ -347,6 +488,7 @@ bool ReflectorLogic::initialize(void)
 
   cfg().getValue(name(), "TMP_MONITOR_TIMEOUT", m_tmp_monitor_timeout);
 
+  Json::Value node_info;
   std::string node_info_file;
   if (cfg().getValue(name(), "NODE_INFO_FILE", node_info_file))
   {
@@ -355,7 +497,7 @@ bool ReflectorLogic::initialize(void)
     {
       try
       {
-        if (!(node_info_is >> m_node_info))
+        if (!(node_info_is >> node_info))
         {
           std::cerr << "*** ERROR: Failure while reading node information file "
                        "\"" << node_info_file << "\""
@@ -380,18 +522,58 @@ bool ReflectorLogic::initialize(void)
       return false;
     }
   }
-  m_node_info["sw"] = "SvxLink";
-  m_node_info["swVer"] = SVXLINK_VERSION;
+  node_info["sw"] = "SvxLink";
+  node_info["swVer"] = SVXLINK_VERSION;
+  std::ostringstream node_info_os;
+  Json::StreamWriterBuilder builder;
+  builder["commentStyle"] = "None";
+  builder["indentation"] = ""; //The JSON document is written on a single line
+  Json::StreamWriter* writer = builder.newStreamWriter();
+  writer->write(node_info, &node_info_os);
+  delete writer;
 
-  cfg().getValue(name(), "UDP_HEARTBEAT_INTERVAL",
-      m_udp_heartbeat_tx_cnt_reset);
+  unsigned udp_heartbeat_interval = 0;
+  cfg().getValue(name(), "UDP_HEARTBEAT_INTERVAL", udp_heartbeat_interval);
 
   if (!LogicBase::initialize())
   {
     return false;
   }
 
-  connect();
+  const std::set<uint32_t> monitor_tgs_set(m_monitor_tgs.begin(),
+                                           m_monitor_tgs.end());
+  for (size_t i=0; i<reflectors.size(); ++i)
+  {
+    const std::string con_name = (reflectors.size() > 1)
+        ? name() + "@" + reflectors[i].first
+        : name();
+    ReflectorConnection *con = new ReflectorConnection(
+        con_name, reflectors[i].first, reflectors[i].second);
+    con->setCredentials(callsign, auth_key);
+    con->setSslContext(m_ssl_ctx);
+    con->setReconnectDelays(reconnect_delay, reconnect_max_delay);
+    if (udp_heartbeat_interval > 0)
+    {
+      con->setUdpHeartbeatInterval(udp_heartbeat_interval);
+    }
+    con->setMetrics(m_udp_rx_cnt, m_udp_lost_cnt, m_reconnect_cnt);
+    con->setNodeInfo(node_info_os.str());
+    con->setMonitorTgs(monitor_tgs_set);
+    con->loggedIn.connect(
+        mem_fun(*this, &ReflectorLogic::onConLoggedIn));
+    con->disconnected.connect(
+        mem_fun(*this, &ReflectorLogic::onConDisconnected));
+    con->msgReceived.connect(
+        mem_fun(*this, &ReflectorLogic::onConMsgReceived));
+    con->udpMsgReceived.connect(
+        mem_fun(*this, &ReflectorLogic::onConUdpMsgReceived));
+    m_cons.push_back(con);
+  }
+  m_heartbeat_timer.setEnable(true);
+  for (Connections::iterator it=m_cons.begin(); it!=m_cons.end(); ++it)
+  {
+    (*it)->connect();
+  }
 
   return true;
 } /* ReflectorLogic::initialize */
@@ -501,8 +683,7 @@ void ReflectorLogic::remoteCmdReceived(LogicBase* src_logic,
           MonitorTgEntry mte(tg);
           mte.timeout = m_tmp_monitor_timeout;
           m_monitor_tgs.insert(mte);
-          sendMsg(MsgTgMonitor(std::set<uint32_t>(
-                  m_monitor_tgs.begin(), m_monitor_tgs.end())));
+          setMonitorTgs();
         }
         std::ostringstream os;
         os << "tmp_monitor_add " << tg;
@@ -671,341 +852,156 @@ void ReflectorLogic::remoteReceivedPublishStateEvent(
  *
  ****************************************************************************/
 
-void ReflectorLogic::onConnected(void)
-{
-  cout << name() << ": Connection established to " << m_con->remoteHost() << ":"
-       << m_con->remotePort() << endl;
-  sendMsg(MsgProtoVer());
-  m_udp_heartbeat_tx_cnt = m_udp_heartbeat_tx_cnt_reset;
-  m_udp_heartbeat_rx_cnt = UDP_HEARTBEAT_RX_CNT_RESET;
-  m_tcp_heartbeat_tx_cnt = TCP_HEARTBEAT_TX_CNT_RESET;
-  m_tcp_heartbeat_rx_cnt = TCP_HEARTBEAT_RX_CNT_RESET;
-  m_heartbeat_timer.setEnable(true);
-  m_next_udp_tx_seq = 0;
-  m_next_udp_rx_seq = 0;
-  timerclear(&m_last_talker_timestamp);
-  m_con_state = STATE_EXPECT_AUTH_CHALLENGE;
-  m_con->setMaxFrameSize(ReflectorMsg::MAX_PREAUTH_FRAME_SIZE);
-} /* ReflectorLogic::onConnected */
-
-
-void ReflectorLogic::onDisconnected(TcpConnection *con,
-                                    TcpConnection::DisconnectReason reason)
+void ReflectorLogic::onConLoggedIn(ReflectorConnection *con)
 {
-  cout << name() << ": Disconnected from " << m_con->remoteHost() << ":"
-       << m_con->remotePort() << ": "
-       << TcpConnection::disconnectReasonStr(reason) << endl;
-  m_reconnect_timer.setTimeout(1000 + std::rand() % 5000);
-  m_reconnect_timer.setEnable(true);
-  delete m_udp_sock;
-  m_udp_sock = 0;
-  m_next_udp_tx_seq = 0;
-  m_next_udp_rx_seq = 0;
-  m_heartbeat_timer.setEnable(false);
-  if (m_flush_timeout_timer.isEnabled())
+  m_connected_gauge->set(1);
+  if ((m_active == 0) ||
+      ((con == m_cons.front()) && !timerisset(&m_last_talker_timestamp)))
   {
-    m_flush_timeout_timer.setEnable(false);
-    m_enc->allEncodedSamplesFlushed();
-  }
-  if (timerisset(&m_last_talker_timestamp))
-  {
-    m_dec->flushEncodedSamples();
-    timerclear(&m_last_talker_timestamp);
+    if ((m_active != 0) && (m_active != con))
+    {
+      cout << name() << ": Switching back to primary reflector "
+           << con->host() << endl;
+    }
+    setActive(con);
   }
-  m_con_state = STATE_DISCONNECTED;
-} /* ReflectorLogic::onDisconnected */
-
 
-void ReflectorLogic::onFrameReceived(FramedTcpConnection *con,
-                                     std::vector<uint8_t>& data)
-{
-  char *buf = reinterpret_cast<char*>(&data.front());
-  int len = data.size();
-
-  stringstream ss;
-  ss.write(buf, len);
-
-  ReflectorMsg header;
-  if (!header.unpack(ss))
+    // The codec is selected using the active connection. The encoded audio
+    // is sent to all reflectors so the other ones must use the same codec.
+  if (con == m_active)
   {
-    cout << "*** ERROR[" << name()
-         << "]: Unpacking failed for TCP message header\n";
-    disconnect();
-    return;
+    string selected_codec;
+    for (vector<string>::const_iterator it = con->codecs().begin();
+         it != con->codecs().end();
+         ++it)
+    {
+      if (codecIsAvailable(*it))
+      {
+        selected_codec = *it;
+        setAudioCodec(selected_codec);
+        break;
+      }
+    }
+    cout << name() << ": ";
+    if (!selected_codec.empty())
+    {
+      cout << "Using audio codec \"" << selected_codec << "\"";
+    }
+    else
+    {
+      cout << "No supported codec :-(";
+    }
+    cout << endl;
   }
-
-  if ((header.type() > 100) && !isLoggedIn())
+  else if (find(con->codecs().begin(), con->codecs().end(), m_enc->name()) ==
+           con->codecs().end())
   {
-    cerr << "*** ERROR[" << name() << "]: Unexpected protocol message received"
+    cerr << "*** WARNING[" << name() << "]: Reflector " << con->host()
+         << " does not support audio codec \"" << m_enc->name() << "\""
          << endl;
-    disconnect();
-    return;
   }
 
-  m_tcp_heartbeat_rx_cnt = TCP_HEARTBEAT_RX_CNT_RESET;
-
-  switch (header.type())
+    // A reflector offering more than one codec is transcoding so it need to
+    // know which one we have selected
+  if ((con->codecs().size() > 1) && (string(m_enc->name()) != "DUMMY"))
   {
-    case MsgHeartbeat::TYPE:
-      break;
-    case MsgError::TYPE:
-      handleMsgError(ss);
-      break;
-    case MsgProtoVerDowngrade::TYPE:
-      handleMsgProtoVerDowngrade(ss);
-      break;
-    case MsgAuthChallenge::TYPE:
-      handleMsgAuthChallenge(ss);
-      break;
-    case MsgAuthOk::TYPE:
-      handleMsgAuthOk();
-      break;
-    case MsgServerInfo::TYPE:
-      handleMsgServerInfo(ss);
-      break;
-    case MsgNodeList::TYPE:
-      handleMsgNodeList(ss);
-      break;
-    case MsgNodeJoined::TYPE:
-      handleMsgNodeJoined(ss);
-      break;
-    case MsgNodeLeft::TYPE:
-      handleMsgNodeLeft(ss);
-      break;
-    case MsgTalkerStart::TYPE:
-      handleMsgTalkerStart(ss);
-      break;
-    case MsgTalkerStop::TYPE:
-      handleMsgTalkerStop(ss);
-      break;
-    case MsgRequestQsy::TYPE:
-      handleMsgRequestQsy(ss);
-      break;
-    default:
-      // Better just ignoring unknown messages for easier addition of protocol
-      // messages while being backwards compatible
-
-      //cerr << "*** WARNING[" << name()
-      //     << "]: Unknown protocol message received: msg_type="
-      //     << header.type() << endl;
-      break;
+    con->sendMsg(MsgSelectCodec(m_enc->name()));
   }
-} /* ReflectorLogic::onFrameReceived */
+} /* ReflectorLogic::onConLoggedIn */
 
 
-void ReflectorLogic::handleMsgError(std::istream& is)
+void ReflectorLogic::onConDisconnected(ReflectorConnection *con)
 {
-  MsgError msg;
-  if (!msg.unpack(is))
+  bool logged_in = false;
+  for (Connections::iterator it=m_cons.begin(); it!=m_cons.end(); ++it)
   {
-    cerr << "*** ERROR[" << name() << "]: Could not unpack MsgAuthError" << endl;
-    disconnect();
-    return;
+    logged_in = logged_in || (*it)->isLoggedIn();
   }
-  cout << name() << ": Error message received from server: " << msg.message()
-       << endl;
-  disconnect();
-} /* ReflectorLogic::handleMsgError */
-
+  m_connected_gauge->set(logged_in ? 1 : 0);
 
-void ReflectorLogic::handleMsgProtoVerDowngrade(std::istream& is)
-{
-  MsgProtoVerDowngrade msg;
-  if (!msg.unpack(is))
+  if (con != m_active)
   {
-    cerr << "*** ERROR[" << name() << "]: Could not unpack MsgProtoVerDowngrade" << endl;
-    disconnect();
     return;
   }
-  cout << name() << ": Server too old and we cannot downgrade to protocol version "
-       << msg.majorVer() << "." << msg.minorVer() << " from "
-       << MsgProtoVer::MAJOR << "." << MsgProtoVer::MINOR
-       << endl;
-  disconnect();
-} /* ReflectorLogic::handleMsgProtoVerDowngrade */
 
-
-void ReflectorLogic::handleMsgAuthChallenge(std::istream& is)
-{
-  if (m_con_state != STATE_EXPECT_AUTH_CHALLENGE)
+    // Prefer a standby connection that is receiving the same talker so that
+    // the audio continue without interruption
+  ReflectorConnection *next = 0;
+  for (Connections::iterator it=m_cons.begin(); it!=m_cons.end(); ++it)
   {
-    cerr << "*** ERROR[" << name() << "]: Unexpected MsgAuthChallenge\n";
-    disconnect();
-    return;
+    ReflectorConnection *c = *it;
+    if ((c != con) && c->isLoggedIn() &&
+        ((next == 0) || (c->talkerActive() && !next->talkerActive())))
+    {
+      next = c;
+    }
   }
-
-  MsgAuthChallenge msg;
-  if (!msg.unpack(is))
+  if (next != 0)
   {
-    cerr << "*** ERROR[" << name() << "]: Could not unpack MsgAuthChallenge\n";
-    disconnect();
-    return;
+    cout << name() << ": Failing over to reflector " << next->host() << endl;
   }
-  const uint8_t *challenge = msg.challenge();
-  if (challenge == 0)
+  setActive(next);
+
+  if (((next == 0) || !next->talkerActive()) &&
+      timerisset(&m_last_talker_timestamp))
   {
-    cerr << "*** ERROR[" << name() << "]: Illegal challenge received\n";
-    disconnect();
-    return;
+    m_dec->flushEncodedSamples();
+    timerclear(&m_last_talker_timestamp);
   }
-  sendMsg(MsgAuthResponse(m_callsign, m_auth_key, challenge));
-  m_con_state = STATE_EXPECT_AUTH_OK;
-} /* ReflectorLogic::handleMsgAuthChallenge */
-
-
-void ReflectorLogic::handleMsgAuthOk(void)
-{
-  if (m_con_state != STATE_EXPECT_AUTH_OK)
+  if ((next == 0) && m_flush_timeout_timer.isEnabled())
   {
-    cerr << "*** ERROR[" << name() << "]: Unexpected MsgAuthOk\n";
-    disconnect();
-    return;
+    m_flush_timeout_timer.setEnable(false);
+    m_enc->allEncodedSamplesFlushed();
   }
-  cout << name() << ": Authentication OK" << endl;
-  m_con_state = STATE_EXPECT_SERVER_INFO;
-  m_con->setMaxFrameSize(ReflectorMsg::MAX_POSTAUTH_FRAME_SIZE);
-} /* ReflectorLogic::handleMsgAuthOk */
+} /* ReflectorLogic::onConDisconnected */
 
 
-void ReflectorLogic::handleMsgServerInfo(std::istream& is)
+void ReflectorLogic::onConMsgReceived(ReflectorConnection *con, unsigned type,
+                                      std::istream& is)
 {
-  if (m_con_state != STATE_EXPECT_SERVER_INFO)
-  {
-    cerr << "*** ERROR[" << name() << "]: Unexpected MsgServerInfo\n";
-    disconnect();
-    return;
-  }
-  MsgServerInfo msg;
-  if (!msg.unpack(is))
+    // The standby reflectors send the same node and talker information so
+    // only the messages from the active one are handled
+  if (con != m_active)
   {
-    cerr << "*** ERROR[" << name() << "]: Could not unpack MsgServerInfo\n";
-    disconnect();
     return;
   }
-  m_client_id = msg.clientId();
-
-  //cout << "### MsgServerInfo: clientId=" << msg.clientId()
-  //     << " codecs=";
-  //std::copy(msg.codecs().begin(), msg.codecs().end(),
-  //     std::ostream_iterator<std::string>(cout, " "));
-  //cout << " nodes=";
-  //std::copy(msg.nodes().begin(), msg.nodes().end(),
-  //     std::ostream_iterator<std::string>(cout, " "));
-  //cout << endl;
 
-  cout << name() << ": Connected nodes: ";
-  const vector<string>& nodes = msg.nodes();
-  if (!nodes.empty())
+  switch (type)
   {
-    vector<string>::const_iterator it = nodes.begin();
-    cout << *it++;
-    for (; it != nodes.end(); ++it)
-    {
-      cout << ", " << *it;
-    }
-  }
-  cout << endl;
-
-  string selected_codec;
-  for (vector<string>::const_iterator it = msg.codecs().begin();
-       it != msg.codecs().end();
-       ++it)
-  {
-    if (codecIsAvailable(*it))
-    {
-      selected_codec = *it;
-      setAudioCodec(selected_codec);
+    case MsgNodeList::TYPE:
+      handleMsgNodeList(is);
+      break;
+    case MsgNodeJoined::TYPE:
+      handleMsgNodeJoined(is);
+      break;
+    case MsgNodeLeft::TYPE:
+      handleMsgNodeLeft(is);
+      break;
+    case MsgTalkerStart::TYPE:
+      handleMsgTalkerStart(is);
+      break;
+    case MsgTalkerStop::TYPE:
+      handleMsgTalkerStop(is);
+      break;
+    case MsgRequestQsy::TYPE:
+      handleMsgRequestQsy(is);
+      break;
+    default:
+      // Better ignoring unknown messages to make it easier to add messages to
+      // the protocol but still be backwards compatible
       break;
-    }
-  }
-  cout << name() << ": ";
-  if (!selected_codec.empty())
-  {
-    cout << "Using audio codec \"" << selected_codec << "\"";
-  }
-  else
-  {
-    cout << "No supported codec :-(";
   }
-  cout << endl;
-
-  delete m_udp_sock;
-  m_udp_sock = new UdpSocket;
-  m_udp_sock->dataReceived.connect(
-      mem_fun(*this, &ReflectorLogic::udpDatagramReceived));
-
-  m_con_state = STATE_CONNECTED;
-
-  std::ostringstream node_info_os;
-  Json::StreamWriterBuilder builder;
-  builder["commentStyle"] = "None";
-  builder["indentation"] = ""; //The JSON document is written on a single line
-  Json::StreamWriter* writer = builder.newStreamWriter();
-  writer->write(m_node_info, &node_info_os);
-  delete writer;
-  MsgNodeInfo node_info_msg(node_info_os.str());
-  sendMsg(node_info_msg);
+} /* ReflectorLogic::onConMsgReceived */
 
-#if 0
-    // Set up RX and TX sites node information
-  MsgNodeInfo::RxSite rx_site;
-  MsgNodeInfo::TxSite tx_site;
-  rx_site.setRxName("Rx1");
-  tx_site.setTxName("Tx1");
-  rx_site.setQthName(cfg().getValue("LocationInfo", "QTH_NAME"));
-  tx_site.setQthName(cfg().getValue("LocationInfo", "QTH_NAME"));
-  int32_t antenna_height = 0;
-  if (cfg().getValue("LocationInfo", "ANTENNA_HEIGHT", antenna_height))
-  {
-    rx_site.setAntennaHeight(antenna_height);
-    tx_site.setAntennaHeight(antenna_height);
-  }
-  float antenna_dir = -1.0f;
-  cfg().getValue("LocationInfo", "ANTENNA_DIR", antenna_dir);
-  rx_site.setAntennaDirection(antenna_dir);
-  tx_site.setAntennaDirection(antenna_dir);
-  double rf_frequency = 0;
-  cfg().getValue("LocationInfo", "FREQUENCY", rf_frequency);
-  if (rf_frequency < 0.0f)
-  {
-    rf_frequency = 0.0f;
-  }
-  rx_site.setRfFrequency(static_cast<uint64_t>(1000000.0f * rf_frequency));
-  tx_site.setRfFrequency(static_cast<uint64_t>(1000000.0f * rf_frequency));
-  vector<float> ctcss_frequencies;
-  //ctcss_frequencies.push_back(136.5);
-  //rx_site.setCtcssFrequencies(ctcss_frequencies);
-  //tx_site.setCtcssFrequencies(ctcss_frequencies);
-  float tx_power = 0.0f;
-  cfg().getValue("LocationInfo", "TX_POWER", tx_power);
-  tx_site.setTxPower(tx_power);
-  MsgNodeInfo::TxSites tx_sites;
-  tx_sites.push_back(tx_site);
-  MsgNodeInfo::RxSites rx_sites;
-  rx_sites.push_back(rx_site);
-
-    // Send node information to the server
-  MsgNodeInfo node_info; node_info
-    .setSwInfo("SvxLink v" SVXLINK_VERSION)
-    .setTxSites(tx_sites)
-    .setRxSites(rx_sites);
-  sendMsg(node_info);
-#endif
-
-  if (m_selected_tg > 0)
-  {
-    cout << name() << ": Selecting TG #" << m_selected_tg << endl;
-    sendMsg(MsgSelectTG(m_selected_tg));
-  }
 
-  if (!m_monitor_tgs.empty())
+void ReflectorLogic::setActive(ReflectorConnection *con)
+{
+  if (con != m_active)
   {
-    sendMsg(MsgTgMonitor(
-          std::set<uint32_t>(m_monitor_tgs.begin(), m_monitor_tgs.end())));
+    m_active = con;
+    m_rx_seq_resync = true;
   }
-  sendUdpMsg(MsgUdpHeartbeat());
-
-} /* ReflectorLogic::handleMsgServerInfo */
+} /* ReflectorLogic::setActive */
 
 
 void ReflectorLogic::handleMsgNodeList(std::istream& is)
@@ -1161,25 +1157,12 @@ void ReflectorLogic::handleMsgRequestQsy(std::istream& is)
 
 void ReflectorLogic::sendMsg(const ReflectorMsg& msg)
 {
-  if (!isConnected())
+  for (Connections::iterator it=m_cons.begin(); it!=m_cons.end(); ++it)
   {
-    return;
-  }
-
-  m_tcp_heartbeat_tx_cnt = TCP_HEARTBEAT_TX_CNT_RESET;
-
-  ostringstream ss;
-  ReflectorMsg header(msg.type());
-  if (!header.pack(ss) || !msg.pack(ss))
-  {
-    cerr << "*** ERROR[" << name()
-         << "]: Failed to pack reflector TCP message\n";
-    disconnect();
-    return;
-  }
-  if (m_con->write(ss.str().data(), ss.str().size()) == -1)
-  {
-    disconnect();
+    if ((*it)->isLoggedIn())
+    {
+      (*it)->sendMsg(msg);
+    }
   }
 } /* ReflectorLogic::sendMsg */
 
@@ -1211,87 +1194,90 @@ void ReflectorLogic::flushEncodedAudio(void)
 } /* ReflectorLogic::flushEncodedAudio */
 
 
-void ReflectorLogic::udpDatagramReceived(const IpAddress& addr, uint16_t port,
-                                         void *buf, int count)
+void ReflectorLogic::onConUdpMsgReceived(ReflectorConnection *con,
+                                         unsigned type, uint16_t seq,
+                                         Async::MsgUnpackBuffer& ub)
 {
-  if (!isLoggedIn())
-  {
-    return;
-  }
-
-  if (addr != m_con->remoteHost())
-  {
-    cout << "*** WARNING[" << name()
-         << "]: UDP packet received from wrong source address "
-         << addr << ". Should be " << m_con->remoteHost() << "." << endl;
-    return;
-  }
-  if (port != m_con->remotePort())
-  {
-    cout << "*** WARNING[" << name()
-         << "]: UDP packet received with wrong source port number "
-         << port << ". Should be " << m_con->remotePort() << "." << endl;
-    return;
-  }
-
-  stringstream ss;
-  ss.write(reinterpret_cast<const char *>(buf), count);
-
-  ReflectorUdpMsg header;
-  if (!header.unpack(ss))
-  {
-    cout << "*** WARNING[" << name()
-         << "]: Unpacking failed for UDP message header" << endl;
-    return;
-  }
-
-  if (header.clientId() != m_client_id)
+    // Any reflector may confirm that our transmission has been flushed
+  if (type == MsgUdpAllSamplesFlushed::TYPE)
   {
-    cout << "*** WARNING[" << name()
-         << "]: UDP packet received with wrong client id "
-         << header.clientId() << ". Should be " << m_client_id << "." << endl;
+    if (m_flush_timeout_timer.isEnabled())
+    {
+      m_flush_timeout_timer.setEnable(false);
+      m_enc->allEncodedSamplesFlushed();
+    }
     return;
   }
 
-    // Check sequence number
-  uint16_t udp_rx_seq_diff = header.sequenceNum() - m_next_udp_rx_seq;
-  if (udp_rx_seq_diff > 0x7fff) // Frame out of sequence (ignore)
-  {
-    cout << name()
-         << ": Dropping out of sequence UDP frame with seq="
-         << header.sequenceNum() << endl;
-    return;
-  }
-  else if (udp_rx_seq_diff > 0) // Frame lost
+  if (con != m_active)
   {
-    cout << name() << ": UDP frame(s) lost. Expected seq="
-         << m_next_udp_rx_seq
-         << " but received " << header.sequenceNum()
-         << ". Resetting next expected sequence number to "
-         << (header.sequenceNum() + 1) << endl;
+      // No audio is decoded from a standby reflector. It is only used if the
+      // active reflector stop sending audio while the standby reflector has
+      // been receiving the same talker for at least the failover time.
+    if (type == MsgUdpFlushSamples::TYPE)
+    {
+      con->sendUdpMsg(MsgUdpAllSamplesFlushed());
+      return;
+    }
+    if ((type != MsgUdpAudio::TYPE) || !con->talkerActive())
+    {
+      return;
+    }
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    if ((m_active != 0) &&
+        ((msSince(m_active->lastAudio(), now) < m_failover_ms) ||
+         (msSince(con->talkerStart(), now) < m_failover_ms)))
+    {
+      return;
+    }
+    cout << name() << ": No audio from reflector "
+         << (m_active != 0 ? m_active->host() : string("-"))
+         << ". Failing over to reflector " << con->host() << endl;
+    setActive(con);
   }
-  m_next_udp_rx_seq = header.sequenceNum() + 1;
-
-  m_udp_heartbeat_rx_cnt = UDP_HEARTBEAT_RX_CNT_RESET;
 
-  switch (header.type())
+  switch (type)
   {
-    case MsgUdpHeartbeat::TYPE:
-      break;
-
     case MsgUdpAudio::TYPE:
     {
       MsgUdpAudio msg;
-      if (!msg.unpack(ss))
+      if (!msg.unpack(ub))
       {
         cerr << "*** WARNING[" << name() << "]: Could not unpack MsgUdpAudio\n";
         return;
       }
       if (!msg.audioData().empty())
       {
+          // Let the decoder fill in frames that were lost in the middle of a
+          // talk spurt. Lost frames at the start of a talk spurt are probably
+          // heartbeats.
+        if ((con->udpRxLostCnt() > 0) && timerisset(&m_last_talker_timestamp))
+        {
+          m_dec->packetLost(&msg.audioData().front(), msg.audioData().size(),
+                            con->udpRxLostCnt());
+        }
         gettimeofday(&m_last_talker_timestamp, NULL);
+        if (m_jitter_buffer != 0)
+        {
+            // Each reflector number its frames independently. Keep the
+            // numbers given to the jitter buffer continuous after a failover.
+          if (m_rx_seq_resync)
+          {
+            m_rx_seq_offset = m_next_rx_seq - seq;
+            m_rx_seq_resync = false;
+          }
+          const uint16_t rx_seq = seq + m_rx_seq_offset;
+          m_jitter_buffer->markPacket(rx_seq);
+          m_next_rx_seq = rx_seq + 1;
+        }
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
         m_dec->writeEncodedSamples(
             &msg.audioData().front(), msg.audioData().size());
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        m_decode_time->observe((end.tv_sec - start.tv_sec) +
+                               (end.tv_nsec - start.tv_nsec) / 1.0e9);
       }
       break;
     }
@@ -1301,101 +1287,61 @@ void ReflectorLogic::udpDatagramReceived(const IpAddress& addr, uint16_t port,
       timerclear(&m_last_talker_timestamp);
       break;
 
-    case MsgUdpAllSamplesFlushed::TYPE:
-      m_enc->allEncodedSamplesFlushed();
-      break;
-
     default:
       // Better ignoring unknown protocol messages for easier addition of new
       // messages while still being backwards compatible
-
-      //cerr << "*** WARNING[" << name()
-      //     << "]: Unknown UDP protocol message received: msg_type="
-      //     << header.type() << endl;
       break;
   }
-} /* ReflectorLogic::udpDatagramReceived */
+} /* ReflectorLogic::onConUdpMsgReceived */
 
 
 void ReflectorLogic::sendUdpMsg(const ReflectorUdpMsg& msg)
 {
-  if (!isLoggedIn())
-  {
-    return;
-  }
-
-  m_udp_heartbeat_tx_cnt = m_udp_heartbeat_tx_cnt_reset;
-
-  if (m_udp_sock == 0)
+  for (Connections::iterator it=m_cons.begin(); it!=m_cons.end(); ++it)
   {
-    return;
+    (*it)->sendUdpMsg(msg);
   }
-
-  ReflectorUdpMsg header(msg.type(), m_client_id, m_next_udp_tx_seq++);
-  ostringstream ss;
-  if (!header.pack(ss) || !msg.pack(ss))
-  {
-    cerr << "*** ERROR[" << name()
-         << "]: Failed to pack reflector TCP message\n";
-    return;
-  }
-  m_udp_sock->write(m_con->remoteHost(), m_con->remotePort(),
-                    ss.str().data(), ss.str().size());
 } /* ReflectorLogic::sendUdpMsg */
 
 
-void ReflectorLogic::connect(void)
+void ReflectorLogic::disconnect(void)
 {
-  if (!isConnected())
+  if (m_active != 0)
   {
-    cout << name() << ": Connecting to " << m_reflector_host << ":"
-         << m_reflector_port << endl;
-    m_reconnect_timer.setEnable(false);
-    m_con = new TcpClient<FramedTcpConnection>(m_reflector_host,
-                                               m_reflector_port);
-    m_con->connected.connect(
-        mem_fun(*this, &ReflectorLogic::onConnected));
-    m_con->disconnected.connect(
-        mem_fun(*this, &ReflectorLogic::onDisconnected));
-    m_con->frameReceived.connect(
-        mem_fun(*this, &ReflectorLogic::onFrameReceived));
-    m_con->connect();
+    m_active->disconnect();
   }
-} /* ReflectorLogic::connect */
+} /* ReflectorLogic::disconnect */
 
 
-void ReflectorLogic::disconnect(void)
+bool ReflectorLogic::isLoggedIn(void) const
 {
-  if (m_con != 0)
+  for (Connections::const_iterator it=m_cons.begin(); it!=m_cons.end(); ++it)
   {
-    if (m_con->isConnected())
+    if ((*it)->isLoggedIn())
     {
-      m_con->disconnect();
-      onDisconnected(m_con, TcpConnection::DR_ORDERED_DISCONNECT);
+      return true;
     }
-    delete m_con;
-    m_con = 0;
-    m_con_state = STATE_DISCONNECTED;
   }
-} /* ReflectorLogic::disconnect */
+  return false;
+} /* ReflectorLogic::isLoggedIn */
 
 
-void ReflectorLogic::reconnect(void)
+void ReflectorLogic::setMonitorTgs(void)
 {
-  disconnect();
-  connect();
-} /* ReflectorLogic::reconnect */
-
-
-bool ReflectorLogic::isConnected(void) const
-{
-  return (m_con != 0) && m_con->isConnected();
-} /* ReflectorLogic::isConnected */
+  const std::set<uint32_t> tgs(m_monitor_tgs.begin(), m_monitor_tgs.end());
+  for (Connections::iterator it=m_cons.begin(); it!=m_cons.end(); ++it)
+  {
+    (*it)->setMonitorTgs(tgs);
+  }
+} /* ReflectorLogic::setMonitorTgs */
 
 
 void ReflectorLogic::allEncodedSamplesFlushed(void)
 {
-  sendUdpMsg(MsgUdpAllSamplesFlushed());
+  if (m_active != 0)
+  {
+    m_active->sendUdpMsg(MsgUdpAllSamplesFlushed());
+  }
 } /* ReflectorLogic::allEncodedSamplesFlushed */
 
 
@@ -1421,104 +1367,134 @@ void ReflectorLogic::handleTimerTick(Async::Timer *t)
     }
   }
 
-  if (--m_udp_heartbeat_tx_cnt == 0)
+  if (m_jitter_buffer != 0)
   {
-    sendUdpMsg(MsgUdpHeartbeat());
+    const Async::AudioJitterBuffer::Stats& stats = m_jitter_buffer->stats();
+    m_jitter_gauge->set(stats.jitter_ms / 1000.0);
+    m_jitter_delay_gauge->set(stats.delay_ms / 1000.0);
   }
 
-  if (--m_tcp_heartbeat_tx_cnt == 0)
+    // Go back to the primary reflector when it is up and nothing is received
+  ReflectorConnection *primary = m_cons.empty() ? 0 : m_cons.front();
+  if ((primary != 0) && (m_active != primary) && primary->isLoggedIn() &&
+      !timerisset(&m_last_talker_timestamp))
   {
-    sendMsg(MsgHeartbeat());
-  }
-
-  if (--m_udp_heartbeat_rx_cnt == 0)
-  {
-    cout << name() << ": UDP Heartbeat timeout" << endl;
-    disconnect();
-  }
-
-  if (--m_tcp_heartbeat_rx_cnt == 0)
-  {
-    cout << name() << ": Heartbeat timeout" << endl;
-    disconnect();
+    cout << name() << ": Switching back to primary reflector "
+         << primary->host() << endl;
+    setActive(primary);
   }
 } /* ReflectorLogic::handleTimerTick */
 
 
 bool ReflectorLogic::setAudioCodec(const std::string& codec_name)
 {
-  delete m_enc;
-  m_enc = Async::AudioEncoder::create(codec_name);
-  if (m_enc == 0)
+  bool success = true;
+  CodecMap::iterator it = m_codecs.find(codec_name);
+  if (it == m_codecs.end())
   {
-    cerr << "*** ERROR[" << name()
-         << "]: Failed to initialize " << codec_name
-         << " audio encoder" << endl;
-    m_enc = Async::AudioEncoder::create("DUMMY");
-    assert(m_enc != 0);
-    return false;
+    Codec codec;
+    if (createCodec(codec_name, codec))
+    {
+      it = m_codecs.insert(make_pair(codec_name, codec)).first;
+    }
+    else
+    {
+      success = false;
+      it = m_codecs.find("DUMMY");
+      if (it == m_codecs.end())
+      {
+        if (!createCodec("DUMMY", codec))
+        {
+          return false;
+        }
+        it = m_codecs.insert(make_pair(string("DUMMY"), codec)).first;
+      }
+    }
   }
-  m_enc->writeEncodedSamples.connect(
-      mem_fun(*this, &ReflectorLogic::sendEncodedAudio));
-  m_enc->flushEncodedSamples.connect(
-      mem_fun(*this, &ReflectorLogic::flushEncodedAudio));
-  m_enc_endpoint->registerSink(m_enc, false);
 
-  string opt_prefix(m_enc->name());
-  opt_prefix += "_ENC_";
-  list<string> names = cfg().listSection(name());
-  for (list<string>::const_iterator nit=names.begin(); nit!=names.end(); ++nit)
+    // Switching to an already set up codec is just a matter of moving the
+    // audio connections over to it
+  const Codec& codec = it->second;
+  if (codec.enc != m_enc)
   {
-    if ((*nit).find(opt_prefix) == 0)
+    if (m_enc != 0)
     {
-      string opt_value;
-      cfg().getValue(name(), *nit, opt_value);
-      string opt_name((*nit).substr(opt_prefix.size()));
-      m_enc->setOption(opt_name, opt_value);
+      m_enc->unregisterSource();
     }
+    m_enc = codec.enc;
+    m_enc_endpoint->registerSink(m_enc, false);
+    m_enc->printCodecParams();
   }
-  m_enc->printCodecParams();
+  if (codec.dec != m_dec)
+  {
+    AudioSink *sink = 0;
+    if (m_dec != 0)
+    {
+      sink = m_dec->sink();
+      m_dec->unregisterSink();
+    }
+    m_dec = codec.dec;
+    if (sink != 0)
+    {
+      m_dec->registerSink(sink, true);
+    }
+    m_dec->printCodecParams();
+  }
+
+  return success;
+} /* ReflectorLogic::setAudioCodec */
+
 
-  AudioSink *sink = 0;
-  if (m_dec != 0)
+bool ReflectorLogic::createCodec(const std::string& codec_name, Codec& codec)
+{
+  AudioEncoder *enc = Async::AudioEncoder::create(codec_name);
+  if (enc == 0)
   {
-    sink = m_dec->sink();
-    m_dec->unregisterSink();
-    delete m_dec;
+    cerr << "*** ERROR[" << name()
+         << "]: Failed to initialize " << codec_name
+         << " audio encoder" << endl;
+    return false;
   }
-  m_dec = Async::AudioDecoder::create(codec_name);
-  if (m_dec == 0)
+  AudioDecoder *dec = Async::AudioDecoder::create(codec_name);
+  if (dec == 0)
   {
     cerr << "*** ERROR[" << name()
          << "]: Failed to initialize " << codec_name
          << " audio decoder" << endl;
-    m_dec = Async::AudioDecoder::create("DUMMY");
-    assert(m_dec != 0);
+    delete enc;
     return false;
   }
-  m_dec->allEncodedSamplesFlushed.connect(
+
+  enc->setProfileName(name() + ":encoder");
+  enc->writeEncodedSamples.connect(
+      mem_fun(*this, &ReflectorLogic::sendEncodedAudio));
+  enc->flushEncodedSamples.connect(
+      mem_fun(*this, &ReflectorLogic::flushEncodedAudio));
+  dec->allEncodedSamplesFlushed.connect(
       mem_fun(*this, &ReflectorLogic::allEncodedSamplesFlushed));
-  if (sink != 0)
-  {
-    m_dec->registerSink(sink, true);
-  }
 
-  opt_prefix = string(m_dec->name()) + "_DEC_";
-  names = cfg().listSection(name());
+  string enc_prefix(string(enc->name()) + "_ENC_");
+  string dec_prefix(string(dec->name()) + "_DEC_");
+  list<string> names = cfg().listSection(name());
   for (list<string>::const_iterator nit=names.begin(); nit!=names.end(); ++nit)
   {
-    if ((*nit).find(opt_prefix) == 0)
+    string opt_value;
+    if ((*nit).find(enc_prefix) == 0)
     {
-      string opt_value;
       cfg().getValue(name(), *nit, opt_value);
-      string opt_name((*nit).substr(opt_prefix.size()));
-      m_dec->setOption(opt_name, opt_value);
+      enc->setOption((*nit).substr(enc_prefix.size()), opt_value);
+    }
+    else if ((*nit).find(dec_prefix) == 0)
+    {
+      cfg().getValue(name(), *nit, opt_value);
+      dec->setOption((*nit).substr(dec_prefix.size()), opt_value);
     }
   }
-  m_dec->printCodecParams();
 
+  codec.enc = enc;
+  codec.dec = dec;
   return true;
-} /* ReflectorLogic::setAudioCodec */
+} /* ReflectorLogic::createCodec */
 
 
 bool ReflectorLogic::codecIsAvailable(const std::string &codec_name)
@@ -1593,6 +1569,24 @@ void ReflectorLogic::onLogicConOutStreamStateChanged(bool is_active,
     m_report_tg_timer.setEnable(true);
   }
 
+  if (is_idle && (m_jitter_buffer != 0) &&
+      (m_jitter_buffer->stats().packets > 0))
+  {
+    const Async::AudioJitterBuffer::Stats& stats = m_jitter_buffer->stats();
+    std::cout << name() << ": Jitter buffer statistics:"
+              << " packets=" << stats.packets
+              << " lost=" << stats.lost
+              << " underruns=" << stats.underruns
+              << " jitter=" << std::fixed << std::setprecision(1)
+              << stats.jitter_ms << "ms"
+              << " target_delay=" << stats.target_delay_ms << "ms"
+              << " accelerated=" << stats.accelerated
+              << " expanded=" << stats.expanded
+              << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    m_jitter_buffer->resetStats();
+  }
+
   checkIdle();
 } /* ReflectorLogic::onLogicConOutStreamStateChanged */
 
@@ -1628,7 +1622,10 @@ void ReflectorLogic::selectTg(uint32_t tg, const std::string& event, bool unmute
 
   if (tg != m_selected_tg)
   {
-    sendMsg(MsgSelectTG(tg));
+    for (Connections::iterator it=m_cons.begin(); it!=m_cons.end(); ++it)
+    {
+      (*it)->selectTg(tg);
+    }
     if (m_selected_tg != 0)
     {
       m_previous_tg = m_selected_tg;
@@ -1706,8 +1703,7 @@ void ReflectorLogic::checkTmpMonitorTimeout(void)
   }
   if (changed)
   {
-    sendMsg(MsgTgMonitor(std::set<uint32_t>(
-            m_monitor_tgs.begin(), m_monitor_tgs.end())));
+    setMonitorTgs();
   }
 } /* ReflectorLogic::checkTmpMonitorTimeout */
 
@@ -1740,21 +1736,25 @@ void ReflectorLogic::checkIdle(void)
 void ReflectorLogic::handlePlayFile(const std::string& path)
 {
   setIdle(false);
-  LinkManager::instance()->playFile(this, path);
+  linkManagerRequest(
+      sigc::bind(sigc::ptr_fun(&ReflectorLogic::linkPlayFile), path));
 } /* ReflectorLogic::handlePlayFile */
 
 
 void ReflectorLogic::handlePlaySilence(int duration)
 {
   setIdle(false);
-  LinkManager::instance()->playSilence(this, duration);
+  linkManagerRequest(
+      sigc::bind(sigc::ptr_fun(&ReflectorLogic::linkPlaySilence), duration));
 } /* ReflectorLogic::handlePlaySilence */
 
 
 void ReflectorLogic::handlePlayTone(int fq, int amp, int duration)
 {
   setIdle(false);
-  LinkManager::instance()->playTone(this, fq, amp, duration);
+  linkManagerRequest(
+      sigc::bind(sigc::ptr_fun(&ReflectorLogic::linkPlayTone),
+                 fq, amp, duration));
 } /* ReflectorLogic::handlePlayTone */
 
 
@@ -1762,10 +1762,38 @@ void ReflectorLogic::handlePlayDtmf(const std::string& digit, int amp,
                                     int duration)
 {
   setIdle(false);
-  LinkManager::instance()->playDtmf(this, digit, amp, duration);
+  linkManagerRequest(
+      sigc::bind(sigc::ptr_fun(&ReflectorLogic::linkPlayDtmf),
+                 digit, amp, duration));
 } /* ReflectorLogic::handlePlayDtmf */
 
 
+void ReflectorLogic::linkPlayFile(LogicBase *logic, std::string path)
+{
+  LinkManager::instance()->playFile(logic, path);
+} /* ReflectorLogic::linkPlayFile */
+
+
+void ReflectorLogic::linkPlaySilence(LogicBase *logic, int duration)
+{
+  LinkManager::instance()->playSilence(logic, duration);
+} /* ReflectorLogic::linkPlaySilence */
+
+
+void ReflectorLogic::linkPlayTone(LogicBase *logic, int fq, int amp,
+                                  int duration)
+{
+  LinkManager::instance()->playTone(logic, fq, amp, duration);
+} /* ReflectorLogic::linkPlayTone */
+
+
+void ReflectorLogic::linkPlayDtmf(LogicBase *logic, std::string digit,
+                                  int amp, int duration)
+{
+  LinkManager::instance()->playDtmf(logic, digit, amp, duration);
+} /* ReflectorLogic::linkPlayDtmf */
+
+
 /*
  * This file has not been truncated
  */
@@ -36,7 +36,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <sys/time.h>
 #include <string>
-#include <json/json.h>
+#include <vector>
+#include <map>
+#include <set>
 
 
 /****************************************************************************
@@ -47,8 +49,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncAudioDecoder.h>
 #include <AsyncAudioEncoder.h>
-#include <AsyncTcpClient.h>
-#include <AsyncFramedTcpConnection.h>
 #include <AsyncTimer.h>
 #include <AsyncAudioFifo.h>
 #include <AsyncAudioStreamStateDetector.h>
@@ -71,12 +71,18 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 namespace Async
 {
-  class UdpSocket;
+  class SslContext;
+  class MsgUnpackBuffer;
   class AudioValve;
+  class AudioJitterBuffer;
+  class MetricCounter;
+  class MetricGauge;
+  class MetricHistogram;
 };
 
 class ReflectorMsg;
 class ReflectorUdpMsg;
+class ReflectorConnection;
 class EventHandler;
 
 
@@ -195,45 +201,35 @@ class ReflectorLogic : public LogicBase
       operator uint32_t(void) const { return tg; }
     };
 
-    typedef enum
-    {
-      STATE_DISCONNECTED, STATE_EXPECT_AUTH_CHALLENGE, STATE_EXPECT_AUTH_OK,
-      STATE_EXPECT_SERVER_INFO, STATE_CONNECTED
-    } ConState;
-
-    typedef Async::TcpClient<Async::FramedTcpConnection> FramedTcpClient;
     typedef std::set<MonitorTgEntry> MonitorTgsSet;
+    typedef std::vector<ReflectorConnection*> Connections;
+
+      // An encoder/decoder pair. Pairs are kept after they have been created
+      // so that switching back to a codec does not have to set it up again.
+    struct Codec
+    {
+      Async::AudioEncoder* enc;
+      Async::AudioDecoder* dec;
+      Codec(void) : enc(0), dec(0) {}
+    };
+    typedef std::map<std::string, Codec> CodecMap;
 
-    static const unsigned DEFAULT_UDP_HEARTBEAT_TX_CNT_RESET  = 15;
-    static const unsigned UDP_HEARTBEAT_RX_CNT_RESET          = 60;
-    static const unsigned TCP_HEARTBEAT_TX_CNT_RESET          = 10;
-    static const unsigned TCP_HEARTBEAT_RX_CNT_RESET          = 15;
     static const unsigned DEFAULT_TG_SELECT_TIMEOUT           = 30;
     static const int      DEFAULT_TMP_MONITOR_TIMEOUT         = 3600;
 
-    std::string                       m_reflector_host;
-    uint16_t                          m_reflector_port;
-    FramedTcpClient*                  m_con;
-    unsigned                          m_msg_type;
-    Async::UdpSocket*                 m_udp_sock;
-    uint32_t                          m_client_id;
-    std::string                       m_auth_key;
-    std::string                       m_callsign;
+    Async::SslContext*                m_ssl_ctx;
+    Connections                       m_cons;
+    ReflectorConnection*              m_active;
+    unsigned                          m_failover_ms;
+    bool                              m_rx_seq_resync;
+    uint16_t                          m_rx_seq_offset;
+    uint16_t                          m_next_rx_seq;
     Async::AudioStreamStateDetector*  m_logic_con_in;
     Async::AudioStreamStateDetector*  m_logic_con_out;
-    Async::Timer                      m_reconnect_timer;
-    uint16_t                          m_next_udp_tx_seq;
-    uint16_t                          m_next_udp_rx_seq;
     Async::Timer                      m_heartbeat_timer;
     Async::AudioDecoder*              m_dec;
     Async::Timer                      m_flush_timeout_timer;
-    unsigned                          m_udp_heartbeat_tx_cnt_reset;
-    unsigned                          m_udp_heartbeat_tx_cnt;
-    unsigned                          m_udp_heartbeat_rx_cnt;
-    unsigned                          m_tcp_heartbeat_tx_cnt;
-    unsigned                          m_tcp_heartbeat_rx_cnt;
     struct timeval                    m_last_talker_timestamp;
-    ConState                          m_con_state;
     Async::AudioEncoder*              m_enc;
     uint32_t                          m_default_tg;
     unsigned                          m_tg_select_timeout;
@@ -247,7 +243,6 @@ class ReflectorLogic : public LogicBase
     bool                              m_tg_local_activity;
     uint32_t                          m_last_qsy;
     MonitorTgsSet                     m_monitor_tgs;
-    Json::Value                       m_node_info;
     Async::AudioSource*               m_enc_endpoint;
     Async::AudioValve*                m_logic_con_in_valve;
     bool                              m_mute_first_tx_loc;
@@ -256,40 +251,43 @@ class ReflectorLogic : public LogicBase
     int                               m_tmp_monitor_timeout;
     bool                              m_use_prio;
     Async::Timer                      m_qsy_pending_timer;
+    Async::AudioJitterBuffer*         m_jitter_buffer;
+    CodecMap                          m_codecs;
+    Async::MetricCounter*             m_udp_rx_cnt;
+    Async::MetricCounter*             m_udp_lost_cnt;
+    Async::MetricCounter*             m_reconnect_cnt;
+    Async::MetricGauge*               m_connected_gauge;
+    Async::MetricGauge*               m_jitter_gauge;
+    Async::MetricGauge*               m_jitter_delay_gauge;
+    Async::MetricHistogram*           m_decode_time;
 
     ReflectorLogic(const ReflectorLogic&);
     ReflectorLogic& operator=(const ReflectorLogic&);
-    void onConnected(void);
-    void onDisconnected(Async::TcpConnection *con,
-                        Async::TcpConnection::DisconnectReason reason);
-    void onFrameReceived(Async::FramedTcpConnection *con,
-                         std::vector<uint8_t>& data);
-    void handleMsgError(std::istream& is);
-    void handleMsgProtoVerDowngrade(std::istream& is);
-    void handleMsgAuthChallenge(std::istream& is);
+    void onConLoggedIn(ReflectorConnection *con);
+    void onConDisconnected(ReflectorConnection *con);
+    void onConMsgReceived(ReflectorConnection *con, unsigned type,
+                          std::istream& is);
+    void onConUdpMsgReceived(ReflectorConnection *con, unsigned type,
+                             uint16_t seq, Async::MsgUnpackBuffer& ub);
+    void setActive(ReflectorConnection *con);
     void handleMsgNodeList(std::istream& is);
     void handleMsgNodeJoined(std::istream& is);
     void handleMsgNodeLeft(std::istream& is);
     void handleMsgTalkerStart(std::istream& is);
     void handleMsgTalkerStop(std::istream& is);
     void handleMsgRequestQsy(std::istream& is);
-    void handleMsgAuthOk(void);
-    void handleMsgServerInfo(std::istream& is);
     void sendMsg(const ReflectorMsg& msg);
     void sendEncodedAudio(const void *buf, int count);
     void flushEncodedAudio(void);
-    void udpDatagramReceived(const Async::IpAddress& addr, uint16_t port,
-                             void *buf, int count);
     void sendUdpMsg(const ReflectorUdpMsg& msg);
-    void connect(void);
     void disconnect(void);
-    void reconnect(void);
-    bool isConnected(void) const;
-    bool isLoggedIn(void) const { return m_con_state == STATE_CONNECTED; }
+    bool isLoggedIn(void) const;
+    void setMonitorTgs(void);
     void allEncodedSamplesFlushed(void);
     void flushTimeout(Async::Timer *t=0);
     void handleTimerTick(Async::Timer *t);
     bool setAudioCodec(const std::string& codec_name);
+    bool createCodec(const std::string& codec_name, Codec& codec);
     bool codecIsAvailable(const std::string &codec_name);
     void tgSelectTimerExpired(void);
     void onLogicConInStreamStateChanged(bool is_active, bool is_idle);
@@ -305,6 +303,11 @@ class ReflectorLogic : public LogicBase
     void handlePlaySilence(int duration);
     void handlePlayTone(int fq, int amp, int duration);
     void handlePlayDtmf(const std::string& digit, int amp, int duration);
+    static void linkPlayFile(LogicBase *logic, std::string path);
+    static void linkPlaySilence(LogicBase *logic, int duration);
+    static void linkPlayTone(LogicBase *logic, int fq, int amp, int duration);
+    static void linkPlayDtmf(LogicBase *logic, std::string digit, int amp,
+                             int duration);
 
 };  /* class ReflectorLogic */
 
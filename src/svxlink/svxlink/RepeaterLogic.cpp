@@ -32,8 +32,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
-#include <sys/time.h>
-
 #include <cstdio>
 #include <string>
 #include <iostream>
@@ -49,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncApplication.h>
 #include <AsyncTimer.h>
 #include <AsyncConfig.h>
 
@@ -128,10 +127,10 @@ using namespace Async;
 RepeaterLogic::RepeaterLogic(Async::Config& cfg, const std::string& name)
   : Logic(cfg, name), repeater_is_up(false),
     up_timer(30000, Timer::TYPE_ONESHOT, false),
-    idle_sound_timer(-1, Timer::TYPE_PERIODIC),
+    idle_sound_timer(-1, Timer::TYPE_PERIODIC), rpt_close_timestamp(0),
     open_on_sql_after_rpt_close(0), open_on_dtmf('?'),
     activate_on_sql_close(false), no_repeat(false), open_on_sql_timer(-1),
-    open_sql_flank(SQL_FLANK_CLOSE),
+    open_sql_flank(SQL_FLANK_CLOSE), sql_up_timestamp(0),
     short_sql_open_cnt(0), sql_flap_sup_min_time(1000),
     sql_flap_sup_max_cnt(0), rgr_enable(true), open_reason("?"),
     ident_nag_min_time(2000), ident_nag_timer(-1)
@@ -142,8 +141,6 @@ RepeaterLogic::RepeaterLogic(Async::Config& cfg, const std::string& name)
   idle_sound_timer.expired.connect(
       mem_fun(*this, &RepeaterLogic::playIdleSound));
   ident_nag_timer.expired.connect(mem_fun(*this, &RepeaterLogic::identNag));
-  timerclear(&rpt_close_timestamp);
-  timerclear(&sql_up_timestamp);
 } /* RepeaterLogic::RepeaterLogic */
 
 
@@ -539,11 +536,11 @@ void RepeaterLogic::setUp(bool up, string reason)
   {
     if (reason != "SQL_FLAP_SUP")
     {
-      gettimeofday(&rpt_close_timestamp, NULL);
+      rpt_close_timestamp = Application::app().monotonicTimeNs();
     }
     else
     {
-      timerclear(&rpt_close_timestamp);
+      rpt_close_timestamp = 0;
     }
     open_reason = "?";
     rxValveSetOpen(false);
@@ -572,7 +569,7 @@ void RepeaterLogic::squelchOpen(bool is_open)
   
   if (is_open)
   {
-    gettimeofday(&sql_up_timestamp, NULL);
+    sql_up_timestamp = Application::app().monotonicTimeNs();
   }
 
   if (repeater_is_up)
@@ -583,10 +580,8 @@ void RepeaterLogic::squelchOpen(bool is_open)
     }
     else
     {
-      struct timeval now, diff_tv;
-      gettimeofday(&now, NULL);
-      timersub(&now, &sql_up_timestamp, &diff_tv);
-      int diff_ms = diff_tv.tv_sec * 1000 + diff_tv.tv_usec / 1000;
+      int diff_ms = (Application::app().monotonicTimeNs() - sql_up_timestamp)
+                    / 1000000;
 	
       if (sql_flap_sup_max_cnt > 0)
       {
@@ -626,9 +621,9 @@ void RepeaterLogic::squelchOpen(bool is_open)
       
       if (open_on_sql_after_rpt_close > 0)
       {
-	struct timeval diff_tv;
-	timersub(&sql_up_timestamp, &rpt_close_timestamp, &diff_tv);
-	if (diff_tv.tv_sec < open_on_sql_after_rpt_close)
+	if ((rpt_close_timestamp != 0) &&
+	    ((sql_up_timestamp - rpt_close_timestamp) / 1000000000 <
+	     uint64_t(open_on_sql_after_rpt_close)))
 	{
 	  open_reason = "SQL_RPT_REOPEN";
 	  activateOnOpenOrClose(SQL_FLANK_OPEN);
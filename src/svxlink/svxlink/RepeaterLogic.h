@@ -35,6 +35,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <stdint.h>
+
 #include <string>
 
 
@@ -187,7 +189,7 @@ class RepeaterLogic : public Logic
     bool      	    repeater_is_up;
     Async::Timer    up_timer;
     Async::Timer    idle_sound_timer;
-    struct timeval  rpt_close_timestamp;
+    uint64_t        rpt_close_timestamp;
     int		    open_on_sql_after_rpt_close;
     char      	    open_on_dtmf;
     std::string     open_on_sel5;
@@ -196,7 +198,7 @@ class RepeaterLogic : public Logic
     bool            no_repeat;
     Async::Timer    open_on_sql_timer;
     SqlFlank  	    open_sql_flank;
-    struct timeval  sql_up_timestamp;
+    uint64_t        sql_up_timestamp;
     int       	    short_sql_open_cnt;
     int       	    sql_flap_sup_min_time;
     int       	    sql_flap_sup_max_cnt;
@@ -316,6 +316,19 @@ proc dtmf_digit_received {digit duration} {
 }
 
 
+#
+# Executed when one or more DTMF digits have been received at once
+#   digits    - The detected DTMF digits
+#   duration  - The duration, in milliseconds, of each digit
+#
+# Return the digits that SvxLink should continue processing. Return an empty
+# string to hide all of them.
+#
+proc dtmf_digits_received {digits duration} {
+  return [Logic::dtmf_digits_received $digits $duration [namespace current]];
+}
+
+
 #
 # Executed when a DTMF command has been received
 #   cmd - The command
@@ -0,0 +1,474 @@
+/**
+@file	 ThreadedLogic.cpp
+@brief   Run a logic core in a worker thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncApplication.h>
+#include <AsyncCppApplication.h>
+#include <AsyncCppEventLoopThread.h>
+#include <AsyncAudioThreadFifo.h>
+#include <AsyncConfig.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ThreadedLogic.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+ThreadedLogic::ThreadedLogic(Async::Config& cfg, const std::string& name,
+                             Async::CppEventLoopThread *thread,
+                             const Factory& factory)
+  : LogicBase(cfg, name),
+    m_main_app(dynamic_cast<CppApplication*>(&Application::app())),
+    m_thread(thread), m_factory(factory), m_thread_cfg(0), m_logic(0),
+    m_audio_in(0), m_audio_out(0),
+    m_mailbox(m_main_app,
+              sigc::mem_fun(*this, &ThreadedLogic::runMainThreadTask)),
+    m_link_registered(false)
+{
+} /* ThreadedLogic::ThreadedLogic */
+
+
+ThreadedLogic::~ThreadedLogic(void)
+{
+  if (m_link_registered && LinkManager::hasInstance())
+  {
+    LinkManager::instance()->deleteLogic(this);
+  }
+
+  if (m_thread->isRunning())
+  {
+    m_thread->postAndWait(sigc::bind(
+          sigc::ptr_fun(&ThreadedLogic::cleanupThread), this));
+  }
+
+  delete m_audio_out;
+  m_audio_out = 0;
+} /* ThreadedLogic::~ThreadedLogic */
+
+
+bool ThreadedLogic::initialize(void)
+{
+  if (m_main_app == 0)
+  {
+    cerr << "*** ERROR: Logic " << name() << " need to run in a thread "
+         << "but threads are not supported by this application\n";
+    return false;
+  }
+
+    // The audio from the logic core is read in the main thread
+  m_audio_out = new AudioThreadFifo(FIFO_SECONDS * INTERNAL_SAMPLE_RATE);
+
+  bool success = false;
+  m_thread->postAndWait(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::setupThread), this, &success));
+  if (!success)
+  {
+    return false;
+  }
+
+  cfg().valueUpdated.connect(sigc::mem_fun(*this, &ThreadedLogic::cfgUpdated));
+
+  if (!LogicBase::initialize())
+  {
+    return false;
+  }
+  m_link_registered = true;
+
+  return true;
+} /* ThreadedLogic::initialize */
+
+
+Async::AudioSink *ThreadedLogic::logicConIn(void)
+{
+  return m_audio_in;
+} /* ThreadedLogic::logicConIn */
+
+
+Async::AudioSource *ThreadedLogic::logicConOut(void)
+{
+  return m_audio_out;
+} /* ThreadedLogic::logicConOut */
+
+
+void ThreadedLogic::remoteCmdReceived(LogicBase* src_logic,
+                                      const std::string& cmd)
+{
+  postToLogicThread(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::deliverRemoteCmd), src_logic, cmd));
+} /* ThreadedLogic::remoteCmdReceived */
+
+
+void ThreadedLogic::playFile(const std::string& path)
+{
+  postToLogicThread(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::deliverPlayFile), path));
+} /* ThreadedLogic::playFile */
+
+
+void ThreadedLogic::playSilence(int length)
+{
+  postToLogicThread(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::deliverPlaySilence), length));
+} /* ThreadedLogic::playSilence */
+
+
+void ThreadedLogic::playTone(int fq, int amp, int len)
+{
+  postToLogicThread(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::deliverPlayTone), fq, amp, len));
+} /* ThreadedLogic::playTone */
+
+
+void ThreadedLogic::playDtmf(const std::string& digits, int amp, int len)
+{
+  postToLogicThread(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::deliverPlayDtmf), digits, amp, len));
+} /* ThreadedLogic::playDtmf */
+
+
+void ThreadedLogic::remoteReceivedTgUpdated(LogicBase *logic, uint32_t tg)
+{
+  postToLogicThread(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::deliverRemoteTg), logic, tg));
+} /* ThreadedLogic::remoteReceivedTgUpdated */
+
+
+void ThreadedLogic::remoteReceivedPublishStateEvent(
+    LogicBase *logic, const std::string& event_name, const std::string& msg)
+{
+  postToLogicThread(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::deliverRemoteStateEvent),
+        logic, event_name, msg));
+} /* ThreadedLogic::remoteReceivedPublishStateEvent */
+
+
+void ThreadedLogic::postToLogicThread(const sigc::slot<void, LogicBase*>& task)
+{
+  if (m_logic != 0)
+  {
+    m_thread->post(sigc::bind(
+          sigc::ptr_fun(&ThreadedLogic::deliverToLogicThread), m_logic, task));
+  }
+} /* ThreadedLogic::postToLogicThread */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void ThreadedLogic::postLinkManagerRequest(
+    const sigc::slot<void, LogicBase*>& request)
+{
+  if (LinkManager::hasInstance())
+  {
+    m_mailbox.post(request);
+  }
+} /* ThreadedLogic::postLinkManagerRequest */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ThreadedLogic::runMainThreadTask(const Task& task)
+{
+  task(this);
+} /* ThreadedLogic::runMainThreadTask */
+
+
+void ThreadedLogic::cfgUpdated(const std::string& section,
+                               const std::string& tag)
+{
+  std::string value;
+  if (cfg().getValue(section, tag, value))
+  {
+    postToLogicThread(sigc::bind(
+          sigc::ptr_fun(&ThreadedLogic::setThreadCfgValue),
+          section, tag, value));
+  }
+} /* ThreadedLogic::cfgUpdated */
+
+
+void ThreadedLogic::setupThread(ThreadedLogic *self, bool *success)
+{
+  *success = false;
+
+    // The FIFO must be created in the thread that read from it
+  self->m_audio_in = new AudioThreadFifo(FIFO_SECONDS * INTERNAL_SAMPLE_RATE);
+
+    // The main thread is waiting so the configuration can be copied safely
+  self->m_thread_cfg = new Config;
+  self->m_thread_cfg->update(self->cfg());
+
+  self->m_logic = self->m_factory(*self->m_thread_cfg, self->name());
+  if (self->m_logic == 0)
+  {
+    return;
+  }
+  self->m_logic->setLinkProxy(self);
+  if (!self->m_logic->initialize())
+  {
+    return;
+  }
+
+  LogicBase *logic = self->m_logic;
+  logic->idleStateChanged.connect(sigc::bind<0>(
+        sigc::ptr_fun(&ThreadedLogic::onIdleStateChanged), self));
+  logic->receivedTgUpdated.connect(sigc::bind<0>(
+        sigc::ptr_fun(&ThreadedLogic::onReceivedTgUpdated), self));
+  logic->publishStateEvent.connect(sigc::bind<0>(
+        sigc::ptr_fun(&ThreadedLogic::onPublishStateEvent), self));
+  logic->configReloadRequested.connect(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::onConfigReloadRequested), self));
+  self->m_audio_in->registerSink(logic->logicConIn());
+  logic->logicConOut()->registerSink(self->m_audio_out);
+  self->setIdle(logic->isIdle());
+
+  *success = true;
+} /* ThreadedLogic::setupThread */
+
+
+void ThreadedLogic::cleanupThread(ThreadedLogic *self)
+{
+  delete self->m_logic;
+  self->m_logic = 0;
+
+    // The FIFO watch belong to the logic thread loop so it is deleted here
+  delete self->m_audio_in;
+  self->m_audio_in = 0;
+
+  delete self->m_thread_cfg;
+  self->m_thread_cfg = 0;
+} /* ThreadedLogic::cleanupThread */
+
+
+void ThreadedLogic::deliverToLogicThread(LogicBase *logic, Task task)
+{
+  task(logic);
+} /* ThreadedLogic::deliverToLogicThread */
+
+
+void ThreadedLogic::onIdleStateChanged(ThreadedLogic *self, bool is_idle)
+{
+  self->m_mailbox.post(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::setIdleState), is_idle));
+} /* ThreadedLogic::onIdleStateChanged */
+
+
+void ThreadedLogic::onReceivedTgUpdated(ThreadedLogic *self, uint32_t tg)
+{
+  self->m_mailbox.post(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::setReceivedTgState), tg));
+} /* ThreadedLogic::onReceivedTgUpdated */
+
+
+void ThreadedLogic::onPublishStateEvent(ThreadedLogic *self,
+                                        const std::string& event_name,
+                                        const std::string& msg)
+{
+  self->m_mailbox.post(sigc::bind(
+        sigc::ptr_fun(&ThreadedLogic::emitPublishStateEvent),
+        event_name, msg));
+} /* ThreadedLogic::onPublishStateEvent */
+
+
+void ThreadedLogic::onConfigReloadRequested(ThreadedLogic *self)
+{
+  self->m_mailbox.post(
+      sigc::ptr_fun(&ThreadedLogic::emitConfigReloadRequested));
+} /* ThreadedLogic::onConfigReloadRequested */
+
+
+void ThreadedLogic::setIdleState(LogicBase *proxy, bool is_idle)
+{
+  static_cast<ThreadedLogic*>(proxy)->setIdle(is_idle);
+} /* ThreadedLogic::setIdleState */
+
+
+void ThreadedLogic::setReceivedTgState(LogicBase *proxy, uint32_t tg)
+{
+  static_cast<ThreadedLogic*>(proxy)->setReceivedTg(tg);
+} /* ThreadedLogic::setReceivedTgState */
+
+
+void ThreadedLogic::emitPublishStateEvent(LogicBase *proxy,
+                                          std::string event_name,
+                                          std::string msg)
+{
+  proxy->publishStateEvent(event_name, msg);
+} /* ThreadedLogic::emitPublishStateEvent */
+
+
+void ThreadedLogic::emitConfigReloadRequested(LogicBase *proxy)
+{
+  proxy->configReloadRequested();
+} /* ThreadedLogic::emitConfigReloadRequested */
+
+
+void ThreadedLogic::setThreadCfgValue(LogicBase *logic, std::string section,
+                                      std::string tag, std::string value)
+{
+  logic->cfg().setValue(section, tag, value);
+} /* ThreadedLogic::setThreadCfgValue */
+
+
+void ThreadedLogic::deliverRemoteCmd(LogicBase *logic, LogicBase *src_logic,
+                                     std::string cmd)
+{
+  logic->remoteCmdReceived(src_logic, cmd);
+} /* ThreadedLogic::deliverRemoteCmd */
+
+
+void ThreadedLogic::deliverPlayFile(LogicBase *logic, std::string path)
+{
+  logic->playFile(path);
+} /* ThreadedLogic::deliverPlayFile */
+
+
+void ThreadedLogic::deliverPlaySilence(LogicBase *logic, int length)
+{
+  logic->playSilence(length);
+} /* ThreadedLogic::deliverPlaySilence */
+
+
+void ThreadedLogic::deliverPlayTone(LogicBase *logic, int fq, int amp, int len)
+{
+  logic->playTone(fq, amp, len);
+} /* ThreadedLogic::deliverPlayTone */
+
+
+void ThreadedLogic::deliverPlayDtmf(LogicBase *logic, std::string digits,
+                                   int amp, int len)
+{
+  logic->playDtmf(digits, amp, len);
+} /* ThreadedLogic::deliverPlayDtmf */
+
+
+void ThreadedLogic::deliverRemoteTg(LogicBase *logic, LogicBase *src_logic,
+                                    uint32_t tg)
+{
+  logic->remoteReceivedTgUpdated(src_logic, tg);
+} /* ThreadedLogic::deliverRemoteTg */
+
+
+void ThreadedLogic::deliverRemoteStateEvent(LogicBase *logic,
+                                            LogicBase *src_logic,
+                                            std::string event_name,
+                                            std::string msg)
+{
+  logic->remoteReceivedPublishStateEvent(src_logic, event_name, msg);
+} /* ThreadedLogic::deliverRemoteStateEvent */
+
+
+
+/*
+ * This file has not been truncated
+ */
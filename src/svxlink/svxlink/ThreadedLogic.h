@@ -0,0 +1,325 @@
+/**
+@file	 ThreadedLogic.h
+@brief   Run a logic core in a worker thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains a proxy logic that make it possible to run a logic core in
+a worker thread with an event loop of its own. The proxy represent the logic
+core in the link manager, which run in the main thread.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef THREADED_LOGIC_INCLUDED
+#define THREADED_LOGIC_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppMailbox.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "LogicBase.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class CppApplication;
+  class CppEventLoopThread;
+  class AudioThreadFifo;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A proxy for a logic core running in a worker thread
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+The logic core doing the actual work is created, initialized, used and
+deleted in a worker thread, the logic thread. Many logic cores may share the
+same thread. This object live in the main thread and is registered in the
+link manager in place of the logic core.
+
+Audio between the link manager and the logic core pass through two wait free
+FIFOs. The calls that the link manager make on this object are posted to the
+logic thread. Signals emitted by the logic core, and link manager requests
+made using LogicBase::linkManagerRequest, are posted to the main thread.
+
+The logic core get a copy of the configuration that is only used in the
+logic thread. When the main configuration is changed, the changed values are
+posted to the copy. Values removed from the main configuration are kept in
+the copy.
+
+Logic cores that share an audio device, or use a module with process wide
+state, must run in the same thread. The LogicBase pointer given to the
+remote* functions of the logic core belong to the main thread. Only its name
+may be used in the logic thread.
+*/
+class ThreadedLogic : public LogicBase
+{
+  public:
+    /**
+     * @brief   A function creating the logic core in the logic thread
+     *
+     * The function is called with the configuration copy and the logic name.
+     * It should return a new logic core that has not been initialized or 0
+     * on failure.
+     */
+    typedef sigc::slot<LogicBase*, Async::Config&, const std::string&> Factory;
+
+    /**
+     * @brief 	Constuctor
+     * @param   cfg     The main configuration object
+     * @param   name    The name of the logic core
+     * @param   thread  The logic thread, which must have been started
+     * @param   factory The function that create the logic core
+     *
+     * The thread is not owned by this object. It must be stopped after all
+     * logic cores running in it have been deleted.
+     */
+    ThreadedLogic(Async::Config& cfg, const std::string& name,
+                  Async::CppEventLoopThread *thread, const Factory& factory);
+
+    /**
+     * @brief 	Destructor
+     */
+    virtual ~ThreadedLogic(void);
+
+    /**
+     * @brief 	Initialize the logic core
+     * @return	Returns \em true on success or \em false on failure
+     *
+     * The logic core is created and initialized in the logic thread. This
+     * function return when that is done.
+     */
+    virtual bool initialize(void);
+
+    /**
+     * @brief 	Get the audio pipe sink used for writing audio into this logic
+     * @return	Returns an audio pipe sink object
+     */
+    virtual Async::AudioSink *logicConIn(void);
+
+    /**
+     * @brief 	Get the audio pipe source used for reading audio from this logic
+     * @return	Returns an audio pipe source object
+     */
+    virtual Async::AudioSource *logicConOut(void);
+
+    /**
+     * @brief   A command has been received from another logic
+     * @param   src_logic The logic that sent the command
+     * @param   cmd       The received command
+     */
+    virtual void remoteCmdReceived(LogicBase* src_logic,
+                                   const std::string& cmd);
+
+    /**
+     * @brief   Play the given file
+     * @param   path The full path to the file to play
+     */
+    virtual void playFile(const std::string& path);
+
+    /**
+     * @brief   Play the a length of silence
+     * @param   length The length, in milliseconds, of silence to play
+     */
+    virtual void playSilence(int length);
+
+    /**
+     * @brief   Play a tone with the given properties
+     * @param   fq The tone frequency
+     * @param   amp The tone amplitude in "milliunits", 1000=full strength
+     * @param   len The length of the tone in milliseconds
+     */
+    virtual void playTone(int fq, int amp, int len);
+
+    /**
+     * @brief   Play DTMF digits
+     * @param   digits The DTMF digits to play
+     * @param   amp The amplitude of the individual DTMF tones (0-1000)
+     * @param   len The length in milliseconds of the digit
+     */
+    virtual void playDtmf(const std::string& digits, int amp, int len);
+
+    /**
+     * @brief   A linked logic has updated its recieved talk group
+     * @param   logic The pointer to the remote logic object
+     * @param   tg    The new received talk group
+     */
+    virtual void remoteReceivedTgUpdated(LogicBase *logic, uint32_t tg);
+
+    /**
+     * @brief   A linked logic has published a state event
+     * @param   logic       The pointer to the remote logic object
+     * @param   event_name  The name of the event
+     * @param   msg         The state update message
+     */
+    virtual void remoteReceivedPublishStateEvent(
+        LogicBase *logic, const std::string& event_name,
+        const std::string& msg);
+
+    /**
+     * @brief   Run a task in the logic thread
+     * @param   task The task to run
+     *
+     * The task is called in the logic thread with the logic core as argument.
+     * This function must be called from the main thread.
+     */
+    virtual void postToLogicThread(const sigc::slot<void, LogicBase*>& task);
+
+  protected:
+    /**
+     * @brief   Forward a link manager request to the main thread
+     * @param   request The request to run
+     *
+     * This function is called from the logic thread.
+     */
+    virtual void postLinkManagerRequest(
+        const sigc::slot<void, LogicBase*>& request);
+
+  private:
+    typedef sigc::slot<void, LogicBase*> Task;
+
+    static const unsigned FIFO_SECONDS = 2;
+
+    Async::CppApplication       *m_main_app;
+    Async::CppEventLoopThread   *m_thread;
+    Factory                     m_factory;
+    Async::Config               *m_thread_cfg;
+    LogicBase                   *m_logic;
+    Async::AudioThreadFifo      *m_audio_in;
+    Async::AudioThreadFifo      *m_audio_out;
+    Async::CppMailbox<Task>     m_mailbox;
+    bool                        m_link_registered;
+
+    ThreadedLogic(const ThreadedLogic&);
+    ThreadedLogic& operator=(const ThreadedLogic&);
+    void runMainThreadTask(const Task& task);
+    void cfgUpdated(const std::string& section, const std::string& tag);
+    static void setupThread(ThreadedLogic *self, bool *success);
+    static void cleanupThread(ThreadedLogic *self);
+    static void deliverToLogicThread(LogicBase *logic, Task task);
+    static void onIdleStateChanged(ThreadedLogic *self, bool is_idle);
+    static void onReceivedTgUpdated(ThreadedLogic *self, uint32_t tg);
+    static void onPublishStateEvent(ThreadedLogic *self,
+                                    const std::string& event_name,
+                                    const std::string& msg);
+    static void onConfigReloadRequested(ThreadedLogic *self);
+    static void setIdleState(LogicBase *proxy, bool is_idle);
+    static void setReceivedTgState(LogicBase *proxy, uint32_t tg);
+    static void emitPublishStateEvent(LogicBase *proxy,
+                                      std::string event_name,
+                                      std::string msg);
+    static void emitConfigReloadRequested(LogicBase *proxy);
+    static void setThreadCfgValue(LogicBase *logic, std::string section,
+                                  std::string tag, std::string value);
+    static void deliverRemoteCmd(LogicBase *logic, LogicBase *src_logic,
+                                 std::string cmd);
+    static void deliverPlayFile(LogicBase *logic, std::string path);
+    static void deliverPlaySilence(LogicBase *logic, int length);
+    static void deliverPlayTone(LogicBase *logic, int fq, int amp, int len);
+    static void deliverPlayDtmf(LogicBase *logic, std::string digits, int amp,
+                                int len);
+    static void deliverRemoteTg(LogicBase *logic, LogicBase *src_logic,
+                                uint32_t tg);
+    static void deliverRemoteStateEvent(LogicBase *logic,
+                                        LogicBase *src_logic,
+                                        std::string event_name,
+                                        std::string msg);
+
+};  /* class ThreadedLogic */
+
+
+//} /* namespace */
+
+#endif /* THREADED_LOGIC_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,276 @@
+/**
+@file	 ThreadedModule.cpp
+@brief   A base class for modules that run in a thread of their own
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncApplication.h>
+#include <AsyncCppApplication.h>
+#include <AsyncCppEventLoopThread.h>
+#include <AsyncAudioThreadFifo.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ThreadedModule.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+ThreadedModule::ThreadedModule(void *dl_handle, Logic *logic,
+                               const string& cfg_name)
+  : Module(dl_handle, logic, cfg_name),
+    m_main_app(dynamic_cast<CppApplication*>(&Application::app())),
+    m_thread(0), m_audio_in(0), m_audio_out(0),
+    m_mailbox(m_main_app,
+              sigc::mem_fun(*this, &ThreadedModule::mainThreadMsg))
+{
+} /* ThreadedModule::ThreadedModule */
+
+
+ThreadedModule::~ThreadedModule(void)
+{
+  stopThread();
+} /* ThreadedModule::~ThreadedModule */
+
+
+bool ThreadedModule::initialize(void)
+{
+  if (!Module::initialize())
+  {
+    return false;
+  }
+
+  if (m_main_app == 0)
+  {
+    cerr << "*** ERROR: Module " << name() << " need to run in a thread "
+         << "but threads are not supported by this application\n";
+    return false;
+  }
+
+    // The audio to the logic core is read in the main thread
+  m_audio_out = new AudioThreadFifo(FIFO_SECONDS * INTERNAL_SAMPLE_RATE);
+  AudioSource::setHandler(m_audio_out);
+
+  m_thread = new CppEventLoopThread;
+  if (!m_thread->start())
+  {
+    cerr << "*** ERROR: Could not start the thread for module "
+         << name() << endl;
+    delete m_thread;
+    m_thread = 0;
+    return false;
+  }
+
+  bool success = false;
+  m_thread->postAndWait(sigc::bind(
+        sigc::ptr_fun(&ThreadedModule::setupThread), this, &success));
+  if (!success)
+  {
+    return false;
+  }
+
+    // The audio from the logic core is read in the module thread
+  AudioSink::setHandler(m_audio_in);
+
+  return true;
+} /* ThreadedModule::initialize */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void ThreadedModule::postToModuleThread(const string& msg)
+{
+  if (m_thread != 0)
+  {
+    m_thread->post(sigc::bind(
+          sigc::ptr_fun(&ThreadedModule::deliverToModuleThread), this, msg));
+  }
+} /* ThreadedModule::postToModuleThread */
+
+
+void ThreadedModule::postToMainThread(const string& msg)
+{
+    m_mailbox.post(msg);
+} /* ThreadedModule::postToMainThread */
+
+
+AudioSource *ThreadedModule::threadAudioIn(void)
+{
+  return m_audio_in;
+} /* ThreadedModule::threadAudioIn */
+
+
+AudioSink *ThreadedModule::threadAudioOut(void)
+{
+  return m_audio_out;
+} /* ThreadedModule::threadAudioOut */
+
+
+void ThreadedModule::stopThread(void)
+{
+  if (m_thread != 0)
+  {
+      // No more audio must be written to the module thread when the FIFO
+      // is deleted
+    AudioSink::clearHandler();
+    if (m_thread->isRunning())
+    {
+      m_thread->postAndWait(sigc::bind(
+            sigc::ptr_fun(&ThreadedModule::cleanupThread), this));
+      m_thread->stop();
+    }
+    delete m_thread;
+    m_thread = 0;
+  }
+
+  if (m_audio_out != 0)
+  {
+    AudioSource::clearHandler();
+    delete m_audio_out;
+    m_audio_out = 0;
+  }
+} /* ThreadedModule::stopThread */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ThreadedModule::setupThread(ThreadedModule *module, bool *success)
+{
+    // The FIFO must be created in the thread that read from it
+  module->m_audio_in =
+    new AudioThreadFifo(FIFO_SECONDS * INTERNAL_SAMPLE_RATE);
+  *success = module->threadInit();
+} /* ThreadedModule::setupThread */
+
+
+void ThreadedModule::cleanupThread(ThreadedModule *module)
+{
+  module->threadCleanup();
+
+    // The FIFO watch belong to the module thread loop so it is deleted here
+  delete module->m_audio_in;
+  module->m_audio_in = 0;
+} /* ThreadedModule::cleanupThread */
+
+
+void ThreadedModule::deliverToModuleThread(ThreadedModule *module,
+                                           std::string msg)
+{
+  module->moduleThreadMsg(msg);
+} /* ThreadedModule::deliverToModuleThread */
+
+
+
+/*
+ * This file has not been truncated
+ */
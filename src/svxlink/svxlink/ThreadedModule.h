@@ -0,0 +1,280 @@
+/**
+@file	 ThreadedModule.h
+@brief   A base class for modules that run in a thread of their own
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This file contains a module base class for modules that do heavy processing,
+like speech synthesis or image decoding, that would otherwise block the
+logic core event loop.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef THREADED_MODULE_INCLUDED
+#define THREADED_MODULE_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppMailbox.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "Module.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class CppApplication;
+  class CppEventLoopThread;
+  class AudioThreadFifo;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Base class for modules that run in a thread of their own
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+A module that inherit this class instead of Module get a thread with an Async
+event loop of its own, the module thread. The Module interface itself, that
+is all the virtual functions called by the logic core, is still called in
+the main thread. The module decide what should be passed on to the module
+thread.
+
+Audio cross between the threads through two wait free FIFOs. Audio from the
+logic core to the module is available in the module thread through
+threadAudioIn and audio from the module to the logic core is written to
+threadAudioOut. Other communication is done using string messages.
+postToModuleThread queue a message that is delivered to moduleThreadMsg in
+the module thread and postToMainThread queue a message that is delivered to
+mainThreadMsg in the main thread. Messages are delivered in the order they
+were posted.
+
+The lifetime rules are:
+- All Async objects used in the module thread must be created in threadInit,
+  or later in the module thread, and must be deleted in threadCleanup.
+- The configuration must only be read in threadInit. The main thread wait
+  for threadInit to return so nothing else is using the configuration while
+  it run.
+- The inheriting class must call stopThread in its destructor. The module
+  thread cannot be stopped by this class destructor since the inheriting
+  class has already been destroyed by then.
+- Messages posted to the main thread that have not been delivered when the
+  module is deleted are thrown away.
+- Objects belonging to one thread may never be used from the other thread.
+  Note that the sigc::trackable base class is not thread safe so a slot
+  bound to an object must be created in the thread owning the object.
+
+The module thread require the application to be an Async::CppApplication.
+*/
+class ThreadedModule : public Module
+{
+  public:
+    /**
+     * @brief 	Constuctor
+     * @param 	dl_handle The plugin handle
+     * @param 	logic 	  The logic core this module belongs to
+     * @param 	cfg_name  The name of the configuration section
+     */
+    ThreadedModule(void *dl_handle, Logic *logic, const std::string& cfg_name);
+
+    /**
+     * @brief 	Destructor
+     */
+    virtual ~ThreadedModule(void);
+
+    /**
+     * @brief 	Initialize the module
+     * @return	Return \em true if the initialization was successful
+     *	      	or else \em false.
+     *
+     * Start the module thread and call threadInit in it. This function
+     * return when threadInit has returned. If this function is reimplemented,
+     * the base class function must be called and its return value checked.
+     */
+    virtual bool initialize(void);
+
+  protected:
+    /**
+     * @brief   Set up the module thread
+     * @return  Return \em true on success or else \em false
+     *
+     * This function is called in the module thread when the module is
+     * initialized. Create the objects used in the module thread here.
+     */
+    virtual bool threadInit(void) { return true; }
+
+    /**
+     * @brief   Clean up the module thread
+     *
+     * This function is called in the module thread by stopThread. Delete all
+     * Async objects belonging to the module thread here. It is also called
+     * if threadInit failed.
+     */
+    virtual void threadCleanup(void) {}
+
+    /**
+     * @brief   A message has been received in the module thread
+     * @param   msg The message posted using postToModuleThread
+     */
+    virtual void moduleThreadMsg(const std::string& msg) {}
+
+    /**
+     * @brief   A message has been received in the main thread
+     * @param   msg The message posted using postToMainThread
+     */
+    virtual void mainThreadMsg(const std::string& msg) {}
+
+    /**
+     * @brief   Post a message to the module thread
+     * @param   msg The message to post
+     *
+     * This function must be called from the main thread.
+     */
+    void postToModuleThread(const std::string& msg);
+
+    /**
+     * @brief   Post a message to the main thread
+     * @param   msg The message to post
+     *
+     * This function must be called from the module thread.
+     */
+    void postToMainThread(const std::string& msg);
+
+    /**
+     * @brief   Get the source for audio from the logic core
+     * @return  Returns the audio source to connect to in the module thread
+     *
+     * Register the audio sink that should receive the audio from the
+     * logic core to this source in threadInit.
+     */
+    Async::AudioSource *threadAudioIn(void);
+
+    /**
+     * @brief   Get the sink for audio to the logic core
+     * @return  Returns the audio sink to write to in the module thread
+     *
+     * Register the audio source that produce audio to the logic core with
+     * this sink in threadInit.
+     */
+    Async::AudioSink *threadAudioOut(void);
+
+    /**
+     * @brief   Stop the module thread
+     *
+     * Call threadCleanup in the module thread and then stop the thread.
+     * This function must be called from the destructor of the inheriting
+     * class. It is safe to call it more than once.
+     */
+    void stopThread(void);
+
+  private:
+    static const unsigned FIFO_SECONDS = 2;
+
+    Async::CppApplication       *m_main_app;
+    Async::CppEventLoopThread   *m_thread;
+    Async::AudioThreadFifo      *m_audio_in;
+    Async::AudioThreadFifo      *m_audio_out;
+    Async::CppMailbox<std::string> m_mailbox;
+
+    ThreadedModule(const ThreadedModule&);
+    ThreadedModule& operator=(const ThreadedModule&);
+    static void setupThread(ThreadedModule *module, bool *success);
+    static void cleanupThread(ThreadedModule *module);
+    static void deliverToModuleThread(ThreadedModule *module, std::string msg);
+
+};  /* class ThreadedModule */
+
+
+//} /* namespace */
+
+#endif /* THREADED_MODULE_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
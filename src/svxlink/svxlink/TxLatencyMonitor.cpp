@@ -0,0 +1,318 @@
+/**
+@file	 TxLatencyMonitor.cpp
+@brief   Measure the latency from squelch open to transmitted audio
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "TxLatencyMonitor.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // Measurements longer than this, in seconds, are not counted
+#define MAX_LATENCY   5.0
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+class TxLatencyMonitor::Histogram
+{
+  public:
+    explicit Histogram(const string& name) : m_name(name) { reset(); }
+
+    void reset(void)
+    {
+      m_count = 0;
+      m_sum = 0.0;
+      m_min = 0.0;
+      m_max = 0.0;
+      fill(m_buckets, m_buckets + BUCKET_CNT, 0);
+    }
+
+    void add(double latency)
+    {
+      const double ms = 1000.0 * latency;
+      m_min = (m_count == 0) ? ms : min(m_min, ms);
+      m_max = (m_count == 0) ? ms : max(m_max, ms);
+      m_sum += ms;
+      m_count += 1;
+      unsigned bucket = 0;
+      while ((bucket < BUCKET_CNT - 1) && (ms >= bucket_limits[bucket]))
+      {
+        ++bucket;
+      }
+      m_buckets[bucket] += 1;
+    }
+
+    void dump(ostream& os) const
+    {
+      os << "  " << left << setw(17) << (m_name + ":") << right
+         << " n=" << m_count;
+      if (m_count > 0)
+      {
+        os << fixed << setprecision(1)
+           << " min=" << m_min
+           << " avg=" << m_sum / m_count
+           << " max=" << m_max << "ms";
+        os.unsetf(ios::floatfield);
+      }
+      os << " |";
+      for (unsigned i=0; i<BUCKET_CNT; ++i)
+      {
+        if (i < BUCKET_CNT - 1)
+        {
+          os << " <" << bucket_limits[i];
+        }
+        else
+        {
+          os << " >=" << bucket_limits[i-1];
+        }
+        os << ":" << m_buckets[i];
+      }
+      os << endl;
+    }
+
+  private:
+    static const unsigned BUCKET_CNT = 10;
+    static const unsigned bucket_limits[BUCKET_CNT - 1];
+
+    string          m_name;
+    unsigned long   m_count;
+    double          m_sum;
+    double          m_min;
+    double          m_max;
+    unsigned long   m_buckets[BUCKET_CNT];
+}; /* TxLatencyMonitor::Histogram */
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+  // The upper limits of the histogram buckets in milliseconds
+const unsigned TxLatencyMonitor::Histogram::bucket_limits[BUCKET_CNT - 1] =
+{
+  5, 10, 20, 50, 100, 200, 500, 1000, 2000
+};
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+TxLatencyMonitor::TxLatencyMonitor(const string& name)
+  : m_name(name), m_sql_event(new Histogram("sql_event")),
+    m_sql_to_tx_in(new Histogram("sql_to_tx_in")),
+    m_tx_in_to_ptt(new Histogram("tx_in_to_ptt")),
+    m_ptt_to_audio_out(new Histogram("ptt_to_audio_out")),
+    m_sql_to_audio_out(new Histogram("sql_to_audio_out")),
+    m_sql_open_time(-1.0), m_tx_in_time(-1.0), m_ptt_time(-1.0)
+{
+} /* TxLatencyMonitor::TxLatencyMonitor */
+
+
+TxLatencyMonitor::~TxLatencyMonitor(void)
+{
+  delete m_sql_event;
+  delete m_sql_to_tx_in;
+  delete m_tx_in_to_ptt;
+  delete m_ptt_to_audio_out;
+  delete m_sql_to_audio_out;
+} /* TxLatencyMonitor::~TxLatencyMonitor */
+
+
+void TxLatencyMonitor::squelchOpened(void)
+{
+  m_sql_open_time = now();
+  m_tx_in_time = -1.0;
+} /* TxLatencyMonitor::squelchOpened */
+
+
+void TxLatencyMonitor::squelchOpenHandled(void)
+{
+  addSince(m_sql_event, m_sql_open_time, now());
+} /* TxLatencyMonitor::squelchOpenHandled */
+
+
+void TxLatencyMonitor::txInputStateChanged(bool is_active, bool is_idle)
+{
+  if (is_active)
+  {
+    m_tx_in_time = now();
+    addSince(m_sql_to_tx_in, m_sql_open_time, m_tx_in_time);
+  }
+} /* TxLatencyMonitor::txInputStateChanged */
+
+
+void TxLatencyMonitor::transmitterStateChanged(bool is_transmitting)
+{
+  if (is_transmitting)
+  {
+    m_ptt_time = now();
+    addSince(m_tx_in_to_ptt, m_tx_in_time, m_ptt_time);
+  }
+  else
+  {
+    m_ptt_time = -1.0;
+  }
+} /* TxLatencyMonitor::transmitterStateChanged */
+
+
+void TxLatencyMonitor::txAudioStarted(void)
+{
+  const double t = now();
+  addSince(m_ptt_to_audio_out, m_ptt_time, t);
+  addSince(m_sql_to_audio_out, m_sql_open_time, t);
+
+    // Only the first transmission after a squelch opening is measured
+  m_sql_open_time = -1.0;
+  m_tx_in_time = -1.0;
+} /* TxLatencyMonitor::txAudioStarted */
+
+
+void TxLatencyMonitor::reset(void)
+{
+  m_sql_event->reset();
+  m_sql_to_tx_in->reset();
+  m_tx_in_to_ptt->reset();
+  m_ptt_to_audio_out->reset();
+  m_sql_to_audio_out->reset();
+} /* TxLatencyMonitor::reset */
+
+
+void TxLatencyMonitor::dump(ostream& os) const
+{
+  os << "--- TX latency for " << m_name << endl;
+  m_sql_event->dump(os);
+  m_sql_to_tx_in->dump(os);
+  m_tx_in_to_ptt->dump(os);
+  m_ptt_to_audio_out->dump(os);
+  m_sql_to_audio_out->dump(os);
+} /* TxLatencyMonitor::dump */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+double TxLatencyMonitor::now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+} /* TxLatencyMonitor::now */
+
+
+void TxLatencyMonitor::addSince(Histogram *hist, double since, double until)
+{
+  if ((since >= 0.0) && (until - since <= MAX_LATENCY))
+  {
+    hist->add(until - since);
+  }
+} /* TxLatencyMonitor::addSince */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,210 @@
+/**
+@file	 TxLatencyMonitor.h
+@brief   Measure the latency from squelch open to transmitted audio
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef TX_LATENCY_MONITOR_INCLUDED
+#define TX_LATENCY_MONITOR_INCLUDED
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+#include <string>
+#include <iosfwd>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Measure the latency from squelch open to transmitted audio
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class is used by a logic core to measure where the time goes between a
+squelch opening on the receiver and the first audio sample reaching the
+transmitter audio device. The logic core call the event functions at each
+transition point and the time between them is taken from the monotonic clock
+and collected in one histogram per stage. The stages are:
+
+  sql_event         - Time spent handling the squelch open event in the logic
+  sql_to_tx_in      - Squelch open to the first audio sample written to the TX
+  tx_in_to_ptt      - First audio sample written to the TX to the TX keying up
+  ptt_to_audio_out  - TX keying up to the first audio sample being output
+  sql_to_audio_out  - The whole way from squelch open to audio output
+
+Measurements older than MAX_LATENCY are dropped since a transmission that
+start that long after a squelch opening is not likely caused by it.
+*/
+class TxLatencyMonitor : public sigc::trackable
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param   name The name of the owner, used when printing
+     */
+    explicit TxLatencyMonitor(const std::string& name);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~TxLatencyMonitor(void);
+
+    /**
+     * @brief   Called when the receiver squelch open
+     */
+    void squelchOpened(void);
+
+    /**
+     * @brief   Called when the logic is done handling the squelch open event
+     */
+    void squelchOpenHandled(void);
+
+    /**
+     * @brief   Called when audio start or stop flowing into the transmitter
+     * @param   is_active \em true if audio is being written to the TX
+     * @param   is_idle   \em true if the audio stream is idle
+     */
+    void txInputStateChanged(bool is_active, bool is_idle);
+
+    /**
+     * @brief   Called when the transmitter is turned on or off
+     * @param   is_transmitting \em true if the transmitter is on
+     */
+    void transmitterStateChanged(bool is_transmitting);
+
+    /**
+     * @brief   Called when the first audio of a transmission is output
+     */
+    void txAudioStarted(void);
+
+    /**
+     * @brief   Clear all histograms
+     */
+    void reset(void);
+
+    /**
+     * @brief   Print all histograms
+     * @param   os The stream to print to
+     */
+    void dump(std::ostream& os) const;
+
+  private:
+    class Histogram;
+
+    std::string   m_name;
+    Histogram     *m_sql_event;
+    Histogram     *m_sql_to_tx_in;
+    Histogram     *m_tx_in_to_ptt;
+    Histogram     *m_ptt_to_audio_out;
+    Histogram     *m_sql_to_audio_out;
+    double        m_sql_open_time;
+    double        m_tx_in_time;
+    double        m_ptt_time;
+
+    TxLatencyMonitor(const TxLatencyMonitor&);
+    TxLatencyMonitor& operator=(const TxLatencyMonitor&);
+    static double now(void);
+    static void addSince(Histogram *hist, double since, double until);
+
+};  /* class TxLatencyMonitor */
+
+
+//} /* namespace */
+
+#endif /* TX_LATENCY_MONITOR_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
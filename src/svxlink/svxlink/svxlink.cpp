@@ -52,6 +52,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iomanip>
 #include <algorithm>
 #include <vector>
+#include <map>
 #include <cstring>
 #include <set>
 #include <cerrno>
@@ -64,10 +65,14 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncCppApplication.h>
+#include <AsyncCppEventLoopThread.h>
 #include <AsyncConfig.h>
 #include <AsyncTimer.h>
 #include <AsyncFdWatch.h>
 #include <AsyncAudioIO.h>
+#include <AsyncMetrics.h>
+#include <AsyncMetricsHttpServer.h>
+#include <AsyncRealtime.h>
 #include <LocationInfo.h>
 #include <common.h>
 #include <config.h>
@@ -85,6 +90,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "SimplexLogic.h"
 #include "RepeaterLogic.h"
 #include "ReflectorLogic.h"
+#include "ThreadedLogic.h"
 #include "LinkManager.h"
 
 
@@ -117,6 +123,60 @@ using namespace sigc;
  *
  ****************************************************************************/
 
+  // Measure how late the main loop is in dispatching a timer. The worst lag
+  // seen during each ten second window is kept in a gauge.
+class LoopLagMonitor : public sigc::trackable
+{
+  public:
+    LoopLagMonitor(void)
+      : m_timer(INTERVAL_MS), m_max_lag(0.0), m_ticks(0)
+    {
+      m_lag = Metrics::instance().histogram("svxlink_loop_lag_seconds",
+          "How late the main loop dispatch a timer",
+          {0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.5});
+      m_max_lag_gauge = Metrics::instance().gauge(
+          "svxlink_loop_lag_max_seconds",
+          "The largest main loop lag during the last ten seconds");
+      m_timer.setLabel("LoopLagMonitor");
+      m_timer.expired.connect(mem_fun(*this, &LoopLagMonitor::onTimeout));
+      m_start = now();
+    }
+
+  private:
+    static const int INTERVAL_MS = 100;
+    static const unsigned WINDOW_TICKS = 100;
+
+    Timer             m_timer;
+    double            m_start;
+    double            m_max_lag;
+    unsigned          m_ticks;
+    MetricHistogram*  m_lag;
+    MetricGauge*      m_max_lag_gauge;
+
+    static double now(void)
+    {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec / 1.0e9;
+    }
+
+    void onTimeout(Timer *t)
+    {
+      const double t_now = now();
+      const double lag = max(0.0, t_now - m_start - INTERVAL_MS / 1000.0);
+      m_lag->observe(lag);
+      m_max_lag = max(m_max_lag, lag);
+      if (++m_ticks == WINDOW_TICKS)
+      {
+        m_max_lag_gauge->set(m_max_lag);
+        m_max_lag = 0.0;
+        m_ticks = 0;
+      }
+      m_start = t_now;
+      t->reset();
+    }
+};
+
 
 
 /****************************************************************************
@@ -129,6 +189,12 @@ static void parse_arguments(int argc, const char **argv);
 static void stdinHandler(FdWatch *w);
 static void stdout_handler(FdWatch *w);
 static void initialize_logics(Config &cfg);
+static LogicBase *create_logic(Config &cfg, const string& logic_name,
+                               string logic_type);
+static bool open_config(Config &cfg, const string& cfg_filename);
+static bool read_cfg_dir(Config &cfg, const string& main_cfg_file);
+static void reload_config(void);
+static void setup_realtime(Config &cfg);
 static void sighup_handler(int signal);
 static void sigterm_handler(int signal);
 static void handle_unix_signal(int signum);
@@ -157,12 +223,17 @@ static char   	      	  *pidfile_name = NULL;
 static char   	      	  *logfile_name = NULL;
 static char   	      	  *runasuser = NULL;
 static char   	      	  *config = NULL;
+static char   	      	  *config_cache = NULL;
+static bool               config_from_cache = false;
 static int    	      	  daemonize = 0;
 static int    	      	  logfd = -1;
 static vector<LogicBase*> logic_vec;
+static map<unsigned, CppEventLoopThread*> logic_threads;
 static FdWatch	      	  *stdin_watch = 0;
 static FdWatch	      	  *stdout_watch = 0;
 static string         	  tstamp_format;
+static string             main_cfg_filename;
+static Config             *running_cfg = 0;
 
 
 /****************************************************************************
@@ -343,7 +414,7 @@ int main(int argc, char **argv)
   if (config != NULL)
   {
     cfg_filename = string(config);
-    if (!cfg.open(cfg_filename))
+    if (!open_config(cfg, cfg_filename))
     {
       cerr << "*** ERROR: Could not open configuration file: "
       	   << config << endl;
@@ -354,13 +425,13 @@ int main(int argc, char **argv)
   {
     cfg_filename = string(home_dir);
     cfg_filename += "/.svxlink/svxlink.conf";
-    if (!cfg.open(cfg_filename))
+    if (!open_config(cfg, cfg_filename))
     {
       cfg_filename = SVX_SYSCONF_INSTALL_DIR "/svxlink.conf";
-      if (!cfg.open(cfg_filename))
+      if (!open_config(cfg, cfg_filename))
       {
 	cfg_filename = SYSCONF_INSTALL_DIR "/svxlink.conf";
-	if (!cfg.open(cfg_filename))
+	if (!open_config(cfg, cfg_filename))
 	{
 	  cerr << "*** ERROR: Could not open configuration file";
           if (errno != 0)
@@ -380,56 +451,18 @@ int main(int argc, char **argv)
       }
     }
   }
-  string main_cfg_filename(cfg_filename);
-  
-  string cfg_dir;
-  if (cfg.getValue("GLOBAL", "CFG_DIR", cfg_dir))
+  main_cfg_filename = cfg_filename;
+  if (!config_from_cache && !read_cfg_dir(cfg, main_cfg_filename))
   {
-    if (cfg_dir[0] != '/')
-    {
-      int slash_pos = main_cfg_filename.rfind('/');
-      if (slash_pos != -1)
-      {
-      	cfg_dir = main_cfg_filename.substr(0, slash_pos+1) + cfg_dir;
-      }
-      else
-      {
-      	cfg_dir = string("./") + cfg_dir;
-      }
-    }
-    
-    DIR *dir = opendir(cfg_dir.c_str());
-    if (dir == NULL)
-    {
-      cerr << "*** ERROR: Could not read from directory spcified by "
-      	   << "configuration variable GLOBAL/CFG_DIR=" << cfg_dir << endl;
-      exit(1);
-    }
-    
-    struct dirent *dirent;
-    while ((dirent = readdir(dir)) != NULL)
-    {
-      char *dot = strrchr(dirent->d_name, '.');
-      if ((dot == NULL) || (dirent->d_name[0] == '.') ||
-          (strcmp(dot, ".conf") != 0))
-      {
-      	continue;
-      }
-      cfg_filename = cfg_dir + "/" + dirent->d_name;
-      if (!cfg.open(cfg_filename))
-       {
-	 cerr << "*** ERROR: Could not open configuration file: "
-	      << cfg_filename << endl;
-	 exit(1);
-       }
-    }
-    
-    if (closedir(dir) == -1)
-    {
-      cerr << "*** ERROR: Error closing directory specified by"
-      	   << "configuration variable GLOBAL/CFG_DIR=" << cfg_dir << endl;
-      exit(1);
-    }
+    exit(1);
+  }
+  running_cfg = &cfg;
+
+  if ((config_cache != NULL) && !config_from_cache &&
+      !cfg.saveSnapshot(config_cache))
+  {
+    cerr << "*** WARNING: Could not write the configuration cache file "
+         << config_cache << ": " << strerror(errno) << endl;
   }
   
   cfg.getValue("GLOBAL", "TIMESTAMP_FORMAT", tstamp_format);
@@ -443,6 +476,10 @@ int main(int argc, char **argv)
   cout << "GNU GPL (General Public License) version 2 or later.\n";
 
   cout << "\nUsing configuration file: " << main_cfg_filename << endl;
+  if (config_from_cache)
+  {
+    cout << "Configuration loaded from cache file " << config_cache << endl;
+  }
   
   string value;
   if (cfg.getValue("GLOBAL", "CARD_SAMPLE_RATE", value))
@@ -483,6 +520,18 @@ int main(int argc, char **argv)
   cfg.getValue("GLOBAL", "CARD_CHANNELS", card_channels);
   AudioIO::setChannels(card_channels);
 
+    // Set up the cache for decoded audio clips
+  unsigned clip_cache_size = 0;
+  if (cfg.getValue("GLOBAL", "CLIP_CACHE_SIZE", clip_cache_size))
+  {
+    MsgHandler::setClipCacheSize(1024 * clip_cache_size);
+  }
+  if (cfg.getValue("GLOBAL", "CLIP_CACHE_PRELOAD", value) && !value.empty())
+  {
+    unsigned cnt = MsgHandler::preloadClips(value);
+    cout << "--- Preloaded " << cnt << " audio clips from " << value << endl;
+  }
+
     // Init locationinfo
   if (cfg.getValue("GLOBAL", "LOCATION_INFO", value))
   {
@@ -505,6 +554,19 @@ int main(int argc, char **argv)
     }
   }
 
+    // Start the Prometheus metrics exporter
+  MetricsHttpServer *metrics_server = 0;
+  if (cfg.getValue("GLOBAL", "METRICS_HTTP_PORT", value) && !value.empty())
+  {
+    metrics_server = new MetricsHttpServer(value);
+  }
+
+  LoopLagMonitor loop_lag_monitor;
+
+    // Enter the realtime mode before the logics open any audio devices so
+    // that the audio I/O threads get realtime scheduling
+  setup_realtime(cfg);
+
   initialize_logics(cfg);
 
   if (LinkManager::hasInstance())
@@ -529,6 +591,7 @@ int main(int argc, char **argv)
 
   app.exec();
 
+  delete metrics_server;
   LinkManager::deleteInstance();
   LocationInfo::deleteInstance();
 
@@ -553,6 +616,14 @@ int main(int argc, char **argv)
     delete *lit;
   }
   logic_vec.clear();
+
+  map<unsigned, CppEventLoopThread*>::iterator tit;
+  for (tit=logic_threads.begin(); tit!=logic_threads.end(); ++tit)
+  {
+    (*tit).second->stop();
+    delete (*tit).second;
+  }
+  logic_threads.clear();
   
   if (logfd != -1)
   {
@@ -599,6 +670,9 @@ static void parse_arguments(int argc, const char **argv)
 	    "Specify the user to run SvxLink as", "<username>"},
     {"config", 0, POPT_ARG_STRING, &config, 0,
 	    "Specify the configuration file to use", "<filename>"},
+    {"config-cache", 0, POPT_ARG_STRING, &config_cache, 0,
+	    "Specify a file used to cache the parsed configuration",
+            "<filename>"},
     /*
     {"int_arg", 'i', POPT_ARG_INT, &int_arg, 0,
 	    "Description of int argument", "<an int>"},
@@ -742,28 +816,44 @@ static void initialize_logics(Config &cfg)
       	   << logic_name << "\". Skipping...\n";
       continue;
     }
-    LogicBase *logic = 0;
-    if (logic_type == "Simplex")
-    {
-      logic = new SimplexLogic(cfg, logic_name);
-    }
-    else if (logic_type == "Repeater")
+    unsigned thread_no = 0;
+    if (!cfg.getValue(logic_name, "THREAD", thread_no, true))
     {
-      logic = new RepeaterLogic(cfg, logic_name);
-    }
-    else if (logic_type == "Reflector")
-    {
-      logic = new ReflectorLogic(cfg, logic_name);
+      cerr << "*** ERROR: Illegal value for configuration variable "
+           << logic_name << "/THREAD. Skipping...\n";
+      continue;
     }
-    else if (logic_type == "Dummy")
+    LogicBase *logic = 0;
+    if (thread_no > 0)
     {
-      logic = new DummyLogic(cfg, logic_name);
+        // The logic core is created in a worker thread and is represented
+        // by a proxy logic in the main thread. Logics with the same thread
+        // number share the thread.
+      CppEventLoopThread *thread = 0;
+      map<unsigned, CppEventLoopThread*>::iterator tit =
+        logic_threads.find(thread_no);
+      if (tit != logic_threads.end())
+      {
+        thread = (*tit).second;
+      }
+      else
+      {
+        thread = new CppEventLoopThread;
+        if (!thread->start())
+        {
+          cerr << "*** ERROR: Could not start thread " << thread_no
+               << " for logic " << logic_name << ". Skipping...\n";
+          delete thread;
+          continue;
+        }
+        logic_threads[thread_no] = thread;
+      }
+      logic = new ThreadedLogic(cfg, logic_name, thread,
+          sigc::bind(sigc::ptr_fun(&create_logic), logic_type));
     }
     else
     {
-      cerr << "*** ERROR: Unknown logic type \"" << logic_type
-           << "\" specified for logic " << logic_name << ".\n";
-      continue;
+      logic = create_logic(cfg, logic_name, logic_type);
     }
     if ((logic == 0) || !logic->initialize())
     {
@@ -773,6 +863,7 @@ static void initialize_logics(Config &cfg)
       continue;
     }
     
+    logic->configReloadRequested.connect(sigc::ptr_fun(&reload_config));
     logic_vec.push_back(logic);
   } while (comma != logics.end());
   
@@ -784,14 +875,192 @@ static void initialize_logics(Config &cfg)
 } /* initialize_logics */
 
 
-static void sighup_handler(int signal)
+static LogicBase *create_logic(Config &cfg, const string& logic_name,
+                               string logic_type)
 {
-  if (logfile_name == 0)
+  if (logic_type == "Simplex")
+  {
+    return new SimplexLogic(cfg, logic_name);
+  }
+  else if (logic_type == "Repeater")
+  {
+    return new RepeaterLogic(cfg, logic_name);
+  }
+  else if (logic_type == "Reflector")
+  {
+    return new ReflectorLogic(cfg, logic_name);
+  }
+  else if (logic_type == "Dummy")
+  {
+    return new DummyLogic(cfg, logic_name);
+  }
+  cerr << "*** ERROR: Unknown logic type \"" << logic_type
+       << "\" specified for logic " << logic_name << ".\n";
+  return 0;
+} /* create_logic */
+
+
+static bool open_config(Config &cfg, const string& cfg_filename)
+{
+    // A configuration cache snapshot is only used if it was created from
+    // the same main configuration file and no source file has changed since
+  if ((config_cache != NULL) && cfg.loadSnapshot(config_cache, cfg_filename))
+  {
+    config_from_cache = true;
+    return true;
+  }
+  return cfg.open(cfg_filename);
+} /* open_config */
+
+
+static bool read_cfg_dir(Config &cfg, const string& main_cfg_file)
+{
+  string cfg_dir;
+  if (!cfg.getValue("GLOBAL", "CFG_DIR", cfg_dir))
+  {
+    return true;
+  }
+
+  if (cfg_dir[0] != '/')
+  {
+    int slash_pos = main_cfg_file.rfind('/');
+    if (slash_pos != -1)
+    {
+      cfg_dir = main_cfg_file.substr(0, slash_pos+1) + cfg_dir;
+    }
+    else
+    {
+      cfg_dir = string("./") + cfg_dir;
+    }
+  }
+
+  DIR *dir = opendir(cfg_dir.c_str());
+  if (dir == NULL)
+  {
+    cerr << "*** ERROR: Could not read from directory spcified by "
+         << "configuration variable GLOBAL/CFG_DIR=" << cfg_dir << endl;
+    return false;
+  }
+
+  bool success = true;
+  struct dirent *dirent;
+  while (success && ((dirent = readdir(dir)) != NULL))
+  {
+    char *dot = strrchr(dirent->d_name, '.');
+    if ((dot == NULL) || (dirent->d_name[0] == '.') ||
+        (strcmp(dot, ".conf") != 0))
+    {
+      continue;
+    }
+    string cfg_filename = cfg_dir + "/" + dirent->d_name;
+    if (!cfg.open(cfg_filename))
+    {
+      cerr << "*** ERROR: Could not open configuration file: "
+           << cfg_filename << endl;
+      success = false;
+    }
+  }
+
+  if (closedir(dir) == -1)
+  {
+    cerr << "*** ERROR: Error closing directory specified by"
+         << "configuration variable GLOBAL/CFG_DIR=" << cfg_dir << endl;
+    return false;
+  }
+  cfg.addDependency(cfg_dir);
+
+  return success;
+} /* read_cfg_dir */
+
+
+static void reload_config(void)
+{
+  if (running_cfg == 0)
+  {
+    return;
+  }
+
+    // Read the whole configuration into a new object first so that a broken
+    // file does not leave the running configuration half updated
+  Config new_cfg;
+  if (!new_cfg.open(main_cfg_filename) ||
+      !read_cfg_dir(new_cfg, main_cfg_filename))
+  {
+    cerr << "*** WARNING: Could not reload the configuration from "
+         << main_cfg_filename << ". Keeping the running configuration."
+         << endl;
+    return;
+  }
+  unsigned changes = running_cfg->update(new_cfg);
+  cout << "Configuration reloaded from " << main_cfg_filename << ": "
+       << changes << " variable(s) changed" << endl;
+
+  if ((config_cache != NULL) && (changes > 0) &&
+      !running_cfg->saveSnapshot(config_cache))
+  {
+    cerr << "*** WARNING: Could not write the configuration cache file "
+         << config_cache << ": " << strerror(errno) << endl;
+  }
+} /* reload_config */
+
+
+static void setup_realtime(Config &cfg)
+{
+  bool realtime = false;
+  cfg.getValue("GLOBAL", "REALTIME", realtime);
+  if (!realtime)
   {
-    cout << "Ignoring SIGHUP\n";
     return;
   }
-  logfile_reopen("SIGHUP received");
+
+  Realtime& rt = Realtime::instance();
+  string value;
+  if (cfg.getValue("GLOBAL", "REALTIME_POLICY", value) &&
+      !rt.setPolicy(value))
+  {
+    cerr << "*** ERROR: Illegal value for config variable "
+            "GLOBAL/REALTIME_POLICY=" << value
+         << ". Valid values are FIFO and RR.\n";
+    exit(1);
+  }
+  int prio = Realtime::DEFAULT_PRIORITY;
+  cfg.getValue("GLOBAL", "REALTIME_PRIO", prio);
+  rt.setPriority(prio);
+  if (cfg.getValue("GLOBAL", "REALTIME_CPU_AFFINITY", value) &&
+      !rt.setCpuAffinity(value))
+  {
+    cerr << "*** ERROR: Illegal value for config variable "
+            "GLOBAL/REALTIME_CPU_AFFINITY=" << value << ".\n";
+    exit(1);
+  }
+  bool lock_memory = true;
+  cfg.getValue("GLOBAL", "REALTIME_LOCK_MEMORY", lock_memory);
+  rt.setLockMemory(lock_memory);
+  size_t prefault_kb = 4096;
+  cfg.getValue("GLOBAL", "REALTIME_PREFAULT_HEAP", prefault_kb);
+  rt.setPrefaultSize(prefault_kb * 1024);
+  unsigned watchdog_period = 1000;
+  cfg.getValue("GLOBAL", "REALTIME_WATCHDOG_PERIOD", watchdog_period);
+  unsigned watchdog_load = 90;
+  cfg.getValue("GLOBAL", "REALTIME_WATCHDOG_LOAD", watchdog_load);
+  rt.setWatchdog(watchdog_period, watchdog_load);
+
+  cout << "--- Entering realtime mode\n";
+  rt.enable();
+} /* setup_realtime */
+
+
+static void sighup_handler(int signal)
+{
+  if (logfile_name != 0)
+  {
+    logfile_reopen("SIGHUP received");
+  }
+  else
+  {
+    cout << "SIGHUP received" << endl;
+  }
+  reload_config();
 } /* sighup_handler */
 
 
@@ -8,7 +8,7 @@ This file contains a class that handle local digital drop receivers.
 
 \verbatim
 SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
-Copyright (C) 2004-2018 Tobias Blomberg / SM0SVX
+Copyright (C) 2004-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -38,6 +38,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <stdio.h>
 #include <stdlib.h>
 #include <arpa/inet.h>
+#include <semaphore.h>
+#include <errno.h>
 #include <sigc++/sigc++.h>
 
 #include <cstring>
@@ -45,11 +47,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 #include <string>
 #include <vector>
+#include <map>
 #include <complex>
 #include <fstream>
 #include <algorithm>
 #include <iterator>
 #include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <system_error>
 
 
 /****************************************************************************
@@ -60,6 +67,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncConfig.h>
 #include <AsyncAudioSource.h>
+#include <AsyncAudioSink.h>
+#include <AsyncAudioThreadFifo.h>
+#include <AsyncAudioPolyphase.h>
+#include <AsyncAudioKernels.h>
 #include <AsyncTcpClient.h>
 
 
@@ -72,6 +83,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Ddr.h"
 #include "WbRxRtlSdr.h"
 #include "DdrFilterCoeffs.h"
+#include "DdrChannelBank.h"
 
 
 /****************************************************************************
@@ -105,84 +117,46 @@ namespace {
   class Decimator
   {
     public:
-      Decimator(void) : dec_fact(0), p_Z(0), taps(0) {}
+      Decimator(void) {}
 
       Decimator(int dec_fact, const float *coeff, int taps)
-        : dec_fact(dec_fact), p_Z(0), taps(taps)
       {
         setDecimatorParams(dec_fact, coeff, taps);
       }
 
-      ~Decimator(void)
-      {
-        delete [] p_Z;
-      }
-
-      int decFact(void) const { return dec_fact; }
+      int decFact(void) const { return dec.factor(); }
 
       void setDecimatorParams(int dec_fact, const float *coeff, int taps)
       {
         assert(taps >= dec_fact);
 
         set_coeff.assign(coeff, coeff + taps);
-        this->dec_fact = dec_fact;
-        this->coeff = set_coeff;
-        this->taps = taps;
-
-        delete [] p_Z;
-        p_Z = new T[taps]();
+        dec.setFilter(dec_fact, coeff, taps);
       }
 
       void setGain(double gain_adjust)
       {
-        coeff = set_coeff;
-        for (vector<float>::iterator it=coeff.begin(); it!=coeff.end(); ++it)
-        {
-          *it *= pow(10.0, gain_adjust / 20.0);
-        }
+        dec.setCoefficients(&set_coeff[0], pow(10.0, gain_adjust / 20.0));
       }
 
       void decimate(vector<T> &out, const vector<T> &in)
       {
-        int orig_count = in.size();
-
           // this implementation assumes in.size() is a multiple of factor_M
-        assert(in.size() % dec_fact == 0);
+        assert(in.size() % dec.factor() == 0);
 
-        int num_out = 0;
-        typename vector<T>::const_iterator src = in.begin();
-        out.clear();
-        out.reserve(in.size() / dec_fact);
-        while (src != in.end())
+        out.resize(in.size() / dec.factor());
+        if (in.empty())
         {
-            // shift Z delay line up to make room for next samples
-          memmove(p_Z + dec_fact, p_Z, (taps - dec_fact) * sizeof(T));
-
-            // copy next samples from input buffer to bottom of Z delay line
-          for (int tap = dec_fact - 1; tap >= 0; tap--)
-          {
-            assert(src != in.end());
-            p_Z[tap] = *src++;
-          }
-
-            // calculate FIR sum
-          T sum(0);
-          for (int tap = 0; tap < taps; tap++)
-          {
-            sum += coeff[tap] * p_Z[tap];
-          }
-          out.push_back(sum);     /* store sum */
-          num_out++;
+          return;
         }
-        assert(num_out == orig_count / dec_fact);
+        int num_out = dec.decimate(&out[0], &in[0], in.size());
+        assert(num_out == static_cast<int>(out.size()));
+        (void)num_out;
       }
 
     private:
-      int             dec_fact;
-      T               *p_Z;
-      int             taps;
-      vector<float>   set_coeff;
-      vector<float>   coeff;
+      AudioPolyphaseDecimator<T>  dec;
+      vector<float>               set_coeff;
   };
 
   template <class T>
@@ -244,13 +218,13 @@ namespace {
       virtual int decFact(void) const { return d1.decFact() * d2.decFact(); }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1;
         d1.decimate(dec_samp1, in);
         d2.decimate(out, dec_samp1);
       }
 
     private:
       Decimator<T> &d1, &d2;
+      vector<T> dec_samp1;
   };
 
   template <class T>
@@ -266,7 +240,6 @@ namespace {
       }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1, dec_samp2;
         d1.decimate(dec_samp1, in);
         d2.decimate(dec_samp2, dec_samp1);
         d3.decimate(out, dec_samp2);
@@ -274,6 +247,7 @@ namespace {
 
     private:
       Decimator<T> &d1, &d2, &d3;
+      vector<T> dec_samp1, dec_samp2;
   };
 
   template <class T>
@@ -290,7 +264,6 @@ namespace {
       }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1, dec_samp2, dec_samp3;
         d1.decimate(dec_samp1, in);
         d2.decimate(dec_samp2, dec_samp1);
         d3.decimate(dec_samp3, dec_samp2);
@@ -299,6 +272,7 @@ namespace {
 
     private:
       Decimator<T> &d1, &d2, &d3, &d4;
+      vector<T> dec_samp1, dec_samp2, dec_samp3;
   };
 
   template <class T>
@@ -316,7 +290,6 @@ namespace {
       }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1, dec_samp2, dec_samp3, dec_samp4;
         d1.decimate(dec_samp1, in);
         d2.decimate(dec_samp2, dec_samp1);
         d3.decimate(dec_samp3, dec_samp2);
@@ -326,6 +299,7 @@ namespace {
 
     private:
       Decimator<T> &d1, &d2, &d3, &d4, &d5;
+      vector<T> dec_samp1, dec_samp2, dec_samp3, dec_samp4;
   };
 
 
@@ -333,41 +307,69 @@ namespace {
   {
     public:
       Translate(unsigned samp_rate, int offset)
-        : samp_rate(samp_rate), n(0)
+        : samp_rate(samp_rate), offset(0), exp_lut(0), n(0),
+          lut_cache_size(0)
       {
         setOffset(offset);
       }
 
-      void setOffset(int offset)
+      void setOffset(int new_offset)
       {
+        if (new_offset == offset)
+        {
+          return;
+        }
+        offset = new_offset;
         n = 0;
-        exp_lut.clear();
+        exp_lut = 0;
         if (offset == 0)
         {
           return;
         }
-        unsigned N = samp_rate / gcd(samp_rate, abs(offset));
-        //cout << "### Translate: offset=" << offset << " N=" << N << endl;
-        exp_lut.resize(N);
-        for (unsigned i=0; i<N; ++i)
+
+          // The lookup tables are kept so that switching back to an offset
+          // that has been used before, like when scanning, is cheap
+        LutCache::iterator it = lut_cache.find(offset);
+        if (it == lut_cache.end())
         {
-          complex<float> e(0.0f, -2.0*M_PI*offset*i/samp_rate);
-          exp_lut[i] = exp(e);
+          unsigned N = samp_rate / gcd(samp_rate, abs(offset));
+          //cout << "### Translate: offset=" << offset << " N=" << N << endl;
+          if (lut_cache_size + N > MAX_LUT_CACHE_SIZE)
+          {
+            lut_cache.clear();
+            lut_cache_size = 0;
+          }
+          it = lut_cache.insert(make_pair(offset, Lut(N))).first;
+          Lut &lut = it->second;
+          for (unsigned i=0; i<N; ++i)
+          {
+            complex<float> e(0.0f, -2.0*M_PI*offset*i/samp_rate);
+            lut[i] = exp(e);
+          }
+          lut_cache_size += N;
         }
+        exp_lut = &it->second;
       }
 
+      bool hasOffset(void) const { return exp_lut != 0; }
+
       void iq_received(vector<WbRxRtlSdr::Sample> &out,
                        const vector<WbRxRtlSdr::Sample> &in)
       {
-        if (exp_lut.size() > 0)
+        if (exp_lut != 0)
         {
-          out.clear();
-          out.reserve(in.size());
-          vector<WbRxRtlSdr::Sample>::const_iterator it;
-          for (it = in.begin(); it != in.end(); ++it)
+            // Mix with the oscillator in blocks that end where the lookup
+            // table wraps around
+          const Lut &lut = *exp_lut;
+          out.resize(in.size());
+          size_t pos = 0;
+          while (pos < in.size())
           {
-            out.push_back(*it * exp_lut[n]);
-            if (++n == exp_lut.size())
+            size_t chunk = min(in.size() - pos, lut.size() - n);
+            audioKernelComplexMultiply(&out[pos], &in[pos], &lut[n], chunk);
+            pos += chunk;
+            n += chunk;
+            if (n == lut.size())
             {
               n = 0;
             }
@@ -380,9 +382,21 @@ namespace {
       }
 
     private:
-      unsigned samp_rate;
-      vector<complex<float> > exp_lut;
-      unsigned n;
+      typedef vector<complex<float> > Lut;
+      typedef map<int, Lut>           LutCache;
+
+        // The maximum total number of samples in the cached lookup tables
+      static const size_t MAX_LUT_CACHE_SIZE = 262144;
+
+      unsigned    samp_rate;
+      int         offset;
+      const Lut   *exp_lut;
+      unsigned    n;
+      LutCache    lut_cache;
+      size_t      lut_cache_size;
+
+      Translate(const Translate&);
+      Translate& operator=(const Translate&);
 
       /**
        * @brief Find the greatest common divisor for two numbers
@@ -473,7 +487,7 @@ namespace {
     public:
       virtual ~Demodulator(void) {}
 
-      virtual void iq_received(vector<WbRxRtlSdr::Sample> samples) = 0;
+      virtual void iq_received(const vector<WbRxRtlSdr::Sample> &samples) = 0;
 
       /**
        * @brief Resume audio output to the sink
@@ -504,46 +518,47 @@ namespace {
     public:
       DemodulatorFm(unsigned samp_rate, double max_dev)
         : iold(1.0f), qold(1.0f),
+          audio_dec_160k(5, coeff_dec_160k_32k, coeff_dec_160k_32k_cnt),
+          audio_dec_192k(6, coeff_dec_192k_32k, coeff_dec_192k_32k_cnt),
           audio_dec(2, coeff_dec_audio_32k_16k, coeff_dec_audio_32k_16k_cnt),
-          dec(0)
+          dec_16k(), dec_32k(audio_dec), dec_160k(audio_dec_160k, audio_dec),
+          dec_192k(audio_dec_192k, audio_dec), dec(0), cur_samp_rate(0),
+          cur_max_dev(0.0)
       {
         setDemodParams(samp_rate, max_dev);
       }
 
-      ~DemodulatorFm(void)
-      {
-        delete dec;
-        dec = 0;
-      }
-
       void setDemodParams(unsigned samp_rate, double max_dev)
       {
-        delete dec;
-        dec = 0;
+        if ((samp_rate == cur_samp_rate) && (max_dev == cur_max_dev))
+        {
+          return;
+        }
 
+          // All decimator chains are set up in the constructor so that
+          // switching between them do not allocate anything
+        dec = 0;
         if (samp_rate == 16000)
         {
-          dec = new DecimatorMS0<float>;
+          dec = &dec_16k;
         }
         else if (samp_rate == 32000)
         {
-          dec = new DecimatorMS1<float>(audio_dec);
+          dec = &dec_32k;
         }
         else if (samp_rate == 160000)
         {
-          audio_dec_wb.setDecimatorParams(5, coeff_dec_160k_32k, 
-                                          coeff_dec_160k_32k_cnt);
-          dec = new DecimatorMS2<float>(audio_dec_wb, audio_dec);
+          dec = &dec_160k;
         }
         else if (samp_rate == 192000)
         {
-          audio_dec_wb.setDecimatorParams(6, coeff_dec_192k_32k, 
-                                          coeff_dec_192k_32k_cnt);
-          dec = new DecimatorMS2<float>(audio_dec_wb, audio_dec);
+          dec = &dec_192k;
         }
 
         assert((dec != 0) &&
                "DemodulatorFm::setDemodParams: Unsupported sampling rate");
+        cur_samp_rate = samp_rate;
+        cur_max_dev = max_dev;
 
           // Adjust the gain so that the maximum deviation corresponds
           // to a peak audio amplitude of 1.0, minus headroom.
@@ -553,7 +568,7 @@ namespace {
         dec->setGain(adj_db);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
           // From article-sdr-is-qs.pdf: Watch your Is and Qs:
           //   FM = (Qn.In-1 - In.Qn-1)/(In.In-1 + Qn.Qn-1)
@@ -561,7 +576,7 @@ namespace {
           // A more indepth report:
           //   Implementation of FM demodulator algorithms on a
           //   high performance digital signal processor
-        vector<float> audio;
+        audio.clear();
         for (size_t idx=0; idx<samples.size(); ++idx)
         {
           complex<float> samp = samples[idx];
@@ -578,17 +593,27 @@ namespace {
 
           audio.push_back(demod);
         }
-        vector<float> dec_audio;
         dec->decimate(dec_audio, audio);
         sinkWriteSamples(&dec_audio[0], dec_audio.size());
       }
 
     private:
+        // The sample buffers are kept between calls to not allocate memory
+        // for every block of samples
+      vector<float> audio;
+      vector<float> dec_audio;
       float iold;
       float qold;
-      Decimator<float> audio_dec_wb;
+      Decimator<float> audio_dec_160k;
+      Decimator<float> audio_dec_192k;
       Decimator<float> audio_dec;
+      DecimatorMS0<float> dec_16k;
+      DecimatorMS1<float> dec_32k;
+      DecimatorMS2<float> dec_160k;
+      DecimatorMS2<float> dec_192k;
       DecimatorMS<float> *dec;
+      unsigned cur_samp_rate;
+      double cur_max_dev;
   };
 
 
@@ -602,12 +627,11 @@ namespace {
         agc.setReference(1);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<WbRxRtlSdr::Sample> gain_adjusted;
         agc.iq_received(gain_adjusted, samples);
 
-        vector<float> audio;
+        audio.clear();
         for (size_t idx=0; idx<gain_adjusted.size(); ++idx)
         {
           complex<float> samp = gain_adjusted[idx];
@@ -618,7 +642,9 @@ namespace {
       }
 
     private:
-      AGC              agc;
+      AGC                         agc;
+      vector<WbRxRtlSdr::Sample>  gain_adjusted;
+      vector<float>               audio;
   };
 
 
@@ -639,7 +665,7 @@ namespace {
         use_lsb = use;
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
         vector<float> Q, Qh, audio;
         Q.reserve(samples.size());
@@ -690,15 +716,12 @@ namespace {
         trans.setOffset(lsb ? 2000 : -2000);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<WbRxRtlSdr::Sample> gain_adjusted;
         agc.iq_received(gain_adjusted, samples);
-
-        vector<WbRxRtlSdr::Sample> translated;
         trans.iq_received(translated, gain_adjusted);
 
-        vector<float> audio;
+        audio.clear();
         audio.reserve(gain_adjusted.size());
         for (vector<WbRxRtlSdr::Sample>::const_iterator it = translated.begin();
              it != translated.end();
@@ -711,8 +734,11 @@ namespace {
       }
 
     private:
-      Translate         trans;
-      AGC               agc;
+      Translate                   trans;
+      AGC                         agc;
+      vector<WbRxRtlSdr::Sample>  gain_adjusted;
+      vector<WbRxRtlSdr::Sample>  translated;
+      vector<float>               audio;
   };
 #endif
 
@@ -728,14 +754,12 @@ namespace {
         agc.setReference(0.05);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<WbRxRtlSdr::Sample> gain_adjusted;
         agc.iq_received(gain_adjusted, samples);
-
-        vector<WbRxRtlSdr::Sample> translated;
         trans.iq_received(translated, gain_adjusted);
-        vector<float> audio;
+
+        audio.clear();
         audio.reserve(translated.size());
         for (vector<WbRxRtlSdr::Sample>::const_iterator it = translated.begin();
              it != translated.end();
@@ -748,8 +772,11 @@ namespace {
       }
 
     private:
-      Translate         trans;
-      AGC               agc;
+      Translate                   trans;
+      AGC                         agc;
+      vector<WbRxRtlSdr::Sample>  gain_adjusted;
+      vector<WbRxRtlSdr::Sample>  translated;
+      vector<float>               audio;
   };
 
 
@@ -758,16 +785,50 @@ namespace {
     public:
       typedef enum
       {
-        BW_WIDE, BW_20K, BW_10K, BW_6K, BW_3K, BW_500
+        BW_WIDE, BW_20K, BW_10K, BW_6K, BW_3K, BW_500, BW_CNT
       } Bandwidth;
 
-      virtual ~Channelizer(void) {}
-      virtual void setBw(Bandwidth bw) = 0;
+      Channelizer(void) : dec(0)
+      {
+        std::fill_n(decs, static_cast<int>(BW_CNT),
+                    static_cast<DecimatorMS<complex<float> >*>(0));
+      }
+
+      virtual ~Channelizer(void)
+      {
+        for (int bw=0; bw<BW_CNT; ++bw)
+        {
+          delete decs[bw];
+        }
+      }
+
+        // The decimator chains for all bandwidths are created up front by
+        // the inheriting class so that a bandwidth switch do not allocate
+      void setBw(Bandwidth bw)
+      {
+        assert((bw >= 0) && (bw < BW_CNT) && (decs[bw] != 0) &&
+               "Channelizer::setBw: Unsupported bandwidth");
+        dec = decs[bw];
+      }
+
       virtual unsigned chSampRate(void) const = 0;
-      virtual void iq_received(vector<WbRxRtlSdr::Sample> &out,
-                               const vector<WbRxRtlSdr::Sample> &in) = 0;
+
+      void iq_received(vector<WbRxRtlSdr::Sample> &out,
+                       const vector<WbRxRtlSdr::Sample> &in)
+      {
+        dec->decimate(out, in);
+        preDemod(out);
+      }
 
       sigc::signal<void, const std::vector<RtlTcp::Sample>&> preDemod;
+
+    protected:
+      DecimatorMS<complex<float> >  *decs[BW_CNT];
+      DecimatorMS<complex<float> >  *dec;
+
+    private:
+      Channelizer(const Channelizer&);
+      Channelizer& operator=(const Channelizer&);
   };
 
   class Channelizer960 : public Channelizer
@@ -783,72 +844,37 @@ namespace {
           ch_filt_narr( 1, coeff_12k5_channel,  coeff_12k5_channel_cnt ),
           ch_filt_6k(   1, coeff_nbam_channel,  coeff_nbam_channel_cnt ),
           ch_filt_3k(   1, coeff_ssb_channel,   coeff_ssb_channel_cnt  ),
-          ch_filt_500(  1, coeff_cw_channel,    coeff_cw_channel_cnt   ),
-          dec(0)
+          ch_filt_500(  1, coeff_cw_channel,    coeff_cw_channel_cnt   )
       {
+        decs[BW_WIDE] = new DecimatorMS1<complex<float> >(dec_960k_192k);
+        decs[BW_20K] = new DecimatorMS4<complex<float> >(dec_960k_192k,
+                                                         dec_192k_64k,
+                                                         dec_64k_32k,
+                                                         ch_filt);
+        decs[BW_10K] = new DecimatorMS4<complex<float> >(dec_960k_192k,
+                                                         dec_192k_48k,
+                                                         dec_48k_16k,
+                                                         ch_filt_narr);
+        decs[BW_6K] = new DecimatorMS4<complex<float> >(dec_960k_192k,
+                                                        dec_192k_48k,
+                                                        dec_48k_16k,
+                                                        ch_filt_6k);
+        decs[BW_3K] = new DecimatorMS4<complex<float> >(dec_960k_192k,
+                                                        dec_192k_48k,
+                                                        dec_48k_16k,
+                                                        ch_filt_3k);
+        decs[BW_500] = new DecimatorMS4<complex<float> >(dec_960k_192k,
+                                                         dec_192k_48k,
+                                                         dec_48k_16k,
+                                                         ch_filt_500);
         setBw(BW_20K);
       }
-      virtual ~Channelizer960(void)
-      {
-        delete dec;
-        dec = 0;
-      }
-
-      virtual void setBw(Bandwidth bw)
-      {
-        delete dec;
-        dec = 0;
-        switch (bw)
-        {
-          case BW_WIDE:
-            dec = new DecimatorMS1<complex<float> >(dec_960k_192k);
-            return;
-          case BW_20K:
-            dec = new DecimatorMS4<complex<float> >(dec_960k_192k,
-                                                    dec_192k_64k,
-                                                    dec_64k_32k, 
-                                                    ch_filt);
-            return;
-          case BW_10K:
-            dec = new DecimatorMS4<complex<float> >(dec_960k_192k,
-                                                    dec_192k_48k,
-                                                    dec_48k_16k,
-                                                    ch_filt_narr);
-            return;
-          case BW_6K:
-            dec = new DecimatorMS4<complex<float> >(dec_960k_192k,
-                                                    dec_192k_48k,
-                                                    dec_48k_16k,
-                                                    ch_filt_6k);
-            return;
-          case BW_3K:
-            dec = new DecimatorMS4<complex<float> >(dec_960k_192k,
-                                                    dec_192k_48k,
-                                                    dec_48k_16k,
-                                                    ch_filt_3k);
-            return;
-          case BW_500:
-            dec = new DecimatorMS4<complex<float> >(dec_960k_192k,
-                                                    dec_192k_48k,
-                                                    dec_48k_16k,
-                                                    ch_filt_500);
-            return;
-        }
-        assert(!"Channelizer::setBw: Unknown bandwidth");
-      }
 
       virtual unsigned chSampRate(void) const
       {
         return 960000 / dec->decFact();
       }
 
-      virtual void iq_received(vector<WbRxRtlSdr::Sample> &out,
-                               const vector<WbRxRtlSdr::Sample> &in)
-      {
-        dec->decimate(out, in);
-        preDemod(out);
-      }
-
     private:
       Decimator<complex<float> >    dec_960k_192k;
       Decimator<complex<float> >    dec_192k_64k;
@@ -860,7 +886,6 @@ namespace {
       Decimator<complex<float> >    ch_filt_6k;
       Decimator<complex<float> >    ch_filt_3k;
       Decimator<complex<float> >    ch_filt_500;
-      DecimatorMS<complex<float> >  *dec;
   };
 
   class Channelizer2400 : public Channelizer
@@ -875,89 +900,134 @@ namespace {
           ch_filt_narr  (1, coeff_12k5_channel,   coeff_12k5_channel_cnt  ),
           ch_filt_6k    (1, coeff_nbam_channel,   coeff_nbam_channel_cnt  ),
           ch_filt_3k    (1, coeff_ssb_channel,    coeff_ssb_channel_cnt   ),
-          ch_filt_500   (1, coeff_cw_channel,     coeff_cw_channel_cnt    ),
-          dec(0)
+          ch_filt_500   (1, coeff_cw_channel,     coeff_cw_channel_cnt    )
       {
+        decs[BW_WIDE] = new DecimatorMS2<complex<float> >(dec_2400k_800k,
+                                                          dec_800k_160k);
+        decs[BW_20K] = new DecimatorMS4<complex<float> >(dec_2400k_800k,
+                                                         dec_800k_160k,
+                                                         dec_160k_32k,
+                                                         ch_filt);
+        decs[BW_10K] = new DecimatorMS5<complex<float> >(dec_2400k_800k,
+                                                         dec_800k_160k,
+                                                         dec_160k_32k,
+                                                         dec_32k_16k,
+                                                         ch_filt_narr);
+        decs[BW_6K] = new DecimatorMS5<complex<float> >(dec_2400k_800k,
+                                                        dec_800k_160k,
+                                                        dec_160k_32k,
+                                                        dec_32k_16k,
+                                                        ch_filt_6k);
+        decs[BW_3K] = new DecimatorMS5<complex<float> >(dec_2400k_800k,
+                                                        dec_800k_160k,
+                                                        dec_160k_32k,
+                                                        dec_32k_16k,
+                                                        ch_filt_3k);
+        decs[BW_500] = new DecimatorMS5<complex<float> >(dec_2400k_800k,
+                                                         dec_800k_160k,
+                                                         dec_160k_32k,
+                                                         dec_32k_16k,
+                                                         ch_filt_500);
         setBw(BW_20K);
       }
-      virtual ~Channelizer2400(void)
-      {
-        delete dec;
-        dec = 0;
-      }
 
-      virtual void setBw(Bandwidth bw)
+      virtual unsigned chSampRate(void) const
       {
-        delete dec;
-        dec = 0;
-
-        switch (bw)
-        {
-          case BW_WIDE:
-            dec = new DecimatorMS2<complex<float> >(dec_2400k_800k,
-                                                    dec_800k_160k);
-            return;
-          case BW_20K:
-            dec = new DecimatorMS4<complex<float> >(dec_2400k_800k,
-                                                    dec_800k_160k,
-                                                    dec_160k_32k, 
-                                                    ch_filt);
-            return;
-          case BW_10K:
-            dec = new DecimatorMS5<complex<float> >(dec_2400k_800k,
-                                                    dec_800k_160k,
-                                                    dec_160k_32k, 
-                                                    dec_32k_16k,
-                                                    ch_filt_narr);
-            return;
-          case BW_6K:
-            dec = new DecimatorMS5<complex<float> >(dec_2400k_800k,
-                                                    dec_800k_160k,
-                                                    dec_160k_32k, 
-                                                    dec_32k_16k,
-                                                    ch_filt_6k);
-            return;
-          case BW_3K:
-            dec = new DecimatorMS5<complex<float> >(dec_2400k_800k,
-                                                    dec_800k_160k,
-                                                    dec_160k_32k,
-                                                    dec_32k_16k,
-                                                    ch_filt_3k);
-            return;
-          case BW_500:
-            dec = new DecimatorMS5<complex<float> >(dec_2400k_800k,
-                                                    dec_800k_160k,
-                                                    dec_160k_32k,
-                                                    dec_32k_16k,
-                                                    ch_filt_500);
-            return;
-        }
-        assert(!"Channelizer::setBw: Unknown bandwidth");
+        return 2400000 / dec->decFact();
       }
 
-      virtual unsigned chSampRate(void) const
+    private:
+      Decimator<complex<float> >    dec_2400k_800k;
+      Decimator<complex<float> >    dec_800k_160k;
+      Decimator<complex<float> >    dec_160k_32k;
+      Decimator<complex<float> >    dec_32k_16k;
+      Decimator<complex<float> >    ch_filt;
+      Decimator<complex<float> >    ch_filt_narr;
+      Decimator<complex<float> >    ch_filt_6k;
+      Decimator<complex<float> >    ch_filt_3k;
+      Decimator<complex<float> >    ch_filt_500;
+  };
+
+  class ChannelizerBank : public Channelizer
+  {
+    public:
+      ChannelizerBank(unsigned samp_rate)
+        : samp_rate(samp_rate),
+          dec_32k_16k   (2, coeff_dec_32k_16k,    coeff_dec_32k_16k_cnt   ),
+          ch_filt       (1, coeff_25k_channel,    coeff_25k_channel_cnt   ),
+          ch_filt_narr  (1, coeff_12k5_channel,   coeff_12k5_channel_cnt  ),
+          ch_filt_6k    (1, coeff_nbam_channel,   coeff_nbam_channel_cnt  ),
+          ch_filt_3k    (1, coeff_ssb_channel,    coeff_ssb_channel_cnt   ),
+          ch_filt_500   (1, coeff_cw_channel,     coeff_cw_channel_cnt    )
       {
-        return 2400000 / dec->decFact();
+          // There are no precalculated coefficients for the first stage
+          // since it depend on the bin sample rate of the channel bank
+        const unsigned fact = samp_rate / 32000;
+        vector<float> coeff;
+        DdrChannelBank::designLowpass(coeff, 21 * fact + 2,
+                                      16000.0 / samp_rate, 70.0);
+        dec_bin_32k.setDecimatorParams(fact, &coeff[0], coeff.size());
+
+          // The wideband mode is not supported by the channel bank
+        decs[BW_20K] = new DecimatorMS2<complex<float> >(dec_bin_32k, ch_filt);
+        decs[BW_10K] = new DecimatorMS3<complex<float> >(dec_bin_32k,
+                                                         dec_32k_16k,
+                                                         ch_filt_narr);
+        decs[BW_6K] = new DecimatorMS3<complex<float> >(dec_bin_32k,
+                                                        dec_32k_16k,
+                                                        ch_filt_6k);
+        decs[BW_3K] = new DecimatorMS3<complex<float> >(dec_bin_32k,
+                                                        dec_32k_16k,
+                                                        ch_filt_3k);
+        decs[BW_500] = new DecimatorMS3<complex<float> >(dec_bin_32k,
+                                                         dec_32k_16k,
+                                                         ch_filt_500);
+        setBw(BW_20K);
       }
 
-      virtual void iq_received(vector<WbRxRtlSdr::Sample> &out,
-                               const vector<WbRxRtlSdr::Sample> &in)
+      virtual unsigned chSampRate(void) const
       {
-        dec->decimate(out, in);
-        preDemod(out);
+        return samp_rate / dec->decFact();
       }
 
     private:
-      Decimator<complex<float> >    dec_2400k_800k;
-      Decimator<complex<float> >    dec_800k_160k;
-      Decimator<complex<float> >    dec_160k_32k;
+      unsigned                      samp_rate;
+      Decimator<complex<float> >    dec_bin_32k;
       Decimator<complex<float> >    dec_32k_16k;
       Decimator<complex<float> >    ch_filt;
       Decimator<complex<float> >    ch_filt_narr;
       Decimator<complex<float> >    ch_filt_6k;
       Decimator<complex<float> >    ch_filt_3k;
       Decimator<complex<float> >    ch_filt_500;
-      DecimatorMS<complex<float> >  *dec;
+  };
+
+  /*
+   * Receive I/Q samples that have been passed through an AudioThreadFifo
+   * as interleaved floats. The FIFO size and all writes to it are even so
+   * the I/Q pairs are never split up.
+   */
+  class IqSink : public Async::AudioSink
+  {
+    public:
+      virtual int writeSamples(const float *samples, int count)
+      {
+        assert(count % 2 == 0);
+        iq.assign(reinterpret_cast<const WbRxRtlSdr::Sample*>(samples),
+                  reinterpret_cast<const WbRxRtlSdr::Sample*>(samples) +
+                  count / 2);
+        iqReceived(iq);
+        return count;
+      }
+
+      virtual void flushSamples(void)
+      {
+        sourceAllSamplesFlushed();
+      }
+
+      sigc::signal<void, const std::vector<WbRxRtlSdr::Sample>&> iqReceived;
+
+    private:
+      vector<WbRxRtlSdr::Sample> iq;
   };
 
 }; /* anonymous namespace */
@@ -966,28 +1036,44 @@ namespace {
 class Ddr::Channel : public sigc::trackable, public Async::AudioSource
 {
   public:
-    Channel(int fq_offset, unsigned sample_rate)
-      : sample_rate(sample_rate), channelizer(0),
+    Channel(int fq_offset, unsigned sample_rate, bool threaded,
+            DdrChannelBank *bank)
+      : sample_rate(sample_rate), channelizer(0), wb_channelizer(0),
+        bank_channelizer(0),
         fm_demod(32000, 5000.0), ssb_demod(16000), cw_demod(16000), demod(0),
         trans(sample_rate, fq_offset), enabled(true), ch_offset(0),
-        fq_offset(fq_offset)
+        fq_offset(fq_offset), bank(bank),
+        bank_trans(bank != 0 ? bank->outputSampleRate() : 1, 0), bin(0),
+        threaded(threaded), audio_fifo(0), iq_fifo(0),
+        iq_head(0), iq_tail(0), iq_overruns(0), stop_worker(false)
     {
+      sem_init(&iq_sem, 0, 0);
     }
 
     ~Channel(void)
     {
-      delete channelizer;
+      stopWorker();
+      clearHandler();
+      if ((audio_fifo != 0) && (demod != 0))
+      {
+        demod->unregisterSink();
+      }
+      delete audio_fifo;
+      delete iq_fifo;
+      delete wb_channelizer;
+      delete bank_channelizer;
+      sem_destroy(&iq_sem);
     }
 
     bool initialize(void)
     {
       if (sample_rate == 2400000)
       {
-        channelizer = new Channelizer2400;
+        wb_channelizer = new Channelizer2400;
       }
       else if (sample_rate == 960000)
       {
-        channelizer = new Channelizer960;
+        wb_channelizer = new Channelizer960;
       }
       else
       {
@@ -995,51 +1081,93 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
              << ". Legal values are: 960000 and 2400000\n";
         return false;
       }
+      channelizer = wb_channelizer;
+
+      if (bank != 0)
+      {
+        bank_channelizer = new ChannelizerBank(bank->outputSampleRate());
+        bank_channelizer->preDemod.connect(preDemod.make_slot());
+      }
+
+      if (threaded)
+      {
+          // The demodulated audio and the channelized I/Q samples are handed
+          // back to the main loop through lock free FIFOs. The I/Q samples
+          // are written as interleaved floats.
+        audio_fifo = new AudioThreadFifo(AUDIO_FIFO_SIZE);
+        setHandler(audio_fifo);
+        iq_fifo = new AudioThreadFifo(IQ_FIFO_SIZE);
+        iq_fifo->registerSink(&iq_sink);
+        iq_sink.iqReceived.connect(preDemod.make_slot());
+        wb_channelizer->preDemod.connect(
+            mem_fun(*this, &Channel::writePreDemodSamples));
+      }
+      else
+      {
+        wb_channelizer->preDemod.connect(preDemod.make_slot());
+      }
+
       setModulation(Modulation::MOD_FM);
-      channelizer->preDemod.connect(preDemod.make_slot());
+
+      if (threaded)
+      {
+        try
+        {
+          worker = std::thread(&Channel::workerFunc, this);
+        }
+        catch (const std::system_error &e)
+        {
+          cerr << "*** ERROR: Could not start DDR channel thread: "
+               << e.what() << endl;
+          return false;
+        }
+      }
       return true;
     }
 
     void setFqOffset(int fq_offset)
     {
+      std::lock_guard<std::mutex> lock(proc_mutex);
       this->fq_offset = fq_offset;
-      trans.setOffset(fq_offset - ch_offset);
+      updateOffset();
     }
 
     void setModulation(Modulation::Type mod)
     {
+      std::lock_guard<std::mutex> lock(proc_mutex);
+      Demodulator *prev_demod = demod;
       demod = 0;
       ch_offset = 0;
       switch (mod)
       {
         case Modulation::MOD_FM:
-          channelizer->setBw(Channelizer::BW_20K);
+          selectChannelizer(Channelizer::BW_20K);
           fm_demod.setDemodParams(channelizer->chSampRate(), 5000);
           demod = &fm_demod;
           break;
         case Modulation::MOD_NBFM:
-          channelizer->setBw(Channelizer::BW_10K);
+          selectChannelizer(Channelizer::BW_10K);
           fm_demod.setDemodParams(channelizer->chSampRate(), 2500);
           demod = &fm_demod;
           break;
         case Modulation::MOD_WBFM:
-          channelizer->setBw(Channelizer::BW_WIDE);
+          selectChannelizer(Channelizer::BW_WIDE);
           fm_demod.setDemodParams(channelizer->chSampRate(), 75000);
           demod = &fm_demod;
           break;
         case Modulation::MOD_AM:
-          channelizer->setBw(Channelizer::BW_10K);
+          selectChannelizer(Channelizer::BW_10K);
           demod = &am_demod;
           break;
         case Modulation::MOD_NBAM:
-          channelizer->setBw(Channelizer::BW_6K);
+          selectChannelizer(Channelizer::BW_6K);
           demod = &am_demod;
           break;
         case Modulation::MOD_USB:
 #ifdef USE_SSB_PHASE_DEMOD
-          channelizer->setBw(Channelizer::BW_6K);
+          selectChannelizer(Channelizer::BW_6K);
 #else
-          channelizer->setBw(Channelizer::BW_3K);
+          selectChannelizer(Channelizer::BW_3K);
           ch_offset = -2000;
 #endif
           ssb_demod.useLsb(false);
@@ -1047,28 +1175,42 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
           break;
         case Modulation::MOD_LSB:
 #ifdef USE_SSB_PHASE_DEMOD
-          channelizer->setBw(Channelizer::BW_6K);
+          selectChannelizer(Channelizer::BW_6K);
 #else
-          channelizer->setBw(Channelizer::BW_3K);
+          selectChannelizer(Channelizer::BW_3K);
           ch_offset = 2000;
 #endif
           ssb_demod.useLsb(true);
           demod = &ssb_demod;
           break;
         case Modulation::MOD_CW:
-          channelizer->setBw(Channelizer::BW_500);
+          selectChannelizer(Channelizer::BW_500);
           demod = &cw_demod;
           break;
         case Modulation::MOD_WBCW:
-          channelizer->setBw(Channelizer::BW_3K);
+          selectChannelizer(Channelizer::BW_3K);
           demod = &cw_demod;
           break;
         case Modulation::MOD_UNKNOWN:
           break;
       }
-      setFqOffset(fq_offset);
+      updateOffset();
       assert((demod != 0) && "Channel::setModulation: Unknown modulation");
-      setHandler(demod);
+      if (threaded)
+      {
+        if (demod != prev_demod)
+        {
+          if (prev_demod != 0)
+          {
+            prev_demod->unregisterSink();
+          }
+          demod->registerSink(audio_fifo);
+        }
+      }
+      else
+      {
+        setHandler(demod);
+      }
     }
 
     unsigned chSampRate(void) const
@@ -1076,24 +1218,75 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
       return channelizer->chSampRate();
     }
 
-    void iq_received(vector<WbRxRtlSdr::Sample> samples)
+    void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
     {
-      if (enabled)
+      if (enabled && (channelizer == wb_channelizer))
       {
-        vector<WbRxRtlSdr::Sample> translated, channelized;
-        trans.iq_received(translated, samples);
-        channelizer->iq_received(channelized, translated);
+          // The wideband samples are shared by all channels so they are
+          // only copied if the channel is not in the center
+        if (trans.hasOffset())
+        {
+          trans.iq_received(translated, samples);
+          channelizer->iq_received(channelized, translated);
+        }
+        else
+        {
+          channelizer->iq_received(channelized, samples);
+        }
         demod->iq_received(channelized);
       }
     };
 
+    void binReceived(const vector<WbRxRtlSdr::Sample> &samples)
+    {
+      if (enabled)
+      {
+        if (bank_trans.hasOffset())
+        {
+          bank_trans.iq_received(translated, samples);
+          channelizer->iq_received(channelized, translated);
+        }
+        else
+        {
+          channelizer->iq_received(channelized, samples);
+        }
+        demod->iq_received(channelized);
+      }
+    }
+
+    void iqBlockReceived(WbRxRtlSdr::SampleBlock block)
+    {
+      if (!enabled)
+      {
+        return;
+      }
+
+      const unsigned h = iq_head.load(memory_order_relaxed);
+      const unsigned t = iq_tail.load(memory_order_acquire);
+      if (h - t == IQ_QUEUE_SIZE)
+      {
+        if (iq_overruns++ % 100 == 0)
+        {
+          cerr << "*** WARNING: DDR channel thread cannot keep up. "
+               << iq_overruns << " blocks of I/Q samples thrown away so "
+               << "far\n";
+        }
+        return;
+      }
+      iq_queue[h % IQ_QUEUE_SIZE] = block;
+      iq_head.store(h + 1, memory_order_release);
+      sem_post(&iq_sem);
+    }
+
     void enable(void)
     {
+      std::lock_guard<std::mutex> lock(proc_mutex);
       enabled = true;
     }
 
     void disable(void)
     {
+      std::lock_guard<std::mutex> lock(proc_mutex);
       enabled = false;
     }
 
@@ -1102,17 +1295,118 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
     sigc::signal<void, const std::vector<RtlTcp::Sample>&> preDemod;
 
   private:
+    static const unsigned IQ_QUEUE_SIZE   = 16;      // 10ms blocks
+    static const unsigned AUDIO_FIFO_SIZE = 16384;   // Samples
+    static const unsigned IQ_FIFO_SIZE    = 65536;   // Interleaved I/Q
+
     unsigned sample_rate;
     Channelizer *channelizer;
+    Channelizer *wb_channelizer;
+    Channelizer *bank_channelizer;
     DemodulatorFm fm_demod;
     DemodulatorAm am_demod;
     DemodulatorSsb ssb_demod;
     DemodulatorCw cw_demod;
     Demodulator *demod;
     Translate trans;
+    vector<WbRxRtlSdr::Sample> translated;
+    vector<WbRxRtlSdr::Sample> channelized;
     bool enabled;
     int ch_offset;
     int fq_offset;
+
+      // Used when the channel get its samples from a channel bank
+    DdrChannelBank *bank;
+    Translate bank_trans;
+    sigc::connection bin_con;
+    int bin;
+
+      // Used when the channel is processed in a worker thread
+    bool threaded;
+    std::mutex proc_mutex;
+    std::thread worker;
+    AudioThreadFifo *audio_fifo;
+    AudioThreadFifo *iq_fifo;
+    IqSink iq_sink;
+    WbRxRtlSdr::SampleBlock iq_queue[IQ_QUEUE_SIZE];
+    std::atomic<unsigned> iq_head;
+    std::atomic<unsigned> iq_tail;
+    sem_t iq_sem;
+    unsigned long iq_overruns;
+    std::atomic<bool> stop_worker;
+
+      // Use the channel bank for all bandwidths except the widest one
+    void selectChannelizer(Channelizer::Bandwidth bw)
+    {
+      channelizer = ((bank_channelizer != 0) && (bw != Channelizer::BW_WIDE))
+                    ? bank_channelizer : wb_channelizer;
+      channelizer->setBw(bw);
+    }
+
+    void updateOffset(void)
+    {
+      const int offset = fq_offset - ch_offset;
+      if (channelizer == bank_channelizer)
+      {
+        int fine_offset = 0;
+        const int new_bin = bank->binForOffset(offset, fine_offset);
+        bank_trans.setOffset(fine_offset);
+        if (!bin_con.connected() || (new_bin != bin))
+        {
+          bin_con.disconnect();
+          bin = new_bin;
+          bin_con = bank->binSignal(bin).connect(
+              mem_fun(*this, &Channel::binReceived));
+        }
+      }
+      else
+      {
+        bin_con.disconnect();
+        trans.setOffset(offset);
+      }
+    }
+
+    void stopWorker(void)
+    {
+      if (worker.joinable())
+      {
+        stop_worker.store(true, memory_order_release);
+        sem_post(&iq_sem);
+        worker.join();
+      }
+    }
+
+      // Run in the worker thread
+    void workerFunc(void)
+    {
+      for (;;)
+      {
+        while ((sem_wait(&iq_sem) != 0) && (errno == EINTR))
+        {
+        }
+        if (stop_worker.load(memory_order_acquire))
+        {
+          break;
+        }
+        const unsigned t = iq_tail.load(memory_order_relaxed);
+        WbRxRtlSdr::SampleBlock block;
+        block.swap(iq_queue[t % IQ_QUEUE_SIZE]);
+        iq_tail.store(t + 1, memory_order_release);
+
+        std::lock_guard<std::mutex> lock(proc_mutex);
+        iq_received(*block);
+      }
+    }
+
+      // Run in the worker thread
+    void writePreDemodSamples(const vector<WbRxRtlSdr::Sample> &samples)
+    {
+      if (!samples.empty())
+      {
+        iq_fifo->writeSamples(reinterpret_cast<const float*>(&samples[0]),
+                              2 * samples.size());
+      }
+    }
 }; /* Channel */
 
 
@@ -1218,7 +1512,8 @@ bool Ddr::initialize(void)
   }
   rtl->registerDdr(this);
 
-  channel = new Channel(fq-rtl->centerFq(), rtl->sampleRate());
+  channel = new Channel(fq-rtl->centerFq(), rtl->sampleRate(),
+                        rtl->channelThreadsEnabled(), rtl->channelBank());
   if (!channel->initialize())
   {
     cout << "*** ERROR: Could not initialize channel object for receiver "
@@ -1228,7 +1523,15 @@ bool Ddr::initialize(void)
     return false;
   }
   channel->preDemod.connect(preDemod.make_slot());
-  rtl->iqReceived.connect(mem_fun(*channel, &Channel::iq_received));
+  if (rtl->channelThreadsEnabled())
+  {
+    rtl->iqBlockReceived.connect(
+        mem_fun(*channel, &Channel::iqBlockReceived));
+  }
+  else
+  {
+    rtl->iqReceived.connect(mem_fun(*channel, &Channel::iq_received));
+  }
   rtl->readyStateChanged.connect(readyStateChanged.make_slot());
 
   string modstr("FM");
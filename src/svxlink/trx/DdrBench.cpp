@@ -0,0 +1,330 @@
+/**
+@file	 DdrBench.cpp
+@brief   Measure the throughput of the DDR channelizer filter chains
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This program runs random I/Q samples through the same decimator and channel
+filter chains that the Ddr receiver use and print the throughput for each
+chain in MS/s. Dividing the throughput with the wideband sample rate give an
+estimate of how many DDR channels that one CPU core can handle. Only the
+channelizer is measured, not the frequency translation or the demodulators.
+The channel bank, used when CHANNEL_BANK is enabled for a tuner, is measured
+with a varying number of active bins.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <complex>
+#include <sstream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioPolyphase.h>
+#include <BenchUtil.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "DdrFilterCoeffs.h"
+#include "DdrChannelBank.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace SvxLink;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+#define MAX_STAGES  5
+
+typedef complex<float> Sample;
+typedef AudioPolyphaseDecimator<Sample> Decimator;
+
+struct Stage
+{
+  int           factor;
+  const float   *coeff;
+  int           taps;
+};
+
+#define STAGE(fact, name) { fact, name, name ## _cnt }
+
+  // The filter chains below must be kept in sync with the Channelizer960 and
+  // Channelizer2400 classes in Ddr.cpp
+struct Chain
+{
+  const char    *name;
+  unsigned      samp_rate;
+  Stage         stages[MAX_STAGES];
+  int           stage_cnt;
+};
+
+static const Chain chains[] =
+{
+  { "960k WIDE", 960000,
+    { STAGE(5, coeff_dec_960k_192k) }, 1 },
+  { "960k 20K", 960000,
+    { STAGE(5, coeff_dec_960k_192k), STAGE(3, coeff_dec_192k_64k),
+      STAGE(2, coeff_dec_64k_32k), STAGE(1, coeff_25k_channel) }, 4 },
+  { "960k 10K", 960000,
+    { STAGE(5, coeff_dec_960k_192k), STAGE(4, coeff_dec_192k_48k),
+      STAGE(3, coeff_dec_48k_16k), STAGE(1, coeff_12k5_channel) }, 4 },
+  { "960k 6K", 960000,
+    { STAGE(5, coeff_dec_960k_192k), STAGE(4, coeff_dec_192k_48k),
+      STAGE(3, coeff_dec_48k_16k), STAGE(1, coeff_nbam_channel) }, 4 },
+  { "960k 3K", 960000,
+    { STAGE(5, coeff_dec_960k_192k), STAGE(4, coeff_dec_192k_48k),
+      STAGE(3, coeff_dec_48k_16k), STAGE(1, coeff_ssb_channel) }, 4 },
+  { "960k 500", 960000,
+    { STAGE(5, coeff_dec_960k_192k), STAGE(4, coeff_dec_192k_48k),
+      STAGE(3, coeff_dec_48k_16k), STAGE(1, coeff_cw_channel) }, 4 },
+  { "2400k WIDE", 2400000,
+    { STAGE(3, coeff_dec_2400k_800k), STAGE(5, coeff_dec_800k_160k) }, 2 },
+  { "2400k 20K", 2400000,
+    { STAGE(3, coeff_dec_2400k_800k), STAGE(5, coeff_dec_800k_160k),
+      STAGE(5, coeff_dec_160k_32k), STAGE(1, coeff_25k_channel) }, 4 },
+  { "2400k 10K", 2400000,
+    { STAGE(3, coeff_dec_2400k_800k), STAGE(5, coeff_dec_800k_160k),
+      STAGE(5, coeff_dec_160k_32k), STAGE(2, coeff_dec_32k_16k),
+      STAGE(1, coeff_12k5_channel) }, 5 },
+  { "2400k 500", 2400000,
+    { STAGE(3, coeff_dec_2400k_800k), STAGE(5, coeff_dec_800k_160k),
+      STAGE(5, coeff_dec_160k_32k), STAGE(2, coeff_dec_32k_16k),
+      STAGE(1, coeff_cw_channel) }, 5 },
+};
+static const int chain_cnt = sizeof(chains) / sizeof(*chains);
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static double runChain(const Chain& chain, const vector<Sample>& block,
+                       double duration);
+static double runBank(unsigned samp_rate, int bins,
+                      const vector<Sample>& block, double duration);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  double duration = 2.0;
+  if (argc > 1)
+  {
+    duration = atof(argv[1]);
+  }
+  if ((argc > 2) || (duration <= 0.0))
+  {
+    cerr << "Usage: DdrBench [seconds per chain]\n";
+    exit(1);
+  }
+
+    // 10ms of samples at 2400kHz, which is a multiple of the total
+    // decimation factor of all chains
+  vector<Sample> block(24000);
+  for (size_t i=0; i<block.size(); ++i)
+  {
+    block[i] = Sample(rand() / (RAND_MAX / 2.0f) - 1.0f,
+                      rand() / (RAND_MAX / 2.0f) - 1.0f);
+  }
+
+#if defined(__AVX__)
+  cout << "Kernels: AVX" << (
+#if defined(__FMA__)
+      "+FMA"
+#else
+      ""
+#endif
+      ) << endl;
+#elif defined(__SSE__)
+  cout << "Kernels: SSE" << endl;
+#elif defined(__ARM_NEON)
+  cout << "Kernels: NEON" << endl;
+#else
+  cout << "Kernels: scalar" << endl;
+#endif
+
+  cout << setw(12) << left << "Chain" << right
+       << setw(10) << "MS/s" << setw(12) << "Channels" << endl;
+  for (int i=0; i<chain_cnt; ++i)
+  {
+    const Chain& chain = chains[i];
+    double msps = runChain(chain, block, duration) / 1.0e6;
+    cout << setw(12) << left << chain.name << right << fixed
+         << setprecision(2) << setw(10) << msps
+         << setprecision(1) << setw(12)
+         << msps * 1.0e6 / chain.samp_rate << endl;
+  }
+
+  cout << endl << setw(12) << left << "Bank" << right
+       << setw(10) << "MS/s" << endl;
+  const unsigned bank_rates[] = { 960000, 2400000 };
+  const int bank_bins[] = { 1, 8, 16 };
+  for (int r=0; r<2; ++r)
+  {
+    for (int b=0; b<3; ++b)
+    {
+      ostringstream name;
+      name << bank_rates[r] / 1000 << "k " << bank_bins[b] << "ch";
+      double msps = runBank(bank_rates[r], bank_bins[b], block, duration);
+      cout << setw(12) << left << name.str() << right << fixed
+           << setprecision(2) << setw(10) << msps / 1.0e6 << endl;
+    }
+  }
+
+  return 0;
+} /* main */
+
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+  // Return the number of input samples per second processed by one channel
+static double runChain(const Chain& chain, const vector<Sample>& block,
+                       double duration)
+{
+  Decimator dec[MAX_STAGES];
+  vector<Sample> buf[MAX_STAGES + 1];
+  for (int i=0; i<chain.stage_cnt; ++i)
+  {
+    const Stage& stage = chain.stages[i];
+    dec[i].setFilter(stage.factor, stage.coeff, stage.taps);
+  }
+  buf[0] = block;
+
+  unsigned long samples = 0;
+  const uint64_t start = benchNowUs();
+  double elapsed = 0.0;
+  while (elapsed < duration)
+  {
+    for (int i=0; i<chain.stage_cnt; ++i)
+    {
+      buf[i+1].resize(buf[i].size() / dec[i].factor() + 1);
+      int cnt = dec[i].decimate(&buf[i+1][0], &buf[i][0], buf[i].size());
+      buf[i+1].resize(cnt);
+    }
+    samples += block.size();
+    elapsed = (benchNowUs() - start) / 1.0e6;
+  }
+  return samples / elapsed;
+} /* runChain */
+
+
+
+  // Return the number of wideband samples per second processed by the bank
+static double runBank(unsigned samp_rate, int bins,
+                      const vector<Sample>& block, double duration)
+{
+  struct BinSink : public sigc::trackable
+  {
+    void binReceived(const vector<Sample>&) {}
+  } sink;
+
+  DdrChannelBank bank(samp_rate);
+  for (int i=0; i<bins; ++i)
+  {
+    bank.binSignal(i - bins / 2).connect(
+        sigc::mem_fun(sink, &BinSink::binReceived));
+  }
+
+  unsigned long samples = 0;
+  const uint64_t start = benchNowUs();
+  double elapsed = 0.0;
+  while (elapsed < duration)
+  {
+    bank.process(block);
+    samples += block.size();
+    elapsed = (benchNowUs() - start) / 1.0e6;
+  }
+  return samples / elapsed;
+} /* runBank */
+
+
+
+/*
+ * This file has not been truncated
+ */
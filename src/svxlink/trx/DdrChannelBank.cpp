@@ -0,0 +1,425 @@
+/**
+@file	 DdrChannelBank.cpp
+@brief   A polyphase FFT filter bank splitting a wideband signal into bins
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This file contains a class that split up the wideband I/Q signal from a
+tuner into equally spaced frequency bins in one pass. It is used when many
+digital drop receivers share one tuner.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cmath>
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "DdrChannelBank.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The spacing between the bins and the output sample rate of each bin.
+  // The output rate is three times the bin spacing so that a channel that
+  // is offset half a bin from the bin center, plus half the channel
+  // bandwidth, fit within the passband of the prototype filter.
+#define BIN_SPACING       32000
+#define BIN_SAMP_RATE     96000
+
+  // The passband and stopband edges of the prototype filter, in Hz
+#define PROTO_PASSBAND    28500
+#define PROTO_STOPBAND    (BIN_SAMP_RATE - PROTO_PASSBAND)
+
+  // The stopband attenuation of the prototype filter, in dB
+#define PROTO_ATTEN       70.0
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+/*
+ * A mixed radix FFT for the small and not necessarily power of two sizes
+ * used by the channel bank, e.g. 30 and 75. It is a recursive decimation in
+ * time FFT using a generic radix-p butterfly for each prime factor. The
+ * transform use a positive exponent, i.e. an unnormalized inverse DFT.
+ */
+class DdrChannelBank::Fft
+{
+  public:
+    explicit Fft(int n) : n(n), twiddles(n), scratch(n)
+    {
+      for (int i=0; i<n; ++i)
+      {
+        twiddles[i] = polar(1.0, 2.0 * M_PI * i / n);
+      }
+      int rest = n;
+      for (int p=2; rest > 1; )
+      {
+        if (rest % p == 0)
+        {
+          factors.push_back(p);
+          rest /= p;
+        }
+        else
+        {
+          ++p;
+        }
+      }
+    }
+
+    void transform(Sample *out, const Sample *in)
+    {
+      work(out, in, 1, 0, n);
+    }
+
+  private:
+    int                 n;
+    vector<Sample>      twiddles;
+    vector<Sample>      scratch;
+    vector<int>         factors;
+
+    void work(Sample *out, const Sample *in, int stride, size_t stage,
+              int len)
+    {
+      const int p = factors[stage];
+      const int m = len / p;
+      if (m == 1)
+      {
+        for (int i=0; i<p; ++i)
+        {
+          out[i] = in[i * stride];
+        }
+      }
+      else
+      {
+        for (int i=0; i<p; ++i)
+        {
+          work(out + i * m, in + i * stride, stride * p, stage + 1, m);
+        }
+      }
+      butterfly(out, stride, m, p);
+    }
+
+    void butterfly(Sample *out, int stride, int m, int p)
+    {
+      for (int u=0; u<m; ++u)
+      {
+        for (int q=0; q<p; ++q)
+        {
+          scratch[q] = out[u + q * m];
+        }
+        for (int q1=0; q1<p; ++q1)
+        {
+          const int k = u + q1 * m;
+          const int step = (stride * k) % n;
+          int tw_idx = 0;
+          Sample sum = scratch[0];
+          for (int q=1; q<p; ++q)
+          {
+            tw_idx += step;
+            if (tw_idx >= n)
+            {
+              tw_idx -= n;
+            }
+            sum += scratch[q] * twiddles[tw_idx];
+          }
+          out[k] = sum;
+        }
+      }
+    }
+}; /* DdrChannelBank::Fft */
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static double besselI0(double x);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+bool DdrChannelBank::isSupportedSampleRate(unsigned samp_rate)
+{
+  return (samp_rate > 0) && (samp_rate % BIN_SAMP_RATE == 0);
+} /* DdrChannelBank::isSupportedSampleRate */
+
+
+void DdrChannelBank::designLowpass(std::vector<float> &coeff, int taps,
+                                   double cutoff, double atten)
+{
+  assert(taps > 1);
+  const double beta = (atten > 50.0) ? 0.1102 * (atten - 8.7)
+                                     : 0.5842 * pow(atten - 21.0, 0.4) +
+                                       0.07886 * (atten - 21.0);
+  coeff.resize(taps);
+  double sum = 0.0;
+  for (int i=0; i<taps; ++i)
+  {
+    const double t = i - (taps - 1) / 2.0;
+    const double x = 2.0 * cutoff * t;
+    const double sinc = (t == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+    const double r = 2.0 * i / (taps - 1) - 1.0;
+    const double window = besselI0(beta * sqrt(1.0 - r * r)) / besselI0(beta);
+    coeff[i] = sinc * window;
+    sum += coeff[i];
+  }
+  for (int i=0; i<taps; ++i)
+  {
+    coeff[i] /= sum;
+  }
+} /* DdrChannelBank::designLowpass */
+
+
+DdrChannelBank::DdrChannelBank(unsigned samp_rate)
+  : samp_rate(samp_rate), bin_cnt(samp_rate / BIN_SPACING),
+    dec_fact(samp_rate / BIN_SAMP_RATE), taps(0), hist_pos(0), phase(0),
+    block_idx(0), fold(bin_cnt), spectrum(bin_cnt), rot(bin_cnt),
+    bin_signals(bin_cnt), bin_out(bin_cnt), fft(0)
+{
+  assert(isSupportedSampleRate(samp_rate));
+
+    // Estimate the needed filter length for a Kaiser window and round it
+    // up to a whole number of taps per polyphase branch
+  const double dw = 2.0 * M_PI * (PROTO_STOPBAND - PROTO_PASSBAND) / samp_rate;
+  int n = static_cast<int>(ceil((PROTO_ATTEN - 8.0) / (2.285 * dw)));
+  taps = (n + bin_cnt - 1) / bin_cnt * bin_cnt;
+
+  vector<float> proto;
+  designLowpass(proto, taps,
+                (PROTO_PASSBAND + PROTO_STOPBAND) / 2.0 / samp_rate,
+                PROTO_ATTEN);
+
+    // Store the coefficients reversed to match the sample history, which is
+    // stored oldest sample first
+  coeff.assign(proto.rbegin(), proto.rend());
+  hist.assign(2 * taps, Sample(0.0f, 0.0f));
+
+  for (int k=0; k<bin_cnt; ++k)
+  {
+    rot[k] = polar(1.0, -2.0 * M_PI * k / bin_cnt);
+  }
+
+  fft = new Fft(bin_cnt);
+} /* DdrChannelBank::DdrChannelBank */
+
+
+DdrChannelBank::~DdrChannelBank(void)
+{
+  delete fft;
+} /* DdrChannelBank::~DdrChannelBank */
+
+
+int DdrChannelBank::binForOffset(int fq_offset, int &fine_offset) const
+{
+  const int spacing = binSpacing();
+  int bin = (fq_offset >= 0) ? (fq_offset + spacing / 2) / spacing
+                             : -((-fq_offset + spacing / 2) / spacing);
+  fine_offset = fq_offset - bin * spacing;
+  return bin;
+} /* DdrChannelBank::binForOffset */
+
+
+DdrChannelBank::BinSignal &DdrChannelBank::binSignal(int bin)
+{
+  return bin_signals[((bin % bin_cnt) + bin_cnt) % bin_cnt];
+} /* DdrChannelBank::binSignal */
+
+
+void DdrChannelBank::process(const std::vector<Sample> &samples)
+{
+  active_bins.clear();
+  for (int k=0; k<bin_cnt; ++k)
+  {
+    if (!bin_signals[k].empty())
+    {
+      active_bins.push_back(k);
+      bin_out[k].clear();
+    }
+  }
+
+  for (size_t i=0; i<samples.size(); ++i)
+  {
+    hist[hist_pos] = hist[hist_pos + taps] = samples[i];
+    if (++hist_pos == taps)
+    {
+      hist_pos = 0;
+    }
+    if (++block_idx == bin_cnt)
+    {
+      block_idx = 0;
+    }
+    if (++phase == dec_fact)
+    {
+      phase = 0;
+      if (!active_bins.empty())
+      {
+        calcOutput();
+      }
+    }
+  }
+
+  for (size_t i=0; i<active_bins.size(); ++i)
+  {
+    const int k = active_bins[i];
+    if (!bin_out[k].empty())
+    {
+      bin_signals[k](bin_out[k]);
+    }
+  }
+} /* DdrChannelBank::process */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void DdrChannelBank::calcOutput(void)
+{
+    // Fold the filtered history into one sample per polyphase branch. The
+    // window is the last taps samples, oldest first, and branch m get the
+    // taps j where (taps - 1 - j) % bin_cnt == m.
+  const Sample *window = &hist[hist_pos];
+  for (int i=0; i<bin_cnt; ++i)
+  {
+    spectrum[i] = Sample(0.0f, 0.0f);
+  }
+  for (int j=0; j<taps; j+=bin_cnt)
+  {
+    for (int i=0; i<bin_cnt; ++i)
+    {
+      spectrum[i] += coeff[j + i] * window[j + i];
+    }
+  }
+  for (int i=0; i<bin_cnt; ++i)
+  {
+    fold[bin_cnt - 1 - i] = spectrum[i];
+  }
+
+  fft->transform(&spectrum[0], &fold[0]);
+
+    // The mixing of each bin down to DC is referenced to the newest sample
+    // in the window, which give a phase rotation in each output sample
+  const int newest = (block_idx + bin_cnt - 1) % bin_cnt;
+  for (size_t i=0; i<active_bins.size(); ++i)
+  {
+    const int k = active_bins[i];
+    bin_out[k].push_back(spectrum[k] * rot[(k * newest) % bin_cnt]);
+  }
+} /* DdrChannelBank::calcOutput */
+
+
+static double besselI0(double x)
+{
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k=1; k<50; ++k)
+  {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < 1.0e-12 * sum)
+    {
+      break;
+    }
+  }
+  return sum;
+} /* besselI0 */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,238 @@
+/**
+@file	 DdrChannelBank.h
+@brief   A polyphase FFT filter bank splitting a wideband signal into bins
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This file contains a class that split up the wideband I/Q signal from a
+tuner into equally spaced frequency bins in one pass. It is used when many
+digital drop receivers share one tuner.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+#ifndef DDR_CHANNEL_BANK_INCLUDED
+#define DDR_CHANNEL_BANK_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+#include <vector>
+#include <complex>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A polyphase FFT channel bank for DDR channels
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class split up a wideband signal into frequency bins spaced 32kHz apart.
+Each bin is mixed down to DC, lowpass filtered and decimated to 96kHz, three
+times the bin spacing, so that a channel anywhere within half a bin from the
+center of the bin can be fine tuned and filtered at the lower sample rate.
+All bins are calculated in one pass using a polyphase filter followed by an
+FFT so the cost is shared by all channels. Only bins that have slots connected
+to them are copied to an output buffer.
+
+A bin number is given as a signed number where zero is the bin at the tuner
+center frequency, positive bins are above it and negative bins below it.
+*/
+class DdrChannelBank
+{
+  public:
+    typedef std::complex<float> Sample;
+    typedef sigc::signal<void, const std::vector<Sample>&> BinSignal;
+
+    /**
+     * @brief   Find out if a wideband sample rate is supported
+     * @param   samp_rate The wideband sample rate
+     * @returns Returns \em true if the sample rate is supported
+     */
+    static bool isSupportedSampleRate(unsigned samp_rate);
+
+    /**
+     * @brief   Design a lowpass FIR filter
+     * @param   coeff   The vector to store the coefficients in
+     * @param   taps    The number of filter taps
+     * @param   cutoff  The cutoff frequency relative to the sample rate
+     * @param   atten   The stopband attenuation in dB
+     *
+     * The filter is a windowed sinc using a Kaiser window. The DC gain is
+     * normalized to one.
+     */
+    static void designLowpass(std::vector<float> &coeff, int taps,
+                              double cutoff, double atten);
+
+    /**
+     * @brief 	Constructor
+     * @param   samp_rate The wideband sample rate
+     *
+     * The sample rate must be supported, @see isSupportedSampleRate.
+     */
+    explicit DdrChannelBank(unsigned samp_rate);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~DdrChannelBank(void);
+
+    /**
+     * @brief   Get the spacing between the bins
+     * @returns Returns the bin spacing in Hz
+     */
+    unsigned binSpacing(void) const { return samp_rate / bin_cnt; }
+
+    /**
+     * @brief   Get the sample rate of the bin outputs
+     * @returns Returns the output sample rate in Hz
+     */
+    unsigned outputSampleRate(void) const { return samp_rate / dec_fact; }
+
+    /**
+     * @brief   Find the bin closest to an offset from the center frequency
+     * @param   fq_offset   The offset from the tuner center frequency in Hz
+     * @param   fine_offset Set to the offset from the center of the bin
+     * @returns Returns the bin number
+     */
+    int binForOffset(int fq_offset, int &fine_offset) const;
+
+    /**
+     * @brief   Get the signal for a bin
+     * @param   bin The bin number, @see binForOffset
+     * @returns Returns the signal that is emitted with the bin samples
+     */
+    BinSignal &binSignal(int bin);
+
+    /**
+     * @brief   Process a block of wideband samples
+     * @param   samples The wideband samples
+     *
+     * The signals for all bins that have slots connected are emitted when
+     * the whole block has been processed.
+     */
+    void process(const std::vector<Sample> &samples);
+
+  private:
+    class Fft;
+
+    unsigned                          samp_rate;
+    int                               bin_cnt;
+    int                               dec_fact;
+    int                               taps;
+    std::vector<float>                coeff;
+    std::vector<Sample>               hist;
+    int                               hist_pos;
+    int                               phase;
+    int                               block_idx;
+    std::vector<Sample>               fold;
+    std::vector<Sample>               spectrum;
+    std::vector<Sample>               rot;
+    std::vector<BinSignal>            bin_signals;
+    std::vector<std::vector<Sample> > bin_out;
+    std::vector<int>                  active_bins;
+    Fft                               *fft;
+
+    DdrChannelBank(const DdrChannelBank&);
+    DdrChannelBank& operator=(const DdrChannelBank&);
+    void calcOutput(void);
+
+};  /* class DdrChannelBank */
+
+
+//} /* namespace */
+
+#endif /* DDR_CHANNEL_BANK_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,509 @@
+/**
+@file	 DtmfBench.cpp
+@brief   Compare the software DTMF decoders on CPU cost and accuracy
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This program feeds a number of synthetic DTMF test tapes through each of
+the software DTMF decoders and print, for each tape, the detection rate,
+the number of wrong and extra digits, the mean detection latency and the
+throughput in MS/s. The tapes are an SNR sweep, a twist sweep and a talk-off
+tape. The talk-off tape is a synthetic voiced signal with varying pitch and
+formants which should not trigger any digits. A recorded talk-off tape, raw
+16 bit signed samples at the internal sample rate, can be given on the
+command line instead. Only the decoders that work on audio are measured.
+The S54S and PTY decoders get their digits from external hardware and the
+AFSK decoder get them from data frames.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncConfig.h>
+#include <BenchUtil.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "DtmfDecoder.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace SvxLink;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The tone and pause durations used on the digit tapes, in milliseconds.
+  // These are the defaults of the DtmfEncoder class. Some decoders, like
+  // the DH1DM decoder, need more than 70ms to detect a digit.
+#define DIGIT_DURATION    100
+#define DIGIT_SPACING     50
+
+  // The number of times the sixteen digits are repeated on each digit tape
+#define DIGIT_REPEAT      20
+
+  // The power of each of the two tones in a digit, in dBFS
+#define TONE_POWER        -16.0
+
+  // The length of the synthetic talk-off tape, in seconds
+#define TALK_OFF_TIME     120
+
+  // The number of samples written to the decoder in each call. The detection
+  // latency is measured with this resolution.
+#define BLOCK_SIZE        64
+
+struct Digit
+{
+  char          digit;
+  size_t        start;
+  size_t        end;
+  bool          hit;
+};
+
+struct Tape
+{
+  string        name;
+  vector<float> samples;
+  vector<Digit> digits;
+};
+
+struct Detection
+{
+  char          digit;
+  size_t        pos;
+};
+
+struct Result
+{
+  unsigned      hits;
+  unsigned      wrong;
+  unsigned      extra;
+  double        latency_ms;
+  double        msps;
+};
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+class DetectionLog : public sigc::trackable
+{
+  public:
+    size_t              pos;
+    vector<Detection>   detections;
+
+    DetectionLog(void) : pos(0) {}
+
+    void digitActivated(char digit)
+    {
+      Detection det = { digit, pos };
+      detections.push_back(det);
+    }
+};
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static void addDigit(Tape &tape, char digit, double twist_db);
+static void addNoise(Tape &tape, double snr_db, mt19937 &rng);
+static void makeDigitTape(Tape &tape, double snr_db, double twist_db,
+                          mt19937 &rng);
+static void makeTalkOffTape(Tape &tape, mt19937 &rng);
+static bool readTape(Tape &tape, const string &filename);
+static bool runTape(const string &type, Tape &tape, Result &result);
+static void printResult(const string &type, const Tape &tape,
+                        const Result &result);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+static const char digit_chars[] = "0123456789ABCD*#";
+static const char keypad[] = "123A456B789C*0#D";
+static const float low_fqs[] = { 697, 770, 852, 941 };
+static const float high_fqs[] = { 1209, 1336, 1477, 1633 };
+static const char *decoder_types[] = { "INTERNAL", "DH1DM" };
+static const int decoder_type_cnt =
+  sizeof(decoder_types) / sizeof(*decoder_types);
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  if (argc > 2)
+  {
+    cerr << "Usage: DtmfBench [talk-off tape]\n";
+    exit(1);
+  }
+
+  mt19937 rng(4711);
+  vector<Tape> tapes;
+
+  const double snrs[] = { 30, 20, 15, 12, 9, 6, 3 };
+  for (size_t i=0; i<sizeof(snrs)/sizeof(*snrs); ++i)
+  {
+    Tape tape;
+    ostringstream name;
+    name << "snr " << snrs[i] << "dB";
+    tape.name = name.str();
+    makeDigitTape(tape, snrs[i], 0.0, rng);
+    tapes.push_back(tape);
+  }
+
+  const double twists[] = { -10, -8, -6, -4, 4, 6, 8, 10 };
+  for (size_t i=0; i<sizeof(twists)/sizeof(*twists); ++i)
+  {
+    Tape tape;
+    ostringstream name;
+    name << "twist " << showpos << twists[i] << "dB";
+    tape.name = name.str();
+    makeDigitTape(tape, 30.0, twists[i], rng);
+    tapes.push_back(tape);
+  }
+
+  Tape talk_off;
+  talk_off.name = "talk-off";
+  if (argc > 1)
+  {
+    if (!readTape(talk_off, argv[1]))
+    {
+      exit(1);
+    }
+  }
+  else
+  {
+    makeTalkOffTape(talk_off, rng);
+  }
+  tapes.push_back(talk_off);
+
+  cout << setw(10) << left << "Decoder" << setw(16) << "Tape" << right
+       << setw(8) << "Hit%" << setw(8) << "Wrong" << setw(8) << "Extra"
+       << setw(10) << "Lat(ms)" << setw(10) << "MS/s" << endl;
+  for (int d=0; d<decoder_type_cnt; ++d)
+  {
+    for (size_t i=0; i<tapes.size(); ++i)
+    {
+      Result result;
+      if (!runTape(decoder_types[d], tapes[i], result))
+      {
+        exit(1);
+      }
+      printResult(decoder_types[d], tapes[i], result);
+    }
+  }
+
+  return 0;
+} /* main */
+
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+  // Add one digit followed by a pause. A positive twist mean that the
+  // high group tone is stronger than the low group tone.
+static void addDigit(Tape &tape, char digit, double twist_db)
+{
+  const int idx = string(keypad).find(digit);
+  const float low_fq = low_fqs[idx / 4];
+  const float high_fq = high_fqs[idx % 4];
+  const double amp = sqrt(2.0) * pow(10.0, TONE_POWER / 20.0);
+  const double low_amp = amp * pow(10.0, -twist_db / 40.0);
+  const double high_amp = amp * pow(10.0, twist_db / 40.0);
+
+  Digit d;
+  d.digit = digit;
+  d.start = tape.samples.size();
+  d.end = d.start + DIGIT_DURATION * INTERNAL_SAMPLE_RATE / 1000;
+  d.hit = false;
+  for (size_t i=d.start; i<d.end; ++i)
+  {
+    const double t = static_cast<double>(i - d.start) / INTERNAL_SAMPLE_RATE;
+    tape.samples.push_back(low_amp * sin(2.0 * M_PI * low_fq * t) +
+                           high_amp * sin(2.0 * M_PI * high_fq * t));
+  }
+  tape.samples.resize(
+      d.end + DIGIT_SPACING * INTERNAL_SAMPLE_RATE / 1000, 0.0f);
+  tape.digits.push_back(d);
+} /* addDigit */
+
+
+  // Add white gaussian noise. The SNR is the power of both tones relative to
+  // the noise power over the whole band.
+static void addNoise(Tape &tape, double snr_db, mt19937 &rng)
+{
+  const double signal_pwr = 2.0 * pow(10.0, TONE_POWER / 10.0);
+  normal_distribution<float> noise(0.0f,
+      sqrt(signal_pwr / pow(10.0, snr_db / 10.0)));
+  for (size_t i=0; i<tape.samples.size(); ++i)
+  {
+    tape.samples[i] += noise(rng);
+  }
+} /* addNoise */
+
+
+static void makeDigitTape(Tape &tape, double snr_db, double twist_db,
+                          mt19937 &rng)
+{
+  tape.samples.assign(DIGIT_SPACING * INTERNAL_SAMPLE_RATE / 1000, 0.0f);
+  for (int r=0; r<DIGIT_REPEAT; ++r)
+  {
+    for (const char *ch=digit_chars; *ch != 0; ++ch)
+    {
+      addDigit(tape, *ch, twist_db);
+    }
+  }
+  addNoise(tape, snr_db, rng);
+} /* makeDigitTape */
+
+
+  // A crude model of voiced speech. Each syllable has a pitch that glide
+  // between two random values and two formants that shape the harmonics.
+  // The syllables are separated by short pauses.
+static void makeTalkOffTape(Tape &tape, mt19937 &rng)
+{
+  uniform_real_distribution<double> uni(0.0, 1.0);
+  const size_t len = TALK_OFF_TIME * INTERNAL_SAMPLE_RATE;
+  tape.samples.reserve(len);
+  while (tape.samples.size() < len)
+  {
+    const size_t syl_len = (0.1 + 0.3 * uni(rng)) * INTERNAL_SAMPLE_RATE;
+    const double f0_start = 90.0 + 160.0 * uni(rng);
+    const double f0_end = 90.0 + 160.0 * uni(rng);
+    const double f1 = 300.0 + 600.0 * uni(rng);
+    const double f2 = 900.0 + 1600.0 * uni(rng);
+    const double amp = pow(10.0, (-12.0 - 12.0 * uni(rng)) / 20.0);
+    double phase = 0.0;
+    for (size_t i=0; i<syl_len; ++i)
+    {
+      const double x = static_cast<double>(i) / syl_len;
+      const double f0 = f0_start + (f0_end - f0_start) * x;
+      phase += 2.0 * M_PI * f0 / INTERNAL_SAMPLE_RATE;
+      double sample = 0.0;
+      for (int h=1; h * f0 < 3400.0; ++h)
+      {
+        const double fq = h * f0;
+        const double g = 1.0 / (1.0 + pow((fq - f1) / 150.0, 2)) +
+                         0.5 / (1.0 + pow((fq - f2) / 200.0, 2));
+        sample += g * sin(h * phase);
+      }
+      tape.samples.push_back(amp * sin(M_PI * x) * sample);
+    }
+    tape.samples.resize(
+        tape.samples.size() + (0.02 + 0.1 * uni(rng)) * INTERNAL_SAMPLE_RATE,
+        0.0f);
+  }
+  addNoise(tape, 30.0, rng);
+} /* makeTalkOffTape */
+
+
+static bool readTape(Tape &tape, const string &filename)
+{
+  ifstream ifs(filename.c_str(), ios::in | ios::binary);
+  if (!ifs)
+  {
+    cerr << "*** ERROR: Could not open talk-off tape \"" << filename
+         << "\"\n";
+    return false;
+  }
+  int16_t buf[1024];
+  while (ifs.read(reinterpret_cast<char*>(buf), sizeof(buf)) ||
+         (ifs.gcount() > 0))
+  {
+    const int cnt = ifs.gcount() / sizeof(*buf);
+    for (int i=0; i<cnt; ++i)
+    {
+      tape.samples.push_back(buf[i] / 32768.0f);
+    }
+  }
+  return true;
+} /* readTape */
+
+
+static bool runTape(const string &type, Tape &tape, Result &result)
+{
+  Config cfg;
+  cfg.setValue("Bench", "DTMF_DEC_TYPE", type);
+  DtmfDecoder *dec = DtmfDecoder::create(0, cfg, "Bench");
+  if ((dec == 0) || !dec->initialize())
+  {
+    cerr << "*** ERROR: Could not initialize the " << type
+         << " DTMF decoder\n";
+    delete dec;
+    return false;
+  }
+  DetectionLog log;
+  dec->digitActivated.connect(
+      sigc::mem_fun(log, &DetectionLog::digitActivated));
+
+  const uint64_t start = benchNowUs();
+  const size_t len = tape.samples.size();
+  while (log.pos < len)
+  {
+    const size_t cnt = min(static_cast<size_t>(BLOCK_SIZE), len - log.pos);
+    dec->writeSamples(&tape.samples[log.pos], cnt);
+    log.pos += cnt;
+  }
+  const double elapsed = (benchNowUs() - start) / 1.0e6;
+  delete dec;
+
+    // Match each detection to the digit that was playing, or had just
+    // stopped playing, at the time of the detection
+  result.hits = result.wrong = result.extra = 0;
+  result.latency_ms = 0.0;
+  result.msps = len / elapsed / 1.0e6;
+  for (size_t i=0; i<tape.digits.size(); ++i)
+  {
+    tape.digits[i].hit = false;
+  }
+  size_t next = 0;
+  double latency_sum = 0.0;
+  for (size_t i=0; i<log.detections.size(); ++i)
+  {
+    const Detection &det = log.detections[i];
+    while ((next < tape.digits.size()) &&
+           (tape.digits[next].end +
+            DIGIT_SPACING * INTERNAL_SAMPLE_RATE / 1000 <= det.pos))
+    {
+      ++next;
+    }
+    if ((next == tape.digits.size()) || (det.pos < tape.digits[next].start))
+    {
+      ++result.extra;
+      continue;
+    }
+    Digit &digit = tape.digits[next];
+    if (digit.hit)
+    {
+      ++result.extra;
+    }
+    else if (digit.digit != det.digit)
+    {
+      ++result.wrong;
+    }
+    else
+    {
+      digit.hit = true;
+      ++result.hits;
+      latency_sum += det.pos - digit.start;
+    }
+  }
+  if (result.hits > 0)
+  {
+    result.latency_ms = 1000.0 * latency_sum / result.hits /
+                        INTERNAL_SAMPLE_RATE;
+  }
+
+  return true;
+} /* runTape */
+
+
+static void printResult(const string &type, const Tape &tape,
+                        const Result &result)
+{
+  cout << setw(10) << left << type << setw(16) << tape.name << right
+       << fixed;
+  if (tape.digits.empty())
+  {
+    cout << setw(8) << "-" << setw(8) << "-" << setw(8) << result.extra
+         << setw(10) << "-";
+  }
+  else
+  {
+    cout << setprecision(1) << setw(8)
+         << 100.0 * result.hits / tape.digits.size()
+         << setw(8) << result.wrong << setw(8) << result.extra
+         << setw(10) << result.latency_ms;
+  }
+  cout << setprecision(2) << setw(10) << result.msps << endl;
+} /* printResult */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -35,6 +35,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <map>
 #include <utility>
 #include <cmath>
+#include <cstring>
 
 
 /****************************************************************************
@@ -299,6 +300,12 @@ void DtmfEncoder::playNextDigit(void)
   {
     length = tone_length;
   }
+  for (int i=0; i<2; ++i)
+  {
+    tones[i].setFq((i == 0) ? low_tone : high_tone, sampling_rate);
+    tones[i].setAmplitude(tone_amp);
+    tones[i].reset();
+  }
   is_playing = true;
   
   writeAudio();
@@ -314,22 +321,21 @@ void DtmfEncoder::writeAudio(void)
   do
   {
     unsigned count = min(BLOCK_SIZE, length - pos);
-    for (unsigned i=0; i<count; ++i)
+    if (low_tone > 0)
+    {
+      Async::AudioOscillator::generateSum(tones, 2, block, count);
+    }
+    else
     {
-      if (low_tone > 0)
-      {
-      	block[i] = tone_amp * sin(2 * M_PI * low_tone * pos / sampling_rate) +
-      		   tone_amp * sin(2 * M_PI * high_tone * pos / sampling_rate);
-      }
-      else
-      {
-      	block[i] = 0;
-      }
-      ++pos;
+      memset(block, 0, count * sizeof(*block));
     }
 
     ret = sinkWriteSamples(block, count);
-    pos -= (count - ret);
+    pos += ret;
+    for (int i=0; i<2; ++i)
+    {
+      tones[i].advance(ret);
+    }
   } while ((ret > 0) && (pos < length));
   
   if (pos == length)
@@ -47,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncAudioSource.h>
+#include <AsyncAudioOscillator.h>
 
 
 /****************************************************************************
@@ -225,6 +226,7 @@ class DtmfEncoder : public Async::AudioSource, sigc::trackable
     unsigned    high_tone;
     unsigned    pos;
     unsigned    length;
+    Async::AudioOscillator tones[2];
     bool      	is_playing;
     bool      	is_sending_digits;
 
@@ -38,6 +38,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cmath>
 #include <utility>
 #include <complex>
+#include <vector>
 
 
 /****************************************************************************
@@ -46,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncAudioKernels.h>
 
 
 /****************************************************************************
@@ -372,6 +374,136 @@ class Goertzel
 };  /* class Goertzel */
 
 
+/**
+@brief	A bank of Goertzel detectors that are all fed the same samples
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class do the same calculations as a number of Goertzel objects that all
+get the same input samples, e.g. the tone detectors in a DTMF decoder. Instead
+of updating one detector at a time for each sample, a whole block of samples
+is run through all detectors in one call. The state of all detectors are
+stored in arrays so that the recursion for several detectors can be
+calculated in parallel using the SIMD instructions available on the target
+CPU. The passband energy of the block, which is often used to calculate the
+relative tone energy (see the Goertzel class documentation), is calculated
+at the same time so that the samples only have to be read once.
+
+Add one bin for each frequency of interest using the addBin function, then
+call reset before each block. The block may be fed in one or more chunks
+using the calc function. The results are then read out per bin. Any
+windowing must be applied to the samples before calling calc.
+*/
+class GoertzelBank
+{
+  public:
+    /**
+     * @brief 	Default constuctor
+     */
+    GoertzelBank(void) : passband_energy(0.0f) {}
+
+    /**
+     * @brief  Add a detector bin to the bank
+     * @param  freq The frequency of interest, in Hz
+     * @param  sample_rate The sample rate used
+     * @return Returns the index of the new bin
+     */
+    size_t addBin(float freq, unsigned sample_rate)
+    {
+      float w = 2.0f * M_PI * (freq / (float)sample_rate);
+      cosw.push_back(cosf(w));
+      sinw.push_back(sinf(w));
+      two_cosw.push_back(2.0f * cosf(w));
+      minus_one.push_back(-1.0f);
+      q0.push_back(0.0f);
+      q1.push_back(0.0f);
+      return q0.size() - 1;
+    }
+
+    /**
+     * @brief  Get the number of bins in the bank
+     * @return Returns the number of bins
+     */
+    size_t size(void) const { return q0.size(); }
+
+    /**
+     * @brief 	Reset the state of all bins and the passband energy
+     */
+    void reset(void)
+    {
+      for (size_t i=0; i<q0.size(); ++i)
+      {
+        q0[i] = q1[i] = 0.0f;
+      }
+      passband_energy = 0.0f;
+    }
+
+    /**
+     * @brief 	Run a number of samples through all bins
+     * @param 	samples The samples to process
+     * @param   count The number of samples
+     */
+    void calc(const float *samples, int count)
+    {
+      if (count <= 0)
+      {
+        return;
+      }
+      passband_energy += Async::audioKernelDotProduct(samples, samples, count);
+      if (!q0.empty())
+      {
+          // A Goertzel detector is a two pole resonator with the feedback
+          // coefficients 2cos(w) and -1. No outputs are needed since only
+          // the end state is of interest.
+        Async::audioKernelResonatorBank(0, 0, 0, samples, count,
+                                        &q0[0], &q1[0], &two_cosw[0],
+                                        &minus_one[0], q0.size());
+      }
+    }
+
+    /**
+     * @brief  Get the energy of all samples fed to the bank since the reset
+     * @return Returns the sum of all squared samples
+     */
+    float passbandEnergy(void) const { return passband_energy; }
+
+    /**
+     * @brief  Calculate the final result in complex form for one bin
+     * @param  bin The bin index
+     * @return Returns the final result in complex form
+     */
+    std::complex<float> result(size_t bin) const
+    {
+      return std::complex<float>(cosw[bin] * q0[bin] - q1[bin],
+                                 sinw[bin] * q0[bin]);
+    }
+
+    /**
+     * @brief 	Read back the squared magnitude for one bin
+     * @param   bin The bin index
+     * @return	Returns the magnitude squared
+     *
+     * The value is the same as Goertzel::magnitudeSquared would give.
+     */
+    float magnitudeSquared(size_t bin) const
+    {
+      return q0[bin] * q0[bin] + q1[bin] * q1[bin] -
+             q0[bin] * q1[bin] * two_cosw[bin];
+    }
+
+  private:
+    std::vector<float> cosw;
+    std::vector<float> sinw;
+    std::vector<float> two_cosw;
+    std::vector<float> minus_one;
+    std::vector<float> q0;
+    std::vector<float> q1;
+    float              passband_energy;
+
+};  /* class GoertzelBank */
+
+
+
 //} /* namespace */
 
 #endif /* GOERTZEL_INCLUDED */
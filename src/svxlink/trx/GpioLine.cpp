@@ -0,0 +1,365 @@
+/**
+@file	 GpioLine.cpp
+@brief   A GPIO line accessed through the Linux GPIO character device
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/gpio.h>
+
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncFdWatch.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "GpioLine.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The number of line events to read in one go
+#define EVENT_BUF_CNT   16
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static bool findLineOffset(int chip_fd, const string& chip_path,
+                           const string& line, unsigned &offset);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+GpioLine::GpioLine(void)
+  : line_fd(-1), watch(0), last_value(false)
+{
+} /* GpioLine::GpioLine */
+
+
+GpioLine::~GpioLine(void)
+{
+  delete watch;
+  watch = 0;
+  if (line_fd >= 0)
+  {
+    close(line_fd);
+    line_fd = -1;
+  }
+} /* GpioLine::~GpioLine */
+
+
+bool GpioLine::openInput(const std::string& chip, const std::string& line,
+                         unsigned debounce_us, const std::string& consumer)
+{
+  if (!requestLine(chip, line, false, debounce_us, consumer) ||
+      !getValue(last_value))
+  {
+    return false;
+  }
+  watch = new FdWatch(line_fd, FdWatch::FD_WATCH_RD);
+  watch->activity.connect(mem_fun(*this, &GpioLine::eventReceived));
+  return true;
+} /* GpioLine::openInput */
+
+
+bool GpioLine::openOutput(const std::string& chip, const std::string& line,
+                          const std::string& consumer)
+{
+  return requestLine(chip, line, true, 0, consumer);
+} /* GpioLine::openOutput */
+
+
+bool GpioLine::getValue(bool &value)
+{
+  struct gpio_v2_line_values values;
+  memset(&values, 0, sizeof(values));
+  values.mask = 1;
+  if (ioctl(line_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0)
+  {
+    cerr << "*** ERROR: Could not read GPIO line value: "
+         << strerror(errno) << endl;
+    return false;
+  }
+  value = (values.bits & 1) != 0;
+  return true;
+} /* GpioLine::getValue */
+
+
+bool GpioLine::setValue(bool value)
+{
+  struct gpio_v2_line_values values;
+  memset(&values, 0, sizeof(values));
+  values.mask = 1;
+  values.bits = value ? 1 : 0;
+  if (ioctl(line_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0)
+  {
+    cerr << "*** ERROR: Could not set GPIO line value: "
+         << strerror(errno) << endl;
+    return false;
+  }
+  return true;
+} /* GpioLine::setValue */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+bool GpioLine::requestLine(const std::string& chip, const std::string& line,
+                           bool output, unsigned debounce_us,
+                           const std::string& consumer)
+{
+  string chip_path(chip);
+  if (chip_path.find('/') == string::npos)
+  {
+    chip_path = "/dev/" + chip_path;
+  }
+
+  string line_name(line);
+  bool active_low = false;
+  if ((line_name.size() > 1) && (line_name[0] == '!'))
+  {
+    active_low = true;
+    line_name.erase(0, 1);
+  }
+
+  int chip_fd = open(chip_path.c_str(), O_RDWR | O_CLOEXEC);
+  if (chip_fd < 0)
+  {
+    cerr << "*** ERROR: Could not open GPIO chip " << chip_path << ": "
+         << strerror(errno) << endl;
+    return false;
+  }
+
+  unsigned offset = 0;
+  if (!findLineOffset(chip_fd, chip_path, line_name, offset))
+  {
+    close(chip_fd);
+    return false;
+  }
+
+  struct gpio_v2_line_request req;
+  memset(&req, 0, sizeof(req));
+  req.offsets[0] = offset;
+  req.num_lines = 1;
+  strncpy(req.consumer, consumer.c_str(), sizeof(req.consumer) - 1);
+  req.config.flags = output ? GPIO_V2_LINE_FLAG_OUTPUT
+                            : (GPIO_V2_LINE_FLAG_INPUT |
+                               GPIO_V2_LINE_FLAG_EDGE_RISING |
+                               GPIO_V2_LINE_FLAG_EDGE_FALLING);
+  if (active_low)
+  {
+    req.config.flags |= GPIO_V2_LINE_FLAG_ACTIVE_LOW;
+  }
+  if (output)
+  {
+    struct gpio_v2_line_config_attribute &attr =
+        req.config.attrs[req.config.num_attrs++];
+    attr.attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+    attr.attr.values = 0;
+    attr.mask = 1;
+  }
+  if (debounce_us > 0)
+  {
+    struct gpio_v2_line_config_attribute &attr =
+        req.config.attrs[req.config.num_attrs++];
+    attr.attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+    attr.attr.debounce_period_us = debounce_us;
+    attr.mask = 1;
+  }
+
+  int ret = ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+  int saved_errno = errno;
+  close(chip_fd);
+  if (ret < 0)
+  {
+    cerr << "*** ERROR: Could not request GPIO line " << line_name
+         << " on " << chip_path << ": " << strerror(saved_errno) << endl;
+    return false;
+  }
+  line_fd = req.fd;
+
+  return true;
+} /* GpioLine::requestLine */
+
+
+void GpioLine::eventReceived(FdWatch *w)
+{
+  struct gpio_v2_line_event events[EVENT_BUF_CNT];
+  ssize_t cnt = read(line_fd, events, sizeof(events));
+  if (cnt < 0)
+  {
+    if ((errno != EAGAIN) && (errno != EINTR))
+    {
+      cerr << "*** ERROR: Could not read GPIO line event: "
+           << strerror(errno) << endl;
+    }
+    return;
+  }
+
+    // Several edges may have been queued so the value is read back instead
+    // of derived from the events. That way the state can never get out of
+    // sync with the line, even if the kernel event buffer overflowed.
+  bool value = last_value;
+  if (getValue(value) && (value != last_value))
+  {
+    last_value = value;
+    valueChanged(value);
+  }
+} /* GpioLine::eventReceived */
+
+
+static bool findLineOffset(int chip_fd, const string& chip_path,
+                           const string& line, unsigned &offset)
+{
+  struct gpiochip_info chip_info;
+  memset(&chip_info, 0, sizeof(chip_info));
+  if (ioctl(chip_fd, GPIO_GET_CHIPINFO_IOCTL, &chip_info) < 0)
+  {
+    cerr << "*** ERROR: Could not read GPIO chip info for " << chip_path
+         << ": " << strerror(errno) << endl;
+    return false;
+  }
+
+  char *endptr = 0;
+  unsigned long num = strtoul(line.c_str(), &endptr, 10);
+  if (!line.empty() && (*endptr == '\0'))
+  {
+    if (num >= chip_info.lines)
+    {
+      cerr << "*** ERROR: GPIO line " << line << " out of range for "
+           << chip_path << " which have " << chip_info.lines << " lines\n";
+      return false;
+    }
+    offset = num;
+    return true;
+  }
+
+  for (unsigned i=0; i<chip_info.lines; ++i)
+  {
+    struct gpio_v2_line_info info;
+    memset(&info, 0, sizeof(info));
+    info.offset = i;
+    if ((ioctl(chip_fd, GPIO_V2_GET_LINEINFO_IOCTL, &info) == 0) &&
+        (line == info.name))
+    {
+      offset = i;
+      return true;
+    }
+  }
+
+  cerr << "*** ERROR: Could not find a GPIO line named \"" << line
+       << "\" on " << chip_path << endl;
+  return false;
+} /* findLineOffset */
+
+
+
+/*
+ * This file has not been truncated
+ */
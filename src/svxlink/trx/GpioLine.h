@@ -0,0 +1,206 @@
+/**
+@file	 GpioLine.h
+@brief   A GPIO line accessed through the Linux GPIO character device
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef GPIO_LINE_INCLUDED
+#define GPIO_LINE_INCLUDED
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class FdWatch;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A GPIO line accessed through the Linux GPIO character device
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class request a single line from a /dev/gpiochipN device using the
+version 2 GPIO character device interface. An input line is requested with
+edge detection so that the kernel report every change as an event on the file
+descriptor. The events are picked up by an FdWatch so no polling is needed.
+The kernel can also debounce an input line before reporting an edge.
+
+Active low operation is handled by the kernel so the values used by this
+class are always the logical values, \em true meaning active.
+*/
+class GpioLine : public sigc::trackable
+{
+  public:
+    /**
+     * @brief 	Default constructor
+     */
+    GpioLine(void);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~GpioLine(void);
+
+    /**
+     * @brief   Request a line for input with edge detection
+     * @param   chip The chip name (gpiochip0) or device path
+     * @param   line The line offset or line name. Prefix with ! to invert.
+     * @param   debounce_us The debounce period in microseconds, 0 for none
+     * @param   consumer The consumer name shown for the line by the kernel
+     * @return  Returns \em true on success or else \em false
+     */
+    bool openInput(const std::string& chip, const std::string& line,
+                   unsigned debounce_us, const std::string& consumer);
+
+    /**
+     * @brief   Request a line for output
+     * @param   chip The chip name (gpiochip0) or device path
+     * @param   line The line offset or line name. Prefix with ! to invert.
+     * @param   consumer The consumer name shown for the line by the kernel
+     * @return  Returns \em true on success or else \em false
+     *
+     * The line is initially set to inactive.
+     */
+    bool openOutput(const std::string& chip, const std::string& line,
+                    const std::string& consumer);
+
+    /**
+     * @brief   Read the current value of the line
+     * @param   value Set to \em true if the line is active
+     * @return  Returns \em true on success or else \em false
+     */
+    bool getValue(bool &value);
+
+    /**
+     * @brief   Set the value of an output line
+     * @param   value Set to \em true to make the line active
+     * @return  Returns \em true on success or else \em false
+     */
+    bool setValue(bool value);
+
+    /**
+     * @brief   A signal that is emitted when the value of an input changes
+     * @param   is_active \em true if the line is now active
+     */
+    sigc::signal<void, bool> valueChanged;
+
+  protected:
+
+  private:
+    int             line_fd;
+    Async::FdWatch  *watch;
+    bool            last_value;
+
+    GpioLine(const GpioLine&);
+    GpioLine& operator=(const GpioLine&);
+    bool requestLine(const std::string& chip, const std::string& line,
+                     bool output, unsigned debounce_us,
+                     const std::string& consumer);
+    void eventReceived(Async::FdWatch *w);
+
+};  /* class GpioLine */
+
+
+//} /* namespace */
+
+#endif /* GPIO_LINE_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
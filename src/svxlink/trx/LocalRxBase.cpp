@@ -41,6 +41,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cmath>
 #include <cstring>
 #include <limits>
+#include <vector>
+#include <algorithm>
 #include <json/json.h>
 
 
@@ -62,7 +64,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioFifo.h>
 #include <AsyncAudioStreamStateDetector.h>
 #include <AsyncAudioFsf.h>
+#include <AsyncAudioTraceTagger.h>
 #include <AsyncUdpSocket.h>
+#include <AsyncAudioMultirateCoeffs.h>
 #include <common.h>
 
 
@@ -75,13 +79,14 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "SigLevDet.h"
 #include "DtmfDecoder.h"
 #include "ToneDetector.h"
+#include "ToneDetectorBank.h"
 #include "SquelchCtcss.h"
 #include "LocalRxBase.h"
-#include "multirate_filter_coeff.h"
 #include "Sel5Decoder.h"
 #include "AfskDemodulator.h"
 #include "Synchronizer.h"
 #include "HdlcDeframer.h"
+#include "AfskMultiDecoder.h"
 #include "Tx.h"
 #include "Emphasis.h"
 
@@ -154,10 +159,30 @@ class AudioUdpSink : public UdpSocket, public AudioSink
     AudioUdpSink(const IpAddress &remote_ip, uint16_t remote_port,
                  uint16_t local_port=0, const IpAddress &bind_ip=IpAddress())
       : UdpSocket(local_port, bind_ip), remote_ip(remote_ip),
-        remote_port(remote_port)
+        remote_port(remote_port), max_samples(0)
     {
     }
 
+    /**
+     * @brief   Coalesce samples into datagrams of at most the given size
+     * @param   mtu The path MTU, including the IP and UDP headers
+     *
+     * Written samples are collected until a full datagram can be sent.
+     * Large writes are split up into several datagrams which are sent
+     * using one system call. An MTU of zero sends one datagram per write.
+     */
+    void setMtu(size_t mtu)
+    {
+      max_samples = (mtu > IP_UDP_HEADER_SIZE)
+                    ? (mtu - IP_UDP_HEADER_SIZE) / sizeof(float) : 0;
+      pending.clear();
+      if (max_samples > 0)
+      {
+        pending.reserve(max_samples);
+        setBatchMode(BATCH_SIZE, max(mtu, static_cast<size_t>(2048)));
+      }
+    }
+
     /**
      * @brief   Write samples into this audio sink
      * @param   samples The buffer containing the samples
@@ -171,9 +196,33 @@ class AudioUdpSink : public UdpSocket, public AudioSink
      */
     virtual int writeSamples(const float *samples, int count)
     {
-      const char *buf = reinterpret_cast<const char *>(samples);
-      size_t len = count * sizeof(*samples);
-      UdpSocket::write(remote_ip, remote_port, buf, len);
+      if (max_samples == 0)
+      {
+        sendDatagram(samples, count);
+        return count;
+      }
+
+      beginWriteBatch();
+      const float *end = samples + count;
+      while (samples < end)
+      {
+        if (pending.empty() && (end - samples >= int(max_samples)))
+        {
+          sendDatagram(samples, max_samples);
+          samples += max_samples;
+          continue;
+        }
+        const size_t n = min(size_t(end - samples),
+                             max_samples - pending.size());
+        pending.insert(pending.end(), samples, samples + n);
+        samples += n;
+        if (pending.size() == max_samples)
+        {
+          sendDatagram(&pending[0], pending.size());
+          pending.clear();
+        }
+      }
+      flushWriteBatch();
       return count;
     }
 
@@ -187,12 +236,30 @@ class AudioUdpSink : public UdpSocket, public AudioSink
      */
     virtual void flushSamples(void)
     {
+      beginWriteBatch();
+      if (!pending.empty())
+      {
+        sendDatagram(&pending[0], pending.size());
+        pending.clear();
+      }
       UdpSocket::write(remote_ip, remote_port, NULL, 0);
+      flushWriteBatch();
     }
 
   private:
+    static const size_t   IP_UDP_HEADER_SIZE = 28;
+    static const unsigned BATCH_SIZE = 16;
+
     Async::IpAddress  remote_ip;
     uint16_t          remote_port;
+    size_t            max_samples;
+    vector<float>     pending;
+
+    void sendDatagram(const float *samples, size_t count)
+    {
+      const char *buf = reinterpret_cast<const char *>(samples);
+      UdpSocket::write(remote_ip, remote_port, buf, count * sizeof(*samples));
+    }
 
 };
 
@@ -234,7 +301,7 @@ namespace {
 LocalRxBase::LocalRxBase(Config &cfg, const std::string& name)
   : Rx(cfg, name), mute_state(MUTE_ALL),
     squelch_det(0), siglevdet(0), /* siglev_offset(0.0), siglev_slope(1.0), */
-    tone_dets(0), sql_valve(0), delay(0), sql_tail_elim(0),
+    tone_dets(0), tone_det_bank(0), sql_valve(0), delay(0), sql_tail_elim(0),
     preamp_gain(0), mute_valve(0), sql_hangtime(0), sql_extended_hangtime(0),
     sql_extended_hangtime_thresh(0), input_fifo(0), dtmf_muting_pre(0),
     ob_afsk_deframer(0), ib_afsk_deframer(0), audio_dev_keep_open(false)
@@ -286,16 +353,23 @@ bool LocalRxBase::initialize(void)
   AudioSource *prev_src = audioSource();
   assert(prev_src != 0);
 
+    // Tag the captured audio when tracing the audio latency
+  AudioTraceTagger *capture_tagger = new AudioTraceTagger(name() + ":capture");
+  prev_src->registerSink(capture_tagger, true);
+  prev_src = capture_tagger;
+
     // Valve used to mute the audio device on MUTE_ALL
   mute_valve = new Async::AudioValve;
   mute_valve->setOpen(false);
   prev_src->registerSink(mute_valve, true);
+  mute_valve->setProfileName(name() + ":mute_valve");
   prev_src = mute_valve;
 
     // Create a fifo buffer to handle large audio blocks
   input_fifo = new AudioFifo(1024);
 //  input_fifo->setOverwrite(true);
   prev_src->registerSink(input_fifo);
+  input_fifo->setProfileName(name() + ":input_fifo");
   prev_src = input_fifo;
 
   SvxLink::SepPair<string, uint16_t> raw_audio_fwd_dest;
@@ -314,6 +388,9 @@ bool LocalRxBase::initialize(void)
       return false;
 
     }
+    size_t raw_audio_udp_mtu = 0;
+    cfg().getValue(name(), "RAW_AUDIO_UDP_MTU", raw_audio_udp_mtu);
+    udp->setMtu(raw_audio_udp_mtu);
     raw_audio_splitter->addSink(udp, true);
   }
   
@@ -323,6 +400,7 @@ bool LocalRxBase::initialize(void)
     AudioAmp *preamp = new AudioAmp;
     preamp->setGain(preamp_gain);
     prev_src->registerSink(preamp, true);
+    preamp->setProfileName(name() + ":preamp");
     prev_src = preamp;
   }
   
@@ -331,6 +409,7 @@ bool LocalRxBase::initialize(void)
   {
     PeakMeter *peak_meter = new PeakMeter(name());
     prev_src->registerSink(peak_meter, true);
+    peak_meter->setProfileName(name() + ":peak_meter");
     prev_src = peak_meter;
   }
   
@@ -341,12 +420,14 @@ bool LocalRxBase::initialize(void)
     AudioDecimator *d1 = new AudioDecimator(3, coeff_48_16_wide,
 					    coeff_48_16_wide_taps);
     prev_src->registerSink(d1, true);
+    d1->setProfileName(name() + ":decimator");
     prev_src = d1;
   }
 
   AudioSplitter *siglevdet_splitter = 0;
   siglevdet_splitter = new AudioSplitter;
   prev_src->registerSink(siglevdet_splitter, true);
+  siglevdet_splitter->setProfileName(name() + ":siglevdet_splitter");
   prev_src = 0;
 
     // Create the signal level detector
@@ -391,12 +472,14 @@ bool LocalRxBase::initialize(void)
 
     DeemphasisFilter *deemph_filt = new DeemphasisFilter;
     prev_src->registerSink(deemph_filt, true);
+    deemph_filt->setProfileName(name() + ":deemphasis");
     prev_src = deemph_filt;
   }
   
     // Create a splitter to distribute full bandwidth audio to all consumers
   AudioSplitter *fullband_splitter = new AudioSplitter;
   prev_src->registerSink(fullband_splitter, true);
+  fullband_splitter->setProfileName(name() + ":fullband_splitter");
   prev_src = fullband_splitter;
 
     // Create the configured squelch detector and initialize it
@@ -471,21 +554,35 @@ bool LocalRxBase::initialize(void)
     fullband_splitter->addSink(fsf, true);
     AudioSource *prev_src = fsf;
 
-    AfskDemodulator *fsk_demod =
-      new AfskDemodulator(fc - shift/2, fc + shift/2, baudrate);
-    //fullband_splitter->addSink(fsk_demod, true);
-    prev_src->registerSink(fsk_demod, true);
-    prev_src = fsk_demod;
-
-    Synchronizer *sync = new Synchronizer(baudrate);
-    prev_src->registerSink(sync, true);
-    prev_src = 0;
-
-    ob_afsk_deframer = new HdlcDeframer;
-    ob_afsk_deframer->frameReceived.connect(
-        mem_fun(*this, &LocalRxBase::dataFrameReceived));
-    sync->bitsReceived.connect(
-        mem_fun(ob_afsk_deframer, &HdlcDeframer::bitsReceived));
+    unsigned decoders = 1;
+    cfg().getValue(name(), "OB_AFSK_DECODERS", decoders);
+    if (decoders > 1)
+    {
+      AfskMultiDecoder *multi_dec =
+        new AfskMultiDecoder(fc - shift/2, fc + shift/2, baudrate, decoders);
+      multi_dec->frameReceived.connect(
+          mem_fun(*this, &LocalRxBase::dataFrameReceived));
+      prev_src->registerSink(multi_dec, true);
+      prev_src = 0;
+    }
+    else
+    {
+      AfskDemodulator *fsk_demod =
+        new AfskDemodulator(fc - shift/2, fc + shift/2, baudrate);
+      //fullband_splitter->addSink(fsk_demod, true);
+      prev_src->registerSink(fsk_demod, true);
+      prev_src = fsk_demod;
+
+      Synchronizer *sync = new Synchronizer(baudrate);
+      prev_src->registerSink(sync, true);
+      prev_src = 0;
+
+      ob_afsk_deframer = new HdlcDeframer;
+      ob_afsk_deframer->frameReceived.connect(
+          mem_fun(*this, &LocalRxBase::dataFrameReceived));
+      sync->bitsReceived.connect(
+          mem_fun(ob_afsk_deframer, &HdlcDeframer::bitsReceived));
+    }
   }
 
   bool ib_afsk_enable = false;
@@ -498,26 +595,64 @@ bool LocalRxBase::initialize(void)
     unsigned baudrate = 1200;
     //cfg().getValue(name(), "IB_AFSK_BAUDRATE", baudrate);
 
-    AfskDemodulator *fsk_demod =
-      new AfskDemodulator(fc - shift/2, fc + shift/2, baudrate);
-    fullband_splitter->addSink(fsk_demod, true);
-    AudioSource *prev_src = fsk_demod;
-
-    Synchronizer *sync = new Synchronizer(baudrate);
-    prev_src->registerSink(sync, true);
-    prev_src = 0;
-
-    ib_afsk_deframer = new HdlcDeframer;
-    ib_afsk_deframer->frameReceived.connect(
-        mem_fun(*this, &LocalRxBase::dataFrameReceivedIb));
-    sync->bitsReceived.connect(
-        mem_fun(ib_afsk_deframer, &HdlcDeframer::bitsReceived));
+    unsigned decoders = 1;
+    cfg().getValue(name(), "IB_AFSK_DECODERS", decoders);
+    if (decoders > 1)
+    {
+      AfskMultiDecoder *multi_dec =
+        new AfskMultiDecoder(fc - shift/2, fc + shift/2, baudrate, decoders);
+      multi_dec->frameReceived.connect(
+          mem_fun(*this, &LocalRxBase::dataFrameReceivedIb));
+      fullband_splitter->addSink(multi_dec, true);
+    }
+    else
+    {
+      AfskDemodulator *fsk_demod =
+        new AfskDemodulator(fc - shift/2, fc + shift/2, baudrate);
+      fullband_splitter->addSink(fsk_demod, true);
+      AudioSource *prev_src = fsk_demod;
+
+      Synchronizer *sync = new Synchronizer(baudrate);
+      prev_src->registerSink(sync, true);
+      prev_src = 0;
+
+      ib_afsk_deframer = new HdlcDeframer;
+      ib_afsk_deframer->frameReceived.connect(
+          mem_fun(*this, &LocalRxBase::dataFrameReceivedIb));
+      sync->bitsReceived.connect(
+          mem_fun(ib_afsk_deframer, &HdlcDeframer::bitsReceived));
+    }
   }
 
     // Create a new audio splitter to handle tone detectors
   tone_dets = new AudioSplitter;
   prev_src->registerSink(tone_dets, true);
+  tone_dets->setProfileName(name() + ":tone_dets");
   prev_src = tone_dets;
+    // The tone detector bank is not fed any audio until the first tone
+    // detector is added
+  tone_det_bank = new ToneDetectorBank;
+  tone_dets->addSink(tone_det_bank, true);
+  tone_dets->enableSink(tone_det_bank, false);
+
+  string dtmf_dec_type("NONE");
+  cfg().getValue(name(), "DTMF_DEC_TYPE", dtmf_dec_type);
+  string sel5_dec_type("NONE");
+  cfg().getValue(name(), "SEL5_DEC_TYPE", sel5_dec_type);
+
+    // If nothing but the receiver audio output use the voiceband audio, the
+    // squelch valve is placed before the voiceband filter so that the
+    // filter only run when the squelch is open
+  const bool voiceband_consumers =
+    (dtmf_dec_type != "NONE") || (sel5_dec_type != "NONE") || mute_1750;
+  sql_valve = new AudioValve;
+  sql_valve->setOpen(false);
+  sql_valve->setProfileName(name() + ":sql_valve");
+  if (!voiceband_consumers)
+  {
+    prev_src->registerSink(sql_valve, true);
+    prev_src = sql_valve;
+  }
 
     // Filter out the voice band, removing high- and subaudible frequencies,
     // for example CTCSS.
@@ -527,17 +662,21 @@ bool LocalRxBase::initialize(void)
   AudioFilter *voiceband_filter = new AudioFilter("BpCh12/-0.1/300-3500");
 #endif
   prev_src->registerSink(voiceband_filter, true);
+  voiceband_filter->setProfileName(name() + ":voiceband_filter");
   prev_src = voiceband_filter;
 
     // Create an audio splitter to distribute the voiceband audio to all
     // other consumers
-  AudioSplitter *voiceband_splitter = new AudioSplitter;
-  prev_src->registerSink(voiceband_splitter, true);
-  prev_src = voiceband_splitter;
+  AudioSplitter *voiceband_splitter = 0;
+  if (voiceband_consumers)
+  {
+    voiceband_splitter = new AudioSplitter;
+    prev_src->registerSink(voiceband_splitter, true);
+    voiceband_splitter->setProfileName(name() + ":voiceband_splitter");
+    prev_src = voiceband_splitter;
+  }
 
     // Create the configured type of DTMF decoder and add it to the splitter
-  string dtmf_dec_type("NONE");
-  cfg().getValue(name(), "DTMF_DEC_TYPE", dtmf_dec_type);
   if (dtmf_dec_type != "NONE")
   {
     DtmfDecoder *dtmf_dec = DtmfDecoder::create(this, cfg(), name());
@@ -563,8 +702,6 @@ bool LocalRxBase::initialize(void)
   }
   
     // Create a selective multiple tone detector object
-  string sel5_dec_type("NONE");
-  cfg().getValue(name(), "SEL5_DEC_TYPE", sel5_dec_type);
   if (sel5_dec_type != "NONE")
   {
     Sel5Decoder *sel5_dec = Sel5Decoder::create(cfg(), name());
@@ -579,11 +716,13 @@ bool LocalRxBase::initialize(void)
     voiceband_splitter->addSink(sel5_dec, true);
   }
 
-    // Create an audio valve to use as squelch and connect it to the splitter
-  sql_valve = new AudioValve;
-  sql_valve->setOpen(false);
-  prev_src->registerSink(sql_valve, true);
-  prev_src = sql_valve;
+    // Connect the squelch valve to the splitter, unless it was placed
+    // before the voiceband filter
+  if (voiceband_consumers)
+  {
+    prev_src->registerSink(sql_valve, true);
+    prev_src = sql_valve;
+  }
 
     // Create the state detector
   AudioStreamStateDetector *state_det = new AudioStreamStateDetector;
@@ -597,7 +736,11 @@ bool LocalRxBase::initialize(void)
   if (delay_line_len > 0)
   {
     delay = new AudioDelayLine(delay_line_len);
+    bool delay_line_compact = false;
+    cfg().getValue(name(), "DELAY_LINE_COMPACT", delay_line_compact);
+    delay->setCompactStorage(delay_line_compact);
     prev_src->registerSink(delay, true);
+    delay->setProfileName(name() + ":delay_line");
     prev_src = delay;
   }
 
@@ -613,6 +756,7 @@ bool LocalRxBase::initialize(void)
     limit->setDecay(20);
     limit->setOutputGain(1);
     prev_src->registerSink(limit, true);
+    limit->setProfileName(name() + ":limiter");
     prev_src = limit;
   }
 
@@ -620,6 +764,7 @@ bool LocalRxBase::initialize(void)
   AudioClipper *clipper = new AudioClipper;
   clipper->setClipLevel(0.98);
   prev_src->registerSink(clipper, true);
+  clipper->setProfileName(name() + ":clipper");
   prev_src = clipper;
 
     // Remove high frequencies generated by the previous clipping
@@ -629,6 +774,7 @@ bool LocalRxBase::initialize(void)
   AudioFilter *splatter_filter = new AudioFilter("LpCh9/-0.05/3500");
 #endif
   prev_src->registerSink(splatter_filter, true);
+  splatter_filter->setProfileName(name() + ":splatter_filter");
   prev_src = splatter_filter;
   
     // Set the previous audio pipe object to handle audio distribution for
@@ -738,7 +884,8 @@ bool LocalRxBase::addToneDetector(float fq, int bw, float thresh,
   det->setPeakThresh(thresh);
   det->detected.connect(sigc::mem_fun(*this, &LocalRxBase::onToneDetected));
   
-  tone_dets->addSink(det, true);
+  tone_det_bank->addDetector(det, true);
+  tone_dets->enableSink(tone_det_bank, true);
   
   return true;
 
@@ -764,7 +911,8 @@ char LocalRxBase::sqlRxId(void) const
 void LocalRxBase::reset(void)
 {
   setMuteState(Rx::MUTE_ALL);
-  tone_dets->removeAllSinks();
+  tone_det_bank->removeAllDetectors();
+  tone_dets->enableSink(tone_det_bank, false);
   if (delay != 0)
   {
     delay->mute(false);
@@ -829,7 +977,7 @@ void LocalRxBase::onToneDetected(float fq)
 } /* LocalRxBase::onToneDetected */
 
 
-void LocalRxBase::dataFrameReceived(vector<uint8_t> frame)
+void LocalRxBase::dataFrameReceived(vector<uint8_t> &frame)
 {
   vector<uint8_t>::const_iterator it = frame.begin();
   if ((frame.size() == 5) && (*it++ == Tx::DATA_CMD_TONE_DETECTED))
@@ -853,11 +1001,11 @@ void LocalRxBase::dataFrameReceived(vector<uint8_t> frame)
 } /* LocalRxBase::dataFrameReceived */
 
 
-void LocalRxBase::dataFrameReceivedIb(vector<uint8_t> frame)
+void LocalRxBase::dataFrameReceivedIb(vector<uint8_t> &frame)
 {
   cout << "### Inband data frame received: len=" << frame.size() << endl;
   dataFrameReceived(frame);
-} /* LocalRxBase::dataFrameReceived */
+} /* LocalRxBase::dataFrameReceivedIb */
 
 
 void LocalRxBase::audioStreamStateChange(bool is_active, bool is_idle)
@@ -78,6 +78,7 @@ namespace Async
 };
 
 class Squelch;
+class ToneDetectorBank;
 class HdlcDeframer;
 
 
@@ -241,6 +242,7 @@ class LocalRxBase : public Rx
     Squelch   	      	      	*squelch_det;
     SigLevDet 	      	        *siglevdet;
     Async::AudioSplitter      	*tone_dets;
+    ToneDetectorBank            *tone_det_bank;
     Async::AudioValve 	        *sql_valve;
     Async::AudioDelayLine     	*delay;
     int       	      	      	sql_tail_elim;
@@ -258,8 +260,8 @@ class LocalRxBase : public Rx
     int audioRead(float *samples, int count);
     void dtmfDigitActivated(char digit);
     void onToneDetected(float fq);
-    void dataFrameReceived(std::vector<uint8_t> frame);
-    void dataFrameReceivedIb(std::vector<uint8_t> frame);
+    void dataFrameReceived(std::vector<uint8_t> &frame);
+    void dataFrameReceivedIb(std::vector<uint8_t> &frame);
     void dtmfDigitDeactivated(char digit, int duration_ms);
     void sel5Detected(std::string sequence);
     void audioStreamStateChange(bool is_active, bool is_idle);
@@ -71,10 +71,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioMixer.h>
 #include <AsyncAudioDebugger.h>
 #include <AsyncAudioPacer.h>
+#include <AsyncAudioOscillator.h>
+#include <AsyncAudioStreamStateDetector.h>
 #include <common.h>
 #include <HdlcFramer.h>
 #include <AfskModulator.h>
 #include <AsyncAudioFsf.h>
+#include <AsyncAudioMultirateCoeffs.h>
 
 
 /****************************************************************************
@@ -85,12 +88,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "LocalTx.h"
 #include "DtmfEncoder.h"
-#include "multirate_filter_coeff.h"
 #include "PttCtrl.h"
 #include "SigLevDetAfsk.h"
 #include "Rx.h"
-#include "Emphasis.h"
 #include "Ptt.h"
+#include "TxAudioConditioner.h"
 
 
 /****************************************************************************
@@ -113,7 +115,6 @@ using namespace SvxLink;
  ****************************************************************************/
 
 #define USE_AUDIO_VALVE         0
-#define DEFAULT_LIMITER_THRESH  0.0
 
 
 /****************************************************************************
@@ -126,10 +127,11 @@ class SineGenerator : public Async::AudioSource
 {
   public:
     explicit SineGenerator(const string& audio_dev, int channel)
-      : audio_io(audio_dev, channel), pos(0), fq(0.0), level(0.0),
-        sample_rate(0), audio_dev_keep_open(false)
+      : audio_io(audio_dev, channel), fq(0.0), sample_rate(0),
+        audio_dev_keep_open(false)
     {
       sample_rate = audio_io.sampleRate();
+      osc.setFq(fq, sample_rate);
       audio_io.registerSource(this);
     }
     
@@ -141,11 +143,12 @@ class SineGenerator : public Async::AudioSource
     void setFq(double tone_fq)
     {
       fq = tone_fq;
+      osc.setFq(fq, sample_rate);
     }
     
     void setLevel(int level_percent)
     {
-      level = level_percent / 100.0;
+      osc.setAmplitude(level_percent / 100.0);
     }
 
     void setKeepOpen(bool keep_open)
@@ -164,7 +167,7 @@ class SineGenerator : public Async::AudioSource
       {
       	if (audio_io.open(AudioIO::MODE_WR))
         {
-          pos = 0;
+          osc.reset();
           writeSamples();
         }
       }
@@ -190,24 +193,20 @@ class SineGenerator : public Async::AudioSource
   private:
     static const int BLOCK_SIZE = 128;
     
-    AudioIO   audio_io;
-    unsigned  pos;
-    double    fq;
-    double    level;
-    int       sample_rate;
-    bool      audio_dev_keep_open;
+    AudioIO         audio_io;
+    double          fq;
+    int             sample_rate;
+    bool            audio_dev_keep_open;
+    AudioOscillator osc;
     
     void writeSamples(void)
     {
       int written;
       do {
 	float buf[BLOCK_SIZE];
-	for (int i=0; i<BLOCK_SIZE; ++i)
-	{
-      	  buf[i] = level * sin(2 * M_PI * fq * (pos+i) / sample_rate);
-	}
+        osc.generate(buf, BLOCK_SIZE);
 	written = sinkWriteSamples(buf, BLOCK_SIZE);
-	pos += written;
+        osc.advance(written);
       } while (written != 0);
     }
     
@@ -251,7 +250,8 @@ LocalTx::LocalTx(Config& cfg, const string& name)
     fsk_mod(0), /*fsk_valve(0),*/ input_handler(0), ptt_ctrl(0),
     audio_valve(0), siglev_sine_gen(0), ptt_hangtimer(0), ptt(0),
     last_rx_id(Rx::ID_UNKNOWN), fsk_first_packet_transmitted(false),
-    hdlc_framer_ib(0), fsk_mod_ib(0), ctrl_pty(0), audio_dev_keep_open(false)
+    hdlc_framer_ib(0), fsk_mod_ib(0), ctrl_pty(0), audio_dev_keep_open(false),
+    ext_audio_conditioning(false)
 {
 
 } /* LocalTx::LocalTx */
@@ -442,79 +442,16 @@ bool LocalTx::initialize(void)
   setHandler(input_handler);
   prev_src = input_handler;
   
-  /*
-  AudioCompressor *comp = new AudioCompressor;
-  comp->setThreshold(-10);
-  comp->setRatio(0.25);
-  comp->setAttack(10);
-  comp->setDecay(100);
-  comp->setOutputGain(0);
-  prev_src->registerSink(comp, true);
-  prev_src = comp;
-  */
-  
-    // If preemphasis is enabled, create the preemphasis filter
-  if (cfg.getValue(name(), "PREEMPHASIS", value) && (atoi(value.c_str()) != 0))
+    // Condition the audio (pre-emphasis, limiter, clipper and voiceband
+    // filter) unless that is already done by someone else, like a MultiTx
+    // that share one conditioning chain between multiple transmitters.
+  if (!ext_audio_conditioning)
   {
-    //AudioFilter *preemph = new AudioFilter("HsBq1/0.05/36/3500");
-    //preemph->setOutputGain(-9.0f);
-    /*
-#if INTERNAL_SAMPLE_RATE < 16000
-    AudioFilter *preemph = new AudioFilter("LpBu1/3000 x HpBu1/3000");
-    preemph->setOutputGain(26);
-#else
-    AudioFilter *preemph = new AudioFilter("LpBu3/5500 x HpBu1/3000");
-    preemph->setOutputGain(21);
-#endif
-    */
-
-    PreemphasisFilter *preemph = new PreemphasisFilter;
-    prev_src->registerSink(preemph, true);
-    prev_src = preemph;
+    TxAudioConditioner *conditioner = new TxAudioConditioner(cfg, name());
+    prev_src->registerSink(conditioner, true);
+    prev_src = conditioner;
   }
 
-    // Add a limiter to smoothly limit the audio before hard clipping it
-  double limiter_thresh = DEFAULT_LIMITER_THRESH;
-  cfg.getValue(name(), "LIMITER_THRESH", limiter_thresh);
-  if (limiter_thresh != 0.0)
-  {
-    AudioCompressor *limit = new AudioCompressor;
-    limit->setThreshold(limiter_thresh);
-    limit->setRatio(0.1);
-    limit->setAttack(2);
-    limit->setDecay(20);
-    limit->setOutputGain(1);
-    prev_src->registerSink(limit, true);
-    prev_src = limit;
-  }
-
-    // Clip audio to limit its amplitude
-  AudioClipper *clipper = new AudioClipper;
-  prev_src->registerSink(clipper, true);
-  prev_src = clipper;
-  
-#if 0
-    // Filter out high frequencies generated by the previous clipping
-#if (INTERNAL_SAMPLE_RATE == 16000)
-  //AudioFilter *splatter_filter = new AudioFilter("LpBu10/5500");
-  AudioFilter *splatter_filter = new AudioFilter("LpCh9/-0.05/5500");
-#else
-  AudioFilter *splatter_filter = new AudioFilter("LpBu20/3500");
-#endif
-  prev_src->registerSink(splatter_filter, true);
-  prev_src = splatter_filter;
-#endif
-
-#if (INTERNAL_SAMPLE_RATE == 16000)
-  AudioFilter *voiceband_filter =
-    new AudioFilter("LpCh9/-0.05/5500 x HpCh12/-0.05/300");
-#else
-  AudioFilter *voiceband_filter =
-    new AudioFilter("LpBu20/3500 x HpCh12/-0.05/300");
-#endif
-  prev_src->registerSink(voiceband_filter, true);
-  prev_src = voiceband_filter;
-
     // Create a valve so that we can control when to transmit audio
   #if USE_AUDIO_VALVE
   audio_valve = new AudioValve;
@@ -704,7 +641,16 @@ bool LocalTx::initialize(void)
     prev_src = i2;
   }
   
+    // Detect when the first audio sample of a transmission reach the audio
+    // device so that the transmit latency can be measured
+  AudioStreamStateDetector *audio_start_det = new AudioStreamStateDetector;
+  audio_start_det->sigStreamStateChanged.connect(
+      mem_fun(*this, &LocalTx::audioStreamStateChanged));
+  prev_src->registerSink(audio_start_det, true);
+  prev_src = audio_start_det;
+
     // Finally connect the whole audio pipe to the audio device
+  audio_io->setProfileName(name() + ":audio_io");
   prev_src->registerSink(audio_io, true);
 
   string ctrl_pty_name;
@@ -723,6 +669,13 @@ bool LocalTx::initialize(void)
 } /* LocalTx::initialize */
 
 
+bool LocalTx::useExternalAudioConditioning(void)
+{
+  ext_audio_conditioning = true;
+  return true;
+} /* LocalTx::useExternalAudioConditioning */
+
+
 void LocalTx::setTxCtrlMode(Tx::TxCtrlMode mode)
 {
   ptt_ctrl->setTxCtrlMode(mode);
@@ -986,6 +939,15 @@ void LocalTx::txTimeoutOccured(Timer *t)
 } /* LocalTx::txTimeoutOccured */
 
 
+void LocalTx::audioStreamStateChanged(bool is_active, bool is_idle)
+{
+  if (is_active)
+  {
+    txAudioStarted();
+  }
+} /* LocalTx::audioStreamStateChanged */
+
+
 bool LocalTx::setPtt(bool tx, bool with_hangtime)
 {
   if (ptt_hangtimer != 0)
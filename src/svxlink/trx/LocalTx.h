@@ -152,6 +152,12 @@ class LocalTx : public Tx
      * @return 	Return \em true on success, or \em false on failure
      */
     bool initialize(void);
+
+    /**
+     * @brief   Let someone else condition the audio for this transmitter
+     * @return  Returns \em true since this is supported by LocalTx
+     */
+    virtual bool useExternalAudioConditioning(void);
   
     /**
      * @brief 	Set the transmit control mode
@@ -236,6 +242,7 @@ class LocalTx : public Tx
     AfskModulator           *fsk_mod_ib;
     RefCountingPty          *ctrl_pty;
     bool                    audio_dev_keep_open;
+    bool                    ext_audio_conditioning;
     
     void txTimeoutOccured(Async::Timer *t);
     bool setPtt(bool tx, bool with_hangtime=false);
@@ -243,6 +250,7 @@ class LocalTx : public Tx
     void allDtmfDigitsSent(void);
     void pttHangtimeExpired(Async::Timer *t);
     bool preTransmitterStateChange(bool do_transmit);
+    void audioStreamStateChanged(bool is_active, bool is_idle);
     void sendFskSiglev(char rxid, uint8_t siglev);
     void sendFskDtmf(const std::string &digits, unsigned duration);
 
@@ -34,6 +34,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <iostream>
 #include <algorithm>
+#include <vector>
+#include <map>
 
 
 /****************************************************************************
@@ -54,6 +56,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "MultiTx.h"
+#include "TxAudioConditioner.h"
 
 
 
@@ -117,7 +120,8 @@ using namespace Async;
 
 MultiTx::MultiTx(Config& cfg, const string& name)
   : Tx(name), cfg(cfg), splitter(0),
-    m_tx_state_delay_timer(100, Async::Timer::TYPE_ONESHOT, false)
+    m_tx_state_delay_timer(100, Async::Timer::TYPE_ONESHOT, false),
+    tx_audio_started(false)
 {
   m_tx_state_delay_timer.expired.connect(
       sigc::hide(sigc::mem_fun(*this, &MultiTx::txStateDelayExpired)));
@@ -158,6 +162,7 @@ bool MultiTx::initialize(void)
   
   splitter = new AudioSplitter;
   
+  vector<string> tx_names;
   string::iterator start(transmitters.begin());
   for (;;)
   {
@@ -165,21 +170,7 @@ bool MultiTx::initialize(void)
     string tx_name(start, comma);
     if (!tx_name.empty())
     {
-      cout << "\tAdding transmitter: " << tx_name << endl;
-      Tx *tx = TxFactory::createNamedTx(cfg, tx_name);
-      if ((tx == 0) || !tx->initialize())
-      {
-      	// FIXME: Cleanup
-      	return false;
-      }
-      tx->setVerbose(false);
-      tx->txTimeout.connect(txTimeout.make_slot());
-      tx->transmitterStateChange.connect(
-      	      hide(mem_fun(*this, &MultiTx::onTransmitterStateChange)));
-      
-      splitter->addSink(tx);
-      
-      txs.push_back(tx);
+      tx_names.push_back(tx_name);
     }
     if (comma == transmitters.end())
     {
@@ -188,6 +179,69 @@ bool MultiTx::initialize(void)
     start = comma;
     ++start;
   }
+
+    // Local transmitters with identical audio conditioning settings share
+    // one conditioning chain so that it only have to run once for all of
+    // them. Each transmitter then only run its own per device stages.
+  map<string, int> cond_id_cnt;
+  vector<string> cond_ids(tx_names.size());
+  for (size_t i=0; i<tx_names.size(); ++i)
+  {
+    string tx_type;
+    if (cfg.getValue(tx_names[i], "TYPE", tx_type) && (tx_type == "Local"))
+    {
+      cond_ids[i] = TxAudioConditioner::configId(cfg, tx_names[i]);
+      cond_id_cnt[cond_ids[i]] += 1;
+    }
+  }
+  map<string, AudioSplitter*> cond_splitters;
+
+  for (size_t i=0; i<tx_names.size(); ++i)
+  {
+    const string& tx_name = tx_names[i];
+    cout << "\tAdding transmitter: " << tx_name << endl;
+    Tx *tx = TxFactory::createNamedTx(cfg, tx_name);
+    if (tx == 0)
+    {
+      // FIXME: Cleanup
+      return false;
+    }
+    bool shared_cond = !cond_ids[i].empty() &&
+                       (cond_id_cnt[cond_ids[i]] > 1) &&
+                       tx->useExternalAudioConditioning();
+    if (!tx->initialize())
+    {
+      // FIXME: Cleanup
+      return false;
+    }
+    tx->setVerbose(false);
+    tx->txTimeout.connect(txTimeout.make_slot());
+    tx->txAudioStarted.connect(
+            mem_fun(*this, &MultiTx::onTxAudioStarted));
+    tx->transmitterStateChange.connect(
+            hide(mem_fun(*this, &MultiTx::onTransmitterStateChange)));
+
+    if (shared_cond)
+    {
+      AudioSplitter *&cond_splitter = cond_splitters[cond_ids[i]];
+      if (cond_splitter == 0)
+      {
+        TxAudioConditioner *conditioner =
+          new TxAudioConditioner(cfg, tx_name);
+        splitter->addSink(conditioner, true);
+        cond_splitter = new AudioSplitter;
+        conditioner->registerSink(cond_splitter, true);
+      }
+      cout << "\t  Sharing audio conditioning (" << cond_ids[i] << ")\n";
+      cond_splitter->addSink(tx);
+    }
+    else
+    {
+      splitter->addSink(tx);
+    }
+
+    txs.push_back(tx);
+  }
   
   setHandler(splitter);
   
@@ -289,12 +343,27 @@ void MultiTx::onTransmitterStateChange(void)
       break;
     }
   }
+  if (!is_transmitting)
+  {
+    tx_audio_started = false;
+  }
   setIsTransmitting(is_transmitting);
   m_tx_state_delay_timer.setEnable(true);
   m_tx_state_delay_timer.reset();
 } /* MultiTx::onTransmitterStateChange */
 
 
+void MultiTx::onTxAudioStarted(void)
+{
+    // Only report the first transmitter that start sending audio
+  if (!tx_audio_started)
+  {
+    tx_audio_started = true;
+    txAudioStarted();
+  }
+} /* MultiTx::onTxAudioStarted */
+
+
 void MultiTx::txStateDelayExpired(void)
 {
   Json::Value event(Json::arrayValue);
@@ -192,10 +192,12 @@ class MultiTx : public Tx
     std::list<Tx *>   	  txs;
     Async::AudioSplitter  *splitter;
     Async::Timer          m_tx_state_delay_timer;
+    bool                  tx_audio_started;
     
     MultiTx(const MultiTx&);
     MultiTx& operator=(const MultiTx&);
     void onTransmitterStateChange(void);
+    void onTxAudioStarted(void);
     void txStateDelayExpired(void);
     
 };  /* class MultiTx */
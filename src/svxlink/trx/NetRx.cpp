@@ -47,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncConfig.h>
 #include <AsyncAudioDecoder.h>
+#include <AsyncAudioTraceTagger.h>
 
 
 /****************************************************************************
@@ -58,6 +59,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "NetRx.h"
 #include "NetTrxMsg.h"
 #include "NetTrxTcpClient.h"
+#include "NetRxDecoder.h"
 
 
 /****************************************************************************
@@ -135,8 +137,10 @@ NetRx::NetRx(Config &cfg, const string& name)
   : Rx(cfg, name), cfg(cfg), mute_state(Rx::MUTE_ALL), tcp_con(0),
     log_disconnects_once(false), log_disconnect(true),
     last_signal_strength(0.0), last_sql_rx_id(Rx::ID_UNKNOWN),
-    unflushed_samples(false), sql_is_open(false), audio_dec(0), fq(0),
-    modulation(Modulation::MOD_UNKNOWN)
+    unflushed_samples(false), sql_is_open(false), audio_dec(0),
+    trace_tagger(0), fq(0),
+    modulation(Modulation::MOD_UNKNOWN), audio_lost_cnt(0),
+    channel(0)
 {
 } /* NetRx::NetRx */
 
@@ -144,6 +148,7 @@ NetRx::NetRx(Config &cfg, const string& name)
 NetRx::~NetRx(void)
 {
   clearHandler();
+  delete trace_tagger;
   delete audio_dec;
   
   tcp_con->deleteInstance();
@@ -179,6 +184,15 @@ bool NetRx::initialize(void)
   cfg.getValue(name(), "UDP_PORT", udp_port);
 
   cfg.getValue(name(), "LOG_DISCONNECTS_ONCE", log_disconnects_once);
+
+  bool udp_audio = false;
+  cfg.getValue(name(), "UDP_AUDIO", udp_audio);
+
+  if (!cfg.getValue(name(), "CHANNEL", 0U, 255U, channel, true))
+  {
+    cerr << "*** ERROR: " << name() << "/CHANNEL must be in the range 0-255\n";
+    return false;
+  }
   
   string audio_dec_name;
   cfg.getValue(name(), "CODEC", audio_dec_name);
@@ -190,16 +204,14 @@ bool NetRx::initialize(void)
   string auth_key;
   cfg.getValue(name(), "AUTH_KEY", auth_key);
   
-  audio_dec = AudioDecoder::create(audio_dec_name);
-  if (audio_dec == 0)
+  AudioDecoder *dec = AudioDecoder::create(audio_dec_name);
+  if (dec == 0)
   {
     cerr << name() << ": *** ERROR: Illegal audio codec (" << audio_dec_name
           << ") specified for receiver " << name() << "\n";
     return false;
   }
-  audio_dec->allEncodedSamplesFlushed.connect(
-          mem_fun(*this, &NetRx::allEncodedSamplesFlushed));
-  string opt_prefix(audio_dec->name());
+  string opt_prefix(dec->name());
   opt_prefix += "_DEC_";
   list<string> names = cfg.listSection(name());
   list<string>::const_iterator nit;
@@ -210,11 +222,20 @@ bool NetRx::initialize(void)
       string opt_value;
       cfg.getValue(name(), *nit, opt_value);
       string opt_name((*nit).substr(opt_prefix.size()));
-      audio_dec->setOption(opt_name, opt_value);
+      dec->setOption(opt_name, opt_value);
     }
   }
-  audio_dec->printCodecParams();
-  setHandler(audio_dec);
+  dec->printCodecParams();
+  audio_dec = new NetRxDecoder(dec);
+  audio_dec->allEncodedSamplesFlushed.connect(
+          mem_fun(*this, &NetRx::allEncodedSamplesFlushed));
+  audio_dec->captureTime.connect(audioCaptureTime.make_slot());
+
+    // The audio is tagged again when it arrive from the network since the
+    // capture time is not transferred over the link
+  trace_tagger = new Async::AudioTraceTagger(name() + ":net_in");
+  audio_dec->registerSink(trace_tagger);
+  setHandler(trace_tagger);
   
   tcp_con = NetTrxTcpClient::instance(host, atoi(tcp_port.c_str()));
   if (tcp_con == 0)
@@ -222,8 +243,18 @@ bool NetRx::initialize(void)
     return false;
   }
   tcp_con->setAuthKey(auth_key);
+  if (!tcp_con->setupTls(cfg, name()))
+  {
+    return false;
+  }
   tcp_con->isReady.connect(mem_fun(*this, &NetRx::connectionReady));
   tcp_con->msgReceived.connect(mem_fun(*this, &NetRx::handleMsg));
+  if (udp_audio)
+  {
+    tcp_con->enableUdpAudio();
+    tcp_con->audioPacketsLost.connect(
+        mem_fun(*this, &NetRx::audioPacketsLost));
+  }
   tcp_con->connect();
 
   squelchOpen.connect(
@@ -339,6 +370,24 @@ void NetRx::setModulation(Modulation::Type mod)
 } /* NetRx::setModulation */
 
 
+void NetRx::setDecoderThread(Async::CppEventLoopThread *thread)
+{
+  assert(audio_dec != 0);
+  if (!audio_dec->setThread(thread))
+  {
+    cerr << "*** WARNING: " << name() << ": Could not decode audio in a "
+            "separate thread. Decoding in the main thread.\n";
+  }
+} /* NetRx::setDecoderThread */
+
+
+void NetRx::setDecodingDeferred(bool defer, unsigned backlog_ms)
+{
+  assert(audio_dec != 0);
+  audio_dec->setDeferred(defer, backlog_ms);
+} /* NetRx::setDecodingDeferred */
+
+
 
 /****************************************************************************
  *
@@ -390,8 +439,9 @@ void NetRx::connectionReady(bool is_ready)
       sendMsg(msg);
     }
 
-    MsgAudioCodecSelect *msg = new MsgRxAudioCodecSelect(audio_dec->name());
-    string opt_prefix(audio_dec->name());
+    MsgAudioCodecSelect *msg =
+        new MsgRxAudioCodecSelect(audio_dec->codecName().c_str());
+    string opt_prefix(audio_dec->codecName());
     opt_prefix += "_ENC_";
     list<string> names = cfg.listSection(name());
     list<string>::const_iterator nit;
@@ -436,6 +486,11 @@ void NetRx::connectionReady(bool is_ready)
 
 void NetRx::handleMsg(Msg *msg)
 {
+  if (tcp_con->rxChannel() != channel)
+  {
+    return;
+  }
+
   switch (msg->type())
   {
     case MsgSquelch::TYPE:
@@ -446,6 +501,7 @@ void NetRx::handleMsg(Msg *msg)
         last_signal_strength = sql_msg->signalStrength();
         last_sql_rx_id = sql_msg->sqlRxId();
         sql_is_open = sql_msg->isOpen();
+        audio_lost_cnt = 0;
         last_sql_activity_info = sql_msg->sqlActivityInfo();
         if (sql_msg->isOpen())
         {
@@ -478,6 +534,20 @@ void NetRx::handleMsg(Msg *msg)
       }
       break;
     }
+
+    case MsgTimestampedSiglevUpdate::TYPE:
+    {
+      if (mute_state != Rx::MUTE_ALL)
+      {
+        MsgTimestampedSiglevUpdate *sql_msg =
+            reinterpret_cast<MsgTimestampedSiglevUpdate*>(msg);
+        last_signal_strength = sql_msg->signalStrength();
+        last_sql_rx_id = sql_msg->sqlRxId();
+        signalLevelUpdated(last_signal_strength);
+        publishSquelchState();
+      }
+      break;
+    }
     
     case MsgDtmf::TYPE:
     {
@@ -504,8 +574,20 @@ void NetRx::handleMsg(Msg *msg)
       if ((mute_state == Rx::MUTE_NONE) && sql_is_open)
       {
 	MsgAudio *audio_msg = reinterpret_cast<MsgAudio*>(msg);
-	unflushed_samples = true;
-        audio_dec->writeEncodedSamples(audio_msg->buf(), audio_msg->size());
+        writeAudio(audio_msg->buf(), audio_msg->size(), 0);
+      }
+      break;
+    }
+
+    case MsgTimestampedAudio::TYPE:
+    {
+      if ((mute_state == Rx::MUTE_NONE) && sql_is_open)
+      {
+	MsgTimestampedAudio *audio_msg =
+            reinterpret_cast<MsgTimestampedAudio*>(msg);
+	struct timeval capture_time;
+        audio_msg->captureTime(capture_time);
+        writeAudio(audio_msg->buf(), audio_msg->size(), &capture_time);
       }
       break;
     }
@@ -533,7 +615,7 @@ void NetRx::handleMsg(Msg *msg)
 
 void NetRx::sendMsg(Msg *msg)
 {
-  tcp_con->sendMsg(msg);
+  tcp_con->sendMsg(msg, channel);
 } /* NetUplink::sendMsg */
 
 
@@ -568,6 +650,15 @@ void NetRx::publishSquelchState(void)
 } /* NetRx::publishSquelchState */
 
 
+void NetRx::writeAudio(const void *buf, int size,
+                       const struct timeval *capture_time)
+{
+  unflushed_samples = true;
+  audio_dec->writeEncodedSamples(buf, size, audio_lost_cnt, capture_time);
+  audio_lost_cnt = 0;
+} /* NetRx::writeAudio */
+
+
 
 /*
  * This file has not been truncated
@@ -72,7 +72,7 @@ namespace NetTrxMsg
 
 namespace Async
 {
-  class AudioDecoder;
+  class AudioTraceTagger;
 };
 
 /****************************************************************************
@@ -93,6 +93,7 @@ namespace Async
 
 class ToneDet;
 class NetTrxTcpClient;
+class NetRxDecoder;
   
 
 /****************************************************************************
@@ -190,6 +191,19 @@ class NetRx : public Rx
      */
     virtual void setModulation(Modulation::Type mod);
 
+    /**
+     * @brief   Set the thread to decode received audio in
+     * @param   thread The thread to use, which must have been started
+     */
+    virtual void setDecoderThread(Async::CppEventLoopThread *thread);
+
+    /**
+     * @brief   Defer decoding of received audio
+     * @param   defer       Set to \em true to keep received audio encoded
+     * @param   backlog_ms  The length of encoded audio to keep
+     */
+    virtual void setDecodingDeferred(bool defer, unsigned backlog_ms);
+
     /**
      * @brief Resume audio output to the sink
      *
@@ -212,16 +226,22 @@ class NetRx : public Rx
     std::list<ToneDet*> tone_detectors;
     bool      	      	unflushed_samples;
     bool      	      	sql_is_open;
-    Async::AudioDecoder *audio_dec;
+    NetRxDecoder        *audio_dec;
+    Async::AudioTraceTagger *trace_tagger;
     unsigned            fq;
     Modulation::Type    modulation;
     std::string         last_sql_activity_info;
+    unsigned            audio_lost_cnt;
+    unsigned            channel;
 
     void connectionReady(bool is_ready);
     void handleMsg(NetTrxMsg::Msg *msg);
     void sendMsg(NetTrxMsg::Msg *msg);
     void allEncodedSamplesFlushed(void);
     void publishSquelchState(void);
+    void audioPacketsLost(unsigned lost_cnt) { audio_lost_cnt += lost_cnt; }
+    void writeAudio(const void *buf, int size,
+                    const struct timeval *capture_time);
 
 };  /* class NetRx */
 
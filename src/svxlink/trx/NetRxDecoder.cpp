@@ -0,0 +1,429 @@
+/**
+@file	 NetRxDecoder.cpp
+@brief   Decode the audio of a remote receiver in place or in a worker thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncApplication.h>
+#include <AsyncCppApplication.h>
+#include <AsyncCppEventLoopThread.h>
+#include <AsyncAudioSink.h>
+#include <AsyncAudioDecoder.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "NetRxDecoder.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+  /*
+   * Collect the samples written by the decoder into a buffer. A flush is
+   * acknowledged at once since the flush is passed on with the samples.
+   */
+  class SampleCollector : public AudioSink
+  {
+    public:
+      SampleCollector(void) : buf(0) {}
+
+      void setBuffer(vector<float> *new_buf) { buf = new_buf; }
+
+      virtual int writeSamples(const float *samples, int count)
+      {
+        if (buf != 0)
+        {
+          buf->insert(buf->end(), samples, samples + count);
+        }
+        return count;
+      }
+
+      virtual void flushSamples(void)
+      {
+        sourceAllSamplesFlushed();
+      }
+
+    private:
+      vector<float> *buf;
+  };
+
+  int64_t toUsec(const struct timeval& tv)
+  {
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+  }
+
+  int64_t nowUsec(void)
+  {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return toUsec(now);
+  }
+};
+
+
+/*
+ * The part of the decoder that is used in the decoder thread. Since tasks
+ * that are on their way between the threads may refer to it, it is kept
+ * until the last such task is gone. The owner pointer is only used in the
+ * thread that created the NetRxDecoder object.
+ */
+struct NetRxDecoder::Worker
+{
+  AudioDecoder    *dec;
+  SampleCollector collector;
+  NetRxDecoder    *owner;
+  CppApplication  *app;
+
+  Worker(AudioDecoder *dec, NetRxDecoder *owner)
+    : dec(dec), owner(owner), app(0)
+  {
+    dec->registerSink(&collector);
+  }
+};
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+NetRxDecoder::NetRxDecoder(AudioDecoder *dec)
+  : m_codec_name(dec->name()), m_worker(new Worker(dec, this)), m_thread(0),
+    m_deferred(false), m_stamp_arrival(false), m_backlog_us(0),
+    m_is_writing(false)
+{
+} /* NetRxDecoder::NetRxDecoder */
+
+
+NetRxDecoder::~NetRxDecoder(void)
+{
+  m_worker->owner = 0;
+  if ((m_thread == 0) ||
+      !m_thread->post(sigc::bind(sigc::ptr_fun(&NetRxDecoder::deleteDecoder),
+                                 m_worker)))
+  {
+    deleteDecoder(m_worker);
+  }
+} /* NetRxDecoder::~NetRxDecoder */
+
+
+bool NetRxDecoder::setThread(CppEventLoopThread *thread)
+{
+  CppApplication *app = dynamic_cast<CppApplication*>(&Application::app());
+  if ((app == 0) || (thread == 0) || !thread->isRunning())
+  {
+    return false;
+  }
+  m_worker->app = app;
+  m_thread = thread;
+  m_stamp_arrival = true;
+  return true;
+} /* NetRxDecoder::setThread */
+
+
+void NetRxDecoder::setDeferred(bool defer, unsigned backlog_ms)
+{
+  m_backlog_us = static_cast<int64_t>(backlog_ms) * 1000;
+  m_stamp_arrival = true;
+  if (defer == m_deferred)
+  {
+    return;
+  }
+  m_deferred = defer;
+  if (!defer)
+  {
+    while (!m_backlog.empty())
+    {
+      decode(m_backlog.front());
+      m_backlog.pop_front();
+    }
+  }
+} /* NetRxDecoder::setDeferred */
+
+
+void NetRxDecoder::writeEncodedSamples(const void *buf, int size,
+                                       unsigned lost_cnt,
+                                       const struct timeval *capture_time)
+{
+  Packet pkt;
+  const uint8_t *data = reinterpret_cast<const uint8_t*>(buf);
+  pkt.data.assign(data, data + size);
+  pkt.lost_cnt = lost_cnt;
+  if (capture_time != 0)
+  {
+    pkt.capture_us = toUsec(*capture_time);
+  }
+  if (m_stamp_arrival)
+  {
+    pkt.arrival_us = nowUsec();
+  }
+
+  if (!m_deferred)
+  {
+    decode(pkt);
+    return;
+  }
+
+  m_backlog.push_back(pkt);
+  while (!m_backlog.empty() &&
+         (pkt.arrival_us - m_backlog.front().arrival_us >= m_backlog_us))
+  {
+    m_backlog.pop_front();
+  }
+} /* NetRxDecoder::writeEncodedSamples */
+
+
+void NetRxDecoder::flushEncodedSamples(void)
+{
+  m_backlog.clear();
+  Packet pkt;
+  pkt.flush = true;
+  decode(pkt);
+} /* NetRxDecoder::flushEncodedSamples */
+
+
+void NetRxDecoder::resumeOutput(void)
+{
+  writeBlocks();
+} /* NetRxDecoder::resumeOutput */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void NetRxDecoder::allSamplesFlushed(void)
+{
+  allEncodedSamplesFlushed();
+} /* NetRxDecoder::allSamplesFlushed */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void NetRxDecoder::decode(const Packet& pkt)
+{
+  if (m_thread != 0)
+  {
+    m_thread->post(sigc::bind(sigc::ptr_fun(&NetRxDecoder::decodeInThread),
+                              m_worker, pkt));
+    return;
+  }
+  m_blocks.push_back(Block());
+  decodePacket(m_worker.get(), pkt, m_blocks.back());
+  writeBlocks();
+} /* NetRxDecoder::decode */
+
+
+void NetRxDecoder::writeBlocks(void)
+{
+  if (m_is_writing)
+  {
+    return;
+  }
+  m_is_writing = true;
+  while (!m_blocks.empty())
+  {
+    Block& block = m_blocks.front();
+    if (block.pos == 0)
+    {
+      emitCaptureTime(block);
+      block.capture_us = block.arrival_us = -1;
+    }
+    while (block.pos < block.samples.size())
+    {
+      int cnt = sinkWriteSamples(&block.samples[block.pos],
+                                 block.samples.size() - block.pos);
+      if (cnt <= 0)
+      {
+        m_is_writing = false;
+        return;
+      }
+      block.pos += cnt;
+    }
+    bool do_flush = block.flush;
+    m_blocks.pop_front();
+    if (do_flush)
+    {
+      sinkFlushSamples();
+    }
+  }
+  m_is_writing = false;
+} /* NetRxDecoder::writeBlocks */
+
+
+void NetRxDecoder::emitCaptureTime(const Block& block)
+{
+  int64_t t = block.capture_us;
+  if ((t < 0) && (block.arrival_us >= 0) && !block.samples.empty())
+  {
+      // The packet arrived when its last sample had been captured
+    t = block.arrival_us -
+        static_cast<int64_t>(block.samples.size()) * 1000000 /
+        INTERNAL_SAMPLE_RATE;
+  }
+  if (t >= 0)
+  {
+    struct timeval tv;
+    tv.tv_sec = t / 1000000;
+    tv.tv_usec = t % 1000000;
+    captureTime(tv);
+  }
+} /* NetRxDecoder::emitCaptureTime */
+
+
+void NetRxDecoder::decodePacket(Worker *worker, const Packet& pkt,
+                                Block& block)
+{
+  assert(worker->dec != 0);
+  block.capture_us = pkt.capture_us;
+  block.arrival_us = pkt.arrival_us;
+  block.flush = pkt.flush;
+  worker->collector.setBuffer(&block.samples);
+  void *data = const_cast<uint8_t*>(pkt.data.data());
+  if (pkt.lost_cnt > 0)
+  {
+    worker->dec->packetLost(data, pkt.data.size(), pkt.lost_cnt);
+  }
+  if (!pkt.data.empty())
+  {
+    worker->dec->writeEncodedSamples(data, pkt.data.size());
+  }
+  if (pkt.flush)
+  {
+    worker->dec->flushEncodedSamples();
+  }
+  worker->collector.setBuffer(0);
+} /* NetRxDecoder::decodePacket */
+
+
+void NetRxDecoder::decodeInThread(std::shared_ptr<Worker> worker, Packet pkt)
+{
+  Block block;
+  decodePacket(worker.get(), pkt, block);
+  worker->app->post(sigc::bind(sigc::ptr_fun(&NetRxDecoder::deliverBlock),
+                               worker, block));
+} /* NetRxDecoder::decodeInThread */
+
+
+void NetRxDecoder::deliverBlock(std::shared_ptr<Worker> worker, Block block)
+{
+  NetRxDecoder *self = worker->owner;
+  if (self != 0)
+  {
+    self->m_blocks.push_back(block);
+    self->writeBlocks();
+  }
+} /* NetRxDecoder::deliverBlock */
+
+
+void NetRxDecoder::deleteDecoder(std::shared_ptr<Worker> worker)
+{
+  delete worker->dec;
+  worker->dec = 0;
+} /* NetRxDecoder::deleteDecoder */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,291 @@
+/**
+@file	 NetRxDecoder.h
+@brief   Decode the audio of a remote receiver in place or in a worker thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-15
+
+This file contains the class used by NetRx to decode the audio packets
+received from a remote receiver. The packets may be decoded in the calling
+thread, in a worker thread or be kept encoded until they are needed.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef NET_RX_DECODER_INCLUDED
+#define NET_RX_DECODER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/time.h>
+#include <stdint.h>
+#include <sigc++/sigc++.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSource.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class AudioDecoder;
+  class CppEventLoopThread;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Decode the audio packets received by a NetRx
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-15
+
+This class wrap an Async::AudioDecoder. By default each packet is decoded as
+soon as it is written, like when using the decoder directly. If a decoder
+thread is set, the packets are decoded in that thread and the decoded audio
+is written to the sink from the thread that created this object. Packets for
+the same receiver are always decoded in order, so one thread can be shared by
+many receivers.
+
+Decoding may also be deferred. The packets are then kept encoded, up to a
+given age, and are decoded when decoding is resumed.
+
+Decoding in another thread or later than the packet arrived would make the
+local arrival time useless for aligning the audio of different receivers.
+When a thread is set or decoding has been deferred at least once, the
+arrival time of each packet is therefore kept with the packet. The
+captureTime signal is emitted with that time before the audio is written,
+unless the packet carried a capture time of its own.
+*/
+class NetRxDecoder : public Async::AudioSource, public sigc::trackable
+{
+  public:
+    /**
+     * @brief 	Constuctor
+     * @param 	dec The decoder to use, which will be owned by this object
+     *
+     * The decoder should be fully configured before this object is created.
+     */
+    explicit NetRxDecoder(Async::AudioDecoder *dec);
+
+    /**
+     * @brief 	Destructor
+     *
+     * If a decoder thread is used, the decoder is deleted in that thread.
+     */
+    ~NetRxDecoder(void);
+
+    /**
+     * @brief   Get the name of the codec
+     * @return  Returns the name of the codec
+     */
+    const std::string& codecName(void) const { return m_codec_name; }
+
+    /**
+     * @brief   Decode the packets in a worker thread
+     * @param   thread The thread to decode in
+     * @return  Returns \em true on success or \em false on failure
+     *
+     * This must be called before any packets are written. The thread must
+     * be kept running until this object has been deleted. Using a thread is
+     * only possible in applications using an Async::CppApplication.
+     */
+    bool setThread(Async::CppEventLoopThread *thread);
+
+    /**
+     * @brief   Defer decoding
+     * @param   defer       Set to \em true to keep new packets encoded
+     * @param   backlog_ms  The maximum age of the packets to keep
+     *
+     * When decoding is resumed, the kept packets are decoded at once.
+     */
+    void setDeferred(bool defer, unsigned backlog_ms);
+
+    /**
+     * @brief   Check if decoding is deferred
+     * @return  Returns \em true if new packets are kept encoded
+     */
+    bool isDeferred(void) const { return m_deferred; }
+
+    /**
+     * @brief 	Write an encoded packet
+     * @param 	buf           Buffer containing the encoded packet
+     * @param 	size          The size of the packet
+     * @param   lost_cnt      The number of packets lost before this one
+     * @param   capture_time  The capture time of the packet or 0 if unknown
+     */
+    void writeEncodedSamples(const void *buf, int size, unsigned lost_cnt,
+                             const struct timeval *capture_time);
+
+    /**
+     * @brief   Call this function when all encoded samples have been written
+     *
+     * Packets that are kept encoded are thrown away.
+     */
+    void flushEncodedSamples(void);
+
+    /**
+     * @brief   Resume audio output to the sink
+     *
+     * This function is normally only called from a connected sink object.
+     */
+    virtual void resumeOutput(void);
+
+    /**
+     * @brief   A signal that is emitted when all samples have been flushed
+     */
+    sigc::signal<void> allEncodedSamplesFlushed;
+
+    /**
+     * @brief   A signal that is emitted before the audio of a packet
+     * @param   tv The time when the audio that follow was captured
+     */
+    sigc::signal<void, const struct timeval&> captureTime;
+
+  protected:
+    /**
+     * @brief   The registered sink has flushed all samples
+     *
+     * This function is normally only called from a connected sink object.
+     */
+    virtual void allSamplesFlushed(void);
+
+  private:
+    struct Packet
+    {
+      std::vector<uint8_t>  data;
+      unsigned              lost_cnt;
+      int64_t               capture_us;
+      int64_t               arrival_us;
+      bool                  flush;
+      Packet(void) : lost_cnt(0), capture_us(-1), arrival_us(-1),
+                     flush(false) {}
+    };
+
+    struct Block
+    {
+      std::vector<float>    samples;
+      size_t                pos;
+      int64_t               capture_us;
+      int64_t               arrival_us;
+      bool                  flush;
+      Block(void) : pos(0), capture_us(-1), arrival_us(-1), flush(false) {}
+    };
+
+    struct Worker;
+
+    std::string                 m_codec_name;
+    std::shared_ptr<Worker>     m_worker;
+    Async::CppEventLoopThread   *m_thread;
+    bool                        m_deferred;
+    bool                        m_stamp_arrival;
+    int64_t                     m_backlog_us;
+    std::deque<Packet>          m_backlog;
+    std::deque<Block>           m_blocks;
+    bool                        m_is_writing;
+
+    NetRxDecoder(const NetRxDecoder&);
+    NetRxDecoder& operator=(const NetRxDecoder&);
+    void decode(const Packet& pkt);
+    void writeBlocks(void);
+    void emitCaptureTime(const Block& block);
+    static void decodePacket(Worker *worker, const Packet& pkt, Block& block);
+    static void decodeInThread(std::shared_ptr<Worker> worker, Packet pkt);
+    static void deliverBlock(std::shared_ptr<Worker> worker, Block block);
+    static void deleteDecoder(std::shared_ptr<Worker> worker);
+
+};  /* class NetRxDecoder */
+
+
+//} /* namespace */
+
+#endif /* NET_RX_DECODER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
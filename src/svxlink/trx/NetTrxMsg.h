@@ -6,7 +6,7 @@
 
 \verbatim
 SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
-Copyright (C) 2003-2018 Tobias Blomberg / SM0SVX
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -40,7 +40,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 #include <vector>
 #include <utility>
+#include <algorithm>
 
+#include <sys/time.h>
 #include <gcrypt.h>
 
 
@@ -50,6 +52,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncMemPool.h>
 #include <Modulation.h>
 #include <Tx.h>
 #include <Rx.h>
@@ -146,6 +149,36 @@ class Msg
      * @return	Returns the message size
      */
      unsigned size(void) const { return m_size; }
+
+    /**
+     * @brief   Allocate a message from the memory pools
+     * @param   size The size of the message object
+     *
+     * Messages are allocated and freed for every message that is sent so
+     * they are taken from the memory pools to not fragment the heap. The
+     * allocation size is stored in front of the message since messages are
+     * deleted through a pointer to this base class.
+     */
+    static void *operator new(size_t size)
+    {
+      char *block = static_cast<char*>(
+          Async::MemPool::allocate(ALLOC_HEADER_SIZE + size));
+      *reinterpret_cast<size_t*>(block) = ALLOC_HEADER_SIZE + size;
+      return block + ALLOC_HEADER_SIZE;
+    }
+
+    /**
+     * @brief   Return a message to the memory pools
+     * @param   ptr The message to free
+     */
+    static void operator delete(void *ptr)
+    {
+      if (ptr != 0)
+      {
+        char *block = static_cast<char*>(ptr) - ALLOC_HEADER_SIZE;
+        Async::MemPool::deallocate(block, *reinterpret_cast<size_t*>(block));
+      }
+    }
     
   protected:
   
@@ -156,6 +189,8 @@ class Msg
     void setSize(unsigned size) { m_size = size; }
         
   private:
+    static const size_t ALLOC_HEADER_SIZE = alignof(std::max_align_t);
+
     unsigned m_type;
     unsigned m_size;
     
@@ -173,10 +208,31 @@ class MsgProtoVer : public Msg
   public:
     static const unsigned TYPE  = 0;
     static const uint16_t MAJOR = 2;
-    static const uint16_t MINOR = 8;
-    MsgProtoVer(void)
-      : Msg(TYPE, sizeof(MsgProtoVer)), m_major(MAJOR),
-        m_minor(MINOR) {}
+    static const uint16_t MINOR = 13;
+
+      // The server greet with the lowest minor version it support so that
+      // older clients, which require an exact match, still can connect. A
+      // newer client then announce its own version to enable new features.
+    static const uint16_t MIN_MINOR = 8;
+
+      // The first minor version with capture timestamps on RX messages
+    static const uint16_t MINOR_TIMESTAMPS = 9;
+
+      // The first minor version that can carry audio over UDP
+    static const uint16_t MINOR_UDP_AUDIO = 10;
+
+      // The first minor version where a connection can carry several channels
+    static const uint16_t MINOR_CHANNELS = 11;
+
+      // The first minor version that can batch signal level updates
+    static const uint16_t MINOR_SIGLEV_BATCH = 12;
+
+      // The first minor version where a session can be resumed using a token
+    static const uint16_t MINOR_SESSION_RESUME = 13;
+
+    MsgProtoVer(uint16_t major=MAJOR, uint16_t minor=MINOR)
+      : Msg(TYPE, sizeof(MsgProtoVer)), m_major(major),
+        m_minor(minor) {}
     uint16_t majorVer(void) const { return m_major; }
     uint16_t minorVer(void) const { return m_minor; }
   
@@ -277,6 +333,175 @@ class MsgAuthOk : public Msg
 };  /* MsgAuthOk */
 
 
+/*
+ * Sent by the server when the UDP audio channel is available. The client
+ * start sending UDP heartbeats, tagged with the session id, to the given UDP
+ * port. Audio is moved to UDP by each side as soon as a valid UDP datagram
+ * has been received from the other side.
+ */
+class MsgUdpAudioSetup : public Msg
+{
+  public:
+    static const unsigned TYPE = 13;
+    MsgUdpAudioSetup(uint32_t session_id, uint16_t udp_port)
+      : Msg(TYPE, sizeof(MsgUdpAudioSetup)), m_session_id(session_id),
+        m_udp_port(udp_port) {}
+    uint32_t sessionId(void) const { return m_session_id; }
+    uint16_t udpPort(void) const { return m_udp_port; }
+
+  private:
+    uint32_t m_session_id;
+    uint16_t m_udp_port;
+
+};  /* MsgUdpAudioSetup */
+
+
+/*
+ * Select the channel that all following messages in the same direction
+ * belong to. Each new connection start on channel 0 in both directions so
+ * connections that only carry one channel never send this message.
+ */
+class MsgSelectChannel : public Msg
+{
+  public:
+    static const unsigned TYPE = 14;
+    explicit MsgSelectChannel(uint8_t channel)
+      : Msg(TYPE, sizeof(MsgSelectChannel)), m_channel(channel) {}
+    uint8_t channel(void) const { return m_channel; }
+
+  private:
+    uint8_t m_channel;
+
+};  /* MsgSelectChannel */
+
+
+/*
+ * Sent by the server after the authentication when the client announce
+ * support for it. A reconnecting client send the token back in a
+ * MsgSessionResume directly after connecting so that the server can send
+ * MsgAuthOk without waiting for the challenge response. The token consist of
+ * an expiry time and a random nonce, signed together with the IP address of
+ * the client using the authentication key. The server therefore need not
+ * remember the tokens it has issued and they are still valid after a
+ * restart of the server.
+ */
+class MsgSessionToken : public Msg
+{
+  public:
+    static const unsigned TYPE      = 15;
+    static const int      NONCE_LEN = 8;
+    static const int      DIGEST_LEN = MsgAuthResponse::DIGEST_LEN;
+    MsgSessionToken(const std::string &key, uint32_t expiry,
+                    const std::string &client_ip)
+      : Msg(TYPE, sizeof(MsgSessionToken)), m_expiry(expiry)
+    {
+      gcry_create_nonce(m_nonce, NONCE_LEN);
+      if (!calcDigest(m_digest, key, client_ip))
+      {
+        exit(1);
+      }
+    }
+
+    uint32_t expiry(void) const { return m_expiry; }
+
+    bool verify(const std::string &key, const std::string &client_ip,
+                uint32_t now) const
+    {
+      if (now >= m_expiry)
+      {
+        return false;
+      }
+      unsigned char digest[DIGEST_LEN];
+      bool ok = calcDigest(digest, key, client_ip);
+      return ok && (memcmp(m_digest, digest, DIGEST_LEN) == 0);
+    }
+
+  protected:
+    MsgSessionToken(unsigned type, const MsgSessionToken &token)
+      : Msg(type, sizeof(MsgSessionToken)), m_expiry(token.m_expiry)
+    {
+      memcpy(m_nonce, token.m_nonce, NONCE_LEN);
+      memcpy(m_digest, token.m_digest, DIGEST_LEN);
+    }
+
+  private:
+    uint32_t      m_expiry;
+    unsigned char m_nonce[NONCE_LEN];
+    unsigned char m_digest[DIGEST_LEN];
+
+    bool calcDigest(unsigned char *digest, const std::string &key,
+                    const std::string &client_ip) const
+    {
+        // The prefix keep a token digest from ever being valid as a
+        // challenge response
+      static const char prefix[] = "session";
+      unsigned char *digest_ptr = 0;
+      gcry_md_hd_t hd = { 0 };
+      gcry_error_t err = gcry_md_open(&hd, MsgAuthResponse::ALGO,
+                                      GCRY_MD_FLAG_HMAC);
+      if (err) goto error;
+      err = gcry_md_setkey(hd, key.c_str(), key.size());
+      if (err) goto error;
+      gcry_md_write(hd, prefix, sizeof(prefix));
+      gcry_md_write(hd, &m_expiry, sizeof(m_expiry));
+      gcry_md_write(hd, m_nonce, NONCE_LEN);
+      gcry_md_write(hd, client_ip.c_str(), client_ip.size());
+      digest_ptr = gcry_md_read(hd, 0);
+      memcpy(digest, digest_ptr, DIGEST_LEN);
+      gcry_md_close(hd);
+      return true;
+
+      error:
+        gcry_md_close(hd);
+        std::cerr << "*** ERROR: gcrypt error: "
+                  << gcry_strsource(err) << "/" << gcry_strerror(err)
+                  << std::endl;
+        return false;
+    }
+
+};  /* MsgSessionToken */
+
+
+/*
+ * Sent by the client directly after connecting, if it got a MsgSessionToken
+ * during an earlier connection. The client still answer the authentication
+ * challenge since the token may have been rejected. The server ignore the
+ * challenge response if the session was resumed.
+ */
+class MsgSessionResume : public MsgSessionToken
+{
+  public:
+    static const unsigned TYPE = 16;
+    explicit MsgSessionResume(const MsgSessionToken &token)
+      : MsgSessionToken(TYPE, token) {}
+
+};  /* MsgSessionResume */
+
+
+/*
+ * The header of a datagram on the UDP audio channel. It is followed by an
+ * ordinary message, a MsgHeartbeat, MsgAudio or MsgTimestampedAudio. The
+ * stream number is the number of MsgFlush messages that the sender had sent
+ * on the TCP connection. Audio that arrive after the flush that ended its
+ * stream is thrown away.
+ */
+class UdpMsgHeader
+{
+  public:
+    UdpMsgHeader(uint32_t session_id=0, uint16_t seq=0, uint16_t stream=0)
+      : m_session_id(session_id), m_seq(seq), m_stream(stream) {}
+    uint32_t sessionId(void) const { return m_session_id; }
+    uint16_t seq(void) const { return m_seq; }
+    uint16_t stream(void) const { return m_stream; }
+
+  private:
+    uint32_t m_session_id;
+    uint16_t m_seq;
+    uint16_t m_stream;
+
+};  /* UdpMsgHeader */
+
+
 
 
 
@@ -416,6 +641,11 @@ class MsgAudio : public Msg
       memcpy(m_buf, buf, size);
       m_size = size;
     }
+    explicit MsgAudio(int size)
+      : Msg(TYPE, sizeof(MsgAudio) - (BUFSIZE - size)), m_size(size)
+    {
+      assert(size <= BUFSIZE);
+    }
     void *buf(void)
     {
       return m_buf;
@@ -429,6 +659,54 @@ class MsgAudio : public Msg
 }; /* MsgAudio */
 
 
+/*
+ * RX audio with the time when it was captured at the remote receiver. This
+ * message replace MsgAudio from the server when timestamps have been
+ * negotiated. The time is only comparable between receivers if their clocks
+ * are synchronized, e.g. using NTP.
+ */
+class MsgTimestampedAudio : public Msg
+{
+  public:
+    static const unsigned TYPE = 103;
+    static const int BUFSIZE = MsgAudio::BUFSIZE;
+    MsgTimestampedAudio(const struct timeval &capture_time, const void *buf,
+                        int size)
+      : Msg(TYPE, sizeof(MsgTimestampedAudio) - (BUFSIZE - size)),
+        m_capture_time(static_cast<uint64_t>(capture_time.tv_sec) * 1000000 +
+                       capture_time.tv_usec)
+    {
+      assert(size <= BUFSIZE);
+      memcpy(m_buf, buf, size);
+      m_size = size;
+    }
+    MsgTimestampedAudio(const struct timeval &capture_time, int size)
+      : Msg(TYPE, sizeof(MsgTimestampedAudio) - (BUFSIZE - size)),
+        m_capture_time(static_cast<uint64_t>(capture_time.tv_sec) * 1000000 +
+                       capture_time.tv_usec),
+        m_size(size)
+    {
+      assert(size <= BUFSIZE);
+    }
+    void captureTime(struct timeval &tv) const
+    {
+      tv.tv_sec = m_capture_time / 1000000;
+      tv.tv_usec = m_capture_time % 1000000;
+    }
+    void *buf(void)
+    {
+      return m_buf;
+    }
+    int size(void) const { return m_size; }
+
+  private:
+    uint64_t  m_capture_time;
+    int       m_size;
+    uint8_t   m_buf[BUFSIZE];
+
+}; /* MsgTimestampedAudio */
+
+
 
 /******************************** RX Messages ********************************/
 
@@ -609,6 +887,94 @@ class MsgSiglevUpdate : public Msg
 }; /* MsgSiglevUpdate */
 
 
+/*
+ * A signal level update with the time when the level was measured. This
+ * message replace MsgSiglevUpdate when timestamps have been negotiated.
+ */
+class MsgTimestampedSiglevUpdate : public Msg
+{
+  public:
+    static const unsigned TYPE = 255;
+    MsgTimestampedSiglevUpdate(const struct timeval &capture_time,
+                               float signal_strength, char sql_rx_id)
+      : Msg(TYPE, sizeof(MsgTimestampedSiglevUpdate)),
+        m_capture_time(static_cast<uint64_t>(capture_time.tv_sec) * 1000000 +
+                       capture_time.tv_usec),
+        m_signal_strength(signal_strength), m_sql_rx_id(sql_rx_id) {}
+    void captureTime(struct timeval &tv) const
+    {
+      tv.tv_sec = m_capture_time / 1000000;
+      tv.tv_usec = m_capture_time % 1000000;
+    }
+    float signalStrength(void) const { return m_signal_strength; }
+    char sqlRxId(void) const { return m_sql_rx_id; }
+
+  private:
+    uint64_t  m_capture_time;
+    float     m_signal_strength;
+    char      m_sql_rx_id;
+
+}; /* MsgTimestampedSiglevUpdate */
+
+
+/*
+ * Signal level updates for several channels in one message. It is sent by
+ * the server instead of one MsgSiglevUpdate per channel when updates for more
+ * than one channel are pending. The message is not affected by
+ * MsgSelectChannel since each entry carry its own channel number.
+ */
+class MsgSiglevBatch : public Msg
+{
+  public:
+    static const unsigned TYPE = 256;
+    static const unsigned MAX_ENTRIES = 256;
+
+    class Entry
+    {
+      public:
+        Entry(uint8_t channel=0, float signal_strength=0.0f,
+              char sql_rx_id='\0')
+          : m_signal_strength(signal_strength), m_channel(channel),
+            m_sql_rx_id(sql_rx_id) {}
+        uint8_t channel(void) const { return m_channel; }
+        float signalStrength(void) const { return m_signal_strength; }
+        char sqlRxId(void) const { return m_sql_rx_id; }
+
+      private:
+        float   m_signal_strength;
+        uint8_t m_channel;
+        char    m_sql_rx_id;
+    };
+
+    MsgSiglevBatch(void)
+      : Msg(TYPE, sizeof(MsgSiglevBatch) - sizeof(m_entries)), m_count(0) {}
+    bool addEntry(const Entry& entry)
+    {
+      if (m_count >= MAX_ENTRIES)
+      {
+        return false;
+      }
+      m_entries[m_count++] = entry;
+      setSize(size() + sizeof(Entry));
+      return true;
+    }
+    unsigned count(void) const { return m_count; }
+    const Entry& entry(unsigned idx) const { return m_entries[idx]; }
+    bool isValid(void) const
+    {
+      return (size() >= sizeof(MsgSiglevBatch) - sizeof(m_entries)) &&
+             (m_count <= MAX_ENTRIES) &&
+             (size() == sizeof(MsgSiglevBatch) - sizeof(m_entries) +
+                        m_count * sizeof(Entry));
+    }
+
+  private:
+    uint16_t  m_count;
+    Entry     m_entries[MAX_ENTRIES];
+
+}; /* MsgSiglevBatch */
+
+
 
 /******************************** TX Messages ********************************/
 
@@ -753,6 +1119,76 @@ class MsgAllSamplesFlushed : public Msg
 #pragma pack(pop)
 
 
+/*
+ * Not a message but a reusable buffer for outgoing messages. For audio
+ * messages only the header is constructed and it is copied into the buffer
+ * directly in front of the payload, so the full size message objects never
+ * have to be allocated. Consecutive messages are appended so that they
+ * can be sent using a single write. The memory is kept when the buffer is
+ * cleared.
+ */
+class MsgBuffer
+{
+  public:
+    MsgBuffer(void) { m_buf.reserve(4 * sizeof(MsgAudio)); }
+    void addMsg(const Msg *msg)
+    {
+      append(msg, msg->size(), 0, 0);
+    }
+    void addData(const void *data, size_t size)
+    {
+      append(data, size, 0, 0);
+    }
+    void addAudio(const void *buf, int size)
+    {
+      const uint8_t *ptr = reinterpret_cast<const uint8_t *>(buf);
+      while (size > 0)
+      {
+        int len = std::min(size, static_cast<int>(MsgAudio::BUFSIZE));
+        MsgAudio hdr(len);
+        append(&hdr, sizeof(MsgAudio) - MsgAudio::BUFSIZE, ptr, len);
+        size -= len;
+        ptr += len;
+      }
+    }
+    void addTimestampedAudio(const struct timeval &capture_time,
+                             const void *buf, int size)
+    {
+      const uint8_t *ptr = reinterpret_cast<const uint8_t *>(buf);
+      while (size > 0)
+      {
+        int len = std::min(size,
+                           static_cast<int>(MsgTimestampedAudio::BUFSIZE));
+        MsgTimestampedAudio hdr(capture_time, len);
+        append(&hdr, sizeof(MsgTimestampedAudio) - MsgTimestampedAudio::BUFSIZE,
+               ptr, len);
+        size -= len;
+        ptr += len;
+      }
+    }
+    bool empty(void) const { return m_buf.empty(); }
+    const void *data(void) const { return &m_buf[0]; }
+    unsigned size(void) const { return m_buf.size(); }
+    void clear(void) { m_buf.clear(); }
+
+  private:
+    std::vector<uint8_t> m_buf;
+
+    void append(const void *hdr, size_t hdr_size, const uint8_t *payload,
+                size_t len)
+    {
+      size_t pos = m_buf.size();
+      m_buf.resize(pos + hdr_size + len);
+      memcpy(&m_buf[pos], hdr, hdr_size);
+      if (len > 0)
+      {
+        memcpy(&m_buf[pos + hdr_size], payload, len);
+      }
+    }
+
+}; /* MsgBuffer */
+
+
 
 } /* namespace */
 
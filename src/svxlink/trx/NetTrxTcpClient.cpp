@@ -42,7 +42,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncApplication.h>
 #include <AsyncTimer.h>
+#include <AsyncConfig.h>
+#include <AsyncSslContext.h>
 
 
 /****************************************************************************
@@ -73,6 +76,14 @@ using namespace NetTrxMsg;
  *
  ****************************************************************************/
 
+  // The first reconnect is done at once. The delay is then doubled for each
+  // failed attempt, from Async::Backoff::MIN_DELAY_MS up to the maximum, with
+  // some jitter added.
+#define RECONNECT_MAX_MS    20000
+
+  // Quick reconnects use the address of the last connection. The host name
+  // is looked up again when the delay reach this value.
+#define RECONNECT_DNS_MS    3200
 
 
 /****************************************************************************
@@ -162,6 +173,54 @@ NetTrxTcpClient *NetTrxTcpClient::instance(const std::string& remote_host,
 } /* NetTrxTcpClient::instance */
 
 
+bool NetTrxTcpClient::setupTls(Config &cfg, const string &section)
+{
+  bool use_tls = false;
+  cfg.getValue(section, "TLS", use_tls);
+  if ((ssl_ctx != 0) || !use_tls)
+  {
+    return true;
+  }
+  if (!isIdle())
+  {
+    cerr << "*** ERROR: " << section << ": TLS must be enabled for all "
+            "receivers and transmitters connecting to " << remote_hostname
+         << ":" << remotePort() << "\n";
+    return false;
+  }
+
+  ssl_ctx = new SslContext(SslContext::ROLE_CLIENT);
+  if (!ssl_ctx->initOk())
+  {
+    return false;
+  }
+  string ca_file;
+  if (cfg.getValue(section, "TLS_CA_FILE", ca_file) &&
+      !ssl_ctx->setCaCertificateFile(ca_file))
+  {
+    return false;
+  }
+  if (!ssl_ctx->verifiesPeer())
+  {
+    cerr << "*** WARNING: " << section << ": TLS is enabled but TLS_CA_FILE "
+            "is not set. The certificate of " << remote_hostname
+         << " will not be verified.\n";
+  }
+  string cert_file;
+  if (cfg.getValue(section, "TLS_CERT_FILE", cert_file))
+  {
+    string key_file;
+    cfg.getValue(section, "TLS_KEY_FILE", key_file);
+    if (!ssl_ctx->setCertificateFiles(cert_file, key_file))
+    {
+      return false;
+    }
+  }
+  setSslContext(ssl_ctx);
+  return true;
+} /* NetTrxTcpClient::setupTls */
+
+
 void NetTrxTcpClient::deleteInstance(void)
 {
   user_cnt -= 1;
@@ -183,10 +242,11 @@ void NetTrxTcpClient::deleteInstance(void)
 } /* NetTrxTcpClient::deleteInstance */
 
 
-void NetTrxTcpClient::sendMsg(Msg *msg)
+void NetTrxTcpClient::sendMsg(Msg *msg, unsigned channel)
 {
   if (state == STATE_READY)
   {
+    selectTxChannel(channel);
     sendMsgP(msg);
   }
   else
@@ -196,6 +256,24 @@ void NetTrxTcpClient::sendMsg(Msg *msg)
 } /* NetTrxTcpClient::sendMsg */
 
 
+void NetTrxTcpClient::sendAudio(const void *buf, int size, unsigned channel)
+{
+  if (state != STATE_READY)
+  {
+    return;
+  }
+  if ((channel == 0) && udp_chan.isActive())
+  {
+    flushOutput();
+    udp_chan.sendAudio(buf, size);
+    return;
+  }
+  selectTxChannel(channel);
+  out_buf.addAudio(buf, size);
+  scheduleFlush();
+} /* NetTrxTcpClient::sendAudio */
+
+
 
 /****************************************************************************
  *
@@ -206,20 +284,30 @@ void NetTrxTcpClient::sendMsg(Msg *msg)
 NetTrxTcpClient::NetTrxTcpClient(const std::string& remote_host,
       	      	      	      	 uint16_t remote_port, size_t recv_buf_len)
   : TcpClient<>(remote_host, remote_port, recv_buf_len), recv_cnt(0),
-    recv_exp(0), reconnect_timer(0), last_msg_timestamp(), heartbeat_timer(0),
-    user_cnt(0), state(STATE_DISC), disc_reason(DR_SYSTEM_ERROR)
+    recv_exp(0), reconnect_timer(0),
+    reconnect_backoff(0, RECONNECT_MAX_MS),
+    remote_hostname(remote_host), last_msg_timestamp(), heartbeat_timer(0),
+    user_cnt(0), state(STATE_DISC), disc_reason(DR_SYSTEM_ERROR),
+    flush_pending(false),
+    udp_chan(remote_host + ":" + to_string(remote_port)),
+    udp_audio_enabled(false), tx_channel(0), rx_channel(0),
+    channels_used(false), resume_msg(0), resume_sent(false), ssl_ctx(0)
 {
   connected.connect(mem_fun(*this, &NetTrxTcpClient::tcpConnected));
   disconnected.connect(mem_fun(*this, &NetTrxTcpClient::tcpDisconnected));
-  dataReceived.connect(mem_fun(*this, &NetTrxTcpClient::tcpDataReceived));
+  setDataHandler<NetTrxTcpClient, &NetTrxTcpClient::tcpDataReceived>(this);
 
-  reconnect_timer = new Timer(20000);
+  reconnect_timer = new Timer(0);
   reconnect_timer->setEnable(false);
   reconnect_timer->expired.connect(mem_fun(*this, &NetTrxTcpClient::reconnect));
   
   heartbeat_timer = new Timer(10000);
   heartbeat_timer->setEnable(false);
   heartbeat_timer->expired.connect(mem_fun(*this, &NetTrxTcpClient::heartbeat));
+
+  udp_chan.msgReceived.connect(
+      mem_fun(*this, &NetTrxTcpClient::udpMsgReceived));
+  udp_chan.packetsLost.connect(audioPacketsLost.make_slot());
   
 } /* NetTrxTcpClient::NetTrxTcpClient */
 
@@ -228,6 +316,9 @@ NetTrxTcpClient::~NetTrxTcpClient(void)
 {
   delete reconnect_timer;
   delete heartbeat_timer;
+  delete resume_msg;
+  setSslContext(0);
+  delete ssl_ctx;
 } /* NetTrxTcpClient::~NetTrxTcpClient */
 
 
@@ -246,7 +337,18 @@ void NetTrxTcpClient::tcpConnected(void)
   recv_exp = sizeof(Msg);
   gettimeofday(&last_msg_timestamp, NULL);
   heartbeat_timer->setEnable(true);
+  tx_channel = 0;
+  rx_channel = 0;
   state = STATE_VER_WAIT;
+
+    // Send the session token at once so that the server can authenticate us
+    // without a challenge/response round trip
+  resume_sent = (resume_msg != 0);
+  if (resume_sent)
+  {
+    out_buf.addMsg(resume_msg);
+    scheduleFlush();
+  }
 } /* NetTx::tcpConnected */
 
 
@@ -255,24 +357,31 @@ void NetTrxTcpClient::tcpDisconnected(TcpConnection *con,
 {
   disc_reason = reason;
   recv_exp = 0;
+  if ((state != STATE_READY) && resume_sent)
+  {
+      // The server may not support session tokens any more
+    delete resume_msg;
+    resume_msg = 0;
+  }
+  resume_sent = false;
   state = STATE_DISC;
+  out_buf.clear();
+  udp_chan.stopSession();
+  reconnect_timer->setTimeout(reconnect_backoff.nextDelay());
   reconnect_timer->setEnable(true);
   heartbeat_timer->setEnable(false);
   isReady(false);
 } /* NetTrxTcpClient::tcpDisconnected */
 
 
-int NetTrxTcpClient::tcpDataReceived(TcpConnection *con, void *data, int size)
+int NetTrxTcpClient::tcpDataReceived(TcpConnection *con, DataView data)
 {
+  int size = data.size();
   //cout << "NetTrxTcpClient::tcpDataReceived: size=" << size << endl;
   
-  //Msg *msg = reinterpret_cast<Msg*>(data);
-  //cout << "Received a TCP message with type " << msg->type()
-  //     << " and size " << msg->size() << endl;
-  
   int orig_size = size;
   
-  char *buf = static_cast<char*>(data);
+  const uint8_t *buf = data.data();
   while (size > 0)
   {
     unsigned read_cnt = min(static_cast<unsigned>(size), recv_exp-recv_cnt);
@@ -332,7 +441,15 @@ int NetTrxTcpClient::tcpDataReceived(TcpConnection *con, void *data, int size)
 void NetTrxTcpClient::reconnect(Timer *t)
 {
   reconnect_timer->setEnable(false);
-  connect();
+  if ((reconnect_backoff.delay() < RECONNECT_DNS_MS) &&
+      !remoteHost().isEmpty())
+  {
+    connect(remoteHost(), remotePort());
+  }
+  else
+  {
+    connect(remote_hostname, remotePort());
+  }
 } /* NetTrxTcpClient::reconnect */
 
 
@@ -351,7 +468,7 @@ void NetTrxTcpClient::handleMsg(Msg *msg)
         MsgProtoVer *ver_msg = reinterpret_cast<MsgProtoVer *>(msg);
         if ((msg->size() != sizeof(MsgProtoVer)) ||
             (ver_msg->majorVer() != MsgProtoVer::MAJOR) ||
-            (ver_msg->minorVer() != MsgProtoVer::MINOR))
+            (ver_msg->minorVer() < MsgProtoVer::MIN_MINOR))
         {
           cerr << "*** ERROR: Incompatible protocol version. Disconnecting from "
                << remoteHost().toString() << ":" << remotePort() << "...\n";
@@ -398,6 +515,13 @@ void NetTrxTcpClient::handleMsg(Msg *msg)
           return;
         }
         state = STATE_READY;
+        reconnect_backoff.reset();
+
+          // Announce our own protocol version so that a server that support
+          // newer features can enable them for this connection
+        MsgProtoVer *ver_msg = new MsgProtoVer;
+        sendMsgP(ver_msg);
+
         isReady(true);
       }
       return;
@@ -416,6 +540,105 @@ void NetTrxTcpClient::handleMsg(Msg *msg)
     }
     
     case MsgProtoVer::TYPE:
+    {
+        // The server acknowledge our version announcement by replying with
+        // the version that will be used for the rest of the connection
+      MsgProtoVer *ver_msg = reinterpret_cast<MsgProtoVer *>(msg);
+      if ((msg->size() == sizeof(MsgProtoVer)) &&
+          (ver_msg->majorVer() == MsgProtoVer::MAJOR))
+      {
+        cout << remoteHost().toString() << ":" << remotePort()
+             << ": Using RemoteTrx protocol version " << ver_msg->majorVer()
+             << "." << ver_msg->minorVer() << endl;
+        if (channels_used &&
+            (ver_msg->minorVer() < MsgProtoVer::MINOR_CHANNELS))
+        {
+          cerr << "*** ERROR: The RemoteTrx at " << remoteHost().toString()
+               << ":" << remotePort() << " does not support channels. "
+                  "Only CHANNEL=0 will work.\n";
+        }
+        break;
+      }
+      cerr << "*** ERROR: Protocol version mismatch. Disconnecting from "
+           << remoteHost().toString() << ":" << remotePort() << "...\n";
+      localDisconnect();
+      break;
+    }
+
+    case MsgSelectChannel::TYPE:
+    {
+      if (msg->size() != sizeof(MsgSelectChannel))
+      {
+        cerr << "*** ERROR: Protocol error. Wrong length of "
+                "MsgSelectChannel message. Disconnecting from "
+             << remoteHost().toString() << ":" << remotePort() << "...\n";
+        localDisconnect();
+        break;
+      }
+      rx_channel = reinterpret_cast<MsgSelectChannel *>(msg)->channel();
+      break;
+    }
+
+    case MsgSiglevBatch::TYPE:
+    {
+      MsgSiglevBatch *batch_msg = reinterpret_cast<MsgSiglevBatch *>(msg);
+      if (!batch_msg->isValid())
+      {
+        cerr << "*** ERROR: Protocol error. Malformed MsgSiglevBatch "
+                "message. Disconnecting from "
+             << remoteHost().toString() << ":" << remotePort() << "...\n";
+        localDisconnect();
+        break;
+      }
+        // Deliver one ordinary signal level update on each channel
+      unsigned tcp_rx_channel = rx_channel;
+      for (unsigned i=0; i<batch_msg->count(); ++i)
+      {
+        const MsgSiglevBatch::Entry& entry = batch_msg->entry(i);
+        rx_channel = entry.channel();
+        MsgSiglevUpdate siglev_msg(entry.signalStrength(), entry.sqlRxId());
+        msgReceived(&siglev_msg);
+      }
+      rx_channel = tcp_rx_channel;
+      break;
+    }
+
+    case MsgSessionToken::TYPE:
+    {
+      if (msg->size() != sizeof(MsgSessionToken))
+      {
+        cerr << "*** ERROR: Protocol error. Wrong length of "
+                "MsgSessionToken message. Disconnecting from "
+             << remoteHost().toString() << ":" << remotePort() << "...\n";
+        localDisconnect();
+        break;
+      }
+      delete resume_msg;
+      resume_msg = new MsgSessionResume(
+          *reinterpret_cast<MsgSessionToken *>(msg));
+      break;
+    }
+
+    case MsgUdpAudioSetup::TYPE:
+    {
+      if (!udp_audio_enabled || (msg->size() != sizeof(MsgUdpAudioSetup)))
+      {
+        break;
+      }
+      if (!udp_chan.isOpen() && !udp_chan.open())
+      {
+        break;
+      }
+      MsgUdpAudioSetup *setup_msg = reinterpret_cast<MsgUdpAudioSetup *>(msg);
+      cout << remoteHost().toString() << ":" << remotePort()
+           << ": Setting up UDP audio channel to port "
+           << setup_msg->udpPort() << endl;
+      udp_chan.startSession(setup_msg->sessionId(), remoteHost(),
+                            setup_msg->udpPort());
+      udp_chan.sendHeartbeat();
+      break;
+    }
+
     case MsgAuthChallenge::TYPE:
     case MsgAuthOk::TYPE:
       cerr << "*** ERROR: Message type " << msg->type()
@@ -437,6 +660,10 @@ void NetTrxTcpClient::heartbeat(Timer *t)
 {
   MsgHeartbeat *msg = new MsgHeartbeat;
   sendMsgP(msg);
+
+    // Keep the UDP channel open through firewalls and NAT
+  udp_chan.checkTimeout();
+  udp_chan.sendHeartbeat();
   
   struct timeval diff_tv;
   struct timeval now;
@@ -467,8 +694,25 @@ void NetTrxTcpClient::sendMsgP(Msg *msg)
 {
   assert(isConnected());
 
-  int written = write(msg, msg->size());
-  if (written != static_cast<int>(msg->size()))
+  out_buf.addMsg(msg);
+  if ((msg->type() == MsgFlush::TYPE) && (tx_channel == 0))
+  {
+      // UDP audio that arrive after the flush will be thrown away
+    udp_chan.flushSent();
+  }
+  delete msg;
+
+    // Messages produced during the same main loop iteration are sent using
+    // a single write
+  scheduleFlush();
+  
+} /* NetTrxTcpClient::sendMsgP */
+
+
+bool NetTrxTcpClient::writeData(const void *buf, unsigned size)
+{
+  int written = write(buf, size);
+  if (written != static_cast<int>(size))
   {
     if (written == -1)
     {
@@ -481,11 +725,60 @@ void NetTrxTcpClient::sendMsgP(Msg *msg)
     }
     disconnect();
     disconnected(this, TcpConnection::DR_ORDERED_DISCONNECT);
+    return false;
   }
-  
-  delete msg;
-  
-} /* NetTrxTcpClient::sendMsgP */
+  return true;
+} /* NetTrxTcpClient::writeData */
+
+
+void NetTrxTcpClient::selectTxChannel(unsigned channel)
+{
+  if (channel != tx_channel)
+  {
+    MsgSelectChannel msg(channel);
+    out_buf.addMsg(&msg);
+    tx_channel = channel;
+    channels_used = true;
+  }
+} /* NetTrxTcpClient::selectTxChannel */
+
+
+void NetTrxTcpClient::scheduleFlush(void)
+{
+  if (!flush_pending)
+  {
+    flush_pending = true;
+    Application::app().runTask(mem_fun(*this, &NetTrxTcpClient::flushOutput));
+  }
+} /* NetTrxTcpClient::scheduleFlush */
+
+
+void NetTrxTcpClient::flushOutput(void)
+{
+  flush_pending = false;
+  if (out_buf.empty())
+  {
+    return;
+  }
+  if (isConnected())
+  {
+    writeData(out_buf.data(), out_buf.size());
+  }
+  out_buf.clear();
+} /* NetTrxTcpClient::flushOutput */
+
+
+void NetTrxTcpClient::udpMsgReceived(Msg *msg)
+{
+  if (state == STATE_READY)
+  {
+      // Only channel 0 use the UDP channel
+    unsigned tcp_rx_channel = rx_channel;
+    rx_channel = 0;
+    msgReceived(msg);
+    rx_channel = tcp_rx_channel;
+  }
+} /* NetTrxTcpClient::udpMsgReceived */
 
 
 
@@ -49,6 +49,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncTcpClient.h>
+#include <AsyncBackoff.h>
 
 
 /****************************************************************************
@@ -58,6 +59,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "NetTrxMsg.h"
+#include "NetTrxUdpChannel.h"
 
 
 /****************************************************************************
@@ -69,6 +71,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 namespace Async
 {
   class Timer;
+  class Config;
+  class SslContext;
 };
 
 
@@ -146,12 +150,60 @@ class NetTrxTcpClient : public Async::TcpClient<>
      * @param key The autentication key to use
      */
     void setAuthKey(const std::string &key) { auth_key = key; }
+
+    /**
+     * @brief Enable TLS on the connection if configured
+     * @param cfg     The configuration to read
+     * @param section The configuration section to read
+     * @return Returns \em false if the TLS configuration is faulty
+     *
+     * TLS is enabled if the TLS configuration variable is set. The
+     * certificates are only loaded by the first user of a shared connection.
+     * This function must be called before the connection is established.
+     */
+    bool setupTls(Async::Config &cfg, const std::string &section);
     
     /**
      * @brief Send a message over the connection
-     * @param msg The message to send
+     * @param msg     The message to send
+     * @param channel The channel on the remote side that the message is for
+     *
+     * All messages sent during the same main loop iteration are written to
+     * the connection using a single write when the call chain has returned
+     * to the main loop.
      */
-    void sendMsg(NetTrxMsg::Msg *msg);
+    void sendMsg(NetTrxMsg::Msg *msg, unsigned channel=0);
+
+    /**
+     * @brief Send encoded audio over the connection
+     * @param buf     The buffer containing the encoded audio
+     * @param size    The number of bytes in the buffer
+     * @param channel The channel on the remote side that the audio is for
+     *
+     * The audio is packed into audio messages in a reusable buffer and is
+     * sent together with other messages in the same way as for sendMsg.
+     */
+    void sendAudio(const void *buf, int size, unsigned channel=0);
+
+    /**
+     * @brief Get the channel that the received message belong to
+     * @return Returns the channel of the message currently being emitted by
+     *         the msgReceived signal
+     *
+     * One connection can carry messages for several remote transceivers.
+     * Users of a shared connection should ignore messages for channels
+     * other than their own.
+     */
+    unsigned rxChannel(void) const { return rx_channel; }
+
+    /**
+     * @brief Accept the UDP audio channel if the server offer it
+     *
+     * When the UDP channel is active, audio is sent and received over UDP
+     * while all other messages still use the TCP connection. Only audio for
+     * channel 0 is sent over UDP.
+     */
+    void enableUdpAudio(void) { udp_audio_enabled = true; }
     
     /**
      * @brief Get the reason for the last disconnect
@@ -170,6 +222,15 @@ class NetTrxTcpClient : public Async::TcpClient<>
      * @param msg The received message
      */
     sigc::signal<void, NetTrxMsg::Msg*> msgReceived;
+
+    /**
+     * @brief A signal that is emitted when UDP audio datagrams were lost
+     * @param lost_cnt The number of lost datagrams
+     *
+     * The signal is emitted just before the audio message that followed the
+     * lost datagrams is emitted by the msgReceived signal.
+     */
+    sigc::signal<void, unsigned> audioPacketsLost;
     
     
   protected:
@@ -207,24 +268,41 @@ class NetTrxTcpClient : public Async::TcpClient<>
     unsigned        recv_cnt;
     unsigned        recv_exp;
     Async::Timer    *reconnect_timer;
+    Async::Backoff  reconnect_backoff;
+    std::string     remote_hostname;
     struct timeval  last_msg_timestamp;
     Async::Timer    *heartbeat_timer;
     int       	    user_cnt;
     std::string     auth_key;
     State           state;
     DiscReason      disc_reason;
+    NetTrxMsg::MsgBuffer out_buf;
+    bool            flush_pending;
+    NetTrxUdpChannel udp_chan;
+    bool            udp_audio_enabled;
+    unsigned        tx_channel;
+    unsigned        rx_channel;
+    bool            channels_used;
+    NetTrxMsg::MsgSessionResume *resume_msg;
+    bool            resume_sent;
+    Async::SslContext *ssl_ctx;
     
     NetTrxTcpClient(const NetTrxTcpClient&);
     NetTrxTcpClient& operator=(const NetTrxTcpClient&);
     void tcpConnected(void);
     void tcpDisconnected(Async::TcpConnection *con,
       	      	      	 Async::TcpConnection::DisconnectReason reason);
-    int tcpDataReceived(TcpConnection *con, void *data, int size);
+    int tcpDataReceived(TcpConnection *con, Async::DataView data);
     void reconnect(Async::Timer *t);
     void handleMsg(NetTrxMsg::Msg *msg);
     void heartbeat(Async::Timer *t);
     void localDisconnect(void);
     void sendMsgP(NetTrxMsg::Msg *msg);
+    bool writeData(const void *buf, unsigned size);
+    void selectTxChannel(unsigned channel);
+    void scheduleFlush(void);
+    void flushOutput(void);
+    void udpMsgReceived(NetTrxMsg::Msg *msg);
 
 };  /* class NetTrxTcpClient */
 
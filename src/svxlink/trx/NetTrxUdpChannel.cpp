@@ -0,0 +1,369 @@
+/**
+@file	 NetTrxUdpChannel.cpp
+@brief   The UDP audio channel of a remote transceiver connection
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncUdpSocket.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "NetTrxUdpChannel.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace NetTrxMsg;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // Heartbeats are sent every ten seconds so this allow two to be lost
+#define UDP_TIMEOUT_MS    25000
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+NetTrxUdpChannel::NetTrxUdpChannel(const std::string& name)
+  : name(name), sock(0), local_port(0), session_id(0), peer_port(0), learn_peer_port(false),
+    in_session(false), is_active(false), next_tx_seq(0), next_rx_seq(0),
+    tx_stream(0), rx_stream(0), last_rx_timestamp(), lost_cnt(0)
+{
+} /* NetTrxUdpChannel::NetTrxUdpChannel */
+
+
+NetTrxUdpChannel::~NetTrxUdpChannel(void)
+{
+  delete sock;
+  sock = 0;
+} /* NetTrxUdpChannel::~NetTrxUdpChannel */
+
+
+bool NetTrxUdpChannel::open(uint16_t local_port)
+{
+  delete sock;
+  this->local_port = local_port;
+  sock = new UdpSocket(local_port);
+  if (!sock->initOk())
+  {
+    cerr << "*** ERROR: Could not open the UDP audio socket for " << name;
+    if (local_port != 0)
+    {
+      cerr << " on port " << local_port;
+    }
+    cerr << endl;
+    delete sock;
+    sock = 0;
+    return false;
+  }
+  sock->setDataHandler<NetTrxUdpChannel,
+                       &NetTrxUdpChannel::datagramReceived>(this);
+  return true;
+} /* NetTrxUdpChannel::open */
+
+
+void NetTrxUdpChannel::startSession(uint32_t session_id,
+                                    const IpAddress& peer_ip,
+                                    uint16_t peer_port)
+{
+  stopSession();
+  this->session_id = session_id;
+  this->peer_ip = peer_ip;
+  this->peer_port = peer_port;
+  learn_peer_port = (peer_port == 0);
+  in_session = true;
+} /* NetTrxUdpChannel::startSession */
+
+
+void NetTrxUdpChannel::stopSession(void)
+{
+  if (in_session && (lost_cnt > 0))
+  {
+    cout << name << ": " << lost_cnt << " UDP audio datagrams were lost\n";
+  }
+  in_session = false;
+  is_active = false;
+  peer_port = 0;
+  next_tx_seq = 0;
+  next_rx_seq = 0;
+  tx_stream = 0;
+  rx_stream = 0;
+  lost_cnt = 0;
+} /* NetTrxUdpChannel::stopSession */
+
+
+void NetTrxUdpChannel::sendHeartbeat(void)
+{
+  MsgHeartbeat msg;
+  sendMsg(&msg, sizeof(msg), 0, 0);
+} /* NetTrxUdpChannel::sendHeartbeat */
+
+
+void NetTrxUdpChannel::sendAudio(const void *buf, int size)
+{
+  const uint8_t *ptr = reinterpret_cast<const uint8_t *>(buf);
+  while (size > 0)
+  {
+    int len = min(size, static_cast<int>(MsgAudio::BUFSIZE));
+    MsgAudio hdr(len);
+    sendMsg(&hdr, sizeof(MsgAudio) - MsgAudio::BUFSIZE, ptr, len);
+    size -= len;
+    ptr += len;
+  }
+} /* NetTrxUdpChannel::sendAudio */
+
+
+void NetTrxUdpChannel::sendTimestampedAudio(
+    const struct timeval& capture_time, const void *buf, int size)
+{
+  const uint8_t *ptr = reinterpret_cast<const uint8_t *>(buf);
+  while (size > 0)
+  {
+    int len = min(size, static_cast<int>(MsgTimestampedAudio::BUFSIZE));
+    MsgTimestampedAudio hdr(capture_time, len);
+    sendMsg(&hdr, sizeof(MsgTimestampedAudio) - MsgTimestampedAudio::BUFSIZE,
+            ptr, len);
+    size -= len;
+    ptr += len;
+  }
+} /* NetTrxUdpChannel::sendTimestampedAudio */
+
+
+void NetTrxUdpChannel::checkTimeout(void)
+{
+  if (!is_active)
+  {
+    return;
+  }
+
+  struct timeval now, diff_tv;
+  gettimeofday(&now, NULL);
+  timersub(&now, &last_rx_timestamp, &diff_tv);
+  int diff_ms = diff_tv.tv_sec * 1000 + diff_tv.tv_usec / 1000;
+  if (diff_ms > UDP_TIMEOUT_MS)
+  {
+    cout << name << ": UDP audio channel timed out. Sending audio over TCP.\n";
+    is_active = false;
+  }
+} /* NetTrxUdpChannel::checkTimeout */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void NetTrxUdpChannel::sendMsg(const void *hdr, size_t hdr_size,
+                               const void *payload, size_t payload_size)
+{
+  if ((sock == 0) || !in_session || (peer_port == 0))
+  {
+    return;
+  }
+
+  UdpMsgHeader udp_hdr(session_id, next_tx_seq++, tx_stream);
+  struct iovec iov[3];
+  iov[0].iov_base = &udp_hdr;
+  iov[0].iov_len = sizeof(udp_hdr);
+  iov[1].iov_base = const_cast<void *>(hdr);
+  iov[1].iov_len = hdr_size;
+  iov[2].iov_base = const_cast<void *>(payload);
+  iov[2].iov_len = payload_size;
+  sock->writev(peer_ip, peer_port, iov, (payload_size > 0) ? 3 : 2);
+} /* NetTrxUdpChannel::sendMsg */
+
+
+void NetTrxUdpChannel::datagramReceived(const IpAddress& ip, uint16_t port,
+                                        DataView data)
+{
+  if (!in_session || (ip != peer_ip) ||
+      (!learn_peer_port && (port != peer_port)))
+  {
+    return;
+  }
+
+  if (data.size() < sizeof(UdpMsgHeader) + sizeof(Msg))
+  {
+    cerr << "*** WARNING: Too short UDP audio datagram received by "
+         << name << endl;
+    return;
+  }
+  const UdpMsgHeader *hdr =
+    reinterpret_cast<const UdpMsgHeader *>(data.data());
+  if (hdr->sessionId() != session_id)
+  {
+    return;
+  }
+    // The datagram is in the writable receive buffer of the socket so the
+    // message can be handed on as non-const
+  Msg *msg = reinterpret_cast<Msg *>(
+      const_cast<uint8_t *>(data.data()) + sizeof(UdpMsgHeader));
+  if (msg->size() != data.size() - sizeof(UdpMsgHeader))
+  {
+    cerr << "*** WARNING: Malformed UDP audio datagram received by "
+         << name << endl;
+    return;
+  }
+
+    // The client may get a new port if it is behind a NAT
+  if (learn_peer_port)
+  {
+    peer_port = port;
+  }
+
+  gettimeofday(&last_rx_timestamp, NULL);
+  if (!is_active)
+  {
+    cout << name << ": UDP audio channel active\n";
+    is_active = true;
+  }
+
+  uint16_t seq_diff = hdr->seq() - next_rx_seq;
+  if (seq_diff > 0x7fff)
+  {
+      // Late datagram. The audio after it has already been played.
+    return;
+  }
+  lost_cnt += seq_diff;
+  next_rx_seq = hdr->seq() + 1;
+
+  switch (msg->type())
+  {
+    case MsgHeartbeat::TYPE:
+      if (learn_peer_port)
+      {
+        sendHeartbeat();
+      }
+      break;
+
+    case MsgAudio::TYPE:
+    case MsgTimestampedAudio::TYPE:
+    {
+      uint16_t stream_diff = rx_stream - hdr->stream();
+      if ((stream_diff > 0) && (stream_diff < 0x8000))
+      {
+          // The stream has already been flushed
+        break;
+      }
+      if (seq_diff > 0)
+      {
+        packetsLost(seq_diff);
+      }
+      msgReceived(msg);
+      break;
+    }
+
+    default:
+      break;
+  }
+} /* NetTrxUdpChannel::datagramReceived */
+
+
+
+/*
+ * This file has not been truncated
+ */
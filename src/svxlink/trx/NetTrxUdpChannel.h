@@ -0,0 +1,285 @@
+/**
+@file	 NetTrxUdpChannel.h
+@brief   The UDP audio channel of a remote transceiver connection
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef NET_TRX_UDP_CHANNEL_INCLUDED
+#define NET_TRX_UDP_CHANNEL_INCLUDED
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/time.h>
+#include <stdint.h>
+#include <sigc++/sigc++.h>
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncIpAddress.h>
+#include <AsyncDataHandler.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "NetTrxMsg.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class UdpSocket;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	The UDP audio channel of a remote transceiver connection
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+Audio sent over the TCP connection between svxlink and remotetrx get stuck
+behind any lost segment until it has been retransmitted. This class implement
+an optional UDP channel that is used for the audio only. Control messages,
+authentication and heartbeats still use the TCP connection, which is also used
+to set up the UDP channel using a MsgUdpAudioSetup message.
+
+Each datagram start with a NetTrxMsg::UdpMsgHeader, holding the session id
+and a sequence number, followed by an ordinary message. The channel is
+considered active when a valid datagram has been received from the peer. If
+nothing is received for a while, the channel become inactive and the users
+should go back to sending audio over TCP.
+
+The server side learn the UDP port of the client from the first valid
+datagram. Datagrams must come from the same IP address as the TCP connection.
+*/
+class NetTrxUdpChannel : public sigc::trackable
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param   name The name of the owner, used in log messages
+     */
+    explicit NetTrxUdpChannel(const std::string& name);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~NetTrxUdpChannel(void);
+
+    /**
+     * @brief   Open the UDP socket
+     * @param   local_port The local port to bind to, 0 for a random port
+     * @return  Returns \em true on success or else \em false
+     */
+    bool open(uint16_t local_port=0);
+
+    /**
+     * @brief   Check if the UDP socket is open
+     */
+    bool isOpen(void) const { return sock != 0; }
+
+    /**
+     * @brief   Get the local port
+     * @return  Returns the port given to open, 0 if it was a random port
+     */
+    uint16_t localPort(void) const { return local_port; }
+
+    /**
+     * @brief   Start a new session
+     * @param   session_id  The session id sent by the server
+     * @param   peer_ip     The IP address of the peer
+     * @param   peer_port   The UDP port of the peer, 0 to learn it
+     */
+    void startSession(uint32_t session_id, const Async::IpAddress& peer_ip,
+                      uint16_t peer_port=0);
+
+    /**
+     * @brief   Stop the session
+     *
+     * Call this when the TCP connection is closed. All received datagrams
+     * are ignored until a new session is started.
+     */
+    void stopSession(void);
+
+    /**
+     * @brief   Check if audio should be sent over UDP
+     * @return  Returns \em true if the peer has been heard from recently
+     */
+    bool isActive(void) const { return is_active; }
+
+    /**
+     * @brief   Send a heartbeat to the peer
+     *
+     * The client should call this regularly to keep firewalls and NAT
+     * mappings open. The server reply to each heartbeat it receive.
+     */
+    void sendHeartbeat(void);
+
+    /**
+     * @brief   Send encoded audio to the peer
+     * @param   buf  The buffer containing the encoded audio
+     * @param   size The number of bytes in the buffer
+     */
+    void sendAudio(const void *buf, int size);
+
+    /**
+     * @brief   Send encoded audio with a capture time to the peer
+     * @param   capture_time The time when the audio was captured
+     * @param   buf  The buffer containing the encoded audio
+     * @param   size The number of bytes in the buffer
+     */
+    void sendTimestampedAudio(const struct timeval& capture_time,
+                              const void *buf, int size);
+
+    /**
+     * @brief   Tell the channel that a MsgFlush has been sent over TCP
+     */
+    void flushSent(void) { ++tx_stream; }
+
+    /**
+     * @brief   Tell the channel that a MsgFlush has been received over TCP
+     */
+    void flushReceived(void) { ++rx_stream; }
+
+    /**
+     * @brief   Check if the peer has gone silent
+     *
+     * Call this regularly, e.g. from the TCP heartbeat handler. The channel
+     * become inactive if no datagram has been received for a while.
+     */
+    void checkTimeout(void);
+
+    /**
+     * @brief   A signal that is emitted when an audio message is received
+     * @param   msg The received message
+     */
+    sigc::signal<void, NetTrxMsg::Msg*> msgReceived;
+
+    /**
+     * @brief   A signal that is emitted when one or more datagrams were lost
+     * @param   lost_cnt The number of lost datagrams
+     *
+     * The signal is emitted just before the message in the datagram that
+     * followed the lost ones is emitted.
+     */
+    sigc::signal<void, unsigned> packetsLost;
+
+  protected:
+
+  private:
+    std::string         name;
+    Async::UdpSocket    *sock;
+    uint16_t            local_port;
+    uint32_t            session_id;
+    Async::IpAddress    peer_ip;
+    uint16_t            peer_port;
+    bool                learn_peer_port;
+    bool                in_session;
+    bool                is_active;
+    uint16_t            next_tx_seq;
+    uint16_t            next_rx_seq;
+    uint16_t            tx_stream;
+    uint16_t            rx_stream;
+    struct timeval      last_rx_timestamp;
+    unsigned long       lost_cnt;
+
+    NetTrxUdpChannel(const NetTrxUdpChannel&);
+    NetTrxUdpChannel& operator=(const NetTrxUdpChannel&);
+    void sendMsg(const void *hdr, size_t hdr_size, const void *payload,
+                 size_t payload_size);
+    void datagramReceived(const Async::IpAddress& ip, uint16_t port,
+                          Async::DataView data);
+
+};  /* class NetTrxUdpChannel */
+
+
+//} /* namespace */
+
+#endif /* NET_TRX_UDP_CHANNEL_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -32,6 +32,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <cstring>
@@ -123,7 +124,7 @@ NetTx::NetTx(Config &cfg, const string& name)
     log_disconnect(true), mode(Tx::TX_OFF),
     ctcss_enable(false), pacer(0), is_connected(false), pending_flush(false),
     unflushed_samples(false), audio_enc(0), fq(0),
-    modulation(Modulation::MOD_UNKNOWN)
+    modulation(Modulation::MOD_UNKNOWN), channel(0), encoded_flush(false)
 {
 } /* NetTx::NetTx */
 
@@ -160,6 +161,15 @@ bool NetTx::initialize(void)
   
   cfg.getValue(name(), "LOG_DISCONNECTS_ONCE", log_disconnects_once);
 
+  bool udp_audio = false;
+  cfg.getValue(name(), "UDP_AUDIO", udp_audio);
+
+  if (!cfg.getValue(name(), "CHANNEL", 0U, 255U, channel, true))
+  {
+    cerr << "*** ERROR: " << name() << "/CHANNEL must be in the range 0-255\n";
+    return false;
+  }
+
   string audio_enc_name;
   cfg.getValue(name(), "CODEC", audio_enc_name);
   if (audio_enc_name.empty())
@@ -207,8 +217,16 @@ bool NetTx::initialize(void)
     return false;
   }
   tcp_con->setAuthKey(auth_key);
+  if (!tcp_con->setupTls(cfg, name()))
+  {
+    return false;
+  }
   tcp_con->isReady.connect(mem_fun(*this, &NetTx::connectionReady));
   tcp_con->msgReceived.connect(mem_fun(*this, &NetTx::handleMsg));
+  if (udp_audio)
+  {
+    tcp_con->enableUdpAudio();
+  }
   tcp_con->connect();
   
   return true;
@@ -291,6 +309,38 @@ void NetTx::setModulation(Modulation::Type mod)
 } /* NetTx::setModulation */
 
 
+bool NetTx::canWriteEncodedAudio(const std::string& codec_name,
+                                 const CodecOptions& dec_opts)
+{
+  if ((audio_enc == 0) || (codec_name != audio_enc->name()))
+  {
+    return false;
+  }
+
+    // The remote decoder will be set up in the same way as the decoder the
+    // audio was originally encoded for, so it can decode the audio as is
+  CodecOptions our_opts;
+  decoderOptions(our_opts);
+  CodecOptions their_opts(dec_opts);
+  sort(our_opts.begin(), our_opts.end());
+  sort(their_opts.begin(), their_opts.end());
+  return our_opts == their_opts;
+} /* NetTx::canWriteEncodedAudio */
+
+
+void NetTx::writeEncodedAudio(const void *buf, int size)
+{
+  writeEncodedSamples(buf, size);
+} /* NetTx::writeEncodedAudio */
+
+
+void NetTx::flushEncodedAudio(void)
+{
+  encoded_flush = true;
+  flushEncodedSamples();
+} /* NetTx::flushEncodedAudio */
+
+
 
 /****************************************************************************
  *
@@ -307,6 +357,24 @@ void NetTx::setModulation(Modulation::Type mod)
  *
  ****************************************************************************/
 
+void NetTx::decoderOptions(CodecOptions& opts) const
+{
+  string opt_prefix(audio_enc->name());
+  opt_prefix += "_DEC_";
+  list<string> names = cfg.listSection(name());
+  list<string>::const_iterator nit;
+  for (nit=names.begin(); nit!=names.end(); ++nit)
+  {
+    if ((*nit).find(opt_prefix) == 0)
+    {
+      string opt_value;
+      cfg.getValue(name(), *nit, opt_value);
+      opts.push_back(make_pair((*nit).substr(opt_prefix.size()), opt_value));
+    }
+  }
+} /* NetTx::decoderOptions */
+
+
 void NetTx::connectionReady(bool is_ready)
 {
   if (is_ready)
@@ -337,19 +405,11 @@ void NetTx::connectionReady(bool is_ready)
 
     MsgAudioCodecSelect *msg = new MsgTxAudioCodecSelect(audio_enc->name());
     cout << name() << ": Requesting CODEC \"" << msg->name() << "\"\n";
-    string opt_prefix(audio_enc->name());
-    opt_prefix += "_DEC_";
-    list<string> names = cfg.listSection(name());
-    list<string>::const_iterator nit;
-    for (nit=names.begin(); nit!=names.end(); ++nit)
+    CodecOptions opts;
+    decoderOptions(opts);
+    for (CodecOptions::const_iterator it=opts.begin(); it!=opts.end(); ++it)
     {
-      if ((*nit).find(opt_prefix) == 0)
-      {
-	string opt_value;
-	cfg.getValue(name(), *nit, opt_value);
-	string opt_name((*nit).substr(opt_prefix.size()));
-	msg->addOption(opt_name, opt_value);
-      }
+      msg->addOption((*it).first, (*it).second);
     }
     sendMsg(msg);
   }
@@ -376,6 +436,11 @@ void NetTx::connectionReady(bool is_ready)
 
 void NetTx::handleMsg(Msg *msg)
 {
+  if (tcp_con->rxChannel() != channel)
+  {
+    return;
+  }
+
   switch (msg->type())
   {
     case MsgTxTimeout::TYPE:
@@ -411,27 +476,23 @@ void NetTx::handleMsg(Msg *msg)
 
 void NetTx::sendMsg(Msg *msg)
 {
-  tcp_con->sendMsg(msg);
+  tcp_con->sendMsg(msg, channel);
 } /* NetUplink::sendMsg */
 
 
 void NetTx::writeEncodedSamples(const void *buf, int size)
 {
   pending_flush = false;
+  const bool audio_started = !unflushed_samples;
   unflushed_samples = true;
   
   if (is_connected)
   {
-    const char *ptr = reinterpret_cast<const char *>(buf);
-    while (size > 0)
+    if (audio_started)
     {
-      const int bufsize = MsgAudio::BUFSIZE;
-      int len = min(size, bufsize);
-      MsgAudio *msg = new MsgAudio(ptr, len);
-      sendMsg(msg);
-      size -= len;
-      ptr += len;
+      txAudioStarted();
     }
+    tcp_con->sendAudio(buf, size, channel);
   }
   else
   {
@@ -462,7 +523,15 @@ void NetTx::allEncodedSamplesFlushed(void)
 {
   unflushed_samples = false;
   pending_flush = false;
-  audio_enc->allEncodedSamplesFlushed();
+  if (encoded_flush)
+  {
+    encoded_flush = false;
+    allEncodedAudioFlushed();
+  }
+  else
+  {
+    audio_enc->allEncodedSamplesFlushed();
+  }
   
   if (!is_connected && (mode == Tx::TX_AUTO))
   {
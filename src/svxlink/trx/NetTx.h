@@ -199,6 +199,29 @@ class NetTx : public Tx
      */
     virtual void setModulation(Modulation::Type mod);
 
+    /**
+     * @brief   Check if encoded audio can be written to this transmitter
+     * @param   codec_name The name of the codec used to encode the audio
+     * @param   dec_opts   The options that a decoder for the audio would use
+     * @return  Returns \em true if the codec is the one configured for this
+     *          transmitter and the decoder options are the same as the ones
+     *          that are sent to the remote decoder
+     */
+    virtual bool canWriteEncodedAudio(const std::string& codec_name,
+                                      const CodecOptions& dec_opts);
+
+    /**
+     * @brief   Send encoded audio on to the remote transmitter
+     * @param   buf  The buffer containing the encoded audio
+     * @param   size The number of bytes in the buffer
+     */
+    virtual void writeEncodedAudio(const void *buf, int size);
+
+    /**
+     * @brief   Flush the encoded audio sent to the remote transmitter
+     */
+    virtual void flushEncodedAudio(void);
+
   protected:
 
   private:
@@ -215,7 +238,10 @@ class NetTx : public Tx
     Async::AudioEncoder   *audio_enc;
     unsigned              fq;
     Modulation::Type      modulation;
+    unsigned              channel;
+    bool                  encoded_flush;
     
+    void decoderOptions(CodecOptions& opts) const;
     void connectionReady(bool is_ready);
     void handleMsg(NetTrxMsg::Msg *msg);
     void sendMsg(NetTrxMsg::Msg *msg);
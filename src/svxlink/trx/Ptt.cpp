@@ -53,6 +53,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Ptt.h"
 #include "PttSerialPin.h"
 #include "PttGpio.h"
+#ifdef HAS_GPIOD_SUPPORT
+#include "PttGpiod.h"
+#endif
 #include "PttPty.h"
 #ifdef HAS_HIDRAW_SUPPORT
 #include "PttHidraw.h"
@@ -137,6 +140,9 @@ Ptt *PttFactoryBase::createNamedPtt(Config& cfg, const string& name)
   PttDummy::Factory dummy_ptt_factory;
   PttSerialPin::Factory serial_ptt_factory;
   PttGpio::Factory gpio_ptt_factory;
+#ifdef HAS_GPIOD_SUPPORT
+  PttGpiod::Factory gpiod_ptt_factory;
+#endif
   PttPty::Factory pty_ptt_factory;
 #ifdef HAS_HIDRAW_SUPPORT
   PttHidraw::Factory hidraw_ptt_factory;
@@ -0,0 +1,174 @@
+/**
+@file	 PttGpiod.cpp
+@brief   A PTT hardware controller using the Linux GPIO character device
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "PttGpiod.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+PttGpiod::PttGpiod(void)
+{
+} /* PttGpiod::PttGpiod */
+
+
+PttGpiod::~PttGpiod(void)
+{
+} /* PttGpiod::~PttGpiod */
+
+
+bool PttGpiod::initialize(Async::Config &cfg, const std::string name)
+{
+  string chip("gpiochip0");
+  cfg.getValue(name, "PTT_GPIOD_CHIP", chip);
+
+  string ptt_line;
+  if (!cfg.getValue(name, "PTT_GPIOD_LINE", ptt_line) || ptt_line.empty())
+  {
+    cerr << "*** ERROR: Config variable " << name
+         << "/PTT_GPIOD_LINE not set\n";
+    return false;
+  }
+
+  if (!line.openOutput(chip, ptt_line, "svxlink-ptt"))
+  {
+    cerr << "*** ERROR: Could not set up the PTT GPIO line in transmitter "
+         << name << ".\n";
+    return false;
+  }
+
+  return true;
+} /* PttGpiod::initialize */
+
+
+bool PttGpiod::setTxOn(bool tx_on)
+{
+  //cerr << "### PttGpiod::setTxOn(" << (tx_on ? "true" : "false") << ")\n";
+  return line.setValue(tx_on);
+} /* PttGpiod::setTxOn */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
+
@@ -0,0 +1,298 @@
+/**
+@file	 RtlFile.cpp
+@brief   A class that replay I/Q samples recorded from an RTL2832u dongle
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "RtlFile.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The interval between blocks when replaying in real time
+#define PACE_INTERVAL   10
+
+  // The number of blocks sent each main loop iteration when replaying as
+  // fast as possible. Other events still get handled between the bursts.
+#define FAST_BURST      10
+
+  // If a real time replay fall this many seconds behind, e.g. because the
+  // host was suspended, the pacing is restarted instead of trying to catch up
+#define MAX_LAG         1.0
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static double monotonicTime(void);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+RtlFile::RtlFile(const string &filename, bool realtime, bool loop)
+  : filename(filename), realtime(realtime), loop(loop), ready(false),
+    file_data(0), file_size(0), file_pos(0), start_timer(0),
+    pace_timer(realtime ? PACE_INTERVAL : 0, Timer::TYPE_PERIODIC, false),
+    start_time(0.0), samples_sent(0)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    cerr << "*** ERROR: Could not open I/Q file \"" << filename << "\": "
+         << strerror(errno) << endl;
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0)
+  {
+    cerr << "*** ERROR: Could not stat I/Q file \"" << filename << "\": "
+         << strerror(errno) << endl;
+    ::close(fd);
+    return;
+  }
+  file_size = st.st_size & ~static_cast<size_t>(1);
+  if (file_size == 0)
+  {
+    cerr << "*** ERROR: The I/Q file \"" << filename << "\" is empty\n";
+    ::close(fd);
+    return;
+  }
+  void *data = mmap(0, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+  {
+    cerr << "*** ERROR: Could not map I/Q file \"" << filename << "\": "
+         << strerror(errno) << endl;
+    file_size = 0;
+    return;
+  }
+  madvise(data, file_size, MADV_SEQUENTIAL);
+  file_data = static_cast<const uint8_t *>(data);
+
+    // Start the replay from the main loop so that all signals have been
+    // connected and all settings have been applied before samples arrive
+  start_timer.expired.connect(hide(mem_fun(*this, &RtlFile::start)));
+  pace_timer.expired.connect(realtime ?
+      hide(mem_fun(*this, &RtlFile::paceTimerExpired)) :
+      hide(mem_fun(*this, &RtlFile::sendAsFastAsPossible)));
+} /* RtlFile::RtlFile */
+
+
+RtlFile::~RtlFile(void)
+{
+  if (file_data != 0)
+  {
+    munmap(const_cast<uint8_t *>(file_data), file_size);
+    file_data = 0;
+  }
+} /* RtlFile::~RtlFile */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void RtlFile::handleSetSampleRate(uint32_t rate)
+{
+  resetPacing();
+} /* RtlFile::handleSetSampleRate */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void RtlFile::start(void)
+{
+  start_timer.setEnable(false);
+  ready = true;
+  readyStateChanged();
+  resetPacing();
+  pace_timer.setEnable(true);
+} /* RtlFile::start */
+
+
+void RtlFile::stop(void)
+{
+  pace_timer.setEnable(false);
+  ready = false;
+  cout << filename << ": End of I/Q file reached\n";
+  readyStateChanged();
+} /* RtlFile::stop */
+
+
+void RtlFile::resetPacing(void)
+{
+  start_time = monotonicTime();
+  samples_sent = 0;
+} /* RtlFile::resetPacing */
+
+
+bool RtlFile::sendBlock(void)
+{
+  if (file_pos >= file_size)
+  {
+    if (!loop)
+    {
+      stop();
+      return false;
+    }
+    file_pos = 0;
+  }
+  size_t len = blockSize();
+  if (len > file_size - file_pos)
+  {
+    len = file_size - file_pos;
+  }
+  const int samp_count = len / 2;
+  handleIq(reinterpret_cast<const complex<uint8_t> *>(file_data + file_pos),
+           samp_count);
+  file_pos += len;
+  samples_sent += samp_count;
+  return true;
+} /* RtlFile::sendBlock */
+
+
+void RtlFile::paceTimerExpired(void)
+{
+  const double elapsed = monotonicTime() - start_time;
+  const unsigned long long target =
+    static_cast<unsigned long long>(elapsed * sampleRate());
+  if (target > samples_sent + MAX_LAG * sampleRate())
+  {
+    resetPacing();
+    return;
+  }
+  while ((samples_sent + blockSize() / 2 <= target) && sendBlock())
+  {
+  }
+} /* RtlFile::paceTimerExpired */
+
+
+void RtlFile::sendAsFastAsPossible(void)
+{
+  for (int i=0; (i<FAST_BURST) && sendBlock(); ++i)
+  {
+  }
+} /* RtlFile::sendAsFastAsPossible */
+
+
+static double monotonicTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+} /* monotonicTime */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,253 @@
+/**
+@file	 RtlFile.h
+@brief   A class that replay I/Q samples recorded from an RTL2832u dongle
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef RTL_FILE_INCLUDED
+#define RTL_FILE_INCLUDED
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncTimer.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "RtlSdr.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Replay recorded I/Q samples as if they came from a dongle
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class reads I/Q samples from a file and feed them into the same signal
+chain as the samples from a real dongle. The file format is the raw
+interleaved unsigned 8 bit I/Q format that is written by the rtl_sdr utility
+and by the capture function in the RtlSdr class. The file does not contain
+any information about the sample rate or the center frequency so these must
+be set to the same values that were used when the file was recorded.
+
+The samples are either replayed in real time, paced by the set sample rate,
+or as fast as possible. Replaying as fast as possible is useful for
+measuring the performance of the whole receiver chain. The file is mapped
+into memory so no extra copying is done when reading it.
+*/
+class RtlFile : public RtlSdr
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param   filename  The name of the file to replay
+     * @param   realtime  Set to \em false to replay as fast as possible
+     * @param   loop      Set to \em true to restart at the end of the file
+     */
+    RtlFile(const std::string &filename, bool realtime=true, bool loop=false);
+
+    /**
+     * @brief 	Destructor
+     */
+    virtual ~RtlFile(void);
+
+    /**
+     * @brief   Find out if the RTL dongle is ready for operation
+     * @returns Returns \em true if the dongle is ready for operation
+     *
+     * The file replay is ready while there are samples left to replay.
+     */
+    virtual bool isReady(void) const { return ready; }
+
+    /**
+     * @brief   Return a string which identifies the specific dongle
+     * @returns Returns a string that uniquely identifies the dongle
+     */
+    virtual const std::string displayName(void) const { return filename; }
+
+  protected:
+    /**
+     * @brief   Set tuner IF gain for the specified stage
+     * @param   stage The number of the gain stage to set
+     * @param   gain The gain in tenths of a dB to set (105=10.5dB)
+     *
+     * The setting is ignored since the samples are already recorded.
+     */
+    virtual void handleSetTunerIfGain(uint16_t stage, int16_t gain) {}
+
+    /**
+     * @brief   Set the center frequency of the tuner
+     * @param   fq The new center frequency, in Hz, to set
+     *
+     * The setting is ignored since the samples are already recorded.
+     */
+    virtual void handleSetCenterFq(uint32_t fq) {}
+
+    /**
+     * @brief   Set the tuner sample rate
+     * @param   rate The new sample, in Hz, rate to set
+     *
+     * The sample rate is used to pace a real time replay.
+     */
+    virtual void handleSetSampleRate(uint32_t rate);
+
+    /**
+     * @brief   Set the gain mode
+     * @param   mode The gain mode to set: 0=automatic, 1=manual
+     *
+     * The setting is ignored since the samples are already recorded.
+     */
+    virtual void handleSetGainMode(uint32_t mode) {}
+
+    /**
+     * @brief   Set manual gain
+     * @param   gain The gain in tenths of a dB to set (105=10.5dB)
+     *
+     * The setting is ignored since the samples are already recorded.
+     */
+    virtual void handleSetGain(int32_t gain) {}
+
+    /**
+     * @brief   Set frequency correction factor
+     * @param   corr The frequency correction factor in PPM
+     *
+     * The setting is ignored since the samples are already recorded.
+     */
+    virtual void handleSetFqCorr(int corr) {}
+
+    /**
+     * @brief   Enable or disable test mode
+     * @param   enable Set to \em true to enable testing
+     *
+     * The setting is ignored since the samples are already recorded.
+     */
+    virtual void handleEnableTestMode(bool enable) {}
+
+    /**
+     * @brief   Enable or disable the digital AGC of the RTL2832
+     * @param   enable Set to \em true to enable the digital AGC
+     *
+     * The setting is ignored since the samples are already recorded.
+     */
+    virtual void handleEnableDigitalAgc(bool enable) {}
+
+  private:
+    std::string               filename;
+    bool                      realtime;
+    bool                      loop;
+    bool                      ready;
+    const uint8_t             *file_data;
+    size_t                    file_size;
+    size_t                    file_pos;
+    Async::Timer              start_timer;
+    Async::Timer              pace_timer;
+    double                    start_time;
+    unsigned long long        samples_sent;
+
+    RtlFile(const RtlFile&);
+    RtlFile& operator=(const RtlFile&);
+    void start(void);
+    void stop(void);
+    void resetPacing(void);
+    bool sendBlock(void);
+    void paceTimerExpired(void);
+    void sendAsFastAsPossible(void);
+
+};  /* class RtlFile */
+
+
+
+//} /* namespace */
+
+#endif /* RTL_FILE_INCLUDED */
+
+
+/*
+ * This file has not been truncated
+ */
@@ -37,6 +37,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iterator>
 #include <algorithm>
 #include <iostream>
+#include <cerrno>
 
 
 /****************************************************************************
@@ -106,6 +107,7 @@ using namespace std;
  *
  ****************************************************************************/
 
+float RtlSdr::sample_lut[256];
 
 
 /****************************************************************************
@@ -119,17 +121,27 @@ RtlSdr::RtlSdr(void)
     tuner_type(TUNER_UNKNOWN), center_fq_set(false), center_fq(100000000),
     samp_rate_set(false), gain_mode(-1), gain(GAIN_UNSET), fq_corr_set(false),
     fq_corr(0), test_mode_set(false), test_mode(false),
-    use_digital_agc_set(false), use_digital_agc(false), dist_print_cnt(-1)
+    use_digital_agc_set(false), use_digital_agc(false), dist_print_cnt(-1),
+    capture_file(0)
 {
   for (unsigned i=0; i<MAX_IF_GAIN_STAGES; ++i)
   {
     tuner_if_gain[i] = GAIN_UNSET;
   }
+  for (unsigned i=0; i<256; ++i)
+  {
+    sample_lut[i] = i / 127.5f - 1.0f;
+  }
 } /* RtlSdr::RtlSdr */
 
 
 RtlSdr::~RtlSdr(void)
 {
+  if (capture_file != 0)
+  {
+    fclose(capture_file);
+    capture_file = 0;
+  }
 }
 
 
@@ -139,6 +151,26 @@ void RtlSdr::enableDistPrint(bool enable)
 } /* RtlSdr::enableDistPrint */
 
 
+bool RtlSdr::enableCapture(const std::string &filename)
+{
+  if (capture_file != 0)
+  {
+    fclose(capture_file);
+  }
+  capture_filename = filename;
+  capture_file = fopen(filename.c_str(), "wb");
+  if (capture_file == 0)
+  {
+    cerr << "*** ERROR: Could not open I/Q capture file \"" << filename
+         << "\": " << strerror(errno) << endl;
+    return false;
+  }
+    // Use a large buffer to keep the number of write system calls down
+  setvbuf(capture_file, 0, _IOFBF, 1024 * 1024);
+  return true;
+} /* RtlSdr::enableCapture */
+
+
 void RtlSdr::setCenterFq(uint32_t fq)
 {
   center_fq = fq;
@@ -280,20 +312,33 @@ void RtlSdr::handleIq(const complex<uint8_t> *samples, int samp_count)
 {
   //cout << "RtlSdr::handleIq: samp_count=" << samp_count << endl;
 
-  vector<Sample> iq;
-  iq.reserve(samp_count);
-  for (int idx=0; idx<samp_count; ++idx)
+  if (capture_file != 0)
   {
-    if ((dist_print_cnt == 0) &&
-        ((samples[idx].real() == 255) || (samples[idx].imag() == 255)))
+    if (fwrite(samples, sizeof(*samples), samp_count, capture_file) !=
+        static_cast<size_t>(samp_count))
     {
-      dist_print_cnt = samp_rate;
+      cerr << "*** ERROR: Could not write to I/Q capture file \""
+           << capture_filename << "\": " << strerror(errno)
+           << ". Stopping capture.\n";
+      fclose(capture_file);
+      capture_file = 0;
     }
-    float i = samples[idx].real();
-    i = i / 127.5f - 1.0f;
-    float q = samples[idx].imag();
-    q = q / 127.5f - 1.0f;
-    iq.push_back(complex<float>(i, q));
+  }
+
+    // The sample buffer is reused for each block. All connected channels
+    // get a reference to the same buffer.
+  iq_buf.resize(samp_count);
+  bool clipped = false;
+  for (int idx=0; idx<samp_count; ++idx)
+  {
+    const uint8_t i = samples[idx].real();
+    const uint8_t q = samples[idx].imag();
+    clipped |= (i == 255) || (q == 255);
+    iq_buf[idx] = Sample(sample_lut[i], sample_lut[q]);
+  }
+  if ((dist_print_cnt == 0) && clipped)
+  {
+    dist_print_cnt = samp_rate;
   }
 
   if (dist_print_cnt > 0)
@@ -310,7 +355,7 @@ void RtlSdr::handleIq(const complex<uint8_t> *samples, int samp_count)
     }
   }
 
-  iqReceived(iq);
+  iqReceived(iq_buf);
 } /* RtlSdr::handleIq */
 
 
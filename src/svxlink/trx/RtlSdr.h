@@ -38,6 +38,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <complex>
 #include <string>
 #include <vector>
+#include <cstdio>
 #include <stdint.h>
 
 
@@ -148,6 +149,18 @@ class RtlSdr : public sigc::trackable
      */
     void enableDistPrint(bool enable);
 
+    /**
+     * @brief   Start capturing the raw I/Q samples to a file
+     * @param   filename The name of the file to write the samples to
+     * @returns Returns \em true on success or else \em false
+     *
+     * All samples received from the dongle are written to the given file in
+     * the raw interleaved unsigned 8 bit format used by the rtl_sdr utility.
+     * The file can be replayed using the RtlFile class. An existing file is
+     * overwritten.
+     */
+    bool enableCapture(const std::string &filename);
+
     /**
      * @brief   Set the center frequency of the tuner
      * @param   fq The new center frequency, in Hz, to set
@@ -294,9 +307,10 @@ class RtlSdr : public sigc::trackable
      *
      * Connecting to this signal is the way to get samples from the DVB-T
      * dongle. The format is a vector of complex floats (I/Q) with a range from
-     * -1 to 1.
+     * -1 to 1. The same vector is given to all connected slots and it is
+     * reused for the next block so it is only valid during the call.
      */
-    sigc::signal<void, std::vector<Sample> > iqReceived;
+    sigc::signal<void, const std::vector<Sample>&> iqReceived;
     
     /**
      * @brief   A signal that is emitted when the ready state changes
@@ -416,6 +430,11 @@ class RtlSdr : public sigc::trackable
     bool              use_digital_agc_set;
     bool              use_digital_agc;
     int               dist_print_cnt;
+    std::vector<Sample> iq_buf;
+    FILE              *capture_file;
+    std::string       capture_filename;
+
+    static float      sample_lut[256];
 
     RtlSdr(const RtlSdr&);
     RtlSdr& operator=(const RtlSdr&);
@@ -45,6 +45,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncTimer.h>
 #include <AsyncConfig.h>
+#include <AsyncMetrics.h>
 
 
 /****************************************************************************
@@ -218,6 +219,9 @@ Rx::Rx(Config &cfg, const string& name)
   : m_name(name), m_verbose(true), m_sql_open(false), m_cfg(cfg),
     m_sql_tmo_timer(0)
 {
+  m_sql_open_cnt = Metrics::instance().counter(
+      "svxlink_rx_squelch_open_total", "Number of squelch openings",
+      Metric::Labels{{"rx", name}});
 } /* Rx::Rx */
 
 
@@ -332,6 +336,10 @@ void Rx::setSquelchState(bool is_open, const std::string& info)
   }
   m_sql_open = is_open;
   m_sql_info = info;
+  if (is_open)
+  {
+    m_sql_open_cnt->inc();
+  }
   squelchOpen(is_open);
 
   if (m_sql_tmo_timer != 0)
@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <sys/time.h>
 #include <stdint.h>
 #include <sigc++/sigc++.h>
 
@@ -72,6 +73,8 @@ namespace Async
 {
   class Timer;
   class Config;
+  class MetricCounter;
+  class CppEventLoopThread;
 };
 
 
@@ -242,6 +245,31 @@ class Rx : public sigc::trackable, public Async::AudioSource
      */
     virtual void setModulation(Modulation::Type mod) {}
 
+    /**
+     * @brief   Set the thread to decode received audio in
+     * @param   thread The thread to use, which must have been started
+     *
+     * Receivers that get their audio in encoded form, like a NetRx, decode it
+     * in the given thread instead of in the thread that the receiver run in.
+     * This must be called before any audio is received and the thread must
+     * not be stopped until the receiver has been deleted. Other receivers
+     * ignore this call.
+     */
+    virtual void setDecoderThread(Async::CppEventLoopThread *thread) {}
+
+    /**
+     * @brief   Defer decoding of received audio
+     * @param   defer       Set to \em true to keep received audio encoded
+     * @param   backlog_ms  The length of encoded audio to keep
+     *
+     * A receiver that get its audio in encoded form keep the audio packets
+     * received during the last backlog_ms milliseconds, without decoding them,
+     * while decoding is deferred. When decoding is no longer deferred, the
+     * kept packets are decoded and written at once. Older packets are thrown
+     * away. Other receivers ignore this call.
+     */
+    virtual void setDecodingDeferred(bool defer, unsigned backlog_ms) {}
+
     /**
      * @brief 	A signal that indicates if the squelch is open or not
      * @param 	is_open \em True if the squelch is open or \em false if not
@@ -275,6 +303,17 @@ class Rx : public sigc::trackable, public Async::AudioSource
      */
     sigc::signal<void, float> signalLevelUpdated;
 
+    /**
+     * @brief   A signal that is emitted before audio with a known capture time
+     * @param   tv The time when the audio that follow was captured
+     *
+     * Receivers that know when their audio was captured, e.g. remote
+     * receivers using a timestamping protocol, emit this signal right before
+     * writing the audio. It is used by the voter to align the audio streams
+     * from different receivers when switching between them.
+     */
+    sigc::signal<void, const struct timeval&> audioCaptureTime;
+
     /**
      * @brief   A signal that is emitted when digital data have been received
      * @param   frame The data frame that was received
@@ -321,6 +360,7 @@ class Rx : public sigc::trackable, public Async::AudioSource
     Async::Config&  m_cfg;
     Async::Timer*   m_sql_tmo_timer;
     std::string     m_sql_info;
+    Async::MetricCounter* m_sql_open_cnt;
     
     void sqlTimeout(Async::Timer *t);
     
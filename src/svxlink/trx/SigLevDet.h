@@ -194,7 +194,7 @@ class SigLevDet : public sigc::trackable, public Async::AudioSink
      * data frame. If the message type is recognized it will be processed buf
      * if it's not recognized nothing will happen.
      */
-    virtual void frameReceived(std::vector<uint8_t> frame) {}
+    virtual void frameReceived(const std::vector<uint8_t> &frame) {}
 
     /**
      * @brief	A signal that is emitted when the signal strength is updated
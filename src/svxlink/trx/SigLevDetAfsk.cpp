@@ -187,7 +187,7 @@ void SigLevDetAfsk::flushSamples(void)
 } /* SigLevDetAfsk::flushSamples */
 
 
-void SigLevDetAfsk::frameReceived(vector<uint8_t> frame)
+void SigLevDetAfsk::frameReceived(const vector<uint8_t> &frame)
 {
   uint8_t cmd = frame[0];
   if (cmd != Tx::DATA_CMD_SIGLEV)
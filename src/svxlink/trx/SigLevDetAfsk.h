@@ -174,7 +174,7 @@ class SigLevDetAfsk : public SigLevDet
 
     virtual int writeSamples(const float *samples, int len);
     virtual void flushSamples(void);
-    virtual void frameReceived(std::vector<uint8_t> frame);
+    virtual void frameReceived(const std::vector<uint8_t> &frame);
 
   protected:
 
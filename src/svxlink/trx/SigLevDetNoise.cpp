@@ -34,7 +34,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <cmath>
 #include <limits>
-//#include <iostream>
+#include <iostream>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -46,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioFilter.h>
 #include <AsyncSigCAudioSink.h>
 #include <AsyncConfig.h>
+#include <AsyncAudioKernels.h>
 
 
 /****************************************************************************
@@ -75,6 +77,14 @@ using namespace Async;
  *
  ****************************************************************************/
 
+  // The output rate of the decimated noise band estimate. The sample rate
+  // and the noise band center frequency must be multiples of this rate.
+#define DEC_OUTPUT_RATE   250
+
+  // The width of the noise band, used to scale the decimated estimate so that
+  // it approximately match the estimate from the bandpass filter
+#define NOISE_BW          500
+
 
 
 /****************************************************************************
@@ -117,10 +127,13 @@ using namespace Async;
  ****************************************************************************/
 
 SigLevDetNoise::SigLevDetNoise(void)
-  : sample_rate(0), block_len(0), filter(0), sigc_sink(0),
-    slope(10.0), offset(0.0), update_interval(0), update_counter(0),
-    integration_time(0), ss(0.0), ss_cnt(0),
-    bogus_thresh(numeric_limits<float>::max())
+  : sample_rate(0), block_time(DEFAULT_BLOCK_TIME), block_len(0), filter(0),
+    sigc_sink(0), slope(10.0), offset(0.0), update_interval(0),
+    update_counter(0), integration_time(0), ss_block_cnt(0), last_ss(0.0),
+    ss(0.0), ss_cnt(0), bogus_thresh(numeric_limits<float>::max()),
+    decimated(false), dec_len(0), dec_pos(0), dec_acc_re(0.0f),
+    dec_acc_im(0.0f), dec_next_acc_re(0.0f), dec_next_acc_im(0.0f),
+    dec_scale(1.0)
 {
 } /* SigLevDetNoise::SigLevDetNoise */
 
@@ -137,22 +150,51 @@ bool SigLevDetNoise::initialize(Config &cfg, const string& name,
                                 int sample_rate)
 {
   this->sample_rate = sample_rate;
-  block_len = BLOCK_TIME * sample_rate / 1000;
-  if (sample_rate >= 16000)
+
+  cfg.getValue(name, "SIGLEV_BLOCK_TIME", block_time);
+  if ((block_time < 10) || (block_time > 1000))
   {
-    filter = new AudioFilter("BpBu4/5000-5500", sample_rate);
+    cerr << "*** ERROR: Config variable " << name
+         << "/SIGLEV_BLOCK_TIME out of range (" << block_time
+         << "). Valid range is 10 to 1000\n";
+    return false;
   }
-  else
+  block_len = block_time * sample_rate / 1000;
+
+  cfg.getValue(name, "SIGLEV_NOISE_DECIMATED", decimated);
+  if (decimated && (sample_rate % DEC_OUTPUT_RATE != 0))
   {
-    filter = new AudioFilter("HpBu4/3500", sample_rate);
+    cerr << "*** ERROR: The decimated noise signal level detector is not "
+            "supported for sample rate " << sample_rate
+         << " in receiver " << name << "\n";
+    return false;
   }
-  setHandler(filter);
+
   sigc_sink = new SigCAudioSink;
   sigc_sink->sigWriteSamples.connect(
       mem_fun(*this, &SigLevDetNoise::processSamples));
   sigc_sink->sigFlushSamples.connect(
       mem_fun(*sigc_sink, &SigCAudioSink::allSamplesFlushed));
-  sigc_sink->registerSource(filter);
+  if (decimated)
+  {
+      // Blocks must end on an output sample of the decimated estimate
+    setupDecimator();
+    block_len = max(1U, (block_len + dec_len / 2) / dec_len) * dec_len;
+    setHandler(sigc_sink);
+  }
+  else
+  {
+    if (sample_rate >= 16000)
+    {
+      filter = new AudioFilter("BpBu4/5000-5500", sample_rate);
+    }
+    else
+    {
+      filter = new AudioFilter("HpBu4/3500", sample_rate);
+    }
+    setHandler(filter);
+    sigc_sink->registerSource(filter);
+  }
   setIntegrationTime(0);
 
   cfg.getValue(name, "SIGLEV_OFFSET", offset);
@@ -195,29 +237,24 @@ void SigLevDetNoise::setContinuousUpdateInterval(int interval_ms)
 
 void SigLevDetNoise::setIntegrationTime(int time_ms)
 {
-  if (time_ms < static_cast<int>(BLOCK_TIME))
+  if (time_ms < static_cast<int>(block_time))
   {
-    time_ms = BLOCK_TIME;
+    time_ms = block_time;
   }
   integration_time = time_ms * sample_rate / 1000;
-
-  while (ss_idx.size() > integration_time / block_len)
-  {
-    ss_values.erase(*ss_idx.begin());
-    ss_idx.pop_front();
-  }
+  trimWindow();
 } /* SigLevDetNoise::setIntegrationTime */
 
 
 float SigLevDetNoise::lastSiglev(void) const
 {
-  if (ss_idx.empty())
+  if (ss_block_cnt == 0)
   {
     return 0.0f;
   }
 
     // Calculate the siglev value
-  float siglev = offset - slope * log10(*ss_idx.back());
+  float siglev = offset - slope * log10(last_ss);
 
     // If the siglev value is way above 100 (like 120), it's probably bogus.
     // It's likely that this is caused by a closed squelch on the receiver or
@@ -227,14 +264,14 @@ float SigLevDetNoise::lastSiglev(void) const
     return 0.0f;
   }
 
-  return offset - slope * log10(*ss_idx.back());
+  return siglev;
 
 } /* SigLevDetNoise::lastSiglev */
 
 
 float SigLevDetNoise::siglevIntegrated(void) const
 {
-  if (ss_values.empty())
+  if (ss_min.empty())
   {
     return 0.0f;
   }
@@ -248,7 +285,7 @@ float SigLevDetNoise::siglevIntegrated(void) const
     // calibration but we'll try to have it hard coded for now.
     // If the BLOCK_TIME is changed, the compensation probably will have to
     // be changed too.
-  float siglev = offset - slope * (log10(*ss_values.begin()) + 0.25);
+  float siglev = offset - slope * (log10(ss_min.front().ss) + 0.25);
 
     // If the siglev value is way above 100 (like 120), it's probably bogus.
     // It's likely that this is caused by a closed squelch on the receiver or
@@ -265,12 +302,19 @@ float SigLevDetNoise::siglevIntegrated(void) const
 
 void SigLevDetNoise::reset(void)
 {
-  filter->reset();
+  if (filter != 0)
+  {
+    filter->reset();
+  }
   update_counter = 0;
-  ss_values.clear();
-  ss_idx.clear();
+  ss_min.clear();
+  ss_block_cnt = 0;
+  last_ss = 0.0;
   ss_cnt = 0;
   ss = 0.0;
+  dec_pos = 0;
+  dec_acc_re = dec_acc_im = 0.0f;
+  dec_next_acc_re = dec_next_acc_im = 0.0f;
 } /* SigLevDetNoise::reset */
 
 
@@ -289,24 +333,53 @@ void SigLevDetNoise::reset(void)
  *
  ****************************************************************************/
 
+void SigLevDetNoise::setupDecimator(void)
+{
+    // Each input sample contribute to two output samples of the decimated
+    // estimate, using a rising and a falling weight. Together this form a
+    // triangular window that is two output periods long. The mixing
+    // frequency is a multiple of the output rate so the mixing phase
+    // repeat every output period and can be included in the tables.
+  const double fq = (sample_rate >= 16000) ? 5250.0 : 3750.0;
+  dec_len = sample_rate / DEC_OUTPUT_RATE;
+  dec_cur_re.resize(dec_len);
+  dec_cur_im.resize(dec_len);
+  dec_next_re.resize(dec_len);
+  dec_next_im.resize(dec_len);
+  double weight_sum = 0.0;
+  for (unsigned i=0; i<dec_len; ++i)
+  {
+    const double w = 2.0 * M_PI * fq * i / sample_rate;
+    const double cur_weight = i + 1;
+    const double next_weight = dec_len - 1 - i;
+    dec_cur_re[i] = cur_weight * cos(w);
+    dec_cur_im[i] = -cur_weight * sin(w);
+    dec_next_re[i] = next_weight * cos(w);
+    dec_next_im[i] = -next_weight * sin(w);
+    weight_sum += cur_weight * cur_weight + next_weight * next_weight;
+  }
+  dec_scale = dec_len * 2.0 * NOISE_BW / sample_rate / weight_sum;
+} /* SigLevDetNoise::setupDecimator */
+
+
 int SigLevDetNoise::processSamples(float *samples, int count)
 {
-  for (int i=0; i<count; ++i)
+  if (decimated)
   {
-    const float &sample = samples[i];
-    ss += static_cast<double>(sample) * sample;
-    if (++ss_cnt >= block_len)
+    processDecimated(samples, count);
+  }
+  else
+  {
+    for (int i=0; i<count; ++i)
     {
-      SsSetIter it = ss_values.insert(ss);
-      ss_idx.push_back(it);
-      if (ss_idx.size() > integration_time / block_len)
+      const float &sample = samples[i];
+      ss += static_cast<double>(sample) * sample;
+      if (++ss_cnt >= block_len)
       {
-        ss_values.erase(*ss_idx.begin());
-        ss_idx.pop_front();
+        addBlock(ss);
+        ss = 0.0;
+        ss_cnt = 0;
       }
-
-      ss = 0.0;
-      ss_cnt = 0;
     }
   }
 
@@ -325,6 +398,74 @@ int SigLevDetNoise::processSamples(float *samples, int count)
 } /* SigLevDetNoise::processSamples */
 
 
+void SigLevDetNoise::processDecimated(const float *samples, int count)
+{
+  while (count > 0)
+  {
+    const int len = min(count, static_cast<int>(dec_len - dec_pos));
+    dec_acc_re += audioKernelDotProduct(samples, &dec_cur_re[dec_pos], len);
+    dec_acc_im += audioKernelDotProduct(samples, &dec_cur_im[dec_pos], len);
+    dec_next_acc_re +=
+      audioKernelDotProduct(samples, &dec_next_re[dec_pos], len);
+    dec_next_acc_im +=
+      audioKernelDotProduct(samples, &dec_next_im[dec_pos], len);
+    samples += len;
+    count -= len;
+    dec_pos += len;
+
+    if (dec_pos == dec_len)
+    {
+      ss += dec_scale * (static_cast<double>(dec_acc_re) * dec_acc_re +
+                         static_cast<double>(dec_acc_im) * dec_acc_im);
+      dec_acc_re = dec_next_acc_re;
+      dec_acc_im = dec_next_acc_im;
+      dec_next_acc_re = dec_next_acc_im = 0.0f;
+      dec_pos = 0;
+
+      ss_cnt += dec_len;
+      if (ss_cnt >= block_len)
+      {
+        addBlock(ss);
+        ss = 0.0;
+        ss_cnt = 0;
+      }
+    }
+  }
+} /* SigLevDetNoise::processDecimated */
+
+
+void SigLevDetNoise::addBlock(double block_ss)
+{
+    // Keep the window sorted in ascending order so that the minimum value is
+    // always at the front. Older values that are larger than the new value
+    // can never be the minimum again.
+  last_ss = block_ss;
+  while (!ss_min.empty() && (ss_min.back().ss >= block_ss))
+  {
+    ss_min.pop_back();
+  }
+  SsEntry entry = { ss_block_cnt++, block_ss };
+  ss_min.push_back(entry);
+  trimWindow();
+} /* SigLevDetNoise::addBlock */
+
+
+void SigLevDetNoise::trimWindow(void)
+{
+  const unsigned window_size = windowSize();
+  while (!ss_min.empty() && (ss_min.front().idx + window_size < ss_block_cnt))
+  {
+    ss_min.pop_front();
+  }
+} /* SigLevDetNoise::trimWindow */
+
+
+unsigned SigLevDetNoise::windowSize(void) const
+{
+  return max(1U, integration_time / block_len);
+} /* SigLevDetNoise::windowSize */
+
+
 
 /*
  * This file has not been truncated
@@ -34,8 +34,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
-#include <list>
-#include <set>
+#include <deque>
+#include <vector>
 #include <sigc++/sigc++.h>
 
 
@@ -114,6 +114,15 @@ namespace Async
 @brief	A simple noise measuring signal level detector
 @author Tobias Blomberg / SM0SVX
 @date   2006-05-07
+
+The detector measure the noise energy in a frequency band above the voice
+band. By default the noise band is isolated using a bandpass filter run at
+the full sample rate. When SIGLEV_NOISE_DECIMATED is set, a cheaper estimate
+is used instead. The noise band is mixed down to DC and integrated over
+short intervals using a triangular window, giving a decimated complex noise
+band signal. The energy of that signal is then used as the noise estimate.
+The minimum over the integration time is tracked incrementally using a
+sliding window.
 */
 class SigLevDetNoise : public SigLevDet
 {
@@ -208,13 +217,17 @@ class SigLevDetNoise : public SigLevDet
   protected:
     
   private:
-    typedef std::multiset<double> SsSet;
-    typedef SsSet::const_iterator SsSetIter;
-    typedef std::list<SsSetIter>  SsIndexList;
+    struct SsEntry
+    {
+      unsigned long idx;
+      double        ss;
+    };
+    typedef std::deque<SsEntry> SsWindow;
 
-    static const unsigned BLOCK_TIME          = 25;     // milliseconds
+    static const unsigned DEFAULT_BLOCK_TIME  = 25;     // milliseconds
 
     unsigned                  sample_rate;
+    unsigned                  block_time;
     unsigned                  block_len;
     Async::AudioFilter	      *filter;
     Async::SigCAudioSink      *sigc_sink;
@@ -223,15 +236,33 @@ class SigLevDetNoise : public SigLevDet
     int			      update_interval;
     int			      update_counter;
     unsigned		      integration_time;
-    SsSet                     ss_values;
-    SsIndexList               ss_idx;
+    SsWindow                  ss_min;
+    unsigned long             ss_block_cnt;
+    double                    last_ss;
     double                    ss;
     unsigned                  ss_cnt;
     float                     bogus_thresh;
-    
+    bool                      decimated;
+    unsigned                  dec_len;
+    unsigned                  dec_pos;
+    std::vector<float>        dec_cur_re;
+    std::vector<float>        dec_cur_im;
+    std::vector<float>        dec_next_re;
+    std::vector<float>        dec_next_im;
+    float                     dec_acc_re;
+    float                     dec_acc_im;
+    float                     dec_next_acc_re;
+    float                     dec_next_acc_im;
+    double                    dec_scale;
+
     SigLevDetNoise(const SigLevDetNoise&);
     SigLevDetNoise& operator=(const SigLevDetNoise&);
+    void setupDecimator(void);
     int processSamples(float *samples, int count);
+    void processDecimated(const float *samples, int count);
+    void addBlock(double block_ss);
+    void trimWindow(void);
+    unsigned windowSize(void) const;
     
 };  /* class SigLevDetNoise */
 
@@ -87,10 +87,10 @@ class SquelchCombine::Node
     virtual void reset(void) = 0;
     virtual void restart(void) = 0;
     virtual void processSamples(const float *samples, int count) = 0;
-    virtual bool isOpen(void) const = 0;
+    virtual bool evaluate(LeafMask leaf_state) const = 0;
+    virtual void collectLeaves(std::vector<LeafNode*>& leaves) = 0;
     virtual std::string activityInfo(void) const = 0;
     virtual SquelchStates& squelchStates(SquelchStates& states) = 0;
-    sigc::signal<void, bool> squelchOpen;
 
   private:
     std::string m_name;
@@ -100,6 +100,8 @@ class SquelchCombine::Node
 class SquelchCombine::LeafNode : public SquelchCombine::Node
 {
   public:
+    sigc::signal<void, bool> squelchOpen;
+
     LeafNode(const std::string n) : Node(n) {}
 
     virtual ~LeafNode(void)
@@ -129,7 +131,18 @@ class SquelchCombine::LeafNode : public SquelchCombine::Node
       return true;
     }
 
-    virtual bool isOpen(void) const { return m_squelch->isOpen(); }
+    bool isOpen(void) const { return m_squelch->isOpen(); }
+
+    virtual bool evaluate(LeafMask leaf_state) const
+    {
+      return ((leaf_state >> m_index) & 1) != 0;
+    }
+
+    virtual void collectLeaves(std::vector<LeafNode*>& leaves)
+    {
+      m_index = leaves.size();
+      leaves.push_back(this);
+    }
 
     virtual std::string activityInfo(void) const
     {
@@ -176,7 +189,8 @@ class SquelchCombine::LeafNode : public SquelchCombine::Node
     }
 
   private:
-    Squelch* m_squelch = nullptr;
+    Squelch*  m_squelch = nullptr;
+    size_t    m_index   = 0;
 }; /* SquelchCombine::LeafNode */
 
 
@@ -186,7 +200,6 @@ class SquelchCombine::UnaryOpNode : public SquelchCombine::Node
     UnaryOpNode(const std::string& name, Node *node)
       : Node(name), m_node(node)
     {
-      m_node->squelchOpen.connect(squelchOpen.make_slot());
     }
 
     virtual ~UnaryOpNode(void)
@@ -222,6 +235,11 @@ class SquelchCombine::UnaryOpNode : public SquelchCombine::Node
       m_node->processSamples(samples, count);
     }
 
+    virtual void collectLeaves(std::vector<LeafNode*>& leaves)
+    {
+      m_node->collectLeaves(leaves);
+    }
+
     virtual SquelchStates& squelchStates(SquelchStates& states)
     {
       return m_node->squelchStates(states);
@@ -240,7 +258,10 @@ class SquelchCombine::UnaryOpNode : public SquelchCombine::Node
 struct SquelchCombine::NegationOpNode : public SquelchCombine::UnaryOpNode
 {
   NegationOpNode(Node* node) : UnaryOpNode("NOT", node) {}
-  virtual bool isOpen(void) const { return !m_node->isOpen(); }
+  virtual bool evaluate(LeafMask leaf_state) const
+  {
+    return !m_node->evaluate(leaf_state);
+  }
 }; /* SquelchCombine::NegationOpNode */
 
 
@@ -250,10 +271,6 @@ class SquelchCombine::BinaryOpNode : public SquelchCombine::Node
     BinaryOpNode(const std::string& n, Node* l, Node* r)
       : Node(n), m_left(l), m_right(r)
     {
-      m_left->squelchOpen.connect(
-          sigc::mem_fun(*this, &BinaryOpNode::onSquelchOpen));
-      m_right->squelchOpen.connect(
-          sigc::mem_fun(*this, &BinaryOpNode::onSquelchOpen));
     }
 
     virtual ~BinaryOpNode(void)
@@ -296,9 +313,10 @@ class SquelchCombine::BinaryOpNode : public SquelchCombine::Node
       m_right->processSamples(samples, count);
     }
 
-    void onSquelchOpen(bool is_open)
+    virtual void collectLeaves(std::vector<LeafNode*>& leaves)
     {
-      squelchOpen(isOpen());
+      m_left->collectLeaves(leaves);
+      m_right->collectLeaves(leaves);
     }
 
     virtual SquelchStates& squelchStates(SquelchStates& states)
@@ -324,9 +342,9 @@ struct SquelchCombine::OrOpNode : public SquelchCombine::BinaryOpNode
 {
   OrOpNode(Node* l, Node* r) : BinaryOpNode("OR", l, r) {}
 
-  virtual bool isOpen(void) const
+  virtual bool evaluate(LeafMask leaf_state) const
   {
-    return m_left->isOpen() || m_right->isOpen();
+    return m_left->evaluate(leaf_state) || m_right->evaluate(leaf_state);
   }
 }; /* SquelchCombine::OrOpNode */
 
@@ -335,9 +353,9 @@ struct SquelchCombine::AndOpNode : public SquelchCombine::BinaryOpNode
 {
   AndOpNode(Node* l, Node* r) : BinaryOpNode("AND", l, r) {}
 
-  virtual bool isOpen(void) const
+  virtual bool evaluate(LeafMask leaf_state) const
   {
-    return m_left->isOpen() && m_right->isOpen();
+    return m_left->evaluate(leaf_state) && m_right->evaluate(leaf_state);
   }
 }; /* SquelchCombine::AndOpNode */
 
@@ -422,16 +440,26 @@ bool SquelchCombine::initialize(Async::Config& cfg,
   m_comb->print(std::cout);
   std::cout << std::endl;
 
-  m_comb->squelchOpen.connect(
-      sigc::mem_fun(*this, &SquelchCombine::onSquelchOpen));
+  if (!compile() || !m_comb->initialize(cfg))
+  {
+    return false;
+  }
 
-  return m_comb->initialize(cfg) && Squelch::initialize(cfg, rx_name);
+  for (size_t i=0; i<m_leaves.size(); ++i)
+  {
+    m_leaves[i]->squelchOpen.connect(sigc::bind(
+        sigc::mem_fun(*this, &SquelchCombine::onLeafSquelchOpen), i));
+  }
+  syncLeafState();
+
+  return Squelch::initialize(cfg, rx_name);
 } /* SquelchCombine::initialize */
 
 
 void SquelchCombine::reset(void)
 {
   m_comb->reset();
+  syncLeafState();
   Squelch::reset();
 } /* SquelchCombine::reset */
 
@@ -462,9 +490,62 @@ int SquelchCombine::processSamples(const float *samples, int count)
  *
  ****************************************************************************/
 
-void SquelchCombine::onSquelchOpen(bool is_open)
+bool SquelchCombine::compile(void)
 {
-  if (is_open != signalDetected())
+  m_comb->collectLeaves(m_leaves);
+  if (m_leaves.size() > 8 * sizeof(LeafMask))
+  {
+    std::cout << "*** ERROR: Too many squelch detectors in squelch combiner "
+                 "expression. The maximum is " << 8 * sizeof(LeafMask)
+              << "." << std::endl;
+    return false;
+  }
+
+    // Evaluate the expression once for every possible combination of
+    // open squelch detectors so that an update is just a table lookup
+  if (m_leaves.size() <= MAX_TABLE_LEAVES)
+  {
+    const LeafMask combinations = LeafMask(1) << m_leaves.size();
+    m_truth_table.resize(combinations);
+    for (LeafMask leaf_state=0; leaf_state<combinations; ++leaf_state)
+    {
+      m_truth_table[leaf_state] = m_comb->evaluate(leaf_state);
+    }
+  }
+
+  return true;
+} /* SquelchCombine::compile */
+
+
+void SquelchCombine::syncLeafState(void)
+{
+  m_leaf_state = 0;
+  for (size_t i=0; i<m_leaves.size(); ++i)
+  {
+    if (m_leaves[i]->isOpen())
+    {
+      m_leaf_state |= LeafMask(1) << i;
+    }
+  }
+} /* SquelchCombine::syncLeafState */
+
+
+void SquelchCombine::onLeafSquelchOpen(bool is_open, size_t leaf_idx)
+{
+  const LeafMask leaf_bit = LeafMask(1) << leaf_idx;
+  if (is_open)
+  {
+    m_leaf_state |= leaf_bit;
+  }
+  else
+  {
+    m_leaf_state &= ~leaf_bit;
+  }
+
+  const bool comb_open = m_truth_table.empty()
+                       ? m_comb->evaluate(m_leaf_state)
+                       : m_truth_table[m_leaf_state];
+  if (comb_open != signalDetected())
   {
     std::string info;
     info.reserve(127);
@@ -477,10 +558,10 @@ void SquelchCombine::onSquelchOpen(bool is_open)
       }
       info += state;
     }
-    setSignalDetected(is_open, info);
-    //setSignalDetected(is_open, m_comb->activityInfo());
+    setSignalDetected(comb_open, info);
+    //setSignalDetected(comb_open, m_comb->activityInfo());
   }
-} /* SquelchCombine::onSquelchOpen */
+} /* SquelchCombine::onLeafSquelchOpen */
 
 
 bool SquelchCombine::tokenize(const std::string& expr)
@@ -36,6 +36,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <string>
 #include <deque>
+#include <vector>
+#include <cstdint>
 
 
 /****************************************************************************
@@ -135,6 +137,12 @@ SIGLEV_CLOSE_THRESH=2
 SQL_DET=COMBINE
 SQL_COMBINE=Rx1:CTCSS | Rx1:SIGLEV
 ...
+
+The expression is compiled into a truth table when it is parsed, indexed by
+the open state of all squelch detectors in the expression. When one of the
+squelch detectors open or close, the new combined state is found using a
+single table lookup. Expressions with more than 16 squelch detectors are
+evaluated by walking the expression tree instead.
 */
 class SquelchCombine : public Squelch
 {
@@ -199,6 +207,7 @@ class SquelchCombine : public Squelch
 
   private:
     typedef std::deque<std::string> Tokens;
+    typedef std::uint64_t LeafMask;
     class Node;
     class LeafNode;
     class UnaryOpNode;
@@ -207,10 +216,17 @@ class SquelchCombine : public Squelch
     struct OrOpNode;
     struct AndOpNode;
 
-    Tokens  m_tokens;
-    Node*   m_comb    = nullptr;
+    static const size_t MAX_TABLE_LEAVES = 16;
+
+    Tokens                  m_tokens;
+    Node*                   m_comb        = nullptr;
+    std::vector<LeafNode*>  m_leaves;
+    LeafMask                m_leaf_state  = 0;
+    std::vector<bool>       m_truth_table;
 
-    void onSquelchOpen(bool is_open);
+    bool compile(void);
+    void syncLeafState(void);
+    void onLeafSquelchOpen(bool is_open, size_t leaf_idx);
     bool tokenize(const std::string& expr);
     Node* parseInstExpression(void);
     Node* parseUnaryOpExpression(void);
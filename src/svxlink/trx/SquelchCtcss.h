@@ -49,7 +49,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncConfig.h>
 #include <AsyncAudioFilter.h>
-#include <AsyncAudioSplitter.h>
 
 
 /****************************************************************************
@@ -59,6 +58,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "ToneDetector.h"
+#include "ToneDetectorBank.h"
 #include "Squelch.h"
 
 
@@ -129,14 +129,16 @@ class SquelchCtcss : public Squelch
      * @brief 	Default constuctor
      */
     explicit SquelchCtcss(void)
-      : m_splitter(0), m_active_det(0), m_ctcss_snr_offset(0.0f) {}
+      : m_bank(0), m_filter(0), m_active_det(0), m_ctcss_snr_offset(0.0f)
+    {}
 
     /**
      * @brief 	Destructor
      */
     virtual ~SquelchCtcss(void)
     {
-      delete m_splitter;
+      delete m_filter;
+      delete m_bank;
     }
 
     /**
@@ -210,7 +212,7 @@ class SquelchCtcss : public Squelch
 	return false;
       }
 
-      m_splitter = new Async::AudioSplitter;
+      m_bank = new ToneDetectorBank;
 
       for (FqList::const_iterator it = ctcss_fqs.begin();
            it != ctcss_fqs.end(); ++it)
@@ -224,12 +226,8 @@ class SquelchCtcss : public Squelch
         {
           det->snrUpdated.connect(snrUpdated.make_slot());
         }
-        Async::AudioSink *sink = det;
-
         m_dets.push_back(det);
-
-        std::stringstream filter_spec;
-        filter_spec << "BpBu8/" << bpf_low << "-" << bpf_high;
+        m_bank->addDetector(det, true);
 
         switch (ctcss_mode)
         {
@@ -259,12 +257,6 @@ class SquelchCtcss : public Squelch
             det->setUndetectSnrThresh(close_thresh, bpf_high - bpf_low);
             det->setUndetectStableCountThresh(2);
             //det->setUndetectPhaseBwThresh(4.0f, 16.0f);
-
-              // Set up CTCSS band pass filter
-            Async::AudioFilter *filter =
-              new Async::AudioFilter(filter_spec.str());
-            filter->registerSink(det, true);
-            sink = filter;
             break;
           }
 
@@ -285,17 +277,19 @@ class SquelchCtcss : public Squelch
             //det->setUndetectPeakToTotPwrThresh(0.3f);
             det->setUndetectSnrThresh(close_thresh, bpf_high - bpf_low);
             det->setUndetectStableCountThresh(2);
-
-              // Set up CTCSS band pass filter
-            Async::AudioFilter *filter =
-              new Async::AudioFilter(filter_spec.str());
-            filter->registerSink(det, true);
-            sink = filter;
             break;
           }
         }
+      }
 
-        m_splitter->addSink(sink, true);
+        // Set up the CTCSS band pass filter. It is shared by all detectors
+        // since they all get the same input.
+      if (ctcss_mode != 1)
+      {
+        std::stringstream filter_spec;
+        filter_spec << "BpBu8/" << bpf_low << "-" << bpf_high;
+        m_filter = new Async::AudioFilter(filter_spec.str());
+        m_filter->registerSink(m_bank);
       }
 
       bool debug = false;
@@ -357,7 +351,11 @@ class SquelchCtcss : public Squelch
      */
     int processSamples(const float *samples, int count)
     {
-      return m_splitter->writeSamples(samples, count);
+      if (m_filter != 0)
+      {
+        return m_filter->writeSamples(samples, count);
+      }
+      return m_bank->writeSamples(samples, count);
     }
 
     /**
@@ -376,7 +374,8 @@ class SquelchCtcss : public Squelch
     typedef std::vector<ToneDetector*> DetList;
 
     DetList                 m_dets;
-    Async::AudioSplitter *  m_splitter;
+    ToneDetectorBank *      m_bank;
+    Async::AudioFilter *    m_filter;
     ToneDetector *          m_active_det;
     float                   m_ctcss_snr_offset;
 
@@ -0,0 +1,189 @@
+/**
+@file	 SquelchGpiod.cpp
+@brief   A squelch detector using the Linux GPIO character device
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "SquelchGpiod.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The default debounce period in milliseconds
+#define DEFAULT_DEBOUNCE  10
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+SquelchGpiod::SquelchGpiod(void)
+{
+} /* SquelchGpiod::SquelchGpiod */
+
+
+SquelchGpiod::~SquelchGpiod(void)
+{
+} /* SquelchGpiod::~SquelchGpiod */
+
+
+bool SquelchGpiod::initialize(Async::Config& cfg, const std::string& rx_name)
+{
+  if (!Squelch::initialize(cfg, rx_name))
+  {
+    return false;
+  }
+
+  string chip("gpiochip0");
+  cfg.getValue(rx_name, "SQL_GPIOD_CHIP", chip);
+
+  string sql_line;
+  if (!cfg.getValue(rx_name, "SQL_GPIOD_LINE", sql_line) || sql_line.empty())
+  {
+    cerr << "*** ERROR: Config variable " << rx_name <<
+            "/SQL_GPIOD_LINE not set or invalid\n";
+    return false;
+  }
+
+  unsigned debounce = DEFAULT_DEBOUNCE;
+  cfg.getValue(rx_name, "SQL_GPIOD_DEBOUNCE", debounce);
+
+  if (!line.openInput(chip, sql_line, 1000 * debounce, "svxlink-sql"))
+  {
+    cerr << "*** ERROR: Could not set up the squelch GPIO line in "
+         << rx_name << endl;
+    return false;
+  }
+  line.valueChanged.connect(mem_fun(*this, &SquelchGpiod::lineChanged));
+
+  bool is_active = false;
+  if (line.getValue(is_active) && is_active)
+  {
+    setSignalDetected(true);
+  }
+
+  return true;
+} /* SquelchGpiod::initialize */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void SquelchGpiod::lineChanged(bool is_active)
+{
+  setSignalDetected(is_active);
+} /* SquelchGpiod::lineChanged */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,161 @@
+/**
+@file	 SquelchGpiod.h
+@brief   A squelch detector using the Linux GPIO character device
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef SQUELCH_GPIOD_INCLUDED
+#define SQUELCH_GPIOD_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "Squelch.h"
+#include "GpioLine.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A squelch detector using the Linux GPIO character device
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This squelch detector read the squelch indicator signal from a GPIO input
+line using the GPIO character device, /dev/gpiochipN. Unlike the GPIO squelch
+detector, which poll the sysfs interface, the kernel report each change of
+the line so the squelch state is updated immediately and an idle receiver
+does not cause any wakeups. The line can be debounced by the kernel.
+*/
+class SquelchGpiod : public Squelch
+{
+  public:
+      /// The name of this class when used by the object factory
+    static constexpr const char* OBJNAME = "GPIOD";
+
+    /**
+     * @brief 	Default constuctor
+     */
+    SquelchGpiod(void);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~SquelchGpiod(void);
+
+    /**
+     * @brief 	Initialize the squelch detector
+     * @param 	cfg A previsously initialized config object
+     * @param 	rx_name The name of the RX (config section name)
+     * @return	Returns \em true on success or else \em false
+     */
+    bool initialize(Async::Config& cfg, const std::string& rx_name);
+
+  protected:
+
+  private:
+    GpioLine  line;
+
+    SquelchGpiod(const SquelchGpiod&);
+    SquelchGpiod& operator=(const SquelchGpiod&);
+    void lineChanged(bool is_active);
+
+};  /* class SquelchGpiod */
+
+
+//} /* namespace */
+
+#endif /* SQUELCH_GPIOD_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
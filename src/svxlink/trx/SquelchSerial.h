@@ -36,6 +36,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <iostream>
 #include <string>
+#include <cstring>
+#include <cerrno>
 
 
 /****************************************************************************
@@ -111,6 +113,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 This squelch detector read the state of an external hardware squelch through
 a pin in the serial port. The pins that can be used are CTS, DSR, DCD and RI.
+Pin changes are reported by the serial port as they happen so the squelch
+react immediately. If pin change notifications cannot be enabled, the pin is
+polled once for every block of audio instead.
 */
 class SquelchSerial : public Squelch
 {
@@ -122,7 +127,8 @@ class SquelchSerial : public Squelch
      * @brief 	Default constuctor
      */
     SquelchSerial(void)
-      : serial(0), sql_pin(Async::Serial::PIN_NONE), sql_pin_act_lvl(true) {}
+      : serial(0), sql_pin(Async::Serial::PIN_NONE), sql_pin_act_lvl(true),
+        poll_pin(true) {}
 
     /**
      * @brief 	Destructor
@@ -235,6 +241,27 @@ class SquelchSerial : public Squelch
         return false;
       }
 
+      bool low_latency = false;
+      cfg.getValue(rx_name, "SERIAL_LOW_LATENCY", low_latency);
+      if (low_latency && !serial->setLowLatency(true))
+      {
+        std::cerr << "*** WARNING: Could not enable low latency mode for "
+                  << "serial port " << serial_port << " in receiver "
+                  << rx_name << ": " << strerror(errno) << "\n";
+      }
+
+      if (serial->setPinNotify(true))
+      {
+        serial->pinChanged.connect(
+            sigc::mem_fun(*this, &SquelchSerial::pinChanged));
+        poll_pin = false;
+        bool is_set = false;
+        if (serial->getPin(sql_pin, is_set))
+        {
+          setSignalDetected(is_set == sql_pin_act_lvl);
+        }
+      }
+
       return true;
     }
 
@@ -247,6 +274,10 @@ class SquelchSerial : public Squelch
      */
     int processSamples(const float *samples, int count)
     {
+      if (!poll_pin)
+      {
+        return count;
+      }
       bool is_set = false;
       if (!serial->getPin(sql_pin, is_set))
       {
@@ -261,10 +292,19 @@ class SquelchSerial : public Squelch
     Async::Serial     	    *serial;
     Async::Serial::Pin      sql_pin;
     bool      	      	    sql_pin_act_lvl;
+    bool                    poll_pin;
 
     SquelchSerial(const SquelchSerial&);
     SquelchSerial& operator=(const SquelchSerial&);
 
+    void pinChanged(Async::Serial::Pin pin, bool is_set)
+    {
+      if (pin == sql_pin)
+      {
+        setSignalDetected(is_set == sql_pin_act_lvl);
+      }
+    }
+
     bool setPins(const Async::Config &cfg, const std::string &rx_name)
     {
       std::string pins;
@@ -43,6 +43,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncSigCAudioSink.h>
+#include <AsyncAudioKernels.h>
 
 
 /****************************************************************************
@@ -148,6 +149,17 @@ SvxSwDtmfDecoder::SvxSwDtmfDecoder(Config &cfg, const string &name)
     col[i+4].initialize(3.0f * col_fqs[i]); // Third overtone
   }
 
+    // The fundamental tones are calculated for every block so they are put
+    // in a bank, four row detectors followed by four column detectors
+  for (size_t i=0; i<4; ++i)
+  {
+    tone_bank.addBin(row_fqs[i], INTERNAL_SAMPLE_RATE);
+  }
+  for (size_t i=0; i<4; ++i)
+  {
+    tone_bank.addBin(col_fqs[i], INTERNAL_SAMPLE_RATE);
+  }
+
     // Initialize window function
   for (size_t n=0; n<BLOCK_SIZE; ++n)
   {
@@ -243,32 +255,12 @@ int SvxSwDtmfDecoder::writeSamples(const float *buf, int len)
 
 void SvxSwDtmfDecoder::processBlock(void)
 {
-    // Reset all Goertzel objects
-  row[0].reset();
-  row[1].reset();
-  row[2].reset();
-  row[3].reset();
-  col[0].reset();
-  col[1].reset();
-  col[2].reset();
-  col[3].reset();
-
     // Calculate the total block energy and energy for all individual
     // Goertzel detectors over the block
-  double block_energy = 0.0;
-  for (size_t i=0; i<BLOCK_SIZE; ++i)
-  {
-    float sample = block[i] * win[i];
-    block_energy += static_cast<double>(sample) * sample;
-    row[0].calc(sample);
-    row[1].calc(sample);
-    row[2].calc(sample);
-    row[3].calc(sample);
-    col[0].calc(sample);
-    col[1].calc(sample);
-    col[2].calc(sample);
-    col[3].calc(sample);
-  }
+  Async::audioKernelMultiply(win_block, block, win, BLOCK_SIZE);
+  tone_bank.reset();
+  tone_bank.calc(win_block, BLOCK_SIZE);
+  const float block_energy = tone_bank.passbandEnergy();
   ios_base::fmtflags orig_cout_flags(cout.flags());
   if (debug)
   {
@@ -301,7 +293,7 @@ void SvxSwDtmfDecoder::processBlock(void)
     float col_sum = 0.0f;
     for (size_t i = 0; i < 4; ++i)
     {
-      const float row_ms = WIN_ENB * row[i].magnitudeSquared();
+      const float row_ms = WIN_ENB * tone_bank.magnitudeSquared(i);
       if (row_ms > max_row_ms)
       {
         max_row_ms = row_ms;
@@ -309,7 +301,7 @@ void SvxSwDtmfDecoder::processBlock(void)
       }
       row_sum += row_ms;
 
-      const float col_ms = WIN_ENB * col[i].magnitudeSquared();
+      const float col_ms = WIN_ENB * tone_bank.magnitudeSquared(i + 4);
       if (col_ms > max_col_ms)
       {
         max_col_ms = col_ms;
@@ -389,7 +381,7 @@ void SvxSwDtmfDecoder::processBlock(void)
     col[max_col_idx+4].reset();
     for (size_t i=0; i<BLOCK_SIZE; ++i)
     {
-      float sample = block[i] * win[i];
+      float sample = win_block[i];
       im.calc(sample);
       row[max_row_idx+4].calc(sample);
       col[max_col_idx+4].calc(sample);
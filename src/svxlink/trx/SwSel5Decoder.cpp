@@ -7,7 +7,7 @@
 
 \verbatim
 SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
-Copyright (C) 2004-2010  Tobias Blomberg / SM0SVX
+Copyright (C) 2004-2026  Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -47,7 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
-
+#include <common.h>
 
 /****************************************************************************
  *
@@ -67,6 +67,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 using namespace std;
 using namespace Async;
+using namespace SvxLink;
 
 
 
@@ -80,13 +81,15 @@ using namespace Async;
 #define SEL5_RELATIVE_PEAK          20.0f  /* 13dB */
 
 // The Goertzel algorithm is just a recursive way to evaluate the DFT at a
-// single frequency. For maximum detection reliability, the bandwidth will
-// be adapted to place the tone frequency near the center of the DFT.
-// As a side effect, the detection bandwidth is slightly narrowed, which
-// however is acceptable for the SEL5 decoder. Furthermore, a time slack
-// between the tone detectors is unavoidable, since they use different
-// block lengths.
+// single frequency. All tone detectors use the same block length, giving a
+// detection bandwidth of about SEL5_BANDWIDTH, so that they can be run over
+// the same windowed block of samples in a Goertzel bank. The exact tone
+// frequency is used for each detector so no adjustment of the block length
+// is needed. The blocks overlap by half a block to not miss the start of
+// a tone.
 #define SEL5_BANDWIDTH              35     /* 35Hz */
+#define SEL5_GOERTZEL_LENGTH        (INTERNAL_SAMPLE_RATE / SEL5_BANDWIDTH)
+#define SEL5_GOERTZEL_STEP          (SEL5_GOERTZEL_LENGTH / 2)
 #define SEL5_BLOCK_LENGTH           (INTERNAL_SAMPLE_RATE / 1000)
 
 
@@ -120,6 +123,86 @@ using namespace Async;
  *
  ****************************************************************************/
 
+namespace {
+  struct Sel5Type
+  {
+    const char *name;
+    const char *digits;
+    float       tones[16];
+  };
+
+  /*  the tones for each mode
+   *                   0        1         2        3        4        5
+   *                   6        7         8        9        A        B
+   *                   C        D         E        F
+  */
+  const Sel5Type sel5_types[] =
+  {
+    { "ZVEI1", "0123456789ABCDEF",
+      { 2400.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f, 1530.0f,
+        1670.0f, 1830.0f, 2000.0f, 2200.0f, 2800.0f,  810.0f,
+         970.0f,  885.0f, 2600.0f,  680.0f } },
+    { "ZVEI2", "0123456789ABCDEF",
+      { 2400.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f, 1530.0f,
+        1670.0f, 1830.0f, 2000.0f, 2200.0f,  885.0f,  810.0f,
+         740.0f,  680.0f,  970.0f, 2600.0f } },
+    { "ZVEI3", "0123456789ABCDEF",
+      { 2200.0f,  970.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f,
+        1530.0f, 1670.0f, 1830.0f, 2000.0f,  885.0f,  810.0f,
+         740.0f,  680.0f, 2400.0f, 2600.0f } },
+    { "PZVEI", "0123456789ABCDEF",
+      { 2400.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f, 1530.0f,
+        1670.0f, 1830.0f, 2000.0f, 2200.0f,  970.0f,  810.0f,
+        2800.0f,  885.0f, 2600.0f,  680.0f } },
+    { "DZVEI", "0123456789ABCDEF",
+      { 2200.0f,  970.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f,
+        1530.0f, 1670.0f, 1830.0f, 2000.0f,  825.0f,  740.0f,
+        2600.0f,  885.0f, 2400.0f,  680.0f } },
+    { "PDZVEI", "0123456789ABCDE",
+      { 2200.0f,  970.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f,
+        1530.0f, 1670.0f, 1830.0f, 2000.0f,  825.0f,  886.0f,
+        2600.0f,  856.0f, 2400.0f } },
+    { "EEA", "0123456789ABCDEF",
+      { 1981.0f, 1124.0f, 1197.0f, 1275.0f, 1358.0f, 1446.0f,
+        1540.0f, 1640.0f, 1747.0f, 1860.0f, 1055.0f,  930.0f,
+        2400.0f,  991.0f, 2110.0f, 2047.0f } },
+    { "EIA", "0123456789ABCDEF",
+      {  600.0f,  741.0f,  882.0f, 1023.0f, 1164.0f, 1305.0f,
+        1446.0f, 1587.0f, 1728.0f, 1869.0f, 2151.0f, 2433.0f,
+        2010.0f, 2292.0f,  459.0f, 1091.0f } },
+    { "VDEW", "0123456789ABCDE",
+      { 2280.0f,  370.0f,  450.0f,  550.0f,  675.0f,  825.0f,
+        1010.0f, 1240.0f, 1520.0f, 1860.0f, 2000.0f, 2100.0f,
+        2200.0f, 2300.0f, 2400.0f } },
+    { "CCIR", "0123456789ABCDEF",
+      { 1981.0f, 1124.0f, 1197.0f, 1275.0f, 1358.0f, 1446.0f,
+        1540.0f, 1640.0f, 1747.0f, 1860.0f, 2400.0f,  930.0f,
+        2247.0f,  991.0f, 2110.0f, 1055.0f } },
+    { "PCCIR", "0123456789ABCDE",
+      { 1981.0f, 1124.0f, 1197.0f, 1275.0f, 1358.0f, 1446.0f,
+        1540.0f, 1640.0f, 1747.0f, 1860.0f, 1050.0f,  930.0f,
+        2247.0f,  991.0f, 2110.0f } },
+    { "CCITT", "0123456789ABCDE",
+      {  400.0f,  679.0f,  770.0f,  852.0f,  941.0f, 1209.0f,
+        1335.0f, 1477.0f, 1633.0f, 1800.0f, 1900.0f, 2000.0f,
+        2100.0f, 2220.0f, 2300.0f } },
+    { "NATEL", "0123456789ABCDEF",
+      { 1633.0f,  631.0f,  697.0f,  770.0f,  852.0f,  941.0f,
+        1040.0f, 1209.0f, 1336.0f, 1477.0f, 1995.0f,  571.0f,
+        2205.0f, 2437.0f, 1805.0f, 2694.0f } },
+    { "EURO", "0123456789ABCDEF",
+      {  979.8f,  903.1f,  832.5f,  764.4f,  707.4f,  652.0f,
+         601.0f,  554.0f,  510.7f,  470.8f,  433.9f,  400.0f,
+         368.7f,  393.9f, 1062.9f,  313.3f } },
+    { "MODAT", "0123456789E",
+      {  637.5f,  787.5f,  937.5f, 1087.5f, 1237.5f, 1387.5f,
+        1537.5f, 1687.5f, 1837.5f, 1987.5f,  487.5f } },
+    { "AUTOA", "0123456789BE",
+      { 1962.0f,  764.0f,  848.0f,  942.0f, 1047.0f, 1163.0f,
+        1292.0f, 1436.0f, 1595.0f, 1770.0f, 2430.0f, 2188.0f } }
+  };
+}; /* anonymous namespace */
+
 
 
 /****************************************************************************
@@ -129,15 +212,15 @@ using namespace Async;
  ****************************************************************************/
 
 SwSel5Decoder::SwSel5Decoder(Config &cfg, const string &name)
-  : Sel5Decoder(cfg, name), sel5_table(0), samples_left(SEL5_BLOCK_LENGTH),
-    last_hit(0), last_stable(0), stable_timer(0), active_timer(0), arr_len(0)
+  : Sel5Decoder(cfg, name), block(SEL5_GOERTZEL_LENGTH),
+    win_block(SEL5_GOERTZEL_LENGTH), win(SEL5_GOERTZEL_LENGTH), block_pos(0),
+    samples_left(SEL5_BLOCK_LENGTH)
 {
 } /* SwSel5Decoder::SwSel5Decoder */
 
 
 SwSel5Decoder::~SwSel5Decoder(void)
 {
-  delete [] sel5_table;
 } /* SwSel5Decoder::~SwSel5Decoder */
 
 
@@ -148,182 +231,46 @@ bool SwSel5Decoder::initialize(void)
     return false;
   }
 
-  float tones[16];
-  /*  the tones for each mode
-   *                   0        1         2        3        4        5
-   *                   6        7         8        9        A        B
-   *                   C        D         E        F
-  */
-  float zvei1[] = { 2400.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f, 1530.0f,
-                    1670.0f, 1830.0f, 2000.0f, 2200.0f, 2800.0f,  810.0f,
-                     970.0f,  885.0f, 2600.0f,  680.0f
-                   };
-  float zvei2[] = { 2400.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f, 1530.0f,
-                     1670.0f, 1830.0f, 2000.0f, 2200.0f, 885.0f,   810.0f,
-                      740.0f,  680.0f,  970.0f, 2600.0f
-                   };
-  float zvei3[] = { 2200.0f, 970.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f,
-                     1530.0f,1670.0f, 1830.0f, 2000.0f,  885.0f,  810.0f,
-                      740.0f, 680.0f, 2400.0f, 2600.0f
-                   };
-  float ccir[]  = { 1981.0f, 1124.0f, 1197.0f, 1275.0f, 1358.0f, 1446.0f,
-                     1540.0f, 1640.0f, 1747.0f, 1860.0f, 2400.0f,  930.0f,
-                     2247.0f,  991.0f, 2110.0f, 1055.0f
-                   };
-  float pccir[] = { 1981.0f, 1124.0f, 1197.0f, 1275.0f, 1358.0f, 1446.0f,
-                     1540.0f, 1640.0f, 1747.0f, 1860.0f, 1050.0f,  930.0f,
-                     2247.0f,  991.0f, 2110.0f, 1055.0f
-                   };
-  float eea[]   = { 1981.0f, 1124.0f, 1197.0f, 1275.0f, 1358.0f, 1446.0f,
-                    1540.0f, 1640.0f, 1747.0f, 1860.0f, 1055.0f,  930.0f,
-                    2400.0f,  991.0f, 2110.0f, 2047.0f
-                   };
-  float eia[]   = {  600.0f,  741.0f,  882.0f, 1023.0f, 1164.0f, 1305.0f,
-                    1446.0f, 1587.0f, 1728.0f, 1869.0f, 2151.0f, 2433.0f,
-                    2010.0f, 2292.0f,  459.0f, 1091.0f
-                   };
-  float dzvei[] = { 2200.0f,  970.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f,
-                    1530.0f, 1670.0f, 1830.0f, 2000.0f,  825.0f,  740.0f,
-                    2600.0f,  885.0f, 2400.0f,  680.0f
-                   };
-  float pzvei[] = { 2400.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f, 1530.0f,
-                    1670.0f, 1830.0f, 2000.0f, 2200.0f,  970.0f,  810.0f,
-                    2800.0f,  885.0f, 2600.0f,  680.0f
-                   };
-  float pdzvei[]= { 2200.0f, 970.0f, 1060.0f, 1160.0f, 1270.0f, 1400.0f,
-                     1530.0f,1670.0f, 1830.0f, 2000.0f,  825.0f,  886.0f,
-                     2600.0f, 856.0f, 2400.0f
-                   };
-  float vdew[] =  { 2280.0f,  370.0f,  450.0f,  550.0f,  675.0f,  825.0f,
-                     1010.0f, 1240.0f, 1520.0f, 1860.0f, 2000.0f, 2100.0f,
-                     2200.0f, 2300.0f, 2400.0f
-                   };
-  float ccitt[] = {  400.0f,  679.0f,  770.0f,  852.0f,  941.0f, 1209.0f,
-                     1335.0f, 1477.0f, 1633.0f, 1800.0f, 1900.0f, 2000.0f,
-                     2100.0f, 2220.0f, 2300.0f
-                   };
-  float euro[] =  {  979.8f,  903.1f,  832.5f,  764.4f,  707.4f,  652.0f,
-                     601.0f,  554.0f,  510.7f,  470.8f,  433.9f,  400.0f,
-                     368.7f,  393.9f, 1062.9f,  313.3f
-                   };
-  float natel[] = { 1633.0f,  631.0f,  697.0f,  770.0f,  852.0f,  941.0f,
-                     1040.0f, 1209.0f, 1336.0f, 1477.0f, 1995.0f,  571.0f,
-                     2205.0f, 2437.0f, 1805.0f, 2694.0f
-                   };
-  float modat[] = {  637.5f,  787.5f,  937.5f, 1087.5f, 1237.5f, 1387.5f,
-                     1537.5f, 1687.5f, 1837.5f, 1987.5f, 487.5f
-                   };
-  float autoa[] = { 1962.0f,  764.0f,  848.0f,  942.0f, 1047.0f, 1163.0f,
-                     1292.0f, 1436.0f, 1595.0f, 1770.0f, 2430.0f,
-                     2188.0f
-                   };
-
   string value;
-  string tonedef = "0123456789";
-
   cfg().getValue(name(), "SEL5_TYPE", value);
-  if (value == "ZVEI1")
-  {
-     memcpy(tones, zvei1, sizeof(zvei1));
-     tonedef += "ABCDEF";
-  }
-  else if (value == "ZVEI2")
-  {
-     memcpy(tones, zvei2, sizeof(zvei2));
-     tonedef += "ABCDEF";
-  }
-  else if (value == "ZVEI3")
-  {
-     memcpy(tones, zvei3, sizeof(zvei3));
-     tonedef += "ABCDEF";
-  }
-  else if (value == "PZVEI")
-  {
-     memcpy(tones, pzvei, sizeof(pzvei));
-     tonedef += "ABCDEF";
-  }
-  else if (value == "DZVEI")
-  {
-     memcpy(tones, dzvei, sizeof(dzvei));
-     tonedef += "ABCDEF";
-  }
-  else if (value == "PDZVEI")
-  {
-     memcpy(tones, pdzvei, sizeof(pdzvei));
-     tonedef += "ABCDE";
-  }
-  else if (value == "EEA")
-  {
-     memcpy(tones, eea, sizeof(eea));
-     tonedef += "ABCDEF";
-  }
-  else if (value == "EIA")
-  {
-     memcpy(tones, eia, sizeof(eia));
-     tonedef += "ABCDEF";
-  }
-  else if (value == "VDEW")
+  vector<string> types;
+  splitStr(types, value, ", ");
+
+    // The frequencies of the tones in the tone bank. A tone that is used by
+    // more than one of the enabled standards is only added once.
+  vector<float> fqs;
+  for (vector<string>::const_iterator it=types.begin();
+       it!=types.end(); ++it)
   {
-     memcpy(tones, vdew, sizeof(vdew));
-     tonedef += "ABCDE";
-  }
-  else if (value == "CCIR" || value == "CCIR1" ||
-            value == "CCIR2")
-  {
-     memcpy(tones, ccir, sizeof(ccir));
-     tonedef += "ABCDEF";
-  }
-  else if (value == "PCCIR")
-  {
-     memcpy(tones, pccir, sizeof(pccir));
-     tonedef += "ABCDE";
-  }
-  else if (value == "CCITT")
-  {
-     memcpy(tones, ccitt, sizeof(ccitt));
-     tonedef += "ABCDE";
-  }
-  else if (value == "NATEL")
-  {
-     memcpy(tones, natel, sizeof(natel));
-     tonedef += "ABCDEF";
-  }
-  else if (value == "EURO")
-  {
-     memcpy(tones, euro, sizeof(euro));
-     tonedef += "ABCDEF";
+    if (!addStandard(*it, fqs))
+    {
+      cerr << "*** WARNING: Unknown Sel5 type \"" << *it
+           << "\" specified for " << name() << "/SEL5_TYPE. Ignoring it.\n";
+    }
   }
-  else if (value == "MODAT")
+  if (standards.empty())
   {
-     memcpy(tones, modat, sizeof(modat));
-     tonedef += "E";
+     cout << "*** WARNING: No/wrong Sel5 type defined, using default\n";
+     addStandard("ZVEI1", fqs);
   }
-  else if (value == "AUTOA")
+
+  for (vector<Standard>::const_iterator it=standards.begin();
+       it!=standards.end(); ++it)
   {
-     memcpy(tones, autoa, sizeof(autoa));
-     tonedef += "BE";
+    cout << "Starting " << it->name << " decoder" << endl;
   }
-  else
+
+  /* Init tone detectors */
+  for (size_t i=0; i<fqs.size(); i++)
   {
-     cout << "*** WARNING: No/wrong Sel5 type defined, using default\n";
-     value = "ZVEI1";
-     memcpy(tones, zvei1, sizeof(zvei1));
-     tonedef += "ABCDEF";
+     tone_bank.addBin(fqs[i], INTERNAL_SAMPLE_RATE);
   }
+  tone_energy.assign(tone_bank.size(), 0.0f);
 
-  arr_len = tonedef.length() - 1;
-  sel5_table = new char[arr_len + 1];
-  strcpy(sel5_table, tonedef.c_str());
-
-  cout << "Starting " << value << " decoder" << endl;
-
-  memset(row_energy, 0, sizeof(row_energy));
-
-  /* Init row detectors */
-  for (int a=0; a<=arr_len; a++)
+  /* Hamming window */
+  for (size_t i = 0; i < win.size(); i++)
   {
-     goertzelInit(&row_out[a],    tones[a], SEL5_BANDWIDTH, 0.0f);
-     goertzelInit(&row_out[a+20], tones[a], SEL5_BANDWIDTH, 0.5f);
+     win[i] = 0.54 - 0.46 * cosf(2.0f * M_PI * i / (win.size() - 1));
   }
 
   return true;
@@ -333,28 +280,17 @@ bool SwSel5Decoder::initialize(void)
 
 int SwSel5Decoder::writeSamples(const float *buf, int len)
 {
-    int k;
     for (int i = 0; i < len; i++)
     {
-        float v1;
-        float famp = *(buf++);
-
-        for (k=0; k<=arr_len; k++)
-        {
-          v1 = row_out[k].v2;
-          row_out[k].v2 = row_out[k].v3;
-          row_out[k].v3 = row_out[k].fac * row_out[k].v2 - v1 +
-			  famp * *(row_out[k].win++);
-        }
+        block[block_pos] = buf[i];
 
         /* Row result calculators */
-        for (k=0; k<=arr_len; k++)
+        if (++block_pos >= block.size())
         {
-          if (--row_out[k].samples_left == 0)
-              row_energy[k] = goertzelResult(&row_out[k]);
-
-          if (--row_out[k+20].samples_left == 0)
-            row_energy[k] = goertzelResult(&row_out[k+20]);
+            calcToneEnergies();
+            memmove(&block[0], &block[SEL5_GOERTZEL_STEP],
+                    (block.size() - SEL5_GOERTZEL_STEP) * sizeof(block[0]));
+            block_pos = block.size() - SEL5_GOERTZEL_STEP;
         }
 
          /* Now we are at the end of the detection block */
@@ -380,22 +316,81 @@ int SwSel5Decoder::writeSamples(const float *buf, int len)
  *
  ****************************************************************************/
 
-void SwSel5Decoder::Sel5Receive(void)
+bool SwSel5Decoder::addStandard(const string &type, vector<float> &fqs)
 {
+  string std_name(type);
+  if ((std_name == "CCIR1") || (std_name == "CCIR2"))
+  {
+    std_name = "CCIR";
+  }
 
-    /* Find the peak row and the peak column */
-    int best_row = findMaxIndex(row_energy);
+  const Sel5Type *sel5_type = 0;
+  for (size_t i=0; i<sizeof(sel5_types)/sizeof(*sel5_types); i++)
+  {
+    if (std_name == sel5_types[i].name)
+    {
+      sel5_type = &sel5_types[i];
+      break;
+    }
+  }
+  if (sel5_type == 0)
+  {
+    return false;
+  }
 
-    uint8_t hit = 0;
-    /* Valid index test */
-    if (best_row >= 0)
+  for (vector<Standard>::const_iterator it=standards.begin();
+       it!=standards.end(); ++it)
+  {
+    if (it->name == std_name)
     {
-        /* Got a hit */
-        hit = sel5_table[best_row];
+      return true;
     }
+  }
 
-    /* Call the post-processing function. */
-    Sel5PostProcess(hit);
+  Standard sel5;
+  sel5.name = std_name;
+  sel5.digits = sel5_type->digits;
+  for (size_t i=0; i<sel5.digits.size(); i++)
+  {
+    const float fq = sel5_type->tones[i];
+    size_t bin = find(fqs.begin(), fqs.end(), fq) - fqs.begin();
+    if (bin == fqs.size())
+    {
+      fqs.push_back(fq);
+    }
+    sel5.bins.push_back(bin);
+  }
+  sel5.last_hit = 0;
+  sel5.last_stable = 0;
+  sel5.stable_timer = 0;
+  sel5.active_timer = 0;
+  standards.push_back(sel5);
+
+  return true;
+
+} /* SwSel5Decoder::addStandard */
+
+
+void SwSel5Decoder::Sel5Receive(void)
+{
+
+    for (vector<Standard>::iterator it=standards.begin();
+         it!=standards.end(); ++it)
+    {
+        /* Find the peak tone */
+        int best_row = findMaxIndex(*it);
+
+        uint8_t hit = 0;
+        /* Valid index test */
+        if (best_row >= 0)
+        {
+            /* Got a hit */
+            hit = it->digits[best_row];
+        }
+
+        /* Call the post-processing function. */
+        Sel5PostProcess(*it, hit);
+    }
 
     /* Reset the sample counter. */
     samples_left = SEL5_BLOCK_LENGTH;
@@ -403,7 +398,7 @@ void SwSel5Decoder::Sel5Receive(void)
 } /* SwSel5Decoder::Sel5Receive */
 
 
-void SwSel5Decoder::Sel5PostProcess(uint8_t hit)
+void SwSel5Decoder::Sel5PostProcess(Standard &sel5, uint8_t hit)
 {
 
   /* This function is called when a complete block has been received. */
@@ -411,101 +406,77 @@ void SwSel5Decoder::Sel5PostProcess(uint8_t hit)
   {
 //    cout << "hit: " << hit << endl;
 
-    if (last_hit != hit) active_timer = 0;
+    if (sel5.last_hit != hit) sel5.active_timer = 0;
 
     /* we need some successfully detects to ensure that a tone has really been
        detected */
-    if (active_timer++ > 10 && last_stable != hit)
+    if (sel5.active_timer++ > 10 && sel5.last_stable != hit)
     {
 
        /* 'E' the the repeat tone  */
-       if (hit == 'E') dec_digits += last_stable;
-         else dec_digits += hit;
+       if (hit == 'E') sel5.dec_digits += sel5.last_stable;
+         else sel5.dec_digits += hit;
 
        /* the last successfully detected digit */
-       last_stable = hit;
+       sel5.last_stable = hit;
     }
 
     /* save the last hit */
-    last_hit = hit;
-    stable_timer = 0;
+    sel5.last_hit = hit;
+    sel5.stable_timer = 0;
   }
 
   /* detecting end of sequence */
-  if (!hit && stable_timer++ > 120)
+  if (!hit && sel5.stable_timer++ > 120)
   {
     /* we need at least 4 digits */
-    if (dec_digits.length() > 3)
+    if (sel5.dec_digits.length() > 3)
     {
-       sequenceDetected(dec_digits);
-//       cout << "Sel5 sequence detected: " << dec_digits << endl;
+       sequenceDetected(sel5.dec_digits);
+//       cout << "Sel5 sequence detected: " << sel5.dec_digits << endl;
     }
-    active_timer = 0;
-    stable_timer = 0;
-    dec_digits = "";
-    last_hit = 0;
+    sel5.active_timer = 0;
+    sel5.stable_timer = 0;
+    sel5.dec_digits = "";
+    sel5.last_hit = 0;
   }
 
 } /* SwSel5Decoder::Sel5PostProcess */
 
 
-void SwSel5Decoder::goertzelInit(GoertzelState *s, float freq, float bw, float offset)
+void SwSel5Decoder::calcToneEnergies(void)
 {
-    /* Adjust the block length to minimize the DFT error. */
-    s->block_length = lrintf(ceilf(freq / bw) * INTERNAL_SAMPLE_RATE / freq);
-    /* Scale output values to achieve same levels at different block lengths. */
-    s->scale_factor = 1.0e6f / (s->block_length * s->block_length);
-    /* Init detector frequency. */
-    s->fac = 2.0f * cosf(2.0f * M_PI * freq / INTERNAL_SAMPLE_RATE);
-    /* Reset the tone detector state. */
-    s->v2 = s->v3 = 0.0f;
-    s->samples_left = static_cast<int>(s->block_length * (1.0f - offset));
-    /* Hamming window */
-    for (int i = 0; i < s->block_length; i++)
+    /* Scale output values to get the same levels as the original
+       decoder which used a separate block length for each tone */
+    const float scale_factor =
+        1.0e6f / (SEL5_GOERTZEL_LENGTH * SEL5_GOERTZEL_LENGTH);
+
+    Async::audioKernelMultiply(&win_block[0], &block[0], &win[0],
+                               block.size());
+    tone_bank.reset();
+    tone_bank.calc(&win_block[0], win_block.size());
+    for (size_t k = 0; k < tone_bank.size(); k++)
     {
-        s->window_table.push_back(
-           0.54 - 0.46 * cosf(2.0f * M_PI * i / (s->block_length - 1)));
+        tone_energy[k] = tone_bank.magnitudeSquared(k) * scale_factor;
     }
-    /* Point to the first table entry */
-    s->win = s->window_table.begin();
 
-} /* SwSel5Decoder::goertzelInit */
+} /* SwSel5Decoder::calcToneEnergies */
 
 
-float SwSel5Decoder::goertzelResult(GoertzelState *s)
-{
-    float v1, res;
-
-    /* Push a zero through the process to finish things off. */
-    v1 = s->v2;
-    s->v2 = s->v3;
-    s->v3 = s->fac*s->v2 - v1;
-    /* Now calculate the non-recursive side of the filter. */
-    /* The result here is not scaled down to allow for the magnification
-       effect of the filter (the usual DFT magnification effect). */
-    res = (s->v3*s->v3 + s->v2*s->v2 - s->v2*s->v3*s->fac) * s->scale_factor;
-    /* Reset the tone detector state. */
-    s->v2 = s->v3 = 0.0f;
-    s->samples_left = s->block_length;
-    s->win = s->window_table.begin();
-    /* Return the calculated signal level. */
-    return res;
-
-} /* SwSel5Decoder::goertzelResult */
-
-
-int SwSel5Decoder::findMaxIndex(const float f[])
+int SwSel5Decoder::findMaxIndex(const Standard &sel5) const
 {
     float threshold = 1.0f;
     int idx = -1;
     int i;
+    const int cnt = sel5.bins.size();
 
     /* Peak search */
-    for (i = 0; i < arr_len; i++)
+    for (i = 0; i < cnt; i++)
     {
-        if (f[i] > threshold)
+        const float f = tone_energy[sel5.bins[i]];
+        if (f > threshold)
         {
-            threshold = f[i];
+            threshold = f;
             idx = i;
         }
     }
@@ -515,9 +486,9 @@ int SwSel5Decoder::findMaxIndex(const float f[])
     /* Peak test */
     threshold *= 1.0f / SEL5_RELATIVE_PEAK;
 
-    for (i = 0; i < arr_len; i++)
+    for (i = 0; i < cnt; i++)
     {
-        if (idx != i && f[i] > threshold)
+        if (idx != i && tone_energy[sel5.bins[i]] > threshold)
             return -1;
     }
     return idx;
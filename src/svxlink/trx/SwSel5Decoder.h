@@ -6,7 +6,7 @@
 
 \verbatim
 SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
-Copyright (C) 2004-2010  Tobias Blomberg / SM0SVX
+Copyright (C) 2004-2026  Tobias Blomberg / SM0SVX
 
 This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License as published by
@@ -36,6 +36,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <vector>
+#include <string>
 #include <stdint.h>
 #include <sigc++/sigc++.h>
 
@@ -55,6 +56,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "Sel5Decoder.h"
+#include "Goertzel.h"
 
 
 /****************************************************************************
@@ -103,6 +105,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  * This class implements a software SEL5 decoder
  * implemented using Goertzel's algorithm.
+ *
+ * More than one Sel5 standard can be enabled at the same time. Tones that
+ * are used by more than one of the enabled standards are only detected once
+ * and each standard then run its own sequence detection on the shared
+ * tone levels.
  */
 class SwSel5Decoder : public Sel5Decoder
 {
@@ -138,49 +145,51 @@ class SwSel5Decoder : public Sel5Decoder
     virtual int writeSamples(const float *samples, int count);
 
   private:
-
-    // Tone detection descriptor
-    typedef struct
+    /*! The detector state for one of the enabled Sel5 standards. */
+    struct Standard
     {
-      float v2;
-      float v3;
-      float fac;
-      float scale_factor;
-      std::vector<float> window_table;
-      std::vector<float>::const_iterator win;
-      int samples_left;
-      int block_length;
-    } GoertzelState;
-
-    /*! Tone detector working states for the row tones. */
-    GoertzelState row_out[36];
-
-    /* tone-digit table*/
-    char *sel5_table;
-
-    /*! Row tone signal level values. */
-    float row_energy[16];
+      /*! The name of the standard */
+      std::string         name;
+      /*! Tone-digit table */
+      std::string         digits;
+      /*! The index in the tone bank of the tone for each digit */
+      std::vector<size_t> bins;
+      /*! The result of the last tone analysis. */
+      uint8_t             last_hit;
+      /*! This is the last stable tone digit. */
+      uint8_t             last_stable;
+      /*! The detection timer advances when the input is stable. */
+      int                 stable_timer;
+      /*! The active timer is reset when a new non-zero digit is detected. */
+      int                 active_timer;
+      /*! the detected Sel5 sequence */
+      std::string         dec_digits;
+    };
+
+    /*! Tone detectors for all distinct tones in the enabled standards. */
+    GoertzelBank tone_bank;
+    /*! The sample block that the tone detectors are run over. */
+    std::vector<float> block;
+    /*! The windowed samples in the current block. */
+    std::vector<float> win_block;
+    /*! The window function applied to each block. */
+    std::vector<float> win;
+    /*! The number of samples in the block. */
+    size_t block_pos;
+
+    /*! Signal level values for each tone in the tone bank. */
+    std::vector<float> tone_energy;
+    /*! The enabled Sel5 standards. */
+    std::vector<Standard> standards;
 
     /*! Remaining sample count in the current detection interval. */
     int samples_left;
-    /*! The result of the last tone analysis. */
-    uint8_t last_hit;
-    /*! This is the last stable tone digit. */
-    uint8_t last_stable;
-    /*! The detection timer advances when the input is stable. */
-    int stable_timer;
-    /*! The active timer is reset when a new non-zero digit is detected. */
-    int active_timer;
-    /*! the detected Sel5 sequence */
-    std::string dec_digits;
-    /*! the length of the tone definition */
-    int arr_len;
 
+    bool addStandard(const std::string &type, std::vector<float> &fqs);
     void Sel5Receive(void);
-    void Sel5PostProcess(uint8_t hit);
-    void goertzelInit(GoertzelState *s, float freq, float bw, float offset);
-    float goertzelResult(GoertzelState *s);
-    int findMaxIndex(const float f[]);
+    void Sel5PostProcess(Standard &sel5, uint8_t hit);
+    void calcToneEnergies(void);
+    int findMaxIndex(const Standard &sel5) const;
 
 };  /* class SwSel5Decoder */
 
@@ -39,6 +39,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <complex>
 
 
 /****************************************************************************
@@ -47,6 +48,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncAudioKernels.h>
 
 
 /****************************************************************************
@@ -56,7 +58,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "ToneDetector.h"
-#include "Goertzel.h"
 
 
 
@@ -96,9 +97,9 @@ struct ToneDetector::DetectorParams
   float		      phase_mean_thresh;
   float		      phase_var_thresh;
   float		      phase_actual_fq;
-  Goertzel	      center;
-  Goertzel	      lower;
-  Goertzel	      upper;
+  float		      two_cosw[MAX_BINS];
+  float		      center_cosw;
+  float		      center_sinw;
   std::vector<float>  window_table;
   bool		      use_windowing;
   float		      peak_to_tot_pwr_thresh;
@@ -130,6 +131,8 @@ struct ToneDetector::DetectorParams
  *
  ****************************************************************************/
 
+  // The second feedback coefficient of a Goertzel stage, for all bins
+static const float minus_one[] = { -1.0f, -1.0f, -1.0f };
 
 
 /****************************************************************************
@@ -210,13 +213,8 @@ void ToneDetector::reset(void)
   stable_count = 0;
   samples_left = par->block_len;
 
-    // Point to the first windowing table entry
-  win = par->window_table.begin();
-
     // Reset Goertzel filters
-  par->center.reset();
-  par->lower.reset();
-  par->upper.reset();
+  resetBins();
 
     // Reset phase check state variables
   phaseCheckReset();
@@ -300,10 +298,8 @@ void ToneDetector::setDetectBw(float bw_hz)
     }
   }
 
-  det_par->center.initialize(tone_fq, INTERNAL_SAMPLE_RATE);
-  det_par->lower.initialize(tone_fq - 2 * bw_hz, INTERNAL_SAMPLE_RATE);
-  det_par->upper.initialize(tone_fq + 2 * bw_hz, INTERNAL_SAMPLE_RATE);
-  
+  initBins(det_par, tone_fq, bw_hz);
+
 } /* ToneDetector::setDetectBw */
 
 
@@ -326,9 +322,7 @@ void ToneDetector::setUndetectBw(float bw_hz)
     }
   }
 
-  undet_par->center.initialize(tone_fq, INTERNAL_SAMPLE_RATE);
-  undet_par->lower.initialize(tone_fq - 2 * bw_hz, INTERNAL_SAMPLE_RATE);
-  undet_par->upper.initialize(tone_fq + 2 * bw_hz, INTERNAL_SAMPLE_RATE);
+  initBins(undet_par, tone_fq, bw_hz);
 
 } /* ToneDetector::setUndetectBw */
 
@@ -455,42 +449,33 @@ void ToneDetector::setUndetectUseWindowing(bool enable)
 
 int ToneDetector::writeSamples(const float *buf, int len)
 {
-  for (int i = 0;  i < len;  i++)
+  int left = len;
+  while (left > 0)
   {
-    float famp = *(buf++);
+    const int chunk_len = chunkLength(left);
+    const float *chunk = buf;
 
       // First apply the Hamming window, if enabled
-    if (par->use_windowing)
+    if (useWindowing())
     {
-      famp *= *(win++);
+      if (win_buf.size() < static_cast<size_t>(chunk_len))
+      {
+        win_buf.resize(chunk_len);
+      }
+      audioKernelMultiply(&win_buf[0], buf, window(), chunk_len);
+      chunk = &win_buf[0];
     }
 
-    passband_energy += static_cast<double>(famp) * famp;
-
-      // Run the recursive Goertzel stage for the center frequency
-    par->center.calc(famp);
-
-    if (par->peak_thresh > 0.0f)
-    {
-        // Run the recursive Goertzel stage for the lower and upper frequency
-      par->lower.calc(famp);
-      par->upper.calc(famp);
-    }
-
-    if ((phase_check_left > 0) && (--phase_check_left == 0))
-    {
-      phaseCheck();
-      phase_check_left = par->period_block_len;
-    }
+      // Run the recursive Goertzel stages and sum up the passband energy
+    runBins(chunk, chunk_len);
+    advance(chunk_len, audioKernelDotProduct(chunk, chunk, chunk_len));
 
-    if (--samples_left == 0)
-    {
-      postProcess();
-    }
+    buf += chunk_len;
+    left -= chunk_len;
   }
-    
+
   return len;
-  
+
 } /* ToneDetector::writeSamples */
 
 
@@ -501,6 +486,116 @@ int ToneDetector::writeSamples(const float *buf, int len)
  *
  ****************************************************************************/
 
+void ToneDetector::initBins(DetectorParams *p, float fq, float bw)
+{
+  const float fqs[MAX_BINS] = { fq, fq - 2 * bw, fq + 2 * bw };
+  for (int i=0; i<MAX_BINS; ++i)
+  {
+    p->two_cosw[i] = 2.0f * cosf(2.0f * M_PI * fqs[i] / INTERNAL_SAMPLE_RATE);
+  }
+  p->center_cosw = cosf(2.0f * M_PI * fq / INTERNAL_SAMPLE_RATE);
+  p->center_sinw = sinf(2.0f * M_PI * fq / INTERNAL_SAMPLE_RATE);
+} /* ToneDetector::initBins */
+
+
+int ToneDetector::binCount(void) const
+{
+    // The lower and upper bins are only needed for the peak check
+  return (par->peak_thresh > 0.0f) ? MAX_BINS : 1;
+} /* ToneDetector::binCount */
+
+
+const float *ToneDetector::binCoeffs(void) const
+{
+  return par->two_cosw;
+} /* ToneDetector::binCoeffs */
+
+
+bool ToneDetector::useWindowing(void) const
+{
+  return par->use_windowing;
+} /* ToneDetector::useWindowing */
+
+
+int ToneDetector::blockLength(void) const
+{
+  return par->block_len;
+} /* ToneDetector::blockLength */
+
+
+int ToneDetector::blockPos(void) const
+{
+  return par->block_len - samples_left;
+} /* ToneDetector::blockPos */
+
+
+const float *ToneDetector::window(void) const
+{
+  return &par->window_table[blockPos()];
+} /* ToneDetector::window */
+
+
+int ToneDetector::chunkLength(int len) const
+{
+    // A chunk must end where the block ends or where the next phase check
+    // is done
+  len = min(len, samples_left);
+  if (phase_check_left > 0)
+  {
+    len = min(len, phase_check_left);
+  }
+  return len;
+} /* ToneDetector::chunkLength */
+
+
+void ToneDetector::runBins(const float *buf, int len)
+{
+  audioKernelResonatorBank(0, 0, 0, buf, len, q0, q1, par->two_cosw,
+                           minus_one, binCount());
+} /* ToneDetector::runBins */
+
+
+void ToneDetector::advance(int len, float energy)
+{
+  passband_energy += energy;
+
+  if ((phase_check_left > 0) && ((phase_check_left -= len) == 0))
+  {
+    phaseCheck();
+    phase_check_left = par->period_block_len;
+  }
+
+  if ((samples_left -= len) == 0)
+  {
+    postProcess();
+  }
+} /* ToneDetector::advance */
+
+
+float ToneDetector::magnitudeSquared(int bin) const
+{
+  return q0[bin] * q0[bin] + q1[bin] * q1[bin] -
+         q0[bin] * q1[bin] * par->two_cosw[bin];
+} /* ToneDetector::magnitudeSquared */
+
+
+float ToneDetector::centerPhase(void) const
+{
+  return std::arg(std::complex<float>(
+        par->center_cosw * q0[BIN_CENTER] - q1[BIN_CENTER],
+        par->center_sinw * q0[BIN_CENTER]));
+} /* ToneDetector::centerPhase */
+
+
+void ToneDetector::resetBins(void)
+{
+  for (int i=0; i<MAX_BINS; ++i)
+  {
+    q0[i] = q1[i] = 0.0f;
+  }
+} /* ToneDetector::resetBins */
+
+
 void ToneDetector::phaseCheckReset(void)
 {
   if (par->phase_mean_thresh > 0.0f)
@@ -518,7 +613,7 @@ void ToneDetector::phaseCheckReset(void)
 
 void ToneDetector::phaseCheck(void)
 {
-  float phase = par->center.phase();
+  float phase = centerPhase();
   if (prev_phase < 2.0f * M_PI)
   {
     float diff = phase - prev_phase;
@@ -542,7 +637,7 @@ void ToneDetector::postProcess(void)
   bool active = true;
 
     // Calculate the magnitude for the center bin
-  float res_center = par->center.magnitudeSquared();
+  float res_center = magnitudeSquared(BIN_CENTER);
 
     // Now determine if the tone is active or not. We start by checking
     // if the tone energy exceed the energy threshold. This check
@@ -554,12 +649,12 @@ void ToneDetector::postProcess(void)
   {
       // Check if the center fq is above the lower fq bin by the peak threshold.
       // This is part of the "neighbour bin SNR" check.
-    float res_lower = par->lower.magnitudeSquared();
+    float res_lower = magnitudeSquared(BIN_LOWER);
     active = active && (res_center > (res_lower * par->peak_thresh));
 
       // Check if the center fq is above the upper fq bin by the peak threshold.
       // This is part of the "neighbour bin SNR" check.
-    float res_upper = par->upper.magnitudeSquared();
+    float res_upper = magnitudeSquared(BIN_UPPER);
     active = active && (res_center > (res_upper * par->peak_thresh));
   }
 
@@ -661,14 +756,10 @@ void ToneDetector::postProcess(void)
     }
   }
 
-    // Point to the first windowing table entry
-  win = par->window_table.begin();
     // Reload sample counter
   samples_left = par->block_len;
 
-  par->center.reset();
-  par->lower.reset();
-  par->upper.reset();
+  resetBins();
   phaseCheckReset();
   passband_energy = 0.0f;
 
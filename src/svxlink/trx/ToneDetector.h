@@ -63,6 +63,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+class ToneDetectorBank;
 
 
 /****************************************************************************
@@ -106,6 +107,13 @@ single frequency. For maximum detection reliability, the bandwidth will
 be adapted to place the tone frequency near the center of the DFT.
 As a side effect, the detection bandwidth is slightly narrowed, which
 however is acceptable for the current use cases (CTCSS, 1750Hz, etc..).
+
+Samples are processed in chunks, up to the next block or phase check
+boundary, so that the Goertzel stages can be run using SIMD instructions.
+When multiple tone detectors are fed the same audio, add them to a
+ToneDetectorBank instead of an audio splitter. The bank will then share the
+windowing and passband energy calculation between detectors that are in the
+same state.
 */
 class ToneDetector : public sigc::trackable, public Async::AudioSink
 {
@@ -469,8 +477,15 @@ class ToneDetector : public sigc::trackable, public Async::AudioSink
     sigc::signal<void, float> snrUpdated;
     
   private:
+    friend class ToneDetectorBank;
+
     struct DetectorParams;
 
+    static const int BIN_CENTER	= 0;
+    static const int BIN_LOWER	= 1;
+    static const int BIN_UPPER	= 2;
+    static const int MAX_BINS	= 3;
+
     static CONSTEXPR bool   DEFAULT_USE_WINDOWING	= true;
     static CONSTEXPR float  DEFAULT_TONE_ENERGY_THRESH	= 0.1f;
     static CONSTEXPR float  DEFAULT_PEAK_THRESH		= 10.0;
@@ -491,9 +506,24 @@ class ToneDetector : public sigc::trackable, public Async::AudioSink
     DetectorParams	*par;
     double		passband_energy;
     float               last_snr;
-
-    std::vector<float>::const_iterator win;
-
+    float               q0[MAX_BINS];
+    float               q1[MAX_BINS];
+    std::vector<float>  win_buf;
+
+    static void initBins(DetectorParams *p, float fq, float bw);
+
+    int binCount(void) const;
+    const float *binCoeffs(void) const;
+    bool useWindowing(void) const;
+    int blockLength(void) const;
+    int blockPos(void) const;
+    const float *window(void) const;
+    int chunkLength(int len) const;
+    void runBins(const float *buf, int len);
+    void advance(int len, float energy);
+    float magnitudeSquared(int bin) const;
+    float centerPhase(void) const;
+    void resetBins(void);
     void phaseCheckReset(void);
     void phaseCheck(void);
     void postProcess(void);
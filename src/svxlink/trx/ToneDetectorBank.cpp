@@ -0,0 +1,293 @@
+/**
+@file	 ToneDetectorBank.cpp
+@brief   Run a number of tone detectors on the same audio stream
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioKernels.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ToneDetector.h"
+#include "ToneDetectorBank.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+ToneDetectorBank::ToneDetectorBank(void)
+  : is_writing(false), remove_cnt(0)
+{
+} /* ToneDetectorBank::ToneDetectorBank */
+
+
+ToneDetectorBank::~ToneDetectorBank(void)
+{
+  deleteDetectors(detectors.size());
+} /* ToneDetectorBank::~ToneDetectorBank */
+
+
+void ToneDetectorBank::addDetector(ToneDetector *det, bool managed)
+{
+  Detector d = { det, managed };
+  detectors.push_back(d);
+} /* ToneDetectorBank::addDetector */
+
+
+void ToneDetectorBank::removeAllDetectors(void)
+{
+  if (is_writing)
+  {
+    remove_cnt = detectors.size();
+    return;
+  }
+  deleteDetectors(detectors.size());
+} /* ToneDetectorBank::removeAllDetectors */
+
+
+int ToneDetectorBank::writeSamples(const float *buf, int len)
+{
+  deleteDetectors(remove_cnt);
+
+  is_writing = true;
+  int left = len;
+  while ((left > 0) && !detectors.empty() && (remove_cnt == 0))
+  {
+      // Find the longest chunk that does not cross a block or phase check
+      // boundary for any of the detectors
+    int chunk_len = left;
+    for (size_t i=0; i<detectors.size(); ++i)
+    {
+      chunk_len = detectors[i].det->chunkLength(chunk_len);
+    }
+
+      // Group the detectors that see the same input and run each group
+    done.assign(detectors.size(), false);
+    for (size_t i=0; i<detectors.size(); ++i)
+    {
+      if (done[i])
+      {
+        continue;
+      }
+      group.clear();
+      for (size_t j=i; j<detectors.size(); ++j)
+      {
+        if (!done[j] && sameInput(detectors[i].det, detectors[j].det))
+        {
+          group.push_back(j);
+          done[j] = true;
+        }
+      }
+      runGroup(buf, chunk_len);
+    }
+
+    buf += chunk_len;
+    left -= chunk_len;
+  }
+  is_writing = false;
+
+  deleteDetectors(remove_cnt);
+
+  return len;
+
+} /* ToneDetectorBank::writeSamples */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ToneDetectorBank::deleteDetectors(size_t cnt)
+{
+  for (size_t i=0; i<cnt; ++i)
+  {
+    if (detectors[i].managed)
+    {
+      delete detectors[i].det;
+    }
+  }
+  detectors.erase(detectors.begin(), detectors.begin() + cnt);
+  remove_cnt = 0;
+} /* ToneDetectorBank::deleteDetectors */
+
+
+bool ToneDetectorBank::sameInput(const ToneDetector *a,
+                                 const ToneDetector *b) const
+{
+    // The Hamming window only depend on the block length so two windowed
+    // detectors see the same input if they are at the same block position
+  if (a->useWindowing() != b->useWindowing())
+  {
+    return false;
+  }
+  return !a->useWindowing() ||
+         ((a->blockLength() == b->blockLength()) &&
+          (a->blockPos() == b->blockPos()));
+} /* ToneDetectorBank::sameInput */
+
+
+void ToneDetectorBank::runGroup(const float *buf, int len)
+{
+  ToneDetector *first = detectors[group[0]].det;
+  const float *chunk = buf;
+  if (first->useWindowing())
+  {
+    if (win_buf.size() < static_cast<size_t>(len))
+    {
+      win_buf.resize(len);
+    }
+    audioKernelMultiply(&win_buf[0], buf, first->window(), len);
+    chunk = &win_buf[0];
+  }
+  const float energy = audioKernelDotProduct(chunk, chunk, len);
+
+    // Gather the Goertzel stages of all detectors in the group so that they
+    // can be run in one pass
+  q0.clear();
+  q1.clear();
+  coeffs.clear();
+  for (size_t i=0; i<group.size(); ++i)
+  {
+    const ToneDetector *det = detectors[group[i]].det;
+    const int bin_cnt = det->binCount();
+    const float *bin_coeffs = det->binCoeffs();
+    q0.insert(q0.end(), det->q0, det->q0 + bin_cnt);
+    q1.insert(q1.end(), det->q1, det->q1 + bin_cnt);
+    coeffs.insert(coeffs.end(), bin_coeffs, bin_coeffs + bin_cnt);
+  }
+  minus_one.resize(coeffs.size(), -1.0f);
+
+  audioKernelResonatorBank(0, 0, 0, chunk, len, &q0[0], &q1[0], &coeffs[0],
+                           &minus_one[0], coeffs.size());
+
+    // Scatter the state back before advancing any detector since advancing
+    // may change the detector parameters
+  size_t pos = 0;
+  for (size_t i=0; i<group.size(); ++i)
+  {
+    ToneDetector *det = detectors[group[i]].det;
+    const int bin_cnt = det->binCount();
+    copy(q0.begin() + pos, q0.begin() + pos + bin_cnt, det->q0);
+    copy(q1.begin() + pos, q1.begin() + pos + bin_cnt, det->q1);
+    pos += bin_cnt;
+  }
+  for (size_t i=0; i<group.size(); ++i)
+  {
+    detectors[group[i]].det->advance(len, energy);
+  }
+} /* ToneDetectorBank::runGroup */
+
+
+
+/*
+ * This file has not been truncated
+ */
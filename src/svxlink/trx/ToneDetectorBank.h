@@ -0,0 +1,208 @@
+/**
+@file	 ToneDetectorBank.h
+@brief   Run a number of tone detectors on the same audio stream
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef TONE_DETECTOR_BANK_INCLUDED
+#define TONE_DETECTOR_BANK_INCLUDED
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+class ToneDetector;
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Run a number of tone detectors on the same audio stream
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class is an audio sink that feed the same audio to a number of tone
+detectors. It is a more efficient replacement for an audio splitter with
+one tone detector per branch. The audio is processed in chunks that end at
+the nearest block or phase check boundary of any of the detectors. Within a
+chunk, all detectors that see the same input, that is all detectors that
+do not use windowing or detectors that use windowing with the same block
+length and block position, share the windowing and the passband energy
+calculation. The Goertzel stages of each such group are run in one pass.
+*/
+class ToneDetectorBank : public sigc::trackable, public Async::AudioSink
+{
+  public:
+    /**
+     * @brief 	Default constructor
+     */
+    ToneDetectorBank(void);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~ToneDetectorBank(void);
+
+    /**
+     * @brief   Add a tone detector to the bank
+     * @param   det     The tone detector to add
+     * @param   managed Set to \em true to let the bank delete the detector
+     */
+    void addDetector(ToneDetector *det, bool managed=false);
+
+    /**
+     * @brief   Remove all tone detectors from the bank
+     *
+     * Managed detectors are deleted. If called from within a tone detector
+     * signal handler, the removal is done when the current block of samples
+     * has been processed. Detectors added after the call are not removed.
+     */
+    void removeAllDetectors(void);
+
+    /**
+     * @brief   Get the number of tone detectors in the bank
+     * @return  Returns the number of tone detectors
+     */
+    size_t size(void) const { return detectors.size(); }
+
+    /**
+     * @brief Write samples into the tone detector bank
+     * @param buf The buffer containing the samples
+     * @param len The number of samples in the buffer
+     */
+    virtual int writeSamples(const float *buf, int len);
+
+    /**
+     * @brief   Tell the sink to flush the previously written samples
+     *
+     * This function is used to tell the sink to flush previously written
+     * samples. When done flushing, the sink should call the
+     * sourceAllSamplesFlushed function.
+     */
+    virtual void flushSamples(void) { sourceAllSamplesFlushed(); }
+
+  private:
+    struct Detector
+    {
+      ToneDetector  *det;
+      bool          managed;
+    };
+
+    std::vector<Detector>     detectors;
+    std::vector<bool>         done;
+    std::vector<int>          group;
+    std::vector<float>        win_buf;
+    std::vector<float>        q0;
+    std::vector<float>        q1;
+    std::vector<float>        coeffs;
+    std::vector<float>        minus_one;
+    bool                      is_writing;
+    size_t                    remove_cnt;
+
+    ToneDetectorBank(const ToneDetectorBank&);
+    ToneDetectorBank& operator=(const ToneDetectorBank&);
+    void deleteDetectors(size_t cnt);
+    bool sameInput(const ToneDetector *a, const ToneDetector *b) const;
+    void runGroup(const float *buf, int len);
+
+};  /* class ToneDetectorBank */
+
+
+//} /* namespace */
+
+#endif /* TONE_DETECTOR_BANK_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
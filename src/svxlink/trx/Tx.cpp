@@ -44,6 +44,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncMetrics.h>
 
 
 /****************************************************************************
@@ -242,6 +243,19 @@ void Tx::setIsTransmitting(bool is_transmitting)
            << (is_transmitting ? "ON" : "OFF") << endl;
     }
     m_is_transmitting = is_transmitting;
+    if (is_transmitting)
+    {
+        // The counter is looked up when first needed since the constructor
+        // is inline
+      if (m_tx_cnt == 0)
+      {
+        m_tx_cnt = Metrics::instance().counter(
+            "svxlink_tx_transmit_total",
+            "Number of times the transmitter has been turned on",
+            Metric::Labels{{"tx", m_name}});
+      }
+      m_tx_cnt->inc();
+    }
     transmitterStateChange(is_transmitting);
 
     char tx_id = id();
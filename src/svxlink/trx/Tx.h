@@ -39,6 +39,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sigc++/sigc++.h>
 
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -67,6 +68,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+namespace Async
+{
+  class MetricCounter;
+};
 
 
 /****************************************************************************
@@ -137,7 +142,7 @@ class Tx : public sigc::trackable, public Async::AudioSink
      */
     Tx(std::string tx_name)
       : m_name(tx_name), m_tx_id('\0'), m_verbose(true),
-        m_is_transmitting(false)
+        m_is_transmitting(false), m_tx_cnt(0)
     {
     }
   
@@ -236,6 +241,59 @@ class Tx : public sigc::trackable, public Async::AudioSink
      */
     virtual void setModulation(Modulation::Type mod) {}
 
+    /**
+     * @brief   Let someone else condition the audio for this transmitter
+     * @return  Returns \em true if the transmitter support this
+     *
+     * This function must be called before initialize. If the transmitter
+     * support it, the audio conditioning stages (pre-emphasis, limiter,
+     * clipper and voiceband filter) are left out of the transmitter audio
+     * chain. The audio written to the transmitter must then already have
+     * been conditioned, e.g. by a TxAudioConditioner shared by multiple
+     * transmitters in a MultiTx.
+     */
+    virtual bool useExternalAudioConditioning(void) { return false; }
+
+    /**
+     * @brief   Options given to an audio codec, as name/value pairs
+     */
+    typedef std::vector<std::pair<std::string, std::string> > CodecOptions;
+
+    /**
+     * @brief   Check if encoded audio can be written to this transmitter
+     * @param   codec_name The name of the codec used to encode the audio
+     * @param   dec_opts   The options that a decoder for the audio would use
+     * @return  Returns \em true if writeEncodedAudio can be used
+     *
+     * A transmitter that encode the audio again using the same codec, like
+     * the NetTx, can forward encoded audio untouched. That save a full
+     * decode/encode cycle. The default is to not support encoded audio.
+     */
+    virtual bool canWriteEncodedAudio(const std::string& codec_name,
+                                      const CodecOptions& dec_opts)
+    {
+      return false;
+    }
+
+    /**
+     * @brief   Write encoded audio to the transmitter
+     * @param   buf  The buffer containing the encoded audio
+     * @param   size The number of bytes in the buffer
+     *
+     * This function must only be used if canWriteEncodedAudio have returned
+     * \em true for the codec that the audio was encoded with. Encoded audio
+     * must not be mixed with audio written to the audio sink.
+     */
+    virtual void writeEncodedAudio(const void *buf, int size) {}
+
+    /**
+     * @brief   Flush the encoded audio written to the transmitter
+     *
+     * The allEncodedAudioFlushed signal is emitted when all encoded audio
+     * has been transmitted.
+     */
+    virtual void flushEncodedAudio(void) {}
+
     /**
      * @brief 	This signal is emitted when the tx timeout timer expires
      *
@@ -253,6 +311,25 @@ class Tx : public sigc::trackable, public Async::AudioSink
      */
     sigc::signal<void, bool> transmitterStateChange;
 
+    /**
+     * @brief   This signal is emitted when the first audio of a transmission
+     *          is output
+     *
+     * This signal is emitted when the first audio sample after the
+     * transmitter has been idle reach the audio device, or the network for a
+     * remote transmitter. It is used to measure the latency from a squelch
+     * opening to audio actually being transmitted.
+     */
+    sigc::signal<void> txAudioStarted;
+
+    /**
+     * @brief   A signal that is emitted when all encoded audio is flushed
+     *
+     * This signal is emitted after a call to flushEncodedAudio when all the
+     * encoded audio has been transmitted.
+     */
+    sigc::signal<void> allEncodedAudioFlushed;
+
     /**
      * @brief	A signal that is emitted to publish a state update event
      * @param	event_name The name of the event
@@ -276,6 +353,7 @@ class Tx : public sigc::trackable, public Async::AudioSink
     char        m_tx_id;
     bool        m_verbose;
     bool        m_is_transmitting;
+    Async::MetricCounter* m_tx_cnt;
 
 };  /* class Tx */
 
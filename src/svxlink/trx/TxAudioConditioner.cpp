@@ -0,0 +1,223 @@
+/**
+@file	 TxAudioConditioner.cpp
+@brief   The audio conditioning chain used by a local transmitter
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sstream>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncConfig.h>
+#include <AsyncAudioPassthrough.h>
+#include <AsyncAudioClipper.h>
+#include <AsyncAudioCompressor.h>
+#include <AsyncAudioFilter.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "Emphasis.h"
+#include "TxAudioConditioner.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+#define DEFAULT_LIMITER_THRESH  0.0
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static bool preemphasisEnabled(Config& cfg, const string& tx_name);
+static double limiterThresh(Config& cfg, const string& tx_name);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+string TxAudioConditioner::configId(Config& cfg, const string& tx_name)
+{
+  ostringstream ss;
+  ss << "PREEMPHASIS=" << preemphasisEnabled(cfg, tx_name)
+     << " LIMITER_THRESH=" << limiterThresh(cfg, tx_name);
+  return ss.str();
+} /* TxAudioConditioner::configId */
+
+
+TxAudioConditioner::TxAudioConditioner(Config& cfg, const string& tx_name)
+{
+  AudioPassthrough *input = new AudioPassthrough;
+  AudioSink::setHandler(input);
+  AudioSource *prev_src = input;
+
+    // If preemphasis is enabled, create the preemphasis filter
+  if (preemphasisEnabled(cfg, tx_name))
+  {
+    PreemphasisFilter *preemph = new PreemphasisFilter;
+    prev_src->registerSink(preemph, true);
+    prev_src = preemph;
+  }
+
+    // Add a limiter to smoothly limit the audio before hard clipping it
+  double limiter_thresh = limiterThresh(cfg, tx_name);
+  if (limiter_thresh != 0.0)
+  {
+    AudioCompressor *limit = new AudioCompressor;
+    limit->setThreshold(limiter_thresh);
+    limit->setRatio(0.1);
+    limit->setAttack(2);
+    limit->setDecay(20);
+    limit->setOutputGain(1);
+    prev_src->registerSink(limit, true);
+    prev_src = limit;
+  }
+
+    // Clip audio to limit its amplitude
+  AudioClipper *clipper = new AudioClipper;
+  prev_src->registerSink(clipper, true);
+  prev_src = clipper;
+
+#if (INTERNAL_SAMPLE_RATE == 16000)
+  AudioFilter *voiceband_filter =
+    new AudioFilter("LpCh9/-0.05/5500 x HpCh12/-0.05/300");
+#else
+  AudioFilter *voiceband_filter =
+    new AudioFilter("LpBu20/3500 x HpCh12/-0.05/300");
+#endif
+  prev_src->registerSink(voiceband_filter, true);
+  prev_src = voiceband_filter;
+
+  AudioSource::setHandler(prev_src);
+} /* TxAudioConditioner::TxAudioConditioner */
+
+
+TxAudioConditioner::~TxAudioConditioner(void)
+{
+  AudioSource::clearHandler();
+  AudioSink *handler = AudioSink::handler();
+  AudioSink::clearHandler();
+  delete handler;
+} /* TxAudioConditioner::~TxAudioConditioner */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+static bool preemphasisEnabled(Config& cfg, const string& tx_name)
+{
+  int preemphasis = 0;
+  cfg.getValue(tx_name, "PREEMPHASIS", preemphasis);
+  return preemphasis != 0;
+} /* preemphasisEnabled */
+
+
+static double limiterThresh(Config& cfg, const string& tx_name)
+{
+  double limiter_thresh = DEFAULT_LIMITER_THRESH;
+  cfg.getValue(tx_name, "LIMITER_THRESH", limiter_thresh);
+  return limiter_thresh;
+} /* limiterThresh */
+
+
+
+/*
+ * This file has not been truncated
+ */
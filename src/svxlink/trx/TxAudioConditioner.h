@@ -0,0 +1,165 @@
+/**
+@file	 TxAudioConditioner.h
+@brief   The audio conditioning chain used by a local transmitter
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef TX_AUDIO_CONDITIONER_INCLUDED
+#define TX_AUDIO_CONDITIONER_INCLUDED
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+#include <AsyncAudioSource.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class Config;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	The audio conditioning chain used by a local transmitter
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-14
+
+This class contain the audio processing stages that condition the audio
+before it is transmitted: pre-emphasis, limiter, clipper and the voiceband
+filter. The stages are configured using the PREEMPHASIS and LIMITER_THRESH
+configuration variables in the transmitter configuration section.
+
+Normally each LocalTx have its own conditioning chain. When multiple
+transmitters in a MultiTx have identical conditioning settings, the MultiTx
+run a single chain for all of them instead. The configId function is used to
+find out if the settings for two transmitters are identical.
+*/
+class TxAudioConditioner : public Async::AudioSink, public Async::AudioSource
+{
+  public:
+    /**
+     * @brief   Get a string that identify the conditioning settings
+     * @param   cfg     A previously initialized config object
+     * @param   tx_name The name of the transmitter config section
+     * @return  Returns a string that is equal for equal settings
+     */
+    static std::string configId(Async::Config& cfg,
+                                const std::string& tx_name);
+
+    /**
+     * @brief 	Constructor
+     * @param   cfg     A previously initialized config object
+     * @param   tx_name The name of the transmitter config section
+     */
+    TxAudioConditioner(Async::Config& cfg, const std::string& tx_name);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~TxAudioConditioner(void);
+
+  private:
+    TxAudioConditioner(const TxAudioConditioner&);
+    TxAudioConditioner& operator=(const TxAudioConditioner&);
+
+};  /* class TxAudioConditioner */
+
+
+//} /* namespace */
+
+#endif /* TX_AUDIO_CONDITIONER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
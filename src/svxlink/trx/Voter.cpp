@@ -38,8 +38,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <utility>
 #include <list>
+#include <deque>
+#include <vector>
 #include <sigc++/bind.h>
 #include <sys/time.h>
 #include <json/json.h>
@@ -51,12 +54,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncApplication.h>
+#include <AsyncCppEventLoopThread.h>
 #include <AsyncTimer.h>
-#include <AsyncAudioFifo.h>
 #include <AsyncAudioSelector.h>
 #include <AsyncAudioValve.h>
 #include <AsyncPty.h>
 #include <AsyncPtyStreamBuf.h>
+#include <AsyncMetrics.h>
+#include <AsyncTracepoint.h>
 
 
 /****************************************************************************
@@ -95,6 +101,366 @@ using namespace Async;
  *
  ****************************************************************************/
 
+/*
+ * A pool of fixed size sample chunks that is shared by the delay lines of
+ * all satellite receivers. Chunks that are released are kept for reuse so
+ * the memory used is set by the peak number of receivers buffering audio at
+ * the same time, not by the total number of receivers.
+ */
+class Voter::DelayPool
+{
+  public:
+    static const unsigned CHUNK_SIZE = 256;
+
+    struct Chunk
+    {
+      float samples[CHUNK_SIZE];
+    };
+
+    DelayPool(void) {}
+
+    ~DelayPool(void)
+    {
+      vector<Chunk *>::iterator it;
+      for (it=free_chunks.begin(); it!=free_chunks.end(); ++it)
+      {
+        delete *it;
+      }
+    }
+
+    Chunk *acquire(void)
+    {
+      if (free_chunks.empty())
+      {
+        return new Chunk;
+      }
+      Chunk *chunk = free_chunks.back();
+      free_chunks.pop_back();
+      return chunk;
+    }
+
+    void release(Chunk *chunk)
+    {
+      free_chunks.push_back(chunk);
+    }
+
+  private:
+    vector<Chunk *> free_chunks;
+
+    DelayPool(const DelayPool&);
+    DelayPool& operator=(const DelayPool&);
+};
+
+
+/*
+ * A delay line used to hold back the audio from a satellite receiver while
+ * voting. It work like an AudioFifo in overwrite mode but the samples are
+ * stored in chunks drawn from a shared pool. Since audio only arrive while
+ * the receiver squelch is open, an idle receiver does not hold any chunks.
+ *
+ * The delay line also keep track of when the buffered audio was captured,
+ * either from the capture times reported by the receiver or from the local
+ * arrival time. This is used to align the audio when switching receivers.
+ */
+class Voter::DelayLine : public AudioSink, public AudioSource
+{
+  public:
+    DelayLine(DelayPool &pool, unsigned max_samples)
+      : pool(pool), max_samples(max_samples), samp_cnt(0), head_pos(0),
+        tail_pos(0), is_flushing(false), in_pos(0), has_capture_time(false),
+        align_pending(false), align_time(0)
+    {
+    }
+
+    ~DelayLine(void)
+    {
+      discard(samp_cnt);
+    }
+
+    bool empty(void) const { return samp_cnt == 0; }
+
+    /*
+     * Set the capture time of the next sample written. When this is used,
+     * the local arrival time is no longer used to timestamp the audio.
+     */
+    void setCaptureTime(const struct timeval &tv)
+    {
+      has_capture_time = true;
+      addMark(static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec);
+    }
+
+    /*
+     * Return the capture time, in microseconds, of the next sample that
+     * will be output or -1 if the time is not known
+     */
+    int64_t outputTime(void) const
+    {
+      return timeAt(in_pos - samp_cnt);
+    }
+
+    /*
+     * Drop buffered and incoming samples that was captured before the given
+     * time. If the newest sample is older than that by more than the buffer
+     * length, the receiver clocks are assumed to not be synchronized and the
+     * time is ignored.
+     */
+    void alignTo(int64_t t)
+    {
+      align_pending = false;
+      const int64_t head_time = outputTime();
+      if ((t < 0) || (head_time < 0) || (head_time >= t) ||
+          (t - timeAt(in_pos) > samplesToUsec(max_samples)))
+      {
+        return;
+      }
+      while (!empty())
+      {
+        const int64_t behind = t - outputTime();
+        if (behind <= 0)
+        {
+          return;
+        }
+        unsigned cnt = min(usecToSamples(behind), samp_cnt);
+        unsigned seg_cnt = segmentLength(in_pos - samp_cnt);
+        discard(min(cnt, seg_cnt));
+      }
+      align_pending = true;
+      align_time = t;
+    }
+
+    void clear(void)
+    {
+      bool was_empty = empty();
+      align_pending = false;
+      discard(samp_cnt);
+      if (is_flushing && !was_empty)
+      {
+        sinkFlushSamples();
+      }
+    }
+
+    virtual int writeSamples(const float *samples, int count)
+    {
+      is_flushing = false;
+      if (!has_capture_time)
+      {
+          // The arrival time is only marked when it has drifted away from
+          // the sample count, e.g. after a pause in the audio stream
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        const int64_t t = static_cast<int64_t>(now.tv_sec) * 1000000 +
+                          now.tv_usec - samplesToUsec(count);
+        const int64_t expected_t = timeAt(in_pos);
+        if ((expected_t < 0) || (llabs(t - expected_t) > MAX_ARRIVAL_DRIFT))
+        {
+          addMark(t);
+        }
+      }
+      const int orig_count = count;
+      if (align_pending)
+      {
+        assert(empty());
+        unsigned skip = min(usecToSamples(align_time - timeAt(in_pos)),
+                            static_cast<unsigned>(count));
+        in_pos += skip;
+        samples += skip;
+        count -= skip;
+        if (count == 0)
+        {
+          return orig_count;
+        }
+        align_pending = false;
+      }
+      in_pos += count;
+      int written = 0;
+      if (empty())
+      {
+        written = sinkWriteSamples(samples, count);
+      }
+      while (written < count)
+      {
+        if (chunks.empty() || (tail_pos == DelayPool::CHUNK_SIZE))
+        {
+          chunks.push_back(pool.acquire());
+          tail_pos = 0;
+        }
+        unsigned cnt = min(static_cast<unsigned>(count - written),
+                           DelayPool::CHUNK_SIZE - tail_pos);
+        memcpy(chunks.back()->samples + tail_pos, samples + written,
+               cnt * sizeof(*samples));
+        tail_pos += cnt;
+        samp_cnt += cnt;
+        written += cnt;
+      }
+      if (samp_cnt > max_samples)
+      {
+        discard(samp_cnt - max_samples);
+      }
+      return orig_count;
+    }
+
+    virtual void flushSamples(void)
+    {
+      is_flushing = true;
+      if (empty())
+      {
+        sinkFlushSamples();
+      }
+      else
+      {
+        writeFromBuffer();
+      }
+    }
+
+    virtual void resumeOutput(void)
+    {
+      if (!empty())
+      {
+        writeFromBuffer();
+      }
+    }
+
+  protected:
+    virtual void allSamplesFlushed(void)
+    {
+      if (is_flushing && empty())
+      {
+        is_flushing = false;
+        sourceAllSamplesFlushed();
+      }
+    }
+
+  private:
+      // The largest drift, in microseconds, between the local arrival time
+      // and the sample count before the arrival time is marked again
+    static const int64_t MAX_ARRIVAL_DRIFT = 20000;
+
+      // A capture time, in microseconds, for the sample at a stream position
+    typedef deque<pair<uint64_t, int64_t> > Marks;
+
+    DelayPool                   &pool;
+    deque<DelayPool::Chunk *>   chunks;
+    unsigned                    max_samples;
+    unsigned                    samp_cnt;
+    unsigned                    head_pos;
+    unsigned                    tail_pos;
+    bool                        is_flushing;
+    uint64_t                    in_pos;
+    Marks                       marks;
+    bool                        has_capture_time;
+    bool                        align_pending;
+    int64_t                     align_time;
+
+    DelayLine(const DelayLine&);
+    DelayLine& operator=(const DelayLine&);
+
+    static int64_t samplesToUsec(unsigned cnt)
+    {
+      return static_cast<int64_t>(cnt) * 1000000 / INTERNAL_SAMPLE_RATE;
+    }
+
+    static unsigned usecToSamples(int64_t usec)
+    {
+      if (usec <= 0)
+      {
+        return 0;
+      }
+      return (usec * INTERNAL_SAMPLE_RATE + 999999) / 1000000;
+    }
+
+    void addMark(int64_t t)
+    {
+      if (!marks.empty() && (marks.back().first == in_pos))
+      {
+        marks.back().second = t;
+      }
+      else
+      {
+        marks.push_back(Marks::value_type(in_pos, t));
+      }
+        // Only the last mark before the output position is needed
+      const uint64_t out_pos = in_pos - samp_cnt;
+      while ((marks.size() > 1) && (marks[1].first <= out_pos))
+      {
+        marks.pop_front();
+      }
+    }
+
+    int64_t timeAt(uint64_t pos) const
+    {
+      Marks::const_reverse_iterator it;
+      for (it=marks.rbegin(); it!=marks.rend(); ++it)
+      {
+        if (it->first <= pos)
+        {
+          return it->second + samplesToUsec(pos - it->first);
+        }
+      }
+      return -1;
+    }
+
+      // The number of samples from pos up to the next mark
+    unsigned segmentLength(uint64_t pos) const
+    {
+      Marks::const_iterator it;
+      for (it=marks.begin(); it!=marks.end(); ++it)
+      {
+        if (it->first > pos)
+        {
+          return it->first - pos;
+        }
+      }
+      return in_pos - pos;
+    }
+
+    void writeFromBuffer(void)
+    {
+      while (!empty())
+      {
+        unsigned end = (chunks.size() == 1) ? tail_pos : DelayPool::CHUNK_SIZE;
+        int cnt = sinkWriteSamples(chunks.front()->samples + head_pos,
+                                   end - head_pos);
+        if (cnt <= 0)
+        {
+          return;
+        }
+        consume(cnt);
+      }
+      if (is_flushing)
+      {
+        sinkFlushSamples();
+      }
+    }
+
+    void discard(unsigned cnt)
+    {
+      while (cnt > 0)
+      {
+        unsigned end = (chunks.size() == 1) ? tail_pos : DelayPool::CHUNK_SIZE;
+        unsigned chunk_cnt = min(cnt, end - head_pos);
+        consume(chunk_cnt);
+        cnt -= chunk_cnt;
+      }
+    }
+
+    void consume(unsigned cnt)
+    {
+      head_pos += cnt;
+      samp_cnt -= cnt;
+      if ((head_pos == DelayPool::CHUNK_SIZE) || (samp_cnt == 0))
+      {
+        pool.release(chunks.front());
+        chunks.pop_front();
+        head_pos = 0;
+        if (chunks.empty())
+        {
+          tail_pos = 0;
+        }
+      }
+    }
+};
+
+
 /**
  * @brief A class that represents a satellite receiver
  * 
@@ -109,10 +475,11 @@ using namespace Async;
 class Voter::SatRx : public AudioSource, public sigc::trackable
 {
   public:
-    SatRx(Config &cfg, const string &rx_name, int id, int fifo_length_ms)
+    SatRx(Config &cfg, const string &rx_name, int id, int fifo_length_ms,
+          DelayPool &delay_pool)
       : rx_id(id), rx(0), fifo(0), sql_open(false), enabled(true),
         mute_state(Rx::MUTE_ALL), // FIXME: Set this from the Rx object
-        sql_open_delay(0)
+        sql_open_delay(0), indexed(false), decoding_deferred(false)
     {
       rx = RxFactory::createNamedRx(cfg, rx_name);
       if (rx != 0)
@@ -133,8 +500,10 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
 
 	if (fifo_length_ms > 0)
 	{
-	  fifo = new AudioFifo(fifo_length_ms * INTERNAL_SAMPLE_RATE / 1000);
-	  fifo->setOverwrite(true);
+	  fifo = new DelayLine(delay_pool,
+                               fifo_length_ms * INTERNAL_SAMPLE_RATE / 1000);
+	  rx->audioCaptureTime.connect(
+                  mem_fun(*fifo, &DelayLine::setCaptureTime));
 	  prev_src->registerSink(fifo);
 	  prev_src = fifo;
 	  valve.setBlockWhenClosed(true);
@@ -250,17 +619,64 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
     
     char id(void) const { return rx->sqlRxId(); }
 
+    /*
+     * Drop the buffered audio that was captured before the audio that the
+     * given receiver will output next, so that the audio continue from the
+     * same point in time when switching from that receiver to this one.
+     */
+    void alignOutputTo(const SatRx *srx)
+    {
+      if ((fifo != 0) && (srx->fifo != 0))
+      {
+        fifo->alignTo(srx->fifo->outputTime());
+      }
+    }
+
+    void setDecoderThread(Async::CppEventLoopThread *thread)
+    {
+      rx->setDecoderThread(thread);
+    }
+
+    void setDecodingDeferred(bool defer, unsigned backlog_ms)
+    {
+      if (defer != decoding_deferred)
+      {
+        decoding_deferred = defer;
+        rx->setDecodingDeferred(defer, backlog_ms);
+      }
+    }
+
     void setSqlOpenDelay(unsigned new_sql_open_delay)
     {
       sql_open_delay = new_sql_open_delay;
     }
     unsigned sqlOpenDelay(void) const { return sql_open_delay; }
+
+    /*
+     * Move this receiver to its new place in the signal level index. The
+     * receiver is only kept in the index while enabled with an open squelch.
+     */
+    void updateIndex(SiglevIndex &index, float siglev)
+    {
+      if (indexed)
+      {
+        index.erase(index_pos);
+        indexed = false;
+      }
+      if (enabled && sql_open)
+      {
+        index_pos = index.insert(SiglevIndex::value_type(siglev, this));
+        indexed = true;
+      }
+    }
+
+    bool isIndexed(void) const { return indexed; }
     
-    signal<void, char, int>  	dtmfDigitDetected;
-    signal<void, string>  	selcallSequenceDetected;
-    signal<void, bool, SatRx*> 	squelchOpen;
-    signal<void, float, SatRx*>	signalLevelUpdated;
-    signal<void, float>		toneDetected;
+    sigc::signal<void, char, int>  	dtmfDigitDetected;
+    sigc::signal<void, string>  	selcallSequenceDetected;
+    sigc::signal<void, bool, SatRx*> 	squelchOpen;
+    sigc::signal<void, float, SatRx*>	signalLevelUpdated;
+    sigc::signal<void, float>		toneDetected;
 
     
   protected:
@@ -277,7 +693,7 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
     
     int		  rx_id;
     Rx		  *rx;
-    AudioFifo 	  *fifo;
+    DelayLine 	  *fifo;
     AudioValve	  valve;
     DtmfBuf   	  dtmf_buf;
     SelcallBuf	  selcall_buf;
@@ -285,6 +701,9 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
     bool          enabled;
     Rx::MuteState mute_state;
     unsigned      sql_open_delay;
+    bool                  indexed;
+    SiglevIndex::iterator index_pos;
+    bool                  decoding_deferred;
     
     void onDtmfDigitDetected(char digit, int duration)
     {
@@ -377,10 +796,14 @@ class Voter::SatRx : public AudioSource, public sigc::trackable
  ****************************************************************************/
 
 Voter::Voter(Config &cfg, const std::string& name)
-  : Rx(cfg, name), cfg(cfg), m_verbose(true), selector(0),
+  : Rx(cfg, name), cfg(cfg), delay_pool(0), m_verbose(true), selector(0),
     sm(Macho::State<Top>(this)), is_processing_event(false), command_pty(0),
-    m_print_sat_squelch(false)
+    m_print_sat_squelch(false), decode_max_rxs(0), buffer_length(0)
 {
+  m_rx_switch_cnt = Metrics::instance().counter(
+      "svxlink_voter_rx_switch_total",
+      "Number of switches between receivers during a transmission",
+      Metric::Labels{{"rx", name}});
 } /* Voter::Voter */
 
 
@@ -403,6 +826,17 @@ Voter::~Voter(void)
     delete *it;
   }
   rxs.clear();
+  siglev_index.clear();
+  delete delay_pool;
+  delay_pool = 0;
+
+    // The decoder threads are stopped after the receivers using them are gone
+  DecodeThreads::iterator tit;
+  for (tit=decode_threads.begin(); tit!=decode_threads.end(); ++tit)
+  {
+    delete *tit;
+  }
+  decode_threads.clear();
 } /* Voter::~Voter */
 
 
@@ -424,6 +858,7 @@ bool Voter::initialize(void)
       << name() << "/" << "COMMAND_PTY" << endl;
       return false;
     }
+    command_pty->setLineBuffered(true);
     command_pty->dataReceived.connect(
         sigc::mem_fun(*this, &Voter::onCommandPtyInput));
   }
@@ -446,7 +881,7 @@ bool Voter::initialize(void)
   }
   sm->setVotingDelay(voting_delay);
   
-  unsigned buffer_length = voting_delay;
+  buffer_length = voting_delay;
   cfg.getValue(name(), "BUFFER_LENGTH", buffer_length);
   if (buffer_length > MAX_BUFFER_LENGTH)
   {
@@ -455,7 +890,9 @@ bool Voter::initialize(void)
 	 << MAX_BUFFER_LENGTH << ".\n";
     return false;
   }
-  
+
+  delay_pool = new DelayPool;
+
   float hysteresis = 100.0f * (DEFAULT_HYSTERESIS - 1.0f);
   cfg.getValue(name(), "HYSTERESIS", hysteresis);
   if ((hysteresis < 0.0f)
@@ -510,6 +947,28 @@ bool Voter::initialize(void)
 
   cfg.getValue(name(), "VERBOSE", m_print_sat_squelch);
 
+  unsigned decode_thread_cnt = 0;
+  if (!cfg.getValue(name(), "DECODE_THREADS", 0U, MAX_DECODE_THREADS,
+                    decode_thread_cnt, true))
+  {
+    cerr << "*** ERROR: Config variable " << name() << "/DECODE_THREADS out "
+            "of range. Valid range is 0 to " << MAX_DECODE_THREADS << ".\n";
+    return false;
+  }
+  for (unsigned i=0; i<decode_thread_cnt; ++i)
+  {
+    Async::CppEventLoopThread *thread = new Async::CppEventLoopThread;
+    decode_threads.push_back(thread);
+    if (!thread->start())
+    {
+      cerr << "*** ERROR: Could not start the audio decoder threads for "
+           << name() << endl;
+      return false;
+    }
+  }
+
+  cfg.getValue(name(), "DECODE_MAX_RXS", decode_max_rxs);
+
   selector = new AudioSelector;
   setHandler(selector);
   
@@ -534,7 +993,8 @@ bool Voter::initialize(void)
     if (!rx_name.empty())
     {
       cout << "\tAdding receiver: " << rx_name << endl;
-      SatRx *srx = new SatRx(cfg, rx_name, rxs.size() + 1, buffer_length);
+      SatRx *srx = new SatRx(cfg, rx_name, rxs.size() + 1, buffer_length,
+                             *delay_pool);
       srx->setSqlOpenDelay(sql_open_delay);
       srx->squelchOpen.connect(mem_fun(*this, &Voter::satSquelchOpen));
       srx->signalLevelUpdated.connect(
@@ -546,6 +1006,11 @@ bool Voter::initialize(void)
       {
       	return false;
       }
+      if (!decode_threads.empty())
+      {
+        srx->setDecoderThread(
+            decode_threads[rxs.size() % decode_threads.size()]);
+      }
       srx->setMuteState(MUTE_ALL);
       srx->toneDetected.connect(toneDetected.make_slot());
       selector->addSource(srx);
@@ -560,6 +1025,8 @@ bool Voter::initialize(void)
     start = comma;
     ++start;
   }
+
+  updateDecoding();
   
   return true;
   
@@ -663,16 +1130,20 @@ void Voter::satSquelchOpen(bool is_open, SatRx *srx)
     }
     std::cout << std::endl;
   }
+  srx->updateIndex(siglev_index, srx->signalStrength());
   dispatchEvent(Macho::Event(&Top::satSquelchOpen, srx, is_open));
+  updateDecoding();
 } /* Voter::satSquelchOpen */
 
 
 void Voter::satSignalLevelUpdated(float siglev, SatRx *srx)
 {
+  srx->updateIndex(siglev_index, siglev);
   if (srx->isEnabled())
   {
     dispatchEvent(Macho::Event(&Top::satSignalLevelUpdated, srx, siglev));
   }
+  updateDecoding();
 } /* Voter::satSignalLevelUpdated */
 
 
@@ -743,22 +1214,88 @@ void Voter::printSquelchState(void)
 
 Voter::SatRx *Voter::findBestRx(void) const
 {
-  float best_rx_siglev = 0.0f;
-  SatRx *best_rx = 0;
-  list<SatRx *>::const_iterator it;
+  if (siglev_index.empty())
+  {
+    return 0;
+  }
+  return siglev_index.rbegin()->second;
+} /* Voter::findBestRx */
+
+
+void Voter::updateDecoding(void)
+{
+  if (decode_max_rxs == 0)
+  {
+    return;
+  }
+
+    // Decode the receivers with the strongest signals and the active one.
+    // The audio of the rest is kept encoded for as long as it may be needed.
+    // This is run on every signal level update so the decision is made
+    // directly from the index order, without building a temporary set.
+  SatRx *active_srx = sm->activeSrx();
+  unsigned rank = 0;
+  SiglevIndex::const_reverse_iterator iit;
+  for (iit=siglev_index.rbegin(); iit!=siglev_index.rend(); ++iit, ++rank)
+  {
+    SatRx *srx = iit->second;
+    srx->setDecodingDeferred((rank >= decode_max_rxs) && (srx != active_srx),
+                             buffer_length);
+  }
+  list<SatRx *>::iterator it;
   for (it=rxs.begin(); it!=rxs.end(); ++it)
   {
-    if ((*it)->isEnabled() && (*it)->squelchIsOpen() &&
-	((best_rx == 0) || ((*it)->signalStrength() > best_rx_siglev)))
+    if (!(*it)->isIndexed())
     {
-      best_rx = *it;
-      best_rx_siglev = (*it)->signalStrength();
+      (*it)->setDecodingDeferred(*it != active_srx, buffer_length);
     }
   }
-  
-  return best_rx;
-  
-} /* Voter::findBestRx */
+} /* Voter::updateDecoding */
+
+
+
+/****************************************************************************
+ *
+ * Task queue
+ *
+ ****************************************************************************/
+
+Voter::TaskQueue::TaskQueue(void)
+  : drain_pending(false)
+{
+  tasks.reserve(16);
+  running.reserve(16);
+} /* Voter::TaskQueue::TaskQueue */
+
+
+void Voter::TaskQueue::add(const sigc::slot<void> &task)
+{
+  tasks.push_back(task);
+  if (!drain_pending)
+  {
+    drain_pending = true;
+    Application::app().runTask(mem_fun(*this, &TaskQueue::drain));
+  }
+} /* Voter::TaskQueue::add */
+
+
+void Voter::TaskQueue::clear(void)
+{
+  tasks.clear();
+} /* Voter::TaskQueue::clear */
+
+
+void Voter::TaskQueue::drain(void)
+{
+    // Tasks queued by the running tasks are run in the next drain
+  drain_pending = false;
+  running.swap(tasks);
+  for (SlotList::iterator it=running.begin(); it!=running.end(); ++it)
+  {
+    (*it)();
+  }
+  running.clear();
+} /* Voter::TaskQueue::drain */
 
 
 
@@ -778,8 +1315,7 @@ void Voter::Top::init(Voter *voter)
 
 void Voter::Top::exit(void)
 {
-  delete box().task_timer;
-  box().task_timer = 0;
+  box().tasks.clear();
 } /* Voter::Top::exit */
 
 
@@ -819,72 +1355,48 @@ void Voter::Top::satSquelchOpen(SatRx *srx, bool is_open)
 {
   assert(srx != 0);
   
-  if (bestSrx() == 0)
+  box().best_srx = voter().findBestRx();
+  if ((bestSrx() == 0) && is_open)
   {
-    assert(is_open);
+      // A disabled receiver is not in the signal level index
     box().best_srx = srx;
   }
-  else if (srx == bestSrx())
-  {
-    if (!is_open)
-    {
-      box().best_srx = voter().findBestRx();
-    }
-  }
-  else
-  {
-    if (is_open &&
-        (srx->signalStrength() > bestSrx()->signalStrength()))
-    {
-      box().best_srx = srx;
-    }
-  }
 } /* Voter::Top::satSquelchOpen */
 
 
 void Voter::Top::satSignalLevelUpdated(SatRx *srx, float siglev)
 {
   assert(srx != 0);
-  assert(bestSrx() != 0);
   assert(srx->squelchIsOpen());
   
-  if (!bestSrx()->squelchIsOpen() ||
-      (siglev > bestSrx()->signalStrength()))
-  {
-    box().best_srx = srx;
-  }
+  box().best_srx = voter().findBestRx();
+  assert(bestSrx() != 0);
 
   if (srx == activeSrx())
   {
-    runTask(bind(voter().signalLevelUpdated.make_slot(), siglev));
+      // Signal level updates are coalesced so that only the latest value
+      // is reported when the queued tasks are run
+    box().siglev = siglev;
+    if (!box().siglev_queued)
+    {
+      box().siglev_queued = true;
+      runTask(mem_fun(*this, &Voter::Top::emitSignalLevel));
+    }
   }
 } /* Voter::Top::satSignalLevelUpdated */
 
 
 void Voter::Top::runTask(sigc::slot<void> task)
 {
-  box().task_list.push_back(task);
-  
-  if (box().task_timer == 0)
-  {
-    Timer *t = new Timer(0);
-    t->expired.connect(mem_fun(*this, &Voter::Top::taskTimerExpired));
-  }
+  box().tasks.add(task);
 } /* Voter::Top::runTask */
 
 
-void Voter::Top::taskTimerExpired(Timer *t)
+void Voter::Top::emitSignalLevel(void)
 {
-  SlotList::iterator it;
-  for (it=box().task_list.begin(); it!=box().task_list.end(); ++it)
-  {
-    (*it)();
-  }
-  box().task_list.clear();
-  
-  delete box().task_timer;
-  box().task_timer = 0;
-} /* Voter::Top::taskTimerExpired */
+  box().siglev_queued = false;
+  voter().signalLevelUpdated(box().siglev);
+} /* Voter::Top::emitSignalLevel */
 
 
 void Voter::Top::startTimer(unsigned time_ms)
@@ -1045,6 +1557,9 @@ void Voter::VotingDelay::timerExpired(void)
 void Voter::ActiveRxSelected::init(SatRx *srx)
 {
   assert(srx != 0);
+  ASYNC_TRACEPOINT(svxlink, voter_select, voter().name().c_str(),
+                   srx->name().c_str(),
+                   static_cast<int>(srx->signalStrength()));
   box().active_srx = srx;
   if (muteState() == MUTE_CONTENT)
   {
@@ -1084,6 +1599,7 @@ char Voter::ActiveRxSelected::sqlRxId(void)
 
 void Voter::ActiveRxSelected::changeActiveSrx(SatRx *srx)
 {
+  srx->alignOutputTo(activeSrx());
   voter().selector->selectSource(srx);
   activeSrx()->setMuteState(MUTE_CONTENT);
   box().active_srx = srx;
@@ -1325,8 +1841,14 @@ void Voter::SwitchActiveRx::timerExpired(void)
 	   << "\" (" << switch_to_srx_siglev << ")\n";
     }
     
+    ASYNC_TRACEPOINT(svxlink, voter_switch, voter().name().c_str(),
+                     activeSrx()->name().c_str(),
+                     switch_to_srx->name().c_str(),
+                     static_cast<int>(active_srx_siglev),
+                     static_cast<int>(switch_to_srx_siglev));
     changeActiveSrx(switch_to_srx);
     box().switch_to_srx = 0;
+    voter().m_rx_switch_cnt->inc();
   }
   setState<Receiving>();
 } /* Voter::SwitchActiveRx::timerExpired */
@@ -1334,29 +1856,9 @@ void Voter::SwitchActiveRx::timerExpired(void)
 
 void Voter::onCommandPtyInput(const void *buf, size_t count)
 {
+    // The PTY is line buffered so each call contain exactly one command
   const char *buffer = reinterpret_cast<const char*>(buf);
-  for (size_t i=0; i<count; ++i)
-  {
-    char ch = buffer[i];
-    switch (ch)
-    {
-      case '\n':  // Execute command on NL
-        handlePtyCommand(command_buf);
-        command_buf.clear();
-        break;
-
-      case '\r':  // Ignore CR
-        break;
-
-      default:    // Append character to command buffer
-        if (command_buf.size() >= 256)  // Prevent cmd buffer growing too big
-        {
-          command_buf.clear();
-        }
-        command_buf += ch;
-        break;
-    }
-  }
+  handlePtyCommand(std::string(buffer, buffer + count));
 } /* Voter::onCommandPtyInput */
 
 
@@ -1423,6 +1925,8 @@ void Voter::setRxEnabled(const std::string &rx_name, bool do_enable,
         cout << name() << ": " << (do_enable ? "Enabling" : "Disabling")
              << " receiver " << (*it)->name() << endl;
         (*it)->setEnabled(do_enable, disabled_mute_state);
+        (*it)->updateIndex(siglev_index, (*it)->signalStrength());
+        updateDecoding();
       }
       return;
     }
@@ -36,6 +36,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <list>
+#include <map>
+#include <vector>
 
 
 /****************************************************************************
@@ -69,6 +71,7 @@ namespace Async
   class Timer;
   class AudioSelector;
   class Pty;
+  class CppEventLoopThread;
 };
 
 
@@ -199,13 +202,41 @@ class Voter : public Rx
     static CONSTEXPR unsigned MIN_REVOTE_INTERVAL            = 100;
     static CONSTEXPR unsigned MAX_REVOTE_INTERVAL            = 60000;
     static CONSTEXPR unsigned MAX_RX_SWITCH_DELAY            = 3000;
+    static CONSTEXPR unsigned MAX_DECODE_THREADS             = 64;
 
     class SatRx;
+    class DelayPool;
+    class DelayLine;
+
+      // The enabled receivers with an open squelch, ordered by signal level
+    typedef std::multimap<float, SatRx *> SiglevIndex;
+
+    /*
+     * A queue of tasks that are run from the main loop, all at once, when
+     * the current call chain has returned. The queue is drained through
+     * the application task list so no timer is created per task and the task
+     * buffers keep their capacity between drains. Since the queue is
+     * trackable, a pending drain is cancelled if the queue is destroyed.
+     */
+    class TaskQueue : public sigc::trackable
+    {
+      public:
+        typedef std::vector<sigc::slot<void> > SlotList;
+
+        TaskQueue(void);
+        void add(const sigc::slot<void> &task);
+        void clear(void);
+
+      private:
+        SlotList  tasks;
+        SlotList  running;
+        bool      drain_pending;
+
+        void drain(void);
+    };
 
     TOPSTATE(Top)
     {
-      typedef std::list<sigc::slot<void> > SlotList;
-      
 	// Top state variables (visible to all substates)
       struct Box {
 	Box(void)
@@ -213,7 +244,8 @@ class Voter : public Rx
 	    sql_close_revote_delay(DEFAULT_SQL_CLOSE_REVOTE_DELAY),
 	    rx_switch_delay(DEFAULT_RX_SWITCH_DELAY),
 	    revote_interval(DEFAULT_REVOTE_INTERVAL), voter(0), best_srx(0),
-	    mute_state(MUTE_ALL), task_timer(0), event_timer(0)
+	    mute_state(MUTE_ALL), siglev(0.0f), siglev_queued(false),
+	    event_timer(0)
 	{
 	  event_timer.setEnable(false);
 	}
@@ -226,8 +258,9 @@ class Voter : public Rx
 	Voter		*voter;
 	SatRx		*best_srx;
         Rx::MuteState   mute_state;
-	Async::Timer	*task_timer;
-	SlotList	task_list;
+	TaskQueue	tasks;
+	float		siglev;
+	bool		siglev_queued;
 	Async::Timer	event_timer;
       };
 
@@ -274,7 +307,7 @@ class Voter : public Rx
 	SatRx *bestSrx(void) { return box().best_srx; }
 	bool muteState(void) { return box().mute_state; }
 	void runTask(sigc::slot<void> task);
-	void taskTimerExpired(Async::Timer *t);
+	void emitSignalLevel(void);
 	void startTimer(unsigned time_ms);
 	void stopTimer(void);
 	
@@ -403,17 +436,23 @@ class Voter : public Rx
     };
     
     typedef std::list<Macho::IEvent<Top>*> EventQueue;
+    typedef std::vector<Async::CppEventLoopThread*> DecodeThreads;
     
     Async::Config     	  &cfg;
     std::list<SatRx *>	  rxs;
+    DelayPool             *delay_pool;
+    SiglevIndex           siglev_index;
     bool	      	  m_verbose;
     Async::AudioSelector  *selector;
     Macho::Machine<Top>   sm;
     bool		  is_processing_event;
     EventQueue		  event_queue;
     Async::Pty            *command_pty;
-    std::string           command_buf;
     bool                  m_print_sat_squelch;
+    Async::MetricCounter  *m_rx_switch_cnt;
+    DecodeThreads         decode_threads;
+    unsigned              decode_max_rxs;
+    unsigned              buffer_length;
 
     void dispatchEvent(Macho::IEvent<Top> *event);
     void satSquelchOpen(bool is_open, SatRx *rx);
@@ -424,6 +463,7 @@ class Voter : public Rx
     void resetAll(void);
     void printSquelchState(void);
     SatRx *findBestRx(void) const;
+    void updateDecoding(void);
     void onCommandPtyInput(const void *buf, size_t count);
     void handlePtyCommand(const std::string &full_command);
     void setRxEnabled(const std::string &rx_name, bool do_enable,
@@ -0,0 +1,1032 @@
+/**
+@file	 VoterBench.cpp
+@brief   Measure how many remote receivers a voter can handle
+@author  Tobias Blomberg / SM0SVX
+@date	 2026-10-14
+
+This benchmark start a number of simulated remotetrx uplinks in a child
+process. Each uplink talk the real NetTrxMsg protocol over a local TCP
+connection and stream a prerecorded audio clip using a fixed squelch and
+signal level pattern. The parent process set up a voter with one NetRx per
+uplink and measure the CPU usage, the memory usage, the voter decision
+latency and the audio continuity. This is repeated with an increasing number
+of receivers.
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2026 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppApplication.h>
+#include <AsyncConfig.h>
+#include <AsyncTimer.h>
+#include <AsyncTcpServer.h>
+#include <AsyncAudioSink.h>
+#include <AsyncAudioEncoder.h>
+#include <BenchUtil.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "Rx.h"
+#include "NetTrxMsg.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace NetTrxMsg;
+using namespace SvxLink;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+#define BASE_PORT         25300
+#define MAX_RECEIVERS     1000
+#define START_DELAY_MS    2000
+#define WARMUP_MS         5000
+#define TALK_MS           4000
+#define PAUSE_MS          1000
+#define CYCLE_MS          (TALK_MS + PAUSE_MS)
+#define TICK_MS           20
+#define FRAME_SIZE        (INTERNAL_SAMPLE_RATE * TICK_MS / 1000)
+#define SIGLEV_TICKS      5
+#define POLL_MS           5
+#define GAP_MS            100
+#define VOTING_DELAY      200
+#define BUFFER_LENGTH     200
+#define CLIP_SECONDS      10
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+
+  // The receiver id chars that can be told apart by the voter. The '?' char
+  // is used for an unknown receiver id so it is skipped.
+const unsigned ID_CNT = '~' - '!';
+
+char rxId(unsigned idx)
+{
+  if (idx >= ID_CNT)
+  {
+    return Rx::ID_UNKNOWN;
+  }
+  char id = '!' + idx;
+  return (id >= '?') ? id + 1 : id;
+} /* rxId */
+
+
+/*
+ * The schedule is shared by the two processes. It is computed from the start
+ * time so both sides know how many receivers are in use, when the squelch
+ * open and which receiver should win the vote without talking to each other.
+ * Each transmission start with one winner which hand over to the next
+ * receiver halfway through.
+ */
+class Schedule
+{
+  public:
+    uint64_t          t0_us;
+    vector<unsigned>  steps;
+    unsigned          measure_ms;
+
+    Schedule(void) : t0_us(0), measure_ms(0) {}
+
+    uint64_t stepStartUs(size_t step) const
+    {
+      return t0_us + static_cast<uint64_t>(step) *
+                     (WARMUP_MS + measure_ms) * 1000;
+    }
+
+    uint64_t endUs(void) const { return stepStartUs(steps.size()); }
+
+    unsigned rxCntAt(uint64_t t) const
+    {
+      if ((t < t0_us) || (t >= endUs()))
+      {
+        return 0;
+      }
+      return steps[(t - t0_us) / ((WARMUP_MS + measure_ms) * 1000ULL)];
+    }
+
+    uint64_t cycleAt(uint64_t t, uint64_t& cycle_start) const
+    {
+      uint64_t k = (t - t0_us) / (CYCLE_MS * 1000ULL);
+      cycle_start = t0_us + k * CYCLE_MS * 1000;
+      return k;
+    }
+
+    bool isTalking(uint64_t t) const
+    {
+      uint64_t cycle_start;
+      cycleAt(t, cycle_start);
+      return (t - cycle_start) < TALK_MS * 1000ULL;
+    }
+
+    bool isSecondHalf(uint64_t t) const
+    {
+      uint64_t cycle_start;
+      cycleAt(t, cycle_start);
+      return (t - cycle_start) >= TALK_MS * 500ULL;
+    }
+
+    unsigned winnerAt(uint64_t t, unsigned rx_cnt) const
+    {
+      unsigned cand_cnt = min(rx_cnt, ID_CNT);
+      if (cand_cnt == 0)
+      {
+        return 0;
+      }
+      uint64_t cycle_start;
+      uint64_t k = cycleAt(t, cycle_start);
+      if (isSecondHalf(t))
+      {
+        ++k;
+      }
+      return k % cand_cnt;
+    }
+}; /* class Schedule */
+
+
+class UplinkFarm;
+
+/*
+ * The server side of one remotetrx uplink. Just like the NetUplink it greet
+ * the client, negotiate the protocol version, reply to heartbeats and follow
+ * the mute state set by the client.
+ */
+class SimUplink : public sigc::trackable
+{
+  public:
+    SimUplink(const UplinkFarm& farm, unsigned idx);
+    ~SimUplink(void) { delete server; }
+    void tick(uint64_t now, uint64_t tick_cnt);
+
+  private:
+    const UplinkFarm&     farm;
+    unsigned              idx;
+    TcpServer<>           *server;
+    TcpConnection         *con;
+    Rx::MuteState         mute_state;
+    bool                  use_timestamps;
+    bool                  sql_open;
+    size_t                frame_pos;
+    uint64_t              msg_buf[1024];
+
+    void clientConnected(TcpConnection *new_con);
+    void clientDisconnected(TcpConnection *dis_con,
+                            TcpConnection::DisconnectReason reason);
+    int dataReceived(TcpConnection *rx_con, void *buf, int count);
+    void handleMsg(Msg *msg);
+    void sendMsg(const Msg& msg);
+    float siglev(uint64_t now, unsigned rx_cnt) const;
+}; /* class SimUplink */
+
+
+class UplinkFarm : public sigc::trackable
+{
+  public:
+    const Schedule&             sched;
+    string                      codec;
+    vector<vector<uint8_t> >    frames;
+
+    UplinkFarm(const Schedule& sched, const string& codec)
+      : sched(sched), codec(codec), tick_timer(TICK_MS, Timer::TYPE_PERIODIC),
+        tick_cnt(0)
+    {
+    }
+
+    ~UplinkFarm(void)
+    {
+      for (size_t i=0; i<uplinks.size(); ++i)
+      {
+        delete uplinks[i];
+      }
+    }
+
+    bool initialize(const vector<float>& clip)
+    {
+      AudioEncoder *enc = AudioEncoder::create(codec);
+      if (enc == 0)
+      {
+        cerr << "*** ERROR: Unknown audio codec: " << codec << endl;
+        return false;
+      }
+      enc->writeEncodedSamples.connect(
+          sigc::mem_fun(*this, &UplinkFarm::encodedSamplesWritten));
+      for (size_t pos=0; pos+FRAME_SIZE<=clip.size(); pos+=FRAME_SIZE)
+      {
+        frames.push_back(vector<uint8_t>());
+        enc->writeSamples(&clip[pos], FRAME_SIZE);
+      }
+      delete enc;
+
+      unsigned max_rx_cnt = *max_element(sched.steps.begin(),
+                                         sched.steps.end());
+      for (unsigned i=0; i<max_rx_cnt; ++i)
+      {
+        uplinks.push_back(new SimUplink(*this, i));
+      }
+      tick_timer.expired.connect(sigc::mem_fun(*this, &UplinkFarm::onTick));
+      return true;
+    }
+
+  private:
+    vector<SimUplink*>  uplinks;
+    Timer               tick_timer;
+    uint64_t            tick_cnt;
+
+    void encodedSamplesWritten(const void *buf, int size)
+    {
+      const uint8_t *ptr = reinterpret_cast<const uint8_t *>(buf);
+      frames.back().insert(frames.back().end(), ptr, ptr + size);
+    }
+
+    void onTick(Timer *t)
+    {
+      uint64_t now = benchNowUs();
+      if ((now >= sched.endUs()) || (getppid() == 1))
+      {
+        Application::app().quit();
+        return;
+      }
+      for (size_t i=0; i<uplinks.size(); ++i)
+      {
+        uplinks[i]->tick(now, tick_cnt);
+      }
+      ++tick_cnt;
+    }
+}; /* class UplinkFarm */
+
+
+SimUplink::SimUplink(const UplinkFarm& farm, unsigned idx)
+  : farm(farm), idx(idx), server(0), con(0), mute_state(Rx::MUTE_ALL),
+    use_timestamps(false), sql_open(false), frame_pos(0)
+{
+  ostringstream port;
+  port << (BASE_PORT + idx);
+  server = new TcpServer<>(port.str());
+  server->clientConnected.connect(
+      sigc::mem_fun(*this, &SimUplink::clientConnected));
+  server->clientDisconnected.connect(
+      sigc::mem_fun(*this, &SimUplink::clientDisconnected));
+} /* SimUplink::SimUplink */
+
+
+void SimUplink::tick(uint64_t now, uint64_t tick_cnt)
+{
+  if ((con == 0) || (mute_state == Rx::MUTE_ALL))
+  {
+    return;
+  }
+
+  unsigned rx_cnt = farm.sched.rxCntAt(now);
+  bool open = (idx < rx_cnt) && farm.sched.isTalking(now);
+  if (open != sql_open)
+  {
+    sql_open = open;
+    frame_pos = 0;
+    sendMsg(MsgSquelch(open, siglev(now, rx_cnt), rxId(idx), ""));
+  }
+  if (!sql_open)
+  {
+    return;
+  }
+
+  if ((tick_cnt + idx) % SIGLEV_TICKS == 0)
+  {
+    if (use_timestamps)
+    {
+      struct timeval tv;
+      gettimeofday(&tv, NULL);
+      sendMsg(MsgTimestampedSiglevUpdate(tv, siglev(now, rx_cnt), rxId(idx)));
+    }
+    else
+    {
+      sendMsg(MsgSiglevUpdate(siglev(now, rx_cnt), rxId(idx)));
+    }
+  }
+
+  if (mute_state == Rx::MUTE_NONE)
+  {
+    const vector<uint8_t>& frame = farm.frames[frame_pos];
+    frame_pos = (frame_pos + 1) % farm.frames.size();
+    const uint8_t *ptr = frame.empty() ? 0 : &frame[0];
+    int size = frame.size();
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    while (size > 0)
+    {
+      int len = min(size, static_cast<int>(MsgAudio::BUFSIZE));
+      if (use_timestamps)
+      {
+        sendMsg(MsgTimestampedAudio(tv, ptr, len));
+      }
+      else
+      {
+        sendMsg(MsgAudio(ptr, len));
+      }
+      ptr += len;
+      size -= len;
+    }
+  }
+} /* SimUplink::tick */
+
+
+void SimUplink::clientConnected(TcpConnection *new_con)
+{
+  if (con != 0)
+  {
+    new_con->disconnect();
+    return;
+  }
+  con = new_con;
+  con->dataReceived.connect(sigc::mem_fun(*this, &SimUplink::dataReceived));
+  mute_state = Rx::MUTE_ALL;
+  use_timestamps = false;
+  sql_open = false;
+  sendMsg(MsgProtoVer(MsgProtoVer::MAJOR, MsgProtoVer::MIN_MINOR));
+  sendMsg(MsgAuthOk());
+} /* SimUplink::clientConnected */
+
+
+void SimUplink::clientDisconnected(TcpConnection *dis_con,
+                                   TcpConnection::DisconnectReason reason)
+{
+  if (dis_con == con)
+  {
+    con = 0;
+  }
+} /* SimUplink::clientDisconnected */
+
+
+int SimUplink::dataReceived(TcpConnection *rx_con, void *buf, int count)
+{
+  const uint8_t *ptr = reinterpret_cast<const uint8_t *>(buf);
+  int left = count;
+  while (left >= static_cast<int>(sizeof(Msg)))
+  {
+    memcpy(msg_buf, ptr, sizeof(Msg));
+    unsigned msg_size = reinterpret_cast<Msg *>(msg_buf)->size();
+    if ((msg_size < sizeof(Msg)) || (msg_size > sizeof(msg_buf)))
+    {
+      cerr << "*** ERROR: Illegal message size received by simulated "
+              "uplink " << idx << endl;
+      rx_con->disconnect();
+      clientDisconnected(rx_con, TcpConnection::DR_ORDERED_DISCONNECT);
+      return count;
+    }
+    if (static_cast<int>(msg_size) > left)
+    {
+      break;
+    }
+    memcpy(msg_buf, ptr, msg_size);
+    ptr += msg_size;
+    left -= msg_size;
+    handleMsg(reinterpret_cast<Msg *>(msg_buf));
+  }
+  return count - left;
+} /* SimUplink::dataReceived */
+
+
+void SimUplink::handleMsg(Msg *msg)
+{
+  switch (msg->type())
+  {
+    case MsgHeartbeat::TYPE:
+      sendMsg(MsgHeartbeat());
+      break;
+
+    case MsgProtoVer::TYPE:
+    {
+      MsgProtoVer *ver = reinterpret_cast<MsgProtoVer*>(msg);
+      uint16_t minor = min(ver->minorVer(), MsgProtoVer::MINOR);
+      use_timestamps = (minor >= MsgProtoVer::MINOR_TIMESTAMPS);
+      sendMsg(MsgProtoVer(MsgProtoVer::MAJOR, minor));
+      break;
+    }
+
+    case MsgRxAudioCodecSelect::TYPE:
+    {
+      MsgRxAudioCodecSelect *sel = reinterpret_cast<MsgRxAudioCodecSelect*>(msg);
+      if (farm.codec != sel->name())
+      {
+        cerr << "*** WARNING: Simulated uplink " << idx << " use codec "
+             << farm.codec << " but the client requested " << sel->name()
+             << endl;
+      }
+      break;
+    }
+
+    case MsgSetMuteState::TYPE:
+    {
+      MsgSetMuteState *mute = reinterpret_cast<MsgSetMuteState*>(msg);
+      mute_state = mute->muteState();
+      if (mute_state == Rx::MUTE_ALL)
+      {
+        sql_open = false;
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+} /* SimUplink::handleMsg */
+
+
+void SimUplink::sendMsg(const Msg& msg)
+{
+  if (con == 0)
+  {
+    return;
+  }
+  int ret = con->write(&msg, msg.size());
+  if (ret != static_cast<int>(msg.size()))
+  {
+    cerr << "*** ERROR: Simulated uplink " << idx << " could not keep up. "
+            "Disconnecting.\n";
+    TcpConnection *c = con;
+    con = 0;
+    c->disconnect();
+  }
+} /* SimUplink::sendMsg */
+
+
+float SimUplink::siglev(uint64_t now, unsigned rx_cnt) const
+{
+  if (idx == farm.sched.winnerAt(now, rx_cnt))
+  {
+    return 80.0f;
+  }
+    // A deterministic spread below the winner so that the vote is
+    // unambiguous even with the default hysteresis
+  return 10.0f + (idx * 7) % 30 + (rand() % 100) / 100.0f;
+} /* SimUplink::siglev */
+
+
+/*
+ * A sink that count the samples coming out of the voter
+ */
+class CountingSink : public AudioSink
+{
+  public:
+    uint64_t  sample_cnt;
+    uint64_t  last_write_us;
+
+    CountingSink(void) : sample_cnt(0), last_write_us(0) {}
+
+    int writeSamples(const float *samples, int count)
+    {
+      sample_cnt += count;
+      last_write_us = benchNowUs();
+      return count;
+    }
+
+    void flushSamples(void)
+    {
+      sourceAllSamplesFlushed();
+    }
+}; /* class CountingSink */
+
+
+class Bench : public sigc::trackable
+{
+  public:
+    Bench(const Schedule& sched, pid_t sim_pid, const string& codec)
+      : sched(sched), sim_sampler(sim_pid), self_sampler(getpid()),
+        codec(codec), step(0), cfg(0),
+        voter(0), step_timer(0, Timer::TYPE_ONESHOT, false),
+        poll_timer(POLL_MS, Timer::TYPE_PERIODIC, false), measure_start_us(0),
+        is_open(false), open_us(0), open_samples(0), in_gap(false),
+        switch_us(0), switch_seen(true),
+        expected_id(Rx::ID_UNKNOWN), opens(0), wrong(0), missed(0), gaps(0),
+        got_samples(0), expected_samples(0), cpu_start_us(0)
+    {
+      memset(&ru_start, 0, sizeof(ru_start));
+      step_timer.expired.connect(sigc::mem_fun(*this, &Bench::onStepTimer));
+      poll_timer.expired.connect(sigc::mem_fun(*this, &Bench::onPoll));
+    }
+
+    ~Bench(void)
+    {
+      deleteVoter();
+    }
+
+    void start(void)
+    {
+      cout << "Codec " << codec << ", " << sched.measure_ms / 1000
+           << "s per step, voting delay " << VOTING_DELAY << "ms, buffer "
+           << BUFFER_LENGTH << "ms\n";
+      cout << setw(5) << "N" << setw(7) << "cpu%" << setw(8) << "cpu%/rx"
+           << setw(7) << "sim%" << setw(9) << "RSS kB"
+           << setw(6) << "opens" << setw(6) << "wrong"
+           << setw(17) << "open p50/p95/max"
+           << setw(7) << "missed" << setw(19) << "switch p50/p95/max"
+           << setw(8) << "audio%" << setw(6) << "gaps" << endl;
+      scheduleAt(sched.stepStartUs(0));
+    }
+
+  private:
+    const Schedule&   sched;
+    ProcSampler       sim_sampler;
+    ProcSampler       self_sampler;
+    string            codec;
+    size_t            step;
+    Config            *cfg;
+    Rx                *voter;
+    CountingSink      sink;
+    Timer             step_timer;
+    Timer             poll_timer;
+    uint64_t          measure_start_us;
+    bool              is_open;
+    uint64_t          open_us;
+    uint64_t          open_samples;
+    bool              in_gap;
+    uint64_t          switch_us;
+    bool              switch_seen;
+    char              expected_id;
+    LatencyHistogram  open_lat;
+    LatencyHistogram  switch_lat;
+    unsigned          opens;
+    unsigned          wrong;
+    unsigned          missed;
+    unsigned          gaps;
+    uint64_t          got_samples;
+    uint64_t          expected_samples;
+    struct rusage     ru_start;
+    uint64_t          cpu_start_us;
+
+    bool isMeasuring(void) const { return measure_start_us != 0; }
+
+    void scheduleAt(uint64_t t)
+    {
+      uint64_t now = benchNowUs();
+      step_timer.setTimeout((t > now) ? (t - now + 999) / 1000 : 0);
+      step_timer.setEnable(true);
+    }
+
+    void onStepTimer(Timer *t)
+    {
+      step_timer.setEnable(false);
+      if (voter == 0)
+      {
+        startStep();
+      }
+      else if (!isMeasuring())
+      {
+        startMeasuring();
+      }
+      else
+      {
+        finishStep();
+      }
+    }
+
+    void startStep(void)
+    {
+      unsigned rx_cnt = sched.steps[step];
+      cfg = new Config;
+      ostringstream receivers;
+      for (unsigned i=0; i<rx_cnt; ++i)
+      {
+        ostringstream rx_name;
+        rx_name << "Rx" << i;
+        cfg->setValue(rx_name.str(), "TYPE", "Net");
+        cfg->setValue(rx_name.str(), "HOST", "127.0.0.1");
+        cfg->setValue(rx_name.str(), "TCP_PORT", BASE_PORT + i);
+        cfg->setValue(rx_name.str(), "CODEC", codec);
+        receivers << (i > 0 ? "," : "") << rx_name.str();
+      }
+      cfg->setValue("Voter", "TYPE", "Voter");
+      cfg->setValue("Voter", "RECEIVERS", receivers.str());
+      cfg->setValue("Voter", "VOTING_DELAY", VOTING_DELAY);
+      cfg->setValue("Voter", "BUFFER_LENGTH", BUFFER_LENGTH);
+
+      voter = RxFactory::createNamedRx(*cfg, "Voter");
+      if ((voter == 0) || !voter->initialize())
+      {
+        cerr << "*** ERROR: Could not create the voter\n";
+        Application::app().quit();
+        return;
+      }
+      voter->squelchOpen.connect(
+          sigc::mem_fun(*this, &Bench::voterSquelchOpen));
+      voter->registerSink(&sink);
+      voter->setMuteState(Rx::MUTE_NONE);
+      is_open = false;
+      poll_timer.setEnable(true);
+      scheduleAt(sched.stepStartUs(step) + WARMUP_MS * 1000);
+    }
+
+    void startMeasuring(void)
+    {
+      measure_start_us = benchNowUs();
+      open_lat.reset();
+      switch_lat.reset();
+      opens = wrong = missed = gaps = 0;
+      got_samples = expected_samples = 0;
+      getrusage(RUSAGE_SELF, &ru_start);
+      cpu_start_us = measure_start_us;
+        // Set the starting point for the simulator CPU usage
+      sim_sampler.cpuPercent();
+      scheduleAt(sched.stepStartUs(step + 1));
+    }
+
+    void finishStep(void)
+    {
+      struct rusage ru;
+      getrusage(RUSAGE_SELF, &ru);
+      uint64_t elapsed_us = benchNowUs() - cpu_start_us;
+      double cpu_us =
+        (ru.ru_utime.tv_sec - ru_start.ru_utime.tv_sec) * 1e6 +
+        (ru.ru_utime.tv_usec - ru_start.ru_utime.tv_usec) +
+        (ru.ru_stime.tv_sec - ru_start.ru_stime.tv_sec) * 1e6 +
+        (ru.ru_stime.tv_usec - ru_start.ru_stime.tv_usec);
+      double cpu_pct = 100.0 * cpu_us / elapsed_us;
+      double sim_pct = sim_sampler.cpuPercent();
+      unsigned rx_cnt = sched.steps[step];
+      uint64_t rss_kb = 0;
+      self_sampler.rssKb(rss_kb);
+
+      deleteVoter();
+
+      ostringstream open_str, switch_str;
+      open_str << fixed << setprecision(0) << open_lat.percentileMs(50)
+               << "/" << open_lat.percentileMs(95) << "/" << open_lat.maxMs();
+      switch_str << fixed << setprecision(0) << switch_lat.percentileMs(50)
+                 << "/" << switch_lat.percentileMs(95) << "/"
+                 << switch_lat.maxMs();
+      double audio_pct = (expected_samples > 0) ?
+        100.0 * got_samples / expected_samples : 0.0;
+      cout << fixed << setw(5) << rx_cnt
+           << setprecision(1) << setw(7) << cpu_pct
+           << setprecision(3) << setw(8) << cpu_pct / rx_cnt
+           << setprecision(1) << setw(7) << sim_pct
+           << setw(9) << rss_kb
+           << setw(6) << opens << setw(6) << wrong
+           << setw(17) << open_str.str()
+           << setw(7) << missed << setw(19) << switch_str.str()
+           << setprecision(1) << setw(8) << audio_pct
+           << setw(6) << gaps << endl;
+
+      measure_start_us = 0;
+      if (++step >= sched.steps.size())
+      {
+        Application::app().quit();
+        return;
+      }
+      scheduleAt(sched.stepStartUs(step));
+    }
+
+    void deleteVoter(void)
+    {
+      poll_timer.setEnable(false);
+      if (voter != 0)
+      {
+        voter->unregisterSink();
+      }
+      delete voter;
+      voter = 0;
+      delete cfg;
+      cfg = 0;
+    }
+
+    void voterSquelchOpen(bool open)
+    {
+      uint64_t now = benchNowUs();
+      is_open = open;
+      if (open)
+      {
+        open_us = now;
+        open_samples = sink.sample_cnt;
+        sink.last_write_us = now;
+        in_gap = false;
+        uint64_t cycle_start;
+        sched.cycleAt(now, cycle_start);
+        switch_us = cycle_start + TALK_MS * 500;
+        switch_seen = (sched.steps[step] < 2);
+        expected_id = rxId(sched.winnerAt(switch_us, sched.steps[step]));
+        if (!isMeasuring() || (cycle_start < measure_start_us))
+        {
+          return;
+        }
+        ++opens;
+        open_lat.add(now - cycle_start);
+        char first_id =
+          rxId(sched.winnerAt(cycle_start, sched.steps[step]));
+        if (voter->sqlRxId() != first_id)
+        {
+          ++wrong;
+        }
+      }
+      else
+      {
+        uint64_t cycle_start;
+        sched.cycleAt(open_us, cycle_start);
+        if (!isMeasuring() || (cycle_start < measure_start_us))
+        {
+          return;
+        }
+        if (!switch_seen)
+        {
+          ++missed;
+        }
+        got_samples += sink.sample_cnt - open_samples;
+        expected_samples +=
+          static_cast<uint64_t>(TALK_MS) * INTERNAL_SAMPLE_RATE / 1000;
+      }
+    }
+
+    void onPoll(Timer *t)
+    {
+      if (!is_open)
+      {
+        return;
+      }
+      uint64_t now = benchNowUs();
+      if (!switch_seen && (now >= switch_us) &&
+          (voter->sqlRxId() == expected_id))
+      {
+        switch_seen = true;
+        if (isMeasuring() && (open_us >= measure_start_us))
+        {
+          switch_lat.add(now - switch_us);
+        }
+      }
+      if (now - sink.last_write_us > GAP_MS * 1000)
+      {
+        if (!in_gap && isMeasuring())
+        {
+          ++gaps;
+        }
+        in_gap = true;
+      }
+      else
+      {
+        in_gap = false;
+      }
+    }
+}; /* class Bench */
+
+
+} /* End of anonymous namespace */
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static bool load_clip(const char *filename, vector<float>& clip);
+static void handle_unix_signal(int signum);
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+static pid_t sim_pid = 0;
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  unsigned max_rx_cnt = 64;
+  double step_seconds = 30.0;
+  string codec("RAW");
+  const char *clip_file = 0;
+  if (argc > 1)
+  {
+    max_rx_cnt = atoi(argv[1]);
+  }
+  if (argc > 2)
+  {
+    step_seconds = atof(argv[2]);
+  }
+  if (argc > 3)
+  {
+    codec = argv[3];
+  }
+  if (argc > 4)
+  {
+    clip_file = argv[4];
+  }
+  if ((argc > 5) || (max_rx_cnt < 1) || (max_rx_cnt > MAX_RECEIVERS) ||
+      (step_seconds * 1000 < 2 * CYCLE_MS))
+  {
+    cerr << "Usage: VoterBench [max receivers [seconds per step [codec "
+            "[raw audio file]]]]\n"
+            "The audio file should contain signed 16 bit samples at "
+         << INTERNAL_SAMPLE_RATE << "Hz\n";
+    exit(1);
+  }
+
+  vector<float> clip;
+  if (!load_clip(clip_file, clip))
+  {
+    exit(1);
+  }
+
+  Schedule sched;
+  for (unsigned rx_cnt=1; rx_cnt<max_rx_cnt; rx_cnt*=2)
+  {
+    sched.steps.push_back(rx_cnt);
+  }
+  sched.steps.push_back(max_rx_cnt);
+  sched.measure_ms = static_cast<unsigned>(step_seconds * 1000);
+  sched.t0_us = benchNowUs() + START_DELAY_MS * 1000;
+
+    // The uplinks run in a separate process so that the CPU usage of the
+    // voter can be measured on its own
+  sim_pid = fork();
+  if (sim_pid < 0)
+  {
+    perror("fork");
+    exit(1);
+  }
+  if (sim_pid == 0)
+  {
+    CppApplication app;
+    UplinkFarm farm(sched, codec);
+    if (!farm.initialize(clip))
+    {
+      exit(1);
+    }
+    app.exec();
+    return 0;
+  }
+
+  int ret = 0;
+  {
+    CppApplication app;
+    app.catchUnixSignal(SIGINT);
+    app.catchUnixSignal(SIGTERM);
+    app.unixSignalCaught.connect(sigc::ptr_fun(&handle_unix_signal));
+
+    Bench bench(sched, sim_pid, codec);
+    bench.start();
+    app.exec();
+  }
+
+  kill(sim_pid, SIGTERM);
+  int status = 0;
+  waitpid(sim_pid, &status, 0);
+  if (!WIFEXITED(status) && !WIFSIGNALED(status))
+  {
+    ret = 1;
+  }
+
+  return ret;
+} /* main */
+
+
+
+/****************************************************************************
+ *
+ * Functions
+ *
+ ****************************************************************************/
+
+static bool load_clip(const char *filename, vector<float>& clip)
+{
+  if (filename != 0)
+  {
+    ifstream is(filename, ios::binary);
+    if (!is)
+    {
+      cerr << "*** ERROR: Could not open audio file " << filename << endl;
+      return false;
+    }
+    int16_t samp;
+    while (is.read(reinterpret_cast<char *>(&samp), sizeof(samp)))
+    {
+      clip.push_back(samp / 32768.0f);
+    }
+    if (clip.size() < FRAME_SIZE)
+    {
+      cerr << "*** ERROR: The audio file " << filename << " is too short\n";
+      return false;
+    }
+    return true;
+  }
+
+    // A voice like signal: a gliding pitch with harmonics up to 3400Hz and
+    // a syllable envelope
+  const double pi = 3.14159265358979;
+  double phase = 0.0;
+  for (int i=0; i<CLIP_SECONDS*INTERNAL_SAMPLE_RATE; ++i)
+  {
+    double t = static_cast<double>(i) / INTERNAL_SAMPLE_RATE;
+    double f0 = 150.0 + 60.0 * sin(2.0 * pi * 0.3 * t);
+    phase += 2.0 * pi * f0 / INTERNAL_SAMPLE_RATE;
+    double env = 0.5 + 0.5 * sin(2.0 * pi * 4.0 * t);
+    double val = 0.0;
+    for (int h=1; h*f0<3400.0; ++h)
+    {
+      val += sin(h * phase) / h;
+    }
+    clip.push_back(static_cast<float>(0.2 * env * val));
+  }
+  return true;
+} /* load_clip */
+
+
+static void handle_unix_signal(int signum)
+{
+  switch (signum)
+  {
+    case SIGINT:
+    case SIGTERM:
+      Application::app().quit();
+      break;
+  }
+} /* handle_unix_signal */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -38,6 +38,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <algorithm>
 #include <deque>
 #include <iterator>
+#include <atomic>
 
 
 /****************************************************************************
@@ -57,10 +58,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "WbRxRtlSdr.h"
 #include "RtlTcp.h"
+#include "RtlFile.h"
 #ifdef HAS_RTLSDR_SUPPORT
 #include "RtlUsb.h"
 #endif
 #include "Ddr.h"
+#include "DdrChannelBank.h"
 
 
 
@@ -136,7 +139,8 @@ WbRxRtlSdr *WbRxRtlSdr::instance(Async::Config &cfg, const string &name)
 
 
 WbRxRtlSdr::WbRxRtlSdr(Async::Config &cfg, const string &name)
-  : auto_tune_enabled(true), m_name(name), xvrtr_offset(0)
+  : auto_tune_enabled(true), m_name(name), xvrtr_offset(0),
+    channel_threads(false), bank(0)
 {
   //cout << "### Initializing WBRX " << name << endl;
 
@@ -153,6 +157,21 @@ WbRxRtlSdr::WbRxRtlSdr(Async::Config &cfg, const string &name)
     //cout << "###   PORT        = " << tcp_port << endl;
     rtl = new RtlTcp(remote_host, tcp_port);
   }
+  else if (rtl_type == "RtlFile")
+  {
+    string iq_file;
+    if (!cfg.getValue(name, "IQ_FILE", iq_file) || iq_file.empty())
+    {
+      cerr << "*** ERROR: Config variable " << name
+           << "/IQ_FILE must be set when using the RtlFile type\n";
+      exit(1);
+    }
+    bool realtime = true;
+    cfg.getValue(name, "IQ_FILE_REALTIME", realtime);
+    bool loop = false;
+    cfg.getValue(name, "IQ_FILE_LOOP", loop);
+    rtl = new RtlFile(iq_file, realtime, loop);
+  }
 #ifdef HAS_RTLSDR_SUPPORT
   else if (rtl_type == "RtlUsb")
   {
@@ -172,7 +191,7 @@ WbRxRtlSdr::WbRxRtlSdr(Async::Config &cfg, const string &name)
   cfg.getValue(name, "SAMPLE_RATE", sample_rate);
   //cout << "###   SAMPLE_RATE = " << sample_rate << endl;
   rtl->setSampleRate(sample_rate);
-  rtl->iqReceived.connect(iqReceived.make_slot());
+  rtl->iqReceived.connect(mem_fun(*this, &WbRxRtlSdr::rtlIqReceived));
   rtl->readyStateChanged.connect(
       mem_fun(*this, &WbRxRtlSdr::rtlReadyStateChanged));
 
@@ -205,6 +224,45 @@ WbRxRtlSdr::WbRxRtlSdr(Async::Config &cfg, const string &name)
   bool peak_meter = false;
   cfg.getValue(name, "PEAK_METER", peak_meter);
   rtl->enableDistPrint(peak_meter);
+
+  string capture_file;
+  if (cfg.getValue(name, "IQ_CAPTURE_FILE", capture_file) &&
+      !capture_file.empty())
+  {
+    if (rtl_type == "RtlFile")
+    {
+      cerr << "*** WARNING: " << name << "/IQ_CAPTURE_FILE is ignored "
+           << "when replaying an I/Q file\n";
+    }
+    else
+    {
+      rtl->enableCapture(capture_file);
+    }
+  }
+
+  cfg.getValue(name, "CHANNEL_THREADS", channel_threads);
+
+  bool use_bank = false;
+  cfg.getValue(name, "CHANNEL_BANK", use_bank);
+  if (use_bank)
+  {
+    if (DdrChannelBank::isSupportedSampleRate(sample_rate))
+    {
+      bank = new DdrChannelBank(sample_rate);
+      if (channel_threads)
+      {
+        cerr << "*** WARNING: " << name << "/CHANNEL_THREADS is ignored "
+             << "since CHANNEL_BANK is enabled\n";
+        channel_threads = false;
+      }
+    }
+    else
+    {
+      cerr << "*** WARNING: " << name << "/CHANNEL_BANK cannot be used "
+           << "with a sample rate of " << sample_rate << "Hz. The sample "
+           << "rate must be a multiple of 96000Hz.\n";
+    }
+  }
 } /* WbRxRtlSdr::WbRxRtlSdr */
 
 
@@ -212,6 +270,8 @@ WbRxRtlSdr::~WbRxRtlSdr(void)
 {
   delete rtl;
   rtl = 0;
+  delete bank;
+  bank = 0;
 } /* WbRxRtlSdr::~WbRxRtlSdr */
 
 
@@ -402,6 +462,43 @@ void WbRxRtlSdr::rtlReadyStateChanged(void)
 } /* WbRxRtlSdr::rtlReadyStateChanged */
 
 
+void WbRxRtlSdr::rtlIqReceived(const std::vector<Sample> &samples)
+{
+  iqReceived(samples);
+
+  if (bank != 0)
+  {
+    bank->process(samples);
+  }
+
+  if (iqBlockReceived.empty())
+  {
+    return;
+  }
+
+    // Find a block that is no longer used by any receiver. The fence make
+    // sure that a receiver in another thread is done reading the block
+    // before it is overwritten.
+  std::shared_ptr<std::vector<Sample> > block;
+  for (size_t i=0; i<block_pool.size(); ++i)
+  {
+    if (block_pool[i].use_count() == 1)
+    {
+      atomic_thread_fence(memory_order_acquire);
+      block = block_pool[i];
+      break;
+    }
+  }
+  if (!block)
+  {
+    block = std::make_shared<std::vector<Sample> >();
+    block_pool.push_back(block);
+  }
+  block->assign(samples.begin(), samples.end());
+  iqBlockReceived(block);
+} /* WbRxRtlSdr::rtlIqReceived */
+
+
 
 /*
  * This file has not been truncated
@@ -41,6 +41,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <vector>
 #include <complex>
 #include <set>
+#include <memory>
 
 
 /****************************************************************************
@@ -71,6 +72,7 @@ namespace Async
 };
 class RtlSdr;
 class Ddr;
+class DdrChannelBank;
 
 
 /****************************************************************************
@@ -125,6 +127,7 @@ class WbRxRtlSdr : public sigc::trackable
 {
   public:
     typedef std::complex<float> Sample;
+    typedef std::shared_ptr<const std::vector<Sample> > SampleBlock;
 
     static WbRxRtlSdr *instance(Async::Config &cfg, const std::string &name);
 
@@ -195,15 +198,40 @@ class WbRxRtlSdr : public sigc::trackable
      */
     bool isReady(void) const;
 
+    /**
+     * @brief   Find out if the DDR channels should run in worker threads
+     * @returns Returns \em true if CHANNEL_THREADS is set for the tuner
+     */
+    bool channelThreadsEnabled(void) const { return channel_threads; }
+
+    /**
+     * @brief   Get the channel bank for this tuner
+     * @returns Returns the channel bank or 0 if CHANNEL_BANK is not enabled
+     */
+    DdrChannelBank *channelBank(void) const { return bank; }
+
     /**
      * @brief   A signal that is emitted when new samples have been received
      * @param   samples A vector of received samples
      *
      * Connecting to this signal is the way to get samples from the DVB-T
      * dongle. The format is a vector of complex floats (I/Q) with a range from
-     * -1 to 1.
+     * -1 to 1. The vector is only valid during the call.
+     */
+    sigc::signal<void, const std::vector<Sample>&> iqReceived;
+
+    /**
+     * @brief   A signal that is emitted when new samples have been received
+     * @param   block A reference counted block of received samples
+     *
+     * This signal is emitted at the same time as iqReceived but the samples
+     * are given as a shared block that may be kept after the call, e.g. to
+     * be processed by another thread. The block must not be changed. All
+     * receivers get the same block and the buffer is reused when the last
+     * reference has been dropped. The block is only created when there are
+     * slots connected to this signal.
      */
-    sigc::signal<void, std::vector<Sample> > iqReceived;
+    sigc::signal<void, SampleBlock> iqBlockReceived;
     
     /**
      * @brief   A signal that is emitted when the ready state changes
@@ -223,11 +251,15 @@ class WbRxRtlSdr : public sigc::trackable
     bool auto_tune_enabled;
     std::string m_name;
     int xvrtr_offset;
+    bool channel_threads;
+    DdrChannelBank *bank;
+    std::vector<std::shared_ptr<std::vector<Sample> > > block_pool;
 
     WbRxRtlSdr(const WbRxRtlSdr&);
     WbRxRtlSdr& operator=(const WbRxRtlSdr&);
     void findBestCenterFq(void);
     void rtlReadyStateChanged(void);
+    void rtlIqReceived(const std::vector<Sample> &samples);
     
 };  /* class WbRxRtlSdr */
 